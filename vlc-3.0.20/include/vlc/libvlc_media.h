@@ -137,8 +137,47 @@ typedef struct libvlc_media_stats_t
     int         i_sent_packets;
     int         i_sent_bytes;
     float       f_send_bitrate;
+
+    /* End-to-end latency, from the demuxer to the display (video) or the
+     * playback date (audio), in microseconds: 50th, 90th and 99th
+     * percentiles */
+    int64_t     i_video_latency_p50;
+    int64_t     i_video_latency_p90;
+    int64_t     i_video_latency_p99;
+    int64_t     i_audio_latency_p50;
+    int64_t     i_audio_latency_p90;
+    int64_t     i_audio_latency_p99;
 } libvlc_media_stats_t;
 
+/** Number of buckets of the video timing histograms */
+#define LIBVLC_VIDEO_TIMING_BUCKETS 12
+
+/**
+ * Histograms of the time spent by the pictures in the video output.
+ *
+ * Bucket i counts the durations shorter than 2^i milliseconds that did not
+ * fit in the previous buckets (negative durations land in the first one),
+ * and the last bucket the longer durations.
+ */
+typedef struct libvlc_media_video_timings_t
+{
+    /** Time left before the display date, as the picture reaches the
+     *  video output */
+    unsigned    i_lead[LIBVLC_VIDEO_TIMING_BUCKETS];
+    /** Static video filters, such as deinterlacing */
+    unsigned    i_filter[LIBVLC_VIDEO_TIMING_BUCKETS];
+    /** User video filters */
+    unsigned    i_interactive_filter[LIBVLC_VIDEO_TIMING_BUCKETS];
+    /** Subpicture rendering */
+    unsigned    i_spu[LIBVLC_VIDEO_TIMING_BUCKETS];
+    /** Blending, copies and display preparation */
+    unsigned    i_prepare[LIBVLC_VIDEO_TIMING_BUCKETS];
+    /** Display */
+    unsigned    i_display[LIBVLC_VIDEO_TIMING_BUCKETS];
+    /** Lateness of the display against the picture date */
+    unsigned    i_late[LIBVLC_VIDEO_TIMING_BUCKETS];
+} libvlc_media_video_timings_t;
+
 typedef struct libvlc_media_track_info_t
 {
     /* Codec fourcc */
@@ -291,6 +330,16 @@ typedef enum libvlc_media_parse_flag_t
      * when the input is asking for credentials.
      */
     libvlc_media_do_interact    = 0x08,
+    /**
+     * Parse (and fetch) this item only once no other item is waiting, e.g.
+     * when indexing a large collection in the background
+     */
+    libvlc_media_parse_background = 0x10,
+    /**
+     * Only read the container headers: the duration, tracks and tags may be
+     * estimated or incomplete, but parsing is much faster
+     */
+    libvlc_media_parse_lite     = 0x20,
 } libvlc_media_parse_flag_t;
 
 /**
@@ -637,6 +686,19 @@ LIBVLC_API libvlc_state_t libvlc_media_get_state(
 LIBVLC_API int libvlc_media_get_stats( libvlc_media_t *p_md,
                                            libvlc_media_stats_t *p_stats );
 
+/**
+ * Get the video output timing histograms of the media
+ * \param p_md: media descriptor object
+ * \param p_timings: structure receiving the histograms
+ *                   (this structure must be allocated by the caller)
+ * \return true if the statistics are available, false otherwise
+ *
+ * \libvlc_return_bool
+ * \version LibVLC 3.0.21 and later.
+ */
+LIBVLC_API int libvlc_media_get_video_timings( libvlc_media_t *p_md,
+                                    libvlc_media_video_timings_t *p_timings );
+
 /* The following method uses libvlc_media_list_t, however, media_list usage is optionnal
  * and this is here for convenience */
 #define VLC_FORWARD_DECLARE_OBJECT(a) struct a
@@ -884,6 +946,67 @@ LIBVLC_API
 void libvlc_media_slaves_release( libvlc_media_slave_t **pp_slaves,
                                   unsigned int i_count );
 
+/**
+ * Media thumbnailer, see libvlc_media_thumbnailer_new()
+ */
+typedef struct libvlc_media_thumbnailer_t libvlc_media_thumbnailer_t;
+
+/**
+ * Open a media descriptor for thumbnail extraction.
+ *
+ * The thumbnailer does not play the media: there is no media player, no
+ * audio or video output, and only the keyframe nearest before each requested
+ * time is decoded. Several thumbnails can be taken from the same thumbnailer,
+ * which avoids opening the media again for each of them.
+ *
+ * A thumbnailer must only be used from one thread at a time.
+ *
+ * \version LibVLC 3.0.21 or later.
+ *
+ * \param p_md media descriptor object
+ * \return a thumbnailer (release with libvlc_media_thumbnailer_release()),
+ *         or NULL if the media has no decodable video track
+ */
+LIBVLC_API libvlc_media_thumbnailer_t *
+libvlc_media_thumbnailer_new( libvlc_media_t *p_md );
+
+/**
+ * Take a thumbnail.
+ *
+ * The thumbnail is the keyframe nearest before the requested time, scaled
+ * with a fast, low-quality scaler. If both dimensions are 0, the original
+ * size is kept; if only one is 0, the other is computed to keep the aspect
+ * ratio.
+ *
+ * \version LibVLC 3.0.21 or later.
+ *
+ * \param p_th thumbnailer
+ * \param i_time media time of the thumbnail (in ms)
+ * \param psz_format image format ("png", "jpg"...) to encode to, or NULL
+ *        for raw 32-bits RGBA pixels with rows of 4 * width bytes
+ * \param pi_width requested width [IN], actual width [OUT]
+ * \param pi_height requested height [IN], actual height [OUT]
+ * \param pp_data address to store the data (release with libvlc_free())
+ *        [OUT]
+ * \param pi_size address to store the size of the data in bytes [OUT]
+ * \return 0 on success, -1 on error
+ */
+LIBVLC_API int
+libvlc_media_thumbnailer_take( libvlc_media_thumbnailer_t *p_th,
+                               libvlc_time_t i_time, const char *psz_format,
+                               unsigned *pi_width, unsigned *pi_height,
+                               void **pp_data, size_t *pi_size );
+
+/**
+ * Release a media thumbnailer.
+ *
+ * \version LibVLC 3.0.21 or later.
+ *
+ * \param p_th thumbnailer to release
+ */
+LIBVLC_API void
+libvlc_media_thumbnailer_release( libvlc_media_thumbnailer_t *p_th );
+
 /** @}*/
 
 # ifdef __cplusplus
@@ -290,6 +290,29 @@ LIBVLC_API void libvlc_media_player_stop ( libvlc_media_player_t *p_mi );
 LIBVLC_API int libvlc_media_player_set_renderer( libvlc_media_player_t *p_mi,
                                                  libvlc_renderer_item_t *p_item );
 
+/**
+ * Show the video and audio decoded by another media player.
+ *
+ * The media player then renders the pictures and plays the audio of the
+ * source player through its own video window and audio output, without
+ * opening, demuxing nor decoding the media again. This is meant for
+ * applications showing the same media in several places, such as a
+ * thumbnail and a full view of a live channel.
+ *
+ * The media player follows the playback of the source player, so it should
+ * not play a media of its own while mirroring.
+ *
+ * \note Pictures decoded to opaque hardware surfaces cannot be mirrored.
+ *
+ * \param p_mi the Media Player showing the outputs
+ * \param p_source the Media Player decoding the media, or NULL to stop
+ * mirroring
+ * \return 0 on success, -1 on error.
+ * \version LibVLC 3.0.21 or later
+ */
+LIBVLC_API int libvlc_media_player_set_mirror( libvlc_media_player_t *p_mi,
+                                               libvlc_media_player_t *p_source );
+
 /**
  * Callback prototype to allocate and lock a picture buffer.
  *
@@ -456,6 +479,155 @@ void libvlc_video_set_format_callbacks( libvlc_media_player_t *mp,
                                         libvlc_video_format_cb setup,
                                         libvlc_video_cleanup_cb cleanup );
 
+/**
+ * Handle to a displayed picture buffer of the pool.
+ */
+typedef struct libvlc_video_buffer_t libvlc_video_buffer_t;
+
+/**
+ * Callback prototype to provide a picture buffer of the pool.
+ *
+ * This callback is invoked once for each of the picture buffers announced
+ * by the @ref libvlc_video_format_cb callback, when the video output starts.
+ * The buffers must remain valid until they are released, and until the
+ * @ref libvlc_video_cleanup_cb callback is invoked.
+ *
+ * \param opaque private pointer as passed to
+ *               libvlc_video_set_pool_callbacks() [IN]
+ * \param index index of the picture buffer [IN]
+ * \param planes start address of the pixel planes (LibVLC allocates the array
+ *             of void pointers, this callback must initialize the array) [OUT]
+ * \return a private pointer for the display callback to identify the picture
+ *         buffer, or NULL to provide no more buffers
+ */
+typedef void *(*libvlc_video_pool_cb)(void *opaque, unsigned index,
+                                      void **planes);
+
+/**
+ * Callback prototype to display a picture buffer of the pool.
+ *
+ * The application owns the picture buffer from then on: LibVLC will not
+ * render into it again until it is given back with
+ * libvlc_video_buffer_release(), possibly from another thread. Holding too
+ * many buffers stalls the video decoding.
+ *
+ * \param opaque private pointer as passed to
+ *               libvlc_video_set_pool_callbacks() [IN]
+ * \param picture private pointer returned from the
+ *                @ref libvlc_video_pool_cb callback [IN]
+ * \param buffer handle to give the picture buffer back [IN]
+ */
+typedef void (*libvlc_video_pool_display_cb)(void *opaque, void *picture,
+                                             libvlc_video_buffer_t *buffer);
+
+/**
+ * Set callbacks and private data to render decoded video to a pool of
+ * buffers in memory.
+ * Use libvlc_video_set_format() or libvlc_video_set_format_callbacks()
+ * to configure the decoded format, the latter also sets the number of
+ * buffers in the pool.
+ *
+ * Unlike with libvlc_video_set_callbacks(), the video decoder renders
+ * straight into the application buffers when the pool is big enough,
+ * saving a copy of every picture. Otherwise, LibVLC renders into its own
+ * buffers and copies into the application ones.
+ *
+ * \param mp the media player
+ * \param pool callback to provide the picture buffers (must not be NULL)
+ * \param display callback to display video (or NULL if not needed)
+ * \param opaque private pointer for the callbacks (as first parameter)
+ * \version LibVLC 3.0.21 or later
+ */
+LIBVLC_API
+void libvlc_video_set_pool_callbacks( libvlc_media_player_t *mp,
+                                      libvlc_video_pool_cb pool,
+                                      libvlc_video_pool_display_cb display,
+                                      void *opaque );
+
+/**
+ * Give a displayed picture buffer back to LibVLC.
+ *
+ * \param buffer handle received by the @ref libvlc_video_pool_display_cb
+ *               callback
+ * \version LibVLC 3.0.21 or later
+ */
+LIBVLC_API
+void libvlc_video_buffer_release( libvlc_video_buffer_t *buffer );
+
+/**
+ * Type of a decoded video surface.
+ */
+typedef enum libvlc_video_surface_type_t
+{
+    libvlc_video_surface_memory, /**< pixel planes in system memory */
+    libvlc_video_surface_vaapi,  /**< VA-API surface */
+} libvlc_video_surface_type_t;
+
+/**
+ * Description of a decoded video surface.
+ */
+typedef struct libvlc_video_surface_t
+{
+    libvlc_video_surface_type_t type;
+    char chroma[4]; /**< four-characters chroma of the surface */
+    unsigned x_offset; /**< start of the visible area */
+    unsigned y_offset; /**< start of the visible area */
+    unsigned width; /**< visible pixel width */
+    unsigned height; /**< visible pixel height */
+    union
+    {
+        struct
+        {
+            unsigned count; /**< number of planes */
+            void *planes[5]; /**< start address of the pixel planes */
+            unsigned pitches[5]; /**< scanline pitches in bytes */
+            unsigned lines[5]; /**< scanlines count */
+        } memory;
+        struct
+        {
+            void *display; /**< VADisplay */
+            unsigned surface; /**< VASurfaceID, use vaSyncSurface() before
+                                   reading it */
+        } vaapi;
+    } u;
+} libvlc_video_surface_t;
+
+/**
+ * Callback prototype to display a decoded video surface.
+ *
+ * The surface is valid, and will not be rendered into again, until it is
+ * given back with libvlc_video_buffer_release(), possibly from another
+ * thread. Holding too many surfaces stalls the video decoding.
+ *
+ * \param opaque private pointer as passed to
+ *               libvlc_video_set_surface_callbacks() [IN]
+ * \param surface description of the surface (only valid during the
+ *                callback) [IN]
+ * \param buffer handle to give the surface back [IN]
+ */
+typedef void (*libvlc_video_surface_cb)(void *opaque,
+                                        const libvlc_video_surface_t *surface,
+                                        libvlc_video_buffer_t *buffer);
+
+/**
+ * Set callbacks to receive the decoded video surfaces as they are.
+ *
+ * Hardware decoded pictures are given as hardware surfaces when LibVLC can
+ * export them, so that they can be processed on the GPU without reading
+ * them back to system memory. Otherwise, they are given as pixel planes in
+ * system memory, without any conversion from the decoded format when
+ * possible. Subpictures are not blent into the surfaces.
+ *
+ * \param mp the media player
+ * \param display callback to display video (must not be NULL)
+ * \param opaque private pointer for the callback (as first parameter)
+ * \version LibVLC 3.0.21 or later
+ */
+LIBVLC_API
+void libvlc_video_set_surface_callbacks( libvlc_media_player_t *mp,
+                                         libvlc_video_surface_cb display,
+                                         void *opaque );
+
 /**
  * Set the NSView handler where the media player should render its video output.
  *
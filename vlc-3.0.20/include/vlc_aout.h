@@ -57,6 +57,10 @@
 /* Max acceptable resampling (in %) */
 #define AOUT_MAX_RESAMPLING             10
 
+/** Minimum synchronization tolerance in low latency mode
+ * (cf. aout_LatencyTarget()) */
+#define AOUT_LOW_LATENCY_MIN_TOLERANCE  (CLOCK_FREQ / 200)
+
 #include "vlc_es.h"
 
 #define AOUT_FMTS_IDENTICAL( p_first, p_second ) (                          \
@@ -404,6 +408,75 @@ VLC_API void     aout_FiltersChangeViewpoint(aout_filters_t *, const vlc_viewpoi
 
 VLC_API vout_thread_t * aout_filter_RequestVout( filter_t *, vout_thread_t *p_vout, const video_format_t *p_fmt );
 
+/**
+ * Returns the output latency targeted by the low latency mode.
+ *
+ * In this mode, the audio core derives the buffering (the advance of the
+ * buffers passed to the play callback) and the synchronization tolerances
+ * from the output timing jitter it measures. Output plugins should size
+ * their device buffers and periods after this value.
+ *
+ * \return the target latency, or 0 if the default buffering is in use
+ */
+static inline vlc_tick_t aout_LatencyTarget(audio_output_t *aout)
+{
+    return var_InheritInteger(aout, "audio-latency") * (CLOCK_FREQ / 1000);
+}
+
+/**
+ * \defgroup audio_ring Audio ring buffer
+ * Lock-free single-producer single-consumer byte ring for pull-model audio
+ * outputs.
+ *
+ * aout_ring_Write() and aout_ring_Flush() must only be called from the
+ * producer thread (typically the audio output play callback), and
+ * aout_ring_Read() only from the consumer thread (typically the realtime
+ * render callback of the audio API). aout_ring_Read() and aout_ring_Used()
+ * never allocate, lock nor wait, so they are safe to call from a realtime
+ * thread.
+ * @{
+ */
+typedef struct aout_ring aout_ring_t;
+
+/**
+ * Creates an audio ring.
+ *
+ * \param size minimum capacity in bytes (rounded up to a power of two)
+ * \return the ring or NULL on allocation error
+ */
+VLC_API aout_ring_t *aout_ring_New(size_t size) VLC_USED;
+VLC_API void aout_ring_Delete(aout_ring_t *);
+
+/**
+ * Copies up to \p size bytes into the ring (producer side).
+ *
+ * \return the number of bytes written, less than \p size if the ring is full
+ */
+VLC_API size_t aout_ring_Write(aout_ring_t *, const void *buf, size_t size);
+
+/**
+ * Copies up to \p size bytes out of the ring (consumer side).
+ *
+ * \return the number of bytes read, less than \p size on underrun
+ */
+VLC_API size_t aout_ring_Read(aout_ring_t *, void *buf, size_t size);
+
+/**
+ * Returns the number of bytes queued and not yet read nor flushed.
+ * This can be called from either side.
+ */
+VLC_API size_t aout_ring_Used(aout_ring_t *) VLC_USED;
+
+/**
+ * Discards all the data written so far (producer side).
+ *
+ * The consumer skips the discarded bytes on its next read. Until then, they
+ * are not accounted by aout_ring_Used() but still occupy space.
+ */
+VLC_API void aout_ring_Flush(aout_ring_t *);
+
+/** @} */
+
 /** @} */
 
 #endif /* VLC_AOUT_H */
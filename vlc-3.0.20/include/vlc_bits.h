@@ -105,6 +105,18 @@ static inline uint32_t bs_read( bs_t *s, int i_count )
         i_count = 32;
     }
 
+    /* fast path: extract the bits from a single 64-bit window */
+    if( s->pf_forward == NULL && i_count > 0 && s->p_end - s->p >= 8 )
+    {
+        const unsigned i_used = 8 - s->i_left;
+        const uint64_t i_window = GetQWBE( s->p ) << i_used;
+
+        i_result = i_window >> ( 64 - i_count );
+        s->p += ( i_used + i_count ) / 8;
+        s->i_left = 8 - ( i_used + i_count ) % 8;
+        i_count = 0;
+    }
+
     while( i_count > 0 )
     {
         if( s->p >= s->p_end )
@@ -249,6 +261,20 @@ static inline uint_fast32_t bs_read_ue( bs_t * bs )
 {
     unsigned i = 0;
 
+    /* fast path: codes of up to 31 bits, from a single 32-bit window */
+    if( bs->pf_forward == NULL && bs->p_end - bs->p >= 8 )
+    {
+        const uint32_t i_window = GetQWBE( bs->p ) << ( 8 - bs->i_left ) >> 32;
+
+        if( i_window >= 0x10000 )
+        {
+            const unsigned i_length = 2 * clz32( i_window ) + 1;
+
+            bs_skip( bs, i_length );
+            return ( i_window >> ( 32 - i_length ) ) - 1;
+        }
+    }
+
     while( bs_read1( bs ) == 0 && bs->p < bs->p_end && i < 31 )
         i++;
 
@@ -124,6 +124,7 @@ struct block_t
     vlc_tick_t  i_pts;
     vlc_tick_t  i_dts;
     vlc_tick_t  i_length;
+    vlc_tick_t  i_ingest; /**< Date the block reached the ES output */
 
     /* Rudimentary support for overloading block (de)allocation. */
     block_free_t pf_release;
@@ -144,6 +145,28 @@ VLC_API block_t *block_Alloc(size_t size) VLC_USED VLC_MALLOC;
 
 VLC_API block_t *block_TryRealloc(block_t *, ssize_t pre, size_t body) VLC_USED;
 
+/**
+ * Block allocator statistics.
+ *
+ * Small blocks from block_Alloc() are recycled through per-thread caches and
+ * a global pool. These counters are cumulative since process start-up.
+ */
+typedef struct block_pool_stats_t
+{
+    uint64_t i_thread_hits; /**< allocations served by a thread cache */
+    uint64_t i_global_hits; /**< allocations served by the global pool */
+    uint64_t i_misses; /**< poolable allocations that hit the heap */
+    uint64_t i_unpooled; /**< allocations too large to be pooled */
+} block_pool_stats_t;
+
+/**
+ * Gets block allocator statistics.
+ *
+ * @note Counters of other threads caches are aggregated periodically; the
+ * returned values are therefore approximate.
+ */
+VLC_API void block_PoolGetStats(block_pool_stats_t *);
+
 /**
  * Reallocates a block.
  *
@@ -191,6 +214,7 @@ static inline void block_CopyProperties( block_t *dst, block_t *src )
     dst->i_dts     = src->i_dts;
     dst->i_pts     = src->i_pts;
     dst->i_length  = src->i_length;
+    dst->i_ingest  = src->i_ingest;
 }
 
 /**
@@ -213,6 +237,30 @@ static inline block_t *block_Duplicate( block_t *p_block )
     return p_dup;
 }
 
+/**
+ * Shares the payload of a block.
+ *
+ * Creates a block with the same properties and payload as the given one,
+ * without copying the data. The payload is reference counted, and freed
+ * along with the last block referring to it. Each block has its own header,
+ * so that it can be trimmed, chained or released independently.
+ *
+ * The payload of a shared block is read-only, see block_IsWritable().
+ * block_Realloc() and block_TryRealloc() copy it out as needed.
+ *
+ * @param pp_block pointer to the block to share; the first time, the block
+ *                 is replaced by a shared block, so *pp_block may change
+ * @return the new block on success, NULL on error (*pp_block stays valid).
+ */
+VLC_API block_t *block_Share(block_t **pp_block) VLC_USED;
+
+/**
+ * Checks whether the payload of a block can be modified in place.
+ *
+ * @return false if the payload is shared with other blocks, true otherwise
+ */
+VLC_API bool block_IsWritable(const block_t *) VLC_USED;
+
 /**
  * Wraps heap in a block.
  *
@@ -430,6 +478,21 @@ static inline block_t *block_ChainGather( block_t *p_list )
  */
 VLC_API block_fifo_t *block_FifoNew(void) VLC_USED VLC_MALLOC;
 
+/**
+ * Creates a single producer single consumer FIFO queue of blocks.
+ *
+ * This works as a FIFO from block_FifoNew(), except that blocks are normally
+ * exchanged through a lock-free ring buffer. vlc_fifo_Queue() can then queue
+ * blocks without holding the FIFO lock. Waiters on the FIFO are only woken
+ * up when it becomes non-empty.
+ *
+ * @warning Only one thread at a time may queue blocks, and only one thread
+ * at a time may dequeue blocks (with the FIFO locked).
+ *
+ * @return the FIFO or NULL on memory error
+ */
+VLC_API block_fifo_t *block_FifoNewSPSC(void) VLC_USED VLC_MALLOC;
+
 /**
  * Destroys a FIFO created by block_FifoNew().
  *
@@ -549,6 +612,21 @@ int vlc_fifo_TimedWaitCond(vlc_fifo_t *, vlc_cond_t *, vlc_tick_t);
  */
 VLC_API void vlc_fifo_QueueUnlocked(vlc_fifo_t *, block_t *);
 
+/**
+ * Queues a linked-list of blocks into an unlocked FIFO.
+ *
+ * With a FIFO from block_FifoNewSPSC(), this normally does not take the FIFO
+ * lock. Otherwise, this is equivalent to block_FifoPut().
+ *
+ * @param block the head of the list of blocks
+ *              (if NULL, this function has no effects)
+ *
+ * @note This function is not a cancellation point.
+ *
+ * @warning The FIFO must not be locked by the calling thread.
+ */
+VLC_API void vlc_fifo_Queue(vlc_fifo_t *, block_t *);
+
 /**
  * Dequeues the first block from a locked FIFO, if any.
  *
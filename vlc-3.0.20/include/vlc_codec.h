@@ -156,6 +156,12 @@ struct decoder_t
      */
     int             i_extra_picture_buffers;
 
+    /**
+     * Alignment, in bytes, of the plane pointers and pitches of the
+     * pictures the decoder renders into directly (0 if none is needed).
+     */
+    unsigned        i_picture_align;
+
     /* Audio output callbacks */
     int             (*pf_aout_format_update)( decoder_t * );
 
@@ -232,6 +238,10 @@ struct encoder_t
     int i_bframes;               /* One B frame per i_bframes */
     int i_tolerance;             /* Bitrate tolerance */
 
+    /* Pictures held by the encoder before the first output, or -1 if
+     * unknown. Set by the encoder module when opened */
+    int i_delay;
+
     /* Encoder config */
     config_chain_t *p_cfg;
 };
@@ -28,6 +28,37 @@
 
 VLC_API unsigned vlc_CPU(void);
 
+/**
+ * Implementation variant of a processing kernel.
+ */
+typedef struct vlc_cpu_kernel
+{
+    const char *name; /**< Variant name, e.g. "sse2" (for overrides) */
+    unsigned flags; /**< vlc_CPU() flags required by the variant */
+    const void *impl; /**< Implementation (usually a table of functions) */
+} vlc_cpu_kernel_t;
+
+/**
+ * Selects the best kernel variant for the CPU.
+ *
+ * Modules should call this once when they are opened, and keep the result,
+ * rather than checking the CPU capabilities on every call.
+ *
+ * The VLC_CPU_KERNELS environment variable can force a given variant for
+ * benchmarking, as a comma-separated list of kind=name pairs, where kind
+ * can be "*" to match all kernels (e.g. "*=c").
+ *
+ * @param kind name of the kernel set
+ * @param tab variants, from the most to the least preferred
+ * (the last one should require no flags)
+ * @param count number of variants
+ * @return the implementation of the selected variant,
+ * or NULL if none is supported
+ */
+VLC_API const void *vlc_CPU_SelectKernel(const char *kind,
+                                         const vlc_cpu_kernel_t *tab,
+                                         size_t count);
+
 # if defined (__i386__) || defined (__x86_64__)
 #  define HAVE_FPU 1
 #  define VLC_CPU_MMX    0x00000008
@@ -76,6 +76,8 @@ struct demux_t
     es_out_t    *out;   /* our p_es_out */
 
     bool         b_preparsing; /* True if the demux is used to preparse */
+    bool         b_preparse_lite; /* True if preparsing only needs the
+                                     headers: duration, tracks and tags */
 
     /* set by demuxer */
     int (*pf_demux)  ( demux_t * );   /* demux one frame only */
@@ -329,7 +331,14 @@ enum demux_query_e
      * work in future VLC versions, nor with all demux filters
      */
     DEMUX_FILTER_ENABLE,
-    DEMUX_FILTER_DISABLE
+    DEMUX_FILTER_DISABLE,
+
+    /** Hints that only the keyframes of the video tracks will be decoded,
+     * during fast trick play. The demuxer may then skip the other frames.
+     * Can fail.
+     *
+     * arg1= bool */
+    DEMUX_SET_KEYFRAMES_ONLY,
 };
 
 /*************************************************************************
@@ -431,6 +440,24 @@ VLC_API decoder_t * demux_PacketizerNew( demux_t *p_demux, es_format_t *p_fmt, c
  */
 VLC_API void demux_PacketizerDestroy( decoder_t *p_packetizer );
 
+/**
+ * Loads the data stored with demux_CacheStore() under the same name for
+ * the same local file, provided the file did not change since.
+ *
+ * \return a block to release, or NULL if there is nothing (usable) cached
+ */
+VLC_API block_t * demux_CacheLoad( demux_t *p_demux, const char *psz_name ) VLC_USED;
+
+/**
+ * Stores opaque demuxer state, for instance a seek index, to be restored
+ * by demux_CacheLoad() when the same local file is opened again.
+ *
+ * The cache is keyed by the file path, size and modification time, and is
+ * only available for local files.
+ */
+VLC_API int demux_CacheStore( demux_t *p_demux, const char *psz_name,
+                              const void *p_data, size_t i_data );
+
 /* */
 #define DEMUX_INIT_COMMON() do {            \
     p_demux->pf_control = Control;          \
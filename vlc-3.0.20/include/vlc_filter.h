@@ -149,6 +149,12 @@ struct filter_t
 
     /* Private structure for the owner of the decoder */
     filter_owner_t      owner;
+
+    /** Set by audio filters that handle blocks of any size, filter them
+     * in place or into new blocks, and never keep or reallocate their input
+     * blocks past pf_audio_filter: such filters can be run on chunks of
+     * frames of a larger block (audio filter) */
+    bool                b_audio_chunks;
 };
 
 /**
@@ -278,6 +284,36 @@ VLC_API int filter_Blend( filter_t *, picture_t *p_dst, int i_dst_x, int i_dst_y
  */
 VLC_API void filter_DeleteBlend( filter_t * );
 
+/**
+ * It holds the slice threads shared by all filters.
+ *
+ * Filters processing horizontal bands of pictures independently should call
+ * it when opening, so that filter_RunSlices() can run in parallel.
+ *
+ * \return the number of bands that can be processed at the same time
+ */
+VLC_API unsigned filter_HoldSlices( filter_t * );
+
+/**
+ * It releases the slice threads held by filter_HoldSlices().
+ */
+VLC_API void filter_ReleaseSlices( filter_t * );
+
+/**
+ * It runs a function on horizontal bands of lines, in parallel.
+ *
+ * The lines [0, i_lines) are split into bands of a multiple of i_align lines
+ * (except the last one), and pf_slice is called once per band with its first
+ * line and its number of lines, either from the calling thread or from the
+ * slice threads. It returns once all the bands are processed.
+ *
+ * Without filter_HoldSlices(), everything runs on the calling thread.
+ */
+VLC_API void filter_RunSlices( filter_t *, unsigned i_lines, unsigned i_align,
+                               void (*pf_slice)( filter_t *, void *,
+                                                 unsigned i_first, unsigned i_count ),
+                               void *p_data );
+
 /**
  * Create a picture_t *(*)( filter_t *, picture_t * ) compatible wrapper
  * using a void (*)( filter_t *, picture_t *, picture_t * ) function
@@ -298,6 +334,37 @@ VLC_API void filter_DeleteBlend( filter_t * );
         return p_outpic;                                                \
     }
 
+/**
+ * Same as VIDEO_FILTER_WRAPPER, but using a
+ * void (*)( filter_t *, picture_t *, picture_t *, unsigned i_first,
+ * unsigned i_count ) function converting the lines [i_first,
+ * i_first + i_count) of the input picture, run with filter_RunSlices()
+ * on bands of i_align lines.
+ */
+#define VIDEO_FILTER_SLICES_WRAPPER( name, i_align )                    \
+    static void name ## _Slice ( filter_t *p_filter, void *p_data,      \
+                                 unsigned i_first, unsigned i_count )   \
+    {                                                                   \
+        picture_t **pp_pics = p_data;                                   \
+        name( p_filter, pp_pics[0], pp_pics[1], i_first, i_count );     \
+    }                                                                   \
+    static picture_t *name ## _Filter ( filter_t *p_filter,             \
+                                        picture_t *p_pic )              \
+    {                                                                   \
+        picture_t *p_outpic = filter_NewPicture( p_filter );            \
+        if( p_outpic )                                                  \
+        {                                                               \
+            picture_t *pp_pics[2] = { p_pic, p_outpic };                \
+            filter_RunSlices( p_filter,                                 \
+                              p_filter->fmt_in.video.i_y_offset         \
+                            + p_filter->fmt_in.video.i_visible_height,  \
+                              i_align, name ## _Slice, pp_pics );       \
+            picture_CopyProperties( p_outpic, p_pic );                  \
+        }                                                               \
+        picture_Release( p_pic );                                       \
+        return p_outpic;                                                \
+    }
+
 /**
  * Filter chain management API
  * The filter chain management API is used to dynamically construct filters
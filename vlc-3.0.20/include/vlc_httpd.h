@@ -118,6 +118,21 @@ VLC_API void httpd_UrlDelete( httpd_url_t * );
 VLC_API char* httpd_ClientIP( const httpd_client_t *cl, char *, int * );
 VLC_API char* httpd_ServerIP( const httpd_client_t *cl, char *, int * );
 
+/**
+ * Answers the current query of a client progressively.
+ *
+ * This is called from a URL callback, before it returns its first answer.
+ * Once that answer is sent, the callback is called again with the answer
+ * body offset preserved, whenever the client is ready for more data, and
+ * about every 20 ms while the callback has nothing to send. The callback
+ * sends data by setting the answer type, and ends the answer by setting
+ * the body offset to zero.
+ *
+ * HTTP/1.1 clients get a chunked body and may reuse the connection
+ * afterwards; other clients get a body delimited by the connection close.
+ */
+VLC_API void httpd_ClientStream( httpd_client_t *cl, httpd_message_t *answer );
+
 /* High level */
 
 typedef struct httpd_file_t     httpd_file_t;
@@ -125,6 +140,9 @@ typedef struct httpd_file_sys_t httpd_file_sys_t;
 typedef int (*httpd_file_callback_t)( httpd_file_sys_t *, httpd_file_t *, uint8_t *psz_request, uint8_t **pp_data, int *pi_data );
 VLC_API httpd_file_t * httpd_FileNew( httpd_host_t *, const char *psz_url, const char *psz_mime, const char *psz_user, const char *psz_password, httpd_file_callback_t pf_fill, httpd_file_sys_t * ) VLC_USED;
 VLC_API httpd_file_sys_t * httpd_FileDelete( httpd_file_t * );
+/* Serves psz_path from disk, with Range and ETag support; delete with
+ * httpd_FileDelete(), which then returns NULL. */
+VLC_API httpd_file_t * httpd_FilePathNew( httpd_host_t *, const char *psz_url, const char *psz_path, const char *psz_mime, const char *psz_user, const char *psz_password ) VLC_USED;
 
 
 typedef struct httpd_handler_t  httpd_handler_t;
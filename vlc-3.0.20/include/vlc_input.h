@@ -312,7 +312,7 @@ typedef enum input_state_e
 /**
  * Minimal rate value
  */
-#define INPUT_RATE_MIN        32            /* Up to 32/1 */
+#define INPUT_RATE_MIN        16            /* Up to 64/1 */
 /**
  * Maximal rate value
  */
@@ -699,5 +699,22 @@ VLC_API void input_resource_PutAout( input_resource_t *, audio_output_t * );
  */
 VLC_API void input_resource_ResetAout( input_resource_t * );
 
+/**
+ * Shows the output of the decoders using the first resource through the
+ * outputs of the second one as well, i.e. with the video and audio outputs
+ * of another player, without demuxing and decoding the input twice.
+ *
+ * Pictures of opaque (hardware) chromas are not mirrored.
+ */
+VLC_API int input_resource_AddMirror( input_resource_t *, input_resource_t * );
+
+/**
+ * Stops mirroring the decoders output to the given resource.
+ *
+ * The video and audio outputs of the decoders in the mirror resource are
+ * closed before this function returns.
+ */
+VLC_API void input_resource_RemoveMirror( input_resource_t *, input_resource_t * );
+
 /** @} */
 #endif
@@ -102,6 +102,10 @@ struct input_item_t
 
     bool        b_preparse_interact; /**< Force interaction with the user when
                                           preparsing.*/
+    bool        b_preparse_background; /**< Preparse and fetch art with a low
+                                            priority */
+    bool        b_preparse_lite;     /**< Only parse the container headers when
+                                          preparsing */
 };
 
 enum input_item_type_e
@@ -365,7 +369,9 @@ typedef enum input_item_meta_request_option_t
     META_REQUEST_OPTION_SCOPE_LOCAL   = 0x01,
     META_REQUEST_OPTION_SCOPE_NETWORK = 0x02,
     META_REQUEST_OPTION_SCOPE_ANY     = 0x03,
-    META_REQUEST_OPTION_DO_INTERACT   = 0x04
+    META_REQUEST_OPTION_DO_INTERACT   = 0x04,
+    META_REQUEST_OPTION_BACKGROUND    = 0x08,
+    META_REQUEST_OPTION_PARSE_LITE    = 0x10
 } input_item_meta_request_option_t;
 
 /* status of the vlc_InputItemPreparseEnded event */
@@ -387,6 +393,47 @@ VLC_API void libvlc_MetadataCancel( libvlc_int_t *, void * );
 /******************
  * Input stats
  ******************/
+
+/**
+ * Video output timing histograms. Bucket i counts the durations shorter
+ * than 2^i milliseconds that did not fit in the previous buckets (negative
+ * durations land in the first one), and the last bucket the longer ones.
+ */
+#define INPUT_STATS_TIMING_BUCKETS 12
+
+enum input_stats_vout_timing
+{
+    INPUT_STATS_VOUT_LEAD, /**< time left before the display date, when the
+                                picture reaches the video output */
+    INPUT_STATS_VOUT_FILTER, /**< static filters (e.g. deinterlacing) */
+    INPUT_STATS_VOUT_INTERACTIVE_FILTER, /**< user video filters */
+    INPUT_STATS_VOUT_SPU, /**< subpicture rendering */
+    INPUT_STATS_VOUT_PREPARE, /**< blending, copies and display preparation */
+    INPUT_STATS_VOUT_DISPLAY, /**< display */
+    INPUT_STATS_VOUT_LATE, /**< display date minus the picture date */
+    INPUT_STATS_VOUT_TIMINGS
+};
+
+/**
+ * End-to-end latency histograms, from the ES output to the display. The first
+ * bucket counts the latencies shorter than 1024 microseconds, the following
+ * ones split each octave from there in four, and the last bucket counts the
+ * latencies longer than about 33 seconds.
+ */
+#define INPUT_STATS_LATENCY_BUCKETS 62
+
+static inline unsigned input_stats_LatencyBucket(vlc_tick_t latency)
+{
+    unsigned octave = 0;
+
+    if (latency < 1024)
+        return 0;
+    while (latency >= ((vlc_tick_t)2048 << octave))
+        if (++octave == (INPUT_STATS_LATENCY_BUCKETS - 2) / 4)
+            return INPUT_STATS_LATENCY_BUCKETS - 1;
+    return 1 + 4 * octave + ((latency >> (octave + 8)) & 3);
+}
+
 struct input_stats_t
 {
     vlc_mutex_t         lock;
@@ -412,6 +459,10 @@ struct input_stats_t
     /* Vout */
     int64_t i_displayed_pictures;
     int64_t i_lost_pictures;
+    uint64_t vout_timings[INPUT_STATS_VOUT_TIMINGS][INPUT_STATS_TIMING_BUCKETS];
+    vlc_tick_t i_video_latency_p50;
+    vlc_tick_t i_video_latency_p90;
+    vlc_tick_t i_video_latency_p99;
 
     /* Sout */
     int64_t i_sent_packets;
@@ -421,6 +472,9 @@ struct input_stats_t
     /* Aout */
     int64_t i_played_abuffers;
     int64_t i_lost_abuffers;
+    vlc_tick_t i_audio_latency_p50;
+    vlc_tick_t i_audio_latency_p90;
+    vlc_tick_t i_audio_latency_p99;
 };
 
 /**
@@ -47,6 +47,62 @@ static inline void *realloc_or_free( void *p, size_t sz )
     return n;
 }
 
+/**
+ * @}
+ */
+
+/**
+ * \defgroup memory_budget Memory budget
+ * \ingroup memory
+ * @{
+ * Buffers that grow with the input (decoder queues, read-ahead caches...)
+ * register with the memory budget of the LibVLC instance (--memory-budget),
+ * report their current size, and check the budget before growing.
+ * Users of lower priority are refused first.
+ */
+
+enum vlc_memory_priority
+{
+    VLC_MEMORY_LOW, /**< read-ahead caches, up to half of the budget */
+    VLC_MEMORY_NORMAL, /**< queues of pending data, up to 90% */
+    VLC_MEMORY_HIGH, /**< data needed to make progress, whole budget */
+};
+
+typedef struct vlc_memory_user vlc_memory_user_t;
+
+/**
+ * Registers a memory user.
+ *
+ * \return a user handle, or NULL if the instance has no memory budget.
+ * NULL is a valid handle for the other functions (the budget is then never
+ * exceeded).
+ */
+VLC_API vlc_memory_user_t *vlc_memory_Register(vlc_object_t *,
+                                               enum vlc_memory_priority)
+VLC_USED;
+#define vlc_memory_Register(o, p) vlc_memory_Register(VLC_OBJECT(o), p)
+
+/**
+ * Unregisters a memory user, releasing its share of the budget.
+ */
+VLC_API void vlc_memory_Unregister(vlc_memory_user_t *);
+
+/**
+ * Reports the current size of the buffers of a user.
+ *
+ * This is not thread-safe with respect to the same user.
+ */
+VLC_API void vlc_memory_Set(vlc_memory_user_t *, size_t size);
+
+/**
+ * Checks whether a user can grow its buffers.
+ *
+ * \param extra number of bytes the user is about to add
+ * \return true if the budget allows it, false if the user should wait for
+ * its buffers to drain, shrink them or drop data
+ */
+VLC_API bool vlc_memory_Allow(const vlc_memory_user_t *, size_t extra);
+
 /**
  * @}
  */
@@ -81,6 +81,7 @@ struct picture_t
     /**@{*/
     vlc_tick_t      date;                                  /**< display date */
     bool            b_force;
+    vlc_tick_t      ingest;    /**< date the data reached the ES output */
     /**@}*/
 
     /** \name Picture dynamic properties
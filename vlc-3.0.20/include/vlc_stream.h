@@ -89,7 +89,7 @@ struct stream_t
      * (*eof is always false when invoking pf_block(); pf_block() should set
      *  *eof to true if it detects the end of the stream)
      *
-     * \return a data block,
+     * \return a data block or a chain of data blocks,
      * NULL if no data available yet, on error and at end-of-stream
      */
     block_t    *(*pf_block)(stream_t *, bool *eof);
@@ -154,6 +154,8 @@ enum stream_query_e
     STREAM_GET_CONTENT_TYPE,    /**< arg1= char **         res=can fail */
     STREAM_GET_SIGNAL,      /**< arg1=double *pf_quality, arg2=double *pf_strength   res=can fail */
     STREAM_GET_TAGS,        /**< arg1=const block_t ** res=can fail */
+    STREAM_GET_CONSUME_RATE, /**< arg1= uint64_t * (bytes/s) res=can fail */
+    STREAM_GET_ACCESS_LATENCY, /**< arg1= mtime_t *     res=can fail */
 
     STREAM_SET_PAUSE_STATE = 0x200, /**< arg1= bool        res=can fail */
     STREAM_SET_TITLE,       /**< arg1= int          res=can fail */
@@ -231,7 +233,9 @@ VLC_API ssize_t vlc_stream_Peek(stream_t *, const uint8_t **, size_t) VLC_USED;
  * This function should be used instead of vlc_stream_Read() or
  * vlc_stream_Peek() when the caller can handle reads of any size.
  *
- * \return either a data block or NULL
+ * \note The returned block may be the head of a chain of blocks.
+ *
+ * \return either a data block (chain) or NULL
  */
 VLC_API block_t *vlc_stream_ReadBlock(stream_t *) VLC_USED;
 
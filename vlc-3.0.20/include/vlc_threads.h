@@ -946,6 +946,29 @@ VLC_API unsigned vlc_timer_getoverrun(vlc_timer_t) VLC_USED;
  */
 VLC_API unsigned vlc_GetCPUCount(void);
 
+/**
+ * Reserves a share of the CPUs for a decoder.
+ *
+ * Decoders running at the same time in the process share the CPUs
+ * according to their picture sizes: the returned count is the share of the
+ * given size among all the current reservations, including this one.
+ * Decoders cannot change their thread count once started, so the balance is
+ * restored as decoders are (re)created.
+ *
+ * Each call must be paired with vlc_ReleaseDecoderThreads() with the same
+ * picture dimensions.
+ *
+ * \param width picture width (0 if unknown)
+ * \param height picture height (0 if unknown)
+ * \return number of threads the decoder should use (at least 1)
+ */
+VLC_API unsigned vlc_AcquireDecoderThreads(unsigned width, unsigned height);
+
+/**
+ * Releases a reservation made with vlc_AcquireDecoderThreads().
+ */
+VLC_API void vlc_ReleaseDecoderThreads(unsigned width, unsigned height);
+
 enum
 {
     VLC_CLEANUP_PUSH,
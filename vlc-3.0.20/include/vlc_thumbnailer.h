@@ -0,0 +1,78 @@
+/*****************************************************************************
+ * vlc_thumbnailer.h: headless keyframe thumbnailer
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_THUMBNAILER_H
+#define VLC_THUMBNAILER_H
+
+#include <vlc_picture.h>
+
+/**
+ * \defgroup thumbnailer Thumbnailer
+ * \ingroup input
+ *
+ * Extracts still pictures from a media without playing it.
+ *
+ * The thumbnailer drives a demuxer and a video decoder directly: there is no
+ * input thread, no clock and no audio or video output. Each capture seeks to
+ * the nearest keyframe before the requested time, decodes the first picture
+ * from there and scales it with the fastest available converter. A single
+ * thumbnailer can serve any number of captures on the same media.
+ *
+ * The thumbnailer is not thread-safe; it is meant to be used by one thread.
+ * @{
+ */
+
+typedef struct vlc_thumbnailer_t vlc_thumbnailer_t;
+
+/**
+ * Opens a media for thumbnailing.
+ *
+ * \param obj parent object
+ * \param item input item to open
+ * \return a thumbnailer, or NULL if the media has no decodable video
+ */
+VLC_API vlc_thumbnailer_t *vlc_thumbnailer_Create(vlc_object_t *obj,
+                                                  input_item_t *item) VLC_USED;
+#define vlc_thumbnailer_Create(a, b) vlc_thumbnailer_Create(VLC_OBJECT(a), b)
+
+/**
+ * Captures the picture at the keyframe nearest before a given time.
+ *
+ * On input, the chroma and dimensions of the format are the requested ones;
+ * zero values keep those of the decoded picture, and a single zero dimension
+ * preserves the aspect ratio. On output, the format describes the returned
+ * picture.
+ *
+ * \param time media time to capture
+ * \param fmt requested and actual output format [IN/OUT]
+ * \return a picture (release with picture_Release()), or NULL on error
+ */
+VLC_API picture_t *vlc_thumbnailer_Capture(vlc_thumbnailer_t *,
+                                           mtime_t time,
+                                           video_format_t *fmt) VLC_USED;
+
+/**
+ * Closes a thumbnailer.
+ */
+VLC_API void vlc_thumbnailer_Delete(vlc_thumbnailer_t *);
+
+/** @} */
+
+#endif
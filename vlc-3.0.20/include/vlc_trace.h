@@ -0,0 +1,61 @@
+/*****************************************************************************
+ * vlc_trace.h: trace events
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_TRACE_H
+#define VLC_TRACE_H 1
+
+/**
+ * \defgroup trace Trace events
+ * \ingroup os
+ * Timed spans and instants, to attribute latency across threads.
+ *
+ * Events are only recorded if VLC was configured with --enable-trace, and
+ * the --trace-file option is set. They are written there, in the Chrome
+ * trace event format (as read by chrome://tracing and Perfetto), when LibVLC
+ * is destroyed. Otherwise, events are dropped as soon as they are emitted.
+ *
+ * The category and name of an event must be string literals (or otherwise
+ * outlive the LibVLC instance): only their pointers are recorded.
+ * @{
+ */
+
+enum vlc_trace_type
+{
+    VLC_TRACE_BEGIN, /**< Start of a span on the calling thread */
+    VLC_TRACE_END, /**< End of the last span started on the calling thread */
+    VLC_TRACE_INSTANT, /**< Instant event */
+};
+
+/**
+ * Records a trace event on the calling thread.
+ *
+ * \note Use the vlc_trace_*() macros rather than this function.
+ */
+VLC_API void vlc_trace_event(int type, const char *category, const char *name);
+
+#define vlc_trace_begin(cat, name) \
+    vlc_trace_event(VLC_TRACE_BEGIN, cat, name)
+#define vlc_trace_end(cat, name) \
+    vlc_trace_event(VLC_TRACE_END, cat, name)
+#define vlc_trace_instant(cat, name) \
+    vlc_trace_event(VLC_TRACE_INSTANT, cat, name)
+
+/** @} */
+#endif
@@ -53,6 +53,7 @@ typedef struct {
     bool                 change_fmt;
     const video_format_t *fmt;
     unsigned             dpb_size;
+    unsigned             picture_align;
 } vout_configuration_t;
 
 /**
@@ -34,9 +34,11 @@
 #include <vlc/libvlc_events.h>
 
 #include <vlc_common.h>
+#include <vlc_image.h>
 #include <vlc_input.h>
 #include <vlc_meta.h>
 #include <vlc_playlist.h> /* For the preparser */
+#include <vlc_thumbnailer.h>
 #include <vlc_url.h>
 
 #include "../src/libvlc.h"
@@ -730,6 +732,67 @@ int libvlc_media_get_stats( libvlc_media_t *p_md,
     p_stats->i_sent_packets = p_itm_stats->i_sent_packets;
     p_stats->i_sent_bytes = p_itm_stats->i_sent_bytes;
     p_stats->f_send_bitrate = p_itm_stats->f_send_bitrate;
+
+    p_stats->i_video_latency_p50 = p_itm_stats->i_video_latency_p50;
+    p_stats->i_video_latency_p90 = p_itm_stats->i_video_latency_p90;
+    p_stats->i_video_latency_p99 = p_itm_stats->i_video_latency_p99;
+    p_stats->i_audio_latency_p50 = p_itm_stats->i_audio_latency_p50;
+    p_stats->i_audio_latency_p90 = p_itm_stats->i_audio_latency_p90;
+    p_stats->i_audio_latency_p99 = p_itm_stats->i_audio_latency_p99;
+    vlc_mutex_unlock( &p_itm_stats->lock );
+    vlc_mutex_unlock( &item->lock );
+    return true;
+}
+
+int libvlc_media_get_video_timings( libvlc_media_t *p_md,
+                                    libvlc_media_video_timings_t *p_timings )
+{
+    static_assert( LIBVLC_VIDEO_TIMING_BUCKETS == INPUT_STATS_TIMING_BUCKETS,
+                   "Mismatched timing buckets" );
+    input_item_t *item = p_md->p_input_item;
+
+    if( !p_md->p_input_item )
+        return false;
+
+    vlc_mutex_lock( &item->lock );
+
+    input_stats_t *p_itm_stats = p_md->p_input_item->p_stats;
+    if( p_itm_stats == NULL )
+    {
+        vlc_mutex_unlock( &item->lock );
+        return false;
+    }
+
+    static const struct
+    {
+        enum input_stats_vout_timing timing;
+        size_t offset;
+    } histograms[] = {
+        { INPUT_STATS_VOUT_LEAD,
+          offsetof( libvlc_media_video_timings_t, i_lead ) },
+        { INPUT_STATS_VOUT_FILTER,
+          offsetof( libvlc_media_video_timings_t, i_filter ) },
+        { INPUT_STATS_VOUT_INTERACTIVE_FILTER,
+          offsetof( libvlc_media_video_timings_t, i_interactive_filter ) },
+        { INPUT_STATS_VOUT_SPU,
+          offsetof( libvlc_media_video_timings_t, i_spu ) },
+        { INPUT_STATS_VOUT_PREPARE,
+          offsetof( libvlc_media_video_timings_t, i_prepare ) },
+        { INPUT_STATS_VOUT_DISPLAY,
+          offsetof( libvlc_media_video_timings_t, i_display ) },
+        { INPUT_STATS_VOUT_LATE,
+          offsetof( libvlc_media_video_timings_t, i_late ) },
+    };
+
+    vlc_mutex_lock( &p_itm_stats->lock );
+    for( size_t i = 0; i < ARRAY_SIZE( histograms ); i++ )
+    {
+        unsigned *p_buckets = (unsigned *)
+            ( (char *)p_timings + histograms[i].offset );
+        for( unsigned j = 0; j < LIBVLC_VIDEO_TIMING_BUCKETS; j++ )
+            p_buckets[j] =
+                p_itm_stats->vout_timings[histograms[i].timing][j];
+    }
     vlc_mutex_unlock( &p_itm_stats->lock );
     vlc_mutex_unlock( &item->lock );
     return true;
@@ -789,8 +852,11 @@ static int media_parse(libvlc_media_t *media, bool b_async,
          * by libvlc_MetadataRequest */
         if (parse_flag & libvlc_media_fetch_network)
         {
-            ret = libvlc_ArtRequest(libvlc, item,
-                                    META_REQUEST_OPTION_SCOPE_NETWORK);
+            input_item_meta_request_option_t fetch_scope =
+                META_REQUEST_OPTION_SCOPE_NETWORK;
+            if (parse_flag & libvlc_media_parse_background)
+                fetch_scope |= META_REQUEST_OPTION_BACKGROUND;
+            ret = libvlc_ArtRequest(libvlc, item, fetch_scope);
             if (ret != VLC_SUCCESS)
                 return ret;
         }
@@ -799,6 +865,10 @@ static int media_parse(libvlc_media_t *media, bool b_async,
             parse_scope |= META_REQUEST_OPTION_SCOPE_NETWORK;
         if (parse_flag & libvlc_media_do_interact)
             parse_scope |= META_REQUEST_OPTION_DO_INTERACT;
+        if (parse_flag & libvlc_media_parse_background)
+            parse_scope |= META_REQUEST_OPTION_BACKGROUND;
+        if (parse_flag & libvlc_media_parse_lite)
+            parse_scope |= META_REQUEST_OPTION_PARSE_LITE;
         ret = libvlc_MetadataRequest(libvlc, item, parse_scope, timeout, media);
         if (ret != VLC_SUCCESS)
             return ret;
@@ -1285,3 +1355,133 @@ void libvlc_media_slaves_release( libvlc_media_slave_t **pp_slaves,
     }
     free( pp_slaves );
 }
+
+struct libvlc_media_thumbnailer_t
+{
+    vlc_thumbnailer_t *p_thumbnailer;
+    image_handler_t *p_image;
+};
+
+libvlc_media_thumbnailer_t *
+libvlc_media_thumbnailer_new( libvlc_media_t *p_md )
+{
+    libvlc_int_t *p_libvlc = p_md->p_libvlc_instance->p_libvlc_int;
+    libvlc_media_thumbnailer_t *p_th = malloc( sizeof( *p_th ) );
+    if( unlikely(p_th == NULL) )
+    {
+        libvlc_printerr( "Not enough memory" );
+        return NULL;
+    }
+
+    p_th->p_image = image_HandlerCreate( p_libvlc );
+    if( unlikely(p_th->p_image == NULL) )
+    {
+        libvlc_printerr( "Not enough memory" );
+        free( p_th );
+        return NULL;
+    }
+
+    p_th->p_thumbnailer = vlc_thumbnailer_Create( p_libvlc,
+                                                  p_md->p_input_item );
+    if( p_th->p_thumbnailer == NULL )
+    {
+        libvlc_printerr( "Cannot open media for thumbnailing" );
+        image_HandlerDelete( p_th->p_image );
+        free( p_th );
+        return NULL;
+    }
+    return p_th;
+}
+
+int libvlc_media_thumbnailer_take( libvlc_media_thumbnailer_t *p_th,
+                                   libvlc_time_t i_time,
+                                   const char *psz_format,
+                                   unsigned *pi_width, unsigned *pi_height,
+                                   void **pp_data, size_t *pi_size )
+{
+    video_format_t fmt;
+    vlc_fourcc_t i_codec = 0;
+
+    if( psz_format != NULL )
+    {
+        i_codec = image_Type2Fourcc( psz_format );
+        if( i_codec == 0 )
+        {
+            libvlc_printerr( "Unknown image format: %s", psz_format );
+            return -1;
+        }
+    }
+
+    /* Encoders take whatever chroma the decoder produced */
+    video_format_Init( &fmt, psz_format != NULL ? 0 : VLC_CODEC_RGBA );
+    fmt.i_width = *pi_width;
+    fmt.i_height = *pi_height;
+
+    picture_t *p_pic = vlc_thumbnailer_Capture( p_th->p_thumbnailer,
+                                                to_mtime( i_time ), &fmt );
+    if( p_pic == NULL )
+    {
+        libvlc_printerr( "Cannot take thumbnail" );
+        return -1;
+    }
+
+    void *p_data;
+    size_t i_size;
+
+    if( psz_format != NULL )
+    {
+        video_format_t fmt_out;
+
+        video_format_Init( &fmt_out, i_codec );
+        fmt_out.i_width = fmt_out.i_visible_width = fmt.i_visible_width;
+        fmt_out.i_height = fmt_out.i_visible_height = fmt.i_visible_height;
+
+        block_t *p_block = image_Write( p_th->p_image, p_pic, &fmt,
+                                        &fmt_out );
+        picture_Release( p_pic );
+        if( p_block == NULL )
+        {
+            libvlc_printerr( "Cannot encode thumbnail" );
+            return -1;
+        }
+
+        i_size = p_block->i_buffer;
+        p_data = malloc( i_size );
+        if( likely(p_data != NULL) )
+            memcpy( p_data, p_block->p_buffer, i_size );
+        block_Release( p_block );
+    }
+    else
+    {
+        const plane_t *p_plane = &p_pic->p[0];
+        size_t i_pitch = 4 * (size_t)fmt.i_visible_width;
+
+        i_size = i_pitch * fmt.i_visible_height;
+        p_data = malloc( i_size );
+        if( likely(p_data != NULL) )
+            for( unsigned y = 0; y < fmt.i_visible_height; y++ )
+                memcpy( (uint8_t *)p_data + y * i_pitch,
+                        p_plane->p_pixels + 4 * fmt.i_x_offset
+                        + (y + fmt.i_y_offset) * p_plane->i_pitch, i_pitch );
+        picture_Release( p_pic );
+    }
+
+    if( unlikely(p_data == NULL) )
+    {
+        libvlc_printerr( "Not enough memory" );
+        return -1;
+    }
+
+    *pi_width = fmt.i_visible_width;
+    *pi_height = fmt.i_visible_height;
+    *pp_data = p_data;
+    *pi_size = i_size;
+    return 0;
+}
+
+void libvlc_media_thumbnailer_release( libvlc_media_thumbnailer_t *p_th )
+{
+    vlc_thumbnailer_Delete( p_th->p_thumbnailer );
+    image_HandlerDelete( p_th->p_image );
+    free( p_th );
+}
@@ -631,6 +631,9 @@ libvlc_media_player_new( libvlc_instance_t *instance )
     var_Create (mp, "vmem-data", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-setup", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-cleanup", VLC_VAR_ADDRESS);
+    var_Create (mp, "vmem-pool", VLC_VAR_ADDRESS);
+    var_Create (mp, "vmem-pool-display", VLC_VAR_ADDRESS);
+    var_Create (mp, "vmem-surface", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-chroma", VLC_VAR_STRING | VLC_VAR_DOINHERIT);
     var_Create (mp, "vmem-width", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
     var_Create (mp, "vmem-height", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
@@ -739,6 +742,7 @@ libvlc_media_player_new( libvlc_instance_t *instance )
     mp->p_libvlc_instance = instance;
     mp->input.p_thread = NULL;
     mp->input.p_renderer = NULL;
+    mp->input.p_mirror = NULL;
     mp->input.p_resource = input_resource_New(VLC_OBJECT(mp));
     if (unlikely(mp->input.p_resource == NULL))
     {
@@ -817,6 +821,12 @@ static void libvlc_media_player_destroy( libvlc_media_player_t *p_mi )
     /* No need for lock_input() because no other threads knows us anymore */
     if( p_mi->input.p_thread )
         release_input_thread(p_mi);
+    if( p_mi->input.p_mirror )
+    {
+        input_resource_RemoveMirror( p_mi->input.p_mirror->input.p_resource,
+                                     p_mi->input.p_resource );
+        libvlc_media_player_release( p_mi->input.p_mirror );
+    }
     input_resource_Terminate( p_mi->input.p_resource );
     input_resource_Release( p_mi->input.p_resource );
     if( p_mi->input.p_renderer )
@@ -1100,6 +1110,39 @@ int libvlc_media_player_set_renderer( libvlc_media_player_t *p_mi,
     return 0;
 }
 
+int libvlc_media_player_set_mirror( libvlc_media_player_t *p_mi,
+                                    libvlc_media_player_t *p_source )
+{
+    int ret = 0;
+
+    lock_input( p_mi );
+    if( p_mi->input.p_mirror )
+    {
+        input_resource_RemoveMirror( p_mi->input.p_mirror->input.p_resource,
+                                     p_mi->input.p_resource );
+        libvlc_media_player_release( p_mi->input.p_mirror );
+        p_mi->input.p_mirror = NULL;
+    }
+
+    if( p_source )
+    {
+        if( input_resource_AddMirror( p_source->input.p_resource,
+                                      p_mi->input.p_resource ) )
+        {
+            libvlc_printerr( "Cannot mirror this media player" );
+            ret = -1;
+        }
+        else
+        {
+            libvlc_media_player_retain( p_source );
+            p_mi->input.p_mirror = p_source;
+        }
+    }
+    unlock_input( p_mi );
+
+    return ret;
+}
+
 void libvlc_video_set_callbacks( libvlc_media_player_t *mp,
     void *(*lock_cb) (void *, void **),
     void (*unlock_cb) (void *, void *, void *const *),
@@ -1123,6 +1166,34 @@ void libvlc_video_set_format_callbacks( libvlc_media_player_t *mp,
     var_SetAddress( mp, "vmem-cleanup", cleanup );
 }
 
+void libvlc_video_set_pool_callbacks( libvlc_media_player_t *mp,
+                                      libvlc_video_pool_cb pool,
+                                      libvlc_video_pool_display_cb display,
+                                      void *opaque )
+{
+    var_SetAddress( mp, "vmem-pool", pool );
+    var_SetAddress( mp, "vmem-pool-display", display );
+    var_SetAddress( mp, "vmem-data", opaque );
+    var_SetString( mp, "avcodec-hw", "none" );
+    var_SetString( mp, "vout", "vmem" );
+    var_SetString( mp, "window", "none" );
+}
+
+void libvlc_video_set_surface_callbacks( libvlc_media_player_t *mp,
+                                         libvlc_video_surface_cb display,
+                                         void *opaque )
+{
+    var_SetAddress( mp, "vmem-surface", display );
+    var_SetAddress( mp, "vmem-data", opaque );
+    var_SetString( mp, "vout", "vmem" );
+    var_SetString( mp, "window", "none" );
+}
+
+void libvlc_video_buffer_release( libvlc_video_buffer_t *buffer )
+{
+    picture_Release( (picture_t *)buffer );
+}
+
 void libvlc_video_set_format( libvlc_media_player_t *mp, const char *chroma,
                               unsigned width, unsigned height, unsigned pitch )
 {
@@ -48,6 +48,7 @@ struct libvlc_media_player_t
         input_thread_t   *p_thread;
         input_resource_t *p_resource;
         vlc_renderer_item_t *p_renderer;
+        struct libvlc_media_player_t *p_mirror; /* player we mirror */
         vlc_mutex_t       lock;
     } input;
 
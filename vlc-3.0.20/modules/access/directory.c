@@ -42,6 +42,13 @@
 #include <vlc_fs.h>
 #include <vlc_url.h>
 
+/* The entry type reported by readdir() saves a stat() per entry, which is a
+ * network round trip on remote file systems. vlc_readdir() is plain readdir()
+ * on POSIX systems, except on OS/2 where it converts the file name. */
+#if defined(HAVE_OPENAT) && defined(DTTOIF) && !defined(__OS2__)
+# define DIR_ENTRY_TYPE 1
+#endif
+
 struct access_sys_t
 {
     char *base_uri;
@@ -127,22 +134,42 @@ int DirRead (stream_t *access, input_item_node_t *node)
     struct vlc_readdir_helper rdh;
     vlc_readdir_helper_init(&rdh, access, node);
 
-    while (ret == VLC_SUCCESS && (entry = vlc_readdir(sys->dir)) != NULL)
+    while (ret == VLC_SUCCESS)
     {
         struct stat st;
+        mode_t mode = 0;
         int type;
 
+#ifdef DIR_ENTRY_TYPE
+        struct dirent *ent = readdir(sys->dir);
+        if (ent == NULL)
+            break;
+        entry = ent->d_name;
+        mode = DTTOIF(ent->d_type);
+#else
+        entry = vlc_readdir(sys->dir);
+        if (entry == NULL)
+            break;
+#endif
+
+        /* Symbolic links are followed, and some file systems do not report
+         * the type of the entries */
+        if ((mode & S_IFMT) == 0 || S_ISLNK(mode))
+        {
 #ifdef HAVE_OPENAT
-        if (fstatat(dirfd(sys->dir), entry, &st, 0))
-            continue;
+            if (fstatat(dirfd(sys->dir), entry, &st, 0))
+                continue;
 #else
-        char *path;
+            char *path;
 
-        if (asprintf(&path, "%s"DIR_SEP"%s", access->psz_filepath, entry) == -1
-         || (type = vlc_stat(path, &st), free(path), type))
-            continue;
+            if (asprintf(&path, "%s"DIR_SEP"%s", access->psz_filepath, entry) == -1
+             || (type = vlc_stat(path, &st), free(path), type))
+                continue;
 #endif
-        switch (st.st_mode & S_IFMT)
+            mode = st.st_mode;
+        }
+
+        switch (mode & S_IFMT)
         {
             case S_IFBLK:
                 if (!special_files)
@@ -48,6 +48,10 @@
 #define BUDGET_LONGTEXT N_( \
     "Only useful programs are normally demultiplexed from the transponder. " \
     "This option will disable demultiplexing and receive all programs.")
+#define SHARED_TEXT N_("Share the tuner")
+#define SHARED_LONGTEXT N_( \
+    "Inputs on the same adapter and device share a single tuner, so that " \
+    "several programs of one transponder can be received at once.")
 
 #define NAME_TEXT N_("Network name")
 #define NAME_LONGTEXT N_("Unique network name in the System Tuning Spaces")
@@ -264,6 +268,7 @@ vlc_module_begin ()
         change_integer_range (0, 255)
         change_safe ()
     add_bool ("dvb-budget-mode", false, BUDGET_TEXT, BUDGET_LONGTEXT, true)
+    add_bool ("dvb-shared", false, SHARED_TEXT, SHARED_LONGTEXT, true)
 #endif
 #ifdef _WIN32
     add_integer ("dvb-adapter", -1, ADAPTER_TEXT, ADAPTER_LONGTEXT, true)
@@ -31,6 +31,7 @@
 #include <errno.h>
 #include <assert.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <poll.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
@@ -160,8 +161,38 @@ struct dvb_device
     uint8_t device;
     bool budget;
     //size_t buffer_size;
+    /* Shared tuner input */
+    struct dvb_share *share; /**< Shared tuner, or NULL if exclusive */
+    struct dvb_device *next; /**< Next input of the shared tuner */
+    int pipe_out; /**< Write end of the input pipe */
+    bool overflow;
+    uint32_t freq; /**< Requested frequency */
+    uint32_t pidmap[0x2000 / 32]; /**< PIDs selected by this input */
 };
 
+/** Tuner shared by several inputs */
+typedef struct dvb_share
+{
+    struct dvb_share *next;
+    vlc_object_t *obj;
+    dvb_device_t *dev; /**< Underlying (exclusive) device */
+    cam_t *cam;
+    uint8_t adapter;
+    bool dead; /**< Whether the tuner failed */
+    bool tuned;
+    uint32_t freq; /**< Tuned frequency */
+    unsigned refs;
+    vlc_mutex_t lock;
+    vlc_thread_t thread;
+    dvb_device_t *inputs;
+    size_t buflen;
+    uint8_t buf[100 * 188];
+    uint16_t pidrefs[0x2000]; /**< Number of inputs selecting each PID */
+} dvb_share_t;
+
+static vlc_mutex_t dvb_shares_lock = VLC_STATIC_MUTEX;
+static dvb_share_t *dvb_shares = NULL;
+
 /** Opens the device directory for the specified DVB adapter */
 static int dvb_open_adapter (uint8_t adapter)
 {
@@ -180,19 +211,25 @@ static int dvb_open_node (dvb_device_t *d, const char *type, int flags)
     return vlc_openat (d->dir, path, flags | O_NONBLOCK);
 }
 
+static int dvb_open_frontend (dvb_device_t *d);
+static dvb_device_t *dvb_share_open (vlc_object_t *, uint8_t, uint8_t, bool);
+static void dvb_share_close (dvb_device_t *);
+static int dvb_share_add_pid (dvb_device_t *, uint16_t);
+static void dvb_share_remove_pid (dvb_device_t *, uint16_t);
+static bool dvb_share_tuned (dvb_device_t *);
+
 /**
- * Opens the DVB tuner
+ * Opens the DVB device nodes of an adapter
  */
-dvb_device_t *dvb_open (vlc_object_t *obj)
+static dvb_device_t *dvb_open_device (vlc_object_t *obj, uint8_t adapter,
+                                      uint8_t device, bool budget)
 {
     dvb_device_t *d = malloc (sizeof (*d));
     if (unlikely(d == NULL))
         return NULL;
 
     d->obj = obj;
-
-    uint8_t adapter = var_InheritInteger (obj, "dvb-adapter");
-    d->device = var_InheritInteger (obj, "dvb-device");
+    d->device = device;
 
     d->dir = dvb_open_adapter (adapter);
     if (d->dir == -1)
@@ -204,7 +241,8 @@ dvb_device_t *dvb_open (vlc_object_t *obj)
     }
     d->frontend = -1;
     d->cam = NULL;
-    d->budget = var_InheritBool (obj, "dvb-budget-mode");
+    d->budget = budget;
+    d->share = NULL;
 
 #ifndef USE_DMX
     if (d->budget)
@@ -273,8 +311,27 @@ error:
     return NULL;
 }
 
+/**
+ * Opens the DVB tuner
+ */
+dvb_device_t *dvb_open (vlc_object_t *obj)
+{
+    uint8_t adapter = var_InheritInteger (obj, "dvb-adapter");
+    uint8_t device = var_InheritInteger (obj, "dvb-device");
+    bool budget = var_InheritBool (obj, "dvb-budget-mode");
+
+    if (var_InheritBool (obj, "dvb-shared"))
+        return dvb_share_open (obj, adapter, device, budget);
+    return dvb_open_device (obj, adapter, device, budget);
+}
+
 void dvb_close (dvb_device_t *d)
 {
+    if (d->share != NULL)
+    {
+        dvb_share_close (d);
+        return;
+    }
 #ifndef USE_DMX
     if (!d->budget)
     {
@@ -323,7 +380,7 @@ ssize_t dvb_read (dvb_device_t *d, void *buf, size_t len, int ms)
 
     ufd[0].fd = d->demux;
     ufd[0].events = POLLIN;
-    if (d->frontend != -1)
+    if (d->frontend != -1 && d->share == NULL)
     {
         ufd[1].fd = d->frontend;
         ufd[1].events = POLLPRI;
@@ -339,7 +396,7 @@ ssize_t dvb_read (dvb_device_t *d, void *buf, size_t len, int ms)
     if (n <= 0)
         return -1;
 
-    if (d->frontend != -1 && ufd[1].revents)
+    if (d->frontend != -1 && d->share == NULL && ufd[1].revents)
     {
         struct dvb_frontend_event ev;
 
@@ -381,6 +438,8 @@ int dvb_add_pid (dvb_device_t *d, uint16_t pid)
 {
     if (d->budget)
         return 0;
+    if (d->share != NULL)
+        return dvb_share_add_pid (d, pid);
 #ifdef USE_DMX
     if (pid == 0 || ioctl (d->demux, DMX_ADD_PID, &pid) >= 0)
         return 0;
@@ -426,6 +485,11 @@ void dvb_remove_pid (dvb_device_t *d, uint16_t pid)
 {
     if (d->budget)
         return;
+    if (d->share != NULL)
+    {
+        dvb_share_remove_pid (d, pid);
+        return;
+    }
 #ifdef USE_DMX
     if (pid != 0)
         ioctl (d->demux, DMX_REMOVE_PID, &pid);
@@ -446,6 +510,8 @@ bool dvb_get_pid_state (const dvb_device_t *d, uint16_t pid)
 {
     if (d->budget)
         return true;
+    if (d->share != NULL)
+        return (d->pidmap[pid / 32] >> (pid % 32)) & 1;
 
     for (size_t i = 0; i < MAX_PIDS; i++)
         if (d->pids[i].pid == pid)
@@ -454,6 +520,373 @@ bool dvb_get_pid_state (const dvb_device_t *d, uint16_t pid)
     return false;
 }
 
+/*** Shared tuner ***/
+/**
+ * Forwards TS packets to an input of a shared tuner.
+ * Each write is at most PIPE_BUF bytes, so that it is atomic and the input
+ * never receives a truncated packet.
+ */
+static void dvb_share_send (dvb_device_t *d, const uint8_t *buf, size_t len)
+{
+    while (len > 0)
+    {
+        size_t chunk = __MIN(len, (PIPE_BUF / 188) * 188);
+        ssize_t val = write (d->pipe_out, buf, chunk);
+
+        if (val < 0)
+        {
+            if (!d->overflow)
+                msg_Err (d->obj, "cannot forward data fast enough!");
+            d->overflow = true;
+            return;
+        }
+        d->overflow = false;
+        buf += val;
+        len -= val;
+    }
+}
+
+/** Fans the TS packets out to the inputs that selected their PID */
+static void dvb_share_dispatch (dvb_share_t *s, const uint8_t *buf, size_t len)
+{
+    for (dvb_device_t *d = s->inputs; d != NULL; d = d->next)
+    {
+        if (d->pipe_out == -1)
+            continue;
+        if (d->budget)
+        {
+            dvb_share_send (d, buf, len);
+            continue;
+        }
+
+        /* Coalesce consecutive selected packets into a single write */
+        size_t start = 0, end = 0;
+
+        for (size_t i = 0; i < len; i += 188)
+        {
+            uint16_t pid = ((buf[i + 1] & 0x1F) << 8) | buf[i + 2];
+
+            if ((d->pidmap[pid / 32] >> (pid % 32)) & 1)
+            {
+                if (end != i)
+                {
+                    dvb_share_send (d, buf + start, end - start);
+                    start = i;
+                }
+                end = i + 188;
+            }
+        }
+        dvb_share_send (d, buf + start, end - start);
+    }
+}
+
+static void *dvb_share_thread (void *data)
+{
+    dvb_share_t *s = data;
+
+    for (;;)
+    {
+        if (s->cam != NULL)
+        {
+            int canc = vlc_savecancel ();
+            vlc_mutex_lock (&s->lock);
+            en50221_Poll (s->cam);
+            vlc_mutex_unlock (&s->lock);
+            vlc_restorecancel (canc);
+        }
+
+        ssize_t val = dvb_read (s->dev, s->buf + s->buflen,
+                                sizeof (s->buf) - s->buflen, -1);
+        if (val == 0)
+            break;
+        if (val < 0)
+            continue;
+
+        /* Resynchronize on the TS sync byte and keep incomplete packets */
+        uint8_t *p = memchr (s->buf, 0x47, s->buflen + val);
+        size_t len = (p != NULL) ? s->buf + s->buflen + val - p : 0;
+        size_t full = len - (len % 188);
+
+        int canc = vlc_savecancel ();
+        vlc_mutex_lock (&s->lock);
+        dvb_share_dispatch (s, p, full);
+        vlc_mutex_unlock (&s->lock);
+        vlc_restorecancel (canc);
+
+        s->buflen = len - full;
+        if (s->buflen > 0)
+            memmove (s->buf, p + full, s->buflen);
+    }
+
+    /* Fatal error: signal end-of-stream to all inputs */
+    vlc_mutex_lock (&s->lock);
+    for (dvb_device_t *d = s->inputs; d != NULL; d = d->next)
+        if (d->pipe_out != -1)
+        {
+            vlc_close (d->pipe_out);
+            d->pipe_out = -1;
+        }
+    s->dead = true;
+    vlc_mutex_unlock (&s->lock);
+    return NULL;
+}
+
+/**
+ * Attaches an input to the shared tuner of an adapter, opening the tuner
+ * if no other input uses it yet.
+ */
+static dvb_device_t *dvb_share_open (vlc_object_t *obj, uint8_t adapter,
+                                     uint8_t device, bool budget)
+{
+    dvb_device_t *d = malloc (sizeof (*d));
+    if (unlikely(d == NULL))
+        return NULL;
+
+    int fds[2];
+    if (vlc_pipe (fds))
+    {
+        free (d);
+        return NULL;
+    }
+    fcntl (fds[0], F_SETFL, fcntl (fds[0], F_GETFL) | O_NONBLOCK);
+    fcntl (fds[1], F_SETFL, fcntl (fds[1], F_GETFL) | O_NONBLOCK);
+#ifdef F_SETPIPE_SZ
+    if (fcntl (fds[1], F_SETPIPE_SZ, 1 << 20) < 0)
+        msg_Warn (obj, "cannot expand input pipe buffer: %s",
+                  vlc_strerror_c(errno));
+#endif
+
+    vlc_mutex_lock (&dvb_shares_lock);
+
+    dvb_share_t *s = dvb_shares;
+    while (s != NULL && (s->adapter != adapter || s->dev->device != device))
+        s = s->next;
+
+    if (s == NULL)
+    {
+        s = malloc (sizeof (*s));
+        if (unlikely(s == NULL))
+            goto error;
+
+        /* The tuner outlives the input that opened it */
+        s->obj = vlc_object_create (obj->obj.libvlc, sizeof (*s->obj));
+        if (unlikely(s->obj == NULL))
+        {
+            free (s);
+            goto error;
+        }
+
+        s->dev = dvb_open_device (s->obj, adapter, device, budget);
+        if (s->dev == NULL || dvb_open_frontend (s->dev))
+        {
+            if (s->dev != NULL)
+                dvb_close (s->dev);
+            vlc_object_release (s->obj);
+            free (s);
+            goto error;
+        }
+
+        /* The CAM is polled and configured under the tuner lock */
+        s->cam = s->dev->cam;
+        s->dev->cam = NULL;
+        s->adapter = adapter;
+        s->dead = false;
+        s->tuned = false;
+        s->refs = 0;
+        vlc_mutex_init (&s->lock);
+        s->inputs = NULL;
+        s->buflen = 0;
+        memset (s->pidrefs, 0, sizeof (s->pidrefs));
+
+        if (vlc_clone (&s->thread, dvb_share_thread, s,
+                       VLC_THREAD_PRIORITY_INPUT))
+        {
+            vlc_mutex_destroy (&s->lock);
+            s->dev->cam = s->cam;
+            dvb_close (s->dev);
+            vlc_object_release (s->obj);
+            free (s);
+            goto error;
+        }
+
+        s->next = dvb_shares;
+        dvb_shares = s;
+        msg_Dbg (obj, "opened shared tuner on adapter %"PRIu8, adapter);
+    }
+    else
+        msg_Dbg (obj, "attaching to shared tuner on adapter %"PRIu8, adapter);
+
+    if (budget && !s->dev->budget)
+    {
+        msg_Warn (obj, "budget mode not available on shared tuner");
+        budget = false;
+    }
+
+    d->obj = obj;
+    d->dir = s->dev->dir;
+    d->demux = fds[0];
+    d->frontend = s->dev->frontend;
+    d->cam = NULL;
+    d->device = device;
+    d->budget = budget;
+    d->share = s;
+    d->pipe_out = fds[1];
+    d->overflow = false;
+    d->freq = 0;
+    memset (d->pidmap, 0, sizeof (d->pidmap));
+
+    vlc_mutex_lock (&s->lock);
+    if (s->dead)
+    {   /* Tuner failed: end-of-stream */
+        vlc_close (d->pipe_out);
+        d->pipe_out = -1;
+    }
+    d->next = s->inputs;
+    s->inputs = d;
+    s->refs++;
+    vlc_mutex_unlock (&s->lock);
+
+    vlc_mutex_unlock (&dvb_shares_lock);
+    return d;
+
+error:
+    vlc_mutex_unlock (&dvb_shares_lock);
+    vlc_close (fds[1]);
+    vlc_close (fds[0]);
+    free (d);
+    return NULL;
+}
+
+/**
+ * Detaches an input from its shared tuner, closing the tuner if it was the
+ * last input.
+ */
+static void dvb_share_close (dvb_device_t *d)
+{
+    dvb_share_t *s = d->share;
+
+    vlc_mutex_lock (&dvb_shares_lock);
+    vlc_mutex_lock (&s->lock);
+    for (dvb_device_t **pp = &s->inputs; *pp != NULL; pp = &(*pp)->next)
+        if (*pp == d)
+        {
+            *pp = d->next;
+            break;
+        }
+
+    for (unsigned pid = 0; pid < 0x2000; pid++)
+        if ((d->pidmap[pid / 32] >> (pid % 32)) & 1)
+            if (--s->pidrefs[pid] == 0)
+                dvb_remove_pid (s->dev, pid);
+
+    bool last = --s->refs == 0;
+    vlc_mutex_unlock (&s->lock);
+
+    if (d->pipe_out != -1)
+        vlc_close (d->pipe_out);
+    vlc_close (d->demux);
+    free (d);
+
+    if (last)
+    {   /* Release the device before another input can reopen it */
+        for (dvb_share_t **pp = &dvb_shares; *pp != NULL; pp = &(*pp)->next)
+            if (*pp == s)
+            {
+                *pp = s->next;
+                break;
+            }
+
+        vlc_cancel (s->thread);
+        vlc_join (s->thread, NULL);
+        vlc_mutex_destroy (&s->lock);
+
+        s->dev->cam = s->cam;
+        dvb_close (s->dev);
+        vlc_object_release (s->obj);
+        free (s);
+    }
+    vlc_mutex_unlock (&dvb_shares_lock);
+}
+
+/** Adds a PID to the merged filter set of a shared tuner */
+static int dvb_share_add_pid (dvb_device_t *d, uint16_t pid)
+{
+    dvb_share_t *s = d->share;
+    int ret = 0;
+
+    if ((d->pidmap[pid / 32] >> (pid % 32)) & 1)
+        return 0;
+
+    vlc_mutex_lock (&s->lock);
+    if (s->pidrefs[pid] == 0 && dvb_add_pid (s->dev, pid))
+        ret = -1;
+    else
+    {
+        s->pidrefs[pid]++;
+        d->pidmap[pid / 32] |= UINT32_C(1) << (pid % 32);
+    }
+    vlc_mutex_unlock (&s->lock);
+    return ret;
+}
+
+/** Removes a PID from the merged filter set of a shared tuner */
+static void dvb_share_remove_pid (dvb_device_t *d, uint16_t pid)
+{
+    dvb_share_t *s = d->share;
+
+    if (!((d->pidmap[pid / 32] >> (pid % 32)) & 1))
+        return;
+
+    vlc_mutex_lock (&s->lock);
+    d->pidmap[pid / 32] &= ~(UINT32_C(1) << (pid % 32));
+    if (--s->pidrefs[pid] == 0)
+        dvb_remove_pid (s->dev, pid);
+    vlc_mutex_unlock (&s->lock);
+}
+
+/** Checks whether the shared tuner was already tuned by another input */
+static bool dvb_share_tuned (dvb_device_t *d)
+{
+    dvb_share_t *s = d->share;
+
+    vlc_mutex_lock (&s->lock);
+    bool tuned = s->tuned;
+    vlc_mutex_unlock (&s->lock);
+    return tuned;
+}
+
+static int dvb_share_tune (dvb_device_t *d)
+{
+    dvb_share_t *s = d->share;
+    int ret = 0;
+
+    vlc_mutex_lock (&s->lock);
+    if (!s->tuned)
+    {
+        struct dtv_property prop = { .cmd = DTV_TUNE };
+        struct dtv_properties props = { .num = 1, .props = &prop };
+
+        if (ioctl (d->frontend, FE_SET_PROPERTY, &props) < 0)
+        {
+            msg_Err (d->obj, "cannot tune: %s", vlc_strerror_c(errno));
+            ret = -1;
+        }
+        else
+        {
+            s->tuned = true;
+            s->freq = d->freq;
+        }
+    }
+    else if (s->freq != d->freq)
+    {
+        msg_Err (d->obj, "shared tuner is busy on frequency %"PRIu32,
+                 s->freq);
+        ret = -1;
+    }
+    vlc_mutex_unlock (&s->lock);
+    return ret;
+}
+
 /** Finds a frontend of the correct type */
 static int dvb_open_frontend (dvb_device_t *d)
 {
@@ -636,6 +1069,17 @@ float dvb_get_snr (dvb_device_t *d)
 
 bool dvb_set_ca_pmt (dvb_device_t *d, en50221_capmt_info_t *p_capmtinfo)
 {
+    if (d->share != NULL)
+    {
+        dvb_share_t *s = d->share;
+        bool ok = s->cam != NULL;
+
+        vlc_mutex_lock (&s->lock);
+        if (ok)
+            en50221_SetCAPMT (s->cam, p_capmtinfo);
+        vlc_mutex_unlock (&s->lock);
+        return ok;
+    }
     if (d->cam != NULL)
     {
         en50221_SetCAPMT (d->cam, p_capmtinfo);
@@ -659,10 +1103,16 @@ static int dvb_vset_props (dvb_device_t *d, size_t n, va_list ap)
         prop->u.data = va_arg (ap, uint32_t);
         msg_Dbg (d->obj, "setting property %2"PRIu32" to %"PRIu32,
                  prop->cmd, prop->u.data);
+        if (prop->cmd == DTV_FREQUENCY)
+            d->freq = prop->u.data;
         prop++;
         n--;
     }
 
+    /* Do not disturb the other inputs of a shared tuner */
+    if (d->share != NULL && dvb_share_tuned (d))
+        return 0;
+
     if (ioctl (d->frontend, FE_SET_PROPERTY, &props) < 0)
     {
         msg_Err (d->obj, "cannot set frontend tuning parameters: %s",
@@ -701,6 +1151,8 @@ int dvb_set_inversion (dvb_device_t *d, int v)
 
 int dvb_tune (dvb_device_t *d)
 {
+    if (d->share != NULL)
+        return dvb_share_tune (d);
     return dvb_set_prop (d, DTV_TUNE, 0 /* dummy */);
 }
 
@@ -761,6 +1213,9 @@ int dvb_set_sec (dvb_device_t *d, uint64_t freq_Hz, char pol,
 {
     uint32_t freq = freq_Hz / 1000;
 
+    if (d->share != NULL && dvb_share_tuned (d))
+        return 0; /* keep the LNB and DiSEqC switch settings */
+
     /* Always try to configure high voltage, but only warn on enable failure */
     int val = var_InheritBool (d->obj, "dvb-high-voltage");
     if (ioctl (d->frontend, FE_ENABLE_HIGH_LNB_VOLTAGE, &val) < 0 && val)
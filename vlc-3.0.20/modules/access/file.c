@@ -52,6 +52,9 @@
 #   include <unistd.h>
 #endif
 #include <dirent.h>
+#ifdef HAVE_MMAP
+#   include <sys/mman.h>
+#endif
 
 #include <vlc_common.h>
 #include "fs.h"
@@ -69,6 +72,14 @@ struct access_sys_t
     int fd;
 
     bool b_pace_control;
+#ifdef HAVE_LINUX_IO_URING_H
+    file_uring_t *uring;
+#endif
+#ifdef HAVE_MMAP
+    uint64_t map_offset; /* current read offset */
+    uint64_t map_size; /* last known file size */
+    bool map_sequential; /* no seek since the previous mapping */
+#endif
 };
 
 #if !defined (_WIN32) && !defined (__OS2__)
@@ -138,9 +149,26 @@ static bool IsRemote (const char *path)
 #ifndef HAVE_POSIX_FADVISE
 # define posix_fadvise(fd, off, len, adv)
 #endif
+#ifndef HAVE_POSIX_MADVISE
+# define posix_madvise(addr, len, adv)
+#endif
 
 static ssize_t Read (stream_t *, void *, size_t);
 static int FileSeek (stream_t *, uint64_t);
+#ifdef HAVE_LINUX_IO_URING_H
+static block_t *UringBlock (stream_t *, bool *restrict);
+static int UringSeek (stream_t *, uint64_t);
+
+/* Size of each read kept in flight */
+# define URING_READ_SIZE (128 * 1024)
+#endif
+#ifdef HAVE_MMAP
+static block_t *MmapBlock (stream_t *, bool *restrict);
+static int MmapSeek (stream_t *, uint64_t);
+
+/* Size of each mapped view */
+# define MMAP_VIEW_SIZE (1024 * 1024)
+#endif
 static int NoSeek (stream_t *, uint64_t);
 static int FileControl (stream_t *, int, va_list);
 
@@ -225,12 +253,47 @@ int FileOpen( vlc_object_t *p_this )
     p_access->pf_control = FileControl;
     p_access->p_sys = p_sys;
     p_sys->fd = fd;
+#ifdef HAVE_LINUX_IO_URING_H
+    p_sys->uring = NULL;
+#endif
 
     if (S_ISREG (st.st_mode) || S_ISBLK (st.st_mode))
     {
         p_access->pf_seek = FileSeek;
         p_sys->b_pace_control = true;
 
+#ifdef HAVE_LINUX_IO_URING_H
+        if (var_InheritBool (p_access, "file-uring"))
+        {
+            unsigned depth = var_InheritInteger (p_access, "file-uring-depth");
+
+            p_sys->uring = FileUringNew (p_access, fd, depth, URING_READ_SIZE);
+            if (p_sys->uring != NULL)
+            {
+                p_access->pf_read = NULL;
+                p_access->pf_block = UringBlock;
+                p_access->pf_seek = UringSeek;
+                msg_Dbg (p_access, "using io_uring (%u reads in flight)", depth);
+            }
+        }
+#endif
+#ifdef HAVE_MMAP
+        /* A mapping of a file truncated under our feet raises SIGBUS, and
+         * network file systems can fail at any time: local files only. */
+        if (p_access->pf_block == NULL && S_ISREG (st.st_mode)
+         && !IsRemote (fd, p_access->psz_filepath)
+         && var_InheritBool (p_access, "file-mmap"))
+        {
+            p_sys->map_offset = 0;
+            p_sys->map_size = st.st_size;
+            p_sys->map_sequential = true;
+            p_access->pf_read = NULL;
+            p_access->pf_block = MmapBlock;
+            p_access->pf_seek = MmapSeek;
+            msg_Dbg (p_access, "using memory mapped reads");
+        }
+#endif
+
         /* Demuxers will need the beginning of the file for probing. */
         posix_fadvise (fd, 0, 4096, POSIX_FADV_WILLNEED);
         /* In most cases, we only read the file once. */
@@ -265,7 +328,7 @@ void FileClose (vlc_object_t * p_this)
 {
     stream_t     *p_access = (stream_t*)p_this;
 
-    if (p_access->pf_read == NULL)
+    if (p_access->pf_readdir != NULL)
     {
         DirClose (p_this);
         return;
@@ -273,6 +336,10 @@ void FileClose (vlc_object_t * p_this)
 
     access_sys_t *p_sys = p_access->p_sys;
 
+#ifdef HAVE_LINUX_IO_URING_H
+    if (p_sys->uring != NULL)
+        FileUringDelete (p_sys->uring);
+#endif
     vlc_close (p_sys->fd);
 }
 
@@ -311,6 +378,82 @@ static int FileSeek (stream_t *p_access, uint64_t i_pos)
     return VLC_SUCCESS;
 }
 
+#ifdef HAVE_LINUX_IO_URING_H
+static block_t *UringBlock (stream_t *p_access, bool *restrict eof)
+{
+    access_sys_t *sys = p_access->p_sys;
+
+    return FileUringBlock (sys->uring, eof);
+}
+
+static int UringSeek (stream_t *p_access, uint64_t i_pos)
+{
+    access_sys_t *sys = p_access->p_sys;
+
+    FileUringSeek (sys->uring, i_pos);
+    return VLC_SUCCESS;
+}
+#endif
+
+#ifdef HAVE_MMAP
+static block_t *MmapBlock (stream_t *p_access, bool *restrict eof)
+{
+    access_sys_t *sys = p_access->p_sys;
+    uint64_t offset = sys->map_offset;
+
+    if (offset >= sys->map_size)
+    {   /* The file may have grown since the last check */
+        struct stat st;
+
+        if (fstat (sys->fd, &st) == 0)
+            sys->map_size = st.st_size;
+        if (offset >= sys->map_size)
+        {
+            *eof = true;
+            return NULL;
+        }
+    }
+
+    size_t length = __MIN(sys->map_size - offset, MMAP_VIEW_SIZE);
+    size_t skip = offset & (sysconf (_SC_PAGESIZE) - 1);
+    void *addr = mmap (NULL, skip + length, PROT_READ, MAP_PRIVATE, sys->fd,
+                       offset - skip);
+    if (addr == MAP_FAILED)
+    {
+        msg_Err (p_access, "mapping error: %s", vlc_strerror_c(errno));
+        *eof = true;
+        return NULL;
+    }
+
+    /* Read-ahead only pays off once the access pattern looks linear;
+     * right after a seek, let the kernel fault pages in on demand. */
+    if (sys->map_sequential)
+    {
+        posix_madvise (addr, skip + length, POSIX_MADV_SEQUENTIAL);
+        posix_madvise (addr, skip + length, POSIX_MADV_WILLNEED);
+        posix_fadvise (sys->fd, offset + length, MMAP_VIEW_SIZE,
+                       POSIX_FADV_WILLNEED);
+    }
+
+    block_t *block = block_mmap_Alloc ((char *)addr + skip, length);
+    if (unlikely(block == NULL))
+        return NULL;
+
+    sys->map_offset = offset + length;
+    sys->map_sequential = true;
+    return block;
+}
+
+static int MmapSeek (stream_t *p_access, uint64_t i_pos)
+{
+    access_sys_t *sys = p_access->p_sys;
+
+    sys->map_sequential = (i_pos == sys->map_offset);
+    sys->map_offset = i_pos;
+    return VLC_SUCCESS;
+}
+#endif
+
 static int NoSeek (stream_t *p_access, uint64_t i_pos)
 {
     /* vlc_assert_unreachable(); ?? */
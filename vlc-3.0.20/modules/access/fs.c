@@ -39,6 +39,20 @@ vlc_module_begin ()
     set_capability( "access", 50 )
     add_shortcut( "file", "fd", "stream" )
     set_callbacks( FileOpen, FileClose )
+#ifdef HAVE_LINUX_IO_URING_H
+    add_bool( "file-uring", false, N_("Asynchronous reads"),
+              N_("Read regular files and block devices ahead with io_uring. "
+                 "All such inputs share a single completion thread."), true )
+    add_integer_with_range( "file-uring-depth", 4, 1, 64,
+              N_("Asynchronous reads in flight"),
+              N_("Number of 128 KiB reads each input keeps in flight."), true )
+#endif
+#ifdef HAVE_MMAP
+    add_bool( "file-mmap", false, N_("Memory mapped reads"),
+              N_("Map local regular files into memory instead of copying "
+                 "their content. The file must not be truncated while it "
+                 "is being read."), true )
+#endif
 
     add_submodule()
     set_section( N_("Directory" ), NULL )
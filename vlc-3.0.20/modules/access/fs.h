@@ -23,6 +23,15 @@
 int FileOpen (vlc_object_t *);
 void FileClose (vlc_object_t *);
 
+#ifdef HAVE_LINUX_IO_URING_H
+typedef struct file_uring file_uring_t;
+
+file_uring_t *FileUringNew (stream_t *, int fd, unsigned depth, size_t size);
+void FileUringDelete (file_uring_t *);
+block_t *FileUringBlock (file_uring_t *, bool *restrict eof);
+void FileUringSeek (file_uring_t *, uint64_t);
+#endif
+
 int DirOpen (vlc_object_t *);
 int DirInit (stream_t *p_access, DIR *handle);
 int DirRead (stream_t *, input_item_node_t *);
@@ -37,18 +37,21 @@
 #include "resource.h"
 #include "file.h"
 #include "live.h"
+#include "multi.h"
 
 struct access_sys_t
 {
     struct vlc_http_mgr *manager;
     struct vlc_http_resource *resource;
+    struct vlc_http_multi *multi;
 };
 
 static block_t *FileRead(stream_t *access, bool *restrict eof)
 {
     access_sys_t *sys = access->p_sys;
 
-    block_t *b = vlc_http_file_read(sys->resource);
+    block_t *b = (sys->multi != NULL) ? vlc_http_multi_read(sys->multi)
+                                      : vlc_http_file_read(sys->resource);
     if (b == NULL)
         *eof = true;
     return b;
@@ -58,6 +61,12 @@ static int FileSeek(stream_t *access, uint64_t pos)
 {
     access_sys_t *sys = access->p_sys;
 
+    if (sys->multi != NULL)
+    {
+        vlc_http_multi_seek(sys->multi, pos);
+        return VLC_SUCCESS;
+    }
+
     if (vlc_http_file_seek(sys->resource, pos))
         return VLC_EGENERIC;
     return VLC_SUCCESS;
@@ -166,7 +175,9 @@ static int Open(vlc_object_t *obj)
 
     sys->manager = NULL;
     sys->resource = NULL;
+    sys->multi = NULL;
 
+    char *ua = NULL, *referer = NULL;
     void *jar = NULL;
     if (var_InheritBool(obj, "http-forward-cookies"))
         jar = var_InheritAddress(obj, "http-cookies");
@@ -182,15 +193,12 @@ static int Open(vlc_object_t *obj)
     if (sys->manager == NULL)
         goto error;
 
-    char *ua = var_InheritString(obj, "http-user-agent");
-    char *referer = var_InheritString(obj, "http-referrer");
+    ua = var_InheritString(obj, "http-user-agent");
+    referer = var_InheritString(obj, "http-referrer");
     bool live = var_InheritBool(obj, "http-continuous");
 
     sys->resource = (live ? vlc_http_live_create : vlc_http_file_create)(
         sys->manager, access->psz_url, ua, referer);
-    free(referer);
-    free(ua);
-
     if (sys->resource == NULL)
         goto error;
 
@@ -241,6 +249,18 @@ static int Open(vlc_object_t *obj)
         goto error;
     }
 
+    /* Switch to parallel ranges if the file supports them */
+    unsigned parallel = var_InheritInteger(obj, "http-parallel");
+    uintmax_t size = vlc_http_file_get_size(sys->resource);
+
+    if (!live && parallel > 1 && size != (uintmax_t)-1
+     && vlc_http_file_can_seek(sys->resource))
+        sys->multi = vlc_http_multi_create(obj, access->psz_url, ua, referer,
+                                           crd.psz_username, crd.psz_password,
+                                           jar, size, parallel);
+    free(referer);
+    free(ua);
+
     vlc_credential_store(&crd, obj);
     free(psz_realm);
     vlc_credential_clean(&crd);
@@ -263,6 +283,8 @@ static int Open(vlc_object_t *obj)
     return VLC_SUCCESS;
 
 error:
+    free(referer);
+    free(ua);
     if (sys->resource != NULL)
         vlc_http_res_destroy(sys->resource);
     if (sys->manager != NULL)
@@ -279,6 +301,8 @@ static void Close(vlc_object_t *obj)
     stream_t *access = (stream_t *)obj;
     access_sys_t *sys = access->p_sys;
 
+    if (sys->multi != NULL)
+        vlc_http_multi_destroy(sys->multi);
     vlc_http_res_destroy(sys->resource);
     vlc_http_mgr_destroy(sys->manager);
     free(sys);
@@ -296,6 +320,11 @@ vlc_module_begin()
     add_bool("http-continuous", false, N_("Continuous stream"),
              N_("Keep reading a resource that keeps being updated."), true)
         change_volatile()
+    add_integer_with_range("http-parallel", 1, 1, 8,
+        N_("Parallel connections"),
+        N_("Maximum number of connections used to download a file in "
+           "concurrent ranges. This speeds up playback over links with a "
+           "high latency. 1 disables parallel downloads."), true)
     add_bool("http-forward-cookies", true, N_("Cookies forwarding"),
              N_("Forward cookies across HTTP redirections."), true)
     add_string("http-referrer", NULL, N_("Referrer"),
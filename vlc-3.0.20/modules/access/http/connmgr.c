@@ -25,6 +25,7 @@
 #include <assert.h>
 #include <vlc_common.h>
 #include <vlc_network.h>
+#include <vlc_strings.h>
 #include <vlc_tls.h>
 #include <vlc_url.h>
 #include "transport.h"
@@ -92,56 +93,155 @@ static char *vlc_http_proxy_find(const char *hostname, unsigned port,
 }
 
 
+/** Maximum number of connections kept by a manager */
+#define VLC_HTTP_MGR_MAX_CONNS 4
+
+struct vlc_http_mgr_conn
+{
+    struct vlc_http_conn *conn;
+    char *host;
+    unsigned port;
+    bool multiplexed; /**< HTTP/2 rather than HTTP/1.x */
+};
+
 struct vlc_http_mgr
 {
     vlc_object_t *obj;
     vlc_tls_creds_t *creds;
     struct vlc_http_cookie_jar_t *jar;
-    struct vlc_http_conn *conn;
+    struct vlc_http_mgr_conn conns[VLC_HTTP_MGR_MAX_CONNS]; /**< oldest first */
+    unsigned conn_count;
+    vlc_mutex_t lock;
+    bool shared;
 };
 
-static struct vlc_http_conn *vlc_http_mgr_find(struct vlc_http_mgr *mgr,
-                                               const char *host, unsigned port)
+static bool vlc_http_mgr_match(const struct vlc_http_mgr_conn *entry,
+                               const char *host, unsigned port)
+{
+    return entry->port == port && !vlc_ascii_strcasecmp(entry->host, host);
+}
+
+static int vlc_http_mgr_find(struct vlc_http_mgr *mgr,
+                             const struct vlc_http_conn *conn)
 {
-    (void) host; (void) port;
-    return mgr->conn;
+    for (unsigned i = 0; i < mgr->conn_count; i++)
+        if (mgr->conns[i].conn == conn)
+            return i;
+    return -1;
 }
 
-static void vlc_http_mgr_release(struct vlc_http_mgr *mgr,
-                                 struct vlc_http_conn *conn)
+static void vlc_http_mgr_release(struct vlc_http_mgr *mgr, unsigned i)
 {
-    assert(mgr->conn == conn);
-    mgr->conn = NULL;
+    struct vlc_http_conn *conn = mgr->conns[i].conn;
+
+    assert(i < mgr->conn_count);
+    free(mgr->conns[i].host);
+    mgr->conn_count--;
+    memmove(mgr->conns + i, mgr->conns + i + 1,
+            (mgr->conn_count - i) * sizeof (mgr->conns[0]));
 
     vlc_http_conn_release(conn);
 }
 
+/**
+ * Keeps a connection for later requests to the same origin.
+ *
+ * If the manager is full, its oldest connection is given up.
+ */
+static void vlc_http_mgr_add(struct vlc_http_mgr *mgr,
+                             struct vlc_http_conn *conn,
+                             const char *host, unsigned port, bool multiplexed)
+{
+    char *name = strdup(host);
+    if (unlikely(name == NULL))
+    {
+        vlc_http_conn_release(conn);
+        return;
+    }
+
+    if (mgr->conn_count == VLC_HTTP_MGR_MAX_CONNS)
+        vlc_http_mgr_release(mgr, 0);
+
+    struct vlc_http_mgr_conn *entry = &mgr->conns[mgr->conn_count++];
+
+    entry->conn = conn;
+    entry->host = name;
+    entry->port = port;
+    entry->multiplexed = multiplexed;
+}
+
 static
 struct vlc_http_msg *vlc_http_mgr_reuse(struct vlc_http_mgr *mgr,
                                         const char *host, unsigned port,
                                         const struct vlc_http_msg *req)
 {
-    struct vlc_http_conn *conn = vlc_http_mgr_find(mgr, host, port);
-    if (conn == NULL)
-        return NULL;
+    struct vlc_http_conn *conn = NULL;
+    struct vlc_http_stream *stream = NULL;
 
-    struct vlc_http_stream *stream = vlc_http_stream_open(conn, req);
-    if (stream != NULL)
+    vlc_mutex_lock(&mgr->lock);
+    for (unsigned i = 0; i < mgr->conn_count && stream == NULL;)
     {
-        struct vlc_http_msg *m = vlc_http_msg_get_initial(stream);
-        if (m != NULL)
-            return m;
-
-        /* NOTE: If the request were not idempotent, we would not know if it
-         * was processed by the other end. Thus POST is not used/supported so
-         * far, and CONNECT is treated as if it were idempotent (which works
-         * fine here). */
+        struct vlc_http_mgr_conn *entry = &mgr->conns[i];
+
+        if (!vlc_http_mgr_match(entry, host, port))
+        {
+            i++;
+            continue;
+        }
+
+        conn = entry->conn;
+        stream = vlc_http_stream_open(conn, req);
+
+        /* An HTTP/1 connection still busy with another stream can be reused
+         * once that stream is closed. Any other failure is fatal. */
+        if (stream == NULL && (entry->multiplexed || conn->tls == NULL))
+            vlc_http_mgr_release(mgr, i);
+        else
+            i++;
     }
-    /* Get rid of closing or reset connection */
-    vlc_http_mgr_release(mgr, conn);
+    vlc_mutex_unlock(&mgr->lock);
+
+    if (stream == NULL)
+        return NULL;
+
+    /* The initial response is waited for without the lock, so that other
+     * requests can be multiplexed on the same HTTP/2 connection meanwhile. */
+    struct vlc_http_msg *m = vlc_http_msg_get_initial(stream);
+    if (m != NULL)
+        return m;
+
+    /* NOTE: If the request were not idempotent, we would not know if it
+     * was processed by the other end. Thus POST is not used/supported so
+     * far, and CONNECT is treated as if it were idempotent (which works
+     * fine here). */
+
+    /* Get rid of closing or reset connection, unless another thread did */
+    vlc_mutex_lock(&mgr->lock);
+    int i = vlc_http_mgr_find(mgr, conn);
+    if (i >= 0)
+        vlc_http_mgr_release(mgr, i);
+    vlc_mutex_unlock(&mgr->lock);
     return NULL;
 }
 
+/**
+ * Sends a request on a fresh HTTP/1 connection that is not kept.
+ *
+ * HTTP/1 connections cannot be used by more than one thread, so a shared
+ * manager gives up on reusing them. The connection is destroyed along with
+ * the stream.
+ */
+static struct vlc_http_msg *vlc_http_mgr_once(struct vlc_http_conn *conn,
+                                              const struct vlc_http_msg *req)
+{
+    struct vlc_http_stream *stream = vlc_http_stream_open(conn, req);
+
+    vlc_http_conn_release(conn);
+    if (stream == NULL)
+        return NULL;
+    return vlc_http_msg_get_initial(stream);
+}
+
 static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
                                               const char *host, unsigned port,
                                               const struct vlc_http_msg *req)
@@ -149,21 +249,40 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
     vlc_tls_t *tls;
     bool http2 = true;
 
-    if (mgr->creds == NULL && mgr->conn != NULL)
+    vlc_mutex_lock(&mgr->lock);
+    if (mgr->creds == NULL && mgr->conn_count > 0)
+    {
+        vlc_mutex_unlock(&mgr->lock);
         return NULL; /* switch from HTTP to HTTPS not implemented */
+    }
 
     if (mgr->creds == NULL)
     {   /* First TLS connection: load x509 credentials */
         mgr->creds = vlc_tls_ClientCreate(mgr->obj);
         if (mgr->creds == NULL)
+        {
+            vlc_mutex_unlock(&mgr->lock);
             return NULL;
+        }
     }
+    vlc_mutex_unlock(&mgr->lock);
 
     /* TODO? non-idempotent request support */
     struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, req);
     if (resp != NULL)
         return resp; /* existing connection reused */
 
+    /* Connect with the lock held, so that concurrent requests wait for the
+     * new connection and share it rather than opening their own. */
+    vlc_mutex_lock(&mgr->lock);
+    for (unsigned i = 0; i < mgr->conn_count; i++)
+        if (mgr->conns[i].multiplexed
+         && vlc_http_mgr_match(&mgr->conns[i], host, port))
+        {   /* another thread connected meanwhile */
+            vlc_mutex_unlock(&mgr->lock);
+            return vlc_http_mgr_reuse(mgr, host, port, req);
+        }
+
     char *proxy = vlc_http_proxy_find(host, port, true);
     if (proxy != NULL)
     {
@@ -175,7 +294,10 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
         tls = vlc_https_connect(mgr->creds, host, port, &http2);
 
     if (tls == NULL)
+    {
+        vlc_mutex_unlock(&mgr->lock);
         return NULL;
+    }
 
     struct vlc_http_conn *conn;
 
@@ -193,11 +315,19 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
 
     if (unlikely(conn == NULL))
     {
+        vlc_mutex_unlock(&mgr->lock);
         vlc_tls_Close(tls);
         return NULL;
     }
 
-    mgr->conn = conn;
+    if (mgr->shared && !http2)
+    {
+        vlc_mutex_unlock(&mgr->lock);
+        return vlc_http_mgr_once(conn, req);
+    }
+
+    vlc_http_mgr_add(mgr, conn, host, port, http2);
+    vlc_mutex_unlock(&mgr->lock);
 
     return vlc_http_mgr_reuse(mgr, host, port, req);
 }
@@ -206,7 +336,10 @@ static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
                                              const char *host, unsigned port,
                                              const struct vlc_http_msg *req)
 {
-    if (mgr->creds != NULL && mgr->conn != NULL)
+    vlc_mutex_lock(&mgr->lock);
+    bool busy = mgr->creds != NULL && mgr->conn_count > 0;
+    vlc_mutex_unlock(&mgr->lock);
+    if (busy)
         return NULL; /* switch from HTTPS to HTTP not implemented */
 
     struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, req);
@@ -241,13 +374,15 @@ static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
         return NULL;
 
     resp = vlc_http_msg_get_initial(stream);
-    if (resp == NULL)
-    {
+    if (resp == NULL || mgr->shared)
+    {   /* HTTP/1 connections are not kept by a shared manager */
         vlc_http_conn_release(conn);
-        return NULL;
+        return resp;
     }
 
-    mgr->conn = conn;
+    vlc_mutex_lock(&mgr->lock);
+    vlc_http_mgr_add(mgr, conn, host, port, false);
+    vlc_mutex_unlock(&mgr->lock);
     return resp;
 }
 
@@ -273,15 +408,23 @@ struct vlc_http_mgr *vlc_http_mgr_create(vlc_object_t *obj,
     mgr->obj = obj;
     mgr->creds = NULL;
     mgr->jar = jar;
-    mgr->conn = NULL;
+    mgr->conn_count = 0;
+    vlc_mutex_init(&mgr->lock);
+    mgr->shared = false;
     return mgr;
 }
 
+void vlc_http_mgr_set_shared(struct vlc_http_mgr *mgr)
+{
+    mgr->shared = true;
+}
+
 void vlc_http_mgr_destroy(struct vlc_http_mgr *mgr)
 {
-    if (mgr->conn != NULL)
-        vlc_http_mgr_release(mgr, mgr->conn);
+    while (mgr->conn_count > 0)
+        vlc_http_mgr_release(mgr, mgr->conn_count - 1);
     if (mgr->creds != NULL)
         vlc_tls_Delete(mgr->creds);
+    vlc_mutex_destroy(&mgr->lock);
     free(mgr);
 }
@@ -64,6 +64,18 @@ struct vlc_http_cookie_jar_t *vlc_http_mgr_get_jar(struct vlc_http_mgr *);
 struct vlc_http_mgr *vlc_http_mgr_create(vlc_object_t *obj,
                                          struct vlc_http_cookie_jar_t *jar);
 
+/**
+ * Allows concurrent requests
+ *
+ * Lets several threads send requests through the same manager at once.
+ * If the server negotiates HTTP/2, all requests are multiplexed over a
+ * single connection. HTTP/1 connections on the other hand serve a single
+ * request and are not kept for reuse.
+ *
+ * This must be called before the first request.
+ */
+void vlc_http_mgr_set_shared(struct vlc_http_mgr *mgr);
+
 /**
  * Destroys an HTTP connection manager
  *
@@ -43,6 +43,7 @@ struct vlc_http_file
 {
     struct vlc_http_resource resource;
     uintmax_t offset;
+    uintmax_t end; /**< last byte of a bounded range, or UINTMAX_MAX */
 };
 
 static int vlc_http_file_req(const struct vlc_http_resource *res,
@@ -69,6 +70,10 @@ static int vlc_http_file_req(const struct vlc_http_resource *res,
         }
     }
 
+    if (file->end != UINTMAX_MAX)
+        return vlc_http_msg_add_header(req, "Range", "bytes=%ju-%ju",
+                                       *offset, file->end);
+
     if (vlc_http_msg_add_header(req, "Range", "bytes=%ju-", *offset)
      && *offset != 0)
         return -1;
@@ -126,6 +131,7 @@ struct vlc_http_resource *vlc_http_file_create(struct vlc_http_mgr *mgr,
     }
 
     file->offset = 0;
+    file->end = UINTMAX_MAX;
     return &file->resource;
 }
 
@@ -229,6 +235,24 @@ int vlc_http_file_seek(struct vlc_http_resource *res, uintmax_t offset)
     return 0;
 }
 
+struct vlc_http_msg *vlc_http_file_open_range(struct vlc_http_resource *res,
+                                              uintmax_t offset, uintmax_t end)
+{
+    struct vlc_http_file *file = (struct vlc_http_file *)res;
+
+    assert(offset <= end && end != UINTMAX_MAX);
+    file->end = end;
+    struct vlc_http_msg *resp = vlc_http_res_open(res, &offset);
+    file->end = UINTMAX_MAX;
+
+    if (resp != NULL && vlc_http_msg_get_status(resp) != 206)
+    {   /* The server ignored the range */
+        vlc_http_msg_destroy(resp);
+        resp = NULL;
+    }
+    return resp;
+}
+
 block_t *vlc_http_file_read(struct vlc_http_resource *res)
 {
     struct vlc_http_file *file = (struct vlc_http_file *)res;
@@ -28,6 +28,7 @@
  */
 
 struct vlc_http_mgr;
+struct vlc_http_msg;
 struct vlc_http_resource;
 struct block_t;
 
@@ -72,6 +73,20 @@ bool vlc_http_file_can_seek(struct vlc_http_resource *);
  */
 int vlc_http_file_seek(struct vlc_http_resource *, uintmax_t offset);
 
+/**
+ * Requests a bounded byte range.
+ *
+ * Sends a request for the bytes from offset to end included, independently
+ * of the read offset and of the current response of the file.
+ *
+ * @param offset first byte of the range
+ * @param end last byte of the range
+ * @return the partial content response (206) to read the range from,
+ *         or NULL on error
+ */
+struct vlc_http_msg *vlc_http_file_open_range(struct vlc_http_resource *,
+                                              uintmax_t offset, uintmax_t end);
+
 /**
  * Reads data.
  *
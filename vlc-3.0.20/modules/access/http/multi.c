@@ -0,0 +1,459 @@
+/*****************************************************************************
+ * multi.c: HTTP parallel ranges download
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_interrupt.h>
+#include "message.h"
+#include "connmgr.h"
+#include "resource.h"
+#include "file.h"
+#include "multi.h"
+
+/** Size of a range (bytes) */
+#define VLC_HTTP_MULTI_CHUNK (1 << 20)
+/** Ranges requested or buffered per connection */
+#define VLC_HTTP_MULTI_AHEAD 2
+/** Range request attempts, including reconnections */
+#define VLC_HTTP_MULTI_TRIES 2
+
+struct vlc_http_chunk
+{
+    struct vlc_http_chunk *next;
+    block_t *head;
+    block_t **tailp;
+    bool done;
+};
+
+struct vlc_http_worker
+{
+    struct vlc_http_multi *multi;
+    struct vlc_http_mgr *manager;
+    struct vlc_http_resource *resource;
+    vlc_interrupt_t *interrupt;
+    vlc_thread_t thread;
+};
+
+struct vlc_http_multi
+{
+    vlc_object_t *obj;
+    char *url;
+    char *ua;
+    char *ref;
+    char *user;
+    char *pass;
+    struct vlc_http_cookie_jar_t *jar;
+    uintmax_t size;
+    unsigned max;
+
+    vlc_mutex_t lock;
+    vlc_cond_t wait_data;
+    vlc_cond_t wait_space;
+    struct vlc_http_chunk *head; /**< range being read */
+    struct vlc_http_chunk **tailp;
+    unsigned pending; /**< ranges requested or buffered */
+    uintmax_t next; /**< offset of the next range to request */
+    unsigned alive; /**< running workers */
+    bool stopping;
+    bool failed;
+    bool starved; /**< reader waited since the last measure */
+    bool interrupted;
+
+    mtime_t since;
+    uintmax_t bytes; /**< bytes received since the last measure */
+    uintmax_t rate; /**< throughput at the last measure (bytes/s) */
+
+    unsigned count; /**< used workers */
+    struct vlc_http_worker workers[];
+};
+
+static int vlc_http_multi_spawn(struct vlc_http_multi *,
+                                struct vlc_http_worker *);
+
+/**
+ * Adds a connection if the reader is starving and the previous addition
+ * paid off, i.e. the throughput grew by more than an eighth.
+ */
+static void vlc_http_multi_adapt(struct vlc_http_multi *multi)
+{
+    mtime_t now = mdate();
+
+    if (now - multi->since < CLOCK_FREQ)
+        return;
+
+    uintmax_t rate = multi->bytes * CLOCK_FREQ / (now - multi->since);
+
+    if (multi->starved && !multi->stopping && multi->count < multi->max
+     && rate > multi->rate + multi->rate / 8
+     && vlc_http_multi_spawn(multi, &multi->workers[multi->count]) == 0)
+    {
+        msg_Dbg(multi->obj, "%ju kB/s, using %u connections", rate / 1024,
+                multi->count + 1);
+        multi->count++;
+    }
+
+    multi->since = now;
+    multi->bytes = 0;
+    multi->rate = rate;
+    multi->starved = false;
+}
+
+/**
+ * Receives a range into a chunk, reconnecting if the connection fails.
+ */
+static bool vlc_http_multi_fetch(struct vlc_http_worker *worker,
+                                 struct vlc_http_chunk *chunk,
+                                 uintmax_t offset, uintmax_t end)
+{
+    struct vlc_http_multi *multi = worker->multi;
+
+    for (unsigned i = 0; i < VLC_HTTP_MULTI_TRIES; i++)
+    {
+        struct vlc_http_msg *resp =
+            vlc_http_file_open_range(worker->resource, offset, end);
+        if (resp == NULL)
+            continue;
+
+        for (;;)
+        {
+            block_t *block = vlc_http_msg_read(resp);
+            if (block == NULL || block == vlc_http_error)
+                break;
+
+            if (block->i_buffer > end + 1 - offset)
+                block->i_buffer = end + 1 - offset; /* overlong response */
+            offset += block->i_buffer;
+
+            vlc_mutex_lock(&multi->lock);
+            block_ChainLastAppend(&chunk->tailp, block);
+            multi->bytes += block->i_buffer;
+            vlc_cond_signal(&multi->wait_data);
+            vlc_mutex_unlock(&multi->lock);
+
+            if (offset > end)
+                break;
+        }
+        vlc_http_msg_destroy(resp);
+
+        if (offset > end)
+            return true;
+        if (vlc_killed())
+            break;
+    }
+    return false;
+}
+
+static void *vlc_http_multi_thread(void *data)
+{
+    struct vlc_http_worker *worker = data;
+    struct vlc_http_multi *multi = worker->multi;
+
+    vlc_interrupt_set(worker->interrupt);
+
+    vlc_mutex_lock(&multi->lock);
+    for (;;)
+    {
+        while (!multi->stopping && multi->next < multi->size
+            && multi->pending >= VLC_HTTP_MULTI_AHEAD * multi->count)
+            vlc_cond_wait(&multi->wait_space, &multi->lock);
+
+        if (multi->stopping || multi->next >= multi->size)
+            break;
+
+        struct vlc_http_chunk *chunk = malloc(sizeof (*chunk));
+        if (unlikely(chunk == NULL))
+        {
+            multi->failed = true;
+            break;
+        }
+
+        uintmax_t offset = multi->next;
+
+        multi->next += __MIN(multi->size - offset, VLC_HTTP_MULTI_CHUNK);
+        uintmax_t end = multi->next - 1;
+        chunk->next = NULL;
+        chunk->head = NULL;
+        chunk->tailp = &chunk->head;
+        chunk->done = false;
+        *(multi->tailp) = chunk;
+        multi->tailp = &chunk->next;
+        multi->pending++;
+        vlc_mutex_unlock(&multi->lock);
+
+        bool ok = vlc_http_multi_fetch(worker, chunk, offset, end);
+
+        vlc_mutex_lock(&multi->lock);
+        chunk->done = true;
+        if (!ok)
+        {
+            multi->failed = true;
+            break;
+        }
+        vlc_http_multi_adapt(multi);
+    }
+    multi->alive--;
+    vlc_cond_signal(&multi->wait_data);
+    vlc_mutex_unlock(&multi->lock);
+    return NULL;
+}
+
+static int vlc_http_multi_spawn(struct vlc_http_multi *multi,
+                                struct vlc_http_worker *worker)
+{
+    if (worker->resource == NULL)
+    {
+        worker->manager = vlc_http_mgr_create(multi->obj, multi->jar);
+        if (unlikely(worker->manager == NULL))
+            return -1;
+
+        worker->resource = vlc_http_file_create(worker->manager, multi->url,
+                                                multi->ua, multi->ref);
+        if (worker->resource == NULL)
+        {
+            vlc_http_mgr_destroy(worker->manager);
+            return -1;
+        }
+
+        if (multi->user != NULL)
+            vlc_http_res_set_login(worker->resource, multi->user, multi->pass);
+    }
+
+    worker->interrupt = vlc_interrupt_create();
+    if (unlikely(worker->interrupt == NULL))
+        return -1;
+
+    if (vlc_clone(&worker->thread, vlc_http_multi_thread, worker,
+                  VLC_THREAD_PRIORITY_INPUT))
+    {
+        vlc_interrupt_destroy(worker->interrupt);
+        return -1;
+    }
+
+    multi->alive++;
+    return 0;
+}
+
+static void vlc_http_multi_start(struct vlc_http_multi *multi)
+{
+    unsigned count = multi->count;
+
+    vlc_mutex_lock(&multi->lock);
+    multi->count = 0;
+    multi->since = mdate();
+    multi->bytes = 0;
+
+    for (unsigned i = 0; i < count; i++)
+        if (vlc_http_multi_spawn(multi, &multi->workers[multi->count]) == 0)
+            multi->count++;
+    vlc_mutex_unlock(&multi->lock);
+}
+
+static void vlc_http_multi_stop(struct vlc_http_multi *multi)
+{
+    vlc_mutex_lock(&multi->lock);
+    multi->stopping = true;
+    vlc_cond_broadcast(&multi->wait_space);
+    vlc_mutex_unlock(&multi->lock);
+
+    /* No more workers can be added once stopping is set */
+    for (unsigned i = 0; i < multi->count; i++)
+        vlc_interrupt_kill(multi->workers[i].interrupt);
+
+    for (unsigned i = 0; i < multi->count; i++)
+    {
+        vlc_join(multi->workers[i].thread, NULL);
+        vlc_interrupt_destroy(multi->workers[i].interrupt);
+    }
+    assert(multi->alive == 0);
+
+    while (multi->head != NULL)
+    {
+        struct vlc_http_chunk *chunk = multi->head;
+
+        multi->head = chunk->next;
+        block_ChainRelease(chunk->head);
+        free(chunk);
+    }
+    multi->tailp = &multi->head;
+    multi->pending = 0;
+    multi->stopping = false;
+    multi->failed = false;
+}
+
+static void vlc_http_multi_wake_up(void *data)
+{
+    struct vlc_http_multi *multi = data;
+
+    vlc_mutex_lock(&multi->lock);
+    multi->interrupted = true;
+    vlc_cond_signal(&multi->wait_data);
+    vlc_mutex_unlock(&multi->lock);
+}
+
+block_t *vlc_http_multi_read(struct vlc_http_multi *multi)
+{
+    block_t *block = NULL;
+
+    vlc_interrupt_register(vlc_http_multi_wake_up, multi);
+    vlc_mutex_lock(&multi->lock);
+    multi->interrupted = false;
+
+    for (;;)
+    {
+        struct vlc_http_chunk *chunk = multi->head;
+
+        if (chunk != NULL && chunk->head != NULL)
+        {
+            block = chunk->head;
+            chunk->head = block->p_next;
+            if (chunk->head == NULL)
+                chunk->tailp = &chunk->head;
+            block->p_next = NULL;
+            break;
+        }
+
+        if (chunk != NULL && chunk->done)
+        {
+            multi->head = chunk->next;
+            if (multi->head == NULL)
+                multi->tailp = &multi->head;
+            multi->pending--;
+            free(chunk);
+            vlc_cond_signal(&multi->wait_space);
+            continue;
+        }
+
+        if (multi->failed || multi->interrupted)
+            break;
+        if (chunk == NULL && (multi->next >= multi->size || multi->alive == 0))
+            break; /* end of file */
+
+        multi->starved = true;
+        vlc_cond_wait(&multi->wait_data, &multi->lock);
+    }
+
+    vlc_mutex_unlock(&multi->lock);
+    vlc_interrupt_unregister();
+    return block;
+}
+
+void vlc_http_multi_seek(struct vlc_http_multi *multi, uintmax_t offset)
+{
+    vlc_http_multi_stop(multi);
+    multi->next = offset;
+    vlc_http_multi_start(multi);
+}
+
+static char *vlc_http_multi_strdup(const char *str)
+{
+    return (str != NULL) ? strdup(str) : NULL;
+}
+
+struct vlc_http_multi *vlc_http_multi_create(vlc_object_t *obj,
+                                             const char *url, const char *ua,
+                                             const char *ref, const char *user,
+                                             const char *pass,
+                                             struct vlc_http_cookie_jar_t *jar,
+                                             uintmax_t size, unsigned max)
+{
+    assert(max > 0);
+
+    struct vlc_http_multi *multi =
+        malloc(sizeof (*multi) + max * sizeof (multi->workers[0]));
+    if (unlikely(multi == NULL))
+        return NULL;
+
+    multi->obj = obj;
+    multi->url = strdup(url);
+    multi->ua = vlc_http_multi_strdup(ua);
+    multi->ref = vlc_http_multi_strdup(ref);
+    multi->user = vlc_http_multi_strdup(user);
+    multi->pass = vlc_http_multi_strdup(pass);
+    multi->jar = jar;
+    multi->size = size;
+    multi->max = max;
+
+    vlc_mutex_init(&multi->lock);
+    vlc_cond_init(&multi->wait_data);
+    vlc_cond_init(&multi->wait_space);
+    multi->head = NULL;
+    multi->tailp = &multi->head;
+    multi->pending = 0;
+    multi->next = 0;
+    multi->alive = 0;
+    multi->stopping = false;
+    multi->failed = false;
+    multi->starved = false;
+    multi->interrupted = false;
+    multi->rate = 0;
+
+    for (unsigned i = 0; i < max; i++)
+    {
+        multi->workers[i].multi = multi;
+        multi->workers[i].manager = NULL;
+        multi->workers[i].resource = NULL;
+    }
+
+    /* Two connections to begin with, more if they pay off */
+    multi->count = __MIN(max, 2);
+    vlc_http_multi_start(multi);
+
+    if (multi->count == 0)
+    {
+        vlc_http_multi_destroy(multi);
+        return NULL;
+    }
+    return multi;
+}
+
+void vlc_http_multi_destroy(struct vlc_http_multi *multi)
+{
+    vlc_http_multi_stop(multi);
+
+    for (unsigned i = 0; i < multi->max; i++)
+    {
+        struct vlc_http_worker *worker = &multi->workers[i];
+
+        if (worker->resource != NULL)
+        {
+            vlc_http_res_destroy(worker->resource);
+            vlc_http_mgr_destroy(worker->manager);
+        }
+    }
+
+    vlc_cond_destroy(&multi->wait_space);
+    vlc_cond_destroy(&multi->wait_data);
+    vlc_mutex_destroy(&multi->lock);
+    free(multi->pass);
+    free(multi->user);
+    free(multi->ref);
+    free(multi->ua);
+    free(multi->url);
+    free(multi);
+}
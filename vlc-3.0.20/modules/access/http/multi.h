@@ -0,0 +1,80 @@
+/*****************************************************************************
+ * multi.h: HTTP parallel ranges download declarations
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/**
+ * \defgroup http_multi Parallel ranges
+ * Download of a file through concurrent range requests
+ * \ingroup http_res
+ *
+ * A single TCP flow cannot fill a link with a large bandwidth-delay product.
+ * This fetches adjacent ranges of a file over several connections at once
+ * and hands them back in order. The number of connections grows as long as
+ * the reader is starving and the last added connection improved the
+ * measured throughput.
+ * @{
+ */
+
+struct vlc_http_multi;
+struct vlc_http_cookie_jar_t;
+struct block_t;
+
+/**
+ * Starts downloading a file in parallel ranges.
+ *
+ * The file must support byte ranges and have a known size.
+ *
+ * @param obj parent VLC object
+ * @param url URL of the file to read
+ * @param ua user agent string (or NULL to ignore)
+ * @param ref referral URL (or NULL to ignore)
+ * @param user user name (or NULL to ignore)
+ * @param pass password (or NULL to ignore)
+ * @param jar cookie jar (or NULL to ignore)
+ * @param size file size in bytes
+ * @param max maximum number of connections
+ *
+ * @return a download object, or NULL on error
+ */
+struct vlc_http_multi *vlc_http_multi_create(vlc_object_t *obj,
+                                             const char *url, const char *ua,
+                                             const char *ref, const char *user,
+                                             const char *pass,
+                                             struct vlc_http_cookie_jar_t *jar,
+                                             uintmax_t size, unsigned max);
+
+/**
+ * Reads data.
+ *
+ * Waits for and dequeues the next data block in file order.
+ *
+ * @return data block, or NULL on end of file, error or interruption
+ */
+struct block_t *vlc_http_multi_read(struct vlc_http_multi *);
+
+/**
+ * Restarts the download from a given offset.
+ *
+ * Connections are kept for the new ranges.
+ */
+void vlc_http_multi_seek(struct vlc_http_multi *, uintmax_t offset);
+
+void vlc_http_multi_destroy(struct vlc_http_multi *);
+
+/** @} */
@@ -100,6 +100,84 @@ static int rtp_timeout (vlc_tick_t deadline)
     return t;
 }
 
+#ifdef HAVE_RECVMMSG
+/**
+ * Receives as many pending datagrams as the batch allows with a single
+ * system call. Buffers left unused are kept for the next batch.
+ * @return false if no receive buffer could be allocated.
+ */
+static bool rtp_dgram_recv_batch (demux_t *demux, size_t *mru, int flags)
+{
+    demux_sys_t *sys = demux->p_sys;
+    block_t **pkts = sys->batch_pkts;
+    unsigned count;
+
+    for (count = 0; count < sys->batch; count++)
+    {
+        if (pkts[count] == NULL)
+        {
+            pkts[count] = block_Alloc (*mru);
+            if (unlikely(pkts[count] == NULL))
+                break;
+        }
+        sys->batch_iovs[count].iov_base = pkts[count]->p_buffer;
+        sys->batch_iovs[count].iov_len = *mru;
+        sys->batch_msgs[count].msg_hdr = (struct msghdr) {
+            .msg_iov = &sys->batch_iovs[count],
+            .msg_iovlen = 1,
+        };
+    }
+    if (unlikely(count == 0))
+        return false;
+
+    int val = recvmmsg (sys->fd, sys->batch_msgs, count,
+                        MSG_DONTWAIT | flags, NULL);
+    if (val < 0)
+    {
+        if (errno != EAGAIN && errno != EINTR)
+            msg_Warn (demux, "RTP network error: %s", vlc_strerror_c(errno));
+        return true;
+    }
+
+    const size_t old_mru = *mru;
+
+    for (int i = 0; i < val; i++)
+    {
+        block_t *block = pkts[i];
+        size_t len = sys->batch_msgs[i].msg_len;
+
+        pkts[i] = NULL;
+        if (sys->batch_msgs[i].msg_hdr.msg_flags & flags)
+        {
+            msg_Err(demux, "%zu bytes packet truncated (MRU was %zu)",
+                    len, old_mru);
+            block->i_flags |= BLOCK_FLAG_CORRUPTED;
+            if (len > *mru)
+                *mru = len;
+        }
+        else
+            block->i_buffer = len;
+
+        rtp_process (demux, block);
+    }
+
+    /* Move the spare buffers to the front, dropping them if too small */
+    for (unsigned i = val, j = 0; i < sys->batch; i++, j++)
+    {
+        block_t *block = pkts[i];
+
+        pkts[i] = NULL;
+        if (block != NULL && *mru != old_mru)
+        {
+            block_Release (block);
+            block = NULL;
+        }
+        pkts[j] = block;
+    }
+    return true;
+}
+#endif
+
 /**
  * RTP/RTCP session thread for datagram sockets
  */
@@ -145,6 +223,22 @@ void *rtp_dgram_thread (void *opaque)
             if (unlikely(ufd[0].revents & POLLHUP))
                 break; /* RTP socket dead (DCCP only) */
 
+#ifdef HAVE_RECVMMSG
+            if (sys->batch > 1)
+            {
+                size_t mru = iov.iov_len;
+
+                if (!rtp_dgram_recv_batch (demux, &mru, trunc_flag))
+                {
+                    if (iov.iov_len == DEFAULT_MRU)
+                        break; /* we are totallly screwed */
+                    iov.iov_len = DEFAULT_MRU;
+                    continue; /* retry with shrunk MRU */
+                }
+                iov.iov_len = mru;
+                goto dequeue;
+            }
+#endif
             block_t *block = block_Alloc (iov.iov_len);
             if (unlikely(block == NULL))
             {
@@ -57,6 +57,19 @@
     "Secure RTP requires a (non-secret) master salt value. " \
     "This must be a 28-character-long hexadecimal string.")
 
+#define SRTP_CIPHER_TEXT N_("SRTP cipher")
+#define SRTP_CIPHER_LONGTEXT N_( \
+    "Secure RTP encryption and authentication algorithms. " \
+    "AES-GCM (RFC 7714) authenticates with the cipher itself and is much " \
+    "cheaper than AES-CM with HMAC-SHA1. It also accepts a " \
+    "24-character-long salt.")
+
+#ifdef HAVE_SRTP
+static const char *const srtp_cipher_list[] = { "aes-cm", "aes-gcm" };
+static const char *const srtp_cipher_list_text[] = {
+    N_("AES-CM with HMAC-SHA1"), N_("AES-GCM") };
+#endif
+
 #define RTP_MAX_SRC_TEXT N_("Maximum RTP sources")
 #define RTP_MAX_SRC_LONGTEXT N_( \
     "How many distinct active RTP sources are allowed at a time." )
@@ -75,6 +88,10 @@
     "RTP packets will be discarded if they are too far behind (i.e. in the " \
     "past) by this many packets from the last received packet." )
 
+#define RTP_BATCH_TEXT N_("RTP datagrams per receive batch")
+#define RTP_BATCH_LONGTEXT N_( \
+    "Maximum number of RTP datagrams received with a single system call." )
+
 #define RTP_DYNAMIC_PT_TEXT N_("RTP payload format assumed for dynamic " \
                                "payloads")
 #define RTP_DYNAMIC_PT_LONGTEXT N_( \
@@ -110,6 +127,10 @@ vlc_module_begin ()
     add_string ("srtp-salt", "",
                 SRTP_SALT_TEXT, SRTP_SALT_LONGTEXT, false)
         change_safe ()
+    add_string ("srtp-cipher", "aes-cm",
+                SRTP_CIPHER_TEXT, SRTP_CIPHER_LONGTEXT, true)
+        change_string_list (srtp_cipher_list, srtp_cipher_list_text)
+        change_safe ()
 #endif
     add_integer ("rtp-max-src", 1, RTP_MAX_SRC_TEXT,
                  RTP_MAX_SRC_LONGTEXT, true)
@@ -122,6 +143,11 @@ vlc_module_begin ()
     add_integer ("rtp-max-misorder", 100, RTP_MAX_MISORDER_TEXT,
                  RTP_MAX_MISORDER_LONGTEXT, true)
         change_integer_range (0, 32767)
+#ifdef HAVE_RECVMMSG
+    add_integer ("rtp-batch", 1, RTP_BATCH_TEXT,
+                 RTP_BATCH_LONGTEXT, true)
+        change_integer_range (1, 1024)
+#endif
     add_string ("rtp-dynamic-pt", NULL, RTP_DYNAMIC_PT_TEXT,
                 RTP_DYNAMIC_PT_LONGTEXT, true)
         change_string_list (dynamic_pt_list, dynamic_pt_list_text)
@@ -269,6 +295,26 @@ static int Open (vlc_object_t *obj)
     p_sys->max_misorder = var_CreateGetInteger (obj, "rtp-max-misorder");
     p_sys->thread_ready = false;
     p_sys->autodetect   = true;
+#ifdef HAVE_RECVMMSG
+    p_sys->batch        = 1;
+    p_sys->batch_msgs   = NULL;
+    p_sys->batch_iovs   = NULL;
+    p_sys->batch_pkts   = NULL;
+    if (tp != IPPROTO_TCP)
+    {
+        unsigned batch = var_CreateGetInteger (obj, "rtp-batch");
+        if (batch > 1)
+        {
+            p_sys->batch_msgs = calloc (batch, sizeof (struct mmsghdr));
+            p_sys->batch_iovs = calloc (batch, sizeof (struct iovec));
+            p_sys->batch_pkts = calloc (batch, sizeof (block_t *));
+            if (likely(p_sys->batch_msgs != NULL
+                    && p_sys->batch_iovs != NULL
+                    && p_sys->batch_pkts != NULL))
+                p_sys->batch = batch;
+        }
+    }
+#endif
 
     demux->pf_demux   = NULL;
     demux->pf_control = Control;
@@ -282,9 +328,17 @@ static int Open (vlc_object_t *obj)
     char *key = var_CreateGetNonEmptyString (demux, "srtp-key");
     if (key)
     {
+        char *cipher = var_CreateGetString (demux, "srtp-cipher");
+        bool gcm = cipher != NULL && !strcmp (cipher, "aes-gcm");
+        free (cipher);
+
         vlc_gcrypt_init ();
-        p_sys->srtp = srtp_create (SRTP_ENCR_AES_CM, SRTP_AUTH_HMAC_SHA1, 10,
-                                   SRTP_PRF_AES_CM, SRTP_RCC_MODE1);
+        if (gcm)
+            p_sys->srtp = srtp_create (SRTP_ENCR_AES_GCM, SRTP_AUTH_NULL, 16,
+                                       SRTP_PRF_AES_CM, 0);
+        else
+            p_sys->srtp = srtp_create (SRTP_ENCR_AES_CM, SRTP_AUTH_HMAC_SHA1,
+                                       10, SRTP_PRF_AES_CM, SRTP_RCC_MODE1);
         if (p_sys->srtp == NULL)
         {
             free (key);
@@ -337,6 +391,15 @@ static void Close (vlc_object_t *obj)
 #endif
     if (p_sys->session)
         rtp_session_destroy (demux, p_sys->session);
+#ifdef HAVE_RECVMMSG
+    if (p_sys->batch_pkts != NULL)
+        for (unsigned i = 0; i < p_sys->batch; i++)
+            if (p_sys->batch_pkts[i] != NULL)
+                block_Release (p_sys->batch_pkts[i]);
+    free (p_sys->batch_pkts);
+    free (p_sys->batch_iovs);
+    free (p_sys->batch_msgs);
+#endif
     if (p_sys->rtcp_fd != -1)
         net_Close (p_sys->rtcp_fd);
     net_Close (p_sys->fd);
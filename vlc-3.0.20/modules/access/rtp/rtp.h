@@ -77,6 +77,12 @@ struct demux_sys_t
     uint16_t      max_dropout; /**< Max packet forward misordering */
     uint16_t      max_misorder; /**< Max packet backward misordering */
     uint8_t       max_src; /**< Max simultaneous RTP sources */
+#ifdef HAVE_RECVMMSG
+    unsigned      batch; /**< Max datagrams per receive call */
+    struct mmsghdr *batch_msgs;
+    struct iovec  *batch_iovs;
+    block_t      **batch_pkts; /**< Spare receive buffers */
+#endif
     bool          thread_ready;
     bool          autodetect; /**< Payload type autodetection pending */
 };
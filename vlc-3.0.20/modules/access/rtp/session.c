@@ -149,7 +149,11 @@ struct rtp_source_t
     uint16_t max_seq; /* next expected sequence */
 
     uint16_t last_seq; /* sequence of the next dequeued packet */
-    block_t *blocks; /* re-ordered blocks queue */
+    uint16_t first_seq; /* lowest queued sequence */
+    uint16_t high_seq; /* highest queued sequence */
+    uint16_t ring_mask; /* re-ordering ring size minus one */
+    unsigned ring_count; /* number of queued packets */
+    block_t **ring; /* re-ordered packets, indexed by sequence number */
     void    *opaque[]; /* Per-source private payload data */
 };
 
@@ -160,12 +164,29 @@ static rtp_source_t *
 rtp_source_create (demux_t *demux, const rtp_session_t *session,
                    uint32_t ssrc, uint16_t init_seq)
 {
+    demux_sys_t *p_sys = demux->p_sys;
     rtp_source_t *source;
 
     source = malloc (sizeof (*source) + (sizeof (void *) * session->ptc));
     if (source == NULL)
         return NULL;
 
+    /* The ring must hold every sequence number accepted by the dropout and
+     * misorder checks, while keeping sequence comparisons unambiguous. */
+    unsigned size = 64;
+    while (size < 0x8000
+        && size <= (unsigned)p_sys->max_dropout + p_sys->max_misorder)
+        size <<= 1;
+
+    source->ring = calloc (size, sizeof (*source->ring));
+    if (source->ring == NULL)
+    {
+        free (source);
+        return NULL;
+    }
+    source->ring_mask = size - 1;
+    source->ring_count = 0;
+
     source->ssrc = ssrc;
     source->jitter = 0;
     source->ref_rtp = 0;
@@ -173,7 +194,6 @@ rtp_source_create (demux_t *demux, const rtp_session_t *session,
     source->ref_ntp = UINT64_C (1) << 62;
     source->max_seq = source->bad_seq = init_seq;
     source->last_seq = init_seq - 1;
-    source->blocks = NULL;
 
     /* Initializes all payload */
     for (unsigned i = 0; i < session->ptc; i++)
@@ -187,6 +207,8 @@ rtp_source_create (demux_t *demux, const rtp_session_t *session,
 /**
  * Destroys an RTP source and its associated streams.
  */
+static void rtp_source_flush (rtp_source_t *);
+
 static void
 rtp_source_destroy (demux_t *demux, const rtp_session_t *session,
                     rtp_source_t *source)
@@ -195,10 +217,46 @@ rtp_source_destroy (demux_t *demux, const rtp_session_t *session,
 
     for (unsigned i = 0; i < session->ptc; i++)
         session->ptv[i].destroy (demux, source->opaque[i]);
-    block_ChainRelease (source->blocks);
+    rtp_source_flush (source);
+    free (source->ring);
     free (source);
 }
 
+/**
+ * Returns the queued packet with the lowest sequence number, if any.
+ */
+static inline block_t *rtp_source_peek (const rtp_source_t *src)
+{
+    if (src->ring_count == 0)
+        return NULL;
+    return src->ring[src->first_seq & src->ring_mask];
+}
+
+/**
+ * Removes the queued packet with the lowest sequence number.
+ * Finding the next one is amortized over the packets already queued.
+ */
+static block_t *rtp_source_pop (rtp_source_t *src)
+{
+    block_t **slot = &src->ring[src->first_seq & src->ring_mask];
+    block_t *block = *slot;
+
+    assert (block != NULL);
+    *slot = NULL;
+    if (--src->ring_count > 0)
+        while (src->ring[++src->first_seq & src->ring_mask] == NULL);
+    return block;
+}
+
+/**
+ * Releases all queued packets.
+ */
+static void rtp_source_flush (rtp_source_t *src)
+{
+    while (src->ring_count > 0)
+        block_Release (rtp_source_pop (src));
+}
+
 static inline uint16_t rtp_seq (const block_t *block)
 {
     assert (block->i_buffer >= 4);
@@ -338,8 +396,7 @@ rtp_queue (demux_t *demux, rtp_session_t *session, block_t *block)
             src->max_seq = src->bad_seq = seq + 1;
             src->last_seq = seq - 0x7fffe; /* hack for rtp_decode() */
             msg_Warn (demux, "sequence resynchronized");
-            block_ChainRelease (src->blocks);
-            src->blocks = NULL;
+            rtp_source_flush (src);
         }
         else
         {
@@ -351,23 +408,52 @@ rtp_queue (demux_t *demux, rtp_session_t *session, block_t *block)
     if (delta_seq >= 0)
         src->max_seq = seq + 1;
 
+    if ((int16_t)(seq - (src->last_seq + 1)) < 0)
+    {   /* Trash too late packets (and PIM Assert duplicates) */
+        msg_Dbg (demux, "ignoring late packet (sequence: %"PRIu16")", seq);
+        goto drop;
+    }
+
     /* Queues the block in sequence order,
-     * hence there is a single queue for all payload types. */
-    block_t **pp = &src->blocks;
-    for (block_t *prev = *pp; prev != NULL; prev = *pp)
+     * hence there is a single queue for all payload types.
+     * Queued sequence numbers always span less than the ring size, so that
+     * each has its own slot. */
+    if (src->ring_count == 0)
+        src->first_seq = src->high_seq = seq;
+    else
+    if ((int16_t)(seq - src->first_seq) < 0)
     {
-        delta_seq = seq - rtp_seq (prev);
-        if (delta_seq < 0)
-            break;
-        if (delta_seq == 0)
+        if ((uint16_t)(src->high_seq - seq) > src->ring_mask)
         {
-            msg_Dbg (demux, "duplicate packet (sequence: %"PRIu16")", seq);
-            goto drop; /* duplicate */
+            msg_Dbg (demux, "ignoring late packet (sequence: %"PRIu16")",
+                     seq);
+            goto drop;
         }
-        pp = &prev->p_next;
+        src->first_seq = seq;
     }
-    block->p_next = *pp;
-    *pp = block;
+    else
+    {
+        /* Give up on missing packets too far behind */
+        while (src->ring_count > 0
+            && (uint16_t)(seq - src->first_seq) > src->ring_mask)
+            rtp_decode (demux, session, src);
+
+        if (src->ring_count == 0)
+            src->first_seq = src->high_seq = seq;
+        else
+        if ((int16_t)(seq - src->high_seq) > 0)
+            src->high_seq = seq;
+    }
+
+    block_t **slot = &src->ring[seq & src->ring_mask];
+    if (*slot != NULL)
+    {
+        msg_Dbg (demux, "duplicate packet (sequence: %"PRIu16")", seq);
+        goto drop; /* duplicate */
+    }
+    block->p_next = NULL;
+    *slot = block;
+    src->ring_count++;
 
     /*rtp_decode (demux, session, src);*/
     return;
@@ -420,7 +506,7 @@ bool rtp_dequeue (demux_t *demux, const rtp_session_t *session,
          * LibVLC E/S-out clock synchronization. Here, we need to bother about
          * re-ordering packets, as decoders can't cope with mis-ordered data.
          */
-        while (((block = src->blocks)) != NULL)
+        while ((block = rtp_source_peek (src)) != NULL)
         {
             if ((int16_t)(rtp_seq (block) - (src->last_seq + 1)) <= 0)
             {   /* Next (or earlier) block ready, no need to wait */
@@ -471,9 +557,8 @@ void rtp_dequeue_force (demux_t *demux, const rtp_session_t *session)
     for (unsigned i = 0, max = session->srcc; i < max; i++)
     {
         rtp_source_t *src = session->srcv[i];
-        block_t *block;
 
-        while (((block = src->blocks)) != NULL)
+        while (src->ring_count > 0)
             rtp_decode (demux, session, src);
     }
 }
@@ -484,22 +569,14 @@ void rtp_dequeue_force (demux_t *demux, const rtp_session_t *session)
 static void
 rtp_decode (demux_t *demux, const rtp_session_t *session, rtp_source_t *src)
 {
-    block_t *block = src->blocks;
-
-    assert (block);
-    src->blocks = block->p_next;
-    block->p_next = NULL;
+    block_t *block = rtp_source_pop (src);
 
     /* Discontinuity detection */
     uint16_t delta_seq = rtp_seq (block) - (src->last_seq + 1);
     if (delta_seq != 0)
     {
-        if (delta_seq >= 0x8000)
-        {   /* Trash too late packets (and PIM Assert duplicates) */
-            msg_Dbg (demux, "ignoring late packet (sequence: %"PRIu16")",
-                      rtp_seq (block));
-            goto drop;
-        }
+        /* Late packets are never queued, see rtp_queue() */
+        assert (delta_seq < 0x8000);
         msg_Warn (demux, "%"PRIu16" packet(s) lost", delta_seq);
         block->i_flags |= BLOCK_FLAG_DISCONTINUITY;
     }
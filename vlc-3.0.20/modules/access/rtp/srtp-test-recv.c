@@ -33,6 +33,117 @@
 #include <assert.h>
 
 
+static void test_aes_gcm (void)
+{
+    static const char key[] = "0123456789ABCDEF" "0123456789ABCDEF";
+    static const char salt[] = "517569642070726F2071756F"; /* 12 bytes */
+    srtp_session_t *sd, *se;
+    int val;
+
+    /* HMAC and RCC do not apply to AES-GCM */
+    se = srtp_create (SRTP_ENCR_AES_GCM, SRTP_AUTH_HMAC_SHA1, 16,
+                      SRTP_PRF_AES_CM, 0);
+    assert (se == NULL);
+    se = srtp_create (SRTP_ENCR_AES_GCM, SRTP_AUTH_NULL, 10,
+                      SRTP_PRF_AES_CM, 0);
+    assert (se == NULL);
+    se = srtp_create (SRTP_ENCR_AES_GCM, SRTP_AUTH_NULL, 16,
+                      SRTP_PRF_AES_CM, SRTP_RCC_MODE1);
+    assert (se == NULL);
+
+    se = srtp_create (SRTP_ENCR_AES_GCM, SRTP_AUTH_NULL, 16,
+                      SRTP_PRF_AES_CM, 0);
+    assert (se != NULL);
+    sd = srtp_create (SRTP_ENCR_AES_GCM, SRTP_AUTH_NULL, 16,
+                      SRTP_PRF_AES_CM, 0);
+    assert (sd != NULL);
+
+    val = srtp_setkeystring (se, key, salt);
+    assert (val == 0);
+    val = srtp_setkeystring (sd, key, salt);
+    assert (val == 0);
+
+    uint8_t buf[1500], buf2[1500];
+    size_t len;
+
+    /* Too small buffer */
+    len = 0x10c;
+    memset (buf, 0, len);
+    buf[0] = 0x80;
+    buf[3] = 3;
+    val = srtp_send (se, buf, &len, 0x11b);
+    assert (val == ENOSPC);
+    assert (len == 0x11c);
+
+    /* OK (seq=3) */
+    for (unsigned i = 0; i < 256; i++)
+        buf[i + 12] = i;
+    len = 0x10c;
+    val = srtp_send (se, buf, &len, sizeof (buf));
+    assert (val == 0);
+    assert (len == 0x11c);
+    assert (!memcmp (buf, "\x80\x00\x00\x03", 4)); /* header in clear */
+    assert (buf[12] != 0 || buf[13] != 1 || buf[14] != 2);
+
+    /* Tampered header or payload */
+    for (unsigned off = 1; off < len; off += 0x10b)
+    {
+        memcpy (buf2, buf, len);
+        buf2[off] ^= 0x40;
+        size_t len2 = len;
+        val = srtp_recv (sd, buf2, &len2);
+        assert (val == EACCES);
+    }
+
+    memcpy (buf2, buf, len);
+    val = srtp_recv (sd, buf2, &len);
+    assert (val == 0);
+    assert (len == 0x10c);
+    assert (!memcmp (buf2, "\x80\x00\x00\x03" "\x00\x00\x00\x00"
+                           "\x00\x00\x00\x00", 12));
+    for (unsigned i = 0; i < 256; i++)
+        assert (buf2[i + 12] == i); // test actual decryption
+
+    /* Replay attack (seq=3) */
+    len = 0x11c;
+    val = srtp_recv (sd, buf, &len);
+    assert (val == EACCES);
+
+    /* OK but late (seq=2) */
+    len = 0x10c;
+    memset (buf, 0, len);
+    buf[0] = 0x80;
+    buf[3] = 2;
+    val = srtp_send (se, buf, &len, sizeof (buf));
+    assert (val == 0);
+    val = srtp_recv (sd, buf, &len);
+    assert (val == 0);
+    assert (len == 0x10c);
+
+    /* SRTCP round trip */
+    static const uint8_t rtcp[] = "\x80\xc8\x00\x06" "\x12\x34\x56\x78"
+                                  "Sender report payload";
+    len = sizeof (rtcp);
+    memcpy (buf, rtcp, len);
+    val = srtcp_send (se, buf, &len, sizeof (buf));
+    assert (val == 0);
+    assert (len == sizeof (rtcp) + 16 + 4);
+    assert (memcmp (buf + 8, rtcp + 8, sizeof (rtcp) - 8));
+
+    memcpy (buf2, buf, len);
+    val = srtcp_recv (sd, buf2, &len);
+    assert (val == 0);
+    assert (len == sizeof (rtcp));
+    assert (!memcmp (buf2, rtcp, len));
+
+    len = sizeof (rtcp) + 16 + 4;
+    val = srtcp_recv (sd, buf, &len);
+    assert (val == EACCES);
+
+    srtp_destroy (se);
+    srtp_destroy (sd);
+}
+
 int main (void)
 {
     static const char key[] =
@@ -168,5 +279,7 @@ int main (void)
 
     srtp_destroy (se);
     srtp_destroy (sd);
+
+    test_aes_gcm ();
     return 0;
 }
@@ -66,6 +66,7 @@ struct srtp_session_t
     uint16_t rtp_seq;
     uint16_t rtp_rcc;
     uint8_t  tag_len;
+    bool     aead; /* authenticated encryption, without HMAC */
 };
 
 enum
@@ -105,9 +106,9 @@ void srtp_destroy (srtp_session_t *s)
 }
 
 
-static int proto_create (srtp_proto_t *p, int gcipher, int gmd)
+static int proto_create (srtp_proto_t *p, int gcipher, int gmode, int gmd)
 {
-    if (gcry_cipher_open (&p->cipher, gcipher, GCRY_CIPHER_MODE_CTR, 0) == 0)
+    if (gcry_cipher_open (&p->cipher, gcipher, gmode, 0) == 0)
     {
         if (gcry_md_open (&p->mac, gmd, GCRY_MD_FLAG_HMAC) == 0)
             return 0;
@@ -123,6 +124,10 @@ static int proto_create (srtp_proto_t *p, int gcipher, int gmd)
  * internal cryptographic counters; it is however of course feasible to open
  * multiple simultaneous sessions with the same master key.
  *
+ * With AES-GCM, the cipher authenticates the packets by itself: the
+ * authentication algorithm must be SRTP_AUTH_NULL, the tag must be 8, 12 or
+ * 16 bytes long, and no flags are supported.
+ *
  * @param encr encryption algorithm number
  * @param auth authentication algorithm number
  * @param tag_len authentication tag byte length (NOT including RCC)
@@ -136,7 +141,7 @@ srtp_create (int encr, int auth, unsigned tag_len, int prf, unsigned flags)
     if ((flags & ~SRTP_FLAGS_MASK))
         return NULL;
 
-    int cipher, md;
+    int cipher, mode = GCRY_CIPHER_MODE_CTR, md;
     switch (encr)
     {
         case SRTP_ENCR_NULL:
@@ -147,6 +152,11 @@ srtp_create (int encr, int auth, unsigned tag_len, int prf, unsigned flags)
             cipher = GCRY_CIPHER_AES;
             break;
 
+        case SRTP_ENCR_AES_GCM:
+            cipher = GCRY_CIPHER_AES;
+            mode = GCRY_CIPHER_MODE_GCM;
+            break;
+
         default:
             return NULL;
     }
@@ -165,6 +175,13 @@ srtp_create (int encr, int auth, unsigned tag_len, int prf, unsigned flags)
             return NULL;
     }
 
+    if (mode == GCRY_CIPHER_MODE_GCM)
+    {
+        if (md != GCRY_MD_NONE || flags
+         || (tag_len != 8 && tag_len != 12 && tag_len != 16))
+            return NULL;
+    }
+    else
     if (tag_len > gcry_md_get_algo_dlen (md))
         return NULL;
 
@@ -179,15 +196,16 @@ srtp_create (int encr, int auth, unsigned tag_len, int prf, unsigned flags)
     s->flags = flags;
     s->tag_len = tag_len;
     s->rtp_rcc = 1; /* Default RCC rate */
+    s->aead = mode == GCRY_CIPHER_MODE_GCM;
     if (rcc_mode (s))
     {
         if (tag_len < 4)
             goto error;
     }
 
-    if (proto_create (&s->rtp, cipher, md) == 0)
+    if (proto_create (&s->rtp, cipher, mode, md) == 0)
     {
-        if (proto_create (&s->rtcp, cipher, md) == 0)
+        if (proto_create (&s->rtcp, cipher, mode, md) == 0)
             return s;
         proto_destroy (&s->rtp);
     }
@@ -205,26 +223,59 @@ error:
 static int
 do_ctr_crypt (gcry_cipher_hd_t hd, const void *ctr, uint8_t *data, size_t len)
 {
-    const size_t ctrlen = 16;
-    div_t d = div (len, ctrlen);
-
-    if (gcry_cipher_setctr (hd, ctr, ctrlen)
-     || gcry_cipher_encrypt (hd, data, d.quot * ctrlen, NULL, 0))
+    /* libgcrypt handles the truncated last block in CTR mode */
+    if (gcry_cipher_setctr (hd, ctr, 16)
+     || gcry_cipher_encrypt (hd, data, len, NULL, 0))
         return -1;
+    return 0;
+}
 
-    if (d.rem)
-    {
-        /* Truncated last block */
-        uint8_t dummy[ctrlen];
-        data += d.quot * ctrlen;
-        memcpy (dummy, data, d.rem);
-        memset (dummy + d.rem, 0, ctrlen - d.rem);
 
-        if (gcry_cipher_encrypt (hd, dummy, ctrlen, data, ctrlen))
-            return -1;
-        memcpy (data, dummy, d.rem);
+/**
+ * Sets the AES-GCM initialization vector (salt = 12 bytes):
+ * 2 nul bytes, the SSRC and the 48-bits packet index, XOR'ed with the salt.
+ */
+static int
+do_aead_setiv (gcry_cipher_hd_t hd, const uint32_t *salt, uint32_t ssrc,
+               uint64_t index)
+{
+    const uint8_t *k = (const uint8_t *)salt;
+    uint8_t iv[12];
+
+    iv[0] = iv[1] = 0;
+    memcpy (iv + 2, &ssrc, 4);
+    for (unsigned i = 0; i < 6; i++)
+        iv[6 + i] = index >> (40 - 8 * i);
+    for (unsigned i = 0; i < sizeof (iv); i++)
+        iv[i] ^= k[i];
+
+    return gcry_cipher_setiv (hd, iv, sizeof (iv)) ? -1 : 0;
+}
+
+
+/**
+ * AES-GCM encryption/decryption, once the associated data is authenticated.
+ * The tag is computed on encryption, and verified on decryption.
+ *
+ * @return 0 on success, EACCES if the tag does not match, EINVAL otherwise
+ */
+static int
+do_aead_crypt (gcry_cipher_hd_t hd, uint8_t *data, size_t len,
+               uint8_t *tag, size_t tag_len, bool decrypt)
+{
+    if (decrypt)
+    {
+        if (gcry_cipher_decrypt (hd, data, len, NULL, 0))
+            return EINVAL;
+        return gcry_cipher_checktag (hd, tag, tag_len) ? EACCES : 0;
     }
 
+    uint8_t full[16];
+
+    if (gcry_cipher_encrypt (hd, data, len, NULL, 0)
+     || gcry_cipher_gettag (hd, full, sizeof (full)))
+        return EINVAL;
+    memcpy (tag, full, tag_len);
     return 0;
 }
 
@@ -268,8 +319,19 @@ srtp_setkey (srtp_session_t *s, const void *key, size_t keylen,
 {
     /* SRTP/SRTCP cipher/salt/MAC keys derivation */
     gcry_cipher_hd_t prf;
-    uint8_t r[6], keybuf[20];
+    uint8_t r[6], keybuf[20], mastersalt[14];
+    /* AES-GCM uses a 12 bytes session salt (RFC 7714 §8.1) */
+    const size_t sessionsaltlen = s->aead ? 12 : 14;
 
+    /* AES-GCM also takes a 12 bytes master salt, padded with nul bytes for
+     * the AES-CM key derivation function (RFC 7714 §11) */
+    if (saltlen == 12 && s->aead)
+    {
+        memcpy (mastersalt, salt, 12);
+        memset (mastersalt + 12, 0, 2);
+        salt = mastersalt;
+    }
+    else
     if (saltlen != 14)
         return EINVAL;
 
@@ -295,18 +357,21 @@ srtp_setkey (srtp_session_t *s, const void *key, size_t keylen,
         memset (r, 0, sizeof (r));
     if (do_derive (prf, salt, r, 6, SRTP_CRYPT, keybuf, 16)
      || gcry_cipher_setkey (s->rtp.cipher, keybuf, 16)
-     || do_derive (prf, salt, r, 6, SRTP_AUTH, keybuf, 20)
-     || gcry_md_setkey (s->rtp.mac, keybuf, 20)
-     || do_derive (prf, salt, r, 6, SRTP_SALT, s->rtp.salt, 14))
+     || (!s->aead
+      && (do_derive (prf, salt, r, 6, SRTP_AUTH, keybuf, 20)
+       || gcry_md_setkey (s->rtp.mac, keybuf, 20)))
+     || do_derive (prf, salt, r, 6, SRTP_SALT, s->rtp.salt, sessionsaltlen))
         return -1;
 
     /* SRTCP key derivation */
     memcpy (r, &(uint32_t){ htonl (s->rtcp_index) }, 4);
     if (do_derive (prf, salt, r, 4, SRTCP_CRYPT, keybuf, 16)
      || gcry_cipher_setkey (s->rtcp.cipher, keybuf, 16)
-     || do_derive (prf, salt, r, 4, SRTCP_AUTH, keybuf, 20)
-     || gcry_md_setkey (s->rtcp.mac, keybuf, 20)
-     || do_derive (prf, salt, r, 4, SRTCP_SALT, s->rtcp.salt, 14))
+     || (!s->aead
+      && (do_derive (prf, salt, r, 4, SRTCP_AUTH, keybuf, 20)
+       || gcry_md_setkey (s->rtcp.mac, keybuf, 20)))
+     || do_derive (prf, salt, r, 4, SRTCP_SALT, s->rtcp.salt,
+                   sessionsaltlen))
         return -1;
 
     (void)gcry_cipher_close (prf);
@@ -447,24 +512,16 @@ rtp_digest (gcry_md_hd_t md, const uint8_t *data, size_t len,
 
 
 /**
- * Encrypts/decrypts a RTP packet and updates SRTP context
- * (CTR block cypher mode of operation has identical encryption and
- * decryption function).
- *
- * @param buf RTP packet to be en-/decrypted
- * @param len RTP packet length
+ * Computes the RTP header length (i.e. the encryption offset).
  *
- * @return 0 on success, in case of error:
- *  EINVAL  malformatted RTP packet
- *  EACCES  replayed packet or out-of-window or sync lost
+ * @return the header length, or 0 if the RTP packet is malformatted
  */
-static int srtp_crypt (srtp_session_t *s, uint8_t *buf, size_t len)
+static size_t rtp_header_len (const uint8_t *buf, size_t len)
 {
-    assert (s != NULL);
     assert (len >= 12u);
 
     if ((buf[0] >> 6) != 2)
-        return EINVAL;
+        return 0;
 
     /* Computes encryption offset */
     uint16_t offset = 12;
@@ -476,37 +533,82 @@ static int srtp_crypt (srtp_session_t *s, uint8_t *buf, size_t len)
 
         offset += 4;
         if (len < offset)
-            return EINVAL;
+            return 0;
 
         memcpy (&extlen, buf + offset - 2, 2);
         offset += htons (extlen); // skips RTP extension header
     }
 
     if (len < offset)
-        return EINVAL;
+        return 0;
+    return offset;
+}
 
-    /* Determines RTP 48-bits counter and SSRC */
-    uint16_t seq = rtp_seq (buf);
-    uint32_t roc = srtp_compute_roc (s, seq), ssrc;
-    memcpy (&ssrc, buf + 8, 4);
 
-    /* Updates ROC and sequence (it's safe now) */
+/** Checks whether a RTP sequence was already seen or is out-of-window */
+static bool srtp_replayed (const srtp_session_t *s, uint16_t seq)
+{
+    int16_t diff = seq - s->rtp_seq;
+    if (diff > 0)
+        return false; /* Sequence in the future, good */
+
+    /* Sequence in the past/present, bad */
+    unsigned back = -(int)diff;
+    return (back >= 64) || ((s->rtp.window >> back) & 1);
+}
+
+
+/**
+ * Updates ROC, sequence and replay window.
+ *
+ * @return 0 on success, EACCES if the packet is replayed or out-of-window
+ */
+static int srtp_update_seq (srtp_session_t *s, uint16_t seq, uint32_t roc)
+{
+    if (srtp_replayed (s, seq))
+        return EACCES; /* Replay attack */
+
     int16_t diff = seq - s->rtp_seq;
     if (diff > 0)
     {
-        /* Sequence in the future, good */
-        s->rtp.window = s->rtp.window << diff;
+        s->rtp.window = (diff < 64) ? (s->rtp.window << diff) : 0;
         s->rtp.window |= UINT64_C(1);
         s->rtp_seq = seq, s->rtp_roc = roc;
     }
     else
-    {
-        /* Sequence in the past/present, bad */
-        diff = -diff;
-        if ((diff >= 64) || ((s->rtp.window >> diff) & 1))
-            return EACCES; /* Replay attack */
-        s->rtp.window |= UINT64_C(1) << diff;
-    }
+        s->rtp.window |= UINT64_C(1) << -diff;
+    return 0;
+}
+
+
+/**
+ * Encrypts/decrypts a RTP packet and updates SRTP context
+ * (CTR block cypher mode of operation has identical encryption and
+ * decryption function).
+ *
+ * @param buf RTP packet to be en-/decrypted
+ * @param len RTP packet length
+ *
+ * @return 0 on success, in case of error:
+ *  EINVAL  malformatted RTP packet
+ *  EACCES  replayed packet or out-of-window or sync lost
+ */
+static int srtp_crypt (srtp_session_t *s, uint8_t *buf, size_t len)
+{
+    assert (s != NULL);
+
+    size_t offset = rtp_header_len (buf, len);
+    if (offset == 0)
+        return EINVAL;
+
+    /* Determines RTP 48-bits counter and SSRC */
+    uint16_t seq = rtp_seq (buf);
+    uint32_t roc = srtp_compute_roc (s, seq), ssrc;
+    memcpy (&ssrc, buf + 8, 4);
+
+    /* Updates ROC and sequence (it's safe now) */
+    if (srtp_update_seq (s, seq, roc))
+        return EACCES;
 
     /* Encrypt/Decrypt */
     if (s->flags & SRTP_UNENCRYPTED)
@@ -520,6 +622,81 @@ static int srtp_crypt (srtp_session_t *s, uint8_t *buf, size_t len)
 }
 
 
+/**
+ * AES-GCM for RTP: the RTP header is authenticated, the payload is
+ * authenticated and encrypted (RFC 7714 §8).
+ */
+static int
+srtp_aead (srtp_session_t *s, uint8_t *buf, size_t offset, size_t len,
+           uint32_t roc, bool decrypt)
+{
+    uint16_t seq = rtp_seq (buf);
+    uint32_t ssrc;
+    memcpy (&ssrc, buf + 8, 4);
+
+    if (do_aead_setiv (s->rtp.cipher, s->rtp.salt, ssrc,
+                       ((uint64_t)roc << 16) | seq)
+     || gcry_cipher_authenticate (s->rtp.cipher, buf, offset))
+        return EINVAL;
+
+    return do_aead_crypt (s->rtp.cipher, buf + offset, len - offset,
+                          buf + len, s->tag_len, decrypt);
+}
+
+
+/** SRTP sending with AES-GCM, see srtp_send() */
+static int
+srtp_aead_send (srtp_session_t *s, uint8_t *buf, size_t *lenp, size_t bufsize)
+{
+    size_t len = *lenp;
+
+    *lenp = len + s->tag_len;
+    if (bufsize < *lenp)
+        return ENOSPC;
+
+    size_t offset = rtp_header_len (buf, len);
+    if (offset == 0)
+        return EINVAL;
+
+    uint16_t seq = rtp_seq (buf);
+    uint32_t roc = srtp_compute_roc (s, seq);
+    if (srtp_update_seq (s, seq, roc))
+        return EACCES;
+
+    return srtp_aead (s, buf, offset, len, roc, false);
+}
+
+
+/** SRTP receiving with AES-GCM, see srtp_recv() */
+static int
+srtp_aead_recv (srtp_session_t *s, uint8_t *buf, size_t *lenp)
+{
+    size_t len = *lenp;
+
+    if (len < (12u + s->tag_len))
+        return EINVAL;
+    len -= s->tag_len;
+
+    size_t offset = rtp_header_len (buf, len);
+    if (offset == 0)
+        return EINVAL;
+
+    /* The replay window is only updated once the packet is authenticated */
+    uint16_t seq = rtp_seq (buf);
+    if (srtp_replayed (s, seq))
+        return EACCES;
+
+    uint32_t roc = srtp_compute_roc (s, seq);
+    int val = srtp_aead (s, buf, offset, len, roc, true);
+    if (val)
+        return val;
+
+    srtp_update_seq (s, seq, roc);
+    *lenp = len;
+    return 0;
+}
+
+
 /**
  * Turns a RTP packet into a SRTP packet: encrypt it, then computes
  * the authentication tag and appends it.
@@ -547,6 +724,9 @@ srtp_send (srtp_session_t *s, uint8_t *buf, size_t *lenp, size_t bufsize)
     if (len < 12u)
         return EINVAL;
 
+    if (s->aead)
+        return srtp_aead_send (s, buf, lenp, bufsize);
+
     if (!(s->flags & SRTP_UNAUTHENTICATED))
     {
         tag_len = s->tag_len;
@@ -626,6 +806,9 @@ srtp_recv (srtp_session_t *s, uint8_t *buf, size_t *lenp)
     if (len < 12u)
         return EINVAL;
 
+    if (s->aead)
+        return srtp_aead_recv (s, buf, lenp);
+
     if (!(s->flags & SRTP_UNAUTHENTICATED))
     {
         size_t tag_len = s->tag_len, roc_len = 0;
@@ -764,6 +947,94 @@ static int srtcp_crypt (srtp_session_t *s, uint8_t *buf, size_t len)
 }
 
 
+/**
+ * AES-GCM for RTCP: the RTCP header and the SRTCP index are authenticated,
+ * the rest of the packet is authenticated and encrypted (RFC 7714 §9).
+ * The tag follows the encrypted data, and precedes the SRTCP index.
+ */
+static int
+srtcp_aead (srtp_session_t *s, uint8_t *buf, size_t len, uint32_t index,
+            bool decrypt)
+{
+    uint32_t ssrc, eindex = htonl (index | 0x80000000);
+    memcpy (&ssrc, buf + 4, 4);
+
+    if (do_aead_setiv (s->rtcp.cipher, s->rtcp.salt, ssrc, index)
+     || gcry_cipher_authenticate (s->rtcp.cipher, buf, 8)
+     || gcry_cipher_authenticate (s->rtcp.cipher, &eindex, 4))
+        return EINVAL;
+
+    return do_aead_crypt (s->rtcp.cipher, buf + 8, len - 8, buf + len,
+                          s->tag_len, decrypt);
+}
+
+
+/** SRTCP sending with AES-GCM, see srtcp_send() */
+static int
+srtcp_aead_send (srtp_session_t *s, uint8_t *buf, size_t *lenp,
+                 size_t bufsize)
+{
+    size_t len = *lenp;
+    if (bufsize < (len + s->tag_len + 4))
+        return ENOSPC;
+    if ((len < 8) || ((buf[0] >> 6) != 2))
+        return EINVAL;
+
+    uint32_t index = ++s->rtcp_index;
+    if (index >> 31)
+        s->rtcp_index = index = 0; /* 31-bit wrap */
+
+    int val = srtcp_aead (s, buf, len, index, false);
+    if (val)
+        return val;
+
+    len += s->tag_len;
+    memcpy (buf + len, &(uint32_t){ htonl (index | 0x80000000) }, 4);
+    *lenp = len + 4;
+    return 0;
+}
+
+
+/** SRTCP receiving with AES-GCM, see srtcp_recv() */
+static int
+srtcp_aead_recv (srtp_session_t *s, uint8_t *buf, size_t *lenp)
+{
+    size_t len = *lenp;
+    if ((len < (8u + s->tag_len + 4)) || ((buf[0] >> 6) != 2))
+        return EINVAL;
+    len -= 4;
+
+    uint32_t index;
+    memcpy (&index, buf + len, 4);
+    index = ntohl (index);
+    if ((index >> 31) == 0)
+        return EINVAL; // E-bit mismatch
+    index &= ~(1 << 31);
+    len -= s->tag_len;
+
+    /* Checks the replay window before, updates it after authentication */
+    int32_t diff = index - s->rtcp_index;
+    if ((diff <= 0)
+     && ((-diff >= 64) || ((s->rtcp.window >> -diff) & 1)))
+        return EACCES; // replay attack!
+
+    int val = srtcp_aead (s, buf, len, index, true);
+    if (val)
+        return val;
+
+    if (diff > 0)
+    {
+        s->rtcp.window = (diff < 64) ? (s->rtcp.window << diff) : 0;
+        s->rtcp.window |= UINT64_C(1);
+        s->rtcp_index = index;
+    }
+    else
+        s->rtcp.window |= UINT64_C(1) << -diff;
+    *lenp = len;
+    return 0;
+}
+
+
 /**
  * Turns a RTCP packet into a SRTCP packet: encrypt it, then computes
  * the authentication tag and appends it.
@@ -781,6 +1052,10 @@ int
 srtcp_send (srtp_session_t *s, uint8_t *buf, size_t *lenp, size_t bufsize)
 {
     size_t len = *lenp;
+
+    if (s->aead)
+        return srtcp_aead_send (s, buf, lenp, bufsize);
+
     if (bufsize < (len + 4 + s->tag_len))
         return ENOSPC;
 
@@ -822,6 +1097,9 @@ srtcp_recv (srtp_session_t *s, uint8_t *buf, size_t *lenp)
 {
     size_t len = *lenp;
 
+    if (s->aead)
+        return srtcp_aead_recv (s, buf, lenp);
+
     if (len < (4u + s->tag_len))
         return EINVAL;
     len -= s->tag_len;
@@ -41,6 +41,7 @@ enum
     SRTP_ENCR_NULL=0,   //< no encryption
     SRTP_ENCR_AES_CM=1, //< AES counter mode
     SRTP_ENCR_AES_F8=2, //< AES F8 mode (not implemented)
+    SRTP_ENCR_AES_GCM=7, //< AES Galois/Counter mode (RFC 7714)
 };
 
 /** SRTP authenticaton algorithms; same values as MIKEY */
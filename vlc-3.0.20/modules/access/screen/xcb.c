@@ -28,6 +28,9 @@
 #include <errno.h>
 #include <xcb/xcb.h>
 #include <xcb/composite.h>
+#ifdef HAVE_XCB_DAMAGE
+# include <xcb/damage.h>
+#endif
 #ifdef HAVE_SYS_SHM_H
 # include <sys/shm.h>
 # include <xcb/shm.h>
@@ -116,6 +119,11 @@ struct demux_sys_t
     bool              shm; /**< Whether to use MIT-SHM */
     bool              follow_mouse;
     uint16_t          cur_w, cur_h; /**< Actual capture pixel dimensions */
+    uint32_t          damage; /**< Damage object XID, or 0 if none */
+    uint8_t           damage_event; /**< XDamage notify event code */
+    xcb_rectangle_t   dirty; /**< Damaged area since the last frame */
+    int               frame_x, frame_y; /**< Last frame capture coordinates */
+    uint8_t          *frame; /**< Last frame pixels (if tracking damage) */
     /* Timer does not use this, only input thread: */
     vlc_timer_t       timer;
 };
@@ -136,6 +144,28 @@ static bool CheckSHM (xcb_connection_t *conn)
 #endif
 }
 
+/** Checks XDamage support and returns the notify event code, or 0 */
+static uint8_t CheckDamage (xcb_connection_t *conn)
+{
+#ifdef HAVE_XCB_DAMAGE
+    const xcb_query_extension_reply_t *ext =
+        xcb_get_extension_data (conn, &xcb_damage_id);
+    if (ext == NULL || !ext->present)
+        return 0;
+
+    xcb_damage_query_version_reply_t *r =
+        xcb_damage_query_version_reply (conn,
+            xcb_damage_query_version (conn, 1, 1), NULL);
+    if (r == NULL)
+        return 0;
+    free (r);
+    return ext->first_event + XCB_DAMAGE_NOTIFY;
+#else
+    (void) conn;
+    return 0;
+#endif
+}
+
 /**
  * Probes and initializes.
  */
@@ -218,6 +248,19 @@ static int Open (vlc_object_t *obj)
     p_sys->pixmap = xcb_generate_id (conn);
     p_sys->segment = xcb_generate_id (conn);
     p_sys->shm = CheckSHM (conn);
+    p_sys->damage_event = CheckDamage (conn);
+    p_sys->damage = 0;
+#ifdef HAVE_XCB_DAMAGE
+    if (p_sys->damage_event != 0)
+    {   /* Only the changed parts of the window will be captured */
+        p_sys->damage = xcb_generate_id (conn);
+        xcb_damage_create (conn, p_sys->damage, p_sys->window,
+                           XCB_DAMAGE_REPORT_LEVEL_BOUNDING_BOX);
+        msg_Dbg (obj, "using Damage extension");
+    }
+#endif
+    p_sys->dirty.width = p_sys->dirty.height = 0;
+    p_sys->frame = NULL;
     p_sys->w = var_InheritInteger (obj, "screen-width");
     p_sys->h = var_InheritInteger (obj, "screen-height");
     if (p_sys->w != 0 || p_sys->h != 0)
@@ -269,6 +312,7 @@ static void Close (vlc_object_t *obj)
 
     vlc_timer_destroy (p_sys->timer);
     xcb_disconnect (p_sys->conn);
+    free (p_sys->frame);
     free (p_sys);
 }
 
@@ -322,6 +366,127 @@ static int Control (demux_t *demux, int query, va_list args)
 }
 
 
+/**
+ * Captures a rectangle of a drawable
+ */
+static block_t *Capture (demux_t *demux, xcb_drawable_t drawable,
+                         int x, int y, unsigned w, unsigned h)
+{
+    demux_sys_t *sys = demux->p_sys;
+    xcb_connection_t *conn = sys->conn;
+
+    block_t *block = NULL;
+#if HAVE_SYS_SHM_H
+    if (sys->shm)
+    {   /* Capture screen through shared memory */
+        size_t size = w * h * sys->bpp;
+        int id = shmget (IPC_PRIVATE, size, IPC_CREAT | 0777);
+        if (id == -1) /* XXX: fallback */
+        {
+            msg_Err (demux, "shared memory allocation error: %s",
+                     vlc_strerror_c(errno));
+            goto noshm;
+        }
+
+        /* Attach the segment to X and capture */
+        xcb_shm_get_image_reply_t *img;
+        xcb_shm_get_image_cookie_t ck;
+
+        xcb_shm_attach (conn, sys->segment, id, 0 /* read/write */);
+        ck = xcb_shm_get_image (conn, drawable, x, y, w, h, ~0,
+                                XCB_IMAGE_FORMAT_Z_PIXMAP, sys->segment, 0);
+        xcb_shm_detach (conn, sys->segment);
+        img = xcb_shm_get_image_reply (conn, ck, NULL);
+        xcb_flush (conn); /* ensure eventual detach */
+
+        if (img == NULL)
+        {
+            shmctl (id, IPC_RMID, 0);
+            goto noshm;
+        }
+        free (img);
+
+        /* Attach the segment to VLC */
+        void *shm = shmat (id, NULL, 0 /* read/write */);
+        shmctl (id, IPC_RMID, 0);
+        if (-1 == (intptr_t)shm)
+        {
+            msg_Err (demux, "shared memory attachment error: %s",
+                     vlc_strerror_c(errno));
+            return NULL;
+        }
+
+        block = block_shm_Alloc (shm, size);
+        if (unlikely(block == NULL))
+            shmdt (shm);
+    }
+noshm:
+#endif
+    if (block == NULL)
+    {   /* Capture screen through socket (fallback) */
+        xcb_get_image_reply_t *img;
+
+        img = xcb_get_image_reply (conn,
+            xcb_get_image (conn, XCB_IMAGE_FORMAT_Z_PIXMAP, drawable,
+                           x, y, w, h, ~0), NULL);
+        if (img == NULL)
+            return NULL;
+
+        uint8_t *data = xcb_get_image_data (img);
+        size_t datalen = xcb_get_image_data_length (img);
+        block = block_heap_Alloc (img, data + datalen - (uint8_t *)img);
+        if (block == NULL)
+            return NULL;
+        block->p_buffer = data;
+        block->i_buffer = datalen;
+    }
+
+    return block;
+}
+
+/**
+ * Accumulates the area damaged since the previous frame
+ */
+static void CollectDamage (demux_sys_t *sys)
+{
+#ifdef HAVE_XCB_DAMAGE
+    xcb_connection_t *conn = sys->conn;
+    xcb_generic_event_t *ev;
+
+    while ((ev = xcb_poll_for_event (conn)) != NULL)
+    {
+        if ((ev->response_type & 0x7f) == sys->damage_event)
+        {
+            const xcb_rectangle_t *area =
+                &((xcb_damage_notify_event_t *)ev)->area;
+            xcb_rectangle_t *dirty = &sys->dirty;
+
+            if (dirty->width == 0 || dirty->height == 0)
+                *dirty = *area;
+            else
+            {
+                int x1 = __MIN(dirty->x, area->x);
+                int y1 = __MIN(dirty->y, area->y);
+                int x2 = __MAX(dirty->x + dirty->width, area->x + area->width);
+                int y2 = __MAX(dirty->y + dirty->height,
+                               area->y + area->height);
+
+                dirty->x = x1;
+                dirty->y = y1;
+                dirty->width = x2 - x1;
+                dirty->height = y2 - y1;
+            }
+        }
+        free (ev);
+    }
+
+    /* Reset the damage region, so that further changes are notified */
+    xcb_damage_subtract (conn, sys->damage, XCB_NONE, XCB_NONE);
+#else
+    (void) sys; /* never created */
+#endif
+}
+
 /**
  * Processing callback
  */
@@ -417,6 +582,7 @@ discard:
                                geo->root, geo->width, geo->height);
         }
 
+        FREENULL (sys->frame);
         sys->es = InitES (demux, w, h, geo->depth, &sys->bpp);
         if (sys->es != NULL)
         {
@@ -431,70 +597,79 @@ discard:
         (sys->window != geo->root) ? sys->pixmap : sys->window;
     free (geo);
 
-    block_t *block = NULL;
-#if HAVE_SYS_SHM_H
-    if (sys->shm)
-    {   /* Capture screen through shared memory */
-        size_t size = w * h * sys->bpp;
-        int id = shmget (IPC_PRIVATE, size, IPC_CREAT | 0777);
-        if (id == -1) /* XXX: fallback */
-        {
-            msg_Err (demux, "shared memory allocation error: %s",
-                     vlc_strerror_c(errno));
-            goto noshm;
-        }
-
-        /* Attach the segment to X and capture */
-        xcb_shm_get_image_reply_t *img;
-        xcb_shm_get_image_cookie_t ck;
+    block_t *block;
 
-        xcb_shm_attach (conn, sys->segment, id, 0 /* read/write */);
-        ck = xcb_shm_get_image (conn, drawable, x, y, w, h, ~0,
-                                XCB_IMAGE_FORMAT_Z_PIXMAP, sys->segment, 0);
-        xcb_shm_detach (conn, sys->segment);
-        img = xcb_shm_get_image_reply (conn, ck, NULL);
-        xcb_flush (conn); /* ensure eventual detach */
+    if (sys->damage != 0)
+        CollectDamage (sys);
 
-        if (img == NULL)
-        {
-            shmctl (id, IPC_RMID, 0);
-            goto noshm;
-        }
-        free (img);
+    if (sys->damage != 0 && sys->es != NULL)
+    {
+        size_t pitch = w * sys->bpp;
+        size_t size = pitch * h;
+
+        if (sys->frame != NULL && x == sys->frame_x && y == sys->frame_y)
+        {   /* Capture only the damaged part of the previous frame */
+            const xcb_rectangle_t *dirty = &sys->dirty;
+            int x1 = __MAX(x, dirty->x);
+            int y1 = __MAX(y, dirty->y);
+            int x2 = __MIN(x + (int)w, dirty->x + dirty->width);
+            int y2 = __MIN(y + (int)h, dirty->y + dirty->height);
+
+            sys->dirty.width = sys->dirty.height = 0;
+            if (x1 >= x2 || y1 >= y2)
+            {   /* Nothing changed: no frame, only advance the clock */
+                es_out_SetPCR (demux->out, mdate ());
+                return;
+            }
 
-        /* Attach the segment to VLC */
-        void *shm = shmat (id, NULL, 0 /* read/write */);
-        shmctl (id, IPC_RMID, 0);
-        if (-1 == (intptr_t)shm)
-        {
-            msg_Err (demux, "shared memory attachment error: %s",
-                     vlc_strerror_c(errno));
-            return;
-        }
+            block_t *rect = Capture (demux, drawable, x1, y1,
+                                     x2 - x1, y2 - y1);
+            if (rect == NULL)
+                return;
 
-        block = block_shm_Alloc (shm, size);
-        if (unlikely(block == NULL))
-            shmdt (shm);
-    }
-noshm:
-#endif
-    if (block == NULL)
-    {   /* Capture screen through socket (fallback) */
-        xcb_get_image_reply_t *img;
+            size_t rpitch = rect->i_buffer / (y2 - y1);
+            size_t rlen = __MIN(rpitch, (size_t)(x2 - x1) * sys->bpp);
+            uint8_t *dst = sys->frame + (y1 - y) * pitch + (x1 - x) * sys->bpp;
 
-        img = xcb_get_image_reply (conn,
-            xcb_get_image (conn, XCB_IMAGE_FORMAT_Z_PIXMAP, drawable,
-                           x, y, w, h, ~0), NULL);
-        if (img == NULL)
-            return;
+            for (int i = y1; i < y2; i++)
+            {
+                memcpy (dst, rect->p_buffer + (i - y1) * rpitch, rlen);
+                dst += pitch;
+            }
+            block_Release (rect);
 
-        uint8_t *data = xcb_get_image_data (img);
-        size_t datalen = xcb_get_image_data_length (img);
-        block = block_heap_Alloc (img, data + datalen - (uint8_t *)img);
+            block = block_Alloc (size);
+            if (unlikely(block == NULL))
+                return;
+            memcpy (block->p_buffer, sys->frame, size);
+        }
+        else
+        {   /* Full capture, kept as reference for damaged captures */
+            sys->dirty.width = sys->dirty.height = 0;
+            block = Capture (demux, drawable, x, y, w, h);
+            if (block == NULL)
+                return;
+
+            uint8_t *frame = realloc (sys->frame, size);
+            if (block->i_buffer == size && likely(frame != NULL))
+            {
+                memcpy (frame, block->p_buffer, size);
+                sys->frame = frame;
+                sys->frame_x = x;
+                sys->frame_y = y;
+            }
+            else
+            {   /* Padded scan lines: damage cannot be patched in place */
+                free (frame != NULL ? frame : sys->frame);
+                sys->frame = NULL;
+            }
+        }
+    }
+    else
+    {
+        block = Capture (demux, drawable, x, y, w, h);
         if (block == NULL)
             return;
-        block->p_buffer = data;
-        block->i_buffer = datalen;
     }
 
     /* Send block - zero copy */
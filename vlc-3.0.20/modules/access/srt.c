@@ -41,6 +41,7 @@ typedef struct stream_sys_t
     bool        b_interrupted;
     char       *psz_host;
     int         i_port;
+    int         i_poll_timeout;
     int         i_chunks; /* Number of chunks to allocate in the next read */
 } stream_sys_t;
 
@@ -126,7 +127,7 @@ static bool srt_schedule_reconnect(stream_t *p_stream)
         srt_close( p_sys->sock );
     }
 
-    p_sys->sock = srt_socket( res->ai_family, SOCK_DGRAM, 0 );
+    p_sys->sock = srt_open_socket( strm_obj, res->ai_family );
     if ( p_sys->sock == SRT_INVALID_SOCK )
     {
         msg_Err( p_stream, "Failed to open socket." );
@@ -194,7 +195,8 @@ static bool srt_schedule_reconnect(stream_t *p_stream)
     msg_Dbg( p_stream, "Schedule SRT connect (dest address: %s, port: %d).",
         p_sys->psz_host, p_sys->i_port);
 
-    stat = srt_connect( p_sys->sock, res->ai_addr, res->ai_addrlen );
+    stat = srt_connect_links( strm_obj, p_sys->sock,
+                              res->ai_addr, res->ai_addrlen );
     if (stat == SRT_ERROR) {
         msg_Err( p_stream, "Failed to connect to server (reason: %s)",
                 srt_getlasterror_str() );
@@ -227,7 +229,6 @@ out:
 static block_t *BlockSRT(stream_t *p_stream, bool *restrict eof)
 {
     stream_sys_t *p_sys = p_stream->p_sys;
-    int i_poll_timeout = var_InheritInteger( p_stream, SRT_PARAM_POLL_TIMEOUT );
     /* SRT doesn't have a concept of EOF for live streams. */
     VLC_UNUSED(eof);
 
@@ -254,7 +255,7 @@ static block_t *BlockSRT(stream_t *p_stream, bool *restrict eof)
     int readycnt = 1;
     while ( srt_epoll_wait( p_sys->i_poll_id,
         ready, &readycnt, 0, 0,
-        i_poll_timeout, NULL, 0, NULL, 0 ) >= 0)
+        p_sys->i_poll_timeout, NULL, 0, NULL, 0 ) >= 0)
     {
         if ( readycnt < 0  || ready[0] != p_sys->sock )
         {
@@ -373,6 +374,8 @@ static int Open(vlc_object_t *p_this)
 
     p_sys->psz_host = strdup( parsed_url.psz_host );
     p_sys->i_port = parsed_url.i_port;
+    p_sys->i_poll_timeout = var_InheritInteger( p_stream,
+                                                SRT_PARAM_POLL_TIMEOUT );
 
     vlc_UrlClean( &parsed_url );
 
@@ -445,6 +448,13 @@ vlc_module_begin ()
     add_string(SRT_PARAM_STREAMID, "",
             N_(" SRT Stream ID"), NULL, false)
     change_safe()
+#ifdef SRT_HAS_GROUPS
+    add_string( SRT_PARAM_GROUP_TYPE, "", SRT_GROUP_TYPE_TEXT,
+            SRT_GROUP_TYPE_LONGTEXT, true )
+    change_string_list( srt_group_types, srt_group_type_names )
+    add_string( SRT_PARAM_GROUP_LINKS, "", SRT_GROUP_LINKS_TEXT,
+            SRT_GROUP_LINKS_LONGTEXT, true )
+#endif
 
     set_capability("access", 0)
     add_shortcut("srt")
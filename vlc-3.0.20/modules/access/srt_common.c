@@ -23,9 +23,14 @@
 
 #include "srt_common.h"
 
+#include <vlc_network.h>
+
 const char * const srt_key_length_names[] = { N_( "16 bytes" ), N_(
         "24 bytes" ), N_( "32 bytes" ), };
 
+const char * const srt_group_type_names[] = { N_( "None" ),
+        N_( "Broadcast" ), N_( "Backup" ), };
+
 typedef struct parsed_param {
     char *key;
     char *val;
@@ -170,3 +175,112 @@ int srt_set_socket_option(vlc_object_t *this, const char *srt_param,
     return stat;
 }
 
+
+/**
+ * Creates the socket to connect with: a socket group if one was requested
+ * with the group-type parameter, a plain SRT socket otherwise.
+ */
+SRTSOCKET srt_open_socket(vlc_object_t *this, int family)
+{
+#ifdef SRT_HAS_GROUPS
+    char *type = var_InheritString( this, SRT_PARAM_GROUP_TYPE );
+    SRT_GROUP_TYPE gtype = SRT_GTYPE_UNDEFINED;
+
+    if (type != NULL) {
+        if (strcmp( type, "broadcast" ) == 0)
+            gtype = SRT_GTYPE_BROADCAST;
+        else if (strcmp( type, "backup" ) == 0)
+            gtype = SRT_GTYPE_BACKUP;
+        free( type );
+    }
+
+    if (gtype != SRT_GTYPE_UNDEFINED) {
+        SRTSOCKET group = srt_create_group( gtype );
+        if (group == SRT_INVALID_SOCK)
+            msg_Err( this, "Failed to create socket group (reason: %s)",
+                    srt_getlasterror_str() );
+        return group;
+    }
+#endif
+    return srt_socket( family, SOCK_DGRAM, 0 );
+}
+
+#ifdef SRT_HAS_GROUPS
+/**
+ * Connects a socket group to the primary address and to each of the
+ * group-links addresses.
+ */
+static int srt_connect_group_links(vlc_object_t *this, SRTSOCKET group,
+        const struct sockaddr *addr, int addrlen)
+{
+    char *links = var_InheritString( this, SRT_PARAM_GROUP_LINKS );
+    SRT_SOCKGROUPCONFIG *targets = malloc( sizeof (*targets) );
+    int count = 0, stat = SRT_ERROR;
+
+    if (unlikely(targets == NULL))
+        goto out;
+    targets[count++] = srt_prepare_endpoint( NULL, addr, addrlen );
+
+    char *saveptr;
+    for (char *link = (links != NULL) ? strtok_r( links, ",", &saveptr ) : NULL;
+         link != NULL; link = strtok_r( NULL, ",", &saveptr )) {
+        struct addrinfo hints = {
+            .ai_socktype = SOCK_DGRAM,
+        }, *res;
+        char *host = link, *port;
+        int i_port = SRT_DEFAULT_PORT;
+
+        while (*host == ' ')
+            host++;
+        if (*host == '[') {
+            port = strchr( ++host, ']' );
+            if (port != NULL)
+                *port++ = '\0';
+        } else
+            port = host;
+        port = (port != NULL) ? strchr( port, ':' ) : NULL;
+        if (port != NULL) {
+            *port++ = '\0';
+            i_port = atoi( port );
+        }
+
+        int val = vlc_getaddrinfo( host, i_port, &hints, &res );
+        if (val) {
+            msg_Err( this, "Cannot resolve group link [%s]:%d (reason: %s)",
+                    host, i_port, gai_strerror( val ) );
+            continue;
+        }
+
+        SRT_SOCKGROUPCONFIG *tab = realloc( targets,
+                (count + 1) * sizeof (*targets) );
+        if (likely(tab != NULL)) {
+            targets = tab;
+            targets[count++] = srt_prepare_endpoint( NULL, res->ai_addr,
+                    res->ai_addrlen );
+        }
+        freeaddrinfo( res );
+    }
+
+    msg_Dbg( this, "Connecting socket group with %d link(s)", count );
+    stat = srt_connect_group( group, targets, count );
+out:
+    free( targets );
+    free( links );
+    return stat;
+}
+#endif
+
+/**
+ * Connects a socket returned by srt_open_socket().
+ */
+int srt_connect_links(vlc_object_t *this, SRTSOCKET u,
+        const struct sockaddr *addr, int addrlen)
+{
+#ifdef SRT_HAS_GROUPS
+    if (u & SRTGROUP_MASK)
+        return srt_connect_group_links( this, u, addr, addrlen );
+#else
+    VLC_UNUSED(this);
+#endif
+    return srt_connect( u, addr, addrlen );
+}
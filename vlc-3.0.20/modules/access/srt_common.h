@@ -40,6 +40,14 @@
 #define SRT_PARAM_POLL_TIMEOUT                "poll-timeout"
 #define SRT_PARAM_KEY_LENGTH                  "key-length"
 #define SRT_PARAM_STREAMID                    "streamid"
+#define SRT_PARAM_GROUP_TYPE                  "group-type"
+#define SRT_PARAM_GROUP_LINKS                 "group-links"
+
+/* Socket groups (connection bonding) appeared in libsrt 1.5.0 */
+#if defined(SRT_VERSION_VALUE) \
+ && SRT_VERSION_VALUE >= SRT_MAKE_VERSION_VALUE(1, 5, 0)
+# define SRT_HAS_GROUPS 1
+#endif
 
 
 #define SRT_DEFAULT_BANDWIDTH_OVERHEAD_LIMIT 25
@@ -63,6 +71,18 @@ static const int srt_key_lengths[] = { 16, 24, 32, };
 
 extern const char * const srt_key_length_names[];
 
+#define SRT_GROUP_TYPE_TEXT N_("Socket group type")
+#define SRT_GROUP_TYPE_LONGTEXT N_( \
+    "Bond the connection to the URL address with the group links. " \
+    "Broadcast sends every packet over all links, backup only uses " \
+    "another link when the active one fails.")
+#define SRT_GROUP_LINKS_TEXT N_("Socket group links")
+#define SRT_GROUP_LINKS_LONGTEXT N_( \
+    "Comma-separated list of additional host:port addresses of the " \
+    "socket group.")
+static const char * const srt_group_types[] = { "", "broadcast", "backup", };
+extern const char * const srt_group_type_names[];
+
 typedef struct srt_params {
     int latency;
     const char* passphrase;
@@ -77,4 +97,8 @@ bool srt_parse_url(char* url, srt_params_t* params);
 int srt_set_socket_option(vlc_object_t *this, const char *srt_param,
         SRTSOCKET u, SRT_SOCKOPT opt, const void *optval, int optlen);
 
+SRTSOCKET srt_open_socket(vlc_object_t *this, int family);
+int srt_connect_links(vlc_object_t *this, SRTSOCKET u,
+        const struct sockaddr *addr, int addrlen);
+
 #endif
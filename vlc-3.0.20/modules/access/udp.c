@@ -59,6 +59,14 @@ static void Close( vlc_object_t * );
 #define BUFFER_TEXT N_("Receive buffer")
 #define BUFFER_LONGTEXT N_("UDP receive buffer size (bytes)" )
 #define TIMEOUT_TEXT N_("UDP Source timeout (sec)")
+#define BATCH_TEXT N_("Datagrams per receive batch")
+#define BATCH_LONGTEXT N_( \
+    "Maximum number of datagrams received with a single system call. " \
+    "Values above 1 return received datagrams as block chains.")
+#define BATCH_TIMEOUT_TEXT N_("Receive batch timeout (ms)")
+#define BATCH_TIMEOUT_LONGTEXT N_( \
+    "How long to wait for more datagrams to fill a receive batch once the " \
+    "first one arrived. With 0, only already queued datagrams are batched.")
 
 vlc_module_begin ()
     set_shortname( N_("UDP" ) )
@@ -69,6 +77,12 @@ vlc_module_begin ()
     add_obsolete_integer( "server-port" ) /* since 2.0.0 */
     add_obsolete_integer( "udp-buffer" ) /* since 3.0.0 */
     add_integer( "udp-timeout", -1, TIMEOUT_TEXT, NULL, true )
+#ifdef HAVE_RECVMMSG
+    add_integer_with_range( "udp-batch", 1, 1, 1024,
+                            BATCH_TEXT, BATCH_LONGTEXT, true )
+    add_integer( "udp-batch-timeout", 0, BATCH_TIMEOUT_TEXT,
+                 BATCH_TIMEOUT_LONGTEXT, true )
+#endif
 
     set_capability( "access", 0 )
     add_shortcut( "udp", "udpstream", "udp4", "udp6" )
@@ -81,12 +95,23 @@ struct access_sys_t
     int fd;
     int timeout;
     size_t mtu;
+#ifdef HAVE_RECVMMSG
+    unsigned batch;
+    int batch_timeout;
+    block_t **pkts;
+    struct mmsghdr *msgs;
+    struct iovec *iovecs;
+#endif
 };
 
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
 static block_t *BlockUDP( stream_t *, bool * );
+#ifdef HAVE_RECVMMSG
+static block_t *BlockUDPBatch( stream_t *, bool * );
+static void ReleaseBatch( access_sys_t * );
+#endif
 static int Control( stream_t *, int, va_list );
 
 /*****************************************************************************
@@ -174,6 +199,35 @@ static int Open( vlc_object_t *p_this )
     if( sys->timeout > 0)
         sys->timeout *= 1000;
 
+#ifdef HAVE_RECVMMSG
+    sys->batch = var_InheritInteger( p_access, "udp-batch" );
+    sys->batch_timeout = var_InheritInteger( p_access, "udp-batch-timeout" );
+    sys->pkts = NULL;
+    if( sys->batch > 1 )
+    {
+        sys->pkts = vlc_obj_calloc( p_this, sys->batch, sizeof (*sys->pkts) );
+        sys->msgs = vlc_obj_calloc( p_this, sys->batch, sizeof (*sys->msgs) );
+        sys->iovecs = vlc_obj_calloc( p_this, sys->batch,
+                                      sizeof (*sys->iovecs) );
+        if( unlikely(sys->pkts == NULL || sys->msgs == NULL
+                  || sys->iovecs == NULL) )
+        {
+            net_Close( sys->fd );
+            return VLC_ENOMEM;
+        }
+
+        for( unsigned i = 0; i < sys->batch; i++ )
+        {
+            sys->msgs[i].msg_hdr.msg_iov = &sys->iovecs[i];
+            sys->msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        msg_Dbg( p_access, "receiving up to %u datagrams per batch",
+                 sys->batch );
+        p_access->pf_block = BlockUDPBatch;
+    }
+#endif
+
     return VLC_SUCCESS;
 }
 
@@ -185,6 +239,10 @@ static void Close( vlc_object_t *p_this )
     stream_t     *p_access = (stream_t*)p_this;
     access_sys_t *sys = p_access->p_sys;
 
+#ifdef HAVE_RECVMMSG
+    if( sys->pkts != NULL )
+        ReleaseBatch( sys );
+#endif
     net_Close( sys->fd );
 }
 
@@ -285,3 +343,121 @@ skip:
 
     return pkt;
 }
+
+#ifdef HAVE_RECVMMSG
+/*****************************************************************************
+ * BlockUDPBatch: receives several datagrams per system call
+ *****************************************************************************/
+static void ReleaseBatch(access_sys_t *sys)
+{
+    for (unsigned i = 0; i < sys->batch; i++)
+        if (sys->pkts[i] != NULL)
+        {
+            block_Release(sys->pkts[i]);
+            sys->pkts[i] = NULL;
+        }
+}
+
+static block_t *BlockUDPBatch(stream_t *access, bool *restrict eof)
+{
+    access_sys_t *sys = access->p_sys;
+    unsigned count;
+
+    /* Refill the batch with receive buffers */
+    for (count = 0; count < sys->batch; count++)
+    {
+        if (sys->pkts[count] == NULL)
+        {
+            sys->pkts[count] = block_Alloc(sys->mtu);
+            if (unlikely(sys->pkts[count] == NULL))
+                break;
+        }
+
+        sys->iovecs[count].iov_base = sys->pkts[count]->p_buffer;
+        sys->iovecs[count].iov_len = sys->mtu;
+        sys->msgs[count].msg_hdr.msg_flags = 0;
+    }
+
+    if (unlikely(count == 0))
+    {   /* OOM - dequeue and discard one packet */
+        char dummy;
+        recv(sys->fd, &dummy, 1, 0);
+        return NULL;
+    }
+
+    struct pollfd ufd[1];
+
+    ufd[0].fd = sys->fd;
+    ufd[0].events = POLLIN;
+
+    switch (vlc_poll_i11e(ufd, 1, sys->timeout))
+    {
+        case 0:
+            msg_Err(access, "receive time-out");
+            *eof = true;
+            /* fall through */
+        case -1:
+            return NULL;
+    }
+
+    const vlc_tick_t deadline = mdate() + sys->batch_timeout * INT64_C(1000);
+    unsigned received = 0;
+
+    for (;;)
+    {
+        int val = recvmmsg(sys->fd, sys->msgs + received, count - received,
+                           MSG_DONTWAIT | MSG_TRUNC, NULL);
+        if (val > 0)
+            received += val;
+        else if (val == 0 || (errno != EAGAIN && errno != EINTR))
+            break;
+
+        if (received >= count || sys->batch_timeout <= 0)
+            break;
+
+        vlc_tick_t delay = deadline - mdate();
+        if (delay <= 0)
+            break;
+        /* Wait for more datagrams to fill the batch */
+        if (vlc_poll_i11e(ufd, 1, (delay + 999) / 1000) <= 0)
+            break;
+    }
+
+    block_t *chain = NULL, **pp = &chain;
+    size_t mtu = sys->mtu;
+
+    for (unsigned i = 0; i < received; i++)
+    {
+        block_t *pkt = sys->pkts[i];
+        size_t len = sys->msgs[i].msg_len;
+
+        sys->pkts[i] = NULL;
+
+        if (sys->msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+        {
+            msg_Err(access, "%zu bytes packet truncated (MTU was %zu)",
+                    len, mtu);
+            pkt->i_flags |= BLOCK_FLAG_CORRUPTED;
+            if (len > sys->mtu)
+                sys->mtu = len;
+        }
+        else
+            pkt->i_buffer = len;
+
+        *pp = pkt;
+        pp = &pkt->p_next;
+    }
+
+    /* Keep spare buffers at the front for the next batch */
+    for (unsigned i = received, j = 0; i < count; i++, j++)
+    {
+        sys->pkts[j] = sys->pkts[i];
+        sys->pkts[i] = NULL;
+    }
+
+    if (sys->mtu != mtu) /* Spare buffers are too small now */
+        ReleaseBatch(sys);
+
+    return chain;
+}
+#endif
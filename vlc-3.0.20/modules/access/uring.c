@@ -0,0 +1,479 @@
+/*****************************************************************************
+ * uring.c: io_uring read-ahead for the file input
+ *****************************************************************************
+ * Copyright (C) 2023 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include "fs.h"
+
+#ifdef HAVE_LINUX_IO_URING_H
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+
+#include <vlc_access.h>
+#include <vlc_atomic.h>
+#include <vlc_block.h>
+
+/*
+ * All file inputs share a single ring and a single completion thread.
+ * Each input keeps up to "depth" sequential reads in flight, straight into
+ * the blocks it then returns from pf_block.
+ */
+
+#define URING_ENTRIES 1024
+
+struct uring_engine
+{
+    int          fd;
+    unsigned     refs;     /* protected by engine_lock */
+    vlc_thread_t thread;
+
+    vlc_mutex_t  lock;     /* submission side */
+    vlc_cond_t   room;
+    unsigned     inflight;
+    unsigned     max_inflight;
+
+    void        *sq_ring;
+    size_t       sq_ring_size;
+    unsigned    *sq_tail;
+    unsigned    *sq_mask;
+    unsigned    *sq_array;
+    struct io_uring_sqe *sqes;
+    size_t       sqes_size;
+
+    void        *cq_ring;
+    size_t       cq_ring_size;
+    unsigned    *cq_head;
+    unsigned    *cq_tail;
+    unsigned    *cq_mask;
+    struct io_uring_cqe *cqes;
+};
+
+struct uring_read
+{
+    file_uring_t *owner;
+    block_t      *block;
+    uint64_t      offset;
+    int           result;
+    bool          done;
+};
+
+struct file_uring
+{
+    stream_t            *access;
+    struct uring_engine *engine;
+    int                  fd;
+
+    vlc_mutex_t          lock; /* completion vs. reader */
+    vlc_cond_t           wait;
+
+    size_t               read_size;
+    unsigned             depth;
+    unsigned             head;  /* oldest read in flight */
+    unsigned             count; /* reads in flight */
+    uint64_t             next;  /* offset of the next read to submit */
+    struct uring_read    reads[];
+};
+
+static vlc_mutex_t engine_lock = VLC_STATIC_MUTEX;
+static struct uring_engine *engine = NULL;
+static char engine_exit; /* user data of the request stopping the thread */
+
+static int uring_enter(int fd, unsigned submit, unsigned complete,
+                       unsigned flags)
+{
+    return syscall(__NR_io_uring_enter, fd, submit, complete, flags,
+                   NULL, 0);
+}
+
+static void UringComplete(struct uring_read *read, int res)
+{
+    file_uring_t *f = read->owner;
+
+    vlc_mutex_lock(&f->lock);
+    read->result = res;
+    read->done = true;
+    vlc_cond_signal(&f->wait);
+    vlc_mutex_unlock(&f->lock);
+}
+
+static void *EngineThread(void *data)
+{
+    struct uring_engine *e = data;
+    bool exit = false;
+
+    while (!exit)
+    {
+        if (uring_enter(e->fd, 0, 1, IORING_ENTER_GETEVENTS) < 0
+         && errno != EINTR)
+            break;
+
+        /* This thread is the only CQ consumer */
+        unsigned head = *e->cq_head;
+        unsigned tail = atomic_load_explicit((atomic_uint *)e->cq_tail,
+                                             memory_order_acquire);
+        unsigned done = 0;
+
+        for (; head != tail; head++)
+        {
+            const struct io_uring_cqe *cqe = &e->cqes[head & *e->cq_mask];
+            void *user = (void *)(uintptr_t)cqe->user_data;
+
+            if (user == NULL)
+                continue; /* uncounted no-op, see UringSubmit() */
+            if (user == &engine_exit)
+                exit = true;
+            else
+                UringComplete(user, cqe->res);
+            done++;
+        }
+        atomic_store_explicit((atomic_uint *)e->cq_head, head,
+                              memory_order_release);
+
+        if (done > 0)
+        {
+            vlc_mutex_lock(&e->lock);
+            e->inflight -= done;
+            vlc_cond_broadcast(&e->room);
+            vlc_mutex_unlock(&e->lock);
+        }
+    }
+    return NULL;
+}
+
+static int UringSubmit(struct uring_engine *e, uint8_t opcode, int fd,
+                       void *buf, unsigned len, uint64_t offset, void *user)
+{
+    int ret;
+
+    vlc_mutex_lock(&e->lock);
+    /* Do not overflow the completion queue */
+    while (e->inflight >= e->max_inflight)
+        vlc_cond_wait(&e->room, &e->lock);
+
+    /* No SQ polling: the kernel consumed every entry by the time
+     * io_uring_enter() returned, so the submission queue is always empty */
+    unsigned tail = *e->sq_tail;
+    unsigned index = tail & *e->sq_mask;
+    struct io_uring_sqe *sqe = &e->sqes[index];
+
+    memset(sqe, 0, sizeof (*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = (uintptr_t)buf;
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = (uintptr_t)user;
+    e->sq_array[index] = index;
+    atomic_store_explicit((atomic_uint *)e->sq_tail, tail + 1,
+                          memory_order_release);
+
+    do
+        ret = uring_enter(e->fd, 1, 0, 0);
+    while (ret < 0 && errno == EINTR);
+
+    if (ret == 1)
+    {
+        e->inflight++;
+        ret = 0;
+    }
+    else
+    {   /* The entry may still get consumed later: make it harmless */
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = 0;
+        ret = -1;
+    }
+    vlc_mutex_unlock(&e->lock);
+    return ret;
+}
+
+static void EngineDestroy(struct uring_engine *e)
+{
+    if (e->sqes != NULL)
+        munmap(e->sqes, e->sqes_size);
+    if (e->cq_ring != NULL && e->cq_ring != e->sq_ring)
+        munmap(e->cq_ring, e->cq_ring_size);
+    if (e->sq_ring != NULL)
+        munmap(e->sq_ring, e->sq_ring_size);
+    vlc_cond_destroy(&e->room);
+    vlc_mutex_destroy(&e->lock);
+    close(e->fd);
+    free(e);
+}
+
+static struct uring_engine *EngineCreate(void)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof (params));
+
+    int fd = syscall(__NR_io_uring_setup, URING_ENTRIES, &params);
+    if (fd < 0)
+        return NULL;
+
+    /* IORING_OP_READ came along with that feature (Linux 5.6) */
+    if (!(params.features & IORING_FEAT_RW_CUR_POS))
+    {
+        close(fd);
+        errno = ENOSYS;
+        return NULL;
+    }
+
+    struct uring_engine *e = calloc(1, sizeof (*e));
+    if (unlikely(e == NULL))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    e->fd = fd;
+    e->refs = 1;
+    vlc_mutex_init(&e->lock);
+    vlc_cond_init(&e->room);
+    e->max_inflight = params.cq_entries;
+
+    e->sq_ring_size = params.sq_off.array
+                    + params.sq_entries * sizeof (unsigned);
+    e->cq_ring_size = params.cq_off.cqes
+                    + params.cq_entries * sizeof (struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (e->cq_ring_size > e->sq_ring_size)
+            e->sq_ring_size = e->cq_ring_size;
+        e->cq_ring_size = e->sq_ring_size;
+    }
+
+    void *ptr = mmap(NULL, e->sq_ring_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ptr == MAP_FAILED)
+        goto error;
+    e->sq_ring = ptr;
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        e->cq_ring = e->sq_ring;
+    else
+    {
+        ptr = mmap(NULL, e->cq_ring_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (ptr == MAP_FAILED)
+            goto error;
+        e->cq_ring = ptr;
+    }
+
+    e->sqes_size = params.sq_entries * sizeof (struct io_uring_sqe);
+    ptr = mmap(NULL, e->sqes_size, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (ptr == MAP_FAILED)
+        goto error;
+    e->sqes = ptr;
+
+    uint8_t *sq = e->sq_ring, *cq = e->cq_ring;
+    e->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    e->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    e->sq_array = (unsigned *)(sq + params.sq_off.array);
+    e->cq_head = (unsigned *)(cq + params.cq_off.head);
+    e->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    e->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    e->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    if (vlc_clone(&e->thread, EngineThread, e, VLC_THREAD_PRIORITY_INPUT))
+        goto error;
+    return e;
+
+error:
+    EngineDestroy(e);
+    return NULL;
+}
+
+static struct uring_engine *EngineHold(void)
+{
+    struct uring_engine *e;
+
+    vlc_mutex_lock(&engine_lock);
+    if (engine != NULL)
+        engine->refs++;
+    else
+        engine = EngineCreate();
+    e = engine;
+    vlc_mutex_unlock(&engine_lock);
+    return e;
+}
+
+static void EngineRelease(struct uring_engine *e)
+{
+    vlc_mutex_lock(&engine_lock);
+    assert(e == engine);
+    if (--e->refs > 0)
+    {
+        vlc_mutex_unlock(&engine_lock);
+        return;
+    }
+    engine = NULL;
+    vlc_mutex_unlock(&engine_lock);
+
+    /* Entering the ring only fails on transient shortages by now */
+    while (UringSubmit(e, IORING_OP_NOP, -1, NULL, 0, 0, &engine_exit))
+        msleep(VLC_HARD_MIN_SLEEP);
+    vlc_join(e->thread, NULL);
+    EngineDestroy(e);
+}
+
+/* Keeps the configured number of reads in flight */
+static void FileUringFill(file_uring_t *f)
+{
+    while (f->count < f->depth)
+    {
+        struct uring_read *read = &f->reads[(f->head + f->count) % f->depth];
+
+        read->block = block_Alloc(f->read_size);
+        if (unlikely(read->block == NULL))
+            break;
+        read->offset = f->next;
+        read->done = false;
+
+        if (UringSubmit(f->engine, IORING_OP_READ, f->fd,
+                        read->block->p_buffer, f->read_size, read->offset,
+                        read))
+        {
+            block_Release(read->block);
+            break;
+        }
+        f->next += f->read_size;
+        f->count++;
+    }
+}
+
+static struct uring_read *FileUringWait(file_uring_t *f)
+{
+    struct uring_read *read = &f->reads[f->head];
+
+    vlc_mutex_lock(&f->lock);
+    while (!read->done)
+        vlc_cond_wait(&f->wait, &f->lock);
+    vlc_mutex_unlock(&f->lock);
+
+    f->head = (f->head + 1) % f->depth;
+    f->count--;
+    return read;
+}
+
+/* Waits for and discards all reads in flight */
+static void FileUringDrain(file_uring_t *f)
+{
+    while (f->count > 0)
+        block_Release(FileUringWait(f)->block);
+    f->head = 0;
+}
+
+block_t *FileUringBlock(file_uring_t *f, bool *restrict eof)
+{
+    FileUringFill(f);
+    if (f->count == 0)
+    {
+        msg_Err(f->access, "cannot queue read");
+        *eof = true;
+        return NULL;
+    }
+
+    struct uring_read *read = FileUringWait(f);
+    block_t *block = read->block;
+
+    if (read->result <= 0)
+    {
+        if (read->result < 0)
+            msg_Err(f->access, "read error: %s",
+                    vlc_strerror_c(-read->result));
+        block_Release(block);
+        /* Stay there: the file may grow, and the reads queued after this
+         * one are past the end */
+        FileUringDrain(f);
+        f->next = read->offset;
+        *eof = true;
+        return NULL;
+    }
+
+    block->i_buffer = read->result;
+    if ((size_t)read->result < f->read_size)
+    {   /* Short read: the reads queued after this one left a hole */
+        FileUringDrain(f);
+        f->next = read->offset + read->result;
+    }
+
+    /* Queue the next read before handing out this data */
+    FileUringFill(f);
+    return block;
+}
+
+void FileUringSeek(file_uring_t *f, uint64_t offset)
+{
+    FileUringDrain(f);
+    f->next = offset;
+}
+
+file_uring_t *FileUringNew(stream_t *access, int fd, unsigned depth,
+                           size_t read_size)
+{
+    off_t offset = lseek(fd, 0, SEEK_CUR);
+    if (offset == (off_t)-1)
+        return NULL;
+
+    file_uring_t *f = malloc(sizeof (*f) + depth * sizeof (f->reads[0]));
+    if (unlikely(f == NULL))
+        return NULL;
+
+    f->engine = EngineHold();
+    if (f->engine == NULL)
+    {
+        msg_Dbg(access, "io_uring not available: %s",
+                vlc_strerror_c(errno));
+        free(f);
+        return NULL;
+    }
+
+    f->access = access;
+    f->fd = fd;
+    vlc_mutex_init(&f->lock);
+    vlc_cond_init(&f->wait);
+    f->read_size = read_size;
+    f->depth = depth;
+    f->head = 0;
+    f->count = 0;
+    f->next = offset;
+    for (unsigned i = 0; i < depth; i++)
+        f->reads[i].owner = f;
+    return f;
+}
+
+void FileUringDelete(file_uring_t *f)
+{
+    FileUringDrain(f);
+    EngineRelease(f->engine);
+    vlc_cond_destroy(&f->wait);
+    vlc_mutex_destroy(&f->lock);
+    free(f);
+}
+
+#endif /* HAVE_LINUX_IO_URING_H */
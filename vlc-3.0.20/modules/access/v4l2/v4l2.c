@@ -69,6 +69,10 @@
     "(if both width and height are strictly positive)." )
 #define FPS_TEXT N_( "Frame rate" )
 #define FPS_LONGTEXT N_( "Maximum frame rate to use (0 = no limits)." )
+#define ZEROCOPY_TEXT N_( "Zero-copy capture" )
+#define ZEROCOPY_LONGTEXT N_( \
+    "Pass the memory-mapped capture buffers on without copying them. " \
+    "Frames are still copied when the driver runs short of buffers." )
 
 #define RADIO_DEVICE_TEXT N_( "Radio device" )
 #define RADIO_DEVICE_LONGTEXT N_("Radio tuner device node." )
@@ -312,6 +316,8 @@ vlc_module_begin ()
         change_safe()
     add_string( CFG_PREFIX "fps", "60", FPS_TEXT, FPS_LONGTEXT, false )
         change_safe()
+    add_bool( CFG_PREFIX "zero-copy", true, ZEROCOPY_TEXT, ZEROCOPY_LONGTEXT,
+              true )
     add_obsolete_bool( CFG_PREFIX "use-libv4l2" ) /* since 2.1.0 */
 
     set_section( N_( "Tuner" ), NULL )
@@ -35,6 +35,7 @@
 
 #include <vlc_common.h>
 #include <vlc_block.h>
+#include <vlc_atomic.h>
 
 #include "v4l2.h"
 
@@ -579,12 +580,100 @@ vlc_tick_t GetBufferPTS (const struct v4l2_buffer *buf)
     return pts;
 }
 
+/* Memory-mapped buffers, shared with the blocks lent downstream. The pool
+ * outlives StopMmap() until the last lent block is released. */
+struct mmap_pool
+{
+    int fd;
+    bool zerocopy;
+    bool streaming;
+    unsigned lent;
+    vlc_mutex_t lock;
+    atomic_uint refs;
+    uint32_t bufc;
+    struct buffer_t bufv[];
+};
+
+struct mmap_block
+{
+    block_t self;
+    struct mmap_pool *pool;
+    struct v4l2_buffer buf;
+};
+
+static struct mmap_pool *mmap_pool_Get (const struct buffer_t *bufv)
+{
+    return container_of (bufv, struct mmap_pool, bufv);
+}
+
+static void mmap_pool_Release (struct mmap_pool *pool)
+{
+    if (atomic_fetch_sub (&pool->refs, 1) != 1)
+        return;
+
+    for (uint32_t i = 0; i < pool->bufc; i++)
+        v4l2_munmap (pool->bufv[i].start, pool->bufv[i].length);
+    vlc_mutex_destroy (&pool->lock);
+    free (pool);
+}
+
+static void MmapBlockRelease (block_t *block)
+{
+    struct mmap_block *mb = container_of (block, struct mmap_block, self);
+    struct mmap_pool *pool = mb->pool;
+
+    /* Give the buffer back to the driver, unless streaming was stopped */
+    vlc_mutex_lock (&pool->lock);
+    if (pool->streaming)
+        v4l2_ioctl (pool->fd, VIDIOC_QBUF, &mb->buf);
+    pool->lent--;
+    vlc_mutex_unlock (&pool->lock);
+
+    free (mb);
+    mmap_pool_Release (pool);
+}
+
+/**
+ * Wraps a dequeued buffer into a block, which requeues the buffer when
+ * released. Returns NULL if the driver would be left with less than two
+ * queued buffers.
+ */
+static block_t *MmapBlockLend (struct mmap_pool *pool,
+                               const struct v4l2_buffer *buf)
+{
+    vlc_mutex_lock (&pool->lock);
+    if (pool->bufc - pool->lent < 3)
+    {
+        vlc_mutex_unlock (&pool->lock);
+        return NULL;
+    }
+    pool->lent++;
+    vlc_mutex_unlock (&pool->lock);
+
+    struct mmap_block *mb = malloc (sizeof (*mb));
+    if (unlikely(mb == NULL))
+    {
+        vlc_mutex_lock (&pool->lock);
+        pool->lent--;
+        vlc_mutex_unlock (&pool->lock);
+        return NULL;
+    }
+
+    block_Init (&mb->self, pool->bufv[buf->index].start, buf->bytesused);
+    mb->self.pf_release = MmapBlockRelease;
+    mb->pool = pool;
+    mb->buf = *buf;
+    atomic_fetch_add (&pool->refs, 1);
+    return &mb->self;
+}
+
 /*****************************************************************************
  * GrabVideo: Grab a video frame
  *****************************************************************************/
 block_t *GrabVideo (vlc_object_t *demux, int fd,
                     const struct buffer_t *restrict bufv)
 {
+    struct mmap_pool *pool = mmap_pool_Get (bufv);
     struct v4l2_buffer buf = {
         .type = V4L2_BUF_TYPE_VIDEO_CAPTURE,
         .memory = V4L2_MEMORY_MMAP,
@@ -606,6 +695,16 @@ block_t *GrabVideo (vlc_object_t *demux, int fd,
         }
     }
 
+    if (pool->zerocopy)
+    {
+        block_t *block = MmapBlockLend (pool, &buf);
+        if (block != NULL)
+        {
+            block->i_pts = block->i_dts = GetBufferPTS (&buf);
+            return block;
+        }
+    }
+
     /* Copy frame */
     block_t *block = block_Alloc (buf.bytesused);
     if (unlikely(block == NULL))
@@ -651,12 +750,14 @@ int StartUserPtr (vlc_object_t *obj, int fd)
 /**
  * Allocates memory-mapped buffers, queues them and start streaming.
  * @param n requested buffers count [IN], allocated buffers count [OUT]
- * @return array of allocated buffers (use free()), or NULL on error.
+ * @return array of allocated buffers (use StopMmap()), or NULL on error.
  */
 struct buffer_t *StartMmap (vlc_object_t *obj, int fd, uint32_t *restrict n)
 {
+    bool zerocopy = var_InheritBool (obj, CFG_PREFIX"zero-copy");
     struct v4l2_requestbuffers req = {
-        .count = *n,
+        /* Lent buffers are not available to the driver: ask for more */
+        .count = zerocopy ? 2 * *n : *n,
         .type = V4L2_BUF_TYPE_VIDEO_CAPTURE,
         .memory = V4L2_MEMORY_MMAP,
     };
@@ -673,10 +774,21 @@ struct buffer_t *StartMmap (vlc_object_t *obj, int fd, uint32_t *restrict n)
         return NULL;
     }
 
-    struct buffer_t *bufv = vlc_alloc (req.count, sizeof (*bufv));
-    if (unlikely(bufv == NULL))
+    struct mmap_pool *pool = malloc (sizeof (*pool)
+                                     + req.count * sizeof (pool->bufv[0]));
+    if (unlikely(pool == NULL))
         return NULL;
 
+    pool->fd = fd;
+    pool->zerocopy = zerocopy;
+    pool->streaming = false;
+    pool->lent = 0;
+    vlc_mutex_init (&pool->lock);
+    atomic_init (&pool->refs, 1);
+    pool->bufc = 0;
+
+    struct buffer_t *bufv = pool->bufv;
+
     uint32_t bufc = 0;
     while (bufc < req.count)
     {
@@ -719,6 +831,8 @@ struct buffer_t *StartMmap (vlc_object_t *obj, int fd, uint32_t *restrict n)
         msg_Err (obj, "cannot start streaming: %s", vlc_strerror_c(errno));
         goto error;
     }
+    pool->streaming = true;
+    pool->bufc = bufc;
     *n = bufc;
     return bufv;
 error:
@@ -728,11 +842,16 @@ error:
 
 void StopMmap (int fd, struct buffer_t *bufv, uint32_t bufc)
 {
+    struct mmap_pool *pool = mmap_pool_Get (bufv);
     enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
 
     /* STREAMOFF implicitly dequeues all buffers */
+    vlc_mutex_lock (&pool->lock);
+    pool->streaming = false;
     v4l2_ioctl (fd, VIDIOC_STREAMOFF, &type);
-    for (uint32_t i = 0; i < bufc; i++)
-        v4l2_munmap (bufv[i].start, bufv[i].length);
-    free (bufv);
+    vlc_mutex_unlock (&pool->lock);
+
+    /* Buffers still lent are unmapped when their blocks are released */
+    pool->bufc = bufc;
+    mmap_pool_Release (pool);
 }
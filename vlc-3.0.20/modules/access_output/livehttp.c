@@ -43,6 +43,8 @@
 #include <vlc_fs.h>
 #include <vlc_strings.h>
 #include <vlc_charset.h>
+#include <vlc_httpd.h>
+#include <vlc_memstream.h>
 
 #include <gcrypt.h>
 #include <vlc_gcrypt.h>
@@ -57,6 +59,9 @@
 
 #define MAX_RENAME_RETRIES        10
 
+/* Segments kept in memory by default in origin mode */
+#define ORIGIN_NUMSEGS             6
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -105,6 +110,23 @@ static void Close( vlc_object_t * );
 #define INTITIAL_SEG_TEXT N_("Number of first segment")
 #define INITIAL_SEG_LONGTEXT N_("The number of the first segment generated")
 
+#define CMAF_TEXT N_("CMAF segments")
+#define CMAF_LONGTEXT N_("Cut fragmented MP4 (CMAF) segments on the fragments "\
+                         "of the mp4frag muxer, and write its header as a separate "\
+                         "initialization segment.")
+
+#define PARTS_TEXT N_("Low-latency parts")
+#define PARTS_LONGTEXT N_("List every fragment of the recent segments as a "\
+                          "partial segment in the index (LL-HLS). "\
+                          "Requires CMAF segments.")
+
+#define ORIGIN_TEXT N_("HTTP origin")
+#define ORIGIN_LONGTEXT N_("Keep the index and the segments of the live window "\
+                           "in memory and serve them with the built-in HTTP "\
+                           "server instead of writing files. The destination "\
+                           "and the index are then URL paths, the destination "\
+                           "optionally prefixed by the host:port to listen on.")
+
 vlc_module_begin ()
     set_description( N_("HTTP Live streaming output") )
     set_shortname( N_("LiveHTTP" ))
@@ -125,6 +147,12 @@ vlc_module_begin ()
               NOCACHE_TEXT, NOCACHE_LONGTEXT, true )
     add_bool( SOUT_CFG_PREFIX "generate-iv", false,
               RANDOMIV_TEXT, RANDOMIV_LONGTEXT, true )
+    add_bool( SOUT_CFG_PREFIX "cmaf", false,
+              CMAF_TEXT, CMAF_LONGTEXT, false )
+    add_bool( SOUT_CFG_PREFIX "parts", false,
+              PARTS_TEXT, PARTS_LONGTEXT, false )
+    add_bool( SOUT_CFG_PREFIX "origin", false,
+              ORIGIN_TEXT, ORIGIN_LONGTEXT, false )
     add_string( SOUT_CFG_PREFIX "index", NULL,
                 INDEX_TEXT, INDEX_LONGTEXT, false )
     add_string( SOUT_CFG_PREFIX "index-url", NULL,
@@ -156,12 +184,23 @@ static const char *const ppsz_sout_options[] = {
     "key-loadfile",
     "generate-iv",
     "initial-segment-number",
+    "cmaf",
+    "parts",
+    "origin",
     NULL
 };
 
 static ssize_t Write( sout_access_out_t *, block_t * );
 static int Control( sout_access_out_t *, int, va_list );
 
+typedef struct output_part
+{
+    float f_duration;
+    uint64_t i_offset;
+    size_t i_size;
+    bool b_independent;
+} output_part_t;
+
 typedef struct output_segment
 {
     char *psz_filename;
@@ -171,10 +210,21 @@ typedef struct output_segment
     float f_seglength;
     uint32_t i_segment_number;
     uint8_t aes_ivs[16];
+    output_part_t *p_parts;
+    size_t i_parts;
+
+    /* Origin mode: the segment data, protected by the lock of p_sys */
+    sout_access_out_sys_t *p_sys;
+    httpd_url_t *p_url;
+    uint8_t *p_data;
+    size_t i_data;
+    size_t i_alloc;
+    bool b_complete;
 } output_segment_t;
 
 struct sout_access_out_sys_t
 {
+    const char *psz_path;
     char *psz_cursegPath;
     char *psz_indexPath;
     char *psz_indexUrl;
@@ -191,6 +241,7 @@ struct sout_access_out_sys_t
     block_t *ongoing_segment;
     block_t **ongoing_segment_end;
     int i_handle;
+    bool b_segment_open;
     unsigned i_numsegs;
     unsigned i_initial_segment;
     bool b_delsegs;
@@ -199,12 +250,39 @@ struct sout_access_out_sys_t
     bool b_caching;
     bool b_generate_iv;
     bool b_segment_has_data;
+    bool b_cmaf;
+    bool b_parts;
+    char *psz_initPath;
+    char *psz_initUri;
+    uint64_t i_segment_size;
+    float f_part_target;
     uint8_t aes_ivs[16];
     gcry_cipher_hd_t aes_ctx;
     char *key_uri;
     uint8_t stuffing_bytes[16];
     ssize_t stuffing_size;
     vlc_array_t segments_t;
+
+    /* Files are written by a separate thread, so that slow storage does not
+     * hold the muxer back. Everything above belongs to that thread once it
+     * is started. */
+    block_fifo_t *fifo;
+    vlc_thread_t thread;
+    bool b_closing; /* protected by the fifo lock */
+
+    /* In origin mode, the HTTP server reads the index, the initialization
+     * segment and the segments from memory, under the lock. */
+    bool b_origin;
+    httpd_host_t *p_httpd_host;
+    httpd_url_t *p_index_url;
+    httpd_url_t *p_init_url;
+    vlc_mutex_t lock;
+    char *psz_index;
+    size_t i_index;
+    block_t *p_init;
+    int64_t i_last_complete;  /* last complete segment in the index */
+    size_t i_open_parts;      /* parts of the next one in the index */
+    bool b_ended;
 };
 
 static int LoadCryptFile( sout_access_out_t *p_access);
@@ -212,6 +290,337 @@ static int CryptSetup( sout_access_out_t *p_access, char *keyfile );
 static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer );
 static ssize_t writeSegment( sout_access_out_t *p_access );
 static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys );
+static ssize_t WriteBlocks( sout_access_out_t *, block_t * );
+static ssize_t writeFragment( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys );
+static ssize_t writeData( sout_access_out_sys_t *p_sys, int fd,
+                          const void *p_data, size_t i_data );
+static void *WriterThread( void * );
+static char *formatInitPath( const char *psz_path );
+
+/*****************************************************************************
+ * Origin mode: serve the live window from memory
+ *****************************************************************************/
+
+/* Returns the value of a numeric query argument, or -1 */
+static int64_t getQueryNumber( const char *psz_args, const char *psz_name )
+{
+    const size_t i_len = strlen( psz_name );
+
+    while( psz_args && *psz_args )
+    {
+        if( !strncmp( psz_args, psz_name, i_len ) && psz_args[i_len] == '=' )
+        {
+            const char *psz_value = &psz_args[i_len + 1];
+            char *psz_end;
+            long long i_value = strtoll( psz_value, &psz_end, 10 );
+            return ( psz_end > psz_value && i_value >= 0 ) ? i_value : -1;
+        }
+        psz_args = strchr( psz_args, '&' );
+        if( psz_args )
+            psz_args++;
+    }
+    return -1;
+}
+
+/* Parses a "bytes=first-[last]" range, last is SIZE_MAX when open-ended */
+static bool getRange( const httpd_message_t *query, size_t *pi_first, size_t *pi_last )
+{
+    const char *psz_range = httpd_MsgGet( query, "Range" );
+    unsigned long long i_first, i_last = SIZE_MAX;
+    char *psz_end;
+
+    if( !psz_range || strncasecmp( psz_range, "bytes=", 6 ) )
+        return false;
+
+    psz_range += 6;
+    i_first = strtoull( psz_range, &psz_end, 10 );
+    if( psz_end == psz_range || *psz_end != '-' )
+        return false;
+
+    psz_range = psz_end + 1;
+    if( *psz_range )
+    {
+        i_last = strtoull( psz_range, &psz_end, 10 );
+        if( psz_end == psz_range || *psz_end || i_last < i_first )
+            return false;
+    }
+
+    *pi_first = __MIN( i_first, SIZE_MAX );
+    *pi_last = __MIN( i_last, SIZE_MAX );
+    return true;
+}
+
+static void answerInit( httpd_message_t *answer, int i_status )
+{
+    answer->i_proto = HTTPD_PROTO_HTTP;
+    answer->i_version = 1;
+    answer->i_type = HTTPD_MSG_ANSWER;
+    answer->i_status = i_status;
+}
+
+static void answerSetBody( httpd_message_t *answer, const void *p_data, size_t i_data )
+{
+    answer->p_body = i_data > 0 ? malloc( i_data ) : NULL;
+    if( answer->p_body )
+    {
+        memcpy( answer->p_body, p_data, i_data );
+        answer->i_body = i_data;
+    }
+    else
+        answer->i_body = 0;
+}
+
+/* Tells whether a blocking playlist reload (LL-HLS) can be answered */
+static bool isIndexReady( const sout_access_out_sys_t *p_sys,
+                          int64_t i_msn, int64_t i_part )
+{
+    if( p_sys->b_ended || i_msn <= p_sys->i_last_complete )
+        return true;
+    return i_part >= 0 && i_msn == p_sys->i_last_complete + 1 &&
+           (uint64_t)i_part < p_sys->i_open_parts;
+}
+
+static int IndexCallback( httpd_callback_sys_t *p_cbsys, httpd_client_t *cl,
+                          httpd_message_t *answer, const httpd_message_t *query )
+{
+    sout_access_out_sys_t *p_sys = (sout_access_out_sys_t *)p_cbsys;
+
+    if( answer == NULL || query == NULL || cl == NULL )
+        return VLC_SUCCESS;
+
+    const char *psz_args = (const char *)query->psz_args;
+    int64_t i_msn = getQueryNumber( psz_args, "_HLS_msn" );
+    int64_t i_part = i_msn >= 0 ? getQueryNumber( psz_args, "_HLS_part" ) : -1;
+
+    vlc_mutex_lock( &p_sys->lock );
+    if( answer->i_body_offset > 0 )
+    {
+        /* While a blocking reload waits, the body offset holds its deadline */
+        if( isIndexReady( p_sys, i_msn, i_part ) ||
+            mdate() >= answer->i_body_offset )
+        {
+            answer->i_type = HTTPD_MSG_ANSWER;
+            answer->i_body_offset = 0;
+            answerSetBody( answer, p_sys->psz_index, p_sys->i_index );
+        }
+        vlc_mutex_unlock( &p_sys->lock );
+        return VLC_SUCCESS;
+    }
+
+    if( !p_sys->psz_index )
+    {
+        vlc_mutex_unlock( &p_sys->lock );
+        return VLC_EGENERIC;
+    }
+
+    answerInit( answer, 200 );
+    httpd_MsgAdd( answer, "Cache-Control", "no-cache" );
+    if( i_msn > p_sys->i_last_complete + ( p_sys->i_open_parts ? 1 : 0 ) + 2 )
+    {
+        answer->i_status = 400;
+        httpd_MsgAdd( answer, "Content-Length", "0" );
+    }
+    else
+    {
+        httpd_MsgAdd( answer, "Content-Type", "application/vnd.apple.mpegurl" );
+        if( isIndexReady( p_sys, i_msn, i_part ) )
+        {
+            answerSetBody( answer, p_sys->psz_index, p_sys->i_index );
+            httpd_MsgAdd( answer, "Content-Length", "%d", answer->i_body );
+        }
+        else
+        {
+            /* Hold the answer until the index has what was asked for, or
+             * give the current one after three target durations */
+            httpd_ClientStream( cl, answer );
+            answer->i_body_offset = mdate() + 3 * p_sys->i_seglenm;
+        }
+    }
+    vlc_mutex_unlock( &p_sys->lock );
+    return VLC_SUCCESS;
+}
+
+static int InitCallback( httpd_callback_sys_t *p_cbsys, httpd_client_t *cl,
+                         httpd_message_t *answer, const httpd_message_t *query )
+{
+    sout_access_out_sys_t *p_sys = (sout_access_out_sys_t *)p_cbsys;
+
+    if( answer == NULL || query == NULL || cl == NULL )
+        return VLC_SUCCESS;
+
+    vlc_mutex_lock( &p_sys->lock );
+    if( !p_sys->p_init )
+    {
+        vlc_mutex_unlock( &p_sys->lock );
+        return VLC_EGENERIC;
+    }
+    answerInit( answer, 200 );
+    httpd_MsgAdd( answer, "Content-Type", "video/mp4" );
+    answerSetBody( answer, p_sys->p_init->p_buffer, p_sys->p_init->i_buffer );
+    httpd_MsgAdd( answer, "Content-Length", "%d", answer->i_body );
+    vlc_mutex_unlock( &p_sys->lock );
+    return VLC_SUCCESS;
+}
+
+static int SegmentCallback( httpd_callback_sys_t *p_cbsys, httpd_client_t *cl,
+                            httpd_message_t *answer, const httpd_message_t *query )
+{
+    output_segment_t *segment = (output_segment_t *)p_cbsys;
+    sout_access_out_sys_t *p_sys = segment->p_sys;
+
+    if( answer == NULL || query == NULL || cl == NULL )
+        return VLC_SUCCESS;
+
+    vlc_mutex_lock( &p_sys->lock );
+    if( answer->i_body_offset > 0 )
+    {
+        /* The segment being written is sent as it grows: the body offset is
+         * one past the position of the next byte to send */
+        size_t i_pos = answer->i_body_offset - 1;
+        if( i_pos < segment->i_data )
+        {
+            answer->i_type = HTTPD_MSG_ANSWER;
+            answerSetBody( answer, &segment->p_data[i_pos], segment->i_data - i_pos );
+            answer->i_body_offset += answer->i_body;
+        }
+        else if( segment->b_complete )
+        {
+            answer->i_type = HTTPD_MSG_ANSWER;
+            answer->i_body_offset = 0;
+        }
+        vlc_mutex_unlock( &p_sys->lock );
+        return VLC_SUCCESS;
+    }
+
+    size_t i_first = 0, i_last = SIZE_MAX;
+    bool b_range = getRange( query, &i_first, &i_last );
+
+    answerInit( answer, b_range ? 206 : 200 );
+    httpd_MsgAdd( answer, "Content-Type", "%s",
+                  p_sys->b_cmaf ? "video/mp4" : "video/MP2T" );
+
+    if( !segment->b_complete && i_last == SIZE_MAX )
+    {
+        /* Unknown length, answered as RFC 8673 does */
+        if( b_range )
+            httpd_MsgAdd( answer, "Content-Range",
+                          "bytes %zu-9007199254740991/*", i_first );
+        httpd_MsgAdd( answer, "Cache-Control", "no-cache" );
+        httpd_ClientStream( cl, answer );
+        if( i_first < segment->i_data )
+            answerSetBody( answer, &segment->p_data[i_first],
+                           segment->i_data - i_first );
+        answer->i_body_offset = i_first + answer->i_body + 1;
+    }
+    else if( b_range && i_first >= segment->i_data )
+    {
+        answer->i_status = 416;
+        httpd_MsgAdd( answer, "Content-Range", "bytes */%zu", segment->i_data );
+        httpd_MsgAdd( answer, "Content-Length", "0" );
+    }
+    else
+    {
+        size_t i_size = segment->i_data - i_first;
+        if( i_last < segment->i_data )
+            i_size = i_last + 1 - i_first;
+
+        if( b_range && segment->b_complete )
+            httpd_MsgAdd( answer, "Content-Range", "bytes %zu-%zu/%zu",
+                          i_first, i_first + i_size - 1, segment->i_data );
+        else if( b_range )
+            httpd_MsgAdd( answer, "Content-Range", "bytes %zu-%zu/*",
+                          i_first, i_first + i_size - 1 );
+        answerSetBody( answer, &segment->p_data[i_first], i_size );
+        httpd_MsgAdd( answer, "Content-Length", "%d", answer->i_body );
+    }
+    vlc_mutex_unlock( &p_sys->lock );
+    return VLC_SUCCESS;
+}
+
+/* The segments must have been destroyed first */
+static void OriginClose( sout_access_out_sys_t *p_sys )
+{
+    /* No callback runs anymore once its URL is deleted */
+    if( p_sys->p_init_url )
+        httpd_UrlDelete( p_sys->p_init_url );
+    if( p_sys->p_index_url )
+        httpd_UrlDelete( p_sys->p_index_url );
+    httpd_HostDelete( p_sys->p_httpd_host );
+    p_sys->p_httpd_host = NULL;
+
+    vlc_mutex_destroy( &p_sys->lock );
+    free( p_sys->psz_index );
+    if( p_sys->p_init )
+        block_Release( p_sys->p_init );
+}
+
+static int OriginOpen( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys )
+{
+    if( !p_sys->psz_indexPath )
+    {
+        msg_Err( p_access, "no index URL path specified" );
+        return VLC_EGENERIC;
+    }
+
+    /* The host and port to listen on may come first, as with the http
+     * access output */
+    const char *path = p_access->psz_path;
+    path += strcspn( path, "/" );
+    if( path > p_access->psz_path )
+    {
+        const char *port = strrchr( p_access->psz_path, ':' );
+        if( port != NULL && strchr( port, ']' ) != NULL )
+            port = NULL; /* IPv6 numeral */
+        if( port != p_access->psz_path )
+        {
+            int len = (port ? port : path) - p_access->psz_path;
+            char host[len + 1];
+            strncpy( host, p_access->psz_path, len );
+            host[len] = '\0';
+
+            var_Create( p_access, "http-host", VLC_VAR_STRING );
+            var_SetString( p_access, "http-host", host );
+        }
+        if( port != NULL )
+        {
+            int bind_port = atoi( port + 1 );
+            if( bind_port > 0 )
+            {
+                var_Create( p_access, "http-port", VLC_VAR_INTEGER );
+                var_SetInteger( p_access, "http-port", bind_port );
+            }
+        }
+    }
+    if( !*path )
+    {
+        msg_Err( p_access, "no segment URL path specified" );
+        return VLC_EGENERIC;
+    }
+    p_sys->psz_path = path;
+
+    p_sys->p_httpd_host = vlc_http_HostNew( VLC_OBJECT(p_access) );
+    if( p_sys->p_httpd_host == NULL )
+    {
+        msg_Err( p_access, "cannot start HTTP server" );
+        return VLC_EGENERIC;
+    }
+
+    vlc_mutex_init( &p_sys->lock );
+    p_sys->i_last_complete = p_sys->i_segment;
+
+    p_sys->p_index_url = httpd_UrlNew( p_sys->p_httpd_host,
+                                       p_sys->psz_indexPath, NULL, NULL );
+    if( p_sys->p_index_url == NULL )
+    {
+        msg_Err( p_access, "cannot serve `%s'", p_sys->psz_indexPath );
+        OriginClose( p_sys );
+        return VLC_EGENERIC;
+    }
+    httpd_UrlCatch( p_sys->p_index_url, HTTPD_MSG_GET, IndexCallback,
+                    (httpd_callback_sys_t *)p_sys );
+    return VLC_SUCCESS;
+}
+
 /*****************************************************************************
  * Open: open the file
  *****************************************************************************/
@@ -250,6 +659,23 @@ static int Open( vlc_object_t *p_this )
     p_sys->b_caching = var_GetBool( p_access, SOUT_CFG_PREFIX "caching") ;
     p_sys->b_generate_iv = var_GetBool( p_access, SOUT_CFG_PREFIX "generate-iv") ;
     p_sys->b_segment_has_data = false;
+    p_sys->b_cmaf = var_GetBool( p_access, SOUT_CFG_PREFIX "cmaf" );
+    p_sys->b_parts = var_GetBool( p_access, SOUT_CFG_PREFIX "parts" );
+    if( p_sys->b_parts && !p_sys->b_cmaf )
+    {
+        msg_Warn( p_access, "parts require CMAF segments, disabling them" );
+        p_sys->b_parts = false;
+    }
+
+    p_sys->b_origin = var_GetBool( p_access, SOUT_CFG_PREFIX "origin" );
+    p_sys->psz_path = p_access->psz_path;
+    if( p_sys->b_origin )
+    {
+        /* The memory is only given back when segments leave the window */
+        if( p_sys->i_numsegs == 0 )
+            p_sys->i_numsegs = ORIGIN_NUMSEGS;
+        p_sys->b_delsegs = true;
+    }
 
     vlc_array_init( &p_sys->segments_t );
 
@@ -270,7 +696,7 @@ static int Open( vlc_object_t *p_this )
             return VLC_ENOMEM;
         }
         p_sys->psz_indexPath = psz_tmp;
-        if( p_sys->i_initial_segment != 1 )
+        if( p_sys->i_initial_segment != 1 && !p_sys->b_origin )
             vlc_unlink( p_sys->psz_indexPath );
     }
 
@@ -278,6 +704,17 @@ static int Open( vlc_object_t *p_this )
     p_sys->psz_keyfile  = var_GetNonEmptyString( p_access, SOUT_CFG_PREFIX "key-loadfile" );
     p_sys->key_uri      = var_GetNonEmptyString( p_access, SOUT_CFG_PREFIX "key-uri" );
 
+    if( p_sys->b_cmaf && ( p_sys->key_uri || p_sys->psz_keyfile ) )
+    {
+        msg_Err( p_access, "encryption is not supported with CMAF segments" );
+        free( p_sys->key_uri );
+        free( p_sys->psz_keyfile );
+        free( p_sys->psz_indexUrl );
+        free( p_sys->psz_indexPath );
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
+
     p_access->p_sys = p_sys;
 
     if( p_sys->psz_keyfile && ( LoadCryptFile( p_access ) < 0 ) )
@@ -298,13 +735,68 @@ static int Open( vlc_object_t *p_this )
     }
 
     p_sys->i_handle = -1;
+    p_sys->b_segment_open = false;
     p_sys->i_segment = p_sys->i_initial_segment-1;
     p_sys->psz_cursegPath = NULL;
 
+    int i_ret = VLC_ENOMEM;
+    if( p_sys->b_origin && ( i_ret = OriginOpen( p_access, p_sys ) ) )
+        goto error;
+    i_ret = VLC_ENOMEM;
+
+    if( p_sys->b_cmaf )
+    {
+        p_sys->psz_initPath = formatInitPath( p_sys->psz_path );
+        p_sys->psz_initUri = formatInitPath( p_sys->psz_indexUrl ?
+                                             p_sys->psz_indexUrl : p_sys->psz_path );
+        if( !p_sys->psz_initPath || !p_sys->psz_initUri )
+            goto error;
+
+        if( p_sys->b_origin )
+        {
+            p_sys->p_init_url = httpd_UrlNew( p_sys->p_httpd_host,
+                                              p_sys->psz_initPath, NULL, NULL );
+            if( !p_sys->p_init_url )
+            {
+                msg_Err( p_access, "cannot serve `%s'", p_sys->psz_initPath );
+                i_ret = VLC_EGENERIC;
+                goto error;
+            }
+            httpd_UrlCatch( p_sys->p_init_url, HTTPD_MSG_GET, InitCallback,
+                            (httpd_callback_sys_t *)p_sys );
+        }
+    }
+
+    p_sys->fifo = block_FifoNewSPSC();
+    if( unlikely( !p_sys->fifo ) )
+        goto error;
+    if( vlc_clone( &p_sys->thread, WriterThread, p_access,
+                   VLC_THREAD_PRIORITY_LOW ) )
+    {
+        block_FifoRelease( p_sys->fifo );
+        goto error;
+    }
+
     p_access->pf_write = Write;
     p_access->pf_control = Control;
 
     return VLC_SUCCESS;
+
+error:
+    if( p_sys->p_httpd_host )
+        OriginClose( p_sys );
+    if( p_sys->key_uri )
+    {
+        gcry_cipher_close( p_sys->aes_ctx );
+        free( p_sys->key_uri );
+    }
+    free( p_sys->psz_initPath );
+    free( p_sys->psz_initUri );
+    free( p_sys->psz_keyfile );
+    free( p_sys->psz_indexUrl );
+    free( p_sys->psz_indexPath );
+    free( p_sys );
+    return i_ret;
 }
 
 /************************************************************************
@@ -478,7 +970,7 @@ static int CryptKey( sout_access_out_t *p_access, uint32_t i_segment )
 /*****************************************************************************
  * formatSegmentPath: create segment path name based on seg #
  *****************************************************************************/
-static char *formatSegmentPath( char *psz_path, uint32_t i_seg )
+static char *formatSegmentPath( const char *psz_path, uint32_t i_seg )
 {
     char *psz_result;
     char *psz_firstNumSign;
@@ -504,8 +996,39 @@ static char *formatSegmentPath( char *psz_path, uint32_t i_seg )
     return psz_result;
 }
 
+/*****************************************************************************
+ * formatInitPath: create the initialization segment path name
+ *****************************************************************************/
+static char *formatInitPath( const char *psz_path )
+{
+    char *psz_result;
+
+    if ( ! ( psz_result  = vlc_strftime( psz_path ) ) )
+        return NULL;
+
+    /* Replace the segment number placeholder, if any */
+    char *psz_firstNumSign = psz_result + strcspn( psz_result, SEG_NUMBER_PLACEHOLDER );
+    char *psz_newResult;
+    int ret;
+    if ( *psz_firstNumSign )
+    {
+        *psz_firstNumSign = '\0';
+        ret = asprintf( &psz_newResult, "%sinit%s", psz_result,
+                        psz_firstNumSign + 1 + strspn( psz_firstNumSign + 1, SEG_NUMBER_PLACEHOLDER ) );
+    }
+    else
+        ret = asprintf( &psz_newResult, "%s.init", psz_result );
+    free( psz_result );
+
+    return ret < 0 ? NULL : psz_newResult;
+}
+
 static void destroySegment( output_segment_t *segment )
 {
+    if( segment->p_url )
+        httpd_UrlDelete( segment->p_url );
+    free( segment->p_data );
+    free( segment->p_parts );
     free( segment->psz_filename );
     free( segment->psz_duration );
     free( segment->psz_uri );
@@ -555,6 +1078,95 @@ static bool isFirstItemRemovable( sout_access_out_sys_t *p_sys, uint32_t i_first
     return duration >= (first->f_seglength + (float)(p_sys->i_numsegs * p_sys->i_seglen));
 }
 
+/************************************************************************
+ * writeIndexParts: list the parts of a segment (LL-HLS)
+ ************************************************************************/
+static int writeIndexParts( struct vlc_memstream *ms, const output_segment_t *segment )
+{
+    for( size_t i = 0; i < segment->i_parts; i++ )
+    {
+        const output_part_t *part = &segment->p_parts[i];
+        char *psz_duration;
+
+        if( us_asprintf( &psz_duration, "%.3f", part->f_duration ) < 0 )
+            return -1;
+        vlc_memstream_printf( ms, "#EXT-X-PART:DURATION=%s,URI=\"%s\",BYTERANGE=\"%zu@%"PRIu64"\"%s\n",
+                              psz_duration, segment->psz_uri, part->i_size, part->i_offset,
+                              part->b_independent ? ",INDEPENDENT=YES" : "" );
+        free( psz_duration );
+    }
+    return 0;
+}
+
+/************************************************************************
+ * writeIndexFile: replace the index file
+ ************************************************************************/
+static int writeIndexFile( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys,
+                           const char *psz_index, size_t i_index )
+{
+    int val;
+    FILE *fp;
+    char *psz_idxTmp;
+    if ( asprintf( &psz_idxTmp, "%s.tmp", p_sys->psz_indexPath ) < 0)
+        return -1;
+
+    fp = vlc_fopen( psz_idxTmp, "wt");
+    if ( !fp )
+    {
+        msg_Err( p_access, "cannot open index file `%s'", psz_idxTmp );
+        free( psz_idxTmp );
+        return -1;
+    }
+
+    if ( fwrite( psz_index, 1, i_index, fp ) != i_index )
+    {
+        free( psz_idxTmp );
+        fclose( fp );
+        return -1;
+    }
+    fclose( fp );
+
+    val = vlc_rename ( psz_idxTmp, p_sys->psz_indexPath);
+
+    if ( val < 0 )
+    {
+        vlc_unlink( psz_idxTmp );
+        msg_Err( p_access, "Error moving LiveHttp index file" );
+    }
+    else
+        msg_Dbg( p_access, "LiveHttpIndexComplete: %s" , p_sys->psz_indexPath );
+
+    free( psz_idxTmp );
+    return 0;
+}
+
+/************************************************************************
+ * publishIndex: hand the index over to the HTTP server (origin mode)
+ ************************************************************************/
+static void publishIndex( sout_access_out_sys_t *p_sys, char *psz_index,
+                          size_t i_index, bool b_isend )
+{
+    output_segment_t *last = vlc_array_item_at_index( &p_sys->segments_t,
+                                    vlc_array_count( &p_sys->segments_t ) - 1 );
+
+    vlc_mutex_lock( &p_sys->lock );
+    free( p_sys->psz_index );
+    p_sys->psz_index = psz_index;
+    p_sys->i_index = i_index;
+    if( last->psz_duration )
+    {
+        p_sys->i_last_complete = last->i_segment_number;
+        p_sys->i_open_parts = 0;
+    }
+    else
+    {
+        p_sys->i_last_complete = (int64_t)last->i_segment_number - 1;
+        p_sys->i_open_parts = last->i_parts;
+    }
+    p_sys->b_ended = b_isend;
+    vlc_mutex_unlock( &p_sys->lock );
+}
+
 /************************************************************************
  * updateIndexAndDel: If necessary, update index file & delete old segments
  ************************************************************************/
@@ -579,45 +1191,64 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
     // First update index
     if ( p_sys->psz_indexPath )
     {
-        int val;
-        FILE *fp;
-        char *psz_idxTmp;
-        if ( asprintf( &psz_idxTmp, "%s.tmp", p_sys->psz_indexPath ) < 0)
-            return -1;
+        struct vlc_memstream ms;
 
-        fp = vlc_fopen( psz_idxTmp, "wt");
-        if ( !fp )
-        {
-            msg_Err( p_access, "cannot open index file `%s'", psz_idxTmp );
-            free( psz_idxTmp );
+        if ( vlc_memstream_open( &ms ) )
             return -1;
-        }
 
-        if ( fprintf( fp, "#EXTM3U\n#EXT-X-TARGETDURATION:%zu\n#EXT-X-VERSION:3\n#EXT-X-ALLOW-CACHE:%s"
-                          "%s\n#EXT-X-MEDIA-SEQUENCE:%"PRIu32"\n%s", p_sys->i_seglen,
-                          p_sys->b_caching ? "YES" : "NO",
-                          p_sys->i_numsegs > 0 ? "" : b_isend ? "\n#EXT-X-PLAYLIST-TYPE:VOD" : "\n#EXT-X-PLAYLIST-TYPE:EVENT",
-                          i_firstseg, ((p_sys->i_initial_segment > 1) && (p_sys->i_initial_segment == i_firstseg)) ? "#EXT-X-DISCONTINUITY\n" : ""
-                          ) < 0 )
+        /* fMP4 segments need version 7 */
+        vlc_memstream_printf( &ms, "#EXTM3U\n#EXT-X-TARGETDURATION:%zu\n#EXT-X-VERSION:%d\n#EXT-X-ALLOW-CACHE:%s"
+                              "%s\n#EXT-X-MEDIA-SEQUENCE:%"PRIu32"\n", p_sys->i_seglen,
+                              p_sys->b_cmaf ? 7 : 3,
+                              p_sys->b_caching ? "YES" : "NO",
+                              p_sys->i_numsegs > 0 ? "" : b_isend ? "\n#EXT-X-PLAYLIST-TYPE:VOD" : "\n#EXT-X-PLAYLIST-TYPE:EVENT",
+                              i_firstseg );
+
+        if ( p_sys->b_parts && p_sys->f_part_target > .0f )
         {
-            free( psz_idxTmp );
-            fclose( fp );
-            return -1;
+            char *psz_partinf;
+            if ( us_asprintf( &psz_partinf, "#EXT-X-PART-INF:PART-TARGET=%.3f\n"
+                              "#EXT-X-SERVER-CONTROL:%sPART-HOLD-BACK=%.3f\n",
+                              p_sys->f_part_target,
+                              p_sys->b_origin ? "CAN-BLOCK-RELOAD=YES," : "",
+                              3 * p_sys->f_part_target ) < 0 )
+            {
+                if ( !vlc_memstream_close( &ms ) )
+                    free( ms.ptr );
+                return -1;
+            }
+            vlc_memstream_puts( &ms, psz_partinf );
+            free( psz_partinf );
         }
+        else if ( p_sys->b_origin )
+            vlc_memstream_puts( &ms, "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES\n" );
+
+        if ( (p_sys->i_initial_segment > 1) && (p_sys->i_initial_segment == i_firstseg) )
+            vlc_memstream_puts( &ms, "#EXT-X-DISCONTINUITY\n" );
+        if ( p_sys->b_cmaf )
+            vlc_memstream_printf( &ms, "#EXT-X-MAP:URI=\"%s\"\n", p_sys->psz_initUri );
+
         char *psz_current_uri=NULL;
 
+        /* Parts are only listed close to the live edge */
+        float f_remaining = .0f;
+        for ( uint32_t i = i_firstseg; p_sys->b_parts && i <= p_sys->i_segment; i++ )
+        {
+            output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, i - i_firstseg + i_index_offset );
+            f_remaining += segment->psz_duration ? segment->f_seglength : p_sys->f_seglen;
+        }
 
+        output_segment_t *segment = NULL;
         for ( uint32_t i = i_firstseg; i <= p_sys->i_segment; i++ )
         {
             //scale to i_index_offset..numsegs + i_index_offset
             uint32_t index = i - i_firstseg + i_index_offset;
 
-            output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, index );
+            segment = vlc_array_item_at_index( &p_sys->segments_t, index );
             if( p_sys->key_uri &&
                 ( !psz_current_uri ||  strcmp( psz_current_uri, segment->psz_key_uri ) )
               )
             {
-                int ret = 0;
                 free( psz_current_uri );
                 psz_current_uri = strdup( segment->psz_key_uri );
                 if( p_sys->b_generate_iv )
@@ -631,55 +1262,57 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
                         iv_lo <<= 8;
                         iv_lo |= segment->aes_ivs[8+j] & 0xff;
                     }
-                    ret = fprintf( fp, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\",IV=0X%16.16llx%16.16llx\n",
-                                   segment->psz_key_uri, iv_hi, iv_lo );
+                    vlc_memstream_printf( &ms, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\",IV=0X%16.16llx%16.16llx\n",
+                                          segment->psz_key_uri, iv_hi, iv_lo );
 
                 } else {
-                    ret = fprintf( fp, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"\n", segment->psz_key_uri );
+                    vlc_memstream_printf( &ms, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"\n", segment->psz_key_uri );
                 }
-                if( ret < 0 )
+            }
+
+            if( p_sys->b_parts )
+            {
+                f_remaining -= segment->psz_duration ? segment->f_seglength : p_sys->f_seglen;
+                if( f_remaining < (float)( 3 * p_sys->i_seglen ) &&
+                    writeIndexParts( &ms, segment ) < 0 )
                 {
                     free( psz_current_uri );
-                    free( psz_idxTmp );
-                    fclose( fp );
+                    if ( !vlc_memstream_close( &ms ) )
+                        free( ms.ptr );
                     return -1;
                 }
             }
 
-            val = fprintf( fp, "#EXTINF:%s,\n%s\n", segment->psz_duration, segment->psz_uri);
-            if ( val < 0 )
-            {
-                free( psz_current_uri );
-                free( psz_idxTmp );
-                fclose( fp );
-                return -1;
-            }
+            /* The segment being written only has its parts listed */
+            if( !segment->psz_duration )
+                continue;
+
+            vlc_memstream_printf( &ms, "#EXTINF:%s,\n%s\n", segment->psz_duration, segment->psz_uri);
         }
         free( psz_current_uri );
 
-        if ( b_isend )
-        {
-            if ( fputs ( STR_ENDLIST, fp ) < 0)
-            {
-                free( psz_idxTmp );
-                fclose( fp ) ;
-                return -1;
-            }
+        /* The origin can answer a request for the rest of the segment being
+         * written before it is complete */
+        if ( p_sys->b_origin && p_sys->b_parts && !b_isend &&
+             segment && !segment->psz_duration )
+            vlc_memstream_printf( &ms, "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"%s\",BYTERANGE-START=%"PRIu64"\n",
+                                  segment->psz_uri, p_sys->i_segment_size );
 
-        }
-        fclose( fp );
+        if ( b_isend )
+            vlc_memstream_puts( &ms, STR_ENDLIST );
 
-        val = vlc_rename ( psz_idxTmp, p_sys->psz_indexPath);
+        if ( vlc_memstream_close( &ms ) )
+            return -1;
 
-        if ( val < 0 )
+        if ( p_sys->b_origin )
+            publishIndex( p_sys, ms.ptr, ms.length, b_isend );
+        else
         {
-            vlc_unlink( psz_idxTmp );
-            msg_Err( p_access, "Error moving LiveHttp index file" );
+            int val = writeIndexFile( p_access, p_sys, ms.ptr, ms.length );
+            free( ms.ptr );
+            if ( val < 0 )
+                return -1;
         }
-        else
-            msg_Dbg( p_access, "LiveHttpIndexComplete: %s" , p_sys->psz_indexPath );
-
-        free( psz_idxTmp );
     }
 
     // Then take care of deletion
@@ -692,7 +1325,7 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
          msg_Dbg( p_access, "Removing segment number %d", segment->i_segment_number );
          vlc_array_remove( &p_sys->segments_t, 0 );
 
-         if ( segment->psz_filename )
+         if ( segment->psz_filename && !p_sys->b_origin )
          {
              vlc_unlink( segment->psz_filename );
          }
@@ -710,7 +1343,7 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
  *****************************************************************************/
 static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys, bool b_isend )
 {
-    if ( p_sys->i_handle >= 0 )
+    if ( p_sys->b_segment_open )
     {
         output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, vlc_array_count( &p_sys->segments_t ) - 1 );
 
@@ -724,7 +1357,7 @@ static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sy
                msg_Err( p_access, "Couldn't encrypt 16 bytes: %s", gpg_strerror(err) );
             } else {
 
-            int ret = vlc_write( p_sys->i_handle, p_sys->stuffing_bytes, 16 );
+            ssize_t ret = writeData( p_sys, p_sys->i_handle, p_sys->stuffing_bytes, 16 );
             if( ret != 16 )
                 msg_Err( p_access, "Couldn't write 16 bytes" );
             }
@@ -732,8 +1365,17 @@ static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sy
         }
 
 
-        vlc_close( p_sys->i_handle );
+        if ( p_sys->i_handle >= 0 )
+            vlc_close( p_sys->i_handle );
         p_sys->i_handle = -1;
+        p_sys->b_segment_open = false;
+
+        if ( p_sys->b_origin )
+        {
+            vlc_mutex_lock( &p_sys->lock );
+            segment->b_complete = true;
+            vlc_mutex_unlock( &p_sys->lock );
+        }
 
         if( ! ( us_asprintf( &segment->psz_duration, "%.2f", p_sys->f_seglen ) ) )
         {
@@ -762,38 +1404,54 @@ static void Close( vlc_object_t * p_this )
     sout_access_out_t *p_access = (sout_access_out_t*)p_this;
     sout_access_out_sys_t *p_sys = p_access->p_sys;
 
-    if( p_sys->ongoing_segment )
-        block_ChainLastAppend( &p_sys->full_segments_end, p_sys->ongoing_segment );
-    p_sys->ongoing_segment = NULL;
-    p_sys->ongoing_segment_end = &p_sys->ongoing_segment;
+    /* Let the writer thread drain the queue */
+    vlc_fifo_Lock( p_sys->fifo );
+    p_sys->b_closing = true;
+    vlc_fifo_Signal( p_sys->fifo );
+    vlc_fifo_Unlock( p_sys->fifo );
+    vlc_join( p_sys->thread, NULL );
+    block_FifoRelease( p_sys->fifo );
 
-    block_t *output_block = p_sys->full_segments;
-    p_sys->full_segments = NULL;
-    p_sys->full_segments_end = &p_sys->full_segments;
-
-    while( output_block )
+    if( p_sys->b_cmaf )
     {
-        block_t *p_next = output_block->p_next;
-        output_block->p_next = NULL;
-
-        Write( p_access, output_block );
-        output_block = p_next;
+        if( writeFragment( p_access, p_sys ) < 0 )
+            msg_Err( p_access, "Error writing the last fragment" );
     }
-    if( p_sys->ongoing_segment )
+    else
     {
-        block_ChainLastAppend( &p_sys->full_segments_end, p_sys->ongoing_segment );
+        if( p_sys->ongoing_segment )
+            block_ChainLastAppend( &p_sys->full_segments_end, p_sys->ongoing_segment );
         p_sys->ongoing_segment = NULL;
         p_sys->ongoing_segment_end = &p_sys->ongoing_segment;
-    }
 
-    ssize_t writevalue = writeSegment( p_access );
-    msg_Dbg( p_access, "Writing.. %zd", writevalue );
-    if( unlikely( writevalue < 0 ) )
-    {
-        if( p_sys->full_segments )
-            block_ChainRelease( p_sys->full_segments );
+        block_t *output_block = p_sys->full_segments;
+        p_sys->full_segments = NULL;
+        p_sys->full_segments_end = &p_sys->full_segments;
+
+        while( output_block )
+        {
+            block_t *p_next = output_block->p_next;
+            output_block->p_next = NULL;
+
+            WriteBlocks( p_access, output_block );
+            output_block = p_next;
+        }
         if( p_sys->ongoing_segment )
-            block_ChainRelease( p_sys->ongoing_segment );
+        {
+            block_ChainLastAppend( &p_sys->full_segments_end, p_sys->ongoing_segment );
+            p_sys->ongoing_segment = NULL;
+            p_sys->ongoing_segment_end = &p_sys->ongoing_segment;
+        }
+
+        ssize_t writevalue = writeSegment( p_access );
+        msg_Dbg( p_access, "Writing.. %zd", writevalue );
+        if( unlikely( writevalue < 0 ) )
+        {
+            if( p_sys->full_segments )
+                block_ChainRelease( p_sys->full_segments );
+            if( p_sys->ongoing_segment )
+                block_ChainRelease( p_sys->ongoing_segment );
+        }
     }
 
     closeCurrentSegment( p_access, p_sys, true );
@@ -808,7 +1466,8 @@ static void Close( vlc_object_t * p_this )
     {
         output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, 0 );
         vlc_array_remove( &p_sys->segments_t, 0 );
-        if( p_sys->b_delsegs && p_sys->i_numsegs && segment->psz_filename )
+        if( p_sys->b_delsegs && p_sys->i_numsegs && segment->psz_filename &&
+            !p_sys->b_origin )
         {
             msg_Dbg( p_access, "Removing segment number %d name %s", segment->i_segment_number, segment->psz_filename );
             vlc_unlink( segment->psz_filename );
@@ -817,6 +1476,13 @@ static void Close( vlc_object_t * p_this )
         destroySegment( segment );
     }
 
+    if( p_sys->b_origin )
+        OriginClose( p_sys );
+    else if( p_sys->psz_initPath && p_sys->b_delsegs && p_sys->i_numsegs )
+        vlc_unlink( p_sys->psz_initPath );
+
+    free( p_sys->psz_initPath );
+    free( p_sys->psz_initUri );
     free( p_sys->psz_indexUrl );
     free( p_sys->psz_indexPath );
     free( p_sys );
@@ -849,7 +1515,7 @@ static int Control( sout_access_out_t *p_access, int i_query, va_list args )
  *****************************************************************************/
 static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys )
 {
-    int fd;
+    int fd = -1;
 
     uint32_t i_newseg = p_sys->i_segment + 1;
 
@@ -859,8 +1525,8 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
         return -1;
 
     segment->i_segment_number = i_newseg;
-    segment->psz_filename = formatSegmentPath( p_access->psz_path, i_newseg );
-    char *psz_idxFormat = p_sys->psz_indexUrl ? p_sys->psz_indexUrl : p_access->psz_path;
+    segment->psz_filename = formatSegmentPath( p_sys->psz_path, i_newseg );
+    const char *psz_idxFormat = p_sys->psz_indexUrl ? p_sys->psz_indexUrl : p_sys->psz_path;
     segment->psz_uri = formatSegmentPath( psz_idxFormat , i_newseg );
 
     if ( unlikely( !segment->psz_filename ) )
@@ -870,9 +1536,22 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
         return -1;
     }
 
-    fd = vlc_open( segment->psz_filename, O_WRONLY | O_CREAT | O_LARGEFILE |
-                     O_TRUNC, 0666 );
-    if ( fd == -1 )
+    if ( p_sys->b_origin )
+    {
+        segment->p_sys = p_sys;
+        segment->p_url = httpd_UrlNew( p_sys->p_httpd_host, segment->psz_filename,
+                                       NULL, NULL );
+        if ( !segment->p_url )
+        {
+            msg_Err( p_access, "cannot serve `%s'", segment->psz_filename );
+            destroySegment( segment );
+            return -1;
+        }
+        httpd_UrlCatch( segment->p_url, HTTPD_MSG_GET, SegmentCallback,
+                        (httpd_callback_sys_t *)segment );
+    }
+    else if ( ( fd = vlc_open( segment->psz_filename, O_WRONLY | O_CREAT | O_LARGEFILE |
+                               O_TRUNC, 0666 ) ) == -1 )
     {
         msg_Err( p_access, "cannot open `%s' (%s)", segment->psz_filename,
                  vlc_strerror_c(errno) );
@@ -898,9 +1577,12 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
 
     p_sys->psz_cursegPath = strdup(segment->psz_filename);
     p_sys->i_handle = fd;
+    p_sys->b_segment_open = true;
     p_sys->i_segment = i_newseg;
     p_sys->b_segment_has_data = false;
-    return fd;
+    p_sys->i_segment_size = 0;
+    p_sys->f_seglen = .0f;
+    return 0;
 }
 /*****************************************************************************
  * CheckSegmentChange: Check if segment needs to be closed and new opened
@@ -910,7 +1592,7 @@ static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer )
     sout_access_out_sys_t *p_sys = p_access->p_sys;
     ssize_t writevalue = 0;
 
-    if( p_sys->i_handle > 0 && p_sys->b_segment_has_data &&
+    if( p_sys->b_segment_open && p_sys->b_segment_has_data &&
        (( p_buffer->i_length + p_buffer->i_dts - p_sys->i_opendts ) >= p_sys->i_seglenm ) )
     {
         writevalue = writeSegment( p_access );
@@ -923,7 +1605,7 @@ static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer )
         return writevalue;
     }
 
-    if ( unlikely( p_sys->i_handle < 0 ) )
+    if ( unlikely( !p_sys->b_segment_open ) )
     {
         p_sys->i_opendts = p_buffer->i_dts;
 
@@ -941,6 +1623,39 @@ static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer )
     return writevalue;
 }
 
+/*****************************************************************************
+ * writeData: write to the segment file, or append to the segment in memory
+ * when there is no file (origin mode)
+ *****************************************************************************/
+static ssize_t writeData( sout_access_out_sys_t *p_sys, int fd,
+                          const void *p_data, size_t i_data )
+{
+    if( fd >= 0 )
+        return vlc_write( fd, p_data, i_data );
+
+    output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t,
+                                    vlc_array_count( &p_sys->segments_t ) - 1 );
+
+    vlc_mutex_lock( &p_sys->lock );
+    if( segment->i_alloc - segment->i_data < i_data )
+    {
+        size_t i_alloc = __MAX( 2 * segment->i_alloc, segment->i_data + i_data );
+        uint8_t *p_realloc = realloc( segment->p_data, i_alloc );
+        if( unlikely( !p_realloc ) )
+        {
+            vlc_mutex_unlock( &p_sys->lock );
+            errno = ENOMEM;
+            return -1;
+        }
+        segment->p_data = p_realloc;
+        segment->i_alloc = i_alloc;
+    }
+    memcpy( &segment->p_data[segment->i_data], p_data, i_data );
+    segment->i_data += i_data;
+    vlc_mutex_unlock( &p_sys->lock );
+    return i_data;
+}
+
 static ssize_t writeSegment( sout_access_out_t *p_access )
 {
     sout_access_out_sys_t *p_sys = p_access->p_sys;
@@ -990,7 +1705,7 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
 
         }
 
-        ssize_t val = vlc_write( p_sys->i_handle, output->p_buffer, output->i_buffer );
+        ssize_t val = writeData( p_sys, p_sys->i_handle, output->p_buffer, output->i_buffer );
         if ( val == -1 )
         {
            if ( errno == EINTR )
@@ -1020,12 +1735,254 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
 }
 
 /*****************************************************************************
- * Write: standard write on a file descriptor.
+ * writeChain: write and release a chain of blocks
  *****************************************************************************/
-static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
+static ssize_t writeChain( sout_access_out_sys_t *p_sys, int fd, block_t *p_chain )
+{
+    ssize_t i_write = 0;
+
+    while( p_chain )
+    {
+        ssize_t val = writeData( p_sys, fd, p_chain->p_buffer, p_chain->i_buffer );
+        if ( val == -1 )
+        {
+           if ( errno == EINTR )
+              continue;
+           block_ChainRelease( p_chain );
+           return -1;
+        }
+
+        if ( (size_t)val >= p_chain->i_buffer )
+        {
+           block_t *p_next = p_chain->p_next;
+           block_Release( p_chain );
+           p_chain = p_next;
+        }
+        else
+        {
+           p_chain->p_buffer += val;
+           p_chain->i_buffer -= val;
+        }
+        i_write += val;
+    }
+    return i_write;
+}
+
+/*****************************************************************************
+ * writeInitSegment: write the fMP4 header as the initialization segment
+ *****************************************************************************/
+static int writeInitSegment( sout_access_out_t *p_access, block_t *p_header )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    char *psz_initTmp;
+
+    if ( p_sys->b_origin )
+    {
+        block_t *p_init = block_ChainGather( p_header );
+        if ( unlikely( !p_init ) )
+            return -1;
+
+        vlc_mutex_lock( &p_sys->lock );
+        block_t *p_old = p_sys->p_init;
+        p_sys->p_init = p_init;
+        vlc_mutex_unlock( &p_sys->lock );
+        if ( p_old )
+            block_Release( p_old );
+        msg_Dbg( p_access, "LiveHttpInitComplete: %s", p_sys->psz_initPath );
+        return 0;
+    }
+
+    if ( asprintf( &psz_initTmp, "%s.tmp", p_sys->psz_initPath ) < 0 )
+    {
+        block_Release( p_header );
+        return -1;
+    }
+
+    /* Write aside and rename, so that clients never fetch a partial header */
+    int fd = vlc_open( psz_initTmp, O_WRONLY | O_CREAT | O_TRUNC, 0666 );
+    if ( fd == -1 )
+    {
+        msg_Err( p_access, "cannot open `%s' (%s)", psz_initTmp,
+                 vlc_strerror_c(errno) );
+        free( psz_initTmp );
+        block_Release( p_header );
+        return -1;
+    }
+
+    ssize_t val = writeChain( p_sys, fd, p_header );
+    vlc_close( fd );
+    if ( val < 0 || vlc_rename( psz_initTmp, p_sys->psz_initPath ) < 0 )
+    {
+        msg_Err( p_access, "cannot write initialization segment `%s'",
+                 p_sys->psz_initPath );
+        vlc_unlink( psz_initTmp );
+        free( psz_initTmp );
+        return -1;
+    }
+    msg_Dbg( p_access, "LiveHttpInitComplete: %s", p_sys->psz_initPath );
+    free( psz_initTmp );
+    return 0;
+}
+
+/*****************************************************************************
+ * isIndependentFragment: check that the moof starts on sync samples
+ *****************************************************************************/
+static bool isIndependentFragment( const block_t *p_moof )
+{
+    const uint8_t *p_box = p_moof->p_buffer;
+    const uint8_t *p_end = p_box + p_moof->i_buffer;
+
+    if( p_moof->i_buffer < 8 || memcmp( &p_box[4], "moof", 4 ) )
+        return true;
+
+    /* mp4frag only signals the first sample flags of a run when that
+     * sample is not a sync sample */
+    p_box += 8;
+    while( p_end - p_box >= 8 )
+    {
+        uint32_t i_size = GetDWBE( p_box );
+        if( i_size < 8 || i_size > (size_t)(p_end - p_box) )
+            break;
+
+        if( !memcmp( &p_box[4], "traf", 4 ) )
+        {
+            const uint8_t *p_traf_end = p_box + i_size;
+            const uint8_t *p_child = p_box + 8;
+            while( p_traf_end - p_child >= 8 )
+            {
+                uint32_t i_child_size = GetDWBE( p_child );
+                if( i_child_size < 8 || i_child_size > (size_t)(p_traf_end - p_child) )
+                    break;
+
+                if( !memcmp( &p_child[4], "trun", 4 ) && i_child_size >= 16 )
+                {
+                    uint32_t i_flags = GetDWBE( &p_child[8] ) & 0xFFFFFF;
+                    size_t i_offset = 16 + ( ( i_flags & 0x1 ) ? 4 : 0 );
+                    if( ( i_flags & 0x4 ) && i_offset + 4 <= i_child_size &&
+                        ( GetDWBE( &p_child[i_offset] ) & 0x10000 ) )
+                        return false;
+                }
+                p_child += i_child_size;
+            }
+        }
+        p_box += i_size;
+    }
+    return true;
+}
+
+/*****************************************************************************
+ * writeFragment: append the pending fMP4 fragment to the segment
+ *****************************************************************************/
+static ssize_t writeFragment( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys )
+{
+    block_t *p_fragment = p_sys->ongoing_segment;
+    if( !p_fragment )
+        return 0;
+
+    p_sys->ongoing_segment = NULL;
+    p_sys->ongoing_segment_end = &p_sys->ongoing_segment;
+
+    /* mp4frag timestamps the moof with the span of the whole fragment */
+    const float f_duration = (float)p_fragment->i_length / CLOCK_FREQ;
+    const bool b_independent = isIndependentFragment( p_fragment );
+
+    if( p_sys->b_segment_open && b_independent &&
+        p_sys->f_seglen >= (float)p_sys->i_seglen )
+        closeCurrentSegment( p_access, p_sys, false );
+
+    if( !p_sys->b_segment_open )
+    {
+        p_sys->i_opendts = p_fragment->i_dts;
+        msg_Dbg( p_access, "Setting new opendts %"PRId64, p_sys->i_opendts );
+
+        if ( openNextFile( p_access, p_sys ) < 0 )
+        {
+            block_ChainRelease( p_fragment );
+            return -1;
+        }
+    }
+
+    ssize_t i_size = writeChain( p_sys, p_sys->i_handle, p_fragment );
+    if( i_size < 0 )
+    {
+        msg_Err( p_access, "cannot write to `%s' (%s)", p_sys->psz_cursegPath,
+                 vlc_strerror_c(errno) );
+        return -1;
+    }
+
+    if( p_sys->b_parts )
+    {
+        output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, vlc_array_count( &p_sys->segments_t ) - 1 );
+        output_part_t *p_parts = realloc( segment->p_parts,
+                                          ( segment->i_parts + 1 ) * sizeof( *p_parts ) );
+        if( unlikely( !p_parts ) )
+            return -1;
+        p_parts[segment->i_parts++] = (output_part_t) {
+            .f_duration = f_duration,
+            .i_offset = p_sys->i_segment_size,
+            .i_size = i_size,
+            .b_independent = b_independent,
+        };
+        segment->p_parts = p_parts;
+        p_sys->f_part_target = __MAX( p_sys->f_part_target, f_duration );
+    }
+    p_sys->i_segment_size += i_size;
+    p_sys->f_seglen += f_duration;
+
+    /* Publish the part right away */
+    if( p_sys->b_parts )
+        updateIndexAndDel( p_access, p_sys, false );
+
+    return i_size;
+}
+
+/*****************************************************************************
+ * WriteFragments: cut fMP4 segments on the fragments of the muxer
+ *****************************************************************************/
+static ssize_t WriteFragments( sout_access_out_t *p_access, block_t *p_buffer )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    ssize_t i_write = 0;
+
+    while( p_buffer )
+    {
+        block_t *p_temp = p_buffer->p_next;
+        p_buffer->p_next = NULL;
+
+        if( p_buffer->i_flags & BLOCK_FLAG_HEADER )
+        {
+            writeInitSegment( p_access, p_buffer );
+        }
+        else
+        {
+            /* Each moof starts a new fragment */
+            if( p_buffer->i_flags & BLOCK_FLAG_TYPE_I )
+            {
+                ssize_t ret = writeFragment( p_access, p_sys );
+                if( ret < 0 )
+                    msg_Err( p_access, "Error in write loop");
+                else
+                    i_write += ret;
+            }
+            block_ChainLastAppend( &p_sys->ongoing_segment_end, p_buffer );
+        }
+        p_buffer = p_temp;
+    }
+
+    return i_write;
+}
+
+/*****************************************************************************
+ * WriteBlocks: split the stream into segments, on the writer thread
+ *****************************************************************************/
+static ssize_t WriteBlocks( sout_access_out_t *p_access, block_t *p_buffer )
 {
     size_t i_write = 0;
     sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    if( p_sys->b_cmaf )
+        return WriteFragments( p_access, p_buffer );
+
     while( p_buffer )
     {
         /* Check if current block is already past segment-length
@@ -1056,3 +2013,41 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
 
     return i_write;
 }
+
+static void *WriterThread( void *data )
+{
+    sout_access_out_t *p_access = data;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    vlc_fifo_t *fifo = p_sys->fifo;
+
+    vlc_fifo_Lock( fifo );
+    for( ;; )
+    {
+        while( vlc_fifo_IsEmpty( fifo ) && !p_sys->b_closing )
+            vlc_fifo_Wait( fifo );
+
+        block_t *p_chain = vlc_fifo_DequeueAllUnlocked( fifo );
+        if( p_chain == NULL )
+            break;
+        vlc_fifo_Unlock( fifo );
+
+        WriteBlocks( p_access, p_chain );
+
+        vlc_fifo_Lock( fifo );
+    }
+    vlc_fifo_Unlock( fifo );
+    return NULL;
+}
+
+/*****************************************************************************
+ * Write: hand the blocks over to the writer thread
+ *****************************************************************************/
+static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    size_t i_write;
+
+    block_ChainProperties( p_buffer, NULL, &i_write, NULL );
+    vlc_fifo_Queue( p_sys->fifo, p_buffer );
+    return i_write;
+}
@@ -24,7 +24,6 @@
 
 #include <srt_common.h>
 
-#include <vlc_interrupt.h>
 #include <vlc_fs.h>
 #include <vlc_plugin.h>
 #include <vlc_sout.h>
@@ -32,35 +31,22 @@
 #include <vlc_block_helper.h>
 #include <vlc_network.h>
 
+#define SRT_PARAM_SEND_DELAY "send-delay"
+
 typedef struct sout_access_out_sys_t
 {
     SRTSOCKET     sock;
     int           i_poll_id;
-    bool          b_interrupted;
+    int           i_poll_timeout;
+    bool          b_closing;
     vlc_mutex_t   lock;
     int           i_payload_size;
+    vlc_tick_t    i_send_delay;
     block_bytestream_t block_stream;
+    block_fifo_t *p_fifo;
+    vlc_thread_t  thread;
 } sout_access_out_sys_t;
 
-static void srt_wait_interrupted(void *p_data)
-{
-    sout_access_out_t *p_access = p_data;
-    sout_access_out_sys_t *p_sys = p_access->p_sys;
-
-    vlc_mutex_lock( &p_sys->lock );
-    if ( p_sys->i_poll_id >= 0 &&  p_sys->sock != SRT_INVALID_SOCK )
-    {
-        p_sys->b_interrupted = true;
-
-        msg_Dbg( p_access, "Waking up srt_epoll_wait");
-
-        /* Removing all socket descriptors from the monitoring list
-         * wakes up SRT's threads. We only have one to remove. */
-        srt_epoll_remove_usock( p_sys->i_poll_id, p_sys->sock );
-    }
-    vlc_mutex_unlock( &p_sys->lock );
-}
-
 static bool srt_schedule_reconnect(sout_access_out_t *p_access)
 {
     vlc_object_t *access_obj = (vlc_object_t *) p_access;
@@ -121,7 +107,7 @@ static bool srt_schedule_reconnect(sout_access_out_t *p_access)
         srt_close( p_sys->sock );
     }
 
-    p_sys->sock = srt_socket( res->ai_family, SOCK_DGRAM, 0 );
+    p_sys->sock = srt_open_socket( access_obj, res->ai_family );
     if ( p_sys->sock == SRT_INVALID_SOCK )
     {
         msg_Err( p_access, "Failed to open socket." );
@@ -210,7 +196,8 @@ static bool srt_schedule_reconnect(sout_access_out_t *p_access)
     msg_Dbg( p_access, "Schedule SRT connect (dest address: %s, port: %d).",
         psz_dst_addr, i_dst_port );
 
-    stat = srt_connect( p_sys->sock, res->ai_addr, res->ai_addrlen );
+    stat = srt_connect_links( access_obj, p_sys->sock,
+                              res->ai_addr, res->ai_addrlen );
     if ( stat == SRT_ERROR )
     {
         msg_Err( p_access, "Failed to connect to server (reason: %s)",
@@ -237,37 +224,32 @@ out:
     return !failed;
 }
 
-static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
+/* Returns true if Close() is waiting for the send thread */
+static bool srt_closing( sout_access_out_sys_t *p_sys )
+{
+    vlc_mutex_lock( &p_sys->lock );
+    bool b_closing = p_sys->b_closing;
+    vlc_mutex_unlock( &p_sys->lock );
+    return b_closing;
+}
+
+/**
+ * Sends all the complete chunks of the byte stream, and the remaining bytes
+ * too unless more data is expected. Each time the socket is writable, as
+ * many chunks as the SRT send buffer accepts are sent.
+ */
+static void SendChunks( sout_access_out_t *p_access, bool b_flush )
 {
     sout_access_out_sys_t *p_sys = p_access->p_sys;
-    int i_poll_timeout = var_InheritInteger( p_access, SRT_PARAM_POLL_TIMEOUT );
-    bool b_interrupted = false;
-    ssize_t i_len = 0;
-    int chunk_size;
     uint8_t chunk[SRT_LIVE_MAX_PLSIZE];
 
-    if ( p_buffer == NULL )
-        return 0;
-    block_BytestreamPush( &p_sys->block_stream, p_buffer );
-
-    vlc_interrupt_register( srt_wait_interrupted, p_access);
-
-    while( true )
+    for (;;)
     {
-        /* We can leave the remaining bytes less than i_payload_size for next
-         * Write() round, but it will add delay.
-         */
-        chunk_size = __MIN( block_BytestreamRemaining( &p_sys->block_stream ),
-                            p_sys->i_payload_size );
-        if ( chunk_size == 0 )
-            break;
-
-        if ( vlc_killed() )
-        {
-            /* We are told to stop. Stop. */
-            i_len = VLC_EGENERIC;
-            goto out;
-        }
+        size_t i_remaining = block_BytestreamRemaining( &p_sys->block_stream );
+        int chunk_size = __MIN( i_remaining, (size_t)p_sys->i_payload_size );
+        if ( chunk_size == 0
+         || ( chunk_size < p_sys->i_payload_size && !b_flush ) )
+            return;
 
         switch( srt_getsockstate( p_sys->sock ) )
         {
@@ -278,87 +260,103 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
             case SRTS_NONEXIST:
             case SRTS_CLOSED:
                 /* Failed. Schedule recovery. */
-                if ( !srt_schedule_reconnect( p_access ) )
+                vlc_mutex_lock( &p_sys->lock );
+                if ( !p_sys->b_closing && !srt_schedule_reconnect( p_access ) )
                     msg_Err( p_access, "Failed to schedule connect");
+                vlc_mutex_unlock( &p_sys->lock );
                 /* Fall-through */
             default:
                 /* Not ready */
-                i_len = VLC_EGENERIC;
-                goto out;
+                block_BytestreamEmpty( &p_sys->block_stream );
+                return;
         }
 
         SRTSOCKET ready[1];
         int readycnt = 1;
         if ( srt_epoll_wait( p_sys->i_poll_id,
             0, 0, &ready[0], &readycnt,
-            i_poll_timeout, NULL, 0, NULL, 0 ) < 0)
+            p_sys->i_poll_timeout, NULL, 0, NULL, 0 ) < 0 )
         {
-            if ( vlc_killed() )
-            {
-                /* We are told to stop. Stop. */
-                i_len = VLC_EGENERIC;
-                goto out;
-            }
-
-            /* if 'srt_epoll_wait' is interrupted, we still need to
-            *  finish sending current block or it may be sent only
-            *  partially. TODO: this delay can be prevented,
-            *  possibly with a FIFO and an additional thread.
-            */
-            vlc_mutex_lock( &p_sys->lock );
-            if ( p_sys->b_interrupted )
-            {
-                srt_epoll_add_usock( p_sys->i_poll_id, p_sys->sock,
-                    &(int) { SRT_EPOLL_ERR | SRT_EPOLL_OUT });
-                p_sys->b_interrupted = false;
-                b_interrupted = true;
-            }
-            vlc_mutex_unlock( &p_sys->lock );
-
-            if ( !b_interrupted )
-            {
-                continue;
-            }
-            else
-            {
-                msg_Dbg( p_access, "srt_epoll_wait was interrupted");
-            }
+            /* Close() removes the socket from the poll to wake us up */
+            if ( srt_closing( p_sys ) )
+                return;
+            continue;
         }
 
-        if ( readycnt > 0  && ready[0] == p_sys->sock
-            && srt_getsockstate( p_sys->sock ) == SRTS_CONNECTED)
+        if ( readycnt <= 0 || ready[0] != p_sys->sock )
+            continue;
+
+        /* Fill the SRT send buffer as much as possible */
+        while ( chunk_size > 0
+             && ( chunk_size == p_sys->i_payload_size || b_flush ) )
         {
-            if ( block_GetBytes( &p_sys->block_stream, chunk,
-                                 chunk_size ) != VLC_SUCCESS )
-                break;
-            if (srt_sendmsg2( p_sys->sock,
+            block_PeekBytes( &p_sys->block_stream, chunk, chunk_size );
+            if ( srt_sendmsg2( p_sys->sock,
                 (char *)chunk, chunk_size, 0 ) == SRT_ERROR )
             {
+                if ( srt_getlasterror( NULL ) == SRT_EASYNCSND )
+                    break; /* send buffer full, wait again */
+
                 msg_Warn( p_access, "send error: %s", srt_getlasterror_str() );
-                i_len = VLC_EGENERIC;
-                goto out;
-            }
-            else
-            {
-                i_len += chunk_size;
+                block_BytestreamEmpty( &p_sys->block_stream );
+                return;
             }
+            block_SkipBytes( &p_sys->block_stream, chunk_size );
+
+            i_remaining -= chunk_size;
+            chunk_size = __MIN( i_remaining, (size_t)p_sys->i_payload_size );
         }
+        block_BytestreamFlush( &p_sys->block_stream );
     }
+}
 
-out:
-    block_BytestreamEmpty( &p_sys->block_stream );
-    vlc_interrupt_unregister();
+/*****************************************************************************
+ * Thread: sends queued blocks, optionally paced on their DTS
+ *****************************************************************************/
+static void *Thread( void *data )
+{
+    sout_access_out_t *p_access = data;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
 
-    /* Re-add the socket to the poll if we were interrupted */
-    vlc_mutex_lock( &p_sys->lock );
-    if ( p_sys->b_interrupted )
+    for (;;)
     {
-        srt_epoll_add_usock( p_sys->i_poll_id, p_sys->sock,
-            &(int) { SRT_EPOLL_ERR | SRT_EPOLL_OUT } );
-        p_sys->b_interrupted = false;
+        block_t *p_block = block_FifoGet( p_sys->p_fifo );
+
+        if ( p_sys->i_send_delay >= 0 && p_block->i_dts != VLC_TICK_INVALID )
+        {
+            block_cleanup_push( p_block );
+            mwait( p_block->i_dts + p_sys->i_send_delay );
+            vlc_cleanup_pop();
+        }
+
+        int canc = vlc_savecancel();
+        block_BytestreamPush( &p_sys->block_stream, p_block );
+
+        /* Queued data is sent along in full chunks. A partial chunk is only
+         * sent when nothing else is pending, to avoid adding delay. */
+        vlc_fifo_Lock( p_sys->p_fifo );
+        bool b_flush = vlc_fifo_IsEmpty( p_sys->p_fifo );
+        vlc_fifo_Unlock( p_sys->p_fifo );
+        SendChunks( p_access, b_flush );
+        vlc_restorecancel( canc );
     }
-    vlc_mutex_unlock( &p_sys->lock );
+    return NULL;
+}
+
+static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    ssize_t i_len = 0;
+
+    while ( p_buffer != NULL )
+    {
+        block_t *p_next = p_buffer->p_next;
 
+        p_buffer->p_next = NULL;
+        i_len += p_buffer->i_buffer;
+        block_FifoPut( p_sys->p_fifo, p_buffer );
+        p_buffer = p_next;
+    }
     return i_len;
 }
 
@@ -404,6 +402,12 @@ static int Open( vlc_object_t *p_this )
 
     vlc_mutex_init( &p_sys->lock );
     block_BytestreamInit( &p_sys->block_stream );
+    p_sys->sock = SRT_INVALID_SOCK;
+    p_sys->i_poll_timeout = var_InheritInteger( p_access,
+                                                SRT_PARAM_POLL_TIMEOUT );
+    int i_send_delay = var_InheritInteger( p_access, SRT_PARAM_SEND_DELAY );
+    p_sys->i_send_delay = ( i_send_delay >= 0 )
+                        ? i_send_delay * INT64_C(1000) : -1;
 
     p_access->p_sys = p_sys;
 
@@ -423,6 +427,18 @@ static int Open( vlc_object_t *p_this )
         goto failed;
     }
 
+    p_sys->p_fifo = block_FifoNew();
+    if ( unlikely( p_sys->p_fifo == NULL ) )
+        goto failed;
+
+    if ( vlc_clone( &p_sys->thread, Thread, p_access,
+                    VLC_THREAD_PRIORITY_HIGHEST ) )
+    {
+        msg_Err( p_access, "cannot spawn sout access thread" );
+        block_FifoRelease( p_sys->p_fifo );
+        goto failed;
+    }
+
     p_access->pf_write = Write;
     p_access->pf_control = Control;
 
@@ -431,8 +447,9 @@ static int Open( vlc_object_t *p_this )
 failed:
     vlc_mutex_destroy( &p_sys->lock );
 
-    if ( p_sys->sock != -1 ) srt_close( p_sys->sock );
+    if ( p_sys->sock != SRT_INVALID_SOCK ) srt_close( p_sys->sock );
     if ( p_sys->i_poll_id != -1 ) srt_epoll_release( p_sys->i_poll_id );
+    srt_cleanup();
 
     return VLC_EGENERIC;
 }
@@ -442,9 +459,18 @@ static void Close( vlc_object_t * p_this )
     sout_access_out_t     *p_access = (sout_access_out_t*)p_this;
     sout_access_out_sys_t *p_sys = p_access->p_sys;
 
+    /* Removing the socket from the poll wakes the send thread up */
+    vlc_mutex_lock( &p_sys->lock );
+    p_sys->b_closing = true;
+    srt_epoll_remove_usock( p_sys->i_poll_id, p_sys->sock );
+    vlc_mutex_unlock( &p_sys->lock );
+
+    vlc_cancel( p_sys->thread );
+    vlc_join( p_sys->thread, NULL );
+    block_FifoRelease( p_sys->p_fifo );
+
     vlc_mutex_destroy( &p_sys->lock );
 
-    srt_epoll_remove_usock( p_sys->i_poll_id, p_sys->sock );
     srt_close( p_sys->sock );
     srt_epoll_release( p_sys->i_poll_id );
     block_BytestreamRelease( &p_sys->block_stream );
@@ -479,6 +505,19 @@ vlc_module_begin()
     add_string(SRT_PARAM_STREAMID, "",
             N_(" SRT Stream ID"), NULL, false)
     change_safe()
+    add_integer( SRT_PARAM_SEND_DELAY, -1,
+            N_( "Send delay (ms)" ),
+            N_( "If not negative, each block is sent this long after its "
+                "decoding timestamp, spreading the output over time. "
+                "Otherwise, blocks are sent as soon as they are written." ),
+            true )
+#ifdef SRT_HAS_GROUPS
+    add_string( SRT_PARAM_GROUP_TYPE, "", SRT_GROUP_TYPE_TEXT,
+            SRT_GROUP_TYPE_LONGTEXT, true )
+    change_string_list( srt_group_types, srt_group_type_names )
+    add_string( SRT_PARAM_GROUP_LINKS, "", SRT_GROUP_LINKS_TEXT,
+            SRT_GROUP_LINKS_LONGTEXT, true )
+#endif
 
     set_capability( "sout access", 0 )
     add_shortcut( "srt" )
@@ -46,11 +46,19 @@
 #else
 #   include <sys/socket.h>
 #endif
+#ifdef HAVE_SENDMMSG
+#   include <sys/uio.h>
+#   include <netinet/in.h>
+#   include <netinet/udp.h>
+#endif
 
 #include <vlc_network.h>
 
 #define MAX_EMPTY_BLOCKS 200
 
+/* Kernel limit of segments per UDP GSO send */
+#define MAX_GSO_SEGMENTS 64
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -71,6 +79,19 @@ static void Close( vlc_object_t * );
                           "helps reducing the scheduling load on " \
                           "heavily-loaded systems." )
 
+#define BATCH_TEXT N_("Packets per send batch")
+#define BATCH_LONGTEXT N_("Maximum number of packets sent with a single " \
+                          "system call. Packets due within the batch " \
+                          "window are sent together at the deadline of " \
+                          "the first one. 1 disables batching." )
+#define BATCH_WINDOW_TEXT N_("Send batch window (ms)")
+#define BATCH_WINDOW_LONGTEXT N_("Packets due within this delay after the " \
+                                 "first packet of a batch are sent along " \
+                                 "with it." )
+#define GSO_TEXT N_("UDP segmentation offload")
+#define GSO_LONGTEXT N_("Let the kernel split batches of equally sized " \
+                        "packets (UDP GSO), if supported." )
+
 vlc_module_begin ()
     set_description( N_("UDP stream output") )
     set_shortname( "UDP" )
@@ -79,6 +100,13 @@ vlc_module_begin ()
     add_integer( SOUT_CFG_PREFIX "caching", DEFAULT_PTS_DELAY / 1000, CACHING_TEXT, CACHING_LONGTEXT, true )
     add_integer( SOUT_CFG_PREFIX "group", 1, GROUP_TEXT, GROUP_LONGTEXT,
                                  true )
+#ifdef HAVE_SENDMMSG
+    add_integer_with_range( SOUT_CFG_PREFIX "batch", 1, 1, 1024,
+                            BATCH_TEXT, BATCH_LONGTEXT, true )
+    add_integer( SOUT_CFG_PREFIX "batch-window", 1, BATCH_WINDOW_TEXT,
+                 BATCH_WINDOW_LONGTEXT, true )
+    add_bool( SOUT_CFG_PREFIX "gso", true, GSO_TEXT, GSO_LONGTEXT, true )
+#endif
 
     set_capability( "sout access", 0 )
     add_shortcut( "udp" )
@@ -92,6 +120,9 @@ vlc_module_end ()
 static const char *const ppsz_sout_options[] = {
     "caching",
     "group",
+    "batch",
+    "batch-window",
+    "gso",
     NULL
 };
 
@@ -107,6 +138,9 @@ static ssize_t Write   ( sout_access_out_t *, block_t * );
 static int Control( sout_access_out_t *, int, va_list );
 
 static void* ThreadWrite( void * );
+#ifdef HAVE_SENDMMSG
+static void* ThreadWriteBatch( void * );
+#endif
 static block_t *NewUDPPacket( sout_access_out_t *, vlc_tick_t );
 
 struct sout_access_out_sys_t
@@ -120,6 +154,12 @@ struct sout_access_out_sys_t
     block_fifo_t *p_empty_blocks;
     block_t      *p_buffer;
 
+#ifdef HAVE_SENDMMSG
+    unsigned      i_batch;
+    vlc_tick_t    i_batch_window;
+    bool          b_gso;
+#endif
+
     vlc_thread_t  thread;
 };
 
@@ -213,7 +253,29 @@ static int Open( vlc_object_t *p_this )
     p_sys->p_empty_blocks = block_FifoNew();
     p_sys->p_buffer = NULL;
 
-    if( vlc_clone( &p_sys->thread, ThreadWrite, p_access,
+    void *(*entry)( void * ) = ThreadWrite;
+#ifdef HAVE_SENDMMSG
+    p_sys->i_batch = var_GetInteger( p_access, SOUT_CFG_PREFIX "batch" );
+    p_sys->i_batch_window = UINT64_C(1000)
+                   * var_GetInteger( p_access, SOUT_CFG_PREFIX "batch-window" );
+    p_sys->b_gso = false;
+    if( p_sys->i_batch > 1 )
+    {
+        entry = ThreadWriteBatch;
+# ifdef UDP_SEGMENT
+        /* Probe for kernel support: a zero size disables segmentation */
+        int val = 0;
+        if( var_GetBool( p_access, SOUT_CFG_PREFIX "gso" )
+         && setsockopt( i_handle, IPPROTO_UDP, UDP_SEGMENT,
+                        &val, sizeof (val) ) == 0 )
+            p_sys->b_gso = true;
+# endif
+        msg_Dbg( p_access, "sending up to %u packets per batch%s",
+                 p_sys->i_batch, p_sys->b_gso ? " with GSO" : "" );
+    }
+#endif
+
+    if( vlc_clone( &p_sys->thread, entry, p_access,
                            VLC_THREAD_PRIORITY_HIGHEST ) )
     {
         msg_Err( p_access, "cannot spawn sout access thread" );
@@ -453,3 +515,211 @@ static void* ThreadWrite( void *data )
     }
     return NULL;
 }
+
+#ifdef HAVE_SENDMMSG
+/*****************************************************************************
+ * ThreadWriteBatch: Write packets on the network by batches.
+ *****************************************************************************
+ * The deadline of the first packet of each batch paces the output, as in
+ * ThreadWrite(). Packets due within the batch window after it are sent at the
+ * same time with as few system calls as possible.
+ *****************************************************************************/
+typedef struct
+{
+    block_t **pkts;
+    unsigned  count;
+    block_t  *next; /* look-ahead packet, not part of the batch */
+} udp_batch_t;
+
+static void BatchCleanup( void *data )
+{
+    udp_batch_t *batch = data;
+
+    for( unsigned i = 0; i < batch->count; i++ )
+        block_Release( batch->pkts[i] );
+    if( batch->next != NULL )
+        block_Release( batch->next );
+}
+
+#ifdef UDP_SEGMENT
+/* Sends a run of equally sized packets (but the last) with one GSO send */
+static int SendSegments( int fd, block_t *const *pkts, unsigned count )
+{
+    struct iovec iov[MAX_GSO_SEGMENTS];
+    union
+    {
+        char buf[CMSG_SPACE(sizeof (uint16_t))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr msg = {
+        .msg_iov = iov,
+        .msg_iovlen = count,
+        .msg_control = control.buf,
+        .msg_controllen = sizeof (control.buf),
+    };
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    uint16_t segment = pkts[0]->i_buffer;
+
+    assert( count <= MAX_GSO_SEGMENTS );
+    for( unsigned i = 0; i < count; i++ )
+    {
+        iov[i].iov_base = pkts[i]->p_buffer;
+        iov[i].iov_len = pkts[i]->i_buffer;
+    }
+
+    cmsg->cmsg_level = IPPROTO_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof (segment));
+    memcpy( CMSG_DATA(cmsg), &segment, sizeof (segment) );
+
+    return sendmsg( fd, &msg, 0 ) >= 0 ? 0 : -1;
+}
+#endif
+
+static void SendBatch( sout_access_out_t *p_access, block_t *const *pkts,
+                       unsigned count )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    struct mmsghdr msgs[count];
+    struct iovec iov[count];
+    unsigned n = 0;
+
+    for( unsigned i = 0; i < count; )
+    {
+#ifdef UDP_SEGMENT
+        if( p_sys->b_gso )
+        {
+            /* Count packets of the same size, the last one may be shorter.
+             * The whole run must fit in one IPv6 datagram. */
+            size_t size = pkts[i]->i_buffer;
+            size_t total = size;
+            unsigned run = 1;
+
+            while( i + run < count && run < MAX_GSO_SEGMENTS
+                && pkts[i + run]->i_buffer <= size
+                && total + pkts[i + run]->i_buffer <= UINT16_MAX - 8 - 40 )
+            {
+                total += pkts[i + run]->i_buffer;
+                if( pkts[i + run++]->i_buffer < size )
+                    break;
+            }
+
+            if( run > 1 )
+            {
+                if( SendSegments( p_sys->i_handle, pkts + i, run ) == 0 )
+                {
+                    i += run;
+                    continue;
+                }
+                msg_Warn( p_access, "GSO send error: %s",
+                          vlc_strerror_c(errno) );
+                p_sys->b_gso = false;
+            }
+        }
+#endif
+        memset( &msgs[n], 0, sizeof (msgs[n]) );
+        iov[n].iov_base = pkts[i]->p_buffer;
+        iov[n].iov_len = pkts[i]->i_buffer;
+        msgs[n].msg_hdr.msg_iov = &iov[n];
+        msgs[n].msg_hdr.msg_iovlen = 1;
+        n++;
+        i++;
+    }
+
+    for( unsigned sent = 0; sent < n; )
+    {
+        int val = sendmmsg( p_sys->i_handle, msgs + sent, n - sent, 0 );
+        if( val < 0 )
+        {
+            msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
+            val = 1; /* skip the failing packet */
+        }
+        sent += val;
+    }
+}
+
+/* Waits for the batch deadline, then sends all packets due by then */
+static void SendBatchAt( sout_access_out_t *p_access, udp_batch_t *batch,
+                         vlc_tick_t i_date )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    vlc_cleanup_push( BatchCleanup, batch );
+    mwait( i_date );
+
+    /* Gather the packets due within the window */
+    vlc_fifo_Lock( p_sys->p_fifo );
+    while( batch->count < p_sys->i_batch )
+    {
+        block_t *p_next = vlc_fifo_DequeueUnlocked( p_sys->p_fifo );
+        if( p_next == NULL )
+            break;
+        if( p_next->i_dts + p_sys->i_caching > i_date + p_sys->i_batch_window )
+        {
+            batch->next = p_next;
+            break;
+        }
+        batch->pkts[batch->count++] = p_next;
+    }
+    vlc_fifo_Unlock( p_sys->p_fifo );
+
+    SendBatch( p_access, batch->pkts, batch->count );
+    vlc_cleanup_pop();
+}
+
+static void* ThreadWriteBatch( void *data )
+{
+    sout_access_out_t *p_access = data;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    block_t *pkts[p_sys->i_batch];
+    udp_batch_t batch = { .pkts = pkts, .count = 0, .next = NULL };
+    vlc_tick_t i_date_last = -1;
+    unsigned i_dropped_packets = 0;
+
+    for (;;)
+    {
+        block_t *p_pk = batch.next;
+        vlc_tick_t i_date;
+
+        batch.next = NULL;
+        if( p_pk == NULL )
+            p_pk = block_FifoGet( p_sys->p_fifo );
+
+        i_date = p_sys->i_caching + p_pk->i_dts;
+        if( i_date_last > 0 && i_date - i_date_last > 2000000 )
+        {
+            if( !i_dropped_packets )
+                msg_Dbg( p_access, "mmh, hole (%"PRId64" > 2s) -> drop",
+                         i_date - i_date_last );
+
+            block_FifoPut( p_sys->p_empty_blocks, p_pk );
+
+            i_date_last = i_date;
+            i_dropped_packets++;
+            continue;
+        }
+
+        if( i_dropped_packets )
+        {
+            msg_Dbg( p_access, "dropped %i packets", i_dropped_packets );
+            i_dropped_packets = 0;
+        }
+
+        batch.pkts[batch.count++] = p_pk;
+        SendBatchAt( p_access, &batch, i_date );
+
+        vlc_tick_t i_sent = mdate();
+        if ( i_sent > i_date + 20000 )
+        {
+            msg_Dbg( p_access, "packet has been sent too late (%"PRId64 ")",
+                     i_sent - i_date );
+        }
+
+        i_date_last = batch.pkts[batch.count - 1]->i_dts + p_sys->i_caching;
+        for( unsigned i = 0; i < batch.count; i++ )
+            block_FifoPut( p_sys->p_empty_blocks, batch.pkts[i] );
+        batch.count = 0;
+    }
+    return NULL;
+}
+#endif
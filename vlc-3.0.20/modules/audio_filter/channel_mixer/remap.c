@@ -372,6 +372,7 @@ static int OpenFilter( vlc_object_t *p_this )
              aout_FormatPrintChannels( audio_out ) );
 
     p_filter->pf_audio_filter = Remap;
+    p_filter->b_audio_chunks = true;
     return VLC_SUCCESS;
 }
 
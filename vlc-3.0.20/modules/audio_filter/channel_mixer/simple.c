@@ -28,7 +28,9 @@
 # include "config.h"
 #endif
 
+
 #include <vlc_common.h>
+#include <vlc_cpu.h>
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_filter.h>
@@ -38,13 +40,14 @@
  * Module descriptor
  *****************************************************************************/
 static int  OpenFilter( vlc_object_t * );
+static void CloseFilter( vlc_object_t * );
 
 vlc_module_begin ()
     set_description( N_("Audio filter for simple channel mixing") )
     set_category( CAT_AUDIO )
     set_subcategory( SUBCAT_AUDIO_MISC )
     set_capability( "audio converter", 10 )
-    set_callbacks( OpenFilter, NULL );
+    set_callbacks( OpenFilter, CloseFilter );
 vlc_module_end ()
 
 static block_t *Filter( filter_t *, block_t * );
@@ -265,6 +268,305 @@ static void DoWork_6_1_to_5_x( filter_t * p_filter,  block_t * p_in_buf, block_t
 #define GET_WORK(in, out) DoWork_##in##_to_##out
 #endif
 
+/*****************************************************************************
+ * Matrix mixing
+ *****************************************************************************
+ * The most common conversions (5.1 and 7.1 to stereo, stereo to 5.1) are also
+ * expressed as a mixing matrix, and run through SIMD kernels specialized for
+ * their layouts: two frames are processed per iteration, the front, middle
+ * and rear channels being mixed as L/R pairs and the center as a duplicated
+ * lane. The kernels take the coefficients from the matrix, but hard-code
+ * which of them are not null.
+ *****************************************************************************/
+struct filter_sys_t
+{
+    void (*do_work)( filter_t *, block_t *, block_t * );
+    void (*mix)( const filter_sys_t *, float *, const float *, size_t );
+
+    float matrix[AOUT_CHAN_MAX][AOUT_CHAN_MAX]; /* [out][in] */
+    float coefs[3][4]; /* matrix coefficients, as laid out for the kernel */
+    unsigned i_in, i_out;
+};
+
+/* Mixes the frames left over by the SIMD kernels. This supports in-place
+ * operation. */
+static void MixTail( const filter_sys_t *p_sys, float *p_dest,
+                     const float *p_src, size_t i_frames )
+{
+    const unsigned in = p_sys->i_in, out = p_sys->i_out;
+    float buffer[AOUT_CHAN_MAX];
+
+    while( i_frames-- )
+    {
+        for( unsigned o = 0; o < out; o++ )
+        {
+            float sum = 0.f;
+            for( unsigned i = 0; i < in; i++ )
+                sum += p_sys->matrix[o][i] * p_src[i];
+            buffer[o] = sum;
+        }
+        memcpy( p_dest, buffer, out * sizeof(float) );
+        p_src += in;
+        p_dest += out;
+    }
+}
+
+#if defined(HAVE_SSE2_INTRINSICS) \
+ || (defined(__aarch64__) && defined(__ARM_NEON))
+# define MIX_SIMD 1
+#endif
+
+#ifdef HAVE_SSE2_INTRINSICS
+#include <xmmintrin.h>
+
+/* The downmixing kernels load the whole iteration before storing, so that
+ * they can run in place. */
+__attribute__ ((__target__ ("sse")))
+static void Mix_7_1_to_2_0( const filter_sys_t *p_sys, float *p_dest,
+                            const float *p_src, size_t i_frames )
+{
+    const __m128 front = _mm_loadu_ps( p_sys->coefs[0] );
+    const __m128 rear = _mm_loadu_ps( p_sys->coefs[1] );
+    const __m128 center = _mm_loadu_ps( p_sys->coefs[2] );
+
+    for( ; i_frames >= 2; i_frames -= 2 )
+    {
+        /* L R Lm Rm | Lr Rr C LFE */
+        const __m128 a0 = _mm_loadu_ps( p_src );
+        const __m128 b0 = _mm_loadu_ps( p_src + 4 );
+        const __m128 a1 = _mm_loadu_ps( p_src + 8 );
+        const __m128 b1 = _mm_loadu_ps( p_src + 12 );
+
+        __m128 s0 = _mm_add_ps( _mm_mul_ps( a0, front ),
+                                _mm_mul_ps( b0, rear ) );
+        __m128 s1 = _mm_add_ps( _mm_mul_ps( a1, front ),
+                                _mm_mul_ps( b1, rear ) );
+        /* C0 C0 C1 C1 */
+        __m128 c = _mm_shuffle_ps( b0, b1, _MM_SHUFFLE( 2, 2, 2, 2 ) );
+
+        __m128 out = _mm_add_ps(
+            _mm_shuffle_ps( s0, s1, _MM_SHUFFLE( 1, 0, 1, 0 ) ),
+            _mm_shuffle_ps( s0, s1, _MM_SHUFFLE( 3, 2, 3, 2 ) ) );
+        out = _mm_add_ps( out, _mm_mul_ps( c, center ) );
+        _mm_storeu_ps( p_dest, out );
+
+        p_src += 16;
+        p_dest += 4;
+    }
+    MixTail( p_sys, p_dest, p_src, i_frames );
+}
+
+__attribute__ ((__target__ ("sse")))
+static void Mix_5_1_to_2_0( const filter_sys_t *p_sys, float *p_dest,
+                            const float *p_src, size_t i_frames )
+{
+    const __m128 front = _mm_loadu_ps( p_sys->coefs[0] );
+    const __m128 center = _mm_loadu_ps( p_sys->coefs[2] );
+
+    for( ; i_frames >= 2; i_frames -= 2 )
+    {
+        /* L R Ls Rs | C LFE L R | Ls Rs C LFE */
+        const __m128 v0 = _mm_loadu_ps( p_src );
+        const __m128 v1 = _mm_loadu_ps( p_src + 4 );
+        const __m128 v2 = _mm_loadu_ps( p_src + 8 );
+
+        __m128 s0 = _mm_mul_ps( v0, front );
+        __m128 s1 = _mm_mul_ps( _mm_shuffle_ps( v1, v2,
+                                                _MM_SHUFFLE( 1, 0, 3, 2 ) ),
+                                front );
+        /* C0 C0 C1 C1 */
+        __m128 c = _mm_shuffle_ps( v1, v2, _MM_SHUFFLE( 2, 2, 0, 0 ) );
+
+        __m128 out = _mm_add_ps(
+            _mm_shuffle_ps( s0, s1, _MM_SHUFFLE( 1, 0, 1, 0 ) ),
+            _mm_shuffle_ps( s0, s1, _MM_SHUFFLE( 3, 2, 3, 2 ) ) );
+        out = _mm_add_ps( out, _mm_mul_ps( c, center ) );
+        _mm_storeu_ps( p_dest, out );
+
+        p_src += 12;
+        p_dest += 4;
+    }
+    MixTail( p_sys, p_dest, p_src, i_frames );
+}
+
+__attribute__ ((__target__ ("sse")))
+static void Mix_2_0_to_5_1( const filter_sys_t *p_sys, float *p_dest,
+                            const float *p_src, size_t i_frames )
+{
+    const __m128 front = _mm_loadu_ps( p_sys->coefs[0] );
+    const __m128 zero = _mm_setzero_ps();
+
+    for( ; i_frames >= 2; i_frames -= 2 )
+    {
+        const __m128 v = _mm_mul_ps( _mm_loadu_ps( p_src ), front );
+
+        /* L0 R0 0 0 | 0 0 L1 R1 | 0 0 0 0 */
+        _mm_storeu_ps( p_dest, _mm_movelh_ps( v, zero ) );
+        _mm_storeu_ps( p_dest + 4, _mm_movehl_ps( v, zero ) );
+        _mm_storeu_ps( p_dest + 8, zero );
+
+        p_src += 4;
+        p_dest += 12;
+    }
+    MixTail( p_sys, p_dest, p_src, i_frames );
+}
+
+static bool MixCanRun( void )
+{
+    return vlc_CPU_SSE();
+}
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+
+static inline float32x4_t FoldPairs( float32x4_t s0, float32x4_t s1 )
+{
+    return vcombine_f32( vadd_f32( vget_low_f32( s0 ), vget_high_f32( s0 ) ),
+                         vadd_f32( vget_low_f32( s1 ), vget_high_f32( s1 ) ) );
+}
+
+static void Mix_7_1_to_2_0( const filter_sys_t *p_sys, float *p_dest,
+                            const float *p_src, size_t i_frames )
+{
+    const float32x4_t front = vld1q_f32( p_sys->coefs[0] );
+    const float32x4_t rear = vld1q_f32( p_sys->coefs[1] );
+    const float32x4_t center = vld1q_f32( p_sys->coefs[2] );
+
+    for( ; i_frames >= 2; i_frames -= 2 )
+    {
+        const float32x4_t a0 = vld1q_f32( p_src );
+        const float32x4_t b0 = vld1q_f32( p_src + 4 );
+        const float32x4_t a1 = vld1q_f32( p_src + 8 );
+        const float32x4_t b1 = vld1q_f32( p_src + 12 );
+
+        float32x4_t s0 = vmlaq_f32( vmulq_f32( a0, front ), b0, rear );
+        float32x4_t s1 = vmlaq_f32( vmulq_f32( a1, front ), b1, rear );
+        float32x4_t c = vcombine_f32( vdup_laneq_f32( b0, 2 ),
+                                      vdup_laneq_f32( b1, 2 ) );
+
+        vst1q_f32( p_dest, vmlaq_f32( FoldPairs( s0, s1 ), c, center ) );
+
+        p_src += 16;
+        p_dest += 4;
+    }
+    MixTail( p_sys, p_dest, p_src, i_frames );
+}
+
+static void Mix_5_1_to_2_0( const filter_sys_t *p_sys, float *p_dest,
+                            const float *p_src, size_t i_frames )
+{
+    const float32x4_t front = vld1q_f32( p_sys->coefs[0] );
+    const float32x4_t center = vld1q_f32( p_sys->coefs[2] );
+
+    for( ; i_frames >= 2; i_frames -= 2 )
+    {
+        const float32x4_t v0 = vld1q_f32( p_src );
+        const float32x4_t v1 = vld1q_f32( p_src + 4 );
+        const float32x4_t v2 = vld1q_f32( p_src + 8 );
+
+        float32x4_t s0 = vmulq_f32( v0, front );
+        float32x4_t s1 = vmulq_f32( vcombine_f32( vget_high_f32( v1 ),
+                                                  vget_low_f32( v2 ) ),
+                                    front );
+        float32x4_t c = vcombine_f32( vdup_laneq_f32( v1, 0 ),
+                                      vdup_laneq_f32( v2, 2 ) );
+
+        vst1q_f32( p_dest, vmlaq_f32( FoldPairs( s0, s1 ), c, center ) );
+
+        p_src += 12;
+        p_dest += 4;
+    }
+    MixTail( p_sys, p_dest, p_src, i_frames );
+}
+
+static void Mix_2_0_to_5_1( const filter_sys_t *p_sys, float *p_dest,
+                            const float *p_src, size_t i_frames )
+{
+    const float32x4_t front = vld1q_f32( p_sys->coefs[0] );
+    const float32x2_t zero2 = vdup_n_f32( 0.f );
+    const float32x4_t zero = vdupq_n_f32( 0.f );
+
+    for( ; i_frames >= 2; i_frames -= 2 )
+    {
+        const float32x4_t v = vmulq_f32( vld1q_f32( p_src ), front );
+
+        vst1q_f32( p_dest, vcombine_f32( vget_low_f32( v ), zero2 ) );
+        vst1q_f32( p_dest + 4, vcombine_f32( zero2, vget_high_f32( v ) ) );
+        vst1q_f32( p_dest + 8, zero );
+
+        p_src += 4;
+        p_dest += 12;
+    }
+    MixTail( p_sys, p_dest, p_src, i_frames );
+}
+
+static bool MixCanRun( void )
+{
+    return vlc_CPU_ARM64_NEON();
+}
+#endif
+
+#define MIX_CHANS_5_1_MIDDLE (AOUT_CHANS_5_0_MIDDLE | AOUT_CHAN_LFE)
+
+static void MixSetPairs( float coefs[4], const float (*m)[AOUT_CHAN_MAX],
+                         unsigned first, unsigned second )
+{
+    coefs[0] = m[0][first];
+    coefs[1] = m[1][first + 1];
+    coefs[2] = m[0][second];
+    coefs[3] = m[1][second + 1];
+}
+
+/* Fills the matrix of the conversion, and returns the kernel to run it, if
+ * any. The coefficients are the same as the DoWork functions. */
+static void (*MixGet( filter_sys_t *p_sys, uint32_t input, uint32_t output ))
+    ( const filter_sys_t *, float *, const float *, size_t )
+{
+    float (*m)[AOUT_CHAN_MAX] = p_sys->matrix;
+
+    memset( p_sys->matrix, 0, sizeof( p_sys->matrix ) );
+    memset( p_sys->coefs, 0, sizeof( p_sys->coefs ) );
+
+#ifdef MIX_SIMD
+    if( !MixCanRun() )
+        return NULL;
+
+    if( output == AOUT_CHANS_2_0 && input == AOUT_CHANS_7_1 )
+    {
+        m[0][0] = m[1][1] = 1.f;
+        m[0][2] = m[0][4] = m[1][3] = m[1][5] = 0.25f;
+        m[0][6] = m[1][6] = 0.7071f;
+        MixSetPairs( p_sys->coefs[0], m, 0, 2 );
+        MixSetPairs( p_sys->coefs[1], m, 4, 6 );
+        p_sys->coefs[1][2] = p_sys->coefs[1][3] = 0.f; /* C and LFE lanes */
+        p_sys->coefs[2][0] = p_sys->coefs[2][2] = m[0][6];
+        p_sys->coefs[2][1] = p_sys->coefs[2][3] = m[1][6];
+        return Mix_7_1_to_2_0;
+    }
+    if( output == AOUT_CHANS_2_0
+     && ( input == AOUT_CHANS_5_1 || input == MIX_CHANS_5_1_MIDDLE ) )
+    {
+        m[0][0] = m[1][1] = 1.f;
+        m[0][2] = m[0][4] = m[1][3] = m[1][4] = 0.7071f;
+        MixSetPairs( p_sys->coefs[0], m, 0, 2 );
+        p_sys->coefs[2][0] = p_sys->coefs[2][2] = m[0][4];
+        p_sys->coefs[2][1] = p_sys->coefs[2][3] = m[1][4];
+        return Mix_5_1_to_2_0;
+    }
+    if( input == AOUT_CHANS_2_0
+     && ( output == AOUT_CHANS_5_1 || output == MIX_CHANS_5_1_MIDDLE ) )
+    {
+        /* Same as the trivial mixer: the other channels are silent */
+        m[0][0] = m[1][1] = 1.f;
+        MixSetPairs( p_sys->coefs[0], m, 0, 0 );
+        return Mix_2_0_to_5_1;
+    }
+#else
+    VLC_UNUSED(m); VLC_UNUSED(input); VLC_UNUSED(output);
+#endif
+    return NULL;
+}
+
 /*****************************************************************************
  * OpenFilter:
  *****************************************************************************/
@@ -286,6 +588,7 @@ static int OpenFilter( vlc_object_t *p_this )
     if( input == output )
         return VLC_EGENERIC;
 
+    const uint32_t i_input_physical = input;
     const bool b_input_6_1 = input == AOUT_CHANS_6_1_MIDDLE;
     const bool b_input_4_center_rear = input == AOUT_CHANS_4_CENTER_REAR;
 
@@ -343,20 +646,39 @@ static int OpenFilter( vlc_object_t *p_this )
             do_work = GET_WORK(6_1,5_x);
     }
 
-    if( do_work == NULL )
+    filter_sys_t *p_sys = malloc( sizeof(*p_sys) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+
+    p_sys->do_work = do_work;
+    p_sys->i_in = aout_FormatNbChannels( &p_filter->fmt_in.audio );
+    p_sys->i_out = aout_FormatNbChannels( &p_filter->fmt_out.audio );
+    p_sys->mix = MixGet( p_sys, i_input_physical, output );
+    if( p_sys->mix == NULL && do_work == NULL )
+    {
+        free( p_sys );
         return VLC_EGENERIC;
+    }
 
     p_filter->pf_audio_filter = Filter;
-    p_filter->p_sys = (void *)do_work;
+    p_filter->b_audio_chunks = true;
+    p_filter->p_sys = p_sys;
     return VLC_SUCCESS;
 }
 
+static void CloseFilter( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    free( p_filter->p_sys );
+}
+
 /*****************************************************************************
  * Filter:
  *****************************************************************************/
 static block_t *Filter( filter_t *p_filter, block_t *p_block )
 {
-    void (*work)(filter_t *, block_t *, block_t *) = (void *)p_filter->p_sys;
+    filter_sys_t *p_sys = p_filter->p_sys;
 
     if( !p_block || !p_block->i_nb_samples )
     {
@@ -365,6 +687,19 @@ static block_t *Filter( filter_t *p_filter, block_t *p_block )
         return NULL;
     }
 
+    int i_input_nb = aout_FormatNbChannels( &p_filter->fmt_in.audio );
+    int i_output_nb = aout_FormatNbChannels( &p_filter->fmt_out.audio );
+
+    /* The matrix kernels downmix in place, so that the chunked pipeline
+     * keeps working on the same cache-hot buffer. */
+    if( p_sys->mix != NULL && i_output_nb <= i_input_nb )
+    {
+        p_sys->mix( p_sys, (float *)p_block->p_buffer,
+                    (const float *)p_block->p_buffer, p_block->i_nb_samples );
+        p_block->i_buffer = p_block->i_buffer * i_output_nb / i_input_nb;
+        return p_block;
+    }
+
     size_t i_out_size = p_block->i_nb_samples *
       p_filter->fmt_out.audio.i_bitspersample *
         p_filter->fmt_out.audio.i_channels / 8;
@@ -382,15 +717,16 @@ static block_t *Filter( filter_t *p_filter, block_t *p_block )
     p_out->i_pts = p_block->i_pts;
     p_out->i_length = p_block->i_length;
 
-    int i_input_nb = aout_FormatNbChannels( &p_filter->fmt_in.audio );
-    int i_output_nb = aout_FormatNbChannels( &p_filter->fmt_out.audio );
     p_out->i_nb_samples = p_block->i_nb_samples;
     p_out->i_buffer = p_block->i_buffer * i_output_nb / i_input_nb;
 
-    work( p_filter, p_block, p_out );
+    if( p_sys->mix != NULL )
+        p_sys->mix( p_sys, (float *)p_out->p_buffer,
+                    (const float *)p_block->p_buffer, p_block->i_nb_samples );
+    else
+        p_sys->do_work( p_filter, p_block, p_out );
 
     block_Release( p_block );
 
     return p_out;
 }
-
@@ -90,6 +90,11 @@ struct filter_spatialaudio
         , i_last_input_pts(0)
         , inBuf(NULL)
         , outBuf(NULL)
+        , f_teta(0.f)
+        , f_phi(0.f)
+        , f_roll(0.f)
+        , f_zoom(0.f)
+        , b_viewpoint_changed(true)
     {}
     ~filter_spatialaudio()
     {
@@ -120,6 +125,9 @@ struct filter_spatialaudio
 
     CAmbisonicSpeaker *speakers;
 
+    /* Ambisonics block, configured once and refilled for each block */
+    CBFormat inData;
+
     std::vector<float> inputSamples;
     vlc_tick_t i_inputPTS;
     vlc_tick_t i_last_input_pts;
@@ -135,6 +143,8 @@ struct filter_spatialaudio
     float f_phi;
     float f_roll;
     float f_zoom;
+    /* The rotation and zoom coefficients need to be recomputed */
+    bool b_viewpoint_changed;
 };
 
 static std::string getHRTFPath(filter_t *p_filter)
@@ -220,19 +230,24 @@ static block_t *Mix( filter_t *p_filter, block_t *p_buf )
             case filter_spatialaudio::AMBISONICS_DECODER:
             case filter_spatialaudio::AMBISONICS_BINAURAL_DECODER:
             {
-                CBFormat inData;
-                inData.Configure(p_sys->i_order, true, AMB_BLOCK_TIME_LEN);
+                CBFormat &inData = p_sys->inData;
 
                 for (unsigned i = 0; i < p_sys->i_inputNb; ++i)
                     inData.InsertStream(p_sys->inBuf[i], i, AMB_BLOCK_TIME_LEN);
 
-                Orientation ori(p_sys->f_teta, p_sys->f_phi, p_sys->f_roll);
-                p_sys->processor.SetOrientation(ori);
-                p_sys->processor.Refresh();
-                p_sys->processor.Process(&inData, inData.GetSampleCount());
+                if (p_sys->b_viewpoint_changed)
+                {
+                    Orientation ori(p_sys->f_teta, p_sys->f_phi, p_sys->f_roll);
+                    p_sys->processor.SetOrientation(ori);
+                    p_sys->processor.Refresh();
+
+                    p_sys->zoomer.SetZoom(p_sys->f_zoom);
+                    p_sys->zoomer.Refresh();
+
+                    p_sys->b_viewpoint_changed = false;
+                }
 
-                p_sys->zoomer.SetZoom(p_sys->f_zoom);
-                p_sys->zoomer.Refresh();
+                p_sys->processor.Process(&inData, inData.GetSampleCount());
                 p_sys->zoomer.Process(&inData, inData.GetSampleCount());
 
                 if (p_sys->mode == filter_spatialaudio::AMBISONICS_DECODER)
@@ -274,15 +289,26 @@ static void ChangeViewpoint( filter_t *p_filter, const vlc_viewpoint_t *p_vp)
     filter_spatialaudio *p_sys = reinterpret_cast<filter_spatialaudio *>(p_filter->p_sys);
 
 #define RAD(d) ((float) ((d) * M_PI / 180.f))
-    p_sys->f_teta = -RAD(p_vp->yaw);
-    p_sys->f_phi = RAD(p_vp->pitch);
-    p_sys->f_roll = RAD(p_vp->roll);
+    const float f_teta = -RAD(p_vp->yaw);
+    const float f_phi = RAD(p_vp->pitch);
+    const float f_roll = RAD(p_vp->roll);
+#undef RAD
 
+    float f_zoom;
     if (p_vp->fov >= FIELD_OF_VIEW_DEGREES_DEFAULT)
-        p_sys->f_zoom = 0.f; // no unzoom as it does not really make sense.
+        f_zoom = 0.f; // no unzoom as it does not really make sense.
     else
-        p_sys->f_zoom = (FIELD_OF_VIEW_DEGREES_DEFAULT - p_vp->fov) / (FIELD_OF_VIEW_DEGREES_DEFAULT - FIELD_OF_VIEW_DEGREES_MIN);
-#undef RAD
+        f_zoom = (FIELD_OF_VIEW_DEGREES_DEFAULT - p_vp->fov) / (FIELD_OF_VIEW_DEGREES_DEFAULT - FIELD_OF_VIEW_DEGREES_MIN);
+
+    if (f_teta == p_sys->f_teta && f_phi == p_sys->f_phi
+     && f_roll == p_sys->f_roll && f_zoom == p_sys->f_zoom)
+        return;
+
+    p_sys->f_teta = f_teta;
+    p_sys->f_phi = f_phi;
+    p_sys->f_roll = f_roll;
+    p_sys->f_zoom = f_zoom;
+    p_sys->b_viewpoint_changed = true;
 }
 
 static int allocateBuffers(filter_spatialaudio *p_sys)
@@ -409,10 +435,6 @@ static int Open(vlc_object_t *p_this)
     if (p_sys == NULL)
         return VLC_ENOMEM;
 
-    p_sys->f_teta = 0.f;
-    p_sys->f_phi = 0.f;
-    p_sys->f_roll = 0.f;
-    p_sys->f_zoom = 0.f;
     p_sys->i_inputNb = p_filter->fmt_in.audio.i_channels;
     p_sys->i_outputNb = p_filter->fmt_out.audio.i_channels;
 
@@ -516,6 +538,13 @@ static int Open(vlc_object_t *p_this)
         return VLC_EGENERIC;
     }
 
+    if (!p_sys->inData.Configure(p_sys->i_order, true, AMB_BLOCK_TIME_LEN))
+    {
+        msg_Err(p_filter, "Error creating the ambisonic buffer.");
+        delete p_sys;
+        return VLC_EGENERIC;
+    }
+
     p_filter->p_sys = reinterpret_cast<filter_sys_t*>(p_sys);
     p_filter->pf_audio_filter = Mix;
     p_filter->pf_flush = Flush;
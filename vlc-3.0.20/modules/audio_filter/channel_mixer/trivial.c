@@ -178,6 +178,7 @@ static int Create( vlc_object_t *p_this )
         if( aout_FormatNbChannels( outfmt ) == infmt->i_channels )
         {
             p_filter->pf_audio_filter = Equals;
+            p_filter->b_audio_chunks = true;
             return VLC_SUCCESS;
         }
         else
@@ -186,6 +187,7 @@ static int Create( vlc_object_t *p_this )
                 msg_Info(p_filter, "%d channels will be dropped.",
                          infmt->i_channels - AOUT_CHAN_MAX);
             p_filter->pf_audio_filter = Extract;
+            p_filter->b_audio_chunks = true;
             return VLC_SUCCESS;
         }
     }
@@ -208,6 +210,7 @@ static int Create( vlc_object_t *p_this )
       && aout_FormatNbChannels( infmt ) == 1 )
     {
         p_filter->pf_audio_filter = Equals;
+        p_filter->b_audio_chunks = true;
         return VLC_SUCCESS;
     }
 
@@ -290,6 +293,7 @@ static int Create( vlc_object_t *p_this )
         if( b_equals )
         {
             p_filter->pf_audio_filter = Equals;
+            p_filter->b_audio_chunks = true;
             return VLC_SUCCESS;
         }
     }
@@ -303,6 +307,7 @@ static int Create( vlc_object_t *p_this )
         p_filter->pf_audio_filter = Upmix;
     else
         p_filter->pf_audio_filter = Downmix;
+    p_filter->b_audio_chunks = true;
 
     return VLC_SUCCESS;
 }
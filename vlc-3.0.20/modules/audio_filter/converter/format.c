@@ -39,6 +39,18 @@
 #include <vlc_aout.h>
 #include <vlc_block.h>
 #include <vlc_filter.h>
+#include <vlc_cpu.h>
+
+#ifdef HAVE_SSE2_INTRINSICS
+# include <emmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+# define HAVE_FORMAT_NEON
+#endif
 
 /*****************************************************************************
  * Module descriptor
@@ -60,6 +72,22 @@ vlc_module_end()
 typedef block_t *(*cvt_t)(filter_t *, block_t *);
 static cvt_t FindConversion(vlc_fourcc_t src, vlc_fourcc_t dst);
 
+/* Vectorized conversion loop: converts as many of the first samples as
+ * it can, and returns how many it did. The remaining ones are converted by
+ * the plain C loop. Narrowing and same size conversions may be in place. */
+struct cvt_kernel {
+    vlc_fourcc_t src;
+    vlc_fourcc_t dst;
+    size_t (*convert)(void *, const void *, size_t);
+};
+static const struct cvt_kernel *FindKernel(vlc_fourcc_t src, vlc_fourcc_t dst);
+
+static size_t Kernel(filter_t *filter, void *dst, const void *src, size_t n)
+{
+    const struct cvt_kernel *kernel = (const void *)filter->p_sys;
+    return (kernel != NULL) ? kernel->convert(dst, src, n) : 0;
+}
+
 static int Open(vlc_object_t *object)
 {
     filter_t     *filter = (filter_t *)object;
@@ -76,6 +104,8 @@ static int Open(vlc_object_t *object)
     if (filter->pf_audio_filter == NULL)
         return VLC_EGENERIC;
 
+    filter->p_sys = (filter_sys_t *)FindKernel(src->i_codec, dst->i_codec);
+    filter->b_audio_chunks = true;
     msg_Dbg(filter, "%4.4s->%4.4s, bits per sample: %i->%i",
             (char *)&src->i_codec, (char *)&dst->i_codec,
             src->audio.i_bitspersample, dst->audio.i_bitspersample);
@@ -175,7 +205,10 @@ static block_t *S16toFl32(filter_t *filter, block_t *bsrc)
     block_CopyProperties(bdst, bsrc);
     int16_t *src = (int16_t *)bsrc->p_buffer;
     float   *dst = (float *)bdst->p_buffer;
-    for (size_t i = bsrc->i_buffer / 2; i--;)
+    size_t done = Kernel(filter, dst, src, bsrc->i_buffer / 2);
+    src += done;
+    dst += done;
+    for (size_t i = bsrc->i_buffer / 2 - done; i--;)
 #if 0
         /* Slow version */
         *dst++ = (float)*src++ / 32768.f;
@@ -190,7 +223,6 @@ static block_t *S16toFl32(filter_t *filter, block_t *bsrc)
 #endif
 out:
     block_Release(bsrc);
-    VLC_UNUSED(filter);
     return bdst;
 }
 
@@ -203,11 +235,13 @@ static block_t *S16toS32(filter_t *filter, block_t *bsrc)
     block_CopyProperties(bdst, bsrc);
     int16_t *src = (int16_t *)bsrc->p_buffer;
     int32_t *dst = (int32_t *)bdst->p_buffer;
-    for (int i = bsrc->i_buffer / 2; i--;)
+    size_t done = Kernel(filter, dst, src, bsrc->i_buffer / 2);
+    src += done;
+    dst += done;
+    for (size_t i = bsrc->i_buffer / 2 - done; i--;)
         *dst++ = *src++ << 16;
 out:
     block_Release(bsrc);
-    VLC_UNUSED(filter);
     return bdst;
 }
 
@@ -252,10 +286,12 @@ static block_t *Fl32toU8(filter_t *filter, block_t *b)
 
 static block_t *Fl32toS16(filter_t *filter, block_t *b)
 {
-    VLC_UNUSED(filter);
     float   *src = (float *)b->p_buffer;
     int16_t *dst = (int16_t *)src;
-    for (int i = b->i_buffer / 4; i--;) {
+    size_t done = Kernel(filter, dst, src, b->i_buffer / 4);
+    src += done;
+    dst += done;
+    for (size_t i = b->i_buffer / 4 - done; i--;) {
 #if 0
         /* Slow version. */
         if (*src >= 1.0) *dst = 32767;
@@ -282,7 +318,10 @@ static block_t *Fl32toS32(filter_t *filter, block_t *b)
 {
     float   *src = (float *)b->p_buffer;
     int32_t *dst = (int32_t *)src;
-    for (size_t i = b->i_buffer / 4; i--;)
+    size_t done = Kernel(filter, dst, src, b->i_buffer / 4);
+    src += done;
+    dst += done;
+    for (size_t i = b->i_buffer / 4 - done; i--;)
     {
         float s = *(src++) * 2147483648.f;
         if (s >= 2147483647.f)
@@ -293,7 +332,6 @@ static block_t *Fl32toS32(filter_t *filter, block_t *b)
         else
             *(dst++) = lroundf(s);
     }
-    VLC_UNUSED(filter);
     return b;
 }
 
@@ -342,10 +380,12 @@ static block_t *S32toS16(filter_t *filter, block_t *b)
 
 static block_t *S32toFl32(filter_t *filter, block_t *b)
 {
-    VLC_UNUSED(filter);
     int32_t *src = (int32_t*)b->p_buffer;
     float   *dst = (float *)src;
-    for (int i = b->i_buffer / 4; i--;)
+    size_t done = Kernel(filter, dst, src, b->i_buffer / 4);
+    src += done;
+    dst += done;
+    for (size_t i = b->i_buffer / 4 - done; i--;)
         *dst++ = (float)(*src++) / 2147483648.f;
     return b;
 }
@@ -439,6 +479,335 @@ static block_t *Fl64toS32(filter_t *filter, block_t *b)
 }
 
 
+/*** Vectorized loops ***/
+#ifdef HAVE_SSE2_INTRINSICS
+__attribute__ ((__target__ ("sse2")))
+static size_t S16toFl32_SSE2(void *restrict dst, const void *restrict src,
+                             size_t n)
+{
+    const __m128 scale = _mm_set1_ps(1.f / 32768.f);
+    const int16_t *in = src;
+    float *out = dst;
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+        /* sign extend to 32-bits */
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    return i;
+}
+
+__attribute__ ((__target__ ("sse2")))
+static size_t S16toS32_SSE2(void *restrict dst, const void *restrict src,
+                            size_t n)
+{
+    const int16_t *in = src;
+    int32_t *out = dst;
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+
+        _mm_storeu_si128((__m128i *)(out + i),
+                         _mm_unpacklo_epi16(_mm_setzero_si128(), v));
+        _mm_storeu_si128((__m128i *)(out + i + 4),
+                         _mm_unpackhi_epi16(_mm_setzero_si128(), v));
+    }
+    return i;
+}
+
+__attribute__ ((__target__ ("sse2")))
+static size_t Fl32toS16_SSE2(void *dst, const void *src, size_t n)
+{
+    const __m128 scale = _mm_set1_ps(32768.f);
+    const __m128 max = _mm_set1_ps(32767.f);
+    const __m128 min = _mm_set1_ps(-32768.f);
+    const float *in = src;
+    int16_t *out = dst;
+    size_t i;
+
+    /* In place: the output never overtakes the input */
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m128 a = _mm_mul_ps(_mm_loadu_ps(in + i), scale);
+        __m128 b = _mm_mul_ps(_mm_loadu_ps(in + i + 4), scale);
+
+        a = _mm_max_ps(_mm_min_ps(a, max), min);
+        b = _mm_max_ps(_mm_min_ps(b, max), min);
+        _mm_storeu_si128((__m128i *)(out + i),
+                         _mm_packs_epi32(_mm_cvtps_epi32(a),
+                                         _mm_cvtps_epi32(b)));
+    }
+    return i;
+}
+
+__attribute__ ((__target__ ("sse2")))
+static size_t Fl32toS32_SSE2(void *dst, const void *src, size_t n)
+{
+    const __m128 scale = _mm_set1_ps(2147483648.f);
+    const float *in = src;
+    int32_t *out = dst;
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        __m128 v = _mm_mul_ps(_mm_loadu_ps(in + i), scale);
+        /* Overflows convert to INT32_MIN, flip those to INT32_MAX */
+        __m128i over = _mm_castps_si128(_mm_cmpge_ps(v, scale));
+
+        _mm_storeu_si128((__m128i *)(out + i),
+                         _mm_xor_si128(_mm_cvtps_epi32(v), over));
+    }
+    return i;
+}
+
+__attribute__ ((__target__ ("sse2")))
+static size_t S32toFl32_SSE2(void *dst, const void *src, size_t n)
+{
+    const __m128 scale = _mm_set1_ps(1.f / 2147483648.f);
+    const int32_t *in = src;
+    float *out = dst;
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+    }
+    return i;
+}
+
+static const struct cvt_kernel cvt_sse2[] = {
+    { VLC_CODEC_S16N, VLC_CODEC_FL32, S16toFl32_SSE2 },
+    { VLC_CODEC_S16N, VLC_CODEC_S32N, S16toS32_SSE2  },
+    { VLC_CODEC_FL32, VLC_CODEC_S16N, Fl32toS16_SSE2 },
+    { VLC_CODEC_FL32, VLC_CODEC_S32N, Fl32toS32_SSE2 },
+    { VLC_CODEC_S32N, VLC_CODEC_FL32, S32toFl32_SSE2 },
+    { 0, 0, NULL }
+};
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+__attribute__ ((__target__ ("avx2")))
+static size_t S16toFl32_AVX2(void *restrict dst, const void *restrict src,
+                             size_t n)
+{
+    const __m256 scale = _mm256_set1_ps(1.f / 32768.f);
+    const int16_t *in = src;
+    float *out = dst;
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        __m256i lo = _mm256_cvtepi16_epi32(
+                        _mm_loadu_si128((const __m128i *)(in + i)));
+        __m256i hi = _mm256_cvtepi16_epi32(
+                        _mm_loadu_si128((const __m128i *)(in + i + 8)));
+
+        _mm256_storeu_ps(out + i,
+                         _mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale));
+        _mm256_storeu_ps(out + i + 8,
+                         _mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale));
+    }
+    return i;
+}
+
+__attribute__ ((__target__ ("avx2")))
+static size_t Fl32toS16_AVX2(void *dst, const void *src, size_t n)
+{
+    const __m256 scale = _mm256_set1_ps(32768.f);
+    const __m256 max = _mm256_set1_ps(32767.f);
+    const __m256 min = _mm256_set1_ps(-32768.f);
+    const float *in = src;
+    int16_t *out = dst;
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        __m256 a = _mm256_mul_ps(_mm256_loadu_ps(in + i), scale);
+        __m256 b = _mm256_mul_ps(_mm256_loadu_ps(in + i + 8), scale);
+
+        a = _mm256_max_ps(_mm256_min_ps(a, max), min);
+        b = _mm256_max_ps(_mm256_min_ps(b, max), min);
+        /* packing works within 128-bits lanes, restore the sample order */
+        __m256i v = _mm256_packs_epi32(_mm256_cvtps_epi32(a),
+                                       _mm256_cvtps_epi32(b));
+        _mm256_storeu_si256((__m256i *)(out + i),
+                            _mm256_permute4x64_epi64(v, 0xD8));
+    }
+    return i;
+}
+
+__attribute__ ((__target__ ("avx2")))
+static size_t Fl32toS32_AVX2(void *dst, const void *src, size_t n)
+{
+    const __m256 scale = _mm256_set1_ps(2147483648.f);
+    const float *in = src;
+    int32_t *out = dst;
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m256 v = _mm256_mul_ps(_mm256_loadu_ps(in + i), scale);
+        __m256i over = _mm256_castps_si256(_mm256_cmp_ps(v, scale,
+                                                         _CMP_GE_OQ));
+
+        _mm256_storeu_si256((__m256i *)(out + i),
+                            _mm256_xor_si256(_mm256_cvtps_epi32(v), over));
+    }
+    return i;
+}
+
+__attribute__ ((__target__ ("avx2")))
+static size_t S32toFl32_AVX2(void *dst, const void *src, size_t n)
+{
+    const __m256 scale = _mm256_set1_ps(1.f / 2147483648.f);
+    const int32_t *in = src;
+    float *out = dst;
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(in + i));
+        _mm256_storeu_ps(out + i,
+                         _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+    return i;
+}
+
+static const struct cvt_kernel cvt_avx2[] = {
+    { VLC_CODEC_S16N, VLC_CODEC_FL32, S16toFl32_AVX2 },
+    { VLC_CODEC_FL32, VLC_CODEC_S16N, Fl32toS16_AVX2 },
+    { VLC_CODEC_FL32, VLC_CODEC_S32N, Fl32toS32_AVX2 },
+    { VLC_CODEC_S32N, VLC_CODEC_FL32, S32toFl32_AVX2 },
+    { 0, 0, NULL }
+};
+#endif
+
+#ifdef HAVE_FORMAT_NEON
+static size_t S16toFl32_NEON(void *restrict dst, const void *restrict src,
+                             size_t n)
+{
+    const int16_t *in = src;
+    float *out = dst;
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        int16x8_t v = vld1q_s16(in + i);
+
+        vst1q_f32(out + i, vcvtq_n_f32_s32(vmovl_s16(vget_low_s16(v)), 15));
+        vst1q_f32(out + i + 4, vcvtq_n_f32_s32(vmovl_high_s16(v), 15));
+    }
+    return i;
+}
+
+static size_t S16toS32_NEON(void *restrict dst, const void *restrict src,
+                            size_t n)
+{
+    const int16_t *in = src;
+    int32_t *out = dst;
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        int16x8_t v = vld1q_s16(in + i);
+
+        vst1q_s32(out + i, vshll_n_s16(vget_low_s16(v), 16));
+        vst1q_s32(out + i + 4, vshll_high_n_s16(v, 16));
+    }
+    return i;
+}
+
+static size_t Fl32toS16_NEON(void *dst, const void *src, size_t n)
+{
+    const float *in = src;
+    int16_t *out = dst;
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        /* Convert with one more fractional bit, then narrow with rounding
+         * and saturation */
+        int32x4_t a = vcvtq_n_s32_f32(vld1q_f32(in + i), 16);
+        int32x4_t b = vcvtq_n_s32_f32(vld1q_f32(in + i + 4), 16);
+
+        vst1q_s16(out + i, vcombine_s16(vqrshrn_n_s32(a, 1),
+                                        vqrshrn_n_s32(b, 1)));
+    }
+    return i;
+}
+
+static size_t Fl32toS32_NEON(void *dst, const void *src, size_t n)
+{
+    const float *in = src;
+    int32_t *out = dst;
+    size_t i;
+
+    /* The fixed-point conversion saturates */
+    for (i = 0; i + 4 <= n; i += 4)
+        vst1q_s32(out + i, vcvtq_n_s32_f32(vld1q_f32(in + i), 31));
+    return i;
+}
+
+static size_t S32toFl32_NEON(void *dst, const void *src, size_t n)
+{
+    const int32_t *in = src;
+    float *out = dst;
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+        vst1q_f32(out + i, vcvtq_n_f32_s32(vld1q_s32(in + i), 31));
+    return i;
+}
+
+static const struct cvt_kernel cvt_neon[] = {
+    { VLC_CODEC_S16N, VLC_CODEC_FL32, S16toFl32_NEON },
+    { VLC_CODEC_S16N, VLC_CODEC_S32N, S16toS32_NEON  },
+    { VLC_CODEC_FL32, VLC_CODEC_S16N, Fl32toS16_NEON },
+    { VLC_CODEC_FL32, VLC_CODEC_S32N, Fl32toS32_NEON },
+    { VLC_CODEC_S32N, VLC_CODEC_FL32, S32toFl32_NEON },
+    { 0, 0, NULL }
+};
+#endif
+
+static const struct cvt_kernel *LookupKernel(const struct cvt_kernel *table,
+                                             vlc_fourcc_t src,
+                                             vlc_fourcc_t dst)
+{
+    for (; table->convert != NULL; table++)
+        if (table->src == src && table->dst == dst)
+            return table;
+    return NULL;
+}
+
+static const struct cvt_kernel *FindKernel(vlc_fourcc_t src, vlc_fourcc_t dst)
+{
+    const struct cvt_kernel *kernel = NULL;
+
+#ifdef HAVE_AVX2_INTRINSICS
+    if (kernel == NULL && vlc_CPU_AVX2())
+        kernel = LookupKernel(cvt_avx2, src, dst);
+#endif
+#ifdef HAVE_SSE2_INTRINSICS
+    if (kernel == NULL && vlc_CPU_SSE2())
+        kernel = LookupKernel(cvt_sse2, src, dst);
+#endif
+#ifdef HAVE_FORMAT_NEON
+    if (kernel == NULL && vlc_CPU_ARM64_NEON())
+        kernel = LookupKernel(cvt_neon, src, dst);
+#endif
+    VLC_UNUSED(src); VLC_UNUSED(dst);
+    return kernel;
+}
+
 /* */
 /* */
 static const struct {
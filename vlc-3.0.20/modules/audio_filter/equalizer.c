@@ -37,6 +37,7 @@
 
 #include <vlc_aout.h>
 #include <vlc_filter.h>
+#include <vlc_cpu.h>
 
 #include "equalizer_presets.h"
 
@@ -101,6 +102,15 @@ vlc_module_end ()
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
+#define EQZ_CHANNELS_MAX 32
+
+typedef struct
+{
+    /* History, laid out per channel so that channels map to SIMD lanes */
+    float x[2][EQZ_CHANNELS_MAX];
+    float y[EQZ_BANDS_MAX][2][EQZ_CHANNELS_MAX];
+} eqz_state_t;
+
 struct filter_sys_t
 {
     /* Filter static config */
@@ -115,12 +125,13 @@ struct filter_sys_t
     bool b_2eqz;
 
     /* Filter state */
-    float x[32][2];
-    float y[32][128][2];
+    eqz_state_t state;
 
     /* Second filter state */
-    float x2[32][2];
-    float y2[32][128][2];
+    eqz_state_t state2;
+
+    void (*pf_pass)( const filter_sys_t *, eqz_state_t *,
+                     const float *, float *, unsigned );
 
     vlc_mutex_t lock;
 };
@@ -150,6 +161,9 @@ static int Open( vlc_object_t *p_this )
 {
     filter_t     *p_filter = (filter_t *)p_this;
 
+    if( aout_FormatNbChannels( &p_filter->fmt_in.audio ) > EQZ_CHANNELS_MAX )
+        return VLC_EGENERIC;
+
     /* Allocate structure */
     filter_sys_t *p_sys = p_filter->p_sys = malloc( sizeof( *p_sys ) );
     if( !p_sys )
@@ -277,11 +291,123 @@ static inline float EqzConvertdB( float db )
     return EQZ_IN_FACTOR * ( powf( 10.0f, db / 20.0f ) - 1.0f );
 }
 
+/* Runs the band-pass filter bank over one frame of i_lanes channels, and
+ * returns the gain-weighted sum of the bands in out. */
+static void EqzPass( const filter_sys_t *p_sys, eqz_state_t *st,
+                     const float *in, float *out, unsigned i_lanes )
+{
+    for( unsigned ch = 0; ch < i_lanes; ch++ )
+    {
+        const float x = in[ch];
+        float o = 0.0f;
+
+        for( int j = 0; j < p_sys->i_band; j++ )
+        {
+            float y = p_sys->f_alpha[j] * ( x - st->x[1][ch] ) +
+                      p_sys->f_gamma[j] * st->y[j][0][ch] -
+                      p_sys->f_beta[j]  * st->y[j][1][ch];
+
+            st->y[j][1][ch] = st->y[j][0][ch];
+            st->y[j][0][ch] = y;
+
+            o += y * p_sys->f_amp[j];
+        }
+        st->x[1][ch] = st->x[0][ch];
+        st->x[0][ch] = x;
+        out[ch] = o;
+    }
+}
+
+#ifdef HAVE_SSE2_INTRINSICS
+#include <xmmintrin.h>
+
+__attribute__ ((__target__ ("sse")))
+static void EqzPass_sse( const filter_sys_t *p_sys, eqz_state_t *st,
+                         const float *in, float *out, unsigned i_lanes )
+{
+    for( unsigned ch = 0; ch < i_lanes; ch += 4 )
+    {
+        const __m128 x = _mm_loadu_ps( &in[ch] );
+        const __m128 dx = _mm_sub_ps( x, _mm_loadu_ps( &st->x[1][ch] ) );
+        __m128 o = _mm_setzero_ps();
+
+        for( int j = 0; j < p_sys->i_band; j++ )
+        {
+            const __m128 y0 = _mm_loadu_ps( &st->y[j][0][ch] );
+            const __m128 y1 = _mm_loadu_ps( &st->y[j][1][ch] );
+            __m128 y;
+
+            y = _mm_mul_ps( _mm_set1_ps( p_sys->f_alpha[j] ), dx );
+            y = _mm_add_ps( y, _mm_mul_ps( _mm_set1_ps( p_sys->f_gamma[j] ),
+                                           y0 ) );
+            y = _mm_sub_ps( y, _mm_mul_ps( _mm_set1_ps( p_sys->f_beta[j] ),
+                                           y1 ) );
+
+            _mm_storeu_ps( &st->y[j][1][ch], y0 );
+            _mm_storeu_ps( &st->y[j][0][ch], y );
+
+            o = _mm_add_ps( o, _mm_mul_ps( y, _mm_set1_ps( p_sys->f_amp[j] ) ) );
+        }
+        _mm_storeu_ps( &st->x[1][ch], _mm_loadu_ps( &st->x[0][ch] ) );
+        _mm_storeu_ps( &st->x[0][ch], x );
+        _mm_storeu_ps( &out[ch], o );
+    }
+}
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+
+static void EqzPass_neon( const filter_sys_t *p_sys, eqz_state_t *st,
+                          const float *in, float *out, unsigned i_lanes )
+{
+    for( unsigned ch = 0; ch < i_lanes; ch += 4 )
+    {
+        const float32x4_t x = vld1q_f32( &in[ch] );
+        const float32x4_t dx = vsubq_f32( x, vld1q_f32( &st->x[1][ch] ) );
+        float32x4_t o = vdupq_n_f32( 0.0f );
+
+        for( int j = 0; j < p_sys->i_band; j++ )
+        {
+            const float32x4_t y0 = vld1q_f32( &st->y[j][0][ch] );
+            const float32x4_t y1 = vld1q_f32( &st->y[j][1][ch] );
+            float32x4_t y;
+
+            y = vmulq_n_f32( dx, p_sys->f_alpha[j] );
+            y = vaddq_f32( y, vmulq_n_f32( y0, p_sys->f_gamma[j] ) );
+            y = vsubq_f32( y, vmulq_n_f32( y1, p_sys->f_beta[j] ) );
+
+            vst1q_f32( &st->y[j][1][ch], y0 );
+            vst1q_f32( &st->y[j][0][ch], y );
+
+            o = vaddq_f32( o, vmulq_n_f32( y, p_sys->f_amp[j] ) );
+        }
+        vst1q_f32( &st->x[1][ch], vld1q_f32( &st->x[0][ch] ) );
+        vst1q_f32( &st->x[0][ch], x );
+        vst1q_f32( &out[ch], o );
+    }
+}
+#endif
+
+struct eqz_kernels
+{
+    void (*pass)( const filter_sys_t *, eqz_state_t *,
+                  const float *, float *, unsigned );
+};
+
+static const vlc_cpu_kernel_t eqz_kernels[] = {
+#ifdef HAVE_SSE2_INTRINSICS
+    { "sse", VLC_CPU_SSE, &(const struct eqz_kernels){ EqzPass_sse } },
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    { "neon", 0, &(const struct eqz_kernels){ EqzPass_neon } },
+#endif
+    { "c", 0, &(const struct eqz_kernels){ EqzPass } },
+};
+
 static int EqzInit( filter_t *p_filter, int i_rate )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
     eqz_config_t cfg;
-    int i, ch;
+    int i;
     vlc_value_t val1, val2, val3;
     vlc_object_t *p_aout = p_filter->obj.parent;
     int i_ret = VLC_ENOMEM;
@@ -317,21 +443,13 @@ static int EqzInit( filter_t *p_filter, int i_rate )
     }
 
     /* Filter state */
-    for( ch = 0; ch < 32; ch++ )
-    {
-        p_sys->x[ch][0]  =
-        p_sys->x[ch][1]  =
-        p_sys->x2[ch][0] =
-        p_sys->x2[ch][1] = 0.0f;
+    memset( &p_sys->state, 0, sizeof(p_sys->state) );
+    memset( &p_sys->state2, 0, sizeof(p_sys->state2) );
 
-        for( i = 0; i < p_sys->i_band; i++ )
-        {
-            p_sys->y[ch][i][0]  =
-            p_sys->y[ch][i][1]  =
-            p_sys->y2[ch][i][0] =
-            p_sys->y2[ch][i][1] = 0.0f;
-        }
-    }
+    const struct eqz_kernels *kernels =
+        vlc_CPU_SelectKernel( "equalizer", eqz_kernels,
+                              ARRAY_SIZE(eqz_kernels) );
+    p_sys->pf_pass = kernels->pass;
 
     var_Create( p_aout, "equalizer-bands", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
     var_Create( p_aout, "equalizer-preset", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
@@ -390,57 +508,35 @@ static void EqzFilter( filter_t *p_filter, float *out, float *in,
                        int i_samples, int i_channels )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
-    int i, ch, j;
+    /* Round up to whole vectors, the extra lanes are fed with silence */
+    const unsigned i_lanes = ( i_channels + 3 ) & ~3;
+    float x[EQZ_CHANNELS_MAX] = { 0.0f };
+    float x2[EQZ_CHANNELS_MAX];
+    float o[EQZ_CHANNELS_MAX];
+    int i, ch;
 
     vlc_mutex_lock( &p_sys->lock );
     for( i = 0; i < i_samples; i++ )
     {
-        for( ch = 0; ch < i_channels; ch++ )
+        memcpy( x, in, i_channels * sizeof(float) );
+        p_sys->pf_pass( p_sys, &p_sys->state, x, o, i_lanes );
+
+        /* Second filter */
+        if( p_sys->b_2eqz )
+        {
+            for( unsigned j = 0; j < i_lanes; j++ )
+                x2[j] = EQZ_IN_FACTOR * x[j] + o[j];
+            p_sys->pf_pass( p_sys, &p_sys->state2, x2, o, i_lanes );
+
+            /* We add source PCM + filtered PCM */
+            for( ch = 0; ch < i_channels; ch++ )
+                out[ch] = p_sys->f_gamp * p_sys->f_gamp *( EQZ_IN_FACTOR * x2[ch] + o[ch] );
+        }
+        else
         {
-            const float x = in[ch];
-            float o = 0.0f;
-
-            for( j = 0; j < p_sys->i_band; j++ )
-            {
-                float y = p_sys->f_alpha[j] * ( x - p_sys->x[ch][1] ) +
-                          p_sys->f_gamma[j] * p_sys->y[ch][j][0] -
-                          p_sys->f_beta[j]  * p_sys->y[ch][j][1];
-
-                p_sys->y[ch][j][1] = p_sys->y[ch][j][0];
-                p_sys->y[ch][j][0] = y;
-
-                o += y * p_sys->f_amp[j];
-            }
-            p_sys->x[ch][1] = p_sys->x[ch][0];
-            p_sys->x[ch][0] = x;
-
-            /* Second filter */
-            if( p_sys->b_2eqz )
-            {
-                const float x2 = EQZ_IN_FACTOR * x + o;
-                o = 0.0f;
-                for( j = 0; j < p_sys->i_band; j++ )
-                {
-                    float y = p_sys->f_alpha[j] * ( x2 - p_sys->x2[ch][1] ) +
-                              p_sys->f_gamma[j] * p_sys->y2[ch][j][0] -
-                              p_sys->f_beta[j]  * p_sys->y2[ch][j][1];
-
-                    p_sys->y2[ch][j][1] = p_sys->y2[ch][j][0];
-                    p_sys->y2[ch][j][0] = y;
-
-                    o += y * p_sys->f_amp[j];
-                }
-                p_sys->x2[ch][1] = p_sys->x2[ch][0];
-                p_sys->x2[ch][0] = x2;
-
-                /* We add source PCM + filtered PCM */
-                out[ch] = p_sys->f_gamp * p_sys->f_gamp *( EQZ_IN_FACTOR * x2 + o );
-            }
-            else
-            {
-                /* We add source PCM + filtered PCM */
-                out[ch] = p_sys->f_gamp *( EQZ_IN_FACTOR * x + o );
-            }
+            /* We add source PCM + filtered PCM */
+            for( ch = 0; ch < i_channels; ch++ )
+                out[ch] = p_sys->f_gamp *( EQZ_IN_FACTOR * x[ch] + o[ch] );
         }
 
         in  += i_channels;
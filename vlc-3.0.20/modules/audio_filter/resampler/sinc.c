@@ -0,0 +1,650 @@
+/*****************************************************************************
+ * sinc.c : polyphase windowed-sinc resampler
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+#include <vlc_cpu.h>
+
+#define ZEROS_TEXT N_("Filter length")
+#define ZEROS_LONGTEXT N_( \
+    "Number of zero crossings of the interpolation filter on each side. " \
+    "Longer filters have a sharper cut-off, but use more CPU.")
+
+static int Open (vlc_object_t *);
+static int OpenResampler (vlc_object_t *);
+static void Close (vlc_object_t *);
+
+vlc_module_begin ()
+    set_shortname (N_("Sinc resampler"))
+    set_description (N_("Polyphase windowed-sinc resampler"))
+    set_category (CAT_AUDIO)
+    set_subcategory (SUBCAT_AUDIO_RESAMPLER)
+    add_integer ("sinc-resampler-zeros", 16, ZEROS_TEXT, ZEROS_LONGTEXT, true)
+        change_integer_range (4, 64)
+    set_capability ("audio converter", 10)
+    set_callbacks (Open, Close)
+
+    add_submodule ()
+    set_capability ("audio resampler", 10)
+    set_callbacks (OpenResampler, Close)
+    add_shortcut ("sinc")
+vlc_module_end ()
+
+/*
+ * The filter table holds the impulse response for PHASES + 1 evenly spaced
+ * fractional positions. The coefficients of positions in between are
+ * linearly interpolated, so that any ratio can be used without rebuilding
+ * the table: the clock drift compensation only changes the step between
+ * output frames.
+ *
+ * Positions are 32.32 fixed point numbers of input frames.
+ */
+#define PHASES_SHIFT 8
+#define PHASES (1 << PHASES_SHIFT)
+#define FRAC_SHIFT (32 - PHASES_SHIFT)
+
+/* Number of taps is a multiple of this, for the vector kernels */
+#define TAPS_ALIGN 16
+
+/* Pass band, relative to the lowest of the input and output Nyquist
+ * frequencies */
+#define PASS_BAND 0.95f
+
+/* Kaiser window parameter */
+#define KAISER_BETA 9.f
+
+struct filter_sys_t
+{
+    unsigned channels;
+    unsigned zeros;
+
+    float bandwidth; /* of the current table, relative to the input Nyquist */
+    unsigned taps;
+    float *coefs; /* PHASES + 1 rows of taps coefficients */
+    float *deltas; /* differences between consecutive rows */
+    float *row; /* coefficients interpolated for the current position */
+
+    /* Input history, one row of capacity frames per channel. Its first
+     * (taps / 2 - 1) frames are zeros when starting, so that the filter is
+     * centered on the first input frame. */
+    float *history;
+    size_t capacity;
+    size_t frames;
+    uint64_t pos; /* of the next output frame in the history */
+
+    void (*interp)(float *, const float *, const float *, float, unsigned);
+    float (*dot)(const float *, const float *, unsigned);
+};
+
+/*****************************************************************************
+ * Kernels: interp computes the coefficients for an intermediate position,
+ * dot applies them to taps frames of a channel.
+ *****************************************************************************/
+static void InterpC (float *row, const float *coefs, const float *deltas,
+                     float mu, unsigned taps)
+{
+    for (unsigned k = 0; k < taps; k++)
+        row[k] = coefs[k] + mu * deltas[k];
+}
+
+static float DotC (const float *x, const float *row, unsigned taps)
+{
+    float a0 = 0.f, a1 = 0.f, a2 = 0.f, a3 = 0.f;
+
+    for (unsigned k = 0; k < taps; k += 4)
+    {
+        a0 += x[k] * row[k];
+        a1 += x[k + 1] * row[k + 1];
+        a2 += x[k + 2] * row[k + 2];
+        a3 += x[k + 3] * row[k + 3];
+    }
+    return (a0 + a1) + (a2 + a3);
+}
+
+#ifdef HAVE_SSE2_INTRINSICS
+#include <xmmintrin.h>
+
+__attribute__ ((__target__ ("sse")))
+static void InterpSSE (float *row, const float *coefs, const float *deltas,
+                       float mu, unsigned taps)
+{
+    const __m128 m = _mm_set1_ps (mu);
+
+    for (unsigned k = 0; k < taps; k += 4)
+        _mm_storeu_ps (&row[k], _mm_add_ps (_mm_loadu_ps (&coefs[k]),
+                                   _mm_mul_ps (m, _mm_loadu_ps (&deltas[k]))));
+}
+
+__attribute__ ((__target__ ("sse")))
+static float DotSSE (const float *x, const float *row, unsigned taps)
+{
+    __m128 a0 = _mm_setzero_ps (), a1 = _mm_setzero_ps ();
+
+    for (unsigned k = 0; k < taps; k += 8)
+    {
+        a0 = _mm_add_ps (a0, _mm_mul_ps (_mm_loadu_ps (&x[k]),
+                                         _mm_loadu_ps (&row[k])));
+        a1 = _mm_add_ps (a1, _mm_mul_ps (_mm_loadu_ps (&x[k + 4]),
+                                         _mm_loadu_ps (&row[k + 4])));
+    }
+    a0 = _mm_add_ps (a0, a1);
+    a0 = _mm_add_ps (a0, _mm_movehl_ps (a0, a0));
+    a0 = _mm_add_ss (a0, _mm_shuffle_ps (a0, a0, 1));
+    return _mm_cvtss_f32 (a0);
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+#include <immintrin.h>
+
+__attribute__ ((__target__ ("avx")))
+static void InterpAVX (float *row, const float *coefs, const float *deltas,
+                       float mu, unsigned taps)
+{
+    const __m256 m = _mm256_set1_ps (mu);
+
+    for (unsigned k = 0; k < taps; k += 8)
+        _mm256_storeu_ps (&row[k], _mm256_add_ps (_mm256_loadu_ps (&coefs[k]),
+                                  _mm256_mul_ps (m, _mm256_loadu_ps (&deltas[k]))));
+}
+
+__attribute__ ((__target__ ("avx")))
+static float DotAVX (const float *x, const float *row, unsigned taps)
+{
+    __m256 a0 = _mm256_setzero_ps (), a1 = _mm256_setzero_ps ();
+
+    for (unsigned k = 0; k < taps; k += 16)
+    {
+        a0 = _mm256_add_ps (a0, _mm256_mul_ps (_mm256_loadu_ps (&x[k]),
+                                               _mm256_loadu_ps (&row[k])));
+        a1 = _mm256_add_ps (a1, _mm256_mul_ps (_mm256_loadu_ps (&x[k + 8]),
+                                               _mm256_loadu_ps (&row[k + 8])));
+    }
+    a0 = _mm256_add_ps (a0, a1);
+
+    __m128 s = _mm_add_ps (_mm256_castps256_ps128 (a0),
+                           _mm256_extractf128_ps (a0, 1));
+    s = _mm_add_ps (s, _mm_movehl_ps (s, s));
+    s = _mm_add_ss (s, _mm_shuffle_ps (s, s, 1));
+    return _mm_cvtss_f32 (s);
+}
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+
+static void InterpNEON (float *row, const float *coefs, const float *deltas,
+                        float mu, unsigned taps)
+{
+    for (unsigned k = 0; k < taps; k += 4)
+        vst1q_f32 (&row[k], vmlaq_n_f32 (vld1q_f32 (&coefs[k]),
+                                         vld1q_f32 (&deltas[k]), mu));
+}
+
+static float DotNEON (const float *x, const float *row, unsigned taps)
+{
+    float32x4_t a0 = vdupq_n_f32 (0.f), a1 = vdupq_n_f32 (0.f);
+
+    for (unsigned k = 0; k < taps; k += 8)
+    {
+        a0 = vmlaq_f32 (a0, vld1q_f32 (&x[k]), vld1q_f32 (&row[k]));
+        a1 = vmlaq_f32 (a1, vld1q_f32 (&x[k + 4]), vld1q_f32 (&row[k + 4]));
+    }
+    return vaddvq_f32 (vaddq_f32 (a0, a1));
+}
+#endif
+
+struct sinc_kernels
+{
+    void (*interp)(float *, const float *, const float *, float, unsigned);
+    float (*dot)(const float *, const float *, unsigned);
+};
+
+static const vlc_cpu_kernel_t sinc_kernels[] = {
+#if defined(__aarch64__) && defined(__ARM_NEON)
+    { "neon", 0, &(const struct sinc_kernels){ InterpNEON, DotNEON } },
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    { "avx", VLC_CPU_AVX, &(const struct sinc_kernels){ InterpAVX, DotAVX } },
+#endif
+#ifdef HAVE_SSE2_INTRINSICS
+    { "sse", VLC_CPU_SSE, &(const struct sinc_kernels){ InterpSSE, DotSSE } },
+#endif
+    { "c", 0, &(const struct sinc_kernels){ InterpC, DotC } },
+};
+
+/*****************************************************************************
+ * Filter table
+ *****************************************************************************/
+/* Modified Bessel function of the first kind, order 0 */
+static double BesselI0 (double x)
+{
+    double sum = 1., term = 1.;
+
+    for (unsigned k = 1; term > sum * 1e-12; k++)
+    {
+        term *= (x / (2. * k)) * (x / (2. * k));
+        sum += term;
+    }
+    return sum;
+}
+
+/**
+ * Computes the filter table for a bandwidth relative to the input Nyquist
+ * frequency, and moves the history so that it stays centered on the same
+ * position if the number of taps changes.
+ */
+static int SetupTable (filter_sys_t *sys, float bandwidth)
+{
+    const double half = sys->zeros / bandwidth;
+    unsigned taps = 2 * ceil (half);
+    taps = (taps + TAPS_ALIGN - 1) & ~(TAPS_ALIGN - 1);
+
+    const size_t size = (PHASES + 1) * taps;
+    float *coefs = vlc_alloc (size, sizeof (*coefs));
+    float *deltas = vlc_alloc (size, sizeof (*deltas));
+    float *row = vlc_alloc (taps, sizeof (*row));
+    if (unlikely(coefs == NULL || deltas == NULL || row == NULL))
+    {
+        free (coefs);
+        free (deltas);
+        free (row);
+        return VLC_ENOMEM;
+    }
+
+    const double i0_beta = BesselI0 (KAISER_BETA);
+    for (unsigned p = 0; p <= PHASES; p++)
+    {
+        float *h = &coefs[p * taps];
+        double sum = 0.;
+
+        for (unsigned k = 0; k < taps; k++)
+        {
+            /* Distance to the output position, in input frames */
+            const double x = (double)k - (taps / 2 - 1) - (double)p / PHASES;
+            const double w = x / half;
+            double v = 0.;
+
+            if (fabs (w) < 1.)
+            {
+                const double t = M_PI * bandwidth * x;
+                v = (t != 0. ? sin (t) / t : 1.)
+                  * BesselI0 (KAISER_BETA * sqrt (1. - w * w)) / i0_beta;
+            }
+            h[k] = v;
+            sum += v;
+        }
+        for (unsigned k = 0; k < taps; k++)
+            h[k] /= sum; /* unity gain for all the phases */
+    }
+    for (unsigned p = 0; p < PHASES; p++)
+        for (unsigned k = 0; k < taps; k++)
+            deltas[p * taps + k] = coefs[(p + 1) * taps + k]
+                                 - coefs[p * taps + k];
+    memset (&deltas[PHASES * taps], 0, taps * sizeof (*deltas));
+
+    /* Keep the center of the filter on the same input frame */
+    int64_t shift = (int64_t)(taps / 2) - (int64_t)(sys->taps / 2);
+    int64_t start = (int64_t)(sys->pos >> 32) - shift;
+
+    if (sys->taps == 0)
+    {   /* Prime the history */
+        sys->frames = 0;
+        sys->pos = 0;
+        start = 1 - (int64_t)(taps / 2);
+    }
+
+    if (start < 0)
+    {   /* Prepend silence */
+        const size_t pad = -start;
+
+        if (sys->frames + pad > sys->capacity)
+        {
+            const size_t capacity = sys->frames + pad + taps;
+            float *history = vlc_alloc (capacity * sys->channels,
+                                        sizeof (*history));
+            if (unlikely(history == NULL))
+            {
+                free (coefs);
+                free (deltas);
+                free (row);
+                return VLC_ENOMEM;
+            }
+            for (unsigned c = 0; c < sys->channels; c++)
+                memcpy (&history[c * capacity],
+                        &sys->history[c * sys->capacity],
+                        sys->frames * sizeof (*history));
+            free (sys->history);
+            sys->history = history;
+            sys->capacity = capacity;
+        }
+        for (unsigned c = 0; c < sys->channels; c++)
+        {
+            float *h = &sys->history[c * sys->capacity];
+
+            memmove (&h[pad], h, sys->frames * sizeof (*h));
+            memset (h, 0, pad * sizeof (*h));
+        }
+        sys->frames += pad;
+        start = 0;
+    }
+    sys->pos = ((uint64_t)start << 32) | (uint32_t)sys->pos;
+
+    free (sys->coefs);
+    free (sys->deltas);
+    free (sys->row);
+    sys->coefs = coefs;
+    sys->deltas = deltas;
+    sys->row = row;
+    sys->taps = taps;
+    sys->bandwidth = bandwidth;
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Processing
+ *****************************************************************************/
+/**
+ * Appends frames to the history
+ */
+static int Append (filter_sys_t *sys, const block_t *in, vlc_fourcc_t format)
+{
+    const unsigned channels = sys->channels;
+    const size_t frames = in->i_nb_samples;
+
+    if (sys->frames + frames > sys->capacity)
+    {
+        const size_t capacity = sys->frames + frames + sys->taps;
+        float *history = vlc_alloc (capacity * channels, sizeof (*history));
+        if (unlikely(history == NULL))
+            return VLC_ENOMEM;
+
+        for (unsigned c = 0; c < channels; c++)
+            memcpy (&history[c * capacity], &sys->history[c * sys->capacity],
+                    sys->frames * sizeof (*history));
+        free (sys->history);
+        sys->history = history;
+        sys->capacity = capacity;
+    }
+
+    for (unsigned c = 0; c < channels; c++)
+    {
+        float *dst = &sys->history[c * sys->capacity + sys->frames];
+
+        if (format == VLC_CODEC_FL32)
+        {
+            const float *src = (const float *)in->p_buffer + c;
+            for (size_t i = 0; i < frames; i++)
+                dst[i] = src[i * channels];
+        }
+        else
+        {
+            const int16_t *src = (const int16_t *)in->p_buffer + c;
+            for (size_t i = 0; i < frames; i++)
+                dst[i] = src[i * channels] * (1.f / 32768.f);
+        }
+    }
+    sys->frames += frames;
+    return VLC_SUCCESS;
+}
+
+/**
+ * Returns how many frames can be output from the history
+ */
+static size_t Available (const filter_sys_t *sys, uint64_t step)
+{
+    if (sys->frames < sys->taps)
+        return 0;
+
+    const uint64_t last = ((uint64_t)(sys->frames - sys->taps) << 32)
+                        | UINT32_MAX;
+    return sys->pos <= last ? (last - sys->pos) / step + 1 : 0;
+}
+
+/**
+ * Outputs count frames, and drops the input frames not needed anymore
+ */
+static void Process (filter_sys_t *sys, void *out, size_t count,
+                     uint64_t step, vlc_fourcc_t format)
+{
+    const unsigned channels = sys->channels;
+    const unsigned taps = sys->taps;
+
+    for (size_t n = 0; n < count; n++)
+    {
+        const size_t i = sys->pos >> 32;
+        const uint32_t frac = sys->pos;
+        const unsigned p = frac >> FRAC_SHIFT;
+        const float mu = (frac & ((1u << FRAC_SHIFT) - 1))
+                       * (1.f / (1u << FRAC_SHIFT));
+
+        sys->interp (sys->row, &sys->coefs[p * taps], &sys->deltas[p * taps],
+                     mu, taps);
+
+        for (unsigned c = 0; c < channels; c++)
+        {
+            float v = sys->dot (&sys->history[c * sys->capacity + i],
+                                sys->row, taps);
+
+            if (format == VLC_CODEC_FL32)
+                ((float *)out)[n * channels + c] = v;
+            else
+            {
+                long s = lrintf (v * 32768.f);
+                ((int16_t *)out)[n * channels + c] =
+                    VLC_CLIP (s, INT16_MIN, INT16_MAX);
+            }
+        }
+        sys->pos += step;
+    }
+
+    const size_t drop = __MIN(sys->pos >> 32, sys->frames);
+    if (drop > 0)
+    {
+        for (unsigned c = 0; c < channels; c++)
+        {
+            float *h = &sys->history[c * sys->capacity];
+            memmove (h, &h[drop], (sys->frames - drop) * sizeof (*h));
+        }
+        sys->frames -= drop;
+        sys->pos -= (uint64_t)drop << 32;
+    }
+}
+
+static block_t *Output (filter_t *filter, size_t count, uint64_t step)
+{
+    filter_sys_t *sys = filter->p_sys;
+    const audio_format_t *fmt = &filter->fmt_out.audio;
+
+    block_t *out = block_Alloc (count * fmt->i_bytes_per_frame);
+    if (unlikely(out == NULL))
+        return NULL;
+
+    Process (sys, out->p_buffer, count, step, fmt->i_format);
+    out->i_nb_samples = count;
+    out->i_length = count * CLOCK_FREQ / fmt->i_rate;
+    return out;
+}
+
+static uint64_t GetStep (const filter_t *filter)
+{
+    return ((uint64_t)filter->fmt_in.audio.i_rate << 32)
+           / filter->fmt_out.audio.i_rate;
+}
+
+static float GetBandwidth (const filter_t *filter)
+{
+    const unsigned irate = filter->fmt_in.audio.i_rate;
+    const unsigned orate = filter->fmt_out.audio.i_rate;
+
+    return PASS_BAND * (orate < irate ? (float)orate / irate : 1.f);
+}
+
+static block_t *Resample (filter_t *filter, block_t *in)
+{
+    filter_sys_t *sys = filter->p_sys;
+    block_t *out = NULL;
+
+    /* The table only follows large rate changes (playback rate), not the
+     * drift compensation */
+    const float bandwidth = GetBandwidth (filter);
+    if (fabsf (bandwidth - sys->bandwidth) > 0.02f * sys->bandwidth
+     && SetupTable (sys, bandwidth))
+        goto error;
+
+    if (Append (sys, in, filter->fmt_in.audio.i_format))
+        goto error;
+
+    const uint64_t step = GetStep (filter);
+    const size_t count = Available (sys, step);
+    if (count == 0)
+        goto error;
+
+    out = Output (filter, count, step);
+    if (likely(out != NULL))
+        out->i_pts = in->i_pts;
+error:
+    block_Release (in);
+    return out;
+}
+
+static void Reset (filter_sys_t *sys)
+{
+    const size_t pad = sys->taps / 2 - 1;
+
+    for (unsigned c = 0; c < sys->channels; c++)
+        memset (&sys->history[c * sys->capacity], 0,
+                pad * sizeof (*sys->history));
+    sys->frames = pad;
+    sys->pos = 0;
+}
+
+static block_t *Drain (filter_t *filter)
+{
+    filter_sys_t *sys = filter->p_sys;
+    const size_t pad = sys->taps / 2;
+    block_t silence = { .i_nb_samples = pad };
+
+    /* Push the last input frames to the center of the filter */
+    silence.p_buffer = calloc (pad, filter->fmt_in.audio.i_bytes_per_frame);
+    if (unlikely(silence.p_buffer == NULL))
+        return NULL;
+
+    block_t *out = NULL;
+    if (Append (sys, &silence, filter->fmt_in.audio.i_format) == VLC_SUCCESS)
+    {
+        const uint64_t step = GetStep (filter);
+        const size_t count = Available (sys, step);
+
+        if (count > 0)
+            out = Output (filter, count, step);
+    }
+    free (silence.p_buffer);
+    Reset (sys);
+    return out;
+}
+
+static void Flush (filter_t *filter)
+{
+    Reset (filter->p_sys);
+}
+
+static int OpenResampler (vlc_object_t *obj)
+{
+    filter_t *filter = (filter_t *)obj;
+    const audio_format_t *infmt = &filter->fmt_in.audio;
+    const audio_format_t *outfmt = &filter->fmt_out.audio;
+
+    /* Cannot convert format */
+    if (infmt->i_format != outfmt->i_format
+    /* Cannot remix */
+     || infmt->i_channels != outfmt->i_channels || infmt->i_channels == 0)
+        return VLC_EGENERIC;
+
+    switch (infmt->i_format)
+    {
+        case VLC_CODEC_FL32: break;
+        case VLC_CODEC_S16N: break;
+        default:             return VLC_EGENERIC;
+    }
+
+    filter_sys_t *sys = malloc (sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return VLC_ENOMEM;
+
+    sys->channels = infmt->i_channels;
+    sys->zeros = var_InheritInteger (obj, "sinc-resampler-zeros");
+    sys->taps = 0;
+    sys->coefs = sys->deltas = sys->row = NULL;
+    sys->history = NULL;
+    sys->capacity = sys->frames = 0;
+    sys->pos = 0;
+
+    const struct sinc_kernels *kernels =
+        vlc_CPU_SelectKernel ("resampler-sinc", sinc_kernels,
+                              ARRAY_SIZE(sinc_kernels));
+    sys->interp = kernels->interp;
+    sys->dot = kernels->dot;
+
+    if (SetupTable (sys, GetBandwidth (filter)))
+    {
+        free (sys);
+        return VLC_ENOMEM;
+    }
+    msg_Dbg (obj, "%u taps, %u Hz -> %u Hz", sys->taps, infmt->i_rate,
+             outfmt->i_rate);
+
+    filter->p_sys = sys;
+    filter->pf_audio_filter = Resample;
+    filter->pf_audio_drain = Drain;
+    filter->pf_flush = Flush;
+    filter->b_audio_chunks = true;
+    return VLC_SUCCESS;
+}
+
+static int Open (vlc_object_t *obj)
+{
+    filter_t *filter = (filter_t *)obj;
+
+    /* Will change rate */
+    if (filter->fmt_in.audio.i_rate == filter->fmt_out.audio.i_rate)
+        return VLC_EGENERIC;
+    return OpenResampler (obj);
+}
+
+static void Close (vlc_object_t *obj)
+{
+    filter_t *filter = (filter_t *)obj;
+    filter_sys_t *sys = filter->p_sys;
+
+    free (sys->history);
+    free (sys->row);
+    free (sys->deltas);
+    free (sys->coefs);
+    free (sys);
+}
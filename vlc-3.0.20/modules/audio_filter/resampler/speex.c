@@ -94,6 +94,7 @@ static int OpenResampler (vlc_object_t *obj)
 
     filter->p_sys = (filter_sys_t *)st;
     filter->pf_audio_filter = Resample;
+    filter->b_audio_chunks = true;
     return VLC_SUCCESS;
 }
 
@@ -105,6 +105,7 @@ static int OpenResampler (vlc_object_t *obj)
 
     filter->p_sys = (filter_sys_t *)s;
     filter->pf_audio_filter = Resample;
+    filter->b_audio_chunks = true;
     return VLC_SUCCESS;
 }
 
@@ -29,6 +29,7 @@
 #endif
 
 #include <vlc_common.h>
+#include <vlc_cpu.h>
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_filter.h>
@@ -69,6 +70,10 @@ vlc_module_begin ()
         N_("Overlap Length"), N_("Percentage of stride to overlap"), true )
     add_integer_with_range( "scaletempo-search", 14, 0, 200,
         N_("Search Length"), N_("Length in milliseconds to search for best overlap position"), true )
+    add_bool( "scaletempo-fast-search", false,
+        N_("Fast Search"), N_("Search for the best overlap position on a mono downmix "
+        "with a coarse step, then refine it. This is much cheaper with multichannel "
+        "audio and works well with speech"), true )
 #ifdef PITCH_SHIFTER
     add_float_with_range( "pitch-shift", 0, -12, 12,
         N_("Pitch Shift"), N_("Pitch shift in semitones."), false )
@@ -126,10 +131,14 @@ struct filter_sys_t
     void     *table_blend;
     void    (*output_overlap)( filter_t *p_filter, void *p_out_buf, unsigned bytes_off );
     /* best overlap */
+    bool      b_fast_search;
     unsigned  frames_search;
+    unsigned  frames_search_step;
     void     *buf_pre_corr;
     void     *table_window;
+    float    *buf_search_mono;
     unsigned(*best_overlap_offset)( filter_t *p_filter );
+    float   (*dot_product)( const float *, const float *, unsigned );
 #ifdef PITCH_SHIFTER
     /* pitch */
     filter_t * resampler;
@@ -137,6 +146,82 @@ struct filter_sys_t
 #endif
 };
 
+/*****************************************************************************
+ * dot_product: cross correlation kernels
+ *****************************************************************************/
+static float dot_product_c( const float *a, const float *b, unsigned n )
+{
+    /* Independent partial sums, so that the loop is not bound by the latency
+     * of a single accumulator */
+    float s0 = 0.f, s1 = 0.f, s2 = 0.f, s3 = 0.f;
+    unsigned i = 0;
+    for( ; i + 4 <= n; i += 4 ) {
+        s0 += a[i]   * b[i];
+        s1 += a[i+1] * b[i+1];
+        s2 += a[i+2] * b[i+2];
+        s3 += a[i+3] * b[i+3];
+    }
+    for( ; i < n; i++ )
+        s0 += a[i] * b[i];
+    return ( s0 + s1 ) + ( s2 + s3 );
+}
+
+#ifdef HAVE_SSE2_INTRINSICS
+#include <xmmintrin.h>
+
+__attribute__ ((__target__ ("sse")))
+static float dot_product_sse( const float *a, const float *b, unsigned n )
+{
+    __m128 s0 = _mm_setzero_ps();
+    __m128 s1 = _mm_setzero_ps();
+    unsigned i = 0;
+    for( ; i + 8 <= n; i += 8 ) {
+        s0 = _mm_add_ps( s0, _mm_mul_ps( _mm_loadu_ps( a + i ),
+                                         _mm_loadu_ps( b + i ) ) );
+        s1 = _mm_add_ps( s1, _mm_mul_ps( _mm_loadu_ps( a + i + 4 ),
+                                         _mm_loadu_ps( b + i + 4 ) ) );
+    }
+
+    float sum[4];
+    _mm_storeu_ps( sum, _mm_add_ps( s0, s1 ) );
+    float corr = ( sum[0] + sum[1] ) + ( sum[2] + sum[3] );
+    for( ; i < n; i++ )
+        corr += a[i] * b[i];
+    return corr;
+}
+
+static bool dot_product_simd_usable( void )
+{
+    return vlc_CPU_SSE();
+}
+# define dot_product_simd dot_product_sse
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+
+static float dot_product_neon( const float *a, const float *b, unsigned n )
+{
+    float32x4_t s0 = vdupq_n_f32( 0.f );
+    float32x4_t s1 = vdupq_n_f32( 0.f );
+    unsigned i = 0;
+    for( ; i + 8 <= n; i += 8 ) {
+        s0 = vmlaq_f32( s0, vld1q_f32( a + i ), vld1q_f32( b + i ) );
+        s1 = vmlaq_f32( s1, vld1q_f32( a + i + 4 ), vld1q_f32( b + i + 4 ) );
+    }
+
+    float corr = vaddvq_f32( vaddq_f32( s0, s1 ) );
+    for( ; i < n; i++ )
+        corr += a[i] * b[i];
+    return corr;
+}
+
+static bool dot_product_simd_usable( void )
+{
+    return true;
+}
+# define dot_product_simd dot_product_neon
+#endif
+
 /*****************************************************************************
  * best_overlap_offset: calculate best offset for overlap
  *****************************************************************************/
@@ -147,6 +232,7 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
     float best_corr = INT_MIN;
     unsigned best_off = 0;
     unsigned i, off;
+    const unsigned samples_corr = p->samples_overlap - p->samples_per_frame;
 
     pw  = p->table_window;
     po  = p->buf_overlap;
@@ -158,12 +244,7 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
 
     search_start = (float *)p->buf_queue + p->samples_per_frame;
     for( off = 0; off < p->frames_search; off++ ) {
-      float corr = 0;
-      float *ps = search_start;
-      ppc = p->buf_pre_corr;
-      for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
-        corr += *ppc++ * *ps++;
-      }
+      float corr = p->dot_product( p->buf_pre_corr, search_start, samples_corr );
       if( corr > best_corr ) {
         best_corr = corr;
         best_off  = off;
@@ -174,6 +255,68 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
     return best_off * p->bytes_per_frame;
 }
 
+/*****************************************************************************
+ * best_overlap_offset_mono: coarse to fine search on a mono downmix
+ *****************************************************************************/
+static unsigned best_overlap_offset_mono( filter_t *p_filter )
+{
+    filter_sys_t *p = p_filter->p_sys;
+    const unsigned nch = p->samples_per_frame;
+    const unsigned frames_corr = p->samples_overlap / nch - 1;
+    const unsigned step = p->frames_search_step;
+    const float *pw = p->table_window;
+    const float *pin;
+    float *pout;
+    float best_corr = INT_MIN;
+    unsigned best_off = 0;
+    unsigned i, ch, off;
+
+    /* Windowed downmix of the overlap (the window is the same on all channels) */
+    pin  = (float *)p->buf_overlap + nch;
+    pout = p->buf_pre_corr;
+    for( i = 0; i < frames_corr; i++ ) {
+      float sum = 0;
+      for( ch = 0; ch < nch; ch++ )
+        sum += *pin++;
+      *pout++ = pw[i * nch] * sum;
+    }
+
+    /* Downmix of the search area */
+    pin  = (float *)p->buf_queue + nch;
+    pout = p->buf_search_mono;
+    for( i = 0; i < p->frames_search - 1 + frames_corr; i++ ) {
+      float sum = 0;
+      for( ch = 0; ch < nch; ch++ )
+        sum += *pin++;
+      *pout++ = sum;
+    }
+
+    for( off = 0; off < p->frames_search; off += step ) {
+      float corr = p->dot_product( p->buf_pre_corr, p->buf_search_mono + off, frames_corr );
+      if( corr > best_corr ) {
+        best_corr = corr;
+        best_off  = off;
+      }
+    }
+
+    /* Refine around the best coarse position */
+    if( step > 1 ) {
+      const unsigned coarse_off = best_off;
+      const unsigned off_end = __MIN( coarse_off + step, p->frames_search );
+      for( off = coarse_off >= step ? coarse_off - step + 1 : 0; off < off_end; off++ ) {
+        if( off == coarse_off )
+          continue;
+        float corr = p->dot_product( p->buf_pre_corr, p->buf_search_mono + off, frames_corr );
+        if( corr > best_corr ) {
+          best_corr = corr;
+          best_off  = off;
+        }
+      }
+    }
+
+    return best_off * p->bytes_per_frame;
+}
+
 /*****************************************************************************
  * output_overlap: blend end of previous stride with beginning of current stride
  *****************************************************************************/
@@ -361,7 +504,20 @@ static int reinit_buffers( filter_t *p_filter )
             for( j = 0; j < p->samples_per_frame; j++ )
                 *pw++ = v;
         }
-        p->best_overlap_offset = best_overlap_offset_float;
+
+        if( p->b_fast_search )
+        {
+            p->frames_search_step = __MAX( 1, p->sample_rate / 8000 );
+            p->buf_search_mono = vlc_alloc( p->frames_search + frames_overlap, sizeof(float) );
+            if( ! p->buf_search_mono )
+                return VLC_ENOMEM;
+            p->best_overlap_offset = best_overlap_offset_mono;
+        }
+        else
+        {
+            p->frames_search_step = 1;
+            p->best_overlap_offset = best_overlap_offset_float;
+        }
     }
 
     unsigned new_size = ( p->frames_search + frames_stride + frames_overlap ) * p->bytes_per_frame;
@@ -391,13 +547,14 @@ static int reinit_buffers( filter_t *p_filter )
     p->frames_stride_scaled = p->bytes_stride_scaled / p->bytes_per_frame;
 
     msg_Dbg( VLC_OBJECT(p_filter),
-             "%.3f scale, %.3f stride_in, %i stride_out, %i standing, %i overlap, %i search, %i queue, %s mode",
+             "%.3f scale, %.3f stride_in, %i stride_out, %i standing, %i overlap, %i search (step %u), %i queue, %s mode",
              p->scale,
              p->frames_stride_scaled,
              (int)( p->bytes_stride / p->bytes_per_frame ),
              (int)( p->bytes_standing / p->bytes_per_frame ),
              (int)( p->bytes_overlap / p->bytes_per_frame ),
              p->frames_search,
+             p->frames_search_step,
              (int)( p->bytes_queue_max / p->bytes_per_frame ),
              "fl32");
 
@@ -431,15 +588,25 @@ static int Open( vlc_object_t *p_this )
     p_sys->ms_stride       = var_InheritInteger( p_this, "scaletempo-stride" );
     p_sys->percent_overlap = var_InheritFloat( p_this, "scaletempo-overlap" );
     p_sys->ms_search       = var_InheritInteger( p_this, "scaletempo-search" );
+    p_sys->b_fast_search   = var_InheritBool( p_this, "scaletempo-fast-search" );
+
+    msg_Dbg( p_this, "params: %i stride, %.3f overlap, %i search%s",
+             p_sys->ms_stride, p_sys->percent_overlap, p_sys->ms_search,
+             p_sys->b_fast_search ? " (fast)" : "" );
 
-    msg_Dbg( p_this, "params: %i stride, %.3f overlap, %i search",
-             p_sys->ms_stride, p_sys->percent_overlap, p_sys->ms_search );
+    p_sys->dot_product = dot_product_c;
+#ifdef dot_product_simd
+    if( dot_product_simd_usable() )
+        p_sys->dot_product = dot_product_simd;
+#endif
 
     p_sys->buf_queue      = NULL;
     p_sys->buf_overlap    = NULL;
     p_sys->table_blend    = NULL;
     p_sys->buf_pre_corr   = NULL;
     p_sys->table_window   = NULL;
+    p_sys->buf_search_mono = NULL;
+    p_sys->frames_search_step = 1;
     p_sys->bytes_overlap  = 0;
     p_sys->bytes_queued   = 0;
     p_sys->bytes_to_slide = 0;
@@ -455,6 +622,7 @@ static int Open( vlc_object_t *p_this )
     aout_FormatPrepare(&p_filter->fmt_in.audio);
     p_filter->fmt_out.audio = p_filter->fmt_in.audio;
     p_filter->pf_audio_filter = DoWork;
+    p_filter->b_audio_chunks = true;
 
     return VLC_SUCCESS;
 }
@@ -536,6 +704,7 @@ static void Close( vlc_object_t *p_this )
     free( p_sys->table_blend );
     free( p_sys->buf_pre_corr );
     free( p_sys->table_window );
+    free( p_sys->buf_search_mono );
     free( p_sys );
 }
 
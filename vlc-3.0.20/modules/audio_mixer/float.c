@@ -29,9 +29,11 @@
 # include "config.h"
 #endif
 
+#include <math.h>
 #include <stddef.h>
 #include <vlc_common.h>
 #include <vlc_plugin.h>
+#include <vlc_cpu.h>
 #include <vlc_aout.h>
 #include <vlc_aout_volume.h>
 
@@ -39,6 +41,7 @@
  * Local prototypes
  *****************************************************************************/
 static int Create( vlc_object_t * );
+static void Destroy( vlc_object_t * );
 
 /*****************************************************************************
  * Module descriptor
@@ -48,37 +51,267 @@ vlc_module_begin ()
     set_subcategory( SUBCAT_AUDIO_MISC )
     set_description( N_("Single precision audio volume") )
     set_capability( "audio volume", 10 )
-    set_callbacks( Create, NULL )
+    set_callbacks( Create, Destroy )
 vlc_module_end ()
 
+struct audio_volume_sys
+{
+    float f_last; /* multiplier applied to the end of the previous buffer */
+
+    /* Position of each sample of a buffer within the gain ramp, from its
+     * first frame (excluded) to its last one (1.0), so that all channels of
+     * a frame get the same gain. Rebuilt only when the buffer layout
+     * changes. */
+    float *p_ramp;
+    size_t i_ramp_samples;
+    unsigned i_ramp_frames;
+
+    void (*pf_amplify)( float *, size_t, float );
+    void (*pf_ramp)( float *, const float *, size_t, float, float );
+};
+
+/*****************************************************************************
+ * Kernels: pf_amplify multiplies i_count samples by f_mult, pf_ramp by
+ * f_from + f_delta * p_ramp[i].
+ *****************************************************************************/
+static void AmplifyC( float *p, size_t i_count, float f_mult )
+{
+    for( size_t i = 0; i < i_count; i++ )
+        p[i] *= f_mult;
+}
+
+static void RampC( float *p, const float *p_ramp, size_t i_count,
+                   float f_from, float f_delta )
+{
+    for( size_t i = 0; i < i_count; i++ )
+        p[i] *= f_from + f_delta * p_ramp[i];
+}
+
+#ifdef HAVE_SSE2_INTRINSICS
+#include <xmmintrin.h>
+
+__attribute__ ((__target__ ("sse")))
+static void AmplifySSE( float *p, size_t i_count, float f_mult )
+{
+    const __m128 mult = _mm_set1_ps( f_mult );
+    size_t i = 0;
+
+    for( ; i + 8 <= i_count; i += 8 )
+    {
+        _mm_storeu_ps( &p[i],     _mm_mul_ps( _mm_loadu_ps( &p[i] ), mult ) );
+        _mm_storeu_ps( &p[i + 4], _mm_mul_ps( _mm_loadu_ps( &p[i + 4] ), mult ) );
+    }
+    AmplifyC( &p[i], i_count - i, f_mult );
+}
+
+__attribute__ ((__target__ ("sse")))
+static void RampSSE( float *p, const float *p_ramp, size_t i_count,
+                     float f_from, float f_delta )
+{
+    const __m128 from = _mm_set1_ps( f_from );
+    const __m128 delta = _mm_set1_ps( f_delta );
+    size_t i = 0;
+
+    for( ; i + 4 <= i_count; i += 4 )
+    {
+        __m128 gain = _mm_add_ps( from, _mm_mul_ps( delta,
+                                                    _mm_loadu_ps( &p_ramp[i] ) ) );
+        _mm_storeu_ps( &p[i], _mm_mul_ps( _mm_loadu_ps( &p[i] ), gain ) );
+    }
+    RampC( &p[i], &p_ramp[i], i_count - i, f_from, f_delta );
+}
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+#include <immintrin.h>
+
+__attribute__ ((__target__ ("avx")))
+static void AmplifyAVX( float *p, size_t i_count, float f_mult )
+{
+    const __m256 mult = _mm256_set1_ps( f_mult );
+    size_t i = 0;
+
+    for( ; i + 16 <= i_count; i += 16 )
+    {
+        _mm256_storeu_ps( &p[i],
+                          _mm256_mul_ps( _mm256_loadu_ps( &p[i] ), mult ) );
+        _mm256_storeu_ps( &p[i + 8],
+                          _mm256_mul_ps( _mm256_loadu_ps( &p[i + 8] ), mult ) );
+    }
+    AmplifyC( &p[i], i_count - i, f_mult );
+}
+
+__attribute__ ((__target__ ("avx")))
+static void RampAVX( float *p, const float *p_ramp, size_t i_count,
+                     float f_from, float f_delta )
+{
+    const __m256 from = _mm256_set1_ps( f_from );
+    const __m256 delta = _mm256_set1_ps( f_delta );
+    size_t i = 0;
+
+    for( ; i + 8 <= i_count; i += 8 )
+    {
+        __m256 gain = _mm256_add_ps( from,
+                          _mm256_mul_ps( delta, _mm256_loadu_ps( &p_ramp[i] ) ) );
+        _mm256_storeu_ps( &p[i], _mm256_mul_ps( _mm256_loadu_ps( &p[i] ), gain ) );
+    }
+    RampC( &p[i], &p_ramp[i], i_count - i, f_from, f_delta );
+}
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+
+static void AmplifyNEON( float *p, size_t i_count, float f_mult )
+{
+    size_t i = 0;
+
+    for( ; i + 8 <= i_count; i += 8 )
+    {
+        vst1q_f32( &p[i],     vmulq_n_f32( vld1q_f32( &p[i] ), f_mult ) );
+        vst1q_f32( &p[i + 4], vmulq_n_f32( vld1q_f32( &p[i + 4] ), f_mult ) );
+    }
+    AmplifyC( &p[i], i_count - i, f_mult );
+}
+
+static void RampNEON( float *p, const float *p_ramp, size_t i_count,
+                      float f_from, float f_delta )
+{
+    const float32x4_t from = vdupq_n_f32( f_from );
+    size_t i = 0;
+
+    for( ; i + 4 <= i_count; i += 4 )
+    {
+        float32x4_t gain = vmlaq_n_f32( from, vld1q_f32( &p_ramp[i] ), f_delta );
+        vst1q_f32( &p[i], vmulq_f32( vld1q_f32( &p[i] ), gain ) );
+    }
+    RampC( &p[i], &p_ramp[i], i_count - i, f_from, f_delta );
+}
+#endif
+
+struct volume_kernels
+{
+    void (*amplify)( float *, size_t, float );
+    void (*ramp)( float *, const float *, size_t, float, float );
+};
+
+static const vlc_cpu_kernel_t volume_kernels[] = {
+#if defined(__aarch64__) && defined(__ARM_NEON)
+    { "neon", 0, &(const struct volume_kernels){ AmplifyNEON, RampNEON } },
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    { "avx", VLC_CPU_AVX, &(const struct volume_kernels){ AmplifyAVX, RampAVX } },
+#endif
+#ifdef HAVE_SSE2_INTRINSICS
+    { "sse", VLC_CPU_SSE, &(const struct volume_kernels){ AmplifySSE, RampSSE } },
+#endif
+    { "c", 0, &(const struct volume_kernels){ AmplifyC, RampC } },
+};
+
+/**
+ * Prepares the ramp for a buffer of i_samples samples and i_frames frames
+ *
+ * \return the ramp or NULL on error
+ */
+static const float *GetRamp( struct audio_volume_sys *p_sys,
+                             size_t i_samples, unsigned i_frames )
+{
+    if( i_frames == 0 || i_samples % i_frames != 0 )
+        i_frames = i_samples; /* unknown layout: ramp per sample */
+
+    if( p_sys->p_ramp != NULL && p_sys->i_ramp_samples == i_samples
+     && p_sys->i_ramp_frames == i_frames )
+        return p_sys->p_ramp;
+
+    float *p_ramp = realloc( p_sys->p_ramp, i_samples * sizeof(*p_ramp) );
+    if( unlikely(p_ramp == NULL) )
+        return NULL;
+    p_sys->p_ramp = p_ramp;
+    p_sys->i_ramp_samples = i_samples;
+    p_sys->i_ramp_frames = i_frames;
+
+    const size_t i_channels = i_samples / i_frames;
+    for( unsigned i = 0; i < i_frames; i++ )
+    {
+        const float f_pos = (float)(i + 1) / i_frames;
+        for( size_t j = 0; j < i_channels; j++ )
+            *(p_ramp++) = f_pos;
+    }
+    return p_sys->p_ramp;
+}
+
+/**
+ * Returns the multiplier at the start of the buffer and remembers the one
+ * at its end; both are the same unless the volume changed.
+ */
+static float UpdateMultiplier( struct audio_volume_sys *p_sys,
+                               float f_multiplier )
+{
+    float f_from = p_sys->f_last;
+
+    p_sys->f_last = f_multiplier;
+    return isnan( f_from ) ? f_multiplier : f_from;
+}
+
 /**
  * Mixes a new output buffer
+ *
+ * Volume changes are ramped linearly over the buffer to avoid zipper
+ * noise.
  */
 static void FilterFL32( audio_volume_t *p_volume, block_t *p_buffer,
                         float f_multiplier )
 {
+    struct audio_volume_sys *p_sys = p_volume->sys;
+    float *p = (float *)p_buffer->p_buffer;
+    const size_t i_count = p_buffer->i_buffer / sizeof(*p);
+    const float f_from = UpdateMultiplier( p_sys, f_multiplier );
+
+    if( f_from != f_multiplier )
+    {
+        const float *p_ramp = GetRamp( p_sys, i_count,
+                                       p_buffer->i_nb_samples );
+        if( likely(p_ramp != NULL) )
+        {
+            p_sys->pf_ramp( p, p_ramp, i_count,
+                            f_from, f_multiplier - f_from );
+            return;
+        }
+    }
+
     if( f_multiplier == 1.f )
         return; /* nothing to do */
 
-    float *p = (float *)p_buffer->p_buffer;
-    for( size_t i = p_buffer->i_buffer / sizeof(*p); i > 0; i-- )
-        *(p++) *= f_multiplier;
-
-    (void) p_volume;
+    p_sys->pf_amplify( p, i_count, f_multiplier );
 }
 
 static void FilterFL64( audio_volume_t *p_volume, block_t *p_buffer,
                         float f_multiplier )
 {
+    struct audio_volume_sys *p_sys = p_volume->sys;
     double *p = (double *)p_buffer->p_buffer;
+    const size_t i_count = p_buffer->i_buffer / sizeof(*p);
+    const double from = UpdateMultiplier( p_sys, f_multiplier );
     double mult = f_multiplier;
+
+    if( from != mult )
+    {
+        const float *p_ramp = GetRamp( p_sys, i_count,
+                                       p_buffer->i_nb_samples );
+        if( likely(p_ramp != NULL) )
+        {
+            const double delta = mult - from;
+            for( size_t i = 0; i < i_count; i++ )
+                p[i] *= from + delta * p_ramp[i];
+            return;
+        }
+    }
+
     if( mult == 1. )
         return; /* nothing to do */
 
-    for( size_t i = p_buffer->i_buffer / sizeof(*p); i > 0; i-- )
+    for( size_t i = i_count; i > 0; i-- )
         *(p++) *= mult;
-
-    (void) p_volume;
 }
 
 /**
@@ -87,6 +320,7 @@ static void FilterFL64( audio_volume_t *p_volume, block_t *p_buffer,
 static int Create( vlc_object_t *p_this )
 {
     audio_volume_t *p_volume = (audio_volume_t *)p_this;
+    struct audio_volume_sys *p_sys;
 
     switch (p_volume->format)
     {
@@ -99,5 +333,28 @@ static int Create( vlc_object_t *p_this )
         default:
             return -1;
     }
+
+    p_sys = p_volume->sys = malloc( sizeof(*p_sys) );
+    if( unlikely(p_sys == NULL) )
+        return -1;
+    p_sys->f_last = NAN;
+    p_sys->p_ramp = NULL;
+    p_sys->i_ramp_samples = 0;
+    p_sys->i_ramp_frames = 0;
+
+    const struct volume_kernels *kernels =
+        vlc_CPU_SelectKernel( "mixer-float", volume_kernels,
+                              ARRAY_SIZE(volume_kernels) );
+    p_sys->pf_amplify = kernels->amplify;
+    p_sys->pf_ramp = kernels->ramp;
     return 0;
 }
+
+static void Destroy( vlc_object_t *p_this )
+{
+    audio_volume_t *p_volume = (audio_volume_t *)p_this;
+    struct audio_volume_sys *p_sys = p_volume->sys;
+
+    free( p_sys->p_ramp );
+    free( p_sys );
+}
@@ -499,7 +499,11 @@ static int Start (audio_output_t *aout, audio_sample_format_t *restrict fmt)
     sys->rate = fmt->i_rate;
 
 #if 1 /* work-around for period-long latency outputs (e.g. PulseAudio): */
-    param = AOUT_MIN_PREPARE_TIME;
+    /* In low latency mode, use periods short enough for the core to estimate
+     * the delay accurately. The buffer is kept large: its filling is bounded
+     * by the advance of the buffers passed to Play(). */
+    const vlc_tick_t latency = aout_LatencyTarget (aout);
+    param = (latency > 0) ? __MAX(latency / 4, 1000) : AOUT_MIN_PREPARE_TIME;
     val = snd_pcm_hw_params_set_period_time_near (pcm, hw, &param, NULL);
     if (val)
     {
@@ -61,52 +61,6 @@ TickToHostTime(struct aout_sys_common *p_sys, vlc_tick_t i_us)
     return i_us * 1000 * p_sys->tinfo.denom / p_sys->tinfo.numer;
 }
 
-static void
-ca_ClearOutBuffers(audio_output_t *p_aout)
-{
-    struct aout_sys_common *p_sys = (struct aout_sys_common *) p_aout->sys;
-
-    block_ChainRelease(p_sys->p_out_chain);
-    p_sys->p_out_chain = NULL;
-    p_sys->pp_out_last = &p_sys->p_out_chain;
-
-    p_sys->i_out_size = 0;
-}
-
-static void
-lock_init(struct aout_sys_common *p_sys)
-{
-    if (likely(os_unfair_lock_lock))
-        p_sys->lock.unfair = OS_UNFAIR_LOCK_INIT;
-    else
-        vlc_mutex_init(&p_sys->lock.mutex);
-}
-
-static inline void
-lock_destroy(struct aout_sys_common *p_sys)
-{
-    if (unlikely(!os_unfair_lock_lock))
-        vlc_mutex_destroy(&p_sys->lock.mutex);
-}
-
-static inline void
-lock_lock(struct aout_sys_common *p_sys)
-{
-    if (likely(os_unfair_lock_lock))
-        os_unfair_lock_lock(&p_sys->lock.unfair);
-    else
-        vlc_mutex_lock(&p_sys->lock.mutex);
-}
-
-static inline void
-lock_unlock(struct aout_sys_common *p_sys)
-{
-    if (likely(os_unfair_lock_lock))
-        os_unfair_lock_unlock(&p_sys->lock.unfair);
-    else
-        vlc_mutex_unlock(&p_sys->lock.mutex);
-}
-
 int
 ca_Open(audio_output_t *p_aout)
 {
@@ -118,9 +72,8 @@ ca_Open(audio_output_t *p_aout)
     assert(p_sys->tinfo.denom != 0 && p_sys->tinfo.numer != 0);
 
     vlc_sem_init(&p_sys->flush_sem, 0);
-    lock_init(p_sys);
-    p_sys->p_out_chain = NULL;
-    p_sys->pp_out_last = &p_sys->p_out_chain;
+    atomic_init(&p_sys->b_do_flush, false);
+    p_sys->p_out_ring = NULL;
     p_sys->chans_to_reorder = 0;
 
     p_aout->play = ca_Play;
@@ -137,7 +90,14 @@ ca_Close(audio_output_t *p_aout)
     struct aout_sys_common *p_sys = (struct aout_sys_common *) p_aout->sys;
 
     vlc_sem_destroy(&p_sys->flush_sem);
-    lock_destroy(p_sys);
+}
+
+static void
+ca_ResetRenderTime(struct aout_sys_common *p_sys)
+{
+    atomic_store(&p_sys->i_render_host_time, 0);
+    atomic_store(&p_sys->i_first_render_host_time, 0);
+    atomic_store(&p_sys->i_render_frames, 0);
 }
 
 /* Called from render callbacks. No lock, wait, and IO here */
@@ -147,28 +107,30 @@ ca_Render(audio_output_t *p_aout, uint32_t i_frames, uint64_t i_host_time,
 {
     struct aout_sys_common *p_sys = (struct aout_sys_common *) p_aout->sys;
 
-    lock_lock(p_sys);
-
-    if (p_sys->b_do_flush)
+    if (atomic_exchange(&p_sys->b_do_flush, false))
     {
-        ca_ClearOutBuffers(p_aout);
+        /* The ring was flushed by ca_Flush(), the render timings are reset
+         * from this thread so that they can't be overwritten by a render
+         * in progress. */
+        ca_ResetRenderTime(p_sys);
         /* Signal that the renderer is flushed */
-        p_sys->b_do_flush = false;
         vlc_sem_post(&p_sys->flush_sem);
     }
 
-    if (unlikely(p_sys->i_first_render_host_time == 0))
+    const uint64_t i_first_render_host_time =
+        atomic_load(&p_sys->i_first_render_host_time);
+    if (unlikely(i_first_render_host_time == 0))
         goto drop;
 
-    if (p_sys->b_paused)
+    if (atomic_load(&p_sys->b_paused))
     {
-        p_sys->i_render_host_time = i_host_time;
+        atomic_store(&p_sys->i_render_host_time, i_host_time);
         goto drop;
     }
 
     /* Start deferred: write silence (zeros) until we reach the first render
      * host time. */
-    if (unlikely(p_sys->i_first_render_host_time > i_host_time ))
+    if (unlikely(i_first_render_host_time > i_host_time ))
     {
         /* Convert the requested bytes into host time and check that it does
          * not overlap between the first_render host time and the current one.
@@ -177,7 +139,7 @@ ca_Render(audio_output_t *p_aout, uint32_t i_frames, uint64_t i_host_time,
             FramesToUs(p_sys, BytesToFrames(p_sys, i_requested));
         const uint64_t i_requested_host_time =
             TickToHostTime(p_sys, i_requested_us);
-        if (p_sys->i_first_render_host_time >= i_host_time + i_requested_host_time)
+        if (i_first_render_host_time >= i_host_time + i_requested_host_time)
         {
             /* Fill the buffer with silence */
             goto drop;
@@ -185,7 +147,7 @@ ca_Render(audio_output_t *p_aout, uint32_t i_frames, uint64_t i_host_time,
 
         /* Write silence to reach the first_render host time */
         const vlc_tick_t i_silence_us =
-            HostTimeToTick(p_sys, p_sys->i_first_render_host_time - i_host_time);
+            HostTimeToTick(p_sys, i_first_render_host_time - i_host_time);
 
         const uint64_t i_silence_bytes =
             FramesToBytes(p_sys, UsToFrames(p_sys, i_silence_us));
@@ -198,62 +160,36 @@ ca_Render(audio_output_t *p_aout, uint32_t i_frames, uint64_t i_host_time,
         /* Start the first rendering */
     }
 
-    p_sys->i_render_host_time = i_host_time;
-    p_sys->i_render_frames = i_frames;
-
-    size_t i_copied = 0;
-    block_t *p_block = p_sys->p_out_chain;
-    while (p_block != NULL && i_requested != 0)
-    {
-        size_t i_tocopy = __MIN(i_requested, p_block->i_buffer);
-        memcpy(p_output, p_block->p_buffer, i_tocopy);
-        i_requested -= i_tocopy;
-        i_copied += i_tocopy;
-        p_output += i_tocopy;
+    atomic_store(&p_sys->i_render_host_time, i_host_time);
+    atomic_store(&p_sys->i_render_frames, i_frames);
 
-        if (i_tocopy == p_block->i_buffer)
-        {
-            block_t *p_release = p_block;
-            p_block = p_block->p_next;
-            block_Release(p_release);
-        }
-        else
-        {
-            assert(i_requested == 0);
-
-            p_block->p_buffer += i_tocopy;
-            p_block->i_buffer -= i_tocopy;
-        }
-    }
-    p_sys->p_out_chain = p_block;
-    if (!p_sys->p_out_chain)
-        p_sys->pp_out_last = &p_sys->p_out_chain;
-    p_sys->i_out_size -= i_copied;
+    const size_t i_copied = aout_ring_Read(p_sys->p_out_ring, p_output,
+                                           i_requested);
+    i_requested -= i_copied;
+    p_output += i_copied;
 
     /* Pad with 0 */
     if (i_requested > 0)
     {
-        assert(p_sys->i_out_size == 0);
-        p_sys->i_underrun_size += i_requested;
+        atomic_fetch_add(&p_sys->i_underrun_size, i_requested);
         memset(p_output, 0, i_requested);
     }
-
-    lock_unlock(p_sys);
     return;
 
 drop:
     memset(p_output, 0, i_requested);
-    lock_unlock(p_sys);
 }
 
 static mtime_t
-ca_GetLatencyLocked(audio_output_t *p_aout)
+ca_GetLatency(audio_output_t *p_aout)
 {
     struct aout_sys_common *p_sys = (struct aout_sys_common *) p_aout->sys;
 
-    const int64_t i_out_frames = BytesToFrames(p_sys, p_sys->i_out_size);
-    return FramesToUs(p_sys, i_out_frames + p_sys->i_render_frames)
-           + p_sys->i_dev_latency_us;
+    const int64_t i_out_frames =
+        BytesToFrames(p_sys, aout_ring_Used(p_sys->p_out_ring));
+    return FramesToUs(p_sys, i_out_frames
+                             + atomic_load(&p_sys->i_render_frames))
+           + atomic_load(&p_sys->i_dev_latency_us);
 }
 
 int
@@ -261,21 +197,20 @@ ca_TimeGet(audio_output_t *p_aout, vlc_tick_t *delay)
 {
     struct aout_sys_common *p_sys = (struct aout_sys_common *) p_aout->sys;
 
-    lock_lock(p_sys);
-
-    if (p_sys->i_render_host_time == 0 || p_sys->i_first_render_host_time == 0)
+    const uint64_t i_render_host_time =
+        atomic_load(&p_sys->i_render_host_time);
+    if (i_render_host_time == 0
+     || atomic_load(&p_sys->i_first_render_host_time) == 0)
     {
         /* Not yet started (or reached the first_render host time) */
-        lock_unlock(p_sys);
         return -1;
     }
 
     const vlc_tick_t i_render_time_us =
-        HostTimeToTick(p_sys, p_sys->i_render_host_time);
+        HostTimeToTick(p_sys, i_render_host_time);
     const vlc_tick_t i_render_delay = i_render_time_us - mdate();
 
-    *delay = ca_GetLatencyLocked(p_aout) + i_render_delay;
-    lock_unlock(p_sys);
+    *delay = ca_GetLatency(p_aout) + i_render_delay;
     return 0;
 }
 
@@ -284,44 +219,44 @@ ca_Flush(audio_output_t *p_aout, bool wait)
 {
     struct aout_sys_common *p_sys = (struct aout_sys_common *) p_aout->sys;
 
-    lock_lock(p_sys);
     if (wait)
     {
-        while (p_sys->i_out_size > 0)
+        size_t i_used;
+        while ((i_used = aout_ring_Used(p_sys->p_out_ring)) > 0)
         {
-            if (p_sys->b_paused)
+            if (atomic_load(&p_sys->b_paused))
             {
-                ca_ClearOutBuffers(p_aout);
+                aout_ring_Flush(p_sys->p_out_ring);
                 break;
             }
 
             /* Calculate the duration of the circular buffer, in order to wait
              * for the render thread to play it all */
             const vlc_tick_t i_frame_us =
-                FramesToUs(p_sys, BytesToFrames(p_sys, p_sys->i_out_size)) + 10000;
-            lock_unlock(p_sys);
+                FramesToUs(p_sys, BytesToFrames(p_sys, i_used)) + 10000;
             msleep(i_frame_us);
-            lock_lock(p_sys);
         }
+        ca_ResetRenderTime(p_sys);
     }
     else
     {
-        assert(!p_sys->b_do_flush);
-        if (p_sys->b_paused)
-            ca_ClearOutBuffers(p_aout);
+        /* Stop the rendering before discarding the ring, so that the render
+         * callback does not start playing data written after the flush at a
+         * stale first render time. */
+        atomic_store(&p_sys->i_first_render_host_time, 0);
+        aout_ring_Flush(p_sys->p_out_ring);
+
+        atomic_store(&p_sys->b_do_flush, true);
+        /* If the render callback is not running, flush from here. Otherwise,
+         * wait for it to acknowledge the flush. The exchanges guarantee that
+         * only one thread clears the request (cf. ca_SetAliveState()). */
+        if (atomic_load(&p_sys->b_paused)
+         && atomic_exchange(&p_sys->b_do_flush, false))
+            ca_ResetRenderTime(p_sys);
         else
-        {
-            p_sys->b_do_flush = true;
-            lock_unlock(p_sys);
             vlc_sem_wait(&p_sys->flush_sem);
-            lock_lock(p_sys);
-        }
     }
 
-    p_sys->i_render_host_time = p_sys->i_first_render_host_time = 0;
-    p_sys->i_render_frames = 0;
-    lock_unlock(p_sys);
-
     p_sys->b_played = false;
 }
 
@@ -331,9 +266,7 @@ ca_Pause(audio_output_t * p_aout, bool pause, vlc_tick_t date)
     struct aout_sys_common *p_sys = (struct aout_sys_common *) p_aout->sys;
     VLC_UNUSED(date);
 
-    lock_lock(p_sys);
-    p_sys->b_paused = pause;
-    lock_unlock(p_sys);
+    atomic_store(&p_sys->b_paused, pause);
 }
 
 void
@@ -347,74 +280,39 @@ ca_Play(audio_output_t * p_aout, block_t * p_block)
                            p_sys->chans_to_reorder, p_sys->chan_table,
                            VLC_CODEC_FL32);
 
-    lock_lock(p_sys);
-
-    if (p_sys->i_render_host_time == 0)
+    if (atomic_load(&p_sys->i_render_host_time) == 0
+     || atomic_load(&p_sys->i_first_render_host_time) == 0)
     {
         /* Setup the first render time, this date must be updated until the
          * first (non-silence/zero) frame is rendered by the render callback.
          * Once the rendering is truly started, the date can be ignored. */
 
-        const vlc_tick_t first_render_time = p_block->i_pts - ca_GetLatencyLocked(p_aout);
-        p_sys->i_first_render_host_time =
-            TickToHostTime(p_sys, first_render_time);
+        const vlc_tick_t first_render_time = p_block->i_pts - ca_GetLatency(p_aout);
+        atomic_store(&p_sys->i_first_render_host_time,
+                     TickToHostTime(p_sys, first_render_time));
     }
 
-    do
+    const uint8_t *p_data = p_block->p_buffer;
+    size_t i_size = p_block->i_buffer;
+    for (;;)
     {
-        const size_t i_avalaible_bytes =
-            __MIN(p_block->i_buffer, p_sys->i_out_max_size - p_sys->i_out_size);
-
-        if (unlikely(i_avalaible_bytes != p_block->i_buffer))
-        {
-            /* Not optimal but unlikely code path. */
-
-            lock_unlock(p_sys);
-
-            block_t *p_new = block_Alloc(i_avalaible_bytes);
-            if (!p_new)
-            {
-                block_Release(p_block);
-                return;
-            }
-
-            memcpy(p_new->p_buffer, p_block->p_buffer, i_avalaible_bytes);
-
-            p_block->p_buffer += i_avalaible_bytes;
-            p_block->i_buffer -= i_avalaible_bytes;
-
-            lock_lock(p_sys);
+        const size_t i_written = aout_ring_Write(p_sys->p_out_ring, p_data,
+                                                 i_size);
+        p_data += i_written;
+        i_size -= i_written;
 
-            block_ChainLastAppend(&p_sys->pp_out_last, p_new);
-            p_sys->i_out_size += i_avalaible_bytes;
+        if (likely(i_size == 0) || atomic_load(&p_sys->b_paused))
+            break;
 
-            if (p_sys->b_paused)
-            {
-                lock_unlock(p_sys);
-                block_Release(p_block);
-                return;
-            }
-
-            const vlc_tick_t i_frame_us =
-                FramesToUs(p_sys, BytesToFrames(p_sys, p_block->i_buffer));
-
-            /* Wait for the render buffer to play the remaining data */
-            lock_unlock(p_sys);
-            msleep(i_frame_us);
-            lock_lock(p_sys);
-        }
-        else
-        {
-            block_ChainLastAppend(&p_sys->pp_out_last, p_block);
-            p_sys->i_out_size += i_avalaible_bytes;
-            p_block = NULL;
-        }
-    } while (p_block != NULL);
-
-    size_t i_underrun_size = p_sys->i_underrun_size;
-    p_sys->i_underrun_size = 0;
+        /* Not optimal but unlikely code path: wait for the render callback
+         * to play the remaining data */
+        const vlc_tick_t i_frame_us =
+            FramesToUs(p_sys, BytesToFrames(p_sys, i_size));
+        msleep(i_frame_us);
+    }
+    block_Release(p_block);
 
-    lock_unlock(p_sys);
+    size_t i_underrun_size = atomic_exchange(&p_sys->i_underrun_size, 0);
 
     if (!p_sys->b_played)
         p_sys->b_played = true;
@@ -428,10 +326,11 @@ ca_Initialize(audio_output_t *p_aout, const audio_sample_format_t *fmt,
 {
     struct aout_sys_common *p_sys = (struct aout_sys_common *) p_aout->sys;
 
-    p_sys->i_underrun_size = 0;
-    p_sys->b_paused = false;
-    p_sys->i_render_host_time = p_sys->i_first_render_host_time = 0;
-    p_sys->i_render_frames = 0;
+    atomic_init(&p_sys->i_underrun_size, 0);
+    atomic_init(&p_sys->b_paused, false);
+    atomic_init(&p_sys->i_render_host_time, 0);
+    atomic_init(&p_sys->i_first_render_host_time, 0);
+    atomic_init(&p_sys->i_render_frames, 0);
 
     p_sys->i_rate = fmt->i_rate;
     p_sys->i_bytes_per_frame = fmt->i_bytes_per_frame;
@@ -444,7 +343,7 @@ ca_Initialize(audio_output_t *p_aout, const audio_sample_format_t *fmt,
         msg_Warn(p_aout, "VLC can't handle this device latency, lowering it to "
                  "%lld", i_dev_latency_us);
     }
-    p_sys->i_dev_latency_us = i_dev_latency_us;
+    atomic_init(&p_sys->i_dev_latency_us, i_dev_latency_us);
 
     /* setup circular buffer */
     size_t i_audiobuffer_size = fmt->i_rate * fmt->i_bytes_per_frame
@@ -461,7 +360,9 @@ ca_Initialize(audio_output_t *p_aout, const audio_sample_format_t *fmt,
         p_sys->i_out_max_size = i_audiobuffer_size * 2;
     }
 
-    ca_ClearOutBuffers(p_aout);
+    p_sys->p_out_ring = aout_ring_New(p_sys->i_out_max_size);
+    if (p_sys->p_out_ring == NULL)
+        return VLC_ENOMEM;
     p_sys->b_played = false;
 
     return VLC_SUCCESS;
@@ -471,7 +372,8 @@ void
 ca_Uninitialize(audio_output_t *p_aout)
 {
     struct aout_sys_common *p_sys = (struct aout_sys_common *) p_aout->sys;
-    ca_ClearOutBuffers(p_aout);
+    aout_ring_Delete(p_sys->p_out_ring);
+    p_sys->p_out_ring = NULL;
     p_sys->i_out_max_size = 0;
     p_sys->chans_to_reorder = 0;
 }
@@ -481,32 +383,25 @@ ca_SetAliveState(audio_output_t *p_aout, bool alive)
 {
     struct aout_sys_common *p_sys = (struct aout_sys_common *) p_aout->sys;
 
-    lock_lock(p_sys);
+    atomic_store(&p_sys->b_paused, !alive);
 
-    bool b_sem_post = false;
-    p_sys->b_paused = !alive;
-    if (!alive && p_sys->b_do_flush)
+    /* The render callback won't be called anymore: acknowledge a pending
+     * flush in its place */
+    if (!alive && atomic_exchange(&p_sys->b_do_flush, false))
     {
-        ca_ClearOutBuffers(p_aout);
+        ca_ResetRenderTime(p_sys);
         p_sys->b_played = false;
-        p_sys->b_do_flush = false;
-        b_sem_post = true;
-    }
-
-    lock_unlock(p_sys);
-
-    if (b_sem_post)
         vlc_sem_post(&p_sys->flush_sem);
+    }
 }
 
 void ca_SetDeviceLatency(audio_output_t *p_aout, vlc_tick_t i_dev_latency_us)
 {
     struct aout_sys_common *p_sys = (struct aout_sys_common *) p_aout->sys;
 
-    lock_lock(p_sys);
     /* cf. TODO in ca_Initialize */
-    p_sys->i_dev_latency_us = i_dev_latency_us > 1000000 ? 1000000 : i_dev_latency_us;
-    lock_unlock(p_sys);
+    atomic_store(&p_sys->i_dev_latency_us,
+                 i_dev_latency_us > 1000000 ? 1000000 : i_dev_latency_us);
 }
 
 AudioUnit
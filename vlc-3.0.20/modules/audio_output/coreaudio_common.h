@@ -29,10 +29,10 @@
 #import <vlc_common.h>
 #import <vlc_aout.h>
 #import <vlc_threads.h>
+#import <vlc_atomic.h>
 
 #import <AudioUnit/AudioUnit.h>
 #import <AudioToolbox/AudioToolbox.h>
-#import <os/lock.h>
 #import <mach/mach_time.h>
 
 #define STREAM_FORMAT_MSG(pre, sfm) \
@@ -52,37 +52,26 @@ struct aout_sys_common
 
     mach_timebase_info_data_t tinfo;
 
-    size_t              i_underrun_size;
-    bool                b_paused;
-    bool                b_do_flush;
+    atomic_size_t       i_underrun_size;
+    atomic_bool         b_paused;
+    atomic_bool         b_do_flush;
 
     size_t              i_out_max_size;
-    size_t              i_out_size;
     bool                b_played;
-    block_t             *p_out_chain;
-    block_t             **pp_out_last;
-    uint64_t            i_render_host_time;
-    uint64_t            i_first_render_host_time;
-    uint32_t            i_render_frames;
+    aout_ring_t         *p_out_ring;
+    atomic_uint_least64_t i_render_host_time;
+    atomic_uint_least64_t i_first_render_host_time;
+    atomic_uint         i_render_frames;
 
     vlc_sem_t           flush_sem;
 
-    union lock
-    {
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wpartial-availability"
-        os_unfair_lock  unfair;
-#pragma clang diagnostic pop
-        pthread_mutex_t mutex;
-    } lock;
-
     int                 i_rate;
     unsigned int        i_bytes_per_frame;
     unsigned int        i_frame_length;
     uint8_t             chans_to_reorder;
     uint8_t             chan_table[AOUT_CHAN_MAX];
     /* ca_TimeGet extra latency, in micro-seconds */
-    vlc_tick_t          i_dev_latency_us;
+    atomic_int_least64_t i_dev_latency_us;
 };
 
 int ca_Open(audio_output_t *p_aout);
@@ -836,6 +836,15 @@ static int Start(audio_output_t *aout, audio_sample_format_t *restrict fmt)
         attr.tlength = pa_usec_to_bytes(3 * AOUT_MIN_PREPARE_TIME, &ss);
     }
 
+    const vlc_tick_t latency = aout_LatencyTarget(aout);
+    if (latency > 0)
+    {   /* Low latency mode: let the server (or PipeWire) configure the sink
+         * latency after our target length. */
+        flags |= PA_STREAM_ADJUST_LATENCY;
+        attr.tlength = pa_usec_to_bytes(latency, &ss);
+        attr.minreq = pa_usec_to_bytes(latency / 3, &ss);
+    }
+
     if (encoding != PA_ENCODING_PCM)
     {
         pa_format_info_set_channels(formatv, ss.channels);
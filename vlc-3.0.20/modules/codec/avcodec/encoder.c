@@ -544,6 +544,11 @@ int InitVideoEnc( vlc_object_t *p_this )
                    p_enc->fmt_in.video.i_sar_den, 1 << 30 );
 
 
+        /* Chroma of the pictures the encoder is offered */
+        const int i_input_pix_fmt = p_enc->fmt_out.i_codec != VLC_CODEC_TIFF
+                                  ? FindFfmpegChroma( p_enc->fmt_in.i_codec )
+                                  : AV_PIX_FMT_NONE;
+
         p_enc->fmt_in.i_codec = VLC_CODEC_I420;
 
         /* Very few application support YUV in TIFF, not even VLC */
@@ -561,8 +566,22 @@ int InitVideoEnc( vlc_object_t *p_this )
                 AV_PIX_FMT_RGB24,
             };
             bool found = false;
-            const enum PixelFormat *p = p_codec->pix_fmts;
-            for( ; !found && *p != -1; p++ )
+            const enum PixelFormat *p;
+
+            /* Take the pictures as they are if the codec supports them, e.g.
+             * the NV12 output of hardware decoders, to avoid a conversion */
+            for( p = p_codec->pix_fmts;
+                 i_input_pix_fmt != AV_PIX_FMT_NONE && *p != -1; p++ )
+            {
+                if( *p == i_input_pix_fmt )
+                {
+                    found = true;
+                    p_context->pix_fmt = *p;
+                    break;
+                }
+            }
+
+            for( p = p_codec->pix_fmts; !found && *p != -1; p++ )
             {
                 for( size_t i = 0; i < ARRAY_SIZE(vlc_pix_fmts); ++i )
                 {
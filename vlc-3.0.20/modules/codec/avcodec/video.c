@@ -69,6 +69,9 @@ struct decoder_sys_t
     bool b_show_corrupted;
     bool b_from_preroll;
     bool b_hardware_only;
+    bool b_threads_reserved; /* CPUs shared with the other decoders */
+    unsigned i_threads_width;
+    unsigned i_threads_height;
     enum AVDiscard i_skip_frame;
 
     /* how many decoded frames are late */
@@ -79,6 +82,7 @@ struct decoder_sys_t
     /* for direct rendering */
     bool        b_direct_rendering;
     atomic_bool b_dr_failure;
+    atomic_bool b_no_output; /* frames being decoded will not be output */
 
     /* Hack to force display of still pictures */
     bool b_first_frame;
@@ -522,6 +526,7 @@ static int InitVideoDecCommon( decoder_t *p_dec )
     /* ***** libavcodec direct rendering ***** */
     p_sys->b_direct_rendering = false;
     atomic_init(&p_sys->b_dr_failure, false);
+    atomic_init(&p_sys->b_no_output, false);
     if( var_CreateGetBool( p_dec, "avcodec-dr" ) &&
        (p_codec->capabilities & AV_CODEC_CAP_DR1) &&
         /* No idea why ... but this fixes flickering on some TSCC streams */
@@ -532,6 +537,10 @@ static int InitVideoDecCommon( decoder_t *p_dec )
         /* Some codecs set pix_fmt only after the 1st frame has been decoded,
          * so we need to do another check in ffmpeg_GetFrameBuf() */
         p_sys->b_direct_rendering = true;
+        /* Largest libavcodec STRIDE_ALIGN (AVX-512), so that the vout
+         * pictures suit any build and frame threads never fall back to
+         * internal buffers and copies */
+        p_dec->i_picture_align = 64;
     }
 
     p_context->get_format = ffmpeg_GetFormat;
@@ -541,9 +550,13 @@ static int InitVideoDecCommon( decoder_t *p_dec )
     p_context->opaque = p_dec;
 
     int i_thread_count = p_sys->b_hardware_only ? 1 : var_InheritInteger( p_dec, "avcodec-threads" );
+    p_sys->b_threads_reserved = i_thread_count <= 0;
     if( i_thread_count <= 0 )
     {
-        i_thread_count = vlc_GetCPUCount();
+        p_sys->i_threads_width = p_dec->fmt_in.video.i_width;
+        p_sys->i_threads_height = p_dec->fmt_in.video.i_height;
+        i_thread_count = vlc_AcquireDecoderThreads( p_sys->i_threads_width,
+                                                    p_sys->i_threads_height );
         if( i_thread_count > 1 )
             i_thread_count++;
 
@@ -616,6 +629,9 @@ static int InitVideoDecCommon( decoder_t *p_dec )
     /* ***** Open the codec ***** */
     if( OpenVideoCodec( p_dec ) < 0 )
     {
+        if( p_sys->b_threads_reserved )
+            vlc_ReleaseDecoderThreads( p_sys->i_threads_width,
+                                       p_sys->i_threads_height );
         vlc_sem_destroy( &p_sys->sem_mt );
         free( p_sys );
         avcodec_free_context( &p_context );
@@ -1176,6 +1192,9 @@ static picture_t *DecodeBlock( decoder_t *p_dec, block_t **pp_block, bool *error
         p_context->skip_frame = __MAX( p_context->skip_frame,
                                               AVDISCARD_NONREF );
     }
+    /* Preroll frames are only decoded as references for the next ones: do
+     * not tie up output pictures for them. */
+    atomic_store( &p_sys->b_no_output, !b_need_output_picture );
 
     /*
      * Do the actual decoding now */
@@ -1493,6 +1512,9 @@ void EndVideoDec( vlc_object_t *obj )
     if( p_sys->p_va )
         vlc_va_Delete( p_sys->p_va, &hwaccel_context );
 
+    if( p_sys->b_threads_reserved )
+        vlc_ReleaseDecoderThreads( p_sys->i_threads_width,
+                                   p_sys->i_threads_height );
     vlc_sem_destroy( &p_sys->sem_mt );
     free( p_sys );
 }
@@ -1614,8 +1636,15 @@ static int lavc_dr_GetFrame(struct AVCodecContext *ctx, AVFrame *frame,
     avcodec_align_dimensions2(ctx, &width, &height, aligns);
 
     /* Check that the picture is suitable for libavcodec */
-    assert(pic->p[0].i_pitch >= width * pic->p[0].i_pixel_pitch);
-    assert(pic->p[0].i_lines >= height);
+    if (pic->p[0].i_pitch < width * pic->p[0].i_pixel_pitch ||
+        pic->p[0].i_lines < height)
+    {
+        if (!atomic_exchange(&sys->b_dr_failure, true))
+            msg_Warn(dec, "picture too small (%dx%d): disabling direct rendering",
+                     pic->p[0].i_pitch / pic->p[0].i_pixel_pitch,
+                     pic->p[0].i_lines);
+        goto error;
+    }
 
     for (int i = 0; i < pic->i_planes; i++)
     {
@@ -1688,7 +1717,7 @@ static int lavc_GetFrame(struct AVCodecContext *ctx, AVFrame *frame, int flags)
     wait_mt(sys);
     if (sys->p_va == NULL)
     {
-        if (!sys->b_direct_rendering)
+        if (!sys->b_direct_rendering || atomic_load(&sys->b_no_output))
         {
             post_mt(sys);
             return avcodec_default_get_buffer2(ctx, frame, flags);
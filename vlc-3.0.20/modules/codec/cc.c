@@ -103,6 +103,7 @@ typedef enum
 #define EIA608_MARGIN  0.10
 #define EIA608_VISIBLE (1.0 - EIA608_MARGIN * 2)
 #define FONT_TO_LINE_HEIGHT_RATIO 1.06
+#define EIA608_SPU_DURATION (10 * CLOCK_FREQ) /* 10s max */
 
 struct eia608_screen // A CC buffer
 {
@@ -202,11 +203,20 @@ typedef struct
         uint8_t d1;
         uint8_t d2;
     } last;
+
+    /* Last displayed screen sent downstream (used to skip unchanged updates) */
+    struct
+    {
+        eia608_screen screen;
+        vlc_tick_t i_pts;
+    } output;
 } eia608_t;
 
 static void         Eia608Init( eia608_t * );
 static eia608_status_t Eia608Parse( eia608_t *h, int i_channel_selected, const uint8_t data[2] );
 static void         Eia608FillUpdaterRegions( subpicture_updater_sys_t *p_updater, eia608_t *h );
+static bool         Eia608IsOutputChanged( const eia608_t *h, vlc_tick_t i_pts );
+static void         Eia608SetOutput( eia608_t *h, vlc_tick_t i_pts );
 
 /* It will be enough up to 63 B frames, which is far too high for
  * broadcast environment */
@@ -491,13 +501,17 @@ static subpicture_t *Subtitle( decoder_t *p_dec, eia608_t *h, vlc_tick_t i_pts )
     if( i_pts <= VLC_TICK_INVALID )
         return NULL;
 
+    /* The previous subpicture is still valid if no displayed row changed */
+    if( !Eia608IsOutputChanged( h, i_pts ) )
+        return NULL;
+
     /* Create the subpicture unit */
     p_spu = decoder_NewSubpictureText( p_dec );
     if( !p_spu )
         return NULL;
 
     p_spu->i_start    = i_pts;
-    p_spu->i_stop     = i_pts + 10000000;   /* 10s max */
+    p_spu->i_stop     = i_pts + EIA608_SPU_DURATION;
     p_spu->b_ephemer  = true;
     p_spu->b_absolute = false;
 
@@ -526,6 +540,7 @@ static subpicture_t *Subtitle( decoder_t *p_dec, eia608_t *h, vlc_tick_t i_pts )
     p_spu_sys->p_default_style->i_features |= (STYLE_HAS_FONT_COLOR | STYLE_HAS_FLAGS);
 
     Eia608FillUpdaterRegions( p_spu_sys, h );
+    Eia608SetOutput( h, i_pts );
 
     return p_spu;
 }
@@ -1265,6 +1280,48 @@ static void Eia608FillUpdaterRegions( subpicture_updater_sys_t *p_updater, eia60
     }
 }
 
+static bool Eia608IsRowChanged( const eia608_screen *a, const eia608_screen *b, int i_row )
+{
+    if( !a->row_used[i_row] && !b->row_used[i_row] )
+        return false;
+
+    return a->row_used[i_row] != b->row_used[i_row] ||
+           memcmp( a->characters[i_row], b->characters[i_row], sizeof(*a->characters) ) ||
+           memcmp( a->colors[i_row], b->colors[i_row], sizeof(*a->colors) ) ||
+           memcmp( a->fonts[i_row], b->fonts[i_row], sizeof(*a->fonts) );
+}
+
+static bool Eia608IsOutputChanged( const eia608_t *h, vlc_tick_t i_pts )
+{
+    /* Refresh before the last subpicture expires, and after any discontinuity */
+    if( h->output.i_pts <= VLC_TICK_INVALID || i_pts < h->output.i_pts ||
+        i_pts - h->output.i_pts >= EIA608_SPU_DURATION / 2 )
+        return true;
+
+    for( int i = 0; i < EIA608_SCREEN_ROWS; i++ )
+    {
+        if( Eia608IsRowChanged( &h->screen[h->i_screen], &h->output.screen, i ) )
+            return true;
+    }
+    return false;
+}
+
+static void Eia608SetOutput( eia608_t *h, vlc_tick_t i_pts )
+{
+    const eia608_screen *screen = &h->screen[h->i_screen];
+
+    for( int i = 0; i < EIA608_SCREEN_ROWS; i++ )
+    {
+        if( !Eia608IsRowChanged( screen, &h->output.screen, i ) )
+            continue;
+        memcpy( h->output.screen.characters[i], screen->characters[i], sizeof(*screen->characters) );
+        memcpy( h->output.screen.colors[i], screen->colors[i], sizeof(*screen->colors) );
+        memcpy( h->output.screen.fonts[i], screen->fonts[i], sizeof(*screen->fonts) );
+        h->output.screen.row_used[i] = screen->row_used[i];
+    }
+    h->output.i_pts = i_pts;
+}
+
 /* */
 static void Eia608Init( eia608_t *h )
 {
@@ -1287,6 +1344,7 @@ static void Eia608Init( eia608_t *h )
     h->color = EIA608_COLOR_DEFAULT;
     h->font = EIA608_FONT_REGULAR;
     h->i_row_rollup = EIA608_SCREEN_ROWS-1;
+    h->output.i_pts = VLC_TICK_INVALID;
 }
 static eia608_status_t Eia608Parse( eia608_t *h, int i_channel_selected, const uint8_t data[2] )
 {
@@ -82,6 +82,8 @@ struct decoder_sys_t
 {
     Dav1dSettings s;
     Dav1dContext *c;
+    unsigned i_width;
+    unsigned i_height;
 };
 
 static const struct
@@ -324,7 +326,6 @@ static int Decode(decoder_t *dec, block_t *block)
 static int OpenDecoder(vlc_object_t *p_this)
 {
     decoder_t *dec = (decoder_t *)p_this;
-    unsigned i_core_count = vlc_GetCPUCount();
 
     if (dec->fmt_in.i_codec != VLC_CODEC_AV1)
         return VLC_EGENERIC;
@@ -333,6 +334,12 @@ static int OpenDecoder(vlc_object_t *p_this)
     if (!p_sys)
         return VLC_ENOMEM;
 
+    /* share the CPUs with the other decoders of the process */
+    p_sys->i_width = dec->fmt_in.video.i_width;
+    p_sys->i_height = dec->fmt_in.video.i_height;
+    unsigned i_core_count = vlc_AcquireDecoderThreads(p_sys->i_width,
+                                                      p_sys->i_height);
+
     dav1d_default_settings(&p_sys->s);
 #if DAV1D_API_VERSION_MAJOR >= 6
     p_sys->s.n_threads = var_InheritInteger(p_this, "dav1d-thread-frames");
@@ -373,10 +380,13 @@ static int OpenDecoder(vlc_object_t *p_this)
     p_sys->s.allocator.cookie = dec;
     p_sys->s.allocator.alloc_picture_callback = NewPicture;
     p_sys->s.allocator.release_picture_callback = FreePicture;
+    /* pictures are rendered into directly */
+    dec->i_picture_align = DAV1D_PICTURE_ALIGNMENT;
 
     if (dav1d_open(&p_sys->c, &p_sys->s) < 0)
     {
         msg_Err(p_this, "Could not open the Dav1d decoder");
+        vlc_ReleaseDecoderThreads(p_sys->i_width, p_sys->i_height);
         return VLC_EGENERIC;
     }
 
@@ -426,5 +436,6 @@ static void CloseDecoder(vlc_object_t *p_this)
     FlushDecoder(dec);
 
     dav1d_close(&p_sys->c);
+    vlc_ReleaseDecoderThreads(p_sys->i_width, p_sys->i_height);
 }
 
@@ -70,6 +70,7 @@
 #ifdef HAVE_CONFIG_H
 # include "config.h"
 #endif
+#include <assert.h>
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
@@ -1404,37 +1405,49 @@ static void dvbsub_pdata4bpp( bs_t *s, uint8_t *p, int i_width, int *pi_off )
 
 static void dvbsub_pdata8bpp( bs_t *s, uint8_t *p, int i_width, int *pi_off )
 {
-    bool b_stop = false;
+    /* The 8-bit/pixel codes are byte aligned: the pixels up to the next
+     * 0x00 escape are copied at once, only the run-length codes are parsed */
+    const uint8_t *p_data = s->p;
+    const uint8_t *p_end = s->p_end;
 
-    while( !b_stop && !bs_eof( s ) )
+    assert( s->i_left == 8 );
+
+    while( p_data < p_end )
     {
-        int i_count = 0, i_color = 0;
+        const uint8_t *p_escape = memchr( p_data, 0x00, p_end - p_data );
+        size_t i_literal = ( p_escape ? p_escape : p_end ) - p_data;
 
-        i_color = bs_read( s, 8 );
-        if( i_color != 0x00 )
+        if( i_literal > 0 )
         {
-            /* Add 1 pixel */
-            i_count = 1;
-        }
-        else
-        {
-            if( bs_read( s, 1 ) == 0x00 )           // Switch1
-            {
-                if( bs_show( s, 7 ) != 0x00 )
-                {
-                    i_count = bs_read( s, 7 );
-                }
-                else
-                {
-                    bs_skip( s, 7 );
-                    b_stop = true;
-                }
-            }
-            else
+            /* Sanity check */
+            if( i_literal > (size_t)( i_width - *pi_off ) )
             {
-                i_count = bs_read( s, 7 );
-                i_color = bs_read( s, 8 );
+                i_literal = i_width - *pi_off;
+                memcpy( p + *pi_off, p_data, i_literal );
+                *pi_off += i_literal;
+                p_data += i_literal + 1;
+                break;
             }
+            memcpy( p + *pi_off, p_data, i_literal );
+            *pi_off += i_literal;
+        }
+        if( p_escape == NULL || p_escape + 1 >= p_end )
+        {
+            p_data = p_end;
+            break;
+        }
+
+        p_data = p_escape + 1;
+        const uint8_t i_code = *p_data++;
+        int i_count = i_code & 0x7f, i_color = 0;
+
+        if( i_code == 0x00 ) /* End of string */
+            break;
+        if( i_code & 0x80 )
+        {
+            if( p_data >= p_end )
+                break;
+            i_color = *p_data++;
         }
 
         if( !i_count ) continue;
@@ -1442,13 +1455,11 @@ static void dvbsub_pdata8bpp( bs_t *s, uint8_t *p, int i_width, int *pi_off )
         /* Sanity check */
         if( ( i_count + *pi_off ) > i_width ) break;
 
-        if( i_count == 1 ) p[*pi_off] = i_color;
-        else memset( ( p + *pi_off ), i_color, i_count );
-
+        memset( ( p + *pi_off ), i_color, i_count );
         (*pi_off) += i_count;
     }
 
-    bs_align( s );
+    s->p = (uint8_t *)__MIN( p_data, p_end );
 }
 
 static void free_all( decoder_t *p_dec )
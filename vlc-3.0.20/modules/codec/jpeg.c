@@ -493,6 +493,30 @@ static int DecodeBlock(decoder_t *p_dec, block_t *p_block)
 
     p_sys->p_jpeg.out_color_space = JCS_RGB;
 
+    int i_otag; /* Orientation tag has valid range of 1-8. 1 is normal orientation, 0 = unspecified = normal */
+    i_otag = jpeg_GetOrientation( &p_sys->p_jpeg );
+
+    /* Scale down in the DCT domain, if the picture will be downscaled
+     * afterwards (image handler) */
+    unsigned i_want_width = var_GetInteger(p_dec, "image-decode-width");
+    unsigned i_want_height = var_GetInteger(p_dec, "image-decode-height");
+    if (i_otag > 1 && ORIENT_IS_SWAP(ORIENT_FROM_EXIF(i_otag)))
+    {
+        unsigned i_tmp = i_want_width;
+        i_want_width = i_want_height;
+        i_want_height = i_tmp;
+    }
+    if (i_want_width > 0 || i_want_height > 0)
+    {
+        unsigned i_denom = 8;
+        while (i_denom > 1 &&
+               (p_sys->p_jpeg.image_width < i_want_width * i_denom ||
+                p_sys->p_jpeg.image_height < i_want_height * i_denom))
+            i_denom /= 2;
+        p_sys->p_jpeg.scale_num = 1;
+        p_sys->p_jpeg.scale_denom = i_denom;
+    }
+
     jpeg_start_decompress(&p_sys->p_jpeg);
 
     /* Set output properties */
@@ -501,8 +525,6 @@ static int DecodeBlock(decoder_t *p_dec, block_t *p_block)
     p_dec->fmt_out.video.i_sar_num = 1;
     p_dec->fmt_out.video.i_sar_den = 1;
 
-    int i_otag; /* Orientation tag has valid range of 1-8. 1 is normal orientation, 0 = unspecified = normal */
-    i_otag = jpeg_GetOrientation( &p_sys->p_jpeg );
     if ( i_otag > 1 )
     {
         msg_Dbg( p_dec, "Jpeg orientation is %d", i_otag );
@@ -75,6 +75,16 @@ vlc_module_end ()
 static int DecodeBlock( decoder_t *, block_t * );
 static void Flush( decoder_t * );
 
+/* Region bitmap rendered by a previous update, reused while unchanged */
+#define REGION_CACHE_SIZE 4
+typedef struct
+{
+    int        i_width;
+    int        i_height;
+    uint64_t   i_hash;
+    picture_t *p_picture;
+} region_cache_t;
+
 /* */
 struct decoder_sys_t
 {
@@ -91,6 +101,10 @@ struct decoder_sys_t
 
     /* */
     ASS_Track      *p_track;
+
+    /* */
+    region_cache_t cache[REGION_CACHE_SIZE];
+    int            i_cache;
 };
 static void DecSysRelease( decoder_sys_t *p_sys );
 static void DecSysHold( decoder_sys_t *p_sys );
@@ -126,6 +140,8 @@ typedef struct
 
 static int BuildRegions( rectangle_t *p_region, int i_max_region, ASS_Image *p_img_list, int i_width, int i_height );
 static void RegionDraw( subpicture_region_t *p_region, ASS_Image *p_img );
+static uint64_t RegionHash( const rectangle_t *p_region, const ASS_Image *p_img );
+static void CacheFlush( decoder_sys_t *p_sys );
 static void OldEngineClunkyRollInfoPatch( decoder_t *p_dec, ASS_Track * );
 
 //#define DEBUG_REGION
@@ -156,6 +172,7 @@ static int Create( vlc_object_t *p_this )
     p_sys->p_library  = NULL;
     p_sys->p_renderer = NULL;
     p_sys->p_track    = NULL;
+    p_sys->i_cache    = 0;
 
     /* Create libass library */
     ASS_Library *p_library = p_sys->p_library = ass_library_init();
@@ -319,6 +336,7 @@ static void DecSysRelease( decoder_sys_t *p_sys )
     vlc_mutex_unlock( &p_sys->lock );
     vlc_mutex_destroy( &p_sys->lock );
 
+    CacheFlush( p_sys );
     if( p_sys->p_track )
         ass_free_track( p_sys->p_track );
     if( p_sys->p_renderer )
@@ -450,6 +468,7 @@ static int SubpictureValidate( subpicture_t *p_subpic,
         const double dst_ratio = (double)p_fmt_dst->i_visible_width / p_fmt_dst->i_visible_height;
         ass_set_aspect_ratio( p_sys->p_renderer, dst_ratio / src_ratio, 1 );
         p_sys->fmt = fmt;
+        CacheFlush( p_sys );
     }
 
     /* */
@@ -502,13 +521,18 @@ static void SubpictureUpdate( subpicture_t *p_subpic,
         return;
     }
 
-    /* Allocate the regions and draw them */
+    /* Allocate the regions and draw them, or reuse the bitmaps of the
+     * previous update for regions whose images did not change (typically
+     * when libass only moved them, or changed other regions) */
     subpicture_region_t **pp_region_last = &p_subpic->p_region;
+    region_cache_t cache[REGION_CACHE_SIZE];
+    int i_cache = 0;
 
     for( int i = 0; i < i_region; i++ )
     {
         subpicture_region_t *r;
         video_format_t fmt_region;
+        const uint64_t i_hash = RegionHash( &region[i], p_img );
 
         /* */
         fmt_region = fmt;
@@ -525,12 +549,42 @@ static void SubpictureUpdate( subpicture_t *p_subpic,
         r->i_align = SUBPICTURE_ALIGN_TOP | SUBPICTURE_ALIGN_LEFT;
 
         /* */
-        RegionDraw( r, p_img );
+        picture_t *p_cached = NULL;
+        for( int j = 0; j < p_sys->i_cache; j++ )
+        {
+            const region_cache_t *c = &p_sys->cache[j];
+            if( c->i_hash == i_hash &&
+                c->i_width == (int)fmt_region.i_width &&
+                c->i_height == (int)fmt_region.i_height )
+            {
+                p_cached = c->p_picture;
+                break;
+            }
+        }
+
+        if( p_cached != NULL )
+        {
+            picture_Release( r->p_picture );
+            r->p_picture = picture_Hold( p_cached );
+        }
+        else
+            RegionDraw( r, p_img );
+
+        cache[i_cache++] = (region_cache_t) {
+            .i_width = fmt_region.i_width,
+            .i_height = fmt_region.i_height,
+            .i_hash = i_hash,
+            .p_picture = picture_Hold( r->p_picture ),
+        };
 
         /* */
         *pp_region_last = r;
         pp_region_last = &r->p_next;
     }
+
+    CacheFlush( p_sys );
+    memcpy( p_sys->cache, cache, i_cache * sizeof(*cache) );
+    p_sys->i_cache = i_cache;
     vlc_mutex_unlock( &p_sys->lock );
 
 }
@@ -697,6 +751,51 @@ static int BuildRegions( rectangle_t *p_region, int i_max_region, ASS_Image *p_i
     return i_region;
 }
 
+static void CacheFlush( decoder_sys_t *p_sys )
+{
+    for( int i = 0; i < p_sys->i_cache; i++ )
+        picture_Release( p_sys->cache[i].p_picture );
+    p_sys->i_cache = 0;
+}
+
+/* Identifies the content of a region: the images it draws, with their
+ * position relative to the region, color and bitmap */
+static uint64_t RegionHash( const rectangle_t *p_region, const ASS_Image *p_img )
+{
+    uint64_t h = UINT64_C(0xcbf29ce484222325);
+#define MIX(v) h = ( h ^ (uint64_t)(v) ) * UINT64_C(0x100000001b3)
+
+    for( ; p_img != NULL; p_img = p_img->next )
+    {
+        /* Same selection as RegionDraw */
+        if( p_img->dst_x < p_region->x0 || p_img->dst_x + p_img->w > p_region->x1 ||
+            p_img->dst_y < p_region->y0 || p_img->dst_y + p_img->h > p_region->y1 )
+            continue;
+
+        MIX( p_img->dst_x - p_region->x0 );
+        MIX( p_img->dst_y - p_region->y0 );
+        MIX( p_img->w );
+        MIX( p_img->h );
+        MIX( p_img->color );
+
+        for( int y = 0; y < p_img->h; y++ )
+        {
+            const uint8_t *p_line = &p_img->bitmap[y * p_img->stride];
+            int x = 0;
+            for( ; x + 8 <= p_img->w; x += 8 )
+            {
+                uint64_t v;
+                memcpy( &v, &p_line[x], sizeof(v) );
+                MIX( v );
+            }
+            for( ; x < p_img->w; x++ )
+                MIX( p_line[x] );
+        }
+    }
+#undef MIX
+    return h;
+}
+
 static void RegionDraw( subpicture_region_t *p_region, ASS_Image *p_img )
 {
     const plane_t *p = &p_region->p_picture->p[0];
@@ -723,6 +822,8 @@ static void RegionDraw( subpicture_region_t *p_region, ASS_Image *p_img )
             for( x = 0; x < p_img->w; x++ )
             {
                 const unsigned alpha = p_img->bitmap[y*p_img->stride+x];
+                if( alpha == 0 )
+                    continue; /* fully transparent, leaves the pixel as is */
                 const unsigned an = (255 - a) * alpha / 255;
 
                 uint8_t *p_rgba = &p->p_pixels[(y+p_img->dst_y-i_y) * p->i_pitch + 4 * (x+p_img->dst_x-i_x)];
@@ -78,6 +78,12 @@ typedef struct
     } display;
 }  ttml_style_t;
 
+typedef struct
+{
+    const tt_node_t *p_node;
+    ttml_style_t    *p_style; /* inherited style, NULL if none */
+} ttml_style_cache_t;
+
 typedef struct
 {
     vlc_dictionary_t regions;
@@ -85,6 +91,11 @@ typedef struct
     ttml_length_t    root_extent_h, root_extent_v;
     unsigned         i_cell_resolution_v;
     unsigned         i_cell_resolution_h;
+    /* Document wide, shared by all the time intervals */
+    vlc_dictionary_t style_ids;  /* <style> nodes by id */
+    vlc_dictionary_t region_ids; /* <region> nodes by id */
+    ttml_style_cache_t *p_styles; /* sorted by node */
+    size_t           i_styles;
 } ttml_context_t;
 
 typedef struct
@@ -150,11 +161,16 @@ static void ttml_region_Delete( ttml_region_t *p_region )
 
 static ttml_style_t * ttml_style_Duplicate( const ttml_style_t *p_src )
 {
-    ttml_style_t *p_dup = ttml_style_New( );
+    ttml_style_t *p_dup = malloc( sizeof( *p_dup ) );
     if( p_dup )
     {
         *p_dup = *p_src;
         p_dup->font_style = text_style_Duplicate( p_src->font_style );
+        if( unlikely( !p_dup->font_style ) )
+        {
+            free( p_dup );
+            return NULL;
+        }
     }
     return p_dup;
 }
@@ -579,8 +595,8 @@ static void DictMergeWithStyleID( ttml_context_t *p_ctx, const char *psz_id,
     if( psz_id && p_ctx->p_rootnode )
     {
         /* Lookup referenced style ID */
-        const tt_node_t *p_node = FindNode( p_ctx->p_rootnode,
-                                            "style", -1, psz_id );
+        const tt_node_t *p_node =
+                vlc_dictionary_value_for_key( &p_ctx->style_ids, psz_id );
         if( p_node )
             DictionaryMerge( &p_node->attr_dict, p_dst );
     }
@@ -592,8 +608,8 @@ static void DictMergeWithRegionID( ttml_context_t *p_ctx, const char *psz_id,
     assert(p_ctx->p_rootnode);
     if( psz_id && p_ctx->p_rootnode )
     {
-        const tt_node_t *p_regionnode = FindNode( p_ctx->p_rootnode,
-                                                 "region", -1, psz_id );
+        const tt_node_t *p_regionnode =
+                vlc_dictionary_value_for_key( &p_ctx->region_ids, psz_id );
         if( !p_regionnode )
             return;
 
@@ -666,6 +682,40 @@ static ttml_style_t * InheritTTMLStyles( ttml_context_t *p_ctx, tt_node_t *p_nod
     return p_ttml_style;
 }
 
+/* Same as InheritTTMLStyles(), but computed once per node and document */
+static ttml_style_t * InheritTTMLStylesCached( ttml_context_t *p_ctx,
+                                               tt_node_t *p_node )
+{
+    size_t lo = 0, hi = p_ctx->i_styles;
+    while( lo < hi )
+    {
+        size_t mid = (lo + hi) / 2;
+        const ttml_style_cache_t *p_entry = &p_ctx->p_styles[mid];
+        if( p_entry->p_node == p_node )
+            return p_entry->p_style ? ttml_style_Duplicate( p_entry->p_style )
+                                    : NULL;
+        if( (uintptr_t) p_entry->p_node < (uintptr_t) p_node )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    ttml_style_t *p_style = InheritTTMLStyles( p_ctx, p_node );
+
+    ttml_style_cache_t *p_styles = realloc( p_ctx->p_styles,
+                                   (p_ctx->i_styles + 1) * sizeof(*p_styles) );
+    if( unlikely( !p_styles ) )
+        return p_style;
+    memmove( &p_styles[lo + 1], &p_styles[lo],
+             (p_ctx->i_styles - lo) * sizeof(*p_styles) );
+    p_styles[lo].p_node = p_node;
+    p_styles[lo].p_style = p_style;
+    p_ctx->p_styles = p_styles;
+    p_ctx->i_styles++;
+
+    return p_style ? ttml_style_Duplicate( p_style ) : NULL;
+}
+
 static int ParseTTMLChunk( xml_reader_t *p_reader, tt_node_t **pp_rootnode )
 {
     const char* psz_node_name;
@@ -810,7 +860,7 @@ static void AppendTextToRegion( ttml_context_t *p_ctx, const tt_textnode_t *p_tt
     if( p_segment )
     {
         bool b_preserve_space = false;
-        ttml_style_t *s = InheritTTMLStyles( p_ctx, p_ttnode->p_parent );
+        ttml_style_t *s = InheritTTMLStylesCached( p_ctx, p_ttnode->p_parent );
         if( s )
         {
             if( p_set_styles )
@@ -951,9 +1001,51 @@ static tt_node_t *ParseTTML( decoder_t *p_dec, const uint8_t *p_buffer, size_t i
     return p_rootnode;
 }
 
+/* Indexes the style and region nodes by id. As with a tree lookup, the
+ * first one in document order wins. */
+static void IndexTTMLIds( ttml_context_t *p_ctx, tt_node_t *p_node )
+{
+    vlc_dictionary_t *p_ids = NULL;
+    if( !tt_node_NameCompare( p_node->psz_node_name, "style" ) )
+        p_ids = &p_ctx->style_ids;
+    else if( !tt_node_NameCompare( p_node->psz_node_name, "region" ) )
+        p_ids = &p_ctx->region_ids;
+
+    if( p_ids )
+    {
+        const char *psz = vlc_dictionary_value_for_key( &p_node->attr_dict, "xml:id" );
+        if( !psz ) /* People can't do xml properly */
+            psz = vlc_dictionary_value_for_key( &p_node->attr_dict, "id" );
+        if( psz && !vlc_dictionary_has_key( p_ids, psz ) )
+            vlc_dictionary_insert( p_ids, psz, p_node );
+    }
+
+    for( tt_basenode_t *p_child = p_node->p_child;
+                        p_child; p_child = p_child->p_next )
+    {
+        if( p_child->i_type != TT_NODE_TYPE_TEXT )
+            IndexTTMLIds( p_ctx, (tt_node_t *) p_child );
+    }
+}
+
+static void CleanTTMLContext( ttml_context_t *p_ctx )
+{
+    vlc_dictionary_clear( &p_ctx->style_ids, NULL, NULL );
+    vlc_dictionary_clear( &p_ctx->region_ids, NULL, NULL );
+    for( size_t i = 0; i < p_ctx->i_styles; i++ )
+        if( p_ctx->p_styles[i].p_style )
+            ttml_style_Delete( p_ctx->p_styles[i].p_style );
+    free( p_ctx->p_styles );
+}
+
 static void InitTTMLContext( tt_node_t *p_rootnode, ttml_context_t *p_ctx )
 {
     p_ctx->p_rootnode = p_rootnode;
+    p_ctx->p_styles = NULL;
+    p_ctx->i_styles = 0;
+    vlc_dictionary_init( &p_ctx->style_ids, 0 );
+    vlc_dictionary_init( &p_ctx->region_ids, 0 );
+    IndexTTMLIds( p_ctx, p_rootnode );
     /* set defaults required for size/cells computation */
     p_ctx->root_extent_h.i_value = 100;
     p_ctx->root_extent_h.unit = TTML_UNIT_PERCENT;
@@ -982,26 +1074,23 @@ static void InitTTMLContext( tt_node_t *p_rootnode, ttml_context_t *p_ctx )
     }
 }
 
-static ttml_region_t *GenerateRegions( tt_node_t *p_rootnode, tt_time_t playbacktime )
+static ttml_region_t *GenerateRegions( ttml_context_t *p_ctx, tt_time_t playbacktime )
 {
     ttml_region_t*  p_regions = NULL;
     ttml_region_t** pp_region_last = &p_regions;
+    tt_node_t *p_rootnode = p_ctx->p_rootnode;
 
     if( !tt_node_NameCompare( p_rootnode->psz_node_name, "tt" ) )
     {
         const tt_node_t *p_bodynode = FindNode( p_rootnode, "body", 1, NULL );
         if( p_bodynode )
         {
-            ttml_context_t context;
-            InitTTMLContext( p_rootnode, &context );
-            context.p_rootnode = p_rootnode;
-
-            vlc_dictionary_init( &context.regions, 1 );
-            ConvertNodesToRegionContent( &context, p_bodynode, NULL, NULL, playbacktime );
+            vlc_dictionary_init( &p_ctx->regions, 1 );
+            ConvertNodesToRegionContent( p_ctx, p_bodynode, NULL, NULL, playbacktime );
 
-            for( int i = 0; i < context.regions.i_size; ++i )
+            for( int i = 0; i < p_ctx->regions.i_size; ++i )
             {
-                for ( const vlc_dictionary_entry_t* p_entry = context.regions.p_entries[i];
+                for ( const vlc_dictionary_entry_t* p_entry = p_ctx->regions.p_entries[i];
                                                     p_entry != NULL; p_entry = p_entry->p_next )
                 {
                     *pp_region_last = (ttml_region_t *) p_entry->p_value;
@@ -1009,7 +1098,7 @@ static ttml_region_t *GenerateRegions( tt_node_t *p_rootnode, tt_time_t playback
                 }
             }
 
-            vlc_dictionary_clear( &context.regions, NULL, NULL );
+            vlc_dictionary_clear( &p_ctx->regions, NULL, NULL );
         }
     }
     else if ( !tt_node_NameCompare( p_rootnode->psz_node_name, "div" ) ||
@@ -1051,6 +1140,9 @@ static int ParseBlock( decoder_t *p_dec, const block_t *p_block )
     tt_timings_Resolve( (tt_basenode_t *) p_rootnode, &temporal_extent,
                         &p_timings_array, &i_timings_count );
 
+    ttml_context_t context;
+    InitTTMLContext( p_rootnode, &context );
+
 #ifdef TTML_DEBUG
     for( size_t i=0; i<i_timings_count; i++ )
         printf("%ld ", tt_time_Convert( &p_timings_array[i] ) );
@@ -1067,7 +1159,7 @@ static int ParseBlock( decoder_t *p_dec, const block_t *p_block )
             break;
 
         subpicture_t *p_spu = NULL;
-        ttml_region_t *p_regions = GenerateRegions( p_rootnode, p_timings_array[i] );
+        ttml_region_t *p_regions = GenerateRegions( &context, p_timings_array[i] );
         if( p_regions && ( p_spu = decoder_NewSubpictureText( p_dec ) ) )
         {
             p_spu->i_start    = VLC_TICK_0 + tt_time_Convert( &p_timings_array[i] );
@@ -1121,6 +1213,7 @@ static int ParseBlock( decoder_t *p_dec, const block_t *p_block )
             decoder_QueueSub( p_dec, p_spu );
     }
 
+    CleanTTMLContext( &context );
     tt_node_RecursiveDelete( p_rootnode );
 
     free( p_timings_array );
@@ -157,6 +157,8 @@ struct decoder_sys_t
 #ifdef HAVE_CSS
     /* CSS */
     vlc_css_rule_t *p_css_rules;
+    text_style_t  **pp_css_styles; /* declarations of each rule, as a style */
+    size_t          i_css_styles;
 #endif
 };
 
@@ -1659,37 +1661,84 @@ static void ClearCSSStyles( webvtt_dom_node_t *p_node )
 }
 
 #ifdef HAVE_CSS
+static void FillStyleFromCssRule( const vlc_css_rule_t *p_rule,
+                                  text_style_t *p_style )
+{
+    for( const vlc_css_declaration_t *p_decl = p_rule->p_declarations;
+                                      p_decl; p_decl = p_decl->p_next )
+        webvtt_FillStyleFromCssDeclaration( p_decl, p_style );
+}
+
+/* Converts the declarations of the newly parsed rules only once, instead of
+ * on every node and every rendering */
+static void UpdateCSSStyles( decoder_sys_t *p_sys )
+{
+    size_t i_count = 0;
+    for( const vlc_css_rule_t *p_rule = p_sys->p_css_rules;
+                               p_rule; p_rule = p_rule->p_next )
+        i_count++;
+
+    if( i_count <= p_sys->i_css_styles )
+        return;
+
+    text_style_t **pp_styles = realloc( p_sys->pp_css_styles,
+                                        i_count * sizeof(*pp_styles) );
+    if( unlikely( !pp_styles ) )
+        return;
+    p_sys->pp_css_styles = pp_styles;
+
+    const vlc_css_rule_t *p_rule = p_sys->p_css_rules;
+    for( size_t i = 0; i < i_count; i++, p_rule = p_rule->p_next )
+    {
+        if( i < p_sys->i_css_styles )
+            continue;
+        pp_styles[i] = text_style_Create( STYLE_NO_DEFAULTS );
+        if( pp_styles[i] )
+            FillStyleFromCssRule( p_rule, pp_styles[i] );
+    }
+    p_sys->i_css_styles = i_count;
+}
+
 static void ApplyCSSRules( decoder_t *p_dec, const vlc_css_rule_t *p_rule,
                            vlc_tick_t i_nzplaybacktime )
 {
-    for ( ;  p_rule ; p_rule = p_rule->p_next )
+    decoder_sys_t *p_sys = p_dec->p_sys;
+
+    for ( size_t i_rule = 0; p_rule ; p_rule = p_rule->p_next, i_rule++ )
     {
         vlc_array_t results;
         vlc_array_init( &results );
 
         webvtt_domnode_SelectRuleNodes( p_dec, p_rule, i_nzplaybacktime, &results );
 
-        for( const vlc_css_declaration_t *p_decl = p_rule->p_declarations;
-                                          p_decl; p_decl = p_decl->p_next )
+        const text_style_t *p_rulestyle = ( i_rule < p_sys->i_css_styles )
+                                        ? p_sys->pp_css_styles[i_rule] : NULL;
+
+        for( size_t i=0; i<vlc_array_count(&results); i++ )
         {
-            for( size_t i=0; i<vlc_array_count(&results); i++ )
+            webvtt_dom_node_t *p_node = vlc_array_item_at_index( &results, i );
+            if( !webvtt_domnode_supportsCSSStyle( p_node ) )
+                continue;
+
+            text_style_t *p_style = webvtt_domnode_getCSSStyle( p_node );
+            if( !p_style && p_rulestyle )
             {
-                webvtt_dom_node_t *p_node = vlc_array_item_at_index( &results, i );
-                if( !webvtt_domnode_supportsCSSStyle( p_node ) )
-                    continue;
+                /* Same as filling a new style from the declarations */
+                webvtt_domnode_setCSSStyle( p_node,
+                                            text_style_Duplicate( p_rulestyle ) );
+                continue;
+            }
 
-                text_style_t *p_style = webvtt_domnode_getCSSStyle( p_node );
-                if( !p_style )
-                {
-                    p_style = text_style_Create( STYLE_NO_DEFAULTS );
-                    webvtt_domnode_setCSSStyle( p_node, p_style );
-                }
+            if( !p_style )
+            {
+                p_style = text_style_Create( STYLE_NO_DEFAULTS );
+                webvtt_domnode_setCSSStyle( p_node, p_style );
+            }
 
-                if( !p_style )
-                    continue;
+            if( !p_style )
+                continue;
 
-                webvtt_FillStyleFromCssDeclaration( p_decl, p_style );
-            }
+            FillStyleFromCssRule( p_rule, p_style );
         }
         vlc_array_clear( &results );
     }
@@ -1984,6 +2033,8 @@ static void ParserHeaderHandler( void *priv, enum webvtt_header_line_e s,
 
                 vlc_css_parser_Clean(&p);
                 free( ctx->css.ptr );
+
+                UpdateCSSStyles( p_sys );
             }
         }
 #endif
@@ -2090,6 +2141,9 @@ void webvtt_CloseDecoder( vlc_object_t *p_this )
 
 #ifdef HAVE_CSS
     vlc_css_rules_Delete( p_sys->p_css_rules );
+    for( size_t i = 0; i < p_sys->i_css_styles; i++ )
+        text_style_Delete( p_sys->pp_css_styles[i] );
+    free( p_sys->pp_css_styles );
 #endif
 
     free( p_sys );
@@ -410,6 +410,10 @@ static void x264_log( void *, int i_level, const char *psz, va_list );
 
 #define HRD_TEXT N_("HRD-timing information")
 #define TUNE_TEXT N_("Default tune setting used" )
+#define LATENCY_TEXT N_("Target latency (ms)")
+#define LATENCY_LONGTEXT N_( "Encode for low-latency streaming: sliced " \
+    "threads, no lookahead nor B-frames, periodic intra refresh, and a VBV " \
+    "buffer holding this much of the bitrate. 0 disables this mode." )
 #define PRESET_TEXT N_("Default preset setting used" )
 
 #define X264_OPTIONS_TEXT N_("x264 advanced options")
@@ -727,6 +731,9 @@ vlc_module_begin ()
         vlc_config_set (VLC_CONFIG_LIST,
             (sizeof(x264_tune_names) / sizeof (char*)) - 1,
             x264_tune_names, x264_tune_names);
+    add_integer( SOUT_CFG_PREFIX "latency", 0, LATENCY_TEXT,
+                 LATENCY_LONGTEXT, false )
+        change_integer_range( 0, 10000 )
 
     add_string( SOUT_CFG_PREFIX "options", NULL, X264_OPTIONS_TEXT,
                 X264_OPTIONS_LONGTEXT, true )
@@ -751,7 +758,7 @@ static const char *const ppsz_sout_options[] = {
     "aq-mode", "aq-strength", "psy-rd", "psy", "profile", "lookahead", "slices",
     "slice-max-size", "slice-max-mbs", "intra-refresh", "mbtree", "hrd",
     "tune","preset", "opengop", "bluray-compat", "frame-packing", "options",
-    "fullrange",
+    "fullrange", "latency",
     NULL
 };
 
@@ -876,6 +883,20 @@ static int  Open ( vlc_object_t *p_this )
         free(psz_preset);
         psz_preset = NULL;
     }
+    const int i_latency = var_GetInteger( p_enc, SOUT_CFG_PREFIX "latency" );
+    if( i_latency > 0 )
+    {
+        /* zerolatency: sliced threads, no lookahead, B-frames nor mb-tree */
+        char *psz_low;
+        if( asprintf( &psz_low, "%s%szerolatency", psz_tune ? psz_tune : "",
+                      psz_tune && *psz_tune ? "," : "" ) < 0 )
+            psz_low = NULL;
+        if( psz_low != NULL )
+        {
+            free( psz_tune );
+            psz_tune = psz_low;
+        }
+    }
 #ifdef MODULE_NAME_IS_x262
     p_sys->param.b_mpeg2 = true;
     x264_param_default_mpeg2( &p_sys->param );
@@ -1002,6 +1023,16 @@ static int  Open ( vlc_object_t *p_this )
     /* max bitrate = average bitrate -> CBR */
     p_sys->param.rc.i_vbv_max_bitrate = var_GetInteger( p_enc, SOUT_CFG_PREFIX "vbv-maxrate" );
 
+    /* Bound the buffering to the target latency, unless set explicitly */
+    if( i_latency > 0 && p_sys->param.rc.i_bitrate > 0 )
+    {
+        if( p_sys->param.rc.i_vbv_max_bitrate <= 0 )
+            p_sys->param.rc.i_vbv_max_bitrate = p_sys->param.rc.i_bitrate;
+        if( p_sys->param.rc.i_vbv_buffer_size <= 0 )
+            p_sys->param.rc.i_vbv_buffer_size = __MAX( 1,
+                p_sys->param.rc.i_vbv_max_bitrate * i_latency / 1000 );
+    }
+
 
     if( !var_GetBool( p_enc, SOUT_CFG_PREFIX "mbtree" ) )
        p_sys->param.rc.b_mb_tree = var_GetBool( p_enc, SOUT_CFG_PREFIX "mbtree" );
@@ -1093,7 +1124,9 @@ static int  Open ( vlc_object_t *p_this )
     if( i_val >= 0 && i_val <= 16 && i_val != 3 )
         p_sys->param.i_bframe = i_val;
 
-    p_sys->param.b_intra_refresh = var_GetBool( p_enc, SOUT_CFG_PREFIX "intra-refresh" );
+    /* no large IDR frames to buffer in low-latency mode */
+    p_sys->param.b_intra_refresh = i_latency > 0 ||
+        var_GetBool( p_enc, SOUT_CFG_PREFIX "intra-refresh" );
 
     psz_val = var_GetString( p_enc, SOUT_CFG_PREFIX "bpyramid" );
     if( !strcmp( psz_val, "normal" ) )
@@ -1448,6 +1481,8 @@ static int  Open ( vlc_object_t *p_this )
     }
 
     p_enc->fmt_out.i_extra = i_extra;
+    p_enc->i_delay = x264_encoder_maximum_delayed_frames( p_sys->h );
+    msg_Dbg( p_enc, "encoder delay: %d frame(s)", p_enc->i_delay );
 
     return VLC_SUCCESS;
 }
@@ -42,14 +42,30 @@
 static int  Open (vlc_object_t *);
 static void Close(vlc_object_t *);
 
+#define SOUT_CFG_PREFIX "sout-x265-"
+
+#define LATENCY_TEXT N_("Target latency (ms)")
+#define LATENCY_LONGTEXT N_("Encode for low-latency streaming: wavefront " \
+    "threads only, no lookahead nor B-frames, periodic intra refresh, and " \
+    "a VBV buffer holding this much of the bitrate. 0 disables this mode.")
+
 vlc_module_begin ()
     set_description(N_("H.265/HEVC encoder (x265)"))
     set_capability("encoder", 200)
     set_callbacks(Open, Close)
     set_category(CAT_INPUT)
     set_subcategory(SUBCAT_INPUT_VCODEC)
+
+    add_integer(SOUT_CFG_PREFIX "latency", 0, LATENCY_TEXT,
+                LATENCY_LONGTEXT, false)
+        change_integer_range(0, 10000)
 vlc_module_end ()
 
+static const char *const ppsz_sout_options[] = {
+    "latency",
+    NULL
+};
+
 struct encoder_sys_t
 {
     x265_encoder    *h;
@@ -150,13 +166,28 @@ static int  Open (vlc_object_t *p_this)
     if (!p_sys)
         return VLC_ENOMEM;
 
+    config_ChainParse(p_enc, SOUT_CFG_PREFIX, ppsz_sout_options, p_enc->p_cfg);
+
     p_enc->fmt_in.i_codec = VLC_CODEC_I420;
 
     x265_param *param = &p_sys->param;
     x265_param_default(param);
 
-    param->frameNumThreads = vlc_GetCPUCount();
-    param->bEnableWavefront = 0; // buggy in x265, use frame threading for now
+    const int i_latency = var_GetInteger(p_enc, SOUT_CFG_PREFIX "latency");
+    if (i_latency > 0) {
+        /* no lookahead, B-frames nor cu-tree */
+        x265_param_default_preset(param, NULL, "zerolatency");
+        /* every frame thread delays the output by one frame: wavefront
+         * is the only parallelism left */
+        param->frameNumThreads = 1;
+        param->bEnableWavefront = 1;
+#if X265_BUILD >= 68
+        param->bIntraRefresh = 1;
+#endif
+    } else {
+        param->frameNumThreads = vlc_GetCPUCount();
+        param->bEnableWavefront = 0; // buggy in x265, use frame threading for now
+    }
     param->maxCUSize = 16; /* use smaller macroblock */
 
 #if X265_BUILD >= 6
@@ -192,6 +223,12 @@ static int  Open (vlc_object_t *p_this)
     if (p_enc->fmt_out.i_bitrate > 0) {
         param->rc.bitrate = p_enc->fmt_out.i_bitrate / 1000;
         param->rc.rateControlMode = X265_RC_ABR;
+
+        /* bound the buffering to the target latency */
+        if (i_latency > 0) {
+            param->rc.vbvMaxBitrate = param->rc.bitrate;
+            param->rc.vbvBufferSize = __MAX(1, param->rc.bitrate * i_latency / 1000);
+        }
     }
 
     p_sys->h = x265_encoder_open(param);
@@ -229,6 +266,8 @@ static int  Open (vlc_object_t *p_this)
     p_sys->dts = 0;
     p_sys->initial_date = 0;
     p_sys->i_initial_delay = 0;
+    p_enc->i_delay = param->frameNumThreads - 1 + param->lookaheadDepth +
+                     param->bframes;
 
     p_enc->pf_encode_video = Encode;
     p_enc->pf_encode_audio = NULL;
@@ -648,20 +648,23 @@ static int OpaquePage( picture_t *p_src, const vbi_page *p_page,
 
     assert( p_fmt->i_chroma == VLC_CODEC_RGBA );
 
-    /* Kludge since zvbi doesn't provide an option to specify opacity. */
+    /* Kludge since zvbi doesn't provide an option to specify opacity.
+     * The opacity is the same for the 12 pixels of a character line. */
     for( y = 0; y < p_fmt->i_height; y++ )
     {
-        for( x = 0; x < p_fmt->i_width; x++ )
+        const vbi_char *p_row = &p_page->text[ text_offset + y/10 * p_page->columns ];
+        uint32_t *p_line = (uint32_t*)&p_src->p->p_pixels[y * p_src->p->i_pitch];
+
+        for( x = 0; x < p_fmt->i_width; x += 12 )
         {
-            const vbi_opacity opacity = p_page->text[ text_offset + y/10 * p_page->columns + x/12 ].opacity;
-            const int background = p_page->text[ text_offset + y/10 * p_page->columns + x/12 ].background;
-            uint32_t *p_pixel = (uint32_t*)&p_src->p->p_pixels[y * p_src->p->i_pitch + 4*x];
+            const vbi_char *p_char = &p_row[ x/12 ];
+            const unsigned i_cell = __MIN( 12, p_fmt->i_width - x );
 
-            switch( opacity )
+            switch( p_char->opacity )
             {
             /* Show video instead of this character */
             case VBI_TRANSPARENT_SPACE:
-                *p_pixel = 0;
+                memset( &p_line[x], 0, i_cell * sizeof(*p_line) );
                 break;
             /* Display foreground and background color */
             /* To make the boxed text "closed captioning" transparent
@@ -674,10 +677,15 @@ static int OpaquePage( picture_t *p_src, const vbi_page *p_page,
                     break;
             /* Full text transparency. only foreground color is show */
             case VBI_TRANSPARENT_FULL:
-                if( (*p_pixel) == (0xff000000 | p_page->color_map[background] ) )
-                    *p_pixel = 0;
+            {
+                const uint32_t background =
+                    0xff000000 | p_page->color_map[p_char->background];
+                for( unsigned i = 0; i < i_cell; i++ )
+                    if( p_line[x + i] == background )
+                        p_line[x + i] = 0;
                 break;
             }
+            }
         }
     }
     /* end of kludge */
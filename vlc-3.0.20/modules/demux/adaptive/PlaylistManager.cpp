@@ -36,7 +36,10 @@
 #include "logic/AlwaysLowestAdaptationLogic.hpp"
 #include "logic/PredictiveAdaptationLogic.hpp"
 #include "logic/NearOptimalAdaptationLogic.hpp"
+#include "logic/HybridAdaptationLogic.hpp"
 #include "logic/BufferingLogic.hpp"
+#include "http/BandwidthCache.hpp"
+#include "SessionMetrics.hpp"
 #include "tools/Debug.hpp"
 #include <vlc_stream.h>
 #include <vlc_demux.h>
@@ -83,15 +86,31 @@ PlaylistManager::PlaylistManager( demux_t *p_demux_,
     cached.playlistEnd = 0;
     cached.playlistLength = 0;
     cached.lastupdate = 0;
+    catchupRate = 1.0f;
+    startupTime = VLC_TICK_INVALID;
+    b_playing = false;
+    metrics = new SessionMetrics(VLC_OBJECT(p_demux), (vlc_object_t *) p_demux->p_input);
+    resources->getConnManager()->setMetricsObserver(metrics);
 }
 
 PlaylistManager::~PlaylistManager   ()
 {
+    vlc_object_t *p_input = (vlc_object_t *) p_demux->p_input;
+    if(catchupRate != 1.0f && p_input &&
+       var_GetFloat(p_input, "rate") == catchupRate)
+        var_SetFloat(p_input, "rate", 1.0f);
     delete streamFactory;
     unsetPeriod();
+    /* remember this origin's bandwidth for the next sessions */
+    BandwidthCache *bwcache = resources->getBandwidthCache();
+    size_t bps;
+    vlc_tick_t rtt;
+    if(bwcache && resources->getConnManager()->getBandwidthEstimate(&bps, &rtt))
+        bwcache->put(bps, rtt);
     delete playlist;
     delete logic;
     delete resources;
+    delete metrics;
     delete bufferingLogic;
     vlc_cond_destroy(&waitcond);
     vlc_mutex_destroy(&lock);
@@ -129,6 +148,7 @@ bool PlaylistManager::setupPeriod()
                                                          &synchronizationReferences);
             if(!tracker)
                 continue;
+            tracker->registerListener(metrics);
 
             AbstractStream *st = streamFactory->create(p_demux, set->getStreamFormat(),
                                                        tracker);
@@ -148,12 +168,23 @@ bool PlaylistManager::setupPeriod()
                 st->setDescription(set->description.Get());
         }
     }
+
+    /* Issue all streams init and first segment requests at once,
+       otherwise each one waits for the previous one's round trips */
+    if(!b_preparsing && !streams.empty())
+    {
+        resources->getConnManager()->setParallelDownloads(streams.size());
+        for(AbstractStream *st : streams)
+            st->prefetchStart();
+    }
     return true;
 }
 
 bool PlaylistManager::init(bool b_preparsing)
 {
     this->b_preparsing = b_preparsing;
+    if(!b_preparsing)
+        startupTime = mdate();
 
     if(!setupPeriod())
         return false;
@@ -517,6 +548,7 @@ int PlaylistManager::doDemux(int64_t increment)
                     return VLC_DEMUXER_EOF;
 
                 demux.times = Times();
+                b_playing = false;
                 demux.firsttimes = Times();
                 es_out_Control(p_demux->out, ES_OUT_RESET_PCR);
 
@@ -525,6 +557,9 @@ int PlaylistManager::doDemux(int64_t increment)
         }
         break;
     case AbstractStream::Status::Buffering:
+        /* ran out of data after playback started */
+        if(b_playing)
+            metrics->setRebuffering(true);
         vlc_mutex_lock(&demux.lock);
         vlc_cond_timedwait(&demux.cond, &demux.lock, mdate() + CLOCK_FREQ / 20);
         vlc_mutex_unlock(&demux.lock);
@@ -532,6 +567,7 @@ int PlaylistManager::doDemux(int64_t increment)
     case AbstractStream::Status::Discontinuity:
         vlc_mutex_lock(&demux.lock);
         demux.times = Times();
+        b_playing = false;
         demux.firsttimes = Times();
         demux.pcr_syncpoint = TimestampSynchronizationPoint::Discontinuity;
         es_out_Control(p_demux->out, ES_OUT_RESET_PCR);
@@ -544,8 +580,15 @@ int PlaylistManager::doDemux(int64_t increment)
             demux.times = barrier;
             vlc_tick_t pcr = VLC_TICK_0 + std::max(INT64_C(0), demux.times.continuous - CLOCK_FREQ/10);
             es_out_Control(p_demux->out, ES_OUT_SET_GROUP_PCR, 0, pcr);
+            if(startupTime != VLC_TICK_INVALID)
+            {
+                metrics->setStartupTime(mdate() - startupTime);
+                startupTime = VLC_TICK_INVALID;
+            }
+            b_playing = true;
         }
         vlc_mutex_unlock(&demux.lock);
+        metrics->setRebuffering(false);
         break;
     }
 
@@ -584,6 +627,7 @@ int PlaylistManager::doControl(int i_query, va_list args)
             {
                 vlc_tick_t now = mdate();
                 demux.times = Times();
+                b_playing = false;
                 cached.lastupdate = 0;
                 if(b_pause)
                 {
@@ -655,6 +699,7 @@ int PlaylistManager::doControl(int i_query, va_list args)
 
             demux.pcr_syncpoint = TimestampSynchronizationPoint::RandomAccess;
             demux.times = Times();
+            b_playing = false;
             demux.firsttimes = Times();
             cached.lastupdate = 0;
             cached.i_time = VLC_TICK_INVALID;
@@ -677,6 +722,7 @@ int PlaylistManager::doControl(int i_query, va_list args)
             vlc_mutex_locker locker(&cached.lock);
             demux.pcr_syncpoint = TimestampSynchronizationPoint::RandomAccess;
             demux.times = Times();
+            b_playing = false;
             demux.firsttimes = Times();
             cached.lastupdate = 0;
             cached.i_time = VLC_TICK_INVALID;
@@ -829,6 +875,10 @@ void PlaylistManager::updateControlsPosition()
         {
             cached.f_position = 0.0;
         }
+
+        if(cached.i_time != VLC_TICK_INVALID && cached.playlistEnd &&
+           bufferingLogic && bufferingLogic->isLowLatency(playlist))
+            updatePlaybackRate(VLC_TICK_0 + cached.playlistEnd - cached.i_time);
     }
     else
     {
@@ -851,6 +901,38 @@ void PlaylistManager::updateControlsPosition()
                             startTimes.segment.demux, cached.f_position));
 }
 
+void PlaylistManager::updatePlaybackRate(vlc_tick_t latency)
+{
+    vlc_object_t *p_input = (vlc_object_t *) p_demux->p_input;
+    if(!p_input)
+        return;
+
+    /* rate was changed by the user */
+    if(var_GetFloat(p_input, "rate") != catchupRate)
+        return;
+
+    /* Latency is measured from the demuxed position, which is ahead of
+     * the playback by the decoders buffering. Only drift matters here. */
+    const vlc_tick_t target = bufferingLogic->getLiveDelay(playlist);
+    const vlc_tick_t tolerance = std::max(target / 4, CLOCK_FREQ / 2);
+    float rate = catchupRate;
+    if(latency > target + tolerance)
+        rate = playlist->maxPlaybackRate.Get() > 1.0f ? playlist->maxPlaybackRate.Get() : 1.05f;
+    else if(latency < target - tolerance)
+        rate = (playlist->minPlaybackRate.Get() > 0.0f && playlist->minPlaybackRate.Get() < 1.0f)
+             ? playlist->minPlaybackRate.Get() : 0.95f;
+    else if((rate > 1.0f && latency <= target) || (rate < 1.0f && latency >= target))
+        rate = 1.0f;
+
+    if(rate == catchupRate)
+        return;
+
+    msg_Dbg(p_demux, "live latency %" PRId64 "ms, target %" PRId64 "ms, playback rate %.2f",
+            latency / 1000, target / 1000, rate);
+    catchupRate = rate;
+    var_SetFloat(p_input, "rate", rate);
+}
+
 AbstractAdaptationLogic *PlaylistManager::createLogic(AbstractAdaptationLogic::LogicType type, AbstractConnectionManager *conn)
 {
     vlc_object_t *obj = VLC_OBJECT(p_demux);
@@ -888,6 +970,15 @@ AbstractAdaptationLogic *PlaylistManager::createLogic(AbstractAdaptationLogic::L
             logic = noplogic;
             break;
         }
+        case AbstractAdaptationLogic::LogicType::Hybrid:
+        {
+            HybridAdaptationLogic *hybridlogic =
+                    new (std::nothrow) HybridAdaptationLogic(obj);
+            if(hybridlogic)
+                conn->setDownloadRateObserver(hybridlogic);
+            logic = hybridlogic;
+            break;
+        }
         case AbstractAdaptationLogic::LogicType::Predictive:
         {
             AbstractAdaptationLogic *predictivelogic =
@@ -916,6 +1007,12 @@ AbstractAdaptationLogic *PlaylistManager::createLogic(AbstractAdaptationLogic::L
         }
 
         logic->setMaxDeviceResolution(w, h);
+
+        BandwidthCache *bwcache = resources->getBandwidthCache();
+        size_t bps;
+        vlc_tick_t rtt;
+        if(bwcache && bwcache->get(&bps, &rtt))
+            logic->setInitialBandwidth(bps, rtt);
     }
 
     return logic;
@@ -932,6 +1029,10 @@ AbstractBufferingLogic *PlaylistManager::createBufferingLogic() const
         v = var_InheritInteger(p_demux, "adaptive-maxbuffer");
         if(v)
             bl->setUserMaxBuffering(CLOCK_FREQ / 1000 * v);
+        bl->setUserPrefetchSegments(var_InheritInteger(p_demux, "adaptive-prefetch"));
+        int lowlatency = var_InheritInteger(p_demux, "adaptive-lowlatency");
+        if(lowlatency != -1)
+            bl->setLowDelay(lowlatency);
     }
     return bl;
 }
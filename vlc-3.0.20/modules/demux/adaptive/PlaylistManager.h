@@ -39,6 +39,8 @@ namespace adaptive
         class AbstractConnectionManager;
     }
 
+    class SessionMetrics;
+
     using namespace playlist;
     using namespace logic;
 
@@ -91,6 +93,7 @@ namespace adaptive
             void unsetPeriod();
 
             void updateControlsPosition();
+            void updatePlaybackRate(vlc_tick_t);
 
             /* local factories */
             virtual AbstractAdaptationLogic *createLogic(AbstractAdaptationLogic::LogicType,
@@ -142,6 +145,14 @@ namespace adaptive
 
             SynchronizationReferences synchronizationReferences;
 
+            /* Low latency live catch up */
+            float                                catchupRate;
+
+            /* Startup, until first PCR, and stalls */
+            vlc_tick_t                           startupTime;
+            bool                                 b_playing;
+            SessionMetrics                      *metrics;
+
         private:
             void setBufferingRunState(bool);
             void Run();
@@ -250,7 +250,8 @@ bool SegmentTracker::ChunkEntry::isValid() const
 }
 
 SegmentTracker::ChunkEntry
-SegmentTracker::prepareChunk(bool switch_allowed, Position pos) const
+SegmentTracker::prepareChunk(bool switch_allowed, Position pos,
+                             BaseRepresentation *nextrep) const
 {
     if(!adaptationSet)
         return ChunkEntry();
@@ -270,7 +271,9 @@ SegmentTracker::prepareChunk(bool switch_allowed, Position pos) const
         if(switch_allowed)
         {
             Position temp;
-            temp.rep = logic->getNextRepresentation(adaptationSet, pos.rep);
+            /* the caller may have already asked the logic */
+            temp.rep = nextrep ? nextrep
+                               : logic->getNextRepresentation(adaptationSet, pos.rep);
             if(temp.rep && temp.rep != pos.rep)
             {
                 /* Convert our segment number if we need to */
@@ -305,6 +308,16 @@ SegmentTracker::prepareChunk(bool switch_allowed, Position pos) const
         segment = pos.rep->getInitSegment();
         if(!segment)
             ++pos;
+        else if(pos.rep->needsIndex())
+        {
+            /* index range can include the init one: save a request */
+            ISegment *index = pos.rep->getIndexSegment();
+            if(index && index->contains(segment->getOffset()))
+            {
+                segment = index;
+                pos.init_sent = true;
+            }
+        }
     }
 
     if(!segment && !pos.index_sent)
@@ -349,9 +362,23 @@ ChunkInterface * SegmentTracker::getNextChunk(bool switch_allowed)
     if(!adaptationSet || !next.isValid())
         return nullptr;
 
+    /* Prefetched chunks were prepared without switching. Drop them if
+       the logic now wants another representation at a switching point */
+    BaseRepresentation *nextrep = nullptr;
+    if(!chunkssequence.empty() && switch_allowed &&
+       adaptationSet->isSegmentAligned() && next.init_sent && next.index_sent)
+    {
+        BaseRepresentation *rep = logic->getNextRepresentation(adaptationSet, next.rep);
+        if(rep && rep != chunkssequence.front().pos.rep)
+        {
+            resetChunksSequence();
+            nextrep = rep;
+        }
+    }
+
     if(chunkssequence.empty())
     {
-        ChunkEntry chunk = prepareChunk(switch_allowed, next);
+        ChunkEntry chunk = prepareChunk(switch_allowed, next, nextrep);
         chunkssequence.push_back(chunk);
     }
 
@@ -436,11 +463,61 @@ ChunkInterface * SegmentTracker::getNextChunk(bool switch_allowed)
                                chunk.starttime, chunk.duration, chunk.displaytime));
 
     if(!b_gap)
+    {
         ++next;
+        prefetchChunks();
+    }
 
     return returnedChunk;
 }
 
+void SegmentTracker::prefetchChunks()
+{
+    const unsigned count = bufferingLogic->getPrefetchSegments(adaptationSet->getPlaylist());
+    if(count == 0 || !next.isValid())
+        return;
+
+    /* Estimate sizes from the advertised bitrate. Init and index
+       chunks are not accounted */
+    auto estimate = [](const Position &p, vlc_tick_t duration) -> uint64_t
+    {
+        if(!p.init_sent || !p.index_sent)
+            return 0;
+        return p.rep->getBandwidth() / 8 * duration / CLOCK_FREQ;
+    };
+
+    const uint64_t budget = bufferingLogic->getPrefetchBudget(next.rep);
+    uint64_t queued = 0;
+    Position pos = next;
+    for(const ChunkEntry &entry : chunkssequence)
+    {
+        queued += estimate(entry.pos, entry.duration);
+        pos = entry.pos;
+        ++pos;
+    }
+
+    while(chunkssequence.size() < count)
+    {
+        /* Check the budget before preparing, as that starts the download */
+        vlc_tick_t startTime, duration;
+        if(budget &&
+           pos.rep->getPlaybackTimeDurationBySegmentNumber(pos.number, &startTime, &duration) &&
+           queued + estimate(pos, duration) > budget)
+            break;
+
+        ChunkEntry entry = prepareChunk(false, pos);
+        if(!entry.isValid())
+        {
+            delete entry.chunk;
+            break;
+        }
+        queued += estimate(entry.pos, entry.duration);
+        chunkssequence.push_back(entry);
+        pos = entry.pos;
+        ++pos;
+    }
+}
+
 bool SegmentTracker::setPositionByTime(vlc_tick_t time, bool restarted, bool tryonly)
 {
     Position pos = Position(current.rep, current.number);
@@ -512,6 +589,35 @@ bool SegmentTracker::setStartPosition()
     return true;
 }
 
+bool SegmentTracker::prefetchStart()
+{
+    if(!adaptationSet || current.isValid() || !chunkssequence.empty())
+        return false;
+
+    if(!setStartPosition())
+        return false;
+
+    /* Request init, index and first media segment upfront, so all
+       streams start in parallel instead of fetching in turn */
+    Position pos = next;
+    for(;;)
+    {
+        ChunkEntry entry = prepareChunk(false, pos);
+        if(!entry.isValid())
+        {
+            delete entry.chunk;
+            break;
+        }
+        chunkssequence.push_back(entry);
+        if(entry.pos.init_sent && entry.pos.index_sent)
+            break;
+        pos = entry.pos;
+        ++pos;
+    }
+
+    return !chunkssequence.empty();
+}
+
 vlc_tick_t SegmentTracker::getPlaybackTime(bool b_next) const
 {
     vlc_tick_t time, duration;
@@ -226,6 +226,7 @@ namespace adaptive
             bool setPositionByTime(mtime_t, bool, bool);
             void setPosition(const Position &, bool);
             bool setStartPosition();
+            bool prefetchStart();
             Position getStartPosition() const;
             vlc_tick_t getPlaybackTime(bool = false) const; /* Current segment start time if selected */
             bool getMediaPlaybackRange(vlc_tick_t *, vlc_tick_t *, vlc_tick_t *) const;
@@ -252,8 +253,10 @@ namespace adaptive
                     vlc_tick_t duration;
             };
             std::list<ChunkEntry> chunkssequence;
-            ChunkEntry prepareChunk(bool switch_allowed, Position pos) const;
+            ChunkEntry prepareChunk(bool switch_allowed, Position pos,
+                                    BaseRepresentation * = nullptr) const;
             void resetChunksSequence();
+            void prefetchChunks();
             void setAdaptationLogic(AbstractAdaptationLogic *);
             void notify(const TrackerEvent &) const;
             bool first;
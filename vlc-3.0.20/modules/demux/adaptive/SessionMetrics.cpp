@@ -0,0 +1,202 @@
+/*
+ * SessionMetrics.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "SessionMetrics.hpp"
+#include "playlist/BaseAdaptationSet.h"
+#include "playlist/BaseRepresentation.h"
+
+#include <vlc_variables.h>
+
+#include <sstream>
+
+using namespace adaptive;
+using namespace adaptive::playlist;
+
+static std::string JSONString(const std::string &s)
+{
+    std::string out("\"");
+    for(char c : s)
+    {
+        if(c == '"' || c == '\\')
+            out += '\\';
+        if((unsigned char) c >= 0x20)
+            out += c;
+    }
+    return out + '"';
+}
+
+SessionMetrics::StreamMetrics::StreamMetrics()
+{
+    bandwidth = 0;
+    switches = 0;
+    buffering = 0;
+    segments = 0;
+    bytes = 0;
+    lastDownloadTime = 0;
+    lastLatency = 0;
+    lastSize = 0;
+}
+
+SessionMetrics::SessionMetrics(vlc_object_t *obj, vlc_object_t *var)
+{
+    p_obj = obj;
+    p_var = var;
+    vlc_mutex_init(&lock);
+    startupTime = VLC_TICK_INVALID;
+    rebuffers = 0;
+    rebufferingStart = VLC_TICK_INVALID;
+    rebufferingTotal = 0;
+    if(p_var)
+        var_Create(p_var, "adaptive-metrics", VLC_VAR_STRING);
+}
+
+SessionMetrics::~SessionMetrics()
+{
+    if(p_var)
+        var_Destroy(p_var, "adaptive-metrics");
+    vlc_mutex_destroy(&lock);
+}
+
+void SessionMetrics::trackerEvent(const TrackerEvent &ev)
+{
+    switch(ev.getType())
+    {
+        case TrackerEvent::Type::RepresentationSwitch:
+        {
+            const RepresentationSwitchEvent &event =
+                    static_cast<const RepresentationSwitchEvent &>(ev);
+            if(!event.next)
+                break;
+            vlc_mutex_lock(&lock);
+            StreamMetrics &stream = streams[event.next->getAdaptationSet()->getID().str()];
+            if(event.prev)
+                stream.switches++;
+            stream.representation = event.next->getID().str();
+            stream.bandwidth = event.next->getBandwidth();
+            vlc_mutex_unlock(&lock);
+            publish();
+        }
+        break;
+
+        case TrackerEvent::Type::BufferingLevelChange:
+        {
+            const BufferingLevelChangedEvent &event =
+                    static_cast<const BufferingLevelChangedEvent &>(ev);
+            vlc_mutex_lock(&lock);
+            streams[event.id->str()].buffering = event.current;
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+        default:
+            break;
+    }
+}
+
+void SessionMetrics::updateDownloadRate(const ID &id, size_t size,
+                                        vlc_tick_t time, vlc_tick_t latency)
+{
+    vlc_mutex_lock(&lock);
+    StreamMetrics &stream = streams[id.str()];
+    stream.segments++;
+    stream.bytes += size;
+    stream.lastSize = size;
+    stream.lastDownloadTime = time;
+    stream.lastLatency = latency;
+    vlc_mutex_unlock(&lock);
+    publish();
+}
+
+void SessionMetrics::setStartupTime(vlc_tick_t time)
+{
+    vlc_mutex_lock(&lock);
+    startupTime = time;
+    vlc_mutex_unlock(&lock);
+    if(p_obj)
+        msg_Dbg(p_obj, "time to first PCR %" PRId64 "ms", time / 1000);
+    publish();
+}
+
+void SessionMetrics::setRebuffering(bool b)
+{
+    const vlc_tick_t now = mdate();
+    vlc_mutex_lock(&lock);
+    if(b == (rebufferingStart != VLC_TICK_INVALID))
+    {
+        vlc_mutex_unlock(&lock);
+        return;
+    }
+    if(b)
+    {
+        rebufferingStart = now;
+        rebuffers++;
+    }
+    else
+    {
+        rebufferingTotal += now - rebufferingStart;
+        if(p_obj)
+            msg_Dbg(p_obj, "rebuffered for %" PRId64 "ms",
+                    (now - rebufferingStart) / 1000);
+        rebufferingStart = VLC_TICK_INVALID;
+    }
+    vlc_mutex_unlock(&lock);
+    publish();
+}
+
+std::string SessionMetrics::toString() const
+{
+    std::stringstream ss;
+    ss.imbue(std::locale("C"));
+    vlc_mutex_lock(&lock);
+    ss << "{\"startup_ms\":"
+       << (startupTime != VLC_TICK_INVALID ? startupTime / 1000 : -1)
+       << ",\"rebuffers\":" << rebuffers
+       << ",\"rebuffering_ms\":" << rebufferingTotal / 1000
+       << ",\"rebuffering\":" << (rebufferingStart != VLC_TICK_INVALID ? "true" : "false")
+       << ",\"streams\":[";
+    for(auto it = streams.begin(); it != streams.end(); ++it)
+    {
+        const StreamMetrics &s = (*it).second;
+        if(it != streams.begin())
+            ss << ',';
+        ss << "{\"id\":" << JSONString((*it).first)
+           << ",\"representation\":" << JSONString(s.representation)
+           << ",\"bandwidth\":" << s.bandwidth
+           << ",\"switches\":" << s.switches
+           << ",\"buffer_ms\":" << s.buffering / 1000
+           << ",\"segments\":" << s.segments
+           << ",\"bytes\":" << s.bytes
+           << ",\"last_segment\":{\"bytes\":" << s.lastSize
+           << ",\"download_ms\":" << s.lastDownloadTime / 1000
+           << ",\"ttfb_ms\":" << s.lastLatency / 1000 << "}}";
+    }
+    vlc_mutex_unlock(&lock);
+    ss << "]}";
+    return ss.str();
+}
+
+void SessionMetrics::publish() const
+{
+    if(p_var)
+        var_SetString(p_var, "adaptive-metrics", toString().c_str());
+}
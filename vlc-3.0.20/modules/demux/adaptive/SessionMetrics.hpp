@@ -0,0 +1,77 @@
+/*
+ * SessionMetrics.hpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef SESSIONMETRICS_HPP_
+#define SESSIONMETRICS_HPP_
+
+#include "SegmentTracker.hpp"
+#include "logic/IDownloadRateObserver.h"
+
+#include <vlc_common.h>
+#include <map>
+#include <string>
+
+namespace adaptive
+{
+    /* Startup, download, representation and buffering figures of the
+     * session, published as a JSON string in the input "adaptive-metrics"
+     * variable for monitoring */
+    class SessionMetrics : public SegmentTrackerListenerInterface,
+                           public IDownloadRateObserver
+    {
+        public:
+            SessionMetrics(vlc_object_t *, vlc_object_t *);
+            virtual ~SessionMetrics();
+
+            virtual void trackerEvent(const TrackerEvent &) override;
+            virtual void updateDownloadRate(const ID &, size_t,
+                                            vlc_tick_t, vlc_tick_t) override;
+            void setStartupTime(vlc_tick_t);
+            void setRebuffering(bool);
+            std::string toString() const;
+
+        private:
+            void publish() const;
+            vlc_object_t *p_obj;
+            vlc_object_t *p_var; /* holding the variable */
+            mutable vlc_mutex_t lock;
+
+            class StreamMetrics
+            {
+                public:
+                    StreamMetrics();
+                    std::string representation;
+                    uint64_t bandwidth;
+                    unsigned switches;
+                    vlc_tick_t buffering;
+                    uint64_t segments;
+                    uint64_t bytes;
+                    vlc_tick_t lastDownloadTime;
+                    vlc_tick_t lastLatency;
+                    size_t lastSize;
+            };
+            std::map<std::string, StreamMetrics> streams;
+            vlc_tick_t startupTime;
+            unsigned rebuffers;
+            vlc_tick_t rebufferingStart;
+            vlc_tick_t rebufferingTotal;
+    };
+}
+
+#endif
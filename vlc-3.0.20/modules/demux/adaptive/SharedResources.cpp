@@ -23,6 +23,7 @@
 
 #include "SharedResources.hpp"
 #include "http/AuthStorage.hpp"
+#include "http/BandwidthCache.hpp"
 #include "http/HTTPConnectionManager.h"
 #include "http/HTTPConnection.hpp"
 #include "encryption/Keyring.hpp"
@@ -30,15 +31,18 @@
 using namespace adaptive;
 
 SharedResources::SharedResources(AuthStorage *auth, Keyring *ring,
-                                 AbstractConnectionManager *conn)
+                                 AbstractConnectionManager *conn,
+                                 BandwidthCache *bwcache)
 {
     authStorage = auth;
     encryptionKeyring = ring;
     connManager = conn;
+    bandwidthCache = bwcache;
 }
 
 SharedResources::~SharedResources()
 {
+    delete bandwidthCache;
     delete connManager;
     delete encryptionKeyring;
     delete authStorage;
@@ -59,6 +63,11 @@ AbstractConnectionManager * SharedResources::getConnManager()
     return connManager;
 }
 
+BandwidthCache * SharedResources::getBandwidthCache()
+{
+    return bandwidthCache;
+}
+
 SharedResources * SharedResources::createDefault(vlc_object_t *obj,
                                                  const std::string & playlisturl)
 {
@@ -66,10 +75,12 @@ SharedResources * SharedResources::createDefault(vlc_object_t *obj,
     Keyring *keyring = new Keyring(obj);
     HTTPConnectionManager *m = new HTTPConnectionManager(obj);
     if(!var_InheritBool(obj, "adaptive-use-access")) /* only use http from access */
-        m->addFactory(new LibVLCHTTPConnectionFactory(auth));
+        m->addFactory(new LibVLCHTTPConnectionFactory(auth,
+                                var_InheritBool(obj, "adaptive-http2")));
     m->addFactory(new StreamUrlConnectionFactory());
     ConnectionParams params(playlisturl);
     if(params.isLocal())
         m->setLocalConnectionsAllowed();
-    return new SharedResources(auth, keyring, m);
+    BandwidthCache *bwcache = new BandwidthCache(obj, params.getHostname());
+    return new SharedResources(auth, keyring, m, bwcache);
 }
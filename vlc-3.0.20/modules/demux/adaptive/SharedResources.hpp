@@ -28,6 +28,7 @@ namespace adaptive
     namespace http
     {
         class AuthStorage;
+        class BandwidthCache;
         class AbstractConnectionManager;
     }
 
@@ -42,11 +43,13 @@ namespace adaptive
     class SharedResources
     {
         public:
-            SharedResources(AuthStorage *, Keyring *, AbstractConnectionManager *);
+            SharedResources(AuthStorage *, Keyring *, AbstractConnectionManager *,
+                            BandwidthCache * = nullptr);
             ~SharedResources();
             AuthStorage *getAuthStorage();
             Keyring     *getKeyring();
             AbstractConnectionManager *getConnManager();
+            BandwidthCache *getBandwidthCache();
             /* Helper */
             static SharedResources * createDefault(vlc_object_t *, const std::string &);
 
@@ -54,6 +57,7 @@ namespace adaptive
             AuthStorage *authStorage;
             Keyring *encryptionKeyring;
             AbstractConnectionManager *connManager;
+            BandwidthCache *bandwidthCache;
     };
 }
 
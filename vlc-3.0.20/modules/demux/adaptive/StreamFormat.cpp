@@ -62,6 +62,8 @@ std::string StreamFormat::str() const
             return "WebM";
         case Type::Ogg:
             return "Ogg";
+        case Type::FLV:
+            return "FLV";
         case Type::Unsupported:
             return "Unsupported";
         default:
@@ -100,6 +102,8 @@ StreamFormat::StreamFormat( const std::string &mimetype )
             type = StreamFormat::Type::TTML;
         else if (tail == "webm")
             type = StreamFormat::Type::WebM;
+        else if (tail == "x-flv")
+            type = StreamFormat::Type::FLV;
     }
 }
 
@@ -40,6 +40,7 @@ namespace adaptive
                 PackedAAC,
                 PackedMP3,
                 PackedAC3,
+                FLV,
                 Unknown,
             };
             static const unsigned PEEK_SIZE   = 4096;
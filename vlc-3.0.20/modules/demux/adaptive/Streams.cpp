@@ -335,6 +335,14 @@ bool AbstractStream::isDisabled() const
     return disabled;
 }
 
+bool AbstractStream::prefetchStart()
+{
+    vlc_mutex_locker locker(&lock);
+    if(!valid || disabled || demuxer)
+        return false;
+    return segmentTracker->prefetchStart();
+}
+
 void AbstractStream::setLivePause(bool b)
 {
     vlc_mutex_locker locker(&lock);
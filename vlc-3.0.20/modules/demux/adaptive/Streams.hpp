@@ -70,6 +70,7 @@ namespace adaptive
         bool isDisabled() const;
         bool isValid() const;
         void setLivePause(bool);
+        bool prefetchStart();
         enum class Status {
             Eof = 0, /* prioritized */
             Discontinuity,
@@ -48,6 +48,9 @@
 #include "../smooth/SmoothManager.hpp"
 #include "../smooth/SmoothStream.hpp"
 #include "../smooth/playlist/SmoothParser.hpp"
+#include "../hds/HDSManager.hpp"
+#include "../hds/HDSStream.hpp"
+#include "../hds/playlist/F4MParser.hpp"
 
 using namespace adaptive::http;
 using namespace adaptive::logic;
@@ -59,6 +62,8 @@ using namespace hls;
 using namespace hls::playlist;
 using namespace smooth;
 using namespace smooth::playlist;
+using namespace hds;
+using namespace hds::playlist;
 
 /*****************************************************************************
  * Module descriptor
@@ -82,6 +87,29 @@ static void Close   (vlc_object_t *);
 #define ADAPT_ACCESS_TEXT N_("Use regular HTTP modules")
 #define ADAPT_ACCESS_LONGTEXT N_("Connect using HTTP access instead of custom HTTP code")
 
+#define ADAPT_PREFETCH_TEXT N_("Segments prefetch")
+#define ADAPT_PREFETCH_LONGTEXT N_("Number of segments to request ahead of the one " \
+                                   "being demuxed, within the max buffering")
+
+#define ADAPT_CONNECTIONS_TEXT N_("Parallel downloads")
+#define ADAPT_CONNECTIONS_LONGTEXT N_("Number of segments downloaded at once, " \
+                                      "each over its own connection")
+
+#define ADAPT_HTTP2_TEXT N_("Multiplex HTTPS requests")
+#define ADAPT_HTTP2_LONGTEXT N_("Send all requests to a same HTTPS server over a " \
+                                "single HTTP/2 connection. Servers without HTTP/2 " \
+                                "support then get one connection per request")
+
+#define ADAPT_BWCACHE_TEXT N_("Remember bandwidth")
+#define ADAPT_BWCACHE_LONGTEXT N_("Start new sessions from the bandwidth last " \
+                                  "measured with the same server, instead of the " \
+                                  "lowest quality")
+
+#define ADAPT_SEGCACHE_TEXT N_("Segments cache size (MiB)")
+#define ADAPT_SEGCACHE_LONGTEXT N_("Memory kept for already downloaded segments, " \
+                                   "so seeking back or switching back to a " \
+                                   "quality does not download them again. 0 disables")
+
 #define ADAPT_LOWLATENCY_TEXT N_("Low latency")
 #define ADAPT_LOWLATENCY_LONGTEXT N_("Overrides low latency parameters")
 
@@ -89,6 +117,7 @@ static const AbstractAdaptationLogic::LogicType pi_logics[] = {
                                 AbstractAdaptationLogic::LogicType::Default,
                                 AbstractAdaptationLogic::LogicType::Predictive,
                                 AbstractAdaptationLogic::LogicType::NearOptimal,
+                                AbstractAdaptationLogic::LogicType::Hybrid,
                                 AbstractAdaptationLogic::LogicType::RateBased,
                                 AbstractAdaptationLogic::LogicType::FixedRate,
                                 AbstractAdaptationLogic::LogicType::AlwaysLowest,
@@ -98,6 +127,7 @@ static const char *const ppsz_logics_values[] = {
                                 "",
                                 "predictive",
                                 "nearoptimal",
+                                "hybrid",
                                 "rate",
                                 "fixedrate",
                                 "lowest",
@@ -106,6 +136,7 @@ static const char *const ppsz_logics_values[] = {
 static const char *const ppsz_logics[] = { N_("Default"),
                                            N_("Predictive"),
                                            N_("Near Optimal"),
+                                           N_("Hybrid Throughput/Buffer"),
                                            N_("Bandwidth Adaptive"),
                                            N_("Fixed Bandwidth"),
                                            N_("Lowest Bandwidth/Quality"),
@@ -137,12 +168,20 @@ vlc_module_begin ()
                      ADAPT_HEIGHT_TEXT, ADAPT_HEIGHT_TEXT, false )
         add_integer( "adaptive-bw",     250, ADAPT_BW_TEXT,     ADAPT_BW_LONGTEXT,     false )
         add_bool   ( "adaptive-use-access", false, ADAPT_ACCESS_TEXT, ADAPT_ACCESS_LONGTEXT, true );
+        add_bool   ( "adaptive-http2", false, ADAPT_HTTP2_TEXT, ADAPT_HTTP2_LONGTEXT, true );
+        add_bool   ( "adaptive-bw-cache", true, ADAPT_BWCACHE_TEXT, ADAPT_BWCACHE_LONGTEXT, true );
         add_integer( "adaptive-livedelay",
                      AbstractBufferingLogic::DEFAULT_LIVE_BUFFERING / 1000,
                      ADAPT_BUFFER_TEXT, ADAPT_BUFFER_LONGTEXT, true );
         add_integer( "adaptive-maxbuffer",
                      AbstractBufferingLogic::DEFAULT_MAX_BUFFERING  / 1000,
                      ADAPT_MAXBUFFER_TEXT, nullptr, true );
+        add_integer_with_range( "adaptive-prefetch", 0, 0, 16,
+                     ADAPT_PREFETCH_TEXT, ADAPT_PREFETCH_LONGTEXT, true );
+        add_integer_with_range( "adaptive-connections", 1, 1, 8,
+                     ADAPT_CONNECTIONS_TEXT, ADAPT_CONNECTIONS_LONGTEXT, true );
+        add_integer_with_range( "adaptive-segment-cache", 16, 0, 1024,
+                     ADAPT_SEGCACHE_TEXT, ADAPT_SEGCACHE_LONGTEXT, true );
         add_integer( "adaptive-lowlatency", -1, ADAPT_LOWLATENCY_TEXT, ADAPT_LOWLATENCY_LONGTEXT, true );
             change_integer_list(rgi_latency, ppsz_latency)
         set_callbacks( Open, Close )
@@ -157,6 +196,8 @@ static PlaylistManager * HandleSmooth(demux_t *, DOMParser &,
                                       const std::string &, AbstractAdaptationLogic::LogicType);
 static PlaylistManager * HandleHLS(demux_t *,
                                    const std::string &, AbstractAdaptationLogic::LogicType);
+static PlaylistManager * HandleHDS(demux_t *, DOMParser &,
+                                   const std::string &, AbstractAdaptationLogic::LogicType);
 
 /*****************************************************************************
  * Open:
@@ -202,8 +243,9 @@ static int Open(vlc_object_t *p_obj)
 
     bool dashmime = DASHManager::mimeMatched(mimeType);
     bool smoothmime = SmoothManager::mimeMatched(mimeType);
+    bool hdsmime = HDSManager::mimeMatched(mimeType);
 
-    if(!dashmime && !smoothmime && HLSManager::isHTTPLiveStreaming(p_demux->s))
+    if(!dashmime && !smoothmime && !hdsmime && HLSManager::isHTTPLiveStreaming(p_demux->s))
     {
         p_manager = HandleHLS(p_demux, playlisturl, logic);
     }
@@ -219,6 +261,10 @@ static int Open(vlc_object_t *p_obj)
         {
             p_manager = HandleSmooth(p_demux, xmlParser, playlisturl, logic);
         }
+        else if(hdsmime)
+        {
+            p_manager = HandleHDS(p_demux, xmlParser, playlisturl, logic);
+        }
         else
         {
             /* We need to probe content */
@@ -239,6 +285,10 @@ static int Open(vlc_object_t *p_obj)
                         {
                             p_manager = HandleSmooth(p_demux, xmlParser, playlisturl, logic);
                         }
+                        else if(HDSManager::isHDS(xmlParser.getRootNode()))
+                        {
+                            p_manager = HandleHDS(p_demux, xmlParser, playlisturl, logic);
+                        }
                     }
                     vlc_stream_Delete(peekstream);
                 }
@@ -376,3 +426,42 @@ static PlaylistManager * HandleHLS(demux_t *p_demux,
     }
     return manager;
 }
+
+static PlaylistManager * HandleHDS(demux_t *p_demux, DOMParser &xmlParser,
+                                   const std::string & playlisturl,
+                                   AbstractAdaptationLogic::LogicType logic)
+{
+    if(!xmlParser.reset(p_demux->s) || !xmlParser.parse(true))
+    {
+        msg_Err(p_demux, "Cannot parse F4M manifest");
+        return nullptr;
+    }
+
+    /* bootstraps can be external */
+    SharedResources *resources =
+            SharedResources::createDefault(VLC_OBJECT(p_demux), playlisturl);
+    if(!resources)
+        return nullptr;
+
+    F4MParser parser(xmlParser.getRootNode(), VLC_OBJECT(p_demux),
+                     resources, playlisturl);
+    F4M *p_playlist = parser.parse();
+    if(p_playlist == nullptr)
+    {
+        msg_Err( p_demux, "Cannot create F4M manifest");
+        delete resources;
+        return nullptr;
+    }
+
+    HDSStreamFactory *factory = new (std::nothrow) HDSStreamFactory;
+    HDSManager *manager = nullptr;
+    if(!factory ||
+       !(manager = new (std::nothrow) HDSManager(p_demux, resources,
+                                                 p_playlist, factory, logic)))
+    {
+        delete p_playlist;
+        delete factory;
+        delete resources;
+    }
+    return manager;
+}
@@ -0,0 +1,182 @@
+/*
+ * BandwidthCache.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLabs and VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "BandwidthCache.hpp"
+
+#include <vlc_configuration.h>
+#include <vlc_fs.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <ctime>
+#include <vector>
+
+using namespace adaptive::http;
+
+#define CACHE_FILENAME   "adaptive-bandwidth.txt"
+#define CACHE_MAXENTRIES 64
+
+BandwidthCache::BandwidthCache( vlc_object_t *obj, const std::string &host )
+{
+    p_obj = obj;
+    origin = host;
+    if( origin.empty() || !var_InheritBool( obj, "adaptive-bw-cache" ) )
+        return;
+
+    char *psz_dir = config_GetUserDir( VLC_CACHE_DIR );
+    if( psz_dir )
+    {
+        path = std::string( psz_dir ) + DIR_SEP + CACHE_FILENAME;
+        free( psz_dir );
+        load();
+    }
+}
+
+BandwidthCache::~BandwidthCache()
+{
+}
+
+bool BandwidthCache::get( size_t *bps, vlc_tick_t *rtt ) const
+{
+    std::map<std::string, Entry>::const_iterator it = entries.find( origin );
+    if( it == entries.end() )
+        return false;
+    *bps = (*it).second.bps;
+    *rtt = (*it).second.rtt;
+    return true;
+}
+
+void BandwidthCache::put( size_t bps, vlc_tick_t rtt )
+{
+    if( path.empty() || bps == 0 )
+        return;
+
+    Entry entry;
+    entry.bps = bps;
+    entry.rtt = rtt;
+    entry.date = time( nullptr );
+    entries[origin] = entry;
+
+    save();
+}
+
+void BandwidthCache::read( std::map<std::string, Entry> *out ) const
+{
+    FILE *fp = vlc_fopen( path.c_str(), "r" );
+    if( !fp )
+        return;
+
+    const time_t now = time( nullptr );
+    char host[256];
+    uintmax_t bps;
+    int64_t rtt, date;
+    while( fscanf( fp, "%255s %ju %" SCNd64 " %" SCNd64,
+                   host, &bps, &rtt, &date ) == 4 )
+    {
+        if( date > now || now - date > EXPIRATION || bps == 0 || rtt < 0 )
+            continue;
+        Entry entry;
+        entry.bps = bps;
+        entry.rtt = rtt;
+        entry.date = date;
+        (*out)[std::string( host )] = entry;
+    }
+    fclose( fp );
+}
+
+void BandwidthCache::load()
+{
+    read( &entries );
+
+    std::map<std::string, Entry>::const_iterator it = entries.find( origin );
+    if( it != entries.end() )
+        msg_Dbg( p_obj, "cached bandwidth for %s: %zu kbps, rtt %" PRId64 "ms",
+                 origin.c_str(), (*it).second.bps / 1000, (*it).second.rtt / 1000 );
+}
+
+void BandwidthCache::save()
+{
+    char *psz_dir = config_GetUserDir( VLC_CACHE_DIR );
+    if( psz_dir )
+    {
+        vlc_mkdir( psz_dir, 0700 );
+        free( psz_dir );
+    }
+
+    /* other sessions may have updated other hosts since we loaded:
+     * keep the most recent estimate of each */
+    std::map<std::string, Entry> ondisk;
+    read( &ondisk );
+    for( std::map<std::string, Entry>::const_iterator it = ondisk.begin();
+                                                      it != ondisk.end(); ++it )
+    {
+        std::map<std::string, Entry>::iterator cur = entries.find( (*it).first );
+        if( cur == entries.end() )
+            entries.insert( *it );
+        else if( (*it).first != origin && (*cur).second.date < (*it).second.date )
+            (*cur).second = (*it).second;
+    }
+
+    /* drop the least recently used hosts */
+    while( entries.size() > CACHE_MAXENTRIES )
+    {
+        std::map<std::string, Entry>::iterator oldest = entries.begin();
+        for( std::map<std::string, Entry>::iterator it = entries.begin();
+                                                    it != entries.end(); ++it )
+        {
+            if( (*it).second.date < (*oldest).second.date )
+                oldest = it;
+        }
+        entries.erase( oldest );
+    }
+
+    /* write aside under a unique name then rename, as concurrent
+     * sessions may race */
+    std::vector<char> tmppath( path.begin(), path.end() );
+    static const char suffix[] = ".XXXXXX";
+    tmppath.insert( tmppath.end(), suffix, suffix + sizeof(suffix) );
+
+    int fd = vlc_mkstemp( &tmppath[0] );
+    FILE *fp = (fd != -1) ? fdopen( fd, "w" ) : nullptr;
+    if( !fp )
+    {
+        if( fd != -1 )
+        {
+            vlc_close( fd );
+            vlc_unlink( &tmppath[0] );
+        }
+        msg_Warn( p_obj, "cannot write bandwidth cache %s", path.c_str() );
+        return;
+    }
+
+    for( std::map<std::string, Entry>::const_iterator it = entries.begin();
+                                                      it != entries.end(); ++it )
+    {
+        fprintf( fp, "%s %ju %" PRId64 " %" PRId64 "\n", (*it).first.c_str(),
+                 (uintmax_t) (*it).second.bps, (int64_t) (*it).second.rtt,
+                 (int64_t) (*it).second.date );
+    }
+
+    if( fclose( fp ) != 0 || vlc_rename( &tmppath[0], path.c_str() ) != 0 )
+        vlc_unlink( &tmppath[0] );
+}
@@ -0,0 +1,64 @@
+/*
+ * BandwidthCache.hpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLabs and VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef BANDWIDTHCACHE_HPP_
+#define BANDWIDTHCACHE_HPP_
+
+#include <vlc_common.h>
+
+#include <map>
+#include <string>
+
+namespace adaptive
+{
+    namespace http
+    {
+        /* Last bandwidth and round trip time estimates, per origin host,
+         * kept in the user cache dir so new sessions do not have to climb
+         * through the whole ladder */
+        class BandwidthCache
+        {
+            public:
+                BandwidthCache(vlc_object_t *, const std::string &);
+                ~BandwidthCache();
+                bool get(size_t *, vlc_tick_t *) const;
+                void put(size_t, vlc_tick_t);
+
+                static const time_t EXPIRATION = 7 * 24 * 3600;
+
+            private:
+                class Entry
+                {
+                    public:
+                        size_t bps;
+                        vlc_tick_t rtt;
+                        time_t date;
+                };
+                void read(std::map<std::string, Entry> *) const;
+                void load();
+                void save();
+                vlc_object_t *p_obj;
+                std::string origin;
+                std::string path;
+                std::map<std::string, Entry> entries;
+        };
+    }
+}
+
+#endif
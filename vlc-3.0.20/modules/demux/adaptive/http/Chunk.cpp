@@ -225,7 +225,7 @@ block_t * HTTPChunkSource::read(size_t readsize)
     }
 
     ssize_t ret = connection->read(p_block->p_buffer, readsize);
-    if(ret < 0)
+    if(ret <= 0)
     {
         block_Release(p_block);
         p_block = nullptr;
@@ -236,19 +236,21 @@ block_t * HTTPChunkSource::read(size_t readsize)
     {
         p_block->i_buffer = (size_t) ret;
         consumed += p_block->i_buffer;
-        if((size_t)ret < readsize)
+        /* reads can be short, only the content length tells the end */
+        if(consumed == contentLength)
         {
             eof = true;
             downloadEndTime = mdate();
         }
-        if(ret && connection->getBytesRead() &&
-           downloadEndTime > requestStartTime && type == ChunkType::Segment)
-        {
-            connManager->updateDownloadRate(sourceid,
-                                            connection->getBytesRead(),
-                                            downloadEndTime - requestStartTime,
-                                            downloadEndTime - responseTime);
-        }
+    }
+
+    if(eof && connection->getBytesRead() &&
+       downloadEndTime > requestStartTime && type == ChunkType::Segment)
+    {
+        connManager->updateDownloadRate(sourceid,
+                                        connection->getBytesRead(),
+                                        downloadEndTime - requestStartTime,
+                                        responseTime - requestStartTime);
     }
 
     return p_block;
@@ -270,7 +272,7 @@ std::string HTTPChunkSource::getContentType() const
     if(connection)
         return connection->getContentType();
     else
-        return std::string();
+        return contentType;
 }
 
 void HTTPChunkSource::setIdentifier(const std::string &s, const BytesRange &r)
@@ -278,6 +280,17 @@ void HTTPChunkSource::setIdentifier(const std::string &s, const BytesRange &r)
     storeid =  makeStorageID(s, r);
 }
 
+void HTTPChunkSource::releaseConnection()
+{
+    vlc_mutex_locker locker(&lock);
+    if(connection)
+    {
+        contentType = connection->getContentType();
+        connection->setUsed(false);
+        connection = nullptr;
+    }
+}
+
 bool HTTPChunkSource::prepare()
 {
     if(prepared)
@@ -376,6 +389,12 @@ bool HTTPChunkBufferedSource::isDone() const
     return done;
 }
 
+bool HTTPChunkBufferedSource::isComplete() const
+{
+    vlc_mutex_locker locker( &lock );
+    return done && contentLength && buffered == contentLength;
+}
+
 void HTTPChunkBufferedSource::hold()
 {
     vlc_mutex_locker locker( &lock );
@@ -446,7 +465,8 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
             p_read = p_block;
             inblockreadoffset = 0;
         }
-        if((size_t) ret < readsize)
+        /* reads can be short, only the content length tells the end */
+        if(contentLength == buffered)
         {
             done = true;
             downloadEndTime = mdate();
@@ -473,9 +493,12 @@ bool HTTPChunkBufferedSource::hasMoreData() const
 
 void HTTPChunkBufferedSource::recycle()
 {
+    vlc_mutex_lock(&lock);
     p_read = p_head;
     inblockreadoffset = 0;
     consumed = 0;
+    eof = (p_head == nullptr && done);
+    vlc_mutex_unlock(&lock);
     HTTPChunkSource::recycle();
 }
 
@@ -137,6 +137,7 @@ namespace adaptive
 
                 virtual bool        prepare();
                 void                setIdentifier(const std::string &, const BytesRange &);
+                void                releaseConnection();
                 AbstractConnection    *connection;
                 AbstractConnectionManager *connManager;
                 mutable vlc_mutex_t lock;
@@ -151,12 +152,14 @@ namespace adaptive
             private:
                 bool init(const std::string &);
                 ConnectionParams    params;
+                std::string         contentType; /* once connection released */
         };
 
         class HTTPChunkBufferedSource : public HTTPChunkSource
         {
             friend class HTTPConnectionManager;
             friend class Downloader;
+            friend class SourceCache;
 
             public:
                 virtual ~HTTPChunkBufferedSource();
@@ -171,6 +174,7 @@ namespace adaptive
                                         bool = false);
                 void               bufferize(size_t);
                 bool               isDone() const;
+                bool               isComplete() const;
                 void               hold();
                 void               release();
 
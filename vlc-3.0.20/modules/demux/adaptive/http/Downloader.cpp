@@ -25,6 +25,7 @@
 
 #include <vlc_threads.h>
 #include <vlc_atomic.h>
+#include <vlc_trace.h>
 
 using namespace adaptive::http;
 
@@ -34,20 +35,18 @@ Downloader::Downloader()
     vlc_cond_init(&waitcond);
     vlc_cond_init(&updatedcond);
     killed = false;
-    thread_handle_valid = false;
-    current = nullptr;
-    cancel_current = false;
 }
 
-bool Downloader::start()
+bool Downloader::start(unsigned count)
 {
-    if(!thread_handle_valid &&
-       vlc_clone(&thread_handle, downloaderThread,
-                 static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT))
+    while(thread_handles.size() < count)
     {
-        return false;
+        vlc_thread_t handle;
+        if(vlc_clone(&handle, downloaderThread,
+                     static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT))
+            return !thread_handles.empty();
+        thread_handles.push_back(handle);
     }
-    thread_handle_valid = true;
     return true;
 }
 
@@ -55,11 +54,11 @@ Downloader::~Downloader()
 {
     vlc_mutex_lock( &lock );
     killed = true;
-    vlc_cond_signal(&waitcond);
+    vlc_cond_broadcast(&waitcond);
     vlc_mutex_unlock( &lock );
 
-    if(thread_handle_valid)
-        vlc_join(thread_handle, nullptr);
+    for(vlc_thread_t handle : thread_handles)
+        vlc_join(handle, nullptr);
     vlc_mutex_destroy(&lock);
     vlc_cond_destroy(&waitcond);
 }
@@ -75,10 +74,11 @@ void Downloader::schedule(HTTPChunkBufferedSource *source)
 void Downloader::cancel(HTTPChunkBufferedSource *source)
 {
     vlc_mutex_lock(&lock);
-    while (current == source)
+    if(isCurrent(source))
     {
-        cancel_current = true;
-        vlc_cond_wait(&updatedcond, &lock);
+        cancelled.push_back(source);
+        while(isCurrent(source))
+            vlc_cond_wait(&updatedcond, &lock);
     }
 
     if(!source->isDone())
@@ -89,6 +89,23 @@ void Downloader::cancel(HTTPChunkBufferedSource *source)
     vlc_mutex_unlock(&lock);
 }
 
+bool Downloader::isCurrent(const HTTPChunkBufferedSource *source) const
+{
+    for(const HTTPChunkBufferedSource *s : current)
+        if(s == source)
+            return true;
+    return false;
+}
+
+HTTPChunkBufferedSource * Downloader::getNext() const
+{
+    /* Oldest request first, skipping the ones other threads are on */
+    for(HTTPChunkBufferedSource *source : chunks)
+        if(!isCurrent(source))
+            return source;
+    return nullptr;
+}
+
 void * Downloader::downloaderThread(void *opaque)
 {
     Downloader *instance = static_cast<Downloader *>(opaque);
@@ -101,24 +118,29 @@ void Downloader::Run()
     vlc_mutex_lock(&lock);
     while(1)
     {
-        while(chunks.empty() && !killed)
+        HTTPChunkBufferedSource *source;
+        while(!(source = getNext()) && !killed)
             vlc_cond_wait(&waitcond, &lock);
 
         if(killed)
             break;
 
-        current = chunks.front();
+        current.push_back(source);
         vlc_mutex_unlock(&lock);
-        current->bufferize(HTTPChunkSource::CHUNK_SIZE);
+        vlc_trace_begin("adaptive", "download");
+        source->bufferize(HTTPChunkSource::CHUNK_SIZE);
+        vlc_trace_end("adaptive", "download");
         vlc_mutex_lock(&lock);
-        if(current->isDone() || cancel_current)
+        current.remove(source);
+
+        const size_t count = cancelled.size();
+        cancelled.remove(source);
+        if(source->isDone() || cancelled.size() != count)
         {
-            chunks.pop_front();
-            current->release();
+            chunks.remove(source);
+            source->release();
         }
-        cancel_current = false;
-        current = nullptr;
-        vlc_cond_signal(&updatedcond);
+        vlc_cond_broadcast(&updatedcond);
     }
     vlc_mutex_unlock(&lock);
 }
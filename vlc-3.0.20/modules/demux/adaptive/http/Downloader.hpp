@@ -24,6 +24,7 @@
 
 #include <vlc_common.h>
 #include <list>
+#include <vector>
 
 namespace adaptive
 {
@@ -36,22 +37,24 @@ namespace adaptive
             public:
                 Downloader();
                 ~Downloader();
-                bool start();
+                bool start(unsigned = 1);
                 void schedule(HTTPChunkBufferedSource *);
                 void cancel(HTTPChunkBufferedSource *);
 
             private:
                 static void * downloaderThread(void *);
                 void Run();
-                vlc_thread_t thread_handle;
+                HTTPChunkBufferedSource * getNext() const;
+                bool isCurrent(const HTTPChunkBufferedSource *) const;
+                std::vector<vlc_thread_t> thread_handles;
                 vlc_mutex_t  lock;
                 vlc_cond_t   waitcond;
                 vlc_cond_t   updatedcond;
-                bool         thread_handle_valid;
                 bool         killed;
-                bool         cancel_current;
                 std::list<HTTPChunkBufferedSource *> chunks;
-                HTTPChunkBufferedSource *current;
+                /* sources being bufferized, one per thread at most */
+                std::list<HTTPChunkBufferedSource *> current;
+                std::list<HTTPChunkBufferedSource *> cancelled;
         };
 
     }
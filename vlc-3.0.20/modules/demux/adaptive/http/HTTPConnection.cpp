@@ -88,15 +88,17 @@ class adaptive::http::LibVLCHTTPSource : public adaptive::AbstractSource
      friend class LibVLCHTTPConnection;
 
      public:
-        LibVLCHTTPSource(vlc_object_t *p_object, struct vlc_http_cookie_jar_t *jar)
+        LibVLCHTTPSource(vlc_object_t *p_object, struct vlc_http_cookie_jar_t *jar,
+                         struct vlc_http_mgr *shared)
         {
-            http_mgr = vlc_http_mgr_create(p_object, jar);
+            owned = (shared == nullptr);
+            http_mgr = owned ? vlc_http_mgr_create(p_object, jar) : shared;
             http_res = nullptr;
             totalRead = 0;
         }
         virtual ~LibVLCHTTPSource()
         {
-            if(http_mgr)
+            if(http_mgr && owned)
                 vlc_http_mgr_destroy(http_mgr);
         }
         virtual block_t *readNextBlock() override
@@ -186,6 +188,7 @@ class adaptive::http::LibVLCHTTPSource : public adaptive::AbstractSource
         static const struct vlc_http_resource_cbs callbacks;
         size_t totalRead;
         struct vlc_http_mgr *http_mgr;
+        bool owned;
         BytesRange range;
 
     public:
@@ -235,10 +238,11 @@ const struct vlc_http_resource_cbs LibVLCHTTPSource::callbacks =
     LibVLCHTTPSource::validateresponse_handler,
 };
 
-LibVLCHTTPConnection::LibVLCHTTPConnection(vlc_object_t *p_object_, AuthStorage *auth)
+LibVLCHTTPConnection::LibVLCHTTPConnection(vlc_object_t *p_object_, AuthStorage *auth,
+                                           struct vlc_http_mgr *shared)
     : AbstractConnection( p_object_ )
 {
-    source = new adaptive::http::LibVLCHTTPSource(p_object_, auth->getJar());
+    source = new adaptive::http::LibVLCHTTPSource(p_object_, auth->getJar(), shared);
     sourceStream = new ChunksSourceStream(p_object, source);
     stream = nullptr;
     char *psz_useragent = var_InheritString(p_object_, "http-user-agent");
@@ -408,7 +412,9 @@ RequestStatus LibVLCHTTPConnection::request(const std::string &path,
 
 ssize_t LibVLCHTTPConnection::read(void *p_buffer, size_t len)
 {
-    ssize_t read = vlc_stream_Read(stream, p_buffer, len);
+    /* return what has been received, so chunked transfers
+     * can be consumed while they are being produced */
+    ssize_t read = vlc_stream_ReadPartial(stream, p_buffer, len);
     bytesRead = source->totalRead;
     return read;
 }
@@ -535,10 +541,19 @@ void StreamUrlConnection::setUsed( bool b )
        reset();
 }
 
-LibVLCHTTPConnectionFactory::LibVLCHTTPConnectionFactory( AuthStorage *auth )
+LibVLCHTTPConnectionFactory::LibVLCHTTPConnectionFactory( AuthStorage *auth,
+                                                          bool multiplex_ )
     : AbstractConnectionFactory()
 {
     authStorage = auth;
+    multiplex = multiplex_;
+}
+
+LibVLCHTTPConnectionFactory::~LibVLCHTTPConnectionFactory()
+{
+    /* connections using them are all gone by now */
+    for(auto &manager : managers)
+        vlc_http_mgr_destroy(manager.second);
 }
 
 AbstractConnection * LibVLCHTTPConnectionFactory::createConnection(vlc_object_t *p_object,
@@ -547,7 +562,29 @@ AbstractConnection * LibVLCHTTPConnectionFactory::createConnection(vlc_object_t
     if((params.getScheme() != "http" && params.getScheme() != "https") ||
        params.getHostname().empty())
         return nullptr;
-    return new LibVLCHTTPConnection(p_object, authStorage);
+
+    /* Only HTTPS can negotiate HTTP/2, and a manager holds a single
+     * connection so it can not be shared between origins */
+    struct vlc_http_mgr *shared = nullptr;
+    if(multiplex && params.getScheme() == "https")
+    {
+        const std::string origin = params.getHostname() + ":" +
+                                   std::to_string(params.getPort());
+        auto it = managers.find(origin);
+        if(it != managers.end())
+        {
+            shared = it->second;
+        }
+        else
+        {
+            shared = vlc_http_mgr_create(p_object, authStorage->getJar());
+            if(shared == nullptr)
+                return nullptr;
+            vlc_http_mgr_set_shared(shared);
+            managers[origin] = shared;
+        }
+    }
+    return new LibVLCHTTPConnection(p_object, authStorage, shared);
 }
 
 StreamUrlConnectionFactory::StreamUrlConnectionFactory()
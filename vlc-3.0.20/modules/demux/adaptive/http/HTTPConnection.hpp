@@ -29,6 +29,9 @@
 #include "BytesRange.hpp"
 #include <vlc_common.h>
 #include <string>
+#include <map>
+
+struct vlc_http_mgr;
 
 namespace adaptive
 {
@@ -75,7 +78,8 @@ namespace adaptive
        class LibVLCHTTPConnection : public AbstractConnection
        {
             public:
-               LibVLCHTTPConnection(vlc_object_t *, AuthStorage *);
+               LibVLCHTTPConnection(vlc_object_t *, AuthStorage *,
+                                    struct vlc_http_mgr * = nullptr);
                virtual ~LibVLCHTTPConnection();
                virtual bool    canReuse     (const ConnectionParams &) const override;
                virtual RequestStatus request(const std::string& path,
@@ -122,11 +126,14 @@ namespace adaptive
        class LibVLCHTTPConnectionFactory : public AbstractConnectionFactory
        {
            public:
-               LibVLCHTTPConnectionFactory( AuthStorage * );
-               virtual ~LibVLCHTTPConnectionFactory() = default;
+               LibVLCHTTPConnectionFactory( AuthStorage *, bool = false );
+               virtual ~LibVLCHTTPConnectionFactory();
                virtual AbstractConnection * createConnection(vlc_object_t *, const ConnectionParams &) override;
            private:
                AuthStorage *authStorage;
+               /* one multiplexed manager per HTTPS origin, when enabled */
+               bool multiplex;
+               std::map<std::string, struct vlc_http_mgr *> managers;
        };
 
        class StreamUrlConnectionFactory : public AbstractConnectionFactory
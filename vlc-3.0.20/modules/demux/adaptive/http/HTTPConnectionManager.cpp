@@ -29,10 +29,13 @@
 #include "HTTPConnection.hpp"
 #include "ConnectionParams.hpp"
 #include "Downloader.hpp"
+#include "SourceCache.hpp"
 #include "tools/Debug.hpp"
 #include <vlc_url.h>
 #include <vlc_http.h>
 
+#include <algorithm>
+
 using namespace adaptive::http;
 
 AbstractConnectionManager::AbstractConnectionManager(vlc_object_t *p_object_)
@@ -40,16 +43,29 @@ AbstractConnectionManager::AbstractConnectionManager(vlc_object_t *p_object_)
 {
     p_object = p_object_;
     rateObserver = nullptr;
+    metricsObserver = nullptr;
+    bpsEstimate = 0;
+    rttEstimate = 0;
+    vlc_mutex_init(&estimatelock);
 }
 
 AbstractConnectionManager::~AbstractConnectionManager()
 {
-
+    vlc_mutex_destroy(&estimatelock);
 }
 
 void AbstractConnectionManager::updateDownloadRate(const adaptive::ID &sourceid, size_t size,
                                                    vlc_tick_t time, vlc_tick_t latency)
 {
+    if(time > 0)
+    {
+        vlc_mutex_lock(&estimatelock);
+        bpsEstimate = bpsAverage.push(CLOCK_FREQ * size * 8 / time);
+        if(latency > 0 && latency < time)
+            rttEstimate = rttAverage.push(latency);
+        vlc_mutex_unlock(&estimatelock);
+    }
+
     if(rateObserver)
     {
         BwDebug(msg_Dbg(p_object,
@@ -58,6 +74,9 @@ void AbstractConnectionManager::updateDownloadRate(const adaptive::ID &sourceid,
                 latency / 1000, sourceid.str().c_str()));
         rateObserver->updateDownloadRate(sourceid, size, time, latency);
     }
+
+    if(metricsObserver)
+        metricsObserver->updateDownloadRate(sourceid, size, time, latency);
 }
 
 void AbstractConnectionManager::setDownloadRateObserver(IDownloadRateObserver *obs)
@@ -65,6 +84,20 @@ void AbstractConnectionManager::setDownloadRateObserver(IDownloadRateObserver *o
     rateObserver = obs;
 }
 
+void AbstractConnectionManager::setMetricsObserver(IDownloadRateObserver *obs)
+{
+    metricsObserver = obs;
+}
+
+bool AbstractConnectionManager::getBandwidthEstimate(size_t *bps, vlc_tick_t *rtt) const
+{
+    vlc_mutex_lock(&estimatelock);
+    *bps = bpsEstimate;
+    *rtt = rttEstimate;
+    vlc_mutex_unlock(&estimatelock);
+    return *bps > 0;
+}
+
 void AbstractConnectionManager::deleteSource(AbstractChunkSource *source)
 {
     delete source;
@@ -77,14 +110,21 @@ HTTPConnectionManager::HTTPConnectionManager    (vlc_object_t *p_object_)
     vlc_mutex_init(&lock);
     downloader = new Downloader();
     downloaderhp = new Downloader();
-    downloader->start();
+    /* segments can go over parallel connections, others are serialized */
+    unsigned connections = var_InheritInteger(p_object, "adaptive-connections");
+    downloader->start(connections ? connections : 1);
     downloaderhp->start();
-    cache_total = 0;
-    cache_max = 1 << 19;
+    cache = new SourceCache(1 << 19);
+    /* played segments, so seeking back does not download again */
+    unsigned segmentcachesize = var_InheritInteger(p_object, "adaptive-segment-cache");
+    segmentcache = segmentcachesize ? new SourceCache((size_t)segmentcachesize << 20) : nullptr;
 }
 
 HTTPConnectionManager::~HTTPConnectionManager   ()
 {
+    /* cached sources must be released before their downloaders */
+    delete cache;
+    delete segmentcache;
     delete downloader;
     delete downloaderhp;
     this->closeAllConnections();
@@ -165,68 +205,53 @@ AbstractChunkSource *HTTPConnectionManager::makeSource(const std::string &url,
                                                        const ID &id, ChunkType type,
                                                        const BytesRange &range)
 {
-    StorageID storageid = HTTPChunkSource::makeStorageID(url, range);
-    switch(type)
+    SourceCache *sourcecache = getCache(type);
+    if(sourcecache)
     {
-        case ChunkType::Init:
-        case ChunkType::Index:
-            for(HTTPChunkBufferedSource *s : cache)
-            {
-                if(s->getStorageID() == storageid)
-                {
-                    cache.remove(s);
-                    cache_total -= s->contentLength;
-                    CacheDebug(msg_Dbg(p_object, "Cache GET '%s' usage %u bytes",
-                                       storageid.c_str(), cache_total));
-                    return s;
-                }
-            }
-            // fallthrough
-        case ChunkType::Segment:
-        case ChunkType::Key:
-        case ChunkType::Playlist:
-        default:
-            return new HTTPChunkBufferedSource(url, this, id, type, range);
+        StorageID storageid = HTTPChunkSource::makeStorageID(url, range);
+        HTTPChunkBufferedSource *s = sourcecache->get(storageid);
+        if(s)
+        {
+            CacheDebug(msg_Dbg(p_object, "Cache GET '%s' usage %zu bytes",
+                               storageid.c_str(), sourcecache->getUsage()));
+            return s;
+        }
     }
+    return new HTTPChunkBufferedSource(url, this, id, type, range);
 }
 
 void HTTPConnectionManager::recycleSource(AbstractChunkSource *source)
 {
-    bool b_cacheable;
-    switch(source->getChunkType())
+    HTTPChunkBufferedSource *buf = dynamic_cast<HTTPChunkBufferedSource *>(source);
+    SourceCache *sourcecache = getCache(source->getChunkType());
+    if(buf && sourcecache && !buf->getStorageID().empty() && buf->isComplete())
+    {
+        /* all data is there, the connection can serve other requests */
+        buf->releaseConnection();
+        if(sourcecache->put(buf))
+        {
+            CacheDebug(msg_Dbg(p_object, "Cache PUT '%s' usage %zu bytes",
+                               buf->getStorageID().c_str(), sourcecache->getUsage()));
+            return;
+        }
+    }
+    deleteSource(source);
+}
+
+SourceCache * HTTPConnectionManager::getCache(ChunkType type) const
+{
+    switch(type)
     {
-        case ChunkType::Index:
         case ChunkType::Init:
-            b_cacheable = true;
-            break;
+        case ChunkType::Index:
+            return cache;
+        case ChunkType::Segment:
+            return segmentcache;
         case ChunkType::Key:
         case ChunkType::Playlist:
-        case ChunkType::Segment:
         default:
-            b_cacheable = false;
-            break;
-    }
-
-    HTTPChunkBufferedSource *buf = dynamic_cast<HTTPChunkBufferedSource *>(source);
-    if(buf && b_cacheable && !buf->getStorageID().empty() &&
-       buf->contentLength < cache_max)
-    {
-        while(cache_max < cache_total + buf->contentLength)
-        {
-            HTTPChunkBufferedSource *purged = cache.back();
-            cache.pop_back();
-            cache_total -= purged->contentLength;
-            CacheDebug(msg_Dbg(p_object, "Cache DEL '%s' usage %u bytes",
-                               purged->getStorageID().c_str(), cache_total));
-            deleteSource(purged);
-        }
-        cache.push_front(buf);
-        cache_total += buf->contentLength;
-        CacheDebug(msg_Dbg(p_object, "Cache PUT '%s' usage %u bytes",
-                           buf->getStorageID().c_str(), cache_total));
+            return nullptr;
     }
-    else
-        deleteSource(source);
 }
 
 Downloader * HTTPConnectionManager::getDownloadQueue(const AbstractChunkSource *source) const
@@ -258,6 +283,12 @@ void HTTPConnectionManager::cancel(AbstractChunkSource *source)
         getDownloadQueue(src)->cancel(src);
 }
 
+void HTTPConnectionManager::setParallelDownloads(unsigned count)
+{
+    /* Never shrinks, and bounded like adaptive-connections */
+    downloader->start(std::min(count, 8U));
+}
+
 void HTTPConnectionManager::setLocalConnectionsAllowed()
 {
     localAllowed = true;
@@ -26,6 +26,7 @@
 #define HTTPCONNECTIONMANAGER_H_
 
 #include "../logic/IDownloadRateObserver.h"
+#include "../tools/MovingAverage.hpp"
 #include "BytesRange.hpp"
 
 #include <vlc_common.h>
@@ -44,6 +45,7 @@ namespace adaptive
         class Downloader;
         class AbstractChunkSource;
         class HTTPChunkBufferedSource;
+        class SourceCache;
         enum class ChunkType;
 
         class AbstractConnectionManager : public IDownloadRateObserver
@@ -60,10 +62,13 @@ namespace adaptive
 
                 virtual void start(AbstractChunkSource *) = 0;
                 virtual void cancel(AbstractChunkSource *) = 0;
+                virtual void setParallelDownloads(unsigned) {}
 
                 virtual void updateDownloadRate(const ID &, size_t,
                                                 mtime_t, mtime_t) override;
                 void setDownloadRateObserver(IDownloadRateObserver *);
+                void setMetricsObserver(IDownloadRateObserver *);
+                bool getBandwidthEstimate(size_t *, vlc_tick_t *) const;
 
             protected:
                 void deleteSource(AbstractChunkSource *);
@@ -71,6 +76,13 @@ namespace adaptive
 
             private:
                 IDownloadRateObserver                              *rateObserver;
+                IDownloadRateObserver                              *metricsObserver;
+                /* whole session estimates, all streams */
+                mutable vlc_mutex_t                                 estimatelock;
+                MovingAverage<size_t>                               bpsAverage;
+                MovingAverage<vlc_tick_t>                           rttAverage;
+                size_t                                              bpsEstimate;
+                vlc_tick_t                                          rttEstimate;
         };
 
         class HTTPConnectionManager : public AbstractConnectionManager
@@ -88,6 +100,7 @@ namespace adaptive
 
                 virtual void start(AbstractChunkSource *)  override;
                 virtual void cancel(AbstractChunkSource *)  override;
+                virtual void setParallelDownloads(unsigned)  override;
                 void         setLocalConnectionsAllowed();
                 void         addFactory(AbstractConnectionFactory *);
 
@@ -101,9 +114,9 @@ namespace adaptive
                 bool                                                localAllowed;
                 AbstractConnection * reuseConnection(ConnectionParams &);
                 Downloader * getDownloadQueue(const AbstractChunkSource *) const;
-                std::list<HTTPChunkBufferedSource *> cache;
-                unsigned cache_total;
-                unsigned cache_max;
+                SourceCache * getCache(ChunkType) const;
+                SourceCache                                        *cache; /* init, index */
+                SourceCache                                        *segmentcache;
         };
     }
 }
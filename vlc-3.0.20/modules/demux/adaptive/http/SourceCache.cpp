@@ -0,0 +1,89 @@
+/*
+ * SourceCache.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLabs and VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "SourceCache.hpp"
+
+using namespace adaptive::http;
+
+SourceCache::SourceCache(size_t size)
+{
+    vlc_mutex_init(&lock);
+    total = 0;
+    max = size;
+}
+
+SourceCache::~SourceCache()
+{
+    while(!sources.empty())
+    {
+        delete sources.front();
+        sources.pop_front();
+    }
+    vlc_mutex_destroy(&lock);
+}
+
+HTTPChunkBufferedSource * SourceCache::get(const StorageID &storageid)
+{
+    vlc_mutex_locker locker(&lock);
+    for(auto it = sources.begin(); it != sources.end(); ++it)
+    {
+        HTTPChunkBufferedSource *s = *it;
+        if(s->getStorageID() == storageid)
+        {
+            sources.erase(it);
+            total -= s->contentLength;
+            return s;
+        }
+    }
+    return nullptr;
+}
+
+bool SourceCache::put(HTTPChunkBufferedSource *source)
+{
+    if(source->contentLength == 0 || source->contentLength > max)
+        return false;
+
+    std::list<HTTPChunkBufferedSource *> purged;
+    vlc_mutex_lock(&lock);
+    while(max < total + source->contentLength)
+    {
+        purged.push_back(sources.back());
+        total -= sources.back()->contentLength;
+        sources.pop_back();
+    }
+    sources.push_front(source);
+    total += source->contentLength;
+    vlc_mutex_unlock(&lock);
+
+    /* deletion cancels, so not under our lock */
+    for(HTTPChunkBufferedSource *s : purged)
+        delete s;
+
+    return true;
+}
+
+size_t SourceCache::getUsage() const
+{
+    vlc_mutex_locker locker(&lock);
+    return total;
+}
@@ -0,0 +1,52 @@
+/*
+ * SourceCache.hpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLabs and VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef SOURCECACHE_HPP_
+#define SOURCECACHE_HPP_
+
+#include "Chunk.h"
+
+#include <vlc_common.h>
+#include <list>
+
+namespace adaptive
+{
+    namespace http
+    {
+        /* Completely downloaded sources, by url and byte range, most
+         * recently used first. Evicts from the tail past its size */
+        class SourceCache
+        {
+            public:
+                SourceCache(size_t);
+                ~SourceCache();
+                HTTPChunkBufferedSource * get(const StorageID &);
+                bool put(HTTPChunkBufferedSource *);
+                size_t getUsage() const;
+
+            private:
+                mutable vlc_mutex_t lock;
+                std::list<HTTPChunkBufferedSource *> sources;
+                size_t total;
+                size_t max;
+        };
+    }
+}
+
+#endif
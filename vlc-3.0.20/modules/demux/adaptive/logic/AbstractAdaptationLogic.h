@@ -52,6 +52,8 @@ namespace adaptive
                                                                     mtime_t, mtime_t) override;
                 virtual void                trackerEvent           (const TrackerEvent &) override {}
                 void                        setMaxDeviceResolution (int, int);
+                /* Seeds the estimate before any download, from a previous session */
+                virtual void                setInitialBandwidth    (size_t, vlc_tick_t) {}
 
                 enum class LogicType
                 {
@@ -62,6 +64,7 @@ namespace adaptive
                     FixedRate,
                     Predictive,
                     NearOptimal,
+                    Hybrid,
                 };
 
             protected:
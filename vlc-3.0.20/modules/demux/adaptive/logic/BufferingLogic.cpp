@@ -47,6 +47,7 @@ AbstractBufferingLogic::AbstractBufferingLogic()
     userMinBuffering = 0;
     userMaxBuffering = 0;
     userLiveDelay = 0;
+    userPrefetchSegments = 0;
 }
 
 void AbstractBufferingLogic::setLowDelay(bool b)
@@ -69,6 +70,11 @@ void AbstractBufferingLogic::setUserLiveDelay(vlc_tick_t v)
     userLiveDelay = v;
 }
 
+void AbstractBufferingLogic::setUserPrefetchSegments(unsigned v)
+{
+    userPrefetchSegments = v;
+}
+
 /* Try to never buffer up to really end */
 /* Enforce no overlap for demuxers segments 3.0.0 */
 /* FIXME: check duration instead ? */
@@ -129,7 +135,7 @@ vlc_tick_t DefaultBufferingLogic::getMaxBuffering(const BasePlaylist *p) const
 vlc_tick_t DefaultBufferingLogic::getLiveDelay(const BasePlaylist *p) const
 {
     if(isLowLatency(p))
-        return getMinBuffering(p);
+        return std::max(p->targetLatency.Get(), getMinBuffering(p));
     vlc_tick_t delay = userLiveDelay ? userLiveDelay
                                   : DEFAULT_LIVE_BUFFERING;
     if(p->suggestedPresentationDelay.Get())
@@ -152,6 +158,22 @@ vlc_tick_t DefaultBufferingLogic::getStableBuffering(const BasePlaylist *p) cons
     return std::min(getMinBuffering(p) * 2, max);
 }
 
+unsigned DefaultBufferingLogic::getPrefetchSegments(const BasePlaylist *p) const
+{
+    /* low latency is about staying on the edge, not getting ahead */
+    if(isLowLatency(p))
+        return 0;
+    return userPrefetchSegments;
+}
+
+uint64_t DefaultBufferingLogic::getPrefetchBudget(const BaseRepresentation *rep) const
+{
+    /* what the max buffering represents at the advertised bitrate,
+       0 when unknown */
+    vlc_tick_t max = getMaxBuffering(rep->getPlaylist());
+    return rep->getBandwidth() / 8 * max / CLOCK_FREQ;
+}
+
 uint64_t DefaultBufferingLogic::getLiveStartSegmentNumber(BaseRepresentation *rep) const
 {
     BasePlaylist *playlist = rep->getPlaylist();
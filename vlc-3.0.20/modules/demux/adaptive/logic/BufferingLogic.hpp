@@ -47,9 +47,13 @@ namespace adaptive
                 virtual vlc_tick_t getMaxBuffering(const BasePlaylist *) const = 0;
                 virtual vlc_tick_t getLiveDelay(const BasePlaylist *) const = 0;
                 virtual vlc_tick_t getStableBuffering(const BasePlaylist *) const = 0;
+                virtual unsigned getPrefetchSegments(const BasePlaylist *) const = 0;
+                virtual uint64_t getPrefetchBudget(const BaseRepresentation *) const = 0;
+                virtual bool isLowLatency(const BasePlaylist *) const = 0;
                 void setUserMinBuffering(vlc_tick_t);
                 void setUserMaxBuffering(vlc_tick_t);
                 void setUserLiveDelay(vlc_tick_t);
+                void setUserPrefetchSegments(unsigned);
                 void setLowDelay(bool);
                 static const vlc_tick_t BUFFERING_LOWEST_LIMIT;
                 static const vlc_tick_t DEFAULT_MIN_BUFFERING;
@@ -60,6 +64,7 @@ namespace adaptive
                 vlc_tick_t userMinBuffering;
                 vlc_tick_t userMaxBuffering;
                 vlc_tick_t userLiveDelay;
+                unsigned userPrefetchSegments;
                 Undef<bool> userLowLatency;
         };
 
@@ -73,13 +78,15 @@ namespace adaptive
                 virtual vlc_tick_t getMaxBuffering(const BasePlaylist *) const override;
                 virtual vlc_tick_t getLiveDelay(const BasePlaylist *) const override;
                 virtual vlc_tick_t getStableBuffering(const BasePlaylist *) const override;
+                virtual unsigned getPrefetchSegments(const BasePlaylist *) const override;
+                virtual uint64_t getPrefetchBudget(const BaseRepresentation *) const override;
+                virtual bool isLowLatency(const BasePlaylist *) const override;
                 static const unsigned SAFETY_BUFFERING_EDGE_OFFSET;
                 static const unsigned SAFETY_EXPURGING_OFFSET;
 
             protected:
                 vlc_tick_t getBufferingOffset(const BasePlaylist *) const;
                 uint64_t getLiveStartSegmentNumber(BaseRepresentation *) const;
-                bool isLowLatency(const BasePlaylist *) const;
         };
     }
 }
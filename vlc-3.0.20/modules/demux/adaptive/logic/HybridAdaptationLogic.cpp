@@ -0,0 +1,380 @@
+/*
+ * HybridAdaptationLogic.cpp
+ *****************************************************************************
+ * Copyright (C) 2023 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "HybridAdaptationLogic.hpp"
+#include "Representationselectors.hpp"
+
+#include "../playlist/BaseAdaptationSet.h"
+#include "../playlist/BaseRepresentation.h"
+#include "../playlist/BasePeriod.h"
+#include "../tools/Debug.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+using namespace adaptive::logic;
+using namespace adaptive;
+
+/*
+ * Throughput rule while the buffer is low, BOLA once it has built up
+ * (as in dash.js DYNAMIC). Throughput is measured on the transfer time
+ * only, and predictions account for the request latency against the
+ * segment duration. Upswitches need some margin and a few segments of
+ * stability, downswitches happen as soon as the quality is not sustainable.
+ */
+
+#define minimumBufferS        (CLOCK_FREQ * 6)
+#define bufferTargetS         (CLOCK_FREQ * 30)
+#define maxSamples            20
+#define fastSamples           3
+#define downswitchFactor      0.90f
+#define upswitchFactor        0.70f
+#define minSegmentsBeforeUp   2
+
+HybridContext::HybridContext()
+    : buffering_level( 0 )
+    , buffering_target( bufferTargetS )
+    , segment_duration( 0 )
+    , last_download_rate( 0 )
+    , segments_since_switch( 0 )
+    , bola( false )
+{ }
+
+void HybridContext::push(size_t size, vlc_tick_t time, vlc_tick_t latency)
+{
+    Sample sample;
+    sample.size = size;
+    sample.latency = (latency > 0 && latency < time) ? latency : 0;
+    sample.transfer = time - sample.latency;
+    if(samples.size() >= maxSamples)
+        samples.pop_front();
+    samples.push_back(sample);
+}
+
+unsigned HybridContext::getThroughput(unsigned count) const
+{
+    /* size weighted over the whole history, and over the last samples only,
+     * so that drops are seen immediately but peaks need to last */
+    uint64_t size = 0, fastsize = 0;
+    vlc_tick_t transfer = 0, fasttransfer = 0;
+    unsigned i = 0;
+    for(std::list<Sample>::const_reverse_iterator it = samples.rbegin();
+                                                  it != samples.rend(); ++it, ++i)
+    {
+        size += (*it).size;
+        transfer += (*it).transfer;
+        if(i < count)
+        {
+            fastsize += (*it).size;
+            fasttransfer += (*it).transfer;
+        }
+    }
+    if(transfer <= 0 || fasttransfer <= 0)
+        return 0;
+    return std::min(CLOCK_FREQ * size * 8 / transfer,
+                    CLOCK_FREQ * fastsize * 8 / fasttransfer);
+}
+
+vlc_tick_t HybridContext::getLatency() const
+{
+    if(samples.empty())
+        return 0;
+    vlc_tick_t latency = 0;
+    unsigned i = 0;
+    for(std::list<Sample>::const_reverse_iterator it = samples.rbegin();
+                                                  it != samples.rend() && i < fastSamples; ++it, ++i)
+        latency += (*it).latency;
+    return latency / i;
+}
+
+HybridAdaptationLogic::HybridAdaptationLogic( vlc_object_t *obj )
+    : AbstractAdaptationLogic(obj)
+    , currentBps( 0 )
+    , usedBps( 0 )
+    , initialLatency( 0 )
+{
+    vlc_mutex_init(&lock);
+}
+
+HybridAdaptationLogic::~HybridAdaptationLogic()
+{
+    vlc_mutex_destroy(&lock);
+}
+
+BaseRepresentation *
+HybridAdaptationLogic::getBolaRepresentation( BaseAdaptationSet *adaptSet, RepresentationSelector &selector,
+                                              const HybridContext &ctx ) const
+{
+    BaseRepresentation *lowest = selector.lowest(adaptSet);
+    BaseRepresentation *highest = selector.highest(adaptSet);
+
+    const float low = (float) std::min(minimumBufferS, ctx.buffering_target / 3) / CLOCK_FREQ;
+    const float target = std::max((float) ctx.buffering_target / CLOCK_FREQ, low * 2);
+    const float level = (float) ctx.buffering_level / CLOCK_FREQ;
+    const float duration = ctx.segment_duration ? (float) ctx.segment_duration / CLOCK_FREQ : 1.0;
+
+    /* utilities are ln(S/Smin) + 1 */
+    const float umax = std::log((float) highest->getBandwidth() / lowest->getBandwidth()) + 1.0;
+    const float gp = (umax - 1.0) / (target / low - 1.0);
+    if(gp <= 0)
+        return highest;
+    const float vp = low / gp;
+
+    BaseRepresentation *ret = nullptr;
+    BaseRepresentation *prev = nullptr;
+    float argmax = 0;
+    for(BaseRepresentation *rep = lowest; rep && rep != prev; rep = selector.higher(adaptSet, rep))
+    {
+        const float utility = std::log((float) rep->getBandwidth() / lowest->getBandwidth()) + 1.0;
+        const float size = (float) rep->getBandwidth() * duration;
+        const float arg = (vp * (utility + gp) - level) / size;
+        if(ret == nullptr || argmax <= arg)
+        {
+            ret = rep;
+            argmax = arg;
+        }
+        prev = rep;
+    }
+    return ret;
+}
+
+BaseRepresentation *HybridAdaptationLogic::getNextRepresentation(BaseAdaptationSet *adaptSet, BaseRepresentation *prevRep)
+{
+    RepresentationSelector selector(maxwidth, maxheight);
+
+    BaseRepresentation *lowest = selector.lowest(adaptSet);
+    BaseRepresentation *highest = selector.highest(adaptSet);
+    if(lowest == nullptr || highest == nullptr)
+        return nullptr;
+
+    if(lowest == highest)
+        return lowest;
+
+    vlc_mutex_lock(&lock);
+
+    std::map<ID, HybridContext>::iterator it = streams.find(adaptSet->getID());
+    if(it == streams.end())
+    {
+        vlc_mutex_unlock(&lock);
+        return lowest;
+    }
+    HybridContext &ctx = (*it).second;
+
+    const unsigned bps = getAvailableBw(currentBps, prevRep);
+    const unsigned safebps = getSustainableBw(bps, ctx, downswitchFactor);
+
+    BaseRepresentation *rep;
+    if(prevRep == nullptr || ctx.samples.empty()) /* Starting */
+    {
+        rep = selector.select(adaptSet, safebps);
+        if(rep == lowest)
+        {
+            /* Handle HLS specific cases where the lowest is audio only. Try to pick first A+V */
+            BaseRepresentation *n = selector.higher(adaptSet, rep);
+            if(rep != n && rep->getCodecs().size() == 1 && n->getCodecs().size() > 1)
+                rep = n;
+        }
+    }
+    else
+    {
+        const vlc_tick_t low = std::min(minimumBufferS, ctx.buffering_target / 3);
+        if(ctx.bola && ctx.buffering_level < low)
+            ctx.bola = false;
+        else if(!ctx.bola && ctx.buffering_level >= low * 2)
+            ctx.bola = true;
+
+        if(ctx.bola)
+            rep = getBolaRepresentation(adaptSet, selector, ctx);
+        else
+            rep = selector.select(adaptSet, safebps);
+
+        if(rep->getBandwidth() > prevRep->getBandwidth())
+        {
+            if(ctx.segments_since_switch < minSegmentsBeforeUp)
+            {
+                rep = prevRep;
+            }
+            else
+            {
+                /* BOLA-O like capping, only up to what the throughput sustains */
+                BaseRepresentation *up = selector.select(adaptSet,
+                                        getSustainableBw(bps, ctx, upswitchFactor));
+                if(up->getBandwidth() < rep->getBandwidth())
+                    rep = (up->getBandwidth() > prevRep->getBandwidth()) ? up : prevRep;
+            }
+        }
+        else if(rep->getBandwidth() < prevRep->getBandwidth() &&
+                ctx.bola && prevRep->getBandwidth() <= safebps)
+        {
+            /* buffer is decreasing, but the throughput still sustains it */
+            rep = prevRep;
+        }
+    }
+
+    if(rep != prevRep)
+        ctx.segments_since_switch = 0;
+    else
+        ctx.segments_since_switch++;
+
+    BwDebug( msg_Info(p_obj, "Stream %s %s buffering level %.2f% rep %ld kBps %u kBps",
+             adaptSet->getID().str().c_str(), ctx.bola ? "bola" : "throughput",
+             (float) 100 * ctx.buffering_level / ctx.buffering_target,
+             rep->getBandwidth()/8000, bps / 8000); );
+
+    vlc_mutex_unlock(&lock);
+
+    return rep;
+}
+
+unsigned HybridAdaptationLogic::getSustainableBw(unsigned i_bw, const HybridContext &ctx,
+                                                 float factor) const
+{
+    /* A segment of duration D at bitrate B takes latency + B * D / bw
+     * to fetch, which has to fit in factor * D */
+    float ratio = factor;
+    if(ctx.segment_duration)
+        ratio -= (float) (ctx.samples.empty() ? initialLatency : ctx.getLatency())
+                 / ctx.segment_duration;
+    if(ratio <= 0)
+        return 0;
+    return i_bw * ratio;
+}
+
+unsigned HybridAdaptationLogic::getAvailableBw(unsigned i_bw, const BaseRepresentation *curRep) const
+{
+    unsigned i_remain = i_bw;
+    if(i_remain > usedBps)
+        i_remain -= usedBps;
+    else
+        i_remain = 0;
+    if(curRep)
+        i_remain += curRep->getBandwidth();
+    return i_remain > i_bw ? i_remain : i_bw;
+}
+
+unsigned HybridAdaptationLogic::getMaxCurrentBw() const
+{
+    unsigned i_max_bitrate = 0;
+    for(std::map<ID, HybridContext>::const_iterator it = streams.begin();
+                                                    it != streams.end(); ++it)
+        i_max_bitrate = std::max(i_max_bitrate, ((*it).second).last_download_rate);
+    return i_max_bitrate;
+}
+
+void HybridAdaptationLogic::updateDownloadRate(const ID &id, size_t dlsize,
+                                               vlc_tick_t time, mtime_t latency)
+{
+    vlc_mutex_lock(&lock);
+    std::map<ID, HybridContext>::iterator it = streams.find(id);
+    if(it != streams.end())
+    {
+        HybridContext &ctx = (*it).second;
+        ctx.push(dlsize, time, latency);
+        ctx.last_download_rate = ctx.getThroughput(fastSamples);
+    }
+    currentBps = getMaxCurrentBw();
+    vlc_mutex_unlock(&lock);
+}
+
+void HybridAdaptationLogic::setInitialBandwidth(size_t bps, vlc_tick_t rtt)
+{
+    vlc_mutex_lock(&lock);
+    currentBps = bps;
+    initialLatency = rtt;
+    vlc_mutex_unlock(&lock);
+}
+
+void HybridAdaptationLogic::trackerEvent(const TrackerEvent &ev)
+{
+    switch(ev.getType())
+    {
+    case TrackerEvent::Type::RepresentationSwitch:
+        {
+            const RepresentationSwitchEvent &event =
+                    static_cast<const RepresentationSwitchEvent &>(ev);
+            vlc_mutex_lock(&lock);
+            if(event.prev)
+                usedBps -= event.prev->getBandwidth();
+            if(event.next)
+                usedBps += event.next->getBandwidth();
+            BwDebug(msg_Info(p_obj, "New total bandwidth usage %u kBps", (usedBps / 8000)));
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    case TrackerEvent::Type::BufferingStateUpdate:
+        {
+            const BufferingStateUpdatedEvent &event =
+                    static_cast<const BufferingStateUpdatedEvent &>(ev);
+            const ID &id = *event.id;
+            vlc_mutex_lock(&lock);
+            if(event.enabled)
+            {
+                if(streams.find(id) == streams.end())
+                {
+                    HybridContext ctx;
+                    streams.insert(std::pair<ID, HybridContext>(id, ctx));
+                }
+            }
+            else
+            {
+                std::map<ID, HybridContext>::iterator it = streams.find(id);
+                if(it != streams.end())
+                    streams.erase(it);
+            }
+            vlc_mutex_unlock(&lock);
+            BwDebug(msg_Info(p_obj, "Stream %s is now known %sactive", id.str().c_str(),
+                         (event.enabled) ? "" : "in"));
+        }
+        break;
+
+    case TrackerEvent::Type::BufferingLevelChange:
+        {
+            const BufferingLevelChangedEvent &event =
+                    static_cast<const BufferingLevelChangedEvent &>(ev);
+            const ID &id = *event.id;
+            vlc_mutex_lock(&lock);
+            HybridContext &ctx = streams[id];
+            ctx.buffering_level = event.current;
+            ctx.buffering_target = event.target;
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    case TrackerEvent::Type::SegmentChange:
+        {
+            const SegmentChangedEvent &event =
+                    static_cast<const SegmentChangedEvent &>(ev);
+            const ID &id = *event.id;
+            vlc_mutex_lock(&lock);
+            HybridContext &ctx = streams[id];
+            if(event.duration > 0)
+                ctx.segment_duration = event.duration;
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    default:
+            break;
+    }
+}
@@ -0,0 +1,89 @@
+/*
+ * HybridAdaptationLogic.hpp
+ *****************************************************************************
+ * Copyright (C) 2023 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef HYBRIDADAPTATIONLOGIC_HPP
+#define HYBRIDADAPTATIONLOGIC_HPP
+
+#include "AbstractAdaptationLogic.h"
+#include "Representationselectors.hpp"
+#include <list>
+#include <map>
+
+namespace adaptive
+{
+    namespace logic
+    {
+        class HybridContext
+        {
+            friend class HybridAdaptationLogic;
+
+            public:
+                HybridContext();
+
+            private:
+                class Sample
+                {
+                    public:
+                        size_t size;
+                        vlc_tick_t transfer;
+                        vlc_tick_t latency;
+                };
+
+                void push(size_t, vlc_tick_t, vlc_tick_t);
+                unsigned getThroughput(unsigned) const;
+                vlc_tick_t getLatency() const;
+
+                std::list<Sample> samples;
+                vlc_tick_t buffering_level;
+                vlc_tick_t buffering_target;
+                vlc_tick_t segment_duration;
+                unsigned last_download_rate;
+                unsigned segments_since_switch;
+                bool bola;
+        };
+
+        class HybridAdaptationLogic : public AbstractAdaptationLogic
+        {
+            public:
+                HybridAdaptationLogic(vlc_object_t *);
+                virtual ~HybridAdaptationLogic();
+
+                virtual BaseRepresentation* getNextRepresentation(BaseAdaptationSet *,
+                                                                  BaseRepresentation *) override;
+                virtual void                updateDownloadRate     (const ID &, size_t,
+                                                                    mtime_t, mtime_t) override;
+                virtual void                trackerEvent           (const TrackerEvent &) override;
+                virtual void                setInitialBandwidth    (size_t, vlc_tick_t) override;
+
+            private:
+                BaseRepresentation *        getBolaRepresentation(BaseAdaptationSet *, RepresentationSelector &,
+                                                                  const HybridContext &) const;
+                unsigned                    getSustainableBw(unsigned, const HybridContext &, float) const;
+                unsigned                    getAvailableBw(unsigned, const BaseRepresentation *) const;
+                unsigned                    getMaxCurrentBw() const;
+                std::map<adaptive::ID, HybridContext> streams;
+                unsigned                    currentBps;
+                unsigned                    usedBps;
+                vlc_tick_t                  initialLatency;
+                vlc_mutex_t                 lock;
+        };
+    }
+}
+
+#endif // HYBRIDADAPTATIONLOGIC_HPP
@@ -207,6 +207,13 @@ void NearOptimalAdaptationLogic::updateDownloadRate(const ID &id, size_t dlsize,
     vlc_mutex_unlock(&lock);
 }
 
+void NearOptimalAdaptationLogic::setInitialBandwidth(size_t bps, vlc_tick_t)
+{
+    vlc_mutex_lock(&lock);
+    currentBps = bps;
+    vlc_mutex_unlock(&lock);
+}
+
 void NearOptimalAdaptationLogic::trackerEvent(const TrackerEvent &ev)
 {
     switch(ev.getType())
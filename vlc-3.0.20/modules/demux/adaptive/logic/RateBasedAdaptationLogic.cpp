@@ -107,6 +107,14 @@ void RateBasedAdaptationLogic::updateDownloadRate(const ID &, size_t size,
     vlc_mutex_unlock(&lock);
 }
 
+void RateBasedAdaptationLogic::setInitialBandwidth(size_t bps, vlc_tick_t)
+{
+    vlc_mutex_lock(&lock);
+    bpsAvg = bps;
+    currentBps = bpsAvg * 3/4;
+    vlc_mutex_unlock(&lock);
+}
+
 void RateBasedAdaptationLogic::trackerEvent(const TrackerEvent &ev)
 {
     if(ev.getType() == TrackerEvent::Type::RepresentationSwitch)
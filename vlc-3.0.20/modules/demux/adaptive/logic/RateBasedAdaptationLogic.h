@@ -44,6 +44,7 @@ namespace adaptive
                 virtual void updateDownloadRate(const ID &, size_t,
                                                 mtime_t, mtime_t) override;
                 virtual void trackerEvent(const TrackerEvent &) override;
+                virtual void setInitialBandwidth(size_t, vlc_tick_t) override;
 
             private:
                 size_t                  bpsAvg;
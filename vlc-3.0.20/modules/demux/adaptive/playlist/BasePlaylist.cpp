@@ -48,6 +48,9 @@ BasePlaylist::BasePlaylist (vlc_object_t *p_object_) :
     timeShiftBufferDepth.Set( 0 );
     suggestedPresentationDelay.Set( 0 );
     presentationStartOffset.Set( 0 );
+    targetLatency.Set( 0 );
+    minPlaybackRate.Set( 0 );
+    maxPlaybackRate.Set( 0 );
     b_needsUpdates = true;
 }
 
@@ -162,6 +165,7 @@ bool BasePlaylist::needsUpdates() const
 void BasePlaylist::updateWith(BasePlaylist *updatedPlaylist)
 {
     availabilityEndTime.Set(updatedPlaylist->availabilityEndTime.Get());
+    targetLatency.Set(updatedPlaylist->targetLatency.Get());
 
     for(size_t i = 0; i < periods.size() && i < updatedPlaylist->periods.size(); i++)
         periods.at(i)->updateWith(updatedPlaylist->periods.at(i));
@@ -74,6 +74,9 @@ namespace adaptive
                 Property<mtime_t>                   timeShiftBufferDepth;
                 Property<mtime_t>                   suggestedPresentationDelay;
                 Property<mtime_t>                   presentationStartOffset;
+                Property<mtime_t>                   targetLatency;
+                Property<float>                     minPlaybackRate;
+                Property<float>                     maxPlaybackRate;
 
             protected:
                 vlc_object_t                       *p_object;
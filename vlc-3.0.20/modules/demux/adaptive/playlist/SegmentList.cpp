@@ -168,6 +168,29 @@ void SegmentList::pruneBySegmentNumber(uint64_t tobelownum)
     }
 }
 
+void SegmentList::pruneAfterSegmentNumber(uint64_t tobeabovenum)
+{
+    while(!segments.empty() && segments.back()->getSequenceNumber() > tobeabovenum)
+    {
+        totalLength -= segments.back()->duration.Get();
+        delete segments.back();
+        segments.pop_back();
+    }
+}
+
+void SegmentList::moveSegmentsFrom(SegmentList *other, uint64_t fromnum)
+{
+    std::vector<Segment *>::iterator it = other->segments.begin();
+    while(it != other->segments.end() && (*it)->getSequenceNumber() < fromnum)
+        ++it;
+    for(std::vector<Segment *>::iterator it2 = it; it2 != other->segments.end(); ++it2)
+    {
+        other->totalLength -= (*it2)->duration.Get();
+        addSegment(*it2);
+    }
+    other->segments.erase(it, other->segments.end());
+}
+
 bool SegmentList::getPlaybackTimeDurationBySegmentNumber(uint64_t number,
                                                          vlc_tick_t *time, vlc_tick_t *dur) const
 {
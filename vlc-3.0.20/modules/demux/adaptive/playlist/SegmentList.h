@@ -46,6 +46,8 @@ namespace adaptive
                 virtual void            updateWith(AbstractMultipleSegmentBaseType *,
                                                    bool = false) override;
                 void                    pruneBySegmentNumber(uint64_t);
+                void                    pruneAfterSegmentNumber(uint64_t);
+                void                    moveSegmentsFrom(SegmentList *, uint64_t);
                 void                    pruneByPlaybackTime(vlc_tick_t);
                 stime_t                 getTotalLength() const;
                 bool                    hasRelativeMediaTimes() const;
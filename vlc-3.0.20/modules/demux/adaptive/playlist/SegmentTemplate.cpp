@@ -106,6 +106,8 @@ uint64_t SegmentTemplate::getLiveTemplateNumber(vlc_tick_t playbacktime, bool ab
                     parentSegmentInformation->getPlaylist()->availabilityStartTime.Get();
             streamstart += parentSegmentInformation->getPeriodStart();
             playbacktime -= streamstart;
+            /* low latency: segments are published while still being produced */
+            playbacktime += inheritAvailabilityTimeOffset();
         }
         stime_t elapsed = timescale.ToScaled(playbacktime) - dur;
         if(elapsed > 0)
@@ -35,6 +35,11 @@
 using namespace adaptive;
 using namespace adaptive::playlist;
 
+/* Elements are kept by value, in one contiguous vector sorted by number
+ * and time, so lookups are binary searches. Each one is still a S entry,
+ * already run length encoded by its repeat count: SegmentList maps
+ * element indexes to its segments. */
+
 SegmentTimeline::SegmentTimeline(AbstractMultipleSegmentBaseType *parent_)
     : AttrsNode(Type::Timeline, parent_)
 {
@@ -44,24 +49,27 @@ SegmentTimeline::SegmentTimeline(AbstractMultipleSegmentBaseType *parent_)
 
 SegmentTimeline::~SegmentTimeline()
 {
-    std::list<Element *>::iterator it;
-    for(it = elements.begin(); it != elements.end(); ++it)
-        delete *it;
 }
 
 void SegmentTimeline::addElement(uint64_t number, stime_t d, uint64_t r, stime_t t)
 {
-    Element *element = new (std::nothrow) Element(number, d, r, t);
-    if(element)
-    {
-        if(!elements.empty() && !t)
-        {
-            const Element *el = elements.back();
-            element->t = el->t + (el->d * (el->r + 1));
-        }
-        elements.push_back(element);
-        totalLength += (d * (r + 1));
-    }
+    if(!elements.empty() && !t)
+        t = elements.back().end();
+    elements.push_back(Element(number, d, r, t));
+    totalLength += (d * (r + 1));
+}
+
+std::vector<SegmentTimeline::Element>::const_iterator
+SegmentTimeline::findElementByNumber(uint64_t number) const
+{
+    /* last element starting at or before number */
+    std::vector<Element>::const_iterator it =
+            std::upper_bound(elements.begin(), elements.end(), number,
+                             [](uint64_t n, const Element &el) { return n < el.number; });
+    if(it == elements.begin())
+        return elements.end();
+    --it;
+    return (number <= (*it).number + (*it).r) ? it : elements.end();
 }
 
 vlc_tick_t SegmentTimeline::getMinAheadScaledTime(uint64_t number) const
@@ -73,16 +81,16 @@ vlc_tick_t SegmentTimeline::getMinAheadScaledTime(uint64_t number) const
        maxElementNumber() < number)
         return 0;
 
-    std::list<Element *>::const_reverse_iterator it;
+    std::vector<Element>::const_reverse_iterator it;
     for(it = elements.rbegin(); it != elements.rend(); ++it)
     {
-        const Element *el = *it;
-        if(number > el->number + el->r)
+        const Element &el = *it;
+        if(number > el.number + el.r)
             break;
-        else if(number < el->number)
-            totalscaledtime += (el->d * (el->r + 1));
+        else if(number < el.number)
+            totalscaledtime += (el.d * (el.r + 1));
         else /* within repeat range */
-            totalscaledtime += el->d * (el->number + el->r - number);
+            totalscaledtime += el.d * (el.number + el.r - number);
     }
 
     return totalscaledtime;
@@ -90,53 +98,31 @@ vlc_tick_t SegmentTimeline::getMinAheadScaledTime(uint64_t number) const
 
 uint64_t SegmentTimeline::getElementNumberByScaledPlaybackTime(stime_t scaled) const
 {
-    const Element *prevel = nullptr;
-    std::list<Element *>::const_iterator it;
-
     if(!elements.size())
         return 0;
 
-    for(it = elements.begin(); it != elements.end(); ++it)
-    {
-        const Element *el = *it;
-        if(scaled >= el->t)
-        {
-            if((uint64_t)scaled < el->t + (el->d * el->r))
-                return el->number + (scaled - el->t) / el->d;
-        }
-        /* might have been discontinuity */
-        else
-        {
-            if(prevel) /* > prev but < current */
-                return prevel->number + prevel->r;
-            else /* << first of the list */
-                return el->number;
-        }
-        prevel = el;
-    }
-
-    /* time is >> any of the list */
-    return prevel->number + prevel->r;
+    /* last element starting at or before that time */
+    std::vector<Element>::const_iterator it =
+            std::upper_bound(elements.begin(), elements.end(), scaled,
+                             [](stime_t s, const Element &el) { return s < el.t; });
+    if(it == elements.begin()) /* << first of the list */
+        return (*it).number;
+    const Element &el = *(--it);
+    if(scaled < el.end())
+        return el.number + (scaled - el.t) / el.d;
+    /* might have been discontinuity, or time is >> any of the list */
+    return el.number + el.r;
 }
 
 bool SegmentTimeline::getScaledPlaybackTimeDurationBySegmentNumber(uint64_t number,
                                                                    stime_t *time, stime_t *duration) const
 {
-    std::list<Element *>::const_iterator it;
-    for(it = elements.begin(); it != elements.end(); ++it)
-    {
-        const Element *el = *it;
-        if(number >= el->number)
-        {
-            if(number <= el->number + el->r)
-            {
-                *time = el->t + el->d * (number - el->number);
-                *duration = el->d;
-                return true;
-            }
-        }
-    }
-    return false;
+    std::vector<Element>::const_iterator it = findElementByNumber(number);
+    if(it == elements.end())
+        return false;
+    *time = (*it).t + (*it).d * (number - (*it).number);
+    *duration = (*it).d;
+    return true;
 }
 
 stime_t SegmentTimeline::getScaledPlaybackTimeByElementNumber(uint64_t number) const
@@ -156,30 +142,23 @@ uint64_t SegmentTimeline::maxElementNumber() const
     if(elements.empty())
         return 0;
 
-    const Element *e = elements.back();
-    return e->number + e->r;
+    const Element &e = elements.back();
+    return e.number + e.r;
 }
 
 uint64_t SegmentTimeline::minElementNumber() const
 {
     if(elements.empty())
         return 0;
-    return elements.front()->number;
+    return elements.front().number;
 }
 
 uint64_t SegmentTimeline::getElementIndexBySequence(uint64_t number) const
 {
-    std::list<Element *>::const_iterator it;
-    for(it = elements.begin(); it != elements.end(); ++it)
-    {
-        const Element *el = *it;
-        if(number >= el->number)
-        {
-            if(number <= el->number + el->r)
-                return std::distance(elements.begin(), it);
-        }
-    }
-    return std::numeric_limits<uint64_t>::max();
+    std::vector<Element>::const_iterator it = findElementByNumber(number);
+    if(it == elements.end())
+        return std::numeric_limits<uint64_t>::max();
+    return std::distance(elements.begin(), it);
 }
 
 void SegmentTimeline::pruneByPlaybackTime(vlc_tick_t time)
@@ -192,30 +171,25 @@ void SegmentTimeline::pruneByPlaybackTime(vlc_tick_t time)
 size_t SegmentTimeline::pruneBySequenceNumber(uint64_t number)
 {
     size_t prunednow = 0;
-    while(elements.size())
+
+    std::vector<Element>::iterator it = elements.begin();
+    while(it != elements.end() && (*it).number + (*it).r < number)
     {
-        Element *el = elements.front();
-        if(el->number >= number)
-        {
-            break;
-        }
-        else if(el->number + el->r >= number)
-        {
-            uint64_t count = number - el->number;
-            el->number += count;
-            el->t += count * el->d;
-            el->r -= count;
-            prunednow += count;
-            totalLength -= count * el->d;
-            break;
-        }
-        else
-        {
-            prunednow += el->r + 1;
-            elements.pop_front();
-            totalLength -= (el->d * (el->r + 1));
-            delete el;
-        }
+        prunednow += (*it).r + 1;
+        totalLength -= ((*it).d * ((*it).r + 1));
+        ++it;
+    }
+    it = elements.erase(elements.begin(), it);
+
+    if(it != elements.end() && (*it).number < number)
+    {
+        Element &el = *it;
+        uint64_t count = number - el.number;
+        el.number += count;
+        el.t += count * el.d;
+        el.r -= count;
+        prunednow += count;
+        totalLength -= count * el.d;
     }
 
     return prunednow;
@@ -225,40 +199,41 @@ void SegmentTimeline::updateWith(SegmentTimeline &other)
 {
     if(elements.empty())
     {
-        while(other.elements.size())
-        {
-            elements.push_back(other.elements.front());
-            other.elements.pop_front();
-        }
+        elements.swap(other.elements);
+        totalLength = other.totalLength;
+        other.elements.clear();
+        other.totalLength = 0;
         return;
     }
 
-    Element *last = elements.back();
-    while(other.elements.size())
+    /* Only the tail of the update can be new. Look for it from the end,
+     * so long DVR windows do not compare every known element */
+    const stime_t end = elements.back().end();
+    std::vector<Element>::const_iterator tail = other.elements.end();
+    while(tail != other.elements.begin() && (*(tail - 1)).end() > end)
+        --tail;
+
+    for(; tail != other.elements.end(); ++tail)
     {
-        Element *el = other.elements.front();
-        other.elements.pop_front();
+        const Element &el = *tail;
+        Element &last = elements.back();
 
-        if(last->contains(el->t)) /* Same element, but prev could have been middle of repeat */
+        if(last.contains(el.t)) /* Same element, but prev could have been middle of repeat */
         {
-            const uint64_t count = (el->t - last->t) / last->d;
-            totalLength -= (last->d * (last->r + 1));
-            last->r = std::max(last->r, el->r + count);
-            totalLength += (last->d * (last->r + 1));
-            delete el;
+            const uint64_t count = (el.t - last.t) / last.d;
+            totalLength -= (last.d * (last.r + 1));
+            last.r = std::max(last.r, el.r + count);
+            totalLength += (last.d * (last.r + 1));
         }
-        else if(el->t < last->t)
+        else if(el.t >= last.t) /* Did not exist in previous list */
         {
-            delete el;
-        }
-        else /* Did not exist in previous list */
-        {
-            totalLength += (el->d * (el->r + 1));
-            elements.push_back(el);
-            el->number = last->number + last->r + 1;
-            last = el;
+            totalLength += (el.d * (el.r + 1));
+            elements.push_back(Element(last.number + last.r + 1, el.d, el.r, el.t));
         }
     }
+
+    other.elements.clear();
+    other.totalLength = 0;
 }
 
 void SegmentTimeline::debug(vlc_object_t *obj, int indent) const
@@ -267,9 +242,9 @@ void SegmentTimeline::debug(vlc_object_t *obj, int indent) const
     ss << std::string(indent, ' ') << "Timeline";
     msg_Dbg(obj, "%s", ss.str().c_str());
 
-    std::list<Element *>::const_iterator it;
+    std::vector<Element>::const_iterator it;
     for(it = elements.begin(); it != elements.end(); ++it)
-        (*it)->debug(obj, indent + 1);
+        (*it).debug(obj, indent + 1);
 }
 
 SegmentTimeline::Element::Element(uint64_t number_, stime_t d_, uint64_t r_, stime_t t_)
@@ -280,9 +255,14 @@ SegmentTimeline::Element::Element(uint64_t number_, stime_t d_, uint64_t r_, sti
     r = r_;
 }
 
+stime_t SegmentTimeline::Element::end() const
+{
+    return t + (stime_t)(r + 1) * d;
+}
+
 bool SegmentTimeline::Element::contains(stime_t time) const
 {
-    if(time >= t && time < t + (stime_t)(r + 1) * d)
+    if(time >= t && time < end())
         return true;
     return false;
 }
@@ -27,7 +27,7 @@
 #include "Inheritables.hpp"
 
 #include <vlc_common.h>
-#include <list>
+#include <vector>
 
 namespace adaptive
 {
@@ -37,8 +37,6 @@ namespace adaptive
 
         class SegmentTimeline : public AttrsNode
         {
-            class Element;
-
             public:
                 SegmentTimeline(AbstractMultipleSegmentBaseType *);
                 virtual ~SegmentTimeline();
@@ -57,21 +55,23 @@ namespace adaptive
                 void debug(vlc_object_t *, int = 0) const;
 
             private:
-                std::list<Element *> elements;
-                stime_t totalLength;
-                AbstractMultipleSegmentBaseType *parent;
-
                 class Element
                 {
                     public:
                         Element(uint64_t, stime_t, uint64_t, stime_t);
                         void debug(vlc_object_t *, int = 0) const;
                         bool contains(stime_t) const;
+                        stime_t end() const;
                         stime_t  t;
                         stime_t  d;
                         uint64_t r;
                         uint64_t number;
                 };
+
+                std::vector<Element>::const_iterator findElementByNumber(uint64_t) const;
+                std::vector<Element> elements;
+                stime_t totalLength;
+                AbstractMultipleSegmentBaseType *parent;
         };
     }
 }
@@ -123,6 +123,7 @@ class DummyConnectionManager : public AbstractConnectionManager
                                                 const BytesRange &br) override
         {
             DummyChunkSource *d;
+            ++requests;
             auto it = data.find(uri);
             if(it == data.end())
                 d = new DummyChunkSource(t, br, std::vector<uint8_t>(), uri);
@@ -135,8 +136,11 @@ class DummyConnectionManager : public AbstractConnectionManager
         virtual void cancel(AbstractChunkSource *) override {}
 
         std::map<std::string, std::vector<uint8_t>> data;
+        static unsigned requests;
 };
 
+unsigned DummyConnectionManager::requests = 0;
+
 using mapentry = std::pair<std::string, std::vector<uint8_t>>;
 
 class SegmentTrackerListener : public SegmentTrackerListenerInterface
@@ -731,9 +735,173 @@ static int SegmentTracker_check_HLSseeks(BaseAdaptationSet *adaptSet,
     return 0;
 }
 
+/****** check segments prefetch ******/
+static int SegmentTracker_check_prefetch(BaseAdaptationSet *adaptSet,
+                                         DummyLogic *logic,
+                                         SegmentTracker *tracker,
+                                         SegmentTrackerListener &events)
+{
+    const stime_t START = 1337;
+    Timescale timescale(100);
+
+    ChunkInterface *currentChunk = nullptr;
+    try
+    {
+        for(int r=0; r<2; r++)
+        {
+            DummyRepresentation *rep = new DummyRepresentation(adaptSet);
+            adaptSet->addRepresentation(rep);
+            rep->setID(ID(std::to_string(r)));
+            rep->setBandwidth(1000000);
+
+            SegmentList *segmentList = nullptr;
+            try
+            {
+                segmentList = new SegmentList(rep);
+                segmentList->addAttribute(new TimescaleAttr(timescale));
+                for(int i=0; i<10; i++)
+                {
+                    /* 10s segments, so 30s of max buffering holds 3 */
+                    Segment *seg = new Segment(rep);
+                    seg->setSequenceNumber(123 + i);
+                    seg->startTime.Set(START + 1000 * i);
+                    seg->duration.Set(1000);
+                    seg->setSourceUrl("sample/aac");
+                    segmentList->addSegment(seg);
+                }
+            } catch (...) {
+                delete segmentList;
+                std::rethrow_exception(std::current_exception());
+            }
+            rep->addAttribute(segmentList);
+        }
+
+        /* returned chunk + prefetch up to budget */
+        DummyConnectionManager::requests = 0;
+        Expect(tracker->setStartPosition() == true);
+        currentChunk = tracker->getNextChunk(true);
+        Expect(currentChunk);
+        Expect(DummyConnectionManager::requests == 1 + 3);
+        delete currentChunk;
+        currentChunk = nullptr;
+
+        /* returned from prefetch, one more requested */
+        events.reset();
+        currentChunk = tracker->getNextChunk(true);
+        Expect(currentChunk);
+        Expect(DummyConnectionManager::requests == 1 + 3 + 1);
+        Expect(events.segmentchanged.starttime == timescale.ToTime(START + 1000 * 1) + VLC_TICK_0);
+        delete currentChunk;
+        currentChunk = nullptr;
+
+        /* switch drops prefetched chunks */
+        logic->repindex = 1;
+        events.reset();
+        currentChunk = tracker->getNextChunk(true);
+        Expect(currentChunk);
+        Expect(events.occured(TrackerEvent::Type::RepresentationSwitch) == true);
+        Expect(events.representationchanged.next == adaptSet->getRepresentations().at(1));
+        Expect(events.segmentchanged.starttime == timescale.ToTime(START + 1000 * 2) + VLC_TICK_0);
+        Expect(DummyConnectionManager::requests == 1 + 3 + 1 + 1 + 3);
+        delete currentChunk;
+        currentChunk = nullptr;
+
+        /* prefetch stops at end of playlist */
+        for(int i=3; i<10; i++)
+        {
+            currentChunk = tracker->getNextChunk(true);
+            Expect(currentChunk);
+            delete currentChunk;
+            currentChunk = nullptr;
+        }
+        Expect(DummyConnectionManager::requests == 1 + 3 + 1 + 1 + 3 + 4);
+        Expect(tracker->getNextChunk(true) == nullptr);
+
+    } catch( ... ) {
+        delete currentChunk;
+        return 1;
+    }
+
+    return 0;
+}
+
+/****** check startup requests ******/
+static int SegmentTracker_check_prefetchstart(BaseAdaptationSet *adaptSet,
+                                              DummyLogic *,
+                                              SegmentTracker *tracker,
+                                              SegmentTrackerListener &)
+{
+    const stime_t START = 1337;
+    Timescale timescale(100);
+
+    ChunkInterface *currentChunk = nullptr;
+    try
+    {
+        DummyRepresentation *rep0 = new DummyRepresentation(adaptSet);
+        adaptSet->addRepresentation(rep0);
+        rep0->setID(ID("0"));
+
+        SegmentList *segmentList = nullptr;
+        try
+        {
+            segmentList = new SegmentList(rep0);
+            segmentList->addAttribute(new TimescaleAttr(timescale));
+            for(int i=0; i<3; i++)
+            {
+                Segment *seg = new Segment(rep0);
+                seg->setSequenceNumber(123 + i);
+                seg->startTime.Set(START + 100 * i);
+                seg->duration.Set(100);
+                seg->setSourceUrl("sample/aac");
+                segmentList->addSegment(seg);
+            }
+        } catch (...) {
+            delete segmentList;
+            std::rethrow_exception(std::current_exception());
+        }
+        rep0->addAttribute(segmentList);
+
+        InitSegment *initSegment = new InitSegment(rep0);
+        initSegment->setSourceUrl("sample/aacinit");
+        segmentList->initialisationSegment.Set(initSegment);
+
+        /* init and first segment requested upfront */
+        DummyConnectionManager::requests = 0;
+        Expect(tracker->prefetchStart() == true);
+        Expect(DummyConnectionManager::requests == 2);
+        Expect(tracker->prefetchStart() == false);
+
+        currentChunk = tracker->getNextChunk(true);
+        Expect(currentChunk);
+        Expect(currentChunk->getContentType() == "sample/aacinit");
+        delete currentChunk;
+        currentChunk = nullptr;
+
+        currentChunk = tracker->getNextChunk(true);
+        Expect(currentChunk);
+        Expect(currentChunk->getContentType() == "sample/aac");
+        Expect(DummyConnectionManager::requests == 2);
+        delete currentChunk;
+        currentChunk = nullptr;
+
+        /* back to regular requests */
+        currentChunk = tracker->getNextChunk(true);
+        Expect(currentChunk);
+        Expect(DummyConnectionManager::requests == 3);
+        delete currentChunk;
+        currentChunk = nullptr;
+
+    } catch( ... ) {
+        delete currentChunk;
+        return 1;
+    }
+
+    return 0;
+}
+
 typedef decltype(SegmentTracker_check_formats) testfunc;
 
-static int Prepare_test(testfunc func)
+static int Prepare_test(testfunc func, unsigned prefetch = 0)
 {
     DummyConnectionManager *connManager = nullptr;
     try
@@ -747,6 +915,7 @@ static int Prepare_test(testfunc func)
 
     SharedResources sharedRes(nullptr, nullptr, connManager);
     DefaultBufferingLogic bufLogic;
+    bufLogic.setUserPrefetchSegments(prefetch);
     SynchronizationReferences syncRefs;
 
     BaseAdaptationSet *adaptSet = CreatePlaylistPeriodAdaptationSet();
@@ -786,5 +955,7 @@ int SegmentTracker_test()
         Prepare_test(SegmentTracker_check_seeks) ||
         Prepare_test(SegmentTracker_check_switches) ||
         Prepare_test(SegmentTracker_check_HLSseeks) ||
+        Prepare_test(SegmentTracker_check_prefetch, 4) ||
+        Prepare_test(SegmentTracker_check_prefetchstart) ||
         0;
 }
@@ -0,0 +1,103 @@
+/*****************************************************************************
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../SessionMetrics.hpp"
+#include "../playlist/BasePlaylist.hpp"
+#include "../playlist/BasePeriod.h"
+#include "../playlist/BaseAdaptationSet.h"
+#include "../playlist/BaseRepresentation.h"
+
+#include "test.hpp"
+
+using namespace adaptive;
+using namespace adaptive::playlist;
+
+class MetricsTestRepresentation : public BaseRepresentation
+{
+    public:
+        MetricsTestRepresentation(BaseAdaptationSet *set) : BaseRepresentation(set) {}
+        virtual ~MetricsTestRepresentation() = default;
+        virtual StreamFormat getStreamFormat() const override { return StreamFormat::Type::Unknown; }
+};
+
+static bool Contains(const std::string &s, const std::string &what)
+{
+    return s.find(what) != std::string::npos;
+}
+
+int SessionMetrics_test()
+{
+    BasePlaylist *pl = nullptr;
+    try
+    {
+        pl = new BasePlaylist(nullptr);
+        BasePeriod *period = new BasePeriod(pl);
+        pl->addPeriod(period);
+        BaseAdaptationSet *set = new BaseAdaptationSet(period);
+        period->addAdaptationSet(set);
+        set->setID(ID("video"));
+        MetricsTestRepresentation *rep0 = new MetricsTestRepresentation(set);
+        rep0->setID(ID("low"));
+        rep0->setBandwidth(500000);
+        set->addRepresentation(rep0);
+        MetricsTestRepresentation *rep1 = new MetricsTestRepresentation(set);
+        rep1->setID(ID("high"));
+        rep1->setBandwidth(2000000);
+        set->addRepresentation(rep1);
+
+        SessionMetrics metrics(nullptr, nullptr);
+        Expect(metrics.toString() == "{\"startup_ms\":-1,\"rebuffers\":0,"
+                                     "\"rebuffering_ms\":0,\"rebuffering\":false,"
+                                     "\"streams\":[]}");
+
+        /* first selection is not a switch */
+        metrics.trackerEvent(RepresentationSwitchEvent(nullptr, rep0));
+        metrics.trackerEvent(RepresentationSwitchEvent(rep0, rep1));
+        metrics.trackerEvent(BufferingLevelChangedEvent(set->getID(), 0, 0,
+                                                        CLOCK_FREQ * 3, 0));
+        metrics.updateDownloadRate(set->getID(), 4096,
+                                   CLOCK_FREQ / 2, CLOCK_FREQ / 10);
+        metrics.setStartupTime(CLOCK_FREQ * 3 / 2);
+
+        std::string s = metrics.toString();
+        Expect(Contains(s, "\"startup_ms\":1500,"));
+        Expect(Contains(s, "{\"id\":\"video\",\"representation\":\"high\","
+                           "\"bandwidth\":2000000,\"switches\":1,\"buffer_ms\":3000,"
+                           "\"segments\":1,\"bytes\":4096,\"last_segment\":"
+                           "{\"bytes\":4096,\"download_ms\":500,\"ttfb_ms\":100}}"));
+
+        metrics.setRebuffering(true);
+        metrics.setRebuffering(true);
+        Expect(Contains(metrics.toString(), "\"rebuffers\":1,"));
+        Expect(Contains(metrics.toString(), "\"rebuffering\":true,"));
+        metrics.setRebuffering(false);
+        Expect(Contains(metrics.toString(), "\"rebuffering\":false,"));
+
+        delete pl;
+    } catch (...) {
+        delete pl;
+        return 1;
+    }
+
+    return 0;
+}
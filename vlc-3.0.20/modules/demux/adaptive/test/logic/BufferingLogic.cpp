@@ -143,6 +143,9 @@ int BufferingLogic_test()
         Expect(bufferinglogic.getMaxBuffering(playlist) < DefaultBufferingLogic::DEFAULT_MAX_BUFFERING);
         Expect(bufferinglogic.getMinBuffering(playlist) >= DefaultBufferingLogic::BUFFERING_LOWEST_LIMIT);
         Expect(bufferinglogic.getLiveDelay(playlist) >= DefaultBufferingLogic::BUFFERING_LOWEST_LIMIT);
+        playlist->targetLatency.Set(DefaultBufferingLogic::BUFFERING_LOWEST_LIMIT * 2);
+        Expect(bufferinglogic.getLiveDelay(playlist) == DefaultBufferingLogic::BUFFERING_LOWEST_LIMIT * 2);
+        playlist->targetLatency.Set(0);
 
         playlist->b_lowlatency = false;
         Expect(bufferinglogic.getStartSegmentNumber(rep) == number);
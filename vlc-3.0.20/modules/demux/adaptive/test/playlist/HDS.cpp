@@ -0,0 +1,384 @@
+/*****************************************************************************
+ *
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../playlist/BasePeriod.h"
+#include "../../playlist/BaseAdaptationSet.h"
+#include "../../playlist/BaseRepresentation.h"
+#include "../../playlist/SegmentTemplate.h"
+#include "../../playlist/SegmentTimeline.h"
+#include "../../xml/Node.h"
+#include "../../../hds/playlist/BootstrapInfo.hpp"
+#include "../../../hds/playlist/F4M.hpp"
+#include "../../../hds/playlist/F4MParser.hpp"
+#include "../../../hds/playlist/HDSRepresentation.hpp"
+
+#include "../test.hpp"
+
+#include <vlc_strings.h>
+
+#include <cstring>
+#include <limits>
+#include <vector>
+
+using namespace adaptive;
+using namespace adaptive::playlist;
+using namespace hds::playlist;
+
+namespace
+{
+    class BoxWriter
+    {
+        public:
+            std::vector<uint8_t> data;
+
+            void u8(uint8_t v) { data.push_back(v); }
+            void u32(uint32_t v)
+            {
+                for(int i = 3; i >= 0; i--)
+                    data.push_back(v >> (8 * i));
+            }
+            void u64(uint64_t v) { u32(v >> 32); u32(v); }
+            void str(const char *s) { data.insert(data.end(), s, s + strlen(s) + 1); }
+            size_t open(const char *type)
+            {
+                size_t pos = data.size();
+                u32(0);
+                data.insert(data.end(), type, type + 4);
+                return pos;
+            }
+            void close(size_t pos) { SetDWBE(&data[pos], data.size() - pos); }
+    };
+
+    class FragmentRunEntry
+    {
+        public:
+            uint32_t first;
+            uint64_t timestamp;
+            uint32_t duration;
+            uint8_t discontinuity;
+    };
+}
+
+static std::vector<uint8_t> MakeBootstrap(bool live, uint32_t timescale, uint64_t time,
+                                          const std::vector<BootstrapInfo::SegmentRun> &segs,
+                                          const std::vector<FragmentRunEntry> &frags,
+                                          uint32_t segcount = 0, uint32_t fragcount = 0,
+                                          uint32_t fragtimescale = 0)
+{
+    BoxWriter w;
+    size_t abst = w.open("abst");
+    w.u32(0); /* version, flags */
+    w.u32(1); /* bootstrap info version */
+    w.u8(live ? 0x20 : 0x00);
+    w.u32(timescale);
+    w.u64(time);
+    w.u64(0); /* SMPTE offset */
+    w.str(""); /* movie identifier */
+    w.u8(1);
+    w.str("http://server.example.com");
+    w.u8(0); /* quality entries */
+    w.str(""); /* DRM */
+    w.str(""); /* metadata */
+
+    w.u8(1);
+    size_t asrt = w.open("asrt");
+    w.u32(0);
+    w.u8(0);
+    w.u32(segcount ? segcount : segs.size());
+    for(size_t i = 0; i < segs.size(); i++)
+    {
+        w.u32(segs[i].firstSegment);
+        w.u32(segs[i].fragmentsPerSegment);
+    }
+    w.close(asrt);
+
+    w.u8(1);
+    size_t afrt = w.open("afrt");
+    w.u32(0);
+    w.u32(fragtimescale ? fragtimescale : timescale);
+    w.u8(0);
+    w.u32(fragcount ? fragcount : frags.size());
+    for(size_t i = 0; i < frags.size(); i++)
+    {
+        w.u32(frags[i].first);
+        w.u64(frags[i].timestamp);
+        w.u32(frags[i].duration);
+        if(frags[i].duration == 0)
+            w.u8(frags[i].discontinuity);
+    }
+    w.close(afrt);
+
+    w.close(abst);
+    return w.data;
+}
+
+static SegmentTimeline * ParseTimeline(const std::vector<uint8_t> &data)
+{
+    BootstrapInfo bootstrap;
+    if(!bootstrap.parse(nullptr, data.data(), data.size()))
+        return nullptr;
+    return bootstrap.createTimeline();
+}
+
+int HDSBootstrap_test()
+{
+    SegmentTimeline *timeline = nullptr;
+    const stime_t max = std::numeric_limits<stime_t>::max();
+
+    try
+    {
+        /* VOD: a single run up to the media time */
+        std::vector<uint8_t> data = MakeBootstrap(false, 1000, 20000,
+                                                  {{1, 10}}, {{1, 0, 4000, 0}});
+        BootstrapInfo bootstrap;
+        Expect(bootstrap.parse(nullptr, data.data(), data.size()));
+        Expect(!bootstrap.live);
+        Expect(bootstrap.servers.size() == 1);
+        Expect(bootstrap.getFragmentCount() == 10);
+        timeline = bootstrap.createTimeline();
+        Expect(timeline);
+        Expect(timeline->minElementNumber() == 1);
+        Expect(timeline->maxElementNumber() == 5);
+        Expect(timeline->getTotalLength() == 20000);
+        delete timeline;
+
+        /* counts are clamped to the declared fragments */
+        timeline = ParseTimeline(MakeBootstrap(false, 1000, 20000,
+                                               {{1, 3}}, {{1, 0, 4000, 0}}));
+        Expect(timeline);
+        Expect(timeline->maxElementNumber() == 3);
+        delete timeline;
+
+        /* several runs, segments, and the table end sentinel */
+        timeline = ParseTimeline(MakeBootstrap(false, 1000, 20000,
+                                               {{1, 2}, {3, 3}},
+                                               {{1, 0, 4000, 0},
+                                                {3, 8000, 2000, 0},
+                                                {0, 0, 0, 0}}));
+        Expect(timeline);
+        Expect(timeline->minElementNumber() == 1);
+        Expect(timeline->maxElementNumber() == 7); /* 2 * 2 + 3 declared */
+        Expect(timeline->getScaledPlaybackTimeByElementNumber(4) == 10000);
+        delete timeline;
+
+        /* live: only completed fragments */
+        timeline = ParseTimeline(MakeBootstrap(true, 1000, 19000,
+                                               {{1, 100}}, {{1, 0, 4000, 0}}));
+        Expect(timeline);
+        Expect(timeline->maxElementNumber() == 4);
+        delete timeline;
+
+        /* media time too large to be rescaled */
+        timeline = ParseTimeline(MakeBootstrap(false, 1, UINT64_MAX,
+                                               {{1, UINT32_MAX}}, {{1, 0, 1, 0}},
+                                               0, 0, 1000));
+        Expect(timeline);
+        Expect(timeline->maxElementNumber() == UINT32_MAX);
+        Expect(timeline->getTotalLength() == UINT32_MAX);
+        delete timeline;
+
+        /* runs ending past the largest time are cut */
+        timeline = ParseTimeline(MakeBootstrap(false, 1000, UINT64_MAX,
+                                               {{1, UINT32_MAX}},
+                                               {{1, (uint64_t) max - 5, 4, 0}}));
+        Expect(timeline);
+        Expect(timeline->maxElementNumber() == 1);
+        delete timeline;
+
+        /* unusable times, backward or undeclared fragments are dropped */
+        timeline = ParseTimeline(MakeBootstrap(false, 1000, 20000,
+                                               {{1, 10}},
+                                               {{5, 0, 4000, 0},
+                                                {2, 4000, 4000, 0},
+                                                {11, 8000, 4000, 0},
+                                                {0, UINT64_MAX, 4000, 0}}));
+        Expect(timeline);
+        Expect(timeline->minElementNumber() == 5);
+        Expect(timeline->maxElementNumber() == 5);
+        delete timeline;
+        timeline = nullptr;
+
+        /* truncated boxes */
+        data = MakeBootstrap(false, 1000, 20000, {{1, 10}}, {{1, 0, 4000, 0}});
+        for(size_t i = 0; i < data.size(); i++)
+        {
+            BootstrapInfo truncated;
+            Expect(!truncated.parse(nullptr, data.data(), i));
+        }
+
+        /* box sizes larger than the data */
+        std::vector<uint8_t> oversized = data;
+        SetDWBE(&oversized[0], data.size() + 1);
+        Expect(!bootstrap.parse(nullptr, oversized.data(), oversized.size()));
+
+        /* entry counts larger than the tables */
+        data = MakeBootstrap(false, 1000, 20000, {{1, 10}}, {{1, 0, 4000, 0}},
+                             UINT32_MAX, 0);
+        Expect(!bootstrap.parse(nullptr, data.data(), data.size()));
+        data = MakeBootstrap(false, 1000, 20000, {{1, 10}}, {{1, 0, 4000, 0}},
+                             0, UINT32_MAX);
+        Expect(!bootstrap.parse(nullptr, data.data(), data.size()));
+    }
+    catch(...)
+    {
+        delete timeline;
+        return 1;
+    }
+
+    return 0;
+}
+
+static const std::string strManifest("manifest");
+static const std::string strDuration("duration");
+static const std::string strStreamType("streamType");
+static const std::string strBootstrapInfo("bootstrapInfo");
+static const std::string strMedia("media");
+static const std::string strId("id");
+static const std::string strUrl("url");
+static const std::string strBitrate("bitrate");
+static const std::string strWidth("width");
+static const std::string strBootstrapInfoId("bootstrapInfoId");
+static const std::string strAlternate("alternate");
+
+static xml::Node * NewNode(xml::Node *parent, const std::string &name,
+                           const std::string &text = std::string())
+{
+    xml::Node *node = new xml::Node();
+    node->setName(&name);
+    node->setText(text);
+    if(parent)
+        parent->addSubNode(node);
+    return node;
+}
+
+static std::string EncodeBootstrap(const std::vector<uint8_t> &data)
+{
+    char *psz = vlc_b64_encode_binary(data.data(), data.size());
+    std::string b64(psz ? psz : "");
+    free(psz);
+    /* manifests wrap their base64 payloads */
+    if(b64.size() > 16)
+        b64.insert(16, "\n    ");
+    return b64;
+}
+
+int F4M_test()
+{
+    xml::Node *root = nullptr;
+    F4M *f4m = nullptr;
+
+    try
+    {
+        root = NewNode(nullptr, strManifest);
+        NewNode(root, strDuration, "20.0");
+        NewNode(root, strStreamType, "recorded");
+
+        xml::Node *node = NewNode(root, strBootstrapInfo,
+                                  EncodeBootstrap(MakeBootstrap(false, 1000, 20000,
+                                                                {{1, 2}, {3, 3}},
+                                                                {{1, 0, 4000, 0}})));
+        node->addAttribute(&strId, "boot0");
+
+        node = NewNode(root, strMedia);
+        node->addAttribute(&strUrl, "low");
+        node->addAttribute(&strBitrate, "800");
+        node->addAttribute(&strWidth, "640");
+        node->addAttribute(&strBootstrapInfoId, "boot0");
+
+        /* bitrate overflowing once in bps */
+        node = NewNode(root, strMedia);
+        node->addAttribute(&strUrl, "high");
+        node->addAttribute(&strBitrate, "18446744073709552");
+        node->addAttribute(&strBootstrapInfoId, "boot0");
+
+        /* audio alternate, and unknown bootstrap */
+        node = NewNode(root, strMedia);
+        node->addAttribute(&strUrl, "audio");
+        node->addAttribute(&strAlternate, "true");
+        node->addAttribute(&strBootstrapInfoId, "boot0");
+        node = NewNode(root, strMedia);
+        node->addAttribute(&strUrl, "other");
+        node->addAttribute(&strBootstrapInfoId, "boot1");
+
+        F4MParser parser(root, nullptr, nullptr, "http://example.com/foo/manifest.f4m");
+        f4m = parser.parse();
+        Expect(f4m);
+        Expect(!f4m->isLive());
+        Expect(f4m->duration.Get() == vlc_tick_t(20 * CLOCK_FREQ));
+
+        BasePeriod *period = f4m->getFirstPeriod();
+        Expect(period);
+        Expect(period->getAdaptationSets().size() == 1);
+        const std::vector<BaseRepresentation *> &reps =
+                period->getAdaptationSets().front()->getRepresentations();
+        Expect(reps.size() == 2);
+
+        /* sorted by bandwidth */
+        HDSRepresentation *rep = dynamic_cast<HDSRepresentation *>(reps.back());
+        Expect(rep);
+        Expect(rep->getStreamFormat() == StreamFormat(StreamFormat::Type::FLV));
+        Expect(rep->getBandwidth() == 800000);
+        Expect(rep->getWidth() == 640);
+        Expect(reps.front()->getBandwidth() == 0);
+
+        /* fragments 1-2 in segment 1, 3-4 in segment 2, then segment 3 */
+        Expect(rep->getSegmentNumber(1) == 1);
+        Expect(rep->getSegmentNumber(4) == 2);
+        Expect(rep->getSegmentNumber(7) == 3);
+        SegmentTemplate *templ = rep->inheritSegmentTemplate();
+        Expect(templ);
+        Expect(rep->contextualize(4, "Seg{segment}-Frag{fragment}", templ) == "Seg2-Frag4");
+        Expect(rep->getMediaSegment(5) != nullptr);
+        Expect(rep->getMediaSegment(6) == nullptr);
+
+        delete f4m;
+        f4m = nullptr;
+        delete root;
+
+        /* no duration: live */
+        root = NewNode(nullptr, strManifest);
+        node = NewNode(root, strBootstrapInfo,
+                       EncodeBootstrap(MakeBootstrap(true, 1000, 20000,
+                                                     {{1, 100}}, {{1, 0, 4000, 0}})));
+        node = NewNode(root, strMedia);
+        node->addAttribute(&strUrl, "live");
+
+        F4MParser liveparser(root, nullptr, nullptr, "http://example.com/manifest.f4m");
+        f4m = liveparser.parse();
+        Expect(f4m);
+        Expect(f4m->isLive());
+        Expect(f4m->getFirstPeriod()->getAdaptationSets().front()->
+               getRepresentations().size() == 1);
+
+        delete f4m;
+        delete root;
+    }
+    catch(...)
+    {
+        delete f4m;
+        delete root;
+        return 1;
+    }
+
+    return 0;
+}
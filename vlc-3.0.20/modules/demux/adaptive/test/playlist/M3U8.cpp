@@ -546,5 +546,78 @@ int M3U8Playlist_test()
         return 1;
     }
 
+    /* Manifest 6: low latency */
+    const char manifest6[] =
+    "#EXTM3U\n"
+    "#EXT-X-TARGETDURATION:4\n"
+    "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=3.0\n"
+    "#EXT-X-PART-INF:PART-TARGET=1.0\n"
+    "#EXT-X-MEDIA-SEQUENCE:10\n"
+    "#EXTINF:4\n"
+    "foobar10.ts\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"foobar11.0.ts\"\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"foobar11.1.ts\",GAP=YES\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"foobar11.ts\",BYTERANGE=\"1000@0\"\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"foobar11.ts\",BYTERANGE=\"500\"\n"
+    "#EXTINF:4\n"
+    "foobar11.ts\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"foobar12.0.ts\"\n"
+    "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"foobar12.1.ts\"\n";
+
+    m3u = ParseM3U8(obj, manifest6, sizeof(manifest6));
+    try
+    {
+        Expect(m3u);
+        Expect(m3u->isLive() == true);
+        Expect(m3u->isLowLatency() == true);
+        BaseRepresentation *rep = m3u->getFirstPeriod()->getAdaptationSets().front()->
+                                  getRepresentations().front();
+        Timescale timescale = rep->inheritTimescale();
+        const SegmentList *segmentList = rep->inheritSegmentList();
+        Expect(segmentList);
+        /* full segment, 3 parts without the gap, current part and hint */
+        const std::vector<Segment *> &list = segmentList->getSegments();
+        Expect(list.size() == 6);
+        for(size_t i=0; i<list.size(); i++)
+            Expect(list.at(i)->getSequenceNumber() == 10 + i);
+
+        const HLSSegment *seg = static_cast<const HLSSegment *>(list.at(0));
+        Expect(!seg->isPartial());
+        Expect(seg->getMediaSequenceNumber() == 10);
+        Expect(seg->duration.Get() == timescale.ToScaled(vlc_tick_from_sec(4)));
+
+        seg = static_cast<const HLSSegment *>(list.at(1));
+        Expect(seg->isPartial());
+        Expect(seg->getMediaSequenceNumber() == 11);
+        Expect(seg->getPartIndex() == 0);
+        Expect(seg->startTime.Get() == timescale.ToScaled(vlc_tick_from_sec(4)));
+
+        seg = static_cast<const HLSSegment *>(list.at(2));
+        Expect(seg->getPartIndex() == 2);
+        Expect(seg->startTime.Get() == timescale.ToScaled(vlc_tick_from_sec(6)));
+        Expect(seg->getOffset() == 0);
+
+        seg = static_cast<const HLSSegment *>(list.at(3));
+        Expect(seg->getPartIndex() == 3);
+        Expect(seg->getOffset() == 1000);
+
+        seg = static_cast<const HLSSegment *>(list.at(4));
+        Expect(seg->getMediaSequenceNumber() == 12);
+        Expect(seg->getPartIndex() == 0);
+        Expect(seg->startTime.Get() == timescale.ToScaled(vlc_tick_from_sec(8)));
+
+        seg = static_cast<const HLSSegment *>(list.at(5));
+        Expect(seg->getMediaSequenceNumber() == 12);
+        Expect(seg->getPartIndex() == 1);
+        Expect(seg->getUrlSegment().toString().find("foobar12.1.ts") != std::string::npos);
+
+        delete m3u;
+    }
+    catch (...)
+    {
+        delete m3u;
+        return 1;
+    }
+
     return 0;
 }
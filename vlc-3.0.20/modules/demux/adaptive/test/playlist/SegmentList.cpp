@@ -135,6 +135,20 @@ int SegmentList_test()
         Expect(segmentList->getStartSegmentNumber() == 123 + 10);
         Expect(segmentList->getTotalLength() == 100 * 10);
 
+        /* delta update: carry over a known range */
+        segmentList->pruneAfterSegmentNumber(123+15);
+        Expect(segmentList->getSegments().size() == 6);
+        Expect(segmentList->getTotalLength() == 100 * 6);
+        delete segmentList2;
+        segmentList2 = new SegmentList(nullptr);
+        segmentList2->moveSegmentsFrom(segmentList, 123+12);
+        Expect(segmentList->getSegments().size() == 2);
+        Expect(segmentList->getTotalLength() == 100 * 2);
+        Expect(segmentList2->getSegments().size() == 4);
+        Expect(segmentList2->getTotalLength() == 100 * 4);
+        Expect(segmentList2->getStartSegmentNumber() == 123 + 12);
+        Expect(segmentList2->getSegments().back()->getSequenceNumber() == 123 + 15);
+
         delete segmentList;
         delete segmentList2;
         segmentList2 = nullptr;
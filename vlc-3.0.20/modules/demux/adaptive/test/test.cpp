@@ -49,6 +49,9 @@ int main()
     TEST(CommandsQueue) ||
     TEST(M3U8MasterPlaylist) ||
     TEST(M3U8Playlist) ||
-    TEST(SegmentTracker)
+    TEST(HDSBootstrap) ||
+    TEST(F4M) ||
+    TEST(SegmentTracker) ||
+    TEST(SessionMetrics)
     ;
 }
@@ -88,6 +88,17 @@ bool DOMParser::reset(stream_t *s)
     return !!vlc_reader;
 }
 
+const std::string * DOMParser::intern(const char *psz)
+{
+    /* manifests only use a few distinct names: reuse the lookup key
+     * storage and keep a single copy of each name */
+    lookup.assign(psz);
+    std::unordered_set<std::string>::const_iterator it = names.find(lookup);
+    if(it == names.end())
+        it = names.insert(lookup).first;
+    return &(*it);
+}
+
 Node* DOMParser::processNode(bool b_strict)
 {
     const char *data;
@@ -108,7 +119,7 @@ Node* DOMParser::processNode(bool b_strict)
                         lifo.top()->addSubNode(node);
                     lifo.push(node);
 
-                    node->setName(std::string(data));
+                    node->setName(intern(data));
                     addAttributesToNode(node);
                 }
 
@@ -160,11 +171,7 @@ void    DOMParser::addAttributesToNode      (Node *node)
     const char *attrName;
 
     while((attrName = xml_ReaderNextAttr(this->vlc_reader, &attrValue)) != nullptr)
-    {
-        std::string key     = attrName;
-        std::string value   = attrValue;
-        node->addAttribute(key, value);
-    }
+        node->addAttribute(intern(attrName), attrValue);
 }
 void    DOMParser::print                    (Node *node, int offset)
 {
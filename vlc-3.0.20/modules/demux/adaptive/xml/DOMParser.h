@@ -30,6 +30,9 @@
 
 #include "Node.h"
 
+#include <string>
+#include <unordered_set>
+
 namespace adaptive
 {
     namespace xml
@@ -52,6 +55,11 @@ namespace adaptive
 
                 xml_reader_t        *vlc_reader;
 
+                /* element and attribute names, shared by all nodes */
+                std::unordered_set<std::string> names;
+                std::string                     lookup;
+
+                const std::string * intern      (const char *);
                 Node*   processNode             (bool);
                 void    addAttributesToNode     (Node *node);
                 void    print                   (Node *node, int offset);
@@ -36,6 +36,7 @@ using namespace adaptive::xml;
 const std::string   Node::EmptyString = "";
 
 Node::Node() :
+    name( &EmptyString ),
     type( -1 )
 {
 }
@@ -55,41 +56,56 @@ void                                Node::addSubNode            (Node *node)
 }
 const std::string&                  Node::getName               () const
 {
-    return this->name;
+    return *this->name;
 }
-void                                Node::setName               (const std::string& name)
+void                                Node::setName               (const std::string *name)
 {
     this->name = name;
 }
 
 bool                                Node::hasAttribute        (const std::string& name) const
 {
-    if(this->attributes.find(name) != this->attributes.end())
-        return true;
-
+    std::vector<Attribute>::const_iterator it;
+    for(it = this->attributes.begin(); it != this->attributes.end(); ++it)
+    {
+        if(*(*it).first == name)
+            return true;
+    }
     return false;
 }
 const std::string&                  Node::getAttributeValue     (const std::string& key) const
 {
-    std::map<std::string, std::string>::const_iterator  it = this->attributes.find( key );
-
-    if ( it != this->attributes.end() )
-        return it->second;
+    std::vector<Attribute>::const_iterator it;
+    for(it = this->attributes.begin(); it != this->attributes.end(); ++it)
+    {
+        if(*(*it).first == key)
+            return (*it).second;
+    }
     return EmptyString;
 }
 
-void                                Node::addAttribute          ( const std::string& key, const std::string& value)
+void                                Node::addAttribute          ( const std::string *key, const char *value)
 {
-    this->attributes[key] = value;
+    std::vector<Attribute>::iterator it;
+    for(it = this->attributes.begin(); it != this->attributes.end(); ++it)
+    {
+        if((*it).first == key)
+        {
+            (*it).second.assign(value);
+            return;
+        }
+    }
+    this->attributes.push_back(Attribute(key, value));
 }
 std::vector<std::string>            Node::getAttributeKeys      () const
 {
     std::vector<std::string> keys;
-    std::map<std::string, std::string>::const_iterator it;
+    std::vector<Attribute>::const_iterator it;
 
+    keys.reserve(this->attributes.size());
     for(it = this->attributes.begin(); it != this->attributes.end(); ++it)
     {
-        keys.push_back(it->first);
+        keys.push_back(*(*it).first);
     }
     return keys;
 }
@@ -104,11 +120,6 @@ void Node::setText(const std::string &text)
     this->text = text;
 }
 
-const std::map<std::string,std::string>&   Node::getAttributes         () const
-{
-    return this->attributes;
-}
-
 int Node::getType() const
 {
     return this->type;
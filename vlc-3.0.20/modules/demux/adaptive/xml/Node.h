@@ -27,7 +27,7 @@
 
 #include <vector>
 #include <string>
-#include <map>
+#include <utility>
 
 namespace adaptive
 {
@@ -42,23 +42,27 @@ namespace adaptive
                 const std::vector<Node *>&          getSubNodes         () const;
                 void                                addSubNode          (Node *node);
                 const std::string&                  getName             () const;
-                void                                setName             (const std::string& name);
+                void                                setName             (const std::string *name);
                 bool                                hasAttribute        (const std::string& name) const;
-                void                                addAttribute        (const std::string& key, const std::string& value);
+                void                                addAttribute        (const std::string *key, const char *value);
                 const std::string&                  getAttributeValue   (const std::string& key) const;
                 std::vector<std::string>            getAttributeKeys    () const;
                 const std::string&                  getText             () const;
                 void                                setText( const std::string &text );
-                const std::map<std::string, std::string>& getAttributes () const;
                 int                                 getType() const;
                 void                                setType( int type );
                 std::vector<std::string>            toString(int) const;
 
             private:
+                /* names and keys are interned by the parser, which outlives
+                 * the nodes; elements carry only a few attributes, so a
+                 * linear lookup beats a map */
+                typedef std::pair<const std::string *, std::string> Attribute;
+
                 static const std::string            EmptyString;
                 std::vector<Node *>                 subNodes;
-                std::map<std::string, std::string>  attributes;
-                std::string                         name;
+                std::vector<Attribute>              attributes;
+                const std::string                   *name;
                 std::string                         text;
                 int                                 type;
 
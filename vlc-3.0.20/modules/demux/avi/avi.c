@@ -33,6 +33,7 @@
 #include <limits.h>
 
 #include <vlc_common.h>
+#include <vlc_atomic.h>
 #include <vlc_plugin.h>
 #include <vlc_demux.h>
 #include <vlc_input.h>
@@ -120,24 +121,65 @@ typedef struct
 
 typedef struct
 {
-    vlc_fourcc_t i_id;
     uint32_t     i_flags;
     uint64_t     i_pos;
     uint32_t     i_length;
-    uint64_t     i_lengthtotal;
 
 } avi_entry_t;
 
+/* Index entries are stored by blocks, with positions relative to the first
+ * entry of the block and cumulated lengths only kept once per block. This
+ * takes 8.5 bytes per entry instead of the 32 bytes of an avi_entry_t. */
+#define AVI_INDEX_BLOCK 64
+
+typedef struct
+{
+    uint64_t i_pos;         /* position of the first entry */
+    uint64_t i_lengthtotal; /* cumulated length of the previous blocks */
+    uint64_t i_keyframes;   /* one bit per entry */
+    uint64_t *p_pos;        /* absolute positions, if a delta overflowed */
+    uint32_t i_delta[AVI_INDEX_BLOCK];
+    uint32_t i_length[AVI_INDEX_BLOCK];
+
+} avi_index_block_t;
+
 typedef struct
 {
-    uint32_t        i_size;
-    uint32_t        i_max;
-    avi_entry_t     *p_entry;
+    uint32_t          i_size;
+    uint32_t          i_max;
+    avi_index_block_t *p_block;
 
 } avi_index_t;
 static void avi_index_Init( avi_index_t * );
 static void avi_index_Clean( avi_index_t * );
-static int64_t avi_index_Append( avi_index_t *, uint64_t *, avi_entry_t * );
+static int64_t avi_index_Append( avi_index_t *, uint64_t *, const avi_entry_t * );
+
+static inline uint64_t avi_index_Pos( const avi_index_t *p_index, uint32_t i )
+{
+    const avi_index_block_t *p_block = &p_index->p_block[i / AVI_INDEX_BLOCK];
+    i %= AVI_INDEX_BLOCK;
+    return p_block->p_pos ? p_block->p_pos[i] : p_block->i_pos + p_block->i_delta[i];
+}
+
+static inline uint32_t avi_index_Length( const avi_index_t *p_index, uint32_t i )
+{
+    return p_index->p_block[i / AVI_INDEX_BLOCK].i_length[i % AVI_INDEX_BLOCK];
+}
+
+/* Cumulated length of the entries before i */
+static inline uint64_t avi_index_LengthTotal( const avi_index_t *p_index, uint32_t i )
+{
+    const avi_index_block_t *p_block = &p_index->p_block[i / AVI_INDEX_BLOCK];
+    uint64_t i_total = p_block->i_lengthtotal;
+    for( uint32_t j = 0; j < i % AVI_INDEX_BLOCK; j++ )
+        i_total += p_block->i_length[j];
+    return i_total;
+}
+
+static inline bool avi_index_IsKeyframe( const avi_index_t *p_index, uint32_t i )
+{
+    return (p_index->p_block[i / AVI_INDEX_BLOCK].i_keyframes >> (i % AVI_INDEX_BLOCK)) & 1;
+}
 
 typedef struct
 {
@@ -171,6 +213,22 @@ typedef struct
 
 } avi_track_t;
 
+/* Index built from LIST-movi in the background */
+typedef struct
+{
+    vlc_thread_t    thread;
+    vlc_mutex_t     lock;
+    stream_t        *s;
+    atomic_bool     b_stop;
+    bool            b_done;
+
+    uint64_t        i_movi_end;
+    uint64_t        i_riffx_pos; /* second RIFF chunk (OpenDML) or 0 */
+
+    /* entries found since the last merge, one index per track */
+    avi_index_t     *p_pending;
+} avi_index_builder_t;
+
 struct demux_sys_t
 {
     vlc_tick_t i_time;
@@ -189,6 +247,8 @@ struct demux_sys_t
     uint64_t i_movi_begin;
     uint64_t i_movi_lastchunk_pos;   /* XXX position of last valid chunk */
 
+    avi_index_builder_t *p_builder;
+
     /* number of streams and information */
     unsigned int i_track;
     avi_track_t  **track;
@@ -219,12 +279,14 @@ static int AVI_StreamBytesSet ( demux_t *, avi_track_t *, uint64_t i_byte );
 vlc_fourcc_t AVI_FourccGetCodec( unsigned int i_cat, vlc_fourcc_t );
 static int   AVI_GetKeyFlag    ( const avi_track_t *, const uint8_t * );
 
-static int AVI_PacketGetHeader( demux_t *, avi_packet_t *p_pk );
-static int AVI_PacketNext     ( demux_t * );
-static int AVI_PacketSearch   ( demux_t * );
+static int AVI_PacketGetHeader( stream_t *, avi_packet_t *p_pk );
+static int AVI_PacketNext     ( stream_t * );
+static int AVI_PacketSearch   ( demux_t *, stream_t * );
 
 static void AVI_IndexLoad    ( demux_t * );
 static void AVI_IndexCreate  ( demux_t * );
+static void AVI_IndexMerge   ( demux_t * );
+static void AVI_IndexStop    ( demux_t * );
 
 static void AVI_ExtractSubtitle( demux_t *, unsigned int i_stream, avi_chunk_list_t *, avi_chunk_STRING_t * );
 
@@ -278,6 +340,8 @@ static void Close ( vlc_object_t * p_this )
     demux_t *    p_demux = (demux_t *)p_this;
     demux_sys_t *p_sys = p_demux->p_sys  ;
 
+    AVI_IndexStop( p_demux );
+
     for( unsigned int i = 0; i < p_sys->i_track; i++ )
     {
         if( p_sys->track[i] )
@@ -850,6 +914,13 @@ static int Open( vlc_object_t * p_this )
         goto error;
     }
 
+    if( p_demux->b_preparse_lite )
+    {   /* Estimate the length from the main header, without the index */
+        p_sys->i_length = (vlc_tick_t)p_avih->i_totalframes *
+                          (vlc_tick_t)p_avih->i_microsecperframe / CLOCK_FREQ;
+        goto index_done;
+    }
+
     i_do_index = var_InheritInteger( p_demux, "avi-index" );
     if( i_do_index == 1 ) /* Always fix */
     {
@@ -880,10 +951,11 @@ aviindex:
     for( unsigned int i = 0; i < p_sys->i_track; i++ )
     {
         const avi_track_t *tk = p_sys->track[i];
-        if( tk->fmt.i_cat == VIDEO_ES && tk->idx.p_entry )
+        if( tk->fmt.i_cat == VIDEO_ES )
             i_idx_totalframes = __MAX(i_idx_totalframes, tk->idx.i_size);
     }
-    if( i_idx_totalframes != p_avih->i_totalframes &&
+    if( !p_sys->p_builder &&
+        i_idx_totalframes != p_avih->i_totalframes &&
         p_sys->i_length < (vlc_tick_t)p_avih->i_totalframes *
                           (vlc_tick_t)p_avih->i_microsecperframe /
                           CLOCK_FREQ )
@@ -931,6 +1003,7 @@ aviindex:
         }
     }
 
+index_done:
     /* fix some BeOS MediaKit generated file */
     for( unsigned i = 0 ; i < p_sys->i_track; i++ )
     {
@@ -952,8 +1025,8 @@ aviindex:
             tk->i_rate == p_wf->nSamplesPerSec )
         {
             int64_t i_track_length =
-                tk->idx.p_entry[tk->idx.i_size-1].i_length +
-                tk->idx.p_entry[tk->idx.i_size-1].i_lengthtotal;
+                avi_index_Length( &tk->idx, tk->idx.i_size-1 ) +
+                avi_index_LengthTotal( &tk->idx, tk->idx.i_size-1 );
             vlc_tick_t i_length = (vlc_tick_t)p_avih->i_totalframes *
                                (vlc_tick_t)p_avih->i_microsecperframe;
 
@@ -1163,6 +1236,7 @@ static int Demux_Seekable( demux_t *p_demux )
     /* cannot be more than 100 stream (dcXX or wbXX) */
     avi_track_toread_t toread[100];
 
+    AVI_IndexMerge( p_demux );
 
     /* detect new selected/unselected streams */
     for( i_track = 0; i_track < p_sys->i_track; i_track++ )
@@ -1222,7 +1296,7 @@ static int Demux_Seekable( demux_t *p_demux )
         toread[i_track].b_ok = tk->b_activated && !tk->b_eof;
         if( tk->i_idxposc < tk->idx.i_size )
         {
-            toread[i_track].i_posf = tk->idx.p_entry[tk->i_idxposc].i_pos;
+            toread[i_track].i_posf = avi_index_Pos( &tk->idx, tk->i_idxposc );
            if( tk->i_idxposb > 0 )
            {
                 toread[i_track].i_posf += 8 + tk->i_idxposb;
@@ -1307,7 +1381,7 @@ static int Demux_Seekable( demux_t *p_demux )
             if( p_sys->b_seekable && p_sys->i_movi_lastchunk_pos >= p_sys->i_movi_begin + 12 )
             {
                 vlc_stream_Seek( p_demux->s, p_sys->i_movi_lastchunk_pos );
-                if( AVI_PacketNext( p_demux ) )
+                if( AVI_PacketNext( p_demux->s ) )
                 {
                     return( AVI_TrackStopFinishedStreams( p_demux ) ? 0 : 1 );
                 }
@@ -1321,7 +1395,7 @@ static int Demux_Seekable( demux_t *p_demux )
             {
                 avi_packet_t avi_pk;
 
-                if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+                if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
                 {
                     msg_Warn( p_demux,
                              "cannot get packet header, track disabled" );
@@ -1330,7 +1404,7 @@ static int Demux_Seekable( demux_t *p_demux )
                 if( avi_pk.i_stream >= p_sys->i_track ||
                     ( avi_pk.i_cat != AUDIO_ES && avi_pk.i_cat != VIDEO_ES ) )
                 {
-                    if( AVI_PacketNext( p_demux ) )
+                    if( AVI_PacketNext( p_demux->s ) )
                     {
                         msg_Warn( p_demux,
                                   "cannot skip packet, track disabled" );
@@ -1357,11 +1431,9 @@ static int Demux_Seekable( demux_t *p_demux )
 
                     /* add this chunk to the index */
                     avi_entry_t index;
-                    index.i_id     = avi_pk.i_fourcc;
                     index.i_flags  = AVI_GetKeyFlag(tk, avi_pk.i_peek);
                     index.i_pos    = avi_pk.i_pos;
                     index.i_length = avi_pk.i_size;
-                    index.i_lengthtotal = index.i_length;
                     int64_t i_indexid = avi_index_Append( &tk->idx, &p_sys->i_movi_lastchunk_pos, &index );
 
                     /* do we will read this data ? */
@@ -1374,7 +1446,7 @@ static int Demux_Seekable( demux_t *p_demux )
                     }
                     else
                     {
-                        if( AVI_PacketNext( p_demux ) )
+                        if( AVI_PacketNext( p_demux->s ) )
                         {
                             msg_Warn( p_demux,
                                       "cannot skip packet, track disabled" );
@@ -1394,7 +1466,7 @@ static int Demux_Seekable( demux_t *p_demux )
         tk = p_sys->track[i_track];
 
         size_t i_size;
-        unsigned i_ck_remaining_bytes = tk->idx.p_entry[tk->i_idxposc].i_length -
+        unsigned i_ck_remaining_bytes = avi_index_Length( &tk->idx, tk->i_idxposc ) -
                                         tk->i_idxposb;
 
         /* read those data */
@@ -1436,7 +1508,7 @@ static int Demux_Seekable( demux_t *p_demux )
         }
 
         p_frame->i_pts = VLC_TICK_0 + AVI_GetPTS( tk );
-        if( tk->idx.p_entry[tk->i_idxposc].i_flags&AVIIF_KEYFRAME )
+        if( avi_index_IsKeyframe( &tk->idx, tk->i_idxposc ) )
         {
             p_frame->i_flags = BLOCK_FLAG_TYPE_I;
         }
@@ -1451,7 +1523,7 @@ static int Demux_Seekable( demux_t *p_demux )
             toread[i_track].i_toread -= i_size;
             tk->i_idxposb += i_size;
             if( tk->i_idxposb >=
-                    tk->idx.p_entry[tk->i_idxposc].i_length )
+                    avi_index_Length( &tk->idx, tk->i_idxposc ) )
             {
                 tk->i_idxposb = 0;
                 tk->i_idxposc++;
@@ -1472,7 +1544,7 @@ static int Demux_Seekable( demux_t *p_demux )
         if( tk->i_idxposc < tk->idx.i_size)
         {
             toread[i_track].i_posf =
-                tk->idx.p_entry[tk->i_idxposc].i_pos;
+                avi_index_Pos( &tk->idx, tk->i_idxposc );
             if( tk->i_idxposb > 0 )
             {
                 toread[i_track].i_posf += 8 + tk->i_idxposb;
@@ -1553,7 +1625,7 @@ static int Demux_UnSeekable( demux_t *p_demux )
 
         avi_packet_t    avi_pk;
 
-        if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+        if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
         {
             return VLC_DEMUXER_EOF;
         }
@@ -1570,18 +1642,18 @@ static int Demux_UnSeekable( demux_t *p_demux )
                 case AVIFOURCC_JUNK:
                 case AVIFOURCC_LIST:
                 case AVIFOURCC_RIFF:
-                    return( !AVI_PacketNext( p_demux ) ? 1 : 0 );
+                    return( !AVI_PacketNext( p_demux->s ) ? 1 : 0 );
                 case AVIFOURCC_idx1:
                     if( p_sys->b_odml )
                     {
-                        return( !AVI_PacketNext( p_demux ) ? 1 : 0 );
+                        return( !AVI_PacketNext( p_demux->s ) ? 1 : 0 );
                     }
                     return VLC_DEMUXER_EOF;
                 default:
                     msg_Warn( p_demux,
                               "seems to have lost position @%"PRIu64", resync",
                               vlc_stream_Tell(p_demux->s) );
-                    if( AVI_PacketSearch( p_demux ) )
+                    if( AVI_PacketSearch( p_demux, p_demux->s ) )
                     {
                         msg_Err( p_demux, "resync failed" );
                         return VLC_DEMUXER_EGENERIC;
@@ -1607,7 +1679,7 @@ static int Demux_UnSeekable( demux_t *p_demux )
             }
             else
             {
-                if( AVI_PacketNext( p_demux ) )
+                if( AVI_PacketNext( p_demux->s ) )
                 {
                     return VLC_DEMUXER_EOF;
                 }
@@ -1647,6 +1719,8 @@ static int Seek( demux_t *p_demux, vlc_tick_t i_date, int i_percent, bool b_accu
     {
         uint64_t i_pos_backup = vlc_stream_Tell( p_demux->s );
 
+        AVI_IndexMerge( p_demux );
+
         /* Check and lazy load indexes if it was not done (not fastseekable) */
         if ( !p_sys->b_indexloaded && ( p_sys->i_avih_flags & AVIF_HASINDEX ) )
         {
@@ -1716,8 +1790,8 @@ static int Seek( demux_t *p_demux, vlc_tick_t i_date, int i_percent, bool b_accu
                 goto failandresetpos;
             }
 
-            while( i_pos >= p_stream->idx.p_entry[p_stream->i_idxposc].i_pos +
-               p_stream->idx.p_entry[p_stream->i_idxposc].i_length + 8 )
+            while( i_pos >= avi_index_Pos( &p_stream->idx, p_stream->i_idxposc ) +
+               avi_index_Length( &p_stream->idx, p_stream->i_idxposc ) + 8 )
             {
                 /* search after i_idxposc */
                 if( AVI_StreamChunkSet( p_demux,
@@ -1985,12 +2059,12 @@ static vlc_tick_t AVI_GetPTS( avi_track_t *tk )
         {
             /* use the last entry */
             idx = tk->idx.i_size - 1;
-            i_count = tk->idx.p_entry[idx].i_lengthtotal
-                    + tk->idx.p_entry[idx].i_length;
+            i_count = avi_index_LengthTotal( &tk->idx, idx )
+                    + avi_index_Length( &tk->idx, idx );
         }
         else
         {
-            i_count = tk->idx.p_entry[idx].i_lengthtotal;
+            i_count = avi_index_LengthTotal( &tk->idx, idx );
         }
         return AVI_GetDPTS( tk, i_count + tk->i_idxposb );
     }
@@ -2012,7 +2086,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, avi_track_t *tk )
     if( p_sys->i_movi_lastchunk_pos >= p_sys->i_movi_begin + 12 )
     {
         vlc_stream_Seek( p_demux->s, p_sys->i_movi_lastchunk_pos );
-        if( AVI_PacketNext( p_demux ) )
+        if( AVI_PacketNext( p_demux->s ) )
         {
             return VLC_EGENERIC;
         }
@@ -2024,7 +2098,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, avi_track_t *tk )
 
     for( ;; )
     {
-        if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+        if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
         {
             msg_Warn( p_demux, "cannot get packet header" );
             return VLC_EGENERIC;
@@ -2032,7 +2106,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, avi_track_t *tk )
         if( avi_pk.i_stream >= p_sys->i_track ||
             ( avi_pk.i_cat != AUDIO_ES && avi_pk.i_cat != VIDEO_ES ) )
         {
-            if( AVI_PacketNext( p_demux ) )
+            if( AVI_PacketNext( p_demux->s ) )
             {
                 return VLC_EGENERIC;
             }
@@ -2054,11 +2128,9 @@ static int AVI_StreamChunkFind( demux_t *p_demux, avi_track_t *tk )
 
             /* add this chunk to the index */
             avi_entry_t index;
-            index.i_id     = avi_pk.i_fourcc;
             index.i_flags  = AVI_GetKeyFlag(tk_pk, avi_pk.i_peek);
             index.i_pos    = avi_pk.i_pos;
             index.i_length = avi_pk.i_size;
-            index.i_lengthtotal = index.i_length;
             avi_index_Append( &tk_pk->idx, &p_sys->i_movi_lastchunk_pos, &index );
 
             if( tk_pk == tk )
@@ -2066,7 +2138,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, avi_track_t *tk )
                 return VLC_SUCCESS;
             }
 
-            if( AVI_PacketNext( p_demux ) )
+            if( AVI_PacketNext( p_demux->s ) )
             {
                 return VLC_EGENERIC;
             }
@@ -2104,8 +2176,8 @@ static int AVI_StreamBytesSet( demux_t    *p_demux,
                                uint64_t  i_byte )
 {
     if( ( p_stream->idx.i_size > 0 )
-        &&( i_byte < p_stream->idx.p_entry[p_stream->idx.i_size - 1].i_lengthtotal +
-                p_stream->idx.p_entry[p_stream->idx.i_size - 1].i_length ) )
+        &&( i_byte < avi_index_LengthTotal( &p_stream->idx, p_stream->idx.i_size - 1 ) +
+                avi_index_Length( &p_stream->idx, p_stream->idx.i_size - 1 ) ) )
     {
         /* index is valid to find the ck */
         /* uses dichototmie to be fast enough */
@@ -2114,15 +2186,15 @@ static int AVI_StreamBytesSet( demux_t    *p_demux,
         int i_idxmin  = 0;
         for( ;; )
         {
-            if( p_stream->idx.p_entry[i_idxposc].i_lengthtotal > i_byte )
+            if( avi_index_LengthTotal( &p_stream->idx, i_idxposc ) > i_byte )
             {
                 i_idxmax  = i_idxposc ;
                 i_idxposc = ( i_idxmin + i_idxposc ) / 2 ;
             }
             else
             {
-                if( p_stream->idx.p_entry[i_idxposc].i_lengthtotal +
-                        p_stream->idx.p_entry[i_idxposc].i_length <= i_byte)
+                if( avi_index_LengthTotal( &p_stream->idx, i_idxposc ) +
+                        avi_index_Length( &p_stream->idx, i_idxposc ) <= i_byte)
                 {
                     i_idxmin  = i_idxposc ;
                     i_idxposc = (i_idxmax + i_idxposc ) / 2 ;
@@ -2131,7 +2203,7 @@ static int AVI_StreamBytesSet( demux_t    *p_demux,
                 {
                     p_stream->i_idxposc = i_idxposc;
                     p_stream->i_idxposb = i_byte -
-                            p_stream->idx.p_entry[i_idxposc].i_lengthtotal;
+                            avi_index_LengthTotal( &p_stream->idx, i_idxposc );
                     return VLC_SUCCESS;
                 }
             }
@@ -2150,11 +2222,11 @@ static int AVI_StreamBytesSet( demux_t    *p_demux,
                 return VLC_EGENERIC;
             }
 
-        } while( p_stream->idx.p_entry[p_stream->i_idxposc].i_lengthtotal +
-                    p_stream->idx.p_entry[p_stream->i_idxposc].i_length <= i_byte );
+        } while( avi_index_LengthTotal( &p_stream->idx, p_stream->i_idxposc ) +
+                    avi_index_Length( &p_stream->idx, p_stream->i_idxposc ) <= i_byte );
 
         p_stream->i_idxposb = i_byte -
-                       p_stream->idx.p_entry[p_stream->i_idxposc].i_lengthtotal;
+                       avi_index_LengthTotal( &p_stream->idx, p_stream->i_idxposc );
         return VLC_SUCCESS;
     }
 }
@@ -2186,7 +2258,7 @@ static int AVI_TrackSeek( demux_t *p_demux,
             {
                 tk->i_blockno = 0;
                 for( unsigned int i = 0; i < tk->i_idxposc; i++ )
-                    tk->i_blockno += ( tk->idx.p_entry[i].i_length + tk->i_blocksize - 1 ) / tk->i_blocksize;
+                    tk->i_blockno += ( avi_index_Length( &tk->idx, i ) + tk->i_blocksize - 1 ) / tk->i_blocksize;
             }
         }
 
@@ -2202,7 +2274,7 @@ static int AVI_TrackSeek( demux_t *p_demux,
             //if( i_date < i_oldpts || 1 )
             {
                 while( tk->i_idxposc > 0 &&
-                   !( tk->idx.p_entry[tk->i_idxposc].i_flags & AVIIF_KEYFRAME ) )
+                   !avi_index_IsKeyframe( &tk->idx, tk->i_idxposc ) )
                 {
                     if( AVI_StreamChunkSet( p_demux, tk, tk->i_idxposc - 1 ) )
                     {
@@ -2214,7 +2286,7 @@ static int AVI_TrackSeek( demux_t *p_demux,
             else
             {
                 while( tk->i_idxposc < tk->idx.i_size &&
-                        !( tk->idx.p_entry[tk->i_idxposc].i_flags & AVIIF_KEYFRAME ) )
+                        !avi_index_IsKeyframe( &tk->idx, tk->i_idxposc ) )
                 {
                     if( AVI_StreamChunkSet( p_demux, tk, tk->i_idxposc + 1 ) )
                     {
@@ -2348,17 +2420,17 @@ static void AVI_ParseStreamHeader( vlc_fourcc_t i_id,
 /****************************************************************************
  *
  ****************************************************************************/
-static int AVI_PacketGetHeader( demux_t *p_demux, avi_packet_t *p_pk )
+static int AVI_PacketGetHeader( stream_t *s, avi_packet_t *p_pk )
 {
     const uint8_t *p_peek;
 
-    if( vlc_stream_Peek( p_demux->s, &p_peek, 16 ) < 16 )
+    if( vlc_stream_Peek( s, &p_peek, 16 ) < 16 )
     {
         return VLC_EGENERIC;
     }
     p_pk->i_fourcc  = VLC_FOURCC( p_peek[0], p_peek[1], p_peek[2], p_peek[3] );
     p_pk->i_size    = GetDWLE( p_peek + 4 );
-    p_pk->i_pos     = vlc_stream_Tell( p_demux->s );
+    p_pk->i_pos     = vlc_stream_Tell( s );
     if( p_pk->i_fourcc == AVIFOURCC_LIST || p_pk->i_fourcc == AVIFOURCC_RIFF )
     {
         p_pk->i_type = VLC_FOURCC( p_peek[8],  p_peek[9],
@@ -2375,12 +2447,12 @@ static int AVI_PacketGetHeader( demux_t *p_demux, avi_packet_t *p_pk )
     return VLC_SUCCESS;
 }
 
-static int AVI_PacketNext( demux_t *p_demux )
+static int AVI_PacketNext( stream_t *s )
 {
     avi_packet_t    avi_ck;
     size_t          i_skip = 0;
 
-    if( AVI_PacketGetHeader( p_demux, &avi_ck ) )
+    if( AVI_PacketGetHeader( s, &avi_ck ) )
     {
         return VLC_EGENERIC;
     }
@@ -2405,7 +2477,7 @@ static int AVI_PacketNext( demux_t *p_demux )
     if( i_skip > SSIZE_MAX )
         return VLC_EGENERIC;
 
-    ssize_t i_ret = vlc_stream_Read( p_demux->s, NULL, i_skip );
+    ssize_t i_ret = vlc_stream_Read( s, NULL, i_skip );
     if( i_ret < 0 || (size_t) i_ret != i_skip )
     {
         return VLC_EGENERIC;
@@ -2413,7 +2485,7 @@ static int AVI_PacketNext( demux_t *p_demux )
     return VLC_SUCCESS;
 }
 
-static int AVI_PacketSearch( demux_t *p_demux )
+static int AVI_PacketSearch( demux_t *p_demux, stream_t *s )
 {
     demux_sys_t     *p_sys = p_demux->p_sys;
     avi_packet_t    avi_pk;
@@ -2421,11 +2493,11 @@ static int AVI_PacketSearch( demux_t *p_demux )
 
     for( ;; )
     {
-        if( vlc_stream_Read( p_demux->s, NULL, 1 ) != 1 )
+        if( vlc_stream_Read( s, NULL, 1 ) != 1 )
         {
             return VLC_EGENERIC;
         }
-        AVI_PacketGetHeader( p_demux, &avi_pk );
+        AVI_PacketGetHeader( s, &avi_pk );
         if( avi_pk.i_stream < p_sys->i_track &&
             ( avi_pk.i_cat == AUDIO_ES || avi_pk.i_cat == VIDEO_ES ) )
         {
@@ -2460,16 +2532,19 @@ static void avi_index_Init( avi_index_t *p_index )
 {
     p_index->i_size  = 0;
     p_index->i_max   = 0;
-    p_index->p_entry = NULL;
+    p_index->p_block = NULL;
 }
 static void avi_index_Clean( avi_index_t *p_index )
 {
-    free( p_index->p_entry );
+    for( uint32_t i = 0; i < p_index->i_max / AVI_INDEX_BLOCK; i++ )
+        free( p_index->p_block[i].p_pos );
+    free( p_index->p_block );
 }
-#define MAX_INDEX_ENTRIES __MIN(SIZE_MAX/sizeof(avi_entry_t), UINT32_MAX)
+#define MAX_INDEX_ENTRIES __MIN(SIZE_MAX/sizeof(avi_index_block_t)*AVI_INDEX_BLOCK, \
+                                UINT32_MAX/AVI_INDEX_BLOCK*AVI_INDEX_BLOCK)
 #define INDEX_EXTENT 16384
 static int64_t avi_index_Append( avi_index_t *p_index, uint64_t *pi_last_pos,
-                                 avi_entry_t *p_entry )
+                                 const avi_entry_t *p_entry )
 {
     /* Update last chunk position */
     if( *pi_last_pos < p_entry->i_pos )
@@ -2481,32 +2556,60 @@ static int64_t avi_index_Append( avi_index_t *p_index, uint64_t *pi_last_pos,
     /* add the entry */
     if( p_index->i_size >= p_index->i_max )
     {
+        uint32_t i_max;
         if( MAX_INDEX_ENTRIES - INDEX_EXTENT > p_index->i_max )
-            p_index->i_max += INDEX_EXTENT;
+            i_max = p_index->i_max + INDEX_EXTENT;
         else
-            p_index->i_max = MAX_INDEX_ENTRIES;
-        p_index->p_entry = realloc_or_free( p_index->p_entry,
-                                            p_index->i_max * sizeof(avi_entry_t) );
-        if( !p_index->p_entry )
+            i_max = MAX_INDEX_ENTRIES;
+        avi_index_block_t *p_block =
+            realloc( p_index->p_block,
+                     i_max / AVI_INDEX_BLOCK * sizeof(avi_index_block_t) );
+        if( !p_block )
         {
+            avi_index_Clean( p_index );
             avi_index_Init( p_index );
             return -1;
         }
+        for( uint32_t i = p_index->i_max / AVI_INDEX_BLOCK;
+             i < i_max / AVI_INDEX_BLOCK; i++ )
+            p_block[i].p_pos = NULL;
+        p_index->p_block = p_block;
+        p_index->i_max = i_max;
     }
-    /* calculate cumulate length */
-    if( p_index->i_size > 0 )
+
+    const uint32_t i = p_index->i_size % AVI_INDEX_BLOCK;
+    avi_index_block_t *p_block = &p_index->p_block[p_index->i_size / AVI_INDEX_BLOCK];
+
+    if( i == 0 )
     {
-        p_entry->i_lengthtotal =
-            p_index->p_entry[p_index->i_size - 1].i_length +
-                p_index->p_entry[p_index->i_size - 1].i_lengthtotal;
+        /* calculate cumulate length */
+        p_block->i_lengthtotal = p_index->i_size > 0 ?
+            avi_index_LengthTotal( p_index, p_index->i_size - 1 ) +
+            avi_index_Length( p_index, p_index->i_size - 1 ) : 0;
+        p_block->i_pos = p_entry->i_pos;
+        p_block->i_keyframes = 0;
     }
-    else
+
+    /* idx1 positions are not always increasing, nor close to each other */
+    if( !p_block->p_pos && ( p_entry->i_pos < p_block->i_pos ||
+                             p_entry->i_pos - p_block->i_pos > UINT32_MAX ) )
     {
-        p_entry->i_lengthtotal = 0;
+        p_block->p_pos = vlc_alloc( AVI_INDEX_BLOCK, sizeof(*p_block->p_pos) );
+        if( !p_block->p_pos )
+            return -1;
+        for( uint32_t j = 0; j < i; j++ )
+            p_block->p_pos[j] = p_block->i_pos + p_block->i_delta[j];
     }
 
-    p_index->p_entry[p_index->i_size++] = *p_entry;
-    return p_index->i_size - 1;
+    if( p_block->p_pos )
+        p_block->p_pos[i] = p_entry->i_pos;
+    else
+        p_block->i_delta[i] = p_entry->i_pos - p_block->i_pos;
+    p_block->i_length[i] = p_entry->i_length;
+    if( p_entry->i_flags & AVIIF_KEYFRAME )
+        p_block->i_keyframes |= UINT64_C(1) << i;
+
+    return p_index->i_size++;
 }
 
 static int AVI_IndexFind_idx1( demux_t *p_demux,
@@ -2598,11 +2701,9 @@ static int AVI_IndexLoad_idx1( demux_t *p_demux,
             (i_cat == p_sys->track[i_stream]->fmt.i_cat || i_cat == UNKNOWN_ES ) )
         {
             avi_entry_t index;
-            index.i_id     = p_idx1->entry[i_index].i_fourcc;
             index.i_flags  = p_idx1->entry[i_index].i_flags&(~AVIIF_FIXKEYFRAME);
             index.i_pos    = p_idx1->entry[i_index].i_pos + i_offset;
             index.i_length = p_idx1->entry[i_index].i_length;
-            index.i_lengthtotal = index.i_length;
 
             avi_index_Append( &p_index[i_stream], pi_last_offset, &index );
         }
@@ -2617,14 +2718,14 @@ static int AVI_IndexLoad_idx1( demux_t *p_demux,
             if( p_sys->track[i_index]->i_samplesize )
             {
                 i_length = AVI_GetDPTS( p_sys->track[i_index],
-                                        p_index[i_index].p_entry[i].i_lengthtotal );
+                                        avi_index_LengthTotal( &p_index[i_index], i ) );
             }
             else
             {
                 i_length = AVI_GetDPTS( p_sys->track[i_index], i );
             }
             msg_Dbg( p_demux, "index stream %d @%ld time %ld", i_index,
-                     p_index[i_index].p_entry[i].i_pos, i_length );
+                     avi_index_Pos( &p_index[i_index], i ), i_length );
         }
     }
 #endif
@@ -2643,11 +2744,9 @@ static void __Parse_indx( demux_t *p_demux, avi_index_t *p_index, uint64_t *pi_m
     {
         for( unsigned i = 0; i < p_indx->i_entriesinuse; i++ )
         {
-            index.i_id     = p_indx->i_id;
             index.i_flags  = p_indx->idx.std[i].i_size & 0x80000000 ? 0 : AVIIF_KEYFRAME;
             index.i_pos    = p_indx->i_baseoffset + p_indx->idx.std[i].i_offset - 8;
             index.i_length = p_indx->idx.std[i].i_size&0x7fffffff;
-            index.i_lengthtotal = index.i_length;
 
             avi_index_Append( p_index, pi_max_offset, &index );
         }
@@ -2656,11 +2755,9 @@ static void __Parse_indx( demux_t *p_demux, avi_index_t *p_index, uint64_t *pi_m
     {
         for( unsigned i = 0; i < p_indx->i_entriesinuse; i++ )
         {
-            index.i_id     = p_indx->i_id;
             index.i_flags  = p_indx->idx.field[i].i_size & 0x80000000 ? 0 : AVIIF_KEYFRAME;
             index.i_pos    = p_indx->i_baseoffset + p_indx->idx.field[i].i_offset - 8;
             index.i_length = p_indx->idx.field[i].i_size;
-            index.i_lengthtotal = index.i_length;
 
             avi_index_Append( p_index, pi_max_offset, &index );
         }
@@ -2772,13 +2869,17 @@ static void AVI_IndexLoad( demux_t *p_demux )
 
         /* Fix key flag */
         bool b_key = false;
-        for( unsigned j = 0; !b_key && j < p_index->i_size; j++ )
-            b_key = p_index->p_entry[j].i_flags & AVIIF_KEYFRAME;
+        for( unsigned j = 0; !b_key && j < p_index->i_size; j += AVI_INDEX_BLOCK )
+            b_key = p_index->p_block[j / AVI_INDEX_BLOCK].i_keyframes != 0;
         if( !b_key )
         {
             msg_Warn( p_demux, "no key frame set for track %u", i );
-            for( unsigned j = 0; j < p_index->i_size; j++ )
-                p_index->p_entry[j].i_flags |= AVIIF_KEYFRAME;
+            for( unsigned j = 0; j < p_index->i_size; j += AVI_INDEX_BLOCK )
+            {
+                unsigned i_count = __MIN( p_index->i_size - j, AVI_INDEX_BLOCK );
+                p_index->p_block[j / AVI_INDEX_BLOCK].i_keyframes =
+                    UINT64_MAX >> (AVI_INDEX_BLOCK - i_count);
+            }
         }
 
         /* */
@@ -2787,41 +2888,18 @@ static void AVI_IndexLoad( demux_t *p_demux )
     }
 }
 
-static void AVI_IndexCreate( demux_t *p_demux )
+static void AVI_IndexScan( demux_t *p_demux, stream_t *s, uint64_t i_movi_end,
+                           uint64_t i_riffx_pos, avi_index_builder_t *p_builder )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
-    avi_chunk_list_t *p_riff;
-    avi_chunk_list_t *p_movi;
-
-    unsigned int i_stream;
-    uint32_t i_movi_end;
-
     vlc_tick_t i_dialog_update;
     vlc_dialog_id *p_dialog_id = NULL;
-
-    p_riff = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_RIFF, 0, true );
-    p_movi = AVI_ChunkFind( p_riff, AVIFOURCC_movi, 0, true );
-
-    if( !p_movi )
-    {
-        msg_Err( p_demux, "cannot find p_movi" );
-        return;
-    }
-
-    for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
-        avi_index_Init( &p_sys->track[i_stream]->idx );
-
-    i_movi_end = __MIN( (uint32_t)(p_movi->i_chunk_pos + p_movi->i_chunk_size),
-                        stream_Size( p_demux->s ) );
-
-    vlc_stream_Seek( p_demux->s, p_movi->i_chunk_pos + 12 );
-    msg_Warn( p_demux, "creating index from LIST-movi, will take time !" );
-
+    uint64_t i_pending_pos = 0;
 
     /* Only show dialog if AVI is > 10MB */
     i_dialog_update = mdate();
-    if( stream_Size( p_demux->s ) > 10000000 )
+    if( stream_Size( s ) > 10000000 )
     {
         p_dialog_id =
             vlc_dialog_display_progress( p_demux, false, 0.0, _("Cancel"),
@@ -2833,21 +2911,24 @@ static void AVI_IndexCreate( demux_t *p_demux )
     {
         avi_packet_t pk;
 
+        if( p_builder && atomic_load( &p_builder->b_stop ) )
+            break;
+
         /* Don't update/check dialog too often */
         if( p_dialog_id != NULL && mdate() - i_dialog_update > 100000 )
         {
             if( vlc_dialog_is_cancelled( p_demux, p_dialog_id ) )
                 break;
 
-            double f_current = vlc_stream_Tell( p_demux->s );
-            double f_size    = stream_Size( p_demux->s );
+            double f_current = vlc_stream_Tell( s );
+            double f_size    = stream_Size( s );
             double f_pos     = f_current / f_size;
             vlc_dialog_update_progress( p_demux, p_dialog_id, f_pos );
 
             i_dialog_update = mdate();
         }
 
-        if( AVI_PacketGetHeader( p_demux, &pk ) )
+        if( AVI_PacketGetHeader( s, &pk ) )
             break;
 
         if( pk.i_stream < p_sys->i_track &&
@@ -2856,12 +2937,18 @@ static void AVI_IndexCreate( demux_t *p_demux )
             avi_track_t *tk = p_sys->track[pk.i_stream];
 
             avi_entry_t index;
-            index.i_id      = pk.i_fourcc;
             index.i_flags   = AVI_GetKeyFlag(tk, pk.i_peek);
             index.i_pos     = pk.i_pos;
             index.i_length  = pk.i_size;
-            index.i_lengthtotal = pk.i_size;
-            avi_index_Append( &tk->idx, &p_sys->i_movi_lastchunk_pos, &index );
+            if( p_builder )
+            {
+                vlc_mutex_lock( &p_builder->lock );
+                avi_index_Append( &p_builder->p_pending[pk.i_stream],
+                                  &i_pending_pos, &index );
+                vlc_mutex_unlock( &p_builder->lock );
+            }
+            else
+                avi_index_Append( &tk->idx, &p_sys->i_movi_lastchunk_pos, &index );
         }
         else
         {
@@ -2870,13 +2957,8 @@ static void AVI_IndexCreate( demux_t *p_demux )
             case AVIFOURCC_idx1:
                 if( p_sys->b_odml )
                 {
-                    avi_chunk_list_t *p_sysx;
-                    p_sysx = AVI_ChunkFind( &p_sys->ck_root,
-                                            AVIFOURCC_RIFF, 1, true );
-
                     msg_Dbg( p_demux, "looking for new RIFF chunk" );
-                    if( !p_sysx || vlc_stream_Seek( p_demux->s,
-                                         p_sysx->i_chunk_pos + 24 ) )
+                    if( !i_riffx_pos || vlc_stream_Seek( s, i_riffx_pos + 24 ) )
                         goto print_stat;
                     break;
                 }
@@ -2892,7 +2974,7 @@ static void AVI_IndexCreate( demux_t *p_demux )
 
             default:
                 msg_Warn( p_demux, "need resync, probably broken avi" );
-                if( AVI_PacketSearch( p_demux ) )
+                if( AVI_PacketSearch( p_demux, s ) )
                 {
                     msg_Warn( p_demux, "lost sync, abord index creation" );
                     goto print_stat;
@@ -2901,7 +2983,7 @@ static void AVI_IndexCreate( demux_t *p_demux )
         }
 
         if( ( !p_sys->b_odml && pk.i_pos + pk.i_size >= i_movi_end ) ||
-            AVI_PacketNext( p_demux ) )
+            AVI_PacketNext( s ) )
         {
             break;
         }
@@ -2910,6 +2992,194 @@ static void AVI_IndexCreate( demux_t *p_demux )
 print_stat:
     if( p_dialog_id != NULL )
         vlc_dialog_release( p_demux, p_dialog_id );
+}
+
+static void *AVI_IndexThread( void *data )
+{
+    demux_t *p_demux = data;
+    avi_index_builder_t *p_builder = p_demux->p_sys->p_builder;
+
+    AVI_IndexScan( p_demux, p_builder->s, p_builder->i_movi_end,
+                   p_builder->i_riffx_pos, p_builder );
+
+    vlc_mutex_lock( &p_builder->lock );
+    p_builder->b_done = true;
+    vlc_mutex_unlock( &p_builder->lock );
+    return NULL;
+}
+
+static int AVI_IndexStart( demux_t *p_demux, uint64_t i_movi_pos,
+                           uint64_t i_movi_end, uint64_t i_riffx_pos )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !p_demux->psz_access || !p_demux->psz_location )
+        return VLC_EGENERIC;
+
+    avi_index_builder_t *p_builder = malloc( sizeof(*p_builder) );
+    if( !p_builder )
+        return VLC_ENOMEM;
+
+    p_builder->p_pending = vlc_alloc( p_sys->i_track, sizeof(avi_index_t) );
+    if( !p_builder->p_pending )
+    {
+        free( p_builder );
+        return VLC_ENOMEM;
+    }
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+        avi_index_Init( &p_builder->p_pending[i] );
+
+    /* Scan through a stream of our own, so that playback is not disturbed */
+    char *psz_url;
+    if( asprintf( &psz_url, "%s://%s", p_demux->psz_access,
+                  p_demux->psz_location ) == -1 )
+        psz_url = NULL;
+    p_builder->s = psz_url ? vlc_stream_NewURL( p_demux, psz_url ) : NULL;
+    free( psz_url );
+    if( !p_builder->s ||
+        stream_Size( p_builder->s ) != stream_Size( p_demux->s ) ||
+        vlc_stream_Seek( p_builder->s, i_movi_pos + 12 ) )
+        goto error;
+
+    vlc_mutex_init( &p_builder->lock );
+    atomic_init( &p_builder->b_stop, false );
+    p_builder->b_done = false;
+    p_builder->i_movi_end = i_movi_end;
+    p_builder->i_riffx_pos = i_riffx_pos;
+
+    p_sys->p_builder = p_builder;
+    if( vlc_clone( &p_builder->thread, AVI_IndexThread, p_demux,
+                   VLC_THREAD_PRIORITY_LOW ) )
+    {
+        p_sys->p_builder = NULL;
+        vlc_mutex_destroy( &p_builder->lock );
+        goto error;
+    }
+    return VLC_SUCCESS;
+
+error:
+    if( p_builder->s )
+        vlc_stream_Delete( p_builder->s );
+    free( p_builder->p_pending );
+    free( p_builder );
+    return VLC_EGENERIC;
+}
+
+static void AVI_IndexStop( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    avi_index_builder_t *p_builder = p_sys->p_builder;
+
+    if( !p_builder )
+        return;
+
+    atomic_store( &p_builder->b_stop, true );
+    vlc_join( p_builder->thread, NULL );
+
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+        avi_index_Clean( &p_builder->p_pending[i] );
+    free( p_builder->p_pending );
+    vlc_stream_Delete( p_builder->s );
+    vlc_mutex_destroy( &p_builder->lock );
+    free( p_builder );
+    p_sys->p_builder = NULL;
+}
+
+/* Moves the entries found in the background to the track indexes.
+ * Both only grow from the last known chunk on, in file order, so that the
+ * entries already indexed while playing are simply skipped. */
+static void AVI_IndexMerge( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    avi_index_builder_t *p_builder = p_sys->p_builder;
+
+    if( !p_builder )
+        return;
+
+    vlc_mutex_lock( &p_builder->lock );
+    const uint64_t i_known_pos = p_sys->i_movi_lastchunk_pos;
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_index_t *p_pending = &p_builder->p_pending[i];
+
+        for( uint32_t j = 0; j < p_pending->i_size; j++ )
+        {
+            avi_entry_t index;
+            index.i_pos = avi_index_Pos( p_pending, j );
+            if( index.i_pos <= i_known_pos )
+                continue;
+            index.i_flags = avi_index_IsKeyframe( p_pending, j ) ? AVIIF_KEYFRAME : 0;
+            index.i_length = avi_index_Length( p_pending, j );
+            avi_index_Append( &p_sys->track[i]->idx,
+                              &p_sys->i_movi_lastchunk_pos, &index );
+        }
+        avi_index_Clean( p_pending );
+        avi_index_Init( p_pending );
+    }
+    const bool b_done = p_builder->b_done;
+    vlc_mutex_unlock( &p_builder->lock );
+
+    if( b_done )
+    {
+        AVI_IndexStop( p_demux );
+
+        for( unsigned i = 0; i < p_sys->i_track; i++ )
+        {
+            msg_Dbg( p_demux, "stream[%d] created %d index entries",
+                     i, p_sys->track[i]->idx.i_size );
+        }
+        p_sys->i_length = AVI_MovieGetLength( p_demux );
+    }
+}
+
+static void AVI_IndexCreate( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    avi_chunk_list_t *p_riff;
+    avi_chunk_list_t *p_movi;
+
+    unsigned int i_stream;
+    uint32_t i_movi_end;
+
+    p_riff = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_RIFF, 0, true );
+    p_movi = AVI_ChunkFind( p_riff, AVIFOURCC_movi, 0, true );
+
+    if( !p_movi )
+    {
+        msg_Err( p_demux, "cannot find p_movi" );
+        return;
+    }
+
+    for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
+    {
+        avi_index_Clean( &p_sys->track[i_stream]->idx );
+        avi_index_Init( &p_sys->track[i_stream]->idx );
+    }
+    p_sys->i_movi_lastchunk_pos = 0;
+
+    i_movi_end = __MIN( (uint32_t)(p_movi->i_chunk_pos + p_movi->i_chunk_size),
+                        stream_Size( p_demux->s ) );
+
+    avi_chunk_list_t *p_riffx = AVI_ChunkFind( &p_sys->ck_root,
+                                               AVIFOURCC_RIFF, 1, true );
+    uint64_t i_riffx_pos = p_riffx ? p_riffx->i_chunk_pos : 0;
+
+    if( AVI_IndexStart( p_demux, p_movi->i_chunk_pos, i_movi_end,
+                        i_riffx_pos ) == VLC_SUCCESS )
+    {
+        msg_Dbg( p_demux, "creating index from LIST-movi in the background" );
+        return;
+    }
+
+    if( vlc_stream_Seek( p_demux->s, p_movi->i_chunk_pos + 12 ) )
+    {
+        msg_Err( p_demux, "cannot seek to LIST-movi" );
+        return;
+    }
+    msg_Warn( p_demux, "creating index from LIST-movi, will take time !" );
+
+    AVI_IndexScan( p_demux, p_demux->s, i_movi_end, i_riffx_pos, NULL );
 
     for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
     {
@@ -3204,7 +3474,7 @@ static vlc_tick_t  AVI_MovieGetLength( demux_t *p_demux )
         vlc_tick_t i_length;
 
         /* fix length for each stream */
-        if( tk->idx.i_size < 1 || !tk->idx.p_entry )
+        if( tk->idx.i_size < 1 )
         {
             continue;
         }
@@ -3212,8 +3482,8 @@ static vlc_tick_t  AVI_MovieGetLength( demux_t *p_demux )
         if( tk->i_samplesize )
         {
             i_length = AVI_GetDPTS( tk,
-                                    tk->idx.p_entry[tk->idx.i_size-1].i_lengthtotal +
-                                        tk->idx.p_entry[tk->idx.i_size-1].i_length );
+                                    avi_index_LengthTotal( &tk->idx, tk->idx.i_size-1 ) +
+                                        avi_index_Length( &tk->idx, tk->idx.i_size-1 ) );
         }
         else
         {
@@ -57,10 +57,13 @@ DASHManager::DASHManager(demux_t *demux_,
                          AbstractAdaptationLogic::LogicType type) :
              PlaylistManager(demux_, res, mpd, factory, type)
 {
+    lastmpd = nullptr;
 }
 
 DASHManager::~DASHManager   ()
 {
+    if(lastmpd)
+        block_Release(lastmpd);
 }
 
 void DASHManager::scheduleNextUpdate()
@@ -101,6 +104,14 @@ bool DASHManager::updatePlaylist()
         if(!p_block)
             return false;
 
+        /* Nothing new, no need to parse and merge it again */
+        if(lastmpd && lastmpd->i_buffer == p_block->i_buffer &&
+           !memcmp(lastmpd->p_buffer, p_block->p_buffer, p_block->i_buffer))
+        {
+            block_Release(p_block);
+            return true;
+        }
+
         stream_t *mpdstream = vlc_stream_MemoryNew(p_demux, p_block->p_buffer, p_block->i_buffer, true);
         if(!mpdstream)
         {
@@ -125,7 +136,9 @@ bool DASHManager::updatePlaylist()
             delete newmpd;
         }
         vlc_stream_Delete(mpdstream);
-        block_Release(p_block);
+        if(lastmpd)
+            block_Release(lastmpd);
+        lastmpd = p_block;
     }
 
     return true;
@@ -59,6 +59,9 @@ namespace dash
 
         protected:
             virtual int doControl(int, va_list) override;
+
+        private:
+            block_t *lastmpd; /* previous manifest, to skip unchanged updates */
     };
 
 }
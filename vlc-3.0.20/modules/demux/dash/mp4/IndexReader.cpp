@@ -29,6 +29,8 @@ using namespace adaptive::mp4;
 using namespace dash::mp4;
 using namespace dash::mpd;
 
+#define SUBSEGMENT_MIN_DURATION (CLOCK_FREQ / 2)
+
 IndexReader::IndexReader(vlc_object_t *obj)
     : AtomsReader(obj)
 {
@@ -46,16 +48,23 @@ bool IndexReader::parseIndex(block_t *p_block, BaseRepresentation *rep, uint64_t
         std::vector<Representation::SplitPoint> splitlist;
         MP4_Box_data_sidx_t *sidx = sidxbox->data.p_sidx;
         /* sidx refers to offsets from end of sidx pos in the file + first offset */
-        point.offset = sidx->i_first_offset + i_fileoffset + sidxbox->i_pos + sidxbox->i_size;
-        point.time = 0;
+        uint64_t offset = sidx->i_first_offset + i_fileoffset + sidxbox->i_pos + sidxbox->i_size;
+        stime_t time = 0;
         if(!sidx->i_timescale)
             return false;
+        /* Merge short subsegments, as each one costs a request */
+        const stime_t minduration = Timescale(sidx->i_timescale).ToScaled(SUBSEGMENT_MIN_DURATION);
         for(uint16_t i=0; i<sidx->i_reference_count; i++)
         {
-            splitlist.push_back(point);
-            point.offset += sidx->p_items[i].i_referenced_size;
-            point.duration = sidx->p_items[i].i_subsegment_duration;
-            point.time += point.duration;
+            if(splitlist.empty() || time - splitlist.back().time >= minduration)
+            {
+                point.offset = offset;
+                point.duration = splitlist.empty() ? 0 : time - splitlist.back().time;
+                point.time = time;
+                splitlist.push_back(point);
+            }
+            offset += sidx->p_items[i].i_referenced_size;
+            time += sidx->p_items[i].i_subsegment_duration;
         }
         rep->replaceAttribute(new TimescaleAttr(Timescale(sidx->i_timescale)));
         rep->SplitUsingIndex(splitlist);
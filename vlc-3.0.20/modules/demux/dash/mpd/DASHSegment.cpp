@@ -38,23 +38,47 @@ using namespace dash::mp4;
 DashIndexChunk::DashIndexChunk(AbstractChunkSource *source, BaseRepresentation *rep)
     : SegmentChunk(source, rep)
 {
-
+    p_head = nullptr;
+    pp_tail = &p_head;
+    parsed = false;
 }
 
 DashIndexChunk::~DashIndexChunk()
 {
-
+    block_ChainRelease(p_head);
 }
 
 void DashIndexChunk::onDownload(block_t **pp_block)
 {
     decrypt(pp_block);
 
-    if(!rep || ((*pp_block)->i_flags & BLOCK_FLAG_HEADER) == 0 )
+    if(!rep || parsed)
         return;
 
+    /* index can span multiple blocks, when fetched along with init */
+    if(((*pp_block)->i_flags & BLOCK_FLAG_HEADER) == 0 || hasMoreData())
+    {
+        block_t *p_dup = block_Duplicate(*pp_block);
+        if(p_dup)
+            block_ChainLastAppend(&pp_tail, p_dup);
+        if(hasMoreData())
+            return;
+    }
+
+    parsed = true;
     IndexReader br(rep->getPlaylist()->getVLCObject());
-    br.parseIndex(*pp_block, rep, getStartByteInFile());
+    if(p_head)
+    {
+        block_t *p_index = block_ChainGather(p_head);
+        p_head = nullptr;
+        pp_tail = &p_head;
+        if(p_index)
+        {
+            br.parseIndex(p_index, rep, getStartByteInFile());
+            block_Release(p_index);
+        }
+    }
+    else br.parseIndex(*pp_block, rep, getStartByteInFile());
 }
 
 DashIndexSegment::DashIndexSegment(ICanonicalUrl *parent) :
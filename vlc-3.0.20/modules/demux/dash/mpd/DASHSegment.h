@@ -41,6 +41,11 @@ namespace dash
                 DashIndexChunk(AbstractChunkSource *, BaseRepresentation *);
                 ~DashIndexChunk();
                 virtual void onDownload(block_t **) override;
+
+            private:
+                block_t *p_head;
+                block_t **pp_tail;
+                bool parsed;
         };
 
         class DashIndexSegment : public IndexSegment
@@ -98,6 +98,7 @@ MPD * IsoffMainParser::parse()
     {
         parseMPDAttributes(mpd, root);
         parseProgramInformation(DOMHelper::getFirstChildElementByName(root, "ProgramInformation"), mpd);
+        parseServiceDescription(DOMHelper::getFirstChildElementByName(root, "ServiceDescription"), mpd);
         parseMPDBaseUrl(mpd, root);
         parsePeriods(mpd, root);
         mpd->addAttribute(new StartnumberAttr(1));
@@ -108,49 +109,36 @@ MPD * IsoffMainParser::parse()
 
 void    IsoffMainParser::parseMPDAttributes   (MPD *mpd, xml::Node *node)
 {
-    const std::map<std::string, std::string> & attr = node->getAttributes();
+    if(node->hasAttribute("mediaPresentationDuration"))
+        mpd->duration.Set(IsoTime(node->getAttributeValue("mediaPresentationDuration")));
 
-    std::map<std::string, std::string>::const_iterator it;
+    if(node->hasAttribute("minBufferTime"))
+        mpd->setMinBuffering(IsoTime(node->getAttributeValue("minBufferTime")));
 
-    it = attr.find("mediaPresentationDuration");
-    if(it != attr.end())
-        mpd->duration.Set(IsoTime(it->second));
-
-    it = attr.find("minBufferTime");
-    if(it != attr.end())
-        mpd->setMinBuffering(IsoTime(it->second));
-
-    it = attr.find("minimumUpdatePeriod");
-    if(it != attr.end())
+    if(node->hasAttribute("minimumUpdatePeriod"))
     {
-        vlc_tick_t minupdate = IsoTime(it->second);
+        vlc_tick_t minupdate = IsoTime(node->getAttributeValue("minimumUpdatePeriod"));
         if(minupdate > 0)
             mpd->minUpdatePeriod.Set(minupdate);
     }
 
-    it = attr.find("maxSegmentDuration");
-    if(it != attr.end())
-        mpd->maxSegmentDuration.Set(IsoTime(it->second));
+    if(node->hasAttribute("maxSegmentDuration"))
+        mpd->maxSegmentDuration.Set(IsoTime(node->getAttributeValue("maxSegmentDuration")));
 
-    it = attr.find("type");
-    if(it != attr.end())
-        mpd->setType(it->second);
+    if(node->hasAttribute("type"))
+        mpd->setType(node->getAttributeValue("type"));
 
-    it = attr.find("availabilityStartTime");
-    if(it != attr.end())
-        mpd->availabilityStartTime.Set(UTCTime(it->second).mtime());
+    if(node->hasAttribute("availabilityStartTime"))
+        mpd->availabilityStartTime.Set(UTCTime(node->getAttributeValue("availabilityStartTime")).mtime());
 
-    it = attr.find("availabilityEndTime");
-    if(it != attr.end())
-        mpd->availabilityEndTime.Set(UTCTime(it->second).mtime());
+    if(node->hasAttribute("availabilityEndTime"))
+        mpd->availabilityEndTime.Set(UTCTime(node->getAttributeValue("availabilityEndTime")).mtime());
 
-    it = attr.find("timeShiftBufferDepth");
-        if(it != attr.end())
-            mpd->timeShiftBufferDepth.Set(IsoTime(it->second));
+    if(node->hasAttribute("timeShiftBufferDepth"))
+        mpd->timeShiftBufferDepth.Set(IsoTime(node->getAttributeValue("timeShiftBufferDepth")));
 
-    it = attr.find("suggestedPresentationDelay");
-    if(it != attr.end())
-        mpd->suggestedPresentationDelay.Set(IsoTime(it->second));
+    if(node->hasAttribute("suggestedPresentationDelay"))
+        mpd->suggestedPresentationDelay.Set(IsoTime(node->getAttributeValue("suggestedPresentationDelay")));
 }
 
 void IsoffMainParser::parsePeriods(MPD *mpd, Node *root)
@@ -185,7 +173,8 @@ void IsoffMainParser::parseSegmentBaseType(MPD *, Node *node,
                                            AbstractSegmentBaseType *base,
                                            SegmentInformation *parent)
 {
-    parseInitSegment(DOMHelper::getFirstChildElementByName(node, "Initialization"), base, parent);
+    Node *initNode = DOMHelper::getFirstChildElementByName(node, "Initialization");
+    parseInitSegment(initNode, base, parent);
 
     if(node->hasAttribute("indexRange"))
     {
@@ -195,7 +184,14 @@ void IsoffMainParser::parseSegmentBaseType(MPD *, Node *node,
             IndexSegment *index = new (std::nothrow) DashIndexSegment(parent);
             if(index)
             {
-                index->setByteRange(start, end);
+                /* Contiguous init and index ranges from the same file are
+                 * fetched with a single request */
+                InitSegment *init = base->initialisationSegment.Get();
+                if(init && start > 0 && !initNode->hasAttribute("sourceURL") &&
+                   init->contains(start - 1) && !init->contains(start))
+                    index->setByteRange(init->getOffset(), end);
+                else
+                    index->setByteRange(start, end);
                 base->indexSegment.Set(index);
                 /* index must be before data, so data starts at index end */
                 if(dynamic_cast<SegmentBase *>(base))
@@ -570,6 +566,29 @@ void IsoffMainParser::parseProgramInformation(Node * node, MPD *mpd)
     }
 }
 
+void IsoffMainParser::parseServiceDescription(Node * node, MPD *mpd)
+{
+    if(!node)
+        return;
+
+    Node *child = DOMHelper::getFirstChildElementByName(node, "Latency");
+    if(child && child->hasAttribute("target"))
+    {
+        /* milliseconds */
+        uint64_t target = Integer<uint64_t>(child->getAttributeValue("target"));
+        mpd->targetLatency.Set(CLOCK_FREQ / 1000 * target);
+    }
+
+    child = DOMHelper::getFirstChildElementByName(node, "PlaybackRate");
+    if(child)
+    {
+        if(child->hasAttribute("min"))
+            mpd->minPlaybackRate.Set(Integer<double>(child->getAttributeValue("min")));
+        if(child->hasAttribute("max"))
+            mpd->maxPlaybackRate.Set(Integer<double>(child->getAttributeValue("max")));
+    }
+}
+
 Profile IsoffMainParser::getProfile() const
 {
     Profile res(Profile::Name::Unknown);
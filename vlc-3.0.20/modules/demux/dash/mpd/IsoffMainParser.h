@@ -82,6 +82,7 @@ namespace dash
                 size_t  parseSegmentList    (MPD *, xml::Node *, SegmentInformation *);
                 size_t  parseSegmentTemplate(MPD *, xml::Node *, SegmentInformation *);
                 void    parseProgramInformation(xml::Node *, MPD *);
+                void    parseServiceDescription(xml::Node *, MPD *);
                 void    parseSegmentBaseType(MPD *mpd, xml::Node *node,
                                              AbstractSegmentBaseType *base,
                                              SegmentInformation *parent);
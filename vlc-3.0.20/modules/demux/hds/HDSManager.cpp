@@ -0,0 +1,154 @@
+/*
+ * HDSManager.cpp
+ *****************************************************************************
+ * Copyright © 2026 - VideoLAN and VLC authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_fixups.h>
+#include <cinttypes>
+
+#include "HDSManager.hpp"
+
+#include "../adaptive/SharedResources.hpp"
+#include "../adaptive/http/Chunk.h"
+#include "../adaptive/tools/Retrieve.hpp"
+#include "playlist/F4MParser.hpp"
+#include "../adaptive/xml/DOMParser.h"
+#include <vlc_stream.h>
+#include <vlc_demux.h>
+#include <time.h>
+
+using namespace adaptive;
+using namespace adaptive::logic;
+using namespace hds;
+using namespace hds::playlist;
+
+HDSManager::HDSManager(demux_t *demux_,
+                       SharedResources *res,
+                       F4M *playlist,
+                       AbstractStreamFactory *factory,
+                       AbstractAdaptationLogic::LogicType type) :
+             PlaylistManager(demux_, res, playlist, factory, type)
+{
+}
+
+HDSManager::~HDSManager()
+{
+}
+
+F4M * HDSManager::fetchManifest()
+{
+    std::string playlisturl(p_demux->psz_access);
+    playlisturl.append("://");
+    playlisturl.append(p_demux->psz_location);
+
+    block_t *p_block = Retrieve::HTTP(resources, ChunkType::Playlist, playlisturl);
+    if(!p_block)
+        return nullptr;
+
+    stream_t *memorystream = vlc_stream_MemoryNew(p_demux, p_block->p_buffer, p_block->i_buffer, true);
+    if(!memorystream)
+    {
+        block_Release(p_block);
+        return nullptr;
+    }
+
+    xml::DOMParser parser(memorystream);
+    if(!parser.parse(true))
+    {
+        vlc_stream_Delete(memorystream);
+        block_Release(p_block);
+        return nullptr;
+    }
+
+    F4M *manifest = nullptr;
+
+    F4MParser *manifestParser = new (std::nothrow) F4MParser(parser.getRootNode(), VLC_OBJECT(p_demux),
+                                                             resources, playlisturl);
+    if(manifestParser)
+    {
+        manifest = manifestParser->parse();
+        delete manifestParser;
+    }
+
+    vlc_stream_Delete(memorystream);
+    block_Release(p_block);
+
+    return manifest;
+}
+
+bool HDSManager::updatePlaylist()
+{
+    /* Fragments carry no timeline: live bootstraps must be fetched again */
+    if(!playlist->isLive() || !nextPlaylistupdate)
+        return true;
+
+    F4M *newManifest = fetchManifest();
+    if(!newManifest)
+        return false;
+
+    playlist->updateWith(newManifest);
+    delete newManifest;
+
+#ifdef NDEBUG
+    playlist->debug();
+#endif
+
+    return true;
+}
+
+void HDSManager::scheduleNextUpdate()
+{
+    time_t now = time(nullptr);
+
+    vlc_tick_t minbuffer = getMinAheadTime() / 2;
+
+    if(playlist->minUpdatePeriod.Get() > minbuffer)
+        minbuffer = playlist->minUpdatePeriod.Get();
+
+    nextPlaylistupdate = now + minbuffer / CLOCK_FREQ;
+
+    msg_Dbg(p_demux, "Updated playlist, next update in %" PRId64 "s", (vlc_tick_t) nextPlaylistupdate - now );
+}
+
+bool HDSManager::needsUpdate() const
+{
+    if(nextPlaylistupdate && time(nullptr) < nextPlaylistupdate)
+        return false;
+
+    return PlaylistManager::needsUpdate();
+}
+
+bool HDSManager::reactivateStream(AbstractStream *stream)
+{
+    if(playlist->isLive())
+        updatePlaylist();
+    return PlaylistManager::reactivateStream(stream);
+}
+
+bool HDSManager::isHDS(xml::Node *root)
+{
+    return root->getName() == "manifest";
+}
+
+bool HDSManager::mimeMatched(const std::string &mime)
+{
+    return (mime == "application/f4m+xml");
+}
@@ -0,0 +1,63 @@
+/*
+ * HDSManager.hpp
+ *****************************************************************************
+ * Copyright © 2026 - VideoLAN and VLC authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef HDSMANAGER_HPP
+#define HDSMANAGER_HPP
+
+#include "../adaptive/PlaylistManager.h"
+#include "../adaptive/logic/AbstractAdaptationLogic.h"
+#include "playlist/F4M.hpp"
+
+namespace adaptive
+{
+    namespace xml
+    {
+        class Node;
+    }
+}
+
+namespace hds
+{
+    using namespace adaptive;
+
+    class HDSManager : public PlaylistManager
+    {
+        public:
+            HDSManager( demux_t *, SharedResources *, playlist::F4M *,
+                        AbstractStreamFactory *,
+                        logic::AbstractAdaptationLogic::LogicType type );
+            virtual ~HDSManager();
+
+            virtual bool needsUpdate() const override;
+            virtual void scheduleNextUpdate() override;
+            virtual bool updatePlaylist() override;
+
+            static bool isHDS(xml::Node *);
+            static bool mimeMatched(const std::string &);
+
+        protected:
+            virtual bool reactivateStream(AbstractStream *) override;
+
+        private:
+            playlist::F4M * fetchManifest();
+    };
+
+}
+
+#endif // HDSMANAGER_HPP
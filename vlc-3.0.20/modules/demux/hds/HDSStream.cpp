@@ -0,0 +1,133 @@
+/*
+ * HDSStream.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLAN and VLC authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "HDSStream.hpp"
+#include "playlist/HDSRepresentation.hpp"
+#include "../adaptive/SegmentTracker.hpp"
+#include "../adaptive/plumbing/Demuxer.hpp"
+#include <vlc_demux.h>
+#include <vlc_block.h>
+
+#include <cstring>
+
+using namespace hds;
+using namespace hds::playlist;
+
+static const uint8_t flv_file_header[] =
+{
+    'F', 'L', 'V', 0x01,
+    0x05,                   /* audio and video */
+    0x00, 0x00, 0x00, 0x09, /* header length */
+    0x00, 0x00, 0x00, 0x00, /* first previous tag size */
+};
+
+static void SetFLVHeader(std::vector<uint8_t> *header, const std::vector<uint8_t> &metadata)
+{
+    header->assign(flv_file_header, flv_file_header + sizeof(flv_file_header));
+    if(metadata.empty() || metadata.size() > 0xFFFFFF)
+        return;
+
+    /* onMetaData script tag, timestamp and stream id left to 0 */
+    uint8_t tag[11] = { 0x12 };
+    tag[1] = metadata.size() >> 16;
+    tag[2] = metadata.size() >> 8;
+    tag[3] = metadata.size();
+    header->insert(header->end(), tag, tag + sizeof(tag));
+    header->insert(header->end(), metadata.begin(), metadata.end());
+
+    uint8_t tagsize[4];
+    SetDWBE(tagsize, sizeof(tag) + metadata.size());
+    header->insert(header->end(), tagsize, tagsize + sizeof(tagsize));
+}
+
+HDSStream::HDSStream(demux_t *demux)
+    :AbstractStream(demux)
+{
+    SetFLVHeader(&flvheader, std::vector<uint8_t>());
+    b_flvheader_pending = true;
+}
+
+HDSStream::~HDSStream()
+{
+}
+
+void HDSStream::trackerEvent(const TrackerEvent &ev)
+{
+    if(ev.getType() == TrackerEvent::Type::RepresentationSwitch)
+    {
+        const RepresentationSwitchEvent &event =
+                static_cast<const RepresentationSwitchEvent &>(ev);
+        const HDSRepresentation *rep = dynamic_cast<const HDSRepresentation *>(event.next);
+        if(rep)
+            SetFLVHeader(&flvheader, rep->getMetadata());
+    }
+    AbstractStream::trackerEvent(ev);
+}
+
+bool HDSStream::startDemux()
+{
+    b_flvheader_pending = true;
+    return AbstractStream::startDemux();
+}
+
+bool HDSStream::restartDemux()
+{
+    /* a kept demuxer must not see a second header */
+    if(!demuxer || demuxer->needsRestartOnSeek())
+        b_flvheader_pending = true;
+    return AbstractStream::restartDemux();
+}
+
+AbstractDemuxer *HDSStream::newDemux(vlc_object_t *p_obj, const StreamFormat &format,
+                                     es_out_t *out, AbstractSourceStream *source) const
+{
+    if(format != StreamFormat::Type::FLV)
+        return nullptr;
+    return new Demuxer(p_obj, "avformat", out, source);
+}
+
+block_t * HDSStream::checkBlock(block_t *p_block, bool)
+{
+    /* Fragments only carry FLV tags, the demuxer needs a file header */
+    if(p_block && b_flvheader_pending)
+    {
+        b_flvheader_pending = false;
+        const size_t i_header = flvheader.size();
+        p_block = block_Realloc(p_block, i_header, i_header + p_block->i_buffer);
+        if(p_block)
+            memcpy(p_block->p_buffer, flvheader.data(), i_header);
+    }
+    return p_block;
+}
+
+AbstractStream * HDSStreamFactory::create(demux_t *realdemux, const StreamFormat &format,
+                                          SegmentTracker *tracker) const
+{
+    HDSStream *stream = new (std::nothrow) HDSStream(realdemux);
+    if(stream && !stream->init(format,tracker))
+    {
+        delete stream;
+        return nullptr;
+    }
+    return stream;
+}
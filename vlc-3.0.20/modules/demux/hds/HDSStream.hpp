@@ -0,0 +1,60 @@
+/*
+ * HDSStream.hpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLAN and VLC authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef HDSSTREAM_HPP
+#define HDSSTREAM_HPP
+
+#include "../adaptive/Streams.hpp"
+
+#include <vector>
+
+namespace hds
+{
+    using namespace adaptive;
+
+    class HDSStream : public AbstractStream
+    {
+        public:
+            HDSStream(demux_t *);
+            virtual ~HDSStream();
+            virtual void trackerEvent(const TrackerEvent &) override;
+
+        protected:
+            virtual block_t *checkBlock(block_t *, bool) override;
+            virtual AbstractDemuxer * newDemux(vlc_object_t *, const StreamFormat &,
+                                               es_out_t *, AbstractSourceStream *) const override;
+            virtual bool startDemux() override;
+            virtual bool restartDemux() override;
+
+        private:
+            /* FLV file header and onMetaData tag, sent once per demuxer */
+            std::vector<uint8_t> flvheader;
+            bool b_flvheader_pending;
+    };
+
+    class HDSStreamFactory : public AbstractStreamFactory
+    {
+        public:
+            virtual AbstractStream *create(demux_t*, const StreamFormat &,
+                                   SegmentTracker *) const override;
+    };
+
+}
+
+#endif // HDSSTREAM_HPP
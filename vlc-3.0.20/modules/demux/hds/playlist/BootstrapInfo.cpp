@@ -0,0 +1,359 @@
+/*
+ * BootstrapInfo.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "BootstrapInfo.hpp"
+#include "../../adaptive/playlist/SegmentTimeline.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace hds::playlist;
+
+BootstrapInfo::BootstrapInfo()
+{
+    live = false;
+    timescale = 0;
+    currentMediaTime = 0;
+    fragmentTimescale = 0;
+}
+
+BootstrapInfo::~BootstrapInfo()
+{
+}
+
+static bool ReadString(const uint8_t **pp, const uint8_t *end, std::string *str)
+{
+    const uint8_t *p = *pp;
+    const uint8_t *zero = (const uint8_t *) memchr(p, '\0', end - p);
+    if(!zero)
+        return false;
+    if(str)
+        str->assign((const char *) p, zero - p);
+    *pp = zero + 1;
+    return true;
+}
+
+static bool ReadStrings(const uint8_t **pp, const uint8_t *end,
+                        std::vector<std::string> *strs)
+{
+    if(*pp >= end)
+        return false;
+    uint8_t count = *(*pp)++;
+    while(count-- > 0)
+    {
+        std::string str;
+        if(!ReadString(pp, end, &str))
+            return false;
+        if(strs)
+            strs->push_back(str);
+    }
+    return true;
+}
+
+/* Checks the box header and returns the end of the box */
+static const uint8_t * ReadBoxHeader(const uint8_t **pp, const uint8_t *end,
+                                     const char *type)
+{
+    const uint8_t *p = *pp;
+    if(end - p < 8)
+        return nullptr;
+
+    uint64_t size = GetDWBE(p);
+    if(memcmp(&p[4], type, 4))
+        return nullptr;
+    p += 8;
+
+    if(size == 1)
+    {
+        if(end - p < 8)
+            return nullptr;
+        size = GetQWBE(p);
+        p += 8;
+    }
+    else if(size == 0)
+    {
+        size = end - *pp;
+    }
+
+    if(size < (uint64_t)(p - *pp) || size > (uint64_t)(end - *pp))
+        return nullptr;
+
+    const uint8_t *boxend = *pp + size;
+    *pp = p;
+    return boxend;
+}
+
+bool BootstrapInfo::parseSegmentRuns(vlc_object_t *obj, const uint8_t **pp,
+                                     const uint8_t *end)
+{
+    const uint8_t *boxend = ReadBoxHeader(pp, end, "asrt");
+    if(!boxend)
+    {
+        msg_Err(obj, "Can't find asrt in bootstrap");
+        return false;
+    }
+
+    const uint8_t *p = *pp + 4; /* version, flags */
+    if(p > boxend || !ReadStrings(&p, boxend, nullptr) || boxend - p < 4)
+    {
+        msg_Err(obj, "Premature end of asrt");
+        return false;
+    }
+
+    uint32_t count = GetDWBE(p);
+    p += 4;
+    if((uint64_t)(boxend - p) < (uint64_t)count * 8)
+    {
+        msg_Err(obj, "Not enough data in asrt for segment run entries");
+        return false;
+    }
+
+    /* Further tables are for other quality levels */
+    if(segmentRuns.empty())
+    {
+        for(; count > 0; count--, p += 8)
+        {
+            SegmentRun run;
+            run.firstSegment = GetDWBE(p);
+            run.fragmentsPerSegment = GetDWBE(&p[4]);
+            segmentRuns.push_back(run);
+        }
+    }
+
+    *pp = boxend;
+    return true;
+}
+
+bool BootstrapInfo::parseFragmentRuns(vlc_object_t *obj, const uint8_t **pp,
+                                      const uint8_t *end)
+{
+    const uint8_t *boxend = ReadBoxHeader(pp, end, "afrt");
+    if(!boxend)
+    {
+        msg_Err(obj, "Can't find afrt in bootstrap");
+        return false;
+    }
+
+    const uint8_t *p = *pp + 4; /* version, flags */
+    if(boxend - p < 4)
+    {
+        msg_Err(obj, "afrt is too short");
+        return false;
+    }
+    uint32_t runtimescale = GetDWBE(p);
+    p += 4;
+
+    if(!ReadStrings(&p, boxend, nullptr) || boxend - p < 4)
+    {
+        msg_Err(obj, "Premature end of afrt");
+        return false;
+    }
+
+    uint32_t count = GetDWBE(p);
+    p += 4;
+
+    std::vector<FragmentRun> runs;
+    for(; count > 0; count--)
+    {
+        if(boxend - p < 16)
+        {
+            msg_Err(obj, "Not enough data in afrt");
+            return false;
+        }
+
+        FragmentRun run;
+        run.firstFragment = GetDWBE(p);
+        run.timestamp = GetQWBE(&p[4]);
+        run.duration = GetDWBE(&p[12]);
+        run.discontinuity = 0;
+        p += 16;
+        if(run.duration == 0)
+        {
+            if(p >= boxend)
+                break;
+            run.discontinuity = *p++;
+            /* ignore the end of table sentinel */
+            if(run.discontinuity == 0 && run.firstFragment == 0 && run.timestamp == 0)
+                continue;
+        }
+        runs.push_back(run);
+    }
+
+    if(fragmentRuns.empty())
+    {
+        fragmentTimescale = runtimescale;
+        fragmentRuns.swap(runs);
+    }
+
+    *pp = boxend;
+    return true;
+}
+
+bool BootstrapInfo::parse(vlc_object_t *obj, const uint8_t *data, size_t size)
+{
+    const uint8_t *p = data;
+    const uint8_t *end = ReadBoxHeader(&p, data + size, "abst");
+    if(!end || end - p < 29)
+    {
+        msg_Warn(obj, "Not enough bootstrap data");
+        return false;
+    }
+
+    /* version, flags, bootstrap info version */
+    p += 8;
+    live = !!(*p & 0x20);
+    p += 1;
+    timescale = GetDWBE(p);
+    currentMediaTime = GetQWBE(&p[4]);
+    /* skip the SMPTE time code offset */
+    p += 20;
+
+    servers.clear();
+    if(!ReadString(&p, end, nullptr) || /* movie identifier */
+       !ReadStrings(&p, end, &servers) ||
+       !ReadStrings(&p, end, nullptr) || /* quality entries */
+       !ReadString(&p, end, nullptr) || /* DRM data */
+       !ReadString(&p, end, nullptr) || /* metadata */
+       p >= end)
+    {
+        msg_Warn(obj, "Premature end of bootstrap info");
+        return false;
+    }
+
+    segmentRuns.clear();
+    for(uint8_t count = *p++; count > 0; count--)
+    {
+        if(!parseSegmentRuns(obj, &p, end))
+            return false;
+    }
+
+    if(p >= end)
+    {
+        msg_Warn(obj, "Couldn't find afrt data");
+        return false;
+    }
+
+    fragmentRuns.clear();
+    for(uint8_t count = *p++; count > 0; count--)
+    {
+        if(!parseFragmentRuns(obj, &p, end))
+            return false;
+    }
+
+    if(fragmentTimescale == 0)
+        fragmentTimescale = timescale ? timescale : 1000;
+
+    return !segmentRuns.empty() && !fragmentRuns.empty();
+}
+
+/* Fragments are numbered from 1 across all the segments of the table */
+uint64_t BootstrapInfo::getFragmentCount() const
+{
+    unsigned long long total = 0;
+    for(size_t i = 0; i < segmentRuns.size(); i++)
+    {
+        const SegmentRun &run = segmentRuns[i];
+        unsigned long long segments = 1; /* the last run is the current segment */
+        if(i + 1 < segmentRuns.size())
+        {
+            if(segmentRuns[i + 1].firstSegment <= run.firstSegment)
+                continue;
+            segments = segmentRuns[i + 1].firstSegment - run.firstSegment;
+        }
+
+        unsigned long long fragments;
+        if(umulll_overflow(segments, run.fragmentsPerSegment, &fragments) ||
+           uaddll_overflow(total, fragments, &total))
+            return UINT64_MAX;
+    }
+    return total;
+}
+
+/* Converts a time between timescales, saturating instead of wrapping */
+static uint64_t Rescale(uint64_t time, uint32_t from, uint32_t to)
+{
+    const uint64_t max = INT64_MAX;
+    unsigned long long q, r;
+    if(umulll_overflow(time / from, to, &q))
+        return max;
+    r = (time % from) * (unsigned long long) to / from; /* fits: both are < 2^32 */
+    if(uaddll_overflow(q, r, &q) || q > max)
+        return max;
+    return q;
+}
+
+SegmentTimeline * BootstrapInfo::createTimeline() const
+{
+    SegmentTimeline *timeline = new (std::nothrow) SegmentTimeline(nullptr);
+    if(!timeline)
+        return nullptr;
+
+    /* Time of the last available fragment (live) or total duration */
+    uint64_t lastTime = 0;
+    if(timescale && fragmentTimescale)
+        lastTime = Rescale(currentMediaTime, timescale, fragmentTimescale);
+
+    /* Don't trust the fragment table beyond what the segment table declares */
+    const uint64_t lastFragment = getFragmentCount();
+    uint64_t nextFragment = 0;
+    uint64_t length = 0;
+
+    for(size_t i = 0; i < fragmentRuns.size(); i++)
+    {
+        const FragmentRun &run = fragmentRuns[i];
+        if(run.duration == 0) /* discontinuity marker */
+            continue;
+
+        /* runs must go forward, and times must fit the timeline */
+        if(run.firstFragment == 0 || run.firstFragment < nextFragment ||
+           run.firstFragment > lastFragment || run.timestamp > (uint64_t) INT64_MAX)
+            continue;
+
+        const FragmentRun *next = (i + 1 < fragmentRuns.size()) ? &fragmentRuns[i + 1]
+                                                                : nullptr;
+        uint64_t count = 1;
+        if(next && next->firstFragment > run.firstFragment)
+            count = next->firstFragment - run.firstFragment;
+        else if(next && next->timestamp > run.timestamp)
+            count = (next->timestamp - run.timestamp) / run.duration;
+        else if(!next && lastTime > run.timestamp)
+            count = (lastTime - run.timestamp + (live ? 0 : run.duration - 1)) / run.duration;
+
+        if(count == 0)
+            count = 1;
+        if(count > lastFragment - run.firstFragment + 1)
+            count = lastFragment - run.firstFragment + 1;
+        /* the end of the run, and the timeline length, must remain valid times */
+        const uint64_t room = (uint64_t) INT64_MAX - std::max(run.timestamp, length);
+        if(count > room / run.duration)
+            count = room / run.duration;
+        if(count == 0)
+            continue;
+
+        timeline->addElement(run.firstFragment, run.duration, count - 1, run.timestamp);
+        nextFragment = run.firstFragment + count;
+        length += count * run.duration;
+    }
+
+    return timeline;
+}
@@ -0,0 +1,85 @@
+/*
+ * BootstrapInfo.hpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef HDSBOOTSTRAPINFO_HPP
+#define HDSBOOTSTRAPINFO_HPP
+
+#include <vlc_common.h>
+
+#include <string>
+#include <vector>
+
+namespace adaptive
+{
+    namespace playlist
+    {
+        class SegmentTimeline;
+    }
+}
+
+namespace hds
+{
+    namespace playlist
+    {
+        using namespace adaptive::playlist;
+
+        /* Bootstrap info box (abst) with its segment (asrt) and
+         * fragment (afrt) run tables */
+        class BootstrapInfo
+        {
+            public:
+                BootstrapInfo();
+                ~BootstrapInfo();
+
+                bool parse(vlc_object_t *, const uint8_t *, size_t);
+                SegmentTimeline * createTimeline() const;
+                uint64_t getFragmentCount() const;
+
+                class SegmentRun
+                {
+                    public:
+                        uint32_t firstSegment;
+                        uint32_t fragmentsPerSegment;
+                };
+
+                class FragmentRun
+                {
+                    public:
+                        uint32_t firstFragment;
+                        uint64_t timestamp;
+                        uint32_t duration;
+                        uint8_t  discontinuity;
+                };
+
+                bool live;
+                uint32_t timescale;
+                uint64_t currentMediaTime;
+                std::vector<std::string> servers;
+                std::vector<SegmentRun> segmentRuns;
+                uint32_t fragmentTimescale;
+                std::vector<FragmentRun> fragmentRuns;
+
+            private:
+                bool parseSegmentRuns(vlc_object_t *, const uint8_t **, const uint8_t *);
+                bool parseFragmentRuns(vlc_object_t *, const uint8_t **, const uint8_t *);
+        };
+    }
+}
+
+#endif // HDSBOOTSTRAPINFO_HPP
@@ -0,0 +1,45 @@
+/*
+ * F4M.cpp
+ *****************************************************************************
+ * Copyright © 2026 - VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "F4M.hpp"
+
+#include <vlc_common.h>
+
+using namespace hds::playlist;
+
+F4M::F4M (vlc_object_t *p_object) :
+    BasePlaylist(p_object)
+{
+    minUpdatePeriod.Set( 2 * CLOCK_FREQ );
+    b_live = false;
+}
+
+F4M::~F4M()
+{
+
+}
+
+bool F4M::isLive() const
+{
+    return b_live;
+}
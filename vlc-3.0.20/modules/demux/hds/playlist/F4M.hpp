@@ -0,0 +1,47 @@
+/*
+ * F4M.hpp
+ *****************************************************************************
+ * Copyright © 2026 - VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef HDSF4M_HPP
+#define HDSF4M_HPP
+
+#include "../../adaptive/playlist/BasePlaylist.hpp"
+
+namespace hds
+{
+    namespace playlist
+    {
+        using namespace adaptive::playlist;
+
+        class F4M : public BasePlaylist
+        {
+            friend class F4MParser;
+
+            public:
+                F4M(vlc_object_t *);
+                virtual ~F4M();
+
+                virtual bool                    isLive() const override;
+
+            private:
+                bool b_live;
+        };
+    }
+}
+
+#endif // HDSF4M_HPP
@@ -0,0 +1,271 @@
+/*
+ * F4MParser.cpp
+ *****************************************************************************
+ * Copyright © 2026 - VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "F4MParser.hpp"
+
+#include "F4M.hpp"
+#include "BootstrapInfo.hpp"
+#include "HDSRepresentation.hpp"
+#include "HDSSegment.hpp"
+#include "../../adaptive/playlist/BasePeriod.h"
+#include "../../adaptive/playlist/BaseAdaptationSet.h"
+#include "../../adaptive/playlist/SegmentTimeline.h"
+#include "../../adaptive/playlist/SegmentTemplate.h"
+#include "../../adaptive/playlist/Inheritables.hpp"
+#include "../../adaptive/playlist/Url.hpp"
+#include "../../adaptive/http/Chunk.h"
+#include "../../adaptive/xml/DOMHelper.h"
+#include "../../adaptive/xml/Node.h"
+#include "../../adaptive/tools/Helper.h"
+#include "../../adaptive/tools/Conversions.hpp"
+#include "../../adaptive/tools/Retrieve.hpp"
+
+#include <vlc_block.h>
+#include <vlc_charset.h>
+#include <vlc_strings.h>
+
+#include <cctype>
+#include <cstring>
+
+using namespace hds::playlist;
+using namespace adaptive::xml;
+using namespace adaptive::http;
+
+F4MParser::F4MParser(Node *root_, vlc_object_t *p_object_,
+                     SharedResources *res, const std::string & playlisturl_)
+{
+    root = root_;
+    p_object = p_object_;
+    resources = res;
+    playlisturl = playlisturl_;
+}
+
+F4MParser::~F4MParser()
+{
+}
+
+/* base64 payloads of the manifest are usually wrapped over several lines */
+static bool DecodeBase64(const std::string &text, std::vector<uint8_t> *out)
+{
+    std::string b64;
+    for(std::string::const_iterator it = text.begin(); it != text.end(); ++it)
+    {
+        if(!isspace((unsigned char) *it))
+            b64 += *it;
+    }
+
+    uint8_t *p_data = nullptr;
+    size_t i_data = vlc_b64_decode_binary(&p_data, b64.c_str());
+    if(!p_data)
+        return false;
+    out->assign(p_data, p_data + i_data);
+    free(p_data);
+    return i_data > 0;
+}
+
+bool F4MParser::loadBootstrap(Node *node, BootstrapInfo *bootstrap)
+{
+    std::vector<uint8_t> data;
+
+    if(node->hasAttribute("url"))
+    {
+        std::string url = node->getAttributeValue("url");
+        if(url.find("://") == std::string::npos)
+            url = baseurl + url;
+
+        block_t *p_block = Retrieve::HTTP(resources, ChunkType::Playlist, url);
+        if(!p_block)
+        {
+            msg_Err(p_object, "Failed to download bootstrap %s", url.c_str());
+            return false;
+        }
+        data.assign(p_block->p_buffer, p_block->p_buffer + p_block->i_buffer);
+        block_Release(p_block);
+    }
+    else if(!DecodeBase64(node->getText(), &data))
+    {
+        msg_Err(p_object, "Couldn't decode bootstrap info");
+        return false;
+    }
+
+    return bootstrap->parse(p_object, data.data(), data.size());
+}
+
+void F4MParser::parseMedia(BaseAdaptationSet *adaptSet, Node *mediaNode, unsigned id)
+{
+    /* Audio only alternates would need their own adaptation set */
+    if(mediaNode->hasAttribute("alternate"))
+        return;
+
+    const std::string url = mediaNode->getAttributeValue("url");
+    if(url.empty())
+        return;
+
+    const std::string bootstrapId = mediaNode->getAttributeValue("bootstrapInfoId");
+    Node *bootstrapNode = nullptr;
+    std::vector<Node *> bootstraps = DOMHelper::getChildElementByTagName(root, "bootstrapInfo");
+    std::vector<Node *>::const_iterator it;
+    for(it = bootstraps.begin(); it != bootstraps.end(); ++it)
+    {
+        if(bootstrapId.empty() || (*it)->getAttributeValue("id") == bootstrapId)
+        {
+            bootstrapNode = *it;
+            break;
+        }
+    }
+
+    BootstrapInfo bootstrap;
+    if(!bootstrapNode || !loadBootstrap(bootstrapNode, &bootstrap))
+    {
+        msg_Warn(p_object, "No usable bootstrap for media %s", url.c_str());
+        return;
+    }
+
+    HDSRepresentation *rep = new (std::nothrow) HDSRepresentation(adaptSet);
+    if(!rep)
+        return;
+
+    rep->setID(ID(id));
+
+    /* kbps */
+    if(mediaNode->hasAttribute("bitrate"))
+    {
+        uint64_t bitrate = Integer<uint64_t>(mediaNode->getAttributeValue("bitrate"));
+        if(bitrate <= UINT64_MAX / 1000)
+            rep->setBandwidth(bitrate * 1000);
+    }
+
+    if(mediaNode->hasAttribute("width"))
+        rep->setWidth(Integer<uint64_t>(mediaNode->getAttributeValue("width")));
+
+    if(mediaNode->hasAttribute("height"))
+        rep->setHeight(Integer<uint64_t>(mediaNode->getAttributeValue("height")));
+
+    if(!bootstrap.servers.empty() && !bootstrap.servers.front().empty())
+        rep->baseUrl.Set(new Url(bootstrap.servers.front() + "/"));
+
+    Node *metadataNode = DOMHelper::getFirstChildElementByName(mediaNode, "metadata");
+    std::vector<uint8_t> metadata;
+    if(metadataNode && DecodeBase64(metadataNode->getText(), &metadata))
+    {
+        /* onMetaData must end with an AMF object end marker */
+        static const uint8_t amf_object_end[] = { 0x00, 0x00, 0x09 };
+        if(metadata.size() >= sizeof(amf_object_end) &&
+           !memcmp(&metadata[metadata.size() - sizeof(amf_object_end)],
+                   amf_object_end, sizeof(amf_object_end)))
+            rep->setMetadata(metadata);
+        else
+            msg_Dbg(p_object, "Ignoring invalid metadata packet on media %u", id);
+    }
+
+    rep->setSegmentRuns(bootstrap.segmentRuns);
+    rep->addAttribute(new TimescaleAttr(Timescale(bootstrap.fragmentTimescale)));
+
+    /* HDSSegment is a template holder */
+    SegmentTemplate *templ = new SegmentTemplate(new HDSSegmentTemplateSegment(), rep);
+    if(templ)
+    {
+        templ->setSourceUrl(url + "Seg{segment}-Frag{fragment}");
+        SegmentTimeline *timeline = bootstrap.createTimeline();
+        if(timeline)
+            templ->addAttribute(timeline);
+        rep->setSegmentTemplate(templ);
+    }
+
+    adaptSet->addRepresentation(rep);
+}
+
+F4M * F4MParser::parse()
+{
+    F4M *manifest = new (std::nothrow) F4M(p_object);
+    if(!manifest)
+        return nullptr;
+
+    baseurl = Helper::getDirectoryPath(playlisturl).append("/");
+    Node *node = DOMHelper::getFirstChildElementByName(root, "baseURL");
+    if(node)
+    {
+        std::string url = node->getText();
+        Helper::trim(url, " \t\r\n");
+        if(!url.empty())
+        {
+            if(url.back() != '/')
+                url.append("/");
+            baseurl = url;
+        }
+    }
+    manifest->setPlaylistUrl(baseurl);
+
+    node = DOMHelper::getFirstChildElementByName(root, "duration");
+    if(node)
+    {
+        double duration = us_strtod(node->getText().c_str(), nullptr);
+        if(duration > 0)
+            manifest->duration.Set(duration * CLOCK_FREQ);
+    }
+
+    /* Without a duration, a stream can only be live */
+    std::string streamType;
+    node = DOMHelper::getFirstChildElementByName(root, "streamType");
+    if(node)
+    {
+        streamType = node->getText();
+        Helper::trim(streamType, " \t\r\n");
+    }
+    manifest->b_live = (streamType == "live") ||
+                       (streamType != "recorded" && manifest->duration.Get() == 0);
+
+    node = DOMHelper::getFirstChildElementByName(root, "dvrInfo");
+    if(node && node->hasAttribute("windowDuration"))
+    {
+        int64_t window = Integer<int64_t>(node->getAttributeValue("windowDuration"));
+        if(window > 0)
+            manifest->timeShiftBufferDepth.Set(window * CLOCK_FREQ);
+    }
+
+    /* Need a default Period */
+    BasePeriod *period = new (std::nothrow) BasePeriod(manifest);
+    if(period)
+    {
+        period->duration.Set(manifest->duration.Get());
+
+        BaseAdaptationSet *adaptSet = new (std::nothrow) BaseAdaptationSet(period);
+        if(adaptSet)
+        {
+            adaptSet->setID(ID(1));
+            unsigned nextid = 1;
+            std::vector<Node *> medias = DOMHelper::getChildElementByTagName(root, "media");
+            std::vector<Node *>::const_iterator it;
+            for(it = medias.begin(); it != medias.end(); ++it)
+                parseMedia(adaptSet, *it, nextid++);
+
+            if(!adaptSet->getRepresentations().empty())
+                period->addAdaptationSet(adaptSet);
+            else
+                delete adaptSet;
+        }
+        manifest->addPeriod(period);
+    }
+
+    return manifest;
+}
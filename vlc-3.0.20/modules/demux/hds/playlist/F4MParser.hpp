@@ -0,0 +1,73 @@
+/*
+ * F4MParser.hpp
+ *****************************************************************************
+ * Copyright © 2026 - VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef HDSF4MPARSER_HPP
+#define HDSF4MPARSER_HPP
+
+#include <string>
+
+#include <vlc_common.h>
+
+namespace adaptive
+{
+    class SharedResources;
+
+    namespace playlist
+    {
+        class BaseAdaptationSet;
+    }
+    namespace xml
+    {
+        class Node;
+    }
+}
+
+namespace hds
+{
+    namespace playlist
+    {
+        using namespace adaptive::playlist;
+        using namespace adaptive;
+
+        class F4M;
+        class BootstrapInfo;
+
+        class F4MParser
+        {
+            public:
+                F4MParser                  (xml::Node *, vlc_object_t *,
+                                            SharedResources *, const std::string &);
+                virtual ~F4MParser         ();
+
+                F4M * parse();
+
+            private:
+                bool loadBootstrap(xml::Node *, BootstrapInfo *);
+                void parseMedia(BaseAdaptationSet *, xml::Node *, unsigned);
+
+                xml::Node       *root;
+                vlc_object_t    *p_object;
+                SharedResources *resources;
+                std::string      playlisturl;
+                std::string      baseurl;
+        };
+    }
+}
+
+#endif // HDSF4MPARSER_HPP
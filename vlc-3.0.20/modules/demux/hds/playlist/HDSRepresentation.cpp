@@ -0,0 +1,125 @@
+/*
+ * HDSRepresentation.cpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "HDSRepresentation.hpp"
+
+#include <sstream>
+
+using namespace hds::playlist;
+
+HDSRepresentation::HDSRepresentation  ( BaseAdaptationSet *set ) :
+                BaseRepresentation( set )
+{
+}
+
+HDSRepresentation::~HDSRepresentation ()
+{
+}
+
+StreamFormat HDSRepresentation::getStreamFormat() const
+{
+    return StreamFormat(StreamFormat::Type::FLV);
+}
+
+void HDSRepresentation::updateWith(SegmentInformation *updated)
+{
+    HDSRepresentation *rep = dynamic_cast<HDSRepresentation *>(updated);
+    if(rep && !rep->segmentRuns.empty())
+        segmentRuns = rep->segmentRuns;
+    BaseRepresentation::updateWith(updated);
+}
+
+void HDSRepresentation::setSegmentRuns(const std::vector<BootstrapInfo::SegmentRun> &runs)
+{
+    segmentRuns = runs;
+}
+
+uint64_t HDSRepresentation::getSegmentNumber(uint64_t fragment) const
+{
+    /* Fragments are numbered from 1 across all segments */
+    uint64_t first = 1;
+    for(size_t i = 0; i < segmentRuns.size(); i++)
+    {
+        const BootstrapInfo::SegmentRun &run = segmentRuns[i];
+        if(run.fragmentsPerSegment == 0)
+            continue;
+
+        if(i + 1 < segmentRuns.size() &&
+           segmentRuns[i + 1].firstSegment > run.firstSegment)
+        {
+            const uint64_t count = (uint64_t)(segmentRuns[i + 1].firstSegment -
+                                              run.firstSegment) * run.fragmentsPerSegment;
+            if(fragment < first + count)
+                return run.firstSegment + (fragment - first) / run.fragmentsPerSegment;
+            first += count;
+        }
+        else
+        {
+            /* last run goes on forever */
+            if(fragment < first)
+                return run.firstSegment;
+            return run.firstSegment + (fragment - first) / run.fragmentsPerSegment;
+        }
+    }
+    return 1;
+}
+
+void HDSRepresentation::setMetadata(const std::vector<uint8_t> &data)
+{
+    metadata = data;
+}
+
+const std::vector<uint8_t> & HDSRepresentation::getMetadata() const
+{
+    return metadata;
+}
+
+std::string HDSRepresentation::contextualize(size_t number, const std::string &component,
+                                             const SegmentTemplate *templ) const
+{
+    std::string ret(component);
+    size_t pos;
+
+    if(!templ)
+        return ret;
+
+    pos = ret.find("{segment}");
+    if(pos != std::string::npos)
+    {
+        std::stringstream ss;
+        ss.imbue(std::locale("C"));
+        ss << getSegmentNumber(number);
+        ret.replace(pos, std::string("{segment}").length(), ss.str());
+    }
+
+    pos = ret.find("{fragment}");
+    if(pos != std::string::npos)
+    {
+        std::stringstream ss;
+        ss.imbue(std::locale("C"));
+        ss << number;
+        ret.replace(pos, std::string("{fragment}").length(), ss.str());
+    }
+
+    return ret;
+}
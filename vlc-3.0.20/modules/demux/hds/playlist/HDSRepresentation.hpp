@@ -0,0 +1,59 @@
+/*
+ * HDSRepresentation.hpp
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef HDSREPRESENTATION_HPP
+#define HDSREPRESENTATION_HPP
+
+#include "../../adaptive/playlist/BaseRepresentation.h"
+#include "BootstrapInfo.hpp"
+
+#include <vector>
+
+namespace hds
+{
+    namespace playlist
+    {
+        using namespace adaptive;
+        using namespace adaptive::playlist;
+
+        class HDSRepresentation : public BaseRepresentation
+        {
+            public:
+                HDSRepresentation(BaseAdaptationSet *);
+                virtual ~HDSRepresentation ();
+
+                virtual StreamFormat getStreamFormat() const override;
+                virtual void updateWith(SegmentInformation *) override;
+
+                /* for segment templates */
+                virtual std::string contextualize(size_t, const std::string &,
+                                                  const SegmentTemplate *) const override;
+
+                void setSegmentRuns(const std::vector<BootstrapInfo::SegmentRun> &);
+                uint64_t getSegmentNumber(uint64_t) const;
+                void setMetadata(const std::vector<uint8_t> &);
+                const std::vector<uint8_t> & getMetadata() const;
+
+            private:
+                std::vector<BootstrapInfo::SegmentRun> segmentRuns;
+                std::vector<uint8_t> metadata; /* onMetaData AMF payload */
+        };
+    }
+}
+#endif // HDSREPRESENTATION_HPP
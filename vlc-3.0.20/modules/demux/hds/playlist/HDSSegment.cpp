@@ -0,0 +1,121 @@
+/*****************************************************************************
+ * HDSSegment.cpp:
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "HDSSegment.hpp"
+
+#include <vlc_block.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+using namespace hds::playlist;
+
+HDSSegmentChunk::HDSSegmentChunk(AbstractChunkSource *source, BaseRepresentation *rep)
+    : SegmentChunk(source, rep)
+{
+    boxheaderlen = 0;
+    boxremain = 0;
+    inmdat = false;
+}
+
+HDSSegmentChunk::~HDSSegmentChunk()
+{
+
+}
+
+void HDSSegmentChunk::onDownload(block_t **pp_block)
+{
+    decrypt(pp_block);
+
+    /* Boxes can be split over any number of blocks: keep the parsing
+     * state across calls and compact the mdat payload in place */
+    block_t *p_block = *pp_block;
+    const uint8_t *in = p_block->p_buffer;
+    const uint8_t *end = in + p_block->i_buffer;
+    uint8_t *out = p_block->p_buffer;
+
+    while(in < end)
+    {
+        if(boxremain == 0)
+        {
+            size_t needed = 8;
+            if(boxheaderlen >= 4 && GetDWBE(boxheader) == 1)
+                needed = 16; /* 64 bits size */
+
+            size_t len = std::min(needed - boxheaderlen, (size_t)(end - in));
+            memcpy(&boxheader[boxheaderlen], in, len);
+            boxheaderlen += len;
+            in += len;
+            if(boxheaderlen < needed)
+                continue;
+            if(needed == 8 && GetDWBE(boxheader) == 1)
+                continue;
+
+            uint64_t size = GetDWBE(boxheader);
+            if(size == 1)
+                size = GetQWBE(&boxheader[8]);
+            else if(size == 0) /* up to the end of the fragment */
+                size = std::numeric_limits<uint64_t>::max();
+
+            inmdat = !memcmp(&boxheader[4], "mdat", 4);
+            if(size < boxheaderlen) /* broken box: drop the rest */
+            {
+                size = std::numeric_limits<uint64_t>::max();
+                inmdat = false;
+            }
+            boxremain = size - boxheaderlen;
+            boxheaderlen = 0;
+        }
+        else
+        {
+            size_t len = std::min(boxremain, (uint64_t)(end - in));
+            if(inmdat)
+            {
+                memmove(out, in, len);
+                out += len;
+            }
+            in += len;
+            boxremain -= len;
+        }
+    }
+
+    p_block->i_buffer = out - p_block->p_buffer;
+}
+
+HDSSegmentTemplateSegment::HDSSegmentTemplateSegment(ICanonicalUrl *parent)
+    : SegmentTemplateSegment(parent)
+{
+
+}
+
+HDSSegmentTemplateSegment::~HDSSegmentTemplateSegment()
+{
+
+}
+
+SegmentChunk* HDSSegmentTemplateSegment::createChunk(AbstractChunkSource *source, BaseRepresentation *rep)
+{
+     /* act as factory */
+    return new (std::nothrow) HDSSegmentChunk(source, rep);
+}
@@ -0,0 +1,56 @@
+/*****************************************************************************
+ * HDSSegment.hpp:
+ *****************************************************************************
+ * Copyright (C) 2026 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef HDSSEGMENT_HPP
+#define HDSSEGMENT_HPP
+
+#include "../../adaptive/playlist/SegmentTemplate.h"
+#include "../../adaptive/playlist/SegmentChunk.hpp"
+
+namespace hds
+{
+    namespace playlist
+    {
+        using namespace adaptive::playlist;
+
+        /* F4F fragment: only the mdat payload, FLV tags, goes to the demuxer */
+        class HDSSegmentChunk : public SegmentChunk
+        {
+            public:
+                HDSSegmentChunk(AbstractChunkSource *, BaseRepresentation *);
+                virtual ~HDSSegmentChunk();
+                virtual void onDownload(block_t **) override;
+
+            private:
+                uint8_t  boxheader[16];
+                size_t   boxheaderlen;
+                uint64_t boxremain;
+                bool     inmdat;
+        };
+
+        class HDSSegmentTemplateSegment : public SegmentTemplateSegment
+        {
+            public:
+                HDSSegmentTemplateSegment( ICanonicalUrl * = nullptr );
+                virtual ~HDSSegmentTemplateSegment();
+                virtual SegmentChunk* createChunk(AbstractChunkSource *, BaseRepresentation *) override;
+        };
+    }
+}
+#endif // HDSSEGMENT_HPP
@@ -47,6 +47,12 @@ HLSRepresentation::HLSRepresentation  ( BaseAdaptationSet *set ) :
     updateFailureCount = 0;
     lastUpdateTime = 0;
     targetDuration = 0;
+    partTarget = 0;
+    canBlockReload = false;
+    canSkipUntil = 0;
+    b_fullUpdate = true;
+    nextMediaSequence = 0;
+    nextPartIndex = 0;
     streamFormat = StreamFormat::Type::Unknown;
     channels = 0;
 }
@@ -70,6 +76,13 @@ bool HLSRepresentation::initialized() const
     return b_loaded;
 }
 
+bool HLSRepresentation::canDeltaUpdate() const
+{
+    /* the known playlist must be no older than half the skip boundary */
+    return b_loaded && isLive() && canSkipUntil && !b_fullUpdate &&
+           mdate() - lastUpdateTime < canSkipUntil / 2;
+}
+
 void HLSRepresentation::setPlaylistUrl(const std::string &uri)
 {
     playlistUrl = Url(uri);
@@ -139,9 +152,13 @@ bool HLSRepresentation::needsUpdate(uint64_t number) const
         vlc_tick_t duration = targetDuration
                          ? CLOCK_FREQ * targetDuration
                          : CLOCK_FREQ * 2;
+        /* low latency playlists are refreshed at the pace of their parts */
+        vlc_tick_t interval = partTarget ? partTarget : duration;
         if(updateFailureCount)
-            duration /= 2;
-        if(elapsed < duration)
+            interval /= 2;
+        else if(canBlockReload)
+            interval /= 4; /* server holds the request, only rate limit */
+        if(elapsed < interval)
             return false;
 
         if(number == std::numeric_limits<uint64_t>::max())
@@ -196,7 +213,30 @@ CodecDescription * HLSRepresentation::makeCodecDescription(const std::string &s)
 
 uint64_t HLSRepresentation::translateSegmentNumber(uint64_t num, const BaseRepresentation *from) const
 {
-    if(targetDuration == static_cast<const HLSRepresentation *>(from)->targetDuration)
+    const HLSRepresentation *hlsfrom = static_cast<const HLSRepresentation *>(from);
+
+    /* Numbering no longer matches media sequences when partial segments
+     * are listed, so use the playlist position of the segment or part */
+    if(partTarget || hlsfrom->partTarget)
+    {
+        const HLSSegment *fromSeg = dynamic_cast<const HLSSegment *>(from->getMediaSegment(num));
+        const SegmentList *segmentList = inheritSegmentList();
+        if(!fromSeg || !segmentList)
+            return std::numeric_limits<uint64_t>::max();
+
+        const std::vector<Segment *> &list = segmentList->getSegments();
+        for(auto it = list.cbegin(); it != list.cend(); ++it)
+        {
+            const HLSSegment *seg = static_cast<const HLSSegment *>(*it);
+            if(seg->getMediaSequenceNumber() > fromSeg->getMediaSequenceNumber() ||
+               (seg->getMediaSequenceNumber() == fromSeg->getMediaSequenceNumber() &&
+                seg->getPartIndex() >= fromSeg->getPartIndex()))
+                return seg->getSequenceNumber();
+        }
+        return std::numeric_limits<uint64_t>::max();
+    }
+
+    if(targetDuration == hlsfrom->targetDuration)
         return num;
 
     ISegment *fromSeg = from->getMediaSegment(num);
@@ -47,6 +47,7 @@ namespace hls
                 Url getPlaylistUrl() const;
                 bool isLive() const;
                 bool initialized() const;
+                bool canDeltaUpdate() const;
                 virtual void scheduleNextUpdate(uint64_t, bool) override;
                 virtual bool needsUpdate(uint64_t) const override;
                 virtual void debug(vlc_object_t *, int) const override;
@@ -60,6 +61,12 @@ namespace hls
 
             protected:
                 time_t targetDuration;
+                vlc_tick_t partTarget; /* 0 unless partial segments are listed */
+                bool canBlockReload;
+                vlc_tick_t canSkipUntil; /* delta updates skip boundary, or 0 */
+                bool b_fullUpdate; /* next update can't be a delta */
+                uint64_t nextMediaSequence;
+                unsigned nextPartIndex;
                 Url playlistUrl;
 
             private:
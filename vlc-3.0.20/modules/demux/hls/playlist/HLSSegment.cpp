@@ -31,19 +31,37 @@ HLSSegment::HLSSegment( ICanonicalUrl *parent, uint64_t seq ) :
     Segment( parent )
 {
     setSequenceNumber(seq);
+    mediaSequence = seq;
+    b_partial = false;
+    partIndex = 0;
 }
 
 HLSSegment::~HLSSegment()
 {
 }
 
+uint64_t HLSSegment::getMediaSequenceNumber() const
+{
+    return mediaSequence;
+}
+
+bool HLSSegment::isPartial() const
+{
+    return b_partial;
+}
+
+unsigned HLSSegment::getPartIndex() const
+{
+    return partIndex;
+}
+
 bool HLSSegment::prepareChunk(SharedResources *res, SegmentChunk *chunk, BaseRepresentation *rep)
 {
     if(encryption.method == CommonEncryption::Method::AES_128)
     {
         if (encryption.iv.size() != 16)
         {
-            uint64_t sequence = getSequenceNumber();
+            uint64_t sequence = mediaSequence;
             encryption.iv.clear();
             encryption.iv.resize(16);
             encryption.iv[15] = (sequence >> 0) & 0xff;
@@ -38,10 +38,21 @@ namespace hls
             public:
                 HLSSegment( ICanonicalUrl *parent, uint64_t sequence );
                 virtual ~HLSSegment();
+                uint64_t getMediaSequenceNumber() const;
+                bool isPartial() const;
+                unsigned getPartIndex() const;
 
             protected:
                 virtual bool prepareChunk(SharedResources *, SegmentChunk *,
                                           BaseRepresentation *) override;
+
+            private:
+                /* the playlist numbering, which partial segments share
+                   with their parent and is distinct from the tracking
+                   sequence number once partial segments are listed */
+                uint64_t mediaSequence;
+                bool b_partial;
+                unsigned partIndex;
         };
     }
 }
@@ -225,7 +225,29 @@ void M3U8Parser::fillAdaptsetFromMediainfo(const AttributesTag *mediatag,
 
 bool M3U8Parser::appendSegmentsFromPlaylistURI(vlc_object_t *p_obj, HLSRepresentation *rep)
 {
-    block_t *p_block = Retrieve::HTTP(resources, ChunkType::Playlist, rep->getPlaylistUrl().toString());
+    std::string url = rep->getPlaylistUrl().toString();
+    const bool b_block = rep->b_loaded && rep->isLive() && rep->canBlockReload;
+    const bool b_delta = rep->canDeltaUpdate();
+    if(b_block || b_delta)
+    {
+        std::ostringstream os;
+        os.imbue(std::locale("C"));
+        os << url << (url.find('?') == std::string::npos ? '?' : '&');
+        /* blocking reload: the server answers once the next
+         * segment or part is available */
+        if(b_block)
+        {
+            os << "_HLS_msn=" << rep->nextMediaSequence;
+            if(rep->partTarget)
+                os << "&_HLS_part=" << rep->nextPartIndex;
+        }
+        /* delta update: the server skips the segments we already know */
+        if(b_delta)
+            os << (b_block ? "&" : "") << "_HLS_skip=YES";
+        url = os.str();
+    }
+
+    block_t *p_block = Retrieve::HTTP(resources, ChunkType::Playlist, url);
     if(p_block)
     {
         stream_t *substream = vlc_stream_MemoryNew(p_obj, p_block->p_buffer, p_block->i_buffer, true);
@@ -279,6 +301,63 @@ static bool parseEncryption(const AttributesTag *keytag, const Url &playlistUrl,
     }
 }
 
+static bool isSameMedia(const HLSSegment *a, const HLSSegment *b)
+{
+    return a->getMediaSequenceNumber() == b->getMediaSequenceNumber() &&
+           a->isPartial() == b->isPartial() &&
+           a->getPartIndex() == b->getPartIndex();
+}
+
+static bool isNextMedia(const HLSSegment *prev, const HLSSegment *next)
+{
+    if(prev->isPartial() && next->isPartial() &&
+       next->getMediaSequenceNumber() == prev->getMediaSequenceNumber())
+        return next->getPartIndex() == prev->getPartIndex() + 1;
+    return next->getMediaSequenceNumber() == prev->getMediaSequenceNumber() + 1 &&
+           next->getPartIndex() == 0;
+}
+
+/* Partial segments get their own tracking numbers, contiguous across
+ * playlist updates: continue from what is already known */
+static uint64_t getFirstSegmentNumber(const SegmentList *known,
+                                      const std::list<HLSSegment *> &update)
+{
+    if(!known || known->getSegments().empty())
+        return update.front()->getMediaSequenceNumber();
+
+    const std::vector<Segment *> &list = known->getSegments();
+    uint64_t index = 0;
+    for(const HLSSegment *seg : update)
+    {
+        for(auto it = list.crbegin(); it != list.crend(); ++it)
+        {
+            const HLSSegment *knownseg = static_cast<const HLSSegment *>(*it);
+            if(isSameMedia(knownseg, seg) && knownseg->getSequenceNumber() >= index)
+                return knownseg->getSequenceNumber() - index;
+        }
+        index++;
+    }
+
+    /* nothing in common, signal a gap unless it directly follows */
+    const HLSSegment *last = static_cast<const HLSSegment *>(list.back());
+    return last->getSequenceNumber() + (isNextMedia(last, update.front()) ? 1 : 2);
+}
+
+/* Last whole segment with that media sequence in the known list */
+static const HLSSegment * findKnownSegment(const SegmentList *known, uint64_t mediaSequence)
+{
+    if(!known)
+        return nullptr;
+    const std::vector<Segment *> &list = known->getSegments();
+    for(auto it = list.crbegin(); it != list.crend(); ++it)
+    {
+        const HLSSegment *knownseg = static_cast<const HLSSegment *>(*it);
+        if(knownseg->getMediaSequenceNumber() == mediaSequence && !knownseg->isPartial())
+            return knownseg;
+    }
+    return nullptr;
+}
+
 void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std::list<Tag *> &tagslist)
 {
     bool b_pdt = tagslist.cend() != std::find_if(tagslist.cbegin(), tagslist.cend(),
@@ -301,9 +380,45 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
     const SingleValueTag *ctx_byterange = nullptr;
     CommonEncryption encryption;
     const ValuesListTag *ctx_extinf = nullptr;
+    unsigned partIndex = 0;
+    std::size_t prevpartbyterangeoffset = 0;
+    const AttributesTag *preloadhint = nullptr;
+    /* delta update, known segments to carry over */
+    const HLSSegment *lastskipped = nullptr;
+    uint64_t windowStart = 0;
+    bool b_deltafailed = false;
 
     std::list<HLSSegment *> segmentstoappend;
 
+    auto setSegmentTimes = [&](HLSSegment *segment, vlc_tick_t nzDuration)
+    {
+        segment->duration.Set(timescale.ToScaled(nzDuration));
+        segment->startTime.Set(timescale.ToScaled(nzStartTime));
+        nzStartTime += nzDuration;
+        totalduration += nzDuration;
+        if(absReferenceTime > VLC_TICK_INVALID)
+        {
+            segment->setDisplayTime(absReferenceTime);
+            absReferenceTime += nzDuration;
+        }
+    };
+
+    auto setSegmentContext = [&](HLSSegment *segment)
+    {
+        segment->setDiscontinuitySequenceNumber(discontinuitySequence);
+        segment->discontinuity = discontinuity;
+        discontinuity = false;
+
+        if(encryption.method != CommonEncryption::Method::None)
+            segment->setEncryption(encryption);
+    };
+
+    rep->partTarget = 0;
+    rep->canBlockReload = false;
+    rep->canSkipUntil = 0;
+    /* set again below while the playlist still advertises parts */
+    static_cast<M3U8 *>(rep->getPlaylist())->setLowLatency(false);
+
     std::list<Tag *>::const_iterator it;
     for(it = tagslist.begin(); it != tagslist.end(); ++it)
     {
@@ -333,6 +448,23 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
                     break;
                 }
 
+                /* Completed segment already listed as parts */
+                if(partIndex)
+                {
+                    ctx_extinf = nullptr;
+                    if(ctx_byterange)
+                    {
+                        std::pair<std::size_t,std::size_t> range = ctx_byterange->getValue().getByteRange();
+                        if(range.first == 0)
+                            range.first = prevbyterangeoffset;
+                        prevbyterangeoffset = range.first + range.second;
+                        ctx_byterange = nullptr;
+                    }
+                    sequenceNumber++;
+                    partIndex = 0;
+                    break;
+                }
+
                 HLSSegment *segment = new (std::nothrow) HLSSegment(rep, sequenceNumber++);
                 if(!segment)
                     break;
@@ -348,15 +480,7 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
                         nzDuration = CLOCK_FREQ * durAttribute->floatingPoint();
                     ctx_extinf = nullptr;
                 }
-                segment->duration.Set(timescale.ToScaled(nzDuration));
-                segment->startTime.Set(timescale.ToScaled(nzStartTime));
-                nzStartTime += nzDuration;
-                totalduration += nzDuration;
-                if(absReferenceTime > VLC_TICK_INVALID)
-                {
-                    segment->setDisplayTime(absReferenceTime);
-                    absReferenceTime += nzDuration;
-                }
+                setSegmentTimes(segment, nzDuration);
 
                 segmentstoappend.push_back(segment);
 
@@ -369,12 +493,116 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
                     segment->setByteRange(range.first, prevbyterangeoffset - 1);
                     ctx_byterange = nullptr;
                 }
-                segment->setDiscontinuitySequenceNumber(discontinuitySequence);
-                segment->discontinuity = discontinuity;
-                discontinuity = false;
+                setSegmentContext(segment);
+            }
+            break;
+
+            case AttributesTag::EXTXPART:
+            {
+                const AttributesTag *parttag = static_cast<const AttributesTag *>(tag);
+                const Attribute *uriAttr = parttag->getAttributeByName("URI");
+                const Attribute *durAttr = parttag->getAttributeByName("DURATION");
+                if(!rep->partTarget || !uriAttr || !durAttr)
+                    break;
+
+                const unsigned index = partIndex++;
+                const vlc_tick_t nzDuration = CLOCK_FREQ * durAttr->floatingPoint();
+                const Attribute *gapAttr = parttag->getAttributeByName("GAP");
+                if(gapAttr && gapAttr->value == "YES")
+                {
+                    nzStartTime += nzDuration;
+                    totalduration += nzDuration;
+                    if(absReferenceTime > VLC_TICK_INVALID)
+                        absReferenceTime += nzDuration;
+                    break;
+                }
 
-                if(encryption.method != CommonEncryption::Method::None)
-                    segment->setEncryption(encryption);
+                HLSSegment *segment = new (std::nothrow) HLSSegment(rep, sequenceNumber);
+                if(!segment)
+                    break;
+                segment->b_partial = true;
+                segment->partIndex = index;
+                segment->setSourceUrl(uriAttr->quotedString());
+                setSegmentTimes(segment, nzDuration);
+
+                const Attribute *byterangeAttr = parttag->getAttributeByName("BYTERANGE");
+                if(byterangeAttr)
+                {
+                    const Attribute byterange = byterangeAttr->unescapeQuotes();
+                    std::pair<std::size_t,std::size_t> range = byterange.getByteRange();
+                    /* no offset: follows previous part of the same resource */
+                    if(byterange.value.find('@') == std::string::npos)
+                        range.first = prevpartbyterangeoffset;
+                    prevpartbyterangeoffset = range.first + range.second;
+                    segment->setByteRange(range.first, prevpartbyterangeoffset - 1);
+                }
+                setSegmentContext(segment);
+
+                segmentstoappend.push_back(segment);
+            }
+            break;
+
+            case AttributesTag::EXTXPARTINF:
+            {
+                const Attribute *targetAttr = static_cast<const AttributesTag *>(tag)->
+                                              getAttributeByName("PART-TARGET");
+                if(!b_vod && targetAttr)
+                {
+                    rep->partTarget = CLOCK_FREQ * targetAttr->floatingPoint();
+                    static_cast<M3U8 *>(rep->getPlaylist())->setLowLatency(true);
+                }
+            }
+            break;
+
+            case AttributesTag::EXTXSERVERCONTROL:
+            {
+                const AttributesTag *controltag = static_cast<const AttributesTag *>(tag);
+                const Attribute *blockAttr = controltag->getAttributeByName("CAN-BLOCK-RELOAD");
+                rep->canBlockReload = (blockAttr && blockAttr->value == "YES");
+                const Attribute *holdAttr = controltag->getAttributeByName("PART-HOLD-BACK");
+                if(holdAttr)
+                    rep->getPlaylist()->targetLatency.Set(CLOCK_FREQ * holdAttr->floatingPoint());
+                const Attribute *skipAttr = controltag->getAttributeByName("CAN-SKIP-UNTIL");
+                if(!b_vod && skipAttr)
+                    rep->canSkipUntil = CLOCK_FREQ * skipAttr->floatingPoint();
+            }
+            break;
+
+            case AttributesTag::EXTXSKIP:
+            {
+                const Attribute *skippedAttr = static_cast<const AttributesTag *>(tag)->
+                                               getAttributeByName("SKIPPED-SEGMENTS");
+                if(!skippedAttr || !segmentstoappend.empty() || partIndex)
+                    break;
+                const uint64_t skipped = skippedAttr->decimal();
+                if(skipped == 0)
+                    break;
+                /* the skipped segments are the ones we already have,
+                 * continue timings and numbering from the last one */
+                lastskipped = findKnownSegment(rep->inheritSegmentList(),
+                                               sequenceNumber + skipped - 1);
+                if(!lastskipped)
+                {
+                    b_deltafailed = true;
+                    break;
+                }
+                windowStart = sequenceNumber;
+                sequenceNumber += skipped;
+                nzStartTime = timescale.ToTime(lastskipped->startTime.Get() +
+                                               lastskipped->duration.Get());
+                if(lastskipped->getDisplayTime() != VLC_TICK_INVALID)
+                    absReferenceTime = lastskipped->getDisplayTime() +
+                                       timescale.ToTime(lastskipped->duration.Get());
+                discontinuitySequence = lastskipped->getDiscontinuitySequenceNumber();
+            }
+            break;
+
+            case AttributesTag::EXTXPRELOADHINT:
+            {
+                const Attribute *typeAttr = static_cast<const AttributesTag *>(tag)->
+                                            getAttributeByName("TYPE");
+                if(typeAttr && typeAttr->value == "PART")
+                    preloadhint = static_cast<const AttributesTag *>(tag);
             }
             break;
 
@@ -438,7 +666,9 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
             break;
 
             case SingleValueTag::EXTXDISCONTINUITYSEQUENCE:
-                discontinuitySequence = static_cast<const SingleValueTag *>(tag)->getValue().decimal();
+                /* applies to the first segment, which a delta update skipped */
+                if(!lastskipped)
+                    discontinuitySequence = static_cast<const SingleValueTag *>(tag)->getValue().decimal();
                 break;
 
             case Tag::EXTXDISCONTINUITY:
@@ -451,6 +681,69 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
         }
     }
 
+    /* Next expected part, which the server is already producing.
+     * Request it now so it streams as it is being written. */
+    const Attribute *hinturiAttr = preloadhint ? preloadhint->getAttributeByName("URI") : nullptr;
+    if(hinturiAttr && rep->partTarget)
+    {
+        HLSSegment *segment = new (std::nothrow) HLSSegment(rep, sequenceNumber);
+        if(segment)
+        {
+            segment->b_partial = true;
+            segment->partIndex = partIndex;
+            segment->setSourceUrl(hinturiAttr->quotedString());
+            setSegmentTimes(segment, rep->partTarget);
+            const Attribute *startAttr = preloadhint->getAttributeByName("BYTERANGE-START");
+            const Attribute *lengthAttr = preloadhint->getAttributeByName("BYTERANGE-LENGTH");
+            if(startAttr || lengthAttr)
+            {
+                std::size_t start = startAttr ? startAttr->decimal() : 0;
+                segment->setByteRange(start, lengthAttr ? start + lengthAttr->decimal() - 1 : 0);
+            }
+            setSegmentContext(segment);
+            segmentstoappend.push_back(segment);
+        }
+    }
+
+    if(b_deltafailed)
+    {
+        /* we no longer have what was skipped, ask for the whole playlist */
+        for(HLSSegment *seg : segmentstoappend)
+            delete seg;
+        delete segmentList;
+        rep->b_fullUpdate = true;
+        return;
+    }
+    rep->b_fullUpdate = false;
+
+    rep->nextMediaSequence = sequenceNumber;
+    rep->nextPartIndex = partIndex;
+
+    if(rep->partTarget && !segmentstoappend.empty())
+    {
+        uint64_t number = getFirstSegmentNumber(rep->inheritSegmentList(), segmentstoappend);
+        for(HLSSegment *seg : segmentstoappend)
+            seg->setSequenceNumber(number++);
+    }
+
+    if(lastskipped)
+    {
+        /* carry the skipped segments over, the listed ones replace the rest */
+        SegmentList *known = rep->inheritSegmentList();
+        const HLSSegment *firstskipped = nullptr;
+        for(const Segment *seg : known->getSegments())
+        {
+            const HLSSegment *knownseg = static_cast<const HLSSegment *>(seg);
+            if(knownseg->getMediaSequenceNumber() >= windowStart && !knownseg->isPartial())
+            {
+                firstskipped = knownseg;
+                break;
+            }
+        }
+        known->pruneAfterSegmentNumber(lastskipped->getSequenceNumber());
+        segmentList->moveSegmentsFrom(known, firstskipped->getSequenceNumber());
+    }
+
     for(HLSSegment *seg : segmentstoappend)
         segmentList->addSegment(seg);
     segmentstoappend.clear();
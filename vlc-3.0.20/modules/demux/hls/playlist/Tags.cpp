@@ -308,6 +308,11 @@ Tag * TagFactory::createTagByName(const std::string &name, const std::string &va
         {"EXT-X-START",                     AttributesTag::EXTXSTART},
         {"EXT-X-STREAM-INF",                AttributesTag::EXTXSTREAMINF},
         {"EXT-X-SESSION-KEY",               AttributesTag::EXTXSESSIONKEY},
+        {"EXT-X-PART",                      AttributesTag::EXTXPART},
+        {"EXT-X-PART-INF",                  AttributesTag::EXTXPARTINF},
+        {"EXT-X-PRELOAD-HINT",              AttributesTag::EXTXPRELOADHINT},
+        {"EXT-X-SERVER-CONTROL",            AttributesTag::EXTXSERVERCONTROL},
+        {"EXT-X-SKIP",                      AttributesTag::EXTXSKIP},
         {"EXTINF",                          ValuesListTag::EXTINF},
         {"",                                SingleValueTag::URI},
         {nullptr,                              0},
@@ -345,6 +350,11 @@ Tag * TagFactory::createTagByName(const std::string &name, const std::string &va
         case AttributesTag::EXTXMEDIA:
         case AttributesTag::EXTXSTART:
         case AttributesTag::EXTXSTREAMINF:
+        case AttributesTag::EXTXPART:
+        case AttributesTag::EXTXPARTINF:
+        case AttributesTag::EXTXPRELOADHINT:
+        case AttributesTag::EXTXSERVERCONTROL:
+        case AttributesTag::EXTXSKIP:
             return new (std::nothrow) AttributesTag(exttagmapping[i].i, value);
         }
 
@@ -58,6 +58,18 @@ static void Close(vlc_object_t *);
     "If non empty and image-decode is true, the image will be " \
     "converted to the specified chroma.")
 
+#define WIDTH_TEXT N_("Width")
+#define WIDTH_LONGTEXT N_( \
+    "If non zero and image-decode is true, the image will be scaled to " \
+    "this width. JPEG images are scaled down while decoding, which is much " \
+    "faster for large photos shown on a smaller display.")
+
+#define HEIGHT_TEXT N_("Height")
+#define HEIGHT_LONGTEXT N_( \
+    "If non zero and image-decode is true, the image will be scaled to " \
+    "this height. If only one of the width and height is set, the aspect " \
+    "ratio is preserved.")
+
 #define DURATION_TEXT N_("Duration in seconds")
 #define DURATION_LONGTEXT N_( \
     "Duration in seconds before simulating an end of file. " \
@@ -85,6 +97,12 @@ vlc_module_begin()
         change_safe()
     add_string("image-chroma", "", CHROMA_TEXT, CHROMA_LONGTEXT, true)
         change_safe()
+    add_integer("image-width", 0, WIDTH_TEXT, WIDTH_LONGTEXT, true)
+        change_integer_range(0, 16384)
+        change_safe()
+    add_integer("image-height", 0, HEIGHT_TEXT, HEIGHT_LONGTEXT, true)
+        change_integer_range(0, 16384)
+        change_safe()
     add_float("image-duration", 10, DURATION_TEXT, DURATION_LONGTEXT, false)
         change_safe()
     add_string("image-fps", "10/1", FPS_TEXT, FPS_LONGTEXT, true)
@@ -148,6 +166,8 @@ static block_t *Decode(demux_t *demux,
 
     video_format_t decoded;
     video_format_Init(&decoded, chroma);
+    decoded.i_width  = var_InheritInteger(demux, "image-width");
+    decoded.i_height = var_InheritInteger(demux, "image-height");
 
     picture_t *image = image_Read(handler, data, fmt, &decoded);
     image_HandlerDelete(handler);
@@ -28,6 +28,11 @@
 #include "Ebml_parser.hpp"
 
 #include <vlc_actions.h>
+#include <vlc_configuration.h>
+#include <vlc_fs.h>
+#include <vlc_md5.h>
+
+#include <sys/stat.h>
 
 event_thread_t::event_thread_t(demux_t *p_demux) : p_demux(p_demux)
 {
@@ -431,6 +436,7 @@ void *event_thread_t::EventThread(void *data)
 
 demux_sys_t::~demux_sys_t()
 {
+    SaveSeekIndex();
     CleanUi();
     size_t i;
     for ( i=0; i<streams.size(); i++ )
@@ -592,6 +598,181 @@ void demux_sys_t::CleanUi()
     msg_Dbg( &demuxer, "Stopping the UI Hook" );
 }
 
+bool demux_sys_t::LoadAttachments()
+{
+    bool b_loaded = false;
+    for( size_t i = 0; i < opened_segments.size(); i++ )
+        b_loaded |= opened_segments[i]->LoadAttachments();
+    b_attachments_pending = false;
+    return b_loaded;
+}
+
+bool demux_sys_t::NeedAttachments() const
+{
+    /* the SSA decoders look for their fonts when they are created */
+    for( size_t i = 0; i < opened_segments.size(); i++ )
+    {
+        const matroska_segment_c::tracks_map_t & tracks = opened_segments[i]->tracks;
+        for( matroska_segment_c::tracks_map_t::const_iterator it = tracks.begin();
+             it != tracks.end(); ++it )
+        {
+            if( it->second->fmt.i_codec == VLC_CODEC_SSA )
+                return true;
+        }
+    }
+    return false;
+}
+
+#define SEEK_INDEX_DIR        "mkv-index"
+#define SEEK_INDEX_HEAD       (64 * 1024)
+#define SEEK_INDEX_MAXENTRIES 64
+
+static std::string SeekIndexDir()
+{
+    std::string dir;
+    char *psz_dir = config_GetUserDir( VLC_CACHE_DIR );
+    if( psz_dir )
+    {
+        dir = std::string( psz_dir ) + DIR_SEP + SEEK_INDEX_DIR;
+        free( psz_dir );
+    }
+    return dir;
+}
+
+void demux_sys_t::InitSeekIndex()
+{
+    /* local files only: remote ones have no date to tell revisions apart */
+    struct stat st;
+    if( !var_InheritBool( &demuxer, "mkv-seek-index-cache" )
+     || demuxer.psz_file == NULL || vlc_stat( demuxer.psz_file, &st ) )
+        return;
+
+    /* identify the file by its size, date and head, the path may change */
+    uint64_t i_size;
+    if( vlc_stream_GetSize( demuxer.s, &i_size ) || i_size == 0 )
+        return;
+
+    const uint8_t *p_peek;
+    ssize_t i_peek = vlc_stream_Peek( demuxer.s, &p_peek, SEEK_INDEX_HEAD );
+    if( i_peek <= 0 )
+        return;
+
+    int64_t i_mtime = st.st_mtime;
+
+    struct md5_s md5;
+    InitMD5( &md5 );
+    AddMD5( &md5, &i_size, sizeof(i_size) );
+    AddMD5( &md5, &i_mtime, sizeof(i_mtime) );
+    AddMD5( &md5, p_peek, i_peek );
+    EndMD5( &md5 );
+
+    char *psz_hash = psz_md5_hash( &md5 );
+    if( psz_hash )
+    {
+        seek_index_key = psz_hash;
+        free( psz_hash );
+    }
+}
+
+static std::string SeekIndexPath( const std::string & key, const matroska_segment_c & segment )
+{
+    std::string dir = SeekIndexDir();
+    if( dir.empty() )
+        return dir;
+    char psz_pos[24];
+    snprintf( psz_pos, sizeof(psz_pos), "%" PRIu64, segment.segment->GetElementPosition() );
+    return dir + DIR_SEP + key + "-" + psz_pos + ".idx";
+}
+
+void demux_sys_t::LoadSeekIndex()
+{
+    if( seek_index_key.empty() || p_current_vsegment == NULL || streams.empty() )
+        return;
+
+    /* only the main file segment, and only when it has no cues to rely on */
+    matroska_segment_c *p_segment = p_current_vsegment->CurrentSegment();
+    if( p_segment == NULL || p_segment->b_cues || &p_segment->es != &streams[0]->estream )
+        return;
+
+    p_indexed_segment = p_segment;
+
+    const std::string path = SeekIndexPath( seek_index_key, *p_segment );
+    if( path.empty() )
+        return;
+
+    FILE *fp = vlc_fopen( path.c_str(), "r" );
+    if( fp )
+    {
+        uint64_t i_size;
+        if( vlc_stream_GetSize( demuxer.s, &i_size ) == VLC_SUCCESS &&
+            p_segment->LoadSeekIndex( fp, i_size ) )
+            msg_Dbg( &demuxer, "loaded cached seek index %s", path.c_str() );
+        else
+            msg_Warn( &demuxer, "ignoring invalid seek index %s", path.c_str() );
+        fclose( fp );
+    }
+    i_index_size = p_segment->SeekIndexSize();
+}
+
+void demux_sys_t::SaveSeekIndex()
+{
+    if( p_indexed_segment == NULL || p_indexed_segment->SeekIndexSize() <= i_index_size )
+        return;
+
+    const std::string dir = SeekIndexDir();
+    if( dir.empty() )
+        return;
+
+    char *psz_cachedir = config_GetUserDir( VLC_CACHE_DIR );
+    if( psz_cachedir )
+    {
+        vlc_mkdir( psz_cachedir, 0700 );
+        free( psz_cachedir );
+    }
+    vlc_mkdir( dir.c_str(), 0700 );
+
+    /* drop the oldest indexes */
+    DIR *p_dir = vlc_opendir( dir.c_str() );
+    if( p_dir )
+    {
+        std::vector<std::pair<time_t, std::string> > files;
+        const char *psz_file;
+        while( (psz_file = vlc_readdir( p_dir )) != NULL )
+        {
+            std::string file = dir + DIR_SEP + psz_file;
+            struct stat st;
+            if( file.size() > 4 && !file.compare( file.size() - 4, 4, ".idx" ) &&
+                vlc_stat( file.c_str(), &st ) == 0 )
+                files.push_back( std::make_pair( st.st_mtime, file ) );
+        }
+        closedir( p_dir );
+
+        if( files.size() >= SEEK_INDEX_MAXENTRIES )
+        {
+            std::sort( files.begin(), files.end() );
+            for( size_t i = 0; i <= files.size() - SEEK_INDEX_MAXENTRIES; i++ )
+                vlc_unlink( files[i].second.c_str() );
+        }
+    }
+
+    /* write aside then rename, as concurrent sessions may race */
+    const std::string path = SeekIndexPath( seek_index_key, *p_indexed_segment );
+    const std::string tmppath = path + ".tmp";
+    FILE *fp = vlc_fopen( tmppath.c_str(), "w" );
+    if( !fp )
+    {
+        msg_Warn( &demuxer, "cannot write seek index %s", tmppath.c_str() );
+        return;
+    }
+
+    bool b_ok = p_indexed_segment->SaveSeekIndex( fp );
+    if( fclose( fp ) != 0 || !b_ok ||
+        vlc_rename( tmppath.c_str(), path.c_str() ) != 0 )
+        vlc_unlink( tmppath.c_str() );
+    else
+        msg_Dbg( &demuxer, "saved seek index %s", path.c_str() );
+}
+
 void demux_sys_t::PreloadFamily( const matroska_segment_c & of_segment )
 {
     for (size_t i=0; i<opened_segments.size(); i++)
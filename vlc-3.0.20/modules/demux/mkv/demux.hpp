@@ -342,6 +342,9 @@ public:
         ,f_duration(-1.0)
         ,p_input(NULL)
         ,p_ev(NULL)
+        ,p_indexed_segment(NULL)
+        ,i_index_size(0)
+        ,b_attachments_pending(false)
     {
         vlc_mutex_init( &lock_demuxer );
     }
@@ -390,6 +393,13 @@ public:
     void InitUi();
     void CleanUi();
 
+    bool LoadAttachments();
+    bool NeedAttachments() const;
+
+    void InitSeekIndex();
+    void LoadSeekIndex();
+    void SaveSeekIndex();
+
     /* for spu variables */
     input_thread_t *p_input;
     uint8_t        palette[4][4];
@@ -397,6 +407,14 @@ public:
 
     /* event */
     event_thread_t *p_ev;
+
+    /* seek index cache, for files without cues */
+    std::string        seek_index_key;
+    matroska_segment_c *p_indexed_segment;
+    size_t             i_index_size;
+
+    /* attachments are parsed once playback started */
+    bool               b_attachments_pending;
 };
 
 
@@ -28,6 +28,7 @@
 #include "util.hpp"
 #include "Ebml_parser.hpp"
 #include "Ebml_dispatcher.hpp"
+#include "stream_io_callback.hpp"
 
 #include <new>
 #include <iterator>
@@ -62,11 +63,15 @@ matroska_segment_c::matroska_segment_c( demux_sys_t & demuxer, EbmlStream & estr
     ,ep( EbmlParser(&estream, p_seg, &demuxer.demuxer ))
     ,b_preloaded(false)
     ,b_ref_external_segments(false)
+    ,b_attachments_parsed(false)
+    ,p_block_data(NULL)
 {
 }
 
 matroska_segment_c::~matroska_segment_c()
 {
+    if( p_block_data )
+        block_Release( p_block_data );
     free( psz_writing_application );
     free( psz_muxing_application );
     free( psz_segment_filename );
@@ -527,6 +532,26 @@ bool matroska_segment_c::PreloadClusters(uint64 i_cluster_pos)
     return true;
 }
 
+/* Attachments can be huge (fonts, covers) and are not needed to start
+ * playback, so only their position is kept while preloading */
+bool matroska_segment_c::CanSeekBack() const
+{
+    bool b_seekable;
+
+    if( vlc_stream_Control( sys.demuxer.s, STREAM_CAN_SEEK, &b_seekable ) )
+        return false;
+    return b_seekable;
+}
+
+bool matroska_segment_c::LoadAttachments()
+{
+    if( b_attachments_parsed || i_attachments_position < 0 || !CanSeekBack() )
+        return false;
+
+    return LoadSeekHeadItem( EBML_INFO(KaxAttachments), i_attachments_position ) &&
+           b_attachments_parsed;
+}
+
 bool matroska_segment_c::PreloadFamily( const matroska_segment_c & of_segment )
 {
     if ( b_preloaded )
@@ -667,8 +692,13 @@ bool matroska_segment_c::Preload( )
             msg_Dbg( &sys.demuxer, "|   + Attachments" );
             if( i_attachments_position < 0 )
             {
-                ParseAttachments( ka_ptr );
                 i_attachments_position = el->GetElementPosition();
+                /* parsed on demand when we can come back, see LoadAttachments */
+                if( !CanSeekBack() )
+                {
+                    ParseAttachments( ka_ptr );
+                    b_attachments_parsed = true;
+                }
             }
         }
         else if( MKV_CHECKED_PTR_DECL ( kc_ptr, KaxChapters, el ) )
@@ -770,10 +800,11 @@ bool matroska_segment_c::LoadSeekHeadItem( const EbmlCallbacks & ClassInfos, int
     else if( MKV_CHECKED_PTR_DECL ( ka_ptr, KaxAttachments, el ) )
     {
         msg_Dbg( &sys.demuxer, "|   + Attachments" );
-        if( i_attachments_position < 0 )
+        if( !b_attachments_parsed )
         {
             ParseAttachments( ka_ptr );
             i_attachments_position = i_element_position;
+            b_attachments_parsed = true;
         }
     }
     else if( MKV_CHECKED_PTR_DECL ( kc_ptr, KaxChapters, el ) )
@@ -910,6 +941,67 @@ bool matroska_segment_c::Seek( demux_t &demuxer, vlc_tick_t i_absolute_mk_date,
 }
 
 
+/* Unlaced and uncompressed SimpleBlocks hold a single frame that can be
+ * read straight into a block_t, only the header goes through libmatroska */
+bool matroska_segment_c::ReadSimpleBlockData( KaxSimpleBlock & ksblock )
+{
+    vlc_stream_io_callback & io = static_cast<vlc_stream_io_callback &>( es.I_O() );
+    const uint64 i_data_pos = io.getFilePointer();
+
+    const uint8_t *p_peek;
+    if( io.peek( &p_peek, 5 ) < 5 )
+        return false;
+
+    unsigned i_track;
+    size_t   i_header;
+    if( p_peek[0] & 0x80 )
+    {
+        i_track  = p_peek[0] & 0x7F;
+        i_header = 4;
+    }
+    else if( p_peek[0] & 0x40 )
+    {
+        i_track  = ( ( p_peek[0] & 0x3F ) << 8 ) | p_peek[1];
+        i_header = 5;
+    }
+    else
+        return false;
+
+    /* laced */
+    if( ksblock.GetSize() <= i_header || ( p_peek[i_header - 1] & 0x06 ) )
+        return false;
+
+    tracks_map_t::const_iterator it = tracks.find( i_track );
+    if( it == tracks.end() )
+        return false;
+
+    const mkv_track_t & track = *it->second;
+    if( track.i_compression_type != MATROSKA_COMPRESSION_NONE ||
+        track.fmt.i_codec == VLC_CODEC_PRORES || track.fmt.i_codec == VLC_CODEC_WAVPACK )
+        return false;
+
+    try
+    {
+        ksblock.ReadData( io, SCOPE_PARTIAL_DATA );
+    }
+    catch(...)
+    {
+        io.setFilePointer( i_data_pos );
+        return false;
+    }
+
+    io.setFilePointer( i_data_pos + i_header );
+    block_t *p_block = io.readBlock( ksblock.GetSize() - i_header );
+    if( p_block == NULL )
+    {
+        io.setFilePointer( i_data_pos );
+        return false;
+    }
+
+    p_block_data = p_block;
+    return true;
+}
+
 mkv_track_t * matroska_segment_c::FindTrackByBlock(
                                              const KaxBlock *p_block, const KaxSimpleBlock *p_simpleblock )
 {
@@ -1189,6 +1281,12 @@ int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_s
     *pb_discardable_picture = false;
     *pi_duration = 0;
 
+    if( p_block_data )
+    {
+        block_Release( p_block_data );
+        p_block_data = NULL;
+    }
+
     struct BlockPayload {
         matroska_segment_c * const obj;
         EbmlParser         * const ep;
@@ -1259,7 +1357,8 @@ int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_s
             }
 
             vars.simpleblock = &ksblock;
-            vars.simpleblock->ReadData( vars.obj->es.I_O() );
+            if( !vars.obj->ReadSimpleBlockData( ksblock ) )
+                vars.simpleblock->ReadData( vars.obj->es.I_O() );
             vars.simpleblock->SetParent( *vars.obj->cluster );
 
             if( ksblock.IsKeyframe() )
@@ -136,8 +136,14 @@ public:
     EbmlParser                     ep;
     bool                           b_preloaded;
     bool                           b_ref_external_segments;
+    bool                           b_attachments_parsed;
+
+    /* payload of the last SimpleBlock when it was read directly */
+    block_t                        *p_block_data;
 
     bool Preload();
+    bool LoadAttachments();
+    bool CanSeekBack() const;
     bool PreloadFamily( const matroska_segment_c & segment );
     bool PreloadClusters( uint64 i_cluster_position );
     void InformationCreate();
@@ -156,6 +162,11 @@ public:
 
     bool SameFamily( const matroska_segment_c & of_segment ) const;
 
+    /* seek index built while playing, persisted when there are no cues */
+    bool LoadSeekIndex( FILE *fp, uint64_t i_max_pos ) { return _seeker.load_index( fp, i_max_pos ); }
+    bool SaveSeekIndex( FILE *fp ) const { return _seeker.save_index( fp ); }
+    size_t SeekIndexSize() const { return _seeker.index_size(); }
+
 private:
     void LoadCues( KaxCues *cues );
     void LoadTags( KaxTags *tags );
@@ -168,6 +179,7 @@ private:
     void ParseChapterAtom( int i_level, KaxChapterAtom *ca, chapter_item_c & chapters );
     void ParseTrackEntry( const KaxTrackEntry* m );
     bool ParseCluster( KaxCluster *cluster, bool b_update_start_time = true, ScopeMode read_fully = SCOPE_ALL_DATA );
+    bool ReadSimpleBlockData( KaxSimpleBlock & );
     bool ParseSimpleTags( SimpleTag* out, KaxTagSimple *tag, int level = 50 );
     void IndexAppendCluster( KaxCluster *cluster );
     bool TrackInit( mkv_track_t * p_tk );
@@ -151,7 +151,9 @@ void matroska_segment_c::ParseSeekHead( KaxSeekHead *seekhead )
                 else if( id == EBML_ID(KaxCues) )
                 {
                     msg_Dbg( &sys.demuxer, "|   - cues at %" PRId64, i_pos );
-                    LoadSeekHeadItem( EBML_INFO(KaxCues), i_pos );
+                    /* only needed to seek */
+                    if( !sys.demuxer.b_preparse_lite )
+                        LoadSeekHeadItem( EBML_INFO(KaxCues), i_pos );
                 }
                 else if( id == EBML_ID(KaxInfo) )
                 {
@@ -181,7 +183,9 @@ void matroska_segment_c::ParseSeekHead( KaxSeekHead *seekhead )
                 else if( id == EBML_ID(KaxAttachments) )
                 {
                     msg_Dbg( &sys.demuxer, "|   - attachments at %" PRId64, i_pos );
-                    LoadSeekHeadItem( EBML_INFO(KaxAttachments), i_pos );
+                    /* parsed on demand, see LoadAttachments */
+                    if( i_attachments_position < 0 )
+                        i_attachments_position = i_pos;
                 }
 #ifdef MKV_DEBUG
                 else if( id != EBML_ID(KaxCluster) && id != EBML_ID(EbmlVoid) &&
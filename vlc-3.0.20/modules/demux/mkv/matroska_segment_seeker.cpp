@@ -523,3 +523,115 @@ SegmentSeeker::mkv_jump_to( matroska_segment_c& ms, fptr_t fpos )
     ms.es.I_O().setFilePointer( fpos );
 }
 
+
+#define INDEX_HEADER "VLC mkv index 1"
+
+bool
+SegmentSeeker::load_index( FILE *fp, fptr_t max_fpos )
+{
+    char header[sizeof(INDEX_HEADER)];
+    if( fgets( header, sizeof(header), fp ) == NULL || strcmp( header, INDEX_HEADER ) )
+        return false;
+
+    /* the index is identified by the file size, so any position past the
+     * end means it is corrupted: parse aside and keep all or nothing */
+    SegmentSeeker loaded( *this );
+
+    char type;
+    while( fscanf( fp, " %c", &type ) == 1 )
+    {
+        uint64_t fpos, end;
+        int64_t  pts, duration;
+        unsigned track_id;
+        int      trust;
+
+        switch( type )
+        {
+            case 'R':
+                if( fscanf( fp, "%" SCNu64 " %" SCNu64, &fpos, &end ) != 2
+                 || fpos > end || fpos > max_fpos )
+                    return false;
+                loaded.mark_range_as_searched( Range( fpos, std::min( end, max_fpos ) ) );
+                break;
+            case 'S':
+                if( fscanf( fp, "%u %" SCNu64 " %" SCNd64 " %d",
+                            &track_id, &fpos, &pts, &trust ) != 4
+                 || fpos >= max_fpos )
+                    return false;
+                switch( trust )
+                {
+                    case Seekpoint::TRUSTED:
+                    case Seekpoint::QUESTIONABLE:
+                        loaded.add_seekpoint( track_id, Seekpoint( fpos, pts,
+                                              static_cast<Seekpoint::TrustLevel>( trust ) ) );
+                        break;
+                    case Seekpoint::DISABLED:
+                        break;
+                    default:
+                        return false;
+                }
+                break;
+            case 'P':
+                if( fscanf( fp, "%" SCNu64, &fpos ) != 1 || fpos >= max_fpos )
+                    return false;
+                if( !std::binary_search( loaded._cluster_positions.begin(),
+                                         loaded._cluster_positions.end(), fpos ) )
+                    loaded.add_cluster_position( fpos );
+                break;
+            case 'C':
+            {
+                if( fscanf( fp, "%" SCNu64 " %" SCNd64 " %" SCNd64 " %" SCNu64,
+                            &fpos, &pts, &duration, &end ) != 4
+                 || fpos >= max_fpos )
+                    return false;
+                Cluster cinfo = { fpos, pts, duration, end };
+                loaded._clusters.insert( cluster_map_t::value_type( pts, cinfo ) );
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    if( ferror( fp ) )
+        return false;
+
+    _ranges_searched.swap( loaded._ranges_searched );
+    _tracks_seekpoints.swap( loaded._tracks_seekpoints );
+    _cluster_positions.swap( loaded._cluster_positions );
+    _clusters.swap( loaded._clusters );
+    return true;
+}
+
+bool
+SegmentSeeker::save_index( FILE *fp ) const
+{
+    fputs( INDEX_HEADER "\n", fp );
+
+    for( ranges_t::const_iterator it = _ranges_searched.begin(); it != _ranges_searched.end(); ++it )
+        fprintf( fp, "R %" PRIu64 " %" PRIu64 "\n", it->start, it->end );
+
+    for( tracks_seekpoints_t::const_iterator it = _tracks_seekpoints.begin(); it != _tracks_seekpoints.end(); ++it )
+    {
+        for( seekpoints_t::const_iterator sp = it->second.begin(); sp != it->second.end(); ++sp )
+            fprintf( fp, "S %u %" PRIu64 " %" PRId64 " %d\n",
+                     it->first, sp->fpos, sp->pts, static_cast<int>( sp->trust_level ) );
+    }
+
+    for( cluster_positions_t::const_iterator it = _cluster_positions.begin(); it != _cluster_positions.end(); ++it )
+        fprintf( fp, "P %" PRIu64 "\n", *it );
+
+    for( cluster_map_t::const_iterator it = _clusters.begin(); it != _clusters.end(); ++it )
+        fprintf( fp, "C %" PRIu64 " %" PRId64 " %" PRId64 " %" PRIu64 "\n",
+                 it->second.fpos, it->second.pts, it->second.duration, it->second.size );
+
+    return !ferror( fp );
+}
+
+size_t
+SegmentSeeker::index_size() const
+{
+    size_t size = _cluster_positions.size() + _clusters.size();
+    for( tracks_seekpoints_t::const_iterator it = _tracks_seekpoints.begin(); it != _tracks_seekpoints.end(); ++it )
+        size += it->second.size();
+    return size;
+}
@@ -30,6 +30,7 @@
 #include <vector>
 #include <map>
 #include <limits>
+#include <cstdio>
 
 class matroska_segment_c;
 
@@ -118,6 +119,11 @@ class SegmentSeeker
         void mark_range_as_searched( Range );
         ranges_t get_search_areas( fptr_t start, fptr_t end ) const;
 
+        // persistent index, for files without cues
+        bool load_index( FILE *, fptr_t max_fpos );
+        bool save_index( FILE * ) const;
+        size_t index_size() const;
+
     public:
         ranges_t            _ranges_searched;
         tracks_seekpoints_t _tracks_seekpoints;
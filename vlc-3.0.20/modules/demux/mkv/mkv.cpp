@@ -81,6 +81,10 @@ vlc_module_begin ()
             N_("Preload clusters"),
             N_("Find all cluster positions by jumping cluster-to-cluster before playback"), true );
 
+    add_bool( "mkv-seek-index-cache", false,
+            N_("Cache seek index"),
+            N_("Keep the clusters found while playing local files without cues in the user cache directory, to seek faster the next time."), true );
+
     add_shortcut( "mka", "mkv" )
 vlc_module_end ()
 
@@ -115,6 +119,8 @@ static int Open( vlc_object_t * p_this )
     p_demux->pf_control = Control;
     p_demux->p_sys      = p_sys = new demux_sys_t( *p_demux );
 
+    p_sys->InitSeekIndex();
+
     p_stream = new matroska_stream_c( p_demux->s, false );
     if ( unlikely(p_stream == NULL) )
     {
@@ -147,7 +153,8 @@ static int Open( vlc_object_t * p_this )
         goto error;
     }
 
-    if (b_need_preload && var_InheritBool( p_demux, "mkv-preload-local-dir" ))
+    if (b_need_preload && !p_demux->b_preparse_lite &&
+        var_InheritBool( p_demux, "mkv-preload-local-dir" ))
     {
         msg_Dbg( p_demux, "Preloading local dir" );
         /* get the files from the same dir from the same family (based on p_demux->psz_path) */
@@ -251,6 +258,14 @@ static int Open( vlc_object_t * p_this )
         goto error;
     }
 
+    if( ( p_demux->b_preparsing && !p_demux->b_preparse_lite ) ||
+        p_sys->NeedAttachments() )
+        p_sys->LoadAttachments();
+    else
+        p_sys->b_attachments_pending = true;
+
+    if( !p_demux->b_preparse_lite )
+        p_sys->LoadSeekIndex();
     p_sys->InitUi();
 
     return VLC_SUCCESS;
@@ -536,37 +551,54 @@ void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock
     else
         block_size = block->GetSize();
 
-    const unsigned int i_number_frames = block != NULL ? block->NumberFrames() :
+    /* single frame already read from the stream */
+    block_t *p_direct = NULL;
+    if( simpleblock != NULL )
+    {
+        p_direct = p_segment->p_block_data;
+        p_segment->p_block_data = NULL;
+    }
+
+    const unsigned int i_number_frames = p_direct != NULL ? 1 :
+            block != NULL ? block->NumberFrames() :
             ( simpleblock != NULL ? simpleblock->NumberFrames() : 0 );
 
     for( unsigned int i_frame = 0; i_frame < i_number_frames; i_frame++ )
     {
         block_t *p_block;
-        DataBuffer *data;
-        if( simpleblock != NULL )
+        if( p_direct != NULL )
         {
-            data = &simpleblock->GetBuffer(i_frame);
+            p_block = p_direct;
+            p_direct = NULL;
         }
         else
         {
-            data = &block->GetBuffer(i_frame);
-        }
-        frame_size += data->Size();
-        if( !data->Buffer() || data->Size() > frame_size || frame_size > block_size  )
-        {
-            msg_Warn( p_demux, "Cannot read frame (too long or no frame)" );
-            break;
+            DataBuffer *data;
+            if( simpleblock != NULL )
+            {
+                data = &simpleblock->GetBuffer(i_frame);
+            }
+            else
+            {
+                data = &block->GetBuffer(i_frame);
+            }
+            frame_size += data->Size();
+            if( !data->Buffer() || data->Size() > frame_size || frame_size > block_size  )
+            {
+                msg_Warn( p_demux, "Cannot read frame (too long or no frame)" );
+                break;
+            }
+            size_t extra_data = track.fmt.i_codec == VLC_CODEC_PRORES ? 8 : 0;
+
+            if( track.i_compression_type == MATROSKA_COMPRESSION_HEADER &&
+                track.p_compression_data != NULL &&
+                track.i_encoding_scope & MATROSKA_ENCODING_SCOPE_ALL_FRAMES )
+                p_block = MemToBlock( data->Buffer(), data->Size(), track.p_compression_data->GetSize() + extra_data );
+            else if( unlikely( track.fmt.i_codec == VLC_CODEC_WAVPACK ) )
+                p_block = packetize_wavpack( track, data->Buffer(), data->Size() );
+            else
+                p_block = MemToBlock( data->Buffer(), data->Size(), extra_data );
         }
-        size_t extra_data = track.fmt.i_codec == VLC_CODEC_PRORES ? 8 : 0;
-
-        if( track.i_compression_type == MATROSKA_COMPRESSION_HEADER &&
-            track.p_compression_data != NULL &&
-            track.i_encoding_scope & MATROSKA_ENCODING_SCOPE_ALL_FRAMES )
-            p_block = MemToBlock( data->Buffer(), data->Size(), track.p_compression_data->GetSize() + extra_data );
-        else if( unlikely( track.fmt.i_codec == VLC_CODEC_WAVPACK ) )
-            p_block = packetize_wavpack( track, data->Buffer(), data->Size() );
-        else
-            p_block = MemToBlock( data->Buffer(), data->Size(), extra_data );
 
         if( p_block == NULL )
         {
@@ -729,6 +761,13 @@ static int Demux( demux_t *p_demux)
         p_vsegment = p_sys->p_current_vsegment;
     }
 
+    if( p_sys->b_attachments_pending && p_sys->i_pcr != VLC_TICK_INVALID )
+    {
+        /* the input fetches the attachments again with the meta */
+        if( p_sys->LoadAttachments() )
+            p_demux->info.i_update |= INPUT_UPDATE_META;
+    }
+
     matroska_segment_c *p_segment = p_vsegment->CurrentSegment();
     if ( p_segment == NULL )
         return 0;
@@ -34,6 +34,33 @@ vlc_stream_io_callback::vlc_stream_io_callback( stream_t *s_, bool b_owner_ )
                        : s( s_), b_owner( b_owner_ )
 {
     mb_eof = false;
+    /* only read ahead where it cannot add latency */
+    if( vlc_stream_Control( s, STREAM_CAN_FASTSEEK, &b_window ) )
+        b_window = false;
+    p_window = NULL;
+    i_window = i_window_pos = 0;
+}
+
+void vlc_stream_io_callback::Commit( void )
+{
+    if( i_window_pos > 0 )
+        vlc_stream_Read( s, NULL, i_window_pos );
+    p_window = NULL;
+    i_window = i_window_pos = 0;
+}
+
+bool vlc_stream_io_callback::Fill( void )
+{
+    Commit();
+
+    ssize_t i_peek = vlc_stream_Peek( s, &p_window, WINDOW_SIZE );
+    if( i_peek <= 0 )
+    {
+        p_window = NULL;
+        return false;
+    }
+    i_window = i_peek;
+    return true;
 }
 
 uint32 vlc_stream_io_callback::read( void *p_buffer, size_t i_size )
@@ -41,14 +68,24 @@ uint32 vlc_stream_io_callback::read( void *p_buffer, size_t i_size )
     if( i_size <= 0 || mb_eof )
         return 0;
 
-    int i_ret = vlc_stream_Read( s, p_buffer, i_size );
-    return i_ret < 0 ? 0 : i_ret;
+    if( i_size > i_window - i_window_pos &&
+        ( !b_window || i_size > WINDOW_SIZE / 4 || !Fill() ) )
+    {
+        Commit();
+        int i_ret = vlc_stream_Read( s, p_buffer, i_size );
+        return i_ret < 0 ? 0 : i_ret;
+    }
+
+    i_size = __MIN( i_size, i_window - i_window_pos );
+    memcpy( p_buffer, &p_window[i_window_pos], i_size );
+    i_window_pos += i_size;
+    return i_size;
 }
 
 void vlc_stream_io_callback::setFilePointer(int64_t i_offset, seek_mode mode )
 {
     int64_t i_pos, i_size;
-    int64_t i_current = vlc_stream_Tell( s );
+    int64_t i_current = getFilePointer();
 
     switch( mode )
     {
@@ -64,7 +101,22 @@ void vlc_stream_io_callback::setFilePointer(int64_t i_offset, seek_mode mode )
     }
 
     if(i_pos == i_current)
+    {
+        /* a failed seek leaves the stream where it was: going back there
+         * (e.g. after a failed seek head item load) is valid again */
+        mb_eof = false;
+        return;
+    }
+
+    /* move within the window */
+    const int64_t i_window_start = i_current - i_window_pos;
+    if( i_pos >= i_window_start && i_pos < i_window_start + (int64_t) i_window )
+    {
+        i_window_pos = i_pos - i_window_start;
+        mb_eof = false;
         return;
+    }
+    Commit();
 
     if( i_pos < 0 || ( ( i_size = stream_Size( s ) ) != 0 && i_pos >= i_size ) )
     {
@@ -84,7 +136,35 @@ uint64 vlc_stream_io_callback::getFilePointer( void )
 {
     if ( s == NULL )
         return 0;
-    return vlc_stream_Tell( s );
+    return vlc_stream_Tell( s ) + i_window_pos;
+}
+
+ssize_t vlc_stream_io_callback::peek( const uint8_t **pp_peek, size_t i_size )
+{
+    if( mb_eof )
+        return 0;
+    if( i_size <= i_window - i_window_pos )
+    {
+        *pp_peek = &p_window[i_window_pos];
+        return i_size;
+    }
+    Commit();
+    return vlc_stream_Peek( s, pp_peek, i_size );
+}
+
+block_t * vlc_stream_io_callback::readBlock( size_t i_size )
+{
+    if( i_size == 0 || mb_eof )
+        return NULL;
+
+    Commit();
+    block_t *p_block = vlc_stream_Block( s, i_size );
+    if( p_block != NULL && p_block->i_buffer != i_size )
+    {
+        block_Release( p_block );
+        return NULL;
+    }
+    return p_block;
 }
 
 size_t vlc_stream_io_callback::write(const void *, size_t )
@@ -104,6 +184,6 @@ uint64 vlc_stream_io_callback::toRead( void )
     if( i_size <= 0 )
         return UINT64_MAX;
 
-    return static_cast<uint64>( i_size - vlc_stream_Tell( s ) );
+    return static_cast<uint64>( i_size - getFilePointer() );
 }
 
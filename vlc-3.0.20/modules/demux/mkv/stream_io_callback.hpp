@@ -33,6 +33,17 @@ class vlc_stream_io_callback: public IOCallback
     bool           mb_eof;
     bool           b_owner;
 
+    /* Peeked read-ahead window serving the small EBML header reads.
+     * The stream position lags behind by i_window_pos until Commit() */
+    static const size_t WINDOW_SIZE = 16 * 1024;
+    bool           b_window;
+    const uint8_t  *p_window;
+    size_t         i_window;
+    size_t         i_window_pos;
+
+    void           Commit          ( void );
+    bool           Fill            ( void );
+
   public:
     vlc_stream_io_callback( stream_t *, bool owner );
 
@@ -40,6 +51,8 @@ class vlc_stream_io_callback: public IOCallback
     {
         if( b_owner )
             vlc_stream_Delete( s );
+        else
+            Commit();
     }
 
     bool IsEOF() const { return mb_eof; }
@@ -50,5 +63,9 @@ class vlc_stream_io_callback: public IOCallback
     virtual uint64   getFilePointer  ( void );
     virtual void     close           ( void ) { return; }
     uint64           toRead          ( void );
+
+    /* direct access, to avoid copying the payloads through libmatroska */
+    ssize_t          peek            ( const uint8_t **pp_peek, size_t i_size );
+    block_t *        readBlock       ( size_t i_size );
 };
 
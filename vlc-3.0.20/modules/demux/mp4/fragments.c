@@ -30,6 +30,7 @@ void MP4_Fragments_Index_Delete( mp4_fragments_index_t *p_index )
     {
         free( p_index->pi_pos );
         free( p_index->p_times );
+        free( p_index->p_tracks_end );
         free( p_index );
     }
 }
@@ -43,27 +44,70 @@ mp4_fragments_index_t * MP4_Fragments_Index_New( unsigned i_tracks, unsigned i_n
     {
         p_index->p_times = calloc( (size_t)i_num * i_tracks, sizeof(*p_index->p_times) );
         p_index->pi_pos = calloc( i_num, sizeof(*p_index->pi_pos) );
-        if( !p_index->p_times || !p_index->pi_pos )
+        p_index->p_tracks_end = calloc( i_tracks, sizeof(*p_index->p_tracks_end) );
+        if( !p_index->p_times || !p_index->pi_pos || !p_index->p_tracks_end )
         {
             MP4_Fragments_Index_Delete( p_index );
             return NULL;
         }
-        p_index->i_entries = i_num;
+        p_index->i_entries = 0;
+        p_index->i_alloc = i_num;
         p_index->i_last_time = 0;
         p_index->i_tracks = i_tracks;
+        p_index->i_scan_pos = 0;
     }
     return p_index;
 }
 
-stime_t MP4_Fragment_Index_GetTrackStartTime( mp4_fragments_index_t *p_index,
-                                              unsigned i_track_index, uint64_t i_moof_pos )
+stime_t * MP4_Fragments_Index_Add( mp4_fragments_index_t *p_index, uint64_t i_moof_pos )
 {
-    for( size_t i=0; i<p_index->i_entries; i++ )
+    if( p_index->i_entries &&
+        p_index->pi_pos[p_index->i_entries - 1] >= i_moof_pos )
+        return NULL;
+
+    if( p_index->i_entries == p_index->i_alloc )
     {
-        if( p_index->pi_pos[i] >= i_moof_pos )
-            return p_index->p_times[i * p_index->i_tracks + i_track_index];
+        if( p_index->i_alloc > UINT_MAX / 2 ||
+            SIZE_MAX / p_index->i_tracks / sizeof(*p_index->p_times) < (size_t)p_index->i_alloc * 2 )
+            return NULL;
+        const unsigned i_alloc = p_index->i_alloc * 2;
+
+        uint64_t *pi_pos = realloc( p_index->pi_pos, i_alloc * sizeof(*pi_pos) );
+        if( !pi_pos )
+            return NULL;
+        p_index->pi_pos = pi_pos;
+
+        stime_t *p_times = realloc( p_index->p_times,
+                                    (size_t)i_alloc * p_index->i_tracks * sizeof(*p_times) );
+        if( !p_times )
+            return NULL;
+        p_index->p_times = p_times;
+        p_index->i_alloc = i_alloc;
     }
-    return 0;
+
+    p_index->pi_pos[p_index->i_entries] = i_moof_pos;
+    return &p_index->p_times[(size_t)p_index->i_entries++ * p_index->i_tracks];
+}
+
+bool MP4_Fragment_Index_GetTrackStartTime( const mp4_fragments_index_t *p_index,
+                                           unsigned i_track_index, uint64_t i_moof_pos,
+                                           stime_t *pi_time )
+{
+    size_t i_low = 0, i_high = p_index->i_entries;
+    while( i_low < i_high )
+    {
+        size_t i_mid = i_low + (i_high - i_low) / 2;
+        if( p_index->pi_pos[i_mid] < i_moof_pos )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+
+    if( i_low == p_index->i_entries || p_index->pi_pos[i_low] != i_moof_pos )
+        return false;
+
+    *pi_time = p_index->p_times[i_low * p_index->i_tracks + i_track_index];
+    return true;
 }
 
 stime_t MP4_Fragment_Index_GetTracksDuration( const mp4_fragments_index_t *p_index )
@@ -78,14 +122,22 @@ bool MP4_Fragments_Index_Lookup( mp4_fragments_index_t *p_index, stime_t *pi_tim
         i_track_index >= p_index->i_tracks )
         return false;
 
-    for( size_t i=1; i<p_index->i_entries; i++ )
+    /* last entry starting at or before the time, fragments are in order */
+    size_t i_low = 1, i_high = p_index->i_entries;
+    while( i_low < i_high )
     {
-        if( p_index->p_times[i * p_index->i_tracks + i_track_index] > *pi_time )
-        {
-            *pi_time = p_index->p_times[(i - 1) * p_index->i_tracks + i_track_index];
-            *pi_pos = p_index->pi_pos[i - 1];
-            return true;
-        }
+        size_t i_mid = i_low + (i_high - i_low) / 2;
+        if( p_index->p_times[i_mid * p_index->i_tracks + i_track_index] > *pi_time )
+            i_high = i_mid;
+        else
+            i_low = i_mid + 1;
+    }
+
+    if( i_low < p_index->i_entries )
+    {
+        *pi_time = p_index->p_times[(i_low - 1) * p_index->i_tracks + i_track_index];
+        *pi_pos = p_index->pi_pos[i_low - 1];
+        return true;
     }
 
     *pi_time = p_index->p_times[(size_t)(p_index->i_entries - 1) * p_index->i_tracks];
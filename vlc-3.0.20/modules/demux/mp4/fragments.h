@@ -28,15 +28,24 @@ typedef struct mp4_fragments_index_t
     uint64_t *pi_pos;
     stime_t  *p_times; // movie scaled
     unsigned i_entries;
+    unsigned i_alloc;
     stime_t i_last_time; // movie scaled
     unsigned i_tracks;
+    /* incremental building */
+    stime_t  *p_tracks_end; // track scaled, end of the last fragment
+    uint64_t i_scan_pos;    // where the next moof lookup starts
 } mp4_fragments_index_t;
 
 void MP4_Fragments_Index_Delete( mp4_fragments_index_t *p_index );
 mp4_fragments_index_t * MP4_Fragments_Index_New( unsigned i_tracks, unsigned i_num );
 
-stime_t MP4_Fragment_Index_GetTrackStartTime( mp4_fragments_index_t *p_index,
-                                              unsigned i_track_index, uint64_t i_moof_pos );
+/* Appends a moof entry, which must be past the last one.
+ * Returns the tracks start times row to fill, or NULL */
+stime_t * MP4_Fragments_Index_Add( mp4_fragments_index_t *p_index, uint64_t i_moof_pos );
+
+bool MP4_Fragment_Index_GetTrackStartTime( const mp4_fragments_index_t *p_index,
+                                           unsigned i_track_index, uint64_t i_moof_pos,
+                                           stime_t *pi_time );
 stime_t MP4_Fragment_Index_GetTracksDuration( const mp4_fragments_index_t *p_index );
 
 bool MP4_Fragments_Index_Lookup( mp4_fragments_index_t *p_index,
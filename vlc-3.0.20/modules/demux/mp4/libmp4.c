@@ -5028,6 +5028,50 @@ MP4_Box_t *MP4_BoxGetNextChunk( stream_t *s )
     return p_fakeroot;
 }
 
+/* moov children are many small boxes, some of them only partially read.
+ * Every skip within moov turns into a new request on network streams, so
+ * fetch the whole box at once and parse it from memory */
+#define MP4_MOOV_BUFFERED_MAX (32 << 20)
+
+static int MP4_ReadBoxMoovBuffered( stream_t *p_stream, MP4_Box_t *p_father )
+{
+    MP4_Box_t peekbox = { 0 };
+    bool b_restrictionhit = false;
+
+    if( !MP4_PeekBoxHeader( p_stream, &peekbox ) || peekbox.i_type != ATOM_moov )
+        return 1; /* nothing to load, the rest of the file will tell */
+
+    if( peekbox.i_size >= 8 && peekbox.i_size <= MP4_MOOV_BUFFERED_MAX )
+    {
+        block_t *p_block = vlc_stream_Block( p_stream, peekbox.i_size );
+        if( p_block && p_block->i_buffer == peekbox.i_size )
+        {
+            stream_t *p_substream = vlc_stream_MemoryNew( p_stream, p_block->p_buffer,
+                                                          p_block->i_buffer, true );
+            if( p_substream )
+            {
+                MP4_Box_t *p_box = MP4_ReadBoxRestricted( p_substream, p_father,
+                                                          NULL, NULL, &b_restrictionhit );
+                vlc_stream_Delete( p_substream );
+                block_Release( p_block );
+                /* do pos fixup */
+                if( p_box )
+                    MP4_BoxOffsetUp( p_box, peekbox.i_pos );
+                return 1;
+            }
+        }
+        if( p_block )
+            block_Release( p_block );
+
+        /* truncated or no memory, let the regular reader handle it */
+        if( MP4_Seek( p_stream, peekbox.i_pos ) )
+            return 0;
+    }
+
+    MP4_ReadBoxRestricted( p_stream, p_father, NULL, NULL, &b_restrictionhit );
+    return 1;
+}
+
 /*****************************************************************************
  * MP4_BoxGetRoot : Parse the entire file, and create all boxes in memory
  *****************************************************************************
@@ -5048,13 +5092,14 @@ MP4_Box_t *MP4_BoxGetRoot( stream_t *p_stream )
         p_vroot->i_size = i_size;
 
     /* First get the moov */
+    const uint32_t moovlist[] = { ATOM_moov, 0 };
     {
-        const uint32_t stoplist[] = { ATOM_moov, ATOM_mdat, 0 };
-        i_result = MP4_ReadBoxContainerChildren( p_stream, p_vroot, stoplist );
+        const uint32_t stoplist[] = { ATOM_mdat, 0 };
+        i_result = MP4_ReadBoxContainerRestricted( p_stream, p_vroot, stoplist, moovlist );
     }
 
     /* mdat appeared first */
-    if( i_result && !MP4_BoxGet( p_vroot, "moov" ) )
+    if( i_result && p_vroot->p_last && p_vroot->p_last->i_type == ATOM_mdat )
     {
         bool b_seekable;
         if( vlc_stream_Control( p_stream, STREAM_CAN_SEEK, &b_seekable ) != VLC_SUCCESS || !b_seekable )
@@ -5064,10 +5109,13 @@ MP4_Box_t *MP4_BoxGetRoot( stream_t *p_stream )
         }
 
         /* continue loading up to moov */
-        const uint32_t stoplist[] = { ATOM_moov, 0 };
-        i_result = MP4_ReadBoxContainerChildren( p_stream, p_vroot, stoplist );
+        i_result = MP4_ReadBoxContainerRestricted( p_stream, p_vroot, NULL, moovlist );
     }
 
+    /* stopped right before moov */
+    if( i_result )
+        i_result = MP4_ReadBoxMoovBuffered( p_stream, p_vroot );
+
     if( !i_result )
         goto error;
 
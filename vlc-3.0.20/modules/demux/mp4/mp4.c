@@ -90,9 +90,11 @@ struct demux_sys_t
     bool         b_seekable;
     bool         b_fastseekable;
     bool         b_error;        /* unrecoverable */
+    bool         b_keyframes_only; /* trick play: skip video non-sync samples */
 
     bool            b_index_probed;     /* mFra sync points index */
     bool            b_fragments_probed; /* moof segments index created */
+    bool            b_fragments_scan_confirmed;
 
     MP4_Box_t *p_moov;
 
@@ -154,6 +156,7 @@ static int  MP4_TrackSeek   ( demux_t *, mp4_track_t *, vlc_tick_t );
 static uint64_t MP4_TrackGetPos    ( mp4_track_t * );
 static uint32_t MP4_TrackGetReadSize( mp4_track_t *, uint32_t * );
 static int      MP4_TrackNextSample( demux_t *, mp4_track_t *, uint32_t );
+static int      TrackSkipToSyncSample( demux_t *, mp4_track_t * );
 static void     MP4_TrackSetELST( demux_t *, mp4_track_t *, int64_t );
 
 static void     MP4_UpdateSeekpoint( demux_t *, int64_t );
@@ -168,6 +171,9 @@ static stime_t GetMoovTrackDuration( demux_sys_t *p_sys, unsigned i_track_ID );
 
 static int  ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented );
 static int  ProbeFragmentsChecked( demux_t *p_demux );
+static int  FragIndexScan( demux_t *p_demux, stime_t i_target );
+static int  FragIndexScanChecked( demux_t *p_demux, stime_t i_target );
+static void FragIndexAppend( demux_sys_t *p_sys, MP4_Box_t *p_moof );
 static int  ProbeIndex( demux_t *p_demux );
 
 static int FragCreateTrunIndex( demux_t *, MP4_Box_t *, MP4_Box_t *, stime_t, bool );
@@ -295,90 +301,54 @@ static es_out_id_t * MP4_AddTrackES( es_out_t *out, mp4_track_t *p_track )
     return p_es;
 }
 
-static int MP4_ChunkAllocDtsEntries( mp4_chunk_t *ck )
-{
-    size_t entries = ck->i_entries_dts;
-
-    if( entries <= ARRAY_SIZE(ck->small_dts_buf) / 2 )
-    {
-        ck->p_sample_count_dts = ck->small_dts_buf;
-        ck->p_sample_delta_dts = ck->small_dts_buf + entries;
-        return 0;
-    }
-
-    uint32_t *buf = calloc( entries, sizeof( buf[0] ) * 2 );
-    if( unlikely(buf == NULL) )
-        return VLC_ENOMEM;
-
-    ck->p_sample_count_dts = buf;
-    ck->p_sample_delta_dts = buf + entries;
-    return 0;
-}
-
-static int MP4_ChunkAllocPtsEntries( mp4_chunk_t *ck )
-{
-    size_t entries = ck->i_entries_pts;
-
-    if( entries <= ARRAY_SIZE(ck->small_pts_buf) / 2 )
-    {
-        ck->p_sample_count_pts = ck->small_pts_buf;
-        ck->p_sample_offset_pts = ck->small_pts_buf + entries;
-        return 0;
-    }
-
-    uint32_t *buf = calloc( entries, sizeof( buf[0] ) * 2 );
-    if( unlikely(buf == NULL) )
-        return VLC_ENOMEM;
-
-    ck->p_sample_count_pts = buf;
-    ck->p_sample_offset_pts = buf + entries;
-    return 0;
-}
-
-static void MP4_ChunkDestroy( mp4_chunk_t *ck )
-{
-    if( ck->p_sample_count_dts != ck->small_dts_buf )
-        free( ck->p_sample_count_dts );
-    if( ck->p_sample_count_pts != ck->small_pts_buf )
-        free( ck->p_sample_count_pts );
-}
-
-static stime_t MP4_ChunkGetSampleDTS( const mp4_chunk_t *p_chunk,
+static stime_t MP4_ChunkGetSampleDTS( const mp4_track_t *p_track,
+                                      const mp4_chunk_t *p_chunk,
                                       uint32_t i_sample )
 {
-    uint32_t i_index = 0;
+    const MP4_Box_data_stts_t *stts = p_track->p_stts;
+    uint32_t i_index = p_chunk->i_dts_index;
+    uint32_t i_skip = p_chunk->i_dts_skip;
     stime_t sdts = p_chunk->i_first_dts;
-    while( i_sample > 0 && i_index < p_chunk->i_entries_dts )
+    while( i_sample > 0 && i_index < stts->i_entry_count )
     {
-        if( i_sample > p_chunk->p_sample_count_dts[i_index] )
+        uint32_t i_count = stts->pi_sample_count[i_index] - i_skip;
+        uint32_t i_delta = stts->pi_sample_delta[i_index];
+        if( i_sample > i_count )
         {
-            sdts += p_chunk->p_sample_count_dts[i_index] *
-                p_chunk->p_sample_delta_dts[i_index];
-            i_sample -= p_chunk->p_sample_count_dts[i_index++];
+            sdts += (uint64_t) i_count * i_delta;
+            i_sample -= i_count;
+            i_index++;
+            i_skip = 0;
         }
         else
         {
-            sdts += i_sample * p_chunk->p_sample_delta_dts[i_index];
+            sdts += (uint64_t) i_sample * i_delta;
             break;
         }
     }
     return sdts;
 }
 
-static bool MP4_ChunkGetSampleCTSDelta( const mp4_chunk_t *p_chunk,
+static bool MP4_ChunkGetSampleCTSDelta( const mp4_track_t *p_track,
+                                        const mp4_chunk_t *p_chunk,
                                         uint32_t i_sample, stime_t *pi_delta )
 {
-    if( p_chunk->p_sample_count_pts && p_chunk->p_sample_offset_pts )
+    const MP4_Box_data_ctts_t *ctts = p_track->p_ctts;
+    if( !ctts )
+        return false;
+
+    uint32_t i_skip = p_chunk->i_pts_skip;
+    for( uint32_t i_index = p_chunk->i_pts_index; i_index < ctts->i_entry_count; i_index++ )
     {
-        for( uint32_t i_index = 0; i_index < p_chunk->i_entries_pts ; i_index++ )
+        uint32_t i_count = ctts->pi_sample_count[i_index] - i_skip;
+        if( i_sample < i_count )
         {
-            if( i_sample < p_chunk->p_sample_count_pts[i_index] )
-            {
-                *pi_delta = p_chunk->p_sample_offset_pts[i_index];
-                return true;
-            }
-            i_sample -= p_chunk->p_sample_count_pts[i_index];
+            int64_t i_ctsdelta = ctts->pi_sample_offset[i_index] + p_track->i_cts_shift;
+            *pi_delta = ( i_ctsdelta < 0 ) ? 0 : i_ctsdelta; /* should not */
+            return true;
         }
+        i_sample -= i_count;
+        i_skip = 0;
     }
     return false;
 }
@@ -411,7 +381,7 @@ static inline mtime_t MP4_TrackGetDTS( demux_t *p_demux, mp4_track_t *p_track )
     demux_sys_t *p_sys = p_demux->p_sys;
     const mp4_chunk_t *p_chunk = &p_track->chunk[p_track->i_chunk];
 
-    stime_t sdts = MP4_ChunkGetSampleDTS( p_chunk,
+    stime_t sdts = MP4_ChunkGetSampleDTS( p_track, p_chunk,
                                           p_track->i_sample - p_chunk->i_sample_first );
 
     /* now handle elst */
@@ -426,7 +396,7 @@ static inline bool MP4_TrackGetPTSDelta( demux_t *p_demux, const mp4_track_t *p_
     VLC_UNUSED( p_demux );
     const mp4_chunk_t *ck = &p_track->chunk[p_track->i_chunk];
     stime_t delta;
-    if( !MP4_ChunkGetSampleCTSDelta( ck, p_track->i_sample - ck->i_sample_first, &delta ) )
+    if( !MP4_ChunkGetSampleCTSDelta( p_track, ck, p_track->i_sample - ck->i_sample_first, &delta ) )
         return false;
     *pi_delta = MP4_rescale( delta, p_track->i_timescale, CLOCK_FREQ );
     return true;
@@ -1035,7 +1005,8 @@ static int Open( vlc_object_t * p_this )
 
         if ( p_sys->b_seekable )
         {
-            if( !p_sys->b_fragmented /* as unknown */ )
+            /* Scanning the whole file is too slow to only read headers */
+            if( !p_sys->b_fragmented /* as unknown */ && !p_demux->b_preparse_lite )
             {
                 /* Probe remaining to check if there's really fragments
                    or if that file is just ready to append fragments */
@@ -1282,6 +1253,21 @@ static int DemuxTrack( demux_t *p_demux, mp4_track_t *tk, uint64_t i_readpos,
         if( tk->i_sample >= tk->i_sample_count )
             return VLC_DEMUXER_EOS;
 
+        if( p_demux->p_sys->b_keyframes_only && tk->fmt.i_cat == VIDEO_ES &&
+            !p_demux->p_sys->b_fragmented )
+        {
+            const uint32_t i_sample = tk->i_sample;
+
+            if( TrackSkipToSyncSample( p_demux, tk ) )
+                goto end;
+            if( tk->i_sample != i_sample )
+            {
+                i_current_nzdts = MP4_TrackGetDTS( p_demux, tk );
+                i_readpos = MP4_TrackGetPos( tk );
+                continue;
+            }
+        }
+
 #if 0
         msg_Dbg( p_demux, "tk(%i)=%"PRId64" mv=%"PRId64" pos=%"PRIu64, tk->i_track_ID,
                  MP4_TrackGetDTS( p_demux, tk ),
@@ -1760,23 +1746,21 @@ static int FragSeekToTime( demux_t *p_demux, vlc_tick_t i_nztime, bool b_accurat
             /* Does only provide segment position and a sync sample time */
             msg_Dbg( p_demux, "seeking to sync point %" PRId64, i_sync_time );
         }
-        else if( !p_sys->b_fragments_probed )
+        else
         {
-            int i_ret = ProbeFragmentsChecked( p_demux );
+            /* only index up to the target */
+            int i_ret = FragIndexScanChecked( p_demux,
+                            MP4_rescale( i_sync_time, CLOCK_FREQ, p_sys->i_timescale ) );
             if( i_ret != VLC_SUCCESS )
                 return i_ret;
         }
 
-        if( p_sys->b_fragments_probed && p_sys->p_fragsindex )
+        if( p_sys->p_fragsindex && p_sys->p_fragsindex->i_entries )
         {
             stime_t i_basetime = MP4_rescale( i_sync_time, CLOCK_FREQ, p_sys->i_timescale );
-            if( !MP4_Fragments_Index_Lookup( p_sys->p_fragsindex, &i_basetime, &i64, i_seek_track_index ) )
-            {
-                p_sys->b_error = (vlc_stream_Seek( p_demux->s, i_backup_pos ) != VLC_SUCCESS);
-                return VLC_EGENERIC;
-            }
-            msg_Dbg( p_demux, "seeking to fragment index pos %" PRId64 " %" PRId64, i64,
-                     MP4_rescale( i_basetime, p_sys->i_timescale, CLOCK_FREQ ) );
+            if( MP4_Fragments_Index_Lookup( p_sys->p_fragsindex, &i_basetime, &i64, i_seek_track_index ) )
+                msg_Dbg( p_demux, "seeking to fragment index pos %" PRId64 " %" PRId64, i64,
+                         MP4_rescale( i_basetime, p_sys->i_timescale, CLOCK_FREQ ) );
         }
     }
 
@@ -1989,6 +1973,10 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             *pf = p_sys->f_fps;
             return VLC_SUCCESS;
 
+        case DEMUX_SET_KEYFRAMES_ONLY:
+            p_sys->b_keyframes_only = (bool)va_arg( args, int );
+            return VLC_SUCCESS;
+
         case DEMUX_GET_ATTACHMENTS:
         {
             input_attachment_t ***ppp_attach = va_arg( args, input_attachment_t*** );
@@ -2388,12 +2376,10 @@ static int TrackCreateChunksIndex( demux_t *p_demux,
         ck->i_offset = BOXDATA(p_co64)->i_chunk_offset[i_chunk];
 
         ck->i_first_dts = 0;
-        ck->i_entries_dts = 0;
-        ck->p_sample_count_dts = NULL;
-        ck->p_sample_delta_dts = NULL;
-        ck->i_entries_pts = 0;
-        ck->p_sample_count_pts = NULL;
-        ck->p_sample_offset_pts = NULL;
+        ck->i_dts_index = 0;
+        ck->i_dts_skip = 0;
+        ck->i_pts_index = 0;
+        ck->i_pts_skip = 0;
     }
 
     /* now we read index for SampleEntry( soun vide mp4a mp4v ...)
@@ -2455,54 +2441,6 @@ static int TrackCreateChunksIndex( demux_t *p_demux,
     return VLC_SUCCESS;
 }
 
-static int xTTS_CountEntries( demux_t *p_demux, uint32_t *pi_entry /* out */,
-                              const uint32_t i_index,
-                              uint32_t i_index_samples_left,
-                              uint32_t i_sample_count,
-                              const uint32_t *pi_index_sample_count,
-                              const uint32_t i_table_count )
-{
-    uint32_t i_array_offset;
-    while( i_sample_count > 0 )
-    {
-        if ( likely((UINT32_MAX - i_index) >= *pi_entry) )
-            i_array_offset = i_index + *pi_entry;
-        else
-            return VLC_EGENERIC;
-
-        if ( i_array_offset >= i_table_count )
-        {
-            msg_Err( p_demux, "invalid index counting total samples %u %u", i_array_offset,  i_table_count );
-            return VLC_ENOVAR;
-        }
-
-        if ( i_index_samples_left )
-        {
-            if ( i_index_samples_left > i_sample_count )
-            {
-                i_index_samples_left -= i_sample_count;
-                i_sample_count = 0;
-                *pi_entry +=1; /* No samples left, go copy */
-                break;
-            }
-            else
-            {
-                i_sample_count -= i_index_samples_left;
-                i_index_samples_left = 0;
-                *pi_entry += 1;
-                continue;
-            }
-        }
-        else
-        {
-            i_sample_count -= __MIN( i_sample_count, pi_index_sample_count[i_array_offset] );
-            *pi_entry += 1;
-        }
-    }
-
-    return VLC_SUCCESS;
-}
-
 static int TrackCreateSamplesIndex( demux_t *p_demux,
                                     mp4_track_t *p_demux_track )
 {
@@ -2542,16 +2480,7 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     {
         /* 2: each sample can have a different size */
         p_demux_track->i_sample_size = 0;
-        p_demux_track->p_sample_size =
-            calloc( p_demux_track->i_sample_count, sizeof( uint32_t ) );
-        if( p_demux_track->p_sample_size == NULL )
-            return VLC_ENOMEM;
-
-        for( uint32_t i_sample = 0; i_sample < p_demux_track->i_sample_count; i_sample++ )
-        {
-            p_demux_track->p_sample_size[i_sample] =
-                    stsz->i_entry_size[i_sample];
-        }
+        p_demux_track->p_sample_size = stsz->i_entry_size;
     }
 
     if ( p_demux_track->i_chunk_count && p_demux_track->i_sample_size == 0 )
@@ -2566,116 +2495,58 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
 
     /* Use stts table to create a sample number -> dts table.
      * XXX: if we don't want to waste too much memory, we can't expand
-     *  the box! so each chunk will contain an "extract" of this table
-     *  for fast research (problem with raw stream where a sample is sometime
-     *  just channels*bits_per_sample/8 */
-
-     /* FIXME: refactor STTS & CTTS, STTS having now only few extra lines and
-      *        differing in 2/2 fields and 1 signedness */
+     *  the box! so each chunk only records where its first sample lies
+     *  in the stts and ctts tables, which stay owned by the boxes */
 
     vlc_tick_t i_next_dts = 0;
     /* Find stts
      *  Gives mapping between sample and decoding time
      */
     p_box = MP4_BoxGet( p_demux_track->p_stbl, "stts" );
-    if( !p_box )
+    if( !p_box || !p_box->data.p_stts )
     {
         msg_Warn( p_demux, "cannot find STTS box" );
         return VLC_EGENERIC;
     }
     else
     {
-        MP4_Box_data_stts_t *stts = p_box->data.p_stts;
+        const MP4_Box_data_stts_t *stts = p_box->data.p_stts;
+        p_demux_track->p_stts = stts;
 
         msg_Warn( p_demux, "STTS table of %"PRIu32" entries", stts->i_entry_count );
 
-        /* Create sample -> dts table per chunk */
         uint32_t i_index = 0;
-        uint32_t i_current_index_samples_left = 0;
+        uint32_t i_skip = 0;
 
         for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
         {
             mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_sample_count;
+            uint32_t i_sample_count = ck->i_sample_count;
 
-            /* save first dts */
+            /* save first dts and table position */
             ck->i_first_dts = i_next_dts;
+            ck->i_dts_index = i_index;
+            ck->i_dts_skip = i_skip;
 
-            /* count how many entries are needed for this chunk
-             * for p_sample_delta_dts and p_sample_count_dts */
-            ck->i_entries_dts = 0;
-
-            int i_ret = xTTS_CountEntries( p_demux, &ck->i_entries_dts, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           stts->pi_sample_count,
-                                           stts->i_entry_count );
-            if ( i_ret == VLC_EGENERIC )
-                return i_ret;
-
-            /* allocate them */
-            i_ret = MP4_ChunkAllocDtsEntries( ck );
-            if( i_ret )
+            while( i_sample_count > 0 && i_index < stts->i_entry_count )
             {
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_dts );
-                ck->i_entries_dts = 0;
-                return i_ret;
-            }
-
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
-
-            for( uint32_t i = 0; i < ck->i_entries_dts; i++ )
-            {
-                if ( i_current_index_samples_left )
-                {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_sample_count ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_dts - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        ck->p_sample_count_dts[i] = i_current_index_samples_left;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_current_index_samples_left ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
-                }
-                else
+                uint32_t i_count = __MIN( stts->pi_sample_count[i_index] - i_skip,
+                                          i_sample_count );
+                i_next_dts += (uint64_t) i_count * (uint32_t) stts->pi_sample_delta[i_index];
+                i_sample_count -= i_count;
+                i_skip += i_count;
+                if( i_skip == stts->pi_sample_count[i_index] )
                 {
-                    if ( stts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_sample_count ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_current_index_samples_left = stts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_dts - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        ck->p_sample_count_dts[i] = stts->pi_sample_count[i_index];
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( stts->pi_sample_count[i_index] ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_sample_count -= stts->pi_sample_count[i_index];
-                        i_index++;
-                    }
+                    i_index++;
+                    i_skip = 0;
                 }
-
             }
+
+            if( i_sample_count > 0 )
+                msg_Err( p_demux, "invalid index counting total samples %u %u",
+                         i_index, stts->i_entry_count );
+
+            ck->i_duration = i_next_dts - ck->i_first_dts;
         }
     }
 
@@ -2686,93 +2557,37 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     p_box = MP4_BoxGet( p_demux_track->p_stbl, "ctts" );
     if( p_box && p_box->data.p_ctts )
     {
-        MP4_Box_data_ctts_t *ctts = p_box->data.p_ctts;
+        const MP4_Box_data_ctts_t *ctts = p_box->data.p_ctts;
+        p_demux_track->p_ctts = ctts;
 
         msg_Warn( p_demux, "CTTS table of %"PRIu32" entries", ctts->i_entry_count );
 
-        int64_t i_cts_shift = 0;
         const MP4_Box_t *p_cslg = MP4_BoxGet( p_demux_track->p_stbl, "cslg" );
         if( p_cslg && BOXDATA(p_cslg) )
-            i_cts_shift = BOXDATA(p_cslg)->ct_to_dts_shift;
+            p_demux_track->i_cts_shift = BOXDATA(p_cslg)->ct_to_dts_shift;
 
-        /* Create pts-dts table per chunk */
         uint32_t i_index = 0;
-        uint32_t i_current_index_samples_left = 0;
+        uint32_t i_skip = 0;
 
         for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
         {
             mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_sample_count;
-
-            /* count how many entries are needed for this chunk
-             * for p_sample_offset_pts and p_sample_count_pts */
-            ck->i_entries_pts = 0;
-            int i_ret = xTTS_CountEntries( p_demux, &ck->i_entries_pts, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           ctts->pi_sample_count,
-                                           ctts->i_entry_count );
-            if ( i_ret == VLC_EGENERIC )
-                return i_ret;
+            uint32_t i_sample_count = ck->i_sample_count;
 
-            /* allocate them */
-            i_ret = MP4_ChunkAllocPtsEntries( ck );
-            if( i_ret )
-            {
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_pts );
-                ck->i_entries_pts = 0;
-                return i_ret;
-            }
-
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
+            ck->i_pts_index = i_index;
+            ck->i_pts_skip = i_skip;
 
-            for( uint32_t i = 0; i < ck->i_entries_pts; i++ )
+            while( i_sample_count > 0 && i_index < ctts->i_entry_count )
             {
-                int64_t i_ctsdelta = ctts->pi_sample_offset[i_index] + i_cts_shift;
-                if( i_ctsdelta < 0 ) /* should not */
-                    i_ctsdelta = 0;
-                if ( i_current_index_samples_left )
+                uint32_t i_count = __MIN( ctts->pi_sample_count[i_index] - i_skip,
+                                          i_sample_count );
+                i_sample_count -= i_count;
+                i_skip += i_count;
+                if( i_skip == ctts->pi_sample_count[i_index] )
                 {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        ck->p_sample_offset_pts[i] = i_ctsdelta;
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_pts - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = i_current_index_samples_left;
-                        ck->p_sample_offset_pts[i] = i_ctsdelta;
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
+                    i_index++;
+                    i_skip = 0;
                 }
-                else
-                {
-                    if ( ctts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        ck->p_sample_offset_pts[i] = i_ctsdelta;
-                        i_current_index_samples_left = ctts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_pts - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = ctts->pi_sample_count[i_index];
-                        ck->p_sample_offset_pts[i] = i_ctsdelta;
-                        i_sample_count -= ctts->pi_sample_count[i_index];
-                        i_index++;
-                    }
-                }
-
-
             }
         }
     }
@@ -3029,7 +2844,7 @@ static int TrackTimeToSampleChunk( demux_t *p_demux, mp4_track_t *p_track,
     uint64_t     i_dts;
     unsigned int i_sample;
     unsigned int i_chunk;
-    int          i_index;
+    uint32_t     i_index;
 
     /* FIXME see if it's needed to check p_track->i_chunk_count */
     if( p_track->i_chunk_count == 0 )
@@ -3073,50 +2888,50 @@ static int TrackTimeToSampleChunk( demux_t *p_demux, mp4_track_t *p_track,
         i_start = MP4_rescale( i_start, CLOCK_FREQ, p_track->i_timescale );
     }
 
-    /* we start from sample 0/chunk 0, hope it won't take too much time */
     /* *** find good chunk *** */
-    for( i_chunk = 0; ; i_chunk++ )
-    {
-        if( i_chunk + 1 >= p_track->i_chunk_count )
-        {
-            /* at the end and can't check if i_start in this chunk,
-               it will be check while searching i_sample */
-            i_chunk = p_track->i_chunk_count - 1;
-            break;
-        }
-
-        if( (uint64_t)i_start >= p_track->chunk[i_chunk].i_first_dts &&
-            (uint64_t)i_start <  p_track->chunk[i_chunk + 1].i_first_dts )
-        {
-            break;
+    /* chunks are sorted by first dts: look for the last one starting
+       before i_start. If there is none, default to the last chunk, it
+       will be checked while searching i_sample */
+    i_chunk = p_track->i_chunk_count - 1;
+    if( i_start >= 0 )
+    {
+        uint32_t i_low = 0, i_high = p_track->i_chunk_count;
+        while( i_low < i_high )
+        {
+            uint32_t i_mid = i_low + ( i_high - i_low ) / 2;
+            if( p_track->chunk[i_mid].i_first_dts <= (uint64_t)i_start )
+                i_low = i_mid + 1;
+            else
+                i_high = i_mid;
         }
+        if( i_low > 0 )
+            i_chunk = i_low - 1;
     }
 
     /* *** find sample in the chunk *** */
-    i_sample = p_track->chunk[i_chunk].i_sample_first;
-    i_dts    = p_track->chunk[i_chunk].i_first_dts;
-    for( i_index = 0;  i_index < p_track->chunk[i_chunk].i_entries_dts &&
-                       i_sample < p_track->chunk[i_chunk].i_sample_count; )
-    {
-        if( i_dts +
-            p_track->chunk[i_chunk].p_sample_count_dts[i_index] *
-            p_track->chunk[i_chunk].p_sample_delta_dts[i_index] < (uint64_t)i_start )
-        {
-            i_dts    +=
-                p_track->chunk[i_chunk].p_sample_count_dts[i_index] *
-                p_track->chunk[i_chunk].p_sample_delta_dts[i_index];
-
-            i_sample += p_track->chunk[i_chunk].p_sample_count_dts[i_index];
+    const mp4_chunk_t *ck = &p_track->chunk[i_chunk];
+    const MP4_Box_data_stts_t *stts = p_track->p_stts;
+    uint32_t i_skip = ck->i_dts_skip;
+    uint32_t i_left = ck->i_sample_count;
+    i_sample = ck->i_sample_first;
+    i_dts    = ck->i_first_dts;
+    for( i_index = ck->i_dts_index; i_left > 0 && i_index < stts->i_entry_count; )
+    {
+        uint32_t i_count = __MIN( stts->pi_sample_count[i_index] - i_skip, i_left );
+        uint32_t i_delta = stts->pi_sample_delta[i_index];
+        if( i_dts + (uint64_t) i_count * i_delta < (uint64_t)i_start )
+        {
+            i_dts    += (uint64_t) i_count * i_delta;
+            i_sample += i_count;
+            i_left   -= i_count;
+            i_skip    = 0;
             i_index++;
         }
         else
         {
-            if( p_track->chunk[i_chunk].p_sample_delta_dts[i_index] <= 0 )
-            {
+            if( i_delta == 0 )
                 break;
-            }
-            i_sample += ( i_start - i_dts ) /
-                p_track->chunk[i_chunk].p_sample_delta_dts[i_index];
+            i_sample += ( i_start - i_dts ) / i_delta;
             break;
         }
     }
@@ -3201,6 +3016,45 @@ static int TrackGotoChunkSample( demux_t *p_demux, mp4_track_t *p_track,
 
     return p_track->b_selected ? VLC_SUCCESS : VLC_EGENERIC;
 }
+/* Moves to the first sync sample from the current one, or past the end of
+ * the track when there are none left */
+static int TrackSkipToSyncSample( demux_t *p_demux, mp4_track_t *p_track )
+{
+    const MP4_Box_t *p_stss = MP4_BoxGet( p_track->p_stbl, "stss" );
+    if( !p_stss || !BOXDATA(p_stss) || !BOXDATA(p_stss)->i_entry_count )
+        return VLC_SUCCESS; /* every sample is a sync sample */
+
+    const MP4_Box_data_stss_t *p_stss_data = BOXDATA(p_stss);
+    uint32_t i_low = 0, i_high = p_stss_data->i_entry_count;
+    while( i_low < i_high )
+    {
+        const uint32_t i_mid = i_low + (i_high - i_low) / 2;
+        if( p_stss_data->i_sample_number[i_mid] < p_track->i_sample )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+
+    if( i_low >= p_stss_data->i_entry_count ||
+        p_stss_data->i_sample_number[i_low] >= p_track->i_sample_count )
+    {
+        p_track->i_sample = p_track->i_sample_count;
+        return VLC_SUCCESS;
+    }
+
+    const uint32_t i_sync_sample = p_stss_data->i_sample_number[i_low];
+    if( i_sync_sample == p_track->i_sample )
+        return VLC_SUCCESS;
+
+    unsigned i_chunk = p_track->i_chunk;
+    while( i_chunk < p_track->i_chunk_count - 1 &&
+           i_sync_sample >= p_track->chunk[i_chunk].i_sample_first +
+                            p_track->chunk[i_chunk].i_sample_count )
+        i_chunk++;
+
+    return TrackGotoChunkSample( p_demux, p_track, i_chunk, i_sync_sample );
+}
+
 #if 0
 static void MP4_TrackRestart( demux_t *p_demux, mp4_track_t *p_track,
                               MP4_Box_t *p_params_box )
@@ -3558,16 +3412,8 @@ static void MP4_TrackClean( es_out_t *out, mp4_track_t *p_track )
     if( p_track->p_es )
         es_out_Del( out, p_track->p_es );
 
-    if( p_track->chunk )
-    {
-        for( unsigned int i_chunk = 0; i_chunk < p_track->i_chunk_count; i_chunk++ )
-            MP4_ChunkDestroy( &p_track->chunk[i_chunk] );
-    }
     free( p_track->chunk );
 
-    if( !p_track->i_sample_size )
-        free( p_track->p_sample_size );
-
     if ( p_track->asfinfo.p_frame )
         block_ChainRelease( p_track->asfinfo.p_frame );
 
@@ -4190,118 +4036,157 @@ static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
 
     assert( p_sys->p_root );
 
-    MP4_Box_t *p_vroot = MP4_BoxNew(ATOM_root);
-    if( !p_vroot )
-        return VLC_EGENERIC;
+    if( p_sys->b_seekable && b_force )
+    {
+        /* Duration is unknown, we need to index all fragments */
+        if( FragIndexScan( p_demux, INT64_MAX ) != VLC_SUCCESS )
+            return VLC_EGENERIC;
+        *pb_fragmented = p_sys->p_fragsindex->i_entries > 0;
+#ifdef MP4_VERBOSE
+        MP4_Fragments_Index_Dump( VLC_OBJECT(p_demux), p_sys->p_fragsindex, p_sys->i_timescale );
+#endif
+    }
+    else
+    {
+        MP4_Box_t *p_vroot = MP4_BoxNew(ATOM_root);
+        if( !p_vroot )
+            return VLC_EGENERIC;
 
-    if( p_sys->b_seekable && (p_sys->b_fastseekable || b_force) )
+        /* We stop at first moof, which validates our fragmentation condition
+         * and we'll find others while reading, or when seeking. */
+        const uint32_t excllist[] = { ATOM_moof, 0 };
+        MP4_ReadBoxContainerRestricted( p_demux->s, p_vroot, NULL, excllist );
+        /* Peek since we stopped before restriction */
+        const uint8_t *p_peek;
+        if ( vlc_stream_Peek( p_demux->s, &p_peek, 8 ) == 8 )
+            *pb_fragmented = (VLC_FOURCC( p_peek[4], p_peek[5], p_peek[6], p_peek[7] ) == ATOM_moof);
+        else
+            *pb_fragmented = false;
+
+        MP4_BoxFree( p_vroot );
+    }
+
+    MP4_Box_t *p_mehd = MP4_BoxGet( p_sys->p_moov, "mvex/mehd");
+    if ( !p_mehd )
+           p_sys->i_cumulated_duration = GetCumulatedDuration( p_demux );
+
+    return VLC_SUCCESS;
+}
+
+static mp4_fragments_index_t * FragIndexGet( demux_sys_t *p_sys )
+{
+    if( !p_sys->p_fragsindex && p_sys->i_tracks )
     {
-        MP4_ReadBoxContainerChildren( p_demux->s, p_vroot, NULL ); /* Get the rest of the file */
-        p_sys->b_fragments_probed = true;
+        p_sys->p_fragsindex = MP4_Fragments_Index_New( p_sys->i_tracks, 64 );
+        if( p_sys->p_fragsindex )
+            p_sys->p_fragsindex->i_scan_pos = p_sys->p_moov->i_pos + p_sys->p_moov->i_size;
+    }
+    return p_sys->p_fragsindex;
+}
+
+static void FragIndexAppend( demux_sys_t *p_sys, MP4_Box_t *p_moof )
+{
+    mp4_fragments_index_t *p_index = p_sys->p_fragsindex;
+    const bool b_first = ( p_index->i_entries == 0 );
 
-        const unsigned i_moof = MP4_BoxCount( p_vroot, "/moof" );
-        if( i_moof )
+    stime_t *p_times = MP4_Fragments_Index_Add( p_index, p_moof->i_pos );
+    if( !p_times )
+        return;
+
+    for( unsigned i=0; i<p_sys->i_tracks; i++ )
+    {
+        stime_t i_duration = 0;
+        MP4_Box_t *p_tfdt = NULL;
+        MP4_Box_t *p_traf = MP4_GetTrafByTrackID( p_moof, p_sys->track[i].i_track_ID );
+        if( p_traf )
+            p_tfdt = MP4_BoxGet( p_traf, "tfdt" );
+
+        if( p_tfdt && BOXDATA(p_tfdt) )
         {
-            *pb_fragmented = true;
-            p_sys->p_fragsindex = MP4_Fragments_Index_New( p_sys->i_tracks, i_moof );
-            if( !p_sys->p_fragsindex )
-            {
-                MP4_BoxFree( p_vroot );
-                return VLC_EGENERIC;
-            }
+            p_index->p_tracks_end[i] = p_tfdt->data.p_tfdt->i_base_media_decode_time;
+        }
+        else if( b_first ) /* Set first fragment time offset from moov */
+        {
+            i_duration = GetMoovTrackDuration( p_sys, p_sys->track[i].i_track_ID );
+            p_index->p_tracks_end[i] = MP4_rescale( i_duration, p_sys->i_timescale, p_sys->track[i].i_timescale );
+        }
 
-            stime_t *pi_track_times = calloc( p_sys->i_tracks, sizeof(*pi_track_times) );
-            if( !pi_track_times )
-            {
-                MP4_Fragments_Index_Delete( p_sys->p_fragsindex );
-                p_sys->p_fragsindex = NULL;
-                MP4_BoxFree( p_vroot );
-                return VLC_EGENERIC;
-            }
+        p_times[i] = MP4_rescale( p_index->p_tracks_end[i], p_sys->track[i].i_timescale, p_sys->i_timescale );
 
-            unsigned index = 0;
+        if( GetMoofTrackDuration( p_sys->p_moov, p_moof, p_sys->track[i].i_track_ID, &i_duration ) )
+            p_index->p_tracks_end[i] += i_duration;
 
-            for( MP4_Box_t *p_moof = p_vroot->p_first; p_moof; p_moof = p_moof->p_next )
-            {
-                if( p_moof->i_type != ATOM_moof )
-                    continue;
+        stime_t i_movietime = MP4_rescale( p_index->p_tracks_end[i], p_sys->track[i].i_timescale, p_sys->i_timescale );
+        if( p_index->i_last_time < i_movietime )
+            p_index->i_last_time = i_movietime;
+    }
+}
 
-                for( unsigned i=0; i<p_sys->i_tracks; i++ )
-                {
-                    stime_t i_duration = 0;
-                    MP4_Box_t *p_tfdt = NULL;
-                    MP4_Box_t *p_traf = MP4_GetTrafByTrackID( p_moof, p_sys->track[i].i_track_ID );
-                    if( p_traf )
-                        p_tfdt = MP4_BoxGet( p_traf, "tfdt" );
+/* Extends the fragments index, one moof at a time from where the previous
+ * scan or the playback stopped, until it covers i_target (movie scaled) */
+static int FragIndexScan( demux_t *p_demux, stime_t i_target )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
 
-                    /* Set first fragment time offset from moov */
-                    if( index == 0 )
-                        pi_track_times[i] = GetMoovTrackDuration( p_sys, p_sys->track[i].i_track_ID );
+    mp4_fragments_index_t *p_index = FragIndexGet( p_sys );
+    if( !p_index )
+        return VLC_ENOMEM;
 
-                    if( p_tfdt && BOXDATA(p_tfdt) )
-                    {
-                        pi_track_times[i] = p_tfdt->data.p_tfdt->i_base_media_decode_time;
-                    }
-                    else if( index == 0 ) /* Set first fragment time offset from moov */
-                    {
-                        i_duration = GetMoovTrackDuration( p_sys, p_sys->track[i].i_track_ID );
-                        pi_track_times[i] = MP4_rescale( i_duration, p_sys->i_timescale, p_sys->track[i].i_timescale );
-                    }
+    if( p_sys->b_fragments_probed || i_target < p_index->i_last_time )
+        return VLC_SUCCESS;
 
-                    stime_t i_movietime = MP4_rescale( pi_track_times[i], p_sys->track[i].i_timescale, p_sys->i_timescale );
-                    p_sys->p_fragsindex->p_times[index * p_sys->i_tracks + i] = i_movietime;
+    const uint64_t i_backup_pos = vlc_stream_Tell( p_demux->s );
+    if( vlc_stream_Seek( p_demux->s, p_index->i_scan_pos ) != VLC_SUCCESS )
+        return VLC_EGENERIC;
 
-                    if( GetMoofTrackDuration( p_sys->p_moov, p_moof, p_sys->track[i].i_track_ID, &i_duration ) )
-                        pi_track_times[i] += i_duration;
-                }
+    msg_Dbg( p_demux, "indexing fragments from %"PRIu64, p_index->i_scan_pos );
 
-                p_sys->p_fragsindex->pi_pos[index++] = p_moof->i_pos;
-            }
+    while( i_target >= p_index->i_last_time )
+    {
+        MP4_Box_t *p_vroot = MP4_BoxGetNextChunk( p_demux->s );
+        if( !p_vroot )
+        {
+            p_sys->b_fragments_probed = true;
+            break;
+        }
 
-            for( unsigned i=0; i<p_sys->i_tracks; i++ )
+        bool b_moof = false;
+        for( MP4_Box_t *p_box = p_vroot->p_first; p_box; p_box = p_box->p_next )
+        {
+            if( p_box->i_type == ATOM_moof )
             {
-                stime_t i_movietime = MP4_rescale( pi_track_times[i], p_sys->track[i].i_timescale, p_sys->i_timescale );
-                if( p_sys->p_fragsindex->i_last_time < i_movietime )
-                    p_sys->p_fragsindex->i_last_time = i_movietime;
+                FragIndexAppend( p_sys, p_box );
+                b_moof = true;
             }
+        }
+        MP4_BoxFree( p_vroot );
 
-            free( pi_track_times );
-#ifdef MP4_VERBOSE
-            MP4_Fragments_Index_Dump( VLC_OBJECT(p_demux), p_sys->p_fragsindex, p_sys->i_timescale );
-#endif
+        p_index->i_scan_pos = vlc_stream_Tell( p_demux->s );
+        if( !b_moof )
+        {
+            p_sys->b_fragments_probed = true;
+            break;
         }
     }
-    else
+
+    if( vlc_stream_Seek( p_demux->s, i_backup_pos ) != VLC_SUCCESS )
     {
-        /* We stop at first moof, which validates our fragmentation condition
-         * and we'll find others while reading. */
-        const uint32_t excllist[] = { ATOM_moof, 0 };
-        MP4_ReadBoxContainerRestricted( p_demux->s, p_vroot, NULL, excllist );
-        /* Peek since we stopped before restriction */
-        const uint8_t *p_peek;
-        if ( vlc_stream_Peek( p_demux->s, &p_peek, 8 ) == 8 )
-            *pb_fragmented = (VLC_FOURCC( p_peek[4], p_peek[5], p_peek[6], p_peek[7] ) == ATOM_moof);
-        else
-            *pb_fragmented = false;
+        p_sys->b_error = true;
+        return VLC_EGENERIC;
     }
 
-    MP4_BoxFree( p_vroot );
-
-    MP4_Box_t *p_mehd = MP4_BoxGet( p_sys->p_moov, "mvex/mehd");
-    if ( !p_mehd )
-           p_sys->i_cumulated_duration = GetCumulatedDuration( p_demux );
-
     return VLC_SUCCESS;
 }
 
-static int ProbeFragmentsChecked( demux_t *p_demux )
+static int FragIndexScanChecked( demux_t *p_demux, stime_t i_target )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
-    if( p_sys->b_fragments_probed )
+    if( p_sys->b_fragments_probed ||
+       ( p_sys->p_fragsindex && i_target < p_sys->p_fragsindex->i_last_time ) )
         return VLC_SUCCESS;
 
-    if( !p_sys->b_fastseekable )
+    if( !p_sys->b_fastseekable && !p_sys->b_fragments_scan_confirmed )
     {
         const char *psz_msg = _(
             "Because this file index is broken or missing, "
@@ -4319,19 +4204,22 @@ static int ProbeFragmentsChecked( demux_t *p_demux )
                                                "%s", psz_msg );
         if( !b_continue )
             return VLC_EGENERIC;
+        p_sys->b_fragments_scan_confirmed = true;
     }
 
-    const uint64_t i_backup_pos = vlc_stream_Tell( p_demux->s );
-    int i_ret = vlc_stream_Seek( p_demux->s, p_sys->p_moov->i_pos + p_sys->p_moov->i_size );
-    if( i_ret == VLC_SUCCESS )
-    {
-        bool foo;
-        i_ret = ProbeFragments( p_demux, true, &foo );
-        p_sys->b_fragments_probed = true;
-    }
+    return FragIndexScan( p_demux, i_target );
+}
 
-    if( i_ret != VLC_SUCCESS )
-        p_sys->b_error = (vlc_stream_Seek( p_demux->s, i_backup_pos ) != VLC_SUCCESS);
+static int ProbeFragmentsChecked( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->b_fragments_probed )
+        return VLC_SUCCESS;
+
+    int i_ret = FragIndexScanChecked( p_demux, INT64_MAX );
+    if( i_ret == VLC_SUCCESS && !MP4_BoxGet( p_sys->p_moov, "mvex/mehd") )
+        p_sys->i_cumulated_duration = GetCumulatedDuration( p_demux );
 
     return i_ret;
 }
@@ -4645,11 +4533,13 @@ static int FragCreateTrunIndex( demux_t *p_demux, MP4_Box_t *p_moof,
             {
                 unsigned i_track_index = (p_track - p_sys->track);
                 assert(&p_sys->track[i_track_index] == p_track);
-                i_traf_start_time = MP4_Fragment_Index_GetTrackStartTime( p_sys->p_fragsindex,
-                                                                          i_track_index, p_moof->i_pos );
-                i_traf_start_time = MP4_rescale( i_traf_start_time,
-                                                 p_sys->i_timescale, p_track->i_timescale );
-                b_has_base_media_decode_time = true;
+                if( MP4_Fragment_Index_GetTrackStartTime( p_sys->p_fragsindex, i_track_index,
+                                                          p_moof->i_pos, &i_traf_start_time ) )
+                {
+                    i_traf_start_time = MP4_rescale( i_traf_start_time,
+                                                     p_sys->i_timescale, p_track->i_timescale );
+                    b_has_base_media_decode_time = true;
+                }
             }
 
             if( !b_has_base_media_decode_time && p_chunksidx )
@@ -4956,6 +4846,7 @@ static int DemuxFrag( demux_t *p_demux )
         }
         else
         {
+            const uint64_t i_chunk_pos = vlc_stream_Tell( p_demux->s );
             MP4_Box_t *p_vroot = MP4_BoxGetNextChunk( p_demux->s );
             if(!p_vroot)
             {
@@ -4963,6 +4854,18 @@ static int DemuxFrag( demux_t *p_demux )
                 goto end;
             }
 
+            /* Extend the fragments index while playing from its end */
+            mp4_fragments_index_t *p_index = p_sys->b_seekable ? FragIndexGet( p_sys ) : NULL;
+            if( p_index && !p_sys->b_fragments_probed && i_chunk_pos == p_index->i_scan_pos )
+            {
+                MP4_Box_t *p_moof = MP4_BoxGet( p_vroot, "moof" );
+                if( p_moof )
+                {
+                    FragIndexAppend( p_sys, p_moof );
+                    p_index->i_scan_pos = vlc_stream_Tell( p_demux->s );
+                }
+            }
+
             MP4_Box_t *p_box = NULL;
             for( p_box = p_vroot->p_first; p_box; p_box = p_box->p_next )
             {
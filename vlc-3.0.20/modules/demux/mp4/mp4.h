@@ -47,15 +47,13 @@ typedef struct
     uint64_t     i_first_dts;   /* DTS of the first sample */
     uint64_t     i_duration;    /* total duration of all samples */
 
-    uint32_t     i_entries_dts;
-    uint32_t     *p_sample_count_dts;
-    uint32_t     *p_sample_delta_dts;   /* dts delta */
-    uint32_t     small_dts_buf[4];
-
-    uint32_t     i_entries_pts;
-    uint32_t     *p_sample_count_pts;
-    uint32_t     *p_sample_offset_pts;  /* pts-dts */
-    uint32_t     small_pts_buf[4];
+    /* position of the first sample of this chunk in the track stts
+     * and ctts tables: entry index and samples of that entry already
+     * consumed by the previous chunks */
+    uint32_t     i_dts_index;
+    uint32_t     i_dts_skip;
+    uint32_t     i_pts_index;
+    uint32_t     i_pts_skip;
 
     /* TODO if needed add pts
         but quickly *add* support for edts and seeking */
@@ -121,7 +119,8 @@ typedef struct
     /* sample size, p_sample_size defined only if i_sample_size == 0
         else i_sample_size is size for all sample */
     uint32_t         i_sample_size;
-    uint32_t         *p_sample_size; /* XXX perhaps add file offset if take
+    const uint32_t   *p_sample_size; /* points into the stsz box
+                                        XXX perhaps add file offset if take
 //                                    too much time to do sumations each time*/
 
     uint32_t     i_sample_first; /* i_sample_first value
@@ -131,6 +130,9 @@ typedef struct
 
     const MP4_Box_t *p_track;
     const MP4_Box_t *p_stbl;  /* will contain all timing information */
+    const MP4_Box_data_stts_t *p_stts; /* sample -> dts, always defined */
+    const MP4_Box_data_ctts_t *p_ctts; /* sample -> pts-dts, can be NULL */
+    int64_t          i_cts_shift;      /* cslg composition to decode shift */
     const MP4_Box_t *p_stsd;  /* will contain all data to initialize decoder */
     const MP4_Box_t *p_sample;/* point on actual sdsd */
 
@@ -119,6 +119,28 @@ typedef struct
     sync_table_ctx_t current;
 } sync_table_t;
 
+typedef struct
+{
+    vlc_tick_t i_time;
+    uint64_t i_pos;
+} seek_point_t;
+
+/* Time to offset index, built by scanning the frame headers on demand */
+typedef struct
+{
+    bool b_enabled;
+    bool b_eof;
+    seek_point_t *p_points;
+    size_t i_points;
+    size_t i_alloc;
+    size_t i_stored;    /* points already in the demux cache */
+    /* scan state */
+    uint32_t i_header;  /* reference header fields */
+    unsigned i_rate;
+    uint64_t i_next_pos;
+    uint64_t i_samples;
+} frame_index_t;
+
 struct demux_sys_t
 {
     codec_t codec;
@@ -161,6 +183,7 @@ struct demux_sys_t
     float rgf_replay_peak[AUDIO_REPLAY_GAIN_MAX];
 
     sync_table_t mllt;
+    frame_index_t index;
 };
 
 static int MpgaProbe( demux_t *p_demux, int64_t *pi_offset );
@@ -182,6 +205,8 @@ static int MlpInit( demux_t *p_demux );
 
 static bool Parse( demux_t *p_demux, block_t **pp_output );
 static uint64_t SeekByMlltTable( demux_t *p_demux, vlc_tick_t *pi_time );
+static int SeekByFrameIndex( demux_t *p_demux, vlc_tick_t i_time );
+static void FrameIndexStore( demux_t *p_demux );
 
 static const codec_t p_codecs[] = {
     { VLC_CODEC_MP4A, false, "mp4 audio",  AacProbe,  AacInit },
@@ -375,6 +400,9 @@ static void Close( vlc_object_t * p_this )
         block_ChainRelease( p_sys->p_packetized_data );
     if( p_sys->mllt.p_bits )
         free( p_sys->mllt.p_bits );
+    if( p_sys->index.i_points > p_sys->index.i_stored )
+        FrameIndexStore( p_demux );
+    free( p_sys->index.p_points );
     demux_PacketizerDestroy( p_sys->p_packetizer );
     free( p_sys );
 }
@@ -447,8 +475,19 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
                 p_sys->p_packetized_data = NULL;
                 return VLC_SUCCESS;
             }
+            if( p_sys->index.b_enabled )
+            {
+                va_list ap;
+
+                va_copy( ap, args );
+                i_ret = SeekByFrameIndex( p_demux, va_arg( ap, int64_t ) );
+                va_end( ap );
+                if( i_ret == VLC_SUCCESS )
+                    return VLC_SUCCESS;
+            }
             /* FIXME TODO: implement a high precision seek (with mp3 parsing)
              * needed for multi-input */
+            /* fall through */
         }
         default:
             i_ret = demux_vaControlHelper( p_demux->s, p_sys->i_stream_offset, -1,
@@ -758,6 +797,303 @@ static int MpgaGetFrameSamples( uint32_t h )
     }
 }
 
+/* Returns the frame size in bytes, or 0 for free format frames */
+static unsigned MpgaGetFrameSize( uint32_t h, unsigned *pi_rate )
+{
+    static const uint16_t ppi_bitrate[2][3][16] =
+    {
+        {   /* MPEG-1, layer I, II, III */
+            { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448, 0 },
+            { 0, 32, 48, 56,  64,  80,  96, 112, 128, 160, 192, 224, 256, 320, 384, 0 },
+            { 0, 32, 40, 48,  56,  64,  80,  96, 112, 128, 160, 192, 224, 256, 320, 0 },
+        },
+        {   /* MPEG-2 and 2.5 */
+            { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256, 0 },
+            { 0,  8, 16, 24, 32, 40, 48,  56,  64,  80,  96, 112, 128, 144, 160, 0 },
+            { 0,  8, 16, 24, 32, 40, 48,  56,  64,  80,  96, 112, 128, 144, 160, 0 },
+        },
+    };
+    static const unsigned pi_freq[3] = { 44100, 48000, 32000 };
+
+    const unsigned i_layer = 3 - ((h >> 17) & 0x03);
+    const unsigned i_bitrate = 1000 * ppi_bitrate[MPGA_VERSION(h)][i_layer][(h >> 12) & 0x0F];
+    const unsigned i_padding = (h >> 9) & 0x01;
+
+    /* MPEG-2.5 halves the MPEG-2 rates again */
+    *pi_rate = pi_freq[(h >> 10) & 0x03] >> ( MPGA_VERSION(h) + !((h >> 20) & 0x01) );
+    if( i_bitrate == 0 )
+        return 0;
+
+    switch( i_layer )
+    {
+    case 0:
+        return ( 12 * i_bitrate / *pi_rate + i_padding ) * 4;
+    case 1:
+        return 144 * i_bitrate / *pi_rate + i_padding;
+    default:
+        return ( MPGA_VERSION(h) ? 72 : 144 ) * i_bitrate / *pi_rate + i_padding;
+    }
+}
+
+/* version, layer and sampling frequency must not change between frames */
+#define MPGA_HEADER_MASK 0xFFFE0C00
+
+static bool MpgaIsVbr( const uint8_t *p_peek, int i_peek )
+{
+    uint32_t h = GetDWBE( p_peek );
+    unsigned i_rate;
+    int i_pos = 0;
+
+    for( int i = 0; i < 8 && i_pos + 4 <= i_peek; i++ )
+    {
+        uint32_t i_next = GetDWBE( &p_peek[i_pos] );
+        if( !MpgaCheckSync( &p_peek[i_pos] ) ||
+            ( i_next & MPGA_HEADER_MASK ) != ( h & MPGA_HEADER_MASK ) )
+            break;
+        if( ( i_next & 0xF000 ) != ( h & 0xF000 ) )
+            return true;
+
+        unsigned i_size = MpgaGetFrameSize( i_next, &i_rate );
+        if( i_size == 0 )
+            break;
+        i_pos += i_size;
+    }
+    return false;
+}
+
+#define FRAME_INDEX_INTERVAL CLOCK_FREQ
+#define FRAME_INDEX_CHUNK    (64 * 1024)
+
+static bool FrameIndexAdd( frame_index_t *p_index, vlc_tick_t i_time, uint64_t i_pos )
+{
+    if( p_index->i_points == p_index->i_alloc )
+    {
+        size_t i_alloc = p_index->i_alloc ? p_index->i_alloc * 2 : 1024;
+        seek_point_t *p_points = realloc( p_index->p_points,
+                                          i_alloc * sizeof(*p_points) );
+        if( !p_points )
+            return false;
+        p_index->p_points = p_points;
+        p_index->i_alloc = i_alloc;
+    }
+    p_index->p_points[p_index->i_points].i_time = i_time;
+    p_index->p_points[p_index->i_points].i_pos = i_pos;
+    p_index->i_points++;
+    return true;
+}
+
+/* Walks the frame headers from the end of the index until it covers
+ * i_time, reading the stream by large chunks */
+static void FrameIndexScan( demux_t *p_demux, vlc_tick_t i_time )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    frame_index_t *p_index = &p_sys->index;
+    uint8_t *p_buf = malloc( FRAME_INDEX_CHUNK );
+    uint64_t i_buf_pos = p_index->i_next_pos;
+    size_t i_buf = 0;
+
+    if( !p_buf || vlc_stream_Seek( p_demux->s, i_buf_pos ) )
+    {
+        free( p_buf );
+        return;
+    }
+
+    for( ;; )
+    {
+        vlc_tick_t i_frame_time = p_index->i_samples * CLOCK_FREQ / p_index->i_rate;
+        if( i_frame_time > i_time )
+            break;
+
+        uint64_t i_next = p_index->i_next_pos;
+        if( i_next + 4 > i_buf_pos + i_buf )
+        {
+            /* keep the bytes of a split header, skip the rest */
+            size_t i_keep = 0;
+            if( i_next < i_buf_pos + i_buf )
+            {
+                i_keep = i_buf_pos + i_buf - i_next;
+                memmove( p_buf, &p_buf[i_buf - i_keep], i_keep );
+            }
+            else if( i_next > i_buf_pos + i_buf &&
+                     vlc_stream_Read( p_demux->s, NULL, i_next - i_buf_pos - i_buf )
+                     != (ssize_t)( i_next - i_buf_pos - i_buf ) )
+            {
+                p_index->b_eof = true;
+                break;
+            }
+            ssize_t i_read = vlc_stream_Read( p_demux->s, &p_buf[i_keep],
+                                              FRAME_INDEX_CHUNK - i_keep );
+            i_buf_pos = i_next;
+            i_buf = i_keep + ( i_read > 0 ? i_read : 0 );
+            if( i_buf < 4 )
+            {
+                p_index->b_eof = true;
+                break;
+            }
+        }
+
+        const uint8_t *p_header = &p_buf[i_next - i_buf_pos];
+        const uint32_t h = GetDWBE( p_header );
+        unsigned i_rate, i_size = 0;
+
+        if( MpgaCheckSync( p_header ) &&
+            ( h & MPGA_HEADER_MASK ) == p_index->i_header )
+            i_size = MpgaGetFrameSize( h, &i_rate );
+        if( i_size == 0 )
+        {
+            /* lost sync (tags, garbage): look for the next frame */
+            p_index->i_next_pos++;
+            continue;
+        }
+
+        if( p_index->i_points == 0 ||
+            i_frame_time >= p_index->p_points[p_index->i_points - 1].i_time
+                            + FRAME_INDEX_INTERVAL )
+        {
+            if( !FrameIndexAdd( p_index, i_frame_time, i_next ) )
+                break;
+        }
+        p_index->i_samples += MpgaGetFrameSamples( h );
+        p_index->i_next_pos += i_size;
+    }
+    free( p_buf );
+}
+
+/* Cached index layout, followed by the seek points */
+typedef struct
+{
+    uint32_t i_version;
+    uint32_t i_header;
+    uint32_t i_rate;
+    uint32_t b_eof;
+    uint64_t i_stream_offset;
+    uint64_t i_next_pos;
+    uint64_t i_samples;
+} frame_index_head_t;
+
+#define FRAME_INDEX_VERSION 1
+
+static void FrameIndexStore( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    frame_index_t *p_index = &p_sys->index;
+    const frame_index_head_t head = {
+        .i_version = FRAME_INDEX_VERSION,
+        .i_header = p_index->i_header,
+        .i_rate = p_index->i_rate,
+        .b_eof = p_index->b_eof,
+        .i_stream_offset = p_sys->i_stream_offset,
+        .i_next_pos = p_index->i_next_pos,
+        .i_samples = p_index->i_samples,
+    };
+    const size_t i_data = sizeof(head) + p_index->i_points * sizeof(seek_point_t);
+    uint8_t *p_data = malloc( i_data );
+    if( !p_data )
+        return;
+
+    memcpy( p_data, &head, sizeof(head) );
+    memcpy( &p_data[sizeof(head)], p_index->p_points,
+            p_index->i_points * sizeof(seek_point_t) );
+    if( demux_CacheStore( p_demux, "es-index", p_data, i_data ) == VLC_SUCCESS )
+        p_index->i_stored = p_index->i_points;
+    free( p_data );
+}
+
+static bool FrameIndexLoad( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    frame_index_t *p_index = &p_sys->index;
+    block_t *p_block = demux_CacheLoad( p_demux, "es-index" );
+    if( !p_block )
+        return false;
+
+    frame_index_head_t head;
+    size_t i_points = 0;
+    if( p_block->i_buffer >= sizeof(head) )
+    {
+        memcpy( &head, p_block->p_buffer, sizeof(head) );
+        i_points = ( p_block->i_buffer - sizeof(head) ) / sizeof(seek_point_t);
+    }
+
+    bool b_ok = i_points > 0 && head.i_version == FRAME_INDEX_VERSION &&
+                head.i_rate > 0 && head.i_stream_offset == (uint64_t)p_sys->i_stream_offset;
+    if( b_ok )
+    {
+        seek_point_t *p_points = malloc( i_points * sizeof(*p_points) );
+        if( p_points )
+        {
+            memcpy( p_points, &p_block->p_buffer[sizeof(head)],
+                    i_points * sizeof(*p_points) );
+            free( p_index->p_points );
+            p_index->p_points = p_points;
+            p_index->i_points = p_index->i_alloc = p_index->i_stored = i_points;
+            p_index->i_header = head.i_header;
+            p_index->i_rate = head.i_rate;
+            p_index->b_eof = head.b_eof;
+            p_index->i_next_pos = head.i_next_pos;
+            p_index->i_samples = head.i_samples;
+            msg_Dbg( p_demux, "loaded cached frame index (%zu points)", i_points );
+        }
+        else
+            b_ok = false;
+    }
+    block_Release( p_block );
+    return b_ok;
+}
+
+static int SeekByFrameIndex( demux_t *p_demux, vlc_tick_t i_time )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    frame_index_t *p_index = &p_sys->index;
+
+    if( p_index->i_rate == 0 && !FrameIndexLoad( p_demux ) )
+    {
+        /* start from the first frame */
+        const uint8_t *p_peek;
+        if( vlc_stream_Seek( p_demux->s, p_sys->i_stream_offset ) ||
+            vlc_stream_Peek( p_demux->s, &p_peek, 4 ) < 4 ||
+            !MpgaCheckSync( p_peek ) ||
+            MpgaGetFrameSize( GetDWBE( p_peek ), &p_index->i_rate ) == 0 )
+        {
+            p_index->b_enabled = false;
+            return VLC_EGENERIC;
+        }
+        p_index->i_header = GetDWBE( p_peek ) & MPGA_HEADER_MASK;
+        p_index->i_next_pos = p_sys->i_stream_offset;
+    }
+
+    if( !p_index->b_eof &&
+        ( p_index->i_points == 0 ||
+          p_index->p_points[p_index->i_points - 1].i_time < i_time ) )
+        FrameIndexScan( p_demux, i_time );
+
+    if( p_index->i_points == 0 )
+        return VLC_EGENERIC;
+
+    /* last point before the requested time */
+    size_t i_low = 0, i_high = p_index->i_points;
+    while( i_high - i_low > 1 )
+    {
+        size_t i_mid = ( i_low + i_high ) / 2;
+        if( p_index->p_points[i_mid].i_time <= i_time )
+            i_low = i_mid;
+        else
+            i_high = i_mid;
+    }
+
+    const seek_point_t *p_point = &p_index->p_points[i_low];
+    if( vlc_stream_Seek( p_demux->s, p_point->i_pos ) )
+        return VLC_EGENERIC;
+
+    p_sys->i_time_offset = p_point->i_time - p_sys->i_pts;
+    /* And reset buffered data */
+    if( p_sys->p_packetized_data )
+        block_ChainRelease( p_sys->p_packetized_data );
+    p_sys->p_packetized_data = NULL;
+    es_out_Control( p_demux->out, ES_OUT_SET_NEXT_DISPLAY_TIME, VLC_TICK_0 + i_time );
+    return VLC_SUCCESS;
+}
+
 static int MpgaProbe( demux_t *p_demux, int64_t *pi_offset )
 {
     const int pi_wav[] = { WAVE_FORMAT_MPEG, WAVE_FORMAT_MPEGLAYER3, WAVE_FORMAT_UNKNOWN };
@@ -978,6 +1314,14 @@ static int MpgaInit( demux_t *p_demux )
 
     ID3Parse( p_demux, ID3TAG_Parse_Handler );
 
+    /* Index the frames of VBR files for exact seeking, where that is fast */
+    bool b_fastseek = false;
+    i_peek = vlc_stream_Peek( p_demux->s, &p_peek, 8 * 1441 );
+    if( i_peek >= 4 && MpgaCheckSync( p_peek ) &&
+        !vlc_stream_Control( p_demux->s, STREAM_CAN_FASTSEEK, &b_fastseek ) &&
+        b_fastseek )
+        p_sys->index.b_enabled = MpgaIsVbr( p_peek, i_peek );
+
     /* Load a potential xing header */
     i_peek = vlc_stream_Peek( p_demux->s, &p_peek, 4 + 1024 );
     if( i_peek < 4 + 21 )
@@ -1021,6 +1365,7 @@ static int MpgaInit( demux_t *p_demux )
 
     if( p_sys->xing.i_frames > 0 && p_sys->xing.i_bytes > 0 )
     {
+        p_sys->index.b_enabled = b_fastseek;
         p_sys->xing.i_frame_samples = MpgaGetFrameSamples( header );
         msg_Dbg( p_demux, "xing frames&bytes value present "
                  "(%d bytes, %d frames, %d samples/frame)",
@@ -51,6 +51,9 @@
 #define CDXA_SECTOR_SIZE 2352
 #define CDXA_SECTOR_HEADER_SIZE 24
 
+/* Packets of fast seekable streams are cut out of reads of this size */
+#define PS_BATCH_SIZE (64 * 1024)
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -104,6 +107,12 @@ struct demux_sys_t
     bool  b_have_pack;
     bool  b_bad_scr;
     bool  b_seekable;
+
+    /* Current read, its payload is shared by the packets handed out. The
+     * stream position is ahead of the demuxer by its i_buffer. */
+    block_t *p_batch;
+    bool     b_batch;
+
     enum
     {
         MPEG_PS = 0,
@@ -115,8 +124,12 @@ struct demux_sys_t
 static int Demux  ( demux_t *p_demux );
 static int Control( demux_t *p_demux, int i_query, va_list args );
 
-static int      ps_pkt_resynch( stream_t *, int, bool );
-static block_t *ps_pkt_read   ( stream_t * );
+static int      ps_pkt_resynch( demux_t *, int, bool );
+static block_t *ps_pkt_read   ( demux_t * );
+
+static uint64_t PsTell( demux_t * );
+static int      PsSeek( demux_t *, uint64_t );
+static void     PsBatchFlush( demux_sys_t * );
 
 /*****************************************************************************
  * Open
@@ -222,9 +235,13 @@ static int OpenCommon( vlc_object_t *p_this, bool b_force )
     p_sys->b_have_pack = false;
     p_sys->b_bad_scr   = false;
     p_sys->b_seekable  = false;
+    p_sys->p_batch     = NULL;
+    p_sys->b_batch     = false;
     p_sys->format      = format;
 
     vlc_stream_Control( p_demux->s, STREAM_CAN_SEEK, &p_sys->b_seekable );
+    /* Only where reading ahead cannot stall a live input */
+    vlc_stream_Control( p_demux->s, STREAM_CAN_FASTSEEK, &p_sys->b_batch );
 
     ps_psm_init( &p_sys->psm );
     ps_track_init( p_sys->tk );
@@ -264,6 +281,7 @@ static void Close( vlc_object_t *p_this )
     }
 
     ps_psm_destroy( &p_sys->psm );
+    PsBatchFlush( p_sys );
 
     free( p_sys );
 }
@@ -274,7 +292,7 @@ static int Probe( demux_t *p_demux, bool b_end )
     int i_ret, i_id;
     block_t *p_pkt;
 
-    i_ret = ps_pkt_resynch( p_demux->s, p_sys->format, p_sys->b_have_pack );
+    i_ret = ps_pkt_resynch( p_demux, p_sys->format, p_sys->b_have_pack );
     if( i_ret < 0 )
     {
         return VLC_DEMUXER_EOF;
@@ -291,7 +309,7 @@ static int Probe( demux_t *p_demux, bool b_end )
     if( p_sys->b_lost_sync ) msg_Warn( p_demux, "found sync code" );
     p_sys->b_lost_sync = false;
 
-    if( ( p_pkt = ps_pkt_read( p_demux->s ) ) == NULL )
+    if( ( p_pkt = ps_pkt_read( p_demux ) ) == NULL )
     {
         return VLC_DEMUXER_EOF;
     }
@@ -341,18 +359,18 @@ static bool FindLength( demux_t *p_demux )
         p_sys->i_length = 0;
         /* Check beginning */
         int i = 0;
-        i_current_pos = vlc_stream_Tell( p_demux->s );
+        i_current_pos = PsTell( p_demux );
         while( i < 40 && Probe( p_demux, false ) > 0 ) i++;
 
         /* Check end */
         i_size = stream_Size( p_demux->s );
         i_end = VLC_CLIP( i_size, 0, 200000 );
-        if( vlc_stream_Seek( p_demux->s, i_size - i_end ) == VLC_SUCCESS )
+        if( PsSeek( p_demux, i_size - i_end ) == VLC_SUCCESS )
         {
             i = 0;
             while( i < 400 && Probe( p_demux, true ) > 0 ) i++;
             if( i_current_pos >= 0 &&
-                vlc_stream_Seek( p_demux->s, i_current_pos ) != VLC_SUCCESS )
+                PsSeek( p_demux, i_current_pos ) != VLC_SUCCESS )
                     return false;
         }
         else return false;
@@ -408,7 +426,7 @@ static int Demux( demux_t *p_demux )
     int i_ret, i_mux_rate;
     block_t *p_pkt;
 
-    i_ret = ps_pkt_resynch( p_demux->s, p_sys->format, p_sys->b_have_pack );
+    i_ret = ps_pkt_resynch( p_demux, p_sys->format, p_sys->b_have_pack );
     if( i_ret < 0 )
     {
         return VLC_DEMUXER_EOF;
@@ -418,7 +436,7 @@ static int Demux( demux_t *p_demux )
         if( !p_sys->b_lost_sync )
         {
             msg_Warn( p_demux, "garbage at input from %"PRIu64", trying to resync...",
-                                vlc_stream_Tell(p_demux->s) );
+                                PsTell( p_demux ) );
             NotifyDiscontinuity( p_sys->tk, p_demux->out );
         }
 
@@ -435,7 +453,7 @@ static int Demux( demux_t *p_demux )
             return VLC_DEMUXER_EGENERIC;
     }
 
-    if( ( p_pkt = ps_pkt_read( p_demux->s ) ) == NULL )
+    if( ( p_pkt = ps_pkt_read( p_demux ) ) == NULL )
     {
         return VLC_DEMUXER_EOF;
     }
@@ -460,7 +478,7 @@ static int Demux( demux_t *p_demux )
                 p_sys->i_first_scr = p_sys->i_pack_scr;
             CheckPCR( p_sys, p_demux->out, p_sys->i_pack_scr );
             p_sys->i_scr = p_sys->i_pack_scr;
-            p_sys->i_lastpack_byte = vlc_stream_Tell( p_demux->s );
+            p_sys->i_lastpack_byte = PsTell( p_demux );
             if( !p_sys->b_have_pack ) p_sys->b_have_pack = true;
             /* done later on to work around bad vcd/svcd streams */
             /* es_out_SetPCR( p_demux->out, p_sys->i_scr ); */
@@ -680,7 +698,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             i64 = stream_Size( p_demux->s ) - p_sys->i_start_byte;
             if( i64 > 0 )
             {
-                double current = vlc_stream_Tell( p_demux->s ) - p_sys->i_start_byte;
+                double current = PsTell( p_demux ) - p_sys->i_start_byte;
                 *pf = current / (double)i64;
             }
             else
@@ -705,7 +723,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
                 i64 = p_sys->i_start_byte + (int64_t)(i64 * f);
             }
 
-            i_ret = vlc_stream_Seek( p_demux->s, i64 );
+            i_ret = PsSeek( p_demux, i64 );
             if( i_ret == VLC_SUCCESS )
             {
                 NotifyDiscontinuity( p_sys->tk, p_demux->out );
@@ -726,7 +744,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
                 /* H.222 2.5.2.2 */
                 if( p_sys->i_mux_rate > 0 && p_sys->b_have_pack )
                 {
-                    uint64_t i_offset = vlc_stream_Tell( p_demux->s ) - p_sys->i_lastpack_byte;
+                    uint64_t i_offset = PsTell( p_demux ) - p_sys->i_lastpack_byte;
                     *pi64 += CLOCK_FREQ * i_offset / (p_sys->i_mux_rate * 50);
                 }
                 return VLC_SUCCESS;
@@ -771,9 +789,11 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
         }
 
         case DEMUX_SET_TITLE:
+            PsBatchFlush( p_sys );
             return vlc_stream_vaControl( p_demux->s, STREAM_SET_TITLE, args );
 
         case DEMUX_SET_SEEKPOINT:
+            PsBatchFlush( p_sys );
             return vlc_stream_vaControl( p_demux->s, STREAM_SET_SEEKPOINT,
                                          args );
 
@@ -791,17 +811,124 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
  * Divers:
  *****************************************************************************/
 
+static void PsBatchFlush( demux_sys_t *p_sys )
+{
+    if( p_sys->p_batch )
+    {
+        block_Release( p_sys->p_batch );
+        p_sys->p_batch = NULL;
+    }
+}
+
+static size_t PsBatchRemain( const demux_sys_t *p_sys )
+{
+    return p_sys->p_batch ? p_sys->p_batch->i_buffer : 0;
+}
+
+/* Reads ahead so that at least i_size bytes are available, unless at EOF.
+ * The unconsumed part of the previous read is carried over. */
+static void PsBatchRefill( demux_t *p_demux, size_t i_size )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const size_t i_remain = PsBatchRemain( p_sys );
+    const size_t i_alloc = __MAX( i_size, PS_BATCH_SIZE );
+
+    block_t *p_batch = block_Alloc( i_alloc );
+    if( unlikely(!p_batch) )
+        return;
+
+    if( i_remain > 0 )
+        memcpy( p_batch->p_buffer, p_sys->p_batch->p_buffer, i_remain );
+    ssize_t i_read = vlc_stream_Read( p_demux->s, &p_batch->p_buffer[i_remain],
+                                      i_alloc - i_remain );
+    p_batch->i_buffer = i_remain + ( i_read > 0 ? i_read : 0 );
+
+    PsBatchFlush( p_sys );
+    p_sys->p_batch = p_batch;
+}
+
+static ssize_t PsPeek( demux_t *p_demux, const uint8_t **pp_peek, size_t i_peek )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !p_sys->b_batch )
+        return vlc_stream_Peek( p_demux->s, pp_peek, i_peek );
+
+    if( PsBatchRemain( p_sys ) < i_peek )
+        PsBatchRefill( p_demux, i_peek );
+    if( !p_sys->p_batch )
+        return 0;
+
+    *pp_peek = p_sys->p_batch->p_buffer;
+    return __MIN( i_peek, p_sys->p_batch->i_buffer );
+}
+
+static ssize_t PsSkip( demux_t *p_demux, size_t i_skip )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !p_sys->b_batch )
+        return vlc_stream_Read( p_demux->s, NULL, i_skip );
+
+    const size_t i_remain = PsBatchRemain( p_sys );
+    if( i_skip <= i_remain )
+    {
+        p_sys->p_batch->p_buffer += i_skip;
+        p_sys->p_batch->i_buffer -= i_skip;
+        return i_skip;
+    }
+
+    PsBatchFlush( p_sys );
+    ssize_t i_read = vlc_stream_Read( p_demux->s, NULL, i_skip - i_remain );
+    return i_remain + ( i_read > 0 ? i_read : 0 );
+}
+
+/* Hands out the next i_size bytes as a block sharing the payload of the
+ * current read, instead of copying them out of the stream */
+static block_t *PsBlock( demux_t *p_demux, size_t i_size )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const uint8_t *p_peek;
+
+    if( !p_sys->b_batch )
+        return vlc_stream_Block( p_demux->s, i_size );
+
+    ssize_t i_peek = PsPeek( p_demux, &p_peek, i_size );
+    if( i_peek <= 0 )
+        return NULL;
+
+    block_t *p_pkt = block_Share( &p_sys->p_batch );
+    if( unlikely(!p_pkt) )
+        return NULL;
+    p_pkt->i_buffer = i_peek;
+    PsSkip( p_demux, i_peek );
+    return p_pkt;
+}
+
+static uint64_t PsTell( demux_t *p_demux )
+{
+    return vlc_stream_Tell( p_demux->s ) - PsBatchRemain( p_demux->p_sys );
+}
+
+static int PsSeek( demux_t *p_demux, uint64_t i_pos )
+{
+    int i_ret = vlc_stream_Seek( p_demux->s, i_pos );
+    if( i_ret == VLC_SUCCESS )
+        PsBatchFlush( p_demux->p_sys );
+    return i_ret;
+}
+
 /* PSResynch: resynch on a system startcode
  *  It doesn't skip more than 512 bytes
  *  -1 -> error, 0 -> not synch, 1 -> ok
  */
-static int ps_pkt_resynch( stream_t *s, int format, bool b_pack )
+static int ps_pkt_resynch( demux_t *p_demux, int format, bool b_pack )
 {
     const uint8_t *p_peek;
     int     i_peek;
     int     i_skip;
 
-    if( vlc_stream_Peek( s, &p_peek, 4 ) < 4 )
+    if( PsPeek( p_demux, &p_peek, 4 ) < 4 )
     {
         return -1;
     }
@@ -811,7 +938,7 @@ static int ps_pkt_resynch( stream_t *s, int format, bool b_pack )
         return 1;
     }
 
-    if( ( i_peek = vlc_stream_Peek( s, &p_peek, 512 ) ) < 4 )
+    if( ( i_peek = PsPeek( p_demux, &p_peek, 512 ) ) < 4 )
     {
         return -1;
     }
@@ -842,20 +969,20 @@ static int ps_pkt_resynch( stream_t *s, int format, bool b_pack )
             p_peek[3] >= PS_STREAM_ID_END_STREAM &&
             ( !b_pack || p_peek[3] == PS_STREAM_ID_PACK_HEADER ) )
         {
-            return vlc_stream_Read( s, NULL, i_skip ) == i_skip ? 1 : -1;
+            return PsSkip( p_demux, i_skip ) == i_skip ? 1 : -1;
         }
 
         p_peek++;
         i_peek--;
         i_skip++;
     }
-    return vlc_stream_Read( s, NULL, i_skip ) == i_skip ? 0 : -1;
+    return PsSkip( p_demux, i_skip ) == i_skip ? 0 : -1;
 }
 
-static block_t *ps_pkt_read( stream_t *s )
+static block_t *ps_pkt_read( demux_t *p_demux )
 {
     const uint8_t *p_peek;
-    int i_peek = vlc_stream_Peek( s, &p_peek, 14 );
+    int i_peek = PsPeek( p_demux, &p_peek, 14 );
     if( i_peek < 4 )
         return NULL;
 
@@ -866,7 +993,7 @@ static block_t *ps_pkt_read( stream_t *s )
         i_size = 6;
         for( ;; )
         {
-            i_peek = vlc_stream_Peek( s, &p_peek, i_size + 1024 );
+            i_peek = PsPeek( p_demux, &p_peek, i_size + 1024 );
             if( i_peek <= i_size + 4 )
             {
                 return NULL;
@@ -876,7 +1003,7 @@ static block_t *ps_pkt_read( stream_t *s )
                 if( p_peek[i_size] == 0x00 && p_peek[i_size+1] == 0x00 &&
                     p_peek[i_size+2] == 0x01 && p_peek[i_size+3] >= PS_STREAM_ID_END_STREAM )
                 {
-                    return vlc_stream_Block( s, i_size );
+                    return PsBlock( p_demux, i_size );
                 }
                 i_size++;
             }
@@ -885,7 +1012,7 @@ static block_t *ps_pkt_read( stream_t *s )
     else
     {
         /* Normal case */
-        return vlc_stream_Block( s, i_size );
+        return PsBlock( p_demux, i_size );
     }
 
     return NULL;
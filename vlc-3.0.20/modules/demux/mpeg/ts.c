@@ -35,6 +35,7 @@
 #include <vlc_access.h>    /* DVB-specific things */
 #include <vlc_demux.h>
 #include <vlc_input.h>
+#include <vlc_atomic.h>
 
 #include "ts_pid.h"
 #include "ts_streams.h"
@@ -46,6 +47,7 @@
 #include "ts_hotfixes.h"
 #include "ts_sl.h"
 #include "ts_metadata.h"
+#include "ts_workers.h"
 #include "sections.h"
 #include "pes.h"
 #include "timestamps.h"
@@ -122,6 +124,18 @@ static void Close ( vlc_object_t * );
 #define TS_SKIP_GHOST_PROGRAM_TEXT "Only create ES on program sending data"
 #define TS_OFFSETFIX_TEXT   "Try to fix too early PCR (or late DTS)"
 
+#define BATCH_TEXT N_("Packets per read")
+#define BATCH_LONGTEXT N_( \
+    "Read that many TS packets at once and hand them out as references " \
+    "to the same buffer instead of copying each of them. The buffer stays " \
+    "allocated until all its packets are released. 1 reads packet by packet." )
+
+#define WORKERS_TEXT N_("Output threads")
+#define WORKERS_LONGTEXT N_( \
+    "Send the elementary streams from that many threads, each one serving " \
+    "its own share of the programs, so that a program slow to output can't " \
+    "hold back the others. 0 sends everything from the input thread." )
+
 #define PCR_TEXT N_("Trust in-stream PCR")
 #define PCR_LONGTEXT N_("Use the stream PCR as a reference.")
 
@@ -157,6 +171,8 @@ vlc_module_begin ()
     add_integer( "ts-csa-pkt", 188, CPKT_TEXT, CPKT_LONGTEXT, true )
         change_safe()
 
+    add_integer_with_range( "ts-read-packets", 1, 1, 2048, BATCH_TEXT, BATCH_LONGTEXT, true )
+    add_integer_with_range( "ts-workers", 0, 0, 32, WORKERS_TEXT, WORKERS_LONGTEXT, true )
     add_bool( "ts-split-es", true, SPLIT_ES_TEXT, SPLIT_ES_LONGTEXT, false )
     add_bool( "ts-seek-percent", false, SEEK_PERCENT_TEXT, SEEK_PERCENT_LONGTEXT, true )
     add_bool( "ts-cc-check", true, CC_CHECK_TEXT, CC_CHECK_LONGTEXT, true )
@@ -196,10 +212,22 @@ static bool GatherSectionsData( demux_t *p_demux, ts_pid_t *, block_t *, size_t
 static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_prg, vlc_tick_t i_pcr );
 
 static block_t* ReadTSPacket( demux_t *p_demux );
+static void TsBatchFlush( demux_sys_t * );
+static int TsSeek( demux_sys_t *, uint64_t );
+static uint64_t TsTell( demux_sys_t * );
+static unsigned SkipFilteredTSPackets( demux_t *p_demux );
+static void PublishSkipStats( demux_t *p_demux );
 static int SeekToTime( demux_t *p_demux, const ts_pmt_t *, int64_t time );
 static void ReadyQueuesPostSeek( demux_t *p_demux );
 static void PCRHandle( demux_t *p_demux, ts_pid_t *, vlc_tick_t );
 static void PCRFixHandle( demux_t *, ts_pmt_t *, block_t * );
+static void RunOutputJob( demux_t *, ts_worker_job_t * );
+
+static inline void DrainOutput( demux_sys_t *p_sys )
+{
+    if( p_sys->p_workers )
+        ts_workers_Drain( p_sys->p_workers );
+}
 
 #define TS_PACKET_SIZE_188 188
 #define TS_PACKET_SIZE_192 192
@@ -207,6 +235,9 @@ static void PCRFixHandle( demux_t *, ts_pmt_t *, block_t * );
 #define TS_PACKET_SIZE_MAX 204
 #define TS_HEADER_SIZE 4
 
+/* how many packets we scan at once when skipping filtered pids */
+#define TS_SKIP_BATCH_COUNT 128
+
 #define PROBE_CHUNK_COUNT 500
 #define PROBE_MAX         (PROBE_CHUNK_COUNT * 10)
 
@@ -404,6 +435,9 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_packet_size = i_packet_size;
     p_sys->i_packet_header_size = i_packet_header_size;
     p_sys->i_ts_read = 50;
+    p_sys->i_batch_packets = var_InheritInteger( p_demux, "ts-read-packets" );
+    p_sys->p_batch = NULL;
+    p_sys->p_workers = NULL;
     p_sys->csa = NULL;
     p_sys->b_start_record = false;
 
@@ -498,6 +532,10 @@ static int Open( vlc_object_t *p_this )
 
     p_sys->b_split_es = var_InheritBool( p_demux, "ts-split-es" );
 
+    unsigned i_workers = var_InheritInteger( p_demux, "ts-workers" );
+    if( i_workers > 0 )
+        p_sys->p_workers = ts_workers_New( p_demux, i_workers, RunOutputJob );
+
     p_sys->b_canseek = false;
     p_sys->b_canfastseek = false;
     p_sys->b_ignore_time_for_positions = var_InheritBool( p_demux, "ts-seek-percent" );
@@ -526,6 +564,8 @@ static int Open( vlc_object_t *p_this )
         TsChangeStandard( p_sys, TS_STANDARD_ATSC );
     }
 
+    var_Create( p_demux, "ts-skipped-packets", VLC_VAR_INTEGER );
+
     vlc_stream_Control( p_sys->stream, STREAM_CAN_SEEK, &p_sys->b_canseek );
     vlc_stream_Control( p_sys->stream, STREAM_CAN_FASTSEEK,
                         &p_sys->b_canfastseek );
@@ -560,6 +600,19 @@ static void Close( vlc_object_t *p_this )
     demux_t     *p_demux = (demux_t*)p_this;
     demux_sys_t *p_sys = p_demux->p_sys;
 
+    if( p_sys->stats.i_start > 0 )
+    {
+        const vlc_tick_t i_elapsed = mdate() - p_sys->stats.i_start;
+        msg_Dbg( p_demux, "read %"PRIu64" packets (%"PRIu64" skipped unparsed), "
+                 "%"PRIu64" packets/s", p_sys->stats.i_packets, p_sys->stats.i_skipped,
+                 i_elapsed > 0 ? p_sys->stats.i_packets * CLOCK_FREQ / i_elapsed : 0 );
+    }
+
+    TsBatchFlush( p_sys );
+
+    if( p_sys->p_workers )
+        ts_workers_Delete( p_sys->p_workers );
+
     PIDRelease( p_demux, GetPID(p_sys, 0) );
 
     vlc_mutex_lock( &p_sys->csa_lock );
@@ -628,21 +681,30 @@ static int Demux( demux_t *p_demux )
     /* If we had no PAT within MIN_PAT_INTERVAL, create PAT/PMT from probed streams */
     if( p_sys->i_pmt_es == 0 && !SEEN(GetPID(p_sys, 0)) && p_sys->patfix.status == PAT_MISSING )
     {
+        DrainOutput( p_sys );
         MissingPATPMTFixup( p_demux );
         p_sys->patfix.status = PAT_FIXTRIED;
         GetPID(p_sys, 0)->u.p_pat->b_generated = true;
     }
 
+    if( unlikely(p_sys->stats.i_start == 0) )
+        p_sys->stats.i_start = mdate();
+
     /* We read at most 100 TS packet or until a frame is completed */
     for( unsigned i_pkt = 0; i_pkt < p_sys->i_ts_read; i_pkt++ )
     {
         bool         b_frame = false;
         int          i_header = 0;
         block_t     *p_pkt;
+
+        SkipFilteredTSPackets( p_demux );
+
         if( !(p_pkt = ReadTSPacket( p_demux )) )
         {
+            PublishSkipStats( p_demux );
             return VLC_DEMUXER_EOF;
         }
+        p_sys->stats.i_packets++;
 
         if( p_sys->b_start_record )
         {
@@ -650,6 +712,7 @@ static int Demux( demux_t *p_demux )
             vlc_stream_Control( p_sys->stream, STREAM_SET_RECORD_STATE, true,
                                 "ts" );
             p_sys->b_start_record = false;
+            p_sys->b_recording = true;
         }
 
         /* Early reject truncated packets from hw devices */
@@ -708,6 +771,8 @@ static int Demux( demux_t *p_demux )
         {
         case TYPE_PAT:
         case TYPE_PMT:
+            /* Tables updates can change or delete the ES output jobs refer to */
+            DrainOutput( p_sys );
             /* PAT and PMT are not allowed to be scrambled */
             ts_psi_Packet_Push( p_pid, p_pkt->p_buffer );
             block_Release( p_pkt );
@@ -769,6 +834,7 @@ static int Demux( demux_t *p_demux )
             break;
     }
 
+    PublishSkipStats( p_demux );
     demux_UpdateTitleFromStream( p_demux );
     return VLC_DEMUXER_SUCCESS;
 }
@@ -815,6 +881,8 @@ void UpdatePESFilters( demux_t *p_demux, bool b_all )
     demux_sys_t *p_sys = p_demux->p_sys;
     ts_pat_t *p_pat = GetPID(p_sys, 0)->u.p_pat;
 
+    DrainOutput( p_sys );
+
     /* We need 3 pass to avoid loss on deselect/relesect with hw filters and
        because pid could be shared and its state altered by another unselected pmt
        First clear flag on every referenced pid
@@ -908,6 +976,23 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             p_pmt = p_pat->programs.p_elems[i]->u.p_pmt;
     }
 
+    switch( i_query )
+    {
+    case DEMUX_CAN_SEEK:
+    case DEMUX_GET_POSITION:
+    case DEMUX_GET_TIME:
+    case DEMUX_GET_LENGTH:
+    case DEMUX_GET_META:
+    case DEMUX_GET_SIGNAL:
+    case DEMUX_GET_TITLE_INFO:
+    case DEMUX_CAN_RECORD:
+        /* frequent queries not touching the output */
+        break;
+    default:
+        DrainOutput( p_sys );
+        break;
+    }
+
     switch( i_query )
     {
     case DEMUX_CAN_SEEK:
@@ -947,7 +1032,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         if( (i64 = stream_Size( p_sys->stream) ) > 0 )
         {
-            uint64_t offset = vlc_stream_Tell( p_sys->stream );
+            uint64_t offset = TsTell( p_sys );
             *pf = (double)offset / (double)i64;
             return VLC_SUCCESS;
         }
@@ -994,7 +1079,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         i64 = stream_Size( p_sys->stream );
         if( i64 > 0 &&
-            vlc_stream_Seek( p_sys->stream, (int64_t)(i64 * f) ) == VLC_SUCCESS )
+            TsSeek( p_sys, (int64_t)(i64 * f) ) == VLC_SUCCESS )
         {
             ReadyQueuesPostSeek( p_demux );
             return VLC_SUCCESS;
@@ -1131,9 +1216,11 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     }
 
     case DEMUX_SET_TITLE:
+        TsBatchFlush( p_sys );
         return vlc_stream_vaControl( p_sys->stream, STREAM_SET_TITLE, args );
 
     case DEMUX_SET_SEEKPOINT:
+        TsBatchFlush( p_sys );
         return vlc_stream_vaControl( p_sys->stream, STREAM_SET_SEEKPOINT,
                                      args );
 
@@ -1149,8 +1236,11 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
         b_bool = va_arg( args, int );
 
         if( !b_bool )
+        {
             vlc_stream_Control( p_sys->stream, STREAM_SET_RECORD_STATE,
                                 false );
+            p_sys->b_recording = false;
+        }
         p_sys->b_start_record = b_bool;
         return VLC_SUCCESS;
 
@@ -1386,7 +1476,8 @@ static block_t * ConvertPESBlock( demux_t *p_demux, ts_es_t *p_es,
 /****************************************************************************
  * fanouts current block to all subdecoders / shared pid es
  ****************************************************************************/
-static void SendDataChain( demux_t *p_demux, ts_es_t *p_es, block_t *p_chain )
+static void SendDataChain( demux_t *p_demux, ts_es_t *p_es, uint32_t i_flags,
+                           block_t *p_chain )
 {
     while( p_chain )
     {
@@ -1395,11 +1486,8 @@ static void SendDataChain( demux_t *p_demux, ts_es_t *p_es, block_t *p_chain )
         p_block->p_next = NULL;
 
         ts_es_t *p_es_send = p_es;
-        if( p_es_send->i_next_block_flags )
-        {
-            p_block->i_flags |= p_es_send->i_next_block_flags;
-            p_es_send->i_next_block_flags = 0;
-        }
+        p_block->i_flags |= i_flags;
+        i_flags = 0;
 
         while( p_es_send )
         {
@@ -1444,6 +1532,47 @@ static void SendDataChain( demux_t *p_demux, ts_es_t *p_es, block_t *p_chain )
     }
 }
 
+/* Sends from the input thread, or hands over to the thread serving the
+ * program. Pending discontinuity flags are taken here, as the input thread
+ * keeps on setting them. A pid shared between programs fans out to the ES
+ * of each of them, so it stays on the input thread: a single program's
+ * thread would race with the others' and let their PCR overtake the data. */
+static void OutputDataChain( demux_t *p_demux, ts_es_t *p_es, block_t *p_chain )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !p_chain )
+        return;
+
+    const uint32_t i_flags = p_es->i_next_block_flags;
+    p_es->i_next_block_flags = 0;
+
+    if( p_sys->p_workers && p_es->p_next == NULL )
+    {
+        ts_worker_job_t *p_job = malloc( sizeof(*p_job) );
+        if( likely(p_job) )
+        {
+            p_job->p_es = p_es;
+            p_job->p_chain = p_chain;
+            p_job->i_flags = i_flags;
+            p_job->i_program = p_es->p_program->i_number;
+            ts_workers_Queue( p_sys->p_workers, p_job );
+            return;
+        }
+    }
+
+    SendDataChain( p_demux, p_es, i_flags, p_chain );
+}
+
+static void RunOutputJob( demux_t *p_demux, ts_worker_job_t *p_job )
+{
+    if( p_job->p_es )
+        SendDataChain( p_demux, p_job->p_es, p_job->i_flags, p_job->p_chain );
+    else
+        es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR,
+                        p_job->i_program, p_job->i_pcr );
+}
+
 /****************************************************************************
  * gathering stuff
  ****************************************************************************/
@@ -1647,7 +1776,7 @@ static void ParsePESDataChain( demux_t *p_demux, ts_pid_t *pid, block_t *p_pes,
                     p_block = ConvertPESBlock( p_demux, p_es, i_pes_size, i_stream_id, p_block );
                 }
 
-                SendDataChain( p_demux, p_es, p_block );
+                OutputDataChain( p_demux, p_es, p_block );
             }
             else
             {
@@ -1717,6 +1846,193 @@ static bool PushPESBlock( demux_t *p_demux, ts_pid_t *pid, block_t *p_pkt, bool
     return b_ret;
 }
 
+/*****************************************************************************
+ * Batched reads: a single stream read split into refcounted packet views
+ *****************************************************************************/
+typedef struct
+{
+    block_t     self;
+    ts_batch_t *p_batch;
+} ts_packet_view_t;
+
+struct ts_batch_t
+{
+    atomic_uint      refs;     /* demuxer reference + views not yet released */
+    block_t         *p_block;  /* the stream read */
+    size_t           i_offset; /* first byte not handed out yet */
+    unsigned         i_views;
+    ts_packet_view_t views[];
+};
+
+static void TsBatchRelease( ts_batch_t *p_batch )
+{
+    if( atomic_fetch_sub_explicit( &p_batch->refs, 1, memory_order_acq_rel ) == 1 )
+    {
+        block_Release( p_batch->p_block );
+        free( p_batch );
+    }
+}
+
+/* views can end up released from any decoder thread */
+static void TsPacketViewRelease( block_t *p_block )
+{
+    ts_packet_view_t *p_view = container_of( p_block, ts_packet_view_t, self );
+    TsBatchRelease( p_view->p_batch );
+}
+
+static void TsBatchFlush( demux_sys_t *p_sys )
+{
+    if( p_sys->p_batch )
+    {
+        TsBatchRelease( p_sys->p_batch );
+        p_sys->p_batch = NULL;
+    }
+}
+
+static size_t TsBatchRemain( const demux_sys_t *p_sys )
+{
+    const ts_batch_t *p_batch = p_sys->p_batch;
+    return p_batch ? p_batch->p_block->i_buffer - p_batch->i_offset : 0;
+}
+
+/* Descrambles the packets of a new read all at once. Stops at the first lost
+ * sync, leaving the rest to per packet csa_Decrypt() after resync */
+static void TsBatchDescramble( demux_sys_t *p_sys, block_t *p_block )
+{
+    const size_t i_size = p_sys->i_packet_size;
+    uint8_t *pkts[CSA_BATCH_MAX];
+    int i_pkts = 0;
+
+    vlc_mutex_lock( &p_sys->csa_lock );
+    for( size_t i = 0; i + i_size <= p_block->i_buffer; i += i_size )
+    {
+        uint8_t *p = &p_block->p_buffer[i + p_sys->i_packet_header_size];
+        if( p[0] != 0x47 )
+            break;
+        /* skip corrupted, stuffing, and clear packets */
+        if( (p[1]&0x80) || ( (p[1]&0x1f) == 0x1f && p[2] == 0xff ) || !(p[3]&0x80) )
+            continue;
+        pkts[i_pkts++] = p;
+        if( i_pkts == CSA_BATCH_MAX )
+        {
+            csa_DecryptBatch( p_sys->csa, pkts, i_pkts, p_sys->i_csa_pkt_size );
+            i_pkts = 0;
+        }
+    }
+    if( i_pkts > 0 )
+        csa_DecryptBatch( p_sys->csa, pkts, i_pkts, p_sys->i_csa_pkt_size );
+    vlc_mutex_unlock( &p_sys->csa_lock );
+}
+
+static bool TsBatchRefill( demux_sys_t *p_sys )
+{
+    TsBatchFlush( p_sys );
+
+    const unsigned i_count = p_sys->i_batch_packets;
+    ts_batch_t *p_batch = malloc( sizeof(*p_batch) + i_count * sizeof(p_batch->views[0]) );
+    if( unlikely(!p_batch) )
+        return false;
+
+    p_batch->p_block = vlc_stream_Block( p_sys->stream, (size_t)i_count * p_sys->i_packet_size );
+    if( !p_batch->p_block )
+    {
+        free( p_batch );
+        return false;
+    }
+    if( p_sys->csa )
+        TsBatchDescramble( p_sys, p_batch->p_block );
+
+    atomic_init( &p_batch->refs, 1 );
+    p_batch->i_offset = 0;
+    p_batch->i_views = 0;
+    p_sys->p_batch = p_batch;
+    return true;
+}
+
+/* Position of the next packet, not of the stream which is ahead by the
+ * part of the current read not handed out yet */
+static uint64_t TsTell( demux_sys_t *p_sys )
+{
+    return vlc_stream_Tell( p_sys->stream ) - TsBatchRemain( p_sys );
+}
+
+static int TsSeek( demux_sys_t *p_sys, uint64_t i_pos )
+{
+    TsBatchFlush( p_sys );
+    return vlc_stream_Seek( p_sys->stream, i_pos );
+}
+
+static block_t *TsReadPacketBlock( demux_sys_t *p_sys )
+{
+    const size_t i_size = p_sys->i_packet_size;
+
+    if( p_sys->i_batch_packets <= 1 )
+        return vlc_stream_Block( p_sys->stream, i_size );
+
+    if( TsBatchRemain( p_sys ) == 0 && !TsBatchRefill( p_sys ) )
+        return NULL;
+
+    ts_batch_t *p_batch = p_sys->p_batch;
+    const size_t i_remain = TsBatchRemain( p_sys );
+    uint8_t *p_data = &p_batch->p_block->p_buffer[p_batch->i_offset];
+
+    if( likely(i_remain >= i_size) )
+    {
+        /* each view consumes i_size bytes of a i_count * i_size read */
+        assert( p_batch->i_views < p_sys->i_batch_packets );
+        ts_packet_view_t *p_view = &p_batch->views[p_batch->i_views++];
+        block_Init( &p_view->self, p_data, i_size );
+        p_view->self.pf_release = TsPacketViewRelease;
+        p_view->p_batch = p_batch;
+        atomic_fetch_add_explicit( &p_batch->refs, 1, memory_order_relaxed );
+        p_batch->i_offset += i_size;
+        return &p_view->self;
+    }
+
+    /* Packet straddling two reads after a resync, or truncated at EOF */
+    block_t *p_pkt = block_Alloc( i_size );
+    if( likely(p_pkt) )
+    {
+        memcpy( p_pkt->p_buffer, p_data, i_remain );
+        ssize_t i_read = vlc_stream_Read( p_sys->stream, &p_pkt->p_buffer[i_remain],
+                                          i_size - i_remain );
+        p_pkt->i_buffer = i_remain + ( i_read > 0 ? i_read : 0 );
+    }
+    TsBatchFlush( p_sys );
+    return p_pkt;
+}
+
+/* Looks for sync within the current read, starting right past the packet
+ * that lost it. Drops the read when it has none. */
+static bool TsBatchResync( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    ts_batch_t *p_batch = p_sys->p_batch;
+    if( !p_batch )
+        return false;
+
+    const uint8_t *p_buf = p_batch->p_block->p_buffer;
+    const size_t i_buf = p_batch->p_block->i_buffer;
+    const size_t i_sync = p_sys->i_packet_header_size;
+
+    for( size_t i = p_batch->i_offset; i + i_sync + p_sys->i_packet_size < i_buf; i++ )
+    {
+        if( p_buf[i + i_sync] == 0x47 &&
+            p_buf[i + i_sync + p_sys->i_packet_size] == 0x47 )
+        {
+            msg_Dbg( p_demux, "skipping %zu bytes of garbage at %"PRIu64,
+                     i - p_batch->i_offset, TsTell( p_sys ) );
+            p_batch->i_offset = i;
+            return true;
+        }
+    }
+
+    msg_Dbg( p_demux, "skipping %zu bytes of garbage at %"PRIu64,
+             TsBatchRemain( p_sys ), TsTell( p_sys ) );
+    TsBatchFlush( p_sys );
+    return false;
+}
+
 static block_t* ReadTSPacket( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -1724,13 +2040,13 @@ static block_t* ReadTSPacket( demux_t *p_demux )
     block_t     *p_pkt;
 
     /* Get a new TS packet */
-    if( !( p_pkt = vlc_stream_Block( p_sys->stream, p_sys->i_packet_size ) ) )
+    if( !( p_pkt = TsReadPacketBlock( p_sys ) ) )
     {
         int64_t size = stream_Size( p_sys->stream );
-        if( size >= 0 && (uint64_t)size == vlc_stream_Tell( p_sys->stream ) )
-            msg_Dbg( p_demux, "EOF at %"PRIu64, vlc_stream_Tell( p_sys->stream ) );
+        if( size >= 0 && (uint64_t)size == TsTell( p_sys ) )
+            msg_Dbg( p_demux, "EOF at %"PRIu64, TsTell( p_sys ) );
         else
-            msg_Dbg( p_demux, "Can't read TS packet at %"PRIu64, vlc_stream_Tell(p_sys->stream) );
+            msg_Dbg( p_demux, "Can't read TS packet at %"PRIu64, TsTell( p_sys ) );
         return NULL;
     }
 
@@ -1754,6 +2070,9 @@ static block_t* ReadTSPacket( demux_t *p_demux )
         block_Release( p_pkt );
         for( ;; )
         {
+            if( TsBatchResync( p_demux ) )
+                break;
+
             const uint8_t *p_peek;
             int i_peek = 0;
             unsigned i_skip = 0;
@@ -1776,7 +2095,7 @@ static block_t* ReadTSPacket( demux_t *p_demux )
                 i_skip++;
             }
             msg_Dbg( p_demux, "skipping %d bytes of garbage at %"PRIu64,
-                     i_skip, vlc_stream_Tell( p_sys->stream ) );
+                     i_skip, TsTell( p_sys ) );
             if (vlc_stream_Read( p_sys->stream, NULL, i_skip ) != i_skip)
                 return NULL;
 
@@ -1785,8 +2104,8 @@ static block_t* ReadTSPacket( demux_t *p_demux )
                 break;
             }
         }
-        msg_Dbg( p_demux, "resynced at %" PRIu64, vlc_stream_Tell( p_sys->stream ) );
-        if( !( p_pkt = vlc_stream_Block( p_sys->stream, p_sys->i_packet_size ) ) )
+        msg_Dbg( p_demux, "resynced at %" PRIu64, TsTell( p_sys ) );
+        if( !( p_pkt = TsReadPacketBlock( p_sys ) ) )
         {
             msg_Dbg( p_demux, "eof ?" );
             return NULL;
@@ -1795,6 +2114,131 @@ static block_t* ReadTSPacket( demux_t *p_demux )
     return p_pkt;
 }
 
+/* Tells if all packets of that pid would be thrown away by Demux() anyway:
+ * stuffing, or unselected ES that only the HW filter emulation keeps from
+ * being gathered */
+static bool PIDIsDiscardable( demux_sys_t *p_sys, const ts_pid_t *pid )
+{
+    if( pid->i_pid == 0x1FFF )
+        return SEEN(pid);
+
+    if( pid->type != TYPE_STREAM || !SEEN(pid) || (pid->i_flags & FLAG_FILTERED) )
+        return false;
+
+    /* PCR still has to be extracted from any program clock carrier */
+    const ts_pat_t *p_pat = GetPID(p_sys, 0)->u.p_pat;
+    for( int i = 0; i < p_pat->programs.i_size; i++ )
+    {
+        const ts_pmt_t *p_pmt = p_pat->programs.p_elems[i]->u.p_pmt;
+        if( p_pmt->i_pid_pcr == pid->i_pid )
+            return false;
+    }
+    return true;
+}
+
+/* Returns the pid of a packet which can be dropped unparsed, or NULL */
+static ts_pid_t *GetDiscardablePID( demux_sys_t *p_sys, const uint8_t *p )
+{
+    /* Let ReadTSPacket() resync and Demux() report errors */
+    if( p[0] != 0x47 || (p[1] & 0x80) )
+        return NULL;
+
+    ts_pid_t *pid = GetPID( p_sys, ( (p[1]&0x1f)<<8 )|p[2] );
+    return PIDIsDiscardable( p_sys, pid ) ? pid : NULL;
+}
+
+/* Drops the run of discardable packets at the current stream position.
+ * The packets are checked in place in the stream buffer and skipped all at
+ * once, so that unselected programs of a mux never cost a block_t or a
+ * ProcessTSPacket() call. Stops at the first packet needing real parsing,
+ * and when anything that could need those packets (no access filter,
+ * recording, pat fixup probing, delayed ES creation) is in effect. */
+static unsigned SkipFilteredTSPackets( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->b_access_control || p_sys->b_recording || p_sys->b_start_record ||
+        p_sys->es_creation == DELAY_ES )
+        return 0;
+
+    ts_pid_t *patpid = GetPID(p_sys, 0);
+    if( !SEEN(patpid) || unlikely(patpid->type != TYPE_PAT) )
+        return 0;
+
+    const uint8_t *p_peek;
+    const size_t i_size = p_sys->i_packet_size;
+    ssize_t i_peek;
+    if( p_sys->i_batch_packets > 1 )
+    {
+        /* scan the current read instead of the stream */
+        if( TsBatchRemain( p_sys ) == 0 && !TsBatchRefill( p_sys ) )
+            return 0;
+        p_peek = &p_sys->p_batch->p_block->p_buffer[p_sys->p_batch->i_offset];
+        i_peek = TsBatchRemain( p_sys );
+    }
+    else
+    {
+        /* Most calls stop on a selected packet: check the first one before
+         * peeking a whole batch */
+        if( vlc_stream_Peek( p_sys->stream, &p_peek, i_size ) < (ssize_t) i_size ||
+            GetDiscardablePID( p_sys, &p_peek[p_sys->i_packet_header_size] ) == NULL )
+            return 0;
+        i_peek = vlc_stream_Peek( p_sys->stream, &p_peek,
+                                  i_size * TS_SKIP_BATCH_COUNT );
+    }
+    if( i_peek < (ssize_t) i_size )
+        return 0;
+
+    const unsigned i_count = i_peek / i_size;
+    const uint8_t *p = &p_peek[p_sys->i_packet_header_size];
+    int i_last_pid = -1;
+    unsigned i_skip = 0;
+
+    for( ; i_skip < i_count; i_skip++, p += i_size )
+    {
+        /* Let ReadTSPacket() resync and Demux() report errors */
+        if( p[0] != 0x47 || (p[1] & 0x80) )
+            break;
+
+        /* Muxers emit runs of the same pid, only look it up on change */
+        const int i_pid = ( (p[1]&0x1f)<<8 )|p[2];
+        if( i_pid != i_last_pid )
+        {
+            ts_pid_t *pid = GetDiscardablePID( p_sys, p );
+            if( pid == NULL )
+                break;
+            /* Continuity is lost while skipping. Don't flag a
+             * discontinuity if that ES gets selected later */
+            pid->i_cc = 0xff;
+            i_last_pid = i_pid;
+        }
+    }
+
+    if( i_skip == 0 )
+        return 0;
+
+    if( p_sys->p_batch )
+        p_sys->p_batch->i_offset += i_skip * i_size;
+    else if( vlc_stream_Read( p_sys->stream, NULL, i_skip * i_size ) != (ssize_t)(i_skip * i_size) )
+        return 0;
+
+    p_sys->b_end_preparse = true;
+    p_sys->stats.i_packets += i_skip;
+    p_sys->stats.i_skipped += i_skip;
+    return i_skip;
+}
+
+/* Once per Demux() call, not per skipped run, as setting a variable locks */
+static void PublishSkipStats( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->stats.i_skipped == p_sys->stats.i_skipped_published )
+        return;
+    p_sys->stats.i_skipped_published = p_sys->stats.i_skipped;
+    var_SetInteger( p_demux, "ts-skipped-packets", p_sys->stats.i_skipped );
+}
+
 static vlc_tick_t GetPCR( const block_t *p_pkt )
 {
     const uint8_t *p = p_pkt->p_buffer;
@@ -1906,13 +2350,13 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, int64_t i_scaled
 
     /* Deal with common but worst binary search case */
     if( p_pmt->pcr.i_first == i_scaledtime && p_sys->b_canseek )
-        return vlc_stream_Seek( p_sys->stream, 0 );
+        return TsSeek( p_sys, 0 );
 
     const int64_t i_stream_size = stream_Size( p_sys->stream );
     if( !p_sys->b_canfastseek || i_stream_size < p_sys->i_packet_size )
         return VLC_EGENERIC;
 
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TsTell( p_sys );
 
     /* Find the time position by using binary search algorithm. */
     uint64_t i_head_pos = 0;
@@ -1928,7 +2372,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, int64_t i_scaled
         uint64_t i_div = i_splitpos % p_sys->i_packet_size;
         i_splitpos -= i_div;
 
-        if ( vlc_stream_Seek( p_sys->stream, i_splitpos ) != VLC_SUCCESS )
+        if ( TsSeek( p_sys, i_splitpos ) != VLC_SUCCESS )
             break;
 
         uint64_t i_pos = i_splitpos;
@@ -1942,7 +2386,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, int64_t i_scaled
                 break;
             }
             else
-                i_pos = vlc_stream_Tell( p_sys->stream );
+                i_pos = TsTell( p_sys );
 
             int i_pid = PIDGet( p_pkt );
             ts_pid_t *p_pid = GetPID(p_sys, i_pid);
@@ -1999,7 +2443,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, int64_t i_scaled
     if( !b_found )
     {
         msg_Dbg( p_demux, "Seek():cannot find a time position." );
-        vlc_stream_Seek( p_sys->stream, i_initial_pos );
+        TsSeek( p_sys, i_initial_pos );
         return VLC_EGENERIC;
     }
     return VLC_SUCCESS;
@@ -2080,7 +2524,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, int64_t *pi_
                         if( b_end )
                         {
                             p_pmt->i_last_dts = *pi_pcr;
-                            p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                            p_pmt->i_last_dts_byte = TsTell( p_sys );
                         }
                         /* Start, only keep first */
                         else if( b_pcrresult && p_pmt->pcr.i_first == -1 )
@@ -2108,7 +2552,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, int64_t *pi_
 int ProbeStart( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TsTell( p_sys );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = 0;
@@ -2121,7 +2565,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
         i_pos = p_sys->i_packet_size * i_probe_count;
         i_pos = __MIN( i_pos, i_stream_size );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( TsSeek( p_sys, i_pos ) )
             return VLC_EGENERIC;
 
         ProbeChunk( p_demux, i_program, false, &i_pcr, &b_found );
@@ -2131,7 +2575,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
     } while( i_pos < i_stream_size && !b_found &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( TsSeek( p_sys, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2140,7 +2584,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
 int ProbeEnd( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TsTell( p_sys );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = PROBE_CHUNK_COUNT;
@@ -2153,7 +2597,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
         i_pos = i_stream_size - (p_sys->i_packet_size * i_probe_count);
         i_pos = __MAX( i_pos, 0 );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( TsSeek( p_sys, i_pos ) )
             return VLC_EGENERIC;
 
         ProbeChunk( p_demux, i_program, true, &i_pcr, &b_found );
@@ -2163,7 +2607,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
     } while( i_pos > 0 && !b_found &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( TsSeek( p_sys, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2211,17 +2655,28 @@ static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, vlc_tick_t i_pcr )
 
     if ( p_sys->i_pmt_es )
     {
-        es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR, p_pmt->i_number, FROM_SCALE(i_pcr) );
+        ts_worker_job_t *p_job = p_sys->p_workers ? malloc( sizeof(*p_job) ) : NULL;
+        if( p_job )
+        {
+            /* Must not get ahead of the data already queued for output */
+            p_job->p_es = NULL;
+            p_job->p_chain = NULL;
+            p_job->i_program = p_pmt->i_number;
+            p_job->i_pcr = FROM_SCALE(i_pcr);
+            ts_workers_Queue( p_sys->p_workers, p_job );
+        }
+        else
+            es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR, p_pmt->i_number, FROM_SCALE(i_pcr) );
         /* growing files/named fifo handling */
         if( p_sys->b_access_control == false &&
-            vlc_stream_Tell( p_sys->stream ) > p_pmt->i_last_dts_byte )
+            TsTell( p_sys ) > p_pmt->i_last_dts_byte )
         {
             if( p_pmt->i_last_dts_byte == 0 ) /* first run */
                 p_pmt->i_last_dts_byte = stream_Size( p_sys->stream );
             else
             {
                 p_pmt->i_last_dts = i_pcr;
-                p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                p_pmt->i_last_dts_byte = TsTell( p_sys );
             }
         }
     }
@@ -2860,6 +3315,8 @@ void AddAndCreateES( demux_t *p_demux, ts_pid_t *pid, bool b_create_delayed )
 {
     demux_sys_t  *p_sys = p_demux->p_sys;
 
+    DrainOutput( p_sys );
+
     if( b_create_delayed )
         p_sys->es_creation = CREATE_ES;
 
@@ -24,6 +24,8 @@
     typedef struct arib_instance_t arib_instance_t;
 #endif
 typedef struct csa_t csa_t;
+typedef struct ts_batch_t ts_batch_t;
+typedef struct ts_workers_t ts_workers_t;
 
 #define TS_USER_PMT_NUMBER (0)
 
@@ -60,6 +62,13 @@ struct demux_sys_t
     /* how many TS packet we read at once */
     unsigned    i_ts_read;
 
+    /* packets per stream read when splitting large reads, and current read */
+    unsigned    i_batch_packets;
+    ts_batch_t *p_batch;
+
+    /* output threads, NULL when sending from the input thread */
+    ts_workers_t *p_workers;
+
     bool        b_cc_check;
     bool        b_ignore_time_for_positions;
 
@@ -130,6 +139,17 @@ struct demux_sys_t
 
     /* */
     bool        b_start_record;
+    bool        b_recording;
+
+    /* packet throughput, reported on close and through the
+     * "ts-skipped-packets" variable */
+    struct
+    {
+        uint64_t   i_packets; /* total TS packets consumed */
+        uint64_t   i_skipped; /* dropped from the stream buffer before any block_t work */
+        uint64_t   i_skipped_published; /* last value of the variable */
+        vlc_tick_t i_start;
+    } stats;
 };
 
 void TsChangeStandard( demux_sys_t *, ts_standards_e );
@@ -0,0 +1,175 @@
+/*****************************************************************************
+ * ts_workers.c : per program output threads for the TS demuxer
+ *****************************************************************************
+ * Copyright (C) 2023 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+
+#include "ts_streams.h"
+#include "ts_workers.h"
+
+typedef struct
+{
+    vlc_thread_t     thread;
+    vlc_mutex_t      lock;
+    vlc_cond_t       wait;     /* jobs queued or exit */
+    vlc_cond_t       idle;     /* queue went empty */
+    ts_worker_job_t *p_first;
+    ts_worker_job_t **pp_last;
+    bool             b_busy;
+    bool             b_exit;
+    ts_workers_t    *p_owner;
+} ts_worker_t;
+
+struct ts_workers_t
+{
+    demux_t         *p_demux;
+    ts_worker_run_cb pf_run;
+    unsigned         i_count;
+    ts_worker_t      workers[];
+};
+
+static void *WorkerThread( void *p_data )
+{
+    ts_worker_t *p_worker = p_data;
+    ts_workers_t *p_owner = p_worker->p_owner;
+
+    vlc_mutex_lock( &p_worker->lock );
+    for( ;; )
+    {
+        while( !p_worker->p_first && !p_worker->b_exit )
+            vlc_cond_wait( &p_worker->wait, &p_worker->lock );
+        if( !p_worker->p_first )
+            break;
+
+        ts_worker_job_t *p_job = p_worker->p_first;
+        p_worker->p_first = NULL;
+        p_worker->pp_last = &p_worker->p_first;
+        p_worker->b_busy = true;
+        vlc_mutex_unlock( &p_worker->lock );
+
+        while( p_job )
+        {
+            ts_worker_job_t *p_next = p_job->p_next;
+            p_owner->pf_run( p_owner->p_demux, p_job );
+            free( p_job );
+            p_job = p_next;
+        }
+
+        vlc_mutex_lock( &p_worker->lock );
+        p_worker->b_busy = false;
+        if( !p_worker->p_first )
+            vlc_cond_broadcast( &p_worker->idle );
+    }
+    vlc_mutex_unlock( &p_worker->lock );
+
+    return NULL;
+}
+
+ts_workers_t * ts_workers_New( demux_t *p_demux, unsigned i_count, ts_worker_run_cb pf_run )
+{
+    ts_workers_t *p_workers = malloc( sizeof(*p_workers) + i_count * sizeof(ts_worker_t) );
+    if( !p_workers )
+        return NULL;
+
+    p_workers->p_demux = p_demux;
+    p_workers->pf_run = pf_run;
+    p_workers->i_count = 0;
+
+    for( unsigned i = 0; i < i_count; i++ )
+    {
+        ts_worker_t *p_worker = &p_workers->workers[i];
+        vlc_mutex_init( &p_worker->lock );
+        vlc_cond_init( &p_worker->wait );
+        vlc_cond_init( &p_worker->idle );
+        p_worker->p_first = NULL;
+        p_worker->pp_last = &p_worker->p_first;
+        p_worker->b_busy = false;
+        p_worker->b_exit = false;
+        p_worker->p_owner = p_workers;
+
+        if( vlc_clone( &p_worker->thread, WorkerThread, p_worker,
+                       VLC_THREAD_PRIORITY_INPUT ) )
+        {
+            vlc_cond_destroy( &p_worker->idle );
+            vlc_cond_destroy( &p_worker->wait );
+            vlc_mutex_destroy( &p_worker->lock );
+            break;
+        }
+        p_workers->i_count++;
+    }
+
+    if( p_workers->i_count == 0 )
+    {
+        free( p_workers );
+        return NULL;
+    }
+
+    msg_Dbg( p_demux, "using %u output threads", p_workers->i_count );
+    return p_workers;
+}
+
+void ts_workers_Delete( ts_workers_t *p_workers )
+{
+    for( unsigned i = 0; i < p_workers->i_count; i++ )
+    {
+        ts_worker_t *p_worker = &p_workers->workers[i];
+
+        vlc_mutex_lock( &p_worker->lock );
+        p_worker->b_exit = true;
+        vlc_cond_signal( &p_worker->wait );
+        vlc_mutex_unlock( &p_worker->lock );
+
+        vlc_join( p_worker->thread, NULL );
+        vlc_cond_destroy( &p_worker->idle );
+        vlc_cond_destroy( &p_worker->wait );
+        vlc_mutex_destroy( &p_worker->lock );
+    }
+    free( p_workers );
+}
+
+void ts_workers_Queue( ts_workers_t *p_workers, ts_worker_job_t *p_job )
+{
+    ts_worker_t *p_worker =
+        &p_workers->workers[(unsigned) p_job->i_program % p_workers->i_count];
+
+    p_job->p_next = NULL;
+
+    vlc_mutex_lock( &p_worker->lock );
+    *p_worker->pp_last = p_job;
+    p_worker->pp_last = &p_job->p_next;
+    vlc_cond_signal( &p_worker->wait );
+    vlc_mutex_unlock( &p_worker->lock );
+}
+
+void ts_workers_Drain( ts_workers_t *p_workers )
+{
+    for( unsigned i = 0; i < p_workers->i_count; i++ )
+    {
+        ts_worker_t *p_worker = &p_workers->workers[i];
+
+        vlc_mutex_lock( &p_worker->lock );
+        while( p_worker->p_first || p_worker->b_busy )
+            vlc_cond_wait( &p_worker->idle, &p_worker->lock );
+        vlc_mutex_unlock( &p_worker->lock );
+    }
+}
@@ -0,0 +1,52 @@
+/*****************************************************************************
+ * ts_workers.h : per program output threads for the TS demuxer
+ *****************************************************************************
+ * Copyright (C) 2023 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_TS_WORKERS_H
+#define VLC_TS_WORKERS_H
+
+typedef struct ts_workers_t ts_workers_t;
+
+/* Output work for one program: either a chain of blocks to send to an ES,
+ * or a program clock update to apply once the data queued before it is out */
+typedef struct ts_worker_job_t ts_worker_job_t;
+struct ts_worker_job_t
+{
+    ts_worker_job_t *p_next;
+    ts_es_t         *p_es;     /* NULL for a PCR update */
+    block_t         *p_chain;
+    uint32_t         i_flags;  /* flags for the first block */
+    int              i_program;
+    vlc_tick_t       i_pcr;
+};
+
+typedef void (*ts_worker_run_cb)( demux_t *, ts_worker_job_t * );
+
+ts_workers_t * ts_workers_New( demux_t *, unsigned i_count, ts_worker_run_cb );
+/* Waits for all queued jobs, then stops the threads */
+void ts_workers_Delete( ts_workers_t * );
+
+/* Queues the job on the thread serving i_program. Jobs of a same program
+ * run in queueing order. Takes ownership of the job chain. */
+void ts_workers_Queue( ts_workers_t *, ts_worker_job_t * );
+
+/* Returns once every job queued so far has run. The demux thread must drain
+ * before altering any program or ES state that jobs can reference. */
+void ts_workers_Drain( ts_workers_t * );
+
+#endif
@@ -60,6 +60,9 @@ vlc_module_begin ()
     set_capability( "demux", 50 )
     set_callbacks( Open, Close )
     add_shortcut( "ogg" )
+    add_bool( "ogg-index-cache", false, N_("Cache seek index"),
+              N_("Keep the positions found while seeking in a file, and "
+                 "reuse them the next time it is played."), true )
 vlc_module_end ()
 
 
@@ -265,6 +268,7 @@ static void Close( vlc_object_t *p_this )
     /* Cleanup the bitstream parser */
     ogg_sync_clear( &p_sys->oy );
 
+    Oggseek_IndexStore( p_demux );
     Ogg_EndOfStream( p_demux );
 
     if( p_sys->p_old_stream )
@@ -339,7 +343,10 @@ static int Demux( demux_t * p_demux )
             /* Find the real duration */
             vlc_stream_Control( p_demux->s, STREAM_CAN_SEEK, &b_canseek );
             if ( b_canseek )
+            {
                 Oggseek_ProbeEnd( p_demux );
+                Oggseek_IndexLoad( p_demux );
+            }
         }
         else
         {
@@ -2248,7 +2255,8 @@ static int Ogg_BeginningOfStream( demux_t *p_demux )
         p_stream->p_es = NULL;
 
         /* initialise kframe index */
-        p_stream->idx=NULL;
+        p_stream->idx.p_entries = NULL;
+        p_stream->idx.i_size = p_stream->idx.i_alloc = 0;
 
         if ( p_stream->fmt.i_bitrate == 0  &&
              ( p_stream->fmt.i_cat == VIDEO_ES ||
@@ -2340,10 +2348,7 @@ static void Ogg_LogicalStreamDelete( demux_t *p_demux, logical_stream_t *p_strea
     es_format_Clean( &p_stream->fmt_old );
     es_format_Clean( &p_stream->fmt );
 
-    if ( p_stream->idx != NULL)
-    {
-        oggseek_index_entries_free( p_stream->idx );
-    }
+    oggseek_index_entries_free( p_stream );
 
     Ogg_FreeSkeleton( p_stream->p_skel );
     p_stream->p_skel = NULL;
@@ -100,8 +100,14 @@ typedef struct logical_stream_s
     /* offset of first keyframe for theora; can be 0 or 1 depending on version number */
     int8_t i_keyframe_offset;
 
-    /* keyframe index for seeking, created as we discover keyframes */
-    demux_index_entry_t *idx;
+    /* keyframe index for seeking, created as we discover keyframes,
+     * sorted by page position */
+    struct
+    {
+        demux_index_entry_t *p_entries;
+        size_t i_size;
+        size_t i_alloc;
+    } idx;
 
     /* Skeleton data */
     ogg_skeleton_t *p_skel;
@@ -32,8 +32,12 @@
 
 #include <vlc_common.h>
 #include <vlc_demux.h>
+#include <vlc_configuration.h>
+#include <vlc_fs.h>
+#include <vlc_md5.h>
 
 #include <ogg/ogg.h>
+#include <errno.h>
 #include <limits.h>
 #include <math.h>
 #include <assert.h>
@@ -68,36 +72,30 @@ typedef struct packetStartCoordinates
 * index entries
 *************************************************************/
 
-/* free all entries in index list */
+/* free all entries in index */
 
-void oggseek_index_entries_free ( demux_index_entry_t *idx )
+void oggseek_index_entries_free ( logical_stream_t *p_stream )
 {
-    demux_index_entry_t *idx_next;
-
-    while ( idx != NULL )
-    {
-        idx_next = idx->p_next;
-        free( idx );
-        idx = idx_next;
-    }
+    free( p_stream->idx.p_entries );
+    p_stream->idx.p_entries = NULL;
+    p_stream->idx.i_size = p_stream->idx.i_alloc = 0;
 }
 
-
-/* internal function to create a new list member */
-
-static demux_index_entry_t *index_entry_new( int64_t i_timestamp, int64_t i_pagepos )
+/* first entry at or after i_pagepos */
+static size_t OggSeekIndexLookupPos( const logical_stream_t *p_stream,
+                                     int64_t i_pagepos )
 {
-    if ( i_timestamp == VLC_TICK_INVALID || i_pagepos < 1 )
-        return NULL;
+    size_t i_lo = 0, i_hi = p_stream->idx.i_size;
 
-    demux_index_entry_t *idx = malloc( sizeof(*idx) );
-    if ( idx )
+    while ( i_lo < i_hi )
     {
-        idx->i_value = i_timestamp;
-        idx->i_pagepos = i_pagepos;
-        idx->p_next = NULL;
+        size_t i_mid = ( i_lo + i_hi ) / 2;
+        if ( p_stream->idx.p_entries[i_mid].i_pagepos < i_pagepos )
+            i_lo = i_mid + 1;
+        else
+            i_hi = i_mid;
     }
-    return idx;
+    return i_lo;
 }
 
 /* We insert into index, sorting by pagepos (as a page can match multiple
@@ -106,56 +104,178 @@ const demux_index_entry_t *OggSeek_IndexAdd ( logical_stream_t *p_stream,
                                              int64_t i_timestamp,
                                              int64_t i_pagepos )
 {
-    demux_index_entry_t **pp_next = &p_stream->idx;
-    for( ; *pp_next; )
-    {
-        if( (*pp_next)->i_pagepos >= i_pagepos )
-        {
-            if( (*pp_next)->i_pagepos == i_pagepos )
-                return NULL;
-            break;
-        }
-        pp_next = &((*pp_next)->p_next);
-    }
+    if ( i_timestamp == VLC_TICK_INVALID || i_pagepos < 1 )
+        return NULL;
+
+    size_t i = OggSeekIndexLookupPos( p_stream, i_pagepos );
+    if ( i < p_stream->idx.i_size &&
+         p_stream->idx.p_entries[i].i_pagepos == i_pagepos )
+        return NULL;
 
-    demux_index_entry_t *ie = index_entry_new( i_timestamp, i_pagepos );
-    if ( ie )
+    if ( p_stream->idx.i_size == p_stream->idx.i_alloc )
     {
-        ie->p_next = *pp_next;
-        *pp_next = ie;
+        size_t i_alloc = p_stream->idx.i_alloc ? p_stream->idx.i_alloc * 2 : 32;
+        demux_index_entry_t *p_entries =
+            realloc( p_stream->idx.p_entries, i_alloc * sizeof(*p_entries) );
+        if ( !p_entries )
+            return NULL;
+        p_stream->idx.p_entries = p_entries;
+        p_stream->idx.i_alloc = i_alloc;
     }
 
+    demux_index_entry_t *ie = &p_stream->idx.p_entries[i];
+    memmove( ie + 1, ie, ( p_stream->idx.i_size - i ) * sizeof(*ie) );
+    p_stream->idx.i_size++;
+    ie->i_value = i_timestamp;
+    ie->i_pagepos = i_pagepos;
+
     return ie;
 }
 
+/* Timestamps grow along with page positions, so we can bisect on them */
 static bool OggSeekIndexFind ( logical_stream_t *p_stream, int64_t i_timestamp,
                                int64_t *pi_pos_lower, int64_t *pi_pos_upper,
                                int64_t *pi_lower_timestamp )
 {
-    demux_index_entry_t *idx = p_stream->idx;
+    const demux_index_entry_t *p_entries = p_stream->idx.p_entries;
+    size_t i_lo = 0, i_hi = p_stream->idx.i_size;
+
+    /* first entry after i_timestamp */
+    while ( i_lo < i_hi )
+    {
+        size_t i_mid = ( i_lo + i_hi ) / 2;
+        if ( p_entries[i_mid].i_value <= i_timestamp )
+            i_lo = i_mid + 1;
+        else
+            i_hi = i_mid;
+    }
+
+    if ( i_lo == 0 )
+        return false;
+
+    *pi_pos_lower = p_entries[i_lo - 1].i_pagepos;
+    *pi_lower_timestamp = p_entries[i_lo - 1].i_value;
+    if ( i_lo < p_stream->idx.i_size ) /* not found on last index */
+        *pi_pos_upper = p_entries[i_lo].i_pagepos;
+    return true;
+}
+
+/* on-disk copy of the index, keyed by the MRL */
+
+static char *OggSeekIndexPath( demux_t *p_demux, bool b_create )
+{
+    if ( !p_demux->psz_access || !p_demux->psz_location )
+        return NULL;
+
+    struct md5_s md5;
+    InitMD5( &md5 );
+    AddMD5( &md5, p_demux->psz_access, strlen( p_demux->psz_access ) );
+    AddMD5( &md5, "://", 3 );
+    AddMD5( &md5, p_demux->psz_location, strlen( p_demux->psz_location ) );
+    EndMD5( &md5 );
+
+    char *psz_hash = psz_md5_hash( &md5 );
+    char *psz_cachedir = config_GetUserDir( VLC_CACHE_DIR );
+    char *psz_path = NULL;
+
+    if ( psz_hash && psz_cachedir )
+    {
+        if ( b_create )
+            vlc_mkdir( psz_cachedir, 0700 );
+        if ( asprintf( &psz_path, "%s" DIR_SEP "ogg-%s.idx",
+                       psz_cachedir, psz_hash ) == -1 )
+            psz_path = NULL;
+    }
+    free( psz_cachedir );
+    free( psz_hash );
+    return psz_path;
+}
+
+void Oggseek_IndexLoad( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if ( p_sys->i_total_bytes <= 0 ||
+         !var_InheritBool( p_demux, "ogg-index-cache" ) )
+        return;
 
-    while ( idx != NULL )
+    char *psz_path = OggSeekIndexPath( p_demux, false );
+    if ( !psz_path )
+        return;
+    FILE *file = vlc_fopen( psz_path, "rt" );
+    free( psz_path );
+    if ( !file )
+        return;
+
+    int64_t i_size;
+    unsigned i_count = 0;
+
+    /* The file size is the only check that the content did not change */
+    if ( fscanf( file, "VLC ogg index 1 %"SCNd64, &i_size ) == 1 &&
+         i_size == p_sys->i_total_bytes )
     {
-        if ( idx->i_value <= i_timestamp )
+        int i_serial;
+        int64_t i_value, i_pagepos;
+
+        while ( fscanf( file, "%d %"SCNd64" %"SCNd64,
+                        &i_serial, &i_value, &i_pagepos ) == 3 )
         {
-            if ( !idx->p_next ) /* found on last index */
+            for ( int i = 0; i < p_sys->i_streams; i++ )
             {
-                *pi_pos_lower = idx->i_pagepos;
-                *pi_lower_timestamp = idx->i_value;
-                return true;
-            }
-            if ( idx->p_next->i_value > i_timestamp )
-            {
-                *pi_pos_lower = idx->i_pagepos;
-                *pi_lower_timestamp = idx->i_value;
-                *pi_pos_upper = idx->p_next->i_pagepos;
-                return true;
+                logical_stream_t *p_stream = p_sys->pp_stream[i];
+
+                if ( p_stream->i_serial_no != i_serial ||
+                     i_pagepos < p_stream->i_data_start || i_pagepos >= i_size )
+                    continue;
+                if ( OggSeek_IndexAdd( p_stream, i_value, i_pagepos ) )
+                    i_count++;
+                break;
             }
         }
-        idx = idx->p_next;
     }
+    fclose( file );
 
-    return false;
+    if ( i_count )
+        msg_Dbg( p_demux, "loaded %u seek index entries", i_count );
+}
+
+void Oggseek_IndexStore( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    bool b_empty = true;
+
+    for ( int i = 0; i < p_sys->i_streams; i++ )
+        if ( p_sys->pp_stream[i]->idx.i_size )
+            b_empty = false;
+
+    if ( b_empty || p_sys->i_total_bytes <= 0 ||
+         !var_InheritBool( p_demux, "ogg-index-cache" ) )
+        return;
+
+    char *psz_path = OggSeekIndexPath( p_demux, true );
+    if ( !psz_path )
+        return;
+    FILE *file = vlc_fopen( psz_path, "wt" );
+    if ( !file )
+    {
+        msg_Warn( p_demux, "cannot write seek index %s: %s", psz_path,
+                  vlc_strerror_c( errno ) );
+        free( psz_path );
+        return;
+    }
+    free( psz_path );
+
+    fprintf( file, "VLC ogg index 1 %"PRId64"\n", p_sys->i_total_bytes );
+    for ( int i = 0; i < p_sys->i_streams; i++ )
+    {
+        const logical_stream_t *p_stream = p_sys->pp_stream[i];
+
+        for ( size_t j = 0; j < p_stream->idx.i_size; j++ )
+            fprintf( file, "%d %"PRId64" %"PRId64"\n", p_stream->i_serial_no,
+                     p_stream->idx.p_entries[j].i_value,
+                     p_stream->idx.p_entries[j].i_pagepos );
+    }
+    fclose( file );
 }
 
 /*********************************************************************
@@ -798,6 +918,75 @@ static int64_t OggBisectSearchByTime( demux_t *p_demux, logical_stream_t *p_stre
             return -1;
         }
 
+        if ( i_end_pos - ( i_start_pos - i_segsize ) <= OGGSEEK_BISECT_WINDOW )
+        {
+            /* Each bisection step costs a seek, i.e. a new request over
+             * HTTP: read what is left at once and check every page */
+            ogg_sync_state oy;
+            ogg_page page;
+            int64_t i_pos = __MAX( i_start_pos - i_segsize, i_pos_lower );
+            int64_t i_size = i_end_pos - i_pos + MAX_PAGE_SIZE;
+            char *buf;
+
+            if ( p_sys->i_total_bytes > 0 )
+                i_size = __MIN( i_size, p_sys->i_total_bytes - i_pos );
+
+            ogg_sync_init( &oy );
+            if ( i_size > 0 && !vlc_stream_Seek( p_demux->s, i_pos ) &&
+                 ( buf = ogg_sync_buffer( &oy, i_size ) ) != NULL )
+            {
+                ssize_t i_read = vlc_stream_Read( p_demux->s, buf, i_size );
+                long i_result;
+
+                if ( i_read > 0 )
+                    ogg_sync_wrote( &oy, i_read );
+
+                while ( ( i_result = ogg_sync_pageseek( &oy, &page ) ) != 0 )
+                {
+                    if ( i_result < 0 )
+                    {
+                        /* skipped bytes */
+                        i_pos -= i_result;
+                        continue;
+                    }
+
+                    current.i_pos = i_pos;
+                    i_pos += i_result;
+                    if ( current.i_pos >= i_end_pos )
+                        break;
+
+                    current.i_granule = ogg_page_granulepos( &page );
+                    if ( ogg_page_serialno( &page ) != p_stream->i_serial_no ||
+                         current.i_granule <= 0 )
+                        continue;
+
+                    current.i_timestamp = Oggseek_GranuleToAbsTimestamp( p_stream,
+                                                                         current.i_granule, false );
+                    if ( current.i_timestamp == -1 )
+                        continue;
+                    else if ( current.i_timestamp < -1 )
+                        current.i_timestamp = 0;
+
+                    if ( current.i_timestamp <= i_targettime )
+                    {
+                        if ( current.i_timestamp > bestlower.i_timestamp )
+                            bestlower = current;
+                    }
+                    else
+                    {
+                        if ( lowestupper.i_timestamp == -1 || current.i_timestamp < lowestupper.i_timestamp )
+                            lowestupper = current;
+                        break;
+                    }
+                }
+            }
+            ogg_sync_clear( &oy );
+
+            OggDebug( msg_Dbg(p_demux, "Bisect window read, bl %"PRId64" lu %"PRId64,
+                      bestlower.i_granule, lowestupper.i_granule ) );
+            break;
+        }
+
 
         current.i_pos = find_first_page_granule( p_demux,
                                                  i_start_pos, i_end_pos,
@@ -30,10 +30,12 @@
 
 #define OGGSEEK_BYTES_TO_READ 8500
 
+/* bisection reads the remaining region at once below this size */
+#define OGGSEEK_BISECT_WINDOW (128 * 1024)
+
 /* this is typedefed to demux_index_entry_t in ogg.h */
 struct oggseek_index_entry
 {
-    demux_index_entry_t *p_next;
     /* value is highest granulepos for theora, sync frame for dirac */
     int64_t i_value;
     int64_t i_pagepos;
@@ -50,6 +52,8 @@ int     Oggseek_SeektoAbsolutetime ( demux_t *, logical_stream_t *, int64_t i_gr
 const demux_index_entry_t *OggSeek_IndexAdd ( logical_stream_t *, int64_t, int64_t );
 void    Oggseek_ProbeEnd( demux_t * );
 
-void oggseek_index_entries_free ( demux_index_entry_t * );
+void oggseek_index_entries_free ( logical_stream_t * );
+void Oggseek_IndexLoad ( demux_t * );
+void Oggseek_IndexStore ( demux_t * );
 
 int64_t oggseek_read_page ( demux_t * );
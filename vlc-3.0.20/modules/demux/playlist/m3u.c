@@ -40,8 +40,17 @@
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
+/* IPTV attributes of an #EXTINF line, pointing into the line buffer */
+typedef struct
+{
+    char *psz_tvg_name;
+    char *psz_tvg_logo;
+    char *psz_group_title;
+} extinf_attrs_t;
+
 static int ReadDir( stream_t *, input_item_node_t * );
-static void parseEXTINF( char *psz_string, char **ppsz_artist, char **ppsz_name, int *pi_duration );
+static void parseEXTINF( char *psz_string, char **ppsz_artist, char **ppsz_name,
+                         int *pi_duration, extinf_attrs_t *p_attrs );
 static bool ContainsURL(const uint8_t *, size_t);
 
 static char *GuessEncoding (const char *str)
@@ -217,6 +226,7 @@ static int ReadDir( stream_t *p_demux, input_item_node_t *p_subitems )
     char       *psz_name = NULL;
     char       *psz_artist = NULL;
     char       *psz_album_art = NULL;
+    char       *psz_genre = NULL;
     int        i_parsed_duration = 0;
     vlc_tick_t i_duration = -1;
     const char**ppsz_options = NULL;
@@ -250,16 +260,31 @@ static int ReadDir( stream_t *p_demux, input_item_node_t *p_subitems )
             if( !strncasecmp( psz_parse, "EXTINF:", sizeof("EXTINF:") -1 ) )
             {
                 /* Extended info */
+                extinf_attrs_t attrs = { NULL, NULL, NULL };
+
                 psz_parse += sizeof("EXTINF:") - 1;
                 FREENULL( psz_name );
                 FREENULL( psz_artist );
-                parseEXTINF( psz_parse, &psz_artist, &psz_name, &i_parsed_duration );
+                parseEXTINF( psz_parse, &psz_artist, &psz_name,
+                             &i_parsed_duration, &attrs );
                 if( i_parsed_duration >= 0 )
                     i_duration = i_parsed_duration * INT64_C(1000000);
+                if( EMPTY_STR(psz_name) && !EMPTY_STR(attrs.psz_tvg_name) )
+                    psz_name = attrs.psz_tvg_name;
                 if( psz_name )
                     psz_name = pf_dup( psz_name );
                 if( psz_artist )
                     psz_artist = pf_dup( psz_artist );
+                if( !EMPTY_STR(attrs.psz_tvg_logo) )
+                {
+                    free( psz_album_art );
+                    psz_album_art = pf_dup( attrs.psz_tvg_logo );
+                }
+                if( !EMPTY_STR(attrs.psz_group_title) )
+                {
+                    free( psz_genre );
+                    psz_genre = pf_dup( attrs.psz_group_title );
+                }
             }
             else if( !strncasecmp( psz_parse, "EXTVLCOPT:",
                                    sizeof("EXTVLCOPT:") -1 ) )
@@ -326,6 +351,8 @@ static int ReadDir( stream_t *p_demux, input_item_node_t *p_subitems )
             if( psz_name ) input_item_SetTitle( p_input, psz_name );
             if( !EMPTY_STR(psz_album_art) )
                 input_item_SetArtURL( p_input, psz_album_art );
+            if( !EMPTY_STR(psz_genre) )
+                input_item_SetGenre( p_input, psz_genre );
 
             input_item_node_AppendItem( p_subitems, p_input );
             input_item_Release( p_input );
@@ -347,6 +374,7 @@ static int ReadDir( stream_t *p_demux, input_item_node_t *p_subitems )
             FREENULL( psz_name );
             FREENULL( psz_artist );
             FREENULL( psz_album_art );
+            FREENULL( psz_genre );
             i_parsed_duration = 0;
             i_duration = -1;
 
@@ -356,8 +384,50 @@ static int ReadDir( stream_t *p_demux, input_item_node_t *p_subitems )
     return VLC_SUCCESS; /* Needed for correct operation of go back */
 }
 
+/* Parses the key="value" attributes following the duration, in place */
+static void parseEXTINFAttributes(char *psz_string, extinf_attrs_t *p_attrs)
+{
+    /* skip the duration */
+    psz_string += strcspn( psz_string, " \t" );
+
+    while( *psz_string )
+    {
+        psz_string += strspn( psz_string, " \t" );
+
+        char *psz_key = psz_string;
+        psz_string += strcspn( psz_string, "= \t" );
+        if( *psz_string != '=' )
+            continue;
+        *psz_string++ = '\0';
+
+        char *psz_value;
+        if( *psz_string == '"' )
+        {
+            psz_value = ++psz_string;
+            psz_string = strchr( psz_string, '"' );
+            if( psz_string == NULL )
+                return;
+        }
+        else
+        {
+            psz_value = psz_string;
+            psz_string += strcspn( psz_string, " \t" );
+        }
+        if( *psz_string )
+            *psz_string++ = '\0';
+
+        if( !strcasecmp( psz_key, "tvg-name" ) )
+            p_attrs->psz_tvg_name = psz_value;
+        else if( !strcasecmp( psz_key, "tvg-logo" ) )
+            p_attrs->psz_tvg_logo = psz_value;
+        else if( !strcasecmp( psz_key, "group-title" ) )
+            p_attrs->psz_group_title = psz_value;
+    }
+}
+
 static void parseEXTINF(char *psz_string, char **ppsz_artist,
-                        char **ppsz_name, int *pi_duration)
+                        char **ppsz_name, int *pi_duration,
+                        extinf_attrs_t *p_attrs)
 {
     char *end = NULL;
     char *psz_item = NULL;
@@ -368,13 +438,20 @@ static void parseEXTINF(char *psz_string, char **ppsz_artist,
     for (; psz_string < end && ( *psz_string == '\t' || *psz_string == ' ' );
          psz_string++ );
 
-    /* duration: read to next comma */
+    /* duration and attributes: read to next comma, outside of quotes */
     psz_item = psz_string;
-    psz_string = strchr( psz_string, ',' );
-    if ( psz_string )
+    for( bool b_quoted = false; *psz_string; psz_string++ )
+    {
+        if( *psz_string == '"' )
+            b_quoted = !b_quoted;
+        else if( *psz_string == ',' && !b_quoted )
+            break;
+    }
+    if ( *psz_string == ',' )
     {
         *psz_string = '\0';
         *pi_duration = atoi( psz_item );
+        parseEXTINFAttributes( psz_item, p_attrs );
     }
     else
     {
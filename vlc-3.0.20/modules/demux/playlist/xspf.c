@@ -76,8 +76,11 @@ typedef struct
 {
     input_item_t **pp_tracklist;
     int i_tracklist_entries;
+    int i_tracklist_size;
     int i_track_id;
     char * psz_base;
+    char * psz_text; /**< text content buffer, reused across elements */
+    size_t i_text_size;
 } xspf_sys_t;
 
 static int ReadDir(stream_t *, input_item_node_t *);
@@ -116,6 +119,7 @@ void Close_xspf(vlc_object_t *p_this)
             input_item_Release(p_sys->pp_tracklist[i]);
     free(p_sys->pp_tracklist);
     free(p_sys->psz_base);
+    free(p_sys->psz_text);
     free(p_sys);
 }
 
@@ -131,6 +135,7 @@ static int ReadDir(stream_t *p_stream, input_item_node_t *p_subitems)
 
     sys->pp_tracklist = NULL;
     sys->i_tracklist_entries = 0;
+    sys->i_tracklist_size = 0;
     sys->i_track_id = -1;
     sys->psz_base = strdup(p_stream->psz_url);
 
@@ -208,8 +213,11 @@ static bool parse_node(stream_t *p_stream,
                        xml_reader_t *p_xml_reader, const char *psz_root_node,
                        const xml_elem_hnd_t *pl_elements, size_t i_pl_elements)
 {
+    xspf_sys_t *sys = p_stream->p_sys;
     bool b_ret = false;
 
+    /* The text content of the current simple element is copied into a
+     * buffer shared by all elements, as it is consumed at the element end */
     char *psz_value = NULL;
     const char *name;
     int i_node;
@@ -222,7 +230,7 @@ static bool parse_node(stream_t *p_stream,
         switch (i_node)
         {
             case XML_READER_STARTELEM:
-                FREENULL(psz_value);
+                psz_value = NULL;
                 if (!*name)
                 {
                     msg_Err(p_stream, "invalid XML stream");
@@ -252,16 +260,19 @@ static bool parse_node(stream_t *p_stream,
                 break;
 
             case XML_READER_TEXT:
-                free(psz_value);
-                if(!p_handler)
-                {
-                    psz_value = NULL;
-                }
-                else
+                psz_value = NULL;
+                if(p_handler)
                 {
-                    psz_value = strdup(name);
-                    if (unlikely(!psz_value))
-                        goto end;
+                    size_t i_len = strlen(name) + 1;
+                    if (i_len > sys->i_text_size)
+                    {
+                        char *psz_text = realloc(sys->psz_text, i_len);
+                        if (unlikely(!psz_text))
+                            goto end;
+                        sys->psz_text = psz_text;
+                        sys->i_text_size = i_len;
+                    }
+                    psz_value = memcpy(sys->psz_text, name, i_len);
                 }
                 break;
 
@@ -286,7 +297,6 @@ static bool parse_node(stream_t *p_stream,
                         p_handler->pf_handler.smpl(p_input_item, p_handler->name,
                                                    psz_value, p_stream->p_sys);
 
-                    free(psz_value);
                     psz_value = NULL;
                     p_handler = NULL;
                 }
@@ -295,8 +305,6 @@ static bool parse_node(stream_t *p_stream,
     }
 
 end:
-    free(psz_value);
-
     return b_ret;
 }
 
@@ -463,18 +471,29 @@ static bool parse_track_node COMPLEX_INTERFACE
         else
         {
             /* Extend array as needed */
-            if (p_sys->i_track_id >= p_sys->i_tracklist_entries)
+            if (p_sys->i_track_id >= p_sys->i_tracklist_size)
             {
-                input_item_t **pp;
-                pp = realloc(p_sys->pp_tracklist,
-                             (p_sys->i_track_id + 1) * sizeof(*pp));
+                /* Grow geometrically, as IDs are usually sequential */
+                int i_size = p_sys->i_tracklist_size;
+                if (i_size < 64)
+                    i_size = 64;
+                while (i_size <= p_sys->i_track_id && i_size <= INT_MAX / 2)
+                    i_size *= 2;
+                if (i_size <= p_sys->i_track_id ||
+                    (size_t)i_size >= SIZE_MAX / sizeof(p_new_input))
+                    i_size = p_sys->i_track_id + 1;
+
+                input_item_t **pp = realloc(p_sys->pp_tracklist,
+                                            i_size * sizeof(*pp));
                 if (pp)
                 {
                     p_sys->pp_tracklist = pp;
-                    while (p_sys->i_track_id >= p_sys->i_tracklist_entries)
-                        pp[p_sys->i_tracklist_entries++] = NULL;
+                    p_sys->i_tracklist_size = i_size;
                 }
             }
+            while (p_sys->i_track_id >= p_sys->i_tracklist_entries &&
+                   p_sys->i_tracklist_entries < p_sys->i_tracklist_size)
+                p_sys->pp_tracklist[p_sys->i_tracklist_entries++] = NULL;
 
             if (p_sys->i_track_id < p_sys->i_tracklist_entries)
             {
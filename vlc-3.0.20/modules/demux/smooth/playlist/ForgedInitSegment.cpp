@@ -62,11 +62,14 @@ ForgedInitSegment::ForgedInitSegment(ICanonicalUrl *parent,
     fourcc = 0;
     es_type = UNKNOWN_ES;
     track_id = 1;
+    moovcache = nullptr;
 }
 
 ForgedInitSegment::~ForgedInitSegment()
 {
     free(extradata);
+    if(moovcache)
+        block_Release(moovcache);
 }
 
 static uint8_t *HexDecode(const std::string &s, size_t *decoded_size)
@@ -306,7 +309,12 @@ block_t * ForgedInitSegment::buildMoovBox()
 
 SegmentChunk* ForgedInitSegment::toChunk(SharedResources *, size_t, BaseRepresentation *rep)
 {
-    block_t *moov = buildMoovBox();
+    /* Properties are only set while parsing: the moov does not change
+       and is reused for every switch to this quality */
+    if(!moovcache)
+        moovcache = buildMoovBox();
+
+    block_t *moov = moovcache ? block_Duplicate(moovcache) : nullptr;
     if(moov)
     {
         MemoryChunkSource *source = new (std::nothrow) MemoryChunkSource(ChunkType::Init, moov);
@@ -57,6 +57,7 @@ namespace smooth
                 void fromWaveFormatEx(const uint8_t *p_data, size_t i_data);
                 void fromVideoInfoHeader(const uint8_t *p_data, size_t i_data);
                 block_t * buildMoovBox();
+                block_t *moovcache; /* forged once, on first use */
                 std::string data;
                 std::string type;
                 std::string language;
@@ -134,6 +134,7 @@ typedef struct
     int64_t i_stop;
 
     char    *psz_text;
+    uint64_t i_offset; /* position of the cue in the stream (streaming mode) */
 } subtitle_t;
 
 typedef struct
@@ -184,6 +185,11 @@ struct demux_sys_t
 
     int64_t     i_length;
 
+    /* In streaming mode only the cue timings are kept in memory, the text
+     * is parsed back from the stream when the cue is sent */
+    bool        b_streaming;
+    int         (*pf_read)( vlc_object_t *, subs_properties_t *, text_t *, subtitle_t*, size_t );
+
     /* */
     subs_properties_t props;
 
@@ -246,6 +252,14 @@ static const struct
 static int Demux( demux_t * );
 static int Control( demux_t *, int, va_list );
 
+/* Files above this size are indexed instead of being loaded in memory */
+#define SUB_STREAMING_MIN_SIZE (4 * 1024 * 1024)
+
+static int subtitle_ParseSubRipTiming( subtitle_t *, const char * );
+static int subtitle_ParseSubViewerTiming( subtitle_t *, const char * );
+static int  SubtitleIndex( demux_t *, int (*)( subtitle_t *, const char * ) );
+static int  SubtitleLoadText( demux_t *, subtitle_t * );
+
 static void Fix( demux_t * );
 static char * get_language_from_filename( const char * );
 
@@ -324,6 +338,7 @@ static int Open ( vlc_object_t *p_this )
     p_sys->i_next_demux_date = 0;
 
     p_sys->pf_convert = ToTextBlock;
+    p_sys->b_streaming = false;
 
     p_sys->subtitles.i_current= 0;
     p_sys->subtitles.i_count  = 0;
@@ -642,8 +657,27 @@ static int Open ( vlc_object_t *p_this )
             break;
         }
     }
+    p_sys->pf_read = pf_read;
+
+    /* SubRip and SubViewer cues are self-contained blocks ending with an
+     * empty line: big files are only indexed and read back on demand */
+    int (*pf_parse_timing)( subtitle_t *, const char * ) = NULL;
+    if( p_sys->props.i_type == SUB_TYPE_SUBRIP )
+        pf_parse_timing = subtitle_ParseSubRipTiming;
+    else if( p_sys->props.i_type == SUB_TYPE_SUBVIEWER )
+        pf_parse_timing = subtitle_ParseSubViewerTiming;
 
-    msg_Dbg( p_demux, "loading all subtitles..." );
+    if( pf_parse_timing != NULL )
+    {
+        bool b_can_seek;
+        uint64_t i_size;
+
+        if( vlc_stream_Control( p_demux->s, STREAM_CAN_SEEK, &b_can_seek ) == VLC_SUCCESS &&
+            b_can_seek &&
+            vlc_stream_GetSize( p_demux->s, &i_size ) == VLC_SUCCESS &&
+            i_size >= SUB_STREAMING_MIN_SIZE )
+            p_sys->b_streaming = true;
+    }
 
     if( e_bom == UTF8BOM && /* skip BOM */
         vlc_stream_Read( p_demux->s, NULL, 3 ) != 3 )
@@ -652,35 +686,50 @@ static int Open ( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
-    /* Load the whole file */
-    text_t txtlines;
-    TextLoad( &txtlines, p_demux->s );
+    if( p_sys->b_streaming )
+    {
+        msg_Dbg( p_demux, "indexing subtitles..." );
 
-    /* Parse it */
-    for( size_t i_max = 0; i_max < SIZE_MAX - 500 * sizeof(subtitle_t); )
+        if( SubtitleIndex( p_demux, pf_parse_timing ) )
+        {
+            Close( p_this );
+            return VLC_ENOMEM;
+        }
+    }
+    else
     {
-        if( p_sys->subtitles.i_count >= i_max )
+        msg_Dbg( p_demux, "loading all subtitles..." );
+
+        /* Load the whole file */
+        text_t txtlines;
+        TextLoad( &txtlines, p_demux->s );
+
+        /* Parse it */
+        for( size_t i_max = 0; i_max < SIZE_MAX - 500 * sizeof(subtitle_t); )
         {
-            i_max += 500;
-            subtitle_t *p_realloc = realloc( p_sys->subtitles.p_array, sizeof(subtitle_t) * i_max );
-            if( p_realloc == NULL )
+            if( p_sys->subtitles.i_count >= i_max )
             {
-                TextUnload( &txtlines );
-                Close( p_this );
-                return VLC_ENOMEM;
+                i_max += 500;
+                subtitle_t *p_realloc = realloc( p_sys->subtitles.p_array, sizeof(subtitle_t) * i_max );
+                if( p_realloc == NULL )
+                {
+                    TextUnload( &txtlines );
+                    Close( p_this );
+                    return VLC_ENOMEM;
+                }
+                p_sys->subtitles.p_array = p_realloc;
             }
-            p_sys->subtitles.p_array = p_realloc;
-        }
 
-        if( pf_read( VLC_OBJECT(p_demux), &p_sys->props, &txtlines,
-                     &p_sys->subtitles.p_array[p_sys->subtitles.i_count],
-                     p_sys->subtitles.i_count ) )
-            break;
+            if( pf_read( VLC_OBJECT(p_demux), &p_sys->props, &txtlines,
+                         &p_sys->subtitles.p_array[p_sys->subtitles.i_count],
+                         p_sys->subtitles.i_count ) )
+                break;
 
-        p_sys->subtitles.i_count++;
+            p_sys->subtitles.i_count++;
+        }
+        /* Unload */
+        TextUnload( &txtlines );
     }
-    /* Unload */
-    TextUnload( &txtlines );
 
     msg_Dbg(p_demux, "loaded %zu subtitles", p_sys->subtitles.i_count );
 
@@ -785,6 +834,23 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             i64 = va_arg( args, int64_t );
             p_sys->b_first_time = true;
             p_sys->i_next_demux_date = i64;
+            if( p_sys->b_streaming )
+            {
+                /* Cues were indexed in file order, which is also the
+                 * start time order: bisect for the last cue starting
+                 * before the new time */
+                size_t i_low = 0, i_high = p_sys->subtitles.i_count;
+                while( i_high - i_low > 1 )
+                {
+                    size_t i_mid = i_low + (i_high - i_low) / 2;
+                    if( p_sys->subtitles.p_array[i_mid].i_start > i64 )
+                        i_high = i_mid;
+                    else
+                        i_low = i_mid;
+                }
+                p_sys->subtitles.i_current = i_low;
+                return VLC_SUCCESS;
+            }
             for( size_t i = 0; i < p_sys->subtitles.i_count; i++ )
             {
                 if( p_sys->subtitles.p_array[i].i_start > i64 && i > 0 )
@@ -854,7 +920,14 @@ static int Demux( demux_t *p_demux )
     while( p_sys->subtitles.i_current < p_sys->subtitles.i_count &&
            p_sys->subtitles.p_array[p_sys->subtitles.i_current].i_start <= i_barrier )
     {
-        const subtitle_t *p_subtitle = &p_sys->subtitles.p_array[p_sys->subtitles.i_current];
+        subtitle_t *p_subtitle = &p_sys->subtitles.p_array[p_sys->subtitles.i_current];
+
+        if( p_sys->b_streaming && p_subtitle->psz_text == NULL &&
+            SubtitleLoadText( p_demux, p_subtitle ) != VLC_SUCCESS )
+        {
+            p_sys->subtitles.i_current++;
+            continue;
+        }
 
         if ( !p_sys->b_slave && p_sys->b_first_time )
         {
@@ -876,6 +949,9 @@ static int Demux( demux_t *p_demux )
             }
         }
 
+        if( p_sys->b_streaming )
+            FREENULL( p_subtitle->psz_text );
+
         p_sys->subtitles.i_current++;
     }
 
@@ -950,6 +1026,116 @@ static int TextLoad( text_t *txt, stream_t *s )
 
     return VLC_SUCCESS;
 }
+/*****************************************************************************
+ * SubtitleIndex: record the timings and position of every cue
+ *****************************************************************************/
+static int SubtitleIndex( demux_t *p_demux,
+                          int (*pf_parse_timing)( subtitle_t *, const char * ) )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    size_t i_max = 0;
+    bool b_text = false;
+
+    for( ;; )
+    {
+        uint64_t i_pos = vlc_stream_Tell( p_demux->s );
+        char *psz = vlc_stream_ReadLine( p_demux->s );
+
+        if( psz == NULL )
+            break;
+
+        /* Skip the text of the current cue, up to the empty line */
+        if( b_text )
+        {
+            b_text = *psz != '\0';
+            free( psz );
+            continue;
+        }
+
+        if( p_sys->subtitles.i_count >= i_max )
+        {
+            if( i_max >= SIZE_MAX / sizeof(subtitle_t) - 500 )
+            {
+                free( psz );
+                break;
+            }
+            i_max += 500;
+            subtitle_t *p_realloc = realloc( p_sys->subtitles.p_array, sizeof(subtitle_t) * i_max );
+            if( p_realloc == NULL )
+            {
+                free( psz );
+                return VLC_ENOMEM;
+            }
+            p_sys->subtitles.p_array = p_realloc;
+        }
+
+        subtitle_t *p_subtitle = &p_sys->subtitles.p_array[p_sys->subtitles.i_count];
+        if( pf_parse_timing( p_subtitle, psz ) == VLC_SUCCESS &&
+            p_subtitle->i_start < p_subtitle->i_stop )
+        {
+            p_subtitle->psz_text = NULL;
+            p_subtitle->i_offset = i_pos;
+            p_sys->subtitles.i_count++;
+            b_text = true;
+        }
+        free( psz );
+    }
+
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * SubtitleLoadText: parse back the text of an indexed cue
+ *****************************************************************************/
+static int SubtitleLoadText( demux_t *p_demux, subtitle_t *p_subtitle )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    text_t txt = { .i_line_count = 0, .i_line = 0, .line = NULL };
+    size_t i_line_max = 0;
+    subtitle_t cue;
+    int i_ret = VLC_EGENERIC;
+
+    if( vlc_stream_Seek( p_demux->s, p_subtitle->i_offset ) )
+        return VLC_EGENERIC;
+
+    /* Timing line and text, up to the empty line ending the cue */
+    for( ;; )
+    {
+        char *psz = vlc_stream_ReadLine( p_demux->s );
+
+        if( psz == NULL )
+            break;
+
+        if( txt.i_line_count >= i_line_max )
+        {
+            i_line_max += 8;
+            char **pp_realloc = realloc( txt.line, i_line_max * sizeof( char * ) );
+            if( pp_realloc == NULL )
+            {
+                free( psz );
+                goto end;
+            }
+            txt.line = pp_realloc;
+        }
+        txt.line[txt.i_line_count++] = psz;
+
+        if( *psz == '\0' )
+            break;
+    }
+
+    if( p_sys->pf_read( VLC_OBJECT(p_demux), &p_sys->props, &txt, &cue, 0 ) == VLC_SUCCESS )
+    {
+        p_subtitle->psz_text = cue.psz_text;
+        i_ret = VLC_SUCCESS;
+    }
+
+end:
+    for( size_t i = 0; i < txt.i_line_count; i++ )
+        free( txt.line[i] );
+    free( txt.line );
+    return i_ret;
+}
+
 static void TextUnload( text_t *txt )
 {
     if( txt->i_line_count )
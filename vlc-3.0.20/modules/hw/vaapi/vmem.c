@@ -0,0 +1,63 @@
+/*****************************************************************************
+ * vmem.c: VA-API surface export for the video memory output
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+
+#include "vlc_vaapi.h"
+#include "../../video_output/vmem_surface.h"
+
+static int Export(vmem_surface_t *exporter, picture_t *pic,
+                  struct vmem_surface_desc *desc)
+{
+    VLC_UNUSED(exporter);
+
+    /* Pictures from a VA-API decoder always carry their surface */
+    if (pic->context == NULL)
+        return VLC_EGENERIC;
+
+    desc->type = VMEM_SURFACE_VAAPI;
+    desc->u.vaapi.display = vlc_vaapi_PicGetDisplay(pic);
+    desc->u.vaapi.surface = vlc_vaapi_PicGetSurface(pic);
+    return VLC_SUCCESS;
+}
+
+static int Open(vlc_object_t *obj)
+{
+    vmem_surface_t *exporter = (vmem_surface_t *)obj;
+
+    if (!vlc_vaapi_IsChromaOpaque(exporter->chroma))
+        return VLC_EGENERIC;
+
+    exporter->export = Export;
+    return VLC_SUCCESS;
+}
+
+vlc_module_begin ()
+    set_description("VA-API surface export for video memory output")
+    set_capability("vmem surface", 100)
+    set_callbacks(Open, NULL)
+    set_category(CAT_VIDEO)
+    set_subcategory(SUBCAT_VIDEO_VOUT)
+vlc_module_end ()
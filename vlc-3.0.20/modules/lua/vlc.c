@@ -675,17 +675,136 @@ int vlclua_add_modules_path( lua_State *L, const char *psz_filename )
     return 0;
 }
 
+/*****************************************************************************
+ * Compiled scripts cache
+ *
+ * The same scripts are loaded again for every probe (playlist, meta, art...)
+ * in a new Lua state. Keep their compiled chunks, as long as the files are
+ * not modified, so that they are neither read nor parsed again.
+ *****************************************************************************/
+#define CHUNK_CACHE_SIZE 128
+
+typedef struct
+{
+    char *psz_path;
+    time_t i_mtime;
+    off_t i_size;
+    char *p_code;
+    size_t i_code;
+} vlclua_chunk_t;
+
+static vlc_mutex_t chunk_lock = VLC_STATIC_MUTEX;
+static vlclua_chunk_t chunk_cache[CHUNK_CACHE_SIZE];
+static unsigned chunk_next;
+
+typedef struct
+{
+    char *p_code;
+    size_t i_code;
+} vlclua_dump_t;
+
+static int vlclua_chunk_writer( lua_State *L, const void *p, size_t sz,
+                                void *ud )
+{
+    vlclua_dump_t *dump = ud;
+    (void) L;
+
+    char *p_code = realloc( dump->p_code, dump->i_code + sz );
+    if( unlikely(p_code == NULL) )
+        return 1;
+    memcpy( p_code + dump->i_code, p, sz );
+    dump->p_code = p_code;
+    dump->i_code += sz;
+    return 0;
+}
+
+/** luaL_loadfile() with a cache of the compiled chunks, keyed by path */
+static int vlclua_loadfile( lua_State *L, const char *psz_path,
+                            const char *psz_localpath )
+{
+    struct stat st;
+    if( vlc_stat( psz_path, &st ) )
+        return luaL_loadfile( L, psz_localpath );
+
+    char *psz_chunkname;
+    if( asprintf( &psz_chunkname, "@%s", psz_localpath ) == -1 )
+        return luaL_loadfile( L, psz_localpath );
+
+    vlc_mutex_lock( &chunk_lock );
+    for( unsigned i = 0; i < CHUNK_CACHE_SIZE; i++ )
+    {
+        vlclua_chunk_t *chunk = &chunk_cache[i];
+        if( chunk->psz_path == NULL || strcmp( chunk->psz_path, psz_path ) )
+            continue;
+
+        if( chunk->i_mtime == st.st_mtime && chunk->i_size == st.st_size )
+        {
+            if( luaL_loadbuffer( L, chunk->p_code, chunk->i_code,
+                                 psz_chunkname ) == 0 )
+            {
+                vlc_mutex_unlock( &chunk_lock );
+                free( psz_chunkname );
+                return 0;
+            }
+            lua_pop( L, 1 ); /* error message */
+        }
+        /* The script was modified */
+        FREENULL( chunk->psz_path );
+        FREENULL( chunk->p_code );
+        break;
+    }
+    vlc_mutex_unlock( &chunk_lock );
+    free( psz_chunkname );
+
+    int i_ret = luaL_loadfile( L, psz_localpath );
+    if( i_ret )
+        return i_ret;
+
+    vlclua_dump_t dump = { NULL, 0 };
+#if LUA_VERSION_NUM >= 503
+    if( lua_dump( L, vlclua_chunk_writer, &dump, 0 ) )
+#else
+    if( lua_dump( L, vlclua_chunk_writer, &dump ) )
+#endif
+    {
+        free( dump.p_code );
+        return 0;
+    }
+
+    char *psz_dup = strdup( psz_path );
+    if( unlikely(psz_dup == NULL) )
+    {
+        free( dump.p_code );
+        return 0;
+    }
+
+    vlc_mutex_lock( &chunk_lock );
+    vlclua_chunk_t *chunk = &chunk_cache[chunk_next];
+    chunk_next = ( chunk_next + 1 ) % CHUNK_CACHE_SIZE;
+    free( chunk->psz_path );
+    free( chunk->p_code );
+    chunk->psz_path = psz_dup;
+    chunk->i_mtime = st.st_mtime;
+    chunk->i_size = st.st_size;
+    chunk->p_code = dump.p_code;
+    chunk->i_code = dump.i_code;
+    vlc_mutex_unlock( &chunk_lock );
+    return 0;
+}
+
 /** Replacement for luaL_dofile, using VLC's input capabilities */
 int vlclua_dofile( vlc_object_t *p_this, lua_State *L, const char *curi )
 {
     char *uri = ToLocaleDup( curi );
     if( !strstr( uri, "://" ) ) {
-        int ret = luaL_dofile( L, uri );
+        int ret = vlclua_loadfile( L, curi, uri )
+               || lua_pcall( L, 0, LUA_MULTRET, 0 );
         free( uri );
         return ret;
     }
     if( !strncasecmp( uri, "file://", 7 ) ) {
-        int ret = luaL_dofile( L, uri + 7 );
+        int ret = vlclua_loadfile( L, curi + 7, uri + 7 )
+               || lua_pcall( L, 0, LUA_MULTRET, 0 );
         free( uri );
         return ret;
     }
@@ -47,8 +47,103 @@ typedef struct vlc_tls_gnutls
     vlc_tls_t tls;
     gnutls_session_t session;
     vlc_object_t *obj;
+    char *cache_key; /**< client session cache key, or NULL */
+    bool handshaked;
 } vlc_tls_gnutls_t;
 
+/*
+ * Client session resumption cache.
+ * Short-lived connections to the same server (e.g. HTTP adaptive streaming
+ * segments) can then skip the full handshake.
+ */
+#define SESSION_CACHE_SIZE 16
+
+static struct
+{
+    char *key;
+    gnutls_datum_t data;
+    vlc_tick_t last_use;
+} session_cache[SESSION_CACHE_SIZE];
+static vlc_mutex_t session_cache_lock = VLC_STATIC_MUTEX;
+
+/**
+ * Builds the session cache key from the server name and the ALPN list,
+ * as a session is only reusable for the same protocol set.
+ */
+static char *gnutls_SessionCacheKey(const char *hostname,
+                                    const char *const *alpn)
+{
+    size_t len = strlen(hostname) + 1;
+
+    for (const char *const *p = alpn; p != NULL && *p != NULL; p++)
+        len += strlen(*p) + 1;
+
+    char *key = malloc(len);
+    if (unlikely(key == NULL))
+        return NULL;
+
+    char *ptr = stpcpy(key, hostname);
+    for (const char *const *p = alpn; p != NULL && *p != NULL; p++)
+    {
+        *(ptr++) = '\n';
+        ptr = stpcpy(ptr, *p);
+    }
+    return key;
+}
+
+static void gnutls_SessionCacheGet(gnutls_session_t session, const char *key)
+{
+    vlc_mutex_lock(&session_cache_lock);
+    for (size_t i = 0; i < SESSION_CACHE_SIZE; i++)
+        if (session_cache[i].key != NULL && !strcmp(session_cache[i].key, key))
+        {
+            gnutls_session_set_data(session, session_cache[i].data.data,
+                                    session_cache[i].data.size);
+            session_cache[i].last_use = mdate();
+            break;
+        }
+    vlc_mutex_unlock(&session_cache_lock);
+}
+
+static void gnutls_SessionCachePut(gnutls_session_t session, const char *key)
+{
+    gnutls_datum_t data;
+
+    if (gnutls_session_get_data2(session, &data) != 0)
+        return;
+
+    char *dup = strdup(key);
+    if (unlikely(dup == NULL))
+    {
+        gnutls_free(data.data);
+        return;
+    }
+
+    size_t slot = 0;
+
+    vlc_mutex_lock(&session_cache_lock);
+    for (size_t i = 0; i < SESSION_CACHE_SIZE; i++)
+    {
+        if (session_cache[i].key != NULL && !strcmp(session_cache[i].key, key))
+        {
+            slot = i;
+            break;
+        }
+        /* Otherwise, reuse a free slot or the least recently used one */
+        if (session_cache[slot].key != NULL
+         && (session_cache[i].key == NULL
+          || session_cache[i].last_use < session_cache[slot].last_use))
+            slot = i;
+    }
+
+    free(session_cache[slot].key);
+    gnutls_free(session_cache[slot].data.data);
+    session_cache[slot].key = dup;
+    session_cache[slot].data = data;
+    session_cache[slot].last_use = mdate();
+    vlc_mutex_unlock(&session_cache_lock);
+}
+
 static int gnutls_Init (vlc_object_t *obj)
 {
     const char *version = gnutls_check_version ("3.3.0");
@@ -213,7 +308,13 @@ static void gnutls_Close (vlc_tls_t *tls)
 {
     vlc_tls_gnutls_t *priv = (vlc_tls_gnutls_t *)tls;
 
+    /* Save the session at the end, as TLS 1.3 tickets are only received
+     * after the handshake. */
+    if (priv->cache_key != NULL && priv->handshaked)
+        gnutls_SessionCachePut(priv->session, priv->cache_key);
+
     gnutls_deinit(priv->session);
+    free(priv->cache_key);
     free(priv);
 }
 
@@ -295,6 +396,8 @@ static vlc_tls_gnutls_t *gnutls_SessionOpen(vlc_tls_creds_t *creds, int type,
 
     priv->session = session;
     priv->obj = VLC_OBJECT(creds);
+    priv->cache_key = NULL;
+    priv->handshaked = false;
 
     vlc_tls_t *tls = &priv->tls;
 
@@ -352,6 +455,9 @@ static int gnutls_ContinueHandshake(vlc_tls_creds_t *crd,
     return -1;
 
 done:
+    priv->handshaked = true;
+    if (gnutls_session_is_resumed(session))
+        msg_Dbg(crd, " - resumed session");
 #if (GNUTLS_VERSION_NUMBER >= 0x030500)
     /* intentionally left blank */;
 
@@ -403,10 +509,16 @@ static vlc_tls_t *gnutls_ClientSessionOpen(vlc_tls_creds_t *crd,
     gnutls_dh_set_prime_bits (session, 1024);
 
     if (likely(hostname != NULL))
+    {
         /* fill Server Name Indication */
         gnutls_server_name_set (session, GNUTLS_NAME_DNS,
                                 hostname, strlen (hostname));
 
+        priv->cache_key = gnutls_SessionCacheKey(hostname, alpn);
+        if (likely(priv->cache_key != NULL))
+            gnutls_SessionCacheGet(session, priv->cache_key);
+    }
+
     return &priv->tls;
 }
 
@@ -546,6 +658,9 @@ static int gnutls_ClientHandshake(vlc_tls_creds_t *creds, vlc_tls_t *tls,
     return 0;
 
 error:
+    /* Never resume a session that failed verification */
+    free(priv->cache_key);
+    priv->cache_key = NULL;
     if (alp != NULL)
         free(*alp);
     return -1;
@@ -617,6 +732,7 @@ typedef struct vlc_tls_creds_sys
 {
     gnutls_certificate_credentials_t x509_cred;
     gnutls_dh_params_t dh_params;
+    gnutls_datum_t ticket_key;
 } vlc_tls_creds_sys_t;
 
 /**
@@ -631,7 +747,13 @@ static vlc_tls_t *gnutls_ServerSessionOpen(vlc_tls_creds_t *crd,
 
     assert (hostname == NULL);
     priv = gnutls_SessionOpen(crd, GNUTLS_SERVER, sys->x509_cred, sk, alpn);
-    return (priv != NULL) ? &priv->tls : NULL;
+    if (priv == NULL)
+        return NULL;
+
+    /* Let returning clients resume their sessions */
+    if (sys->ticket_key.data != NULL)
+        gnutls_session_ticket_enable_server(priv->session, &sys->ticket_key);
+    return &priv->tls;
 }
 
 static int gnutls_ServerHandshake(vlc_tls_creds_t *crd, vlc_tls_t *tls,
@@ -727,6 +849,14 @@ static int OpenServer (vlc_tls_creds_t *crd, const char *cert, const char *key)
 
     msg_Dbg (crd, "ciphers parameters loaded");
 
+    val = gnutls_session_ticket_key_generate (&sys->ticket_key);
+    if (val < 0)
+    {
+        msg_Warn (crd, "cannot generate session ticket key: %s",
+                  gnutls_strerror (val));
+        sys->ticket_key.data = NULL;
+    }
+
     crd->sys = sys;
     crd->open = gnutls_ServerSessionOpen;
     crd->handshake = gnutls_ServerHandshake;
@@ -749,6 +879,11 @@ static void CloseServer (vlc_tls_creds_t *crd)
     /* all sessions depending on the server are now deinitialized */
     gnutls_certificate_free_credentials (sys->x509_cred);
     gnutls_dh_params_deinit (sys->dh_params);
+    if (sys->ticket_key.data != NULL)
+    {
+        memset (sys->ticket_key.data, 0, sys->ticket_key.size);
+        gnutls_free (sys->ticket_key.data);
+    }
     free (sys);
 }
 #endif
@@ -53,6 +53,18 @@
     "\"Fast Start\" files are optimized for downloads and allow the user " \
     "to start previewing the file while it is downloading.")
 
+#define MOOVSPACE_TEXT N_("Space reserved for the index (bytes)")
+#define MOOVSPACE_LONGTEXT N_(\
+    "Space reserved at the start of \"Fast Start\" files for the index. " \
+    "If the index fits, the file does not have to be rewritten when " \
+    "closing. The index takes roughly 20 bytes per sample. " \
+    "0 disables the reservation.")
+
+#define FRAGLEN_TEXT N_("Fragment length")
+#define FRAGLEN_LONGTEXT N_(\
+    "Target duration of the fragments, in milliseconds. " \
+    "Fragments start on keyframes whenever possible.")
+
 static int  Open   (vlc_object_t *);
 static void Close  (vlc_object_t *);
 static int  OpenFrag   (vlc_object_t *);
@@ -69,6 +81,9 @@ vlc_module_begin ()
     add_bool(SOUT_CFG_PREFIX "faststart", true,
               FASTSTART_TEXT, FASTSTART_LONGTEXT,
               true)
+    add_integer(SOUT_CFG_PREFIX "moov-space", 0,
+                MOOVSPACE_TEXT, MOOVSPACE_LONGTEXT, true)
+        change_integer_range(0, INT32_MAX)
     set_capability("sout mux", 5)
     add_shortcut("mp4", "mov", "3gp")
     set_callbacks(Open, Close)
@@ -80,6 +95,9 @@ add_submodule ()
     set_shortname("MP4 Frag")
     add_shortcut("mp4frag", "mp4stream")
     set_capability("sout mux", 0)
+    add_integer(SOUT_CFG_PREFIX "fragment-length", 1500,
+                FRAGLEN_TEXT, FRAGLEN_LONGTEXT, true)
+        change_integer_range(100, 10000)
     set_callbacks(OpenFrag, CloseFrag)
 
 vlc_module_end ()
@@ -88,7 +106,11 @@ vlc_module_end ()
  * Exported prototypes
  *****************************************************************************/
 static const char *const ppsz_sout_options[] = {
-    "faststart", NULL
+    "faststart", "moov-space", NULL
+};
+
+static const char *const ppsz_frag_options[] = {
+    "fragment-length", NULL
 };
 
 static int Control(sout_mux_t *, int, va_list);
@@ -158,6 +180,10 @@ struct sout_mux_sys_t
     bool b_64_ext;
     bool b_fast_start;
 
+    /* reserved space for the fast start moov */
+    uint32_t i_moov_space;
+    uint64_t i_moov_space_pos;
+
     /* global */
     bool     b_header_sent;
 
@@ -173,6 +199,7 @@ struct sout_mux_sys_t
     /* mp4frag */
     bool           b_fragmented;
     vlc_tick_t     i_written_duration;
+    vlc_tick_t     i_fragment_length;
     uint32_t       i_mfhd_sequence;
 };
 
@@ -209,6 +236,22 @@ static int WriteSlowStartHeader(sout_mux_t *p_mux)
         box_send(p_mux, box);
     }
 
+    /* Reserve space for the moov as a free box */
+    if (p_sys->i_moov_space > 0) {
+        block_t *p_free = block_Alloc(p_sys->i_moov_space);
+        if (!p_free)
+            return VLC_ENOMEM;
+
+        memset(p_free->p_buffer, 0, p_free->i_buffer);
+        SetDWBE(p_free->p_buffer, p_sys->i_moov_space);
+        memcpy(&p_free->p_buffer[4], "free", 4);
+
+        p_sys->i_moov_space_pos = p_sys->i_pos;
+        p_sys->i_pos += p_free->i_buffer;
+        p_sys->i_mdat_pos = p_sys->i_pos;
+        sout_AccessOutWrite(p_mux->p_access, p_free);
+    }
+
     /* Now add mdat header */
     box = box_new("mdat");
     if(!box)
@@ -253,6 +296,14 @@ static int Open(vlc_object_t *p_this)
     p_sys->b_fragmented = false;
     p_sys->b_header_sent = false;
 
+    p_sys->i_moov_space = 0;
+    p_sys->i_moov_space_pos = 0;
+    if (var_GetBool(p_this, SOUT_CFG_PREFIX "faststart")) {
+        int64_t i_space = var_GetInteger(p_this, SOUT_CFG_PREFIX "moov-space");
+        if (i_space >= 16)
+            p_sys->i_moov_space = i_space;
+    }
+
     /* FIXME FIXME
      * Quicktime actually doesn't like the 64 bits extensions !!! */
     p_sys->b_64_ext = false;
@@ -296,6 +347,30 @@ static void Close(vlc_object_t *p_this)
 
     /* Check we need to create "fast start" files */
     p_sys->b_fast_start = var_GetBool(p_this, SOUT_CFG_PREFIX "faststart");
+    if (p_sys->b_fast_start && p_sys->i_moov_space > 0 && moov && moov->b) {
+        size_t i_moov_size = moov->b->i_buffer;
+
+        /* The remaining space must be able to hold a free box header */
+        if (i_moov_size == p_sys->i_moov_space ||
+            i_moov_size + 8 <= p_sys->i_moov_space) {
+            /* The data does not move, so the chunk offsets stay valid */
+            uint32_t i_left = p_sys->i_moov_space - i_moov_size;
+
+            sout_AccessOutSeek(p_mux->p_access, p_sys->i_moov_space_pos);
+            box_send(p_mux, moov);
+            moov = NULL;
+
+            if (i_left > 0 && bo_init(&bo, 8)) {
+                bo_add_32be  (&bo, i_left);
+                bo_add_fourcc(&bo, "free");
+                sout_AccessOutWrite(p_mux->p_access, bo.b);
+            }
+            p_sys->b_fast_start = false;
+        } else
+            msg_Warn(p_this, "index (%zu bytes) does not fit in reserved "
+                     "space (%"PRIu32" bytes), moving data", i_moov_size,
+                     p_sys->i_moov_space);
+    }
     while (p_sys->b_fast_start && moov && moov->b) {
         /* Move data to the end of the file so we can fit the moov header
          * at the start */
@@ -351,9 +426,10 @@ static void Close(vlc_object_t *p_this)
     }
 
     /* Write MOOV header */
-    sout_AccessOutSeek(p_mux->p_access, i_moov_pos);
-    if (moov != NULL)
+    if (moov != NULL) {
+        sout_AccessOutSeek(p_mux->p_access, i_moov_pos);
         box_send(p_mux, moov);
+    }
 
 cleanup:
     /* Clean-up */
@@ -803,8 +879,6 @@ static void box_send(sout_mux_t *p_mux,  bo_t *box)
 /***************************************************************************
     MP4 Live submodule
 ****************************************************************************/
-#define FRAGMENT_LENGTH  (CLOCK_FREQ * 3/2)
-
 #define ENQUEUE_ENTRY(object, entry) \
     do {\
         if (object.p_last)\
@@ -1226,6 +1300,10 @@ static int OpenFrag(vlc_object_t *p_this)
     p_sys->i_start_dts = VLC_TICK_INVALID;
     p_sys->i_mfhd_sequence = 1;
 
+    config_ChainParse(p_mux, SOUT_CFG_PREFIX, ppsz_frag_options, p_mux->p_cfg);
+    p_sys->i_fragment_length = CLOCK_FREQ / 1000 *
+                var_GetInteger(p_mux, SOUT_CFG_PREFIX "fragment-length");
+
     return VLC_SUCCESS;
 }
 
@@ -1233,7 +1311,7 @@ static void WriteFragments(sout_mux_t *p_mux, bool b_flush)
 {
     sout_mux_sys_t *p_sys = (sout_mux_sys_t*) p_mux->p_sys;
     bo_t *moof = NULL;
-    vlc_tick_t i_barrier_time = p_sys->i_written_duration + FRAGMENT_LENGTH;
+    vlc_tick_t i_barrier_time = p_sys->i_written_duration + p_sys->i_fragment_length;
     size_t i_mdat_size = 0;
     bool b_has_samples = false;
 
@@ -1279,6 +1357,20 @@ static void WriteFragments(sout_mux_t *p_mux, bool b_flush)
 
     if (moof)
     {
+        /* timestamp the fragment, so that segmenters can cut on it */
+        vlc_tick_t i_length = 0;
+        for (unsigned int i = 0; i < p_sys->i_nb_streams; i++)
+        {
+            const mp4_stream_t *p_stream = p_sys->pp_streams[i];
+            vlc_tick_t i_stream_length = 0;
+            for (const mp4_fragentry_t *p_entry = p_stream->towrite.p_first;
+                 p_entry; p_entry = p_entry->p_next)
+                i_stream_length += p_entry->p_block->i_length;
+            i_length = __MAX(i_length, i_stream_length);
+        }
+        moof->b->i_dts = p_sys->i_start_dts + p_sys->i_written_duration;
+        moof->b->i_length = i_length;
+
         msg_Dbg(p_mux, "writing moof @ %"PRId64, p_sys->i_pos);
         p_sys->i_pos += moof->b->i_buffer;
         assert(moof->b->i_flags & BLOCK_FLAG_TYPE_I); /* http sout */
@@ -1446,7 +1538,7 @@ static int MuxFrag(sout_mux_t *p_mux)
         p_stream->p_held_entry = NULL;
 
         if (p_stream->b_hasiframes && (p_heldblock->i_flags & BLOCK_FLAG_TYPE_I) &&
-            p_stream->mux.i_read_duration - p_sys->i_written_duration < FRAGMENT_LENGTH)
+            p_stream->mux.i_read_duration - p_sys->i_written_duration < p_sys->i_fragment_length)
         {
             /* Flag the last iframe time, we'll use it as boundary so it will start
                next fragment */
@@ -1495,7 +1587,7 @@ static int MuxFrag(sout_mux_t *p_mux)
     p_sys->i_written_duration = i_min_written_duration;
 
     /* we have prerolled enough to know all streams, and have enough date to create a fragment */
-    if (p_stream->read.p_first && p_sys->i_read_duration - p_sys->i_written_duration >= FRAGMENT_LENGTH)
+    if (p_stream->read.p_first && p_sys->i_read_duration - p_sys->i_written_duration >= p_sys->i_fragment_length)
         WriteFragments(p_mux, false);
 
     return VLC_SUCCESS;
@@ -47,13 +47,20 @@ struct csa_t
     int     p, q, r;
 
     bool    use_odd;
+
+    /* csa_DecryptBatch() keystream, one row per packet */
+    uint8_t stream[CSA_BATCH_MAX][184];
 };
 
 static void csa_ComputeKey( uint8_t kk[57], uint8_t ck[8] );
 
 static void csa_StreamCypher( csa_t *c, int b_init, uint8_t *ck, uint8_t *sb, uint8_t *cb );
 
+static void csa_StreamCypherBatch( csa_t *c, uint8_t *const *ck, uint8_t *const *sb,
+                                   int i_lanes, int i_blocks );
+
 static void csa_BlockDecypher( uint8_t kk[57], uint8_t ib[8], uint8_t bd[8] );
+static void csa_BlockDecypherBatch( uint8_t *const *kk, uint64_t *R, int i_lanes );
 static void csa_BlockCypher( uint8_t kk[57], uint8_t bd[8], uint8_t ib[8] );
 
 /*****************************************************************************
@@ -224,6 +231,146 @@ void csa_Decrypt( csa_t *c, uint8_t *pkt, int i_pkt_size )
     }
 }
 
+/*****************************************************************************
+ * csa_DecryptBatch:
+ *****************************************************************************
+ * Same as calling csa_Decrypt on each packet, but the stream cypher runs
+ * bitsliced over up to CSA_BATCH_MAX packets at once.
+ *****************************************************************************/
+#define CSA_BATCH_MIN 8 /* below that, the bitsliced cypher is slower */
+
+static void csa_DecryptLanes( csa_t *c, uint8_t **pkts, int i_count, int i_pkt_size )
+{
+    uint8_t *pkt_lane[CSA_BATCH_MAX];
+    uint8_t *ck_lane[CSA_BATCH_MAX];
+    uint8_t *kk_lane[CSA_BATCH_MAX];
+    uint8_t *sb_lane[CSA_BATCH_MAX];
+    int      hdr_lane[CSA_BATCH_MAX];
+    int      i_lanes = 0;
+    int      i_blocks = 0;
+
+    for( int l = 0; l < i_count; l++ )
+    {
+        uint8_t *pkt = pkts[l];
+
+        /* transport scrambling control */
+        if( (pkt[3]&0x80) == 0 )
+            continue;
+
+        const bool b_odd = pkt[3]&0x40;
+
+        /* clear transport scrambling control */
+        pkt[3] &= 0x3f;
+
+        int i_hdr = 4;
+        if( pkt[3]&0x20 )
+        {
+            /* skip adaption field */
+            i_hdr += pkt[4] + 1;
+        }
+
+        if( 188 - i_hdr < 8 || i_pkt_size < i_hdr )
+            continue;
+
+        const int n = (i_pkt_size - i_hdr) / 8;
+        const int i_residue = (i_pkt_size - i_hdr) % 8;
+        const int i_needed = ( n > 0 ? n - 1 : 0 ) + ( i_residue > 0 );
+        if( i_needed > i_blocks )
+            i_blocks = i_needed;
+
+        pkt_lane[i_lanes] = pkt;
+        ck_lane[i_lanes] = b_odd ? c->o_ck : c->e_ck;
+        kk_lane[i_lanes] = b_odd ? c->o_kk : c->e_kk;
+        sb_lane[i_lanes] = &pkt[i_hdr];
+        hdr_lane[i_lanes] = i_hdr;
+        i_lanes++;
+    }
+
+    if( i_lanes == 0 )
+        return;
+
+    csa_StreamCypherBatch( c, ck_lane, sb_lane, i_lanes, i_blocks );
+
+    uint8_t  ib[CSA_BATCH_MAX][8];
+    uint64_t R[CSA_BATCH_MAX];
+    uint8_t *kk_active[CSA_BATCH_MAX];
+    int      active[CSA_BATCH_MAX];
+
+    for( int l = 0; l < i_lanes; l++ )
+        memcpy( ib[l], &pkt_lane[l][hdr_lane[l]], 8 );
+
+    /* i-th block of every packet that has one */
+    for( int i = 1; ; i++ )
+    {
+        int i_active = 0;
+        for( int l = 0; l < i_lanes; l++ )
+        {
+            if( (i_pkt_size - hdr_lane[l]) / 8 < i )
+                continue;
+            active[i_active] = l;
+            kk_active[i_active] = kk_lane[l];
+            R[i_active] = GetQWLE( ib[l] );
+            i_active++;
+        }
+        if( i_active == 0 )
+            break;
+
+        csa_BlockDecypherBatch( kk_active, R, i_active );
+
+        for( int a = 0; a < i_active; a++ )
+        {
+            const int l = active[a];
+            uint8_t *pkt = pkt_lane[l];
+            const int i_hdr = hdr_lane[l];
+            uint8_t block[8];
+
+            SetQWLE( block, R[a] );
+            if( i != (i_pkt_size - i_hdr) / 8 )
+            {
+                for( int j = 0; j < 8; j++ )
+                    ib[l][j] = pkt[i_hdr+8*i+j] ^ c->stream[l][8*(i-1)+j];
+            }
+            else
+            {
+                /* last block */
+                memset( ib[l], 0, 8 );
+            }
+            for( int j = 0; j < 8; j++ )
+                pkt[i_hdr+8*(i-1)+j] = ib[l][j] ^ block[j];
+        }
+    }
+
+    for( int l = 0; l < i_lanes; l++ )
+    {
+        uint8_t *pkt = pkt_lane[l];
+        const int n = (i_pkt_size - hdr_lane[l]) / 8;
+        const int i_residue = (i_pkt_size - hdr_lane[l]) % 8;
+        const uint8_t *stream = &c->stream[l][8 * ( n > 0 ? n - 1 : 0 )];
+
+        for( int j = 0; j < i_residue; j++ )
+            pkt[i_pkt_size - i_residue + j] ^= stream[j];
+    }
+}
+
+void csa_DecryptBatch( csa_t *c, uint8_t **pkts, int i_count, int i_pkt_size )
+{
+    while( i_count > 0 )
+    {
+        const int i_lanes = __MIN( i_count, CSA_BATCH_MAX );
+
+        if( i_lanes < CSA_BATCH_MIN )
+        {
+            for( int i = 0; i < i_lanes; i++ )
+                csa_Decrypt( c, pkts[i], i_pkt_size );
+        }
+        else
+            csa_DecryptLanes( c, pkts, i_lanes, i_pkt_size );
+
+        pkts += i_lanes;
+        i_count -= i_lanes;
+    }
+}
+
 /*****************************************************************************
  * csa_Encrypt:
  *****************************************************************************/
@@ -494,6 +641,185 @@ static void csa_StreamCypher( csa_t *c, int b_init, uint8_t *ck, uint8_t *sb, ui
 }
 
 
+/*****************************************************************************
+ * Bitsliced stream cypher: bit b of every nibble/flag of csa_StreamCypher
+ * state is a 64 bits word holding that bit for 64 packets (lane l = bit l).
+ *****************************************************************************/
+typedef struct
+{
+    uint64_t A[11][4];
+    uint64_t B[11][4];
+    uint64_t X[4], Y[4], Z[4];
+    uint64_t D[4], E[4], F[4];
+    uint64_t p, q, r;
+} csa_bs_state_t;
+
+/* evaluates a 5 to 2 bits sbox as a multiplexer tree over its inputs */
+static inline void csa_bs_sbox( const int sbox[0x20], uint64_t i4, uint64_t i3,
+                                uint64_t i2, uint64_t i1, uint64_t i0,
+                                uint64_t *o1, uint64_t *o0 )
+{
+    uint64_t out[2];
+
+    for( int b = 0; b < 2; b++ )
+    {
+        uint64_t m[16];
+
+        for( int k = 0; k < 16; k++ )
+        {
+            const uint64_t t0 = -(uint64_t)( (sbox[2*k+0] >> b)&1 );
+            const uint64_t t1 = -(uint64_t)( (sbox[2*k+1] >> b)&1 );
+            m[k] = t0 ^ ( (t0 ^ t1) & i0 );
+        }
+        for( int k = 0; k < 8; k++ )
+            m[k] = m[2*k] ^ ( (m[2*k] ^ m[2*k+1]) & i1 );
+        for( int k = 0; k < 4; k++ )
+            m[k] = m[2*k] ^ ( (m[2*k] ^ m[2*k+1]) & i2 );
+        for( int k = 0; k < 2; k++ )
+            m[k] = m[2*k] ^ ( (m[2*k] ^ m[2*k+1]) & i3 );
+        out[b] = m[0] ^ ( (m[0] ^ m[1]) & i4 );
+    }
+    *o1 = out[1];
+    *o0 = out[0];
+}
+
+/* one 2 bits iteration of csa_StreamCypher, in1/in2 are NULL past init */
+static void csa_bs_step( csa_bs_state_t *s, const uint64_t *in1, const uint64_t *in2,
+                         uint64_t *op1, uint64_t *op0 )
+{
+    uint64_t (*A)[4] = s->A;
+    uint64_t (*B)[4] = s->B;
+    uint64_t s1[2], s2[2], s3[2], s4[2], s5[2], s6[2], s7[2];
+    uint64_t extra_B[4], next_A1[4], next_B1[4], next_E[4], sum[4];
+
+    csa_bs_sbox( sbox1, A[4][0], A[1][2], A[6][1], A[7][3], A[9][0], &s1[1], &s1[0] );
+    csa_bs_sbox( sbox2, A[2][1], A[3][2], A[6][3], A[7][0], A[9][1], &s2[1], &s2[0] );
+    csa_bs_sbox( sbox3, A[1][3], A[2][0], A[5][1], A[5][3], A[6][2], &s3[1], &s3[0] );
+    csa_bs_sbox( sbox4, A[3][3], A[1][1], A[2][3], A[4][2], A[8][0], &s4[1], &s4[0] );
+    csa_bs_sbox( sbox5, A[5][2], A[4][3], A[6][0], A[8][1], A[9][2], &s5[1], &s5[0] );
+    csa_bs_sbox( sbox6, A[3][1], A[4][1], A[5][0], A[7][2], A[9][3], &s6[1], &s6[0] );
+    csa_bs_sbox( sbox7, A[2][2], A[3][0], A[7][1], A[8][2], A[8][3], &s7[1], &s7[0] );
+
+    /* use 4x4 xor to produce extra nibble for T3 */
+    extra_B[3] = B[3][0] ^ B[6][1] ^ B[7][2] ^ B[9][3];
+    extra_B[2] = B[6][0] ^ B[8][1] ^ B[3][3] ^ B[4][2];
+    extra_B[1] = B[5][3] ^ B[8][2] ^ B[4][0] ^ B[5][1];
+    extra_B[0] = B[9][2] ^ B[6][3] ^ B[3][1] ^ B[8][0];
+
+    for( int k = 0; k < 4; k++ )
+    {
+        /* T1 and T2 */
+        next_A1[k] = A[10][k] ^ s->X[k];
+        next_B1[k] = B[7][k] ^ B[10][k] ^ s->Y[k];
+        if( in1 )
+        {
+            next_A1[k] ^= s->D[k] ^ in1[k];
+            next_B1[k] ^= in2[k];
+        }
+    }
+
+    /* if p=1, rotate left */
+    const uint64_t b3 = next_B1[3];
+    for( int k = 3; k > 0; k-- )
+        next_B1[k] ^= s->p & ( next_B1[k] ^ next_B1[k-1] );
+    next_B1[0] ^= s->p & ( next_B1[0] ^ b3 );
+
+    /* T4 = sum, carry of Z + E + r */
+    uint64_t carry = s->r;
+    for( int k = 0; k < 4; k++ )
+    {
+        const uint64_t x = s->Z[k] ^ s->E[k];
+        sum[k] = x ^ carry;
+        carry = ( s->Z[k] & s->E[k] ) | ( x & carry );
+    }
+
+    for( int k = 0; k < 4; k++ )
+    {
+        /* T3 */
+        s->D[k] = s->E[k] ^ s->Z[k] ^ extra_B[k];
+
+        next_E[k] = s->F[k];
+        s->F[k] = s->E[k] ^ ( s->q & ( sum[k] ^ s->E[k] ) );
+        s->E[k] = next_E[k];
+    }
+    s->r ^= s->q & ( carry ^ s->r );
+
+    memmove( &A[2], &A[1], 9 * sizeof(A[0]) );
+    memmove( &B[2], &B[1], 9 * sizeof(B[0]) );
+    memcpy( A[1], next_A1, sizeof(A[1]) );
+    memcpy( B[1], next_B1, sizeof(B[1]) );
+
+    s->X[3] = s4[0]; s->X[2] = s3[0]; s->X[1] = s2[1]; s->X[0] = s1[1];
+    s->Y[3] = s6[0]; s->Y[2] = s5[0]; s->Y[1] = s4[1]; s->Y[0] = s3[1];
+    s->Z[3] = s2[0]; s->Z[2] = s1[0]; s->Z[1] = s6[1]; s->Z[0] = s5[1];
+    s->p = s7[1];
+    s->q = s7[0];
+
+    /* 2 output bits are a function of the 4 bits of D */
+    *op1 = s->D[3] ^ s->D[2];
+    *op0 = s->D[1] ^ s->D[0];
+}
+
+/* loads the nibbles of byte i of each lane as bit planes */
+static void csa_bs_load( uint64_t hi[4], uint64_t lo[4], uint8_t *const *bytes,
+                         int i, int i_lanes )
+{
+    memset( hi, 0, 4 * sizeof(*hi) );
+    memset( lo, 0, 4 * sizeof(*lo) );
+    for( int l = 0; l < i_lanes; l++ )
+    {
+        const unsigned v = bytes[l][i];
+        for( int k = 0; k < 4; k++ )
+        {
+            hi[k] |= (uint64_t)( (v >> (4+k))&1 ) << l;
+            lo[k] |= (uint64_t)( (v >> k)&1 ) << l;
+        }
+    }
+}
+
+/* Inits the stream cypher of i_lanes packets from their ck and first
+ * payload bytes sb, then generates i_blocks blocks of 8 bytes into
+ * c->stream[lane] */
+static void csa_StreamCypherBatch( csa_t *c, uint8_t *const *ck, uint8_t *const *sb,
+                                   int i_lanes, int i_blocks )
+{
+    csa_bs_state_t s;
+    uint64_t hi[4], lo[4];
+    uint64_t op[8];
+
+    /* load first 32 bits of CK into A[1]..A[8]
+     * load last  32 bits of CK into B[1]..B[8]
+     * all other regs = 0 */
+    memset( &s, 0, sizeof(s) );
+    for( int i = 0; i < 4; i++ )
+    {
+        csa_bs_load( s.A[1+2*i], s.A[2+2*i], ck, i, i_lanes );
+        csa_bs_load( s.B[1+2*i], s.B[2+2*i], ck, 4+i, i_lanes );
+    }
+
+    for( int i = 0; i < 8; i++ )
+    {
+        csa_bs_load( hi, lo, sb, i, i_lanes );
+        for( int j = 0; j < 4; j++ )
+            csa_bs_step( &s, (j % 2) ? lo : hi, (j % 2) ? hi : lo,
+                         &op[7-2*j], &op[6-2*j] );
+    }
+
+    for( int i = 0; i < 8 * i_blocks; i++ )
+    {
+        for( int j = 0; j < 4; j++ )
+            csa_bs_step( &s, NULL, NULL, &op[7-2*j], &op[6-2*j] );
+
+        for( int l = 0; l < i_lanes; l++ )
+        {
+            unsigned v = 0;
+            for( int b = 0; b < 8; b++ )
+                v |= ( (op[b] >> l)&1 ) << b;
+            c->stream[l][i] = v;
+        }
+    }
+}
+
 // block - sbox
 static const uint8_t block_sbox[256] =
 {
@@ -574,6 +900,27 @@ static void csa_BlockDecypher( uint8_t kk[57], uint8_t ib[8], uint8_t bd[8] )
     }
 }
 
+/* csa_BlockDecypher of several blocks at once, R[1]..R[8] of each being
+ * the bytes of a 64 bits word, least significant first */
+static void csa_BlockDecypherBatch( uint8_t *const *kk, uint64_t *R, int i_lanes )
+{
+    // loop over kk[56]..kk[1]
+    for( int i = 56; i > 0; i-- )
+    {
+        for( int l = 0; l < i_lanes; l++ )
+        {
+            const uint64_t r = R[l];
+            const int sbox_out = block_sbox[ kk[l][i]^((r >> 48)&0xff) ];
+            const uint64_t t = (r >> 56) ^ sbox_out;
+
+            /* R[n+1] = R[n], then xor R[8]^sbox_out into R[1], R[3], R[4],
+             * R[5] and perm_out into R[7] */
+            R[l] = (r << 8) ^ ( t * UINT64_C(0x0000000101010001) )
+                            ^ ( (uint64_t)block_perm[sbox_out] << 48 );
+        }
+    }
+}
+
 static void csa_BlockCypher( uint8_t kk[57], uint8_t bd[8], uint8_t ib[8] )
 {
     int i;
@@ -42,6 +42,9 @@
 
 #include <vlc_iso_lang.h>
 
+/* Packs are written out gathered in blocks of up to this size */
+#define PS_OUT_BLOCK_SIZE (64 * 1024)
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -450,6 +453,7 @@ static void DelStream( sout_mux_t *p_mux, sout_input_t *p_input )
 static int Mux( sout_mux_t *p_mux )
 {
     sout_mux_sys_t *p_sys = p_mux->p_sys;
+    block_t *p_out = NULL;
 
     for( ;; )
     {
@@ -464,7 +468,7 @@ static int Mux( sout_mux_t *p_mux )
         int i_stream = sout_MuxGetStream( p_mux, 1, &i_dts );
         if( i_stream < 0 )
         {
-            return VLC_SUCCESS;
+            break;
         }
 
         p_input  = p_mux->pp_inputs[i_stream];
@@ -522,18 +526,65 @@ static int Mux( sout_mux_t *p_mux )
 
         block_ChainAppend( &p_ps, p_data );
 
-        /* Get size of output data so we can calculate the instant bitrate */
-        for( p_data = p_ps; p_data; p_data = p_data->p_next )
+        /* Gather the packs in larger blocks. Headers always start a block,
+         * so that the flag is kept for the segmenters. */
+        if( p_out != NULL && p_ps != NULL &&
+            ( p_ps->i_flags & BLOCK_FLAG_HEADER ) )
         {
-            p_sys->i_instant_size += p_data->i_buffer;
+            sout_AccessOutWrite( p_mux->p_access, p_out );
+            p_out = NULL;
         }
 
-        sout_AccessOutWrite( p_mux->p_access, p_ps );
+        while( p_ps != NULL )
+        {
+            p_data = p_ps;
+            p_ps = p_ps->p_next;
+            p_data->p_next = NULL;
+
+            /* Get size of output data so we can calculate the instant bitrate */
+            p_sys->i_instant_size += p_data->i_buffer;
+
+            if( p_out != NULL &&
+                p_out->i_buffer + p_data->i_buffer > PS_OUT_BLOCK_SIZE )
+            {
+                sout_AccessOutWrite( p_mux->p_access, p_out );
+                p_out = NULL;
+            }
+            if( p_out == NULL && p_data->i_buffer >= PS_OUT_BLOCK_SIZE / 2 )
+            {
+                /* Not worth a copy */
+                sout_AccessOutWrite( p_mux->p_access, p_data );
+                continue;
+            }
+            if( p_out == NULL )
+            {
+                p_out = block_Alloc( PS_OUT_BLOCK_SIZE );
+                if( unlikely(p_out == NULL) )
+                {
+                    block_Release( p_data );
+                    continue;
+                }
+                p_out->i_buffer = 0;
+                p_out->i_flags  = 0;
+                p_out->i_dts    = p_data->i_dts;
+                p_out->i_length = 0;
+            }
+
+            memcpy( &p_out->p_buffer[p_out->i_buffer], p_data->p_buffer,
+                    p_data->i_buffer );
+            p_out->i_buffer += p_data->i_buffer;
+            p_out->i_length += p_data->i_length;
+            p_out->i_flags  |= p_data->i_flags;
+            block_Release( p_data );
+        }
 
         /* Increase counter */
         p_sys->i_pes_count++;
     }
 
+    if( p_out != NULL )
+        sout_AccessOutWrite( p_mux->p_access, p_out );
+
     return VLC_SUCCESS;
 }
 
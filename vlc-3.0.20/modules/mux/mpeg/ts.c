@@ -148,6 +148,11 @@ static const char *const ts_standards_list_text[] =
   "of the shaping algorithm, since I frames are usually the biggest " \
   "frames in the stream.")
 
+#define BLOCK_TEXT N_("TS packets per output block")
+#define BLOCK_LONGTEXT N_("Number of TS packets gathered in each block " \
+  "given to the access output. The default of 7 packets fills an UDP " \
+  "or RTP datagram. Use 1 to output packets one by one.")
+
 #define PCR_TEXT N_("PCR interval (ms)")
 #define PCR_LONGTEXT N_("Set at which interval " \
   "PCRs (Program Clock Reference) will be sent (in milliseconds). " \
@@ -226,6 +231,8 @@ vlc_module_begin ()
     add_bool(SOUT_CFG_PREFIX "use-key-frames", false, KEYF_TEXT, KEYF_LONGTEXT, true)
 
     add_integer( SOUT_CFG_PREFIX "pcr", 70, PCR_TEXT, PCR_LONGTEXT, true)
+    add_integer( SOUT_CFG_PREFIX "block-packets", 7, BLOCK_TEXT, BLOCK_LONGTEXT, true)
+        change_integer_range( 1, 64 )
     add_integer( SOUT_CFG_PREFIX "bmin", 0, BMIN_TEXT, BMIN_LONGTEXT, true)
     add_integer( SOUT_CFG_PREFIX "bmax", 0, BMAX_TEXT, BMAX_LONGTEXT, true)
     add_integer( SOUT_CFG_PREFIX "dts-delay", 400, DTS_TEXT, DTS_LONGTEXT, true)
@@ -249,7 +256,7 @@ static const char *const ppsz_sout_options[] = {
     "netid", "sdtdesc",
     "es-id-pid", "shaping", "pcr", "bmin", "bmax", "use-key-frames",
     "dts-delay", "csa-ck", "csa2-ck", "csa-use", "csa-pkt", "crypt-audio", "crypt-video",
-    "muxpmt", "program-pmt", "alignment",
+    "muxpmt", "program-pmt", "alignment", "block-packets",
     NULL
 };
 
@@ -367,6 +374,10 @@ struct sout_mux_sys_t
     sdt_psi_t       sdt;
     ts_mux_standard standard;
 
+    /* PSI packets, built again only when the tables change */
+    sout_buffer_chain_t psi_pat;
+    sout_buffer_chain_t psi_pmt;
+
     /* for TS building */
     int64_t         i_bitrate_min;
     int64_t         i_bitrate_max;
@@ -381,6 +392,9 @@ struct sout_mux_sys_t
 
     vlc_tick_t      i_pcr;  /* last PCR emitted */
 
+    int             i_block_packets;
+    block_t         *p_free_ts; /* sent TS packets, reused by TSNew() */
+
     csa_t           *csa;
     int             i_csa_pkt_size;
     bool            b_crypt_audio;
@@ -481,6 +495,8 @@ static void GetPAT( sout_mux_t *p_mux, sout_buffer_chain_t *c );
 static void GetPMT( sout_mux_t *p_mux, sout_buffer_chain_t *c );
 
 static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream, bool b_pcr );
+static block_t *TSAlloc( sout_mux_sys_t *p_sys );
+static void TSRelease( sout_mux_sys_t *p_sys, block_t *p_ts );
 static void TSSetPCR( block_t *p_ts, vlc_tick_t i_dts );
 
 static csa_t *csaSetup( vlc_object_t *p_this )
@@ -734,6 +750,10 @@ static int Open( vlc_object_t *p_this )
              p_sys->i_shaping_delay, p_sys->i_pcr_delay, p_sys->i_dts_delay );
 
     p_sys->b_use_key_frames = var_GetBool( p_mux, SOUT_CFG_PREFIX "use-key-frames" );
+    p_sys->i_block_packets = var_GetInteger( p_mux, SOUT_CFG_PREFIX "block-packets" );
+
+    BufferChainInit( &p_sys->psi_pat );
+    BufferChainInit( &p_sys->psi_pmt );
 
     p_mux->p_sys        = p_sys;
 
@@ -773,6 +793,10 @@ static void Close( vlc_object_t * p_this )
         free( p_sys->sdt.desc[i].psz_provider );
     }
 
+    BufferChainClean( &p_sys->psi_pat );
+    BufferChainClean( &p_sys->psi_pmt );
+    block_ChainRelease( p_sys->p_free_ts );
+
     free( p_sys );
 }
 
@@ -975,6 +999,7 @@ static int AddStream( sout_mux_t *p_mux, sout_input_t *p_input )
 
     /* We only change PMT version (PAT isn't changed) */
     p_sys->i_pmt_version_number = ( p_sys->i_pmt_version_number + 1 )%32;
+    BufferChainClean( &p_sys->psi_pmt );
 
     /* Update pcr_pid */
     SelectPCRStream( p_mux, NULL );
@@ -1035,6 +1060,7 @@ static void DelStream( sout_mux_t *p_mux, sout_input_t *p_input )
     /* We only change PMT version (PAT isn't changed) */
     p_sys->i_pmt_version_number++;
     p_sys->i_pmt_version_number %= 32;
+    BufferChainClean( &p_sys->psi_pmt );
 }
 
 static void SetHeader( sout_buffer_chain_t *c,
@@ -1767,6 +1793,7 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
 {
     sout_mux_sys_t  *p_sys = p_mux->p_sys;
     int i_packet_count = p_chain_ts->i_depth;
+    block_t *p_out = NULL;
 
     if ( i_pcr_length / 1000 > 0 )
     {
@@ -1811,14 +1838,67 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
         /* latency */
         p_ts->i_dts += p_sys->i_shaping_delay * 3 / 2;
 
-        sout_AccessOutWrite( p_mux->p_access, p_ts );
+        /* Gather the packets in larger blocks. A packet flagged for the
+         * segmenters always starts a block, so that the flag is kept. */
+        if( p_out != NULL &&
+            ( p_out->i_buffer >= (size_t)p_sys->i_block_packets * 188 ||
+              ( p_ts->i_flags & (BLOCK_FLAG_HEADER|BLOCK_FLAG_TYPE_I) ) ) )
+        {
+            sout_AccessOutWrite( p_mux->p_access, p_out );
+            p_out = NULL;
+        }
+        if( p_out == NULL )
+        {
+            p_out = block_Alloc( p_sys->i_block_packets * 188 );
+            if( unlikely(p_out == NULL) )
+            {
+                TSRelease( p_sys, p_ts );
+                continue;
+            }
+            p_out->i_buffer = 0;
+            p_out->i_flags  = 0;
+            p_out->i_dts    = p_ts->i_dts;
+            p_out->i_length = 0;
+        }
+
+        memcpy( &p_out->p_buffer[p_out->i_buffer], p_ts->p_buffer, 188 );
+        p_out->i_buffer += 188;
+        p_out->i_length += p_ts->i_length;
+        p_out->i_flags  |= p_ts->i_flags;
+        TSRelease( p_sys, p_ts );
     }
+
+    if( p_out != NULL )
+        sout_AccessOutWrite( p_mux->p_access, p_out );
+}
+
+/* TS packets are recycled once copied to the output, instead of allocating
+ * and freeing one block per packet */
+static block_t *TSAlloc( sout_mux_sys_t *p_sys )
+{
+    block_t *p_ts = p_sys->p_free_ts;
+
+    if( p_ts == NULL )
+        return block_Alloc( 188 );
+
+    p_sys->p_free_ts = p_ts->p_next;
+    p_ts->p_next   = NULL;
+    p_ts->i_flags  = 0;
+    p_ts->i_pts    = 0;
+    p_ts->i_dts    = 0;
+    p_ts->i_length = 0;
+    return p_ts;
+}
+
+static void TSRelease( sout_mux_sys_t *p_sys, block_t *p_ts )
+{
+    p_ts->p_next = p_sys->p_free_ts;
+    p_sys->p_free_ts = p_ts;
 }
 
 static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream,
                        bool b_pcr )
 {
-    VLC_UNUSED(p_mux);
     block_t *p_pes = p_stream->state.chain_pes.p_first;
 
     bool b_new_pes = false;
@@ -1838,7 +1918,7 @@ static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream,
         b_adaptation_field = true;
     }
 
-    block_t *p_ts = block_Alloc( 188 );
+    block_t *p_ts = TSAlloc( p_mux->p_sys );
 
     if (b_new_pes && !(p_pes->i_flags & BLOCK_FLAG_NO_KEYFRAME) && p_pes->i_flags & BLOCK_FLAG_TYPE_I)
     {
@@ -1931,20 +2011,74 @@ static void TSSetPCR( block_t *p_ts, vlc_tick_t i_dts )
     p_ts->p_buffer[11] = 0; /* we don't set PCR extension */
 }
 
+static tsmux_stream_t *PSIStream( sout_mux_sys_t *p_sys, uint16_t i_pid )
+{
+    if( i_pid == p_sys->pat.i_pid )
+        return &p_sys->pat;
+    if( i_pid == p_sys->sdt.ts.i_pid )
+        return &p_sys->sdt.ts;
+    for( unsigned i = 0; i < p_sys->i_num_pmt; i++ )
+        if( i_pid == p_sys->pmt[i].i_pid )
+            return &p_sys->pmt[i];
+    return NULL;
+}
+
+/* Appends copies of the cached PSI packets, continuing the continuity
+ * counter of their PID */
+static void PSICopy( sout_mux_sys_t *p_sys, const sout_buffer_chain_t *cache,
+                     sout_buffer_chain_t *c )
+{
+    for( const block_t *p_psi = cache->p_first; p_psi != NULL;
+         p_psi = p_psi->p_next )
+    {
+        block_t *p_ts = TSAlloc( p_sys );
+        if( unlikely(p_ts == NULL) )
+            break;
+        memcpy( p_ts->p_buffer, p_psi->p_buffer, 188 );
+
+        uint16_t i_pid = ( ( p_ts->p_buffer[1] & 0x1f ) << 8 ) | p_ts->p_buffer[2];
+        tsmux_stream_t *p_owner = PSIStream( p_sys, i_pid );
+        if( p_owner != NULL )
+        {
+            p_ts->p_buffer[3] = ( p_ts->p_buffer[3] & 0xf0 ) |
+                                p_owner->i_continuity_counter;
+            p_owner->i_continuity_counter =
+                ( p_owner->i_continuity_counter + 1 ) % 16;
+        }
+        BufferChainAppend( c, p_ts );
+    }
+}
+
 void GetPAT( sout_mux_t *p_mux, sout_buffer_chain_t *c )
 {
     sout_mux_sys_t       *p_sys = p_mux->p_sys;
 
-    BuildPAT( p_sys->p_dvbpsi,
-              c, (PEStoTSCallback)BufferChainAppend,
-              p_sys->i_tsid, p_sys->i_pat_version_number,
-              &p_sys->pat,
-              p_sys->i_num_pmt, p_sys->pmt, p_sys->i_pmt_program_number );
+    if( p_sys->psi_pat.i_depth == 0 )
+    {
+        /* The counter is set when the packets are copied */
+        uint8_t i_cc = p_sys->pat.i_continuity_counter;
+
+        BuildPAT( p_sys->p_dvbpsi,
+                  &p_sys->psi_pat, (PEStoTSCallback)BufferChainAppend,
+                  p_sys->i_tsid, p_sys->i_pat_version_number,
+                  &p_sys->pat,
+                  p_sys->i_num_pmt, p_sys->pmt, p_sys->i_pmt_program_number );
+        p_sys->pat.i_continuity_counter = i_cc;
+    }
+
+    PSICopy( p_sys, &p_sys->psi_pat, c );
 }
 
 static void GetPMT( sout_mux_t *p_mux, sout_buffer_chain_t *c )
 {
     sout_mux_sys_t *p_sys = p_mux->p_sys;
+
+    if( p_sys->psi_pmt.i_depth > 0 )
+    {
+        PSICopy( p_sys, &p_sys->psi_pmt, c );
+        return;
+    }
+
     pes_mapped_stream_t mapped[p_mux->i_nb_inputs];
 
     for (int i_stream = 0; i_stream < p_mux->i_nb_inputs; i_stream++ )
@@ -1963,11 +2097,23 @@ static void GetPMT( sout_mux_t *p_mux, sout_buffer_chain_t *c )
         mapped[i_stream].ts = &p_stream->ts;
     }
 
+    /* The counters are set when the packets are copied */
+    uint8_t pi_cc[MAX_PMT];
+    uint8_t i_sdt_cc = p_sys->sdt.ts.i_continuity_counter;
+    for (unsigned i = 0; i < p_sys->i_num_pmt; i++ )
+        pi_cc[i] = p_sys->pmt[i].i_continuity_counter;
+
     BuildPMT( p_sys->p_dvbpsi, VLC_OBJECT(p_mux), p_sys->standard,
-              c, (PEStoTSCallback)BufferChainAppend,
+              &p_sys->psi_pmt, (PEStoTSCallback)BufferChainAppend,
               p_sys->i_tsid, p_sys->i_pmt_version_number,
               ((sout_input_sys_t *)p_sys->p_pcr_input->p_sys)->ts.i_pid,
               &p_sys->sdt,
               p_sys->i_num_pmt, p_sys->pmt, p_sys->i_pmt_program_number,
               p_mux->i_nb_inputs, mapped );
+
+    p_sys->sdt.ts.i_continuity_counter = i_sdt_cc;
+    for (unsigned i = 0; i < p_sys->i_num_pmt; i++ )
+        p_sys->pmt[i].i_continuity_counter = pi_cc[i];
+
+    PSICopy( p_sys, &p_sys->psi_pmt, c );
 }
@@ -289,9 +289,20 @@ static int Mux( sout_mux_t *p_mux )
 
         /* Do the channel reordering */
         if( p_sys->i_chans_to_reorder )
+        {
+            /* The payload may be shared with other outputs */
+            if( !block_IsWritable( p_block ) )
+            {
+                block_t *p_copy = block_Duplicate( p_block );
+                block_Release( p_block );
+                if( unlikely(p_copy == NULL) )
+                    continue;
+                p_block = p_copy;
+            }
             aout_ChannelReorder( p_block->p_buffer, p_block->i_buffer,
                                  p_sys->i_chans_to_reorder,
                                  p_sys->pi_chan_table, p_input->p_fmt->i_codec );
+        }
 
         sout_AccessOutWrite( p_mux->p_access, p_block );
     }
@@ -113,6 +113,7 @@ struct decoder_sys_t
 
     /* Useful values of the Slice Header */
     h264_slice_t slice;
+    unsigned i_slice_first_mb; /* of the last slice of the current picture */
 
     /* */
     int i_next_block_flags;
@@ -158,6 +159,10 @@ static void PutSPS( decoder_t *p_dec, block_t *p_frag );
 static void PutPPS( decoder_t *p_dec, block_t *p_frag );
 static void PutSPSEXT( decoder_t *p_dec, block_t *p_frag );
 static bool ParseSliceHeader( decoder_t *p_dec, const block_t *p_frag, h264_slice_t *p_slice );
+static bool PeekSliceStart( const block_t *p_frag, unsigned *pi_first_mb,
+                            enum h264_slice_type_e *pi_type );
+static bool IsNextSliceOfPicture( const decoder_sys_t *p_sys, const block_t *p_frag,
+                                  unsigned i_first_mb );
 static bool ParseSeiCallback( const hxxx_sei_data_t *, void * );
 
 
@@ -655,6 +660,19 @@ static block_t *ParseNALBlock( decoder_t *p_dec, bool *pb_ts_used, block_t *p_fr
                 p_sys->i_recoveryfnum = UINT_MAX;
             }
 
+            /* Only the first slice of a picture needs a full header parse,
+             * the following ones are queued from their first fields */
+            unsigned i_first_mb = 0;
+            enum h264_slice_type_e i_type;
+            if( PeekSliceStart( p_frag, &i_first_mb, &i_type ) &&
+                IsNextSliceOfPicture( p_sys, p_frag, i_first_mb ) )
+            {
+                p_sys->slice.type = i_type;
+                p_sys->i_slice_first_mb = i_first_mb;
+                block_ChainLastAppend( &p_sys->frame.pp_append, p_frag );
+                break;
+            }
+
             if( ParseSliceHeader( p_dec, p_frag, &newslice ) )
             {
                 /* Only IDR carries the id, to be propagated */
@@ -679,6 +697,7 @@ static block_t *ParseNALBlock( decoder_t *p_dec, bool *pb_ts_used, block_t *p_fr
 
                 /* */
                 p_sys->slice = newslice;
+                p_sys->i_slice_first_mb = i_first_mb;
             }
             else
             {
@@ -1204,6 +1223,50 @@ static bool ParseSliceHeader( decoder_t *p_dec, const block_t *p_frag, h264_slic
     return true;
 }
 
+static bool PeekSliceStart( const block_t *p_frag, unsigned *pi_first_mb,
+                            enum h264_slice_type_e *pi_type )
+{
+    const uint8_t *p_stripped = p_frag->p_buffer;
+    size_t i_stripped = p_frag->i_buffer;
+
+    if( !hxxx_strip_AnnexB_startcode( &p_stripped, &i_stripped ) || i_stripped < 2 )
+        return false;
+
+    bs_t s;
+    unsigned i_bitflow = 0;
+    bs_init( &s, &p_stripped[1], i_stripped - 1 ); /* skip nal unit header */
+    s.p_fwpriv = &i_bitflow;
+    s.pf_forward = hxxx_bsfw_ep3b_to_rbsp;  /* Does the emulated 3bytes conversion to rbsp */
+
+    *pi_first_mb = bs_read_ue( &s );
+    *pi_type = bs_read_ue( &s ) % 5;
+
+    return !bs_eof( &s );
+}
+
+static bool IsNextSliceOfPicture( const decoder_sys_t *p_sys, const block_t *p_frag,
+                                  unsigned i_first_mb )
+{
+    /* Without arbitrary slice order (only allowed by baseline and
+     * extended profiles), slices of a picture come by increasing first
+     * macroblock and a new picture always starts on macroblock 0.
+     * A slice following the previous one can then only belong to the
+     * current picture, which requires the same nal_ref_idc and IDR type */
+    if( !p_sys->b_slice || !p_sys->p_active_sps || !p_sys->p_active_pps ||
+        p_sys->p_active_sps->i_profile == PROFILE_H264_BASELINE ||
+        p_sys->p_active_sps->i_profile == PROFILE_H264_EXTENDED )
+        return false;
+
+    const uint8_t i_nal_header = p_frag->p_buffer[4];
+    const int i_nal_type = i_nal_header & 0x1f;
+    if( ( i_nal_type != H264_NAL_SLICE && i_nal_type != H264_NAL_SLICE_IDR ) ||
+        i_nal_type != p_sys->slice.i_nal_type ||
+        ( (i_nal_header >> 5) & 0x03 ) != p_sys->slice.i_nal_ref_idc )
+        return false;
+
+    return i_first_mb > p_sys->i_slice_first_mb;
+}
+
 static bool ParseSeiCallback( const hxxx_sei_data_t *p_sei_data, void *cbdata )
 {
     decoder_t *p_dec = (decoder_t *) cbdata;
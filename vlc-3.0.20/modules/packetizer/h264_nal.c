@@ -627,21 +627,27 @@ void h264_release_sps_extension( h264_sequence_parameter_set_extension_t *p_sps_
         h264type *p_h264type = calloc(1, sizeof(h264type)); \
         if(likely(p_h264type)) \
         { \
-            bs_t bs; \
-            bs_init( &bs, p_buf, i_buf ); \
-            unsigned i_bitflow = 0; \
+            uint8_t *p_rbsp = NULL; \
             if( b_escaped ) \
             { \
-                bs.p_fwpriv = &i_bitflow; \
-                bs.pf_forward = hxxx_bsfw_ep3b_to_rbsp;  /* Does the emulated 3bytes conversion to rbsp */ \
+                /* Strip emulation prevention 3bytes once, then read plain */ \
+                p_rbsp = hxxx_ep3b_to_rbsp( p_buf, i_buf, &i_buf ); \
+                if( !p_rbsp ) \
+                { \
+                    free( p_h264type ); \
+                    return NULL; \
+                } \
+                p_buf = p_rbsp; \
             } \
-            else (void) i_bitflow;\
+            bs_t bs; \
+            bs_init( &bs, p_buf, i_buf ); \
             bs_skip( &bs, 8 ); /* Skip nal_unit_header */ \
             if( !decode( &bs, p_h264type ) ) \
             { \
                 release( p_h264type ); \
                 p_h264type = NULL; \
             } \
+            free( p_rbsp ); \
         } \
         return p_h264type; \
     }
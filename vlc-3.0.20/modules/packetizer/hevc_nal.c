@@ -696,15 +696,20 @@ void hevc_rbsp_release_vps( hevc_video_parameter_set_t *p_vps )
         hevctype *p_hevctype = calloc(1, sizeof(hevctype)); \
         if(likely(p_hevctype)) \
         { \
-            bs_t bs; \
-            bs_init( &bs, p_buf, i_buf ); \
-            unsigned i_bitflow = 0; \
+            uint8_t *p_rbsp = NULL; \
             if( b_escaped ) \
             { \
-                bs.p_fwpriv = &i_bitflow; \
-                bs.pf_forward = hxxx_bsfw_ep3b_to_rbsp;  /* Does the emulated 3bytes conversion to rbsp */ \
+                /* Strip emulation prevention 3bytes once, then read plain */ \
+                p_rbsp = hxxx_ep3b_to_rbsp( p_buf, i_buf, &i_buf ); \
+                if( !p_rbsp ) \
+                { \
+                    free( p_hevctype ); \
+                    return NULL; \
+                } \
+                p_buf = p_rbsp; \
             } \
-            else (void) i_bitflow;\
+            bs_t bs; \
+            bs_init( &bs, p_buf, i_buf ); \
             bs_skip( &bs, 7 ); /* nal_unit_header */ \
             uint8_t i_nuh_layer_id = bs_read( &bs, 6 ); \
             bs_skip( &bs, 3 ); /* !nal_unit_header */ \
@@ -713,6 +718,7 @@ void hevc_rbsp_release_vps( hevc_video_parameter_set_t *p_vps )
                 release( p_hevctype ); \
                 p_hevctype = NULL; \
             } \
+            free( p_rbsp ); \
         } \
         return p_hevctype; \
     }
@@ -24,6 +24,7 @@
 #include <vlc_common.h>
 #include <vlc_block.h>
 #include <vlc_codec.h>
+#include <vlc_atomic.h>
 
 #include "hxxx_common.h"
 #include "../codec/cc.h"
@@ -105,6 +106,60 @@ block_t * cc_storage_get_current( cc_storage_t *p_ccs, decoder_cc_desc_t *p_desc
     return p_block;
 }
 
+/****************************************************************************
+ * NAL views: large NALs are not copied out of the xxC1 input block, but
+ * handed over as blocks pointing into it. The input block is released
+ * with the last view, and only the access unit gathering copies the data.
+ * Small NALs (parameter sets, SEI) are still copied, as the packetizers
+ * may keep them around for a long time.
+ ****************************************************************************/
+#define HXXX_NAL_VIEW_MIN_SIZE 4096
+
+typedef struct
+{
+    block_t *p_block;
+    atomic_uint i_refs;
+} hxxx_nal_source_t;
+
+typedef struct
+{
+    block_t self;
+    hxxx_nal_source_t *p_source;
+} hxxx_nal_view_t;
+
+static void hxxx_nal_source_Release( hxxx_nal_source_t *p_source )
+{
+    if( atomic_fetch_sub( &p_source->i_refs, 1 ) == 1 )
+    {
+        block_Release( p_source->p_block );
+        free( p_source );
+    }
+}
+
+static void hxxx_nal_view_Release( block_t *p_block )
+{
+    hxxx_nal_view_t *p_view = container_of( p_block, hxxx_nal_view_t, self );
+    hxxx_nal_source_Release( p_view->p_source );
+    free( p_view );
+}
+
+static block_t *hxxx_nal_view_New( hxxx_nal_source_t *p_source,
+                                   uint8_t *p_buf, size_t i_buf )
+{
+    hxxx_nal_view_t *p_view = malloc( sizeof(*p_view) );
+    if( !p_view )
+        return NULL;
+    /* p_start/i_size span the NAL only, so that reallocations never
+     * touch the neighbouring ones */
+    block_Init( &p_view->self, p_buf, i_buf );
+    p_view->self.pf_release = hxxx_nal_view_Release;
+    p_view->self.i_dts = p_source->p_block->i_dts;
+    p_view->self.i_pts = p_source->p_block->i_pts;
+    p_view->p_source = p_source;
+    atomic_fetch_add( &p_source->i_refs, 1 );
+    return &p_view->self;
+}
+
 /****************************************************************************
  * PacketizeXXC1: Takes VCL blocks of data and creates annexe B type NAL stream
  * Will always use 4 byte 0 0 0 1 startcodes
@@ -115,6 +170,7 @@ block_t *PacketizeXXC1( decoder_t *p_dec, uint8_t i_nal_length_size,
 {
     block_t       *p_block;
     block_t       *p_ret = NULL;
+    hxxx_nal_source_t *p_source = NULL;
     uint8_t       *p;
 
     if( !pp_block || !*pp_block )
@@ -150,9 +206,25 @@ block_t *PacketizeXXC1( decoder_t *p_dec, uint8_t i_nal_length_size,
         }
 
         /* Convert AVC to AnnexB */
-        block_t *p_nal;
+        block_t *p_nal = NULL;
+        /* Startcode can overwrite the length field in place */
+        if( i_nal_length_size == 4 && i_size >= HXXX_NAL_VIEW_MIN_SIZE )
+        {
+            if( !p_source && (p_source = malloc( sizeof(*p_source) )) )
+            {
+                p_source->p_block = p_block;
+                atomic_init( &p_source->i_refs, 1 );
+            }
+            if( p_source )
+                p_nal = hxxx_nal_view_New( p_source, p - 4, 4 + i_size );
+        }
+
+        if( p_nal )
+        {
+            p += i_size;
+        }
         /* If data exactly match remaining bytes (1 NAL only or trailing one) */
-        if( i_size == p_block->p_buffer + p_block->i_buffer - p )
+        else if( !p_source && i_size == p_block->p_buffer + p_block->i_buffer - p )
         {
             p_block->i_buffer = i_size;
             p_block->p_buffer = p;
@@ -193,7 +265,9 @@ block_t *PacketizeXXC1( decoder_t *p_dec, uint8_t i_nal_length_size,
             break;
     }
 
-    if( p_block )
+    if( p_source )
+        hxxx_nal_source_Release( p_source );
+    else if( p_block )
         block_Release( p_block );
 
     return p_ret;
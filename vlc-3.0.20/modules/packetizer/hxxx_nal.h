@@ -228,29 +228,35 @@ static inline uint8_t *hxxx_bsfw_ep3b_to_rbsp( uint8_t *p, uint8_t *end, void *p
     return p;
 }
 
-#if 0
-/* Discards emulation prevention three bytes */
+/* Discards emulation prevention three bytes, with the same rules as the
+ * forward callback above: the first byte is not part of any sequence, and
+ * a trailing 0x03 is kept. The returned buffer must be freed. */
 static inline uint8_t * hxxx_ep3b_to_rbsp(const uint8_t *p_src, size_t i_src, size_t *pi_ret)
 {
     uint8_t *p_dst;
-    if(!p_src || !(p_dst = malloc(i_src)))
+    if(!p_src || !(p_dst = malloc(i_src ? i_src : 1)))
         return NULL;
 
-    size_t j = 0;
-    for (size_t i = 0; i < i_src; i++) {
-        if (i < i_src - 3 &&
-            p_src[i] == 0 && p_src[i+1] == 0 && p_src[i+2] == 3) {
-            p_dst[j++] = 0;
-            p_dst[j++] = 0;
-            i += 2;
-            continue;
+    size_t i_dst = 0;
+    const uint8_t *p = p_src;
+    const uint8_t *end = p_src + i_src;
+    const uint8_t *p_ep3b = p;
+
+    while( (p_ep3b = memchr(p_ep3b, 0x03, end - p_ep3b)) != NULL )
+    {
+        if( p_ep3b - p_src >= 3 && p_ep3b + 1 < end &&
+            p_ep3b[-1] == 0 && p_ep3b[-2] == 0 )
+        {
+            memcpy( &p_dst[i_dst], p, p_ep3b - p );
+            i_dst += p_ep3b - p;
+            p = p_ep3b + 1;
         }
-        p_dst[j++] = p_src[i];
+        p_ep3b++;
     }
-    *pi_ret = j;
+    memcpy( &p_dst[i_dst], p, end - p );
+    *pi_ret = i_dst + (end - p);
     return p_dst;
 }
-#endif
 
 /* Declarations */
 
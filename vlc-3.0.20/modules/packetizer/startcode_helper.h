@@ -25,6 +25,13 @@
 #if !defined(CAN_COMPILE_SSE2) && defined(HAVE_SSE2_INTRINSICS)
    #include <emmintrin.h>
 #endif
+#ifdef HAVE_AVX2_INTRINSICS
+   #include <immintrin.h>
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+   #include <arm_neon.h>
+   #define HAVE_STARTCODE_NEON
+#endif
 
 /* Looks up efficiently for an AnnexB startcode 0x00 0x00 0x01
  * by using a 4 times faster trick than single byte lookup. */
@@ -57,7 +64,7 @@ static inline const uint8_t * startcode_FindAnnexB_SSE2( const uint8_t *p, const
             return p;
     }
 
-    if( p == end )
+    if( p > end )
         return NULL;
 
     alignedend = end - ((intptr_t) end & 15);
@@ -109,16 +116,80 @@ static inline const uint8_t * startcode_FindAnnexB_SSE2( const uint8_t *p, const
 
 #endif
 
+#ifdef HAVE_AVX2_INTRINSICS
+
+/* Compares the buffer and its next two bytes shifted copies at once,
+ * which gives exact matches without any scalar confirmation */
+__attribute__ ((__target__ ("avx2")))
+static inline const uint8_t * startcode_FindAnnexB_AVX2( const uint8_t *p, const uint8_t *end )
+{
+    const __m256i zeros = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi8( 0x01 );
+
+    /* last loaded byte is p[33] */
+    for( ; end - p >= 34; p += 32 )
+    {
+        __m256i v0 = _mm256_loadu_si256( (const __m256i *) &p[0] );
+        __m256i v1 = _mm256_loadu_si256( (const __m256i *) &p[1] );
+        __m256i v2 = _mm256_loadu_si256( (const __m256i *) &p[2] );
+        __m256i res = _mm256_and_si256( _mm256_cmpeq_epi8( v0, zeros ),
+                      _mm256_and_si256( _mm256_cmpeq_epi8( v1, zeros ),
+                                        _mm256_cmpeq_epi8( v2, ones ) ) );
+        uint32_t match = _mm256_movemask_epi8( res );
+        if( match )
+            return p + ctz( match );
+    }
+
+    for (end -= 3; p <= end; p++) {
+        if (p[0] == 0 && p[1] == 0 && p[2] == 1)
+            return p;
+    }
+
+    return NULL;
+}
+
+#endif
+
+#ifdef HAVE_STARTCODE_NEON
+
+/* Same as the AVX2 version, 16 bytes at a time */
+static inline const uint8_t * startcode_FindAnnexB_NEON( const uint8_t *p, const uint8_t *end )
+{
+    const uint8x16_t zeros = vdupq_n_u8( 0x00 );
+    const uint8x16_t ones = vdupq_n_u8( 0x01 );
+
+    /* last loaded byte is p[17] */
+    for( ; end - p >= 18; p += 16 )
+    {
+        uint8x16_t res = vandq_u8( vceqq_u8( vld1q_u8( &p[0] ), zeros ),
+                         vandq_u8( vceqq_u8( vld1q_u8( &p[1] ), zeros ),
+                                   vceqq_u8( vld1q_u8( &p[2] ), ones ) ) );
+        /* narrow to 4 bits per byte, in reversed match order */
+        uint64_t match = vget_lane_u64( vreinterpret_u64_u8(
+                            vshrn_n_u16( vreinterpretq_u16_u8( res ), 4 ) ), 0 );
+        if( match )
+        {
+            unsigned lo = match;
+            return p + ( ( lo ? ctz( lo ) : 32 + ctz( match >> 32 ) ) >> 2 );
+        }
+    }
+
+    for (end -= 3; p <= end; p++) {
+        if (p[0] == 0 && p[1] == 0 && p[2] == 1)
+            return p;
+    }
+
+    return NULL;
+}
+
+#endif
+
 /* That code is adapted from libav's ff_avc_find_startcode_internal
  * and i believe the trick originated from
  * https://graphics.stanford.edu/~seander/bithacks.html#ZeroInWord
  */
-static inline const uint8_t * startcode_FindAnnexB( const uint8_t *p, const uint8_t *end )
+static inline const uint8_t * startcode_FindAnnexB_Bits( const uint8_t *p, const uint8_t *end )
 {
-#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
-    if (vlc_CPU_SSE2())
-        return startcode_FindAnnexB_SSE2(p, end);
-#endif
     const uint8_t *a = p + 4 - ((intptr_t)p & 3);
 
     for (end -= 3; p < a && p <= end; p++) {
@@ -143,6 +214,23 @@ static inline const uint8_t * startcode_FindAnnexB( const uint8_t *p, const uint
     return NULL;
 }
 
+static inline const uint8_t * startcode_FindAnnexB( const uint8_t *p, const uint8_t *end )
+{
+#ifdef HAVE_AVX2_INTRINSICS
+    if (vlc_CPU_AVX2())
+        return startcode_FindAnnexB_AVX2(p, end);
+#endif
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+    if (vlc_CPU_SSE2())
+        return startcode_FindAnnexB_SSE2(p, end);
+#endif
+#ifdef HAVE_STARTCODE_NEON
+    if (vlc_CPU_ARM64_NEON())
+        return startcode_FindAnnexB_NEON(p, end);
+#endif
+    return startcode_FindAnnexB_Bits(p, end);
+}
+
 #undef TRY_MATCH
 
 #endif
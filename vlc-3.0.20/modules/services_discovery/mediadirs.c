@@ -183,15 +183,30 @@ static void *Run( void *data )
     services_discovery_sys_t *p_sys = p_sd->p_sys;
 
     int num_dir = sizeof( p_sys->psz_dir ) / sizeof( p_sys->psz_dir[0] );
+    struct stat st_dir[sizeof( p_sys->psz_dir ) / sizeof( p_sys->psz_dir[0] )];
     for( int i = 0; i < num_dir; i++ )
     {
         char* psz_dir = p_sys->psz_dir[i];
 
         /* make sure the directory exists */
-        struct stat st;
+        struct stat *p_st = &st_dir[i];
+        p_st->st_mode = 0;
         if( psz_dir == NULL            ||
-            vlc_stat( psz_dir, &st )  ||
-            !S_ISDIR( st.st_mode ) )
+            vlc_stat( psz_dir, p_st )  ||
+            !S_ISDIR( p_st->st_mode ) )
+        {
+            p_st->st_mode = 0;
+            continue;
+        }
+
+        /* the record and snapshot paths often point to the user directory:
+         * do not scan the same directory twice */
+        bool b_scanned = false;
+        for( int j = 0; j < i && !b_scanned; j++ )
+            b_scanned = S_ISDIR( st_dir[j].st_mode ) &&
+                        st_dir[j].st_dev == p_st->st_dev &&
+                        st_dir[j].st_ino == p_st->st_ino;
+        if( b_scanned )
             continue;
 
         char* psz_uri = vlc_path2uri( psz_dir, "file" );
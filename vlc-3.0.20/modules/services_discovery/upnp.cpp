@@ -39,6 +39,7 @@
 #include <assert.h>
 #include <limits.h>
 #include <algorithm>
+#include <map>
 #include <set>
 #include <string>
 
@@ -71,6 +72,11 @@ static IXML_Document* UpnpActionComplete_get_ActionResult( const UpnpActionCompl
 */
 const char* MEDIA_SERVER_DEVICE_TYPE = "urn:schemas-upnp-org:device:MediaServer:1";
 const char* CONTENT_DIRECTORY_SERVICE_TYPE = "urn:schemas-upnp-org:service:ContentDirectory:1";
+
+/* Number of Browse requests sent concurrently when paging */
+#define BROWSE_MAX_PENDING 4
+/* Number of directories kept in the browse cache */
+#define BROWSE_CACHE_SIZE 64
 const char* SATIP_SERVER_DEVICE_TYPE = "urn:ses-com:device:SatIPServer:1";
 
 #define SATIP_CHANNEL_LIST N_("SAT>IP channel list")
@@ -168,19 +174,11 @@ const char* xml_getChildElementValue( IXML_Element* p_parent,
 }
 
 /*
- * Extracts the result document from a SOAP response
+ * Parses the DIDL document extracted from a SOAP response
  */
-IXML_Document* parseBrowseResult( IXML_Document* p_doc )
+IXML_Document* parseBrowseResult( const char* psz_raw_didl )
 {
-    assert( p_doc );
-
-    // ixml*_getElementsByTagName will ultimately only case the pointer to a Node
-    // pointer, and pass it to a private function. Don't bother have a IXML_Document
-    // version of getChildElementValue
-    const char* psz_raw_didl = xml_getChildElementValue( (IXML_Element*)p_doc, "Result" );
-
-    if( !psz_raw_didl )
-        return NULL;
+    assert( psz_raw_didl );
 
     /* First, try parsing the buffer as is */
     IXML_Document* p_result_doc = ixmlParseBuffer( psz_raw_didl );
@@ -1130,31 +1128,93 @@ int MediaServer::sendActionCb( Upnp_EventType eventType,
 {
     if( eventType != UPNP_CONTROL_ACTION_COMPLETE )
         return 0;
-    IXML_Document** pp_sendActionResult = (IXML_Document** )p_cookie;
+    BrowseResponse* p_response = (BrowseResponse* )p_cookie;
+    const UpnpActionComplete *p_result = (const UpnpActionComplete *)p_event;
+
+    /* Only keep the values we need, rather than duplicating the whole
+     * response document, which embeds the (escaped) DIDL document */
+    IXML_Element* p_doc = (IXML_Element* )
+            UpnpActionComplete_get_ActionResult( p_result );
+    if ( p_doc == NULL )
+        return 0;
+
+    const char* psz_didl = xml_getChildElementValue( p_doc, "Result" );
+    if ( psz_didl == NULL )
+        return 0;
+    const char* psz_total = xml_getChildElementValue( p_doc, "TotalMatches" );
+    const char* psz_returned = xml_getChildElementValue( p_doc, "NumberReturned" );
+
+    p_response->didl = psz_didl;
+    p_response->total = psz_total ? strtol( psz_total, NULL, 10 ) : 0;
+    p_response->returned = psz_returned ? strtol( psz_returned, NULL, 10 ) : 0;
+    p_response->received = true;
+    return 0;
+}
+
+int MediaServer::updateIdCb( Upnp_EventType eventType,
+                             UpnpEventPtr p_event, void *p_cookie )
+{
+    if( eventType != UPNP_CONTROL_ACTION_COMPLETE )
+        return 0;
+    std::string* p_id = (std::string* )p_cookie;
     const UpnpActionComplete *p_result = (const UpnpActionComplete *)p_event;
 
-    /* The only way to dup the result is to print it and parse it again */
-    DOMString tmpStr = ixmlPrintNode( ( IXML_Node * ) UpnpActionComplete_get_ActionResult( p_result ) );
-    if (tmpStr == NULL)
+    IXML_Element* p_doc = (IXML_Element* )
+            UpnpActionComplete_get_ActionResult( p_result );
+    if ( p_doc == NULL )
         return 0;
 
-    *pp_sendActionResult = ixmlParseBuffer( tmpStr );
-    ixmlFreeDOMString( tmpStr );
+    const char* psz_id = xml_getChildElementValue( p_doc, "Id" );
+    if ( psz_id != NULL )
+        *p_id = psz_id;
     return 0;
 }
 
 /* Access part */
-IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
-                                           const char* psz_browser_flag_,
-                                           const char* psz_filter_,
-                                           const char* psz_starting_index,
-                                           const char* psz_requested_count_,
-                                           const char* psz_sort_criteria_ )
+
+/*
+ * Sends an action to the content directory without waiting for the reply.
+ * The callback is called with the cookie once the reply is received, and the
+ * returned object must be released with waitAndRelease().
+ */
+Upnp_i11e_cb* MediaServer::_sendAction( IXML_Document* p_action,
+                                        Upnp_FunPtr callback, void *p_cookie )
+{
+    access_sys_t *sys = (access_sys_t *)m_access->p_sys;
+
+    /* Setup an interruptible callback that will call the callback if not
+     * interrupted by vlc_interrupt_kill */
+    Upnp_i11e_cb *i11eCb = new Upnp_i11e_cb( callback, p_cookie );
+    int i_res = UpnpSendActionAsync( sys->p_upnp->handle(),
+              m_psz_root,
+              CONTENT_DIRECTORY_SERVICE_TYPE,
+              NULL, /* ignored in SDK, must be NULL */
+              p_action,
+              Upnp_i11e_cb::run, i11eCb );
+
+    if ( i_res != UPNP_E_SUCCESS )
+    {
+        msg_Err( m_access, "%s when trying the send() action with URL: %s",
+                UpnpGetErrorMessage( i_res ), m_access->psz_location );
+        /* The callback will never be called */
+        delete i11eCb;
+        return NULL;
+    }
+    return i11eCb;
+}
+
+Upnp_i11e_cb* MediaServer::_browseAction( const char* psz_object_id_,
+                                          const char* psz_browser_flag_,
+                                          const char* psz_filter_,
+                                          long i_starting_index,
+                                          long i_requested_count,
+                                          const char* psz_sort_criteria_,
+                                          BrowseResponse* p_response )
 {
     IXML_Document* p_action = NULL;
-    IXML_Document* p_response = NULL;
     Upnp_i11e_cb *i11eCb = NULL;
-    access_sys_t *sys = (access_sys_t *)m_access->p_sys;
+    std::string starting_index = std::to_string( i_starting_index );
+    std::string requested_count = std::to_string( i_requested_count );
 
     int i_res;
 
@@ -1192,7 +1252,7 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
     }
 
     i_res = UpnpAddToAction( &p_action, "Browse",
-            CONTENT_DIRECTORY_SERVICE_TYPE, "StartingIndex", psz_starting_index );
+            CONTENT_DIRECTORY_SERVICE_TYPE, "StartingIndex", starting_index.c_str() );
     if ( i_res != UPNP_E_SUCCESS )
     {
         msg_Dbg( m_access, "AddToAction 'StartingIndex' failed: %s",
@@ -1201,7 +1261,7 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
     }
 
     i_res = UpnpAddToAction( &p_action, "Browse",
-            CONTENT_DIRECTORY_SERVICE_TYPE, "RequestedCount", psz_requested_count_ );
+            CONTENT_DIRECTORY_SERVICE_TYPE, "RequestedCount", requested_count.c_str() );
 
     if ( i_res != UPNP_E_SUCCESS )
     {
@@ -1220,99 +1280,190 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
         goto browseActionCleanup;
     }
 
-    /* Setup an interruptible callback that will call sendActionCb if not
-     * interrupted by vlc_interrupt_kill */
-    i11eCb = new Upnp_i11e_cb( sendActionCb, &p_response );
-    i_res = UpnpSendActionAsync( sys->p_upnp->handle(),
-              m_psz_root,
-              CONTENT_DIRECTORY_SERVICE_TYPE,
-              NULL, /* ignored in SDK, must be NULL */
-              p_action,
-              Upnp_i11e_cb::run, i11eCb );
+    i11eCb = _sendAction( p_action, sendActionCb, p_response );
 
-    if ( i_res != UPNP_E_SUCCESS )
+browseActionCleanup:
+    ixmlDocument_free( p_action );
+    return i11eCb;
+}
+
+/*
+ * Returns the SystemUpdateID of the server, or an empty string if unknown
+ */
+std::string MediaServer::_getSystemUpdateId()
+{
+    std::string id;
+
+    if ( vlc_killed() )
+        return id;
+
+    IXML_Document* p_action = UpnpMakeAction( "GetSystemUpdateID",
+                                              CONTENT_DIRECTORY_SERVICE_TYPE,
+                                              0, NULL );
+    if ( p_action == NULL )
+        return id;
+
+    Upnp_i11e_cb *i11eCb = _sendAction( p_action, updateIdCb, &id );
+    if ( i11eCb != NULL )
+        i11eCb->waitAndRelease();
+    ixmlDocument_free( p_action );
+    return id;
+}
+
+/*
+ * Adds the containers and items of a DIDL document
+ */
+bool MediaServer::addContents( const std::string& didl )
+{
+    IXML_Document* p_result = parseBrowseResult( didl.c_str() );
+    if ( !p_result )
     {
-        msg_Err( m_access, "%s when trying the send() action with URL: %s",
-                UpnpGetErrorMessage( i_res ), m_access->psz_location );
+        msg_Err( m_access, "browse() response parsing failed" );
+        return false;
     }
-    /* Wait for the callback to fill p_response or wait for an interrupt */
-    i11eCb->waitAndRelease();
 
-browseActionCleanup:
-    ixmlDocument_free( p_action );
-    return p_response;
+    IXML_NodeList* containerNodeList =
+    ixmlDocument_getElementsByTagName( p_result, "container" );
+
+    if ( containerNodeList )
+    {
+        for ( unsigned int i = 0; i < ixmlNodeList_length( containerNodeList ); i++)
+            addContainer( (IXML_Element*)ixmlNodeList_item( containerNodeList, i ) );
+        ixmlNodeList_free( containerNodeList );
+    }
+
+    IXML_NodeList* itemNodeList = ixmlDocument_getElementsByTagName( p_result,
+                                                                    "item" );
+    if ( itemNodeList )
+    {
+        for ( unsigned int i = 0; i < ixmlNodeList_length( itemNodeList ); i++)
+            addItem( (IXML_Element*)ixmlNodeList_item( itemNodeList, i ) );
+        ixmlNodeList_free( itemNodeList );
+    }
+
+    ixmlDocument_free( p_result );
+    return true;
 }
 
+/*
+ * Directories browsed during this session, keyed by control URL and object
+ * ID, and valid as long as the server SystemUpdateID does not change
+ */
+struct BrowseCacheEntry
+{
+    std::string updateId;
+    std::vector<std::string> pages;
+};
+
+static vlc_mutex_t browse_cache_lock = VLC_STATIC_MUTEX;
+static std::map<std::string, BrowseCacheEntry> browse_cache;
+
 /*
  * Fetches and parses the UPNP response
  */
 bool MediaServer::fetchContents()
 {
-    std::string StartingIndex = "0";
-    std::string RequestedCount = "5000";
-    const char* psz_TotalMatches = "0";
-    const char* psz_NumberReturned = "0";
-    long  l_reqCount = 0;
+    std::string key = std::string( m_psz_root ) + "#" +
+                      ( m_psz_objectId ? m_psz_objectId : "0" );
+    std::string updateId = _getSystemUpdateId();
+    BrowseCacheEntry entry;
 
-    do
+    if ( !updateId.empty() )
     {
-        IXML_Document* p_response = _browseAction( m_psz_objectId,
-                                                  "BrowseDirectChildren",
-                                                  "*",
-                                                  StartingIndex.c_str(),
-                                                  // Some servers don't understand "0" as "no-limit"
-                                                  RequestedCount.c_str(), /* RequestedCount */
-                                                  "" /* SortCriteria */
-                                                  );
-        if ( !p_response )
+        vlc_mutex_lock( &browse_cache_lock );
+        std::map<std::string, BrowseCacheEntry>::const_iterator it =
+            browse_cache.find( key );
+        if ( it != browse_cache.end() && it->second.updateId == updateId )
+            entry = it->second;
+        vlc_mutex_unlock( &browse_cache_lock );
+
+        if ( !entry.pages.empty() )
         {
-            msg_Err( m_access, "No response from browse() action" );
-            return false;
+            msg_Dbg( m_access, "using cached contents (SystemUpdateID %s)",
+                     updateId.c_str() );
+            for ( size_t i = 0; i < entry.pages.size(); i++ )
+                if ( !addContents( entry.pages[i] ) )
+                    return false;
+            return true;
         }
+    }
 
-        psz_TotalMatches = xml_getChildElementValue( (IXML_Element*)p_response, "TotalMatches" );
-        psz_NumberReturned = xml_getChildElementValue( (IXML_Element*)p_response, "NumberReturned" );
-
-        StartingIndex = std::to_string(  std::stol(psz_NumberReturned) + std::stol(StartingIndex) );
-        l_reqCount = std::stol(psz_TotalMatches) - std::stol(StartingIndex) ;
-        RequestedCount = std::to_string(l_reqCount);
-
-        IXML_Document* p_result = parseBrowseResult( p_response );
+    /* The first page tells how many entries the server returns per request,
+     * the following pages are then requested concurrently */
+    long i_start = 0;
+    long i_total = 1;
+    long i_page = 5000; // Some servers don't understand "0" as "no-limit"
 
-        ixmlDocument_free( p_response );
+    while ( i_start < i_total )
+    {
+        BrowseResponse responses[BROWSE_MAX_PENDING];
+        Upnp_i11e_cb* callbacks[BROWSE_MAX_PENDING];
+        int i_pending = 1;
 
-        if ( !p_result )
+        if ( i_start > 0 )
         {
-            msg_Err( m_access, "browse() response parsing failed" );
-            return false;
+            long i_pages = ( i_total - i_start + i_page - 1 ) / i_page;
+            if ( i_pages < BROWSE_MAX_PENDING )
+                i_pending = i_pages;
+            else
+                i_pending = BROWSE_MAX_PENDING;
         }
 
-#ifndef NDEBUG
-        msg_Dbg( m_access, "Got DIDL document: %s", ixmlPrintDocument( p_result ) );
-#endif
-
-        IXML_NodeList* containerNodeList =
-        ixmlDocument_getElementsByTagName( p_result, "container" );
-
-        if ( containerNodeList )
+        for ( int i = 0; i < i_pending; i++ )
+            callbacks[i] = _browseAction( m_psz_objectId,
+                                          "BrowseDirectChildren",
+                                          "*",
+                                          i_start + i * i_page,
+                                          i_page,
+                                          "" /* SortCriteria */,
+                                          &responses[i] );
+        for ( int i = 0; i < i_pending; i++ )
+            if ( callbacks[i] )
+                callbacks[i]->waitAndRelease();
+
+        if ( !callbacks[0] || !responses[0].received )
         {
-            for ( unsigned int i = 0; i < ixmlNodeList_length( containerNodeList ); i++)
-                addContainer( (IXML_Element*)ixmlNodeList_item( containerNodeList, i ) );
-            ixmlNodeList_free( containerNodeList );
+            msg_Err( m_access, "No response from browse() action" );
+            return false;
         }
 
-        IXML_NodeList* itemNodeList = ixmlDocument_getElementsByTagName( p_result,
-                                                                        "item" );
-        if ( itemNodeList )
+        for ( int i = 0; i < i_pending; i++ )
         {
-            for ( unsigned int i = 0; i < ixmlNodeList_length( itemNodeList ); i++)
-                addItem( (IXML_Element*)ixmlNodeList_item( itemNodeList, i ) );
-            ixmlNodeList_free( itemNodeList );
+            const BrowseResponse& response = responses[i];
+            if ( !callbacks[i] || !response.received )
+                break; /* request it again from the next loop */
+
+            if ( !addContents( response.didl ) )
+                return false;
+            entry.pages.push_back( response.didl );
+
+            if ( i_start == 0 )
+                i_page = response.returned;
+            i_total = response.total;
+            i_start += response.returned;
+            /* On a short page, the next requests are misaligned: resume
+             * from the first missing entry */
+            if ( response.returned < i_page )
+                break;
         }
 
-        ixmlDocument_free( p_result );
+        if ( responses[0].returned <= 0 )
+            break;
+    }
+
+    msg_Dbg( m_access, "got %ld entries in %zu pages", i_start,
+             entry.pages.size() );
+
+    if ( !updateId.empty() )
+    {
+        entry.updateId = updateId;
+        vlc_mutex_lock( &browse_cache_lock );
+        if ( browse_cache.size() >= BROWSE_CACHE_SIZE &&
+             browse_cache.find( key ) == browse_cache.end() )
+            browse_cache.erase( browse_cache.begin() );
+        browse_cache[key] = entry;
+        vlc_mutex_unlock( &browse_cache_lock );
     }
-    while( l_reqCount );
     return true;
 }
 
@@ -143,6 +143,16 @@ private:
     void*           m_cookie;
 };
 
+/* Content of a Browse action response */
+struct BrowseResponse
+{
+    BrowseResponse() : total( 0 ), returned( 0 ), received( false ) {}
+    std::string didl;
+    long total;
+    long returned;
+    bool received;
+};
+
 class MediaServer
 {
 public:
@@ -156,10 +166,14 @@ private:
 
     bool addContainer( IXML_Element* containerElement );
     bool addItem( IXML_Element* itemElement );
+    bool addContents( const std::string& didl );
 
-    IXML_Document* _browseAction(const char*, const char*, const char*,
-            const char*, const char*, const char* );
+    Upnp_i11e_cb* _sendAction( IXML_Document*, Upnp_FunPtr, void * );
+    Upnp_i11e_cb* _browseAction(const char*, const char*, const char*,
+            long, long, const char*, BrowseResponse* );
+    std::string _getSystemUpdateId();
     static int sendActionCb( Upnp_EventType, UpnpEventPtr, void *);
+    static int updateIdCb( Upnp_EventType, UpnpEventPtr, void *);
 
 private:
     char* m_psz_root;
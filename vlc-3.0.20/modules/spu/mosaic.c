@@ -52,6 +52,18 @@ static subpicture_t *Filter ( filter_t *, vlc_tick_t );
 static int MosaicCallback   ( vlc_object_t *, char const *, vlc_value_t,
                               vlc_value_t, void * );
 
+/*****************************************************************************
+ * mosaic_tile_t : converted picture of a bridged ES
+ *****************************************************************************/
+typedef struct
+{
+    const bridged_es_t *p_es; /* Bridged ES of the tile */
+    picture_t *p_source;      /* Picture the tile was converted from */
+    picture_t *p_picture;     /* Converted picture */
+    image_handler_t *p_image; /* Converter, kept across pictures of the ES */
+    bool b_used;              /* Whether the ES was seen by the last Filter */
+} mosaic_tile_t;
+
 /*****************************************************************************
  * filter_sys_t : filter descriptor
  *****************************************************************************/
@@ -59,7 +71,8 @@ struct filter_sys_t
 {
     vlc_mutex_t lock;         /* Internal filter lock */
 
-    image_handler_t *p_image;
+    mosaic_tile_t *p_tiles;   /* Converted pictures, by bridged ES */
+    int i_tiles;
 
     int i_position;           /* Mosaic positioning method */
     bool b_ar;          /* Do we keep the aspect ratio ? */
@@ -328,10 +341,8 @@ static int CreateFilter( vlc_object_t *p_this )
 
     p_sys->b_keep = var_CreateGetBoolCommand( p_filter,
                                               CFG_PREFIX "keep-picture" );
-    if ( !p_sys->b_keep )
-    {
-        p_sys->p_image = image_HandlerCreate( p_filter );
-    }
+    p_sys->p_tiles = NULL;
+    p_sys->i_tiles = 0;
 
     p_sys->i_order_length = 0;
     p_sys->ppsz_order = NULL;
@@ -372,6 +383,67 @@ static int CreateFilter( vlc_object_t *p_this )
     return VLC_SUCCESS;
 }
 
+/*****************************************************************************
+ * Tiles: keep the converted picture of each bridged ES
+ *****************************************************************************
+ * Converting a picture is the most expensive part of the mosaic. A source
+ * picture is usually shown over several mosaic frames, and each ES has its
+ * own format: one converter per ES, and one conversion per source picture.
+ *****************************************************************************/
+static void TileClean( mosaic_tile_t *p_tile )
+{
+    if( p_tile->p_source != NULL )
+        picture_Release( p_tile->p_source );
+    if( p_tile->p_picture != NULL )
+        picture_Release( p_tile->p_picture );
+    if( p_tile->p_image != NULL )
+        image_HandlerDelete( p_tile->p_image );
+}
+
+static mosaic_tile_t *TileGet( filter_t *p_filter, const bridged_es_t *p_es )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    for( int i = 0; i < p_sys->i_tiles; i++ )
+        if( p_sys->p_tiles[i].p_es == p_es )
+            return &p_sys->p_tiles[i];
+
+    mosaic_tile_t *p_tiles = realloc( p_sys->p_tiles,
+                                 (p_sys->i_tiles + 1) * sizeof( *p_tiles ) );
+    if( unlikely(p_tiles == NULL) )
+        return NULL;
+    p_sys->p_tiles = p_tiles;
+
+    mosaic_tile_t *p_tile = &p_tiles[p_sys->i_tiles];
+    p_tile->p_image = image_HandlerCreate( p_filter );
+    if( p_tile->p_image == NULL )
+        return NULL;
+    p_tile->p_es = p_es;
+    p_tile->p_source = NULL;
+    p_tile->p_picture = NULL;
+    p_tile->b_used = false;
+    p_sys->i_tiles++;
+    return p_tile;
+}
+
+/* Drops the tiles of the ES that are gone from the bridge */
+static void TilesPurge( filter_sys_t *p_sys )
+{
+    int j = 0;
+
+    for( int i = 0; i < p_sys->i_tiles; i++ )
+    {
+        if( p_sys->p_tiles[i].b_used )
+        {
+            p_sys->p_tiles[i].b_used = false;
+            p_sys->p_tiles[j++] = p_sys->p_tiles[i];
+        }
+        else
+            TileClean( &p_sys->p_tiles[i] );
+    }
+    p_sys->i_tiles = j;
+}
+
 /*****************************************************************************
  * DestroyFilter: destroy mosaic video filter
  *****************************************************************************/
@@ -401,10 +473,9 @@ static void DestroyFilter( vlc_object_t *p_this )
     DEL_CB( order );
 #undef DEL_CB
 
-    if( !p_sys->b_keep )
-    {
-        image_HandlerDelete( p_sys->p_image );
-    }
+    for( int i = 0; i < p_sys->i_tiles; i++ )
+        TileClean( &p_sys->p_tiles[i] );
+    free( p_sys->p_tiles );
 
     if( p_sys->i_order_length )
     {
@@ -591,6 +662,8 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
             fmt_in.i_chroma = p_es->p_picture->format.i_chroma;
             fmt_in.i_height = p_es->p_picture->format.i_height;
             fmt_in.i_width = p_es->p_picture->format.i_width;
+            fmt_in.i_visible_width = fmt_in.i_width;
+            fmt_in.i_visible_height = fmt_in.i_height;
 
             if( fmt_in.i_chroma == VLC_CODEC_YUVA ||
                 fmt_in.i_chroma == VLC_CODEC_RGBA )
@@ -618,16 +691,39 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
             fmt_out.i_visible_width = fmt_out.i_width;
             fmt_out.i_visible_height = fmt_out.i_height;
 
-            p_converted = image_Convert( p_sys->p_image, p_es->p_picture,
-                                         &fmt_in, &fmt_out );
-            if( !p_converted )
+            mosaic_tile_t *p_tile = TileGet( p_filter, p_es );
+            if( p_tile == NULL )
             {
-                msg_Warn( p_filter,
-                           "image resizing and chroma conversion failed" );
                 video_format_Clean( &fmt_in );
                 video_format_Clean( &fmt_out );
                 continue;
             }
+            p_tile->b_used = true;
+
+            if( p_tile->p_source != p_es->p_picture
+             || p_tile->p_picture->format.i_chroma != fmt_out.i_chroma
+             || p_tile->p_picture->format.i_width != fmt_out.i_width
+             || p_tile->p_picture->format.i_height != fmt_out.i_height )
+            {
+                p_converted = image_Convert( p_tile->p_image, p_es->p_picture,
+                                             &fmt_in, &fmt_out );
+                if( !p_converted )
+                {
+                    msg_Warn( p_filter,
+                               "image resizing and chroma conversion failed" );
+                    video_format_Clean( &fmt_in );
+                    video_format_Clean( &fmt_out );
+                    continue;
+                }
+
+                if( p_tile->p_source != NULL )
+                    picture_Release( p_tile->p_source );
+                if( p_tile->p_picture != NULL )
+                    picture_Release( p_tile->p_picture );
+                p_tile->p_source = picture_Hold( p_es->p_picture );
+                p_tile->p_picture = p_converted;
+            }
+            p_converted = p_tile->p_picture;
         }
         else
         {
@@ -640,11 +736,13 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
         }
 
         p_region = subpicture_region_New( &fmt_out );
-        /* FIXME the copy is probably not needed anymore */
-        if( p_region )
+        if( p_region && !p_sys->b_keep )
+        {   /* The region only reads the tile: share it instead of copying */
+            picture_Release( p_region->p_picture );
+            p_region->p_picture = picture_Hold( p_converted );
+        }
+        else if( p_region )
             picture_Copy( p_region->p_picture, p_converted );
-        if( !p_sys->b_keep )
-            picture_Release( p_converted );
 
         if( !p_region )
         {
@@ -723,6 +821,8 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
         p_region_prev = p_region;
     }
 
+    TilesPurge( p_sys );
+
     vlc_global_unlock( VLC_MOSAIC_MUTEX );
     vlc_mutex_unlock( &p_sys->lock );
 
@@ -919,10 +1019,6 @@ static int MosaicCallback( vlc_object_t *p_this, char const *psz_var,
     {
         vlc_mutex_lock( &p_sys->lock );
         p_sys->b_keep = newval.b_bool;
-        if ( !p_sys->b_keep && !p_sys->p_image )
-        {
-            p_sys->p_image = image_HandlerCreate( p_this );
-        }
         vlc_mutex_unlock( &p_sys->lock );
     }
 
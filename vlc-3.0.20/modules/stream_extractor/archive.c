@@ -61,6 +61,13 @@ vlc_module_begin()
 
 vlc_module_end()
 
+/* Decompressed data of the extracted entry is kept in a ring buffer, filled
+ * ahead of the reader by a worker thread, while the data already read stays
+ * available for backward seeks */
+#define ARCHIVE_CACHE_SIZE     ( 8 * 1024 * 1024 )
+#define ARCHIVE_READAHEAD_SIZE ( 4 * 1024 * 1024 )
+#define ARCHIVE_READ_CHUNK     ( 64 * 1024 )
+
 typedef struct libarchive_callback_t libarchive_callback_t;
 typedef struct private_sys_t private_sys_t;
 typedef struct archive libarchive_t;
@@ -83,6 +90,21 @@ struct private_sys_t
 
     libarchive_callback_t** pp_callback_data;
     size_t i_callback_data;
+
+    struct
+    {
+        vlc_mutex_t lock;
+        vlc_cond_t wait;
+        vlc_thread_t thread;
+        bool b_running;
+        bool b_stop;
+        bool b_eof;
+
+        uint8_t* p_buffer;
+        uint64_t i_start; /* entry offset of the oldest cached byte */
+        uint64_t i_end;   /* entry offset of libarchive */
+        uint64_t i_pos;   /* entry offset of the reader */
+    } cache;
 };
 
 struct libarchive_callback_t {
@@ -561,7 +583,7 @@ static int ReadDir( stream_directory_t* p_directory, input_item_node_t* p_node )
     return archive_status == ARCHIVE_EOF ? VLC_SUCCESS : VLC_EGENERIC;
 }
 
-static ssize_t Read( stream_extractor_t *p_extractor, void* p_data, size_t i_size )
+static ssize_t archive_read( stream_extractor_t *p_extractor, void* p_data, size_t i_size )
 {
     char dummy_buffer[ 8192 ];
 
@@ -610,7 +632,7 @@ static int archive_skip_decompressed( stream_extractor_t* p_extractor, uint64_t
 {
     while( i_skip )
     {
-        ssize_t i_read = Read( p_extractor, NULL, i_skip );
+        ssize_t i_read = archive_read( p_extractor, NULL, i_skip );
 
         if( i_read < 1 )
             return VLC_EGENERIC;
@@ -621,12 +643,135 @@ static int archive_skip_decompressed( stream_extractor_t* p_extractor, uint64_t
     return VLC_SUCCESS;
 }
 
-static int Seek( stream_extractor_t* p_extractor, uint64_t i_req )
+/* ------------------------------------------------------------------------- */
+
+static void archive_cache_fill( stream_extractor_t* p_extractor )
 {
     private_sys_t* p_sys = p_extractor->p_sys;
 
-    if( !p_sys->p_entry || !p_sys->b_seekable_source )
-        return VLC_EGENERIC;
+    /* called with the cache locked, and less than ARCHIVE_READAHEAD_SIZE
+     * bytes ahead of the reader */
+
+    size_t i_ahead = p_sys->cache.i_end - p_sys->cache.i_pos;
+    size_t i_slot  = p_sys->cache.i_end % ARCHIVE_CACHE_SIZE;
+    size_t i_chunk = __MIN( ARCHIVE_READ_CHUNK, ARCHIVE_READAHEAD_SIZE - i_ahead );
+
+    i_chunk = __MIN( i_chunk, ARCHIVE_CACHE_SIZE - i_slot );
+
+    /* DROP THE OLDEST DATA BEFORE OVERWRITING IT */
+
+    if( p_sys->cache.i_end + i_chunk - p_sys->cache.i_start > ARCHIVE_CACHE_SIZE )
+        p_sys->cache.i_start = p_sys->cache.i_end + i_chunk - ARCHIVE_CACHE_SIZE;
+
+    vlc_mutex_unlock( &p_sys->cache.lock );
+
+    ssize_t i_read = archive_read( p_extractor,
+      &p_sys->cache.p_buffer[ i_slot ], i_chunk );
+
+    vlc_mutex_lock( &p_sys->cache.lock );
+
+    if( i_read > 0 )
+        p_sys->cache.i_end += i_read;
+    else
+        p_sys->cache.b_eof = true;
+
+    vlc_cond_broadcast( &p_sys->cache.wait );
+}
+
+static void* archive_cache_thread( void* data )
+{
+    stream_extractor_t* p_extractor = data;
+    private_sys_t* p_sys = p_extractor->p_sys;
+
+    vlc_mutex_lock( &p_sys->cache.lock );
+
+    for( ;; )
+    {
+        while( !p_sys->cache.b_stop && ( p_sys->cache.b_eof ||
+               p_sys->cache.i_end - p_sys->cache.i_pos >= ARCHIVE_READAHEAD_SIZE ) )
+            vlc_cond_wait( &p_sys->cache.wait, &p_sys->cache.lock );
+
+        if( p_sys->cache.b_stop )
+            break;
+
+        archive_cache_fill( p_extractor );
+    }
+
+    vlc_mutex_unlock( &p_sys->cache.lock );
+    return NULL;
+}
+
+static void archive_cache_start( stream_extractor_t* p_extractor )
+{
+    private_sys_t* p_sys = p_extractor->p_sys;
+
+    p_sys->cache.b_stop = false;
+    p_sys->cache.b_running = !vlc_clone( &p_sys->cache.thread,
+      archive_cache_thread, p_extractor, VLC_THREAD_PRIORITY_INPUT );
+
+    if( !p_sys->cache.b_running )
+        msg_Warn( p_extractor, "unable to start read-ahead thread" );
+}
+
+static void archive_cache_stop( stream_extractor_t* p_extractor )
+{
+    private_sys_t* p_sys = p_extractor->p_sys;
+
+    if( !p_sys->cache.b_running )
+        return;
+
+    vlc_mutex_lock( &p_sys->cache.lock );
+    p_sys->cache.b_stop = true;
+    vlc_cond_broadcast( &p_sys->cache.wait );
+    vlc_mutex_unlock( &p_sys->cache.lock );
+
+    vlc_join( p_sys->cache.thread, NULL );
+    p_sys->cache.b_running = false;
+}
+
+static void archive_cache_reset( private_sys_t* p_sys, uint64_t i_pos )
+{
+    p_sys->cache.i_start = i_pos;
+    p_sys->cache.i_end   = i_pos;
+    p_sys->cache.i_pos   = i_pos;
+    p_sys->cache.b_eof   = p_sys->b_eof || p_sys->b_dead;
+}
+
+static ssize_t Read( stream_extractor_t *p_extractor, void* p_data, size_t i_size )
+{
+    private_sys_t* p_sys = p_extractor->p_sys;
+
+    if( p_sys->p_entry == NULL )
+        return 0;
+
+    vlc_mutex_lock( &p_sys->cache.lock );
+
+    while( p_sys->cache.i_pos == p_sys->cache.i_end && !p_sys->cache.b_eof )
+    {
+        if( p_sys->cache.b_running )
+            vlc_cond_wait( &p_sys->cache.wait, &p_sys->cache.lock );
+        else
+            archive_cache_fill( p_extractor );
+    }
+
+    size_t i_slot = p_sys->cache.i_pos % ARCHIVE_CACHE_SIZE;
+    size_t i_copy = __MIN( i_size, p_sys->cache.i_end - p_sys->cache.i_pos );
+
+    i_copy = __MIN( i_copy, ARCHIVE_CACHE_SIZE - i_slot );
+
+    if( p_data )
+        memcpy( p_data, &p_sys->cache.p_buffer[ i_slot ], i_copy );
+
+    p_sys->cache.i_pos += i_copy;
+    vlc_cond_broadcast( &p_sys->cache.wait );
+    vlc_mutex_unlock( &p_sys->cache.lock );
+
+    return i_copy;
+}
+
+static int archive_seek( stream_extractor_t* p_extractor, uint64_t i_req )
+{
+    private_sys_t* p_sys = p_extractor->p_sys;
 
     if( archive_entry_size_is_set( p_sys->p_entry ) &&
         (uint64_t)archive_entry_size( p_sys->p_entry ) <= i_req )
@@ -669,6 +814,40 @@ static int Seek( stream_extractor_t* p_extractor, uint64_t i_req )
     return VLC_SUCCESS;
 }
 
+static int Seek( stream_extractor_t* p_extractor, uint64_t i_req )
+{
+    private_sys_t* p_sys = p_extractor->p_sys;
+
+    if( !p_sys->p_entry )
+        return VLC_EGENERIC;
+
+    /* SERVE FROM THE CACHE IF POSSIBLE */
+
+    vlc_mutex_lock( &p_sys->cache.lock );
+
+    if( i_req >= p_sys->cache.i_start && i_req <= p_sys->cache.i_end )
+    {
+        p_sys->cache.i_pos = i_req;
+        vlc_cond_broadcast( &p_sys->cache.wait );
+        vlc_mutex_unlock( &p_sys->cache.lock );
+        return VLC_SUCCESS;
+    }
+
+    vlc_mutex_unlock( &p_sys->cache.lock );
+
+    if( !p_sys->b_seekable_source )
+        return VLC_EGENERIC;
+
+    archive_cache_stop( p_extractor );
+
+    int i_ret = archive_seek( p_extractor, i_req );
+
+    archive_cache_reset( p_sys, i_req );
+    archive_cache_start( p_extractor );
+
+    return i_ret;
+}
+
 
 static void CommonClose( private_sys_t* p_sys )
 {
@@ -694,7 +873,14 @@ static void DirectoryClose( vlc_object_t* p_obj )
 static void ExtractorClose( vlc_object_t* p_obj )
 {
     stream_extractor_t* p_extractor = (void*)p_obj;
-    return CommonClose( p_extractor->p_sys );
+    private_sys_t* p_sys = p_extractor->p_sys;
+
+    archive_cache_stop( p_extractor );
+    vlc_cond_destroy( &p_sys->cache.wait );
+    vlc_mutex_destroy( &p_sys->cache.lock );
+    free( p_sys->cache.p_buffer );
+
+    return CommonClose( p_sys );
 }
 
 static private_sys_t* CommonOpen( vlc_object_t* p_obj, stream_t* source  )
@@ -744,7 +930,21 @@ static int ExtractorOpen( vlc_object_t* p_obj )
         return VLC_EGENERIC;
     }
 
+    p_sys->cache.p_buffer = malloc( ARCHIVE_CACHE_SIZE );
+
+    if( unlikely( !p_sys->cache.p_buffer ) )
+    {
+        CommonClose( p_sys );
+        return VLC_ENOMEM;
+    }
+
+    vlc_mutex_init( &p_sys->cache.lock );
+    vlc_cond_init( &p_sys->cache.wait );
+    archive_cache_reset( p_sys, 0 );
+
     p_extractor->p_sys = p_sys;
+    archive_cache_start( p_extractor );
+
     p_extractor->pf_read = Read;
     p_extractor->pf_control = Control;
     p_extractor->pf_seek = Seek;
@@ -34,6 +34,7 @@
 #include <vlc_stream.h>
 #include <vlc_fs.h>
 #include <vlc_interrupt.h>
+#include <vlc_memory.h>
 
 struct stream_sys_t
 {
@@ -59,8 +60,17 @@ struct stream_sys_t
     size_t       buffer_length;
     size_t       buffer_size;
     char        *buffer;
+    vlc_memory_user_t *memory;
     size_t       read_size;
     size_t       seek_threshold;
+
+    /* Adaptive buffer sizing (target_time is zero for a fixed size) */
+    size_t       buffer_max;
+    mtime_t      target_time;
+    uint64_t     consume_rate;
+    uint64_t     consume_bytes;
+    mtime_t      consume_date;
+    mtime_t      latency;
 };
 
 static ssize_t ThreadRead(stream_t *stream, void *buf, size_t length)
@@ -71,10 +81,16 @@ static ssize_t ThreadRead(stream_t *stream, void *buf, size_t length)
     vlc_mutex_unlock(&sys->lock);
     assert(length > 0);
 
+    mtime_t start = mdate();
     ssize_t val = vlc_stream_ReadPartial(stream->p_source, buf, length);
+    mtime_t duration = mdate() - start;
 
     vlc_mutex_lock(&sys->lock);
     vlc_restorecancel(canc);
+
+    if (val > 0)
+        sys->latency = sys->latency ? (3 * sys->latency + duration) / 4
+                                    : duration;
     return val;
 }
 
@@ -116,6 +132,96 @@ static int ThreadControl(stream_t *stream, int query, ...)
 
 #define MAX_READ 65536
 #define SEEK_THRESHOLD MAX_READ
+#define MIN_BUFFER_SIZE (1 << 18)
+#define RATE_PERIOD (CLOCK_FREQ / 2)
+
+/**
+ * Computes the buffer size needed to cover the target time at the current
+ * consumption rate, plus the time to get data from upstream.
+ */
+static size_t BufferTarget(const stream_t *stream)
+{
+    const stream_sys_t *sys = stream->p_sys;
+    uint64_t size = sys->consume_rate * (sys->target_time + sys->latency)
+                    / CLOCK_FREQ;
+
+    if (size > sys->buffer_size)
+    {
+        /* Leave headroom to limit the number of copies as the rate varies */
+        size += size / 2;
+        if (!vlc_memory_Allow(sys->memory, size - sys->buffer_size))
+            return sys->buffer_size; /* over the memory budget */
+    }
+    else if (size < sys->buffer_size / 4)
+        size = sys->buffer_size / 2;
+    else
+        return sys->buffer_size;
+
+    if (size > sys->buffer_max)
+        size = sys->buffer_max;
+    if (size < MIN_BUFFER_SIZE)
+        size = MIN_BUFFER_SIZE;
+    if (sys->size != (uint64_t)-1 && size > sys->size)
+        size = sys->size;
+    return size;
+}
+
+static void BufferResize(stream_t *stream, size_t size)
+{
+    stream_sys_t *sys = stream->p_sys;
+    int canc = vlc_savecancel();
+
+    vlc_mutex_unlock(&sys->lock);
+    char *buffer = malloc(size);
+    vlc_mutex_lock(&sys->lock);
+    vlc_restorecancel(canc);
+
+    if (unlikely(buffer == NULL))
+    {   /* Stick to the current size */
+        sys->buffer_max = sys->buffer_size;
+        return;
+    }
+
+    if (sys->buffer_length > size)
+    {   /* Discard the oldest historical data, but never unread data */
+        size_t drop = sys->buffer_length - size;
+
+        if (sys->stream_offset >= sys->buffer_offset
+         && sys->stream_offset < sys->buffer_offset + drop)
+        {
+            free(buffer);
+            return;
+        }
+        sys->buffer_offset += drop;
+        sys->buffer_length -= drop;
+    }
+
+    /* Both buffers are indexed by stream offset modulo their size */
+    uint64_t offset = sys->buffer_offset;
+    uint64_t end = offset + sys->buffer_length;
+
+    while (offset < end)
+    {
+        size_t from = offset % sys->buffer_size;
+        size_t to = offset % size;
+        size_t len = end - offset;
+
+        if (len > sys->buffer_size - from)
+            len = sys->buffer_size - from;
+        if (len > size - to)
+            len = size - to;
+        memcpy(buffer + to, sys->buffer + from, len);
+        offset += len;
+    }
+
+    msg_Dbg(stream, "buffer resized from %zu to %zu bytes (%"PRIu64" B/s, "
+            "%"PRId64" us latency)", sys->buffer_size, size,
+            sys->consume_rate, sys->latency);
+    free(sys->buffer);
+    sys->buffer = buffer;
+    sys->buffer_size = size;
+    vlc_memory_Set(sys->memory, size);
+}
 
 static void *Thread(void *data)
 {
@@ -202,6 +308,17 @@ static void *Thread(void *data)
             continue;
         }
 
+        if (sys->target_time > 0)
+        {   /* Keep enough data ahead to cover the target time */
+            size_t size = BufferTarget(stream);
+            if (size != sys->buffer_size)
+            {
+                BufferResize(stream, size);
+                if (sys->buffer_size == size)
+                    continue;
+            }
+        }
+
         assert(sys->buffer_size >= sys->buffer_length);
 
         size_t len = sys->buffer_size - sys->buffer_length;
@@ -271,6 +388,31 @@ static int Seek(stream_t *stream, uint64_t offset)
     return 0;
 }
 
+static void ConsumeRateUpdate(stream_sys_t *sys, size_t len)
+{
+    mtime_t now = mdate();
+
+    if (sys->consume_date == VLC_TS_INVALID)
+    {   /* (Re)start measuring */
+        sys->consume_date = now;
+        sys->consume_bytes = 0;
+        return;
+    }
+
+    sys->consume_bytes += len;
+
+    mtime_t elapsed = now - sys->consume_date;
+    if (elapsed < RATE_PERIOD)
+        return;
+
+    uint64_t rate = sys->consume_bytes * CLOCK_FREQ / elapsed;
+
+    sys->consume_rate = sys->consume_rate ? (3 * sys->consume_rate + rate) / 4
+                                          : rate;
+    sys->consume_date = now;
+    sys->consume_bytes = 0;
+}
+
 static size_t BufferLevel(const stream_t *stream, bool *eof)
 {
     stream_sys_t *sys = stream->p_sys;
@@ -328,6 +470,7 @@ static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
 
     memcpy(buf, sys->buffer + offset, copy);
     sys->stream_offset += copy;
+    ConsumeRateUpdate(sys, copy);
     vlc_cond_signal(&sys->wait_space);
     vlc_mutex_unlock(&sys->lock);
     return copy;
@@ -380,12 +523,24 @@ static int Control(stream_t *stream, int query, va_list args)
         case STREAM_GET_SIGNAL:
         case STREAM_GET_TAGS:
             return VLC_EGENERIC;
+        case STREAM_GET_CONSUME_RATE:
+            vlc_mutex_lock(&sys->lock);
+            *va_arg(args, uint64_t *) = sys->consume_rate;
+            vlc_mutex_unlock(&sys->lock);
+            break;
+        case STREAM_GET_ACCESS_LATENCY:
+            vlc_mutex_lock(&sys->lock);
+            *va_arg(args, mtime_t *) = sys->latency;
+            vlc_mutex_unlock(&sys->lock);
+            break;
         case STREAM_SET_PAUSE_STATE:
         {
             bool paused = va_arg(args, unsigned);
 
             vlc_mutex_lock(&sys->lock);
             sys->paused = paused;
+            /* Do not account the pause as slow consumption */
+            sys->consume_date = VLC_TS_INVALID;
             vlc_cond_signal(&sys->wait_space);
             vlc_mutex_unlock (&sys->lock);
             break;
@@ -453,6 +608,11 @@ static int Open(vlc_object_t *obj)
     sys->buffer_size = var_InheritInteger(obj, "prefetch-buffer-size") << 10u;
     sys->read_size = var_InheritInteger(obj, "prefetch-read-size");
     sys->seek_threshold = var_InheritInteger(obj, "prefetch-seek-threshold");
+    sys->target_time = var_InheritInteger(obj, "prefetch-target-time") * 1000;
+    sys->consume_rate = 0;
+    sys->consume_bytes = 0;
+    sys->consume_date = VLC_TS_INVALID;
+    sys->latency = 0;
 
     uint64_t size = stream_Size(stream->p_source);
     if (size > 0)
@@ -462,7 +622,14 @@ static int Open(vlc_object_t *obj)
         if (sys->read_size > size)
             sys->read_size = size;
     }
-    if (sys->buffer_size < sys->read_size)
+
+    sys->buffer_max = sys->buffer_size;
+    if (sys->target_time > 0)
+    {   /* Start small, the buffer grows with the consumption rate */
+        if (sys->buffer_size > MIN_BUFFER_SIZE)
+            sys->buffer_size = MIN_BUFFER_SIZE;
+    }
+    else if (sys->buffer_size < sys->read_size)
         sys->buffer_size = sys->read_size;
 
     sys->buffer = malloc(sys->buffer_size);
@@ -473,6 +640,9 @@ static int Open(vlc_object_t *obj)
     if (unlikely(sys->interrupt == NULL))
         goto error;
 
+    sys->memory = vlc_memory_Register(stream, VLC_MEMORY_LOW);
+    vlc_memory_Set(sys->memory, sys->buffer_size);
+
     vlc_mutex_init(&sys->lock);
     vlc_cond_init(&sys->wait_data);
     vlc_cond_init(&sys->wait_space);
@@ -485,11 +655,17 @@ static int Open(vlc_object_t *obj)
         vlc_cond_destroy(&sys->wait_data);
         vlc_mutex_destroy(&sys->lock);
         vlc_interrupt_destroy(sys->interrupt);
+        vlc_memory_Unregister(sys->memory);
         goto error;
     }
 
-    msg_Dbg(stream, "using %zu bytes buffer, %zu bytes read",
-            sys->buffer_size, sys->read_size);
+    if (sys->target_time > 0)
+        msg_Dbg(stream, "using up to %zu bytes buffer for %"PRId64" ms, "
+                "%zu bytes read", sys->buffer_max, sys->target_time / 1000,
+                sys->read_size);
+    else
+        msg_Dbg(stream, "using %zu bytes buffer, %zu bytes read",
+                sys->buffer_size, sys->read_size);
     stream->pf_read = Read;
     stream->pf_readdir = ReadDir;
     stream->pf_control = Control;
@@ -519,6 +695,7 @@ static void Close (vlc_object_t *obj)
     vlc_cond_destroy(&sys->wait_data);
     vlc_mutex_destroy(&sys->lock);
 
+    vlc_memory_Unregister(sys->memory);
     free(sys->buffer);
     free(sys->content_type);
     free(sys);
@@ -533,7 +710,8 @@ vlc_module_begin()
     set_callbacks(Open, Close)
 
     add_integer("prefetch-buffer-size", 1 << 14, N_("Buffer size"),
-                N_("Prefetch buffer size (KiB)"), false)
+                N_("Prefetch buffer size, or maximum size if the buffer is "
+                   "adaptive (KiB)"), false)
         change_integer_range(4, 1 << 20)
     add_integer("prefetch-read-size", 1 << 24, N_("Read size"),
                 N_("Prefetch background read size (bytes)"), true)
@@ -541,4 +719,9 @@ vlc_module_begin()
     add_integer("prefetch-seek-threshold", 1 << 14, N_("Seek threshold"),
                 N_("Prefetch forward seek threshold (bytes)"), true)
         change_integer_range(0, UINT64_C(1) << 60)
+    add_integer("prefetch-target-time", 5000, N_("Target time"),
+                N_("Size the prefetch buffer to cover this duration at the "
+                   "current consumption rate (ms). 0 uses a fixed size."),
+                true)
+        change_integer_range(0, 600000)
 vlc_module_end()
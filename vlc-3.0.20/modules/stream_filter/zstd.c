@@ -0,0 +1,465 @@
+/*****************************************************************************
+ * zstd.c: Zstandard decompression module for VLC
+ *****************************************************************************
+ * Copyright (C) 2023 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <zstd.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_stream.h>
+#include <vlc_block.h>
+
+/* Zstandard frames are independent from one another: the frames that fit in
+ * ZSTD_FRAME_MAX bytes are decompressed by a pool of worker threads, while
+ * the larger ones (e.g. single frame files) are streamed on the reading
+ * thread. */
+#define ZSTD_FRAME_MAX   (4 << 20)
+#define ZSTD_THREADS_MAX 8
+#define ZSTD_JOBS_MAX    (2 * ZSTD_THREADS_MAX)
+
+struct zstd_job
+{
+    block_t *in;
+    block_t *out;
+    enum { JOB_PENDING, JOB_RUNNING, JOB_DONE } state;
+};
+
+struct stream_sys_t
+{
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    vlc_thread_t threads[ZSTD_THREADS_MAX];
+    unsigned thread_count;
+    bool stop;
+
+    /* Jobs in stream order, owned by the reading thread */
+    struct zstd_job jobs[ZSTD_JOBS_MAX];
+    unsigned job_head;
+    unsigned job_count;
+
+    ZSTD_DStream *dstream;
+    bool serial; /* streaming the current frame */
+    bool serial_next; /* next frame is too large to be queued */
+    bool source_eof;
+    bool done;
+};
+
+static block_t *DecodeFrame(ZSTD_DStream *dstream, const block_t *in)
+{
+    unsigned long long size = ZSTD_getFrameContentSize(in->p_buffer,
+                                                       in->i_buffer);
+    if (size == ZSTD_CONTENTSIZE_UNKNOWN || size == ZSTD_CONTENTSIZE_ERROR
+     || size == 0 || size > 16 * ZSTD_FRAME_MAX)
+        size = ZSTD_DStreamOutSize();
+
+    block_t *out = block_Alloc(size);
+    if (unlikely(out == NULL))
+        return NULL;
+
+    ZSTD_inBuffer inbuf = { in->p_buffer, in->i_buffer, 0 };
+    ZSTD_outBuffer outbuf = { out->p_buffer, out->i_buffer, 0 };
+
+    ZSTD_initDStream(dstream);
+
+    for (;;)
+    {
+        size_t val = ZSTD_decompressStream(dstream, &outbuf, &inbuf);
+
+        if (ZSTD_isError(val))
+            goto error;
+        if (val == 0) /* end of frame */
+            break;
+
+        if (outbuf.pos < outbuf.size)
+        {
+            if (inbuf.pos == inbuf.size)
+                goto error; /* truncated frame */
+            continue;
+        }
+
+        block_t *grown = block_Realloc(out, 0, 2 * out->i_buffer);
+        if (unlikely(grown == NULL))
+            return NULL;
+        out = grown;
+        outbuf.dst = out->p_buffer;
+        outbuf.size = out->i_buffer;
+    }
+
+    out->i_buffer = outbuf.pos;
+    return out;
+error:
+    block_Release(out);
+    return NULL;
+}
+
+static struct zstd_job *NextPendingJob(stream_sys_t *sys)
+{
+    for (unsigned i = 0; i < sys->job_count; i++)
+    {
+        struct zstd_job *job = &sys->jobs[(sys->job_head + i) % ZSTD_JOBS_MAX];
+
+        if (job->state == JOB_PENDING)
+            return job;
+    }
+    return NULL;
+}
+
+static void *Worker(void *data)
+{
+    stream_t *stream = data;
+    stream_sys_t *sys = stream->p_sys;
+    ZSTD_DStream *dstream = ZSTD_createDStream();
+
+    vlc_mutex_lock(&sys->lock);
+    for (;;)
+    {
+        struct zstd_job *job;
+
+        while (!sys->stop && (job = NextPendingJob(sys)) == NULL)
+            vlc_cond_wait(&sys->wait, &sys->lock);
+        if (sys->stop)
+            break;
+
+        job->state = JOB_RUNNING;
+        vlc_mutex_unlock(&sys->lock);
+
+        block_t *out = NULL;
+        if (likely(dstream != NULL))
+            out = DecodeFrame(dstream, job->in);
+
+        vlc_mutex_lock(&sys->lock);
+        job->out = out;
+        job->state = JOB_DONE;
+        vlc_cond_broadcast(&sys->wait);
+    }
+    vlc_mutex_unlock(&sys->lock);
+
+    ZSTD_freeDStream(dstream);
+    return NULL;
+}
+
+/**
+ * Queues the next frame of the source.
+ * \return 1 if a frame was queued, 0 if the next frame cannot be queued and
+ * must be streamed, -1 at the end of the source.
+ */
+static int QueueFrame(stream_t *stream)
+{
+    stream_sys_t *sys = stream->p_sys;
+    const uint8_t *peek;
+    size_t size;
+
+    for (size_t want = 1 << 16;; want *= 4)
+    {
+        ssize_t val = vlc_stream_Peek(stream->p_source, &peek, want);
+        if (val <= 0)
+            return -1;
+
+        size = ZSTD_findFrameCompressedSize(peek, val);
+        if (!ZSTD_isError(size))
+            break;
+        /* Too large or truncated: the stream decoder will handle it */
+        if ((size_t)val < want || want >= ZSTD_FRAME_MAX)
+            return 0;
+    }
+
+    block_t *in = vlc_stream_Block(stream->p_source, size);
+    if (in == NULL)
+        return -1;
+
+    vlc_mutex_lock(&sys->lock);
+    struct zstd_job *job = &sys->jobs[(sys->job_head + sys->job_count)
+                                      % ZSTD_JOBS_MAX];
+    job->in = in;
+    job->out = NULL;
+    job->state = JOB_PENDING;
+    sys->job_count++;
+    vlc_cond_signal(&sys->wait);
+    vlc_mutex_unlock(&sys->lock);
+    return 1;
+}
+
+static block_t *ReadJob(stream_t *stream)
+{
+    stream_sys_t *sys = stream->p_sys;
+
+    /* Keep the workers busy */
+    while (!sys->source_eof && !sys->serial_next
+        && sys->job_count < 2 * sys->thread_count)
+    {
+        int val = QueueFrame(stream);
+
+        if (val < 0)
+            sys->source_eof = true;
+        else if (val == 0)
+            sys->serial_next = true;
+    }
+
+    if (sys->job_count == 0)
+    {
+        if (sys->serial_next)
+        {
+            ZSTD_initDStream(sys->dstream);
+            sys->serial_next = false;
+            sys->serial = true;
+        }
+        else
+            sys->done = true;
+        return NULL;
+    }
+
+    struct zstd_job *job = &sys->jobs[sys->job_head];
+
+    vlc_mutex_lock(&sys->lock);
+    while (job->state != JOB_DONE)
+        vlc_cond_wait(&sys->wait, &sys->lock);
+    sys->job_head = (sys->job_head + 1) % ZSTD_JOBS_MAX;
+    sys->job_count--;
+    vlc_mutex_unlock(&sys->lock);
+
+    block_Release(job->in);
+    if (job->out == NULL)
+    {
+        msg_Err(stream, "corrupt frame");
+        sys->done = true;
+    }
+    return job->out;
+}
+
+static block_t *ReadSerial(stream_t *stream)
+{
+    stream_sys_t *sys = stream->p_sys;
+    const uint8_t *peek;
+
+    ssize_t val = vlc_stream_Peek(stream->p_source, &peek,
+                                  ZSTD_DStreamInSize());
+    if (val <= 0)
+    {
+        msg_Err(stream, "unexpected end of stream");
+        sys->done = true;
+        return NULL;
+    }
+
+    block_t *out = block_Alloc(ZSTD_DStreamOutSize());
+    if (unlikely(out == NULL))
+    {
+        sys->done = true;
+        return NULL;
+    }
+
+    ZSTD_inBuffer inbuf = { peek, val, 0 };
+    ZSTD_outBuffer outbuf = { out->p_buffer, out->i_buffer, 0 };
+    size_t ret = ZSTD_decompressStream(sys->dstream, &outbuf, &inbuf);
+
+    /* Only consume the bytes of this frame */
+    vlc_stream_Read(stream->p_source, NULL, inbuf.pos);
+
+    if (ZSTD_isError(ret))
+    {
+        msg_Err(stream, "corrupt stream: %s", ZSTD_getErrorName(ret));
+        block_Release(out);
+        sys->done = true;
+        return NULL;
+    }
+
+    if (ret == 0) /* end of frame */
+        sys->serial = false;
+
+    out->i_buffer = outbuf.pos;
+    return out;
+}
+
+static block_t *Block(stream_t *stream, bool *restrict eof)
+{
+    stream_sys_t *sys = stream->p_sys;
+    block_t *out = NULL;
+
+    while (out == NULL && !sys->done)
+    {
+        out = sys->serial ? ReadSerial(stream) : ReadJob(stream);
+
+        if (out != NULL && out->i_buffer == 0)
+        {   /* Skippable or empty frame */
+            block_Release(out);
+            out = NULL;
+        }
+    }
+
+    if (out == NULL)
+        *eof = true;
+    return out;
+}
+
+static int ReadDir(stream_t *stream, input_item_node_t *node)
+{
+    (void) stream; (void) node;
+    return VLC_EGENERIC;
+}
+
+static int Seek(stream_t *stream, uint64_t offset)
+{
+    (void) stream; (void) offset;
+    return -1;
+}
+
+static int Control(stream_t *stream, int query, va_list args)
+{
+    switch (query)
+    {
+        case STREAM_CAN_SEEK:
+        case STREAM_CAN_FASTSEEK:
+            *va_arg(args, bool *) = false;
+            break;
+        case STREAM_CAN_PAUSE:
+        case STREAM_CAN_CONTROL_PACE:
+        case STREAM_GET_PTS_DELAY:
+        case STREAM_GET_META:
+        case STREAM_GET_CONTENT_TYPE:
+        case STREAM_GET_SIGNAL:
+        case STREAM_SET_PAUSE_STATE:
+            return vlc_stream_vaControl(stream->p_source, query, args);
+        case STREAM_IS_DIRECTORY:
+        case STREAM_GET_SIZE:
+        case STREAM_GET_TITLE_INFO:
+        case STREAM_GET_TITLE:
+        case STREAM_GET_SEEKPOINT:
+        case STREAM_SET_TITLE:
+        case STREAM_SET_SEEKPOINT:
+        case STREAM_SET_PRIVATE_ID_STATE:
+        case STREAM_SET_PRIVATE_ID_CA:
+        case STREAM_GET_PRIVATE_ID_STATE:
+            return VLC_EGENERIC;
+        default:
+            msg_Err(stream, "unimplemented query (%d) in control", query);
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static void Stop(stream_sys_t *sys)
+{
+    vlc_mutex_lock(&sys->lock);
+    sys->stop = true;
+    vlc_cond_broadcast(&sys->wait);
+    vlc_mutex_unlock(&sys->lock);
+
+    for (unsigned i = 0; i < sys->thread_count; i++)
+        vlc_join(sys->threads[i], NULL);
+}
+
+static void Clean(stream_sys_t *sys)
+{
+    for (unsigned i = 0; i < sys->job_count; i++)
+    {
+        struct zstd_job *job = &sys->jobs[(sys->job_head + i) % ZSTD_JOBS_MAX];
+
+        block_Release(job->in);
+        if (job->out != NULL)
+            block_Release(job->out);
+    }
+
+    ZSTD_freeDStream(sys->dstream);
+    vlc_cond_destroy(&sys->wait);
+    vlc_mutex_destroy(&sys->lock);
+    free(sys);
+}
+
+static int Open(vlc_object_t *obj)
+{
+    stream_t *stream = (stream_t *)obj;
+    const uint8_t *peek;
+
+    if (vlc_stream_Peek(stream->p_source, &peek, 4) < 4)
+        return VLC_EGENERIC;
+
+    /* Zstandard frame, or skippable frame */
+    if (GetDWLE(peek) != 0xFD2FB528 && (GetDWLE(peek) & ~0xF) != 0x184D2A50)
+        return VLC_EGENERIC;
+
+    stream_sys_t *sys = malloc(sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return VLC_ENOMEM;
+
+    vlc_mutex_init(&sys->lock);
+    vlc_cond_init(&sys->wait);
+    sys->thread_count = 0;
+    sys->stop = false;
+    sys->job_head = 0;
+    sys->job_count = 0;
+    sys->serial = false;
+    sys->serial_next = false;
+    sys->source_eof = false;
+    sys->done = false;
+
+    sys->dstream = ZSTD_createDStream();
+    if (unlikely(sys->dstream == NULL))
+    {
+        Clean(sys);
+        return VLC_ENOMEM;
+    }
+
+    stream->p_sys = sys;
+
+    unsigned threads = vlc_GetCPUCount();
+    if (threads > ZSTD_THREADS_MAX)
+        threads = ZSTD_THREADS_MAX;
+
+    while (sys->thread_count < threads
+        && vlc_clone(&sys->threads[sys->thread_count], Worker, stream,
+                     VLC_THREAD_PRIORITY_INPUT) == 0)
+        sys->thread_count++;
+
+    if (sys->thread_count == 0)
+    {
+        Clean(sys);
+        return VLC_ENOMEM;
+    }
+
+    msg_Dbg(stream, "using %u decompression threads", sys->thread_count);
+
+    stream->pf_block = Block;
+    stream->pf_readdir = ReadDir;
+    stream->pf_seek = Seek;
+    stream->pf_control = Control;
+    return VLC_SUCCESS;
+}
+
+static void Close(vlc_object_t *obj)
+{
+    stream_t *stream = (stream_t *)obj;
+    stream_sys_t *sys = stream->p_sys;
+
+    Stop(sys);
+    Clean(sys);
+}
+
+vlc_module_begin()
+    set_category(CAT_INPUT)
+    set_subcategory(SUBCAT_INPUT_STREAM_FILTER)
+    set_capability("stream_filter", 30)
+
+    set_description(N_("Zstandard decompression filter"))
+    set_callbacks(Open, Close)
+vlc_module_end()
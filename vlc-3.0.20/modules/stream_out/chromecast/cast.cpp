@@ -116,6 +116,7 @@ struct sout_stream_sys_t
     void stopSoutChain(sout_stream_t* p_stream);
     sout_stream_id_sys_t *GetSubId( sout_stream_t*, sout_stream_id_sys_t*, bool update = true );
     bool isFlushing( sout_stream_t* );
+    int getNextTranscodingState() const;
     void setNextTranscodingState();
     bool transcodingCanFallback() const;
 
@@ -772,6 +773,7 @@ static void Del(sout_stream_t *p_stream, sout_stream_id_sys_t *id)
  * 1: Transcode to h264 & accept all supported audio formats if the video codec
  *    was HEVC/VP9
  * 2: Transcode to H264 & MP3
+ * Steps that would transcode a missing track are skipped.
  *
  * Additionally:
  * - Allow (E)AC3 passthrough depending on the audio-passthrough
@@ -807,6 +809,11 @@ bool sout_stream_sys_t::canDecodeAudio( sout_stream_t *p_stream,
     {
         return p_fmt->i_channels <= 2;
     }
+    if ( i_codec == VLC_CODEC_FLAC )
+    {
+        /* Up to 96kHz/24-bit */
+        return p_fmt->i_rate <= 96000 && p_fmt->i_bitspersample <= 24;
+    }
     return i_codec == VLC_CODEC_VORBIS || i_codec == VLC_CODEC_OPUS ||
            i_codec == VLC_CODEC_MP3;
 }
@@ -890,17 +897,35 @@ bool sout_stream_sys_t::startSoutChain(sout_stream_t *p_stream,
     return true;
 }
 
+int sout_stream_sys_t::getNextTranscodingState() const
+{
+    /* Skip the steps that would transcode a missing track, as they would
+     * only restart the same chain */
+    bool has_audio = false, has_video = false;
+    for (size_t i = 0; i < streams.size(); ++i)
+    {
+        if (streams[i]->fmt.i_cat == AUDIO_ES)
+            has_audio = true;
+        else if (streams[i]->fmt.i_cat == VIDEO_ES && b_supports_video)
+            has_video = true;
+    }
+
+    if (!(transcoding_state & TRANSCODING_VIDEO) && has_video)
+        return transcoding_state | TRANSCODING_VIDEO;
+    else if (!(transcoding_state & TRANSCODING_AUDIO) && has_audio)
+        return has_video ? TRANSCODING_AUDIO
+                         : transcoding_state | TRANSCODING_AUDIO;
+    return transcoding_state;
+}
+
 void sout_stream_sys_t::setNextTranscodingState()
 {
-    if (!(transcoding_state & TRANSCODING_VIDEO))
-        transcoding_state |= TRANSCODING_VIDEO;
-    else if (!(transcoding_state & TRANSCODING_AUDIO))
-        transcoding_state = TRANSCODING_AUDIO;
+    transcoding_state = getNextTranscodingState();
 }
 
 bool sout_stream_sys_t::transcodingCanFallback() const
 {
-    return transcoding_state != (TRANSCODING_VIDEO|TRANSCODING_AUDIO);
+    return getNextTranscodingState() != transcoding_state;
 }
 
 static std::string GetVencVPXOption( sout_stream_t * /* p_stream */,
@@ -278,7 +278,8 @@ static int Send( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
 
             if( id->pp_ids[i_stream] )
             {
-                block_t *p_dup = block_Duplicate( p_buffer );
+                /* The outputs share the payload, rather than copying it */
+                block_t *p_dup = block_Share( &p_buffer );
 
                 if( p_dup )
                     sout_StreamIdSend( p_dup_stream, id->pp_ids[i_stream], p_dup );
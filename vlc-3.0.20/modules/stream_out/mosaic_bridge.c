@@ -537,6 +537,13 @@ static int decoder_queue_video( decoder_t *p_dec, picture_t *p_pic )
             return -1;
         }
     }
+    else if( !p_sys->p_vf2 )
+    {
+        /* TODO: chroma conversion if needed */
+
+        /* The mosaic only reads the picture: hand over the decoded one */
+        p_new_pic = picture_Hold( p_pic );
+    }
     else
     {
         /* TODO: chroma conversion if needed */
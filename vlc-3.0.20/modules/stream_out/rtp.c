@@ -137,6 +137,14 @@
     "Default caching value for outbound RTP streams. This " \
     "value should be set in milliseconds." )
 
+#define BATCH_TEXT N_("Packets per send batch")
+#define BATCH_LONGTEXT N_("Maximum number of packets sent to each " \
+    "destination with a single system call. Packets due within the batch " \
+    "window are sent along with the first one. 1 disables batching." )
+#define BATCH_WINDOW_TEXT N_("Send batch window (ms)")
+#define BATCH_WINDOW_LONGTEXT N_("Packets due within this delay after the " \
+    "first packet of a batch are sent along with it." )
+
 #define PROTO_TEXT N_("Transport protocol")
 #define PROTO_LONGTEXT N_( \
     "This selects which transport protocol to use for RTP." )
@@ -152,6 +160,22 @@
     "Secure RTP requires a (non-secret) master salt value. " \
     "This must be a 28-character-long hexadecimal string.")
 
+#define SRTP_CIPHER_TEXT N_("SRTP cipher")
+#define SRTP_CIPHER_LONGTEXT N_( \
+    "Secure RTP encryption and authentication algorithms. " \
+    "AES-GCM (RFC 7714) authenticates with the cipher itself and is much " \
+    "cheaper than AES-CM with HMAC-SHA1. It also accepts a " \
+    "24-character-long salt.")
+
+#ifdef HAVE_SRTP
+static const char *const ppsz_srtp_ciphers[] = {
+    "aes-cm", "aes-gcm",
+};
+static const char *const ppsz_srtp_ciphers_text[] = {
+    N_("AES-CM with HMAC-SHA1"), N_("AES-GCM"),
+};
+#endif
+
 static const char *const ppsz_protos[] = {
     "dccp", "sctp", "tcp", "udp", "udplite",
 };
@@ -227,12 +251,19 @@ vlc_module_begin ()
               RTCP_MUX_TEXT, RTCP_MUX_LONGTEXT, false )
     add_integer( SOUT_CFG_PREFIX "caching", DEFAULT_PTS_DELAY / 1000,
                  CACHING_TEXT, CACHING_LONGTEXT, true )
+    add_integer_with_range( SOUT_CFG_PREFIX "batch", 1, 1, 1024,
+                            BATCH_TEXT, BATCH_LONGTEXT, true )
+    add_integer( SOUT_CFG_PREFIX "batch-window", 1, BATCH_WINDOW_TEXT,
+                 BATCH_WINDOW_LONGTEXT, true )
 
 #ifdef HAVE_SRTP
     add_string( SOUT_CFG_PREFIX "key", "",
                 SRTP_KEY_TEXT, SRTP_KEY_LONGTEXT, false )
     add_string( SOUT_CFG_PREFIX "salt", "",
                 SRTP_SALT_TEXT, SRTP_SALT_LONGTEXT, false )
+    add_string( SOUT_CFG_PREFIX "cipher", "aes-cm",
+                SRTP_CIPHER_TEXT, SRTP_CIPHER_LONGTEXT, true )
+        change_string_list( ppsz_srtp_ciphers, ppsz_srtp_ciphers_text )
 #endif
 
     add_bool( SOUT_CFG_PREFIX "mp4a-latm", false, RFC3016_TEXT,
@@ -263,9 +294,9 @@ vlc_module_end ()
 static const char *const ppsz_sout_options[] = {
     "dst", "name", "cat", "port", "port-audio", "port-video", "*sdp", "ttl",
     "mux", "sap", "description", "url", "email",
-    "proto", "rtcp-mux", "caching",
+    "proto", "rtcp-mux", "caching", "batch", "batch-window",
 #ifdef HAVE_SRTP
-    "key", "salt",
+    "key", "salt", "cipher",
 #endif
     "mp4a-latm", NULL
 };
@@ -370,6 +401,7 @@ struct sout_stream_id_sys_t
     int                 i_mtu;
 #ifdef HAVE_SRTP
     srtp_session_t     *srtp;
+    size_t              srtp_overhead; /* bytes appended to each packet */
 #endif
 
     /* Packets sinks */
@@ -385,6 +417,8 @@ struct sout_stream_id_sys_t
 
     block_fifo_t     *p_fifo;
     int64_t           i_caching;
+    unsigned          i_batch;
+    vlc_tick_t        i_batch_window;
 };
 
 /*****************************************************************************
@@ -982,6 +1016,12 @@ static sout_stream_id_sys_t *Add( sout_stream_t *p_stream,
     id->b_first_packet = true;
     id->i_caching =
         (int64_t)1000 * var_GetInteger( p_stream, SOUT_CFG_PREFIX "caching");
+    id->i_batch = var_GetInteger( p_stream, SOUT_CFG_PREFIX "batch" );
+#ifndef HAVE_SENDMMSG
+    id->i_batch = 1;
+#endif
+    id->i_batch_window = UINT64_C(1000)
+                   * var_GetInteger( p_stream, SOUT_CFG_PREFIX "batch-window" );
 
     vlc_rand_bytes (&id->i_sequence, sizeof (id->i_sequence));
     vlc_rand_bytes (id->ssrc, sizeof (id->ssrc));
@@ -1025,9 +1065,23 @@ static sout_stream_id_sys_t *Add( sout_stream_t *p_stream,
     char *key = var_GetNonEmptyString (p_stream, SOUT_CFG_PREFIX"key");
     if (key)
     {
+        char *cipher = var_GetString (p_stream, SOUT_CFG_PREFIX"cipher");
+        bool gcm = cipher != NULL && !strcmp (cipher, "aes-gcm");
+        free (cipher);
+
         vlc_gcrypt_init ();
-        id->srtp = srtp_create (SRTP_ENCR_AES_CM, SRTP_AUTH_HMAC_SHA1, 10,
-                                   SRTP_PRF_AES_CM, SRTP_RCC_MODE1);
+        if (gcm)
+        {
+            id->srtp = srtp_create (SRTP_ENCR_AES_GCM, SRTP_AUTH_NULL, 16,
+                                    SRTP_PRF_AES_CM, 0);
+            id->srtp_overhead = 16;
+        }
+        else
+        {
+            id->srtp = srtp_create (SRTP_ENCR_AES_CM, SRTP_AUTH_HMAC_SHA1, 10,
+                                    SRTP_PRF_AES_CM, SRTP_RCC_MODE1);
+            id->srtp_overhead = 10;
+        }
         if (id->srtp == NULL)
         {
             free (key);
@@ -1392,53 +1446,173 @@ static int  HttpCallback( httpd_file_sys_t *p_args,
 /****************************************************************************
  * RTP send
  ****************************************************************************/
-static void* ThreadSend( void *data )
-{
 #ifdef _WIN32
 # define ENOBUFS      WSAENOBUFS
 # define EAGAIN       WSAEWOULDBLOCK
 # define EWOULDBLOCK  WSAEWOULDBLOCK
 #endif
+
+#ifdef HAVE_SRTP
+/* Protects a packet in place, or releases it on error */
+static block_t *rtp_protect( sout_stream_id_sys_t *id, block_t *out )
+{
+    /* FIXME: this is awfully inefficient */
+    size_t len = out->i_buffer;
+    size_t size = len + id->srtp_overhead;
+    out = block_Realloc( out, 0, size );
+    if( unlikely(out == NULL) )
+        return NULL;
+    out->i_buffer = len;
+
+    int canc = vlc_savecancel ();
+    int val = srtp_send( id->srtp, out->p_buffer, &len, size );
+    vlc_restorecancel (canc);
+    if( val )
+    {
+        msg_Dbg( id->p_stream, "SRTP sending error: %s",
+                 vlc_strerror_c(val) );
+        block_Release( out );
+        return NULL;
+    }
+    out->i_buffer = len;
+    return out;
+}
+#endif
+
+/* Handles a send error, returns true if the sink is dead */
+static bool rtp_send_failed( int fd, const block_t *out )
+{
+    int err = net_errno;
+
+    if( err != EAGAIN
+#if EWOULDBLOCK != EAGAIN
+     && err != EWOULDBLOCK
+#endif
+     && err != ENOBUFS && err != ENOMEM )
+    {
+        int type;
+        getsockopt( fd, SOL_SOCKET, SO_TYPE,
+                    &type, &(socklen_t){ sizeof(type) });
+        if( type != SOCK_DGRAM )
+            return true; /* Broken connection */
+
+        /* ICMP soft error: ignore and retry */
+        send( fd, out->p_buffer, out->i_buffer, 0 );
+    }
+    return false;
+}
+
+/* Waits for the packet deadline, releasing the packet if cancelled */
+static void rtp_wait( block_t *out, vlc_tick_t deadline )
+{
+    block_cleanup_push (out);
+    mwait (deadline);
+    vlc_cleanup_pop ();
+}
+
+/* Sends packets to one sink, returns true if the sink is dead */
+static bool rtp_send_sink( int fd, block_t *const *pkts, unsigned count )
+{
+#ifdef HAVE_SENDMMSG
+    if( count > 1 )
+    {
+        struct mmsghdr msgs[count];
+        struct iovec iov[count];
+
+        for( unsigned i = 0; i < count; i++ )
+        {
+            memset( &msgs[i], 0, sizeof (msgs[i]) );
+            iov[i].iov_base = pkts[i]->p_buffer;
+            iov[i].iov_len = pkts[i]->i_buffer;
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        for( unsigned sent = 0; sent < count; )
+        {
+            int val = sendmmsg( fd, msgs + sent, count - sent, 0 );
+            if( val < 0 )
+            {
+                if( rtp_send_failed( fd, pkts[sent] ) )
+                    return true;
+                val = 1; /* skip the failing packet */
+            }
+            sent += val;
+        }
+        return false;
+    }
+#endif
+    for( unsigned i = 0; i < count; i++ )
+        if( send( fd, pkts[i]->p_buffer, pkts[i]->i_buffer, 0 ) == -1
+         && rtp_send_failed( fd, pkts[i] ) )
+            return true;
+    return false;
+}
+
+/*****************************************************************************
+ * ThreadSend: the deadline of the first packet of each batch paces the
+ * output. Packets due within the batch window after it are sent at the same
+ * time, with one system call per sink if possible.
+ *****************************************************************************/
+static void* ThreadSend( void *data )
+{
     sout_stream_id_sys_t *id = data;
     unsigned i_caching = id->i_caching;
+    block_t *pkts[id->i_batch];
+    block_t *next = NULL;
 
     for (;;)
     {
-        block_t *out = block_FifoGet( id->p_fifo );
-        block_cleanup_push (out);
+        block_t *out = next;
 
+        next = NULL;
+        if( out == NULL )
+            out = block_FifoGet( id->p_fifo );
 #ifdef HAVE_SRTP
         if( id->srtp )
-        {   /* FIXME: this is awfully inefficient */
-            size_t len = out->i_buffer;
-            out = block_Realloc( out, 0, len + 10 );
-            out->i_buffer = len;
-
-            int canc = vlc_savecancel ();
-            int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
-            vlc_restorecancel (canc);
-            if( val )
-            {
-                msg_Dbg( id->p_stream, "SRTP sending error: %s",
-                         vlc_strerror_c(val) );
-                block_Release( out );
-                out = NULL;
-            }
-            else
-                out->i_buffer = len;
+        {
+            out = rtp_protect( id, out );
+            if( out == NULL )
+                continue;
         }
-        if (out)
-            mwait (out->i_dts + i_caching);
-        vlc_cleanup_pop ();
-        if (out == NULL)
-            continue;
-#else
-        mwait (out->i_dts + i_caching);
-        vlc_cleanup_pop ();
 #endif
+        rtp_wait( out, out->i_dts + i_caching );
 
-        ssize_t len = out->i_buffer;
         int canc = vlc_savecancel ();
+        unsigned count = 0;
+        pkts[count++] = out;
+
+        /* Gather the packets due within the window */
+        if( id->i_batch > 1 )
+        {
+            vlc_fifo_Lock( id->p_fifo );
+            while( count < id->i_batch )
+            {
+                block_t *pkt = vlc_fifo_DequeueUnlocked( id->p_fifo );
+                if( pkt == NULL )
+                    break;
+                if( pkt->i_dts > out->i_dts + id->i_batch_window )
+                {
+                    next = pkt;
+                    break;
+                }
+                pkts[count++] = pkt;
+            }
+            vlc_fifo_Unlock( id->p_fifo );
+        }
+#ifdef HAVE_SRTP
+        if( id->srtp )
+        {
+            unsigned kept = 1;
+            for( unsigned i = 1; i < count; i++ )
+            {
+                block_t *pkt = rtp_protect( id, pkts[i] );
+                if( pkt != NULL )
+                    pkts[kept++] = pkt;
+            }
+            count = kept;
+        }
+#endif
 
         vlc_mutex_lock( &id->lock_sink );
         unsigned deadc = 0; /* How many dead sockets? */
@@ -1449,26 +1623,16 @@ static void* ThreadSend( void *data )
 #ifdef HAVE_SRTP
             if( !id->srtp ) /* FIXME: SRTCP support */
 #endif
-                SendRTCP( id->sinkv[i].rtcp, out );
+                for( unsigned j = 0; j < count; j++ )
+                    SendRTCP( id->sinkv[i].rtcp, pkts[j] );
 
-            if( send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 ) == -1
-             && net_errno != EAGAIN && net_errno != EWOULDBLOCK
-             && net_errno != ENOBUFS && net_errno != ENOMEM )
-            {
-                int type;
-                getsockopt( id->sinkv[i].rtp_fd, SOL_SOCKET, SO_TYPE,
-                            &type, &(socklen_t){ sizeof(type) });
-                if( type == SOCK_DGRAM )
-                    /* ICMP soft error: ignore and retry */
-                    send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 );
-                else
-                    /* Broken connection */
-                    deadv[deadc++] = id->sinkv[i].rtp_fd;
-            }
+            if( rtp_send_sink( id->sinkv[i].rtp_fd, pkts, count ) )
+                deadv[deadc++] = id->sinkv[i].rtp_fd;
         }
-        id->i_seq_sent_next = ntohs(((uint16_t *) out->p_buffer)[1]) + 1;
+        id->i_seq_sent_next = ntohs(((uint16_t *) pkts[count - 1]->p_buffer)[1]) + 1;
         vlc_mutex_unlock( &id->lock_sink );
-        block_Release( out );
+        for( unsigned i = 0; i < count; i++ )
+            block_Release( pkts[i] );
 
         for( unsigned i = 0; i < deadc; i++ )
         {
@@ -67,10 +67,11 @@ struct rtsp_stream_t
     unsigned        track_id;
 
     int             sessionc;
-    rtsp_session_t **sessionv;
+    rtsp_session_t **sessionv; /* sorted by session id */
 
     int             timeout;
     vlc_timer_t     timer;
+    bool            timer_armed;
 };
 
 
@@ -312,6 +313,7 @@ static void RtspUpdateTimer( rtsp_stream_t *rtsp )
     if (timeout != 0)
         timeout += rtsp->timeout * CLOCK_FREQ;
     vlc_timer_schedule(rtsp->timer, true, timeout, 0);
+    rtsp->timer_armed = timeout != 0;
 }
 
 
@@ -353,7 +355,17 @@ rtsp_session_t *RtspClientNew( rtsp_stream_t *rtsp )
     s->trackc = 0;
     s->trackv = NULL;
 
-    TAB_APPEND( rtsp->sessionc, rtsp->sessionv, s );
+    /* Keep the sessions sorted for RtspClientGet() */
+    int low = 0, high = rtsp->sessionc;
+    while( low < high )
+    {
+        int mid = low + (high - low) / 2;
+        if( rtsp->sessionv[mid]->id < s->id )
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    TAB_INSERT( rtsp->sessionc, rtsp->sessionv, s, low );
 
     return s;
 }
@@ -375,13 +387,8 @@ rtsp_session_t *RtspClientGet( rtsp_stream_t *rtsp, const char *name )
     if( errno || *end )
         return NULL;
 
-    /* FIXME: use a hash/dictionary */
-    for( i = 0; i < rtsp->sessionc; i++ )
-    {
-        if( rtsp->sessionv[i]->id == id )
-            return rtsp->sessionv[i];
-    }
-    return NULL;
+    BSEARCH( rtsp->sessionv, rtsp->sessionc, ->id, uint64_t, id, i );
+    return (i >= 0) ? rtsp->sessionv[i] : NULL;
 }
 
 
@@ -407,7 +414,10 @@ static void RtspClientAlive( rtsp_session_t *session )
         return;
 
     session->last_seen = mdate();
-    RtspUpdateTimer(session->stream);
+    /* Deadlines only move forward here: an armed timer fires early at
+     * worst, and RtspTimeOut() then reschedules it */
+    if (!session->stream->timer_armed)
+        RtspUpdateTimer(session->stream);
 }
 
 static int dup_socket(int oldfd)
@@ -37,6 +37,11 @@
  *
  * the video-data and audio-data pointers will be passed to lock/unlock function
  *
+ * Alternatively, the block callbacks hand each block over without any copy:
+ * the application receives the payload and owns it until it calls the given
+ * release function with the opaque block pointer. Blocks must be released
+ * before the LibVLC instance is.
+ *
  ******************************************************************************/
 
 /*****************************************************************************
@@ -74,6 +79,18 @@
 #define LT_AUDIO_POSTRENDER_CALLBACK N_( "Address of the audio postrender callback function. " \
                                         "This function will be called when the render is into the buffer." )
 
+#define T_VIDEO_BLOCK_CALLBACK N_( "Video block callback" )
+#define LT_VIDEO_BLOCK_CALLBACK N_( "Address of the video block callback " \
+                                    "function. This function will receive " \
+                                    "each block without copy, instead of " \
+                                    "the render callbacks." )
+
+#define T_AUDIO_BLOCK_CALLBACK N_( "Audio block callback" )
+#define LT_AUDIO_BLOCK_CALLBACK N_( "Address of the audio block callback " \
+                                    "function. This function will receive " \
+                                    "each block without copy, instead of " \
+                                    "the render callbacks." )
+
 #define T_VIDEO_DATA N_( "Video Callback data" )
 #define LT_VIDEO_DATA N_( "Data for the video callback function." )
 
@@ -107,6 +124,10 @@ vlc_module_begin ()
         change_volatile()
     add_string( SOUT_PREFIX_AUDIO "postrender-callback", "0", T_AUDIO_POSTRENDER_CALLBACK, LT_AUDIO_POSTRENDER_CALLBACK, true )
         change_volatile()
+    add_string( SOUT_PREFIX_VIDEO "block-callback", "0", T_VIDEO_BLOCK_CALLBACK, LT_VIDEO_BLOCK_CALLBACK, true )
+        change_volatile()
+    add_string( SOUT_PREFIX_AUDIO "block-callback", "0", T_AUDIO_BLOCK_CALLBACK, LT_AUDIO_BLOCK_CALLBACK, true )
+        change_volatile()
     add_string( SOUT_PREFIX_VIDEO "data", "0", T_VIDEO_DATA, LT_VIDEO_DATA, true )
         change_volatile()
     add_string( SOUT_PREFIX_AUDIO "data", "0", T_AUDIO_DATA, LT_VIDEO_DATA, true )
@@ -122,7 +143,8 @@ vlc_module_end ()
  *****************************************************************************/
 static const char *const ppsz_sout_options[] = {
     "video-prerender-callback", "audio-prerender-callback",
-    "video-postrender-callback", "audio-postrender-callback", "video-data", "audio-data", "time-sync", NULL
+    "video-postrender-callback", "audio-postrender-callback",
+    "video-block-callback", "audio-block-callback", "video-data", "audio-data", "time-sync", NULL
 };
 
 static sout_stream_id_sys_t *Add( sout_stream_t *, const es_format_t * );
@@ -139,6 +161,9 @@ static int SendVideo( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
 static int SendAudio( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                       block_t *p_buffer );
 
+typedef void ( *smem_block_callback_t ) ( void* p_data, uint8_t* p_buffer, size_t size, vlc_tick_t pts, vlc_tick_t dts,
+                                          void* p_block, void ( *pf_release ) ( void* p_block ) );
+
 struct sout_stream_id_sys_t
 {
     es_format_t format;
@@ -152,6 +177,8 @@ struct sout_stream_sys_t
     void ( *pf_audio_prerender_callback ) ( void* p_audio_data, uint8_t** pp_pcm_buffer, size_t size );
     void ( *pf_video_postrender_callback ) ( void* p_video_data, uint8_t* p_pixel_buffer, int width, int height, int pixel_pitch, size_t size, vlc_tick_t pts );
     void ( *pf_audio_postrender_callback ) ( void* p_audio_data, uint8_t* p_pcm_buffer, unsigned int channels, unsigned int rate, unsigned int nb_samples, unsigned int bits_per_sample, size_t size, vlc_tick_t pts );
+    smem_block_callback_t pf_video_block_callback;
+    smem_block_callback_t pf_audio_block_callback;
     bool time_sync;
 };
 
@@ -237,6 +264,15 @@ static int Open( vlc_object_t *p_this )
     if (p_sys->pf_audio_postrender_callback == NULL)
         p_sys->pf_audio_postrender_callback = AudioPostrenderDefaultCallback;
 
+    /* Block callbacks are optional, and replace the render callbacks */
+    psz_tmp = var_GetString( p_stream, SOUT_PREFIX_VIDEO "block-callback" );
+    p_sys->pf_video_block_callback = (smem_block_callback_t)(intptr_t)atoll( psz_tmp );
+    free( psz_tmp );
+
+    psz_tmp = var_GetString( p_stream, SOUT_PREFIX_AUDIO "block-callback" );
+    p_sys->pf_audio_block_callback = (smem_block_callback_t)(intptr_t)atoll( psz_tmp );
+    free( psz_tmp );
+
     /* Setting stream out module callbacks */
     p_stream->pf_add    = Add;
     p_stream->pf_del    = Del;
@@ -320,11 +356,13 @@ static sout_stream_id_sys_t *AddVideo( sout_stream_t *p_stream,
 static sout_stream_id_sys_t *AddAudio( sout_stream_t *p_stream,
                                        const es_format_t *p_fmt )
 {
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
     char* psz_tmp;
     sout_stream_id_sys_t* id;
     int i_bits_per_sample = aout_BitsPerSample( p_fmt->i_codec );
 
-    if( !i_bits_per_sample )
+    /* Compressed audio can only be passed through as blocks */
+    if( !i_bits_per_sample && !p_sys->pf_audio_block_callback )
     {
         msg_Err( p_stream, "Smem does only support raw audio format" );
         return NULL;
@@ -350,9 +388,39 @@ static void Del( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
     free( id );
 }
 
+static void BlockRelease( void *p_block )
+{
+    block_Release( p_block );
+}
+
+/* Hands each block of the chain over to the application, which releases it */
+static int SendBlocks( smem_block_callback_t pf_callback, void *p_data,
+                       block_t *p_buffer )
+{
+    while( p_buffer != NULL )
+    {
+        block_t *p_next = p_buffer->p_next;
+
+        p_buffer->p_next = NULL;
+        pf_callback( p_data, p_buffer->p_buffer, p_buffer->i_buffer,
+                     p_buffer->i_pts, p_buffer->i_dts, p_buffer, BlockRelease );
+        p_buffer = p_next;
+    }
+    return VLC_SUCCESS;
+}
+
 static int Send( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                  block_t *p_buffer )
 {
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    if ( id->format.i_cat == VIDEO_ES && p_sys->pf_video_block_callback )
+        return SendBlocks( p_sys->pf_video_block_callback, id->p_data,
+                           p_buffer );
+    else if ( id->format.i_cat == AUDIO_ES && p_sys->pf_audio_block_callback )
+        return SendBlocks( p_sys->pf_audio_block_callback, id->p_data,
+                           p_buffer );
+
     if ( id->format.i_cat == VIDEO_ES )
         return SendVideo( p_stream, id, p_buffer );
     else if ( id->format.i_cat == AUDIO_ES )
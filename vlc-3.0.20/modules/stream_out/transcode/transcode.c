@@ -81,6 +81,13 @@
     "Video filters will be applied to the video streams (after overlays " \
     "are applied). You can enter a colon-separated list of filters." )
 
+#define RUNGS_TEXT N_("Video ladder rungs")
+#define RUNGS_LONGTEXT N_( \
+    "Comma-separated list of additional renditions of the video, as " \
+    "WIDTHxHEIGHT@BITRATE (in kb/s). The video is decoded and filtered " \
+    "once, then scaled and encoded for each rung. Rung N is output as a " \
+    "separate ES, with the id of the source ES plus N*1000." )
+
 #define AENC_TEXT N_("Audio encoder")
 #define AENC_LONGTEXT N_( \
     "This is the audio encoder module that will be used (and its associated "\
@@ -129,7 +136,18 @@
     "VIDEO." )
 #define POOL_TEXT N_("Picture pool size")
 #define POOL_LONGTEXT N_( "Defines how many pictures we allow to be in pool "\
-    "between decoder/encoder threads when threads > 0" )
+    "between the decoder, filter and encoder threads when threads > 0" )
+#define SEGMENTS_TEXT N_("Parallel video segments")
+#define SEGMENTS_LONGTEXT N_( \
+    "For offline conversions: the video is cut into segments, each of " \
+    "them starting with a keyframe, and this many segments are encoded " \
+    "at once by separate instances of the encoder, then output in order. " \
+    "The rate control restarts with every segment. This buffers up to " \
+    "that many segments of decoded pictures; 0 disables it." )
+#define SEGLEN_TEXT N_("Video segment length")
+#define SEGLEN_LONGTEXT N_( \
+    "Number of pictures of each video segment, when encoding segments " \
+    "in parallel." )
 
 
 static const char *const ppsz_deinterlace_type[] =
@@ -178,6 +196,8 @@ vlc_module_begin ()
                  MAXHEIGHT_LONGTEXT, true )
     add_module_list( SOUT_CFG_PREFIX "vfilter", "video filter",
                      NULL, VFILTER_TEXT, VFILTER_LONGTEXT, false )
+    add_string( SOUT_CFG_PREFIX "rungs", NULL, RUNGS_TEXT,
+                RUNGS_LONGTEXT, true )
 
     set_section( N_("Audio"), NULL )
     add_module( SOUT_CFG_PREFIX "aenc", "encoder", NULL, AENC_TEXT,
@@ -213,6 +233,12 @@ vlc_module_begin ()
                  THREADS_LONGTEXT, true )
     add_integer( SOUT_CFG_PREFIX "pool-size", 10, POOL_TEXT, POOL_LONGTEXT, true )
         change_integer_range( 1, 1000 )
+    add_integer( SOUT_CFG_PREFIX "segments", 0, SEGMENTS_TEXT,
+                 SEGMENTS_LONGTEXT, true )
+        change_integer_range( 0, 64 )
+    add_integer( SOUT_CFG_PREFIX "segment-length", 100, SEGLEN_TEXT,
+                 SEGLEN_LONGTEXT, true )
+        change_integer_range( 1, 100000 )
     add_bool( SOUT_CFG_PREFIX "high-priority", false, HP_TEXT, HP_LONGTEXT,
               true )
 
@@ -224,7 +250,7 @@ static const char *const ppsz_sout_options[] = {
     "deinterlace-module", "threads", "aenc", "acodec", "ab", "alang",
     "afilter", "samplerate", "channels", "senc", "scodec", "soverlay",
     "sfilter", "high-priority", "maxwidth", "maxheight", "pool-size",
-    NULL
+    "rungs", "segments", "segment-length", NULL
 };
 
 /*****************************************************************************
@@ -234,6 +260,50 @@ static sout_stream_id_sys_t *Add( sout_stream_t *, const es_format_t * );
 static void              Del ( sout_stream_t *, sout_stream_id_sys_t * );
 static int               Send( sout_stream_t *, sout_stream_id_sys_t *, block_t* );
 
+/* Parses the rungs of the video ladder: WIDTHxHEIGHT@BITRATE, where either
+ * dimension can be 0 to keep the aspect ratio, and the bitrate can be
+ * omitted to use the main one. */
+static void ParseRungs( sout_stream_t *p_stream, sout_stream_sys_t *p_sys,
+                        char *psz_rungs )
+{
+    char *psz_save;
+
+    for( char *psz_rung = strtok_r( psz_rungs, ",", &psz_save );
+         psz_rung != NULL; psz_rung = strtok_r( NULL, ",", &psz_save ) )
+    {
+        transcode_rung_cfg_t cfg = { 0, 0, 0 };
+        char *end;
+
+        cfg.i_width = strtoul( psz_rung, &end, 10 );
+        if( *end == 'x' )
+            cfg.i_height = strtoul( end + 1, &end, 10 );
+        if( *end == '@' )
+            cfg.i_bitrate = strtol( end + 1, &end, 10 );
+
+        if( *end != '\0' || ( cfg.i_width == 0 && cfg.i_height == 0 )
+         || cfg.i_bitrate < 0 )
+        {
+            msg_Warn( p_stream, "ignoring invalid rung \"%s\"", psz_rung );
+            continue;
+        }
+        if( cfg.i_bitrate == 0 )
+            cfg.i_bitrate = p_sys->i_vbitrate;
+        else if( cfg.i_bitrate < 16000 )
+            cfg.i_bitrate *= 1000;
+
+        transcode_rung_cfg_t *p_rungs =
+            realloc( p_sys->p_rungs_cfg,
+                     ( p_sys->i_rungs + 1 ) * sizeof( *p_rungs ) );
+        if( unlikely( p_rungs == NULL ) )
+            break;
+        p_rungs[p_sys->i_rungs++] = cfg;
+        p_sys->p_rungs_cfg = p_rungs;
+
+        msg_Dbg( p_stream, "video rung %zu: %ux%u %dkb/s", p_sys->i_rungs,
+                 cfg.i_width, cfg.i_height, cfg.i_bitrate / 1000 );
+    }
+}
+
 /*****************************************************************************
  * Open:
  *****************************************************************************/
@@ -355,6 +425,11 @@ static int Open( vlc_object_t *p_this )
         p_sys->psz_vf2 = NULL;
     free( psz_string );
 
+    psz_string = var_GetString( p_stream, SOUT_CFG_PREFIX "rungs" );
+    if( psz_string && *psz_string )
+        ParseRungs( p_stream, p_sys, psz_string );
+    free( psz_string );
+
     if( var_GetBool( p_stream, SOUT_CFG_PREFIX "deinterlace" ) )
         psz_string = var_GetString( p_stream,
                                     SOUT_CFG_PREFIX "deinterlace-module" );
@@ -367,6 +442,9 @@ static int Open( vlc_object_t *p_this )
 
     p_sys->i_threads = var_GetInteger( p_stream, SOUT_CFG_PREFIX "threads" );
     p_sys->pool_size = var_GetInteger( p_stream, SOUT_CFG_PREFIX "pool-size" );
+    p_sys->i_segments = var_GetInteger( p_stream, SOUT_CFG_PREFIX "segments" );
+    p_sys->i_segment_length =
+        var_GetInteger( p_stream, SOUT_CFG_PREFIX "segment-length" );
     p_sys->b_high_priority = var_GetBool( p_stream, SOUT_CFG_PREFIX "high-priority" );
 
     if( p_sys->i_vcodec )
@@ -442,6 +520,7 @@ static void Close( vlc_object_t * p_this )
     free( p_sys->psz_alang );
 
     free( p_sys->psz_vf2 );
+    free( p_sys->p_rungs_cfg );
 
     config_ChainDestroy( p_sys->p_video_cfg );
     free( p_sys->psz_venc );
@@ -14,17 +14,92 @@
 /*100ms is around the limit where people are noticing lipsync issues*/
 #define MASTER_SYNC_MAX_DRIFT 100000
 
-struct sout_stream_sys_t
+/* ES id offset between two rungs of the video ladder */
+#define TRANSCODE_RUNG_ID_STEP 1000
+
+/* Segment of the video, encoded from a keyframe by its own instance of the
+ * encoder */
+typedef struct transcode_vsegment_t transcode_vsegment_t;
+struct transcode_vsegment_t
 {
-    sout_stream_id_sys_t *id_video;
-    block_t         *p_buffers;
+    transcode_vsegment_t *p_next;
+    encoder_t       *p_encoder;
+    picture_t       *p_pics;        /**< pictures waiting to be encoded */
+    picture_t       **pp_pics_last;
+    unsigned int    i_pics;         /**< pictures queued so far */
+    block_t         *p_blocks;      /**< encoded data, once done */
+    bool            b_closed;       /**< no more pictures will be queued */
+    bool            b_taken;        /**< picked up by a worker thread */
+    bool            b_done;
+};
+
+/* Segment-parallel encoding, for offline conversions: several segments are
+ * encoded at once by worker threads, and output in order */
+typedef struct
+{
+    sout_stream_t   *p_stream;
+    vlc_thread_t    *p_threads;
+    unsigned int    i_threads;
+    vlc_mutex_t     lock;
+    vlc_cond_t      wait;           /**< signaled when work is queued */
+    vlc_cond_t      done;           /**< signaled when a segment is done */
+    transcode_vsegment_t *p_first;  /**< segments, in output order */
+    transcode_vsegment_t *p_last;   /**< segment being fed */
+    unsigned int    i_busy;         /**< segments not done yet */
+    bool            b_abort;
+} transcode_vseg_t;
+
+/* Video encoder, and the thread feeding it when threads are enabled */
+typedef struct
+{
+    encoder_t       *p_encoder;
+    transcode_vseg_t *p_seg;        /**< segment workers, replacing thread */
+
+    vlc_thread_t    thread;
     vlc_mutex_t     lock_out;
     vlc_cond_t      cond;
     bool            b_abort;
     picture_fifo_t *pp_pics;
     vlc_sem_t       picture_pool_has_room;
-    uint32_t        pool_size;
+    block_t         *p_buffers;
+} transcode_venc_t;
+
+/* Video filters stage, run by its own thread when threads are enabled, so
+ * that decoding, filtering and encoding are pipelined */
+typedef struct
+{
+    sout_stream_t   *p_stream;
+
     vlc_thread_t    thread;
+    vlc_mutex_t     lock;
+    vlc_cond_t      wait;       /**< signaled when a picture is queued */
+    vlc_cond_t      idle;       /**< signaled when a picture is filtered */
+    picture_fifo_t  *pp_pics;
+    unsigned int    i_pending;  /**< queued or being filtered pictures */
+    bool            b_abort;
+} transcode_vfilter_t;
+
+/* Additional rung of the video ladder: the decoded and filtered pictures
+ * are scaled and encoded once per rung */
+typedef struct
+{
+    unsigned int    i_width;
+    unsigned int    i_height;
+    int             i_bitrate;
+} transcode_rung_cfg_t;
+
+typedef struct
+{
+    transcode_venc_t venc;
+    filter_chain_t  *p_cf_chain; /**< Scaling and chroma conversion */
+    void            *id;         /**< id of the out stream */
+} transcode_rung_t;
+
+struct sout_stream_sys_t
+{
+    uint32_t        pool_size;
+    unsigned int    i_segments;
+    unsigned int    i_segment_length;
 
     /* Audio */
     vlc_fourcc_t    i_acodec;   /* codec audio (0 if not transcode) */
@@ -54,6 +129,9 @@ struct sout_stream_sys_t
 
     char            *psz_vf2;
 
+    transcode_rung_cfg_t *p_rungs_cfg;
+    size_t          i_rungs;
+
     /* SPU */
     vlc_fourcc_t    i_scodec;   /* codec spu (0 if not transcode) */
     char            *psz_senc;
@@ -107,6 +185,11 @@ struct sout_stream_id_sys_t
          {
              filter_chain_t  *p_f_chain; /**< Video filters */
              filter_chain_t  *p_uf_chain; /**< User-specified video filters */
+             filter_chain_t  *p_cf_chain; /**< Conversion, with a ladder */
+             transcode_vfilter_t vfilter;
+             transcode_venc_t venc;
+             transcode_rung_t *p_rungs;
+             size_t           i_rungs;
              video_format_t  fmt_input_video;
              video_format_t  video_dec_out; /* only rw from pf_vout_format_update() */
          };
@@ -103,58 +103,590 @@ static picture_t *transcode_video_filter_buffer_new( filter_t *p_filter )
 
 static void* EncoderThread( void *obj )
 {
-    sout_stream_sys_t *p_sys = (sout_stream_sys_t*)obj;
-    sout_stream_id_sys_t *id = p_sys->id_video;
+    transcode_venc_t *venc = obj;
+    encoder_t *p_enc = venc->p_encoder;
     picture_t *p_pic = NULL;
     int canc = vlc_savecancel ();
     block_t *p_block = NULL;
 
-    vlc_mutex_lock( &p_sys->lock_out );
+    vlc_mutex_lock( &venc->lock_out );
 
     for( ;; )
     {
-        while( !p_sys->b_abort &&
-               (p_pic = picture_fifo_Pop( p_sys->pp_pics )) == NULL )
-            vlc_cond_wait( &p_sys->cond, &p_sys->lock_out );
-        vlc_sem_post( &p_sys->picture_pool_has_room );
+        while( !venc->b_abort &&
+               (p_pic = picture_fifo_Pop( venc->pp_pics )) == NULL )
+            vlc_cond_wait( &venc->cond, &venc->lock_out );
+        vlc_sem_post( &venc->picture_pool_has_room );
 
         if( p_pic )
         {
             /* release lock while encoding */
-            vlc_mutex_unlock( &p_sys->lock_out );
-            p_block = id->p_encoder->pf_encode_video( id->p_encoder, p_pic );
+            vlc_mutex_unlock( &venc->lock_out );
+            p_block = p_enc->pf_encode_video( p_enc, p_pic );
             picture_Release( p_pic );
-            vlc_mutex_lock( &p_sys->lock_out );
+            vlc_mutex_lock( &venc->lock_out );
 
-            block_ChainAppend( &p_sys->p_buffers, p_block );
+            block_ChainAppend( &venc->p_buffers, p_block );
         }
 
-        if( p_sys->b_abort )
+        if( venc->b_abort )
             break;
     }
 
     /*Encode what we have in the buffer on closing*/
-    while( (p_pic = picture_fifo_Pop( p_sys->pp_pics )) != NULL )
+    while( (p_pic = picture_fifo_Pop( venc->pp_pics )) != NULL )
     {
-        vlc_sem_post( &p_sys->picture_pool_has_room );
-        p_block = id->p_encoder->pf_encode_video( id->p_encoder, p_pic );
+        vlc_sem_post( &venc->picture_pool_has_room );
+        p_block = p_enc->pf_encode_video( p_enc, p_pic );
         picture_Release( p_pic );
-        block_ChainAppend( &p_sys->p_buffers, p_block );
+        block_ChainAppend( &venc->p_buffers, p_block );
     }
 
     /*Now flush encoder*/
-    do {
-        p_block = id->p_encoder->pf_encode_video(id->p_encoder, NULL );
-        block_ChainAppend( &p_sys->p_buffers, p_block );
-    } while( p_block );
+    if( p_enc->p_module )
+    {
+        do {
+            p_block = p_enc->pf_encode_video( p_enc, NULL );
+            block_ChainAppend( &venc->p_buffers, p_block );
+        } while( p_block );
+    }
 
-    vlc_mutex_unlock( &p_sys->lock_out );
+    vlc_mutex_unlock( &venc->lock_out );
 
     vlc_restorecancel (canc);
 
     return NULL;
 }
 
+static void transcode_vsegment_delete( transcode_vsegment_t *seg )
+{
+    encoder_t *p_enc = seg->p_encoder;
+
+    while( seg->p_pics != NULL )
+    {
+        picture_t *p_pic = seg->p_pics;
+        seg->p_pics = p_pic->p_next;
+        picture_Release( p_pic );
+    }
+    block_ChainRelease( seg->p_blocks );
+
+    if( p_enc->p_module )
+        module_unneed( p_enc, p_enc->p_module );
+    es_format_Clean( &p_enc->fmt_in );
+    es_format_Clean( &p_enc->fmt_out );
+    vlc_object_release( p_enc );
+    free( seg );
+}
+
+/* Creates a segment, with a new encoder configured as the opened one */
+static transcode_vsegment_t *transcode_vsegment_new( sout_stream_t *p_stream,
+                                                     const encoder_t *p_model )
+{
+    transcode_vsegment_t *seg = malloc( sizeof( *seg ) );
+    if( unlikely( seg == NULL ) )
+        return NULL;
+
+    encoder_t *p_enc = sout_EncoderCreate( p_stream );
+    if( unlikely( p_enc == NULL ) )
+    {
+        free( seg );
+        return NULL;
+    }
+    p_enc->p_module = NULL;
+    es_format_Copy( &p_enc->fmt_in, &p_model->fmt_in );
+    es_format_Copy( &p_enc->fmt_out, &p_model->fmt_out );
+    /* The new encoder outputs its own headers */
+    free( p_enc->fmt_out.p_extra );
+    p_enc->fmt_out.p_extra = NULL;
+    p_enc->fmt_out.i_extra = 0;
+    p_enc->i_threads = p_model->i_threads;
+    p_enc->p_cfg = p_model->p_cfg;
+
+    seg->p_next = NULL;
+    seg->p_encoder = p_enc;
+    seg->p_pics = NULL;
+    seg->pp_pics_last = &seg->p_pics;
+    seg->i_pics = 0;
+    seg->p_blocks = NULL;
+    seg->b_closed = seg->b_taken = seg->b_done = false;
+    return seg;
+}
+
+/* Encodes the pictures of a segment as they are queued, until it is closed.
+ * Called with the lock held. */
+static block_t *SegmentEncode( transcode_vseg_t *vseg,
+                               transcode_vsegment_t *seg )
+{
+    sout_stream_t *p_stream = vseg->p_stream;
+    encoder_t *p_enc = seg->p_encoder;
+    const vlc_fourcc_t i_chroma = p_enc->fmt_in.i_codec;
+    block_t *p_blocks = NULL;
+
+    vlc_mutex_unlock( &vseg->lock );
+    p_enc->p_module = module_need( p_enc, "encoder",
+                                   p_stream->p_sys->psz_venc, true );
+    if( p_enc->p_module == NULL )
+        msg_Err( p_stream, "cannot open segment video encoder" );
+    else if( p_enc->fmt_in.i_codec != i_chroma )
+    {
+        msg_Err( p_stream, "segment encoder chroma %4.4s differs from %4.4s",
+                 (const char *)&p_enc->fmt_in.i_codec,
+                 (const char *)&i_chroma );
+        module_unneed( p_enc, p_enc->p_module );
+        p_enc->p_module = NULL;
+    }
+    vlc_mutex_lock( &vseg->lock );
+
+    for( ;; )
+    {
+        picture_t *p_pic = seg->p_pics;
+
+        if( p_pic == NULL )
+        {
+            if( seg->b_closed || vseg->b_abort )
+                break;
+            vlc_cond_wait( &vseg->wait, &vseg->lock );
+            continue;
+        }
+        seg->p_pics = p_pic->p_next;
+        if( seg->p_pics == NULL )
+            seg->pp_pics_last = &seg->p_pics;
+        p_pic->p_next = NULL;
+        vlc_mutex_unlock( &vseg->lock );
+
+        if( p_enc->p_module )
+            block_ChainAppend( &p_blocks, p_enc->pf_encode_video( p_enc, p_pic ) );
+        picture_Release( p_pic );
+
+        vlc_mutex_lock( &vseg->lock );
+    }
+    vlc_mutex_unlock( &vseg->lock );
+
+    /* Flush the delayed pictures: the next segment starts from scratch */
+    if( p_enc->p_module )
+    {
+        block_t *p_block;
+        do {
+            p_block = p_enc->pf_encode_video( p_enc, NULL );
+            block_ChainAppend( &p_blocks, p_block );
+        } while( p_block );
+        module_unneed( p_enc, p_enc->p_module );
+        p_enc->p_module = NULL;
+    }
+
+    vlc_mutex_lock( &vseg->lock );
+    return p_blocks;
+}
+
+static void *SegmentThread( void *data )
+{
+    transcode_vseg_t *vseg = data;
+    int canc = vlc_savecancel();
+
+    vlc_mutex_lock( &vseg->lock );
+    while( !vseg->b_abort )
+    {
+        transcode_vsegment_t *seg = vseg->p_first;
+
+        while( seg != NULL && seg->b_taken )
+            seg = seg->p_next;
+        if( seg == NULL )
+        {
+            vlc_cond_wait( &vseg->wait, &vseg->lock );
+            continue;
+        }
+        seg->b_taken = true;
+
+        seg->p_blocks = SegmentEncode( vseg, seg );
+        seg->b_done = true;
+        vseg->i_busy--;
+        vlc_cond_broadcast( &vseg->done );
+    }
+    vlc_mutex_unlock( &vseg->lock );
+
+    vlc_restorecancel( canc );
+    return NULL;
+}
+
+static void transcode_vseg_stop( transcode_vseg_t *vseg )
+{
+    vlc_mutex_lock( &vseg->lock );
+    vseg->b_abort = true;
+    vlc_cond_broadcast( &vseg->wait );
+    vlc_mutex_unlock( &vseg->lock );
+
+    for( unsigned int i = 0; i < vseg->i_threads; i++ )
+        vlc_join( vseg->p_threads[i], NULL );
+
+    while( vseg->p_first != NULL )
+    {
+        transcode_vsegment_t *seg = vseg->p_first;
+        vseg->p_first = seg->p_next;
+        transcode_vsegment_delete( seg );
+    }
+    vlc_mutex_destroy( &vseg->lock );
+    vlc_cond_destroy( &vseg->wait );
+    vlc_cond_destroy( &vseg->done );
+    free( vseg->p_threads );
+    free( vseg );
+}
+
+static transcode_vseg_t *transcode_vseg_start( sout_stream_t *p_stream )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    int i_priority = p_sys->b_high_priority ? VLC_THREAD_PRIORITY_OUTPUT :
+                       VLC_THREAD_PRIORITY_VIDEO;
+
+    transcode_vseg_t *vseg = malloc( sizeof( *vseg ) );
+    if( unlikely( vseg == NULL ) )
+        return NULL;
+    vseg->p_threads = vlc_alloc( p_sys->i_segments, sizeof( vlc_thread_t ) );
+    if( unlikely( vseg->p_threads == NULL ) )
+    {
+        free( vseg );
+        return NULL;
+    }
+
+    vseg->p_stream = p_stream;
+    vseg->i_threads = 0;
+    vlc_mutex_init( &vseg->lock );
+    vlc_cond_init( &vseg->wait );
+    vlc_cond_init( &vseg->done );
+    vseg->p_first = vseg->p_last = NULL;
+    vseg->i_busy = 0;
+    vseg->b_abort = false;
+
+    while( vseg->i_threads < p_sys->i_segments )
+    {
+        if( vlc_clone( &vseg->p_threads[vseg->i_threads], SegmentThread,
+                       vseg, i_priority ) )
+        {
+            msg_Err( p_stream, "cannot spawn segment encoder thread" );
+            transcode_vseg_stop( vseg );
+            return NULL;
+        }
+        vseg->i_threads++;
+    }
+    return vseg;
+}
+
+/* Queues a picture to the segment being fed, or to a new segment once it is
+ * full. This blocks while all the workers are busy. */
+static void transcode_vseg_push( transcode_vseg_t *vseg,
+                                 const encoder_t *p_model, picture_t *p_pic )
+{
+    const unsigned int i_length = vseg->p_stream->p_sys->i_segment_length;
+
+    vlc_mutex_lock( &vseg->lock );
+    transcode_vsegment_t *seg = vseg->p_last;
+
+    if( seg == NULL || seg->b_closed || seg->i_pics >= i_length )
+    {
+        if( seg != NULL && !seg->b_closed )
+        {
+            seg->b_closed = true;
+            vlc_cond_broadcast( &vseg->wait );
+        }
+        while( vseg->i_busy >= vseg->i_threads )
+            vlc_cond_wait( &vseg->done, &vseg->lock );
+
+        seg = transcode_vsegment_new( vseg->p_stream, p_model );
+        if( unlikely( seg == NULL ) )
+        {
+            vlc_mutex_unlock( &vseg->lock );
+            picture_Release( p_pic );
+            return;
+        }
+        if( vseg->p_last != NULL )
+            vseg->p_last->p_next = seg;
+        else
+            vseg->p_first = seg;
+        vseg->p_last = seg;
+        vseg->i_busy++;
+    }
+
+    *seg->pp_pics_last = p_pic;
+    seg->pp_pics_last = &p_pic->p_next;
+    seg->i_pics++;
+    vlc_cond_broadcast( &vseg->wait );
+    vlc_mutex_unlock( &vseg->lock );
+}
+
+/* Picks up the data of the segments done, in order */
+static block_t *transcode_vseg_get_buffers( transcode_vseg_t *vseg )
+{
+    block_t *p_buffers = NULL;
+
+    vlc_mutex_lock( &vseg->lock );
+    while( vseg->p_first != NULL && vseg->p_first->b_done )
+    {
+        transcode_vsegment_t *seg = vseg->p_first;
+
+        vseg->p_first = seg->p_next;
+        if( vseg->p_first == NULL )
+            vseg->p_last = NULL;
+        block_ChainAppend( &p_buffers, seg->p_blocks );
+        seg->p_blocks = NULL;
+        transcode_vsegment_delete( seg );
+    }
+    vlc_mutex_unlock( &vseg->lock );
+
+    return p_buffers;
+}
+
+/* Closes the segment being fed, and waits for all the segments to be done */
+static void transcode_vseg_drain( transcode_vseg_t *vseg )
+{
+    vlc_mutex_lock( &vseg->lock );
+    if( vseg->p_last != NULL )
+        vseg->p_last->b_closed = true;
+    vlc_cond_broadcast( &vseg->wait );
+    while( vseg->i_busy > 0 )
+        vlc_cond_wait( &vseg->done, &vseg->lock );
+    vlc_mutex_unlock( &vseg->lock );
+}
+
+static int transcode_venc_start( sout_stream_t *p_stream,
+                                 transcode_venc_t *venc )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    int i_priority = p_sys->b_high_priority ? VLC_THREAD_PRIORITY_OUTPUT :
+                       VLC_THREAD_PRIORITY_VIDEO;
+
+    if( p_sys->i_segments > 0 )
+    {
+        venc->p_seg = transcode_vseg_start( p_stream );
+        return venc->p_seg != NULL ? VLC_SUCCESS : VLC_EGENERIC;
+    }
+
+    venc->pp_pics = picture_fifo_New();
+    if( venc->pp_pics == NULL )
+    {
+        msg_Err( p_stream, "cannot create picture fifo" );
+        return VLC_ENOMEM;
+    }
+
+    /* Pictures queued ahead of an encoder that holds few of them only add
+     * latency */
+    unsigned i_room = p_sys->pool_size;
+    if( venc->p_encoder->i_delay >= 0 )
+        i_room = __MIN( i_room, (unsigned)venc->p_encoder->i_delay + 2 );
+    vlc_sem_init( &venc->picture_pool_has_room, i_room );
+    vlc_mutex_init( &venc->lock_out );
+    vlc_cond_init( &venc->cond );
+    venc->p_buffers = NULL;
+    venc->b_abort = false;
+    if( vlc_clone( &venc->thread, EncoderThread, venc, i_priority ) )
+    {
+        msg_Err( p_stream, "cannot spawn encoder thread" );
+        vlc_mutex_destroy( &venc->lock_out );
+        vlc_cond_destroy( &venc->cond );
+        vlc_sem_destroy( &venc->picture_pool_has_room );
+        picture_fifo_Delete( venc->pp_pics );
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+/* Makes the encoder thread encode the queued pictures, flush the encoder
+ * and exit */
+static void transcode_venc_drain( transcode_venc_t *venc )
+{
+    vlc_mutex_lock( &venc->lock_out );
+    venc->b_abort = true;
+    vlc_cond_signal( &venc->cond );
+    vlc_mutex_unlock( &venc->lock_out );
+
+    vlc_join( venc->thread, NULL );
+}
+
+static void transcode_venc_stop( sout_stream_t *p_stream,
+                                 transcode_venc_t *venc )
+{
+    if( venc->p_seg != NULL )
+    {
+        transcode_vseg_stop( venc->p_seg );
+        venc->p_seg = NULL;
+        return;
+    }
+    if( p_stream->p_sys->i_threads < 1 )
+        return;
+
+    if( !venc->b_abort )
+        transcode_venc_drain( venc );
+
+    picture_fifo_Delete( venc->pp_pics );
+    block_ChainRelease( venc->p_buffers );
+    vlc_mutex_destroy( &venc->lock_out );
+    vlc_cond_destroy( &venc->cond );
+    vlc_sem_destroy( &venc->picture_pool_has_room );
+}
+
+/* Picks up the data the encoder thread wants to output */
+static block_t *transcode_venc_get_buffers( transcode_venc_t *venc )
+{
+    if( venc->p_seg != NULL )
+        return transcode_vseg_get_buffers( venc->p_seg );
+
+    vlc_mutex_lock( &venc->lock_out );
+    block_t *p_buffers = venc->p_buffers;
+    venc->p_buffers = NULL;
+    vlc_mutex_unlock( &venc->lock_out );
+
+    return p_buffers;
+}
+
+/* Drains the encoder, once the last picture was output */
+static void transcode_venc_flush( sout_stream_t *p_stream,
+                                  transcode_venc_t *venc, block_t **out )
+{
+    encoder_t *p_enc = venc->p_encoder;
+
+    if( venc->p_seg != NULL )
+    {
+        transcode_vseg_drain( venc->p_seg );
+        block_ChainAppend( out, transcode_vseg_get_buffers( venc->p_seg ) );
+    }
+    else if( p_stream->p_sys->i_threads == 0 )
+    {
+        if( p_enc->p_module )
+        {
+            block_t *p_block;
+            do {
+                p_block = p_enc->pf_encode_video( p_enc, NULL );
+                block_ChainAppend( out, p_block );
+            } while( p_block );
+        }
+    }
+    else
+    {
+        msg_Dbg( p_stream, "Flushing thread and waiting that");
+        transcode_venc_drain( venc );
+        block_ChainAppend( out, transcode_venc_get_buffers( venc ) );
+        msg_Dbg( p_stream, "Flushing done");
+    }
+}
+
+static void transcode_video_filter_run( sout_stream_t *, sout_stream_id_sys_t *,
+                                        picture_t *, block_t ** );
+
+static void *FilterThread( void *data )
+{
+    sout_stream_id_sys_t *id = data;
+    transcode_vfilter_t *vfilter = &id->vfilter;
+    int canc = vlc_savecancel();
+
+    vlc_mutex_lock( &vfilter->lock );
+    for( ;; )
+    {
+        picture_t *p_pic;
+
+        while( (p_pic = picture_fifo_Pop( vfilter->pp_pics )) == NULL &&
+               !vfilter->b_abort )
+            vlc_cond_wait( &vfilter->wait, &vfilter->lock );
+        if( p_pic == NULL )
+            break;
+        vlc_mutex_unlock( &vfilter->lock );
+
+        /* The encoders are threaded too: their output is picked up by the
+         * sout thread, which is the only one to use the next stream. */
+        block_t *p_out = NULL;
+        transcode_video_filter_run( vfilter->p_stream, id, p_pic, &p_out );
+        assert( p_out == NULL );
+
+        vlc_mutex_lock( &vfilter->lock );
+        vfilter->i_pending--;
+        vlc_cond_signal( &vfilter->idle );
+    }
+    vlc_mutex_unlock( &vfilter->lock );
+
+    vlc_restorecancel( canc );
+    return NULL;
+}
+
+static int transcode_vfilter_start( sout_stream_t *p_stream,
+                                    sout_stream_id_sys_t *id )
+{
+    transcode_vfilter_t *vfilter = &id->vfilter;
+    int i_priority = p_stream->p_sys->b_high_priority ?
+                       VLC_THREAD_PRIORITY_OUTPUT : VLC_THREAD_PRIORITY_VIDEO;
+
+    vfilter->pp_pics = picture_fifo_New();
+    if( vfilter->pp_pics == NULL )
+        return VLC_ENOMEM;
+
+    vfilter->p_stream = p_stream;
+    vlc_mutex_init( &vfilter->lock );
+    vlc_cond_init( &vfilter->wait );
+    vlc_cond_init( &vfilter->idle );
+    vfilter->i_pending = 0;
+    vfilter->b_abort = false;
+    if( vlc_clone( &vfilter->thread, FilterThread, id, i_priority ) )
+    {
+        msg_Err( p_stream, "cannot spawn filter thread" );
+        vlc_mutex_destroy( &vfilter->lock );
+        vlc_cond_destroy( &vfilter->wait );
+        vlc_cond_destroy( &vfilter->idle );
+        picture_fifo_Delete( vfilter->pp_pics );
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static void transcode_vfilter_stop( sout_stream_t *p_stream,
+                                    sout_stream_id_sys_t *id )
+{
+    transcode_vfilter_t *vfilter = &id->vfilter;
+
+    if( p_stream->p_sys->i_threads < 1 )
+        return;
+
+    vlc_mutex_lock( &vfilter->lock );
+    vfilter->b_abort = true;
+    vlc_cond_signal( &vfilter->wait );
+    vlc_mutex_unlock( &vfilter->lock );
+    vlc_join( vfilter->thread, NULL );
+
+    picture_fifo_Delete( vfilter->pp_pics );
+    vlc_mutex_destroy( &vfilter->lock );
+    vlc_cond_destroy( &vfilter->wait );
+    vlc_cond_destroy( &vfilter->idle );
+}
+
+/* Queues a decoded picture to the filter thread. This blocks the decoder
+ * while pool-size pictures are already pending. */
+static void transcode_vfilter_push( sout_stream_t *p_stream,
+                                    sout_stream_id_sys_t *id,
+                                    picture_t *p_pic )
+{
+    transcode_vfilter_t *vfilter = &id->vfilter;
+    const unsigned int i_max = __MAX( p_stream->p_sys->pool_size, 1 );
+
+    vlc_mutex_lock( &vfilter->lock );
+    while( vfilter->i_pending >= i_max )
+        vlc_cond_wait( &vfilter->idle, &vfilter->lock );
+    picture_fifo_Push( vfilter->pp_pics, p_pic );
+    vfilter->i_pending++;
+    vlc_cond_signal( &vfilter->wait );
+    vlc_mutex_unlock( &vfilter->lock );
+}
+
+/* Waits for the filter thread to be done with all the queued pictures, so
+ * that the filter chains and encoders can be changed, or drained */
+static void transcode_vfilter_wait( sout_stream_t *p_stream,
+                                    sout_stream_id_sys_t *id )
+{
+    transcode_vfilter_t *vfilter = &id->vfilter;
+
+    if( p_stream->p_sys->i_threads < 1 )
+        return;
+
+    vlc_mutex_lock( &vfilter->lock );
+    while( vfilter->i_pending > 0 )
+        vlc_cond_wait( &vfilter->idle, &vfilter->lock );
+    vlc_mutex_unlock( &vfilter->lock );
+}
+
 static int decoder_queue_video( decoder_t *p_dec, picture_t *p_pic )
 {
     sout_stream_id_sys_t *id = p_dec->p_queue_ctx;
@@ -265,32 +797,17 @@ static int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_sys_t *i
     id->p_encoder->fmt_in.video.i_chroma = id->p_encoder->fmt_in.i_codec;
     id->p_encoder->p_module = NULL;
 
-    if( p_sys->i_threads <= 0 )
-        return VLC_SUCCESS;
-
-    int i_priority = p_sys->b_high_priority ? VLC_THREAD_PRIORITY_OUTPUT :
-                       VLC_THREAD_PRIORITY_VIDEO;
-    p_sys->id_video = id;
-    p_sys->pp_pics = picture_fifo_New();
-    if( p_sys->pp_pics == NULL )
+    id->venc.p_encoder = id->p_encoder;
+    if( ( p_sys->i_threads >= 1 || p_sys->i_segments > 0 ) &&
+        transcode_venc_start( p_stream, &id->venc ) )
     {
-        msg_Err( p_stream, "cannot create picture fifo" );
         module_unneed( id->p_decoder, id->p_decoder->p_module );
         id->p_decoder->p_module = NULL;
-        return VLC_ENOMEM;
+        return VLC_EGENERIC;
     }
-
-    vlc_sem_init( &p_sys->picture_pool_has_room, p_sys->pool_size );
-    vlc_mutex_init( &p_sys->lock_out );
-    vlc_cond_init( &p_sys->cond );
-    p_sys->p_buffers = NULL;
-    p_sys->b_abort = false;
-    if( vlc_clone( &p_sys->thread, EncoderThread, p_sys, i_priority ) )
+    if( p_sys->i_threads >= 1 && transcode_vfilter_start( p_stream, id ) )
     {
-        msg_Err( p_stream, "cannot spawn encoder thread" );
-        vlc_mutex_destroy( &p_sys->lock_out );
-        vlc_cond_destroy( &p_sys->cond );
-        picture_fifo_Delete( p_sys->pp_pics );
+        transcode_venc_stop( p_stream, &id->venc );
         module_unneed( id->p_decoder, id->p_decoder->p_module );
         id->p_decoder->p_module = NULL;
         return VLC_EGENERIC;
@@ -392,47 +909,48 @@ static int conversion_video_filter_append( sout_stream_id_sys_t *id,
 
 static void transcode_video_framerate_init( sout_stream_t *p_stream,
                                             sout_stream_id_sys_t *id,
+                                            encoder_t *p_enc,
                                             const video_format_t *p_vid_out )
 {
     /* Handle frame rate conversion */
-    if( !id->p_encoder->fmt_out.video.i_frame_rate ||
-        !id->p_encoder->fmt_out.video.i_frame_rate_base )
+    if( !p_enc->fmt_out.video.i_frame_rate ||
+        !p_enc->fmt_out.video.i_frame_rate_base )
     {
         if( p_vid_out->i_frame_rate &&
             p_vid_out->i_frame_rate_base )
         {
-            id->p_encoder->fmt_out.video.i_frame_rate =
+            p_enc->fmt_out.video.i_frame_rate =
                 p_vid_out->i_frame_rate;
-            id->p_encoder->fmt_out.video.i_frame_rate_base =
+            p_enc->fmt_out.video.i_frame_rate_base =
                 p_vid_out->i_frame_rate_base;
         }
         else
         {
             /* Pick a sensible default value */
-            id->p_encoder->fmt_out.video.i_frame_rate = ENC_FRAMERATE;
-            id->p_encoder->fmt_out.video.i_frame_rate_base = ENC_FRAMERATE_BASE;
+            p_enc->fmt_out.video.i_frame_rate = ENC_FRAMERATE;
+            p_enc->fmt_out.video.i_frame_rate_base = ENC_FRAMERATE_BASE;
         }
     }
 
-    id->p_encoder->fmt_in.video.i_frame_rate =
-        id->p_encoder->fmt_out.video.i_frame_rate;
-    id->p_encoder->fmt_in.video.i_frame_rate_base =
-        id->p_encoder->fmt_out.video.i_frame_rate_base;
+    p_enc->fmt_in.video.i_frame_rate =
+        p_enc->fmt_out.video.i_frame_rate;
+    p_enc->fmt_in.video.i_frame_rate_base =
+        p_enc->fmt_out.video.i_frame_rate_base;
 
-    vlc_ureduce( &id->p_encoder->fmt_in.video.i_frame_rate,
-        &id->p_encoder->fmt_in.video.i_frame_rate_base,
-        id->p_encoder->fmt_in.video.i_frame_rate,
-        id->p_encoder->fmt_in.video.i_frame_rate_base,
+    vlc_ureduce( &p_enc->fmt_in.video.i_frame_rate,
+        &p_enc->fmt_in.video.i_frame_rate_base,
+        p_enc->fmt_in.video.i_frame_rate,
+        p_enc->fmt_in.video.i_frame_rate_base,
         0 );
      msg_Dbg( p_stream, "source fps %u/%u, destination %u/%u",
         id->p_decoder->fmt_out.video.i_frame_rate,
         id->p_decoder->fmt_out.video.i_frame_rate_base,
-        id->p_encoder->fmt_in.video.i_frame_rate,
-        id->p_encoder->fmt_in.video.i_frame_rate_base );
+        p_enc->fmt_in.video.i_frame_rate,
+        p_enc->fmt_in.video.i_frame_rate_base );
 }
 
 static void transcode_video_size_init( sout_stream_t *p_stream,
-                                     sout_stream_id_sys_t *id,
+                                     encoder_t *p_enc,
                                      const video_format_t *p_vid_out )
 {
     sout_stream_sys_t *p_sys = p_stream->p_sys;
@@ -465,8 +983,8 @@ static void transcode_video_size_init( sout_stream_t *p_stream,
     msg_Dbg( p_stream, "source pixel aspect is %f:1", f_aspect );
 
     /* Calculate scaling factor for specified parameters */
-    if( id->p_encoder->fmt_out.video.i_visible_width <= 0 &&
-        id->p_encoder->fmt_out.video.i_visible_height <= 0 && p_sys->f_scale )
+    if( p_enc->fmt_out.video.i_visible_width <= 0 &&
+        p_enc->fmt_out.video.i_visible_height <= 0 && p_sys->f_scale )
     {
         /* Global scaling. Make sure width will remain a factor of 16 */
         float f_real_scale;
@@ -485,26 +1003,26 @@ static void transcode_video_size_init( sout_stream_t *p_stream,
         f_scale_width = f_real_scale;
         f_scale_height = (float) i_new_height / (float) i_src_visible_height;
     }
-    else if( id->p_encoder->fmt_out.video.i_visible_width > 0 &&
-             id->p_encoder->fmt_out.video.i_visible_height <= 0 )
+    else if( p_enc->fmt_out.video.i_visible_width > 0 &&
+             p_enc->fmt_out.video.i_visible_height <= 0 )
     {
         /* Only width specified */
-        f_scale_width = (float)id->p_encoder->fmt_out.video.i_visible_width/i_src_visible_width;
+        f_scale_width = (float)p_enc->fmt_out.video.i_visible_width/i_src_visible_width;
         f_scale_height = f_scale_width;
     }
-    else if( id->p_encoder->fmt_out.video.i_visible_width <= 0 &&
-             id->p_encoder->fmt_out.video.i_visible_height > 0 )
+    else if( p_enc->fmt_out.video.i_visible_width <= 0 &&
+             p_enc->fmt_out.video.i_visible_height > 0 )
     {
          /* Only height specified */
-         f_scale_height = (float)id->p_encoder->fmt_out.video.i_visible_height/i_src_visible_height;
+         f_scale_height = (float)p_enc->fmt_out.video.i_visible_height/i_src_visible_height;
          f_scale_width = f_scale_height;
      }
-     else if( id->p_encoder->fmt_out.video.i_visible_width > 0 &&
-              id->p_encoder->fmt_out.video.i_visible_height > 0 )
+     else if( p_enc->fmt_out.video.i_visible_width > 0 &&
+              p_enc->fmt_out.video.i_visible_height > 0 )
      {
          /* Width and height specified */
-         f_scale_width = (float)id->p_encoder->fmt_out.video.i_visible_width/i_src_visible_width;
-         f_scale_height = (float)id->p_encoder->fmt_out.video.i_visible_height/i_src_visible_height;
+         f_scale_width = (float)p_enc->fmt_out.video.i_visible_width/i_src_visible_width;
+         f_scale_height = (float)p_enc->fmt_out.video.i_visible_height/i_src_visible_height;
      }
 
      /* check maxwidth and maxheight */
@@ -541,15 +1059,15 @@ static void transcode_video_size_init( sout_stream_t *p_stream,
      if( i_dst_height & 1 ) ++i_dst_height;
 
      /* Store calculated values */
-     id->p_encoder->fmt_out.video.i_width = i_dst_width;
-     id->p_encoder->fmt_out.video.i_visible_width = i_dst_visible_width;
-     id->p_encoder->fmt_out.video.i_height = i_dst_height;
-     id->p_encoder->fmt_out.video.i_visible_height = i_dst_visible_height;
+     p_enc->fmt_out.video.i_width = i_dst_width;
+     p_enc->fmt_out.video.i_visible_width = i_dst_visible_width;
+     p_enc->fmt_out.video.i_height = i_dst_height;
+     p_enc->fmt_out.video.i_visible_height = i_dst_visible_height;
 
-     id->p_encoder->fmt_in.video.i_width = i_dst_width;
-     id->p_encoder->fmt_in.video.i_visible_width = i_dst_visible_width;
-     id->p_encoder->fmt_in.video.i_height = i_dst_height;
-     id->p_encoder->fmt_in.video.i_visible_height = i_dst_visible_height;
+     p_enc->fmt_in.video.i_width = i_dst_width;
+     p_enc->fmt_in.video.i_visible_width = i_dst_visible_width;
+     p_enc->fmt_in.video.i_height = i_dst_height;
+     p_enc->fmt_in.video.i_visible_height = i_dst_visible_height;
 
      msg_Dbg( p_stream, "source %ix%i, destination %ix%i",
          i_src_visible_width, i_src_visible_height,
@@ -558,7 +1076,7 @@ static void transcode_video_size_init( sout_stream_t *p_stream,
 }
 
 static void transcode_video_sar_init( sout_stream_t *p_stream,
-                                     sout_stream_id_sys_t *id,
+                                     encoder_t *p_enc,
                                      const video_format_t *p_vid_out )
 {
     int i_src_visible_width = p_vid_out->i_visible_width;
@@ -570,68 +1088,74 @@ static void transcode_video_sar_init( sout_stream_t *p_stream,
         i_src_visible_height = p_vid_out->i_height;
 
     /* Check whether a particular aspect ratio was requested */
-    if( id->p_encoder->fmt_out.video.i_sar_num <= 0 ||
-        id->p_encoder->fmt_out.video.i_sar_den <= 0 )
+    if( p_enc->fmt_out.video.i_sar_num <= 0 ||
+        p_enc->fmt_out.video.i_sar_den <= 0 )
     {
-        vlc_ureduce( &id->p_encoder->fmt_out.video.i_sar_num,
-                     &id->p_encoder->fmt_out.video.i_sar_den,
-                     (uint64_t)p_vid_out->i_sar_num * id->p_encoder->fmt_out.video.i_width * p_vid_out->i_height,
-                     (uint64_t)p_vid_out->i_sar_den * id->p_encoder->fmt_out.video.i_height * p_vid_out->i_width,
+        vlc_ureduce( &p_enc->fmt_out.video.i_sar_num,
+                     &p_enc->fmt_out.video.i_sar_den,
+                     (uint64_t)p_vid_out->i_sar_num * p_enc->fmt_out.video.i_width * p_vid_out->i_height,
+                     (uint64_t)p_vid_out->i_sar_den * p_enc->fmt_out.video.i_height * p_vid_out->i_width,
                      0 );
     }
     else
     {
-        vlc_ureduce( &id->p_encoder->fmt_out.video.i_sar_num,
-                     &id->p_encoder->fmt_out.video.i_sar_den,
-                     id->p_encoder->fmt_out.video.i_sar_num,
-                     id->p_encoder->fmt_out.video.i_sar_den,
+        vlc_ureduce( &p_enc->fmt_out.video.i_sar_num,
+                     &p_enc->fmt_out.video.i_sar_den,
+                     p_enc->fmt_out.video.i_sar_num,
+                     p_enc->fmt_out.video.i_sar_den,
                      0 );
     }
 
-    id->p_encoder->fmt_in.video.i_sar_num =
-        id->p_encoder->fmt_out.video.i_sar_num;
-    id->p_encoder->fmt_in.video.i_sar_den =
-        id->p_encoder->fmt_out.video.i_sar_den;
+    p_enc->fmt_in.video.i_sar_num =
+        p_enc->fmt_out.video.i_sar_num;
+    p_enc->fmt_in.video.i_sar_den =
+        p_enc->fmt_out.video.i_sar_den;
 
     msg_Dbg( p_stream, "encoder aspect is %i:%i",
-             id->p_encoder->fmt_out.video.i_sar_num * id->p_encoder->fmt_out.video.i_width,
-             id->p_encoder->fmt_out.video.i_sar_den * id->p_encoder->fmt_out.video.i_height );
+             p_enc->fmt_out.video.i_sar_num * p_enc->fmt_out.video.i_width,
+             p_enc->fmt_out.video.i_sar_den * p_enc->fmt_out.video.i_height );
 
 }
 
 static void transcode_video_encoder_init( sout_stream_t *p_stream,
                                           sout_stream_id_sys_t *id,
+                                          encoder_t *p_enc,
                                           picture_t *p_pic )
 {
     const video_format_t *p_vid_out = video_output_format( id, p_pic );
 
-    id->p_encoder->fmt_in.video.orientation =
-        id->p_encoder->fmt_out.video.orientation =
+    p_enc->fmt_in.video.orientation =
+        p_enc->fmt_out.video.orientation =
         id->p_decoder->fmt_in.video.orientation;
 
-    transcode_video_framerate_init( p_stream, id, p_vid_out );
+    transcode_video_framerate_init( p_stream, id, p_enc, p_vid_out );
 
-    transcode_video_size_init( p_stream, id, p_vid_out );
-    transcode_video_sar_init( p_stream, id, p_vid_out );
+    transcode_video_size_init( p_stream, p_enc, p_vid_out );
+    transcode_video_sar_init( p_stream, p_enc, p_vid_out );
 
     msg_Dbg( p_stream, "source chroma: %4.4s, destination %4.4s",
              (const char *)&id->p_decoder->fmt_out.video.i_chroma,
-             (const char *)&id->p_encoder->fmt_in.video.i_chroma);
+             (const char *)&p_enc->fmt_in.video.i_chroma);
 }
 
 static int transcode_video_encoder_open( sout_stream_t *p_stream,
-                                         sout_stream_id_sys_t *id )
+                                         encoder_t *p_enc,
+                                         vlc_fourcc_t i_chroma, void **pp_id )
 {
     sout_stream_sys_t *p_sys = p_stream->p_sys;
 
 
     msg_Dbg( p_stream, "destination (after video filters) %ix%i",
-             id->p_encoder->fmt_in.video.i_width,
-             id->p_encoder->fmt_in.video.i_height );
+             p_enc->fmt_in.video.i_width,
+             p_enc->fmt_in.video.i_height );
 
-    id->p_encoder->p_module =
-        module_need( id->p_encoder, "encoder", p_sys->psz_venc, true );
-    if( !id->p_encoder->p_module )
+    /* Offer the chroma of the filtered pictures: an encoder supporting it
+     * takes them as they are, without any conversion */
+    p_enc->fmt_in.i_codec = i_chroma;
+
+    p_enc->p_module =
+        module_need( p_enc, "encoder", p_sys->psz_venc, true );
+    if( !p_enc->p_module )
     {
         msg_Err( p_stream, "cannot find video encoder (module:%s fourcc:%4.4s)",
                  p_sys->psz_venc ? p_sys->psz_venc : "any",
@@ -639,14 +1163,14 @@ static int transcode_video_encoder_open( sout_stream_t *p_stream,
         return VLC_EGENERIC;
     }
 
-    id->p_encoder->fmt_in.video.i_chroma = id->p_encoder->fmt_in.i_codec;
+    p_enc->fmt_in.video.i_chroma = p_enc->fmt_in.i_codec;
 
     /*  */
-    id->p_encoder->fmt_out.i_codec =
-        vlc_fourcc_GetCodec( VIDEO_ES, id->p_encoder->fmt_out.i_codec );
+    p_enc->fmt_out.i_codec =
+        vlc_fourcc_GetCodec( VIDEO_ES, p_enc->fmt_out.i_codec );
 
-    id->id = sout_StreamIdAdd( p_stream->p_next, &id->p_encoder->fmt_out );
-    if( !id->id )
+    *pp_id = sout_StreamIdAdd( p_stream->p_next, &p_enc->fmt_out );
+    if( !*pp_id )
     {
         msg_Err( p_stream, "cannot add this stream" );
         return VLC_EGENERIC;
@@ -655,27 +1179,199 @@ static int transcode_video_encoder_open( sout_stream_t *p_stream,
     return VLC_SUCCESS;
 }
 
-void transcode_video_close( sout_stream_t *p_stream,
-                                   sout_stream_id_sys_t *id )
+/* Creates the scaling and chroma conversion chain from the filtered pictures
+ * to an encoder of the ladder */
+static filter_chain_t *transcode_video_conversion_new( sout_stream_t *p_stream,
+                                                       sout_stream_id_sys_t *id,
+                                                       encoder_t *p_enc,
+                                                       picture_t *p_pic )
 {
-    if( p_stream->p_sys->i_threads >= 1 && !p_stream->p_sys->b_abort )
+    filter_owner_t owner = {
+        .sys = p_stream->p_sys,
+        .video = {
+            .buffer_new = transcode_video_filter_buffer_new,
+        },
+    };
+    const video_format_t *p_vid_out = video_output_format( id, p_pic );
+    es_format_t fmt_in;
+
+    es_format_Init( &fmt_in, VIDEO_ES, p_vid_out->i_chroma );
+    fmt_in.video = *p_vid_out;
+
+    filter_chain_t *p_chain = filter_chain_NewVideo( p_stream, false, &owner );
+    if( p_chain == NULL )
+        return NULL;
+    filter_chain_Reset( p_chain, &fmt_in, &p_enc->fmt_in );
+
+    if( ( ( p_vid_out->i_chroma != p_enc->fmt_in.video.i_chroma ) ||
+          ( p_vid_out->i_width != p_enc->fmt_in.video.i_width ) ||
+          ( p_vid_out->i_height != p_enc->fmt_in.video.i_height ) ) &&
+        filter_chain_AppendConverter( p_chain, &fmt_in,
+                                      &p_enc->fmt_in ) != VLC_SUCCESS )
     {
-        vlc_mutex_lock( &p_stream->p_sys->lock_out );
-        p_stream->p_sys->b_abort = true;
-        vlc_cond_signal( &p_stream->p_sys->cond );
-        vlc_mutex_unlock( &p_stream->p_sys->lock_out );
+        filter_chain_Delete( p_chain );
+        return NULL;
+    }
+    return p_chain;
+}
 
-        vlc_join( p_stream->p_sys->thread, NULL );
+/* Sizes the encoders of the ladder from the filtered pictures. The main
+ * encoder gets its own conversion chain too, so that the deinterlace and
+ * user filters output is shared by all the rungs. */
+static int transcode_video_ladder_init( sout_stream_t *p_stream,
+                                        sout_stream_id_sys_t *id,
+                                        picture_t *p_pic )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    if( id->p_cf_chain )
+        filter_chain_Delete( id->p_cf_chain );
+    id->p_cf_chain = transcode_video_conversion_new( p_stream, id,
+                                                     id->p_encoder, p_pic );
+    if( id->p_cf_chain == NULL )
+        return VLC_EGENERIC;
 
-        picture_fifo_Delete( p_stream->p_sys->pp_pics );
-        block_ChainRelease( p_stream->p_sys->p_buffers );
+    for( size_t i = 0; i < id->i_rungs; i++ )
+    {
+        transcode_rung_t *rung = &id->p_rungs[i];
+        encoder_t *p_enc = rung->venc.p_encoder;
+
+        p_enc->fmt_out.video.i_visible_width  =
+            p_sys->p_rungs_cfg[i].i_width & ~1;
+        p_enc->fmt_out.video.i_visible_height =
+            p_sys->p_rungs_cfg[i].i_height & ~1;
+        p_enc->fmt_out.video.i_sar_num = p_enc->fmt_out.video.i_sar_den = 0;
+        p_enc->fmt_in.i_codec = p_enc->fmt_in.video.i_chroma =
+            id->p_encoder->fmt_in.i_codec;
+
+        transcode_video_encoder_init( p_stream, id, p_enc, p_pic );
+        p_enc->fmt_in.video.space     = id->p_encoder->fmt_in.video.space;
+        p_enc->fmt_in.video.transfer  = id->p_encoder->fmt_in.video.transfer;
+        p_enc->fmt_in.video.primaries = id->p_encoder->fmt_in.video.primaries;
+        p_enc->fmt_in.video.b_color_range_full =
+            id->p_encoder->fmt_in.video.b_color_range_full;
+
+        if( rung->p_cf_chain )
+            filter_chain_Delete( rung->p_cf_chain );
+        rung->p_cf_chain = transcode_video_conversion_new( p_stream, id,
+                                                           p_enc, p_pic );
+        if( rung->p_cf_chain == NULL )
+            return VLC_EGENERIC;
     }
+    return VLC_SUCCESS;
+}
 
-    if( p_stream->p_sys->i_threads >= 1 )
+static int transcode_video_ladder_open( sout_stream_t *p_stream,
+                                        sout_stream_id_sys_t *id )
+{
+    for( size_t i = 0; i < id->i_rungs; i++ )
     {
-        vlc_mutex_destroy( &p_stream->p_sys->lock_out );
-        vlc_cond_destroy( &p_stream->p_sys->cond );
+        transcode_rung_t *rung = &id->p_rungs[i];
+
+        encoder_t *p_enc = rung->venc.p_encoder;
+
+        if( transcode_video_encoder_open( p_stream, p_enc,
+                                          id->p_encoder->fmt_in.i_codec,
+                                          &rung->id ) != VLC_SUCCESS )
+            return VLC_EGENERIC;
+
+        /* The conversion chain outputs the chroma of the main encoder */
+        if( p_enc->fmt_in.i_codec != id->p_encoder->fmt_in.i_codec )
+        {
+            msg_Err( p_stream, "rung encoder chroma %4.4s differs from %4.4s",
+                     (const char *)&p_enc->fmt_in.i_codec,
+                     (const char *)&id->p_encoder->fmt_in.i_codec );
+            return VLC_EGENERIC;
+        }
     }
+    return VLC_SUCCESS;
+}
+
+static void transcode_video_rung_send( sout_stream_t *p_stream,
+                                       transcode_rung_t *rung,
+                                       block_t *p_block )
+{
+    if( p_block == NULL )
+        return;
+    if( rung->id == NULL )
+    {
+        block_ChainRelease( p_block );
+        return;
+    }
+    sout_StreamIdSend( p_stream->p_next, rung->id, p_block );
+}
+
+static int transcode_video_rungs_new( sout_stream_t *p_stream,
+                                      const es_format_t *p_fmt,
+                                      sout_stream_id_sys_t *id )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    id->p_rungs = calloc( p_sys->i_rungs, sizeof( *id->p_rungs ) );
+    if( unlikely( id->p_rungs == NULL ) )
+        return VLC_ENOMEM;
+
+    for( size_t i = 0; i < p_sys->i_rungs; i++ )
+    {
+        encoder_t *p_enc = sout_EncoderCreate( p_stream );
+        if( !p_enc )
+            return VLC_ENOMEM;
+        p_enc->p_module = NULL;
+
+        /* Same encoder as the main one, with its own size and bitrate */
+        es_format_Copy( &p_enc->fmt_in, &id->p_encoder->fmt_in );
+        es_format_Copy( &p_enc->fmt_out, &id->p_encoder->fmt_out );
+        p_enc->fmt_out.i_id = p_fmt->i_id + ( i + 1 ) * TRANSCODE_RUNG_ID_STEP;
+        p_enc->fmt_out.i_bitrate = p_sys->p_rungs_cfg[i].i_bitrate;
+        p_enc->i_threads = p_sys->i_threads;
+        p_enc->p_cfg = p_sys->p_video_cfg;
+
+        transcode_rung_t *rung = &id->p_rungs[id->i_rungs];
+        rung->venc.p_encoder = p_enc;
+        if( ( p_sys->i_threads >= 1 || p_sys->i_segments > 0 ) &&
+            transcode_venc_start( p_stream, &rung->venc ) )
+        {
+            es_format_Clean( &p_enc->fmt_in );
+            es_format_Clean( &p_enc->fmt_out );
+            vlc_object_release( p_enc );
+            return VLC_EGENERIC;
+        }
+        id->i_rungs++;
+    }
+    return VLC_SUCCESS;
+}
+
+static void transcode_video_rungs_delete( sout_stream_t *p_stream,
+                                          sout_stream_id_sys_t *id )
+{
+    for( size_t i = 0; i < id->i_rungs; i++ )
+    {
+        transcode_rung_t *rung = &id->p_rungs[i];
+        encoder_t *p_enc = rung->venc.p_encoder;
+
+        transcode_venc_stop( p_stream, &rung->venc );
+        if( p_enc->p_module )
+            module_unneed( p_enc, p_enc->p_module );
+        if( rung->p_cf_chain )
+            filter_chain_Delete( rung->p_cf_chain );
+        if( rung->id )
+            sout_StreamIdDel( p_stream->p_next, rung->id );
+
+        es_format_Clean( &p_enc->fmt_in );
+        es_format_Clean( &p_enc->fmt_out );
+        vlc_object_release( p_enc );
+    }
+    free( id->p_rungs );
+    id->p_rungs = NULL;
+    id->i_rungs = 0;
+}
+
+void transcode_video_close( sout_stream_t *p_stream,
+                                   sout_stream_id_sys_t *id )
+{
+    transcode_vfilter_stop( p_stream, id );
+    transcode_venc_stop( p_stream, &id->venc );
+    transcode_video_rungs_delete( p_stream, id );
 
     /* Close decoder */
     if( id->p_decoder->p_module )
@@ -692,11 +1388,16 @@ void transcode_video_close( sout_stream_t *p_stream,
         filter_chain_Delete( id->p_f_chain );
     if( id->p_uf_chain )
         filter_chain_Delete( id->p_uf_chain );
+    if( id->p_cf_chain )
+        filter_chain_Delete( id->p_cf_chain );
 }
 
-static void OutputFrame( sout_stream_t *p_stream, picture_t *p_pic, sout_stream_id_sys_t *id, block_t **out )
+static void OutputFrame( sout_stream_t *p_stream, picture_t *p_pic,
+                         sout_stream_id_sys_t *id, transcode_venc_t *venc,
+                         filter_chain_t *p_chain, block_t **out )
 {
     sout_stream_sys_t *p_sys = p_stream->p_sys;
+    encoder_t *p_enc = venc->p_encoder;
 
     /*
      * Encoding
@@ -704,7 +1405,7 @@ static void OutputFrame( sout_stream_t *p_stream, picture_t *p_pic, sout_stream_
     /* Check if we have a subpicture to overlay */
     if( p_sys->p_spu )
     {
-        video_format_t fmt = id->p_encoder->fmt_in.video;
+        video_format_t fmt = p_enc->fmt_in.video;
         if( fmt.i_visible_width <= 0 || fmt.i_visible_height <= 0 )
         {
             fmt.i_visible_width  = fmt.i_width;
@@ -720,11 +1421,11 @@ static void OutputFrame( sout_stream_t *p_stream, picture_t *p_pic, sout_stream_
         /* Overlay subpicture */
         if( p_subpic )
         {
-            if( filter_chain_IsEmpty( id->p_f_chain ) )
+            if( filter_chain_IsEmpty( p_chain ) )
             {
                 /* We can't modify the picture, we need to duplicate it,
                  * in this point the picture is already p_encoder->fmt.in format*/
-                picture_t *p_tmp = video_new_buffer_encoder( id->p_encoder );
+                picture_t *p_tmp = video_new_buffer_encoder( p_enc );
                 if( likely( p_tmp ) )
                 {
                     picture_Copy( p_tmp, p_pic );
@@ -740,25 +1441,89 @@ static void OutputFrame( sout_stream_t *p_stream, picture_t *p_pic, sout_stream_
         }
     }
 
-    if( p_sys->i_threads == 0 )
+    if( venc->p_seg != NULL )
+        transcode_vseg_push( venc->p_seg, p_enc, p_pic );
+    else if( p_sys->i_threads == 0 )
     {
         block_t *p_block;
 
-        p_block = id->p_encoder->pf_encode_video( id->p_encoder, p_pic );
+        p_block = p_enc->pf_encode_video( p_enc, p_pic );
         block_ChainAppend( out, p_block );
+        picture_Release( p_pic );
     }
+    else
+    {
+        vlc_sem_wait( &venc->picture_pool_has_room );
+        vlc_mutex_lock( &venc->lock_out );
+        picture_fifo_Push( venc->pp_pics, p_pic );
+        vlc_cond_signal( &venc->cond );
+        vlc_mutex_unlock( &venc->lock_out );
+    }
+}
 
-    if( p_sys->i_threads )
+/* Fans a filtered picture out to all the rungs of the ladder: each one only
+ * holds a reference to it until it is scaled */
+static void OutputLadderFrame( sout_stream_t *p_stream, picture_t *p_pic,
+                               sout_stream_id_sys_t *id, block_t **out )
+{
+    for( size_t i = 0; i < id->i_rungs; i++ )
     {
-        vlc_sem_wait( &p_sys->picture_pool_has_room );
-        vlc_mutex_lock( &p_sys->lock_out );
-        picture_fifo_Push( p_sys->pp_pics, p_pic );
-        vlc_cond_signal( &p_sys->cond );
-        vlc_mutex_unlock( &p_sys->lock_out );
+        transcode_rung_t *rung = &id->p_rungs[i];
+        picture_t *p_scaled_pic =
+            filter_chain_VideoFilter( rung->p_cf_chain, picture_Hold( p_pic ) );
+
+        if( p_scaled_pic )
+        {
+            block_t *p_block = NULL;
+
+            OutputFrame( p_stream, p_scaled_pic, id, &rung->venc,
+                         rung->p_cf_chain, &p_block );
+            transcode_video_rung_send( p_stream, rung, p_block );
+        }
     }
 
-    if ( p_sys->i_threads == 0 )
-        picture_Release( p_pic );
+    p_pic = filter_chain_VideoFilter( id->p_cf_chain, p_pic );
+    if( p_pic )
+        OutputFrame( p_stream, p_pic, id, &id->venc, id->p_cf_chain, out );
+}
+
+static void transcode_video_filter_run( sout_stream_t *p_stream,
+                                        sout_stream_id_sys_t *id,
+                                        picture_t *p_pic, block_t **out )
+{
+    /* Run the filter and output chains; first with the picture,
+     * and then with NULL as many times as we need until they
+     * stop outputting frames.
+     */
+    for ( ;; ) {
+        picture_t *p_filtered_pic = p_pic;
+
+        /* Run filter chain */
+        if( id->p_f_chain )
+            p_filtered_pic = filter_chain_VideoFilter( id->p_f_chain, p_filtered_pic );
+        if( !p_filtered_pic )
+            break;
+
+        for ( ;; ) {
+            picture_t *p_user_filtered_pic = p_filtered_pic;
+
+            /* Run user specified filter chain */
+            if( id->p_uf_chain )
+                p_user_filtered_pic = filter_chain_VideoFilter( id->p_uf_chain, p_user_filtered_pic );
+            if( !p_user_filtered_pic )
+                break;
+
+            if( id->i_rungs > 0 )
+                OutputLadderFrame( p_stream, p_user_filtered_pic, id, out );
+            else
+                OutputFrame( p_stream, p_user_filtered_pic, id, &id->venc,
+                             id->p_f_chain, out );
+
+            p_filtered_pic = NULL;
+        }
+
+        p_pic = NULL;
+    }
 }
 
 int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
@@ -797,6 +1562,8 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                         id->fmt_input_video.i_sar_num, p_pic->format.i_sar_num,
                         id->fmt_input_video.i_sar_den, p_pic->format.i_sar_den
                     );
+            transcode_vfilter_wait( p_stream, id );
+
             /* Close filters */
             if( id->p_f_chain )
                 filter_chain_Delete( id->p_f_chain );
@@ -810,9 +1577,12 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
             id->p_encoder->fmt_out.video.i_visible_height = p_sys->i_height & ~1;
             id->p_encoder->fmt_out.video.i_sar_num = id->p_encoder->fmt_out.video.i_sar_den = 0;
 
-            transcode_video_encoder_init( p_stream, id, p_pic );
+            transcode_video_encoder_init( p_stream, id, id->p_encoder, p_pic );
             transcode_video_filter_init( p_stream, id );
-            if( conversion_video_filter_append( id, p_pic ) != VLC_SUCCESS )
+            if( ( id->i_rungs > 0
+                  ? transcode_video_ladder_init( p_stream, id, p_pic )
+                  : conversion_video_filter_append( id, p_pic ) )
+                != VLC_SUCCESS )
                 goto error;
             memcpy( &id->fmt_input_video, &p_pic->format, sizeof(video_format_t));
         }
@@ -820,51 +1590,36 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
 
         if( unlikely( !id->p_encoder->p_module && p_pic ) )
         {
+            transcode_vfilter_wait( p_stream, id );
+
             if( id->p_f_chain )
                 filter_chain_Delete( id->p_f_chain );
             if( id->p_uf_chain )
                 filter_chain_Delete( id->p_uf_chain );
             id->p_f_chain = id->p_uf_chain = NULL;
 
-            transcode_video_encoder_init( p_stream, id, p_pic );
+            transcode_video_encoder_init( p_stream, id, id->p_encoder, p_pic );
             transcode_video_filter_init( p_stream, id );
-            if( conversion_video_filter_append( id, p_pic ) != VLC_SUCCESS )
-                goto error;
             memcpy( &id->fmt_input_video, &p_pic->format, sizeof(video_format_t));
 
-            if( transcode_video_encoder_open( p_stream, id ) != VLC_SUCCESS )
+            /* Open the encoder before building the conversion chain, so
+             * that it can pick the chroma of the filtered pictures */
+            if( transcode_video_encoder_open( p_stream, id->p_encoder,
+                    video_output_format( id, p_pic )->i_chroma,
+                    &id->id ) != VLC_SUCCESS )
+                goto error;
+            if( ( id->i_rungs > 0
+                  ? transcode_video_ladder_init( p_stream, id, p_pic )
+                  : conversion_video_filter_append( id, p_pic ) )
+                != VLC_SUCCESS ||
+                transcode_video_ladder_open( p_stream, id ) != VLC_SUCCESS )
                 goto error;
         }
 
-        /* Run the filter and output chains; first with the picture,
-         * and then with NULL as many times as we need until they
-         * stop outputting frames.
-         */
-        for ( ;; ) {
-            picture_t *p_filtered_pic = p_pic;
-
-            /* Run filter chain */
-            if( id->p_f_chain )
-                p_filtered_pic = filter_chain_VideoFilter( id->p_f_chain, p_filtered_pic );
-            if( !p_filtered_pic )
-                break;
-
-            for ( ;; ) {
-                picture_t *p_user_filtered_pic = p_filtered_pic;
-
-                /* Run user specified filter chain */
-                if( id->p_uf_chain )
-                    p_user_filtered_pic = filter_chain_VideoFilter( id->p_uf_chain, p_user_filtered_pic );
-                if( !p_user_filtered_pic )
-                    break;
-
-                OutputFrame( p_stream, p_user_filtered_pic, id, out );
-
-                p_filtered_pic = NULL;
-            }
-
-            p_pic = NULL;
-        }
+        if( p_sys->i_threads >= 1 )
+            transcode_vfilter_push( p_stream, id, p_pic );
+        else
+            transcode_video_filter_run( p_stream, id, p_pic, out );
         continue;
 error:
         if( p_pic )
@@ -872,45 +1627,27 @@ error:
         id->b_error = true;
     } while( p_pics );
 
-    if( p_sys->i_threads >= 1 )
+    if( p_sys->i_threads >= 1 || p_sys->i_segments > 0 )
     {
-        /* Pick up any return data the encoder thread wants to output. */
-        vlc_mutex_lock( &p_sys->lock_out );
-        *out = p_sys->p_buffers;
-        p_sys->p_buffers = NULL;
-        vlc_mutex_unlock( &p_sys->lock_out );
+        /* Pick up any return data the encoder threads want to output. */
+        block_ChainAppend( out, transcode_venc_get_buffers( &id->venc ) );
+        for( size_t i = 0; i < id->i_rungs; i++ )
+            transcode_video_rung_send( p_stream, &id->p_rungs[i],
+                transcode_venc_get_buffers( &id->p_rungs[i].venc ) );
     }
 
 end:
     /* Drain encoder */
     if( unlikely( !id->b_error && in == NULL ) )
     {
-        if( p_sys->i_threads == 0 )
+        transcode_vfilter_wait( p_stream, id );
+        transcode_venc_flush( p_stream, &id->venc, out );
+        for( size_t i = 0; i < id->i_rungs; i++ )
         {
-            if( id->p_encoder->p_module )
-            {
-                block_t *p_block;
-                do {
-                    p_block = id->p_encoder->pf_encode_video(id->p_encoder, NULL );
-                    block_ChainAppend( out, p_block );
-                } while( p_block );
-            }
-        }
-        else
-        {
-            msg_Dbg( p_stream, "Flushing thread and waiting that");
-            vlc_mutex_lock( &p_stream->p_sys->lock_out );
-            p_stream->p_sys->b_abort = true;
-            vlc_cond_signal( &p_stream->p_sys->cond );
-            vlc_mutex_unlock( &p_stream->p_sys->lock_out );
-
-            vlc_join( p_stream->p_sys->thread, NULL );
-            vlc_mutex_lock( &p_sys->lock_out );
-            *out = p_sys->p_buffers;
-            p_sys->p_buffers = NULL;
-            vlc_mutex_unlock( &p_sys->lock_out );
-
-            msg_Dbg( p_stream, "Flushing done");
+            block_t *p_block = NULL;
+
+            transcode_venc_flush( p_stream, &id->p_rungs[i].venc, &p_block );
+            transcode_video_rung_send( p_stream, &id->p_rungs[i], p_block );
         }
     }
 
@@ -952,6 +1689,16 @@ bool transcode_video_add( sout_stream_t *p_stream, const es_format_t *p_fmt,
         id->p_encoder->fmt_in.video.i_frame_rate_base = id->p_encoder->fmt_out.video.i_frame_rate_base = (p_sys->fps_den ? p_sys->fps_den : 1);
     }
 
+    /* The rungs of the ladder share the decoder and the filters */
+    if( p_sys->i_rungs > 0 &&
+        transcode_video_rungs_new( p_stream, p_fmt, id ) != VLC_SUCCESS )
+    {
+        msg_Err( p_stream, "cannot create video ladder" );
+        transcode_video_close( p_stream, id );
+        id->b_transcode = false;
+        return false;
+    }
+
     return true;
 }
 
@@ -70,6 +70,7 @@
 #include "platform_fonts.h"
 #include "freetype.h"
 #include "text_layout.h"
+#include "layout_cache.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -1396,6 +1397,10 @@ static int Create( vlc_object_t *p_this )
         p_sys->p_stroker = NULL;
     }
 
+    p_sys->p_layout_cache = LayoutCache_New( LAYOUT_CACHE_SIZE );
+    if( unlikely(!p_sys->p_layout_cache) )
+        goto error;
+
     /* Dictionnaries for fonts and families */
     vlc_dictionary_init( &p_sys->face_map, 50 );
     vlc_dictionary_init( &p_sys->family_map, 50 );
@@ -1525,6 +1530,10 @@ static void Destroy( vlc_object_t *p_this )
     text_style_Delete( p_sys->p_default_style );
     text_style_Delete( p_sys->p_forced_style );
 
+    /* Cached glyphs */
+    if( p_sys->p_layout_cache )
+        LayoutCache_Delete( p_sys->p_layout_cache );
+
     /* Fonts dicts */
     vlc_dictionary_clear( &p_sys->fallback_map, FreeFamilies, p_filter );
     vlc_dictionary_clear( &p_sys->face_map, FreeFace, p_filter );
@@ -68,12 +68,16 @@ typedef uint32_t uni_char_t;
  * It describes the freetype specific properties of an output thread.
  *****************************************************************************/
 typedef struct vlc_family_t vlc_family_t;
+typedef struct layout_cache_t layout_cache_t;
 struct filter_sys_t
 {
     FT_Library     p_library;       /* handle to library     */
     FT_Face        p_face;          /* handle to face object */
     FT_Stroker     p_stroker;       /* handle to path stroker object */
 
+    /** Shaped runs and glyphs, shared across the rendered regions */
+    layout_cache_t *p_layout_cache;
+
     text_style_t  *p_default_style;
     text_style_t  *p_forced_style;  /* Renderer overridings */
 
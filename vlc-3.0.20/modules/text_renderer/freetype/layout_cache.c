@@ -0,0 +1,168 @@
+/*****************************************************************************
+ * layout_cache.c : LRU cache of shaped runs and glyphs
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+
+#include "layout_cache.h"
+
+#define BUCKETS_COUNT 1024
+
+typedef struct cache_entry_t cache_entry_t;
+struct cache_entry_t
+{
+    cache_entry_t *p_hash_next;
+    cache_entry_t *p_older;
+    cache_entry_t *p_newer;
+
+    uint32_t       i_hash;
+    void          *p_value;
+    size_t         i_size;
+    void         (*pf_free)( void * );
+
+    size_t         i_key;
+    uint8_t        key[];
+};
+
+struct layout_cache_t
+{
+    cache_entry_t *pp_buckets[BUCKETS_COUNT];
+    cache_entry_t *p_oldest;
+    cache_entry_t *p_newest;
+    size_t         i_size;
+    size_t         i_max_size;
+};
+
+static uint32_t Hash( const void *p_key, size_t i_key )
+{
+    /* FNV-1a */
+    const uint8_t *p = p_key;
+    uint32_t i_hash = 2166136261u;
+    for( size_t i = 0; i < i_key; i++ )
+        i_hash = ( i_hash ^ p[i] ) * 16777619u;
+    return i_hash;
+}
+
+static void Unlink( layout_cache_t *p_cache, cache_entry_t *p_entry )
+{
+    if( p_entry->p_older )
+        p_entry->p_older->p_newer = p_entry->p_newer;
+    else
+        p_cache->p_oldest = p_entry->p_newer;
+    if( p_entry->p_newer )
+        p_entry->p_newer->p_older = p_entry->p_older;
+    else
+        p_cache->p_newest = p_entry->p_older;
+}
+
+static void LinkNewest( layout_cache_t *p_cache, cache_entry_t *p_entry )
+{
+    p_entry->p_newer = NULL;
+    p_entry->p_older = p_cache->p_newest;
+    if( p_cache->p_newest )
+        p_cache->p_newest->p_newer = p_entry;
+    else
+        p_cache->p_oldest = p_entry;
+    p_cache->p_newest = p_entry;
+}
+
+static void Evict( layout_cache_t *p_cache, cache_entry_t *p_entry )
+{
+    cache_entry_t **pp = &p_cache->pp_buckets[p_entry->i_hash % BUCKETS_COUNT];
+    while( *pp != p_entry )
+        pp = &(*pp)->p_hash_next;
+    *pp = p_entry->p_hash_next;
+
+    Unlink( p_cache, p_entry );
+    p_cache->i_size -= p_entry->i_size;
+    p_entry->pf_free( p_entry->p_value );
+    free( p_entry );
+}
+
+layout_cache_t *LayoutCache_New( size_t i_max_size )
+{
+    layout_cache_t *p_cache = calloc( 1, sizeof( *p_cache ) );
+    if( p_cache )
+        p_cache->i_max_size = i_max_size;
+    return p_cache;
+}
+
+void LayoutCache_Delete( layout_cache_t *p_cache )
+{
+    while( p_cache->p_oldest )
+        Evict( p_cache, p_cache->p_oldest );
+    free( p_cache );
+}
+
+void *LayoutCache_Get( layout_cache_t *p_cache,
+                       const void *p_key, size_t i_key )
+{
+    const uint32_t i_hash = Hash( p_key, i_key );
+
+    for( cache_entry_t *p_entry = p_cache->pp_buckets[i_hash % BUCKETS_COUNT];
+         p_entry; p_entry = p_entry->p_hash_next )
+    {
+        if( p_entry->i_hash == i_hash && p_entry->i_key == i_key
+         && !memcmp( p_entry->key, p_key, i_key ) )
+        {
+            Unlink( p_cache, p_entry );
+            LinkNewest( p_cache, p_entry );
+            return p_entry->p_value;
+        }
+    }
+    return NULL;
+}
+
+int LayoutCache_Put( layout_cache_t *p_cache,
+                     const void *p_key, size_t i_key,
+                     void *p_value, size_t i_size,
+                     void (*pf_free)( void * ) )
+{
+    cache_entry_t *p_entry = malloc( sizeof( *p_entry ) + i_key );
+    if( unlikely(!p_entry) )
+    {
+        pf_free( p_value );
+        return VLC_ENOMEM;
+    }
+
+    p_entry->i_hash = Hash( p_key, i_key );
+    p_entry->p_value = p_value;
+    p_entry->i_size = sizeof( *p_entry ) + i_key + i_size;
+    p_entry->pf_free = pf_free;
+    p_entry->i_key = i_key;
+    memcpy( p_entry->key, p_key, i_key );
+
+    cache_entry_t **pp_bucket = &p_cache->pp_buckets[p_entry->i_hash % BUCKETS_COUNT];
+    p_entry->p_hash_next = *pp_bucket;
+    *pp_bucket = p_entry;
+    LinkNewest( p_cache, p_entry );
+    p_cache->i_size += p_entry->i_size;
+
+    return VLC_SUCCESS;
+}
+
+void LayoutCache_Trim( layout_cache_t *p_cache )
+{
+    while( p_cache->i_size > p_cache->i_max_size && p_cache->p_oldest )
+        Evict( p_cache, p_cache->p_oldest );
+}
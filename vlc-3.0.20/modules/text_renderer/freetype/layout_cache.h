@@ -0,0 +1,73 @@
+/*****************************************************************************
+ * layout_cache.h : LRU cache of shaped runs and glyphs
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LAYOUT_CACHE_H
+#define LAYOUT_CACHE_H
+
+/** \defgroup freetype_cache Layout cache
+ * \ingroup freetype
+ * Values computed while laying out text (shaped runs, loaded and rendered
+ * glyphs), kept across the rendered regions and keyed by opaque byte
+ * strings.
+ *
+ * Entries are only evicted by LayoutCache_Trim(), so that values
+ * returned by LayoutCache_Get() stay valid until the next call to it.
+ * @{
+ */
+
+/** Size of the cache of the text renderer, in bytes */
+#define LAYOUT_CACHE_SIZE (8 * 1024 * 1024)
+
+typedef struct layout_cache_t layout_cache_t;
+
+/**
+ * Creates a cache holding about \p i_max_size bytes of values
+ */
+layout_cache_t *LayoutCache_New( size_t i_max_size );
+
+void LayoutCache_Delete( layout_cache_t *p_cache );
+
+/**
+ * Looks up a value and marks it as most recently used.
+ *
+ * \return the value or NULL if not cached
+ */
+void *LayoutCache_Get( layout_cache_t *p_cache,
+                       const void *p_key, size_t i_key );
+
+/**
+ * Adds a value, owned by the cache from now on.
+ *
+ * \param i_size memory used by the value, accounted against the cache size
+ * \param pf_free releases the value, called right away on failure
+ */
+int LayoutCache_Put( layout_cache_t *p_cache,
+                     const void *p_key, size_t i_key,
+                     void *p_value, size_t i_size,
+                     void (*pf_free)( void * ) );
+
+/**
+ * Evicts the least recently used values until the cache fits its size.
+ */
+void LayoutCache_Trim( layout_cache_t *p_cache );
+
+/** @} */
+
+#endif
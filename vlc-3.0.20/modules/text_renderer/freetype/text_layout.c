@@ -65,6 +65,7 @@
 #include "freetype.h"
 #include "text_layout.h"
 #include "platform_fonts.h"
+#include "layout_cache.h"
 
 #include <stdlib.h>
 
@@ -117,6 +118,69 @@ typedef struct run_desc_t
 
 } run_desc_t;
 
+/**
+ * Layout cache keys. They are compared as bytes, so they must be zeroed
+ * before being filled.
+ */
+enum
+{
+    CACHE_GLYPH,
+    CACHE_BITMAP,
+    CACHE_RUN,
+};
+
+/**
+ * A loaded glyph: its face (hence its size), its synthetic styles and
+ * its stroke
+ */
+typedef struct
+{
+    int      i_type;
+    FT_Face  p_face;
+    FT_UInt  i_glyph_index;
+    int      i_style_flags;
+    FT_Fixed i_stroke_radius;
+} glyph_key_t;
+
+/**
+ * A rendered glyph or outline, at the subpixel phase of its origin
+ */
+typedef struct
+{
+    int         i_type;
+    glyph_key_t glyph;
+    bool        b_outline;
+    FT_Pos      i_x_phase;
+    FT_Pos      i_y_phase;
+} bitmap_key_t;
+
+typedef struct
+{
+    FT_Glyph  p_glyph;
+    FT_Glyph  p_outline;
+    FT_Vector advance;
+} cached_glyph_t;
+
+#ifdef HAVE_HARFBUZZ
+/**
+ * A shaped run, followed in the key by its code points
+ */
+typedef struct
+{
+    int            i_type;
+    FT_Face        p_face;
+    hb_script_t    script;
+    hb_direction_t direction;
+} run_key_t;
+
+typedef struct
+{
+    unsigned int         i_glyph_count;
+    hb_glyph_info_t     *p_infos;
+    hb_glyph_position_t *p_positions;
+} cached_run_t;
+#endif
+
 /**
  * Glyph bitmaps. Advance and offset are 26.6 values
  */
@@ -132,6 +196,7 @@ typedef struct glyph_bitmaps_t
     int      i_y_offset;
     int      i_x_advance;
     int      i_y_advance;
+    glyph_key_t key;      /* p_face is NULL if not cached */
 } glyph_bitmaps_t;
 
 typedef struct paragraph_t
@@ -234,6 +299,131 @@ static void FixGlyph( FT_Glyph glyph, FT_BBox *p_bbox,
     }
 }
 
+static size_t GlyphSize( FT_Glyph p_glyph )
+{
+    if( p_glyph->format == FT_GLYPH_FORMAT_BITMAP )
+    {
+        const FT_Bitmap *p_bitmap = &((FT_BitmapGlyph)p_glyph)->bitmap;
+        return sizeof( FT_BitmapGlyphRec )
+             + p_bitmap->rows * (size_t) abs( p_bitmap->pitch );
+    }
+    if( p_glyph->format == FT_GLYPH_FORMAT_OUTLINE )
+    {
+        const FT_Outline *p_outline = &((FT_OutlineGlyph)p_glyph)->outline;
+        return sizeof( FT_OutlineGlyphRec )
+             + p_outline->n_points * ( sizeof( FT_Vector ) + 1 )
+             + p_outline->n_contours * sizeof( short );
+    }
+    return sizeof( FT_GlyphRec );
+}
+
+static void FreeCachedGlyph( void *p_data )
+{
+    cached_glyph_t *p_cached = p_data;
+    FT_Done_Glyph( p_cached->p_glyph );
+    if( p_cached->p_outline )
+        FT_Done_Glyph( p_cached->p_outline );
+    free( p_cached );
+}
+
+static void FreeCachedBitmap( void *p_data )
+{
+    FT_Done_Glyph( (FT_Glyph) p_data );
+}
+
+/**
+ * Keeps copies of a freshly loaded glyph and its outline
+ */
+static void CacheGlyph( filter_t *p_filter, const glyph_key_t *p_key,
+                        FT_Glyph p_glyph, FT_Glyph p_outline,
+                        const FT_Vector *p_advance )
+{
+    cached_glyph_t *p_cached = malloc( sizeof( *p_cached ) );
+    if( !p_cached )
+        return;
+
+    if( FT_Glyph_Copy( p_glyph, &p_cached->p_glyph ) )
+    {
+        free( p_cached );
+        return;
+    }
+    p_cached->p_outline = NULL;
+    if( p_outline && FT_Glyph_Copy( p_outline, &p_cached->p_outline ) )
+    {
+        FT_Done_Glyph( p_cached->p_glyph );
+        free( p_cached );
+        return;
+    }
+    p_cached->advance = *p_advance;
+
+    size_t i_size = sizeof( *p_cached ) + GlyphSize( p_glyph );
+    if( p_outline )
+        i_size += GlyphSize( p_outline );
+    LayoutCache_Put( p_filter->p_sys->p_layout_cache, p_key, sizeof( *p_key ),
+                     p_cached, i_size, FreeCachedGlyph );
+}
+
+/**
+ * FT_Glyph_To_Bitmap() going through the layout cache. Bitmaps are
+ * rendered and cached at the subpixel phase of the origin, then moved by
+ * its integer part, which gives the same pixels.
+ */
+static FT_Error RenderGlyph( filter_t *p_filter, const glyph_key_t *p_key,
+                             bool b_outline, FT_Glyph *pp_glyph,
+                             FT_Vector *p_origin, FT_Bool b_destroy )
+{
+    layout_cache_t *p_cache = p_filter->p_sys->p_layout_cache;
+
+    /* Bitmap fonts ignore the origin */
+    if( !p_key->p_face || (*pp_glyph)->format != FT_GLYPH_FORMAT_OUTLINE )
+        return FT_Glyph_To_Bitmap( pp_glyph, FT_RENDER_MODE_NORMAL,
+                                   p_origin, b_destroy );
+
+    bitmap_key_t key;
+    memset( &key, 0, sizeof( key ) );
+    key.i_type = CACHE_BITMAP;
+    key.glyph = *p_key;
+    key.b_outline = b_outline;
+    key.i_x_phase = p_origin->x & 63;
+    key.i_y_phase = p_origin->y & 63;
+
+    FT_Error i_error;
+    FT_Glyph p_bitmap = LayoutCache_Get( p_cache, &key, sizeof( key ) );
+    FT_Glyph p_copy;
+    if( p_bitmap )
+    {
+        i_error = FT_Glyph_Copy( p_bitmap, &p_copy );
+        if( i_error )
+            return i_error;
+    }
+    else
+    {
+        FT_Vector phase = { .x = key.i_x_phase, .y = key.i_y_phase };
+        p_bitmap = *pp_glyph;
+        i_error = FT_Glyph_To_Bitmap( &p_bitmap, FT_RENDER_MODE_NORMAL,
+                                      &phase, 0 );
+        if( i_error )
+            return i_error;
+        i_error = FT_Glyph_Copy( p_bitmap, &p_copy );
+        if( i_error )
+        {
+            FT_Done_Glyph( p_bitmap );
+            return i_error;
+        }
+        LayoutCache_Put( p_cache, &key, sizeof( key ), p_bitmap,
+                         GlyphSize( p_bitmap ), FreeCachedBitmap );
+    }
+
+    FT_BitmapGlyph p_bitmap_glyph = (FT_BitmapGlyph) p_copy;
+    p_bitmap_glyph->left += p_origin->x >> 6;
+    p_bitmap_glyph->top  += p_origin->y >> 6;
+
+    if( b_destroy )
+        FT_Done_Glyph( *pp_glyph );
+    *pp_glyph = p_copy;
+    return 0;
+}
+
 static paragraph_t *NewParagraph( filter_t *p_filter,
                                   int i_size,
                                   const uni_char_t *p_code_points,
@@ -671,6 +861,51 @@ static int ItemizeParagraph( filter_t *p_filter, paragraph_t *p_paragraph )
  * Glyph substitutions of base glyphs and diacritics may take place,
  * so the paragraph size may change.
  */
+static void *NewRunKey( const paragraph_t *p_paragraph,
+                        const run_desc_t *p_run, size_t *pi_key )
+{
+    const size_t i_count = p_run->i_end_offset - p_run->i_start_offset;
+    const size_t i_key = sizeof( run_key_t ) + i_count * sizeof( uni_char_t );
+    run_key_t *p_key = calloc( 1, i_key );
+    if( !p_key )
+        return NULL;
+
+    p_key->i_type = CACHE_RUN;
+    p_key->p_face = p_run->p_face;
+    p_key->script = p_run->script;
+    p_key->direction = p_run->direction;
+    memcpy( p_key + 1, p_paragraph->p_code_points + p_run->i_start_offset,
+            i_count * sizeof( uni_char_t ) );
+
+    *pi_key = i_key;
+    return p_key;
+}
+
+/**
+ * Keeps a copy of the glyphs of a run shaped by HarfBuzz
+ */
+static void CacheRun( filter_t *p_filter, const void *p_key, size_t i_key,
+                      const run_desc_t *p_run )
+{
+    const size_t i_infos = p_run->i_glyph_count * sizeof( hb_glyph_info_t );
+    const size_t i_positions =
+        p_run->i_glyph_count * sizeof( hb_glyph_position_t );
+    cached_run_t *p_cached = malloc( sizeof( *p_cached )
+                                     + i_infos + i_positions );
+    if( !p_cached )
+        return;
+
+    p_cached->i_glyph_count = p_run->i_glyph_count;
+    p_cached->p_infos = (hb_glyph_info_t *)( p_cached + 1 );
+    p_cached->p_positions =
+        (hb_glyph_position_t *)( (uint8_t *) p_cached->p_infos + i_infos );
+    memcpy( p_cached->p_infos, p_run->p_glyph_infos, i_infos );
+    memcpy( p_cached->p_positions, p_run->p_glyph_positions, i_positions );
+
+    LayoutCache_Put( p_filter->p_sys->p_layout_cache, p_key, i_key, p_cached,
+                     sizeof( *p_cached ) + i_infos + i_positions, free );
+}
+
 static int ShapeParagraphHarfBuzz( filter_t *p_filter,
                                    paragraph_t **p_old_paragraph )
 {
@@ -717,11 +952,26 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
         else
             p_face = p_run->p_face;
 
+        size_t i_key;
+        void *p_key = NewRunKey( p_paragraph, p_run, &i_key );
+        const cached_run_t *p_cached = p_key ?
+            LayoutCache_Get( p_sys->p_layout_cache, p_key, i_key ) : NULL;
+        if( p_cached )
+        {
+            free( p_key );
+            p_run->p_glyph_infos = p_cached->p_infos;
+            p_run->p_glyph_positions = p_cached->p_positions;
+            p_run->i_glyph_count = p_cached->i_glyph_count;
+            i_total_glyphs += p_run->i_glyph_count;
+            continue;
+        }
+
         p_run->p_hb_font = hb_ft_font_create( p_face, 0 );
         if( !p_run->p_hb_font )
         {
             msg_Err( p_filter,
                      "ShapeParagraphHarfBuzz(): hb_ft_font_create() error" );
+            free( p_key );
             goto error;
         }
 
@@ -730,6 +980,7 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
         {
             msg_Err( p_filter,
                      "ShapeParagraphHarfBuzz(): hb_buffer_create() error" );
+            free( p_key );
             goto error;
         }
 
@@ -749,9 +1000,16 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
         {
             msg_Err( p_filter,
                      "ShapeParagraphHarfBuzz() invalid glyph count in shaped run" );
+            free( p_key );
             goto error;
         }
 
+        if( p_key )
+        {
+            CacheRun( p_filter, p_key, i_key, p_run );
+            free( p_key );
+        }
+
         i_total_glyphs += p_run->i_glyph_count;
     }
 
@@ -815,8 +1073,11 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
 
     for( int i = 0; i < p_paragraph->i_runs_count; ++i )
     {
-        hb_font_destroy( p_paragraph->p_runs[ i ].p_hb_font );
-        hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
+        /* Runs found in the layout cache were not shaped */
+        if( p_paragraph->p_runs[ i ].p_hb_font )
+            hb_font_destroy( p_paragraph->p_runs[ i ].p_hb_font );
+        if( p_paragraph->p_runs[ i ].p_buffer )
+            hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
     }
     FreeParagraph( *p_old_paragraph );
     *p_old_paragraph = p_new_paragraph;
@@ -971,12 +1232,15 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
         else
             p_face = p_run->p_face;
 
-        if( p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
+        const bool b_outline = p_sys->p_stroker
+                            && (p_style->i_style_flags & STYLE_OUTLINE);
+        int i_radius = 0;
+        if( b_outline )
         {
             double f_outline_thickness =
                 var_InheritInteger( p_filter, "freetype-outline-thickness" ) / 100.0;
             f_outline_thickness = VLC_CLIP( f_outline_thickness, 0.0, 0.5 );
-            int i_radius = ( i_live_size << 6 ) * f_outline_thickness;
+            i_radius = ( i_live_size << 6 ) * f_outline_thickness;
             FT_Stroker_Set( p_sys->p_stroker,
                             i_radius,
                             FT_STROKER_LINECAP_ROUND,
@@ -1001,6 +1265,7 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
         p_bitmaps->p_shadow = 0; \
         p_bitmaps->i_x_advance = 0; \
         p_bitmaps->i_y_advance = 0; \
+        p_bitmaps->key.p_face = NULL; \
         continue; \
     }
 
@@ -1033,39 +1298,74 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
                     SKIP_GLYPH( p_bitmaps )
             }
 
-            if( FT_Load_Glyph( p_face, i_glyph_index,
-                               FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
-             && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
-                SKIP_GLYPH( p_bitmaps )
+            /* The face already carries the size */
+            glyph_key_t *p_key = &p_bitmaps->key;
+            memset( p_key, 0, sizeof( *p_key ) );
+            p_key->i_type = CACHE_GLYPH;
+            p_key->p_face = p_face;
+            p_key->i_glyph_index = i_glyph_index;
+            p_key->i_style_flags = p_style->i_style_flags
+                                 & ( STYLE_BOLD | STYLE_ITALIC | STYLE_OUTLINE );
+            if( b_outline )
+                p_key->i_stroke_radius = i_radius;
+            else
+                p_key->i_style_flags &= ~STYLE_OUTLINE;
 
-            if( ( p_style->i_style_flags & STYLE_BOLD )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
-                FT_GlyphSlot_Embolden( p_face->glyph );
-            if( ( p_style->i_style_flags & STYLE_ITALIC )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
-                FT_GlyphSlot_Oblique( p_face->glyph );
+            FT_Vector advance;
+            const cached_glyph_t *p_cached =
+                LayoutCache_Get( p_sys->p_layout_cache, p_key, sizeof( *p_key ) );
+            if( p_cached )
+            {
+                if( FT_Glyph_Copy( p_cached->p_glyph, &p_bitmaps->p_glyph ) )
+                    SKIP_GLYPH( p_bitmaps )
 
-            if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
-                SKIP_GLYPH( p_bitmaps )
+                p_bitmaps->p_outline = 0;
+                if( p_cached->p_outline
+                 && FT_Glyph_Copy( p_cached->p_outline, &p_bitmaps->p_outline ) )
+                    p_bitmaps->p_outline = 0;
+                advance = p_cached->advance;
+            }
+            else
+            {
+                if( FT_Load_Glyph( p_face, i_glyph_index,
+                                   FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
+                 && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
+                    SKIP_GLYPH( p_bitmaps )
 
-#undef SKIP_GLYPH
+                if( ( p_style->i_style_flags & STYLE_BOLD )
+                      && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
+                    FT_GlyphSlot_Embolden( p_face->glyph );
+                if( ( p_style->i_style_flags & STYLE_ITALIC )
+                      && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
+                    FT_GlyphSlot_Oblique( p_face->glyph );
 
-            if( p_filter->p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
-            {
-                p_bitmaps->p_outline = p_bitmaps->p_glyph;
-                if( FT_Glyph_Stroke( &p_bitmaps->p_outline,
-                                      p_filter->p_sys->p_stroker, 0 ) )
-                    p_bitmaps->p_outline = 0;
+                if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
+                    SKIP_GLYPH( p_bitmaps )
+
+                p_bitmaps->p_outline = 0;
+                if( b_outline )
+                {
+                    p_bitmaps->p_outline = p_bitmaps->p_glyph;
+                    if( FT_Glyph_Stroke( &p_bitmaps->p_outline,
+                                          p_filter->p_sys->p_stroker, 0 ) )
+                        p_bitmaps->p_outline = 0;
+                }
+                advance = p_face->glyph->advance;
+
+                CacheGlyph( p_filter, p_key, p_bitmaps->p_glyph,
+                            p_bitmaps->p_outline, &advance );
             }
 
+#undef SKIP_GLYPH
+
             if( p_style->i_shadow_alpha != STYLE_ALPHA_TRANSPARENT )
                 p_bitmaps->p_shadow = p_bitmaps->p_outline ?
                                       p_bitmaps->p_outline : p_bitmaps->p_glyph;
 
             if( b_overwrite_advance )
             {
-                p_bitmaps->i_x_advance = p_face->glyph->advance.x;
-                p_bitmaps->i_y_advance = p_face->glyph->advance.y;
+                p_bitmaps->i_x_advance = advance.x;
+                p_bitmaps->i_y_advance = advance.y;
             }
 
             unsigned i_x_advance = FT_FLOOR( abs( p_bitmaps->i_x_advance ) );
@@ -1170,8 +1470,10 @@ static int LayoutLine( filter_t *p_filter,
 
         if( p_bitmaps->p_shadow )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_shadow, FT_RENDER_MODE_NORMAL,
-                                    &pen_shadow, 0 ) )
+            const bool b_outline_shadow =
+                p_bitmaps->p_shadow == p_bitmaps->p_outline;
+            if( RenderGlyph( p_filter, &p_bitmaps->key, b_outline_shadow,
+                             &p_bitmaps->p_shadow, &pen_shadow, 0 ) )
                 p_bitmaps->p_shadow = 0;
             else
                 FT_Glyph_Get_CBox( p_bitmaps->p_shadow, ft_glyph_bbox_pixels,
@@ -1179,8 +1481,8 @@ static int LayoutLine( filter_t *p_filter,
         }
         if( p_bitmaps->p_glyph )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_glyph, FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 1 ) )
+            if( RenderGlyph( p_filter, &p_bitmaps->key, false,
+                             &p_bitmaps->p_glyph, &pen_new, 1 ) )
             {
                 FT_Done_Glyph( p_bitmaps->p_glyph );
                 if( p_bitmaps->p_outline )
@@ -1196,8 +1498,8 @@ static int LayoutLine( filter_t *p_filter,
         }
         if( p_bitmaps->p_outline )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_outline, FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 1 ) )
+            if( RenderGlyph( p_filter, &p_bitmaps->key, true,
+                             &p_bitmaps->p_outline, &pen_new, 1 ) )
             {
                 FT_Done_Glyph( p_bitmaps->p_outline );
                 p_bitmaps->p_outline = 0;
@@ -1519,6 +1821,8 @@ int LayoutText( filter_t *p_filter,
     unsigned i_max_advance_x = 0;
     int i_max_face_height = 0;
 
+    LayoutCache_Trim( p_filter->p_sys->p_layout_cache );
+
     for( int i = 0; i <= i_len; ++i )
     {
         if( i == i_len || psz_text[ i ] == '\n' )
@@ -111,6 +111,192 @@ static const vlc_fourcc_t *get_allowed_chromas( filter_t *p_filter )
     }
 }
 
+/* Opaque chromas whose pictures stay in GPU memory. Converting between
+ * chromas of the same family does not copy the pictures to the CPU. */
+static const vlc_fourcc_t pi_gpu_families[] = {
+    VLC_CODEC_VAAPI_420, VLC_CODEC_VAAPI_420_10BPP, 0,
+    VLC_CODEC_VDPAU_VIDEO_420, VLC_CODEC_VDPAU_VIDEO_422,
+    VLC_CODEC_VDPAU_VIDEO_444, VLC_CODEC_VDPAU_OUTPUT, 0,
+    VLC_CODEC_D3D9_OPAQUE, VLC_CODEC_D3D9_OPAQUE_10B, 0,
+    VLC_CODEC_D3D11_OPAQUE, VLC_CODEC_D3D11_OPAQUE_10B, 0,
+    VLC_CODEC_CVPX_NV12, VLC_CODEC_CVPX_UYVY, VLC_CODEC_CVPX_I420,
+    VLC_CODEC_CVPX_BGRA, VLC_CODEC_CVPX_P010, 0,
+    0
+};
+
+static const vlc_fourcc_t *get_gpu_family( vlc_fourcc_t i_chroma )
+{
+    for( const vlc_fourcc_t *p_family = pi_gpu_families; *p_family;
+         p_family++ )
+    {
+        const vlc_fourcc_t *p = p_family;
+        for( ; *p; p++ )
+            if( *p == i_chroma )
+                return p_family;
+        p_family = p;
+    }
+    return NULL;
+}
+
+/* Declared cost of converting one pixel between two CPU chromas, in rough
+ * units, for the conversions done by dedicated SIMD modules. The others go
+ * through swscale, with CONVERSION_COST_GENERIC. */
+static const struct
+{
+    vlc_fourcc_t i_from;
+    vlc_fourcc_t i_to;
+    unsigned i_cost;
+} conversion_costs[] = {
+    /* Plane (de)interleaving */
+    { VLC_CODEC_I420,     VLC_CODEC_NV12,     1 },
+    { VLC_CODEC_YV12,     VLC_CODEC_NV12,     1 },
+    { VLC_CODEC_NV12,     VLC_CODEC_I420,     1 },
+    { VLC_CODEC_NV12,     VLC_CODEC_YV12,     1 },
+    { VLC_CODEC_I420_10L, VLC_CODEC_P010,     1 },
+    { VLC_CODEC_P010,     VLC_CODEC_I420_10L, 1 },
+    /* Chroma subsampling and packing */
+    { VLC_CODEC_I422,     VLC_CODEC_I420,     1 },
+    { VLC_CODEC_I420,     VLC_CODEC_YUYV,     2 },
+    { VLC_CODEC_I420,     VLC_CODEC_UYVY,     2 },
+    { VLC_CODEC_I422,     VLC_CODEC_YUYV,     2 },
+    { VLC_CODEC_I422,     VLC_CODEC_UYVY,     2 },
+    { VLC_CODEC_YUYV,     VLC_CODEC_I420,     2 },
+    { VLC_CODEC_UYVY,     VLC_CODEC_I420,     2 },
+    { VLC_CODEC_YUYV,     VLC_CODEC_I422,     2 },
+    { VLC_CODEC_UYVY,     VLC_CODEC_I422,     2 },
+    /* YUV to RGB */
+    { VLC_CODEC_I420,     VLC_CODEC_RGB32,    3 },
+    { VLC_CODEC_I420,     VLC_CODEC_RGB16,    3 },
+};
+
+#define CONVERSION_COST_GPU     1  /* stays in GPU memory */
+#define CONVERSION_COST_GENERIC 4  /* swscale */
+#define CONVERSION_COST_COPY    16 /* between GPU and CPU memory */
+
+static unsigned get_conversion_cost( vlc_fourcc_t i_from, vlc_fourcc_t i_to )
+{
+    if( i_from == i_to )
+        return 0;
+
+    const vlc_fourcc_t *p_from_family = get_gpu_family( i_from );
+    const vlc_fourcc_t *p_to_family = get_gpu_family( i_to );
+    if( p_from_family != NULL || p_to_family != NULL )
+        return p_from_family == p_to_family ? CONVERSION_COST_GPU
+                                            : CONVERSION_COST_COPY;
+
+    for( size_t i = 0; i < ARRAY_SIZE(conversion_costs); i++ )
+        if( conversion_costs[i].i_from == i_from &&
+            conversion_costs[i].i_to == i_to )
+            return conversion_costs[i].i_cost;
+    return CONVERSION_COST_GENERIC;
+}
+
+/* Middle man chromas which worked, per (input, output) pair, so that the
+ * next chain for the same conversion is built at the first attempt */
+#define MIDDLE_CACHE_SIZE 16
+
+static struct
+{
+    vlc_mutex_t lock;
+    unsigned i_next;
+    struct
+    {
+        vlc_fourcc_t i_in;
+        vlc_fourcc_t i_out;
+        vlc_fourcc_t i_mid;
+    } entries[MIDDLE_CACHE_SIZE];
+} middle_cache = { VLC_STATIC_MUTEX, 0, { { 0, 0, 0 } } };
+
+static vlc_fourcc_t middle_cache_Get( vlc_fourcc_t i_in, vlc_fourcc_t i_out )
+{
+    vlc_fourcc_t i_mid = 0;
+
+    vlc_mutex_lock( &middle_cache.lock );
+    for( unsigned i = 0; i < MIDDLE_CACHE_SIZE; i++ )
+        if( middle_cache.entries[i].i_in == i_in &&
+            middle_cache.entries[i].i_out == i_out )
+        {
+            i_mid = middle_cache.entries[i].i_mid;
+            break;
+        }
+    vlc_mutex_unlock( &middle_cache.lock );
+    return i_mid;
+}
+
+static void middle_cache_Put( vlc_fourcc_t i_in, vlc_fourcc_t i_out,
+                              vlc_fourcc_t i_mid )
+{
+    vlc_mutex_lock( &middle_cache.lock );
+    unsigned i;
+    for( i = 0; i < MIDDLE_CACHE_SIZE; i++ )
+        if( middle_cache.entries[i].i_in == i_in &&
+            middle_cache.entries[i].i_out == i_out )
+            break;
+    if( i == MIDDLE_CACHE_SIZE )
+    {
+        i = middle_cache.i_next;
+        middle_cache.i_next = ( i + 1 ) % MIDDLE_CACHE_SIZE;
+    }
+    middle_cache.entries[i].i_in = i_in;
+    middle_cache.entries[i].i_out = i_out;
+    middle_cache.entries[i].i_mid = i_mid;
+    vlc_mutex_unlock( &middle_cache.lock );
+}
+
+#define MAX_MIDDLE_CHROMAS 16
+
+/**
+ * Lists the middle man chromas to try, cheapest chain first.
+ *
+ * The cost of a chain is the sum of the costs of its two conversions, so
+ * staying in the GPU family of the input comes first, and a single fast
+ * step is preferred over two generic ones. The middle man that worked last
+ * time for the same conversion is tried before all others.
+ */
+static unsigned get_middle_chromas( filter_t *p_filter,
+                                    vlc_fourcc_t pi_chromas[MAX_MIDDLE_CHROMAS] )
+{
+    const vlc_fourcc_t i_in = p_filter->fmt_in.video.i_chroma;
+    const vlc_fourcc_t i_out = p_filter->fmt_out.video.i_chroma;
+    unsigned pi_costs[MAX_MIDDLE_CHROMAS];
+    unsigned i_count = 0;
+
+    const vlc_fourcc_t *p_family = get_gpu_family( i_in );
+    const vlc_fourcc_t *pi_allowed_chromas = get_allowed_chromas( p_filter );
+    for( unsigned n = 0; n < 2; n++ )
+    {
+        const vlc_fourcc_t *p = n == 0 ? p_family : pi_allowed_chromas;
+        for( ; p != NULL && *p && i_count < MAX_MIDDLE_CHROMAS; p++ )
+        {
+            if( *p == i_in || *p == i_out )
+                continue;
+
+            /* Insertion sort, keeping the list order for equal costs */
+            const unsigned i_cost = get_conversion_cost( i_in, *p )
+                                  + get_conversion_cost( *p, i_out );
+            unsigned i = i_count++;
+            for( ; i > 0 && pi_costs[i - 1] > i_cost; i-- )
+            {
+                pi_chromas[i] = pi_chromas[i - 1];
+                pi_costs[i] = pi_costs[i - 1];
+            }
+            pi_chromas[i] = *p;
+            pi_costs[i] = i_cost;
+        }
+    }
+
+    const vlc_fourcc_t i_cached = middle_cache_Get( i_in, i_out );
+    for( unsigned i = 1; i_cached != 0 && i < i_count; i++ )
+        if( pi_chromas[i] == i_cached )
+        {
+            memmove( &pi_chromas[1], &pi_chromas[0], i * sizeof(*pi_chromas) );
+            pi_chromas[0] = i_cached;
+            break;
+        }
+
+    return i_count;
+}
+
 struct filter_sys_t
 {
     filter_chain_t *p_chain;
@@ -321,13 +507,11 @@ static int BuildChromaChain( filter_t *p_filter )
     int i_ret = VLC_EGENERIC;
 
     /* Now try chroma format list */
-    const vlc_fourcc_t *pi_allowed_chromas = get_allowed_chromas( p_filter );
-    for( int i = 0; pi_allowed_chromas[i]; i++ )
+    vlc_fourcc_t pi_chromas[MAX_MIDDLE_CHROMAS];
+    const unsigned i_chromas = get_middle_chromas( p_filter, pi_chromas );
+    for( unsigned i = 0; i < i_chromas; i++ )
     {
-        const vlc_fourcc_t i_chroma = pi_allowed_chromas[i];
-        if( i_chroma == p_filter->fmt_in.i_codec ||
-            i_chroma == p_filter->fmt_out.i_codec )
-            continue;
+        const vlc_fourcc_t i_chroma = pi_chromas[i];
 
         msg_Dbg( p_filter, "Trying to use chroma %4.4s as middle man",
                  (char*)&i_chroma );
@@ -344,7 +528,11 @@ static int BuildChromaChain( filter_t *p_filter )
         es_format_Clean( &fmt_mid );
 
         if( i_ret == VLC_SUCCESS )
+        {
+            middle_cache_Put( p_filter->fmt_in.video.i_chroma,
+                              p_filter->fmt_out.video.i_chroma, i_chroma );
             break;
+        }
     }
 
     return i_ret;
@@ -363,15 +551,13 @@ static int BuildFilterChain( filter_t *p_filter )
     int i_ret = VLC_EGENERIC;
 
     /* Now try chroma format list */
-    const vlc_fourcc_t *pi_allowed_chromas = get_allowed_chromas( p_filter );
-    for( int i = 0; pi_allowed_chromas[i]; i++ )
+    vlc_fourcc_t pi_chromas[MAX_MIDDLE_CHROMAS];
+    const unsigned i_chromas = get_middle_chromas( p_filter, pi_chromas );
+    for( unsigned i = 0; i < i_chromas; i++ )
     {
         filter_chain_Reset( p_filter->p_sys->p_chain, &p_filter->fmt_in, &p_filter->fmt_out );
 
-        const vlc_fourcc_t i_chroma = pi_allowed_chromas[i];
-        if( i_chroma == p_filter->fmt_in.i_codec ||
-            i_chroma == p_filter->fmt_out.i_codec )
-            continue;
+        const vlc_fourcc_t i_chroma = pi_chromas[i];
 
         msg_Dbg( p_filter, "Trying to use chroma %4.4s as middle man",
                  (char*)&i_chroma );
@@ -35,6 +35,17 @@
 #include <vlc_cpu.h>
 #include <assert.h>
 
+#ifndef COPY_TEST_NOOPTIM
+# ifdef HAVE_AVX2_INTRINSICS
+#  include <immintrin.h>
+#  define COPY_AVX2
+# endif
+# if defined(__aarch64__) && defined(__ARM_NEON)
+#  include <arm_neon.h>
+#  define COPY_NEON
+# endif
+#endif
+
 #include "copy.h"
 static void CopyPlane(uint8_t *dst, size_t dst_pitch,
                       const uint8_t *src, size_t src_pitch,
@@ -613,12 +624,274 @@ static void SSE_Copy420_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
 #undef COPY64
 #endif /* CAN_COMPILE_SSE2 */
 
+/* Line kernels used instead of the plain C loops. A positive bitshift
+ * shifts 16 bits samples right, a negative one shifts them left. */
+struct copy_lines
+{
+    void (*split)(uint8_t *dstu, uint8_t *dstv, const uint8_t *src,
+                  size_t count);
+    void (*split16)(uint16_t *dstu, uint16_t *dstv, const uint16_t *src,
+                    size_t count, int bitshift);
+    void (*interleave)(uint8_t *dst, const uint8_t *srcu, const uint8_t *srcv,
+                       size_t count);
+    void (*interleave16)(uint16_t *dst, const uint16_t *srcu,
+                         const uint16_t *srcv, size_t count, int bitshift);
+    void (*shift16)(uint16_t *dst, const uint16_t *src, size_t count,
+                    int bitshift);
+};
+
+static inline uint16_t Shift16(uint16_t v, int bitshift)
+{
+    return bitshift >= 0 ? v >> bitshift : v << -bitshift;
+}
+
+#ifdef COPY_AVX2
+__attribute__ ((__target__ ("avx2")))
+static void AVX2_SplitLine(uint8_t *dstu, uint8_t *dstv, const uint8_t *src,
+                           size_t count)
+{
+    const __m256i shuffle = _mm256_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14,
+                                             1, 3, 5, 7, 9, 11, 13, 15,
+                                             0, 2, 4, 6, 8, 10, 12, 14,
+                                             1, 3, 5, 7, 9, 11, 13, 15);
+    size_t x = 0;
+    for (; x + 32 <= count; x += 32)
+    {
+        /* UV pairs to U0-7 V0-7 U8-15 V8-15, then U0-15 V0-15 */
+        __m256i a = _mm256_loadu_si256((const __m256i *)&src[2 * x]);
+        __m256i b = _mm256_loadu_si256((const __m256i *)&src[2 * x + 32]);
+        a = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(a, shuffle), 0xd8);
+        b = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(b, shuffle), 0xd8);
+        _mm256_storeu_si256((__m256i *)&dstu[x], _mm256_permute2x128_si256(a, b, 0x20));
+        _mm256_storeu_si256((__m256i *)&dstv[x], _mm256_permute2x128_si256(a, b, 0x31));
+    }
+    for (; x < count; x++)
+    {
+        dstu[x] = src[2 * x];
+        dstv[x] = src[2 * x + 1];
+    }
+}
+
+__attribute__ ((__target__ ("avx2")))
+static inline __m256i AVX2_Shift16(__m256i v, int bitshift)
+{
+    if (bitshift > 0)
+        return _mm256_srl_epi16(v, _mm_cvtsi32_si128(bitshift));
+    if (bitshift < 0)
+        return _mm256_sll_epi16(v, _mm_cvtsi32_si128(-bitshift));
+    return v;
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void AVX2_SplitLine16(uint16_t *dstu, uint16_t *dstv,
+                             const uint16_t *src, size_t count, int bitshift)
+{
+    const __m256i shuffle = _mm256_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13,
+                                             2, 3, 6, 7, 10, 11, 14, 15,
+                                             0, 1, 4, 5, 8, 9, 12, 13,
+                                             2, 3, 6, 7, 10, 11, 14, 15);
+    size_t x = 0;
+    for (; x + 16 <= count; x += 16)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i *)&src[2 * x]);
+        __m256i b = _mm256_loadu_si256((const __m256i *)&src[2 * x + 16]);
+        a = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(a, shuffle), 0xd8);
+        b = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(b, shuffle), 0xd8);
+        __m256i u = _mm256_permute2x128_si256(a, b, 0x20);
+        __m256i v = _mm256_permute2x128_si256(a, b, 0x31);
+        _mm256_storeu_si256((__m256i *)&dstu[x], AVX2_Shift16(u, bitshift));
+        _mm256_storeu_si256((__m256i *)&dstv[x], AVX2_Shift16(v, bitshift));
+    }
+    for (; x < count; x++)
+    {
+        dstu[x] = Shift16(src[2 * x], bitshift);
+        dstv[x] = Shift16(src[2 * x + 1], bitshift);
+    }
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void AVX2_InterleaveLine(uint8_t *dst, const uint8_t *srcu,
+                                const uint8_t *srcv, size_t count)
+{
+    size_t x = 0;
+    for (; x + 32 <= count; x += 32)
+    {
+        __m256i u = _mm256_loadu_si256((const __m256i *)&srcu[x]);
+        __m256i v = _mm256_loadu_si256((const __m256i *)&srcv[x]);
+        __m256i lo = _mm256_unpacklo_epi8(u, v);
+        __m256i hi = _mm256_unpackhi_epi8(u, v);
+        _mm256_storeu_si256((__m256i *)&dst[2 * x], _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i *)&dst[2 * x + 32], _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    for (; x < count; x++)
+    {
+        dst[2 * x] = srcu[x];
+        dst[2 * x + 1] = srcv[x];
+    }
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void AVX2_InterleaveLine16(uint16_t *dst, const uint16_t *srcu,
+                                  const uint16_t *srcv, size_t count,
+                                  int bitshift)
+{
+    size_t x = 0;
+    for (; x + 16 <= count; x += 16)
+    {
+        __m256i u = AVX2_Shift16(_mm256_loadu_si256((const __m256i *)&srcu[x]), bitshift);
+        __m256i v = AVX2_Shift16(_mm256_loadu_si256((const __m256i *)&srcv[x]), bitshift);
+        __m256i lo = _mm256_unpacklo_epi16(u, v);
+        __m256i hi = _mm256_unpackhi_epi16(u, v);
+        _mm256_storeu_si256((__m256i *)&dst[2 * x], _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i *)&dst[2 * x + 16], _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    for (; x < count; x++)
+    {
+        dst[2 * x] = Shift16(srcu[x], bitshift);
+        dst[2 * x + 1] = Shift16(srcv[x], bitshift);
+    }
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void AVX2_ShiftLine16(uint16_t *dst, const uint16_t *src, size_t count,
+                             int bitshift)
+{
+    size_t x = 0;
+    for (; x + 16 <= count; x += 16)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)&src[x]);
+        _mm256_storeu_si256((__m256i *)&dst[x], AVX2_Shift16(v, bitshift));
+    }
+    for (; x < count; x++)
+        dst[x] = Shift16(src[x], bitshift);
+}
+
+static const struct copy_lines avx2_lines = {
+    AVX2_SplitLine, AVX2_SplitLine16, AVX2_InterleaveLine,
+    AVX2_InterleaveLine16, AVX2_ShiftLine16,
+};
+#endif /* COPY_AVX2 */
+
+#ifdef COPY_NEON
+static void NEON_SplitLine(uint8_t *dstu, uint8_t *dstv, const uint8_t *src,
+                           size_t count)
+{
+    size_t x = 0;
+    for (; x + 16 <= count; x += 16)
+    {
+        uint8x16x2_t uv = vld2q_u8(&src[2 * x]);
+        vst1q_u8(&dstu[x], uv.val[0]);
+        vst1q_u8(&dstv[x], uv.val[1]);
+    }
+    for (; x < count; x++)
+    {
+        dstu[x] = src[2 * x];
+        dstv[x] = src[2 * x + 1];
+    }
+}
+
+static void NEON_SplitLine16(uint16_t *dstu, uint16_t *dstv,
+                             const uint16_t *src, size_t count, int bitshift)
+{
+    /* vshlq shifts right with negative counts */
+    const int16x8_t shift = vdupq_n_s16(-bitshift);
+    size_t x = 0;
+    for (; x + 8 <= count; x += 8)
+    {
+        uint16x8x2_t uv = vld2q_u16(&src[2 * x]);
+        vst1q_u16(&dstu[x], vshlq_u16(uv.val[0], shift));
+        vst1q_u16(&dstv[x], vshlq_u16(uv.val[1], shift));
+    }
+    for (; x < count; x++)
+    {
+        dstu[x] = Shift16(src[2 * x], bitshift);
+        dstv[x] = Shift16(src[2 * x + 1], bitshift);
+    }
+}
+
+static void NEON_InterleaveLine(uint8_t *dst, const uint8_t *srcu,
+                                const uint8_t *srcv, size_t count)
+{
+    size_t x = 0;
+    for (; x + 16 <= count; x += 16)
+    {
+        uint8x16x2_t uv = { { vld1q_u8(&srcu[x]), vld1q_u8(&srcv[x]) } };
+        vst2q_u8(&dst[2 * x], uv);
+    }
+    for (; x < count; x++)
+    {
+        dst[2 * x] = srcu[x];
+        dst[2 * x + 1] = srcv[x];
+    }
+}
+
+static void NEON_InterleaveLine16(uint16_t *dst, const uint16_t *srcu,
+                                  const uint16_t *srcv, size_t count,
+                                  int bitshift)
+{
+    const int16x8_t shift = vdupq_n_s16(-bitshift);
+    size_t x = 0;
+    for (; x + 8 <= count; x += 8)
+    {
+        uint16x8x2_t uv = { { vshlq_u16(vld1q_u16(&srcu[x]), shift),
+                              vshlq_u16(vld1q_u16(&srcv[x]), shift) } };
+        vst2q_u16(&dst[2 * x], uv);
+    }
+    for (; x < count; x++)
+    {
+        dst[2 * x] = Shift16(srcu[x], bitshift);
+        dst[2 * x + 1] = Shift16(srcv[x], bitshift);
+    }
+}
+
+static void NEON_ShiftLine16(uint16_t *dst, const uint16_t *src, size_t count,
+                             int bitshift)
+{
+    const int16x8_t shift = vdupq_n_s16(-bitshift);
+    size_t x = 0;
+    for (; x + 8 <= count; x += 8)
+        vst1q_u16(&dst[x], vshlq_u16(vld1q_u16(&src[x]), shift));
+    for (; x < count; x++)
+        dst[x] = Shift16(src[x], bitshift);
+}
+
+static const struct copy_lines neon_lines = {
+    NEON_SplitLine, NEON_SplitLine16, NEON_InterleaveLine,
+    NEON_InterleaveLine16, NEON_ShiftLine16,
+};
+#endif /* COPY_NEON */
+
+/* Returns the line kernels of the CPU, or NULL to use the C loops */
+static const struct copy_lines *GetCopyLines(void)
+{
+#ifdef COPY_AVX2
+    if (vlc_CPU_AVX2())
+        return &avx2_lines;
+#endif
+#ifdef COPY_NEON
+    if (vlc_CPU_ARM64_NEON())
+        return &neon_lines;
+#endif
+    return NULL;
+}
+
 static void CopyPlane(uint8_t *dst, size_t dst_pitch,
                       const uint8_t *src, size_t src_pitch,
                       unsigned height, int bitshift)
 {
     const size_t copy_pitch = __MIN(src_pitch, dst_pitch);
-    if (bitshift != 0)
+    const struct copy_lines *lines = GetCopyLines();
+    if (bitshift != 0 && lines != NULL)
+    {
+        for (unsigned y = 0; y < height; y++)
+        {
+            lines->shift16((uint16_t *) dst, (const uint16_t *) src,
+                           copy_pitch / 2, bitshift);
+            src += src_pitch;
+            dst += dst_pitch;
+        }
+    }
+    else if (bitshift != 0)
     {
         for (unsigned y = 0; y < height; y++)
         {
@@ -724,6 +997,19 @@ static void SplitPlanes(uint8_t *dstu, size_t dstu_pitch,
                         uint8_t *dstv, size_t dstv_pitch,
                         const uint8_t *src, size_t src_pitch, unsigned height)
 {
+    const struct copy_lines *lines = GetCopyLines();
+    if (lines != NULL)
+    {
+        size_t copy_pitch = __MIN(__MIN(src_pitch / 2, dstu_pitch), dstv_pitch);
+        for (unsigned y = 0; y < height; y++)
+        {
+            lines->split(dstu, dstv, src, copy_pitch);
+            src  += src_pitch;
+            dstu += dstu_pitch;
+            dstv += dstv_pitch;
+        }
+        return;
+    }
     SPLIT_PLANES(uint8_t, 2);
 }
 
@@ -732,7 +1018,20 @@ static void SplitPlanes16(uint8_t *dstu, size_t dstu_pitch,
                           const uint8_t *src, size_t src_pitch, unsigned height,
                           int bitshift)
 {
-    if (bitshift == 0)
+    const struct copy_lines *lines = GetCopyLines();
+    if (lines != NULL)
+    {
+        size_t copy_pitch = __MIN(__MIN(src_pitch / 4, dstu_pitch), dstv_pitch);
+        for (unsigned y = 0; y < height; y++)
+        {
+            lines->split16((uint16_t *) dstu, (uint16_t *) dstv,
+                           (const uint16_t *) src, copy_pitch, bitshift);
+            src  += src_pitch;
+            dstu += dstu_pitch;
+            dstv += dstv_pitch;
+        }
+    }
+    else if (bitshift == 0)
         SPLIT_PLANES(uint16_t, 4);
     else if (bitshift > 0)
         SPLIT_PLANES_SHIFTR(uint16_t, 4, bitshift & 0xf);
@@ -834,6 +1133,17 @@ void Copy420_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
     const unsigned copy_lines = (height+1) / 2;
     const unsigned copy_pitch = __MIN(src_pitch[1], dst->p[1].i_pitch / 2);
 
+    const struct copy_lines *lines = GetCopyLines();
+    if (lines != NULL)
+    {
+        for (unsigned y = 0; y < copy_lines; y++)
+            lines->interleave(&dst->p[1].p_pixels[y * dst->p[1].i_pitch],
+                              &src[U_PLANE][y * src_pitch[U_PLANE]],
+                              &src[V_PLANE][y * src_pitch[V_PLANE]],
+                              copy_pitch);
+        return;
+    }
+
     const int i_extra_pitch_uv = dst->p[1].i_pitch - 2 * copy_pitch;
     const int i_extra_pitch_u  = src_pitch[U_PLANE] - copy_pitch;
     const int i_extra_pitch_v  = src_pitch[V_PLANE] - copy_pitch;
@@ -863,6 +1173,18 @@ void Copy420_16_P_to_SP(picture_t *dst, const uint8_t *src[static 3],
     const unsigned copy_lines = (height+1) / 2;
     const unsigned copy_pitch = src_pitch[1] / 2;
 
+    const struct copy_lines *lines = GetCopyLines();
+    if (lines != NULL)
+    {
+        for (unsigned y = 0; y < copy_lines; y++)
+            lines->interleave16(
+                (uint16_t *) &dst->p[1].p_pixels[y * dst->p[1].i_pitch],
+                (const uint16_t *) &src[U_PLANE][y * src_pitch[U_PLANE]],
+                (const uint16_t *) &src[V_PLANE][y * src_pitch[V_PLANE]],
+                copy_pitch, bitshift);
+        return;
+    }
+
     const int i_extra_pitch_uv = dst->p[1].i_pitch / 2 - 2 * copy_pitch;
     const int i_extra_pitch_u  = src_pitch[U_PLANE] / 2 - copy_pitch;
     const int i_extra_pitch_v  = src_pitch[V_PLANE] / 2 - copy_pitch;
@@ -885,6 +1207,22 @@ void CopyFromI420_10ToP010(picture_t *dst, const uint8_t *src[static 3],
 {
     (void) cache;
 
+    const struct copy_lines *lines = GetCopyLines();
+    if (lines != NULL)
+    {
+        for (unsigned y = 0; y < height; y++)
+            lines->shift16((uint16_t *) &dst->p[0].p_pixels[y * dst->p[0].i_pitch],
+                           (const uint16_t *) &src[Y_PLANE][y * src_pitch[Y_PLANE]],
+                           src_pitch[0] / 2, -6);
+        for (unsigned y = 0; y < (height+1) / 2; y++)
+            lines->interleave16(
+                (uint16_t *) &dst->p[1].p_pixels[y * dst->p[1].i_pitch],
+                (const uint16_t *) &src[U_PLANE][y * src_pitch[U_PLANE]],
+                (const uint16_t *) &src[V_PLANE][y * src_pitch[V_PLANE]],
+                src_pitch[1] / 2, -6);
+        return;
+    }
+
     const int i_extra_pitch_dst_y = (dst->p[0].i_pitch  - src_pitch[0]) / 2;
     const int i_extra_pitch_src_y = (src_pitch[Y_PLANE] - src_pitch[0]) / 2;
     uint16_t *dstY = (uint16_t *) dst->p[0].p_pixels;
@@ -897,7 +1235,7 @@ void CopyFromI420_10ToP010(picture_t *dst, const uint8_t *src[static 3],
         srcY += i_extra_pitch_src_y;
     }
 
-    const unsigned copy_lines = height / 2;
+    const unsigned copy_lines = (height+1) / 2;
     const unsigned copy_pitch = src_pitch[1] / 2;
 
     const int i_extra_pitch_uv = dst->p[1].i_pitch / 2 - 2 * copy_pitch;
@@ -1040,7 +1378,8 @@ static const struct test_conv convs[] = {
       .dsts = { { VLC_CODEC_I420_10L, 6, .conv16 = Copy420_16_SP_to_P } },
     },
     { .src_chroma = VLC_CODEC_I420_10L,
-      .dsts = { { VLC_CODEC_P010, -6, .conv16 = Copy420_16_P_to_SP } },
+      .dsts = { { VLC_CODEC_P010, -6, .conv16 = Copy420_16_P_to_SP },
+                { VLC_CODEC_P010, 0, .conv = CopyFromI420_10ToP010 } },
     },
 };
 #define NB_CONVS ARRAY_SIZE(convs)
@@ -1158,8 +1497,96 @@ static picture_t *pic_new_unaligned(const video_format_t *fmt)
     return picture_NewFromResource(fmt, &rsc);
 }
 
-int main(void)
+static void conv_run(const struct test_dst *test_dst, picture_t *dst,
+                     picture_t *src, const copy_cache_t *cache)
 {
+    const uint8_t * src_planes[3] = { src->p[Y_PLANE].p_pixels,
+                                      src->p[U_PLANE].p_pixels,
+                                      src->p[V_PLANE].p_pixels };
+    const size_t    src_pitches[3] = { src->p[Y_PLANE].i_pitch,
+                                       src->p[U_PLANE].i_pitch,
+                                       src->p[V_PLANE].i_pitch };
+
+    if (test_dst->bitshift == 0)
+        test_dst->conv(dst, src_planes, src_pitches,
+                       src->format.i_visible_height, cache);
+    else
+        test_dst->conv16(dst, src_planes, src_pitches,
+                         src->format.i_visible_height, test_dst->bitshift,
+                         cache);
+}
+
+/* Measures the throughput of every conversion at 1080p and 2160p,
+ * counted in source bytes */
+static int bench(void)
+{
+    static const struct test_size bench_sizes[] = {
+        { 1920, 1088, 1920, 1080 },
+        { 3840, 2160, 3840, 2160 },
+    };
+
+    for (size_t j = 0; j < ARRAY_SIZE(bench_sizes); ++j)
+    {
+        const struct test_size *size = &bench_sizes[j];
+
+        for (size_t i = 0; i < NB_CONVS; ++i)
+        {
+            const struct test_conv *conv = &convs[i];
+            const vlc_chroma_description_t *src_dsc =
+                vlc_fourcc_GetChromaDescription(conv->src_chroma);
+            assert(src_dsc);
+
+            video_format_t fmt;
+            video_format_Init(&fmt, 0);
+            video_format_Setup(&fmt, conv->src_chroma,
+                               size->i_width, size->i_height,
+                               size->i_visible_width, size->i_visible_height,
+                               1, 1);
+            picture_t *src = picture_NewFromFormat(&fmt);
+            assert(src);
+            piccheck(src, src_dsc, true);
+
+            size_t src_size = 0;
+            for (int p = 0; p < src->i_planes; ++p)
+                src_size += src->p[p].i_visible_lines * src->p[p].i_visible_pitch;
+
+            copy_cache_t cache;
+            int ret = CopyInitCache(&cache, src->format.i_width
+                                    * src_dsc->pixel_size);
+            assert(ret == VLC_SUCCESS);
+
+            for (size_t f = 0; conv->dsts[f].chroma != 0; ++f)
+            {
+                const struct test_dst *test_dst = &conv->dsts[f];
+                fmt.i_chroma = test_dst->chroma;
+                picture_t *dst = picture_NewFromFormat(&fmt);
+                assert(dst);
+
+                const unsigned count = 200;
+                mtime_t start = mdate();
+                for (unsigned k = 0; k < count; ++k)
+                    conv_run(test_dst, dst, src, &cache);
+                mtime_t elapsed = mdate() - start;
+
+                printf("%4u x %4u %4.4s -> %4.4s: %8.1f MB/s\n",
+                       size->i_visible_width, size->i_visible_height,
+                       (const char *) &conv->src_chroma,
+                       (const char *) &test_dst->chroma,
+                       elapsed ? (double) src_size * count / elapsed : 0.);
+                picture_Release(dst);
+            }
+            picture_Release(src);
+            CopyCleanCache(&cache);
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && !strcmp(argv[1], "--bench"))
+        return bench();
+
     alarm(10);
 
 #ifndef COPY_TEST_NOOPTIM
@@ -1208,25 +1635,12 @@ int main(void)
                 picture_t *dst = picture_NewFromFormat(&fmt);
                 assert(dst);
 
-                const uint8_t * src_planes[3] = { src->p[Y_PLANE].p_pixels,
-                                                  src->p[U_PLANE].p_pixels,
-                                                  src->p[V_PLANE].p_pixels };
-                const size_t    src_pitches[3] = { src->p[Y_PLANE].i_pitch,
-                                                   src->p[U_PLANE].i_pitch,
-                                                   src->p[V_PLANE].i_pitch };
-
                 fprintf(stderr, "testing: %u x %u (vis: %u x %u) %4.4s -> %4.4s\n",
                         size->i_width, size->i_height,
                         size->i_visible_width, size->i_visible_height,
                         (const char *) &src->format.i_chroma,
                         (const char *) &dst->format.i_chroma);
-                if (test_dst->bitshift == 0)
-                    test_dst->conv(dst, src_planes, src_pitches,
-                                   src->format.i_visible_height, &cache);
-                else
-                    test_dst->conv16(dst, src_planes, src_pitches,
-                                   src->format.i_visible_height, test_dst->bitshift,
-                                   &cache);
+                conv_run(test_dst, dst, src, &cache);
                 piccheck(dst, dst_dsc, false);
                 picture_Release(dst);
             }
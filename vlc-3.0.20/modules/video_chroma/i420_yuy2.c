@@ -62,10 +62,14 @@
  * Local and extern prototypes.
  *****************************************************************************/
 static int  Activate ( vlc_object_t * );
-
-static void I420_YUY2           ( filter_t *, picture_t *, picture_t * );
-static void I420_YVYU           ( filter_t *, picture_t *, picture_t * );
-static void I420_UYVY           ( filter_t *, picture_t *, picture_t * );
+static void Deactivate ( vlc_object_t * );
+
+static void I420_YUY2           ( filter_t *, picture_t *, picture_t *,
+                                  unsigned, unsigned );
+static void I420_YVYU           ( filter_t *, picture_t *, picture_t *,
+                                  unsigned, unsigned );
+static void I420_UYVY           ( filter_t *, picture_t *, picture_t *,
+                                  unsigned, unsigned );
 static picture_t *I420_YUY2_Filter    ( filter_t *, picture_t * );
 static picture_t *I420_YVYU_Filter    ( filter_t *, picture_t * );
 static picture_t *I420_UYVY_Filter    ( filter_t *, picture_t * );
@@ -100,7 +104,7 @@ vlc_module_begin ()
     set_capability( "video converter", 250 )
 # define vlc_CPU_capable() vlc_CPU_ALTIVEC()
 #endif
-    set_callbacks( Activate, NULL )
+    set_callbacks( Activate, Deactivate )
 vlc_module_end ()
 
 /*****************************************************************************
@@ -163,9 +167,18 @@ static int Activate( vlc_object_t *p_this )
             return -1;
     }
 
+    filter_HoldSlices( p_filter );
     return 0;
 }
 
+/*****************************************************************************
+ * Deactivate: release the slice threads
+ *****************************************************************************/
+static void Deactivate( vlc_object_t *p_this )
+{
+    filter_ReleaseSlices( (filter_t *)p_this );
+}
+
 #if 0
 static inline unsigned long long read_cycles(void)
 {
@@ -178,9 +191,9 @@ static inline unsigned long long read_cycles(void)
 
 /* Following functions are local */
 
-VIDEO_FILTER_WRAPPER( I420_YUY2 )
-VIDEO_FILTER_WRAPPER( I420_YVYU )
-VIDEO_FILTER_WRAPPER( I420_UYVY )
+VIDEO_FILTER_SLICES_WRAPPER( I420_YUY2, 2 )
+VIDEO_FILTER_SLICES_WRAPPER( I420_YVYU, 2 )
+VIDEO_FILTER_SLICES_WRAPPER( I420_UYVY, 2 )
 #if !defined (MODULE_NAME_IS_i420_yuy2_altivec)
 VIDEO_FILTER_WRAPPER( I420_IUYV )
 #endif
@@ -193,12 +206,15 @@ VIDEO_FILTER_WRAPPER( I420_Y211 )
  *****************************************************************************/
 VLC_TARGET
 static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
-                                           picture_t *p_dest )
+                                           picture_t *p_dest,
+                                           unsigned i_first, unsigned i_height )
 {
-    uint8_t *p_line1, *p_line2 = p_dest->p->p_pixels;
-    uint8_t *p_y1, *p_y2 = p_source->Y_PIXELS;
-    uint8_t *p_u = p_source->U_PIXELS;
-    uint8_t *p_v = p_source->V_PIXELS;
+    uint8_t *p_line1, *p_line2 = p_dest->p->p_pixels
+                               + i_first * p_dest->p->i_pitch;
+    uint8_t *p_y1, *p_y2 = p_source->Y_PIXELS
+                         + i_first * p_source->p[Y_PLANE].i_pitch;
+    uint8_t *p_u = p_source->U_PIXELS + i_first / 2 * p_source->p[U_PLANE].i_pitch;
+    uint8_t *p_v = p_source->V_PIXELS + i_first / 2 * p_source->p[V_PLANE].i_pitch;
 
     int i_x, i_y;
 
@@ -228,10 +244,10 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
     vector unsigned char y_vec;
 
     if( !( ( (p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width) % 32 ) |
-           ( (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) % 2 ) ) )
+           ( i_height % 2 ) ) )
     {
         /* Width is a multiple of 32, we take 2 lines at a time */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+        for( i_y = i_height / 2 ; i_y-- ; )
         {
             VEC_NEXT_LINES( );
             for( i_x = (p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width) / 32 ; i_x-- ; )
@@ -245,10 +261,10 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
 #warning FIXME: converting widths % 16 but !widths % 32 is broken on altivec
 #if 0
     else if( !( ( (p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width) % 16 ) |
-                ( (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) % 4 ) ) )
+                ( i_height % 4 ) ) )
     {
         /* Width is only a multiple of 16, we take 4 lines at a time */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 4 ; i_y-- ; )
+        for( i_y = i_height / 4 ; i_y-- ; )
         {
             /* Line 1 and 2, pixels 0 to ( width - 16 ) */
             VEC_NEXT_LINES( );
@@ -296,7 +312,7 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
                                - ( p_filter->fmt_out.video.i_x_offset * 2 );
 
 #if !defined(MODULE_NAME_IS_i420_yuy2_sse2)
-    for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+    for( i_y = i_height / 2 ; i_y-- ; )
     {
         p_line1 = p_line2;
         p_line2 += p_dest->p->i_pitch;
@@ -348,7 +364,7 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
         ((intptr_t)p_line2|(intptr_t)p_y2))) )
     {
         /* use faster SSE2 aligned fetch and store */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+        for( i_y = i_height / 2 ; i_y-- ; )
         {
             p_line1 = p_line2;
             p_line2 += p_dest->p->i_pitch;
@@ -374,7 +390,7 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
     else
     {
         /* use slower SSE2 unaligned fetch and store */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+        for( i_y = i_height / 2 ; i_y-- ; )
         {
             p_line1 = p_line2;
             p_line2 += p_dest->p->i_pitch;
@@ -408,12 +424,15 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
  *****************************************************************************/
 VLC_TARGET
 static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
-                                           picture_t *p_dest )
+                                           picture_t *p_dest,
+                                           unsigned i_first, unsigned i_height )
 {
-    uint8_t *p_line1, *p_line2 = p_dest->p->p_pixels;
-    uint8_t *p_y1, *p_y2 = p_source->Y_PIXELS;
-    uint8_t *p_u = p_source->U_PIXELS;
-    uint8_t *p_v = p_source->V_PIXELS;
+    uint8_t *p_line1, *p_line2 = p_dest->p->p_pixels
+                               + i_first * p_dest->p->i_pitch;
+    uint8_t *p_y1, *p_y2 = p_source->Y_PIXELS
+                         + i_first * p_source->p[Y_PLANE].i_pitch;
+    uint8_t *p_u = p_source->U_PIXELS + i_first / 2 * p_source->p[U_PLANE].i_pitch;
+    uint8_t *p_v = p_source->V_PIXELS + i_first / 2 * p_source->p[V_PLANE].i_pitch;
 
     int i_x, i_y;
 
@@ -443,10 +462,10 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
     vector unsigned char y_vec;
 
     if( !( ( (p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width) % 32 ) |
-           ( (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) % 2 ) ) )
+           ( i_height % 2 ) ) )
     {
         /* Width is a multiple of 32, we take 2 lines at a time */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+        for( i_y = i_height / 2 ; i_y-- ; )
         {
             VEC_NEXT_LINES( );
             for( i_x = (p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width) / 32 ; i_x-- ; )
@@ -458,10 +477,10 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
         }
     }
     else if( !( ( (p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width) % 16 ) |
-                ( (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) % 4 ) ) )
+                ( i_height % 4 ) ) )
     {
         /* Width is only a multiple of 16, we take 4 lines at a time */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 4 ; i_y-- ; )
+        for( i_y = i_height / 4 ; i_y-- ; )
         {
             /* Line 1 and 2, pixels 0 to ( width - 16 ) */
             VEC_NEXT_LINES( );
@@ -508,7 +527,7 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
                                - ( p_filter->fmt_out.video.i_x_offset * 2 );
 
 #if !defined(MODULE_NAME_IS_i420_yuy2_sse2)
-    for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+    for( i_y = i_height / 2 ; i_y-- ; )
     {
         p_line1 = p_line2;
         p_line2 += p_dest->p->i_pitch;
@@ -558,7 +577,7 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
         ((intptr_t)p_line2|(intptr_t)p_y2))) )
     {
         /* use faster SSE2 aligned fetch and store */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+        for( i_y = i_height / 2 ; i_y-- ; )
         {
             p_line1 = p_line2;
             p_line2 += p_dest->p->i_pitch;
@@ -586,7 +605,7 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
     else
     {
         /* use slower SSE2 unaligned fetch and store */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+        for( i_y = i_height / 2 ; i_y-- ; )
         {
             p_line1 = p_line2;
             p_line2 += p_dest->p->i_pitch;
@@ -621,12 +640,15 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
  *****************************************************************************/
 VLC_TARGET
 static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
-                                           picture_t *p_dest )
+                                           picture_t *p_dest,
+                                           unsigned i_first, unsigned i_height )
 {
-    uint8_t *p_line1, *p_line2 = p_dest->p->p_pixels;
-    uint8_t *p_y1, *p_y2 = p_source->Y_PIXELS;
-    uint8_t *p_u = p_source->U_PIXELS;
-    uint8_t *p_v = p_source->V_PIXELS;
+    uint8_t *p_line1, *p_line2 = p_dest->p->p_pixels
+                               + i_first * p_dest->p->i_pitch;
+    uint8_t *p_y1, *p_y2 = p_source->Y_PIXELS
+                         + i_first * p_source->p[Y_PLANE].i_pitch;
+    uint8_t *p_u = p_source->U_PIXELS + i_first / 2 * p_source->p[U_PLANE].i_pitch;
+    uint8_t *p_v = p_source->V_PIXELS + i_first / 2 * p_source->p[V_PLANE].i_pitch;
 
     int i_x, i_y;
 
@@ -656,10 +678,10 @@ static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
     vector unsigned char y_vec;
 
     if( !( ( (p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width) % 32 ) |
-           ( (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) % 2 ) ) )
+           ( i_height % 2 ) ) )
     {
         /* Width is a multiple of 32, we take 2 lines at a time */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+        for( i_y = i_height / 2 ; i_y-- ; )
         {
             VEC_NEXT_LINES( );
             for( i_x = (p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width) / 32 ; i_x-- ; )
@@ -671,10 +693,10 @@ static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
         }
     }
     else if( !( ( (p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width) % 16 ) |
-                ( (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) % 4 ) ) )
+                ( i_height % 4 ) ) )
     {
         /* Width is only a multiple of 16, we take 4 lines at a time */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 4 ; i_y-- ; )
+        for( i_y = i_height / 4 ; i_y-- ; )
         {
             /* Line 1 and 2, pixels 0 to ( width - 16 ) */
             VEC_NEXT_LINES( );
@@ -721,7 +743,7 @@ static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
                                - ( p_filter->fmt_out.video.i_x_offset * 2 );
 
 #if !defined(MODULE_NAME_IS_i420_yuy2_sse2)
-    for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+    for( i_y = i_height / 2 ; i_y-- ; )
     {
         p_line1 = p_line2;
         p_line2 += p_dest->p->i_pitch;
@@ -771,7 +793,7 @@ static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
         ((intptr_t)p_line2|(intptr_t)p_y2))) )
     {
         /* use faster SSE2 aligned fetch and store */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+        for( i_y = i_height / 2 ; i_y-- ; )
         {
             p_line1 = p_line2;
             p_line2 += p_dest->p->i_pitch;
@@ -799,7 +821,7 @@ static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
     else
     {
         /* use slower SSE2 unaligned fetch and store */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+        for( i_y = i_height / 2 ; i_y-- ; )
         {
             p_line1 = p_line2;
             p_line2 += p_dest->p->i_pitch;
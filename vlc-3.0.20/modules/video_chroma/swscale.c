@@ -39,6 +39,13 @@
 #include <libswscale/swscale.h>
 #include <libswscale/version.h>
 
+/* Slice threading, through the AVFrame API */
+#define SWSCALE_THREADS (LIBSWSCALE_VERSION_INT >= AV_VERSION_INT(6, 1, 100))
+#if SWSCALE_THREADS
+# include <libavutil/frame.h>
+# include <libavutil/opt.h>
+#endif
+
 #ifdef __APPLE__
 # include <TargetConditionals.h>
 #endif
@@ -58,6 +65,10 @@ static void CloseScaler( vlc_object_t * );
 #define SCALEMODE_TEXT N_("Scaling mode")
 #define SCALEMODE_LONGTEXT N_("Scaling mode to use.")
 
+#define THREADS_TEXT N_("Threads")
+#define THREADS_LONGTEXT N_( "Number of threads used to scale each " \
+    "picture (0 = number of CPUs). This requires libswscale 6.1 or later." )
+
 static const int pi_mode_values[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
 const char *const ppsz_mode_descriptions[] =
 { N_("Fast bilinear"), N_("Bilinear"), N_("Bicubic (good quality)"),
@@ -74,6 +85,8 @@ vlc_module_begin ()
     set_callbacks( OpenScaler, CloseScaler )
     add_integer( "swscale-mode", 2, SCALEMODE_TEXT, SCALEMODE_LONGTEXT, true )
         change_integer_list( pi_mode_values, ppsz_mode_descriptions )
+    add_integer_with_range( "swscale-threads", 0, 0, 32,
+                            THREADS_TEXT, THREADS_LONGTEXT, true )
 vlc_module_end ()
 
 /* Version checking */
@@ -82,6 +95,18 @@ vlc_module_end ()
  * Local prototypes
  ****************************************************************************/
 
+/* Number of scaling contexts kept, so that going back and forth between a
+ * few resolutions (adaptive streaming) does not initialize them each time */
+#define SCALER_CACHE_SIZE 4
+
+typedef struct
+{
+    int i_fmti, i_fmto;
+    int i_widthi, i_heighti;
+    int i_widtho, i_heighto;
+    int i_flags;
+} ScalerKey;
+
 /**
  * Internal swscale filter structure.
  */
@@ -89,6 +114,14 @@ struct filter_sys_t
 {
     SwsFilter *p_filter;
     int i_cpu_mask, i_sws_flags;
+    unsigned i_threads;
+
+    /* Most recently used first */
+    struct
+    {
+        ScalerKey key;
+        struct SwsContext *ctx;
+    } cache[SCALER_CACHE_SIZE];
 
     video_format_t fmt_in;
     video_format_t fmt_out;
@@ -97,6 +130,8 @@ struct filter_sys_t
 
     struct SwsContext *ctx;
     struct SwsContext *ctxA;
+    ScalerKey key;
+    ScalerKey keyA;
     picture_t *p_src_a;
     picture_t *p_dst_a;
     int i_extend_factor;
@@ -111,6 +146,7 @@ struct filter_sys_t
 static picture_t *Filter( filter_t *, picture_t * );
 static int  Init( filter_t * );
 static void Clean( filter_t * );
+static void CacheClean( filter_sys_t * );
 
 typedef struct
 {
@@ -161,6 +197,13 @@ static int OpenScaler( vlc_object_t *p_this )
 
     /* Set CPU capabilities */
     p_sys->i_cpu_mask = GetSwsCpuMask();
+#if SWSCALE_THREADS
+    p_sys->i_threads = var_InheritInteger( p_filter, "swscale-threads" );
+    if( p_sys->i_threads == 0 )
+        p_sys->i_threads = vlc_GetCPUCount();
+#else
+    p_sys->i_threads = 1;
+#endif
 
     /* */
     i_sws_mode = var_CreateGetInteger( p_filter, "swscale-mode" );
@@ -186,6 +229,7 @@ static int OpenScaler( vlc_object_t *p_this )
 
     if( Init( p_filter ) )
     {
+        CacheClean( p_sys );
         if( p_sys->p_filter )
             sws_freeFilter( p_sys->p_filter );
         free( p_sys );
@@ -216,6 +260,7 @@ static void CloseScaler( vlc_object_t *p_this )
     filter_sys_t *p_sys = p_filter->p_sys;
 
     Clean( p_filter );
+    CacheClean( p_sys );
     if( p_sys->p_filter )
         sws_freeFilter( p_sys->p_filter );
     free( p_sys );
@@ -350,6 +395,89 @@ static int GetParameters( ScalerConfiguration *p_cfg,
     return VLC_SUCCESS;
 }
 
+static struct SwsContext *CreateContext( filter_t *p_filter,
+                                         const ScalerKey *key )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+#if SWSCALE_THREADS
+    if( p_sys->i_threads > 1 )
+    {
+        struct SwsContext *ctx = sws_alloc_context();
+        if( ctx == NULL )
+            return NULL;
+
+        av_opt_set_int( ctx, "srcw", key->i_widthi, 0 );
+        av_opt_set_int( ctx, "srch", key->i_heighti, 0 );
+        av_opt_set_int( ctx, "src_format", key->i_fmti, 0 );
+        av_opt_set_int( ctx, "dstw", key->i_widtho, 0 );
+        av_opt_set_int( ctx, "dsth", key->i_heighto, 0 );
+        av_opt_set_int( ctx, "dst_format", key->i_fmto, 0 );
+        av_opt_set_int( ctx, "sws_flags", key->i_flags, 0 );
+        av_opt_set_int( ctx, "threads", p_sys->i_threads, 0 );
+        if( sws_init_context( ctx, p_sys->p_filter, NULL ) < 0 )
+        {
+            sws_freeContext( ctx );
+            return NULL;
+        }
+        return ctx;
+    }
+#endif
+    return sws_getContext( key->i_widthi, key->i_heighti, key->i_fmti,
+                           key->i_widtho, key->i_heighto, key->i_fmto,
+                           key->i_flags, p_sys->p_filter, NULL, 0 );
+}
+
+/* Returns a cached context for the given parameters or creates it, evicting
+ * the least recently used one */
+static struct SwsContext *GetContext( filter_t *p_filter, const ScalerKey *key )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    unsigned i;
+
+    for( i = 0; i < SCALER_CACHE_SIZE - 1; i++ )
+        if( p_sys->cache[i].ctx == NULL ||
+            !memcmp( &p_sys->cache[i].key, key, sizeof(*key) ) )
+            break;
+
+    struct SwsContext *ctx = p_sys->cache[i].ctx;
+    if( ctx != NULL && memcmp( &p_sys->cache[i].key, key, sizeof(*key) ) )
+    {
+        sws_freeContext( ctx );
+        ctx = NULL;
+    }
+    if( ctx == NULL )
+    {
+        ctx = CreateContext( p_filter, key );
+        if( ctx == NULL )
+        {
+            /* Keep the cache packed */
+            memmove( &p_sys->cache[i], &p_sys->cache[i + 1],
+                     ( SCALER_CACHE_SIZE - 1 - i ) * sizeof(p_sys->cache[0]) );
+            p_sys->cache[SCALER_CACHE_SIZE - 1].ctx = NULL;
+            return NULL;
+        }
+    }
+    else
+        msg_Dbg( p_filter, "reusing scaling context %ix%i -> %ix%i",
+                 key->i_widthi, key->i_heighti, key->i_widtho, key->i_heighto );
+
+    memmove( &p_sys->cache[1], &p_sys->cache[0], i * sizeof(p_sys->cache[0]) );
+    p_sys->cache[0].key = *key;
+    p_sys->cache[0].ctx = ctx;
+    return ctx;
+}
+
+static void CacheClean( filter_sys_t *p_sys )
+{
+    for( unsigned i = 0; i < SCALER_CACHE_SIZE; i++ )
+    {
+        if( p_sys->cache[i].ctx )
+            sws_freeContext( p_sys->cache[i].ctx );
+        p_sys->cache[i].ctx = NULL;
+    }
+}
+
 static int Init( filter_t *p_filter )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
@@ -398,18 +526,27 @@ static int Init( filter_t *p_filter )
     const unsigned i_fmto_visible_width = p_fmto->i_visible_width * p_sys->i_extend_factor;
     for( int n = 0; n < (cfg.b_has_a ? 2 : 1); n++ )
     {
-        const int i_fmti = n == 0 ? cfg.i_fmti : AV_PIX_FMT_GRAY8;
-        const int i_fmto = n == 0 ? cfg.i_fmto : AV_PIX_FMT_GRAY8;
-        struct SwsContext *ctx;
+        const ScalerKey key = {
+            .i_fmti = n == 0 ? cfg.i_fmti : AV_PIX_FMT_GRAY8,
+            .i_fmto = n == 0 ? cfg.i_fmto : AV_PIX_FMT_GRAY8,
+            .i_widthi = i_fmti_visible_width,
+            .i_heighti = p_fmti->i_visible_height,
+            .i_widtho = i_fmto_visible_width,
+            .i_heighto = p_fmto->i_visible_height,
+            .i_flags = cfg.i_sws_flags | p_sys->i_cpu_mask,
+        };
+        struct SwsContext *ctx = GetContext( p_filter, &key );
 
-        ctx = sws_getContext( i_fmti_visible_width, p_fmti->i_visible_height, i_fmti,
-                              i_fmto_visible_width, p_fmto->i_visible_height, i_fmto,
-                              cfg.i_sws_flags | p_sys->i_cpu_mask,
-                              p_sys->p_filter, NULL, 0 );
         if( n == 0 )
+        {
             p_sys->ctx = ctx;
+            p_sys->key = key;
+        }
         else
+        {
             p_sys->ctxA = ctx;
+            p_sys->keyA = key;
+        }
     }
     if( p_sys->ctxA )
     {
@@ -480,11 +617,7 @@ static void Clean( filter_t *p_filter )
     if( p_sys->p_dst_a )
         picture_Release( p_sys->p_dst_a );
 
-    if( p_sys->ctxA )
-        sws_freeContext( p_sys->ctxA );
-
-    if( p_sys->ctx )
-        sws_freeContext( p_sys->ctx );
+    /* The contexts are owned by the cache */
 
     /* We have to set it to null has we call be called again :( */
     p_sys->ctx = NULL;
@@ -582,7 +715,54 @@ static void SwapUV( picture_t *p_dst, const picture_t *p_src )
     picture_CopyPixels( p_dst, &tmp );
 }
 
+#if SWSCALE_THREADS
+static void ReleaseNothing( void *opaque, uint8_t *data )
+{
+    VLC_UNUSED(opaque); VLC_UNUSED(data);
+}
+
+/* Points a frame to the picture planes. The buffer reference is only there
+ * so that libswscale references the frame instead of copying it. */
+static int WrapFrame( AVFrame *frame, uint8_t *pp_pixel[4], int pi_pitch[4],
+                      int i_width, int i_height, int i_format )
+{
+    frame->buf[0] = av_buffer_create( pp_pixel[0], 1, ReleaseNothing, NULL, 0 );
+    if( frame->buf[0] == NULL )
+        return VLC_ENOMEM;
+    for( unsigned i = 0; i < 4; i++ )
+    {
+        frame->data[i] = pp_pixel[i];
+        frame->linesize[i] = pi_pitch[i];
+    }
+    frame->width = i_width;
+    frame->height = i_height;
+    frame->format = i_format;
+    return VLC_SUCCESS;
+}
+
+static int ScaleThreaded( struct SwsContext *ctx, const ScalerKey *key,
+                          uint8_t *src[4], int src_stride[4],
+                          uint8_t *dst[4], int dst_stride[4] )
+{
+    AVFrame *src_frame = av_frame_alloc();
+    AVFrame *dst_frame = av_frame_alloc();
+    int ret = -1;
+
+    if( src_frame != NULL && dst_frame != NULL &&
+        WrapFrame( src_frame, src, src_stride,
+                   key->i_widthi, key->i_heighti, key->i_fmti ) == VLC_SUCCESS &&
+        WrapFrame( dst_frame, dst, dst_stride,
+                   key->i_widtho, key->i_heighto, key->i_fmto ) == VLC_SUCCESS )
+        ret = sws_scale_frame( ctx, dst_frame, src_frame );
+
+    av_frame_free( &src_frame );
+    av_frame_free( &dst_frame );
+    return ret;
+}
+#endif
+
 static void Convert( filter_t *p_filter, struct SwsContext *ctx,
+                     const ScalerKey *key,
                      picture_t *p_dst, picture_t *p_src, int i_height,
                      int i_plane_count, bool b_swap_uvi, bool b_swap_uvo )
 {
@@ -606,6 +786,13 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
     GetPixels( dst, dst_stride, p_sys->desc_out, &p_filter->fmt_out.video,
                p_dst, i_plane_count, b_swap_uvo );
 
+#if SWSCALE_THREADS
+    if( p_sys->i_threads > 1 &&
+        ScaleThreaded( ctx, key, src, src_stride, dst, dst_stride ) >= 0 )
+        return;
+#else
+    VLC_UNUSED(key);
+#endif
 #if LIBSWSCALE_VERSION_INT  >= ((0<<16)+(5<<8)+0)
     sws_scale( ctx, src, src_stride, 0, i_height,
                dst, dst_stride );
@@ -662,8 +849,9 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         /* Even if alpha is unused, swscale expects the pointer to be set */
         const int n_planes = !p_sys->ctxA && (p_src->i_planes == 4 ||
                              p_dst->i_planes == 4) ? 4 : 3;
-        Convert( p_filter, p_sys->ctx, p_dst, p_src, p_fmti->i_visible_height,
-                 n_planes, p_sys->b_swap_uvi, p_sys->b_swap_uvo );
+        Convert( p_filter, p_sys->ctx, &p_sys->key, p_dst, p_src,
+                 p_fmti->i_visible_height, n_planes,
+                 p_sys->b_swap_uvi, p_sys->b_swap_uvo );
     }
     if( p_sys->ctxA )
     {
@@ -675,8 +863,8 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         else
             plane_CopyPixels( p_sys->p_src_a->p, p_src->p+A_PLANE );
 
-        Convert( p_filter, p_sys->ctxA, p_sys->p_dst_a, p_sys->p_src_a,
-                 p_fmti->i_visible_height, 1, false, false );
+        Convert( p_filter, p_sys->ctxA, &p_sys->keyA, p_sys->p_dst_a,
+                 p_sys->p_src_a, p_fmti->i_visible_height, 1, false, false );
         if( p_fmto->i_chroma == VLC_CODEC_RGBA || p_fmto->i_chroma == VLC_CODEC_BGRA )
             InjectA( p_dst, p_sys->p_dst_a, OFFSET_A );
         else if( p_fmto->i_chroma == VLC_CODEC_ARGB )
@@ -123,6 +123,16 @@ struct filter_sys_t
                                int, int );
     int (*pf_process_sat_hue_clip)( picture_t *, picture_t *, int, int,
                                     int, int, int );
+
+    /* Set when the parameters change, the tables below are only computed
+     * again then */
+    atomic_bool b_changed;
+    union
+    {
+        uint8_t  p8[256];
+        uint16_t p16[1024]; /* The full range will only be used for 10-bit */
+    } luma;
+    int i_sin, i_cos, i_sat, i_x, i_y;
 };
 
 /*****************************************************************************
@@ -152,6 +162,15 @@ static int Create( vlc_object_t *p_this )
         CASE_PLANAR_YUV
             /* Planar YUV */
             p_filter->pf_video_filter = FilterPlanar;
+#ifdef HAVE_SSE2_INTRINSICS
+            if( vlc_CPU_SSE2() )
+            {
+                /* Clipping costs nothing there */
+                p_sys->pf_process_sat_hue_clip = planar_sat_hue_SSE2;
+                p_sys->pf_process_sat_hue = planar_sat_hue_SSE2;
+                break;
+            }
+#endif
             p_sys->pf_process_sat_hue_clip = planar_sat_hue_clip_C;
             p_sys->pf_process_sat_hue = planar_sat_hue_C;
             break;
@@ -160,6 +179,14 @@ static int Create( vlc_object_t *p_this )
         CASE_PLANAR_YUV9
             /* Planar YUV 9-bit or 10-bit */
             p_filter->pf_video_filter = FilterPlanar;
+#ifdef HAVE_SSE2_INTRINSICS
+            if( vlc_CPU_SSE2() )
+            {
+                p_sys->pf_process_sat_hue_clip = planar_sat_hue_SSE2_16;
+                p_sys->pf_process_sat_hue = planar_sat_hue_SSE2_16;
+                break;
+            }
+#endif
             p_sys->pf_process_sat_hue_clip = planar_sat_hue_clip_C_16;
             p_sys->pf_process_sat_hue = planar_sat_hue_C_16;
             break;
@@ -194,6 +221,7 @@ static int Create( vlc_object_t *p_this )
                            var_CreateGetFloatCommand( p_filter, "gamma" ) );
     atomic_init( &p_sys->b_brightness_threshold,
                  var_CreateGetBoolCommand( p_filter, "brightness-threshold" ) );
+    atomic_init( &p_sys->b_changed, true );
 
     var_AddCallback( p_filter, "contrast",   AdjustCallback, p_sys );
     var_AddCallback( p_filter, "brightness", AdjustCallback, p_sys );
@@ -226,44 +254,13 @@ static void Destroy( vlc_object_t *p_this )
 }
 
 /*****************************************************************************
- * Run the filter on a Planar YUV picture
+ * Compute the tables of the planar filter from the parameters
  *****************************************************************************/
-static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
+static void UpdatePlanarTables( filter_sys_t *p_sys, bool b_16bit,
+                                float f_range )
 {
-    /* The full range will only be used for 10-bit */
-    int pi_luma[1024];
     int pi_gamma[1024];
 
-    picture_t *p_outpic;
-
-    filter_sys_t *p_sys = p_filter->p_sys;
-
-    if( !p_pic ) return NULL;
-
-    p_outpic = filter_NewPicture( p_filter );
-    if( !p_outpic )
-    {
-        picture_Release( p_pic );
-        return NULL;
-    }
-
-    bool b_16bit;
-    float f_range;
-    switch( p_filter->fmt_in.video.i_chroma )
-    {
-        CASE_PLANAR_YUV10
-            b_16bit = true;
-            f_range = 1024.f;
-            break;
-        CASE_PLANAR_YUV9
-            b_16bit = true;
-            f_range = 512.f;
-            break;
-        default:
-            b_16bit = false;
-            f_range = 256.f;
-    }
-
     const float f_max = f_range - 1.f;
     const unsigned i_max = f_max;
     const int i_range = f_range;
@@ -296,7 +293,11 @@ static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
         /* Fill the luma lookup table */
         for( unsigned i = 0 ; i < i_size; i++ )
         {
-            pi_luma[ i ] = pi_gamma[VLC_CLIP( (int)(i_lum + i_cont * i / i_range), 0, i_max )];
+            int i_luma = pi_gamma[VLC_CLIP( (int)(i_lum + i_cont * i / i_range), 0, i_max )];
+            if( b_16bit )
+                p_sys->luma.p16[ i ] = i_luma;
+            else
+                p_sys->luma.p8[ i ] = i_luma;
         }
     }
     else
@@ -307,7 +308,10 @@ static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
          */
         for( int i = 0 ; i < i_range; i++ )
         {
-            pi_luma[ i ] = (i < i_lum) ? 0 : i_max;
+            if( b_16bit )
+                p_sys->luma.p16[ i ] = (i < i_lum) ? 0 : i_max;
+            else
+                p_sys->luma.p8[ i ] = (i < i_lum) ? 0 : i_max;
         }
 
         /*
@@ -316,11 +320,59 @@ static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
         i_sat = 0;
     }
 
+    p_sys->i_sin = sinf(f_hue) * f_max;
+    p_sys->i_cos = cosf(f_hue) * f_max;
+
+    /* pow(2, (bpp * 2) - 1) */
+    p_sys->i_x = ( cosf(f_hue) + sinf(f_hue) ) * f_range * i_mid;
+    p_sys->i_y = ( cosf(f_hue) - sinf(f_hue) ) * f_range * i_mid;
+    p_sys->i_sat = i_sat;
+}
+
+/*****************************************************************************
+ * Run the filter on a Planar YUV picture
+ *****************************************************************************/
+static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
+
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( !p_pic ) return NULL;
+
+    p_outpic = filter_NewPicture( p_filter );
+    if( !p_outpic )
+    {
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    bool b_16bit;
+    float f_range;
+    switch( p_filter->fmt_in.video.i_chroma )
+    {
+        CASE_PLANAR_YUV10
+            b_16bit = true;
+            f_range = 1024.f;
+            break;
+        CASE_PLANAR_YUV9
+            b_16bit = true;
+            f_range = 512.f;
+            break;
+        default:
+            b_16bit = false;
+            f_range = 256.f;
+    }
+
+    if( atomic_exchange( &p_sys->b_changed, false ) )
+        UpdatePlanarTables( p_sys, b_16bit, f_range );
+
     /*
      * Do the Y plane
      */
     if ( b_16bit )
     {
+        const uint16_t *pi_luma = p_sys->luma.p16;
         uint16_t *p_in, *p_in_end, *p_line_end;
         uint16_t *p_out;
         p_in = (uint16_t *) p_pic->p[Y_PLANE].p_pixels;
@@ -357,6 +409,7 @@ static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
     }
     else
     {
+        const uint8_t *pi_luma = p_sys->luma.p8;
         uint8_t *p_in, *p_in_end, *p_line_end;
         uint8_t *p_out;
         p_in = p_pic->p[Y_PLANE].p_pixels;
@@ -396,76 +449,37 @@ static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
      * Do the U and V planes
      */
 
-    int i_sin = sinf(f_hue) * f_max;
-    int i_cos = cosf(f_hue) * f_max;
-
-    /* pow(2, (bpp * 2) - 1) */
-    int i_x = ( cosf(f_hue) + sinf(f_hue) ) * f_range * i_mid;
-    int i_y = ( cosf(f_hue) - sinf(f_hue) ) * f_range * i_mid;
-
-    if ( i_sat > i_range )
+    if ( p_sys->i_sat > (int)f_range )
     {
         /* Currently no errors are implemented in the function, if any are added
          * check them here */
-        p_sys->pf_process_sat_hue_clip( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                        i_x, i_y );
+        p_sys->pf_process_sat_hue_clip( p_pic, p_outpic, p_sys->i_sin,
+                                        p_sys->i_cos, p_sys->i_sat,
+                                        p_sys->i_x, p_sys->i_y );
     }
     else
     {
         /* Currently no errors are implemented in the function, if any are added
          * check them here */
-        p_sys->pf_process_sat_hue( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                        i_x, i_y );
+        p_sys->pf_process_sat_hue( p_pic, p_outpic, p_sys->i_sin,
+                                   p_sys->i_cos, p_sys->i_sat,
+                                   p_sys->i_x, p_sys->i_y );
     }
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
 
 /*****************************************************************************
- * Run the filter on a Packed YUV picture
+ * Compute the tables of the packed filter from the parameters
  *****************************************************************************/
-static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
+static void UpdatePackedTables( filter_sys_t *p_sys )
 {
-    int pi_luma[256];
     int pi_gamma[256];
 
-    picture_t *p_outpic;
-    uint8_t *p_in, *p_in_end, *p_line_end;
-    uint8_t *p_out;
-    int i_y_offset, i_u_offset, i_v_offset;
-
-    int i_pitch, i_visible_pitch;
-
     double  f_hue;
     double  f_gamma;
     int32_t i_cont, i_lum;
-    int i_sat, i_sin, i_cos, i_x, i_y;
-
-    filter_sys_t *p_sys = p_filter->p_sys;
-
-    if( !p_pic ) return NULL;
-
-    i_pitch = p_pic->p->i_pitch;
-    i_visible_pitch = p_pic->p->i_visible_pitch;
-
-    if( GetPackedYuvOffsets( p_pic->format.i_chroma, &i_y_offset,
-                             &i_u_offset, &i_v_offset ) != VLC_SUCCESS )
-    {
-        msg_Warn( p_filter, "Unsupported input chroma (%4.4s)",
-                  (char*)&(p_pic->format.i_chroma) );
-
-        picture_Release( p_pic );
-        return NULL;
-    }
-
-    p_outpic = filter_NewPicture( p_filter );
-    if( !p_outpic )
-    {
-        msg_Warn( p_filter, "can't get output picture" );
-
-        picture_Release( p_pic );
-        return NULL;
-    }
+    int i_sat;
 
     /* Get variables */
     i_cont = (int)( vlc_atomic_load_float( &p_sys->f_contrast ) * 255 );
@@ -493,7 +507,7 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
         /* Fill the luma lookup table */
         for( int i = 0 ; i < 256 ; i++ )
         {
-            pi_luma[ i ] = pi_gamma[clip_uint8_vlc( i_lum + i_cont * i / 256)];
+            p_sys->luma.p8[ i ] = pi_gamma[clip_uint8_vlc( i_lum + i_cont * i / 256)];
         }
     }
     else
@@ -504,7 +518,7 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
          */
         for( int i = 0 ; i < 256 ; i++ )
         {
-            pi_luma[ i ] = (i < i_lum) ? 0 : 255;
+            p_sys->luma.p8[ i ] = (i < i_lum) ? 0 : 255;
         }
 
         /*
@@ -513,6 +527,56 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
         i_sat = 0;
     }
 
+    p_sys->i_sin = sin(f_hue) * 256;
+    p_sys->i_cos = cos(f_hue) * 256;
+
+    p_sys->i_x = ( cos(f_hue) + sin(f_hue) ) * 32768;
+    p_sys->i_y = ( cos(f_hue) - sin(f_hue) ) * 32768;
+    p_sys->i_sat = i_sat;
+}
+
+/*****************************************************************************
+ * Run the filter on a Packed YUV picture
+ *****************************************************************************/
+static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
+    uint8_t *p_in, *p_in_end, *p_line_end;
+    uint8_t *p_out;
+    int i_y_offset, i_u_offset, i_v_offset;
+
+    int i_pitch, i_visible_pitch;
+
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const uint8_t *pi_luma = p_sys->luma.p8;
+
+    if( !p_pic ) return NULL;
+
+    i_pitch = p_pic->p->i_pitch;
+    i_visible_pitch = p_pic->p->i_visible_pitch;
+
+    if( GetPackedYuvOffsets( p_pic->format.i_chroma, &i_y_offset,
+                             &i_u_offset, &i_v_offset ) != VLC_SUCCESS )
+    {
+        msg_Warn( p_filter, "Unsupported input chroma (%4.4s)",
+                  (char*)&(p_pic->format.i_chroma) );
+
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    p_outpic = filter_NewPicture( p_filter );
+    if( !p_outpic )
+    {
+        msg_Warn( p_filter, "can't get output picture" );
+
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    if( atomic_exchange( &p_sys->b_changed, false ) )
+        UpdatePackedTables( p_sys );
+
     /*
      * Do the Y plane
      */
@@ -554,16 +618,11 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
      * Do the U and V planes
      */
 
-    i_sin = sin(f_hue) * 256;
-    i_cos = cos(f_hue) * 256;
-
-    i_x = ( cos(f_hue) + sin(f_hue) ) * 32768;
-    i_y = ( cos(f_hue) - sin(f_hue) ) * 32768;
-
-    if ( i_sat > 256 )
+    if ( p_sys->i_sat > 256 )
     {
-        if ( p_sys->pf_process_sat_hue_clip( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                             i_x, i_y ) != VLC_SUCCESS )
+        if ( p_sys->pf_process_sat_hue_clip( p_pic, p_outpic, p_sys->i_sin,
+                                             p_sys->i_cos, p_sys->i_sat,
+                                             p_sys->i_x, p_sys->i_y ) != VLC_SUCCESS )
         {
             /* Currently only one error can happen in the function, but if there
              * will be more of them, this message must go away */
@@ -575,8 +634,9 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
     }
     else
     {
-        if ( p_sys->pf_process_sat_hue( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                        i_x, i_y ) != VLC_SUCCESS )
+        if ( p_sys->pf_process_sat_hue( p_pic, p_outpic, p_sys->i_sin,
+                                        p_sys->i_cos, p_sys->i_sat,
+                                        p_sys->i_x, p_sys->i_y ) != VLC_SUCCESS )
         {
             /* Currently only one error can happen in the function, but if there
              * will be more of them, this message must go away */
@@ -610,5 +670,6 @@ static int AdjustCallback( vlc_object_t *p_this, char const *psz_var,
     else if( !strcmp( psz_var, "brightness-threshold" ) )
         atomic_store( &p_sys->b_brightness_threshold, newval.b_bool );
 
+    atomic_store( &p_sys->b_changed, true );
     return VLC_SUCCESS;
 }
@@ -389,3 +389,170 @@ int packed_sat_hue_C( picture_t * p_pic, picture_t * p_outpic, int i_sin,
 
     return VLC_SUCCESS;
 }
+
+#ifdef HAVE_SSE2_INTRINSICS
+#include <emmintrin.h>
+
+struct sat_hue_sse2
+{
+    __m128i cos_sin;  /* (cos, sin) pairs */
+    __m128i msin_cos; /* (-sin, cos) pairs */
+    __m128i x, y;
+    __m128i sat;
+    __m128i shift;
+    __m128i mid;
+};
+
+__attribute__ ((__target__ ("sse2")))
+static void sat_hue_init_SSE2( struct sat_hue_sse2 *c, int i_bpp, int i_sin,
+                               int i_cos, int i_sat, int i_x, int i_y )
+{
+    c->cos_sin = _mm_set1_epi32( (i_sin << 16) | (i_cos & 0xffff) );
+    c->msin_cos = _mm_set1_epi32( (i_cos << 16) | (-i_sin & 0xffff) );
+    c->x = _mm_set1_epi32( i_x );
+    c->y = _mm_set1_epi32( i_y );
+    /* The high half of each lane is multiplied by 0 */
+    c->sat = _mm_set1_epi32( i_sat );
+    c->shift = _mm_cvtsi32_si128( i_bpp );
+    c->mid = _mm_set1_epi16( I_MID( i_bpp ) );
+}
+
+/* Same arithmetic as PLANAR_WRITE_UV_CLIP on 4 interleaved u/v pairs */
+__attribute__ ((__target__ ("sse2")))
+static inline __m128i sat_hue_4_SSE2( const struct sat_hue_sse2 *c,
+                                      __m128i uv, __m128i coefs,
+                                      __m128i offset )
+{
+    __m128i t = _mm_sub_epi32( _mm_madd_epi16( uv, coefs ), offset );
+    /* fits in 16 bits, so the pairwise multiply works on 32-bit lanes */
+    t = _mm_madd_epi16( _mm_sra_epi32( t, c->shift ), c->sat );
+    return _mm_sra_epi32( t, c->shift );
+}
+
+/* Processes 8 u and v samples in 16-bit lanes, before the final clip */
+__attribute__ ((__target__ ("sse2")))
+static inline void sat_hue_8_SSE2( const struct sat_hue_sse2 *c,
+                                   __m128i u, __m128i v,
+                                   __m128i *p_u, __m128i *p_v )
+{
+    const __m128i lo = _mm_unpacklo_epi16( u, v );
+    const __m128i hi = _mm_unpackhi_epi16( u, v );
+
+    *p_u = _mm_adds_epi16( _mm_packs_epi32(
+                               sat_hue_4_SSE2( c, lo, c->cos_sin, c->x ),
+                               sat_hue_4_SSE2( c, hi, c->cos_sin, c->x ) ),
+                           c->mid );
+    *p_v = _mm_adds_epi16( _mm_packs_epi32(
+                               sat_hue_4_SSE2( c, lo, c->msin_cos, c->y ),
+                               sat_hue_4_SSE2( c, hi, c->msin_cos, c->y ) ),
+                           c->mid );
+}
+
+__attribute__ ((__target__ ("sse2")))
+int planar_sat_hue_SSE2( picture_t * p_pic, picture_t * p_outpic, int i_sin,
+                         int i_cos, int i_sat, int i_x, int i_y )
+{
+    struct sat_hue_sse2 c;
+    sat_hue_init_SSE2( &c, 8, i_sin, i_cos, i_sat, i_x, i_y );
+    const __m128i zero = _mm_setzero_si128();
+
+    const int i_visible_pitch = p_pic->p[U_PLANE].i_visible_pitch;
+    uint8_t i_u, i_v;
+
+    for( int i_line = 0; i_line < p_pic->p[U_PLANE].i_visible_lines; i_line++ )
+    {
+        const uint8_t *p_in = p_pic->p[U_PLANE].p_pixels
+                            + i_line * p_pic->p[U_PLANE].i_pitch;
+        const uint8_t *p_in_v = p_pic->p[V_PLANE].p_pixels
+                              + i_line * p_pic->p[V_PLANE].i_pitch;
+        uint8_t *p_out = p_outpic->p[U_PLANE].p_pixels
+                       + i_line * p_outpic->p[U_PLANE].i_pitch;
+        uint8_t *p_out_v = p_outpic->p[V_PLANE].p_pixels
+                         + i_line * p_outpic->p[V_PLANE].i_pitch;
+        int i = 0;
+
+        for( ; i + 16 <= i_visible_pitch; i += 16 )
+        {
+            const __m128i u = _mm_loadu_si128( (const __m128i *)&p_in[i] );
+            const __m128i v = _mm_loadu_si128( (const __m128i *)&p_in_v[i] );
+            __m128i u_lo, v_lo, u_hi, v_hi;
+
+            sat_hue_8_SSE2( &c, _mm_unpacklo_epi8( u, zero ),
+                            _mm_unpacklo_epi8( v, zero ), &u_lo, &v_lo );
+            sat_hue_8_SSE2( &c, _mm_unpackhi_epi8( u, zero ),
+                            _mm_unpackhi_epi8( v, zero ), &u_hi, &v_hi );
+            _mm_storeu_si128( (__m128i *)&p_out[i],
+                              _mm_packus_epi16( u_lo, u_hi ) );
+            _mm_storeu_si128( (__m128i *)&p_out_v[i],
+                              _mm_packus_epi16( v_lo, v_hi ) );
+        }
+
+        p_in += i; p_in_v += i; p_out += i; p_out_v += i;
+        for( ; i < i_visible_pitch; i++ )
+        {
+            PLANAR_WRITE_UV_CLIP( 8 );
+        }
+    }
+
+    return VLC_SUCCESS;
+}
+
+__attribute__ ((__target__ ("sse2")))
+int planar_sat_hue_SSE2_16( picture_t * p_pic, picture_t * p_outpic, int i_sin,
+                            int i_cos, int i_sat, int i_x, int i_y )
+{
+    int i_bpp;
+    switch( p_pic->format.i_chroma )
+    {
+        CASE_PLANAR_YUV10
+            i_bpp = 10;
+            break;
+        CASE_PLANAR_YUV9
+            i_bpp = 9;
+            break;
+        default:
+            vlc_assert_unreachable();
+    }
+
+    struct sat_hue_sse2 c;
+    sat_hue_init_SSE2( &c, i_bpp, i_sin, i_cos, i_sat, i_x, i_y );
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16( I_MAX( i_bpp ) );
+
+    const int i_visible_width = p_pic->p[U_PLANE].i_visible_pitch >> 1;
+    uint16_t i_u, i_v;
+
+    for( int i_line = 0; i_line < p_pic->p[U_PLANE].i_visible_lines; i_line++ )
+    {
+        const uint16_t *p_in = (const uint16_t *)( p_pic->p[U_PLANE].p_pixels
+                             + i_line * p_pic->p[U_PLANE].i_pitch );
+        const uint16_t *p_in_v = (const uint16_t *)( p_pic->p[V_PLANE].p_pixels
+                               + i_line * p_pic->p[V_PLANE].i_pitch );
+        uint16_t *p_out = (uint16_t *)( p_outpic->p[U_PLANE].p_pixels
+                        + i_line * p_outpic->p[U_PLANE].i_pitch );
+        uint16_t *p_out_v = (uint16_t *)( p_outpic->p[V_PLANE].p_pixels
+                          + i_line * p_outpic->p[V_PLANE].i_pitch );
+        int i = 0;
+
+        for( ; i + 8 <= i_visible_width; i += 8 )
+        {
+            __m128i u = _mm_loadu_si128( (const __m128i *)&p_in[i] );
+            __m128i v = _mm_loadu_si128( (const __m128i *)&p_in_v[i] );
+
+            sat_hue_8_SSE2( &c, u, v, &u, &v );
+            _mm_storeu_si128( (__m128i *)&p_out[i],
+                              _mm_min_epi16( _mm_max_epi16( u, zero ), max ) );
+            _mm_storeu_si128( (__m128i *)&p_out_v[i],
+                              _mm_min_epi16( _mm_max_epi16( v, zero ), max ) );
+        }
+
+        p_in += i; p_in_v += i; p_out += i; p_out_v += i;
+        for( ; i < i_visible_width; i++ )
+        {
+            PLANAR_WRITE_UV_CLIP( i_bpp );
+        }
+    }
+
+    return VLC_SUCCESS;
+}
+#endif
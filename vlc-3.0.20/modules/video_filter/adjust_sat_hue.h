@@ -73,3 +73,17 @@ int packed_sat_hue_clip_C( picture_t * p_pic, picture_t * p_outpic,
  */
 int packed_sat_hue_C( picture_t * p_pic, picture_t * p_outpic,
                       int i_sin, int i_cos, int i_sat, int i_x, int i_y );
+
+#ifdef HAVE_SSE2_INTRINSICS
+/**
+ * SSE2 function for planar format, always clipping
+ */
+int planar_sat_hue_SSE2( picture_t * p_pic, picture_t * p_outpic,
+                         int i_sin, int i_cos, int i_sat, int i_x, int i_y );
+
+/**
+ * SSE2 function for {9,10}-bit planar format, always clipping
+ */
+int planar_sat_hue_SSE2_16( picture_t * p_pic, picture_t * p_outpic,
+                            int i_sin, int i_cos, int i_sat, int i_x, int i_y );
+#endif
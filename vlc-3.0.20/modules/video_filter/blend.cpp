@@ -32,8 +32,22 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_cpu.h>
 #include "filter_picture.h"
 
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+# include <emmintrin.h>
+# define BLEND_SSE2
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+# define BLEND_AVX2
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+# define BLEND_NEON
+#endif
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -548,6 +562,375 @@ void Blend(const CPicture &dst_data, const CPicture &src_data,
     }
 }
 
+/* Row kernels for 8 bits destinations, computing for each sample
+ *   a   = div255(alpha * src_a)
+ *   dst = div255((255 - a) * dst + src * a)
+ * exactly like the generic Blend() above. */
+struct blend_rows {
+    void (*merge)(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                  unsigned count, unsigned alpha);
+    /* src and a are read every other sample, for subsampled chroma */
+    void (*merge2)(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                   unsigned count, unsigned alpha);
+    /* same as merge2, into interleaved chroma */
+    void (*mergeUV)(uint8_t *dst, const uint8_t *u, const uint8_t *v,
+                    const uint8_t *a, unsigned count, unsigned alpha);
+};
+
+static inline uint8_t mergeSample(unsigned dst, unsigned src, unsigned sa,
+                                  unsigned alpha)
+{
+    unsigned a = div255(alpha * sa);
+    return div255((255 - a) * dst + src * a);
+}
+
+#ifdef BLEND_SSE2
+__attribute__ ((__target__ ("sse2")))
+static inline __m128i SSE2_Div255(__m128i v)
+{
+    v = _mm_add_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), _mm_set1_epi16(1));
+    return _mm_srli_epi16(v, 8);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static inline __m128i SSE2_Merge(__m128i d, __m128i s, __m128i sa, __m128i alpha)
+{
+    __m128i a = SSE2_Div255(_mm_mullo_epi16(sa, alpha));
+    __m128i v = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(_mm_set1_epi16(255), a), d),
+                              _mm_mullo_epi16(s, a));
+    return SSE2_Div255(v);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void SSE2_Merge(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                       unsigned count, unsigned alpha)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i va = _mm_set1_epi16(alpha);
+    unsigned x = 0;
+    for (; x + 16 <= count; x += 16) {
+        __m128i d  = _mm_loadu_si128((const __m128i *)&dst[x]);
+        __m128i s  = _mm_loadu_si128((const __m128i *)&src[x]);
+        __m128i sa = _mm_loadu_si128((const __m128i *)&a[x]);
+        __m128i lo = SSE2_Merge(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero),
+                                _mm_unpacklo_epi8(sa, zero), va);
+        __m128i hi = SSE2_Merge(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero),
+                                _mm_unpackhi_epi8(sa, zero), va);
+        _mm_storeu_si128((__m128i *)&dst[x], _mm_packus_epi16(lo, hi));
+    }
+    for (; x < count; x++)
+        dst[x] = mergeSample(dst[x], src[x], a[x], alpha);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void SSE2_Merge2(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                        unsigned count, unsigned alpha)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i even = _mm_set1_epi16(0xff);
+    const __m128i va = _mm_set1_epi16(alpha);
+    unsigned x = 0;
+    /* the last odd sample may be past the end of the line */
+    for (; x + 16 < count; x += 16) {
+        __m128i d  = _mm_loadu_si128((const __m128i *)&dst[x]);
+        __m128i s0 = _mm_and_si128(_mm_loadu_si128((const __m128i *)&src[2 * x]), even);
+        __m128i s1 = _mm_and_si128(_mm_loadu_si128((const __m128i *)&src[2 * x + 16]), even);
+        __m128i a0 = _mm_and_si128(_mm_loadu_si128((const __m128i *)&a[2 * x]), even);
+        __m128i a1 = _mm_and_si128(_mm_loadu_si128((const __m128i *)&a[2 * x + 16]), even);
+        __m128i lo = SSE2_Merge(_mm_unpacklo_epi8(d, zero), s0, a0, va);
+        __m128i hi = SSE2_Merge(_mm_unpackhi_epi8(d, zero), s1, a1, va);
+        _mm_storeu_si128((__m128i *)&dst[x], _mm_packus_epi16(lo, hi));
+    }
+    for (; x < count; x++)
+        dst[x] = mergeSample(dst[x], src[2 * x], a[2 * x], alpha);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void SSE2_MergeUV(uint8_t *dst, const uint8_t *u, const uint8_t *v,
+                         const uint8_t *a, unsigned count, unsigned alpha)
+{
+    const __m128i even = _mm_set1_epi16(0xff);
+    const __m128i va = _mm_set1_epi16(alpha);
+    unsigned x = 0;
+    for (; x + 8 < count; x += 8) {
+        __m128i d  = _mm_loadu_si128((const __m128i *)&dst[2 * x]);
+        __m128i su = _mm_and_si128(_mm_loadu_si128((const __m128i *)&u[2 * x]), even);
+        __m128i sv = _mm_and_si128(_mm_loadu_si128((const __m128i *)&v[2 * x]), even);
+        __m128i sa = _mm_and_si128(_mm_loadu_si128((const __m128i *)&a[2 * x]), even);
+        __m128i ru = SSE2_Merge(_mm_and_si128(d, even), su, sa, va);
+        __m128i rv = SSE2_Merge(_mm_srli_epi16(d, 8), sv, sa, va);
+        _mm_storeu_si128((__m128i *)&dst[2 * x], _mm_or_si128(ru, _mm_slli_epi16(rv, 8)));
+    }
+    for (; x < count; x++) {
+        dst[2 * x + 0] = mergeSample(dst[2 * x + 0], u[2 * x], a[2 * x], alpha);
+        dst[2 * x + 1] = mergeSample(dst[2 * x + 1], v[2 * x], a[2 * x], alpha);
+    }
+}
+
+static const blend_rows sse2_rows = { SSE2_Merge, SSE2_Merge2, SSE2_MergeUV };
+#endif
+
+#ifdef BLEND_AVX2
+__attribute__ ((__target__ ("avx2")))
+static inline __m256i AVX2_Div255(__m256i v)
+{
+    v = _mm256_add_epi16(_mm256_add_epi16(v, _mm256_srli_epi16(v, 8)),
+                         _mm256_set1_epi16(1));
+    return _mm256_srli_epi16(v, 8);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static inline __m256i AVX2_Merge(__m256i d, __m256i s, __m256i sa, __m256i alpha)
+{
+    __m256i a = AVX2_Div255(_mm256_mullo_epi16(sa, alpha));
+    __m256i v = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(_mm256_set1_epi16(255), a), d),
+                                 _mm256_mullo_epi16(s, a));
+    return AVX2_Div255(v);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static inline __m256i AVX2_Load16(const uint8_t *p)
+{
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)p));
+}
+
+__attribute__ ((__target__ ("avx2")))
+static inline void AVX2_Store32(uint8_t *p, __m256i lo, __m256i hi)
+{
+    /* packus works per 128 bits lane */
+    __m256i v = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xd8);
+    _mm256_storeu_si256((__m256i *)p, v);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void AVX2_Merge(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                       unsigned count, unsigned alpha)
+{
+    const __m256i va = _mm256_set1_epi16(alpha);
+    unsigned x = 0;
+    for (; x + 32 <= count; x += 32) {
+        __m256i lo = AVX2_Merge(AVX2_Load16(&dst[x]), AVX2_Load16(&src[x]),
+                                AVX2_Load16(&a[x]), va);
+        __m256i hi = AVX2_Merge(AVX2_Load16(&dst[x + 16]), AVX2_Load16(&src[x + 16]),
+                                AVX2_Load16(&a[x + 16]), va);
+        AVX2_Store32(&dst[x], lo, hi);
+    }
+    for (; x < count; x++)
+        dst[x] = mergeSample(dst[x], src[x], a[x], alpha);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void AVX2_Merge2(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                        unsigned count, unsigned alpha)
+{
+    const __m256i even = _mm256_set1_epi16(0xff);
+    const __m256i va = _mm256_set1_epi16(alpha);
+    unsigned x = 0;
+    /* the last odd sample may be past the end of the line */
+    for (; x + 32 < count; x += 32) {
+        __m256i s0 = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&src[2 * x]), even);
+        __m256i s1 = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&src[2 * x + 32]), even);
+        __m256i a0 = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&a[2 * x]), even);
+        __m256i a1 = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&a[2 * x + 32]), even);
+        __m256i lo = AVX2_Merge(AVX2_Load16(&dst[x]), s0, a0, va);
+        __m256i hi = AVX2_Merge(AVX2_Load16(&dst[x + 16]), s1, a1, va);
+        AVX2_Store32(&dst[x], lo, hi);
+    }
+    for (; x < count; x++)
+        dst[x] = mergeSample(dst[x], src[2 * x], a[2 * x], alpha);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void AVX2_MergeUV(uint8_t *dst, const uint8_t *u, const uint8_t *v,
+                         const uint8_t *a, unsigned count, unsigned alpha)
+{
+    const __m256i even = _mm256_set1_epi16(0xff);
+    const __m256i va = _mm256_set1_epi16(alpha);
+    unsigned x = 0;
+    for (; x + 16 < count; x += 16) {
+        __m256i d  = _mm256_loadu_si256((const __m256i *)&dst[2 * x]);
+        __m256i su = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&u[2 * x]), even);
+        __m256i sv = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&v[2 * x]), even);
+        __m256i sa = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&a[2 * x]), even);
+        __m256i ru = AVX2_Merge(_mm256_and_si256(d, even), su, sa, va);
+        __m256i rv = AVX2_Merge(_mm256_srli_epi16(d, 8), sv, sa, va);
+        _mm256_storeu_si256((__m256i *)&dst[2 * x],
+                            _mm256_or_si256(ru, _mm256_slli_epi16(rv, 8)));
+    }
+    for (; x < count; x++) {
+        dst[2 * x + 0] = mergeSample(dst[2 * x + 0], u[2 * x], a[2 * x], alpha);
+        dst[2 * x + 1] = mergeSample(dst[2 * x + 1], v[2 * x], a[2 * x], alpha);
+    }
+}
+
+static const blend_rows avx2_rows = { AVX2_Merge, AVX2_Merge2, AVX2_MergeUV };
+#endif
+
+#ifdef BLEND_NEON
+static inline uint8x8_t NEON_Div255(uint16x8_t v)
+{
+    return vshrn_n_u16(vaddq_u16(vsraq_n_u16(v, v, 8), vdupq_n_u16(1)), 8);
+}
+
+static inline uint8x8_t NEON_Merge(uint8x8_t d, uint8x8_t s, uint8x8_t sa,
+                                   uint8x8_t alpha)
+{
+    uint8x8_t a = NEON_Div255(vmull_u8(sa, alpha));
+    uint16x8_t v = vmull_u8(vsub_u8(vdup_n_u8(255), a), d);
+    return NEON_Div255(vmlal_u8(v, s, a));
+}
+
+static inline uint8x16_t NEON_Merge(uint8x16_t d, uint8x16_t s, uint8x16_t sa,
+                                    uint8x8_t alpha)
+{
+    return vcombine_u8(NEON_Merge(vget_low_u8(d), vget_low_u8(s), vget_low_u8(sa), alpha),
+                       NEON_Merge(vget_high_u8(d), vget_high_u8(s), vget_high_u8(sa), alpha));
+}
+
+static void NEON_Merge(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                       unsigned count, unsigned alpha)
+{
+    const uint8x8_t va = vdup_n_u8(alpha);
+    unsigned x = 0;
+    for (; x + 16 <= count; x += 16)
+        vst1q_u8(&dst[x], NEON_Merge(vld1q_u8(&dst[x]), vld1q_u8(&src[x]),
+                                     vld1q_u8(&a[x]), va));
+    for (; x < count; x++)
+        dst[x] = mergeSample(dst[x], src[x], a[x], alpha);
+}
+
+static void NEON_Merge2(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                        unsigned count, unsigned alpha)
+{
+    const uint8x8_t va = vdup_n_u8(alpha);
+    unsigned x = 0;
+    /* the last odd sample may be past the end of the line */
+    for (; x + 16 < count; x += 16)
+        vst1q_u8(&dst[x], NEON_Merge(vld1q_u8(&dst[x]), vld2q_u8(&src[2 * x]).val[0],
+                                     vld2q_u8(&a[2 * x]).val[0], va));
+    for (; x < count; x++)
+        dst[x] = mergeSample(dst[x], src[2 * x], a[2 * x], alpha);
+}
+
+static void NEON_MergeUV(uint8_t *dst, const uint8_t *u, const uint8_t *v,
+                         const uint8_t *a, unsigned count, unsigned alpha)
+{
+    const uint8x8_t va = vdup_n_u8(alpha);
+    unsigned x = 0;
+    for (; x + 16 < count; x += 16) {
+        uint8x16x2_t d = vld2q_u8(&dst[2 * x]);
+        uint8x16_t sa = vld2q_u8(&a[2 * x]).val[0];
+        d.val[0] = NEON_Merge(d.val[0], vld2q_u8(&u[2 * x]).val[0], sa, va);
+        d.val[1] = NEON_Merge(d.val[1], vld2q_u8(&v[2 * x]).val[0], sa, va);
+        vst2q_u8(&dst[2 * x], d);
+    }
+    for (; x < count; x++) {
+        dst[2 * x + 0] = mergeSample(dst[2 * x + 0], u[2 * x], a[2 * x], alpha);
+        dst[2 * x + 1] = mergeSample(dst[2 * x + 1], v[2 * x], a[2 * x], alpha);
+    }
+}
+
+static const blend_rows neon_rows = { NEON_Merge, NEON_Merge2, NEON_MergeUV };
+#endif
+
+static const blend_rows *GetBlendRows()
+{
+#ifdef BLEND_AVX2
+    if (vlc_CPU_AVX2())
+        return &avx2_rows;
+#endif
+#ifdef BLEND_SSE2
+    if (vlc_CPU_SSE2())
+        return &sse2_rows;
+#endif
+#ifdef BLEND_NEON
+    if (vlc_CPU_ARM64_NEON())
+        return &neon_rows;
+#endif
+    return NULL;
+}
+
+class CPictureLines : public CPicture {
+public:
+    CPictureLines(const CPicture &cfg) : CPicture(cfg)
+    {
+    }
+    uint8_t *getPixels(unsigned plane, unsigned dy, unsigned ry, unsigned offset) const
+    {
+        const plane_t *p = &picture->p[plane];
+        return &p->p_pixels[(y + dy) / ry * p->i_pitch + offset];
+    }
+    unsigned getX() const
+    {
+        return x;
+    }
+    unsigned getY() const
+    {
+        return y;
+    }
+};
+
+/* Blends YUVA or RGBA pictures onto 8 bits planar or semi-planar YUV,
+ * a chunk of line at a time using the row kernels of the CPU */
+template <unsigned rx, unsigned ry, bool swap_uv, bool semiplanar, bool rgba>
+void BlendRows(const CPicture &dst_data, const CPicture &src_data,
+               unsigned width, unsigned height, int alpha)
+{
+    enum { CHUNK = 256 };
+    const blend_rows *rows = GetBlendRows();
+    const CPictureLines dst(dst_data);
+    const CPictureLines src(src_data);
+    const unsigned x0 = dst.getX();
+    uint8_t yuva[4][CHUNK];
+
+    for (unsigned y = 0; y < height; y++) {
+        const bool full = (dst.getY() + y) % ry == 0;
+
+        for (unsigned x = 0; x < width; x += CHUNK) {
+            const unsigned count = __MIN(width - x, (unsigned)CHUNK);
+            const uint8_t *s[4];
+
+            if (rgba) {
+                const uint8_t *rgb = src.getPixels(0, y, 1, (src.getX() + x) * 4);
+                for (unsigned i = 0; i < count; i++) {
+                    rgb_to_yuv(&yuva[0][i], &yuva[1][i], &yuva[2][i],
+                               rgb[4 * i + 0], rgb[4 * i + 1], rgb[4 * i + 2]);
+                    yuva[3][i] = rgb[4 * i + 3];
+                }
+                for (unsigned i = 0; i < 4; i++)
+                    s[i] = yuva[i];
+            } else {
+                for (unsigned i = 0; i < 4; i++)
+                    s[i] = src.getPixels(i, y, 1, src.getX() + x);
+            }
+
+            rows->merge(dst.getPixels(0, y, 1, x0 + x), s[0], s[3], count, alpha);
+            if (!full)
+                continue;
+
+            /* chroma is merged from the samples on the chroma grid */
+            const unsigned skip = (x0 + x) % rx;
+            if (count <= skip)
+                continue;
+            const unsigned cx = (x0 + x + skip) / rx;
+            const unsigned n = (count - skip + rx - 1) / rx;
+
+            if (semiplanar)
+                rows->mergeUV(dst.getPixels(1, y, ry, 2 * cx),
+                              s[swap_uv ? 2 : 1] + skip, s[swap_uv ? 1 : 2] + skip,
+                              s[3] + skip, n, alpha);
+            else {
+                void (*merge)(uint8_t *, const uint8_t *, const uint8_t *,
+                              unsigned, unsigned) = rx == 1 ? rows->merge : rows->merge2;
+                merge(dst.getPixels(swap_uv ? 2 : 1, y, ry, cx), s[1] + skip,
+                      s[3] + skip, n, alpha);
+                merge(dst.getPixels(swap_uv ? 1 : 2, y, ry, cx), s[2] + skip,
+                      s[3] + skip, n, alpha);
+            }
+        }
+    }
+}
+
 typedef void (*blend_function_t)(const CPicture &dst_data, const CPicture &src_data,
                                  unsigned width, unsigned height, int alpha);
 
@@ -623,6 +1006,31 @@ static const struct {
 #undef YUV
 };
 
+/* Used instead of the above when the CPU has row kernels */
+static const struct {
+    vlc_fourcc_t     dst;
+    vlc_fourcc_t     src;
+    blend_function_t blend;
+} row_blends[] = {
+#define YUV(csp, rx, ry, swap_uv, semiplanar) \
+    { csp, VLC_CODEC_YUVA, BlendRows<rx, ry, swap_uv, semiplanar, false> }, \
+    { csp, VLC_CODEC_RGBA, BlendRows<rx, ry, swap_uv, semiplanar, true> }
+
+    YUV(VLC_CODEC_YV12,     2,2, true,  false),
+    YUV(VLC_CODEC_NV12,     2,2, false, true),
+    YUV(VLC_CODEC_NV21,     2,2, true,  true),
+    YUV(VLC_CODEC_J420,     2,2, false, false),
+    YUV(VLC_CODEC_I420,     2,2, false, false),
+
+    YUV(VLC_CODEC_J422,     2,1, false, false),
+    YUV(VLC_CODEC_I422,     2,1, false, false),
+
+    YUV(VLC_CODEC_J444,     1,1, false, false),
+    YUV(VLC_CODEC_I444,     1,1, false, false),
+
+#undef YUV
+};
+
 struct filter_sys_t {
     filter_sys_t() : blend(NULL)
     {
@@ -675,6 +1083,12 @@ static int Open(vlc_object_t *object)
         if (blends[i].src == src && blends[i].dst == dst)
             sys->blend = blends[i].blend;
     }
+    if (GetBlendRows() != NULL) {
+        for (size_t i = 0; i < sizeof(row_blends) / sizeof(*row_blends); i++) {
+            if (row_blends[i].src == src && row_blends[i].dst == dst)
+                sys->blend = row_blends[i].blend;
+        }
+    }
 
     if (!sys->blend) {
        msg_Err(filter, "no matching alpha blending routine (chroma: %4.4s -> %4.4s)",
@@ -56,6 +56,13 @@ static picture_t *Filter( filter_t *, picture_t * );
 #define ALPHA_TEXT N_("Alpha of the blended image")
 #define ALPHA_LONGTEXT N_("Alpha with which the blend image is blended")
 
+#define WIDTH_TEXT N_("Width of the generated images")
+#define WIDTH_LONGTEXT N_("Width of the images generated when no image " \
+                          "file is given")
+#define HEIGHT_TEXT N_("Height of the generated images")
+#define HEIGHT_LONGTEXT N_("Height of the images generated when no image " \
+                           "file is given")
+
 #define BASE_IMAGE_TEXT N_("Image to be blended onto")
 #define BASE_IMAGE_LONGTEXT N_("The image which will be used to blend onto")
 
@@ -83,6 +90,9 @@ vlc_module_begin ()
               LOOPS_LONGTEXT, false )
     add_integer_with_range( CFG_PREFIX "alpha", 128, 0, 255, ALPHA_TEXT,
               ALPHA_LONGTEXT, false )
+    add_integer( CFG_PREFIX "width", 1920, WIDTH_TEXT, WIDTH_LONGTEXT, false )
+    add_integer( CFG_PREFIX "height", 1080, HEIGHT_TEXT, HEIGHT_LONGTEXT,
+                 false )
 
     set_section( N_("Base image"), NULL )
     add_loadfile( CFG_PREFIX "base-image", NULL, BASE_IMAGE_TEXT,
@@ -100,8 +110,8 @@ vlc_module_begin ()
 vlc_module_end ()
 
 static const char *const ppsz_filter_options[] = {
-    "loops", "alpha", "base-image", "base-chroma", "blend-image",
-    "blend-chroma", NULL
+    "loops", "alpha", "width", "height", "base-image", "base-chroma",
+    "blend-image", "blend-chroma", NULL
 };
 
 /*****************************************************************************
@@ -111,6 +121,7 @@ struct filter_sys_t
 {
     bool b_done;
     int i_loops, i_alpha;
+    unsigned i_width, i_height;
 
     picture_t *p_base_image;
     picture_t *p_blend_image;
@@ -119,12 +130,68 @@ struct filter_sys_t
     vlc_fourcc_t i_blend_chroma;
 };
 
+/* Fills a picture with a gradient, and for the blend image an alpha
+ * ranging from transparent to opaque, like antialiased text boxes */
+static picture_t *blendbench_CreateImage( vlc_fourcc_t i_chroma,
+                                          unsigned i_width, unsigned i_height )
+{
+    video_format_t fmt;
+    video_format_Init( &fmt, i_chroma );
+    video_format_Setup( &fmt, i_chroma, i_width, i_height,
+                        i_width, i_height, 1, 1 );
+    picture_t *p_pic = picture_NewFromFormat( &fmt );
+    video_format_Clean( &fmt );
+    if( p_pic == NULL )
+        return NULL;
+
+    for( int i = 0; i < p_pic->i_planes; i++ )
+    {
+        plane_t *p = &p_pic->p[i];
+        for( int y = 0; y < p->i_lines; y++ )
+            for( int x = 0; x < p->i_pitch; x++ )
+                p->p_pixels[y * p->i_pitch + x] = ( x + y * 3 + i * 64 ) & 0xff;
+    }
+
+    if( i_chroma == VLC_CODEC_YUVA )
+    {
+        plane_t *p = &p_pic->p[A_PLANE];
+        for( int y = 0; y < p->i_lines; y++ )
+            for( int x = 0; x < p->i_pitch; x++ )
+                p->p_pixels[y * p->i_pitch + x] = ( x / 4 + y ) % 3 ?
+                    ( x * 7 + y ) & 0xff : 0;
+    }
+    else if( i_chroma == VLC_CODEC_RGBA || i_chroma == VLC_CODEC_BGRA )
+    {
+        plane_t *p = &p_pic->p[0];
+        for( int y = 0; y < p->i_lines; y++ )
+            for( int x = 0; x < p->i_visible_pitch / 4; x++ )
+                p->p_pixels[y * p->i_pitch + 4 * x + 3] = ( x / 4 + y ) % 3 ?
+                    ( x * 7 + y ) & 0xff : 0;
+    }
+    return p_pic;
+}
+
 static int blendbench_LoadImage( vlc_object_t *p_this, picture_t **pp_pic,
                                  vlc_fourcc_t i_chroma, char *psz_file, const char *psz_name )
 {
     image_handler_t *p_image;
     video_format_t fmt_in, fmt_out;
 
+    if( EMPTY_STR( psz_file ) )
+    {
+        filter_sys_t *p_sys = ((filter_t *)p_this)->p_sys;
+        *pp_pic = blendbench_CreateImage( i_chroma, p_sys->i_width,
+                                          p_sys->i_height );
+        if( *pp_pic == NULL )
+        {
+            msg_Err( p_this, "Unable to create %s image", psz_name );
+            return VLC_EGENERIC;
+        }
+        msg_Dbg( p_this, "%s image generated with dim %u x %u", psz_name,
+                 p_sys->i_width, p_sys->i_height );
+        return VLC_SUCCESS;
+    }
+
     memset( &fmt_in, 0, sizeof(video_format_t) );
     memset( &fmt_out, 0, sizeof(video_format_t) );
 
@@ -175,6 +242,8 @@ static int Create( vlc_object_t *p_this )
                                                   CFG_PREFIX "loops" );
     p_sys->i_alpha = var_CreateGetIntegerCommand( p_filter,
                                                   CFG_PREFIX "alpha" );
+    p_sys->i_width = var_CreateGetInteger( p_filter, CFG_PREFIX "width" );
+    p_sys->i_height = var_CreateGetInteger( p_filter, CFG_PREFIX "height" );
 
     psz_temp = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-chroma" );
     p_sys->i_base_chroma = !psz_temp || strlen( psz_temp ) != 4 ? 0 :
@@ -222,6 +291,7 @@ static void Destroy( vlc_object_t *p_this )
 
     picture_Release( p_sys->p_base_image );
     picture_Release( p_sys->p_blend_image );
+    free( p_sys );
 }
 
 /*****************************************************************************
@@ -260,13 +330,19 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
     }
     time = mdate() - time;
 
-    msg_Info( p_filter, "Blended %d images in %f sec", p_sys->i_loops,
-              time / 1000000.0f );
-    msg_Info( p_filter, "Speed is: %f images/second, %f pixels/second",
-              (float) p_sys->i_loops / time * 1000000,
-              (float) p_sys->i_loops / time * 1000000 *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_pitch *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_lines );
+    const video_format_t *p_fmt = &p_sys->p_blend_image->format;
+    const double f_pixels = (double) p_sys->i_loops * p_fmt->i_visible_width
+                                                    * p_fmt->i_visible_height;
+    if( time <= 0 )
+        time = 1;
+
+    msg_Info( p_filter, "Blended %d images %4.4s -> %4.4s in %f sec",
+              p_sys->i_loops, (const char *) &p_sys->i_blend_chroma,
+              (const char *) &p_sys->i_base_chroma, time / 1000000.0 );
+    msg_Info( p_filter, "Speed is: %f images/second, %f pixels/second, "
+              "%f ms/image", (double) p_sys->i_loops / time * 1000000,
+              f_pixels / time * 1000000,
+              (double) time / 1000 / __MAX(p_sys->i_loops, 1) );
 
     module_unneed( p_blend, p_blend->p_module );
 
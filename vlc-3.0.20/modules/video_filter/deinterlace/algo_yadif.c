@@ -47,6 +47,71 @@
    Necessary preprocessor macros are defined in common.h. */
 #include "yadif.h"
 
+struct yadif_slice
+{
+    void (*filter)(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next,
+                   int w, int prefs, int mrefs, int parity, int mode);
+    const plane_t *prevp;
+    const plane_t *curp;
+    const plane_t *nextp;
+    plane_t *dstp;
+    int i_field;
+    int yadif_parity;
+};
+
+/* Renders the lines [i_first, i_first + i_count) of a plane */
+static void RenderYadifSlice( filter_t *p_filter, void *p_data,
+                              unsigned i_first, unsigned i_count )
+{
+    VLC_UNUSED(p_filter);
+
+    const struct yadif_slice *p_slice = p_data;
+    const plane_t *prevp = p_slice->prevp;
+    const plane_t *curp  = p_slice->curp;
+    const plane_t *nextp = p_slice->nextp;
+    plane_t *dstp        = p_slice->dstp;
+    const int i_field      = p_slice->i_field;
+    const int yadif_parity = p_slice->yadif_parity;
+
+    const int y_end = __MIN( (int)(i_first + i_count), dstp->i_visible_lines - 1 );
+    for( int y = __MAX( (int)i_first, 1 ); y < y_end; y++ )
+    {
+        if( (y % 2) == i_field  ||  yadif_parity == 2 )
+        {
+            memcpy( &dstp->p_pixels[y * dstp->i_pitch],
+                        &curp->p_pixels[y * curp->i_pitch], dstp->i_visible_pitch );
+        }
+        else
+        {
+            int mode;
+            /* Spatial checks only when enough data */
+            mode = (y >= 2 && y < dstp->i_visible_lines - 2) ? 0 : 2;
+
+            assert( prevp->i_pitch == curp->i_pitch && curp->i_pitch == nextp->i_pitch );
+            p_slice->filter( &dstp->p_pixels[y * dstp->i_pitch],
+                    &prevp->p_pixels[y * prevp->i_pitch],
+                    &curp->p_pixels[y * curp->i_pitch],
+                    &nextp->p_pixels[y * nextp->i_pitch],
+                    dstp->i_visible_pitch,
+                    y < dstp->i_visible_lines - 2  ? curp->i_pitch : -curp->i_pitch,
+                    y  - 1  ?  -curp->i_pitch : curp->i_pitch,
+                    yadif_parity,
+                    mode );
+        }
+
+        /* We duplicate the first and last lines. Both are written by the
+           band of their neighbour, as the bands start on even lines. */
+        if( y == 1 )
+            memcpy(&dstp->p_pixels[(y-1) * dstp->i_pitch],
+                       &dstp->p_pixels[ y    * dstp->i_pitch],
+                       dstp->i_pitch);
+        else if( y == dstp->i_visible_lines - 2 )
+            memcpy(&dstp->p_pixels[(y+1) * dstp->i_pitch],
+                       &dstp->p_pixels[ y    * dstp->i_pitch],
+                       dstp->i_pitch);
+    }
+}
+
 int RenderYadifSingle( filter_t *p_filter, picture_t *p_dst, picture_t *p_src )
 {
     return RenderYadif( p_filter, p_dst, p_src, 0, 0 );
@@ -109,75 +174,54 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
     /* Filter if we have all the pictures we need */
     if( p_prev && p_cur && p_next )
     {
-        /* */
-        void (*filter)(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next,
-                       int w, int prefs, int mrefs, int parity, int mode);
+        struct yadif_slice slice = {
+            .i_field = i_field,
+            .yadif_parity = yadif_parity,
+        };
 
 /* android clang build for x86 fails as not enough registers are available */
 #if !defined(__ANDROID__)
+# if defined(HAVE_YADIF_AVX2)
+        if( vlc_CPU_AVX2() )
+            slice.filter = yadif_filter_line_avx2;
+        else
+# endif
 # if defined(HAVE_YADIF_SSSE3)
         if( vlc_CPU_SSSE3() )
-            filter = yadif_filter_line_ssse3;
+            slice.filter = yadif_filter_line_ssse3;
         else
 # endif
 # if defined(HAVE_YADIF_SSE2)
         if( vlc_CPU_SSE2() )
-            filter = yadif_filter_line_sse2;
+            slice.filter = yadif_filter_line_sse2;
         else
 # endif
 # if defined(HAVE_YADIF_MMX)
         if( vlc_CPU_MMX() )
-            filter = yadif_filter_line_mmx;
+            slice.filter = yadif_filter_line_mmx;
         else
 # endif
 #endif
-            filter = yadif_filter_line_c;
+#if defined(HAVE_YADIF_NEON)
+        if( vlc_CPU_ARM64_NEON() )
+            slice.filter = yadif_filter_line_neon;
+        else
+#endif
+            slice.filter = yadif_filter_line_c;
 
         if( p_sys->chroma->pixel_size == 2 )
-            filter = yadif_filter_line_c_16bit;
+            slice.filter = yadif_filter_line_c_16bit;
 
         for( int n = 0; n < p_dst->i_planes; n++ )
         {
-            const plane_t *prevp = &p_prev->p[n];
-            const plane_t *curp  = &p_cur->p[n];
-            const plane_t *nextp = &p_next->p[n];
-            plane_t *dstp        = &p_dst->p[n];
-
-            for( int y = 1; y < dstp->i_visible_lines - 1; y++ )
-            {
-                if( (y % 2) == i_field  ||  yadif_parity == 2 )
-                {
-                    memcpy( &dstp->p_pixels[y * dstp->i_pitch],
-                                &curp->p_pixels[y * curp->i_pitch], dstp->i_visible_pitch );
-                }
-                else
-                {
-                    int mode;
-                    /* Spatial checks only when enough data */
-                    mode = (y >= 2 && y < dstp->i_visible_lines - 2) ? 0 : 2;
-
-                    assert( prevp->i_pitch == curp->i_pitch && curp->i_pitch == nextp->i_pitch );
-                    filter( &dstp->p_pixels[y * dstp->i_pitch],
-                            &prevp->p_pixels[y * prevp->i_pitch],
-                            &curp->p_pixels[y * curp->i_pitch],
-                            &nextp->p_pixels[y * nextp->i_pitch],
-                            dstp->i_visible_pitch,
-                            y < dstp->i_visible_lines - 2  ? curp->i_pitch : -curp->i_pitch,
-                            y  - 1  ?  -curp->i_pitch : curp->i_pitch,
-                            yadif_parity,
-                            mode );
-                }
-
-                /* We duplicate the first and last lines */
-                if( y == 1 )
-                    memcpy(&dstp->p_pixels[(y-1) * dstp->i_pitch],
-                               &dstp->p_pixels[ y    * dstp->i_pitch],
-                               dstp->i_pitch);
-                else if( y == dstp->i_visible_lines - 2 )
-                    memcpy(&dstp->p_pixels[(y+1) * dstp->i_pitch],
-                               &dstp->p_pixels[ y    * dstp->i_pitch],
-                               dstp->i_pitch);
-            }
+            slice.prevp = &p_prev->p[n];
+            slice.curp  = &p_cur->p[n];
+            slice.nextp = &p_next->p[n];
+            slice.dstp  = &p_dst->p[n];
+
+            /* Bands of even lines, so that each one starts on the same field */
+            filter_RunSlices( p_filter, p_dst->p[n].i_visible_lines, 2,
+                              RenderYadifSlice, &slice );
         }
 
         p_sys->context.i_frame_offset = 1; /* p_cur will be rendered at next frame, too */
@@ -348,6 +348,7 @@ struct filter_mode_t
     deinterlace_algo     settings;
     bool                 can_pack;         /**< can handle packed pixel */
     bool                 b_high_bit_depth; /**< can handle high bit depth */
+    bool                 b_slices;         /**< uses the slice threads */
 };
 static struct filter_mode_t filter_mode [] = {
     { "discard", .pf_render_single_pic = RenderDiscard,
@@ -363,9 +364,9 @@ static struct filter_mode_t filter_mode [] = {
     { "blend", .pf_render_single_pic = RenderBlend,
                  { false, false, false, false }, true, true },
     { "yadif", .pf_render_single_pic = RenderYadifSingle,
-                 { false, true, false, false }, false, true },
+                 { false, true, false, false }, false, true, true },
     { "yadif2x", .pf_render_ordered = RenderYadif,
-                 { true, true, false, false }, false, true },
+                 { true, true, false, false }, false, true, true },
     { "x", .pf_render_single_pic = RenderX,
                  { false, false, false, false }, false, false },
     { "phosphor", .pf_render_ordered = RenderPhosphor,
@@ -412,6 +413,7 @@ static void SetFilterMethod( filter_t *p_filter, const char *mode, bool pack )
             msg_Dbg( p_filter, "using %s deinterlace method", mode );
             p_sys->context.settings = filter_mode[i].settings;
             p_sys->context.pf_render_ordered = filter_mode[i].pf_render_ordered;
+            p_sys->b_slices = filter_mode[i].b_slices;
             return;
         }
     }
@@ -521,11 +523,14 @@ notsupp:
     p_sys->chroma = chroma;
 
     InitDeinterlacingContext( &p_sys->context );
+    p_sys->b_slices = false;
 
     config_ChainParse( p_filter, FILTER_CFG_PREFIX, ppsz_filter_options,
                        p_filter->p_cfg );
     char *psz_mode = var_InheritString( p_filter, FILTER_CFG_PREFIX "mode" );
     SetFilterMethod( p_filter, psz_mode, packed );
+    if( p_sys->b_slices )
+        filter_HoldSlices( p_filter );
 
     IVTCClearState( p_filter );
 
@@ -650,5 +655,7 @@ void Close( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t*)p_this;
 
     Flush( p_filter );
+    if( p_filter->p_sys->b_slices )
+        filter_ReleaseSlices( p_filter );
     free( p_filter->p_sys );
 }
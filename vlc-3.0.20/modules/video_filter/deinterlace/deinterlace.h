@@ -77,6 +77,7 @@ struct filter_sys_t
 #endif
 
     struct deinterlace_ctx   context;
+    bool b_slices; /**< The method renders bands of lines in parallel */
 
     /* Algorithm-specific substructures */
     union {
@@ -151,3 +151,207 @@ static void yadif_filter_line_c_16bit(uint8_t *dst8, uint8_t *prev8, uint8_t *cu
     prefs /= 2;
     FILTER
 }
+
+#ifdef HAVE_AVX2_INTRINSICS
+// ================ AVX2 ================
+#include <immintrin.h>
+#define HAVE_YADIF_AVX2
+
+#define AVX2_LOAD(p) _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(p)))
+
+/* Same as CHECK(j), for 16 pixels of which the mask ones are still checked */
+__attribute__ ((__target__ ("avx2")))
+static inline __m256i yadif_check_avx2(const uint8_t *cur, int mrefs, int prefs,
+                                       int j, __m256i mask,
+                                       __m256i *spatial_score,
+                                       __m256i *spatial_pred)
+{
+    __m256i m0 = AVX2_LOAD(&cur[mrefs + j]);
+    __m256i p0 = AVX2_LOAD(&cur[prefs - j]);
+    __m256i score = _mm256_add_epi16(
+        _mm256_add_epi16(
+            _mm256_abs_epi16(_mm256_sub_epi16(AVX2_LOAD(&cur[mrefs - 1 + j]),
+                                              AVX2_LOAD(&cur[prefs - 1 - j]))),
+            _mm256_abs_epi16(_mm256_sub_epi16(m0, p0))),
+        _mm256_abs_epi16(_mm256_sub_epi16(AVX2_LOAD(&cur[mrefs + 1 + j]),
+                                          AVX2_LOAD(&cur[prefs + 1 - j]))));
+
+    mask = _mm256_and_si256(mask, _mm256_cmpgt_epi16(*spatial_score, score));
+    *spatial_score = _mm256_blendv_epi8(*spatial_score, score, mask);
+    *spatial_pred = _mm256_blendv_epi8(*spatial_pred,
+                        _mm256_srai_epi16(_mm256_add_epi16(m0, p0), 1), mask);
+    return mask;
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void yadif_filter_line_avx2(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next, int w, int prefs, int mrefs, int parity, int mode) {
+    uint8_t *prev2= parity ? prev : cur ;
+    uint8_t *next2= parity ? cur  : next;
+    const __m256i ones = _mm256_set1_epi16(-1);
+    const __m256i one = _mm256_set1_epi16(1);
+    int x;
+
+    for (x = 0; x + 16 <= w; x += 16) {
+        __m256i c = AVX2_LOAD(&cur[mrefs + x]);
+        __m256i e = AVX2_LOAD(&cur[prefs + x]);
+        __m256i p2 = AVX2_LOAD(&prev2[x]);
+        __m256i n2 = AVX2_LOAD(&next2[x]);
+        __m256i d = _mm256_srai_epi16(_mm256_add_epi16(p2, n2), 1);
+
+        __m256i temporal_diff0 = _mm256_abs_epi16(_mm256_sub_epi16(p2, n2));
+        __m256i temporal_diff1 = _mm256_srai_epi16(_mm256_add_epi16(
+            _mm256_abs_epi16(_mm256_sub_epi16(AVX2_LOAD(&prev[mrefs + x]), c)),
+            _mm256_abs_epi16(_mm256_sub_epi16(AVX2_LOAD(&prev[prefs + x]), e))), 1);
+        __m256i temporal_diff2 = _mm256_srai_epi16(_mm256_add_epi16(
+            _mm256_abs_epi16(_mm256_sub_epi16(AVX2_LOAD(&next[mrefs + x]), c)),
+            _mm256_abs_epi16(_mm256_sub_epi16(AVX2_LOAD(&next[prefs + x]), e))), 1);
+        __m256i diff = _mm256_max_epi16(_mm256_max_epi16(
+            _mm256_srai_epi16(temporal_diff0, 1), temporal_diff1), temporal_diff2);
+
+        __m256i spatial_pred = _mm256_srai_epi16(_mm256_add_epi16(c, e), 1);
+        __m256i spatial_score = _mm256_sub_epi16(_mm256_add_epi16(
+            _mm256_add_epi16(
+                _mm256_abs_epi16(_mm256_sub_epi16(AVX2_LOAD(&cur[mrefs + x - 1]),
+                                                  AVX2_LOAD(&cur[prefs + x - 1]))),
+                _mm256_abs_epi16(_mm256_sub_epi16(c, e))),
+            _mm256_abs_epi16(_mm256_sub_epi16(AVX2_LOAD(&cur[mrefs + x + 1]),
+                                              AVX2_LOAD(&cur[prefs + x + 1])))), one);
+
+        __m256i mask;
+        mask = yadif_check_avx2(&cur[x], mrefs, prefs, -1, ones,
+                                &spatial_score, &spatial_pred);
+        yadif_check_avx2(&cur[x], mrefs, prefs, -2, mask,
+                         &spatial_score, &spatial_pred);
+        mask = yadif_check_avx2(&cur[x], mrefs, prefs, 1, ones,
+                                &spatial_score, &spatial_pred);
+        yadif_check_avx2(&cur[x], mrefs, prefs, 2, mask,
+                         &spatial_score, &spatial_pred);
+
+        if (mode < 2) {
+            __m256i b = _mm256_srai_epi16(_mm256_add_epi16(
+                AVX2_LOAD(&prev2[2 * mrefs + x]), AVX2_LOAD(&next2[2 * mrefs + x])), 1);
+            __m256i f = _mm256_srai_epi16(_mm256_add_epi16(
+                AVX2_LOAD(&prev2[2 * prefs + x]), AVX2_LOAD(&next2[2 * prefs + x])), 1);
+            __m256i de = _mm256_sub_epi16(d, e);
+            __m256i dc = _mm256_sub_epi16(d, c);
+            __m256i bc = _mm256_sub_epi16(b, c);
+            __m256i fe = _mm256_sub_epi16(f, e);
+            __m256i max = _mm256_max_epi16(_mm256_max_epi16(de, dc),
+                                           _mm256_min_epi16(bc, fe));
+            __m256i min = _mm256_min_epi16(_mm256_min_epi16(de, dc),
+                                           _mm256_max_epi16(bc, fe));
+
+            diff = _mm256_max_epi16(_mm256_max_epi16(diff, min),
+                                    _mm256_sub_epi16(_mm256_setzero_si256(), max));
+        }
+
+        spatial_pred = _mm256_min_epi16(_mm256_max_epi16(spatial_pred,
+                                            _mm256_sub_epi16(d, diff)),
+                                        _mm256_add_epi16(d, diff));
+
+        _mm_storeu_si128((__m128i *)&dst[x],
+                         _mm_packus_epi16(_mm256_castsi256_si128(spatial_pred),
+                                          _mm256_extracti128_si256(spatial_pred, 1)));
+    }
+
+    if (x < w)
+        yadif_filter_line_c(&dst[x], &prev[x], &cur[x], &next[x], w - x,
+                            prefs, mrefs, parity, mode);
+}
+#undef AVX2_LOAD
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+// ================ NEON ================
+#include <arm_neon.h>
+#define HAVE_YADIF_NEON
+
+#define NEON_LOAD(p) vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p)))
+
+/* Same as CHECK(j), for 8 pixels of which the mask ones are still checked */
+static inline uint16x8_t yadif_check_neon(const uint8_t *cur, int mrefs, int prefs,
+                                          int j, uint16x8_t mask,
+                                          int16x8_t *spatial_score,
+                                          int16x8_t *spatial_pred)
+{
+    int16x8_t m0 = NEON_LOAD(&cur[mrefs + j]);
+    int16x8_t p0 = NEON_LOAD(&cur[prefs - j]);
+    int16x8_t score = vaddq_s16(vaddq_s16(
+        vabdq_s16(NEON_LOAD(&cur[mrefs - 1 + j]), NEON_LOAD(&cur[prefs - 1 - j])),
+        vabdq_s16(m0, p0)),
+        vabdq_s16(NEON_LOAD(&cur[mrefs + 1 + j]), NEON_LOAD(&cur[prefs + 1 - j])));
+
+    mask = vandq_u16(mask, vcltq_s16(score, *spatial_score));
+    *spatial_score = vbslq_s16(mask, score, *spatial_score);
+    *spatial_pred = vbslq_s16(mask, vshrq_n_s16(vaddq_s16(m0, p0), 1),
+                              *spatial_pred);
+    return mask;
+}
+
+static void yadif_filter_line_neon(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next, int w, int prefs, int mrefs, int parity, int mode) {
+    uint8_t *prev2= parity ? prev : cur ;
+    uint8_t *next2= parity ? cur  : next;
+    const uint16x8_t ones = vdupq_n_u16(0xffff);
+    int x;
+
+    for (x = 0; x + 8 <= w; x += 8) {
+        int16x8_t c = NEON_LOAD(&cur[mrefs + x]);
+        int16x8_t e = NEON_LOAD(&cur[prefs + x]);
+        int16x8_t p2 = NEON_LOAD(&prev2[x]);
+        int16x8_t n2 = NEON_LOAD(&next2[x]);
+        int16x8_t d = vshrq_n_s16(vaddq_s16(p2, n2), 1);
+
+        int16x8_t temporal_diff0 = vabdq_s16(p2, n2);
+        int16x8_t temporal_diff1 = vshrq_n_s16(vaddq_s16(
+            vabdq_s16(NEON_LOAD(&prev[mrefs + x]), c),
+            vabdq_s16(NEON_LOAD(&prev[prefs + x]), e)), 1);
+        int16x8_t temporal_diff2 = vshrq_n_s16(vaddq_s16(
+            vabdq_s16(NEON_LOAD(&next[mrefs + x]), c),
+            vabdq_s16(NEON_LOAD(&next[prefs + x]), e)), 1);
+        int16x8_t diff = vmaxq_s16(vmaxq_s16(vshrq_n_s16(temporal_diff0, 1),
+                                             temporal_diff1), temporal_diff2);
+
+        int16x8_t spatial_pred = vshrq_n_s16(vaddq_s16(c, e), 1);
+        int16x8_t spatial_score = vsubq_s16(vaddq_s16(vaddq_s16(
+            vabdq_s16(NEON_LOAD(&cur[mrefs + x - 1]), NEON_LOAD(&cur[prefs + x - 1])),
+            vabdq_s16(c, e)),
+            vabdq_s16(NEON_LOAD(&cur[mrefs + x + 1]), NEON_LOAD(&cur[prefs + x + 1]))),
+            vdupq_n_s16(1));
+
+        uint16x8_t mask;
+        mask = yadif_check_neon(&cur[x], mrefs, prefs, -1, ones,
+                                &spatial_score, &spatial_pred);
+        yadif_check_neon(&cur[x], mrefs, prefs, -2, mask,
+                         &spatial_score, &spatial_pred);
+        mask = yadif_check_neon(&cur[x], mrefs, prefs, 1, ones,
+                                &spatial_score, &spatial_pred);
+        yadif_check_neon(&cur[x], mrefs, prefs, 2, mask,
+                         &spatial_score, &spatial_pred);
+
+        if (mode < 2) {
+            int16x8_t b = vshrq_n_s16(vaddq_s16(NEON_LOAD(&prev2[2 * mrefs + x]),
+                                                NEON_LOAD(&next2[2 * mrefs + x])), 1);
+            int16x8_t f = vshrq_n_s16(vaddq_s16(NEON_LOAD(&prev2[2 * prefs + x]),
+                                                NEON_LOAD(&next2[2 * prefs + x])), 1);
+            int16x8_t de = vsubq_s16(d, e);
+            int16x8_t dc = vsubq_s16(d, c);
+            int16x8_t bc = vsubq_s16(b, c);
+            int16x8_t fe = vsubq_s16(f, e);
+            int16x8_t max = vmaxq_s16(vmaxq_s16(de, dc), vminq_s16(bc, fe));
+            int16x8_t min = vminq_s16(vminq_s16(de, dc), vmaxq_s16(bc, fe));
+
+            diff = vmaxq_s16(vmaxq_s16(diff, min), vnegq_s16(max));
+        }
+
+        spatial_pred = vminq_s16(vmaxq_s16(spatial_pred, vsubq_s16(d, diff)),
+                                 vaddq_s16(d, diff));
+
+        vst1_u8(&dst[x], vqmovun_s16(spatial_pred));
+    }
+
+    if (x < w)
+        yadif_filter_line_c(&dst[x], &prev[x], &cur[x], &next[x], w - x,
+                            prefs, mrefs, parity, mode);
+}
+#undef NEON_LOAD
+#endif
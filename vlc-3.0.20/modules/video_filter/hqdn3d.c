@@ -33,6 +33,7 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_cpu.h>
 #include "filter_picture.h"
 
 
@@ -93,6 +94,9 @@ struct filter_sys_t
     int w[3], h[3];
 
     struct vf_priv_s cfg;
+    void (*pf_columns)(const unsigned char *, unsigned char *, unsigned int *,
+                       unsigned short *, long, long, int, int, int, int,
+                       int *, int *);
     bool   b_recalc_coefs;
     vlc_mutex_t coefs_mutex;
     float  luma_spat, luma_temp, chroma_spat, chroma_temp;
@@ -110,7 +114,6 @@ static int Open(vlc_object_t *this)
     const video_format_t *fmt_out = &filter->fmt_out.video;
     const vlc_fourcc_t fourcc_in  = fmt_in->i_chroma;
     const vlc_fourcc_t fourcc_out = fmt_out->i_chroma;
-    int wmax = 0;
 
     const vlc_chroma_description_t *chroma =
             vlc_fourcc_GetChromaDescription(fourcc_in);
@@ -135,14 +138,22 @@ static int Open(vlc_object_t *this)
 
     for (int i = 0; i < 3; ++i) {
         sys->w[i] = fmt_in->i_width  * chroma->p[i].w.num / chroma->p[i].w.den;
-        if (sys->w[i] > wmax) wmax = sys->w[i];
         sys->h[i] = fmt_out->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
+        cfg->Spatial[i] = malloc(sys->w[i] * sys->h[i] * sizeof(unsigned int));
+        if (!cfg->Spatial[i]) {
+            for (int j = 0; j < i; ++j)
+                free(cfg->Spatial[j]);
+            free(sys);
+            return VLC_ENOMEM;
+        }
     }
-    cfg->Line = malloc(wmax*sizeof(unsigned int));
-    if (!cfg->Line) {
-        free(sys);
-        return VLC_ENOMEM;
-    }
+
+#ifdef HAVE_DENOISE_AVX2
+    if (vlc_CPU_AVX2())
+        sys->pf_columns = deNoiseColumns_avx2;
+    else
+#endif
+        sys->pf_columns = deNoiseColumns;
 
     config_ChainParse(filter, FILTER_PREFIX, filter_options,
                       filter->p_cfg);
@@ -157,6 +168,7 @@ static int Open(vlc_object_t *this)
 
     filter->p_sys = sys;
     filter->pf_video_filter = Filter;
+    filter_HoldSlices(filter);
 
     var_AddCallback( filter, FILTER_PREFIX "luma-spat", DenoiseCallback, sys );
     var_AddCallback( filter, FILTER_PREFIX "chroma-spat", DenoiseCallback, sys );
@@ -180,18 +192,91 @@ static void Close(vlc_object_t *this)
     var_DelCallback( filter, FILTER_PREFIX "luma-temp", DenoiseCallback, sys );
     var_DelCallback( filter, FILTER_PREFIX "chroma-temp", DenoiseCallback, sys );
 
+    filter_ReleaseSlices(filter);
     vlc_mutex_destroy( &sys->coefs_mutex );
 
     for (int i = 0; i < 3; ++i) {
         free(cfg->Frame[i]);
+        free(cfg->Spatial[i]);
     }
-    free(cfg->Line);
     free(sys);
 }
 
 /*****************************************************************************
  * Filter
  *****************************************************************************/
+struct denoise_job
+{
+    picture_t *src;
+    picture_t *dst;
+};
+
+static int *SpatialCoefs(struct vf_priv_s *cfg, int plane)
+{
+    return cfg->Coefs[plane == 0 ? 0 : 2];
+}
+
+static int *TemporalCoefs(struct vf_priv_s *cfg, int plane)
+{
+    return cfg->Coefs[plane == 0 ? 1 : 3];
+}
+
+/* Filters horizontally the lines [first, first + count) of the planes
+ * placed one after the other */
+static void FilterLines(filter_t *filter, void *data,
+                        unsigned first, unsigned count)
+{
+    filter_sys_t *sys = filter->p_sys;
+    struct vf_priv_s *cfg = &sys->cfg;
+    const struct denoise_job *job = data;
+    int plane = 0;
+
+    while (first >= (unsigned)sys->h[plane])
+        first -= sys->h[plane++];
+
+    for (; count > 0; plane++, first = 0) {
+        const unsigned lines = __MIN((unsigned)sys->h[plane] - first, count);
+        int *horizontal = SpatialCoefs(cfg, plane);
+        const plane_t *src = &job->src->p[plane];
+
+        count -= lines;
+        if (!horizontal[0])
+            continue;
+        deNoiseLines(&src->p_pixels[first * src->i_pitch],
+                     &cfg->Spatial[plane][first * sys->w[plane]],
+                     sys->w[plane], lines, src->i_pitch, horizontal);
+    }
+}
+
+/* Filters vertically and temporally the columns [first, first + count) of
+ * the planes placed side by side */
+static void FilterColumns(filter_t *filter, void *data,
+                          unsigned first, unsigned count)
+{
+    filter_sys_t *sys = filter->p_sys;
+    struct vf_priv_s *cfg = &sys->cfg;
+    const struct denoise_job *job = data;
+    int plane = 0;
+
+    while (first >= (unsigned)sys->w[plane])
+        first -= sys->w[plane++];
+
+    for (; count > 0; plane++, first = 0) {
+        const unsigned columns = __MIN((unsigned)sys->w[plane] - first, count);
+        int *vertical = SpatialCoefs(cfg, plane);
+        const plane_t *src = &job->src->p[plane];
+        const plane_t *dst = &job->dst->p[plane];
+
+        count -= columns;
+        sys->pf_columns(src->p_pixels, dst->p_pixels,
+                        vertical[0] ? cfg->Spatial[plane] : NULL,
+                        cfg->Frame[plane], first, first + columns,
+                        sys->w[plane], sys->h[plane],
+                        src->i_pitch, dst->i_pitch,
+                        vertical, TemporalCoefs(cfg, plane));
+    }
+}
+
 static picture_t *Filter(filter_t *filter, picture_t *src)
 {
     picture_t *dst;
@@ -221,32 +306,30 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
     }
     vlc_mutex_unlock( &sys->coefs_mutex );
 
-    deNoise(src->p[0].p_pixels, dst->p[0].p_pixels,
-            cfg->Line, &cfg->Frame[0], sys->w[0], sys->h[0],
-            src->p[0].i_pitch, dst->p[0].i_pitch,
-            cfg->Coefs[0],
-            cfg->Coefs[0],
-            cfg->Coefs[1]);
-    deNoise(src->p[1].p_pixels, dst->p[1].p_pixels,
-            cfg->Line, &cfg->Frame[1], sys->w[1], sys->h[1],
-            src->p[1].i_pitch, dst->p[1].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
-    deNoise(src->p[2].p_pixels, dst->p[2].p_pixels,
-            cfg->Line, &cfg->Frame[2], sys->w[2], sys->h[2],
-            src->p[2].i_pitch, dst->p[2].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
-
-    if(unlikely(!cfg->Frame[0] || !cfg->Frame[1] || !cfg->Frame[2]))
-    {
-        picture_Release( src );
-        picture_Release( dst );
-        return NULL;
+    /* The previous frame starts as the first one */
+    for (int i = 0; i < 3; ++i) {
+        if (cfg->Frame[i])
+            continue;
+        cfg->Frame[i] = malloc(sys->w[i] * sys->h[i] * sizeof(unsigned short));
+        if (unlikely(!cfg->Frame[i])) {
+            picture_Release( src );
+            picture_Release( dst );
+            return NULL;
+        }
+        for (int y = 0; y < sys->h[i]; y++) {
+            unsigned short *ant = &cfg->Frame[i][y * sys->w[i]];
+            const uint8_t *pix = &src->p[i].p_pixels[y * src->p[i].i_pitch];
+            for (int x = 0; x < sys->w[i]; x++)
+                ant[x] = pix[x] << 8;
+        }
     }
 
+    struct denoise_job job = { src, dst };
+    filter_RunSlices(filter, sys->h[0] + sys->h[1] + sys->h[2], 4,
+                     FilterLines, &job);
+    filter_RunSlices(filter, sys->w[0] + sys->w[1] + sys->w[2], 8,
+                     FilterColumns, &job);
+
     return CopyInfoAndRelease(dst, src);
 }
 
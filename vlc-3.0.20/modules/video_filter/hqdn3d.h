@@ -22,6 +22,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
+#include <stdbool.h>
 #include <math.h>
 
 #define PARAM1_DEFAULT 4.0
@@ -32,7 +33,7 @@
 
 struct vf_priv_s {
         int Coefs[4][512*16];
-        unsigned int *Line;
+        unsigned int *Spatial[3];
         unsigned short *Frame[3];
 };
 
@@ -46,137 +47,162 @@ static /*inline*/ unsigned int LowPassMul(unsigned int PrevMul, unsigned int Cur
     return CurrMul + Coef[d];
 }
 
-static void deNoiseTemporal(
-                    unsigned char *Frame,        // mpi->planes[x]
-                    unsigned char *FrameDest,    // dmpi->planes[x]
-                    unsigned short *FrameAnt,
-                    int W, int H, int sStride, int dStride,
-                    int *Temporal)
+/* The horizontal filter only depends on the pixels of the line, and the
+ * vertical and temporal filters on the pixels of the column, so the lines
+ * are filtered horizontally first, then the columns vertically and
+ * temporally. This gives the same result as filtering each pixel in turn,
+ * with lines and columns independent from each other. */
+
+static void deNoiseLines(
+                    const unsigned char *Frame,  // mpi->planes[x]
+                    unsigned int *Spatial,       // the spatial plane
+                    int W, int H, int sStride,
+                    int *Horizontal)
 {
-    unsigned int PixelDst;
+    long Y = 0;
 
-    for (long Y = 0; Y < H; Y++){
-        for (long X = 0; X < W; X++){
-            PixelDst = LowPassMul(FrameAnt[X]<<8, Frame[X]<<16, Temporal);
-            FrameAnt[X] = ((PixelDst+0x1000007F)>>8);
-            FrameDest[X]= ((PixelDst+0x10007FFF)>>16);
+    /* Each line is a chain of dependent lookups: filter four lines at once
+     * so that their latencies overlap. */
+    for (; Y + 4 <= H; Y += 4){
+        const unsigned char *F0 = Frame, *F1 = F0 + sStride,
+                            *F2 = F1 + sStride, *F3 = F2 + sStride;
+        unsigned int *L0 = Spatial, *L1 = L0 + W, *L2 = L1 + W, *L3 = L2 + W;
+
+        /* First pixel has no left neighbor. */
+        unsigned int PixelAnt0 = L0[0] = F0[0]<<16;
+        unsigned int PixelAnt1 = L1[0] = F1[0]<<16;
+        unsigned int PixelAnt2 = L2[0] = F2[0]<<16;
+        unsigned int PixelAnt3 = L3[0] = F3[0]<<16;
+
+        for (long X = 1; X < W; X++){
+            PixelAnt0 = L0[X] = LowPassMul(PixelAnt0, F0[X]<<16, Horizontal);
+            PixelAnt1 = L1[X] = LowPassMul(PixelAnt1, F1[X]<<16, Horizontal);
+            PixelAnt2 = L2[X] = LowPassMul(PixelAnt2, F2[X]<<16, Horizontal);
+            PixelAnt3 = L3[X] = LowPassMul(PixelAnt3, F3[X]<<16, Horizontal);
         }
+        Frame += 4 * sStride;
+        Spatial += 4 * W;
+    }
+
+    for (; Y < H; Y++){
+        unsigned int PixelAnt = Spatial[0] = Frame[0]<<16;
+
+        for (long X = 1; X < W; X++)
+            PixelAnt = Spatial[X] = LowPassMul(PixelAnt, Frame[X]<<16, Horizontal);
         Frame += sStride;
-        FrameDest += dStride;
-        FrameAnt += W;
+        Spatial += W;
     }
 }
 
-static void deNoiseSpacial(
-                    unsigned char *Frame,        // mpi->planes[x]
+static void deNoiseColumns(
+                    const unsigned char *Frame,  // mpi->planes[x]
                     unsigned char *FrameDest,    // dmpi->planes[x]
-                    unsigned int *LineAnt,       // vf->priv->Line (width bytes)
-                    int W, int H, int sStride, int dStride,
-                    int *Horizontal, int *Vertical)
+                    unsigned int *Spatial,       // lines filtered horizontally
+                    unsigned short *FrameAnt,
+                    long X0, long X1, int W, int H, int sStride, int dStride,
+                    int *Vertical, int *Temporal)
 {
-    long sLineOffs = 0, dLineOffs = 0;
-    unsigned int PixelAnt;
-    unsigned int PixelDst;
-
-    /* First pixel has no left nor top neighbor. */
-    PixelDst = LineAnt[0] = PixelAnt = Frame[0]<<16;
-    FrameDest[0]= ((PixelDst+0x10007FFF)>>16);
-
-    /* First line has no top neighbor, only left. */
-    for (long X = 1; X < W; X++){
-        PixelDst = LineAnt[X] = LowPassMul(PixelAnt, Frame[X]<<16, Horizontal);
-        FrameDest[X]= ((PixelDst+0x10007FFF)>>16);
-    }
-
-    for (long Y = 1; Y < H; Y++){
-        unsigned int PixelAnt;
-        sLineOffs += sStride, dLineOffs += dStride;
-        /* First pixel on each line doesn't have previous pixel */
-        PixelAnt = Frame[sLineOffs]<<16;
-        PixelDst = LineAnt[0] = LowPassMul(LineAnt[0], PixelAnt, Vertical);
-        FrameDest[dLineOffs]= ((PixelDst+0x10007FFF)>>16);
+    /* The previous frame is updated whenever the spatial filter is off */
+    const bool bTemporal = !Spatial || Temporal[0];
 
-        for (long X = 1; X < W; X++){
+    for (long Y = 0; Y < H; Y++){
+        for (long X = X0; X < X1; X++){
             unsigned int PixelDst;
-            /* The rest are normal */
-            PixelAnt = LowPassMul(PixelAnt, Frame[sLineOffs+X]<<16, Horizontal);
-            PixelDst = LineAnt[X] = LowPassMul(LineAnt[X], PixelAnt, Vertical);
-            FrameDest[dLineOffs+X]= ((PixelDst+0x10007FFF)>>16);
+            if (Spatial){
+                PixelDst = Spatial[X];
+                /* First line has no top neighbor. */
+                if (Y > 0)
+                    PixelDst = Spatial[X] = LowPassMul(Spatial[X - W], PixelDst, Vertical);
+            }
+            else
+                PixelDst = Frame[X]<<16;
+            if (bTemporal){
+                PixelDst = LowPassMul(FrameAnt[X]<<8, PixelDst, Temporal);
+                FrameAnt[X] = ((PixelDst+0x1000007F)>>8);
+            }
+            FrameDest[X]= ((PixelDst+0x10007FFF)>>16);
         }
+        Frame += sStride;
+        FrameDest += dStride;
+        if (Spatial)
+            Spatial += W;
+        FrameAnt += W;
     }
 }
 
-static void deNoise(unsigned char *Frame,        // mpi->planes[x]
-                    unsigned char *FrameDest,    // dmpi->planes[x]
-                    unsigned int *LineAnt,      // vf->priv->Line (width bytes)
-                    unsigned short **FrameAntPtr,
-                    int W, int H, int sStride, int dStride,
-                    int *Horizontal, int *Vertical, int *Temporal)
-{
-    long sLineOffs = 0, dLineOffs = 0;
-    unsigned int PixelAnt;
-    unsigned int PixelDst;
-    unsigned short* FrameAnt=(*FrameAntPtr);
-
-    if(!FrameAnt){
-        (*FrameAntPtr)=FrameAnt=malloc(W*H*sizeof(unsigned short));
-        if(!FrameAnt)
-            return;
-        for (long Y = 0; Y < H; Y++){
-            unsigned short* dst=&FrameAnt[Y*W];
-            unsigned char* src=Frame+Y*sStride;
-            for (long X = 0; X < W; X++) dst[X]=src[X]<<8;
-        }
-    }
+#ifdef HAVE_AVX2_INTRINSICS
+#include <immintrin.h>
+#define HAVE_DENOISE_AVX2
 
-    if(!Horizontal[0] && !Vertical[0]){
-        deNoiseTemporal(Frame, FrameDest, FrameAnt,
-                        W, H, sStride, dStride, Temporal);
-        return;
-    }
-    if(!Temporal[0]){
-        deNoiseSpacial(Frame, FrameDest, LineAnt,
-                       W, H, sStride, dStride, Horizontal, Vertical);
-        return;
-    }
+__attribute__ ((__target__ ("avx2")))
+static inline __m256i LowPassMul_avx2(__m256i PrevMul, __m256i CurrMul, int* Coef){
+    __m256i d = _mm256_srli_epi32(_mm256_add_epi32(_mm256_sub_epi32(PrevMul, CurrMul),
+                                                   _mm256_set1_epi32(0x10007FF)), 12);
+    return _mm256_add_epi32(CurrMul, _mm256_i32gather_epi32(Coef, d, 4));
+}
 
-    /* First pixel has no left nor top neighbor. Only previous frame */
-    LineAnt[0] = PixelAnt = Frame[0]<<16;
-    PixelDst = LowPassMul(FrameAnt[0]<<8, PixelAnt, Temporal);
-    FrameAnt[0] = ((PixelDst+0x1000007F)>>8);
-    FrameDest[0]= ((PixelDst+0x10007FFF)>>16);
-
-    /* First line has no top neighbor. Only left one for each pixel and
-     * last frame */
-    for (long X = 1; X < W; X++){
-        LineAnt[X] = PixelAnt = LowPassMul(PixelAnt, Frame[X]<<16, Horizontal);
-        PixelDst = LowPassMul(FrameAnt[X]<<8, PixelAnt, Temporal);
-        FrameAnt[X] = ((PixelDst+0x1000007F)>>8);
-        FrameDest[X]= ((PixelDst+0x10007FFF)>>16);
-    }
+/* Same as deNoiseColumns(), 8 columns at a time */
+__attribute__ ((__target__ ("avx2")))
+static void deNoiseColumns_avx2(
+                    const unsigned char *Frame,
+                    unsigned char *FrameDest,
+                    unsigned int *Spatial,
+                    unsigned short *FrameAnt,
+                    long X0, long X1, int W, int H, int sStride, int dStride,
+                    int *Vertical, int *Temporal)
+{
+    const bool bTemporal = !Spatial || Temporal[0];
+    const long X8 = X0 + ((X1 - X0) & ~7);
 
-    for (long Y = 1; Y < H; Y++){
-        unsigned int PixelAnt;
-        unsigned short* LinePrev=&FrameAnt[Y*W];
-        sLineOffs += sStride, dLineOffs += dStride;
-        /* First pixel on each line doesn't have previous pixel */
-        PixelAnt = Frame[sLineOffs]<<16;
-        LineAnt[0] = LowPassMul(LineAnt[0], PixelAnt, Vertical);
-        PixelDst = LowPassMul(LinePrev[0]<<8, LineAnt[0], Temporal);
-        LinePrev[0] = ((PixelDst+0x1000007F)>>8);
-        FrameDest[dLineOffs]= ((PixelDst+0x10007FFF)>>16);
+    /* The columns being independent, the remaining ones go first */
+    if (X8 < X1)
+        deNoiseColumns(Frame, FrameDest, Spatial, FrameAnt,
+                       X8, X1, W, H, sStride, dStride, Vertical, Temporal);
 
-        for (long X = 1; X < W; X++){
-            unsigned int PixelDst;
-            /* The rest are normal */
-            PixelAnt = LowPassMul(PixelAnt, Frame[sLineOffs+X]<<16, Horizontal);
-            LineAnt[X] = LowPassMul(LineAnt[X], PixelAnt, Vertical);
-            PixelDst = LowPassMul(LinePrev[X]<<8, LineAnt[X], Temporal);
-            LinePrev[X] = ((PixelDst+0x1000007F)>>8);
-            FrameDest[dLineOffs+X]= ((PixelDst+0x10007FFF)>>16);
+    for (long Y = 0; Y < H; Y++){
+        for (long X = X0; X < X8; X += 8){
+            __m256i PixelDst;
+            if (Spatial){
+                PixelDst = _mm256_loadu_si256((__m256i *)&Spatial[X]);
+                if (Y > 0){
+                    PixelDst = LowPassMul_avx2(
+                        _mm256_loadu_si256((__m256i *)&Spatial[X - W]),
+                        PixelDst, Vertical);
+                    _mm256_storeu_si256((__m256i *)&Spatial[X], PixelDst);
+                }
+            }
+            else
+                PixelDst = _mm256_slli_epi32(_mm256_cvtepu8_epi32(
+                    _mm_loadl_epi64((const __m128i *)&Frame[X])), 16);
+            if (bTemporal){
+                __m256i Ant = _mm256_cvtepu16_epi32(
+                    _mm_loadu_si128((const __m128i *)&FrameAnt[X]));
+                PixelDst = LowPassMul_avx2(_mm256_slli_epi32(Ant, 8),
+                                           PixelDst, Temporal);
+                Ant = _mm256_and_si256(_mm256_srli_epi32(_mm256_add_epi32(PixelDst,
+                                           _mm256_set1_epi32(0x1000007F)), 8),
+                                       _mm256_set1_epi32(0xFFFF));
+                _mm_storeu_si128((__m128i *)&FrameAnt[X],
+                    _mm_packus_epi32(_mm256_castsi256_si128(Ant),
+                                     _mm256_extracti128_si256(Ant, 1)));
+            }
+            __m256i Dest = _mm256_and_si256(_mm256_srli_epi32(_mm256_add_epi32(PixelDst,
+                                                _mm256_set1_epi32(0x10007FFF)), 16),
+                                            _mm256_set1_epi32(0xFF));
+            __m128i Dest16 = _mm_packus_epi32(_mm256_castsi256_si128(Dest),
+                                              _mm256_extracti128_si256(Dest, 1));
+            _mm_storel_epi64((__m128i *)&FrameDest[X],
+                             _mm_packus_epi16(Dest16, Dest16));
         }
+        Frame += sStride;
+        FrameDest += dStride;
+        if (Spatial)
+            Spatial += W;
+        FrameAnt += W;
     }
+
 }
+#endif
 
 
 //===========================================================================//
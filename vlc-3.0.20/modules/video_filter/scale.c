@@ -39,6 +39,7 @@
  * Local prototypes
  ****************************************************************************/
 static int  OpenFilter ( vlc_object_t * );
+static void CloseFilter( vlc_object_t * );
 static picture_t *Filter( filter_t *, picture_t * );
 
 /*****************************************************************************
@@ -47,7 +48,7 @@ static picture_t *Filter( filter_t *, picture_t * );
 vlc_module_begin ()
     set_description( N_("Video scaling filter") )
     set_capability( "video converter", 10 )
-    set_callbacks( OpenFilter, NULL )
+    set_callbacks( OpenFilter, CloseFilter )
 vlc_module_end ()
 
 /*****************************************************************************
@@ -80,29 +81,30 @@ static int OpenFilter( vlc_object_t *p_this )
              p_filter->fmt_in.video.i_height, p_filter->fmt_out.video.i_width,
              p_filter->fmt_out.video.i_height );
 
+    filter_HoldSlices( p_filter );
     return VLC_SUCCESS;
 }
 
+/*****************************************************************************
+ * CloseFilter: release the slice threads
+ *****************************************************************************/
+static void CloseFilter( vlc_object_t *p_this )
+{
+    filter_ReleaseSlices( (filter_t *)p_this );
+}
+
 /****************************************************************************
- * Filter: the whole thing
+ * ScaleSlice: scale the destination lines [i_first, i_first + i_count) of
+ * the first plane, and the matching lines of the other planes
  ****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static void ScaleSlice( filter_t *p_filter, void *p_data,
+                        unsigned i_first, unsigned i_count )
 {
-    picture_t *p_pic_dst;
-
-    if( !p_pic ) return NULL;
-
-#warning Converter cannot (really) change output format.
-    video_format_ScaleCropAr( &p_filter->fmt_out.video, &p_filter->fmt_in.video );
-
-    /* Request output picture */
-    p_pic_dst = filter_NewPicture( p_filter );
-    if( !p_pic_dst )
-    {
-        picture_Release( p_pic );
-        return NULL;
-    }
+    picture_t **pp_pics = p_data;
+    picture_t *p_pic = pp_pics[0], *p_pic_dst = pp_pics[1];
+    const int i_lines = p_pic_dst->p[0].i_visible_lines;
 
+#define SHIFT_SIZE 16
     if( p_filter->fmt_in.video.i_chroma != VLC_CODEC_RGBA &&
         p_filter->fmt_in.video.i_chroma != VLC_CODEC_ARGB &&
         p_filter->fmt_in.video.i_chroma != VLC_CODEC_RGB32 )
@@ -120,7 +122,6 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
             const int i_dst_visible_pitch =
                                        p_pic_dst->p[i_plane].i_visible_pitch;
             const int i_dst_hidden_pitch  = i_dst_pitch - i_dst_visible_pitch;
-#define SHIFT_SIZE 16
             const int i_height_coef  = ( i_src_height << SHIFT_SIZE )
                                        / i_dst_height;
             const int i_width_coef   = ( i_src_width << SHIFT_SIZE )
@@ -128,15 +129,22 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
             const int i_src_height_1 = i_src_height - 1;
             const int i_src_width_1  = i_src_width - 1;
 
+            /* Lines of this plane matching the band of the first plane */
+            const int i_dst_first = i_first * i_dst_visible_lines / i_lines;
+            const int i_dst_last  = ( i_first + i_count ) * i_dst_visible_lines
+                                  / i_lines;
+
             uint8_t *p_src = p_pic->p[i_plane].p_pixels;
-            uint8_t *p_dst = p_pic_dst->p[i_plane].p_pixels;
+            uint8_t *p_dst = p_pic_dst->p[i_plane].p_pixels
+                           + i_dst_first * i_dst_pitch;
             uint8_t *p_dstendline = p_dst + i_dst_visible_pitch;
-            const uint8_t *p_dstend = p_dst + i_dst_visible_lines*i_dst_pitch;
+            const uint8_t *p_dstend = p_pic_dst->p[i_plane].p_pixels
+                                    + i_dst_last * i_dst_pitch;
 
             const int i_shift_height = i_dst_height / i_src_height;
             const int i_shift_width = i_dst_width / i_src_width;
 
-            int l = 1<<(SHIFT_SIZE-i_shift_height);
+            int l = (1<<(SHIFT_SIZE-i_shift_height)) + i_dst_first * i_height_coef;
             for( ; p_dst < p_dstend;
                  p_dst += i_dst_hidden_pitch,
                  p_dstendline += i_dst_pitch, l += i_height_coef )
@@ -160,8 +168,6 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         const int i_src_width    = p_filter->fmt_in.video.i_width;
         const int i_dst_height   = p_filter->fmt_out.video.i_height;
         const int i_dst_width    = p_filter->fmt_out.video.i_width;
-        const int i_dst_visible_lines =
-                                   p_pic_dst->p->i_visible_lines;
         const int i_dst_visible_pitch =
                                    p_pic_dst->p->i_visible_pitch;
         const int i_dst_hidden_pitch  = i_dst_pitch - i_dst_visible_pitch;
@@ -173,14 +179,15 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         const int i_src_width_1  = i_src_width - 1;
 
         uint32_t *p_src = (uint32_t*)p_pic->p->p_pixels;
-        uint32_t *p_dst = (uint32_t*)p_pic_dst->p->p_pixels;
+        uint32_t *p_dst = (uint32_t*)p_pic_dst->p->p_pixels
+                        + i_first*(i_dst_pitch>>2);
         uint32_t *p_dstendline = p_dst + (i_dst_visible_pitch>>2);
-        const uint32_t *p_dstend = p_dst + i_dst_visible_lines*(i_dst_pitch>>2);
+        const uint32_t *p_dstend = p_dst + i_count*(i_dst_pitch>>2);
 
         const int i_shift_height = i_dst_height / i_src_height;
         const int i_shift_width = i_dst_width / i_src_width;
 
-        int l = 1<<(SHIFT_SIZE-i_shift_height);
+        int l = (1<<(SHIFT_SIZE-i_shift_height)) + i_first * i_height_coef;
         for( ; p_dst < p_dstend;
              p_dst += (i_dst_hidden_pitch>>2),
              p_dstendline += (i_dst_pitch>>2),
@@ -195,6 +202,33 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
             }
         }
     }
+}
+
+/****************************************************************************
+ * Filter: the whole thing
+ ****************************************************************************/
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_pic_dst;
+
+    if( !p_pic ) return NULL;
+
+#warning Converter cannot (really) change output format.
+    video_format_ScaleCropAr( &p_filter->fmt_out.video, &p_filter->fmt_in.video );
+
+    /* Request output picture */
+    p_pic_dst = filter_NewPicture( p_filter );
+    if( !p_pic_dst )
+    {
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    /* Bands of even lines, so that they match whole lines of the
+     * subsampled planes */
+    picture_t *pp_pics[2] = { p_pic, p_pic_dst };
+    filter_RunSlices( p_filter, p_pic_dst->p[0].i_visible_lines, 2,
+                      ScaleSlice, pp_pics );
 
     picture_CopyProperties( p_pic_dst, p_pic );
     picture_Release( p_pic );
@@ -25,6 +25,7 @@
 #include <vlc_common.h>
 #include <vlc_picture_pool.h>
 #include <vlc_opengl.h>
+#include <vlc_atomic.h>
 
 /* if USE_OPENGL_ES2 is defined, OpenGL ES version 2 will be used, otherwise
  * normal OpenGL will be used */
@@ -100,6 +101,7 @@ typedef void (APIENTRY *PFNGLVIEWPORTPROC) (GLint x, GLint y, GLsizei width, GLs
 #   define PFNGLGETPROGRAMINFOLOGPROC        typeof(glGetProgramInfoLog)*
 #   define PFNGLGETSHADERIVPROC              typeof(glGetShaderiv)*
 #   define PFNGLGETSHADERINFOLOGPROC         typeof(glGetShaderInfoLog)*
+#   define PFNGLGETSHADERSOURCEPROC          typeof(glGetShaderSource)*
 #   define PFNGLGETUNIFORMLOCATIONPROC       typeof(glGetUniformLocation)*
 #   define PFNGLGETATTRIBLOCATIONPROC        typeof(glGetAttribLocation)*
 #   define PFNGLVERTEXATTRIBPOINTERPROC      typeof(glVertexAttribPointer)*
@@ -143,6 +145,19 @@ typedef GLboolean (APIENTRY *PFNGLUNMAPBUFFERPROC) (GLenum target);
 typedef GLsync (APIENTRY *PFNGLFENCESYNCPROC) (GLenum condition, GLbitfield flags);
 typedef void (APIENTRY *PFNGLDELETESYNCPROC) (GLsync sync);
 typedef GLenum (APIENTRY *PFNGLCLIENTWAITSYNCPROC) (GLsync sync, GLbitfield flags, GLuint64 timeout);
+typedef void (APIENTRY *PFNGLGETPROGRAMBINARYPROC) (GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void (APIENTRY *PFNGLPROGRAMBINARYPROC) (GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (APIENTRY *PFNGLPROGRAMPARAMETERIPROC) (GLuint program, GLenum pname, GLint value);
+#endif
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+# define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+# define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+# define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
 #endif
 
 /**
@@ -195,6 +210,7 @@ typedef struct {
     PFNGLGETSHADERIVPROC        GetShaderiv;
     PFNGLGETPROGRAMINFOLOGPROC  GetProgramInfoLog;
     PFNGLGETSHADERINFOLOGPROC   GetShaderInfoLog;
+    PFNGLGETSHADERSOURCEPROC    GetShaderSource;
 
     /* Shader variables commands */
     PFNGLGETUNIFORMLOCATIONPROC      GetUniformLocation;
@@ -217,6 +233,11 @@ typedef struct {
     PFNGLUSEPROGRAMPROC    UseProgram;
     PFNGLDELETEPROGRAMPROC DeleteProgram;
 
+    /* Program binaries commands, used to cache linked programs */
+    PFNGLGETPROGRAMBINARYPROC  GetProgramBinary; /* can be NULL */
+    PFNGLPROGRAMBINARYPROC     ProgramBinary; /* can be NULL */
+    PFNGLPROGRAMPARAMETERIPROC ProgramParameteri; /* can be NULL */
+
     /* Texture commands */
     PFNGLACTIVETEXTUREPROC ActiveTexture;
 
@@ -257,6 +278,36 @@ struct pl_context;
 struct pl_shader;
 struct pl_shader_res;
 
+/*
+ * Filters run by the fragment shader while sampling the picture, in place of
+ * the CPU video filters of the same name
+ */
+enum
+{
+    OPENGL_FILTER_ADJUST      = 1 << 0,
+    OPENGL_FILTER_SHARPEN     = 1 << 1,
+    OPENGL_FILTER_DEINTERLACE = 1 << 2,
+};
+
+struct opengl_filters
+{
+    /* OPENGL_FILTER_* mask of the requested filters */
+    unsigned requested;
+
+    /* Parameters, using the ranges of the CPU filters; they can be changed
+     * from any thread while playing */
+    vlc_atomic_float contrast;
+    vlc_atomic_float brightness;
+    vlc_atomic_float hue;
+    vlc_atomic_float saturation;
+    vlc_atomic_float gamma;
+    vlc_atomic_float sharpen_sigma;
+
+    /* Parity of the lines kept by the deinterlacer, -1 for progressive
+     * pictures; only changed from the rendering thread */
+    int field;
+};
+
 /*
  * Structure that is filled by "glhw converter" module probe function
  * The implementation should initialize every members of the struct that are
@@ -281,6 +332,9 @@ struct opengl_tex_converter_t
     /* True to dump shaders, set by the caller */
     bool b_dump_shaders;
 
+    /* Filters to run, set by the caller (can be NULL) */
+    struct opengl_filters *filters;
+
     /* Function pointer to the shader init command, set by the caller, see
      * opengl_fragment_shader_init() documentation. */
     GLuint (*pf_fragment_shader_init)(opengl_tex_converter_t *, GLenum,
@@ -332,10 +386,16 @@ struct opengl_tex_converter_t
         GLint TexSize[PICTURE_PLANE_MAX]; /* for GL_TEXTURE_RECTANGLE */
         GLint Coefficients;
         GLint FillColor;
+        GLint AdjustLuma;
+        GLint SharpenSigma;
+        GLint Field;
         GLint *pl_vars; /* for pl_sh_res */
     } uloc;
     bool yuv_color;
     GLfloat yuv_coefficients[16];
+    GLfloat yuv_range_correction;
+    /* OPENGL_FILTER_* mask of the filters run by the fragment shader */
+    unsigned filters_enabled;
 
     struct pl_shader *pl_sh;
     const struct pl_shader_res *pl_sh_res;
@@ -24,6 +24,7 @@
 
 #include <assert.h>
 #include <limits.h>
+#include <stdio.h>
 #include <stdlib.h>
 
 #include <vlc_common.h>
@@ -159,7 +160,7 @@ pbo_picture_create(const opengl_tex_converter_t *tc, bool direct_rendering)
             picture_Release(pic);
             return NULL;
         }
-        picsys->bytes[i] = (p->i_pitch * p->i_lines) + 15 / 16 * 16;
+        picsys->bytes[i] = ((p->i_pitch * p->i_lines) + 15) / 16 * 16;
     }
     return pic;
 }
@@ -228,6 +229,10 @@ tc_pbo_update(const opengl_tex_converter_t *tc, GLuint *textures,
         const GLvoid *data = pic->p[i].p_pixels;
         tc->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER,
                             display_pic->p_sys->buffers[i]);
+        /* Orphan the previous storage: the upload from the last time this
+         * buffer was used may still be pending, don't wait for it */
+        tc->vt->BufferData(GL_PIXEL_UNPACK_BUFFER, display_pic->p_sys->bytes[i],
+                           NULL, GL_DYNAMIC_DRAW);
         tc->vt->BufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, size, data);
 
         tc->vt->ActiveTexture(GL_TEXTURE0 + i);
@@ -594,9 +599,17 @@ opengl_tex_converter_generic_init(opengl_tex_converter_t *tc, bool allow_dr)
     tc->pf_update            = tc_common_update;
     tc->pf_allocate_textures = tc_common_allocate_textures;
 
+    /* OpenGL ES 3.0 has PBO and GL_UNPACK_ROW_LENGTH in core */
+    const char *glversion = (const char *) tc->vt->GetString(GL_VERSION);
+    unsigned gles_major = 0;
+    if (tc->is_gles && glversion != NULL
+     && sscanf(glversion, "OpenGL ES %u", &gles_major) != 1)
+        gles_major = 0;
+    const bool is_gles3 = gles_major >= 3;
+
     /* OpenGL or OpenGL ES2 with GL_EXT_unpack_subimage ext */
-    priv->has_unpack_subimage =
-        !tc->is_gles || HasExtension(tc->glexts, "GL_EXT_unpack_subimage");
+    priv->has_unpack_subimage = !tc->is_gles || is_gles3
+        || HasExtension(tc->glexts, "GL_EXT_unpack_subimage");
 
     if (allow_dr)
     {
@@ -617,11 +630,11 @@ opengl_tex_converter_generic_init(opengl_tex_converter_t *tc, bool allow_dr)
          * Indeed, persistent mapped buffers or PBO seems to be slow with
          * OpenGL 2.1 drivers and bellow. This may be caused by OpenGL
          * compatibility layer. */
-        const unsigned char *ogl_version = tc->vt->GetString(GL_VERSION);
-        const bool glver_ok = strverscmp((const char *)ogl_version, "3.0") >= 0;
+        const bool glver_ok = tc->is_gles ? is_gles3
+                            : strverscmp(glversion, "3.0") >= 0;
 
-        const bool has_pbo = glver_ok &&
-            (HasExtension(tc->glexts, "GL_ARB_pixel_buffer_object") ||
+        const bool has_pbo = glver_ok && (is_gles3 ||
+             HasExtension(tc->glexts, "GL_ARB_pixel_buffer_object") ||
              HasExtension(tc->glexts, "GL_EXT_pixel_buffer_object"));
 
         const bool has_bs = has_pbo &&
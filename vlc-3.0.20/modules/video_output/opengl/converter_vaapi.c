@@ -73,8 +73,9 @@ struct priv
         VADRMPRIMESurfaceDescriptor va_surface_descriptor;
 #else
         VABufferInfo                va_buffer_info;
-#endif
         VAImage                     va_image;
+#endif
+        unsigned                    num_planes;
         void *                      egl_images[3];
     } last;
 };
@@ -106,22 +107,55 @@ vaegl_image_destroy(const opengl_tex_converter_t *tc, EGLImageKHR image)
     tc->gl->egl.destroyImageKHR(tc->gl, image);
 }
 
+#if VA_CHECK_VERSION(1, 1, 0)
+/* Exports the surface as one dmabuf layer per plane, so that each plane
+ * is imported as its own texture, with the surface tiling/compression
+ * modifier. Unlike vaDeriveImage(), this never maps nor detiles the
+ * surface, and it works with drivers that cannot derive images. */
+static int
+vaegl_export_surface(const opengl_tex_converter_t *tc, VASurfaceID surface,
+                     VADRMPRIMESurfaceDescriptor *desc)
+{
+    const struct priv *priv = tc->priv;
+
+    if (vlc_vaapi_ExportSurfaceHandle(VLC_OBJECT(tc->gl), priv->vadpy, surface,
+                                      VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME_2,
+                                      VA_EXPORT_SURFACE_READ_ONLY |
+                                      VA_EXPORT_SURFACE_SEPARATE_LAYERS,
+                                      desc))
+        return VLC_EGENERIC;
+
+    if (desc->num_layers == 0 || desc->num_layers > 3)
+    {
+        for (unsigned i = 0; i < desc->num_objects; ++i)
+            close(desc->objects[i].fd);
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
 static void
-vaegl_release_last_pic(const opengl_tex_converter_t *tc, struct priv *priv)
+vaegl_close_surface(const VADRMPRIMESurfaceDescriptor *desc)
 {
-    vlc_object_t *o = VLC_OBJECT(tc->gl);
+    for (unsigned i = 0; i < desc->num_objects; ++i)
+        close(desc->objects[i].fd);
+}
+#endif
 
-    for (unsigned i = 0; i < priv->last.va_image.num_planes; ++i)
+static void
+vaegl_release_last_pic(const opengl_tex_converter_t *tc, struct priv *priv)
+{
+    for (unsigned i = 0; i < priv->last.num_planes; ++i)
         vaegl_image_destroy(tc, priv->last.egl_images[i]);
 
 #if VA_CHECK_VERSION(1, 1, 0)
-    for (unsigned i = 0; i < priv->last.va_surface_descriptor.num_objects; ++i)
-        close(priv->last.va_surface_descriptor.objects[i].fd);
+    vaegl_close_surface(&priv->last.va_surface_descriptor);
 #else
-    vlc_vaapi_ReleaseBufferHandle(o, priv->vadpy, priv->last.va_image.buf);
-#endif
+    vlc_object_t *o = VLC_OBJECT(tc->gl);
 
+    vlc_vaapi_ReleaseBufferHandle(o, priv->vadpy, priv->last.va_image.buf);
     vlc_vaapi_DestroyImage(o, priv->vadpy, priv->last.va_image.image_id);
+#endif
 
     picture_Release(priv->last.pic);
 }
@@ -174,6 +208,7 @@ vaegl_init_fourcc(const opengl_tex_converter_t *tc, struct priv *priv,
     return VLC_SUCCESS;
 }
 
+#if VA_CHECK_VERSION(1, 1, 0)
 static int
 tc_vaegl_update(const opengl_tex_converter_t *tc, GLuint *textures,
                 const GLsizei *tex_width, const GLsizei *tex_height,
@@ -181,58 +216,29 @@ tc_vaegl_update(const opengl_tex_converter_t *tc, GLuint *textures,
 {
     (void) plane_offset;
     struct priv *priv = tc->priv;
-    vlc_object_t *o = VLC_OBJECT(tc->gl);
-    VAImage va_image;
-#if VA_CHECK_VERSION(1, 1, 0)
     VADRMPRIMESurfaceDescriptor va_surface_descriptor;
-#else
-    VABufferInfo va_buffer_info;
-#endif
     EGLImageKHR egl_images[3] = { };
-    bool release_image = false, release_buffer_info = false;
 
     if (pic == priv->last.pic)
     {
-        va_image = priv->last.va_image;
-#if VA_CHECK_VERSION(1, 1, 0)
-        va_surface_descriptor = priv->last.va_surface_descriptor;
-#endif
-        for (unsigned i = 0; i < priv->last.va_image.num_planes; ++i)
-            egl_images[i] = priv->last.egl_images[i];
+        for (unsigned i = 0; i < priv->last.num_planes; ++i)
+        {
+            tc->vt->BindTexture(tc->tex_target, textures[i]);
+            priv->glEGLImageTargetTexture2DOES(tc->tex_target,
+                                               priv->last.egl_images[i]);
+        }
+        return VLC_SUCCESS;
     }
-    else
-    {
-        if (vlc_vaapi_DeriveImage(o, priv->vadpy, vlc_vaapi_PicGetSurface(pic),
-                                  &va_image))
-            goto error;
-        release_image = true;
 
-        assert(va_image.format.fourcc == priv->fourcc);
-
-#if VA_CHECK_VERSION(1, 1, 0)
-        if (vlc_vaapi_ExportSurfaceHandle(o, priv->vadpy, vlc_vaapi_PicGetSurface(pic),
-                                          VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME_2, 0,
-                                          &va_surface_descriptor))
-            goto error;
-#else
-        va_buffer_info = (VABufferInfo) {
-            .mem_type = VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME
-        };
-        if (vlc_vaapi_AcquireBufferHandle(o, priv->vadpy, va_image.buf,
-                                          &va_buffer_info))
-            goto error;
-#endif
-        release_buffer_info = true;
-    }
+    if (vaegl_export_surface(tc, vlc_vaapi_PicGetSurface(pic),
+                             &va_surface_descriptor))
+        return VLC_EGENERIC;
 
-#if VA_CHECK_VERSION(1, 1, 0)
     for (unsigned i = 0; i < va_surface_descriptor.num_layers; ++i)
     {
         unsigned obj_idx = va_surface_descriptor.layers[i].object_index[0];
 
-        /* Since we don't ask for composite object through
-         * vaExportSurfaceHandle, we shouldn't get any multiplane
-         * layer. */
+        /* Layers are exported separately: one plane each */
         if (va_surface_descriptor.layers[i].num_planes > 1)
           goto error;
 
@@ -250,22 +256,79 @@ tc_vaegl_update(const opengl_tex_converter_t *tc, GLuint *textures,
 
         priv->glEGLImageTargetTexture2DOES(tc->tex_target, egl_images[i]);
     }
+
+    if (priv->last.pic != NULL)
+        vaegl_release_last_pic(tc, priv);
+    priv->last.pic = picture_Hold(pic);
+    priv->last.va_surface_descriptor = va_surface_descriptor;
+    priv->last.num_planes = va_surface_descriptor.num_layers;
+    for (unsigned i = 0; i < va_surface_descriptor.num_layers; ++i)
+        priv->last.egl_images[i] = egl_images[i];
+
+    return VLC_SUCCESS;
+
+error:
+    for (unsigned i = 0; i < 3 && egl_images[i] != NULL; ++i)
+        vaegl_image_destroy(tc, egl_images[i]);
+    vaegl_close_surface(&va_surface_descriptor);
+    return VLC_EGENERIC;
+}
 #else
+static int
+tc_vaegl_update(const opengl_tex_converter_t *tc, GLuint *textures,
+                const GLsizei *tex_width, const GLsizei *tex_height,
+                picture_t *pic, const size_t *plane_offset)
+{
+    (void) plane_offset;
+    struct priv *priv = tc->priv;
+    vlc_object_t *o = VLC_OBJECT(tc->gl);
+    VAImage va_image;
+    VABufferInfo va_buffer_info;
+    EGLImageKHR egl_images[3] = { };
+    bool release_image = false, release_buffer_info = false;
+
+    if (pic == priv->last.pic)
+    {
+        va_image = priv->last.va_image;
+        va_buffer_info = priv->last.va_buffer_info;
+        for (unsigned i = 0; i < priv->last.va_image.num_planes; ++i)
+            egl_images[i] = priv->last.egl_images[i];
+    }
+    else
+    {
+        if (vlc_vaapi_DeriveImage(o, priv->vadpy, vlc_vaapi_PicGetSurface(pic),
+                                  &va_image))
+            goto error;
+        release_image = true;
+
+        assert(va_image.format.fourcc == priv->fourcc);
+
+        va_buffer_info = (VABufferInfo) {
+            .mem_type = VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME
+        };
+        if (vlc_vaapi_AcquireBufferHandle(o, priv->vadpy, va_image.buf,
+                                          &va_buffer_info))
+            goto error;
+        release_buffer_info = true;
+    }
+
     for (unsigned i = 0; i < va_image.num_planes; ++i)
     {
-        egl_images[i] =
-            vaegl_image_create(tc, tex_width[i], tex_height[i],
-                               priv->drm_fourccs[i], va_buffer_info.handle,
-                               va_image.offsets[i], va_image.pitches[i],
-                               DRM_FORMAT_MOD_INVALID);
         if (egl_images[i] == NULL)
-            goto error;
+        {
+            egl_images[i] =
+                vaegl_image_create(tc, tex_width[i], tex_height[i],
+                                   priv->drm_fourccs[i], va_buffer_info.handle,
+                                   va_image.offsets[i], va_image.pitches[i],
+                                   DRM_FORMAT_MOD_INVALID);
+            if (egl_images[i] == NULL)
+                goto error;
+        }
 
         tc->vt->BindTexture(tc->tex_target, textures[i]);
 
         priv->glEGLImageTargetTexture2DOES(tc->tex_target, egl_images[i]);
     }
-#endif
 
     if (pic != priv->last.pic)
     {
@@ -273,11 +336,8 @@ tc_vaegl_update(const opengl_tex_converter_t *tc, GLuint *textures,
             vaegl_release_last_pic(tc, priv);
         priv->last.pic = picture_Hold(pic);
         priv->last.va_image = va_image;
-#if VA_CHECK_VERSION(1, 1, 0)
-        priv->last.va_surface_descriptor = va_surface_descriptor;
-#else
         priv->last.va_buffer_info = va_buffer_info;
-#endif
+        priv->last.num_planes = va_image.num_planes;
 
         for (unsigned i = 0; i < va_image.num_planes; ++i)
             priv->last.egl_images[i] = egl_images[i];
@@ -289,14 +349,7 @@ error:
     if (release_image)
     {
         if (release_buffer_info)
-        {
-#if VA_CHECK_VERSION(1, 1, 0)
-            for (unsigned i = 0; i < va_surface_descriptor.num_objects; ++i)
-                close(va_surface_descriptor.objects[i].fd);
-#else
             vlc_vaapi_ReleaseBufferHandle(o, priv->vadpy, va_image.buf);
-#endif
-        }
 
         for (unsigned i = 0; i < 3 && egl_images[i] != NULL; ++i)
             vaegl_image_destroy(tc, egl_images[i]);
@@ -305,6 +358,7 @@ error:
     }
     return VLC_EGENERIC;
 }
+#endif
 
 static picture_pool_t *
 tc_vaegl_get_pool(const opengl_tex_converter_t *tc, unsigned requested_count)
@@ -319,9 +373,38 @@ tc_vaegl_get_pool(const opengl_tex_converter_t *tc, unsigned requested_count)
     if (!pool)
         return NULL;
 
-    /* Check if a surface from the pool can be derived and displayed via dmabuf
-     * */
+    /* Check if a surface from the pool can be exported and displayed via
+     * dmabuf */
     bool success = false;
+#if VA_CHECK_VERSION(1, 1, 0)
+    VADRMPRIMESurfaceDescriptor va_surface_descriptor;
+    if (vaegl_export_surface(tc, priv->va_surface_ids[0], &va_surface_descriptor))
+        goto error;
+
+    success = true;
+    for (unsigned i = 0; i < va_surface_descriptor.num_layers && success; ++i)
+    {
+        unsigned obj_idx = va_surface_descriptor.layers[i].object_index[0];
+        EGLint w = (va_surface_descriptor.width * tc->texs[i].w.num) / tc->texs[i].w.den;
+        EGLint h = (va_surface_descriptor.height * tc->texs[i].h.num) / tc->texs[i].h.den;
+        EGLImageKHR egl_image =
+            vaegl_image_create(tc, w, h, priv->drm_fourccs[i],
+                               va_surface_descriptor.objects[obj_idx].fd,
+                               va_surface_descriptor.layers[i].offset[0],
+                               va_surface_descriptor.layers[i].pitch[0],
+                               va_surface_descriptor.objects[obj_idx].drm_format_modifier);
+        if (egl_image == NULL)
+        {
+            msg_Warn(o, "Can't create Image KHR: kernel too old ?");
+            success = false;
+        }
+        else
+            vaegl_image_destroy(tc, egl_image);
+    }
+    vaegl_close_surface(&va_surface_descriptor);
+
+error:
+#else
     VAImage va_image = { .image_id = VA_INVALID_ID };
     if (vlc_vaapi_DeriveImage(o, priv->vadpy, priv->va_surface_ids[0],
                               &va_image))
@@ -360,6 +443,7 @@ error:
             vlc_vaapi_ReleaseBufferHandle(o, priv->vadpy, va_image.buf);
         vlc_vaapi_DestroyImage(o, priv->vadpy, va_image.image_id);
     }
+#endif
     if (!success)
     {
         picture_pool_Release(pool);
@@ -382,9 +466,15 @@ Close(vlc_object_t *obj)
     free(tc->priv);
 }
 
+/* Only applies to the vaDeriveImage() import: surfaces exported with their
+ * modifiers are handled fine by these drivers */
 static int
 tc_va_check_interop_blacklist(opengl_tex_converter_t *tc, VADisplay *vadpy)
 {
+#if VA_CHECK_VERSION(1, 1, 0)
+    VLC_UNUSED(tc); VLC_UNUSED(vadpy);
+    return VLC_SUCCESS;
+#else
     const char *vendor = vaQueryVendorString(vadpy);
     if (vendor == NULL)
         return VLC_SUCCESS;
@@ -409,6 +499,7 @@ tc_va_check_interop_blacklist(opengl_tex_converter_t *tc, VADisplay *vadpy)
     }
 
     return VLC_SUCCESS;
+#endif
 }
 
 #ifdef HAVE_VA_X11
@@ -23,6 +23,7 @@
 #endif
 
 #include <assert.h>
+#include <math.h>
 #include <stdlib.h>
 
 #ifdef HAVE_LIBPLACEBO
@@ -290,6 +291,7 @@ tc_yuv_base_init(opengl_tex_converter_t *tc, GLenum tex_target,
     }
 
     tc->yuv_color = true;
+    tc->yuv_range_correction = yuv_range_correction;
 
     *swap_uv = chroma == VLC_CODEC_YV12 || chroma == VLC_CODEC_YV9 ||
                chroma == VLC_CODEC_NV21;
@@ -326,6 +328,18 @@ tc_rgb_base_init(opengl_tex_converter_t *tc, GLenum tex_target,
     return VLC_SUCCESS;
 }
 
+/* Filters sampling neighbour texels need the size of the textures, that is
+ * otherwise only used with rectangle textures */
+static bool
+tc_needs_tex_size(const opengl_tex_converter_t *tc, unsigned tex_idx)
+{
+    if (tc->tex_target == GL_TEXTURE_RECTANGLE)
+        return true;
+    if (tc->filters_enabled & OPENGL_FILTER_DEINTERLACE)
+        return true;
+    return tex_idx == 0 && (tc->filters_enabled & OPENGL_FILTER_SHARPEN);
+}
+
 static int
 tc_base_fetch_locations(opengl_tex_converter_t *tc, GLuint program)
 {
@@ -344,7 +358,7 @@ tc_base_fetch_locations(opengl_tex_converter_t *tc, GLuint program)
         tc->uloc.Texture[i] = tc->vt->GetUniformLocation(program, name);
         if (tc->uloc.Texture[i] == -1)
             return VLC_EGENERIC;
-        if (tc->tex_target == GL_TEXTURE_RECTANGLE)
+        if (tc_needs_tex_size(tc, i))
         {
             snprintf(name, sizeof(name), "TexSize%1u", i);
             tc->uloc.TexSize[i] = tc->vt->GetUniformLocation(program, name);
@@ -357,6 +371,26 @@ tc_base_fetch_locations(opengl_tex_converter_t *tc, GLuint program)
     if (tc->uloc.FillColor == -1)
         return VLC_EGENERIC;
 
+    if (tc->filters_enabled & OPENGL_FILTER_ADJUST)
+    {
+        tc->uloc.AdjustLuma = tc->vt->GetUniformLocation(program, "AdjustLuma");
+        if (tc->uloc.AdjustLuma == -1)
+            return VLC_EGENERIC;
+    }
+    if (tc->filters_enabled & OPENGL_FILTER_SHARPEN)
+    {
+        tc->uloc.SharpenSigma = tc->vt->GetUniformLocation(program,
+                                                            "SharpenSigma");
+        if (tc->uloc.SharpenSigma == -1)
+            return VLC_EGENERIC;
+    }
+    if (tc->filters_enabled & OPENGL_FILTER_DEINTERLACE)
+    {
+        tc->uloc.Field = tc->vt->GetUniformLocation(program, "Field");
+        if (tc->uloc.Field == -1)
+            return VLC_EGENERIC;
+    }
+
 #ifdef HAVE_LIBPLACEBO
     const struct pl_shader_res *res = tc->pl_sh_res;
     for (int i = 0; res && i < res->num_variables; i++) {
@@ -368,6 +402,42 @@ tc_base_fetch_locations(opengl_tex_converter_t *tc, GLuint program)
     return VLC_SUCCESS;
 }
 
+/* Same formulas as the adjust video filter: the luma is scaled around the
+ * middle grey then gamma corrected by the shader, the chroma is rotated by
+ * the hue and scaled by the saturation through the conversion coefficients
+ * (so it is not clipped before the conversion) */
+static void
+tc_adjust_prepare_shader(const opengl_tex_converter_t *tc)
+{
+    struct opengl_filters *filters = tc->filters;
+    const float contrast = vlc_atomic_load_float(&filters->contrast);
+    const float brightness = vlc_atomic_load_float(&filters->brightness);
+    const float hue = vlc_atomic_load_float(&filters->hue)
+                    * (float)(M_PI / 180.);
+    const float saturation = vlc_atomic_load_float(&filters->saturation);
+    const float gamma = vlc_atomic_load_float(&filters->gamma);
+    const float range = tc->yuv_range_correction;
+
+    tc->vt->Uniform4f(tc->uloc.AdjustLuma, contrast * range,
+                      brightness - .5f - contrast / 2.f,
+                      1.f / VLC_CLIP(gamma, .01f, 10.f), 1.f / range);
+
+    const float a = saturation * cosf(hue);
+    const float b = saturation * sinf(hue);
+    const GLfloat *in = tc->yuv_coefficients;
+    GLfloat coefficients[16];
+    for (unsigned j = 0; j < 4; ++j)
+    {
+        coefficients[j] = in[j];
+        coefficients[4 + j] = a * in[4 + j] - b * in[8 + j];
+        coefficients[8 + j] = b * in[4 + j] + a * in[8 + j];
+        coefficients[12 + j] = in[12 + j]
+            + ((.5f - .5f * a - .5f * b) * in[4 + j]
+             + (.5f - .5f * a + .5f * b) * in[8 + j]) / range;
+    }
+    tc->vt->Uniform4fv(tc->uloc.Coefficients, 4, coefficients);
+}
+
 static void
 tc_base_prepare_shader(const opengl_tex_converter_t *tc,
                        const GLsizei *tex_width, const GLsizei *tex_height,
@@ -375,7 +445,9 @@ tc_base_prepare_shader(const opengl_tex_converter_t *tc,
 {
     (void) tex_width; (void) tex_height;
 
-    if (tc->yuv_color)
+    if (tc->filters_enabled & OPENGL_FILTER_ADJUST)
+        tc_adjust_prepare_shader(tc);
+    else if (tc->yuv_color)
         tc->vt->Uniform4fv(tc->uloc.Coefficients, 4, tc->yuv_coefficients);
 
     for (unsigned i = 0; i < tc->tex_count; ++i)
@@ -383,12 +455,17 @@ tc_base_prepare_shader(const opengl_tex_converter_t *tc,
 
     tc->vt->Uniform4f(tc->uloc.FillColor, 1.0f, 1.0f, 1.0f, alpha);
 
-    if (tc->tex_target == GL_TEXTURE_RECTANGLE)
-    {
-        for (unsigned i = 0; i < tc->tex_count; ++i)
+    for (unsigned i = 0; i < tc->tex_count; ++i)
+        if (tc_needs_tex_size(tc, i))
             tc->vt->Uniform2f(tc->uloc.TexSize[i], tex_width[i],
                                tex_height[i]);
-    }
+
+    if (tc->filters_enabled & OPENGL_FILTER_SHARPEN)
+        tc->vt->Uniform1f(tc->uloc.SharpenSigma,
+            VLC_CLIP(vlc_atomic_load_float(&tc->filters->sharpen_sigma),
+                     0.f, 2.f));
+    if (tc->filters_enabled & OPENGL_FILTER_DEINTERLACE)
+        tc->vt->Uniform1f(tc->uloc.Field, tc->filters->field);
 
 #ifdef HAVE_LIBPLACEBO
     const struct pl_shader_res *res = tc->pl_sh_res;
@@ -567,6 +644,7 @@ opengl_fragment_shader_init_impl(opengl_tex_converter_t *tc, GLenum tex_target,
     if (desc == NULL)
         return VLC_EGENERIC;
 
+    tc->filters_enabled = 0;
     if (chroma == VLC_CODEC_XYZ12)
         return xyz12_shader_init(tc);
 
@@ -579,6 +657,20 @@ opengl_fragment_shader_init_impl(opengl_tex_converter_t *tc, GLenum tex_target,
     if (ret != VLC_SUCCESS)
         return 0;
 
+    if (tc->filters != NULL)
+    {
+        unsigned supported = OPENGL_FILTER_DEINTERLACE;
+        if (is_yuv)
+        {
+            supported |= OPENGL_FILTER_ADJUST;
+            /* The luma must be alone in the first texture */
+            if (tc->tex_count > 1)
+                supported |= OPENGL_FILTER_SHARPEN;
+        }
+        tc->filters_enabled = tc->filters->requested & supported;
+    }
+    tc->tex_target = tex_target;
+
     const char *sampler, *lookup, *coord_name;
     switch (tex_target)
     {
@@ -694,14 +786,75 @@ opengl_fragment_shader_init_impl(opengl_tex_converter_t *tc, GLenum tex_target,
     }
 #endif
 
-    if (tex_target == GL_TEXTURE_RECTANGLE)
-    {
-        for (unsigned i = 0; i < tc->tex_count; ++i)
+    for (unsigned i = 0; i < tc->tex_count; ++i)
+        if (tc_needs_tex_size(tc, i))
             ADDF("uniform vec2 TexSize%u;\n", i);
-    }
 
     if (is_yuv)
         ADD("uniform vec4 Coefficients[4];\n");
+    if (tc->filters_enabled & OPENGL_FILTER_ADJUST)
+        ADD("uniform vec4 AdjustLuma;\n");
+    if (tc->filters_enabled & OPENGL_FILTER_SHARPEN)
+        ADD("uniform float SharpenSigma;\n");
+    if (tc->filters_enabled & OPENGL_FILTER_DEINTERLACE)
+        ADD("uniform float Field;\n");
+
+    /* Filters sampling the textures: each one wraps the fetch function of the
+     * previous one */
+    char fetch[PICTURE_PLANE_MAX][48];
+    for (unsigned i = 0; i < tc->tex_count; ++i)
+    {
+        snprintf(fetch[i], sizeof(fetch[i]), "%s(Texture%u, ", lookup, i);
+
+        if (tc->filters_enabled & OPENGL_FILTER_DEINTERLACE)
+        {
+            /* Keep the lines of the first field and interpolate the other
+             * ones, like the linear CPU deinterlacer, before scaling */
+            char height[24];
+            if (tex_target == GL_TEXTURE_RECTANGLE)
+                strcpy(height, "1.0");
+            else
+                snprintf(height, sizeof(height), "TexSize%1u.y", i);
+
+            ADDF("vec4 vlc_line%u(float x, float line) {\n"
+                 " return %s(Texture%u, vec2(x, (line + 0.5) / %s));\n"
+                 "}\n", i, lookup, i, height);
+            ADDF("vec4 vlc_field_line%u(float x, float line) {\n"
+                 " if (mod(line, 2.0) == Field)\n"
+                 "  return vlc_line%u(x, line);\n"
+                 " return 0.5 * (vlc_line%u(x, line - 1.0)"
+                 " + vlc_line%u(x, line + 1.0));\n"
+                 "}\n", i, i, i, i);
+            ADDF("vec4 vlc_deinterlace%u(vec2 coords) {\n"
+                 " if (Field < 0.0)\n"
+                 "  return %s(Texture%u, coords);\n"
+                 " float y = coords.y * %s - 0.5;\n"
+                 " float line = floor(y);\n"
+                 " return mix(vlc_field_line%u(coords.x, line),"
+                 " vlc_field_line%u(coords.x, line + 1.0), y - line);\n"
+                 "}\n", i, lookup, i, height, i, i);
+            snprintf(fetch[i], sizeof(fetch[i]), "vlc_deinterlace%u(", i);
+        }
+    }
+
+    if (tc->filters_enabled & OPENGL_FILTER_SHARPEN)
+    {
+        /* Same kernel as the sharpen CPU filter, on the luma only */
+        const char *f = fetch[0];
+        ADDF("vec4 vlc_sharpen0(vec2 coords) {\n"
+             " vec2 d = vec2(1.0) / %s;\n"
+             " vec4 p = %scoords);\n"
+             " vec4 n = %scoords - d) + %scoords + vec2(0.0, -d.y))"
+             " + %scoords + vec2(d.x, -d.y)) + %scoords + vec2(-d.x, 0.0))"
+             " + %scoords + vec2(d.x, 0.0)) + %scoords + vec2(-d.x, d.y))"
+             " + %scoords + vec2(0.0, d.y)) + %scoords + d);\n"
+             " return clamp(p + clamp(8.0 * p - n, -1.0, 1.0) * SharpenSigma,"
+             " 0.0, 1.0);\n"
+             "}\n", tex_target == GL_TEXTURE_RECTANGLE ? "vec2(1.0)"
+                                                       : "TexSize0",
+             f, f, f, f, f, f, f, f, f);
+        strcpy(fetch[0], "vlc_sharpen0(");
+    }
 
     ADD("uniform vec4 FillColor;\n"
         "void main(void) {\n"
@@ -721,7 +874,7 @@ opengl_fragment_shader_init_impl(opengl_tex_converter_t *tc, GLenum tex_target,
         if (swizzle)
         {
             size_t swizzle_count = strlen(swizzle);
-            ADDF(" colors = %s(Texture%u, %s%u);\n", lookup, i, coord_name, i);
+            ADDF(" colors = %s%s%u);\n", fetch[i], coord_name, i);
             for (unsigned j = 0; j < swizzle_count; ++j)
             {
                 ADDF(" val = colors.%c;\n"
@@ -733,8 +886,8 @@ opengl_fragment_shader_init_impl(opengl_tex_converter_t *tc, GLenum tex_target,
         }
         else
         {
-            ADDF(" vec4 color%u = %s(Texture%u, %s%u);\n",
-                 color_idx, lookup, i, coord_name, i);
+            ADDF(" vec4 color%u = %s%s%u);\n",
+                 color_idx, fetch[i], coord_name, i);
             color_idx++;
             assert(color_idx <= PICTURE_PLANE_MAX);
         }
@@ -742,6 +895,10 @@ opengl_fragment_shader_init_impl(opengl_tex_converter_t *tc, GLenum tex_target,
     unsigned color_count = color_idx;
     assert(yuv_space == COLOR_SPACE_UNDEF || color_count == 3);
 
+    if (tc->filters_enabled & OPENGL_FILTER_ADJUST)
+        ADD(" color0 = vec4(pow(clamp(color0.x * AdjustLuma.x + AdjustLuma.y,"
+            " 0.0, 1.0), AdjustLuma.z) * AdjustLuma.w);\n");
+
     if (is_yuv)
         ADD(" vec4 result = (color0 * Coefficients[0]) + Coefficients[3];\n");
     else
@@ -796,8 +953,6 @@ opengl_fragment_shader_init_impl(opengl_tex_converter_t *tc, GLenum tex_target,
                 (const char *)&chroma, yuv_space, ms.ptr);
     free(ms.ptr);
 
-    tc->tex_target = tex_target;
-
     tc->pf_fetch_locations = tc_base_fetch_locations;
     tc->pf_prepare_shader = tc_base_prepare_shader;
 
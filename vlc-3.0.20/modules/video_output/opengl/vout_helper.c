@@ -31,6 +31,7 @@
 
 #include <assert.h>
 #include <math.h>
+#include <sys/stat.h>
 
 #include <vlc_common.h>
 #include <vlc_picture_pool.h>
@@ -40,6 +41,8 @@
 #include <vlc_modules.h>
 #include <vlc_vout.h>
 #include <vlc_viewpoint.h>
+#include <vlc_fs.h>
+#include <vlc_md5.h>
 
 #include "vout_helper.h"
 #include "internal.h"
@@ -91,6 +94,12 @@ typedef struct {
 
     float    tex_width;
     float    tex_height;
+
+    /* Content of the texture, kept to skip the upload of unchanged regions */
+    picture_t *picture;
+    size_t   pixels_offset;
+    unsigned visible_width;
+    unsigned visible_height;
 } gl_region_t;
 
 struct prgm
@@ -162,6 +171,9 @@ struct vout_display_opengl_t {
     /* Non-power-of-2 texture size support */
     bool supports_npot;
 
+    /* Linked programs are cached on disk */
+    bool program_cache;
+
     /* View point */
     float f_teta;
     float f_phi;
@@ -171,6 +183,10 @@ struct vout_display_opengl_t {
     float f_z;    /* Position of the camera on the shpere radius vector */
     float f_z_min;
     float f_sar;
+
+    /* Filters run by the main program */
+    struct opengl_filters filters;
+    vlc_object_t *filters_obj; /* object holding their parameters */
 };
 
 static const GLfloat identity[] = {
@@ -361,8 +377,8 @@ static inline GLsizei GetAlignedSize(unsigned size)
     return ((align >> 1) == size) ? size : align;
 }
 
-static GLuint BuildVertexShader(const opengl_tex_converter_t *tc,
-                                unsigned plane_count)
+static char *BuildVertexShaderCode(const opengl_tex_converter_t *tc,
+                                   unsigned plane_count)
 {
     /* Basic vertex shader */
     static const char *template =
@@ -395,15 +411,19 @@ static GLuint BuildVertexShader(const opengl_tex_converter_t *tc,
     char *code;
     if (asprintf(&code, template, tc->glsl_version, coord1_header, coord2_header,
                  coord1_code, coord2_code) < 0)
-        return 0;
+        return NULL;
+    return code;
+}
 
+static GLuint BuildVertexShader(const opengl_tex_converter_t *tc,
+                                const char *code)
+{
     GLuint shader = tc->vt->CreateShader(GL_VERTEX_SHADER);
-    tc->vt->ShaderSource(shader, 1, (const char **) &code, NULL);
+    tc->vt->ShaderSource(shader, 1, &code, NULL);
     if (tc->b_dump_shaders)
         msg_Dbg(tc->gl, "\n=== Vertex shader for fourcc: %4.4s ===\n%s\n",
                 (const char *)&tc->fmt.i_chroma, code);
     tc->vt->CompileShader(shader);
-    free(code);
     return shader;
 }
 
@@ -450,12 +470,173 @@ DelTextures(const opengl_tex_converter_t *tc, GLuint *textures)
     memset(textures, 0, tc->tex_count * sizeof(GLuint));
 }
 
+/*
+ * Compiling and linking the shaders can take hundreds of milliseconds with
+ * some GLES drivers, so the linked programs are stored in the user cache
+ * directory. They are keyed by the driver and the shader sources, which
+ * depend on the chroma and the options.
+ */
+#define PROGRAM_CACHE_DIR "glprograms"
+#define PROGRAM_CACHE_MAX_SIZE (4 << 20)
+
+static char *
+ProgramCacheGetPath(const opengl_tex_converter_t *tc, const char *vertex_code)
+{
+    static const GLenum driver_strings[] = {
+        GL_VENDOR, GL_RENDERER, GL_VERSION,
+    };
+    struct md5_s md5;
+
+    InitMD5(&md5);
+    for (size_t i = 0; i < ARRAY_SIZE(driver_strings); i++)
+    {
+        const char *str = (const char *) tc->vt->GetString(driver_strings[i]);
+        if (str == NULL)
+            return NULL;
+        AddMD5(&md5, str, strlen(str) + 1);
+    }
+    AddMD5(&md5, vertex_code, strlen(vertex_code) + 1);
+
+    GLint length = 0;
+    tc->vt->GetShaderiv(tc->fshader, GL_SHADER_SOURCE_LENGTH, &length);
+    if (length <= 0)
+        return NULL;
+    char *fragment_code = malloc(length);
+    if (fragment_code == NULL)
+        return NULL;
+    tc->vt->GetShaderSource(tc->fshader, length, NULL, fragment_code);
+    AddMD5(&md5, fragment_code, length);
+    free(fragment_code);
+    EndMD5(&md5);
+
+    char *hash = psz_md5_hash(&md5);
+    char *cachedir = config_GetUserDir(VLC_CACHE_DIR);
+    char *path;
+    if (hash == NULL || cachedir == NULL
+     || asprintf(&path, "%s"DIR_SEP PROGRAM_CACHE_DIR DIR_SEP"%s.bin",
+                 cachedir, hash) < 0)
+        path = NULL;
+    free(cachedir);
+    free(hash);
+    return path;
+}
+
+/* Returns a linked program, or 0 if not cached or rejected by the driver */
+static GLuint
+ProgramCacheLoad(const opengl_tex_converter_t *tc, const char *path)
+{
+    FILE *file = vlc_fopen(path, "rb");
+    if (file == NULL)
+        return 0;
+
+    GLuint program = 0;
+    uint32_t format;
+    struct stat st;
+    if (fstat(fileno(file), &st) == 0
+     && st.st_size > (off_t)sizeof (format)
+     && st.st_size <= PROGRAM_CACHE_MAX_SIZE
+     && fread(&format, sizeof (format), 1, file) == 1)
+    {
+        size_t size = st.st_size - sizeof (format);
+        void *binary = malloc(size);
+        if (binary != NULL && fread(binary, 1, size, file) == size)
+        {
+            GLint link_status = GL_FALSE;
+            program = tc->vt->CreateProgram();
+            tc->vt->ProgramBinary(program, format, binary, size);
+            tc->vt->GetProgramiv(program, GL_LINK_STATUS, &link_status);
+            if (link_status == GL_FALSE)
+            {
+                tc->vt->DeleteProgram(program);
+                program = 0;
+            }
+        }
+        free(binary);
+    }
+    fclose(file);
+
+    if (program == 0)
+    {
+        /* Stale or corrupted: it will be replaced once linked again */
+        msg_Dbg(tc->gl, "discarding cached program %s", path);
+        vlc_unlink(path);
+    }
+    return program;
+}
+
+static void
+ProgramCacheStore(const opengl_tex_converter_t *tc, GLuint program,
+                  const char *path)
+{
+    GLint size = 0;
+    tc->vt->GetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+    if (size <= 0 || size > PROGRAM_CACHE_MAX_SIZE)
+        return;
+
+    void *binary = malloc(size);
+    if (binary == NULL)
+        return;
+
+    GLsizei length = 0;
+    GLenum glformat;
+    tc->vt->GetProgramBinary(program, size, &length, &glformat, binary);
+
+    char *dir = strdup(path);
+    char *tmp;
+    if (length <= 0 || dir == NULL
+     || asprintf(&tmp, "%s.%p.tmp", path, (void *)tc) < 0)
+        goto end;
+
+    /* Write to a temporary file so that concurrent vouts never load a
+     * truncated binary */
+    *strrchr(dir, DIR_SEP_CHAR) = '\0';
+    vlc_mkdir(dir, 0700);
+
+    FILE *file = vlc_fopen(tmp, "wb");
+    if (file != NULL)
+    {
+        uint32_t format = glformat;
+        bool ok = fwrite(&format, sizeof (format), 1, file) == 1
+               && fwrite(binary, 1, length, file) == (size_t)length;
+        if (fclose(file) == 0 && ok && vlc_rename(tmp, path) == 0)
+            msg_Dbg(tc->gl, "program cached to %s", path);
+        else
+            vlc_unlink(tmp);
+    }
+    free(tmp);
+end:
+    free(dir);
+    free(binary);
+}
+
 static int
-opengl_link_program(struct prgm *prgm)
+opengl_link_program(struct prgm *prgm, bool use_cache)
 {
     opengl_tex_converter_t *tc = prgm->tc;
 
-    GLuint vertex_shader = BuildVertexShader(tc, tc->tex_count);
+    char *vertex_code = BuildVertexShaderCode(tc, tc->tex_count);
+    if (vertex_code == NULL)
+    {
+        tc->vt->DeleteShader(tc->fshader);
+        return VLC_ENOMEM;
+    }
+
+    char *cache_path = use_cache ? ProgramCacheGetPath(tc, vertex_code) : NULL;
+    if (cache_path != NULL)
+    {
+        prgm->id = ProgramCacheLoad(tc, cache_path);
+        if (prgm->id != 0)
+        {
+            msg_Dbg(tc->gl, "program loaded from %s", cache_path);
+            free(cache_path);
+            free(vertex_code);
+            tc->vt->DeleteShader(tc->fshader);
+            goto locations;
+        }
+    }
+
+    GLuint vertex_shader = BuildVertexShader(tc, vertex_code);
+    free(vertex_code);
     GLuint shaders[] = { tc->fshader, vertex_shader };
 
     /* Check shaders messages */
@@ -479,6 +660,9 @@ opengl_link_program(struct prgm *prgm)
     prgm->id = tc->vt->CreateProgram();
     tc->vt->AttachShader(prgm->id, tc->fshader);
     tc->vt->AttachShader(prgm->id, vertex_shader);
+    if (cache_path != NULL && tc->vt->ProgramParameteri != NULL)
+        tc->vt->ProgramParameteri(prgm->id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                                  GL_TRUE);
     tc->vt->LinkProgram(prgm->id);
 
     tc->vt->DeleteShader(vertex_shader);
@@ -505,10 +689,18 @@ opengl_link_program(struct prgm *prgm)
         if (link_status == GL_FALSE)
         {
             msg_Err(tc->gl, "Unable to use program");
+            free(cache_path);
             goto error;
         }
     }
 
+    if (cache_path != NULL)
+    {
+        ProgramCacheStore(tc, prgm->id, cache_path);
+        free(cache_path);
+    }
+
+locations:
     /* Fetch UniformLocations and AttribLocations */
 #define GET_LOC(type, x, str) do { \
     x = tc->vt->Get##type##Location(prgm->id, str); \
@@ -595,7 +787,7 @@ log_cb(void *priv, enum pl_log_level level, const char *msg)
 static int
 opengl_init_program(vout_display_opengl_t *vgl, struct prgm *prgm,
                     const char *glexts, const video_format_t *fmt, bool subpics,
-                    bool b_dump_shaders)
+                    struct opengl_filters *filters, bool b_dump_shaders)
 {
     opengl_tex_converter_t *tc =
         vlc_object_create(vgl->gl, sizeof(opengl_tex_converter_t));
@@ -604,6 +796,7 @@ opengl_init_program(vout_display_opengl_t *vgl, struct prgm *prgm,
 
     tc->gl = vgl->gl;
     tc->vt = &vgl->vt;
+    tc->filters = filters;
     tc->b_dump_shaders = b_dump_shaders;
     tc->pf_fragment_shader_init = opengl_fragment_shader_init_impl;
     tc->glexts = glexts;
@@ -693,7 +886,7 @@ opengl_init_program(vout_display_opengl_t *vgl, struct prgm *prgm,
 
     prgm->tc = tc;
 
-    ret = opengl_link_program(prgm);
+    ret = opengl_link_program(prgm, vgl->program_cache);
     if (ret != VLC_SUCCESS)
     {
         opengl_deinit_program(vgl, prgm);
@@ -707,6 +900,171 @@ opengl_init_program(vout_display_opengl_t *vgl, struct prgm *prgm,
     return VLC_SUCCESS;
 }
 
+static const struct
+{
+    const char *name;
+    unsigned filter;
+} filter_names[] = {
+    { "adjust",      OPENGL_FILTER_ADJUST },
+    { "sharpen",     OPENGL_FILTER_SHARPEN },
+    { "deinterlace", OPENGL_FILTER_DEINTERLACE },
+};
+
+/* Options of the CPU filters, reused as they are */
+static const struct
+{
+    const char *name;
+    unsigned filter;
+    size_t offset;
+} filter_params[] = {
+    { "contrast",      OPENGL_FILTER_ADJUST,
+      offsetof(struct opengl_filters, contrast) },
+    { "brightness",    OPENGL_FILTER_ADJUST,
+      offsetof(struct opengl_filters, brightness) },
+    { "hue",           OPENGL_FILTER_ADJUST,
+      offsetof(struct opengl_filters, hue) },
+    { "saturation",    OPENGL_FILTER_ADJUST,
+      offsetof(struct opengl_filters, saturation) },
+    { "gamma",         OPENGL_FILTER_ADJUST,
+      offsetof(struct opengl_filters, gamma) },
+    { "sharpen-sigma", OPENGL_FILTER_SHARPEN,
+      offsetof(struct opengl_filters, sharpen_sigma) },
+};
+
+static int FilterParamCallback(vlc_object_t *obj, char const *var,
+                               vlc_value_t oldval, vlc_value_t newval,
+                               void *data)
+{
+    VLC_UNUSED(obj); VLC_UNUSED(var); VLC_UNUSED(oldval);
+    vlc_atomic_store_float(data, newval.f_float);
+    return VLC_SUCCESS;
+}
+
+/* Returns the filters listed by the user, the ones that can be tried with
+ * OpenGL are left in vgl->filters.requested */
+static unsigned FiltersInit(vout_display_opengl_t *vgl)
+{
+    char *list = var_InheritString(vgl->gl, "gl-filters");
+    if (list == NULL)
+        return 0;
+
+    char *saveptr;
+    for (const char *name = strtok_r(list, ":,", &saveptr); name != NULL;
+         name = strtok_r(NULL, ":,", &saveptr))
+    {
+        size_t i = 0;
+        while (i < ARRAY_SIZE(filter_names) && strcmp(filter_names[i].name, name))
+            i++;
+        if (i < ARRAY_SIZE(filter_names))
+            vgl->filters.requested |= filter_names[i].filter;
+        else
+            msg_Warn(vgl->gl, "unknown OpenGL filter \"%s\"", name);
+    }
+    free(list);
+
+    const unsigned listed = vgl->filters.requested;
+    if (listed == 0)
+        return 0;
+
+    /* The parameters are changed on the video output, as for the CPU
+     * filters */
+    vlc_object_t *obj = VLC_OBJECT(vgl->gl);
+    for (vlc_object_t *parent = obj; parent != NULL;
+         parent = parent->obj.parent)
+        if (!strcmp(parent->obj.object_type, "video output"))
+        {
+            obj = parent;
+            break;
+        }
+    vgl->filters_obj = obj;
+
+    for (size_t i = 0; i < ARRAY_SIZE(filter_params); i++)
+        if ((vgl->filters.requested & filter_params[i].filter)
+         && config_FindConfig(filter_params[i].name) == NULL)
+        {
+            msg_Warn(vgl->gl, "missing option \"%s\"", filter_params[i].name);
+            vgl->filters.requested &= ~filter_params[i].filter;
+        }
+
+    if (var_InheritBool(obj, "brightness-threshold"))
+        vgl->filters.requested &= ~OPENGL_FILTER_ADJUST;
+
+    for (size_t i = 0; i < ARRAY_SIZE(filter_params); i++)
+    {
+        if (!(vgl->filters.requested & filter_params[i].filter))
+            continue;
+        vlc_atomic_float *param = (void *)((char *)&vgl->filters
+                                           + filter_params[i].offset);
+        const char *name = filter_params[i].name;
+
+        var_Create(obj, name, VLC_VAR_FLOAT | VLC_VAR_DOINHERIT
+                              | VLC_VAR_ISCOMMAND);
+        vlc_atomic_init_float(param, var_GetFloat(obj, name));
+        var_AddCallback(obj, name, FilterParamCallback, param);
+    }
+    vgl->filters.field = -1;
+    return listed;
+}
+
+static void FiltersDeinit(vout_display_opengl_t *vgl)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(filter_params); i++)
+    {
+        if (!(vgl->filters.requested & filter_params[i].filter))
+            continue;
+        vlc_atomic_float *param = (void *)((char *)&vgl->filters
+                                           + filter_params[i].offset);
+        var_DelCallback(vgl->filters_obj, filter_params[i].name,
+                        FilterParamCallback, param);
+        var_Destroy(vgl->filters_obj, filter_params[i].name);
+    }
+}
+
+/* Hands the filters that cannot run in the fragment shader over to the video
+ * output, and disables its own deinterlacer if the shader replaces it */
+static void FiltersFallback(vout_display_opengl_t *vgl, unsigned listed,
+                            unsigned enabled)
+{
+    vlc_object_t *vout = vgl->filters_obj;
+    if (vout == NULL || vout == VLC_OBJECT(vgl->gl))
+        return;
+
+    if (enabled & OPENGL_FILTER_DEINTERLACE)
+        var_SetInteger(vout, "deinterlace", 0);
+
+    for (size_t i = 0; i < ARRAY_SIZE(filter_names); i++)
+    {
+        const char *name = filter_names[i].name;
+        if (!(listed & filter_names[i].filter)
+         || (enabled & filter_names[i].filter))
+            continue;
+
+        msg_Warn(vgl->gl, "cannot run the %s filter with OpenGL, "
+                 "using the CPU one", name);
+        if (filter_names[i].filter == OPENGL_FILTER_DEINTERLACE)
+        {
+            var_SetString(vout, "deinterlace-mode", "linear");
+            var_SetInteger(vout, "deinterlace", 1);
+            continue;
+        }
+
+        char *filters = var_GetNonEmptyString(vout, "video-filter");
+        if (filters != NULL && strstr(filters, name) != NULL)
+        {
+            free(filters);
+            continue;
+        }
+        char *value;
+        if (asprintf(&value, "%s%s%s", filters ? filters : "",
+                     filters ? ":" : "", name) >= 0)
+        {
+            var_SetString(vout, "video-filter", value);
+            free(value);
+        }
+        free(filters);
+    }
+}
+
 static void
 ResizeFormatToGLMaxTexSize(video_format_t *fmt, unsigned int max_tex_size)
 {
@@ -810,6 +1168,7 @@ vout_display_opengl_t *vout_display_opengl_New(video_format_t *fmt,
     GET_PROC_ADDR(GetShaderiv);
     GET_PROC_ADDR(GetProgramInfoLog);
     GET_PROC_ADDR(GetShaderInfoLog);
+    GET_PROC_ADDR(GetShaderSource);
 
     GET_PROC_ADDR(GetUniformLocation);
     GET_PROC_ADDR(GetAttribLocation);
@@ -830,6 +1189,10 @@ vout_display_opengl_t *vout_display_opengl_New(video_format_t *fmt,
     GET_PROC_ADDR(UseProgram);
     GET_PROC_ADDR(DeleteProgram);
 
+    GET_PROC_ADDR_OPTIONAL(GetProgramBinary);
+    GET_PROC_ADDR_OPTIONAL(ProgramBinary);
+    GET_PROC_ADDR_OPTIONAL(ProgramParameteri);
+
     GET_PROC_ADDR(ActiveTexture);
 
     GET_PROC_ADDR(GenBuffers);
@@ -841,6 +1204,8 @@ vout_display_opengl_t *vout_display_opengl_New(video_format_t *fmt,
 
     GET_PROC_ADDR_OPTIONAL(BufferSubData);
     GET_PROC_ADDR_OPTIONAL(BufferStorage);
+    if (vgl->vt.BufferStorage == NULL) /* GL_EXT_buffer_storage (GLES) */
+        vgl->vt.BufferStorage = vlc_gl_GetProcAddress(gl, "glBufferStorageEXT");
     GET_PROC_ADDR_OPTIONAL(MapBufferRange);
     GET_PROC_ADDR_OPTIONAL(FlushMappedBufferRange);
     GET_PROC_ADDR_OPTIONAL(UnmapBuffer);
@@ -894,33 +1259,53 @@ vout_display_opengl_t *vout_display_opengl_New(video_format_t *fmt,
 
     bool b_dump_shaders = var_InheritInteger(gl, "verbose") >= 4;
 
+    GLint binary_formats = 0;
+    if (vgl->vt.GetProgramBinary != NULL && vgl->vt.ProgramBinary != NULL
+     && var_InheritBool(gl, "gl-program-cache"))
+        vgl->vt.GetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binary_formats);
+    vgl->program_cache = binary_formats > 0;
+
     vgl->prgm = &vgl->prgms[0];
     vgl->sub_prgm = &vgl->prgms[1];
 
+    const unsigned filters_listed = FiltersInit(vgl);
+
     GL_ASSERT_NOERROR();
-    int ret;
-    ret = opengl_init_program(vgl, vgl->prgm, extensions, fmt, false,
-                              b_dump_shaders);
+    int ret = VLC_EGENERIC;
+    if (vgl->filters.requested != 0)
+    {
+        ret = opengl_init_program(vgl, vgl->prgm, extensions, fmt, false,
+                                  &vgl->filters, b_dump_shaders);
+        if (ret != VLC_SUCCESS)
+            msg_Warn(gl, "could not init tex converter with filters");
+    }
+    if (ret != VLC_SUCCESS)
+        ret = opengl_init_program(vgl, vgl->prgm, extensions, fmt, false,
+                                  NULL, b_dump_shaders);
     if (ret != VLC_SUCCESS)
     {
         msg_Warn(gl, "could not init tex converter for %4.4s",
                  (const char *) &fmt->i_chroma);
+        FiltersDeinit(vgl);
         free(vgl);
         return NULL;
     }
 
     GL_ASSERT_NOERROR();
     ret = opengl_init_program(vgl, vgl->sub_prgm, extensions, fmt, true,
-                              b_dump_shaders);
+                              NULL, b_dump_shaders);
     if (ret != VLC_SUCCESS)
     {
         msg_Warn(gl, "could not init subpictures tex converter for %4.4s",
                  (const char *) &fmt->i_chroma);
         opengl_deinit_program(vgl, vgl->prgm);
+        FiltersDeinit(vgl);
         free(vgl);
         return NULL;
     }
     GL_ASSERT_NOERROR();
+    if (filters_listed != 0)
+        FiltersFallback(vgl, filters_listed, vgl->prgm->tc->filters_enabled);
     /* Update the fmt to main program one */
     vgl->fmt = vgl->prgm->tc->fmt;
     /* The orientation is handled by the orientation matrix */
@@ -1014,6 +1399,7 @@ void vout_display_opengl_Delete(vout_display_opengl_t *vgl)
         picture_pool_Release(vgl->pool);
     opengl_deinit_program(vgl, vgl->prgm);
     opengl_deinit_program(vgl, vgl->sub_prgm);
+    FiltersDeinit(vgl);
 
     vgl->vt.DeleteBuffers(1, &vgl->vertex_buffer_object);
     vgl->vt.DeleteBuffers(1, &vgl->index_buffer_object);
@@ -1031,6 +1417,8 @@ void vout_display_opengl_Delete(vout_display_opengl_t *vgl)
     {
         if (vgl->region[i].texture)
             vgl->vt.DeleteTextures(1, &vgl->region[i].texture);
+        if (vgl->region[i].picture)
+            picture_Release(vgl->region[i].picture);
     }
     free(vgl->region);
     GL_ASSERT_NOERROR();
@@ -1167,6 +1555,11 @@ int vout_display_opengl_Prepare(vout_display_opengl_t *vgl,
 
     opengl_tex_converter_t *tc = vgl->prgm->tc;
 
+    if (picture->b_progressive)
+        vgl->filters.field = -1;
+    else
+        vgl->filters.field = picture->b_top_field_first ? 0 : 1;
+
     /* Update the texture */
     int ret = tc->pf_update(tc, vgl->texture, vgl->tex_width, vgl->tex_height,
                             picture, NULL);
@@ -1211,7 +1604,38 @@ int vout_display_opengl_Prepare(vout_display_opengl_t *vgl,
             glr->right  =  2.0 * (r->i_x + r->fmt.i_visible_width ) / subpicture->i_original_picture_width  - 1.0;
             glr->bottom = -2.0 * (r->i_y + r->fmt.i_visible_height) / subpicture->i_original_picture_height + 1.0;
 
-            glr->texture = 0;
+            const size_t pixels_offset =
+                r->fmt.i_y_offset * r->p_picture->p->i_pitch +
+                r->fmt.i_x_offset * r->p_picture->p->i_pixel_pitch;
+
+            glr->texture        = 0;
+            glr->picture        = picture_Hold(r->p_picture);
+            glr->pixels_offset  = pixels_offset;
+            glr->visible_width  = r->fmt.i_visible_width;
+            glr->visible_height = r->fmt.i_visible_height;
+
+            /* The SPU renderer hands the same (held) picture for a region
+               that did not change since the previous call: keep its
+               texture as is. */
+            bool uploaded = false;
+            for (int j = 0; j < last_count; j++) {
+                if (last[j].texture &&
+                    last[j].picture        == r->p_picture &&
+                    last[j].pixels_offset  == pixels_offset &&
+                    last[j].visible_width  == glr->visible_width &&
+                    last[j].visible_height == glr->visible_height &&
+                    last[j].width  == glr->width &&
+                    last[j].height == glr->height) {
+                    glr->texture = last[j].texture;
+                    picture_Release(last[j].picture);
+                    memset(&last[j], 0, sizeof(last[j]));
+                    uploaded = true;
+                    break;
+                }
+            }
+            if (uploaded)
+                continue;
+
             /* Try to recycle the textures allocated by the previous
                call to this function. */
             for (int j = 0; j < last_count; j++) {
@@ -1219,14 +1643,13 @@ int vout_display_opengl_Prepare(vout_display_opengl_t *vgl,
                     last[j].width  == glr->width &&
                     last[j].height == glr->height) {
                     glr->texture = last[j].texture;
+                    if (last[j].picture)
+                        picture_Release(last[j].picture);
                     memset(&last[j], 0, sizeof(last[j]));
                     break;
                 }
             }
 
-            const size_t pixels_offset =
-                r->fmt.i_y_offset * r->p_picture->p->i_pitch +
-                r->fmt.i_x_offset * r->p_picture->p->i_pixel_pitch;
             if (!glr->texture)
             {
                 /* Could not recycle a previous texture, generate a new one. */
@@ -1239,11 +1662,17 @@ int vout_display_opengl_Prepare(vout_display_opengl_t *vgl,
                                                * r->p_picture->p[0].i_pixel_pitch;
             ret = tc->pf_update(tc, &glr->texture, &glr->width, &glr->height,
                                 r->p_picture, &pixels_offset);
+            if (ret != VLC_SUCCESS) {
+                picture_Release(glr->picture);
+                glr->picture = NULL;
+            }
         }
     }
     for (int i = 0; i < last_count; i++) {
         if (last[i].texture)
             DelTextures(tc, &last[i].texture);
+        if (last[i].picture)
+            picture_Release(last[i].picture);
     }
     free(last);
 
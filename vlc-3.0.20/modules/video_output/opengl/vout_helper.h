@@ -233,8 +233,22 @@ static const char * const dither_text[] = {
 #define GLCONV_TEXT "Open GL/GLES hardware converter"
 #define GLCONV_LONGTEXT "Force a \"glconv\" module."
 
+#define GLFILTERS_TEXT "OpenGL video filters"
+#define GLFILTERS_LONGTEXT "Colon-separated list of video filters run " \
+    "while rendering, among adjust, sharpen and deinterlace. They use the " \
+    "options of the CPU filters of the same name, which are used instead " \
+    "when the video cannot be filtered with OpenGL."
+
+#define GLPROGRAMCACHE_TEXT "Cache OpenGL shader programs"
+#define GLPROGRAMCACHE_LONGTEXT "Store the linked shader programs in the " \
+    "user cache directory, to skip compiling them when the video output " \
+    "starts. The driver may not support it."
+
 #define add_glopts() \
     add_module ("glconv", "glconv", NULL, GLCONV_TEXT, GLCONV_LONGTEXT, true) \
+    add_string ("gl-filters", NULL, GLFILTERS_TEXT, GLFILTERS_LONGTEXT, true) \
+    add_bool ("gl-program-cache", true, GLPROGRAMCACHE_TEXT, \
+              GLPROGRAMCACHE_LONGTEXT, true) \
     add_glopts_placebo ()
 
 static const vlc_fourcc_t gl_subpicture_chromas[] = {
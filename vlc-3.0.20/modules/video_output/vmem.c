@@ -35,6 +35,9 @@
 #include <vlc_plugin.h>
 #include <vlc_vout_display.h>
 #include <vlc_picture_pool.h>
+#include <vlc_modules.h>
+
+#include "vmem_surface.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -95,7 +98,13 @@ struct vout_display_sys_t {
     void (*unlock)(void *sys, void *id, void *const *plane);
     void (*display)(void *sys, void *id);
     void (*cleanup)(void *sys);
+    void *(*pool_get)(void *sys, unsigned index, void **plane);
+    void (*pool_display)(void *sys, void *id, picture_t *buffer);
+    void (*surface_display)(void *sys, const struct vmem_surface_desc *,
+                            picture_t *buffer);
+    vmem_surface_t *exporter;
 
+    unsigned count; /* number of application buffers, or 0 if unknown */
     unsigned pitches[PICTURE_PLANE_MAX];
     unsigned lines[PICTURE_PLANE_MAX];
 };
@@ -106,8 +115,65 @@ typedef unsigned (*vlc_format_cb)(void **, char *, unsigned *, unsigned *,
 static picture_pool_t *Pool  (vout_display_t *, unsigned);
 static void           Prepare(vout_display_t *, picture_t *, subpicture_t *);
 static void           Display(vout_display_t *, picture_t *, subpicture_t *);
+static void           DisplaySurface(vout_display_t *, picture_t *,
+                                     subpicture_t *);
 static int            Control(vout_display_t *, int, va_list);
 
+/*****************************************************************************
+ * OpenSurface: keeps the decoded format, hardware surfaces included
+ *****************************************************************************/
+static int OpenSurface(vout_display_t *vd, vout_display_sys_t *sys)
+{
+    static const vlc_fourcc_t subpicture_chromas[] = { VLC_CODEC_RGBA, 0 };
+    video_format_t fmt = vd->fmt;
+
+    const vlc_chroma_description_t *desc =
+        vlc_fourcc_GetChromaDescription(fmt.i_chroma);
+    if (desc != NULL && desc->plane_count == 0) {
+        /* Opaque chroma: load a module to export it */
+        sys->exporter = vlc_object_create(vd, sizeof (*sys->exporter));
+        if (sys->exporter != NULL) {
+            sys->exporter->chroma = fmt.i_chroma;
+            sys->exporter->sys = NULL;
+            sys->exporter->module = module_need(sys->exporter, "vmem surface",
+                                                NULL, false);
+            if (sys->exporter->module == NULL) {
+                vlc_object_release(sys->exporter);
+                sys->exporter = NULL;
+            }
+        }
+
+        if (sys->exporter == NULL) {
+            /* Let the core read the surfaces back */
+            const vlc_fourcc_t *fallback =
+                vlc_fourcc_GetYUVFallback(fmt.i_chroma);
+            for (fmt.i_chroma = VLC_CODEC_I420; *fallback != 0; fallback++) {
+                desc = vlc_fourcc_GetChromaDescription(*fallback);
+                if (desc != NULL && desc->plane_count > 0) {
+                    fmt.i_chroma = *fallback;
+                    break;
+                }
+            }
+            msg_Warn(vd, "cannot export %4.4s surfaces, using %4.4s",
+                     (const char *)&vd->fmt.i_chroma,
+                     (const char *)&fmt.i_chroma);
+        }
+    }
+
+    vd->sys     = sys;
+    vd->fmt     = fmt;
+    vd->info.subpicture_chromas = subpicture_chromas; /* not blent */
+    vd->pool    = Pool;
+    vd->prepare = NULL;
+    vd->display = DisplaySurface;
+    vd->control = Control;
+
+    vout_display_SendEventDisplaySize(vd, fmt.i_visible_width,
+                                      fmt.i_visible_height);
+    vout_display_DeleteWindow(vd, NULL);
+    return VLC_SUCCESS;
+}
+
 /*****************************************************************************
  * Open: allocates video thread
  *****************************************************************************
@@ -124,7 +190,10 @@ static int Open(vlc_object_t *object)
     vlc_format_cb setup = var_InheritAddress(vd, "vmem-setup");
 
     sys->lock = var_InheritAddress(vd, "vmem-lock");
-    if (sys->lock == NULL) {
+    sys->pool_get = var_InheritAddress(vd, "vmem-pool");
+    sys->surface_display = var_InheritAddress(vd, "vmem-surface");
+    if (sys->lock == NULL && sys->pool_get == NULL
+     && sys->surface_display == NULL) {
         msg_Err(vd, "missing lock callback");
         free(sys);
         return VLC_EGENERIC;
@@ -133,7 +202,13 @@ static int Open(vlc_object_t *object)
     sys->display = var_InheritAddress(vd, "vmem-display");
     sys->cleanup = var_InheritAddress(vd, "vmem-cleanup");
     sys->opaque = var_InheritAddress(vd, "vmem-data");
+    sys->pool_display = var_InheritAddress(vd, "vmem-pool-display");
+    sys->exporter = NULL;
     sys->pool = NULL;
+    sys->count = 0;
+
+    if (sys->surface_display != NULL)
+        return OpenSurface(vd, sys);
 
     /* Define the video format */
     video_format_t fmt;
@@ -147,8 +222,9 @@ static int Open(vlc_object_t *object)
         memset(sys->pitches, 0, sizeof(sys->pitches));
         memset(sys->lines, 0, sizeof(sys->lines));
 
-        if (setup(&sys->opaque, chroma, &fmt.i_width, &fmt.i_height,
-                           sys->pitches, sys->lines) == 0) {
+        sys->count = setup(&sys->opaque, chroma, &fmt.i_width, &fmt.i_height,
+                           sys->pitches, sys->lines);
+        if (sys->count == 0) {
             msg_Err(vd, "video format setup failure (no pictures)");
             free(sys);
             return VLC_EGENERIC;
@@ -228,17 +304,78 @@ static void Close(vlc_object_t *object)
 
     if (sys->cleanup)
         sys->cleanup(sys->opaque);
+    if (sys->exporter) {
+        module_unneed(sys->exporter, sys->exporter->module);
+        vlc_object_release(sys->exporter);
+    }
     if (sys->pool)
         picture_pool_Release(sys->pool);
     free(sys);
 }
 
+/* Wraps the application buffers into pictures, so that the decoder can
+ * render straight into them. */
+static picture_pool_t *PoolFromBuffers(vout_display_t *vd, unsigned count)
+{
+    vout_display_sys_t *sys = vd->sys;
+
+    if (sys->count > 0)
+        count = sys->count;
+
+    picture_t **pictures = vlc_alloc(count, sizeof (*pictures));
+    if (unlikely(pictures == NULL))
+        return NULL;
+
+    unsigned i;
+    for (i = 0; i < count; i++) {
+        picture_sys_t *picsys = malloc(sizeof (*picsys));
+        if (unlikely(picsys == NULL))
+            break;
+
+        void *planes[PICTURE_PLANE_MAX] = { NULL };
+        picsys->id = sys->pool_get(sys->opaque, i, planes);
+        if (picsys->id == NULL) {
+            free(picsys);
+            break;
+        }
+
+        picture_resource_t rsc = { .p_sys = picsys };
+        for (unsigned j = 0; j < PICTURE_PLANE_MAX; j++) {
+            rsc.p[j].p_pixels = planes[j];
+            rsc.p[j].i_lines  = sys->lines[j];
+            rsc.p[j].i_pitch  = sys->pitches[j];
+        }
+
+        pictures[i] = picture_NewFromResource(&vd->fmt, &rsc);
+        if (pictures[i] == NULL) {
+            free(picsys);
+            break;
+        }
+    }
+
+    picture_pool_t *pool = NULL;
+    if (i > 0) {
+        msg_Dbg(vd, "rendering into %u application buffers", i);
+        pool = picture_pool_New(i, pictures);
+        if (pool == NULL)
+            while (i > 0)
+                picture_Release(pictures[--i]);
+    } else
+        msg_Err(vd, "no application buffers");
+    free(pictures);
+    return pool;
+}
+
 static picture_pool_t *Pool(vout_display_t *vd, unsigned count)
 {
     vout_display_sys_t *sys = vd->sys;
 
-    if (sys->pool == NULL)
-        sys->pool = picture_pool_NewFromFormat(&vd->fmt, count);
+    if (sys->pool == NULL) {
+        if (sys->pool_get != NULL)
+            sys->pool = PoolFromBuffers(vd, count);
+        else
+            sys->pool = picture_pool_NewFromFormat(&vd->fmt, count);
+    }
     return sys->pool;
 }
 
@@ -248,6 +385,9 @@ static void Prepare(vout_display_t *vd, picture_t *pic, subpicture_t *subpic)
     picture_resource_t rsc = { .p_sys = NULL };
     void *planes[PICTURE_PLANE_MAX];
 
+    if (sys->pool_get != NULL) /* already rendered in place */
+        return;
+
     sys->pic_opaque = sys->lock(sys->opaque, planes);
 
     for (unsigned i = 0; i < PICTURE_PLANE_MAX; i++) {
@@ -272,10 +412,51 @@ static void Display(vout_display_t *vd, picture_t *pic, subpicture_t *subpic)
 {
     vout_display_sys_t *sys = vd->sys;
 
-    if (sys->display != NULL)
-        sys->display(sys->opaque, sys->pic_opaque);
+    if (sys->pool_get != NULL) {
+        /* The application releases the picture when done with it */
+        if (sys->pool_display != NULL)
+            sys->pool_display(sys->opaque, pic->p_sys->id, pic);
+        else
+            picture_Release(pic);
+    } else {
+        if (sys->display != NULL)
+            sys->display(sys->opaque, sys->pic_opaque);
+
+        picture_Release(pic);
+    }
+    VLC_UNUSED(subpic);
+}
+
+static void DisplaySurface(vout_display_t *vd, picture_t *pic,
+                           subpicture_t *subpic)
+{
+    vout_display_sys_t *sys = vd->sys;
+    struct vmem_surface_desc desc = {
+        .x_offset = pic->format.i_x_offset,
+        .y_offset = pic->format.i_y_offset,
+        .width = pic->format.i_visible_width,
+        .height = pic->format.i_visible_height,
+    };
+
+    memcpy(desc.chroma, &pic->format.i_chroma, sizeof (desc.chroma));
+    if (sys->exporter != NULL) {
+        if (sys->exporter->export(sys->exporter, pic, &desc)) {
+            msg_Err(vd, "cannot export surface");
+            picture_Release(pic);
+            return;
+        }
+    } else {
+        desc.type = VMEM_SURFACE_MEMORY;
+        desc.u.memory.count = pic->i_planes;
+        for (int i = 0; i < pic->i_planes; i++) {
+            desc.u.memory.planes[i] = pic->p[i].p_pixels;
+            desc.u.memory.pitches[i] = pic->p[i].i_pitch;
+            desc.u.memory.lines[i] = pic->p[i].i_lines;
+        }
+    }
 
-    picture_Release(pic);
+    /* The application releases the picture when done with it */
+    sys->surface_display(sys->opaque, &desc, pic);
     VLC_UNUSED(subpic);
 }
 
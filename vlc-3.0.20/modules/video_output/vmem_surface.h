@@ -0,0 +1,82 @@
+/*****************************************************************************
+ * vmem_surface.h: video memory output hardware surface export
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_VMEM_SURFACE_H
+#define VLC_VMEM_SURFACE_H
+
+#include <vlc_common.h>
+#include <vlc_picture.h>
+
+/* NOTE: the surface types and description must match those of LibVLC */
+enum vmem_surface_type
+{
+    VMEM_SURFACE_MEMORY,
+    VMEM_SURFACE_VAAPI,
+};
+
+struct vmem_surface_desc
+{
+    enum vmem_surface_type type;
+    char chroma[4];
+    unsigned x_offset;
+    unsigned y_offset;
+    unsigned width;
+    unsigned height;
+    union
+    {
+        struct
+        {
+            unsigned count;
+            void *planes[PICTURE_PLANE_MAX];
+            unsigned pitches[PICTURE_PLANE_MAX];
+            unsigned lines[PICTURE_PLANE_MAX];
+        } memory;
+        struct
+        {
+            void *display;
+            unsigned surface;
+        } vaapi;
+    } u;
+};
+
+/**
+ * Exporter of opaque hardware pictures, "vmem surface" capability.
+ *
+ * The module Open callback checks the chroma and sets the export callback.
+ */
+typedef struct vmem_surface_t vmem_surface_t;
+struct vmem_surface_t
+{
+    struct vlc_common_members obj;
+
+    vlc_fourcc_t chroma; /**< opaque chroma of the pictures [IN] */
+
+    /**
+     * Describes the hardware surface of a picture.
+     *
+     * The chroma and dimensions are filled by the caller.
+     */
+    int (*export)(vmem_surface_t *, picture_t *, struct vmem_surface_desc *);
+
+    module_t *module;
+    void *sys;
+};
+
+#endif
@@ -71,17 +71,17 @@ typedef struct spectrum_data
     int *peaks;
     int *prev_heights;
 
-    unsigned i_prev_nb_samples;
-    int16_t *p_prev_s16_buff;
-
-    window_param wind_param;
+    fft_state *p_state;                 /* internal FFT data */
+    window_context wind_ctx;            /* internal window data */
 } spectrum_data;
 
+static void spectrum_Free( void * );
+
 static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
                         const block_t * p_buffer , picture_t * p_picture)
 {
     spectrum_data *p_data = p_effect->p_data;
-    float p_output[FFT_BUFFER_SIZE];  /* Raw FFT Result  */
+    float p_output[FFT_BUFFER_SIZE] = { 0 }; /* Raw FFT Result  */
     int *height;                      /* Bar heights */
     int *peaks;                       /* Peaks */
     int *prev_heights;                /* Previous bar heights */
@@ -104,21 +104,12 @@ static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
      110,115,121,130,141,152,163,174,185,200,255};
     const int *xscale;
 
-    fft_state *p_state;                 /* internal FFT data */
-    DEFINE_WIND_CONTEXT( wind_ctx );    /* internal window data */
-
     int i , j , y , k;
     int i_line;
     int16_t p_dest[FFT_BUFFER_SIZE];      /* Adapted FFT result */
     int16_t p_buffer1[FFT_BUFFER_SIZE];   /* Buffer on which we perform
                                              the FFT (first channel) */
 
-    float *p_buffl =                     /* Original buffer */
-            (float*)p_buffer->p_buffer;
-
-    int16_t  *p_buffs;                    /* int16_t converted buffer */
-    int16_t  *p_s16_buff;                 /* int16_t converted buffer */
-
     if (!p_buffer->i_nb_samples) {
         msg_Err(p_aout, "no samples yet");
         return -1;
@@ -127,6 +118,8 @@ static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
     /* Create p_data if needed */
     if( !p_data )
     {
+        window_param wind_param;
+
         p_effect->p_data = p_data = malloc( sizeof( spectrum_data ) );
         if( !p_data )
             return -1;
@@ -134,27 +127,24 @@ static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
         p_data->peaks = calloc( 80, sizeof(int) );
         p_data->prev_heights = calloc( 80, sizeof(int) );
 
-        p_data->i_prev_nb_samples = 0;
-        p_data->p_prev_s16_buff = NULL;
-
-        window_get_param( p_aout, &p_data->wind_param );
+        /* The FFT and window tables do not depend on the samples */
+        p_data->wind_ctx = (window_context){ NULL, 0 };
+        p_data->p_state = visual_fft_init();
+        if( !p_data->p_state )
+        {
+            msg_Err(p_aout,"unable to initialize FFT transform");
+            goto error;
+        }
+        window_get_param( p_aout, &wind_param );
+        if( !window_init( FFT_BUFFER_SIZE, &wind_param, &p_data->wind_ctx ) )
+        {
+            msg_Err(p_aout,"unable to initialize FFT window");
+            goto error;
+        }
     }
     peaks = (int *)p_data->peaks;
     prev_heights = (int *)p_data->prev_heights;
 
-    /* Allocate the buffer only if the number of samples change */
-    if( p_buffer->i_nb_samples != p_data->i_prev_nb_samples )
-    {
-        free( p_data->p_prev_s16_buff );
-        p_data->p_prev_s16_buff = vlc_alloc( p_buffer->i_nb_samples *
-                                             p_effect->i_nb_chans,
-                                             sizeof(int16_t));
-        p_data->i_prev_nb_samples = p_buffer->i_nb_samples;
-        if( !p_data->p_prev_s16_buff )
-            return -1;
-    }
-    p_buffs = p_s16_buff = p_data->p_prev_s16_buff;
-
     i_80_bands = var_InheritInteger( p_aout, "visual-80-bands" );
     i_peak     = var_InheritInteger( p_aout, "visual-peaks" );
 
@@ -174,45 +164,11 @@ static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
     {
         return -1;
     }
-    /* Convert the buffer to int16_t  */
-    /* Pasted from float32tos16.c */
-    for (i = p_buffer->i_nb_samples * p_effect->i_nb_chans; i--; )
-    {
-        union { float f; int32_t i; } u;
-        u.f = *p_buffl + 384.0;
-        if(u.i >  0x43c07fff ) * p_buffs = 32767;
-        else if ( u.i < 0x43bf8000 ) *p_buffs = -32768;
-        else *p_buffs = u.i - 0x43c00000;
-
-        p_buffl++ ; p_buffs++ ;
-    }
-    p_state  = visual_fft_init();
-    if( !p_state)
-    {
-        free( height );
-        msg_Err(p_aout,"unable to initialize FFT transform");
-        return -1;
-    }
-    if( !window_init( FFT_BUFFER_SIZE, &p_data->wind_param, &wind_ctx ) )
-    {
-        fft_close( p_state );
-        free( height );
-        msg_Err(p_aout,"unable to initialize FFT window");
-        return -1;
-    }
-    p_buffs = p_s16_buff;
-    for ( i = 0 ; i < FFT_BUFFER_SIZE ; i++)
-    {
-        p_output[i]  = 0;
-        p_buffer1[i] = *p_buffs;
-
-        p_buffs += p_effect->i_nb_chans;
-        if( p_buffs >= &p_s16_buff[p_buffer->i_nb_samples * p_effect->i_nb_chans] )
-            p_buffs = p_s16_buff;
 
-    }
-    window_scale_in_place( p_buffer1, &wind_ctx );
-    fft_perform( p_buffer1, p_output, p_state);
+    fft_get_input( (const float *)p_buffer->p_buffer, p_buffer->i_nb_samples,
+                   p_effect->i_nb_chans, p_buffer1 );
+    window_scale_in_place( p_buffer1, &p_data->wind_ctx );
+    fft_perform( p_buffer1, p_output, p_data->p_state );
     for( i = 0; i< FFT_BUFFER_SIZE ; i++ )
         p_dest[i] = p_output[i] *  ( 2 ^ 16 ) / ( ( FFT_BUFFER_SIZE / 2 * 32768 ) ^ 2 );
 
@@ -359,13 +315,14 @@ static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
         }
     }
 
-    window_close( &wind_ctx );
-
-    fft_close( p_state );
-
     free( height );
 
     return 0;
+
+error:
+    spectrum_Free( p_data );
+    p_effect->p_data = NULL;
+    return -1;
 }
 
 static void spectrum_Free( void *data )
@@ -376,7 +333,9 @@ static void spectrum_Free( void *data )
     {
         free( p_data->peaks );
         free( p_data->prev_heights );
-        free( p_data->p_prev_s16_buff );
+        window_close( &p_data->wind_ctx );
+        if( p_data->p_state )
+            fft_close( p_data->p_state );
         free( p_data );
     }
 }
@@ -389,19 +348,19 @@ typedef struct
 {
     int *peaks;
 
-    unsigned i_prev_nb_samples;
-    int16_t *p_prev_s16_buff;
-
-    window_param wind_param;
+    fft_state *p_state;                 /* internal FFT data */
+    window_context wind_ctx;            /* internal window data */
 } spectrometer_data;
 
+static void spectrometer_Free( void * );
+
 static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
                             const block_t * p_buffer , picture_t * p_picture)
 {
 #define Y(R,G,B) ((uint8_t)( (R * .299) + (G * .587) + (B * .114) ))
 #define U(R,G,B) ((uint8_t)( (R * -.169) + (G * -.332) + (B * .500) + 128 ))
 #define V(R,G,B) ((uint8_t)( (R * .500) + (G * -.419) + (B * -.0813) + 128 ))
-    float p_output[FFT_BUFFER_SIZE];  /* Raw FFT Result  */
+    float p_output[FFT_BUFFER_SIZE] = { 0 }; /* Raw FFT Result  */
     int *height;                      /* Bar heights */
     int *peaks;                       /* Peaks */
     int i_80_bands;                   /* number of bands : 80 if true else 20 */
@@ -442,19 +401,11 @@ static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
     const int *xscale;
     const double y_scale =  3.60673760222;  /* (log 256) */
 
-    fft_state *p_state;                 /* internal FFT data */
-    DEFINE_WIND_CONTEXT( wind_ctx );    /* internal window data */
-
     int i , j , k;
     int i_line = 0;
     int16_t p_dest[FFT_BUFFER_SIZE];      /* Adapted FFT result */
     int16_t p_buffer1[FFT_BUFFER_SIZE];   /* Buffer on which we perform
                                              the FFT (first channel) */
-    float *p_buffl =                     /* Original buffer */
-            (float*)p_buffer->p_buffer;
-
-    int16_t  *p_buffs;                    /* int16_t converted buffer */
-    int16_t  *p_s16_buff;                /* int16_t converted buffer */
 
     if (!p_buffer->i_nb_samples) {
         msg_Err(p_aout, "no samples yet");
@@ -465,6 +416,8 @@ static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
     spectrometer_data *p_data = p_effect->p_data;
     if( !p_data )
     {
+        window_param wind_param;
+
         p_data = malloc( sizeof(spectrometer_data) );
         if( !p_data )
             return -1;
@@ -474,25 +427,24 @@ static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
             free( p_data );
             return -1;
         }
-        p_data->i_prev_nb_samples = 0;
-        p_data->p_prev_s16_buff = NULL;
-        window_get_param( p_aout, &p_data->wind_param );
         p_effect->p_data = (void*)p_data;
-    }
-    peaks = p_data->peaks;
 
-    /* Allocate the buffer only if the number of samples change */
-    if( p_buffer->i_nb_samples != p_data->i_prev_nb_samples )
-    {
-        free( p_data->p_prev_s16_buff );
-        p_data->p_prev_s16_buff = vlc_alloc( p_buffer->i_nb_samples *
-                                             p_effect->i_nb_chans,
-                                             sizeof(int16_t));
-        p_data->i_prev_nb_samples = p_buffer->i_nb_samples;
-        if( !p_data->p_prev_s16_buff )
-            return -1;
+        /* The FFT and window tables do not depend on the samples */
+        p_data->wind_ctx = (window_context){ NULL, 0 };
+        p_data->p_state = visual_fft_init();
+        if( !p_data->p_state )
+        {
+            msg_Err(p_aout,"unable to initialize FFT transform");
+            goto error;
+        }
+        window_get_param( p_aout, &wind_param );
+        if( !window_init( FFT_BUFFER_SIZE, &wind_param, &p_data->wind_ctx ) )
+        {
+            msg_Err(p_aout,"unable to initialize FFT window");
+            goto error;
+        }
     }
-    p_buffs = p_s16_buff = p_data->p_prev_s16_buff;
+    peaks = p_data->peaks;
 
     i_original     = var_InheritInteger( p_aout, "spect-show-original" );
     i_80_bands     = var_InheritInteger( p_aout, "spect-80-bands" );
@@ -522,44 +474,10 @@ static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
     if( !height)
         return -1;
 
-    /* Convert the buffer to int16_t  */
-    /* Pasted from float32tos16.c */
-    for (i = p_buffer->i_nb_samples * p_effect->i_nb_chans; i--; )
-    {
-        union { float f; int32_t i; } u;
-        u.f = *p_buffl + 384.0;
-        if(u.i >  0x43c07fff ) * p_buffs = 32767;
-        else if ( u.i < 0x43bf8000 ) *p_buffs = -32768;
-        else *p_buffs = u.i - 0x43c00000;
-
-        p_buffl++ ; p_buffs++ ;
-    }
-    p_state  = visual_fft_init();
-    if( !p_state)
-    {
-        msg_Err(p_aout,"unable to initialize FFT transform");
-        free( height );
-        return -1;
-    }
-    if( !window_init( FFT_BUFFER_SIZE, &p_data->wind_param, &wind_ctx ) )
-    {
-        fft_close( p_state );
-        free( height );
-        msg_Err(p_aout,"unable to initialize FFT window");
-        return -1;
-    }
-    p_buffs = p_s16_buff;
-    for ( i = 0 ; i < FFT_BUFFER_SIZE; i++)
-    {
-        p_output[i]    = 0;
-        p_buffer1[i] = *p_buffs;
-
-        p_buffs += p_effect->i_nb_chans;
-        if( p_buffs >= &p_s16_buff[p_buffer->i_nb_samples * p_effect->i_nb_chans] )
-            p_buffs = p_s16_buff;
-    }
-    window_scale_in_place( p_buffer1, &wind_ctx );
-    fft_perform( p_buffer1, p_output, p_state);
+    fft_get_input( (const float *)p_buffer->p_buffer, p_buffer->i_nb_samples,
+                   p_effect->i_nb_chans, p_buffer1 );
+    window_scale_in_place( p_buffer1, &p_data->wind_ctx );
+    fft_perform( p_buffer1, p_output, p_data->p_state );
     for(i = 0; i < FFT_BUFFER_SIZE; i++)
     {
         int sqrti = sqrt(p_output[i]);
@@ -856,13 +774,14 @@ static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
         }
     }
 
-    window_close( &wind_ctx );
-
-    fft_close( p_state );
-
     free( height );
 
     return 0;
+
+error:
+    spectrometer_Free( p_data );
+    p_effect->p_data = NULL;
+    return -1;
 }
 
 static void spectrometer_Free( void *data )
@@ -872,7 +791,9 @@ static void spectrometer_Free( void *data )
     if( p_data != NULL )
     {
         free( p_data->peaks );
-        free( p_data->p_prev_s16_buff );
+        window_close( &p_data->wind_ctx );
+        if( p_data->p_state )
+            fft_close( p_data->p_state );
         free( p_data );
     }
 }
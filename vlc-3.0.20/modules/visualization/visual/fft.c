@@ -24,6 +24,7 @@
  *****************************************************************************/
 
 #include <stdlib.h>
+#include <stdint.h>
 #include "fft.h"
 
 #include <math.h>
@@ -105,6 +106,37 @@ void fft_close(fft_state *state) {
     free( state );
 }
 
+/*
+ * Extract the FFT input from the first channel of interleaved float samples,
+ * looping over them if there are less than FFT_BUFFER_SIZE of them.
+ *
+ * The input array is assumed to have FFT_BUFFER_SIZE elements.
+ */
+void fft_get_input(const float *samples, unsigned nb_samples,
+                   unsigned channels, sound_sample *input)
+{
+    const float *p_sample = samples;
+    const float *p_end = samples + nb_samples * channels;
+    unsigned int i;
+
+    for(i = 0; i < FFT_BUFFER_SIZE; i++)
+    {
+        /* Pasted from float32tos16.c */
+        union { float f; int32_t i; } u;
+        u.f = *p_sample + 384.f;
+        if(u.i > 0x43c07fff)
+            input[i] = 32767;
+        else if(u.i < 0x43bf8000)
+            input[i] = -32768;
+        else
+            input[i] = u.i - 0x43c00000;
+
+        p_sample += channels;
+        if(p_sample >= p_end)
+            p_sample = samples;
+    }
+}
+
 /*****************************************************************************
  * These functions are called from the other ones
  *****************************************************************************/
@@ -51,6 +51,8 @@ typedef struct _struct_fft_state fft_state;
 fft_state *visual_fft_init (void);
 void fft_perform (const sound_sample *input, float *output, fft_state *state);
 void fft_close (fft_state *state);
+void fft_get_input (const float *samples, unsigned nb_samples,
+                    unsigned channels, sound_sample *input);
 
 
 #endif /* include-guard */
@@ -225,24 +225,8 @@ function file(h,path,url,mime)
 end
 
 function rawfile(h,path,url)
-    local filename = path
-    local mtime = 0    -- vlc.net.stat(filename).modification_time
-    local page = false -- io.open(filename):read("*a")
-    local callback = function(data,request)
-        local new_mtime = vlc.net.stat(filename).modification_time
-        if page == false or new_mtime ~= mtime then
-            -- Re-read the file if it changed
-            if page == false then
-                vlc.msg.dbg("Loading `"..filename.."'")
-            else
-                vlc.msg.dbg("Reloading `"..filename.."'")
-            end
-            page = io.open(filename,"rb"):read("*a")
-            mtime = new_mtime
-        end
-        return page
-    end
-    return h:file(url or path,nil,nil,password,callback,nil)
+    -- Served from disk by the daemon, without loading the file in memory
+    return h:rawfile(url or path,path,nil,nil,password)
 end
 
 function parse_url_request(request)
@@ -26,6 +26,7 @@
 
 # include <vlc_atomic.h>
 # include <vlc_viewpoint.h>
+# include <vlc_input_item.h>
 
 /* Max input rate factor (1/4 -> 4) */
 # define AOUT_MAX_INPUT_RATE (4)
@@ -81,6 +82,11 @@ typedef struct
         unsigned resamp_start_drift; /**< Resampler drift absolute value */
         int resamp_type; /**< Resampler mode (FIXME: redundant / resampling) */
         bool discontinuity;
+        vlc_tick_t latency; /**< Low latency target (or 0 if disabled) */
+        vlc_tick_t jitter; /**< Estimated output timing jitter */
+        vlc_tick_t last_drift; /**< Previous drift (for jitter estimation) */
+        atomic_int_least64_t lead; /**< Advance of buffers sent to the aout */
+        bool free_run; /**< No timing checks nor drift correction */
     } sync;
 
     int initial_stereo_mode; /**< Initial stereo mode set by options */
@@ -93,6 +99,7 @@ typedef struct
 
     atomic_uint buffers_lost;
     atomic_uint buffers_played;
+    atomic_uint latency_hist[INPUT_STATS_LATENCY_BUCKETS];
     atomic_uchar restart;
 } aout_owner_t;
 
@@ -155,8 +162,11 @@ int aout_DecNew(audio_output_t *, const audio_sample_format_t *,
 void aout_DecDelete(audio_output_t *);
 int aout_DecPlay(audio_output_t *, block_t *, int i_input_rate);
 void aout_DecGetResetStats(audio_output_t *, unsigned *, unsigned *);
+void aout_DecGetResetLatency(audio_output_t *,
+                             unsigned [INPUT_STATS_LATENCY_BUCKETS]);
 void aout_DecChangePause(audio_output_t *, bool b_paused, vlc_tick_t i_date);
 void aout_DecFlush(audio_output_t *, bool wait);
+vlc_tick_t aout_DecLeadTime(audio_output_t *);
 void aout_RequestRestart (audio_output_t *, unsigned);
 
 static inline void aout_InputRequestRestart(audio_output_t *aout)
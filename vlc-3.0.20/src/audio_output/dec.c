@@ -33,10 +33,13 @@
 #include <vlc_common.h>
 #include <vlc_aout.h>
 #include <vlc_input.h>
+#include <vlc_trace.h>
 
 #include "aout_internal.h"
 #include "libvlc.h"
 
+#define AOUT_DRIFT_INVALID INT64_MIN
+
 /**
  * Creates an audio output
  */
@@ -110,10 +113,21 @@ error:
     owner->sync.end = VLC_TICK_INVALID;
     owner->sync.resamp_type = AOUT_RESAMPLING_NONE;
     owner->sync.discontinuity = true;
+    owner->sync.latency = aout_LatencyTarget (p_aout);
+    owner->sync.jitter = 0;
+    owner->sync.last_drift = AOUT_DRIFT_INVALID;
+    owner->sync.free_run = var_InheritBool (p_aout, "free-run");
+    atomic_store (&owner->sync.lead, owner->sync.latency > 0
+                  ? owner->sync.latency : AOUT_MAX_PREPARE_TIME);
+    if (owner->sync.latency > 0)
+        msg_Dbg (p_aout, "low latency mode (target: %"PRId64" us)",
+                 owner->sync.latency);
     aout_OutputUnlock (p_aout);
 
     atomic_init (&owner->buffers_lost, 0);
     atomic_init (&owner->buffers_played, 0);
+    for (unsigned i = 0; i < INPUT_STATS_LATENCY_BUCKETS; i++)
+        atomic_init (&owner->latency_hist[i], 0);
     atomic_store (&owner->vp.update, true);
     return 0;
 }
@@ -233,11 +247,59 @@ static void aout_DecSilence (audio_output_t *aout, vlc_tick_t length, vlc_tick_t
     aout_OutputPlay (aout, block);
 }
 
+/**
+ * Estimates the output timing jitter in low latency mode, and derives the
+ * synchronization tolerances and the buffering advance from it.
+ *
+ * The jitter is the smoothed variation of the drift from one buffer to the
+ * next, as for the RTP interarrival jitter (RFC 3550 section 6.4.1). It
+ * mostly accounts for the granularity of the output callbacks (periods) and
+ * for the scheduling latency.
+ */
+static void aout_DecUpdateLatency (audio_output_t *aout, vlc_tick_t drift,
+                                   vlc_tick_t *restrict max_delay,
+                                   vlc_tick_t *restrict max_advance)
+{
+    aout_owner_t *owner = aout_owner (aout);
+
+    if (owner->sync.last_drift != AOUT_DRIFT_INVALID)
+    {
+        const vlc_tick_t d = llabs (drift - owner->sync.last_drift);
+        owner->sync.jitter += (d - owner->sync.jitter) / 16;
+    }
+    owner->sync.last_drift = drift;
+
+    const vlc_tick_t tolerance = __MAX(3 * owner->sync.jitter,
+                                       AOUT_LOW_LATENCY_MIN_TOLERANCE);
+    *max_delay = __MIN(tolerance, AOUT_MAX_PTS_DELAY);
+    *max_advance = __MIN(tolerance, AOUT_MAX_PTS_ADVANCE);
+
+    /* Queue enough data ahead to absorb the jitter */
+    const vlc_tick_t lead = owner->sync.latency + 4 * owner->sync.jitter;
+    atomic_store_explicit (&owner->sync.lead,
+                           __MIN(lead, AOUT_MAX_PREPARE_TIME),
+                           memory_order_relaxed);
+}
+
+/**
+ * Returns how long in advance of their PTS buffers should be passed to
+ * aout_DecPlay(). This is AOUT_MAX_PREPARE_TIME, unless the low latency mode
+ * is enabled.
+ */
+vlc_tick_t aout_DecLeadTime (audio_output_t *aout)
+{
+    aout_owner_t *owner = aout_owner (aout);
+
+    return atomic_load_explicit (&owner->sync.lead, memory_order_relaxed);
+}
+
 static void aout_DecSynchronize (audio_output_t *aout, vlc_tick_t dec_pts,
                                  int input_rate)
 {
     aout_owner_t *owner = aout_owner (aout);
     vlc_tick_t drift;
+    vlc_tick_t max_delay = AOUT_MAX_PTS_DELAY;
+    vlc_tick_t max_advance = AOUT_MAX_PTS_ADVANCE;
 
     /**
      * Depending on the drift between the actual and intended playback times,
@@ -259,6 +321,11 @@ static void aout_DecSynchronize (audio_output_t *aout, vlc_tick_t dec_pts,
         return; /* nothing can be done if timing is unknown */
     drift += mdate () - dec_pts;
 
+    /* In low latency mode, the tolerances follow the measured jitter
+     * instead of the EBU recommendation. */
+    if (owner->sync.latency > 0)
+        aout_DecUpdateLatency (aout, drift, &max_delay, &max_advance);
+
     /* Late audio output.
      * This can happen due to insufficient caching, scheduling jitter
      * or bug in the decoder. Ideally, the output would seek backward. But that
@@ -266,7 +333,7 @@ static void aout_DecSynchronize (audio_output_t *aout, vlc_tick_t dec_pts,
      * where supported. The other alternative is to flush the buffers
      * completely. */
     if (drift > (owner->sync.discontinuity ? 0
-                  : +3 * input_rate * AOUT_MAX_PTS_DELAY / INPUT_RATE_DEFAULT))
+                  : +3 * input_rate * max_delay / INPUT_RATE_DEFAULT))
     {
         if (!owner->sync.discontinuity)
             msg_Warn (aout, "playback way too late (%"PRId64"): "
@@ -279,6 +346,7 @@ static void aout_DecSynchronize (audio_output_t *aout, vlc_tick_t dec_pts,
         aout_StopResampling (aout);
         owner->sync.end = VLC_TICK_INVALID;
         owner->sync.discontinuity = true;
+        owner->sync.last_drift = AOUT_DRIFT_INVALID;
 
         /* Now the output might be too early... Recheck. */
         if (aout_OutputTimeGet (aout, &drift) != 0)
@@ -289,7 +357,7 @@ static void aout_DecSynchronize (audio_output_t *aout, vlc_tick_t dec_pts,
     /* Early audio output.
      * This is rare except at startup when the buffers are still empty. */
     if (drift < (owner->sync.discontinuity ? 0
-                : -3 * input_rate * AOUT_MAX_PTS_ADVANCE / INPUT_RATE_DEFAULT))
+                : -3 * input_rate * max_advance / INPUT_RATE_DEFAULT))
     {
         if (!owner->sync.discontinuity)
             msg_Warn (aout, "playback way too early (%"PRId64"): "
@@ -298,6 +366,7 @@ static void aout_DecSynchronize (audio_output_t *aout, vlc_tick_t dec_pts,
 
         aout_StopResampling (aout);
         owner->sync.discontinuity = true;
+        owner->sync.last_drift = AOUT_DRIFT_INVALID;
         drift = 0;
     }
 
@@ -305,7 +374,7 @@ static void aout_DecSynchronize (audio_output_t *aout, vlc_tick_t dec_pts,
         return;
 
     /* Resampling */
-    if (drift > +AOUT_MAX_PTS_DELAY
+    if (drift > +max_delay
      && owner->sync.resamp_type != AOUT_RESAMPLING_UP)
     {
         msg_Warn (aout, "playback too late (%"PRId64"): up-sampling",
@@ -313,7 +382,7 @@ static void aout_DecSynchronize (audio_output_t *aout, vlc_tick_t dec_pts,
         owner->sync.resamp_type = AOUT_RESAMPLING_UP;
         owner->sync.resamp_start_drift = +drift;
     }
-    if (drift < -AOUT_MAX_PTS_ADVANCE
+    if (drift < -max_advance
      && owner->sync.resamp_type != AOUT_RESAMPLING_DOWN)
     {
         msg_Warn (aout, "playback too early (%"PRId64"): down-sampling",
@@ -364,14 +433,16 @@ int aout_DecPlay (audio_output_t *aout, block_t *block, int input_rate)
 
     block->i_length = CLOCK_FREQ * block->i_nb_samples
                                  / owner->input_format.i_rate;
+    const vlc_tick_t ingest = block->i_ingest;
 
+    vlc_trace_begin ("aout", "play");
     aout_OutputLock (aout);
     int ret = aout_CheckReady (aout);
     if (unlikely(ret == AOUT_DEC_FAILED))
         goto drop; /* Pipeline is unrecoverably broken :-( */
 
     const vlc_tick_t now = mdate (), advance = block->i_pts - now;
-    if (advance < -AOUT_MAX_PTS_DELAY)
+    if (advance < -AOUT_MAX_PTS_DELAY && !owner->sync.free_run)
     {   /* Late buffer can be caused by bugs in the decoder, by scheduling
          * latency spikes (excessive load, SIGSTOP, etc.) or if buffering is
          * insufficient. We assume the PTS is wrong and play the buffer anyway:
@@ -379,7 +450,7 @@ int aout_DecPlay (audio_output_t *aout, block_t *block, int input_rate)
         msg_Warn (aout, "buffer too late (%"PRId64" us): dropped", advance);
         goto drop;
     }
-    if (advance > AOUT_MAX_ADVANCE_TIME)
+    if (advance > AOUT_MAX_ADVANCE_TIME && !owner->sync.free_run)
     {   /* Early buffers can only be caused by bugs in the decoder. */
         msg_Err (aout, "buffer too early (%"PRId64" us): dropped", advance);
         goto drop;
@@ -394,7 +465,9 @@ int aout_DecPlay (audio_output_t *aout, block_t *block, int input_rate)
         vlc_mutex_unlock (&owner->vp.lock);
     }
 
+    vlc_trace_begin ("aout", "filters");
     block = aout_FiltersPlay (owner->filters, block, input_rate);
+    vlc_trace_end ("aout", "filters");
     if (block == NULL)
         goto lost;
 
@@ -402,15 +475,24 @@ int aout_DecPlay (audio_output_t *aout, block_t *block, int input_rate)
     aout_volume_Amplify (owner->volume, block);
 
     /* Drift correction */
-    aout_DecSynchronize (aout, block->i_pts, input_rate);
+    if (!owner->sync.free_run)
+        aout_DecSynchronize (aout, block->i_pts, input_rate);
 
     /* Output */
     owner->sync.end = block->i_pts + block->i_length + 1;
     owner->sync.discontinuity = false;
+    if (ingest != VLC_TICK_INVALID)
+    {   /* The buffer is due at its (system) date */
+        unsigned bucket = input_stats_LatencyBucket (block->i_pts - ingest);
+        atomic_fetch_add (&owner->latency_hist[bucket], 1);
+    }
+    vlc_trace_begin ("aout", "output");
     aout_OutputPlay (aout, block);
+    vlc_trace_end ("aout", "output");
     atomic_fetch_add(&owner->buffers_played, 1);
 out:
     aout_OutputUnlock (aout);
+    vlc_trace_end ("aout", "play");
     return ret;
 drop:
     owner->sync.discontinuity = true;
@@ -429,6 +511,15 @@ void aout_DecGetResetStats(audio_output_t *aout, unsigned *restrict lost,
     *played = atomic_exchange(&owner->buffers_played, 0);
 }
 
+void aout_DecGetResetLatency(audio_output_t *aout,
+                             unsigned latency[INPUT_STATS_LATENCY_BUCKETS])
+{
+    aout_owner_t *owner = aout_owner (aout);
+
+    for (unsigned i = 0; i < INPUT_STATS_LATENCY_BUCKETS; i++)
+        latency[i] = atomic_exchange(&owner->latency_hist[i], 0);
+}
+
 void aout_DecChangePause (audio_output_t *aout, bool paused, vlc_tick_t date)
 {
     aout_owner_t *owner = aout_owner (aout);
@@ -452,6 +543,7 @@ void aout_DecFlush (audio_output_t *aout, bool wait)
 
     aout_OutputLock (aout);
     owner->sync.end = VLC_TICK_INVALID;
+    owner->sync.last_drift = AOUT_DRIFT_INVALID;
     if (owner->mixer_format.i_format)
     {
         if (wait)
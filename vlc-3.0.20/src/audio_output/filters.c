@@ -289,6 +289,166 @@ static block_t *aout_FiltersPipelinePlay(filter_t *const *filters,
     return block;
 }
 
+/** Amount of data of the widest format of a chain that its filters are run
+ * on at once, small enough for a chunk to stay in the CPU caches through all
+ * the filters */
+#define AOUT_FILTERS_CHUNK_SIZE (16 * 1024)
+
+/**
+ * Returns how many frames a chain of filters can be run on at once, or 0 if
+ * blocks must be passed whole.
+ */
+static unsigned aout_FiltersPipelineChunkFrames(filter_t *const *filters,
+                                                unsigned count)
+{
+    unsigned bytes_per_frame = 0;
+
+    if (count < 2)
+        return 0; /* nothing to keep in cache between filters */
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        const audio_format_t *in = &filters[i]->fmt_in.audio;
+        const audio_format_t *out = &filters[i]->fmt_out.audio;
+
+        if (!filters[i]->b_audio_chunks
+         || !AOUT_FMT_LINEAR(in) || !AOUT_FMT_LINEAR(out)
+         || in->i_bytes_per_frame == 0 || out->i_bytes_per_frame == 0
+         || in->i_frame_length != 1 || out->i_frame_length != 1)
+            return 0;
+        bytes_per_frame = __MAX(bytes_per_frame, in->i_bytes_per_frame);
+        bytes_per_frame = __MAX(bytes_per_frame, out->i_bytes_per_frame);
+    }
+    return __MAX(AOUT_FILTERS_CHUNK_SIZE / bytes_per_frame, 32);
+}
+
+static void aout_FiltersChunkRelease(block_t *chunk)
+{
+    (void) chunk; /* the data belongs to the whole block */
+}
+
+/**
+ * Appends the output of a chunk to the output block of the pipeline.
+ */
+static block_t *aout_FiltersChunkAppend(block_t *out, size_t *restrict used,
+                                        block_t *chunk)
+{
+    if (out == NULL)
+    {
+        out = block_Alloc(2 * chunk->i_buffer);
+        if (unlikely(out == NULL))
+            return NULL;
+        block_CopyProperties(out, chunk);
+        out->i_nb_samples = 0;
+        out->i_length = 0;
+        *used = 0;
+    }
+    else if (out->i_buffer - *used < chunk->i_buffer)
+    {
+        block_t *rea = block_TryRealloc(out, 0,
+                                 __MAX(2 * out->i_buffer, *used + chunk->i_buffer));
+        if (unlikely(rea == NULL))
+            return out; /* drop the chunk */
+        out = rea;
+    }
+
+    memcpy(out->p_buffer + *used, chunk->p_buffer, chunk->i_buffer);
+    *used += chunk->i_buffer;
+    out->i_nb_samples += chunk->i_nb_samples;
+    out->i_length += chunk->i_length;
+    return out;
+}
+
+/**
+ * Filters an audio buffer through a chain of filters, in chunks of frames.
+ *
+ * Each chunk goes through all the filters before the next one, so that the
+ * intermediate buffers stay in the CPU caches. Chunks are views of the input
+ * block: as long as all the filters work in place, the block is returned as
+ * is and its data is only accessed once. Otherwise the outputs of the chunks
+ * are gathered in a new block.
+ */
+static block_t *aout_FiltersPipelinePlayChunks(filter_t *const *filters,
+                                               unsigned count, block_t *block,
+                                               unsigned frames)
+{
+    const audio_format_t *fmt = &filters[0]->fmt_in.audio;
+    const size_t chunk_size = frames * fmt->i_bytes_per_frame;
+    block_t *out = NULL;
+    size_t used = 0;
+    bool in_place = true;
+
+    for (size_t offset = 0; offset < block->i_buffer; offset += chunk_size)
+    {
+        const size_t size = __MIN(chunk_size, block->i_buffer - offset);
+        const unsigned chunk_frames = size / fmt->i_bytes_per_frame;
+        /* The rate of the first filter can be overridden for the playback
+         * rate, so the timestamps are based on the block duration. */
+        const mtime_t pts_offset = block->i_length * offset / block->i_buffer;
+        block_t chunk, *res;
+
+        block_Init(&chunk, block->p_buffer + offset, size);
+        chunk.pf_release = aout_FiltersChunkRelease;
+        chunk.i_flags = offset == 0 ? block->i_flags : 0;
+        chunk.i_nb_samples = chunk_frames;
+        chunk.i_pts = block->i_pts != VLC_TS_INVALID
+                    ? block->i_pts + pts_offset : VLC_TS_INVALID;
+        chunk.i_dts = block->i_dts != VLC_TS_INVALID
+                    ? block->i_dts + pts_offset : VLC_TS_INVALID;
+        chunk.i_length = block->i_length * (offset + size) / block->i_buffer
+                       - pts_offset;
+
+        res = aout_FiltersPipelinePlay(filters, count, &chunk);
+
+        if (in_place && res == &chunk
+         && res->p_buffer == block->p_buffer + offset && res->i_buffer == size)
+            continue; /* filtered in place */
+
+        if (in_place && offset > 0)
+        {   /* Gather the chunks filtered in place so far */
+            block_t head;
+
+            block_Init(&head, block->p_buffer, offset);
+            block_CopyProperties(&head, block);
+            head.i_nb_samples = offset / fmt->i_bytes_per_frame;
+            head.i_length = pts_offset;
+            out = aout_FiltersChunkAppend(NULL, &used, &head);
+        }
+        in_place = false;
+
+        if (res != NULL)
+        {
+            out = aout_FiltersChunkAppend(out, &used, res);
+            block_Release(res);
+        }
+    }
+
+    if (in_place)
+        return block;
+
+    block_Release(block);
+    if (out == NULL)
+        return NULL;
+    out->i_buffer = used;
+    return out;
+}
+
+/**
+ * Filters an audio buffer through a chain of filters, in chunks of frames
+ * if the filters allow it and the buffer is large enough.
+ */
+static block_t *aout_FiltersPipelinePlayFused(filter_t *const *filters,
+                                              unsigned count, block_t *block)
+{
+    unsigned frames = aout_FiltersPipelineChunkFrames(filters, count);
+
+    if (frames == 0 || block->i_nb_samples <= frames + frames / 2
+     || block->i_buffer != block->i_nb_samples
+                           * filters[0]->fmt_in.audio.i_bytes_per_frame)
+        return aout_FiltersPipelinePlay(filters, count, block);
+    return aout_FiltersPipelinePlayChunks(filters, count, block, frames);
+}
+
 
 /**
  * Drain the chain of filters.
@@ -713,14 +873,21 @@ block_t *aout_FiltersPlay (aout_filters_t *filters, block_t *block, int rate)
             (nominal_rate * INPUT_RATE_DEFAULT) / rate;
     }
 
-    block = aout_FiltersPipelinePlay (filters->tab, filters->count, block);
     if (filters->resampler != NULL)
     {   /* NOTE: the resampler needs to run even if resampling is 0.
          * The decoder and output rates can still be different. */
+        filter_t *chain[AOUT_MAX_FILTERS + 1];
+
+        memcpy (chain, filters->tab, filters->count * sizeof (*chain));
+        chain[filters->count] = filters->resampler;
         filters->resampler->fmt_in.audio.i_rate += filters->resampling;
-        block = aout_FiltersPipelinePlay (&filters->resampler, 1, block);
+        block = aout_FiltersPipelinePlayFused (chain, filters->count + 1,
+                                               block);
         filters->resampler->fmt_in.audio.i_rate -= filters->resampling;
     }
+    else
+        block = aout_FiltersPipelinePlayFused (filters->tab, filters->count,
+                                               block);
 
     if (nominal_rate != 0)
     {   /* Restore input rate */
@@ -0,0 +1,172 @@
+/*****************************************************************************
+ * ring.c : lock-free audio ring buffer
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_atomic.h>
+
+#define RING_CACHE_LINE 64
+
+/* The read and write positions are free-running byte counters: the number of
+ * queued bytes is always write - read, and the buffer offset is the counter
+ * masked with the (power of two) capacity. Each counter is only ever stored
+ * by one side, and lives on its own cache line so that the producer and the
+ * consumer do not bounce it. */
+struct aout_ring
+{
+    uint8_t *buf;
+    size_t   capacity;
+    size_t   mask;
+
+    /* Stored by the producer */
+    char pad0[RING_CACHE_LINE];
+    atomic_size_t write;
+    atomic_size_t flush; /* write position at the last flush */
+
+    /* Stored by the consumer */
+    char pad1[RING_CACHE_LINE - 2 * sizeof (atomic_size_t)];
+    atomic_size_t read;
+    char pad2[RING_CACHE_LINE - sizeof (atomic_size_t)];
+};
+
+aout_ring_t *aout_ring_New(size_t size)
+{
+    if (size == 0 || size > (SIZE_MAX >> 2))
+        return NULL;
+
+    size_t capacity = 1;
+    while (capacity < size)
+        capacity <<= 1;
+
+    aout_ring_t *ring = malloc(sizeof (*ring));
+    if (unlikely(ring == NULL))
+        return NULL;
+
+    ring->buf = malloc(capacity);
+    if (unlikely(ring->buf == NULL))
+    {
+        free(ring);
+        return NULL;
+    }
+    ring->capacity = capacity;
+    ring->mask = capacity - 1;
+    atomic_init(&ring->write, 0);
+    atomic_init(&ring->flush, 0);
+    atomic_init(&ring->read, 0);
+    return ring;
+}
+
+void aout_ring_Delete(aout_ring_t *ring)
+{
+    free(ring->buf);
+    free(ring);
+}
+
+/* Returns the first position that is not flushed, given the read position */
+static inline size_t ring_Start(const aout_ring_t *ring, size_t read,
+                                size_t flush)
+{
+    /* The flush position is only relevant if it is ahead of the read
+     * position, i.e. the consumer did not go past it yet. */
+    size_t skip = flush - read;
+    return (skip != 0 && skip <= ring->capacity) ? flush : read;
+}
+
+size_t aout_ring_Write(aout_ring_t *ring, const void *buf, size_t size)
+{
+    const size_t write = atomic_load_explicit(&ring->write,
+                                              memory_order_relaxed);
+    const size_t read = atomic_load_explicit(&ring->read,
+                                             memory_order_acquire);
+    /* Flushed bytes are still in use until the consumer skips them */
+    const size_t avail = ring->capacity - (write - read);
+
+    if (size > avail)
+        size = avail;
+    if (size == 0)
+        return 0;
+
+    const size_t offset = write & ring->mask;
+    const size_t first = __MIN(size, ring->capacity - offset);
+
+    memcpy(ring->buf + offset, buf, first);
+    memcpy(ring->buf, (const uint8_t *)buf + first, size - first);
+
+    atomic_store_explicit(&ring->write, write + size, memory_order_release);
+    return size;
+}
+
+size_t aout_ring_Read(aout_ring_t *ring, void *buf, size_t size)
+{
+    const size_t flush = atomic_load_explicit(&ring->flush,
+                                              memory_order_acquire);
+    const size_t write = atomic_load_explicit(&ring->write,
+                                              memory_order_acquire);
+    size_t read = atomic_load_explicit(&ring->read, memory_order_relaxed);
+
+    read = ring_Start(ring, read, flush);
+
+    const size_t used = write - read;
+    if (size > used)
+        size = used;
+
+    if (size > 0)
+    {
+        const size_t offset = read & ring->mask;
+        const size_t first = __MIN(size, ring->capacity - offset);
+
+        memcpy(buf, ring->buf + offset, first);
+        memcpy((uint8_t *)buf + first, ring->buf, size - first);
+    }
+
+    atomic_store_explicit(&ring->read, read + size, memory_order_release);
+    return size;
+}
+
+size_t aout_ring_Used(aout_ring_t *ring)
+{
+    const size_t read = atomic_load_explicit(&ring->read,
+                                             memory_order_acquire);
+    const size_t flush = atomic_load_explicit(&ring->flush,
+                                              memory_order_acquire);
+    const size_t write = atomic_load_explicit(&ring->write,
+                                              memory_order_acquire);
+    const size_t start = ring_Start(ring, read, flush);
+
+    /* On the consumer side, the write position may have moved after the
+     * flush position was loaded; on the producer side, the read position
+     * may have moved past the flush position: both are benign. */
+    return write - start <= ring->capacity ? write - start : 0;
+}
+
+void aout_ring_Flush(aout_ring_t *ring)
+{
+    const size_t write = atomic_load_explicit(&ring->write,
+                                              memory_order_relaxed);
+    atomic_store_explicit(&ring->flush, write, memory_order_release);
+}
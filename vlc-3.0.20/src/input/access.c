@@ -200,12 +200,14 @@ static block_t *AStreamReadBlock(stream_t *s, bool *restrict eof)
     if (block != NULL && input != NULL)
     {
         uint64_t total;
+        size_t size;
+        int count;
 
+        block_ChainProperties(block, &count, &size, NULL);
         vlc_mutex_lock(&input_priv(input)->counters.counters_lock);
-        stats_Update(input_priv(input)->counters.p_read_bytes,
-                     block->i_buffer, &total);
+        stats_Update(input_priv(input)->counters.p_read_bytes, size, &total);
         stats_Update(input_priv(input)->counters.p_input_bitrate, total, NULL);
-        stats_Update(input_priv(input)->counters.p_read_packets, 1, NULL);
+        stats_Update(input_priv(input)->counters.p_read_packets, count, NULL);
         vlc_mutex_unlock(&input_priv(input)->counters.counters_lock);
     }
 
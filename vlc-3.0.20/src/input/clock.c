@@ -34,6 +34,7 @@
 #include <vlc_input.h>
 #include "clock.h"
 #include <assert.h>
+#include <math.h>
 
 /* TODO:
  * - clean up locking once clock code is stable
@@ -99,6 +100,36 @@
 /* Due to some problems in es_out, we cannot use a large value yet */
 #define CR_BUFFERING_TARGET (100000)
 
+/* Kalman clock recovery: growth rate of the variance of the clock offset
+ * (in us^2 per us) and of the clock skew (per us), which bound how fast the
+ * estimate can follow actual clock changes. */
+#define CR_KALMAN_OFFSET_NOISE (1e-2)
+#define CR_KALMAN_SKEW_NOISE (1e-18)
+
+/* Kalman clock recovery: initial and minimal standard deviation of the
+ * reception jitter (in CLOCK_FREQ) */
+#define CR_KALMAN_JITTER_INIT (20000)
+#define CR_KALMAN_JITTER_MIN (1000)
+
+/* Kalman clock recovery: clock references further than this many standard
+ * deviations from the prediction are ignored, unless CR_KALMAN_OUTLIERS
+ * of them come in a row (the transmission delay has changed). */
+#define CR_KALMAN_OUTLIER_SIGMA (3.)
+#define CR_KALMAN_OUTLIERS (10)
+
+/* Adaptive delay: margin kept above the peak arrival delay of the clock
+ * references, and lower bound of the delay (in CLOCK_FREQ) */
+#define CR_ADAPT_MARGIN (20000)
+#define CR_ADAPT_DELAY_MIN (40000)
+
+/* Adaptive delay: time constant (in CLOCK_FREQ) with which past delay peaks
+ * are forgotten */
+#define CR_ADAPT_DECAY (30 * CLOCK_FREQ)
+
+/* Adaptive delay: the delay changes by at most 1/CR_ADAPT_RATE of the
+ * elapsed time, so that playback only gets slightly slower or faster */
+#define CR_ADAPT_RATE (100)
+
 /*****************************************************************************
  * Structures
  *****************************************************************************/
@@ -122,6 +153,26 @@ static void    AvgUpdate( average_t *, vlc_tick_t i_value );
 static vlc_tick_t AvgGet( average_t * );
 static void    AvgRescale( average_t *, int i_divider );
 
+/**
+ * This structure holds a Kalman filter of the clock offset and skew
+ */
+typedef struct
+{
+    bool       b_valid;
+    vlc_tick_t i_date; /* system date of the last update */
+
+    double     f_offset;
+    double     f_skew;
+    double     pf_cov[2][2];
+    double     f_jitter; /* measurement noise variance */
+
+    unsigned   i_outliers;
+    double     f_outlier_min;
+} kalman_t;
+static void    KalmanReset( kalman_t * );
+static void    KalmanUpdate( kalman_t *, vlc_tick_t i_date, vlc_tick_t i_value );
+static vlc_tick_t KalmanGet( const kalman_t * );
+
 /* */
 typedef struct
 {
@@ -157,6 +208,12 @@ struct input_clock_t
     /* Clock drift */
     vlc_tick_t i_next_drift_update;
     average_t drift;
+    bool b_kalman;
+    kalman_t kalman;
+
+    /* Adaptive delay */
+    bool b_adaptive;
+    vlc_tick_t i_delay_peak;
 
     /* Late statistics */
     struct
@@ -177,6 +234,7 @@ struct input_clock_t
     bool    b_paused;
     int     i_rate;
     vlc_tick_t i_pts_delay;
+    vlc_tick_t i_pts_delay_target;
     vlc_tick_t i_pause_date;
 };
 
@@ -184,11 +242,14 @@ static vlc_tick_t ClockStreamToSystem( input_clock_t *, vlc_tick_t i_stream );
 static vlc_tick_t ClockSystemToStream( input_clock_t *, vlc_tick_t i_system );
 
 static vlc_tick_t ClockGetTsOffset( input_clock_t * );
+static vlc_tick_t ClockGetDrift( input_clock_t * );
+static void ClockAdaptDelay( input_clock_t *, vlc_tick_t i_delay,
+                             vlc_tick_t i_elapsed );
 
 /*****************************************************************************
  * input_clock_New: create a new clock
  *****************************************************************************/
-input_clock_t *input_clock_New( int i_rate )
+input_clock_t *input_clock_New( int i_rate, bool b_kalman, bool b_adaptive )
 {
     input_clock_t *cl = malloc( sizeof(*cl) );
     if( !cl )
@@ -207,6 +268,10 @@ input_clock_t *input_clock_New( int i_rate )
 
     cl->i_next_drift_update = VLC_TICK_INVALID;
     AvgInit( &cl->drift, 10 );
+    cl->b_kalman = b_kalman;
+    KalmanReset( &cl->kalman );
+    cl->b_adaptive = b_adaptive;
+    cl->i_delay_peak = 0;
 
     cl->late.i_index = 0;
     for( int i = 0; i < INPUT_CLOCK_LATE_COUNT; i++ )
@@ -214,6 +279,7 @@ input_clock_t *input_clock_New( int i_rate )
 
     cl->i_rate = i_rate;
     cl->i_pts_delay = 0;
+    cl->i_pts_delay_target = 0;
     cl->b_paused = false;
     cl->i_pause_date = VLC_TICK_INVALID;
 
@@ -272,6 +338,8 @@ void input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
     {
         cl->i_next_drift_update = VLC_TICK_INVALID;
         AvgReset( &cl->drift );
+        KalmanReset( &cl->kalman );
+        cl->i_delay_peak = 0;
 
         /* Feed synchro with a new reference point. */
         cl->b_has_reference = true;
@@ -282,7 +350,13 @@ void input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
 
     /* Compute the drift between the stream clock and the system clock
      * when we don't control the source pace */
-    if( !b_can_pace_control && cl->i_next_drift_update < i_ck_system )
+    if( !b_can_pace_control && cl->b_kalman )
+    {
+        const vlc_tick_t i_converted = ClockSystemToStream( cl, i_ck_system );
+
+        KalmanUpdate( &cl->kalman, i_ck_system, i_converted - i_ck_stream );
+    }
+    else if( !b_can_pace_control && cl->i_next_drift_update < i_ck_system )
     {
         const vlc_tick_t i_converted = ClockSystemToStream( cl, i_ck_system );
 
@@ -310,11 +384,23 @@ void input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
     //fprintf( stderr, "input_clock_Update: %d :: %lld\n", b_buffering_allowed, cl->i_buffering_duration/1000 );
 
     /* */
+    const vlc_tick_t i_elapsed = b_reset_reference ? 0
+                               : i_ck_system - cl->last.i_system;
     cl->last = clock_point_Create( i_ck_stream, i_ck_system );
 
     /* It does not take the decoder latency into account but it is not really
      * the goal of the clock here */
-    const vlc_tick_t i_system_expected = ClockStreamToSystem( cl, i_ck_stream + AvgGet( &cl->drift ) );
+    const vlc_tick_t i_system_expected = ClockStreamToSystem( cl, i_ck_stream + ClockGetDrift( cl ) );
+    if( cl->b_adaptive && !b_can_pace_control && i_elapsed > 0 )
+        ClockAdaptDelay( cl, i_ck_system - i_system_expected,
+                         __MIN( i_elapsed, CLOCK_FREQ ) );
+    else if( cl->i_pts_delay < cl->i_pts_delay_target && i_elapsed > 0 )
+    {
+        /* Catch up with the jitter delay after a fast start */
+        const vlc_tick_t i_step = __MIN( i_elapsed, CLOCK_FREQ ) / CR_ADAPT_RATE;
+        cl->i_pts_delay = __MIN( cl->i_pts_delay + i_step,
+                                 cl->i_pts_delay_target );
+    }
     const vlc_tick_t i_late = ( i_ck_system - cl->i_pts_delay ) - i_system_expected;
     *pb_late = i_late > 0;
     if( i_late > 0 )
@@ -394,7 +480,7 @@ vlc_tick_t input_clock_GetWakeup( input_clock_t *cl )
 
     /* Synchronized, we can wait */
     if( cl->b_has_reference )
-        i_wakeup = ClockStreamToSystem( cl, cl->last.i_stream + AvgGet( &cl->drift ) - cl->i_buffering_duration );
+        i_wakeup = ClockStreamToSystem( cl, cl->last.i_stream + ClockGetDrift( cl ) - cl->i_buffering_duration );
 
     vlc_mutex_unlock( &cl->lock );
 
@@ -432,7 +518,7 @@ int input_clock_ConvertTS( vlc_object_t *p_object, input_clock_t *cl,
     /* */
     if( *pi_ts0 > VLC_TICK_INVALID )
     {
-        *pi_ts0 = ClockStreamToSystem( cl, *pi_ts0 + AvgGet( &cl->drift ) );
+        *pi_ts0 = ClockStreamToSystem( cl, *pi_ts0 + ClockGetDrift( cl ) );
         if( *pi_ts0 > cl->i_ts_max )
             cl->i_ts_max = *pi_ts0;
         *pi_ts0 += i_ts_delay;
@@ -441,7 +527,7 @@ int input_clock_ConvertTS( vlc_object_t *p_object, input_clock_t *cl,
     /* XXX we do not update i_ts_max on purpose */
     if( pi_ts1 && *pi_ts1 > VLC_TICK_INVALID )
     {
-        *pi_ts1 = ClockStreamToSystem( cl, *pi_ts1 + AvgGet( &cl->drift ) ) +
+        *pi_ts1 = ClockStreamToSystem( cl, *pi_ts1 + ClockGetDrift( cl ) ) +
                   i_ts_delay;
     }
 
@@ -565,6 +651,8 @@ void input_clock_SetJitter( input_clock_t *cl,
      */
     if( cl->i_pts_delay < i_pts_delay )
         cl->i_pts_delay = i_pts_delay;
+    if( cl->i_pts_delay_target < i_pts_delay )
+        cl->i_pts_delay_target = i_pts_delay;
 
     /* */
     if( i_cr_average < 10 )
@@ -576,6 +664,14 @@ void input_clock_SetJitter( input_clock_t *cl,
     vlc_mutex_unlock( &cl->lock );
 }
 
+void input_clock_SetStartDelay( input_clock_t *cl, vlc_tick_t i_pts_delay )
+{
+    vlc_mutex_lock( &cl->lock );
+    if( cl->i_pts_delay > i_pts_delay )
+        cl->i_pts_delay = i_pts_delay;
+    vlc_mutex_unlock( &cl->lock );
+}
+
 vlc_tick_t input_clock_GetJitter( input_clock_t *cl )
 {
     vlc_mutex_lock( &cl->lock );
@@ -631,6 +727,37 @@ static vlc_tick_t ClockGetTsOffset( input_clock_t *cl )
     return cl->i_pts_delay * ( cl->i_rate - INPUT_RATE_DEFAULT ) / INPUT_RATE_DEFAULT;
 }
 
+/**
+ * It returns the current estimate of the system clock drift, in stream clock
+ */
+static vlc_tick_t ClockGetDrift( input_clock_t *cl )
+{
+    return cl->b_kalman ? KalmanGet( &cl->kalman ) : AvgGet( &cl->drift );
+}
+
+/**
+ * It moves the delay toward the peak arrival delay of the clock references,
+ * plus some margin, within the limit of slight playback rate changes.
+ */
+static void ClockAdaptDelay( input_clock_t *cl, vlc_tick_t i_delay,
+                             vlc_tick_t i_elapsed )
+{
+    if( i_delay > cl->i_delay_peak )
+        cl->i_delay_peak = i_delay;
+    else
+        cl->i_delay_peak -= ( cl->i_delay_peak - i_delay ) * i_elapsed
+                            / CR_ADAPT_DECAY;
+
+    const vlc_tick_t i_target = __MAX( cl->i_delay_peak + CR_ADAPT_MARGIN,
+                                       CR_ADAPT_DELAY_MIN );
+    const vlc_tick_t i_step = i_elapsed / CR_ADAPT_RATE;
+
+    if( i_target > cl->i_pts_delay )
+        cl->i_pts_delay += __MIN( i_target - cl->i_pts_delay, i_step );
+    else
+        cl->i_pts_delay -= __MIN( cl->i_pts_delay - i_target, i_step );
+}
+
 /*****************************************************************************
  * Long term average helpers
  *****************************************************************************/
@@ -673,3 +800,86 @@ static void AvgRescale( average_t *p_avg, int i_divider )
     p_avg->i_value   = i_tmp / p_avg->i_divider;
     p_avg->i_residue = i_tmp % p_avg->i_divider;
 }
+
+/*****************************************************************************
+ * Kalman filter helpers
+ *****************************************************************************
+ * The state is the offset between the system and the stream clocks, and its
+ * rate of change (the skew between the clocks). The offset is measured at
+ * each clock reference, with the reception jitter as measurement noise.
+ *
+ * Network delays are bursty rather than Gaussian: late references are
+ * discarded as outliers, instead of pulling the estimate, as long as they do
+ * not keep coming. The jitter estimate only learns from accepted references.
+ *****************************************************************************/
+static void KalmanReset( kalman_t *k )
+{
+    k->b_valid = false;
+    k->i_outliers = 0;
+}
+static void KalmanUpdate( kalman_t *k, vlc_tick_t i_date, vlc_tick_t i_value )
+{
+    if( !k->b_valid )
+    {
+        k->b_valid = true;
+        k->i_date = i_date;
+        k->f_offset = i_value;
+        k->f_skew = 0.;
+        k->f_jitter = (double)CR_KALMAN_JITTER_INIT * CR_KALMAN_JITTER_INIT;
+        k->pf_cov[0][0] = k->f_jitter;
+        k->pf_cov[0][1] = k->pf_cov[1][0] = 0.;
+        k->pf_cov[1][1] = 1e-8; /* 100 ppm */
+        k->i_outliers = 0;
+        return;
+    }
+
+    /* Prediction */
+    const double dt = i_date - k->i_date;
+    double (*p)[2] = k->pf_cov;
+
+    k->i_date = i_date;
+    k->f_offset += k->f_skew * dt;
+    p[0][0] += dt * ( p[0][1] + p[1][0] + dt * p[1][1] )
+             + CR_KALMAN_OFFSET_NOISE * dt;
+    p[0][1] += dt * p[1][1];
+    p[1][0] += dt * p[1][1];
+    p[1][1] += CR_KALMAN_SKEW_NOISE * dt;
+
+    /* Outlier rejection */
+    double y = i_value - k->f_offset;
+    double s = p[0][0] + k->f_jitter;
+
+    if( fabs( y ) > CR_KALMAN_OUTLIER_SIGMA * sqrt( s ) )
+    {
+        if( k->i_outliers == 0 || y < k->f_outlier_min )
+            k->f_outlier_min = y;
+        if( ++k->i_outliers < CR_KALMAN_OUTLIERS )
+            return;
+
+        /* The delay has changed: restart from the least delayed reference */
+        y = k->f_outlier_min;
+        p[0][0] += y * y;
+        s = p[0][0] + k->f_jitter;
+    }
+    else
+    {
+        k->f_jitter += ( y * y - k->f_jitter ) / 16.;
+        if( k->f_jitter < (double)CR_KALMAN_JITTER_MIN * CR_KALMAN_JITTER_MIN )
+            k->f_jitter = (double)CR_KALMAN_JITTER_MIN * CR_KALMAN_JITTER_MIN;
+    }
+    k->i_outliers = 0;
+
+    /* Correction */
+    const double k0 = p[0][0] / s, k1 = p[1][0] / s;
+
+    k->f_offset += k0 * y;
+    k->f_skew += k1 * y;
+    p[1][0] -= k1 * p[0][0];
+    p[1][1] -= k1 * p[0][1];
+    p[0][0] *= 1. - k0;
+    p[0][1] *= 1. - k0;
+}
+static vlc_tick_t KalmanGet( const kalman_t *k )
+{
+    return k->b_valid ? llround( k->f_offset ) : 0;
+}
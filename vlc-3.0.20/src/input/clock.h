@@ -39,8 +39,13 @@ typedef struct input_clock_t input_clock_t;
 /**
  * This function creates a new input_clock_t.
  * You must use input_clock_Delete to delete it once unused.
+ *
+ * \param b_kalman tells to recover the clock drift with a Kalman filter
+ * rejecting jitter bursts, rather than a moving average.
+ * \param b_adaptive tells to adapt the delay to the measured arrival jitter
+ * of real-time sources, rather than only increase it when late.
  */
-input_clock_t *input_clock_New( int i_rate );
+input_clock_t *input_clock_New( int i_rate, bool b_kalman, bool b_adaptive );
 
 /**
  * This function destroys a input_clock_t created by input_clock_New.
@@ -130,6 +135,13 @@ int input_clock_GetState( input_clock_t *,
 void input_clock_SetJitter( input_clock_t *,
                             vlc_tick_t i_pts_delay, int i_cr_average );
 
+/**
+ * This function lowers the pts_delay down to the given value. It will grow
+ * back to the one set by input_clock_SetJitter, by slightly slowing down
+ * playback, as clock references come.
+ */
+void input_clock_SetStartDelay( input_clock_t *, vlc_tick_t i_pts_delay );
+
 /**
  * This function returns an estimation of the pts_delay needed to avoid rebufferization.
  * XXX in the current implementation, the pts_delay will never be decreased.
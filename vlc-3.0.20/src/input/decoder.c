@@ -42,10 +42,15 @@
 #include <vlc_spu.h>
 #include <vlc_meta.h>
 #include <vlc_dialog.h>
+#include <vlc_interrupt.h>
 #include <vlc_modules.h>
+#include <vlc_memory.h>
+#include <vlc_trace.h>
 
 #include "audio_output/aout_internal.h"
 #include "stream_output/stream_output.h"
+#include "../libvlc.h"
+#include "../misc/executor.h"
 #include "input_internal.h"
 #include "clock.h"
 #include "decoder.h"
@@ -80,6 +85,13 @@ struct decoder_owner_sys_t
 
     vlc_thread_t     thread;
 
+    /* Shared executor, used instead of the thread by lightweight decoders */
+    vlc_executor_t  *p_executor;
+    struct vlc_task  task;
+    bool             b_scheduled; /* the task is queued or running */
+    bool             b_stopping;
+    bool             b_task_paused; /* output pause state, task only */
+
     void (*pf_update_stat)( decoder_owner_sys_t *, unsigned decoded, unsigned lost );
 
     /* Some decoders require already packetized data (ie. not truncated) */
@@ -102,6 +114,11 @@ struct decoder_owner_sys_t
     vlc_cond_t  wait_request;
     vlc_cond_t  wait_acknowledge;
     vlc_cond_t  wait_fifo; /* TODO: merge with wait_acknowledge */
+    vlc_memory_user_t *p_memory; /* FIFO share of the memory budget */
+    vlc_tick_t  i_fifo_max_duration; /* 0 if unbounded (constant) */
+    vlc_tick_t  i_fifo_in_ts; /* last queued timestamp, sender only */
+    vlc_tick_t  i_fifo_out_ts; /* last dequeued timestamp, FIFO lock */
+    vlc_tick_t  i_fifo_throttled; /* throttling start, sender only */
     vlc_cond_t  wait_timed;
 
     /* -- These variables need locking on write(only) -- */
@@ -112,6 +129,11 @@ struct decoder_owner_sys_t
     /* -- Theses variables need locking on read *and* write -- */
     /* Preroll */
     int64_t i_preroll_end;
+    /* Trick play */
+    bool b_keyframes_only;
+    bool b_keyframe_wait;
+    /* Output as soon as decoded (constant) */
+    bool b_free_run;
     /* Pause */
     vlc_tick_t pause_date;
     unsigned frames_countdown;
@@ -141,6 +163,35 @@ struct decoder_owner_sys_t
 
     /* Delay */
     vlc_tick_t i_ts_delay;
+
+    /* Ingest dates of the last input blocks, by timestamp */
+#define DECODER_INGEST_SIZE 32
+    struct
+    {
+        vlc_tick_t i_ts;
+        vlc_tick_t i_date;
+    } ingest[DECODER_INGEST_SIZE];
+    size_t i_ingest;
+
+    /* Outputs of the mirror resources (decoder thread only, used with the
+     * mirrors lock of the resource held) */
+    struct decoder_mirror *p_mirrors;
+    size_t i_mirrors;
+    unsigned i_mirrors_gen;
+    input_resource_mirror_user_t mirror_user;
+};
+
+struct decoder_mirror
+{
+    input_resource_t *p_resource;
+
+    bool b_video;
+    video_format_t video;
+    vout_thread_t *p_vout;
+
+    bool b_audio;
+    audio_sample_format_t audio;
+    audio_output_t *p_aout;
 };
 
 /* Pictures which are DECODER_BOGUS_VIDEO_DELAY or more in advance probably have
@@ -149,6 +200,8 @@ struct decoder_owner_sys_t
 
 /* */
 #define DECODER_SPU_VOUT_WAIT_DURATION ((int)(0.200*CLOCK_FREQ))
+/* Timestamp gaps larger than this are discontinuities, not queued data */
+#define DECODER_FIFO_MAX_GAP ((vlc_tick_t)(60 * CLOCK_FREQ))
 #define BLOCK_FLAG_CORE_PRIVATE_RELOADED (1 << BLOCK_FLAG_CORE_PRIVATE_SHIFT)
 
 /**
@@ -159,6 +212,7 @@ static int LoadDecoder( decoder_t *p_dec, bool b_packetizer,
 {
     p_dec->b_frame_drop_allowed = true;
     p_dec->i_extra_picture_buffers = 0;
+    p_dec->i_picture_align = 0;
 
     p_dec->pf_decode = NULL;
     p_dec->pf_get_cc = NULL;
@@ -294,7 +348,7 @@ static vout_thread_t *aout_request_vout( void *p_private,
     }
 
     p_vout = input_resource_RequestVout( p_owner->p_resource, p_vout, p_fmt, 1,
-                                         b_recyle );
+                                         0, b_recyle );
     if( p_input != NULL )
         input_SendEventVout( p_input );
 
@@ -529,7 +583,7 @@ static int vout_update_format( decoder_t *p_dec )
                                              p_vout, &fmt,
                                              dpb_size +
                                              p_dec->i_extra_picture_buffers + 1,
-                                             true );
+                                             p_dec->i_picture_align, true );
         vlc_mutex_lock( &p_owner->lock );
         p_owner->p_vout = p_vout;
 
@@ -733,6 +787,96 @@ void decoder_AbortPictures( decoder_t *p_dec, bool b_abort )
     vlc_mutex_unlock( &p_owner->lock );
 }
 
+/**
+ * Wakes the decoder loop up, with the FIFO locked.
+ */
+static void DecoderWakeUp( decoder_t *p_dec )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    if( p_owner->p_executor == NULL )
+        vlc_fifo_Signal( p_owner->p_fifo );
+    else if( !p_owner->b_scheduled )
+    {
+        p_owner->b_scheduled = true;
+        vlc_executor_Submit( p_owner->p_executor, &p_owner->task );
+    }
+}
+
+/**
+ * Queues a block in the decoder FIFO and wakes the decoder loop up.
+ */
+static void DecoderQueue( decoder_t *p_dec, block_t *p_block )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    vlc_fifo_Lock( p_owner->p_fifo );
+    vlc_fifo_QueueUnlocked( p_owner->p_fifo, p_block );
+    if( p_owner->p_executor != NULL )
+        DecoderWakeUp( p_dec );
+    vlc_fifo_Unlock( p_owner->p_fifo );
+}
+
+static vlc_tick_t BlockTimestamp( const block_t *p_block )
+{
+    return p_block->i_dts > VLC_TICK_INVALID ? p_block->i_dts
+                                             : p_block->i_pts;
+}
+
+/* Duration of the data queued in the FIFO, or 0 if unknown.
+ * The FIFO lock must be held. */
+static vlc_tick_t DecoderFifoDuration( decoder_owner_sys_t *p_owner )
+{
+    if( vlc_fifo_GetCount( p_owner->p_fifo ) == 0
+     || p_owner->i_fifo_in_ts <= VLC_TICK_INVALID
+     || p_owner->i_fifo_out_ts <= VLC_TICK_INVALID )
+        return 0;
+
+    vlc_tick_t duration = p_owner->i_fifo_in_ts - p_owner->i_fifo_out_ts;
+    if( duration < 0 || duration > DECODER_FIFO_MAX_GAP )
+        return 0;
+    return duration;
+}
+
+static void DecoderFifoInterrupted( void *data )
+{
+    decoder_owner_sys_t *p_owner = data;
+
+    vlc_fifo_Lock( p_owner->p_fifo );
+    vlc_cond_broadcast( &p_owner->wait_fifo );
+    vlc_fifo_Unlock( p_owner->p_fifo );
+}
+
+/* Holds the sender back while the FIFO is too long. The throttling is
+ * bounded: once the FIFO has stayed too long for the maximum duration, the
+ * sender is let through until the FIFO drains, so that a stalled decoder
+ * cannot stall a live input indefinitely. The FIFO is not consumed when
+ * waiting nor paused, so these states are not throttled. */
+static void DecoderFifoThrottle( decoder_owner_sys_t *p_owner )
+{
+    vlc_interrupt_register( DecoderFifoInterrupted, p_owner );
+    vlc_fifo_Lock( p_owner->p_fifo );
+    while( !p_owner->b_stopping && !p_owner->flushing
+        && !p_owner->b_waiting && !p_owner->paused
+        && DecoderFifoDuration( p_owner ) > p_owner->i_fifo_max_duration
+        && !vlc_killed() )
+    {
+        if( p_owner->i_fifo_throttled == VLC_TICK_INVALID )
+            p_owner->i_fifo_throttled = mdate();
+
+        vlc_tick_t deadline = p_owner->i_fifo_throttled
+                            + p_owner->i_fifo_max_duration;
+        if( mdate() >= deadline
+         || vlc_fifo_TimedWaitCond( p_owner->p_fifo, &p_owner->wait_fifo,
+                                    deadline ) )
+            break;
+    }
+    if( DecoderFifoDuration( p_owner ) <= p_owner->i_fifo_max_duration )
+        p_owner->i_fifo_throttled = VLC_TICK_INVALID;
+    vlc_fifo_Unlock( p_owner->p_fifo );
+    vlc_interrupt_unregister();
+}
+
 static void DecoderWaitUnblock( decoder_t *p_dec )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
@@ -948,11 +1092,11 @@ static void DecoderPlayCc( decoder_t *p_dec, block_t *p_cc,
 
         if( i_bitmap > 1 )
         {
-            block_FifoPut( p_ccdec->p_owner->p_fifo, block_Duplicate(p_cc) );
+            DecoderQueue( p_ccdec, block_Duplicate(p_cc) );
         }
         else
         {
-            block_FifoPut( p_ccdec->p_owner->p_fifo, p_cc );
+            DecoderQueue( p_ccdec, p_cc );
             p_cc = NULL; /* was last dec */
         }
     }
@@ -997,6 +1141,294 @@ static int DecoderQueueCc( decoder_t *p_videodec, block_t *p_cc,
     return 0;
 }
 
+/*****************************************************************************
+ * Mirrors: outputs of other players showing the same decoded data
+ *****************************************************************************/
+static vout_thread_t *DecoderMirrorRequestVout( void *p_private,
+                                                vout_thread_t *p_vout,
+                                                const video_format_t *p_fmt,
+                                                bool b_recycle )
+{
+    return input_resource_RequestVout( p_private, p_vout, p_fmt, 1, 0,
+                                       b_recycle );
+}
+
+static void DecoderMirrorCloseVout( struct decoder_mirror *p_mirror )
+{
+    if( p_mirror->p_vout != NULL )
+        input_resource_RequestVout( p_mirror->p_resource, p_mirror->p_vout,
+                                    NULL, 0, 0, true );
+    p_mirror->p_vout = NULL;
+    if( p_mirror->b_video )
+        video_format_Clean( &p_mirror->video );
+    p_mirror->b_video = false;
+}
+
+static void DecoderMirrorCloseAout( struct decoder_mirror *p_mirror )
+{
+    if( p_mirror->p_aout != NULL )
+    {
+        aout_DecFlush( p_mirror->p_aout, false );
+        aout_DecDelete( p_mirror->p_aout );
+        input_resource_PutAout( p_mirror->p_resource, p_mirror->p_aout );
+    }
+    p_mirror->p_aout = NULL;
+    p_mirror->b_audio = false;
+}
+
+static void DecoderMirrorsClear( decoder_owner_sys_t *p_owner )
+{
+    for( size_t i = 0; i < p_owner->i_mirrors; i++ )
+    {
+        struct decoder_mirror *p_mirror = &p_owner->p_mirrors[i];
+
+        if( p_mirror->p_resource == NULL )
+            continue; /* removed, see DecoderMirrorRemove() */
+        DecoderMirrorCloseVout( p_mirror );
+        DecoderMirrorCloseAout( p_mirror );
+        input_resource_Release( p_mirror->p_resource );
+    }
+    free( p_owner->p_mirrors );
+    p_owner->p_mirrors = NULL;
+    p_owner->i_mirrors = 0;
+}
+
+/* Called by input_resource_RemoveMirror(), with the mirrors lock held */
+static void DecoderMirrorRemove( input_resource_mirror_user_t *p_user,
+                                 input_resource_t *p_resource )
+{
+    decoder_owner_sys_t *p_owner =
+        container_of( p_user, decoder_owner_sys_t, mirror_user );
+
+    for( size_t i = 0; i < p_owner->i_mirrors; i++ )
+    {
+        struct decoder_mirror *p_mirror = &p_owner->p_mirrors[i];
+
+        if( p_mirror->p_resource != p_resource )
+            continue;
+
+        DecoderMirrorCloseVout( p_mirror );
+        DecoderMirrorCloseAout( p_mirror );
+        input_resource_Release( p_resource );
+        /* The entry is dropped by the next DecoderMirrorsUpdate() */
+        p_mirror->p_resource = NULL;
+    }
+}
+
+/* Follows the mirrors of the resource, keeping the outputs of the remaining
+ * ones */
+static void DecoderMirrorsUpdate( decoder_t *p_dec )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    unsigned gen = input_resource_GetMirrorsGeneration( p_owner->p_resource );
+    if( gen == p_owner->i_mirrors_gen )
+        return;
+    p_owner->i_mirrors_gen = gen;
+
+    input_resource_t **pp_resource;
+    size_t i_resource;
+    input_resource_HoldMirrors( p_owner->p_resource, &pp_resource, &i_resource );
+
+    struct decoder_mirror *p_mirrors = NULL;
+    if( i_resource > 0 )
+    {
+        p_mirrors = vlc_alloc( i_resource, sizeof(*p_mirrors) );
+        if( unlikely(p_mirrors == NULL) )
+        {
+            for( size_t i = 0; i < i_resource; i++ )
+                input_resource_Release( pp_resource[i] );
+            i_resource = 0;
+        }
+    }
+
+    for( size_t i = 0; i < i_resource; i++ )
+    {
+        struct decoder_mirror *p_mirror = &p_mirrors[i];
+        size_t j = 0;
+
+        while( j < p_owner->i_mirrors &&
+               p_owner->p_mirrors[j].p_resource != pp_resource[i] )
+            j++;
+
+        if( j < p_owner->i_mirrors )
+        {   /* Known mirror: move its outputs */
+            *p_mirror = p_owner->p_mirrors[j];
+            p_owner->p_mirrors[j] = p_owner->p_mirrors[--p_owner->i_mirrors];
+            input_resource_Release( pp_resource[i] );
+        }
+        else
+        {
+            p_mirror->p_resource = pp_resource[i];
+            p_mirror->b_video = false;
+            p_mirror->p_vout = NULL;
+            p_mirror->b_audio = false;
+            p_mirror->p_aout = NULL;
+        }
+    }
+    free( pp_resource );
+
+    DecoderMirrorsClear( p_owner );
+    p_owner->p_mirrors = p_mirrors;
+    p_owner->i_mirrors = i_resource;
+}
+
+/* Locks the mirrors and updates them, unless there are none */
+static bool DecoderMirrorsLock( decoder_t *p_dec )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    if( p_owner->p_resource == NULL )
+        return false;
+
+    /* Only this thread changes i_mirrors: no lock needed to check it */
+    if( p_owner->i_mirrors == 0 && p_owner->i_mirrors_gen
+         == input_resource_GetMirrorsGeneration( p_owner->p_resource ) )
+        return false;
+
+    input_resource_LockMirrors( p_owner->p_resource );
+    DecoderMirrorsUpdate( p_dec );
+    return true;
+}
+
+static void DecoderMirrorVideo( decoder_t *p_dec, const picture_t *p_picture )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    if( !DecoderMirrorsLock( p_dec ) )
+        return;
+
+    for( size_t i = 0; i < p_owner->i_mirrors; i++ )
+    {
+        struct decoder_mirror *p_mirror = &p_owner->p_mirrors[i];
+
+        if( !p_mirror->b_video
+         || !video_format_IsSimilar( &p_mirror->video, &p_picture->format ) )
+        {
+            const vlc_chroma_description_t *p_dsc =
+                vlc_fourcc_GetChromaDescription( p_picture->format.i_chroma );
+
+            if( p_mirror->b_video )
+                video_format_Clean( &p_mirror->video );
+            video_format_Copy( &p_mirror->video, &p_picture->format );
+            p_mirror->b_video = true;
+
+            /* Opaque pictures cannot be copied to another output */
+            if( p_dsc == NULL || p_dsc->plane_count == 0 )
+            {
+                if( p_mirror->p_vout != NULL )
+                    input_resource_RequestVout( p_mirror->p_resource,
+                                                p_mirror->p_vout, NULL,
+                                                0, 0, true );
+                p_mirror->p_vout = NULL;
+                msg_Warn( p_dec, "cannot mirror %4.4s pictures",
+                          (const char *)&p_picture->format.i_chroma );
+                continue;
+            }
+
+            p_mirror->p_vout = input_resource_RequestVout( p_mirror->p_resource,
+                                                           p_mirror->p_vout,
+                                                           &p_mirror->video,
+                                                           1, 0, true );
+        }
+
+        if( p_mirror->p_vout == NULL )
+            continue;
+
+        picture_t *p_copy = vout_GetPicture( p_mirror->p_vout );
+        if( p_copy == NULL )
+            continue;
+        picture_Copy( p_copy, p_picture );
+        vout_PutPicture( p_mirror->p_vout, p_copy );
+    }
+    input_resource_UnlockMirrors( p_owner->p_resource );
+}
+
+static void DecoderMirrorAudio( decoder_t *p_dec, block_t *p_audio, int i_rate )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    if( !DecoderMirrorsLock( p_dec ) )
+        return;
+
+    for( size_t i = 0; i < p_owner->i_mirrors; i++ )
+    {
+        struct decoder_mirror *p_mirror = &p_owner->p_mirrors[i];
+        audio_sample_format_t format = p_dec->fmt_out.audio;
+
+        format.i_format = p_dec->fmt_out.i_codec;
+        aout_FormatPrepare( &format );
+
+        if( !p_mirror->b_audio
+         || !AOUT_FMTS_IDENTICAL( &p_mirror->audio, &format ) )
+        {
+            aout_request_vout_t request_vout = {
+                .pf_request_vout = DecoderMirrorRequestVout,
+                .p_private = p_mirror->p_resource,
+            };
+
+            DecoderMirrorCloseAout( p_mirror );
+            p_mirror->audio = format;
+            p_mirror->b_audio = true;
+
+            audio_output_t *p_aout = input_resource_GetAout( p_mirror->p_resource );
+            if( p_aout != NULL
+             && aout_DecNew( p_aout, &format, &p_dec->fmt_out.audio_replay_gain,
+                             &request_vout ) )
+            {
+                input_resource_PutAout( p_mirror->p_resource, p_aout );
+                p_aout = NULL;
+            }
+            p_mirror->p_aout = p_aout;
+        }
+
+        if( p_mirror->p_aout == NULL )
+            continue;
+
+        block_t *p_dup = block_Duplicate( p_audio );
+        if( p_dup != NULL )
+            aout_DecPlay( p_mirror->p_aout, p_dup, i_rate );
+    }
+    input_resource_UnlockMirrors( p_owner->p_resource );
+}
+
+static void DecoderMirrorsFlush( decoder_owner_sys_t *p_owner )
+{
+    if( p_owner->i_mirrors == 0 )
+        return;
+
+    input_resource_LockMirrors( p_owner->p_resource );
+    for( size_t i = 0; i < p_owner->i_mirrors; i++ )
+    {
+        struct decoder_mirror *p_mirror = &p_owner->p_mirrors[i];
+
+        if( p_mirror->p_vout != NULL )
+            vout_Flush( p_mirror->p_vout, VLC_TICK_INVALID+1 );
+        if( p_mirror->p_aout != NULL )
+            aout_DecFlush( p_mirror->p_aout, false );
+    }
+    input_resource_UnlockMirrors( p_owner->p_resource );
+}
+
+static void DecoderMirrorsChangePause( decoder_owner_sys_t *p_owner,
+                                       bool b_paused, vlc_tick_t i_date )
+{
+    if( p_owner->i_mirrors == 0 )
+        return;
+
+    input_resource_LockMirrors( p_owner->p_resource );
+    for( size_t i = 0; i < p_owner->i_mirrors; i++ )
+    {
+        struct decoder_mirror *p_mirror = &p_owner->p_mirrors[i];
+
+        if( p_mirror->p_vout != NULL )
+            vout_ChangePause( p_mirror->p_vout, b_paused, i_date );
+        if( p_mirror->p_aout != NULL )
+            aout_DecChangePause( p_mirror->p_aout, b_paused, i_date );
+    }
+    input_resource_UnlockMirrors( p_owner->p_resource );
+}
+
 static int DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
                              unsigned *restrict pi_lost_sum )
 {
@@ -1055,6 +1487,12 @@ static int DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
     DecoderFixTs( p_dec, &p_picture->date, NULL, NULL,
                   &i_rate, DECODER_BOGUS_VIDEO_DELAY );
 
+    if( p_owner->b_free_run && b_dated )
+    {   /* Display right away: the vout picture pool paces the decoder */
+        p_picture->date = mdate();
+        p_picture->b_force = true;
+    }
+
     vlc_mutex_unlock( &p_owner->lock );
 
     /* FIXME: The *input* FIFO should not be locked here. This will not work
@@ -1077,6 +1515,7 @@ static int DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
             vout_Flush( p_vout, p_picture->date );
             p_owner->i_last_rate = i_rate;
         }
+        DecoderMirrorVideo( p_dec, p_picture );
         vout_PutPicture( p_vout, p_picture );
     }
     else
@@ -1095,11 +1534,60 @@ discard:
     return 0;
 }
 
+/* Remembers when an input block reached the ES output (p_owner->lock held) */
+static void DecoderIngestPush( decoder_owner_sys_t *p_owner,
+                               const block_t *p_block )
+{
+    vlc_tick_t i_ts = p_block->i_pts > VLC_TICK_INVALID ? p_block->i_pts
+                                                        : p_block->i_dts;
+    if( p_block->i_ingest == VLC_TICK_INVALID || i_ts <= VLC_TICK_INVALID )
+        return;
+
+    if( p_owner->i_ingest == DECODER_INGEST_SIZE )
+    {
+        memmove( &p_owner->ingest[0], &p_owner->ingest[1],
+                 ( DECODER_INGEST_SIZE - 1 ) * sizeof( p_owner->ingest[0] ) );
+        p_owner->i_ingest--;
+    }
+    p_owner->ingest[p_owner->i_ingest].i_ts = i_ts;
+    p_owner->ingest[p_owner->i_ingest].i_date = p_block->i_ingest;
+    p_owner->i_ingest++;
+}
+
+/* Returns when the input an output buffer was decoded from reached the ES
+ * output, i.e. the latest input dated no later than the buffer, and forgets
+ * about older inputs (p_owner->lock held) */
+static vlc_tick_t DecoderIngestPop( decoder_owner_sys_t *p_owner,
+                                    vlc_tick_t i_ts )
+{
+    size_t i_best = SIZE_MAX;
+
+    for( size_t i = 0; i < p_owner->i_ingest; i++ )
+        if( p_owner->ingest[i].i_ts <= i_ts
+         && ( i_best == SIZE_MAX
+           || p_owner->ingest[i].i_ts > p_owner->ingest[i_best].i_ts ) )
+            i_best = i;
+    if( i_best == SIZE_MAX )
+        return VLC_TICK_INVALID;
+
+    const vlc_tick_t i_best_ts = p_owner->ingest[i_best].i_ts;
+    const vlc_tick_t i_date = p_owner->ingest[i_best].i_date;
+    size_t i_count = 0;
+
+    for( size_t i = 0; i < p_owner->i_ingest; i++ )
+        if( p_owner->ingest[i].i_ts >= i_best_ts )
+            p_owner->ingest[i_count++] = p_owner->ingest[i];
+    p_owner->i_ingest = i_count;
+    return i_date;
+}
+
 static void DecoderUpdateStatVideo( decoder_owner_sys_t *p_owner,
                                     unsigned decoded, unsigned lost )
 {
     input_thread_t *p_input = p_owner->p_input;
     unsigned displayed = 0;
+    unsigned timings[INPUT_STATS_VOUT_TIMINGS][INPUT_STATS_TIMING_BUCKETS] = { { 0 } };
+    unsigned latency[INPUT_STATS_LATENCY_BUCKETS] = { 0 };
 
     /* Update ugly stat */
     if( p_input == NULL )
@@ -1110,10 +1598,17 @@ static void DecoderUpdateStatVideo( decoder_owner_sys_t *p_owner,
         unsigned vout_lost = 0;
 
         vout_GetResetStatistic( p_owner->p_vout, &displayed, &vout_lost );
+        vout_GetResetTimings( p_owner->p_vout, timings );
+        vout_GetResetLatency( p_owner->p_vout, latency );
         lost += vout_lost;
     }
 
     vlc_mutex_lock( &input_priv(p_input)->counters.counters_lock );
+    for( unsigned i = 0; i < INPUT_STATS_VOUT_TIMINGS; i++ )
+        for( unsigned j = 0; j < INPUT_STATS_TIMING_BUCKETS; j++ )
+            input_priv(p_input)->counters.vout_timings[i][j] += timings[i][j];
+    for( unsigned i = 0; i < INPUT_STATS_LATENCY_BUCKETS; i++ )
+        input_priv(p_input)->counters.video_latency[i] += latency[i];
     stats_Update( input_priv(p_input)->counters.p_decoded_video, decoded, NULL );
     stats_Update( input_priv(p_input)->counters.p_lost_pictures, lost , NULL);
     stats_Update( input_priv(p_input)->counters.p_displayed_pictures, displayed, NULL);
@@ -1126,6 +1621,10 @@ static int DecoderQueueVideo( decoder_t *p_dec, picture_t *p_pic )
     unsigned i_lost = 0;
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
 
+    vlc_mutex_lock( &p_owner->lock );
+    p_pic->ingest = DecoderIngestPop( p_owner, p_pic->date );
+    vlc_mutex_unlock( &p_owner->lock );
+
     int ret = DecoderPlayVideo( p_dec, p_pic, &i_lost );
 
     p_owner->pf_update_stat( p_owner, 1, i_lost );
@@ -1183,6 +1682,8 @@ static int DecoderPlayAudio( decoder_t *p_dec, block_t *p_audio,
     DecoderWaitUnblock( p_dec );
     DecoderFixTs( p_dec, &p_audio->i_pts, NULL, &p_audio->i_length,
                   &i_rate, AOUT_MAX_ADVANCE_TIME );
+    if( p_owner->b_free_run && p_audio->i_pts > VLC_TICK_INVALID )
+        p_audio->i_pts = mdate();
     vlc_mutex_unlock( &p_owner->lock );
 
     audio_output_t *p_aout = p_owner->p_aout;
@@ -1190,8 +1691,11 @@ static int DecoderPlayAudio( decoder_t *p_dec, block_t *p_audio,
     if( p_aout != NULL && p_audio->i_pts > VLC_TICK_INVALID
      && i_rate >= INPUT_RATE_DEFAULT/AOUT_MAX_INPUT_RATE
      && i_rate <= INPUT_RATE_DEFAULT*AOUT_MAX_INPUT_RATE
-     && !DecoderTimedWait( p_dec, p_audio->i_pts - AOUT_MAX_PREPARE_TIME ) )
+     && ( p_owner->b_free_run
+       || !DecoderTimedWait( p_dec, p_audio->i_pts - aout_DecLeadTime( p_aout ) ) ) )
     {
+        DecoderMirrorAudio( p_dec, p_audio, i_rate );
+
         int status = aout_DecPlay( p_aout, p_audio, i_rate );
         if( status == AOUT_DEC_CHANGED )
         {
@@ -1220,6 +1724,7 @@ static void DecoderUpdateStatAudio( decoder_owner_sys_t *p_owner,
 {
     input_thread_t *p_input = p_owner->p_input;
     unsigned played = 0;
+    unsigned latency[INPUT_STATS_LATENCY_BUCKETS] = { 0 };
 
     /* Update ugly stat */
     if( p_input == NULL )
@@ -1230,10 +1735,13 @@ static void DecoderUpdateStatAudio( decoder_owner_sys_t *p_owner,
         unsigned aout_lost;
 
         aout_DecGetResetStats( p_owner->p_aout, &aout_lost, &played );
+        aout_DecGetResetLatency( p_owner->p_aout, latency );
         lost += aout_lost;
     }
 
     vlc_mutex_lock( &input_priv(p_input)->counters.counters_lock);
+    for( unsigned i = 0; i < INPUT_STATS_LATENCY_BUCKETS; i++ )
+        input_priv(p_input)->counters.audio_latency[i] += latency[i];
     stats_Update( input_priv(p_input)->counters.p_lost_abuffers, lost, NULL );
     stats_Update( input_priv(p_input)->counters.p_played_abuffers, played, NULL );
     stats_Update( input_priv(p_input)->counters.p_decoded_audio, decoded, NULL );
@@ -1245,6 +1753,10 @@ static int DecoderQueueAudio( decoder_t *p_dec, block_t *p_aout_buf )
     unsigned lost = 0;
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
 
+    vlc_mutex_lock( &p_owner->lock );
+    p_aout_buf->i_ingest = DecoderIngestPop( p_owner, p_aout_buf->i_pts );
+    vlc_mutex_unlock( &p_owner->lock );
+
     int ret = DecoderPlayAudio( p_dec, p_aout_buf, &lost );
 
     p_owner->pf_update_stat( p_owner, 1, lost );
@@ -1338,11 +1850,40 @@ static int DecoderQueueSpu( decoder_t *p_dec, subpicture_t *p_spu )
 }
 
 static void DecoderProcess( decoder_t *p_dec, block_t *p_block );
+
+/* In trick play, only the random access points are decoded. When leaving it,
+ * decoding resumes at the next one. Blocks of unknown type are always
+ * decoded as they cannot be told apart. */
+static bool DecoderTrickPlayDrop( decoder_t *p_dec, const block_t *p_block )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+    bool b_drop = false;
+
+    if( p_dec->fmt_in.i_cat != VIDEO_ES )
+        return false;
+
+    vlc_mutex_lock( &p_owner->lock );
+    if( p_block->i_flags & BLOCK_FLAG_TYPE_I )
+        p_owner->b_keyframe_wait = false;
+    else if( p_block->i_flags & BLOCK_FLAG_TYPE_MASK )
+        b_drop = p_owner->b_keyframes_only || p_owner->b_keyframe_wait;
+    vlc_mutex_unlock( &p_owner->lock );
+    return b_drop;
+}
+
 static void DecoderDecode( decoder_t *p_dec, block_t *p_block )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
 
+    if( p_block != NULL && DecoderTrickPlayDrop( p_dec, p_block ) )
+    {
+        block_Release( p_block );
+        return;
+    }
+
+    vlc_trace_begin( "decoder", "decode" );
     int ret = p_dec->pf_decode( p_dec, p_block );
+    vlc_trace_end( "decoder", "decode" );
     switch( ret )
     {
         case VLCDEC_SUCCESS:
@@ -1403,6 +1944,8 @@ static void DecoderProcess( decoder_t *p_dec, block_t *p_block )
 
         vlc_mutex_lock( &p_owner->lock );
         DecoderUpdatePreroll( &p_owner->i_preroll_end, p_block );
+        if( likely( !( p_block->i_flags & BLOCK_FLAG_CORE_PRIVATE_RELOADED ) ) )
+            DecoderIngestPush( p_owner, p_block );
         vlc_mutex_unlock( &p_owner->lock );
         if( unlikely( p_block->i_flags & BLOCK_FLAG_CORE_PRIVATE_RELOADED ) )
         {
@@ -1484,6 +2027,10 @@ static void DecoderProcessFlush( decoder_t *p_dec )
     if( p_packetizer != NULL && p_packetizer->pf_flush != NULL )
         p_packetizer->pf_flush( p_packetizer );
 
+    vlc_mutex_lock( &p_owner->lock );
+    p_owner->i_ingest = 0;
+    vlc_mutex_unlock( &p_owner->lock );
+
     if ( p_dec->pf_flush != NULL )
         p_dec->pf_flush( p_dec );
 
@@ -1504,6 +2051,7 @@ static void DecoderProcessFlush( decoder_t *p_dec )
         sout_InputFlush( p_owner->p_sout_input );
     }
 #endif
+    DecoderMirrorsFlush( p_owner );
     if( p_dec->fmt_out.i_cat == AUDIO_ES )
     {
         if( p_owner->p_aout )
@@ -1534,118 +2082,161 @@ static void DecoderProcessFlush( decoder_t *p_dec )
 }
 
 /**
- * The decoding main loop
+ * Runs one iteration of the decoder loop, with the FIFO locked.
  *
- * \param p_dec the decoder
+ * \param paused pause state of the output, owned by the loop
+ * \return false if the loop is idle until it is woken up again
  */
-static void *DecoderThread( void *p_data )
+static bool DecoderStep( decoder_t *p_dec, bool *paused )
 {
-    decoder_t *p_dec = (decoder_t *)p_data;
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
-    bool paused = false;
 
-    /* The decoder's main loop */
-    vlc_fifo_Lock( p_owner->p_fifo );
-    vlc_fifo_CleanupPush( p_owner->p_fifo );
+    if( p_owner->flushing )
+    {   /* Flush before/regardless of pause. We do not want to resume just
+         * for the sake of flushing (glitches could otherwise happen). */
+        int canc = vlc_savecancel();
 
-    for( ;; )
-    {
-        if( p_owner->flushing )
-        {   /* Flush before/regardless of pause. We do not want to resume just
-             * for the sake of flushing (glitches could otherwise happen). */
-            int canc = vlc_savecancel();
+        vlc_fifo_Unlock( p_owner->p_fifo );
 
-            vlc_fifo_Unlock( p_owner->p_fifo );
+        /* Flush the decoder (and the output) */
+        DecoderProcessFlush( p_dec );
 
-            /* Flush the decoder (and the output) */
-            DecoderProcessFlush( p_dec );
+        vlc_fifo_Lock( p_owner->p_fifo );
+        vlc_restorecancel( canc );
 
-            vlc_fifo_Lock( p_owner->p_fifo );
-            vlc_restorecancel( canc );
+        /* Reset flushing after DecoderProcess in case input_DecoderFlush
+         * is called again. This will avoid a second useless flush (but
+         * harmless). */
+        p_owner->flushing = false;
 
-            /* Reset flushing after DecoderProcess in case input_DecoderFlush
-             * is called again. This will avoid a second useless flush (but
-             * harmless). */
-            p_owner->flushing = false;
+        return true;
+    }
 
-            continue;
-        }
+    if( *paused != p_owner->paused )
+    {   /* Update playing/paused status of the output */
+        int canc = vlc_savecancel();
+        vlc_tick_t date = p_owner->pause_date;
 
-        if( paused != p_owner->paused )
-        {   /* Update playing/paused status of the output */
-            int canc = vlc_savecancel();
-            vlc_tick_t date = p_owner->pause_date;
+        *paused = p_owner->paused;
+        vlc_fifo_Unlock( p_owner->p_fifo );
 
-            paused = p_owner->paused;
-            vlc_fifo_Unlock( p_owner->p_fifo );
+        /* NOTE: Only the audio and video outputs care about pause. */
+        msg_Dbg( p_dec, "toggling %s", *paused ? "resume" : "pause" );
+        if( p_owner->p_vout != NULL )
+            vout_ChangePause( p_owner->p_vout, *paused, date );
+        if( p_owner->p_aout != NULL )
+            aout_DecChangePause( p_owner->p_aout, *paused, date );
+        DecoderMirrorsChangePause( p_owner, *paused, date );
 
-            /* NOTE: Only the audio and video outputs care about pause. */
-            msg_Dbg( p_dec, "toggling %s", paused ? "resume" : "pause" );
-            if( p_owner->p_vout != NULL )
-                vout_ChangePause( p_owner->p_vout, paused, date );
-            if( p_owner->p_aout != NULL )
-                aout_DecChangePause( p_owner->p_aout, paused, date );
+        vlc_restorecancel( canc );
+        vlc_fifo_Lock( p_owner->p_fifo );
+        return true;
+    }
 
-            vlc_restorecancel( canc );
-            vlc_fifo_Lock( p_owner->p_fifo );
-            continue;
-        }
+    if( p_owner->paused && p_owner->frames_countdown == 0 )
+    {   /* Wait for resumption from pause */
+        p_owner->b_idle = true;
+        vlc_cond_signal( &p_owner->wait_acknowledge );
+        return false;
+    }
+
+    vlc_cond_signal( &p_owner->wait_fifo );
 
-        if( p_owner->paused && p_owner->frames_countdown == 0 )
-        {   /* Wait for resumption from pause */
+    block_t *p_block = vlc_fifo_DequeueUnlocked( p_owner->p_fifo );
+    if( p_block != NULL && BlockTimestamp( p_block ) > VLC_TICK_INVALID )
+        p_owner->i_fifo_out_ts = BlockTimestamp( p_block );
+    if( p_block == NULL )
+    {
+        if( likely(!p_owner->b_draining) )
+        {   /* Wait for a block to decode (or a request to drain) */
+            vlc_trace_instant( "decoder", "idle" );
             p_owner->b_idle = true;
             vlc_cond_signal( &p_owner->wait_acknowledge );
-            vlc_fifo_Wait( p_owner->p_fifo );
-            p_owner->b_idle = false;
-            continue;
+            return false;
         }
+        /* We have emptied the FIFO and there is a pending request to
+         * drain. Pass p_block = NULL to decoder just once. */
+    }
 
-        vlc_cond_signal( &p_owner->wait_fifo );
-        vlc_testcancel(); /* forced expedited cancellation in case of stop */
+    vlc_fifo_Unlock( p_owner->p_fifo );
 
-        block_t *p_block = vlc_fifo_DequeueUnlocked( p_owner->p_fifo );
-        if( p_block == NULL )
-        {
-            if( likely(!p_owner->b_draining) )
-            {   /* Wait for a block to decode (or a request to drain) */
-                p_owner->b_idle = true;
-                vlc_cond_signal( &p_owner->wait_acknowledge );
-                vlc_fifo_Wait( p_owner->p_fifo );
-                p_owner->b_idle = false;
-                continue;
-            }
-            /* We have emptied the FIFO and there is a pending request to
-             * drain. Pass p_block = NULL to decoder just once. */
-        }
+    int canc = vlc_savecancel();
+    vlc_trace_begin( "decoder", "process" );
+    DecoderProcess( p_dec, p_block );
+    vlc_trace_end( "decoder", "process" );
 
-        vlc_fifo_Unlock( p_owner->p_fifo );
+    if( p_block == NULL )
+    {   /* Draining: the decoder is drained and all decoded buffers are
+         * queued to the output at this point. Now drain the output. */
+        if( p_owner->p_aout != NULL )
+            aout_DecFlush( p_owner->p_aout, true );
+    }
+    vlc_restorecancel( canc );
 
-        int canc = vlc_savecancel();
-        DecoderProcess( p_dec, p_block );
+    /* TODO? Wait for draining instead of polling. */
+    vlc_mutex_lock( &p_owner->lock );
+    if( p_owner->b_draining && (p_block == NULL) )
+    {
+        p_owner->b_draining = false;
+        p_owner->drained = true;
+    }
+    vlc_fifo_Lock( p_owner->p_fifo );
+    vlc_cond_signal( &p_owner->wait_acknowledge );
+    vlc_mutex_unlock( &p_owner->lock );
+    return true;
+}
 
-        if( p_block == NULL )
-        {   /* Draining: the decoder is drained and all decoded buffers are
-             * queued to the output at this point. Now drain the output. */
-            if( p_owner->p_aout != NULL )
-                aout_DecFlush( p_owner->p_aout, true );
-        }
-        vlc_restorecancel( canc );
+/**
+ * The decoding main loop
+ *
+ * \param p_dec the decoder
+ */
+static void *DecoderThread( void *p_data )
+{
+    decoder_t *p_dec = (decoder_t *)p_data;
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+    bool paused = false;
 
-        /* TODO? Wait for draining instead of polling. */
-        vlc_mutex_lock( &p_owner->lock );
-        if( p_owner->b_draining && (p_block == NULL) )
+    /* The decoder's main loop */
+    vlc_fifo_Lock( p_owner->p_fifo );
+    vlc_fifo_CleanupPush( p_owner->p_fifo );
+
+    for( ;; )
+    {
+        vlc_testcancel(); /* forced expedited cancellation in case of stop */
+
+        if( !DecoderStep( p_dec, &paused ) )
         {
-            p_owner->b_draining = false;
-            p_owner->drained = true;
+            vlc_fifo_Wait( p_owner->p_fifo );
+            p_owner->b_idle = false;
         }
-        vlc_fifo_Lock( p_owner->p_fifo );
-        vlc_cond_signal( &p_owner->wait_acknowledge );
-        vlc_mutex_unlock( &p_owner->lock );
     }
     vlc_cleanup_pop();
     vlc_assert_unreachable();
 }
 
+/**
+ * Runs the decoder loop on the shared executor until it becomes idle.
+ *
+ * \param p_dec the decoder
+ */
+static void DecoderTask( void *p_data )
+{
+    decoder_t *p_dec = (decoder_t *)p_data;
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    vlc_fifo_Lock( p_owner->p_fifo );
+    p_owner->b_idle = false;
+
+    while( !p_owner->b_stopping
+        && DecoderStep( p_dec, &p_owner->b_task_paused ) );
+
+    p_owner->b_scheduled = false;
+    if( p_owner->b_stopping )
+        vlc_cond_broadcast( &p_owner->wait_fifo );
+    vlc_fifo_Unlock( p_owner->p_fifo );
+}
+
 /**
  * Create a decoder object
  *
@@ -1675,6 +2266,9 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
         return NULL;
     }
     p_owner->i_preroll_end = INT64_MIN;
+    p_owner->b_keyframes_only = false;
+    p_owner->b_keyframe_wait = false;
+    p_owner->b_free_run = p_input != NULL && input_priv(p_input)->b_free_run;
     p_owner->i_last_rate = INPUT_RATE_DEFAULT;
     p_owner->p_input = p_input;
     p_owner->p_resource = p_resource;
@@ -1706,10 +2300,17 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     atomic_init( &p_owner->reload, RELOAD_NO_REQUEST );
     p_owner->b_idle = false;
 
+    p_owner->p_executor = NULL;
+    p_owner->task.pf_run = DecoderTask;
+    p_owner->task.opaque = p_dec;
+    p_owner->b_scheduled = false;
+    p_owner->b_stopping = false;
+    p_owner->b_task_paused = false;
+
     es_format_Init( &p_owner->fmt, fmt->i_cat, 0 );
 
     /* decoder fifo */
-    p_owner->p_fifo = block_FifoNew();
+    p_owner->p_fifo = block_FifoNewSPSC();
     if( unlikely(p_owner->p_fifo == NULL) )
     {
         free( p_owner );
@@ -1721,6 +2322,12 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     vlc_cond_init( &p_owner->wait_request );
     vlc_cond_init( &p_owner->wait_acknowledge );
     vlc_cond_init( &p_owner->wait_fifo );
+    p_owner->p_memory = vlc_memory_Register( p_dec, VLC_MEMORY_NORMAL );
+    p_owner->i_fifo_max_duration = var_InheritInteger( p_dec,
+                                "decoder-fifo-duration" ) * (CLOCK_FREQ / 1000);
+    p_owner->i_fifo_in_ts = VLC_TICK_INVALID;
+    p_owner->i_fifo_out_ts = VLC_TICK_INVALID;
+    p_owner->i_fifo_throttled = VLC_TICK_INVALID;
     vlc_cond_init( &p_owner->wait_timed );
 
     /* Set buffers allocation callbacks for the decoders */
@@ -1803,6 +2410,13 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     for( unsigned i = 0; i < MAX_CC_DECODERS; i++ )
         p_owner->cc.pp_decoder[i] = NULL;
     p_owner->i_ts_delay = 0;
+    p_owner->i_ingest = 0;
+    p_owner->p_mirrors = NULL;
+    p_owner->i_mirrors = 0;
+    p_owner->i_mirrors_gen = 0;
+    p_owner->mirror_user.pf_remove = DecoderMirrorRemove;
+    if( p_resource != NULL )
+        input_resource_AttachMirrorUser( p_resource, &p_owner->mirror_user );
     return p_dec;
 }
 
@@ -1825,6 +2439,15 @@ static void DeleteDecoder( decoder_t * p_dec )
     /* Free all packets still in the decoder fifo. */
     block_FifoRelease( p_owner->p_fifo );
 
+    if( p_owner->p_resource != NULL )
+    {
+        input_resource_LockMirrors( p_owner->p_resource );
+        DecoderMirrorsClear( p_owner );
+        input_resource_UnlockMirrors( p_owner->p_resource );
+        input_resource_DetachMirrorUser( p_owner->p_resource,
+                                         &p_owner->mirror_user );
+    }
+
     /* Cleanup */
     if( p_owner->p_aout )
     {
@@ -1842,7 +2465,7 @@ static void DeleteDecoder( decoder_t * p_dec )
         vout_Cancel( p_owner->p_vout, false );
 
         input_resource_RequestVout( p_owner->p_resource, p_owner->p_vout, NULL,
-                                    0, true );
+                                    0, 0, true );
         if( p_owner->p_input != NULL )
             input_SendEventVout( p_owner->p_input );
     }
@@ -1877,6 +2500,7 @@ static void DeleteDecoder( decoder_t * p_dec )
 
     vlc_cond_destroy( &p_owner->wait_timed );
     vlc_cond_destroy( &p_owner->wait_fifo );
+    vlc_memory_Unregister( p_owner->p_memory );
     vlc_cond_destroy( &p_owner->wait_acknowledge );
     vlc_cond_destroy( &p_owner->wait_request );
     vlc_mutex_destroy( &p_owner->lock );
@@ -1940,6 +2564,18 @@ static decoder_t *decoder_New( vlc_object_t *p_parent, input_thread_t *p_input,
     else
         i_priority = VLC_THREAD_PRIORITY_VIDEO;
 
+    /* Lightweight decoders are mostly idle: run them on the shared executor
+     * if there is one, so that they do not hold a thread each. */
+    vlc_executor_t *p_executor =
+        libvlc_priv( p_parent->obj.libvlc )->p_decoder_executor;
+
+    if( p_executor != NULL && p_dec->fmt_out.i_cat != VIDEO_ES )
+    {
+        p_dec->p_owner->p_executor = p_executor;
+        p_dec->p_owner->b_idle = true;
+        return p_dec;
+    }
+
     /* Spawn the decoder thread */
     if( vlc_clone( &p_dec->p_owner->thread, DecoderThread, p_dec, i_priority ) )
     {
@@ -1988,12 +2624,16 @@ void input_DecoderDelete( decoder_t *p_dec )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
 
-    vlc_cancel( p_owner->thread );
+    if( p_owner->p_executor == NULL )
+        vlc_cancel( p_owner->thread );
 
     vlc_fifo_Lock( p_owner->p_fifo );
+    p_owner->b_stopping = true;
     /* Signal DecoderTimedWait */
     p_owner->flushing = true;
     vlc_cond_signal( &p_owner->wait_timed );
+    /* Wake a throttled sender up */
+    vlc_cond_broadcast( &p_owner->wait_fifo );
     vlc_fifo_Unlock( p_owner->p_fifo );
 
     /* Make sure we aren't waiting/decoding anymore */
@@ -2012,7 +2652,15 @@ void input_DecoderDelete( decoder_t *p_dec )
         vout_Cancel( p_owner->p_vout, true );
     vlc_mutex_unlock( &p_owner->lock );
 
-    vlc_join( p_owner->thread, NULL );
+    if( p_owner->p_executor == NULL )
+        vlc_join( p_owner->thread, NULL );
+    else
+    {
+        vlc_fifo_Lock( p_owner->p_fifo );
+        while( p_owner->b_scheduled )
+            vlc_fifo_WaitCond( p_owner->p_fifo, &p_owner->wait_fifo );
+        vlc_fifo_Unlock( p_owner->p_fifo );
+    }
 
     /* */
     if( p_dec->p_owner->cc.b_supported )
@@ -2036,30 +2684,67 @@ void input_DecoderDecode( decoder_t *p_dec, block_t *p_block, bool b_do_pace )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
 
-    vlc_fifo_Lock( p_owner->p_fifo );
+    if( BlockTimestamp( p_block ) > VLC_TICK_INVALID )
+        p_owner->i_fifo_in_ts = BlockTimestamp( p_block );
+
     if( !b_do_pace )
     {
-        /* FIXME: ideally we would check the time amount of data
-         * in the FIFO instead of its size. */
+        if( p_owner->i_fifo_max_duration > 0 )
+            DecoderFifoThrottle( p_owner );
+
+        /* The size is the last resort, when timestamps are missing or the
+         * decoder does not keep up. */
+        size_t bytes = vlc_fifo_GetBytes( p_owner->p_fifo );
+
+        vlc_memory_Set( p_owner->p_memory, bytes );
         /* 400 MiB, i.e. ~ 50mb/s for 60s */
-        if( vlc_fifo_GetBytes( p_owner->p_fifo ) > 400*1024*1024 )
+        if( bytes > 400*1024*1024
+         || ( bytes > 0
+           && !vlc_memory_Allow( p_owner->p_memory, p_block->i_buffer ) ) )
         {
             msg_Warn( p_dec, "decoder/packetizer fifo full (data not "
                       "consumed quickly enough), resetting fifo!" );
+            vlc_fifo_Lock( p_owner->p_fifo );
             block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+            p_owner->i_fifo_out_ts = VLC_TICK_INVALID;
+            vlc_fifo_Unlock( p_owner->p_fifo );
+            vlc_memory_Set( p_owner->p_memory, 0 );
             p_block->i_flags |= BLOCK_FLAG_DISCONTINUITY;
         }
+
+        if( p_owner->p_executor != NULL )
+        {
+            DecoderQueue( p_dec, p_block );
+            return;
+        }
+
+        /* Senders are serialized by the ES output lock: skip the FIFO lock */
+        vlc_fifo_Queue( p_owner->p_fifo, p_block );
+        return;
     }
-    else
+
+    vlc_fifo_Lock( p_owner->p_fifo );
     if( !p_owner->b_waiting )
     {   /* The FIFO is not consumed when waiting, so pacing would deadlock VLC.
          * Locking is not necessary as b_waiting is only read, not written by
          * the decoder thread. */
-        while( vlc_fifo_GetCount( p_owner->p_fifo ) >= 10 )
+        for( ;; )
+        {
+            size_t count = vlc_fifo_GetCount( p_owner->p_fifo );
+
+            vlc_memory_Set( p_owner->p_memory,
+                            vlc_fifo_GetBytes( p_owner->p_fifo ) );
+            /* An empty FIFO is always fed, lest the input stall */
+            if( count == 0 || ( count < 10
+             && vlc_memory_Allow( p_owner->p_memory, p_block->i_buffer ) ) )
+                break;
             vlc_fifo_WaitCond( p_owner->p_fifo, &p_owner->wait_fifo );
+        }
     }
 
     vlc_fifo_QueueUnlocked( p_owner->p_fifo, p_block );
+    if( p_owner->p_executor != NULL )
+        DecoderWakeUp( p_dec );
     vlc_fifo_Unlock( p_owner->p_fifo );
 }
 
@@ -2110,7 +2795,7 @@ void input_DecoderDrain( decoder_t *p_dec )
 
     vlc_fifo_Lock( p_owner->p_fifo );
     p_owner->b_draining = true;
-    vlc_fifo_Signal( p_owner->p_fifo );
+    DecoderWakeUp( p_dec );
     vlc_fifo_Unlock( p_owner->p_fifo );
 }
 
@@ -2126,6 +2811,8 @@ void input_DecoderFlush( decoder_t *p_dec )
 
     /* Empty the fifo */
     block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+    p_owner->i_fifo_in_ts = VLC_TICK_INVALID;
+    p_owner->i_fifo_out_ts = VLC_TICK_INVALID;
 
     /* Don't need to wait for the DecoderThread to flush. Indeed, if called a
      * second time, this function will clear the FIFO again before anything was
@@ -2140,8 +2827,9 @@ void input_DecoderFlush( decoder_t *p_dec )
      && p_owner->frames_countdown == 0 )
         p_owner->frames_countdown++;
 
-    vlc_fifo_Signal( p_owner->p_fifo );
+    DecoderWakeUp( p_dec );
     vlc_cond_signal( &p_owner->wait_timed );
+    vlc_cond_broadcast( &p_owner->wait_fifo );
 
     vlc_fifo_Unlock( p_owner->p_fifo );
 }
@@ -2258,7 +2946,7 @@ void input_DecoderChangePause( decoder_t *p_dec, bool b_paused, vlc_tick_t i_dat
     p_owner->paused = b_paused;
     p_owner->pause_date = i_date;
     p_owner->frames_countdown = 0;
-    vlc_fifo_Signal( p_owner->p_fifo );
+    DecoderWakeUp( p_dec );
     vlc_fifo_Unlock( p_owner->p_fifo );
 }
 
@@ -2271,6 +2959,18 @@ void input_DecoderChangeDelay( decoder_t *p_dec, vlc_tick_t i_delay )
     vlc_mutex_unlock( &p_owner->lock );
 }
 
+void input_DecoderSetKeyframesOnly( decoder_t *p_dec, bool b_keyframes_only )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    vlc_mutex_lock( &p_owner->lock );
+    /* Non-keyframes cannot be decoded until the next keyframe */
+    if( p_owner->b_keyframes_only && !b_keyframes_only )
+        p_owner->b_keyframe_wait = true;
+    p_owner->b_keyframes_only = b_keyframes_only;
+    vlc_mutex_unlock( &p_owner->lock );
+}
+
 void input_DecoderStartWait( decoder_t *p_dec )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
@@ -2332,7 +3032,7 @@ void input_DecoderFrameNext( decoder_t *p_dec, vlc_tick_t *pi_duration )
 
     vlc_fifo_Lock( p_owner->p_fifo );
     p_owner->frames_countdown++;
-    vlc_fifo_Signal( p_owner->p_fifo );
+    DecoderWakeUp( p_dec );
     vlc_fifo_Unlock( p_owner->p_fifo );
 
     vlc_mutex_lock( &p_owner->lock );
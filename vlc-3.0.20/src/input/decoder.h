@@ -43,6 +43,14 @@ void input_DecoderChangePause( decoder_t *, bool b_paused, vlc_tick_t i_date );
  */
 void input_DecoderChangeDelay( decoder_t *, vlc_tick_t i_delay );
 
+/**
+ * This function enables or disables trick play.
+ *
+ * In trick play, the blocks flagged as non-keyframes are dropped before
+ * decoding.
+ */
+void input_DecoderSetKeyframesOnly( decoder_t *, bool b_keyframes_only );
+
 /**
  * This function makes the decoder start waiting for a valid data block from its fifo.
  */
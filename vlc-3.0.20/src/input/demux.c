@@ -29,12 +29,19 @@
 #include <limits.h>
 
 #include "demux.h"
+#include "input_internal.h"
 #include <libvlc.h>
+#include "../modules/modules.h"
 #include <vlc_codec.h>
 #include <vlc_meta.h>
 #include <vlc_url.h>
 #include <vlc_modules.h>
 #include <vlc_strings.h>
+#include <vlc_fs.h>
+#include <vlc_md5.h>
+#include <vlc_configuration.h>
+#include <sys/stat.h>
+#include <dirent.h>
 
 typedef const struct
 {
@@ -175,6 +182,234 @@ static void demux_DestroyDemuxFilter(demux_t *demux)
     demux_Delete(demux->p_next);
 }
 
+/*****************************************************************************
+ * Probe buffer:
+ *  keeps the head of a slow stream while the demuxers are probed, so that
+ *  rewinding between candidates does not read the source again. Once the
+ *  opened demuxer has read past the head, the layer only forwards the
+ *  source (its blocks as is when it has some).
+ *****************************************************************************/
+#define DEMUX_PROBE_BUFFER_MAX (4 << 20)
+
+struct demux_probe_buffer
+{
+    uint8_t *data;
+    size_t size; /* bytes buffered from the start of the source */
+    size_t alloc;
+    bool probing; /* the buffer may still grow */
+    bool own_source;
+    uint64_t offset; /* reader position */
+    uint64_t source_offset;
+};
+
+static ssize_t ProbeBufferForward(stream_t *s, void *buf, size_t len)
+{
+    return vlc_stream_ReadPartial(s->p_source, buf, len);
+}
+
+static block_t *ProbeBufferForwardBlock(stream_t *s, bool *restrict eof)
+{
+    block_t *block = vlc_stream_ReadBlock(s->p_source);
+
+    if (block == NULL)
+        *eof = vlc_stream_Eof(s->p_source);
+    return block;
+}
+
+static int ProbeBufferForwardSeek(stream_t *s, uint64_t offset)
+{
+    return vlc_stream_Seek(s->p_source, offset);
+}
+
+/* Releases the head once the demuxer went past it, and stops buffering */
+static int ProbeBufferRelease(stream_t *s)
+{
+    struct demux_probe_buffer *sys = s->p_sys;
+
+    if (sys->probing || sys->offset < sys->size)
+        return VLC_EGENERIC;
+
+    if (sys->source_offset != sys->offset)
+    {
+        if (vlc_stream_Seek(s->p_source, sys->offset))
+            return VLC_EGENERIC;
+        sys->source_offset = sys->offset;
+    }
+
+    free(sys->data);
+    sys->data = NULL;
+    sys->size = sys->alloc = 0;
+
+    /* The stream core checks the callbacks on every call */
+    if (s->p_source->pf_block != NULL)
+    {
+        s->pf_read = NULL;
+        s->pf_block = ProbeBufferForwardBlock;
+    }
+    else
+        s->pf_read = ProbeBufferForward;
+    s->pf_seek = ProbeBufferForwardSeek;
+    return VLC_SUCCESS;
+}
+
+static ssize_t ProbeBufferRead(stream_t *s, void *buf, size_t len)
+{
+    struct demux_probe_buffer *sys = s->p_sys;
+
+    if (sys->offset < sys->size)
+    {
+        size_t copy = __MIN(len, sys->size - sys->offset);
+
+        memcpy(buf, sys->data + sys->offset, copy);
+        sys->offset += copy;
+        return copy;
+    }
+
+    if (ProbeBufferRelease(s) == VLC_SUCCESS)
+        return vlc_stream_ReadPartial(s->p_source, buf, len);
+
+    if (sys->source_offset != sys->offset)
+    {
+        if (vlc_stream_Seek(s->p_source, sys->offset))
+            return -1;
+        sys->source_offset = sys->offset;
+    }
+
+    if (sys->probing && sys->offset == sys->size
+     && sys->size < DEMUX_PROBE_BUFFER_MAX)
+    {
+        len = __MIN(len, DEMUX_PROBE_BUFFER_MAX - sys->size);
+
+        if (sys->size + len > sys->alloc)
+        {
+            size_t alloc = __MAX(sys->alloc * 2, sys->size + len);
+            uint8_t *data = realloc(sys->data, alloc);
+            if (unlikely(data == NULL))
+                return -1;
+            sys->data = data;
+            sys->alloc = alloc;
+        }
+
+        ssize_t val = vlc_stream_ReadPartial(s->p_source,
+                                             sys->data + sys->size, len);
+        if (val > 0)
+        {
+            memcpy(buf, sys->data + sys->size, val);
+            sys->size += val;
+            sys->offset += val;
+            sys->source_offset += val;
+        }
+        return val;
+    }
+
+    ssize_t val = vlc_stream_ReadPartial(s->p_source, buf, len);
+    if (val > 0)
+    {
+        sys->offset += val;
+        sys->source_offset += val;
+    }
+    return val;
+}
+
+static int ProbeBufferSeek(stream_t *s, uint64_t offset)
+{
+    struct demux_probe_buffer *sys = s->p_sys;
+
+    /* Within the head, the source is only repositioned when read again */
+    if (offset > sys->size)
+    {
+        if (vlc_stream_Seek(s->p_source, offset))
+            return VLC_EGENERIC;
+        sys->source_offset = offset;
+    }
+    sys->offset = offset;
+    return VLC_SUCCESS;
+}
+
+static int ProbeBufferControl(stream_t *s, int query, va_list args)
+{
+    struct demux_probe_buffer *sys = s->p_sys;
+    int ret = vlc_stream_vaControl(s->p_source, query, args);
+
+    if (ret == VLC_SUCCESS
+     && (query == STREAM_SET_TITLE || query == STREAM_SET_SEEKPOINT))
+    {   /* The source was rewound to another content */
+        free(sys->data);
+        sys->data = NULL;
+        sys->size = sys->alloc = 0;
+        sys->probing = false;
+        sys->offset = sys->source_offset = 0;
+    }
+    return ret;
+}
+
+static void ProbeBufferDelete(stream_t *s)
+{
+    struct demux_probe_buffer *sys = s->p_sys;
+
+    if (sys->own_source)
+        vlc_stream_Delete(s->p_source);
+    free(sys->data);
+    free(sys);
+}
+
+/* Only for sources that are slow to seek; s must be at its start */
+static stream_t *ProbeBufferNew(stream_t *source)
+{
+    bool fast;
+
+    if (source->pf_readdir != NULL) /* directories have no bytes to probe */
+        return NULL;
+    if (vlc_stream_Control(source, STREAM_CAN_FASTSEEK, &fast))
+        fast = false;
+    if (fast || vlc_stream_Tell(source) != 0)
+        return NULL;
+
+    struct demux_probe_buffer *sys = malloc(sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return NULL;
+
+    stream_t *s = vlc_stream_CommonNew(source->obj.parent, ProbeBufferDelete);
+    if (unlikely(s == NULL))
+    {
+        free(sys);
+        return NULL;
+    }
+
+    if (source->psz_url != NULL)
+        s->psz_url = strdup(source->psz_url);
+    s->p_input = source->p_input;
+    s->p_source = source;
+    s->pf_read = ProbeBufferRead;
+    s->pf_seek = ProbeBufferSeek;
+    s->pf_control = ProbeBufferControl;
+    s->p_sys = sys;
+
+    sys->data = NULL;
+    sys->size = sys->alloc = 0;
+    sys->probing = true;
+    sys->own_source = true;
+    sys->offset = sys->source_offset = 0;
+    return s;
+}
+
+/* Finds the demux module owning a probe callback, for debug logging */
+static const char *demux_ProbeName(void *func)
+{
+    module_t **mods;
+    const char *name = "?";
+    ssize_t n = module_list_cap(&mods, "demux");
+
+    for (ssize_t i = 0; i < n; i++)
+        if (mods[i]->pf_activate == func)
+        {
+            name = module_get_object(mods[i]);
+            break;
+        }
+    free(mods);
+    return name;
+}
+
 static int demux_Probe(void *func, va_list ap)
 {
     int (*probe)(vlc_object_t *) = func;
@@ -188,7 +423,223 @@ static int demux_Probe(void *func, va_list ap)
         return VLC_EGENERIC;
     }
 
-    return probe(VLC_OBJECT(demux));
+    vlc_tick_t start = mdate();
+    int ret = probe(VLC_OBJECT(demux));
+
+    msg_Dbg(demux, "demux module \"%s\" %s in %"PRId64" us",
+            demux_ProbeName(func), (ret == VLC_SUCCESS) ? "opened" : "probed",
+            mdate() - start);
+    return ret;
+}
+
+/*****************************************************************************
+ * Per file cache
+ *****************************************************************************/
+#define DEMUX_CACHE_DIR         "demux"
+#define DEMUX_CACHE_MAX_ENTRIES 256
+#define DEMUX_CACHE_MAX_SIZE    (16 << 20)
+
+static char *demux_CachePath( demux_t *p_demux, const char *psz_name )
+{
+    struct stat st;
+
+    if( p_demux->psz_file == NULL || strcasecmp( p_demux->psz_access, "file" )
+     || !var_InheritBool( p_demux, "demux-cache" )
+     || vlc_stat( p_demux->psz_file, &st ) || !S_ISREG( st.st_mode ) )
+        return NULL;
+
+    const int64_t i_size = st.st_size;
+    const int64_t i_mtime = st.st_mtime;
+    struct md5_s md5;
+
+    InitMD5( &md5 );
+    AddMD5( &md5, p_demux->psz_file, strlen( p_demux->psz_file ) + 1 );
+    AddMD5( &md5, &i_size, sizeof (i_size) );
+    AddMD5( &md5, &i_mtime, sizeof (i_mtime) );
+    AddMD5( &md5, psz_name, strlen( psz_name ) + 1 );
+    EndMD5( &md5 );
+
+    char *psz_hash = psz_md5_hash( &md5 );
+    char *psz_dir = config_GetUserDir( VLC_CACHE_DIR );
+    char *psz_path;
+    if( psz_hash == NULL || psz_dir == NULL
+     || asprintf( &psz_path, "%s"DIR_SEP DEMUX_CACHE_DIR DIR_SEP"%s",
+                  psz_dir, psz_hash ) < 0 )
+        psz_path = NULL;
+    free( psz_dir );
+    free( psz_hash );
+    return psz_path;
+}
+
+struct demux_cache_entry
+{
+    char *psz_path;
+    time_t i_mtime;
+};
+
+static int demux_CacheEntryCmp( const void *a, const void *b )
+{
+    const struct demux_cache_entry *ea = a, *eb = b;
+
+    return (ea->i_mtime > eb->i_mtime) - (ea->i_mtime < eb->i_mtime);
+}
+
+/* Number of entries in the cache directory, as last counted by this process
+ * plus the entries it added since, or UINT_MAX if not counted yet */
+static vlc_mutex_t demux_cache_lock = VLC_STATIC_MUTEX;
+static unsigned demux_cache_count = UINT_MAX;
+
+/* Counts the entries and, once the cache is full, removes the least recently
+ * written ones in one batch, down to three quarters of the limit, so that the
+ * directory is not scanned again on every following store.
+ * Returns the number of remaining entries. */
+static unsigned demux_CachePrune( const char *psz_dir )
+{
+    DIR *dir = vlc_opendir( psz_dir );
+    if( dir == NULL )
+        return 0;
+
+    const char *psz_ent;
+    struct demux_cache_entry *p_entries = NULL;
+    size_t i_count = 0, i_alloc = 0;
+
+    while( (psz_ent = vlc_readdir( dir )) != NULL )
+    {
+        char *psz_path;
+        struct stat st;
+
+        if( psz_ent[0] == '.'
+         || asprintf( &psz_path, "%s"DIR_SEP"%s", psz_dir, psz_ent ) < 0 )
+            continue;
+
+        if( vlc_stat( psz_path, &st ) == 0 )
+        {
+            if( i_count == i_alloc )
+            {
+                size_t i_new = i_alloc ? i_alloc * 2 : 64;
+                void *p_new = realloc( p_entries, i_new * sizeof (*p_entries) );
+                if( unlikely(p_new == NULL) )
+                {
+                    free( psz_path );
+                    break;
+                }
+                p_entries = p_new;
+                i_alloc = i_new;
+            }
+            p_entries[i_count].psz_path = psz_path;
+            p_entries[i_count].i_mtime = st.st_mtime;
+            i_count++;
+            continue;
+        }
+        free( psz_path );
+    }
+    closedir( dir );
+
+    size_t i_evict = 0;
+    if( i_count >= DEMUX_CACHE_MAX_ENTRIES )
+    {
+        qsort( p_entries, i_count, sizeof (*p_entries), demux_CacheEntryCmp );
+        i_evict = i_count - DEMUX_CACHE_MAX_ENTRIES * 3 / 4;
+    }
+
+    for( size_t i = 0; i < i_count; i++ )
+    {
+        if( i < i_evict && vlc_unlink( p_entries[i].psz_path ) )
+            i_evict = i; /* count what could not be removed */
+        free( p_entries[i].psz_path );
+    }
+    free( p_entries );
+    return i_count - i_evict;
+}
+
+block_t *demux_CacheLoad( demux_t *p_demux, const char *psz_name )
+{
+    char *psz_path = demux_CachePath( p_demux, psz_name );
+    if( psz_path == NULL )
+        return NULL;
+
+    block_t *p_block = block_FilePath( psz_path, false );
+    free( psz_path );
+
+    if( p_block != NULL && p_block->i_buffer == 0 )
+    {
+        block_Release( p_block );
+        p_block = NULL;
+    }
+    return p_block;
+}
+
+int demux_CacheStore( demux_t *p_demux, const char *psz_name,
+                      const void *p_data, size_t i_data )
+{
+    if( i_data == 0 || i_data > DEMUX_CACHE_MAX_SIZE )
+        return VLC_EGENERIC;
+
+    char *psz_path = demux_CachePath( p_demux, psz_name );
+    if( psz_path == NULL )
+        return VLC_EGENERIC;
+
+    char *psz_tmp;
+    if( asprintf( &psz_tmp, "%s.%p.tmp", psz_path, (void *)p_demux ) < 0 )
+    {
+        free( psz_path );
+        return VLC_ENOMEM;
+    }
+
+    /* the cache directory itself may not exist yet */
+    char *psz_dir = strrchr( psz_path, DIR_SEP_CHAR );
+    *psz_dir = '\0';
+    char *psz_parent = strrchr( psz_path, DIR_SEP_CHAR );
+    *psz_parent = '\0';
+    vlc_mkdir( psz_path, 0700 );
+    *psz_parent = DIR_SEP_CHAR;
+    vlc_mkdir( psz_path, 0700 );
+    *psz_dir = DIR_SEP_CHAR;
+
+    struct stat st;
+    if( vlc_stat( psz_path, &st ) )
+    {   /* new entry: make room first if the cache is (or may be) full */
+        vlc_mutex_lock( &demux_cache_lock );
+        if( demux_cache_count >= DEMUX_CACHE_MAX_ENTRIES )
+        {
+            *psz_dir = '\0';
+            demux_cache_count = demux_CachePrune( psz_path );
+            *psz_dir = DIR_SEP_CHAR;
+        }
+        demux_cache_count++;
+        vlc_mutex_unlock( &demux_cache_lock );
+    }
+
+    /* Write to a temporary file so that concurrent inputs never load a
+     * truncated entry */
+    int i_ret = VLC_EGENERIC;
+    FILE *file = vlc_fopen( psz_tmp, "wb" );
+    if( file != NULL )
+    {
+        bool b_ok = fwrite( p_data, 1, i_data, file ) == i_data;
+        if( fclose( file ) == 0 && b_ok && vlc_rename( psz_tmp, psz_path ) == 0 )
+            i_ret = VLC_SUCCESS;
+        else
+            vlc_unlink( psz_tmp );
+    }
+    free( psz_tmp );
+    free( psz_path );
+    return i_ret;
+}
+
+/* Name of the demux that opened the same file last time */
+static char *demux_CacheLoadModule( demux_t *p_demux )
+{
+    block_t *p_block = demux_CacheLoad( p_demux, "module" );
+    if( p_block == NULL )
+        return NULL;
+
+    char *psz_module = NULL;
+    if( p_block->i_buffer < 32
+     && memchr( p_block->p_buffer, ',', p_block->i_buffer ) == NULL )
+        psz_module = strndup( (const char *)p_block->p_buffer, p_block->i_buffer );
+    block_Release( p_block );
+    return psz_module;
 }
 
 /*****************************************************************************
@@ -237,6 +688,8 @@ demux_t *demux_NewAdvanced( vlc_object_t *p_obj, input_thread_t *p_parent_input,
     p_demux->s              = s;
     p_demux->out            = out;
     p_demux->b_preparsing   = b_preparsing;
+    p_demux->b_preparse_lite = b_preparsing && p_parent_input != NULL
+                            && input_priv(p_parent_input)->b_preparse_lite;
 
     p_demux->pf_demux   = NULL;
     p_demux->pf_control = NULL;
@@ -249,20 +702,53 @@ demux_t *demux_NewAdvanced( vlc_object_t *p_obj, input_thread_t *p_parent_input,
     if( s != NULL )
     {
         const char *psz_module = NULL;
+        char *psz_cached = NULL;
 
         if( !strcmp( p_demux->psz_demux, "any" ) && p_demux->psz_file )
         {
             char const* psz_ext = strrchr( p_demux->psz_file, '.' );
 
-            if( psz_ext )
+            /* try the demux that opened this very file last time first */
+            psz_module = psz_cached = demux_CacheLoadModule( p_demux );
+            if( psz_module == NULL && psz_ext )
                 psz_module = DemuxNameFromExtension( psz_ext + 1, b_preparsing );
         }
 
         if( psz_module == NULL )
             psz_module = p_demux->psz_demux;
 
+        stream_t *probe = ProbeBufferNew( s );
+        if( probe != NULL )
+            p_demux->s = probe;
+
         p_demux->p_module = vlc_module_load(p_demux, "demux", psz_module,
              !strcmp(psz_module, p_demux->psz_demux), demux_Probe, p_demux);
+
+        if( probe != NULL )
+        {
+            struct demux_probe_buffer *sys = probe->p_sys;
+
+            sys->probing = false;
+            if( p_demux->p_module == NULL )
+            {   /* The caller keeps the source */
+                sys->own_source = false;
+                vlc_stream_Delete( probe );
+                p_demux->s = s;
+            }
+            else /* demuxers may keep the stream pointer: forward from now */
+                ProbeBufferRelease( probe );
+        }
+
+        /* bulk preparsing should not churn the cache, and only a demux that
+         * won the normal probe is worth trying first next time */
+        if( p_demux->p_module != NULL && !b_preparsing && p_demux->psz_file
+         && !strcmp( p_demux->psz_demux, "any" ) )
+        {
+            const char *psz_name = module_get_object( p_demux->p_module );
+            if( psz_cached == NULL || strcmp( psz_cached, psz_name ) )
+                demux_CacheStore( p_demux, "module", psz_name, strlen( psz_name ) );
+        }
+        free( psz_cached );
     }
     else
     {
@@ -489,6 +975,7 @@ int demux_vaControlHelper( stream_t *s,
         case DEMUX_NAV_MENU:
         case DEMUX_FILTER_ENABLE:
         case DEMUX_FILTER_DISABLE:
+        case DEMUX_SET_KEYFRAMES_ONLY:
             return VLC_EGENERIC;
 
         case DEMUX_SET_TITLE:
@@ -57,6 +57,9 @@
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
+/* Bound of the record pre-roll of an ES, whatever its timestamps */
+#define ES_OUT_RECORD_PREROLL_MAX_SIZE (64*1024*1024)
+
 typedef struct
 {
     /* Program ID */
@@ -94,6 +97,14 @@ struct es_out_id_t
     decoder_t   *p_dec;
     decoder_t   *p_dec_record;
 
+    /* Last blocks, recorded first when recording starts */
+    struct
+    {
+        block_t *p_first;
+        block_t **pp_last;
+        size_t  i_size;
+    } record_preroll;
+
     vlc_tick_t  i_pts_level;
 
     /* Fields for Video with CC */
@@ -160,6 +171,10 @@ struct es_out_sys_t
     vlc_tick_t  i_pts_jitter;
     int         i_cr_average;
     int         i_rate;
+    bool        b_trickplay; /* video decoders only decode keyframes */
+    bool        b_clock_kalman;
+    bool        b_adaptive_caching;
+    vlc_tick_t  i_start_delay; /* fast start delay of live inputs, or 0 */
 
     /* */
     bool        b_paused;
@@ -177,6 +192,7 @@ struct es_out_sys_t
 
     /* Record */
     sout_instance_t *p_sout_record;
+    vlc_tick_t      i_record_preroll;
 
     /* Used only to limit debugging output */
     int         i_prev_stream_level;
@@ -192,6 +208,7 @@ static void         EsOutTerminate( es_out_t * );
 static void         EsOutSelect( es_out_t *, es_out_id_t *es, bool b_force );
 static void         EsOutUpdateInfo( es_out_t *, es_out_id_t *es, const es_format_t *, const vlc_meta_t * );
 static int          EsOutSetRecord(  es_out_t *, bool b_record );
+static void         EsRecordPrerollClean( es_out_id_t * );
 
 static bool EsIsSelected( es_out_id_t *es );
 static void EsSelect( es_out_t *out, es_out_id_t *es );
@@ -335,6 +352,17 @@ es_out_t *input_EsOutNew( input_thread_t *p_input, int i_rate )
     p_sys->i_pause_date = -1;
 
     p_sys->i_rate = i_rate;
+    p_sys->b_trickplay = i_rate < INPUT_RATE_TRICKPLAY;
+
+    char *psz_recovery = var_InheritString( p_input, "clock-recovery" );
+    p_sys->b_clock_kalman = psz_recovery != NULL
+                         && !strcmp( psz_recovery, "kalman" );
+    free( psz_recovery );
+    p_sys->b_adaptive_caching = var_InheritBool( p_input, "adaptive-caching" );
+    p_sys->i_start_delay = INT64_C(1000) * var_InheritInteger( p_input, "zap-caching" );
+
+    p_sys->i_record_preroll = CLOCK_FREQ *
+        var_InheritInteger( p_input, "input-record-preroll" );
 
     p_sys->b_buffering = true;
     p_sys->i_preroll_end = -1;
@@ -371,6 +399,7 @@ static void EsOutTerminate( es_out_t *out )
     {
         if( p_sys->es[i]->p_dec )
             input_DecoderDelete( p_sys->es[i]->p_dec );
+        EsRecordPrerollClean( p_sys->es[i] );
 
         free( p_sys->es[i]->psz_language );
         free( p_sys->es[i]->psz_language_code );
@@ -474,6 +503,126 @@ static void EsOutSetDelay( es_out_t *out, int i_cat, int64_t i_delay )
         EsOutDecoderChangeDelay( out, p_sys->es[i] );
 }
 
+static vlc_tick_t EsRecordPrerollTick( const block_t *p_block )
+{
+    return p_block->i_dts != VLC_TICK_INVALID ? p_block->i_dts : p_block->i_pts;
+}
+
+static bool EsRecordPrerollIsSync( const block_t *p_block )
+{
+    return ( p_block->i_flags & BLOCK_FLAG_TYPE_MASK ) == 0 ||
+           ( p_block->i_flags & BLOCK_FLAG_TYPE_I );
+}
+
+static void EsRecordPrerollClean( es_out_id_t *es )
+{
+    block_ChainRelease( es->record_preroll.p_first );
+    es->record_preroll.p_first = NULL;
+    es->record_preroll.pp_last = &es->record_preroll.p_first;
+    es->record_preroll.i_size = 0;
+}
+
+/* Keeps the last i_record_preroll of the ES, starting on a sync point, so
+ * that a recording can start with the data preceding it. The payloads are
+ * shared with the blocks sent to the decoder, not copied. */
+static void EsRecordPrerollAppend( es_out_t *out, es_out_id_t *es,
+                                   block_t **pp_block )
+{
+    es_out_sys_t *p_sys = out->p_sys;
+    block_t *p_dup = block_Share( pp_block );
+
+    if( p_dup == NULL )
+        return;
+    p_dup->p_next = NULL;
+    block_ChainLastAppend( &es->record_preroll.pp_last, p_dup );
+    es->record_preroll.i_size += p_dup->i_buffer;
+
+    const vlc_tick_t i_last = EsRecordPrerollTick( p_dup );
+
+    /* Drop up to the next sync point, while the remaining data still covers
+     * the pre-roll (or the timestamps went backward) */
+    for( ;; )
+    {
+        block_t *p_next = es->record_preroll.p_first->p_next;
+
+        while( p_next != NULL && !EsRecordPrerollIsSync( p_next ) )
+            p_next = p_next->p_next;
+        if( p_next == NULL )
+            break;
+
+        const vlc_tick_t i_next = EsRecordPrerollTick( p_next );
+        if( es->record_preroll.i_size <= ES_OUT_RECORD_PREROLL_MAX_SIZE &&
+            ( i_last == VLC_TICK_INVALID || i_next == VLC_TICK_INVALID ||
+              ( i_next <= i_last && i_last - i_next < p_sys->i_record_preroll ) ) )
+            break;
+
+        while( es->record_preroll.p_first != p_next )
+        {
+            block_t *p_drop = es->record_preroll.p_first;
+
+            es->record_preroll.p_first = p_drop->p_next;
+            es->record_preroll.i_size -= p_drop->i_buffer;
+            block_Release( p_drop );
+        }
+    }
+
+    /* Without a later sync point to cut at, enforce the size cap anyway:
+     * the recording then starts on a partial group of pictures */
+    while( es->record_preroll.i_size > ES_OUT_RECORD_PREROLL_MAX_SIZE )
+    {
+        block_t *p_drop = es->record_preroll.p_first;
+
+        es->record_preroll.p_first = p_drop->p_next;
+        es->record_preroll.i_size -= p_drop->i_buffer;
+        block_Release( p_drop );
+    }
+    if( es->record_preroll.p_first == NULL )
+        es->record_preroll.pp_last = &es->record_preroll.p_first;
+}
+
+/* Sends the pre-roll blocks of all ES to their record decoders, in
+ * timestamp order */
+static void EsOutRecordPrerollFlush( es_out_t *out )
+{
+    es_out_sys_t   *p_sys = out->p_sys;
+    input_thread_t *p_input = p_sys->p_input;
+
+    for( ;; )
+    {
+        es_out_id_t *p_cand = NULL;
+
+        for( int i = 0; i < p_sys->i_es; i++ )
+        {
+            es_out_id_t *es = p_sys->es[i];
+
+            if( es->record_preroll.p_first == NULL )
+                continue;
+            if( es->p_dec_record == NULL )
+            {
+                EsRecordPrerollClean( es );
+                continue;
+            }
+            if( p_cand == NULL ||
+                EsRecordPrerollTick( es->record_preroll.p_first ) <
+                EsRecordPrerollTick( p_cand->record_preroll.p_first ) )
+                p_cand = es;
+        }
+        if( p_cand == NULL )
+            break;
+
+        block_t *p_block = p_cand->record_preroll.p_first;
+
+        p_cand->record_preroll.p_first = p_block->p_next;
+        if( p_cand->record_preroll.p_first == NULL )
+            p_cand->record_preroll.pp_last = &p_cand->record_preroll.p_first;
+        p_cand->record_preroll.i_size -= p_block->i_buffer;
+        p_block->p_next = NULL;
+
+        input_DecoderDecode( p_cand->p_dec_record, p_block,
+                             input_priv(p_input)->b_out_pace_control );
+    }
+}
+
 static int EsOutSetRecord(  es_out_t *out, bool b_record )
 {
     es_out_sys_t   *p_sys = out->p_sys;
@@ -535,6 +684,8 @@ static int EsOutSetRecord(  es_out_t *out, bool b_record )
             if( p_es->p_dec_record && p_sys->b_buffering )
                 input_DecoderStartWait( p_es->p_dec_record );
         }
+
+        EsOutRecordPrerollFlush( out );
     }
     else
     {
@@ -616,6 +767,19 @@ static void EsOutChangeRate( es_out_t *out, int i_rate )
 
     p_sys->i_rate = i_rate;
     EsOutProgramsChangeRate( out );
+
+    const bool b_trickplay = i_rate < INPUT_RATE_TRICKPLAY;
+    if( b_trickplay != p_sys->b_trickplay )
+    {
+        p_sys->b_trickplay = b_trickplay;
+        for( int i = 0; i < p_sys->i_es; i++ )
+        {
+            es_out_id_t *p_es = p_sys->es[i];
+
+            if( p_es->p_dec != NULL && p_es->fmt.i_cat == VIDEO_ES )
+                input_DecoderSetKeyframesOnly( p_es->p_dec, b_trickplay );
+        }
+    }
 }
 
 static void EsOutChangePosition( es_out_t *out )
@@ -639,6 +803,7 @@ static void EsOutChangePosition( es_out_t *out )
             }
         }
         p_es->i_pts_level = VLC_TICK_INVALID;
+        EsRecordPrerollClean( p_es );
     }
 
     for( int i = 0; i < p_sys->i_pgrm; i++ ) {
@@ -673,7 +838,15 @@ static void EsOutDecodersStopBuffering( es_out_t *out, bool b_forced )
     if( p_sys->i_preroll_end >= 0 )
         i_preroll_duration = __MAX( p_sys->i_preroll_end - i_stream_start, 0 );
 
-    const vlc_tick_t i_buffering_duration = p_sys->i_pts_delay +
+    /* Start live inputs with less buffering, the clock catches up later */
+    vlc_tick_t i_pts_delay = p_sys->i_pts_delay;
+    const bool b_fast_start = p_sys->i_start_delay > 0
+                           && p_sys->i_start_delay < i_pts_delay
+                           && !input_priv(p_sys->p_input)->b_can_pace_control;
+    if( b_fast_start )
+        i_pts_delay = p_sys->i_start_delay;
+
+    const vlc_tick_t i_buffering_duration = i_pts_delay +
                                          i_preroll_duration +
                                          p_sys->i_buffering_extra_stream - p_sys->i_buffering_extra_initial;
 
@@ -703,6 +876,14 @@ static void EsOutDecodersStopBuffering( es_out_t *out, bool b_forced )
     p_sys->i_preroll_end = -1;
     p_sys->i_prev_stream_level = -1;
 
+    if( b_fast_start )
+    {
+        /* Only once: rebuffering means the start delay was too short */
+        p_sys->i_start_delay = 0;
+        for( int i = 0; i < p_sys->i_pgrm; i++ )
+            input_clock_SetStartDelay( p_sys->pgrm[i]->p_clock, i_pts_delay );
+    }
+
     if( p_sys->i_buffering_extra_initial > 0 )
     {
         /* FIXME wrong ? */
@@ -1085,7 +1266,8 @@ static es_out_pgrm_t *EsOutProgramAdd( es_out_t *out, int i_group )
     p_pgrm->b_scrambled = false;
     p_pgrm->i_last_pcr = VLC_TICK_INVALID;
     p_pgrm->p_meta = NULL;
-    p_pgrm->p_clock = input_clock_New( p_sys->i_rate );
+    p_pgrm->p_clock = input_clock_New( p_sys->i_rate, p_sys->b_clock_kalman,
+                                       p_sys->b_adaptive_caching );
     if( !p_pgrm->p_clock )
     {
         free( p_pgrm );
@@ -1625,6 +1807,9 @@ static es_out_id_t *EsOutAddSlave( es_out_t *out, const es_format_t *fmt, es_out
     es->psz_language_code = LanguageGetCode( es->fmt.psz_language );
     es->p_dec = NULL;
     es->p_dec_record = NULL;
+    es->record_preroll.p_first = NULL;
+    es->record_preroll.pp_last = &es->record_preroll.p_first;
+    es->record_preroll.i_size = 0;
     es->cc.type = 0;
     es->cc.i_bitmap = 0;
     es->p_master = p_master;
@@ -1682,6 +1867,8 @@ static void EsCreateDecoder( es_out_t *out, es_out_id_t *p_es )
     {
         if( p_sys->b_buffering )
             input_DecoderStartWait( p_es->p_dec );
+        if( p_sys->b_trickplay && p_es->fmt.i_cat == VIDEO_ES )
+            input_DecoderSetKeyframesOnly( p_es->p_dec, true );
 
         if( !p_es->p_master && p_sys->p_sout_record )
         {
@@ -1702,6 +1889,7 @@ static void EsDestroyDecoder( es_out_t *out, es_out_id_t *p_es )
 
     input_DecoderDelete( p_es->p_dec );
     p_es->p_dec = NULL;
+    EsRecordPrerollClean( p_es );
 
     if( p_es->p_dec_record )
     {
@@ -2063,6 +2251,9 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
             stats_Update( input_priv(p_input)->counters.p_demux_discontinuity, 1, NULL );
         }
         vlc_mutex_unlock( &input_priv(p_input)->counters.counters_lock );
+
+        /* End-to-end latency is accounted from here */
+        p_block->i_ingest = mdate();
     }
 
     vlc_mutex_lock( &p_sys->lock );
@@ -2111,7 +2302,7 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
     }
 
     /* Check for sout mode */
-    if( input_priv(p_input)->p_sout )
+    if( input_priv(p_input)->p_sout && !input_priv(p_input)->b_free_run )
     {
         /* FIXME review this, proper lock may be missing */
         if( input_priv(p_input)->p_sout->i_out_pace_nocontrol > 0 &&
@@ -2136,6 +2327,8 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
             input_DecoderDecode( es->p_dec_record, p_dup,
                                  input_priv(p_input)->b_out_pace_control );
     }
+    else if( p_sys->i_record_preroll > 0 && !es->p_master )
+        EsRecordPrerollAppend( out, es, &p_block );
     input_DecoderDecode( es->p_dec, p_block,
                          input_priv(p_input)->b_out_pace_control );
 
@@ -2241,6 +2434,7 @@ static void EsOutDel( es_out_t *out, es_out_id_t *es )
         }
     }
 
+    EsRecordPrerollClean( es );
     free( es->psz_language );
     free( es->psz_language_code );
 
@@ -2533,12 +2727,16 @@ static int EsOutControlLocked( es_out_t *out, int i_query, va_list args )
             if( p_sys->p_next_frame_es != NULL )
                 return VLC_SUCCESS;
 
-            if( b_late && ( !input_priv(p_sys->p_input)->p_sout ||
-                            !input_priv(p_sys->p_input)->b_out_pace_control ) )
+            /* Only sout and free-run control the pace */
+            if( b_late && !input_priv(p_sys->p_input)->b_out_pace_control )
             {
                 const vlc_tick_t i_pts_delay_base = p_sys->i_pts_delay - p_sys->i_pts_jitter;
                 vlc_tick_t i_pts_delay = input_clock_GetJitter( p_pgrm->p_clock );
 
+                /* The adaptive caching may have gone below the base delay */
+                if( i_pts_delay < i_pts_delay_base )
+                    i_pts_delay = i_pts_delay_base;
+
                 /* Avoid dangerously high value */
                 const vlc_tick_t i_jitter_max = INT64_C(1000) * var_InheritInteger( p_sys->p_input, "clock-jitter" );
                 if( i_pts_delay > __MIN( i_pts_delay_base + i_jitter_max, INPUT_PTS_DELAY_MAX ) )
@@ -2839,8 +3037,7 @@ static int EsOutControlLocked( es_out_t *out, int i_query, va_list args )
 
             /* Fix for buffering delay */
             if( p_sys->p_next_frame_es == NULL
-             && (!input_priv(p_sys->p_input)->p_sout ||
-                 !input_priv(p_sys->p_input)->b_out_pace_control ) )
+             && !input_priv(p_sys->p_input)->b_out_pace_control )
                 i_delay = EsOutGetBuffering( out );
             else
                 i_delay = 0;
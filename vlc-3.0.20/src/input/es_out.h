@@ -74,6 +74,9 @@ enum es_out_query_private_e
     /* Set a new time */
     ES_OUT_SET_TIME,                                /* arg1=vlc_tick_t          res=can fail */
 
+    /* Seek within the timeshift window, relative to the live position */
+    ES_OUT_SET_TIMESHIFT_OFFSET,                    /* arg1=vlc_tick_t          res=can fail */
+
     /* Set next frame */
     ES_OUT_SET_FRAME_NEXT,                          /*                          res=can fail */
 
@@ -140,6 +143,10 @@ static inline int es_out_SetTime( es_out_t *p_out, vlc_tick_t i_date )
 {
     return es_out_Control( p_out, ES_OUT_SET_TIME, i_date );
 }
+static inline int es_out_SetTimeshiftOffset( es_out_t *p_out, vlc_tick_t i_offset )
+{
+    return es_out_Control( p_out, ES_OUT_SET_TIMESHIFT_OFFSET, i_offset );
+}
 static inline int es_out_SetFrameNext( es_out_t *p_out )
 {
     return es_out_Control( p_out, ES_OUT_SET_FRAME_NEXT );
@@ -37,6 +37,11 @@
 #endif
 #include <sys/stat.h>
 #include <unistd.h>
+#include <fcntl.h>
+#if defined(HAVE_MMAP) && defined(HAVE_POSIX_FALLOCATE)
+#  include <sys/mman.h>
+#  define TS_STORAGE_MMAP 1
+#endif
 
 #include <vlc_common.h>
 #include <vlc_fs.h>
@@ -161,6 +166,15 @@ typedef struct attribute_packed
     } u;
 } ts_cmd_t;
 
+typedef struct
+{
+    vlc_tick_t i_date;
+    int        i_cmd;   /* Index of the command in the storage */
+    bool       b_key;   /* Keyframe, or only a clock reference */
+} ts_index_t;
+
+#define TS_STORAGE_CMD_COUNT (30000)
+
 typedef struct ts_storage_t ts_storage_t;
 struct ts_storage_t
 {
@@ -172,14 +186,22 @@ struct ts_storage_t
 #endif
     size_t  i_file_max; /* Max size in bytes */
     int64_t i_file_size;/* Current size in bytes */
-    FILE    *p_filew;   /* FILE handle for data writing */
-    FILE    *p_filer;   /* FILE handle for data reading */
+    int     fd;
+#ifdef TS_STORAGE_MMAP
+    uint8_t *p_map;     /* Mapping of the i_file_max bytes of the file */
+#endif
 
     /* */
     int      i_cmd_r;
     int      i_cmd_w;
+    int      i_cmd_done;/* Commands before were already executed once */
     int      i_cmd_max;
     ts_cmd_t *p_cmd;
+
+    /* Seek points, by increasing date */
+    int        i_index;
+    int        i_index_max;
+    ts_index_t *p_index;
 };
 
 typedef struct
@@ -193,6 +215,7 @@ typedef struct
     /* Lock for all following fields */
     vlc_mutex_t    lock;
     vlc_cond_t     wait;
+    vlc_cond_t     wait_seek;
 
     /* */
     bool           b_paused;
@@ -207,12 +230,22 @@ typedef struct
     /* */
     vlc_tick_t     i_buffering_delay;
 
-    /* */
+    /* Ring of storages, from the oldest one kept for seeking back
+     * (p_storage_h) to the one being written (p_storage_w) */
+    ts_storage_t   *p_storage_h;
     ts_storage_t   *p_storage_r;
     ts_storage_t   *p_storage_w;
+    ts_storage_t   *p_storage_spare; /* Prepared by TsRun() */
+    int            i_storage;        /* Including the spare one */
+    int            i_storage_max;
+    bool           b_overflow;
 
     vlc_tick_t     i_cmd_delay;
 
+    /* */
+    bool           b_seek;
+    vlc_tick_t     i_skip_date;     /* Data before is dropped */
+
 } ts_thread_t;
 
 struct es_out_id_t
@@ -227,6 +260,7 @@ struct es_out_sys_t
 
     /* Configuration */
     int64_t        i_tmp_size_max;    /* Maximal temporary file size in byte */
+    int            i_tmp_count_max;   /* Maximal number of temporary files */
     char           *psz_tmp_path;     /* Path for temporary files */
 
     /* Lock for all following fields */
@@ -263,6 +297,7 @@ static bool         TsHasCmd( ts_thread_t * );
 static bool         TsIsUnused( ts_thread_t * );
 static int          TsChangePause( ts_thread_t *, bool b_source_paused, bool b_paused, vlc_tick_t i_date );
 static int          TsChangeRate( ts_thread_t *, int i_src_rate, int i_rate );
+static int          TsSeek( ts_thread_t *, vlc_tick_t i_offset );
 
 static void         *TsRun( void * );
 
@@ -271,8 +306,9 @@ static void         TsStorageDelete( ts_storage_t * );
 static void         TsStoragePack( ts_storage_t *p_storage );
 static bool         TsStorageIsFull( ts_storage_t *, const ts_cmd_t *p_cmd );
 static bool         TsStorageIsEmpty( ts_storage_t * );
-static void         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd, bool b_flush );
-static void         TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush );
+static int          TsStorageReset( ts_storage_t * );
+static void         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd );
+static bool         TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush );
 
 static void CmdClean( ts_cmd_t * );
 static void cmd_cleanup_routine( void *p ) { CmdClean( p ); }
@@ -286,6 +322,7 @@ static int  CmdInitControl( ts_cmd_t *, int i_query, va_list, bool b_copy );
 static void CmdCleanAdd    ( ts_cmd_t * );
 static void CmdCleanSend   ( ts_cmd_t * );
 static void CmdCleanControl( ts_cmd_t *p_cmd );
+static bool CmdIsReplayable( const ts_cmd_t * );
 
 /* XXX these functions will take the destination es_out_t */
 static void CmdExecuteAdd    ( es_out_t *, ts_cmd_t * );
@@ -344,6 +381,13 @@ es_out_t *input_EsOutTimeshiftNew( input_thread_t *p_input, es_out_t *p_next_out
     msg_Dbg( p_input, "using timeshift granularity of %d MiB",
              (int)p_sys->i_tmp_size_max/(1024*1024) );
 
+    int64_t i_tmp_total_max = var_CreateGetInteger( p_input, "input-timeshift-size" );
+    if( i_tmp_total_max < 0 )
+        i_tmp_total_max = INT64_C(1024)*1024*1024;
+    p_sys->i_tmp_count_max = VLC_CLIP( i_tmp_total_max / p_sys->i_tmp_size_max, 2, 10000 );
+    msg_Dbg( p_input, "using at most %d timeshift files",
+             p_sys->i_tmp_count_max );
+
     p_sys->psz_tmp_path = var_InheritString( p_input, "input-timeshift-path" );
 #if defined (_WIN32) && !VLC_WINSTORE_APP
     if( p_sys->psz_tmp_path == NULL )
@@ -615,6 +659,15 @@ static int ControlLockedSetTime( es_out_t *p_out, vlc_tick_t i_date )
     msg_Err( p_sys->p_input, "EsOutTimeshift does not yet support time change" );
     return VLC_EGENERIC;
 }
+static int ControlLockedSetTimeshiftOffset( es_out_t *p_out, vlc_tick_t i_offset )
+{
+    es_out_sys_t *p_sys = p_out->p_sys;
+
+    if( !p_sys->b_delayed )
+        return VLC_EGENERIC;
+
+    return TsSeek( p_sys->p_ts, i_offset );
+}
 static int ControlLockedSetFrameNext( es_out_t *p_out )
 {
     es_out_sys_t *p_sys = p_out->p_sys;
@@ -714,6 +767,12 @@ static int ControlLocked( es_out_t *p_out, int i_query, va_list args )
 
         return ControlLockedSetTime( p_out, i_date );
     }
+    case ES_OUT_SET_TIMESHIFT_OFFSET:
+    {
+        const vlc_tick_t i_offset = (vlc_tick_t)va_arg( args, vlc_tick_t );
+
+        return ControlLockedSetTimeshiftOffset( p_out, i_offset );
+    }
     case ES_OUT_SET_FRAME_NEXT:
     {
         return ControlLockedSetFrameNext( p_out );
@@ -773,6 +832,7 @@ static int Control( es_out_t *p_out, int i_query, va_list args )
  *****************************************************************************/
 static void TsDestroy( ts_thread_t *p_ts )
 {
+    vlc_cond_destroy( &p_ts->wait_seek );
     vlc_cond_destroy( &p_ts->wait );
     vlc_mutex_destroy( &p_ts->lock );
     free( p_ts );
@@ -794,6 +854,7 @@ static int TsStart( es_out_t *p_out )
     p_ts->p_out = p_sys->p_out;
     vlc_mutex_init( &p_ts->lock );
     vlc_cond_init( &p_ts->wait );
+    vlc_cond_init( &p_ts->wait_seek );
     p_ts->b_paused = p_sys->b_input_paused && !p_sys->b_input_paused_source;
     p_ts->i_pause_date = p_ts->b_paused ? mdate() : -1;
     p_ts->i_rate_source = p_sys->i_input_rate_source;
@@ -802,8 +863,15 @@ static int TsStart( es_out_t *p_out )
     p_ts->i_rate_delay = 0;
     p_ts->i_buffering_delay = 0;
     p_ts->i_cmd_delay = 0;
+    p_ts->b_seek = false;
+    p_ts->i_skip_date = -1;
+    p_ts->p_storage_h = NULL;
     p_ts->p_storage_r = NULL;
     p_ts->p_storage_w = NULL;
+    p_ts->p_storage_spare = NULL;
+    p_ts->i_storage = 0;
+    p_ts->i_storage_max = p_sys->i_tmp_count_max;
+    p_ts->b_overflow = false;
 
     p_sys->b_delayed = true;
     if( vlc_clone( &p_ts->thread, TsRun, p_ts, VLC_THREAD_PRIORITY_INPUT ) )
@@ -845,43 +913,131 @@ static void TsStop( ts_thread_t *p_ts )
 
         CmdClean( &cmd );
     }
-    assert( !p_ts->p_storage_r || !p_ts->p_storage_r->p_next );
-    if( p_ts->p_storage_r )
-        TsStorageDelete( p_ts->p_storage_r );
+    while( p_ts->p_storage_h )
+    {
+        ts_storage_t *p_next = p_ts->p_storage_h->p_next;
+
+        TsStorageDelete( p_ts->p_storage_h );
+        p_ts->p_storage_h = p_next;
+    }
+    if( p_ts->p_storage_spare )
+        TsStorageDelete( p_ts->p_storage_spare );
     vlc_mutex_unlock( &p_ts->lock );
 
     TsDestroy( p_ts );
 }
+/* Gets a storage to write to: the spare one prepared by TsRun(), a new one
+ * while the ring is not complete, or else the oldest one already played */
+static ts_storage_t *TsGetStorageLocked( ts_thread_t *p_ts )
+{
+    ts_storage_t *p_storage = p_ts->p_storage_spare;
+
+    if( p_storage )
+    {
+        p_ts->p_storage_spare = NULL;
+        return p_storage;
+    }
+
+    if( p_ts->i_storage < p_ts->i_storage_max )
+    {
+        p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
+        if( p_storage )
+            p_ts->i_storage++;
+        return p_storage;
+    }
+
+    p_storage = p_ts->p_storage_h;
+    if( !p_storage || p_storage == p_ts->p_storage_r )
+        return NULL;
+
+    p_ts->p_storage_h = p_storage->p_next;
+    if( TsStorageReset( p_storage ) )
+    {
+        TsStorageDelete( p_storage );
+        p_ts->i_storage--;
+        return NULL;
+    }
+    return p_storage;
+}
+/* Creates the next storage ahead, so that the input thread does not have to
+ * wait for the file allocation */
+static void TsPrepareStorageLocked( ts_thread_t *p_ts )
+{
+    if( p_ts->p_storage_spare || p_ts->i_storage >= p_ts->i_storage_max )
+        return;
+
+    p_ts->i_storage++;
+    vlc_mutex_unlock( &p_ts->lock );
+
+    ts_storage_t *p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
+
+    vlc_mutex_lock( &p_ts->lock );
+    if( p_storage )
+    {
+        p_ts->p_storage_spare = p_storage;
+    }
+    else
+    {
+        msg_Warn( p_ts->p_input, "cannot create timeshift file, "
+                  "limiting timeshift to %d files", p_ts->i_storage - 1 );
+        p_ts->i_storage--;
+        p_ts->i_storage_max = __MAX( p_ts->i_storage, 1 );
+    }
+}
 static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
 {
     vlc_mutex_lock( &p_ts->lock );
 
-    if( !p_ts->p_storage_w || TsStorageIsFull( p_ts->p_storage_w, p_cmd ) )
+    /* Seeking back over an ES creation or deletion is not supported */
+    if( p_cmd->i_type == C_ADD || p_cmd->i_type == C_DEL )
     {
-        ts_storage_t *p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
+        for( ts_storage_t *p_storage = p_ts->p_storage_h; p_storage; p_storage = p_storage->p_next )
+            p_storage->i_index = 0;
+    }
 
-        if( !p_storage )
-        {
-            CmdClean( p_cmd );
-            vlc_mutex_unlock( &p_ts->lock );
-            /* TODO warn the user (but only once) */
-            return;
-        }
+    if( !p_ts->p_storage_w || TsStorageIsFull( p_ts->p_storage_w, p_cmd ) )
+    {
+        ts_storage_t *p_storage = TsGetStorageLocked( p_ts );
 
-        if( !p_ts->p_storage_w )
+        if( p_storage )
         {
-            p_ts->p_storage_r = p_ts->p_storage_w = p_storage;
+            if( !p_ts->p_storage_w )
+            {
+                p_ts->p_storage_h = p_ts->p_storage_r = p_ts->p_storage_w = p_storage;
+            }
+            else
+            {
+                TsStoragePack( p_ts->p_storage_w );
+                p_ts->p_storage_w->p_next = p_storage;
+                p_ts->p_storage_w = p_storage;
+            }
+            p_ts->b_overflow = false;
         }
         else
         {
-            TsStoragePack( p_ts->p_storage_w );
-            p_ts->p_storage_w->p_next = p_storage;
-            p_ts->p_storage_w = p_storage;
+            /* The ring is full of data not played yet: drop the new data,
+             * but keep the other commands */
+            ts_storage_t *p_storage_w = p_ts->p_storage_w;
+            ts_cmd_t *p_new = NULL;
+
+            if( p_storage_w && p_cmd->i_type != C_SEND )
+                p_new = realloc( p_storage_w->p_cmd,
+                                 2 * p_storage_w->i_cmd_max * sizeof(*p_new) );
+            if( !p_new )
+            {
+                if( !p_ts->b_overflow )
+                    msg_Warn( p_ts->p_input, "timeshift storage is full, dropping data" );
+                p_ts->b_overflow = true;
+                CmdClean( p_cmd );
+                vlc_mutex_unlock( &p_ts->lock );
+                return;
+            }
+            p_storage_w->p_cmd = p_new;
+            p_storage_w->i_cmd_max *= 2;
         }
     }
 
-    /* TODO return error and warn the user (but only once) */
-    TsStoragePushCmd( p_ts->p_storage_w, p_cmd, p_ts->p_storage_r == p_ts->p_storage_w );
+    TsStoragePushCmd( p_ts->p_storage_w, p_cmd );
 
     vlc_cond_signal( &p_ts->wait );
 
@@ -891,22 +1047,31 @@ static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool b_flush )
 {
     vlc_assert_locked( &p_ts->lock );
 
-    if( TsStorageIsEmpty( p_ts->p_storage_r ) )
-        return VLC_EGENERIC;
+    for( ;; )
+    {
+        ts_storage_t *p_storage = p_ts->p_storage_r;
 
-    TsStoragePopCmd( p_ts->p_storage_r, p_cmd, b_flush );
+        if( TsStorageIsEmpty( p_storage ) )
+            return VLC_EGENERIC;
 
-    while( TsStorageIsEmpty( p_ts->p_storage_r ) )
-    {
-        ts_storage_t *p_next = p_ts->p_storage_r->p_next;
-        if( !p_next )
-            break;
+        /* Data and clock skipped by a seek forward are not even read */
+        const ts_cmd_t *p_next = &p_storage->p_cmd[p_storage->i_cmd_r];
+        const bool b_skip = p_next->i_date < p_ts->i_skip_date && CmdIsReplayable( p_next );
 
-        TsStorageDelete( p_ts->p_storage_r );
-        p_ts->p_storage_r = p_next;
-    }
+        bool b_cmd = TsStoragePopCmd( p_storage, p_cmd, b_flush || b_skip );
 
-    return VLC_SUCCESS;
+        /* Played storages are kept for seeking back */
+        while( TsStorageIsEmpty( p_ts->p_storage_r ) && p_ts->p_storage_r->p_next )
+            p_ts->p_storage_r = p_ts->p_storage_r->p_next;
+
+        if( b_cmd && b_skip )
+        {
+            CmdClean( p_cmd );
+            b_cmd = false;
+        }
+        if( b_cmd )
+            return VLC_SUCCESS;
+    }
 }
 static bool TsHasCmd( ts_thread_t *p_ts )
 {
@@ -980,6 +1145,111 @@ static int TsChangeRate( ts_thread_t *p_ts, int i_src_rate, int i_rate )
     return i_ret;
 }
 
+/* Moves playback to the seek point closest to i_offset from the live
+ * position, preferably a keyframe */
+static int TsSeek( ts_thread_t *p_ts, vlc_tick_t i_offset )
+{
+    vlc_mutex_lock( &p_ts->lock );
+
+    const vlc_tick_t i_now = mdate();
+    const vlc_tick_t i_target = i_now + i_offset;
+    ts_storage_t *p_first = NULL, *p_ref = NULL, *p_key = NULL;
+    const ts_index_t *first = NULL, *ref = NULL, *key = NULL;
+    bool b_after = false;
+
+    for( ts_storage_t *p_storage = p_ts->p_storage_h;
+         p_storage && !b_after; p_storage = p_storage->p_next )
+    {
+        for( int i = 0; i < p_storage->i_index; i++ )
+        {
+            const ts_index_t *p_index = &p_storage->p_index[i];
+
+            if( !first )
+            {
+                p_first = p_storage;
+                first = p_index;
+            }
+            if( p_index->i_date > i_target )
+            {
+                b_after = true;
+                break;
+            }
+
+            p_ref = p_storage;
+            ref = p_index;
+            if( p_index->b_key )
+            {
+                p_key = p_storage;
+                key = p_index;
+            }
+        }
+    }
+
+    if( key )
+    {
+        p_ref = p_key;
+        ref = key;
+    }
+    else if( !ref )
+    {
+        /* Before the window, start from its beginning */
+        p_ref = p_first;
+        ref = first;
+    }
+    if( !ref )
+    {
+        vlc_mutex_unlock( &p_ts->lock );
+        msg_Warn( p_ts->p_input, "no timeshift seek point" );
+        return VLC_EGENERIC;
+    }
+
+    /* Position of the seek point relative to the reading one */
+    bool b_back = false;
+    for( ts_storage_t *p_storage = p_ref; ; p_storage = p_storage->p_next )
+    {
+        if( p_storage == p_ts->p_storage_r )
+        {
+            b_back = p_storage != p_ref || ref->i_cmd < p_storage->i_cmd_r;
+            break;
+        }
+        if( p_storage == p_ts->p_storage_w )
+            break;
+    }
+
+    if( b_back )
+    {
+        /* Replay the storages from there */
+        p_ts->p_storage_r = p_ref;
+        p_ref->i_cmd_r = ref->i_cmd;
+        for( ts_storage_t *p_storage = p_ref->p_next; p_storage; p_storage = p_storage->p_next )
+            p_storage->i_cmd_r = 0;
+        p_ts->i_skip_date = -1;
+    }
+    else
+    {
+        p_ts->i_skip_date = ref->i_date;
+    }
+    msg_Dbg( p_ts->p_input, "timeshift seek %s to %"PRId64" ms from live",
+             b_back ? "back" : "forward", (ref->i_date - i_now) / 1000 );
+
+    /* Play the seek point now */
+    p_ts->i_cmd_delay = i_now - ref->i_date;
+    p_ts->i_rate_date = -1;
+    p_ts->i_rate_delay = 0;
+    p_ts->i_buffering_delay = 0;
+    if( p_ts->b_paused )
+        p_ts->i_pause_date = i_now;
+
+    es_out_SetTime( p_ts->p_out, -1 );
+
+    p_ts->b_seek = true;
+    vlc_cond_signal( &p_ts->wait );
+    vlc_cond_signal( &p_ts->wait_seek );
+    vlc_mutex_unlock( &p_ts->lock );
+
+    return VLC_SUCCESS;
+}
+
 static void *TsRun( void *p_data )
 {
     ts_thread_t *p_ts = p_data;
@@ -990,6 +1260,7 @@ static void *TsRun( void *p_data )
         ts_cmd_t cmd;
         vlc_tick_t  i_deadline;
         bool b_buffering;
+        bool b_seek;
 
         /* Pop a command to execute */
         vlc_mutex_lock( &p_ts->lock );
@@ -998,6 +1269,7 @@ static void *TsRun( void *p_data )
         for( ;; )
         {
             const int canc = vlc_savecancel();
+            TsPrepareStorageLocked( p_ts );
             b_buffering = es_out_GetBuffering( p_ts->p_out );
 
             if( ( !p_ts->b_paused || b_buffering ) && !TsPopCmdLocked( p_ts, &cmd, false ) )
@@ -1009,6 +1281,7 @@ static void *TsRun( void *p_data )
 
             vlc_cond_wait( &p_ts->wait, &p_ts->lock );
         }
+        p_ts->b_seek = false;
 
         if( b_buffering && i_buffering_date < 0 )
         {
@@ -1059,17 +1332,27 @@ static void *TsRun( void *p_data )
         }
         i_deadline = cmd.i_date + p_ts->i_cmd_delay + p_ts->i_rate_delay + p_ts->i_buffering_delay;
 
-        vlc_cleanup_pop();
-        vlc_mutex_unlock( &p_ts->lock );
-
         /* Regulate the speed of command processing to the same one than
-         * reading  */
+         * reading, unless a seek changes the timeline meanwhile */
         vlc_cleanup_push( cmd_cleanup_routine, &cmd );
 
-        mwait( i_deadline );
+        while( !p_ts->b_seek &&
+               !vlc_cond_timedwait( &p_ts->wait_seek, &p_ts->lock, i_deadline ) );
 
         vlc_cleanup_pop();
 
+        b_seek = p_ts->b_seek;
+
+        vlc_cleanup_pop();
+        vlc_mutex_unlock( &p_ts->lock );
+
+        /* Data and clock from before the seek would mess with the new ones */
+        if( b_seek && CmdIsReplayable( &cmd ) )
+        {
+            CmdClean( &cmd );
+            continue;
+        }
+
         /* Execute the command  */
         const int canc = vlc_savecancel();
         switch( cmd.i_type )
@@ -1116,21 +1399,17 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
         return NULL;
     }
 
-    p_storage->p_filew = fdopen( fd, "w+b" );
-    if( p_storage->p_filew == NULL )
-    {
-        vlc_close( fd );
-        vlc_unlink( psz_file );
+#ifdef TS_STORAGE_MMAP
+    /* Allocate the whole file at once: a write to the mapping of a hole
+     * would crash on a full disk */
+    if( posix_fallocate( fd, 0, i_tmp_size_max ) )
         goto error;
-    }
 
-    p_storage->p_filer = vlc_fopen( psz_file, "rb" );
-    if( p_storage->p_filer == NULL )
-    {
-        fclose( p_storage->p_filew );
-        vlc_unlink( psz_file );
+    p_storage->p_map = mmap( NULL, i_tmp_size_max, PROT_READ|PROT_WRITE,
+                             MAP_SHARED, fd, 0 );
+    if( p_storage->p_map == MAP_FAILED )
         goto error;
-    }
+#endif
 
 #ifndef _WIN32
     vlc_unlink( psz_file );
@@ -1139,6 +1418,7 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
     p_storage->psz_file = psz_file;
 #endif
     p_storage->p_next = NULL;
+    p_storage->fd = fd;
 
     /* */
     p_storage->i_file_max = i_tmp_size_max;
@@ -1147,20 +1427,29 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
     /* */
     p_storage->i_cmd_w = 0;
     p_storage->i_cmd_r = 0;
-    p_storage->i_cmd_max = 30000;
+    p_storage->i_cmd_done = 0;
+    p_storage->i_cmd_max = TS_STORAGE_CMD_COUNT;
     p_storage->p_cmd = vlc_alloc( p_storage->i_cmd_max, sizeof(*p_storage->p_cmd) );
     //fprintf( stderr, "\nSTORAGE name=%s size=%d KiB\n", p_storage->psz_file, p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) /1024 );
 
+    p_storage->i_index = 0;
+    p_storage->i_index_max = 0;
+    p_storage->p_index = NULL;
+
     if( !p_storage->p_cmd )
     {
         TsStorageDelete( p_storage );
         return NULL;
     }
     return p_storage;
+#ifdef TS_STORAGE_MMAP
 error:
+    vlc_close( fd );
+    vlc_unlink( psz_file );
     free( psz_file );
     free( p_storage );
     return NULL;
+#endif
 }
 
 static void TsStorageDelete( ts_storage_t *p_storage )
@@ -1169,14 +1458,16 @@ static void TsStorageDelete( ts_storage_t *p_storage )
     {
         ts_cmd_t cmd;
 
-        TsStoragePopCmd( p_storage, &cmd, true );
-
-        CmdClean( &cmd );
+        if( TsStoragePopCmd( p_storage, &cmd, true ) )
+            CmdClean( &cmd );
     }
     free( p_storage->p_cmd );
+    free( p_storage->p_index );
 
-    fclose( p_storage->p_filer );
-    fclose( p_storage->p_filew );
+#ifdef TS_STORAGE_MMAP
+    munmap( p_storage->p_map, p_storage->i_file_max );
+#endif
+    vlc_close( p_storage->fd );
 #ifdef _WIN32
     vlc_unlink( p_storage->psz_file );
     free( p_storage->psz_file );
@@ -1184,6 +1475,29 @@ static void TsStorageDelete( ts_storage_t *p_storage )
     free( p_storage );
 }
 
+/* Empties a played storage to write to it again */
+static int TsStorageReset( ts_storage_t *p_storage )
+{
+    assert( p_storage->i_cmd_done == p_storage->i_cmd_w );
+
+    if( p_storage->i_cmd_max < TS_STORAGE_CMD_COUNT )
+    {
+        ts_cmd_t *p_new = realloc( p_storage->p_cmd,
+                                   TS_STORAGE_CMD_COUNT * sizeof(*p_storage->p_cmd) );
+        if( !p_new )
+            return VLC_ENOMEM;
+        p_storage->p_cmd = p_new;
+        p_storage->i_cmd_max = TS_STORAGE_CMD_COUNT;
+    }
+    p_storage->p_next = NULL;
+    p_storage->i_file_size = 0;
+    p_storage->i_cmd_r = 0;
+    p_storage->i_cmd_w = 0;
+    p_storage->i_cmd_done = 0;
+    p_storage->i_index = 0;
+    return VLC_SUCCESS;
+}
+
 static void TsStoragePack( ts_storage_t *p_storage )
 {
     /* Try to release a bit of memory */
@@ -1211,7 +1525,44 @@ static bool TsStorageIsEmpty( ts_storage_t *p_storage )
 {
     return !p_storage || p_storage->i_cmd_r >= p_storage->i_cmd_w;
 }
-static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bool b_flush )
+static int TsStorageWrite( ts_storage_t *p_storage, const void *p_data, size_t i_size )
+{
+#ifdef TS_STORAGE_MMAP
+    memcpy( &p_storage->p_map[p_storage->i_file_size], p_data, i_size );
+#else
+    if( lseek( p_storage->fd, p_storage->i_file_size, SEEK_SET ) < 0 ||
+        write( p_storage->fd, p_data, i_size ) != (ssize_t)i_size )
+        return VLC_EGENERIC;
+#endif
+    p_storage->i_file_size += i_size;
+    return VLC_SUCCESS;
+}
+static int TsStorageRead( ts_storage_t *p_storage, int64_t i_offset, void *p_data, size_t i_size )
+{
+#ifdef TS_STORAGE_MMAP
+    memcpy( p_data, &p_storage->p_map[i_offset], i_size );
+#else
+    if( lseek( p_storage->fd, i_offset, SEEK_SET ) < 0 ||
+        read( p_storage->fd, p_data, i_size ) != (ssize_t)i_size )
+        return VLC_EGENERIC;
+#endif
+    return VLC_SUCCESS;
+}
+static void TsStorageIndex( ts_storage_t *p_storage, vlc_tick_t i_date, bool b_key )
+{
+    if( p_storage->i_index >= p_storage->i_index_max )
+    {
+        const int i_max = __MAX( 2 * p_storage->i_index_max, 64 );
+        ts_index_t *p_new = realloc( p_storage->p_index, i_max * sizeof(*p_new) );
+        if( !p_new )
+            return;
+        p_storage->p_index = p_new;
+        p_storage->i_index_max = i_max;
+    }
+    p_storage->p_index[p_storage->i_index++] = (ts_index_t){
+        .i_date = i_date, .i_cmd = p_storage->i_cmd_w, .b_key = b_key };
+}
+static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
 {
     ts_cmd_t cmd = *p_cmd;
 
@@ -1221,45 +1572,54 @@ static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bo
     {
         block_t *p_block = cmd.u.send.p_block;
 
+        if( p_block->i_flags & BLOCK_FLAG_TYPE_I )
+            TsStorageIndex( p_storage, cmd.i_date, true );
+
         cmd.u.send.p_block = NULL;
-        cmd.u.send.i_offset = ftell( p_storage->p_filew );
+        cmd.u.send.i_offset = -1;
 
-        if( fwrite( p_block, sizeof(*p_block), 1, p_storage->p_filew ) != 1 )
+        /* A block bigger than a whole storage is lost */
+        if( p_storage->i_file_size + sizeof(*p_block) + p_block->i_buffer <= p_storage->i_file_max )
         {
-            block_Release( p_block );
-            return;
-        }
-        p_storage->i_file_size += sizeof(*p_block);
-        if( p_block->i_buffer > 0 )
-        {
-            if( fwrite( p_block->p_buffer, p_block->i_buffer, 1, p_storage->p_filew ) != 1 )
-            {
-                block_Release( p_block );
-                return;
-            }
+            const int64_t i_offset = p_storage->i_file_size;
+
+            if( !TsStorageWrite( p_storage, p_block, sizeof(*p_block) ) &&
+                !TsStorageWrite( p_storage, p_block->p_buffer, p_block->i_buffer ) )
+                cmd.u.send.i_offset = i_offset;
         }
-        p_storage->i_file_size += p_block->i_buffer;
         block_Release( p_block );
-
-        if( b_flush )
-            fflush( p_storage->p_filew );
+    }
+    else if( cmd.i_type == C_CONTROL &&
+             ( cmd.u.control.i_query == ES_OUT_SET_PCR ||
+               cmd.u.control.i_query == ES_OUT_SET_GROUP_PCR ) )
+    {
+        TsStorageIndex( p_storage, cmd.i_date, false );
     }
     p_storage->p_cmd[p_storage->i_cmd_w++] = cmd;
 }
-static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush )
+/* Returns false for an already executed command that cannot be replayed */
+static bool TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush )
 {
     assert( !TsStorageIsEmpty( p_storage ) );
 
+    const bool b_replay = p_storage->i_cmd_r < p_storage->i_cmd_done;
+
     *p_cmd = p_storage->p_cmd[p_storage->i_cmd_r++];
+    if( !b_replay )
+        p_storage->i_cmd_done = p_storage->i_cmd_r;
+    else if( b_flush || !CmdIsReplayable( p_cmd ) )
+        return false;
+
     if( p_cmd->i_type == C_SEND )
     {
+        const int64_t i_offset = p_cmd->u.send.i_offset;
         block_t block;
+        block_t *p_block = NULL;
 
-        if( !b_flush &&
-            !fseek( p_storage->p_filer, p_cmd->u.send.i_offset, SEEK_SET ) &&
-            fread( &block, sizeof(block), 1, p_storage->p_filer ) == 1 )
+        if( !b_flush && i_offset >= 0 &&
+            !TsStorageRead( p_storage, i_offset, &block, sizeof(block) ) )
         {
-            block_t *p_block = block_Alloc( block.i_buffer );
+            p_block = block_Alloc( block.i_buffer );
             if( p_block )
             {
                 p_block->i_dts      = block.i_dts;
@@ -1267,16 +1627,17 @@ static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_fl
                 p_block->i_flags    = block.i_flags;
                 p_block->i_length   = block.i_length;
                 p_block->i_nb_samples = block.i_nb_samples;
-                p_block->i_buffer = fread( p_block->p_buffer, 1, block.i_buffer, p_storage->p_filer );
+                if( TsStorageRead( p_storage, i_offset + sizeof(block),
+                                   p_block->p_buffer, block.i_buffer ) )
+                {
+                    block_Release( p_block );
+                    p_block = NULL;
+                }
             }
-            p_cmd->u.send.p_block = p_block;
-        }
-        else
-        {
-            //perror( "TsStoragePopCmd" );
-            p_cmd->u.send.p_block = block_Alloc( 1 );
         }
+        p_cmd->u.send.p_block = p_block;
     }
+    return true;
 }
 
 /*****************************************************************************
@@ -1614,6 +1975,21 @@ static int CmdExecuteControl( es_out_t *p_out, ts_cmd_t *p_cmd )
         return VLC_EGENERIC;
     }
 }
+/* Tells if a command can be executed again when seeking back: its
+ * parameters were not released, and it does not change the ES state */
+static bool CmdIsReplayable( const ts_cmd_t *p_cmd )
+{
+    switch( p_cmd->i_type )
+    {
+    case C_SEND:
+        return true;
+    case C_CONTROL:
+        return p_cmd->u.control.i_query == ES_OUT_SET_PCR ||
+               p_cmd->u.control.i_query == ES_OUT_SET_GROUP_PCR;
+    default:
+        return false;
+    }
+}
 static void CmdCleanControl( ts_cmd_t *p_cmd )
 {
     switch( p_cmd->u.control.i_query )
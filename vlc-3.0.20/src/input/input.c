@@ -43,6 +43,7 @@
 #include "item.h"
 #include "resource.h"
 #include "stream.h"
+#include "../libvlc.h"
 
 #include <vlc_aout.h>
 #include <vlc_sout.h>
@@ -55,6 +56,7 @@
 #include <vlc_stream.h>
 #include <vlc_stream_extractor.h>
 #include <vlc_renderer_discovery.h>
+#include <vlc_trace.h>
 
 /*****************************************************************************
  * Local prototypes
@@ -63,7 +65,7 @@ static  void *Run( void * );
 static  void *Preparse( void * );
 
 static input_thread_t * Create  ( vlc_object_t *, input_item_t *,
-                                  const char *, bool, input_resource_t *,
+                                  const char *, bool, bool, input_resource_t *,
                                   vlc_renderer_item_t * );
 static  int             Init    ( input_thread_t *p_input );
 static void             End     ( input_thread_t *p_input );
@@ -130,7 +132,32 @@ input_thread_t *input_Create( vlc_object_t *p_parent,
                               const char *psz_log, input_resource_t *p_resource,
                               vlc_renderer_item_t *p_renderer )
 {
-    return Create( p_parent, p_item, psz_log, false, p_resource, p_renderer );
+    return Create( p_parent, p_item, psz_log, false, false, p_resource,
+                   p_renderer );
+}
+
+input_thread_t *input_CreatePreroll( vlc_object_t *p_parent,
+                                     input_item_t *p_item,
+                                     input_resource_t *p_resource,
+                                     vlc_renderer_item_t *p_renderer )
+{
+    return Create( p_parent, p_item, NULL, false, true, p_resource,
+                   p_renderer );
+}
+
+/**
+ * Let a prerolled input start playback.
+ *
+ * \param p_input the input thread created by input_CreatePreroll()
+ */
+void input_EndPreroll( input_thread_t *p_input )
+{
+    input_thread_private_t *priv = input_priv(p_input);
+
+    vlc_mutex_lock( &priv->lock_control );
+    priv->b_preroll = false;
+    vlc_cond_signal( &priv->wait_control );
+    vlc_mutex_unlock( &priv->lock_control );
 }
 
 #undef input_Read
@@ -143,7 +170,8 @@ input_thread_t *input_Create( vlc_object_t *p_parent,
  */
 int input_Read( vlc_object_t *p_parent, input_item_t *p_item )
 {
-    input_thread_t *p_input = Create( p_parent, p_item, NULL, false, NULL, NULL );
+    input_thread_t *p_input = Create( p_parent, p_item, NULL, false, false,
+                                      NULL, NULL );
     if( !p_input )
         return VLC_EGENERIC;
 
@@ -160,7 +188,7 @@ int input_Read( vlc_object_t *p_parent, input_item_t *p_item )
 input_thread_t *input_CreatePreparser( vlc_object_t *parent,
                                        input_item_t *item )
 {
-    return Create( parent, item, NULL, true, NULL, NULL );
+    return Create( parent, item, NULL, true, false, NULL, NULL );
 }
 
 /**
@@ -284,7 +312,7 @@ input_item_t *input_GetItem( input_thread_t *p_input )
  *****************************************************************************/
 static input_thread_t *Create( vlc_object_t *p_parent, input_item_t *p_item,
                                const char *psz_header, bool b_preparsing,
-                               input_resource_t *p_resource,
+                               bool b_preroll, input_resource_t *p_resource,
                                vlc_renderer_item_t *p_renderer )
 {
     /* Allocate descriptor */
@@ -318,6 +346,7 @@ static input_thread_t *Create( vlc_object_t *p_parent, input_item_t *p_item,
     priv->i_state = INIT_S;
     priv->is_running = false;
     priv->is_stopped = false;
+    priv->b_preroll = b_preroll;
     priv->b_recording = false;
     priv->b_next_frame = false;
     priv->i_rate = INPUT_RATE_DEFAULT;
@@ -327,6 +356,7 @@ static input_thread_t *Create( vlc_object_t *p_parent, input_item_t *p_item,
     priv->attachment_demux = NULL;
     priv->p_sout   = NULL;
     priv->b_out_pace_control = false;
+    priv->b_free_run = false;
     priv->p_renderer = p_renderer && b_preparsing == false ?
                 vlc_renderer_item_hold( p_renderer ) : NULL;
 
@@ -369,6 +399,9 @@ static input_thread_t *Create( vlc_object_t *p_parent, input_item_t *p_item,
     else
         p_input->obj.flags |= OBJECT_FLAGS_QUIET | OBJECT_FLAGS_NOINTERACT;
 
+    /* Demuxers may skip everything but the headers */
+    priv->b_preparse_lite = priv->b_preparsing && p_item->b_preparse_lite;
+
     /* Make sure the interaction option is honored */
     if( !var_InheritBool( p_input, "interact" ) )
         p_input->obj.flags |= OBJECT_FLAGS_NOINTERACT;
@@ -397,7 +430,10 @@ static input_thread_t *Create( vlc_object_t *p_parent, input_item_t *p_item,
         priv->p_resource_private = input_resource_New( VLC_OBJECT( p_input ) );
         priv->p_resource = input_resource_Hold( priv->p_resource_private );
     }
-    input_resource_SetInput( priv->p_resource, p_input );
+    /* A prerolled input must not disturb the one playing meanwhile */
+    priv->b_attached = !b_preroll;
+    if( priv->b_attached )
+        input_resource_SetInput( priv->p_resource, p_input );
 
     /* Init control buffer */
     vlc_mutex_init( &priv->lock_control );
@@ -487,28 +523,71 @@ static input_thread_t *Create( vlc_object_t *p_parent, input_item_t *p_item,
  * This is the "normal" thread that spawns the input processing chain,
  * reads the stream, cleans up and waits
  *****************************************************************************/
+/**
+ * Waits until a prerolled input is allowed to play.
+ *
+ * \return false if the input was stopped meanwhile
+ */
+static bool PrerollWait( input_thread_t *p_input )
+{
+    input_thread_private_t *priv = input_priv(p_input);
+
+    vlc_mutex_lock( &priv->lock_control );
+    if( priv->b_preroll && !priv->is_stopped )
+        msg_Dbg( p_input, "prerolled, waiting" );
+    while( priv->b_preroll && !priv->is_stopped )
+        vlc_cond_wait( &priv->wait_control, &priv->lock_control );
+    const bool b_play = !priv->b_preroll;
+    vlc_mutex_unlock( &priv->lock_control );
+
+    if( b_play && !priv->b_attached )
+    {
+        priv->b_attached = true;
+        input_resource_SetInput( priv->p_resource, p_input );
+    }
+    return b_play;
+}
+
 static void *Run( void *data )
 {
     input_thread_private_t *priv = data;
     input_thread_t *p_input = &priv->input;
+    struct vlc_affinity *affinity =
+        libvlc_priv( p_input->obj.libvlc )->affinity;
+    struct vlc_affinity_group *group = NULL;
 
     vlc_interrupt_set(&priv->interrupt);
 
+    /* Before Init(), so that every thread of the input inherits it */
+    if( affinity != NULL )
+    {
+        group = vlc_affinity_Place( affinity, VLC_OBJECT(p_input) );
+        if( group != NULL )
+            var_SetString( p_input, "thread-placement",
+                           vlc_affinity_GroupName( group ) );
+    }
+
     if( !Init( p_input ) )
     {
-        if( priv->b_can_pace_control && priv->b_out_pace_control )
+        if( PrerollWait( p_input ) )
         {
-            /* We don't want a high input priority here or we'll
-             * end-up sucking up all the CPU time */
-            vlc_set_priority( priv->thread, VLC_THREAD_PRIORITY_LOW );
-        }
+            if( priv->b_can_pace_control && priv->b_out_pace_control )
+            {
+                /* We don't want a high input priority here or we'll
+                 * end-up sucking up all the CPU time */
+                vlc_set_priority( priv->thread, VLC_THREAD_PRIORITY_LOW );
+            }
 
-        MainLoop( p_input, true ); /* FIXME it can be wrong (like with VLM) */
+            MainLoop( p_input, true ); /* FIXME it can be wrong (like with VLM) */
+        }
 
         /* Clean up */
         End( p_input );
     }
 
+    if( group != NULL )
+        vlc_affinity_Leave( affinity, group );
+
     input_SendEventDead( p_input );
     return NULL;
 }
@@ -575,7 +654,11 @@ static void MainLoopDemux( input_thread_t *p_input, bool *pb_changed )
     }
 
     if( i_ret == VLC_DEMUXER_SUCCESS )
+    {
+        vlc_trace_begin( "input", "demux" );
         i_ret = demux_Demux( p_demux );
+        vlc_trace_end( "input", "demux" );
+    }
 
     i_ret = i_ret > 0 ? VLC_DEMUXER_SUCCESS : ( i_ret < 0 ? VLC_DEMUXER_EGENERIC : VLC_DEMUXER_EOF);
 
@@ -839,6 +922,12 @@ static void InitStatistics( input_thread_t *p_input )
         INIT_COUNTER( decoded_audio, COUNTER );
         INIT_COUNTER( decoded_video, COUNTER );
         INIT_COUNTER( decoded_sub, COUNTER );
+        memset( priv->counters.vout_timings, 0,
+                sizeof( priv->counters.vout_timings ) );
+        memset( priv->counters.video_latency, 0,
+                sizeof( priv->counters.video_latency ) );
+        memset( priv->counters.audio_latency, 0,
+                sizeof( priv->counters.audio_latency ) );
         priv->counters.p_sout_send_bitrate = NULL;
         priv->counters.p_sout_sent_packets = NULL;
         priv->counters.p_sout_sent_bytes = NULL;
@@ -1382,6 +1471,11 @@ static int Init( input_thread_t * p_input )
 
     InitTitle( p_input );
 
+    /* Offline processing: only the decoders FIFOs pace the input. This must
+     * be known before the decoders are created. */
+    priv->b_free_run = !priv->b_preparsing && priv->b_can_pace_control
+                    && var_InheritBool( p_input, "free-run" );
+
     /* Load master infos */
     /* Init length */
     vlc_tick_t i_length;
@@ -1408,7 +1502,12 @@ static int Init( input_thread_t * p_input )
         }
     }
 
-    if( !priv->b_preparsing && priv->p_sout )
+    if( priv->b_free_run )
+    {
+        priv->b_out_pace_control = true;
+        msg_Dbg( p_input, "starting in free-run mode" );
+    }
+    else if( !priv->b_preparsing && priv->p_sout )
     {
         priv->b_out_pace_control = priv->p_sout->i_out_pace_nocontrol > 0;
 
@@ -1452,7 +1551,8 @@ error:
         if( input_priv(p_input)->p_sout )
             input_resource_RequestSout( input_priv(p_input)->p_resource,
                                          input_priv(p_input)->p_sout, NULL );
-        input_resource_SetInput( input_priv(p_input)->p_resource, NULL );
+        if( input_priv(p_input)->b_attached )
+            input_resource_SetInput( input_priv(p_input)->p_resource, NULL );
         if( input_priv(p_input)->p_resource_private )
             input_resource_Terminate( input_priv(p_input)->p_resource_private );
     }
@@ -1584,7 +1684,8 @@ do { \
     /* */
     input_resource_RequestSout( input_priv(p_input)->p_resource,
                                  input_priv(p_input)->p_sout, NULL );
-    input_resource_SetInput( input_priv(p_input)->p_resource, NULL );
+    if( input_priv(p_input)->b_attached )
+        input_resource_SetInput( input_priv(p_input)->p_resource, NULL );
     if( input_priv(p_input)->p_resource_private )
         input_resource_Terminate( input_priv(p_input)->p_resource_private );
 }
@@ -2062,6 +2163,18 @@ static bool Control( input_thread_t *p_input,
             if( i_time < 0 )
                 i_time = 0;
 
+            /* While timeshifting a live stream, seek within what was
+             * already received rather than in the stream */
+            int64_t i_live;
+            if( !demux_Control( input_priv(p_input)->master->p_demux,
+                                DEMUX_GET_TIME, &i_live ) &&
+                !es_out_SetTimeshiftOffset( input_priv(p_input)->p_es_out,
+                                            i_time - i_live ) )
+            {
+                b_force_update = true;
+                break;
+            }
+
             /* Reset the decoders states and clock sync (before calling the demuxer */
             es_out_SetTime( input_priv(p_input)->p_es_out, -1 );
 
@@ -2178,6 +2291,12 @@ static bool Control( input_thread_t *p_input,
             /* */
             if( i_rate != input_priv(p_input)->i_rate )
             {
+                bool b_trickplay = i_rate > 0 && i_rate < INPUT_RATE_TRICKPLAY;
+                if( b_trickplay != ( input_priv(p_input)->i_rate > 0 &&
+                        input_priv(p_input)->i_rate < INPUT_RATE_TRICKPLAY ) )
+                    demux_Control( input_priv(p_input)->master->p_demux,
+                                   DEMUX_SET_KEYFRAMES_ONLY, b_trickplay );
+
                 input_priv(p_input)->i_rate = i_rate;
                 input_SendEventRate( p_input, i_rate );
 
@@ -53,6 +53,25 @@ void input_item_SetEpgOffline( input_item_t * );
 input_thread_t *input_CreatePreparser(vlc_object_t *obj, input_item_t *item)
 VLC_USED;
 
+/**
+ * Creates an input to play next.
+ *
+ * Once started with input_Start(), the input opens the item, its demuxer and
+ * its decoders, but it does not demux nor use the input resource until
+ * input_EndPreroll() is called. This hides the opening time of an item
+ * while the previous one is still playing.
+ *
+ * @param obj parent object
+ * @param item input item to play
+ * @param resource input resource shared with the playing input
+ * @param renderer renderer, or NULL
+ * @return an input thread or NULL on error
+ */
+input_thread_t *input_CreatePreroll(vlc_object_t *obj, input_item_t *item,
+                                    input_resource_t *resource,
+                                    vlc_renderer_item_t *renderer) VLC_USED;
+void input_EndPreroll(input_thread_t *);
+
 /* misc/stats.c
  * FIXME it should NOT be defined here or not coded in misc/stats.c */
 input_stats_t *stats_NewInputStats( input_thread_t *p_input );
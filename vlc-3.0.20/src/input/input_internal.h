@@ -88,6 +88,7 @@ typedef struct input_thread_private_t
 
     /* Global properties */
     bool        b_preparsing;
+    bool        b_preparse_lite;
     bool        b_can_pause;
     bool        b_can_rate_control;
     bool        b_can_pace_control;
@@ -96,6 +97,8 @@ typedef struct input_thread_private_t
     int         i_state;
     bool        is_running;
     bool        is_stopped;
+    bool        b_preroll; /* waiting for input_EndPreroll() */
+    bool        b_attached; /* the resource is bound to this input */
     bool        b_recording;
     bool        b_next_frame;
     int         i_rate;
@@ -108,6 +111,7 @@ typedef struct input_thread_private_t
 
     /* Output */
     bool            b_out_pace_control; /* XXX Move it ot es_sout ? */
+    bool            b_free_run; /* :free-run, no clock pacing at all */
     sout_instance_t *p_sout;            /* Idem ? */
     es_out_t        *p_es_out;
     es_out_t        *p_es_out_display;
@@ -166,6 +170,9 @@ typedef struct input_thread_private_t
         counter_t *p_lost_abuffers;
         counter_t *p_displayed_pictures;
         counter_t *p_lost_pictures;
+        uint64_t vout_timings[INPUT_STATS_VOUT_TIMINGS][INPUT_STATS_TIMING_BUCKETS];
+        uint64_t video_latency[INPUT_STATS_LATENCY_BUCKETS];
+        uint64_t audio_latency[INPUT_STATS_LATENCY_BUCKETS];
         vlc_mutex_t counters_lock;
     } counters;
 
@@ -248,6 +255,9 @@ bool input_Stopped( input_thread_t * );
 /* Bound pts_delay */
 #define INPUT_PTS_DELAY_MAX INT64_C(60000000)
 
+/* Rates faster than this (more than 4x) only decode the video keyframes */
+#define INPUT_RATE_TRICKPLAY (INPUT_RATE_DEFAULT/4)
+
 /**********************************************************************
  * Item metadata
  **********************************************************************/
@@ -73,6 +73,18 @@ struct input_resource_t
 
     bool            b_aout_busy;
     audio_output_t *p_aout;
+
+    /* Resources of the players showing what the decoders output, in
+     * addition to ours (protected by lock_hold) */
+    input_resource_t **pp_mirror;
+    int             i_mirror;
+    atomic_uint     mirror_gen;
+
+    /* Serializes the use of the mirror outputs with their removal, and
+     * protects the users of those outputs */
+    vlc_mutex_t     lock_mirror;
+    input_resource_mirror_user_t **pp_mirror_user;
+    int             i_mirror_user;
 };
 
 /* */
@@ -196,7 +208,7 @@ static void DisplayVoutTitle( input_resource_t *p_resource,
 static vout_thread_t *RequestVout( input_resource_t *p_resource,
                                    vout_thread_t *p_vout,
                                    const video_format_t *p_fmt, unsigned dpb_size,
-                                   bool b_recycle )
+                                   unsigned picture_align, bool b_recycle )
 {
     vlc_assert_locked( &p_resource->lock );
 
@@ -237,6 +249,7 @@ static vout_thread_t *RequestVout( input_resource_t *p_resource,
             .change_fmt = true,
             .fmt        = p_fmt,
             .dpb_size   = dpb_size,
+            .picture_align = picture_align,
         };
         p_vout = vout_Request( p_resource->p_parent, &cfg );
         if( !p_vout )
@@ -282,6 +295,7 @@ static vout_thread_t *RequestVout( input_resource_t *p_resource,
                 .change_fmt = false,
                 .fmt        = NULL,
                 .dpb_size   = 0,
+                .picture_align = 0,
             };
             p_resource->p_vout_free = vout_Request( p_resource->p_parent, &cfg );
         }
@@ -423,9 +437,11 @@ input_resource_t *input_resource_New( vlc_object_t *p_parent )
         return NULL;
 
     atomic_init( &p_resource->refs, 1 );
+    atomic_init( &p_resource->mirror_gen, 0 );
     p_resource->p_parent = p_parent;
     vlc_mutex_init( &p_resource->lock );
     vlc_mutex_init( &p_resource->lock_hold );
+    vlc_mutex_init( &p_resource->lock_mirror );
     return p_resource;
 }
 
@@ -439,6 +455,12 @@ void input_resource_Release( input_resource_t *p_resource )
     if( p_resource->p_aout != NULL )
         aout_Destroy( p_resource->p_aout );
 
+    for( int i = 0; i < p_resource->i_mirror; i++ )
+        input_resource_Release( p_resource->pp_mirror[i] );
+    TAB_CLEAN( p_resource->i_mirror, p_resource->pp_mirror );
+    assert( p_resource->i_mirror_user == 0 );
+
+    vlc_mutex_destroy( &p_resource->lock_mirror );
     vlc_mutex_destroy( &p_resource->lock_hold );
     vlc_mutex_destroy( &p_resource->lock );
     free( p_resource );
@@ -466,10 +488,11 @@ void input_resource_SetInput( input_resource_t *p_resource, input_thread_t *p_in
 vout_thread_t *input_resource_RequestVout( input_resource_t *p_resource,
                                             vout_thread_t *p_vout,
                                             const video_format_t *p_fmt, unsigned dpb_size,
-                                            bool b_recycle )
+                                            unsigned picture_align, bool b_recycle )
 {
     vlc_mutex_lock( &p_resource->lock );
-    vout_thread_t *p_ret = RequestVout( p_resource, p_vout, p_fmt, dpb_size, b_recycle );
+    vout_thread_t *p_ret = RequestVout( p_resource, p_vout, p_fmt, dpb_size,
+                                        picture_align, b_recycle );
     vlc_mutex_unlock( &p_resource->lock );
 
     return p_ret;
@@ -487,7 +510,7 @@ void input_resource_HoldVouts( input_resource_t *p_resource, vout_thread_t ***pp
 
 void input_resource_TerminateVout( input_resource_t *p_resource )
 {
-    input_resource_RequestVout( p_resource, NULL, NULL, 0, false );
+    input_resource_RequestVout( p_resource, NULL, NULL, 0, 0, false );
 }
 bool input_resource_HasVout( input_resource_t *p_resource )
 {
@@ -499,6 +522,117 @@ bool input_resource_HasVout( input_resource_t *p_resource )
     return b_vout;
 }
 
+/* Mirrors */
+int input_resource_AddMirror( input_resource_t *p_resource,
+                              input_resource_t *p_mirror )
+{
+    if( p_mirror == p_resource )
+        return VLC_EGENERIC;
+
+    vlc_mutex_lock( &p_resource->lock_hold );
+    for( int i = 0; i < p_resource->i_mirror; i++ )
+    {
+        if( p_resource->pp_mirror[i] == p_mirror )
+        {
+            vlc_mutex_unlock( &p_resource->lock_hold );
+            return VLC_EGENERIC;
+        }
+    }
+    TAB_APPEND( p_resource->i_mirror, p_resource->pp_mirror,
+                input_resource_Hold( p_mirror ) );
+    atomic_fetch_add( &p_resource->mirror_gen, 1 );
+    vlc_mutex_unlock( &p_resource->lock_hold );
+
+    msg_Dbg( p_resource->p_parent, "mirroring outputs to %p",
+             (void *)p_mirror->p_parent );
+    return VLC_SUCCESS;
+}
+
+void input_resource_RemoveMirror( input_resource_t *p_resource,
+                                  input_resource_t *p_mirror )
+{
+    bool b_found = false;
+
+    vlc_mutex_lock( &p_resource->lock_mirror );
+    vlc_mutex_lock( &p_resource->lock_hold );
+    for( int i = 0; i < p_resource->i_mirror; i++ )
+    {
+        if( p_resource->pp_mirror[i] == p_mirror )
+        {
+            TAB_ERASE( p_resource->i_mirror, p_resource->pp_mirror, i );
+            atomic_fetch_add( &p_resource->mirror_gen, 1 );
+            b_found = true;
+            break;
+        }
+    }
+    vlc_mutex_unlock( &p_resource->lock_hold );
+
+    /* Close the outputs now, not on the next picture or block: the decoders
+     * may be idle, and the caller may destroy the mirror right after */
+    if( b_found )
+        for( int i = 0; i < p_resource->i_mirror_user; i++ )
+        {
+            input_resource_mirror_user_t *p_user = p_resource->pp_mirror_user[i];
+            p_user->pf_remove( p_user, p_mirror );
+        }
+    vlc_mutex_unlock( &p_resource->lock_mirror );
+
+    if( b_found )
+        input_resource_Release( p_mirror );
+}
+
+void input_resource_AttachMirrorUser( input_resource_t *p_resource,
+                                      input_resource_mirror_user_t *p_user )
+{
+    vlc_mutex_lock( &p_resource->lock_mirror );
+    TAB_APPEND( p_resource->i_mirror_user, p_resource->pp_mirror_user, p_user );
+    vlc_mutex_unlock( &p_resource->lock_mirror );
+}
+
+void input_resource_DetachMirrorUser( input_resource_t *p_resource,
+                                      input_resource_mirror_user_t *p_user )
+{
+    vlc_mutex_lock( &p_resource->lock_mirror );
+    TAB_REMOVE( p_resource->i_mirror_user, p_resource->pp_mirror_user, p_user );
+    vlc_mutex_unlock( &p_resource->lock_mirror );
+}
+
+void input_resource_LockMirrors( input_resource_t *p_resource )
+{
+    vlc_mutex_lock( &p_resource->lock_mirror );
+}
+
+void input_resource_UnlockMirrors( input_resource_t *p_resource )
+{
+    vlc_mutex_unlock( &p_resource->lock_mirror );
+}
+
+unsigned input_resource_GetMirrorsGeneration( input_resource_t *p_resource )
+{
+    return atomic_load( &p_resource->mirror_gen );
+}
+
+void input_resource_HoldMirrors( input_resource_t *p_resource,
+                                 input_resource_t ***ppp_mirror,
+                                 size_t *pi_mirror )
+{
+    *ppp_mirror = NULL;
+    *pi_mirror = 0;
+
+    vlc_mutex_lock( &p_resource->lock_hold );
+    if( p_resource->i_mirror > 0 )
+    {
+        *ppp_mirror = vlc_alloc( p_resource->i_mirror, sizeof(**ppp_mirror) );
+        if( *ppp_mirror != NULL )
+        {
+            *pi_mirror = p_resource->i_mirror;
+            for( int i = 0; i < p_resource->i_mirror; i++ )
+                (*ppp_mirror)[i] = input_resource_Hold( p_resource->pp_mirror[i] );
+        }
+    }
+    vlc_mutex_unlock( &p_resource->lock_hold );
+}
+
 /* */
 sout_instance_t *input_resource_RequestSout( input_resource_t *p_resource, sout_instance_t *p_sout, const char *psz_sout )
 {
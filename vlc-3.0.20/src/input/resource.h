@@ -40,7 +40,8 @@ sout_instance_t *input_resource_RequestSout( input_resource_t *, sout_instance_t
  * This function handles vout request.
  */
 vout_thread_t *input_resource_RequestVout( input_resource_t *, vout_thread_t *,
-                                           const video_format_t *, unsigned dpb_size, bool b_recycle );
+                                           const video_format_t *, unsigned dpb_size,
+                                           unsigned picture_align, bool b_recycle );
 
 /**
  * This function returns one of the current vout if any.
@@ -66,4 +67,39 @@ void input_resource_Terminate( input_resource_t * );
  */
 input_resource_t *input_resource_Hold( input_resource_t * );
 
+/**
+ * Returns a counter that changes whenever the mirrors are changed.
+ */
+unsigned input_resource_GetMirrorsGeneration( input_resource_t * );
+
+/**
+ * Returns the held resources mirroring the outputs of this one.
+ */
+void input_resource_HoldMirrors( input_resource_t *, input_resource_t ***, size_t * );
+
+/**
+ * User of the outputs of the mirror resources, such as a decoder.
+ *
+ * pf_remove is called with the mirrors lock held when a mirror is removed.
+ * It must close the outputs of that mirror and release the reference
+ * obtained from input_resource_HoldMirrors().
+ */
+typedef struct input_resource_mirror_user input_resource_mirror_user_t;
+struct input_resource_mirror_user
+{
+    void (*pf_remove)( input_resource_mirror_user_t *, input_resource_t * );
+};
+
+void input_resource_AttachMirrorUser( input_resource_t *,
+                                      input_resource_mirror_user_t * );
+void input_resource_DetachMirrorUser( input_resource_t *,
+                                      input_resource_mirror_user_t * );
+
+/**
+ * Locks the mirrors: their outputs must only be used with this lock held,
+ * so that input_resource_RemoveMirror() can close them synchronously.
+ */
+void input_resource_LockMirrors( input_resource_t * );
+void input_resource_UnlockMirrors( input_resource_t * );
+
 #endif
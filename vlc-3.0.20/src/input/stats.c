@@ -65,6 +65,44 @@ static inline float stats_GetRate(const counter_t *counter)
         / (float)(counter->pp_samples[0]->date - counter->pp_samples[1]->date);
 }
 
+/* Lower bound of a latency histogram bucket */
+static vlc_tick_t stats_LatencyBound(unsigned bucket)
+{
+    if (bucket == 0)
+        return 0;
+    bucket--;
+    return (vlc_tick_t)(4 + bucket % 4) << (bucket / 4 + 8);
+}
+
+/* Interpolates a percentile of a latency histogram */
+static vlc_tick_t stats_LatencyPercentile(const uint64_t *histogram,
+                                          unsigned percent)
+{
+    uint64_t total = 0, seen = 0;
+
+    for (unsigned i = 0; i < INPUT_STATS_LATENCY_BUCKETS; i++)
+        total += histogram[i];
+    if (total == 0)
+        return 0;
+
+    uint64_t rank = (total * percent + 99) / 100;
+
+    for (unsigned i = 0; i < INPUT_STATS_LATENCY_BUCKETS; i++)
+    {
+        if (seen + histogram[i] >= rank)
+        {
+            vlc_tick_t low = stats_LatencyBound(i);
+
+            if (i == INPUT_STATS_LATENCY_BUCKETS - 1)
+                return low;
+            return low + (stats_LatencyBound(i + 1) - low)
+                         * (vlc_tick_t)(rank - seen) / (vlc_tick_t)histogram[i];
+        }
+        seen += histogram[i];
+    }
+    return stats_LatencyBound(INPUT_STATS_LATENCY_BUCKETS - 1);
+}
+
 input_stats_t *stats_NewInputStats( input_thread_t *p_input )
 {
     (void)p_input;
@@ -112,10 +150,24 @@ void stats_ComputeInputStats(input_thread_t *input, input_stats_t *st)
     /* Aout */
     st->i_played_abuffers = stats_GetTotal(priv->counters.p_played_abuffers);
     st->i_lost_abuffers = stats_GetTotal(priv->counters.p_lost_abuffers);
+    st->i_audio_latency_p50 =
+        stats_LatencyPercentile(priv->counters.audio_latency, 50);
+    st->i_audio_latency_p90 =
+        stats_LatencyPercentile(priv->counters.audio_latency, 90);
+    st->i_audio_latency_p99 =
+        stats_LatencyPercentile(priv->counters.audio_latency, 99);
 
     /* Vouts */
     st->i_displayed_pictures = stats_GetTotal(priv->counters.p_displayed_pictures);
     st->i_lost_pictures = stats_GetTotal(priv->counters.p_lost_pictures);
+    memcpy(st->vout_timings, priv->counters.vout_timings,
+           sizeof(st->vout_timings));
+    st->i_video_latency_p50 =
+        stats_LatencyPercentile(priv->counters.video_latency, 50);
+    st->i_video_latency_p90 =
+        stats_LatencyPercentile(priv->counters.video_latency, 90);
+    st->i_video_latency_p99 =
+        stats_LatencyPercentile(priv->counters.video_latency, 99);
 
     vlc_mutex_unlock(&st->lock);
     vlc_mutex_unlock(&priv->counters.counters_lock);
@@ -134,6 +186,10 @@ void stats_ReinitInputStats( input_stats_t *p_stats )
     p_stats->i_decoded_video = p_stats->i_decoded_audio =
     p_stats->i_sent_bytes = p_stats->i_sent_packets = p_stats->f_send_bitrate
      = 0;
+    p_stats->i_video_latency_p50 = p_stats->i_video_latency_p90 =
+    p_stats->i_video_latency_p99 = p_stats->i_audio_latency_p50 =
+    p_stats->i_audio_latency_p90 = p_stats->i_audio_latency_p99 = 0;
+    memset( p_stats->vout_timings, 0, sizeof( p_stats->vout_timings ) );
     vlc_mutex_unlock( &p_stats->lock );
 }
 
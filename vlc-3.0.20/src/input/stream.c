@@ -358,6 +358,9 @@ error:
     return NULL;
 }
 
+/** Smallest payload that vlc_stream_Block() shares rather than copies */
+#define STREAM_SHARE_MIN 1024
+
 static ssize_t vlc_stream_CopyBlock(block_t **restrict pp,
                                     void *buf, size_t len)
 {
@@ -376,9 +379,10 @@ static ssize_t vlc_stream_CopyBlock(block_t **restrict pp,
     block->i_buffer -= len;
 
     if (block->i_buffer == 0)
-    {
+    {   /* Accesses may return block chains */
+        *pp = block->p_next;
+        block->p_next = NULL;
         block_Release(block);
-        *pp = NULL;
     }
 
     return likely(len > 0) ? (ssize_t)len : -1;
@@ -472,18 +476,44 @@ ssize_t vlc_stream_Read(stream_t *s, void *buf, size_t len)
     return copied;
 }
 
-ssize_t vlc_stream_Peek(stream_t *s, const uint8_t **restrict bufp, size_t len)
+/**
+ * Gets the peek buffer, or makes the next buffered block the peek buffer.
+ *
+ * With block-based accesses, the next block is fetched directly, so that
+ * the peek buffer is the access block itself rather than a copy. The rest
+ * of a block chain stays queued for subsequent reads. Nothing is fetched
+ * if no data is requested (len is zero).
+ */
+static block_t *vlc_stream_PeekBlock(stream_t *s, size_t len)
 {
     stream_priv_t *priv = (stream_priv_t *)s;
-    block_t *peek;
+    block_t *peek = priv->peek;
 
-    peek = priv->peek;
-    if (peek == NULL)
+    if (peek != NULL)
+        return peek;
+
+    if (priv->block == NULL && len > 0 && s->pf_read == NULL
+     && s->pf_block != NULL && !vlc_killed())
     {
-        peek = priv->block;
-        priv->peek = peek;
-        priv->block = NULL;
+        bool eof = false;
+
+        priv->block = s->pf_block(s, &eof);
+    }
+
+    peek = priv->block;
+    if (peek != NULL)
+    {
+        priv->block = peek->p_next;
+        peek->p_next = NULL;
     }
+    priv->peek = peek;
+    return peek;
+}
+
+ssize_t vlc_stream_Peek(stream_t *s, const uint8_t **restrict bufp, size_t len)
+{
+    stream_priv_t *priv = (stream_priv_t *)s;
+    block_t *peek = vlc_stream_PeekBlock(s, len);
 
     if (peek == NULL)
     {
@@ -570,8 +600,8 @@ block_t *vlc_stream_ReadBlock(stream_t *s)
         priv->eof = !ret;
     }
 
-    if (block != NULL)
-        priv->offset += block->i_buffer;
+    for (block_t *b = block; b != NULL; b = b->p_next)
+        priv->offset += b->i_buffer;
 
     return block;
 }
@@ -699,6 +729,41 @@ block_t *vlc_stream_Block( stream_t *s, size_t size )
     if( unlikely(size > SSIZE_MAX) )
         return NULL;
 
+    /* If the data is already buffered in one block, share it rather than
+     * copying it. Small blocks are copied anyway: they would cost an
+     * allocation either way, and would keep the whole access block alive. */
+    block_t *peek = vlc_stream_PeekBlock( s, size );
+    if( peek != NULL && peek->i_buffer >= size && size >= STREAM_SHARE_MIN )
+    {
+        stream_priv_t *priv = (stream_priv_t *)s;
+        block_t *block;
+
+        if( peek->i_buffer == size )
+        {
+            block = peek;
+            priv->peek = NULL;
+        }
+        else
+        {
+            block = block_Share( &priv->peek );
+            if( unlikely(block == NULL) )
+                goto copy;
+            block->i_buffer = size;
+            priv->peek->p_buffer += size;
+            priv->peek->i_buffer -= size;
+        }
+
+        /* Do not leak the access timestamps and flags to the demuxer */
+        block->i_flags = 0;
+        block->i_nb_samples = 0;
+        block->i_pts = block->i_dts = VLC_TS_INVALID;
+        block->i_length = 0;
+
+        priv->offset += size;
+        return block;
+    }
+
+copy:;
     block_t *block = block_Alloc( size );
     if( unlikely(block == NULL) )
         return NULL;
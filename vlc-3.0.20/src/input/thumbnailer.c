@@ -0,0 +1,471 @@
+/*****************************************************************************
+ * thumbnailer.c: headless keyframe thumbnailer
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_thumbnailer.h>
+#include <vlc_arrays.h>
+#include <vlc_codec.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_image.h>
+#include <vlc_input_item.h>
+#include <vlc_modules.h>
+#include <vlc_stream_extractor.h>
+
+#include "../libvlc.h"
+
+/* Number of demux calls to wait for a video track after opening */
+#define THUMBNAILER_PROBE_COUNT 100
+
+struct es_out_id_t
+{
+    bool b_video;
+};
+
+struct vlc_thumbnailer_t
+{
+    struct vlc_common_members obj;
+
+    demux_t         *p_demux;
+    es_out_t        out;
+    vlc_array_t     es_ids;
+
+    /* Video track being decoded */
+    es_out_id_t     *p_video;
+    decoder_t       *p_dec;
+    bool            b_keyframe;
+
+    /* First picture decoded since the last seek */
+    picture_t       *p_pic;
+
+    /* Scaling and chroma conversion are kept apart so that each keeps its
+     * converter across captures */
+    image_handler_t *p_scaler;
+    image_handler_t *p_converter;
+};
+
+/*****************************************************************************
+ * Decoder owner
+ *****************************************************************************/
+static int DecoderUpdateFormat( decoder_t *p_dec )
+{
+    p_dec->fmt_out.video.i_chroma = p_dec->fmt_out.i_codec;
+    return 0;
+}
+
+static picture_t *DecoderNewBuffer( decoder_t *p_dec )
+{
+    return picture_NewFromFormat( &p_dec->fmt_out.video );
+}
+
+static int DecoderQueueVideo( decoder_t *p_dec, picture_t *p_pic )
+{
+    vlc_thumbnailer_t *p_th = p_dec->p_queue_ctx;
+
+    if( p_th->p_pic == NULL )
+        p_th->p_pic = p_pic;
+    else
+        picture_Release( p_pic );
+    return 0;
+}
+
+static decoder_t *DecoderNew( vlc_thumbnailer_t *p_th, const es_format_t *fmt )
+{
+    decoder_t *p_dec = vlc_custom_create( p_th, sizeof( *p_dec ),
+                                          "thumbnailer decoder" );
+    if( unlikely(p_dec == NULL) )
+        return NULL;
+
+    p_dec->p_module = NULL;
+    es_format_Copy( &p_dec->fmt_in, fmt );
+    es_format_Init( &p_dec->fmt_out, VIDEO_ES, 0 );
+    p_dec->b_frame_drop_allowed = false;
+
+    p_dec->pf_vout_format_update = DecoderUpdateFormat;
+    p_dec->pf_vout_buffer_new = DecoderNewBuffer;
+    p_dec->pf_queue_video = DecoderQueueVideo;
+    p_dec->p_queue_ctx = p_th;
+
+    p_dec->p_module = module_need( p_dec, "video decoder", "$codec", false );
+    if( p_dec->p_module == NULL )
+    {
+        es_format_Clean( &p_dec->fmt_in );
+        es_format_Clean( &p_dec->fmt_out );
+        vlc_object_release( p_dec );
+        return NULL;
+    }
+    return p_dec;
+}
+
+static void DecoderDelete( decoder_t *p_dec )
+{
+    module_unneed( p_dec, p_dec->p_module );
+    es_format_Clean( &p_dec->fmt_in );
+    es_format_Clean( &p_dec->fmt_out );
+    if( p_dec->p_description )
+        vlc_meta_Delete( p_dec->p_description );
+    vlc_object_release( p_dec );
+}
+
+/*****************************************************************************
+ * ES output: feeds the first decodable video track to the decoder, and
+ * drops everything else.
+ *****************************************************************************/
+static es_out_id_t *EsOutAdd( es_out_t *out, const es_format_t *fmt )
+{
+    vlc_thumbnailer_t *p_th = (vlc_thumbnailer_t *)out->p_sys;
+    es_out_id_t *id = malloc( sizeof( *id ) );
+    if( unlikely(id == NULL) )
+        return NULL;
+    if( vlc_array_append( &p_th->es_ids, id ) )
+    {
+        free( id );
+        return NULL;
+    }
+
+    id->b_video = false;
+    if( fmt->i_cat == VIDEO_ES && p_th->p_video == NULL )
+    {
+        p_th->p_dec = DecoderNew( p_th, fmt );
+        if( p_th->p_dec != NULL )
+        {
+            msg_Dbg( p_th, "decoding video track with codec `%4.4s'",
+                     (const char *)&fmt->i_codec );
+            id->b_video = true;
+            p_th->p_video = id;
+        }
+    }
+    return id;
+}
+
+static int EsOutSend( es_out_t *out, es_out_id_t *id, block_t *p_block )
+{
+    vlc_thumbnailer_t *p_th = (vlc_thumbnailer_t *)out->p_sys;
+
+    /* Only decode until the first picture after a seek */
+    if( id != p_th->p_video || p_th->p_pic != NULL )
+    {
+        block_Release( p_block );
+        return VLC_SUCCESS;
+    }
+
+    /* Skip leading blocks flagged as non-keyframes */
+    if( !p_th->b_keyframe )
+    {
+        if( p_block->i_flags & (BLOCK_FLAG_TYPE_P|BLOCK_FLAG_TYPE_B) )
+        {
+            block_Release( p_block );
+            return VLC_SUCCESS;
+        }
+        p_th->b_keyframe = true;
+    }
+
+    p_block->i_flags &= ~BLOCK_FLAG_PREROLL;
+    p_th->p_dec->pf_decode( p_th->p_dec, p_block );
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel( es_out_t *out, es_out_id_t *id )
+{
+    vlc_thumbnailer_t *p_th = (vlc_thumbnailer_t *)out->p_sys;
+
+    if( id == p_th->p_video )
+    {
+        DecoderDelete( p_th->p_dec );
+        p_th->p_dec = NULL;
+        p_th->p_video = NULL;
+    }
+    vlc_array_remove( &p_th->es_ids,
+                      vlc_array_index_of_item( &p_th->es_ids, id ) );
+    free( id );
+}
+
+static int EsOutControl( es_out_t *out, int i_query, va_list args )
+{
+    vlc_thumbnailer_t *p_th = (vlc_thumbnailer_t *)out->p_sys;
+
+    switch( i_query )
+    {
+        case ES_OUT_GET_ES_STATE:
+        {
+            es_out_id_t *id = va_arg( args, es_out_id_t * );
+            bool *pb_selected = va_arg( args, bool * );
+            *pb_selected = id == p_th->p_video;
+            return VLC_SUCCESS;
+        }
+        case ES_OUT_GET_EMPTY:
+            *va_arg( args, bool * ) = true;
+            return VLC_SUCCESS;
+        case ES_OUT_SET_ES:
+        case ES_OUT_SET_ES_DEFAULT:
+        case ES_OUT_SET_ES_STATE:
+        case ES_OUT_SET_ES_FMT:
+        case ES_OUT_SET_GROUP:
+        case ES_OUT_SET_PCR:
+        case ES_OUT_SET_GROUP_PCR:
+        case ES_OUT_RESET_PCR:
+        case ES_OUT_SET_NEXT_DISPLAY_TIME:
+        case ES_OUT_SET_GROUP_META:
+        case ES_OUT_SET_GROUP_EPG:
+        case ES_OUT_SET_GROUP_EPG_EVENT:
+        case ES_OUT_SET_EPG_TIME:
+        case ES_OUT_DEL_GROUP:
+        case ES_OUT_SET_ES_SCRAMBLED_STATE:
+        case ES_OUT_SET_META:
+            return VLC_SUCCESS;
+        default:
+            return VLC_EGENERIC;
+    }
+}
+
+static void EsOutDestroy( es_out_t *out )
+{
+    VLC_UNUSED( out );
+}
+
+/*****************************************************************************
+ * Thumbnailer
+ *****************************************************************************/
+#undef vlc_thumbnailer_Create
+vlc_thumbnailer_t *vlc_thumbnailer_Create( vlc_object_t *p_obj,
+                                           input_item_t *p_item )
+{
+    vlc_thumbnailer_t *p_th = vlc_custom_create( p_obj, sizeof( *p_th ),
+                                                 "thumbnailer" );
+    if( unlikely(p_th == NULL) )
+        return NULL;
+
+    p_th->p_video = NULL;
+    p_th->p_dec = NULL;
+    p_th->b_keyframe = false;
+    p_th->p_pic = NULL;
+    vlc_array_init( &p_th->es_ids );
+
+    p_th->out.pf_add = EsOutAdd;
+    p_th->out.pf_send = EsOutSend;
+    p_th->out.pf_del = EsOutDel;
+    p_th->out.pf_control = EsOutControl;
+    p_th->out.pf_destroy = EsOutDestroy;
+    p_th->out.p_sys = (es_out_sys_t *)p_th;
+
+    /* Software decoding of a single picture is cheaper than setting up a
+     * hardware decoder or frame threads, and the fastest scaler is good
+     * enough for thumbnails. */
+    var_Create( p_th, "avcodec-hw", VLC_VAR_STRING );
+    var_SetString( p_th, "avcodec-hw", "none" );
+    var_Create( p_th, "avcodec-threads", VLC_VAR_INTEGER );
+    var_SetInteger( p_th, "avcodec-threads", 1 );
+    var_Create( p_th, "swscale-mode", VLC_VAR_INTEGER );
+    var_SetInteger( p_th, "swscale-mode", 0 );
+
+    p_th->p_scaler = image_HandlerCreate( p_th );
+    p_th->p_converter = image_HandlerCreate( p_th );
+    if( unlikely(p_th->p_scaler == NULL || p_th->p_converter == NULL) )
+        goto error;
+
+    char *psz_uri = input_item_GetURI( p_item );
+    if( psz_uri == NULL )
+        goto error;
+
+    stream_t *s = vlc_stream_NewMRL( p_th, psz_uri );
+    if( s == NULL )
+    {
+        msg_Err( p_th, "cannot open %s", psz_uri );
+        free( psz_uri );
+        goto error;
+    }
+
+    const char *psz_location = strstr( psz_uri, "://" );
+    psz_location = psz_location != NULL ? psz_location + 3 : psz_uri;
+
+    p_th->p_demux = demux_New( VLC_OBJECT(p_th), "any", psz_location, s, &p_th->out );
+    free( psz_uri );
+    if( p_th->p_demux == NULL )
+    {
+        vlc_stream_Delete( s );
+        goto error;
+    }
+
+    /* Some demuxers only declare their tracks while demuxing */
+    for( unsigned i = 0; p_th->p_video == NULL && i < THUMBNAILER_PROBE_COUNT;
+         i++ )
+        if( demux_Demux( p_th->p_demux ) != VLC_DEMUXER_SUCCESS )
+            break;
+
+    if( p_th->p_video == NULL )
+    {
+        msg_Err( p_th, "no decodable video track" );
+        vlc_thumbnailer_Delete( p_th );
+        return NULL;
+    }
+    return p_th;
+
+error:
+    image_HandlerDelete( p_th->p_scaler );
+    image_HandlerDelete( p_th->p_converter );
+    vlc_object_release( p_th );
+    return NULL;
+}
+
+static void Seek( vlc_thumbnailer_t *p_th, mtime_t i_time )
+{
+    demux_t *p_demux = p_th->p_demux;
+
+    /* An imprecise seek lands on the previous keyframe */
+    if( demux_Control( p_demux, DEMUX_SET_TIME, i_time, false ) )
+    {
+        int64_t i_length;
+
+        if( demux_Control( p_demux, DEMUX_GET_LENGTH, &i_length )
+         || i_length <= 0
+         || demux_Control( p_demux, DEMUX_SET_POSITION,
+                           (double)i_time / i_length, false ) )
+            msg_Warn( p_th, "cannot seek to %"PRId64, i_time );
+    }
+}
+
+static picture_t *Convert( vlc_thumbnailer_t *p_th, image_handler_t *p_image,
+                          picture_t *p_pic, const video_format_t *p_fmt_in,
+                          video_format_t *p_fmt_out )
+{
+    picture_t *p_converted = image_Convert( p_image, p_pic, p_fmt_in,
+                                            p_fmt_out );
+    picture_Release( p_pic );
+    if( p_converted == NULL )
+        msg_Err( p_th, "cannot convert picture from `%4.4s' %ux%u "
+                 "to `%4.4s' %ux%u", (const char *)&p_fmt_in->i_chroma,
+                 p_fmt_in->i_visible_width, p_fmt_in->i_visible_height,
+                 (const char *)&p_fmt_out->i_chroma,
+                 p_fmt_out->i_width, p_fmt_out->i_height );
+    return p_converted;
+}
+
+picture_t *vlc_thumbnailer_Capture( vlc_thumbnailer_t *p_th, mtime_t i_time,
+                                    video_format_t *p_fmt )
+{
+    if( p_th->p_pic != NULL )
+    {
+        picture_Release( p_th->p_pic );
+        p_th->p_pic = NULL;
+    }
+
+    Seek( p_th, i_time );
+
+    if( p_th->p_dec != NULL && p_th->p_dec->pf_flush != NULL )
+        p_th->p_dec->pf_flush( p_th->p_dec );
+    p_th->b_keyframe = false;
+
+    while( p_th->p_pic == NULL && p_th->p_dec != NULL )
+    {
+        if( demux_Demux( p_th->p_demux ) != VLC_DEMUXER_SUCCESS )
+        {
+            /* Drain the pictures held back for reordering */
+            p_th->p_dec->pf_decode( p_th->p_dec, NULL );
+            break;
+        }
+    }
+
+    picture_t *p_pic = p_th->p_pic;
+    p_th->p_pic = NULL;
+    if( p_pic == NULL )
+    {
+        msg_Warn( p_th, "no picture decoded at %"PRId64, i_time );
+        return NULL;
+    }
+
+    video_format_t fmt_in = p_th->p_dec->fmt_out.video;
+    if( fmt_in.i_visible_width == 0 || fmt_in.i_visible_height == 0 )
+    {
+        fmt_in.i_visible_width = fmt_in.i_width;
+        fmt_in.i_visible_height = fmt_in.i_height;
+    }
+    if( fmt_in.i_sar_num == 0 || fmt_in.i_sar_den == 0 )
+        fmt_in.i_sar_num = fmt_in.i_sar_den = 1;
+
+    /* Output square pixels, keeping the display aspect ratio */
+    unsigned i_width = p_fmt->i_width;
+    unsigned i_height = p_fmt->i_height;
+    if( i_width == 0 && i_height == 0 )
+    {
+        i_width = (uint64_t)fmt_in.i_visible_width * fmt_in.i_sar_num
+                / fmt_in.i_sar_den;
+        i_height = fmt_in.i_visible_height;
+    }
+    else if( i_width == 0 )
+        i_width = (uint64_t)fmt_in.i_visible_width * fmt_in.i_sar_num
+                * i_height / fmt_in.i_visible_height / fmt_in.i_sar_den;
+    else if( i_height == 0 )
+        i_height = (uint64_t)fmt_in.i_visible_height * fmt_in.i_sar_den
+                 * i_width / fmt_in.i_visible_width / fmt_in.i_sar_num;
+
+    video_format_t fmt_out;
+    video_format_Init( &fmt_out, p_fmt->i_chroma ? p_fmt->i_chroma
+                                                 : fmt_in.i_chroma );
+    fmt_out.i_width = fmt_out.i_visible_width = __MAX(i_width, 1);
+    fmt_out.i_height = fmt_out.i_visible_height = __MAX(i_height, 1);
+    fmt_out.i_sar_num = fmt_out.i_sar_den = 1;
+
+    /* Scale first, so that the chroma conversion runs on the small picture */
+    if( fmt_out.i_width != fmt_in.i_visible_width
+     || fmt_out.i_height != fmt_in.i_visible_height
+     || fmt_in.i_x_offset != 0 || fmt_in.i_y_offset != 0
+     || fmt_in.i_sar_num != fmt_in.i_sar_den )
+    {
+        video_format_t fmt_scaled = fmt_out;
+
+        fmt_scaled.i_chroma = fmt_in.i_chroma;
+        p_pic = Convert( p_th, p_th->p_scaler, p_pic, &fmt_in, &fmt_scaled );
+        if( p_pic == NULL )
+            return NULL;
+        fmt_in = fmt_scaled;
+    }
+
+    if( fmt_out.i_chroma != fmt_in.i_chroma )
+    {
+        p_pic = Convert( p_th, p_th->p_converter, p_pic, &fmt_in, &fmt_out );
+        if( p_pic == NULL )
+            return NULL;
+    }
+    else
+        fmt_out = fmt_in;
+
+    *p_fmt = fmt_out;
+    return p_pic;
+}
+
+void vlc_thumbnailer_Delete( vlc_thumbnailer_t *p_th )
+{
+    if( p_th->p_pic != NULL )
+        picture_Release( p_th->p_pic );
+    /* Not all demuxers delete their tracks when closing */
+    demux_Delete( p_th->p_demux );
+    if( p_th->p_dec != NULL )
+        DecoderDelete( p_th->p_dec );
+    for( size_t i = 0; i < vlc_array_count( &p_th->es_ids ); i++ )
+        free( vlc_array_item_at_index( &p_th->es_ids, i ) );
+    vlc_array_clear( &p_th->es_ids );
+    image_HandlerDelete( p_th->p_scaler );
+    image_HandlerDelete( p_th->p_converter );
+    vlc_object_release( p_th );
+}
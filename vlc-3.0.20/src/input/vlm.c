@@ -163,6 +163,8 @@ vlm_t *vlm_New ( vlc_object_t *p_this )
     p_vlm->i_id = 1;
     TAB_INIT( p_vlm->i_media, p_vlm->media );
     TAB_INIT( p_vlm->i_schedule, p_vlm->schedule );
+    vlc_dictionary_init( &p_vlm->media_by_name, 0 );
+    vlc_dictionary_init( &p_vlm->schedule_by_name, 0 );
     p_vlm->p_vod = NULL;
     p_vlm->i_consecutive_errors = 0;
     var_Create( p_vlm, "intf-event", VLC_VAR_ADDRESS );
@@ -174,6 +176,8 @@ vlm_t *vlm_New ( vlc_object_t *p_this )
         vlc_mutex_destroy( &p_vlm->lock );
         vlc_mutex_destroy( &p_vlm->lock_manage );
         vlc_mutex_destroy( &p_vlm->lock_delete );
+        vlc_dictionary_clear( &p_vlm->media_by_name, NULL, NULL );
+        vlc_dictionary_clear( &p_vlm->schedule_by_name, NULL, NULL );
         vlc_object_release( p_vlm );
         vlc_mutex_unlock( &vlm_mutex );
         return NULL;
@@ -235,6 +239,8 @@ void vlm_Delete( vlm_t *p_vlm )
 
     vlm_ControlInternal( p_vlm, VLM_CLEAR_SCHEDULES );
     TAB_CLEAN( p_vlm->i_schedule, p_vlm->schedule );
+    vlc_dictionary_clear( &p_vlm->media_by_name, NULL, NULL );
+    vlc_dictionary_clear( &p_vlm->schedule_by_name, NULL, NULL );
     vlc_mutex_unlock( &p_vlm->lock );
 
     vlc_cancel( p_vlm->thread );
@@ -476,14 +482,14 @@ static void* Manage( void* p_object )
                 }
                 else if( vlm->schedule[i]->period != 0 )
                 {
-                    int j = 0;
-                    while( ((vlm->schedule[i]->date + j *
-                             vlm->schedule[i]->period) <= lastcheck) &&
-                           ( vlm->schedule[i]->i_repeat > j ||
-                             vlm->schedule[i]->i_repeat < 0 ) )
-                    {
-                        j++;
-                    }
+                    /* First repetition after the last check */
+                    time_t j = 0;
+                    if( vlm->schedule[i]->date <= lastcheck )
+                        j = ( lastcheck - vlm->schedule[i]->date ) /
+                            vlm->schedule[i]->period + 1;
+                    if( vlm->schedule[i]->i_repeat >= 0 &&
+                        j > vlm->schedule[i]->i_repeat )
+                        j = vlm->schedule[i]->i_repeat;
 
                     real_date = vlm->schedule[i]->date + j *
                         vlm->schedule[i]->period;
@@ -553,21 +559,25 @@ typedef struct
 /* */
 static vlm_media_sys_t *vlm_ControlMediaGetById( vlm_t *p_vlm, int64_t id )
 {
-    for( int i = 0; i < p_vlm->i_media; i++ )
+    /* The media list is sorted by id */
+    int i_low = 0, i_high = p_vlm->i_media - 1;
+    while( i_low <= i_high )
     {
-        if( p_vlm->media[i]->cfg.id == id )
+        const int i = i_low + ( i_high - i_low ) / 2;
+        const int64_t i_id = p_vlm->media[i]->cfg.id;
+
+        if( i_id == id )
             return p_vlm->media[i];
+        if( i_id < id )
+            i_low = i + 1;
+        else
+            i_high = i - 1;
     }
     return NULL;
 }
 static vlm_media_sys_t *vlm_ControlMediaGetByName( vlm_t *p_vlm, const char *psz_name )
 {
-    for( int i = 0; i < p_vlm->i_media; i++ )
-    {
-        if( !strcmp( p_vlm->media[i]->cfg.psz_name, psz_name ) )
-            return p_vlm->media[i];
-    }
-    return NULL;
+    return vlc_dictionary_value_for_key( &p_vlm->media_by_name, psz_name );
 }
 static int vlm_MediaDescriptionCheck( vlm_t *p_vlm, vlm_media_t *p_cfg )
 {
@@ -731,13 +741,19 @@ static int vlm_ControlMediaChange( vlm_t *p_vlm, vlm_media_t *p_cfg )
     if( ( p_media->cfg.b_vod && !p_cfg->b_vod ) || ( !p_media->cfg.b_vod && p_cfg->b_vod ) )
         return VLC_EGENERIC;
 
+    if( strcmp( p_media->cfg.psz_name, p_cfg->psz_name ) &&
+        vlm_ControlMediaGetByName( p_vlm, p_cfg->psz_name ) )
+        return VLC_EGENERIC;
     if( 0 )
     {
         /* TODO check what are the changes being done (stop instance if needed) */
     }
 
+    vlc_dictionary_remove_value_for_key( &p_vlm->media_by_name,
+                                         p_media->cfg.psz_name, NULL, NULL );
     vlm_media_Clean( &p_media->cfg );
     vlm_media_Copy( &p_media->cfg, p_cfg );
+    vlc_dictionary_insert( &p_vlm->media_by_name, p_media->cfg.psz_name, p_media );
 
     return vlm_OnMediaUpdate( p_vlm, p_media );
 }
@@ -786,6 +802,7 @@ static int vlm_ControlMediaAdd( vlm_t *p_vlm, vlm_media_t *p_cfg, int64_t *p_id
 
     /* */
     TAB_APPEND( p_vlm->i_media, p_vlm->media, p_media );
+    vlc_dictionary_insert( &p_vlm->media_by_name, p_media->cfg.psz_name, p_media );
 
     if( p_id )
         *p_id = p_media->cfg.id;
@@ -814,6 +831,8 @@ static int vlm_ControlMediaDel( vlm_t *p_vlm, int64_t id )
     /* */
     vlm_SendEventMediaRemoved( p_vlm, id, p_media->cfg.psz_name );
 
+    vlc_dictionary_remove_value_for_key( &p_vlm->media_by_name,
+                                         p_media->cfg.psz_name, NULL, NULL );
     vlm_media_Clean( &p_media->cfg );
 
     input_item_Release( p_media->vod.p_item );
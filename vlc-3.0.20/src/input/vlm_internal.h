@@ -25,6 +25,7 @@
 #define LIBVLC_VLM_INTERNAL_H 1
 
 #include <vlc_vlm.h>
+#include <vlc_arrays.h>
 #include "input_interface.h"
 
 /* Private */
@@ -104,13 +105,15 @@ struct vlm_t
     /* Vod server (used by media) */
     vod_t          *p_vod;
 
-    /* Media list */
+    /* Media list, sorted by id (ids are allocated in increasing order) */
     int                i_media;
     vlm_media_sys_t    **media;
+    vlc_dictionary_t   media_by_name;
 
     /* Schedule list */
     int            i_schedule;
     vlm_schedule_sys_t **schedule;
+    vlc_dictionary_t   schedule_by_name;
 
     unsigned i_consecutive_errors;
 };
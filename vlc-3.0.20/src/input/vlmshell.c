@@ -957,15 +957,7 @@ error:
  *****************************************************************************/
 vlm_media_sys_t *vlm_MediaSearch( vlm_t *vlm, const char *psz_name )
 {
-    int i;
-
-    for( i = 0; i < vlm->i_media; i++ )
-    {
-        if( strcmp( psz_name, vlm->media[i]->cfg.psz_name ) == 0 )
-            return vlm->media[i];
-    }
-
-    return NULL;
+    return vlc_dictionary_value_for_key( &vlm->media_by_name, psz_name );
 }
 
 /*****************************************************************************
@@ -989,6 +981,7 @@ static vlm_schedule_sys_t *vlm_ScheduleNew( vlm_t *vlm, const char *psz_name )
     p_sched->i_repeat = -1;
 
     TAB_APPEND( vlm->i_schedule, vlm->schedule, p_sched );
+    vlc_dictionary_insert( &vlm->schedule_by_name, p_sched->psz_name, p_sched );
 
     return p_sched;
 }
@@ -1000,6 +993,8 @@ void vlm_ScheduleDelete( vlm_t *vlm, vlm_schedule_sys_t *sched )
     if( sched == NULL ) return;
 
     TAB_REMOVE( vlm->i_schedule, vlm->schedule, sched );
+    vlc_dictionary_remove_value_for_key( &vlm->schedule_by_name,
+                                         sched->psz_name, NULL, NULL );
 
     if( vlm->i_schedule == 0 ) free( vlm->schedule );
     free( sched->psz_name );
@@ -1012,17 +1007,7 @@ void vlm_ScheduleDelete( vlm_t *vlm, vlm_schedule_sys_t *sched )
 
 static vlm_schedule_sys_t *vlm_ScheduleSearch( vlm_t *vlm, const char *psz_name )
 {
-    int i;
-
-    for( i = 0; i < vlm->i_schedule; i++ )
-    {
-        if( strcmp( psz_name, vlm->schedule[i]->psz_name ) == 0 )
-        {
-            return vlm->schedule[i];
-        }
-    }
-
-    return NULL;
+    return vlc_dictionary_value_for_key( &vlm->schedule_by_name, psz_name );
 }
 
 /* Ok, setup schedule command will be able to support only one (argument value) at a time  */
@@ -87,6 +87,12 @@ static const char *const ppsz_snap_formats[] =
     "This is the verbosity level (0=only errors and " \
     "standard messages, 1=warnings, 2=debug).")
 
+#define LOG_ASYNC_TEXT N_("Asynchronous logging")
+#define LOG_ASYNC_LONGTEXT N_( \
+    "Output log messages from a dedicated thread, so that slow logging " \
+    "does not delay the emitting threads. Messages are dropped if they " \
+    "are emitted faster than they can be output.")
+
 #define OPEN_TEXT N_("Default stream")
 #define OPEN_LONGTEXT N_( \
     "This stream will always be opened at VLC startup." )
@@ -163,6 +169,13 @@ static const char *ppsz_roles_text[] = {
     "This delays the audio output. The delay must be given in milliseconds. " \
     "This can be handy if you notice a lag between the video and the audio.")
 
+#define AUDIO_LATENCY_TEXT N_("Low latency audio output")
+#define AUDIO_LATENCY_LONGTEXT N_( \
+    "Target audio output latency, in milliseconds, for live monitoring. " \
+    "The audio buffering and the synchronization tolerances are then " \
+    "adapted to the measured output jitter. " \
+    "0 keeps the default buffering.")
+
 #define AUDIO_RESAMPLER_TEXT N_("Audio resampler")
 #define AUDIO_RESAMPLER_LONGTEXT N_( \
     "This selects which plugin to use for audio resampling." )
@@ -514,6 +527,13 @@ static const char *const ppsz_pos_descriptions[] =
 #define NETWORK_CACHING_LONGTEXT N_( \
     "Caching value for network resources, in milliseconds." )
 
+#define ZAP_CACHING_TEXT N_("Fast start caching (ms)")
+#define ZAP_CACHING_LONGTEXT N_( \
+    "Caching value used when starting real-time network streams, in " \
+    "milliseconds. Playback then catches up with the network caching by " \
+    "slightly slowing down, which speeds up channel changes. " \
+    "0 disables fast start." )
+
 #define CR_AVERAGE_TEXT N_("Clock reference average counter")
 #define CR_AVERAGE_LONGTEXT N_( \
     "When using the PVR input (or a very irregular source), you should " \
@@ -530,6 +550,29 @@ static const char *const ppsz_pos_descriptions[] =
     "This defines the maximum input delay jitter that the synchronization " \
     "algorithms should try to compensate (in milliseconds)." )
 
+#define FREE_RUN_TEXT N_("Process as fast as possible")
+#define FREE_RUN_LONGTEXT N_( \
+    "This disables the clock pacing of inputs that support it: they are " \
+    "demultiplexed as fast as the decoders can consume, and audio and " \
+    "video are output without waiting for their display dates. This is " \
+    "meant for offline processing, not for playback." )
+
+#define CLOCK_RECOVERY_TEXT N_("Clock recovery")
+#define CLOCK_RECOVERY_LONGTEXT N_( \
+    "This selects how the clock drift of real-time sources is followed. " \
+    "The Kalman filter ignores bursts of network delay and converges " \
+    "faster, which allows for smaller network caching values." )
+
+static const char *const ppsz_clock_recovery_values[] =
+    { "average", "kalman" };
+static const char *const ppsz_clock_recovery_descriptions[] =
+    { N_("Moving average"), N_("Kalman filter") };
+
+#define ADAPTIVE_CACHING_TEXT N_("Adaptive caching")
+#define ADAPTIVE_CACHING_LONGTEXT N_( \
+    "This adapts the caching of real-time sources to the measured network " \
+    "jitter, by slightly slowing down or speeding up playback." )
+
 #define NETSYNC_TEXT N_("Network synchronisation" )
 #define NETSYNC_LONGTEXT N_( "This allows you to remotely " \
         "synchronise clocks for server and client. The detailed settings " \
@@ -647,6 +690,11 @@ static const char *const ppsz_prefres[] = {
 #define INPUT_FAST_SEEK_LONGTEXT N_( \
     "Favor speed over precision while seeking" )
 
+#define DEMUX_CACHE_TEXT N_("Cache demuxer state")
+#define DEMUX_CACHE_LONGTEXT N_( \
+    "Remember which demuxer opened a local file, and let demuxers keep " \
+    "state such as seek indexes, so that the file opens faster next time." )
+
 #define INPUT_RATE_TEXT N_("Playback speed")
 #define INPUT_RATE_LONGTEXT N_( \
     "This defines the playback speed (nominal speed is 1.0)." )
@@ -672,6 +720,12 @@ static const char *const ppsz_prefres[] = {
 #define INPUT_RECORD_PATH_LONGTEXT N_( \
     "Directory where the records will be stored" )
 
+#define INPUT_RECORD_PREROLL_TEXT N_("Record pre-roll (seconds)")
+#define INPUT_RECORD_PREROLL_LONGTEXT N_( \
+    "Keep this many seconds of the played tracks in memory, so that " \
+    "recordings made by the stream output start with the data preceding " \
+    "the record request, from a key frame. 0 disables the pre-roll." )
+
 #define INPUT_RECORD_NATIVE_TEXT N_("Prefer native stream recording")
 #define INPUT_RECORD_NATIVE_LONGTEXT N_( \
     "When possible, the input stream will be recorded instead of using " \
@@ -686,6 +740,13 @@ static const char *const ppsz_prefres[] = {
     "This is the maximum size in bytes of the temporary files " \
     "that will be used to store the timeshifted streams." )
 
+#define INPUT_TIMESHIFT_SIZE_TEXT N_("Timeshift size")
+#define INPUT_TIMESHIFT_SIZE_LONGTEXT N_( \
+    "This is the maximum size in bytes of all the temporary files. " \
+    "Once reached, the oldest played part of the stream is overwritten, " \
+    "or the new part is dropped if none was played yet " \
+    "(-1 for 1 GiB)." )
+
 #define INPUT_TITLE_FORMAT_TEXT N_( "Change title according to current media" )
 #define INPUT_TITLE_FORMAT_LONGTEXT N_( "This option allows you to set the title according to what's being played<br>"  \
     "$a: Artist<br>$b: Album<br>$c: Copyright<br>$t: Title<br>$g: Genre<br>"  \
@@ -912,6 +973,40 @@ static const char *const ppsz_prefres[] = {
     "before trying the other ones. Only advanced users should " \
     "alter this option as it can break playback of all your streams." )
 
+#define MEMORY_BUDGET_TEXT N_("Memory budget of the input buffers (MiB)")
+#define MEMORY_BUDGET_LONGTEXT N_( \
+    "This caps the memory held by the decoder queues and the read-ahead " \
+    "caches of all inputs. When it is reached, read-ahead caches stop " \
+    "growing first, then the input waits for the decoders, or drops data " \
+    "if it cannot wait. 0 means no limit.")
+
+#define THREAD_AFFINITY_TEXT N_("Input threads placement")
+#define THREAD_AFFINITY_LONGTEXT N_( \
+    "Pins each input, with the demuxer, decoder, filter, encoder and output " \
+    "threads it starts, to one group of CPUs: a NUMA node, or a few cores " \
+    "of a node. New inputs go to the least loaded group. This keeps the " \
+    "caches of a pipeline warm when many inputs run at once.")
+static const char *const ppsz_thread_affinity[] = { "none", "node", "cores" };
+static const char *const ppsz_thread_affinity_text[] = {
+    N_("None"), N_("NUMA node"), N_("Cores") };
+
+#define THREAD_AFFINITY_CORES_TEXT N_("CPUs per input group")
+#define THREAD_AFFINITY_CORES_LONGTEXT N_( \
+    "Number of CPUs of each group with the \"cores\" placement. " \
+    "0 means one group per NUMA node.")
+
+#define DECODER_FIFO_DURATION_TEXT N_("Decoder queue duration (ms)")
+#define DECODER_FIFO_DURATION_LONGTEXT N_( \
+    "When the input is not paced by the decoders, the input waits while " \
+    "more than this duration of data is queued for a decoder. " \
+    "0 means no limit.")
+
+#define DECODER_EXECUTOR_TEXT N_("Share threads between light decoders")
+#define DECODER_EXECUTOR_LONGTEXT N_( \
+    "Run the audio and subtitles decoders on a shared pool of threads, " \
+    "instead of one thread per decoder. This saves threads and memory " \
+    "when many inputs are played at once.")
+
 #define ENCODER_TEXT N_("Preferred encoders list")
 #define ENCODER_LONGTEXT N_( \
     "This allows you to select a list of encoders that VLC will use in " \
@@ -1055,6 +1150,17 @@ static const char *const ppsz_prefres[] = {
     "Scan plugin directories for new plugins at startup. " \
     "This increases the startup time of VLC.")
 
+#define PLUGINS_LAZY_TEXT N_("Load plugins only when needed")
+#define PLUGINS_LAZY_LONGTEXT N_( \
+    "Only describe plugins from the plugins cache, so that no plugin is " \
+    "loaded until one of its modules is actually used. Plugins missing " \
+    "from the cache, or changed since it was generated, are ignored.")
+
+#define TRACE_FILE_TEXT N_("Trace events file")
+#define TRACE_FILE_LONGTEXT N_( \
+    "Record the timing of the playback threads, and write it to this " \
+    "file (in the Chrome trace event format) when VLC exits.")
+
 #define KEYSTORE_TEXT N_("Preferred keystore list")
 #define KEYSTORE_LONGTEXT N_( \
     "List of keystores that VLC will use in priority." )
@@ -1123,6 +1229,11 @@ static const char *const ppsz_prefres[] = {
 #define PREPARSE_TIMEOUT_LONGTEXT N_( \
     "Maximum time allowed to preparse an item, in milliseconds" )
 
+#define PREPARSE_THREADS_TEXT N_( "Preparsing threads" )
+#define PREPARSE_THREADS_LONGTEXT N_( \
+    "Maximum number of items preparsed in parallel " \
+    "(0 for the number of CPU cores)." )
+
 #define METADATA_NETWORK_TEXT N_( "Allow metadata network access" )
 
 static const char *const psz_recursive_list[] = {
@@ -1177,6 +1288,12 @@ static const char *const psz_recursive_list_text[] = {
 #define PAP_LONGTEXT N_( \
     "Pause each item in the playlist on the last frame." )
 
+#define PREROLL_TEXT N_("Preroll time (ms)")
+#define PREROLL_LONGTEXT N_( \
+    "Open the next playlist item this long before the end of the current " \
+    "one, in milliseconds, to reduce the gap between items. " \
+    "0 disables prerolling." )
+
 #define SP_TEXT N_("Start paused")
 #define SP_LONGTEXT N_( \
     "Pause each item in the playlist on the first frame." )
@@ -1511,6 +1628,9 @@ vlc_module_begin ()
     add_integer( "audio-desync", 0, DESYNC_TEXT,
                  DESYNC_LONGTEXT, true )
         change_safe ()
+    add_integer( "audio-latency", 0, AUDIO_LATENCY_TEXT,
+                 AUDIO_LATENCY_LONGTEXT, true )
+        change_integer_range( 0, 1000 )
 
     /* FIXME TODO create a subcat replay gain ? */
     add_string( "audio-replay-gain-mode", ppsz_replay_gain_mode[0], AUDIO_REPLAY_GAIN_MODE_TEXT,
@@ -1767,6 +1887,8 @@ vlc_module_begin ()
     add_bool( "input-fast-seek", false,
               INPUT_FAST_SEEK_TEXT, INPUT_FAST_SEEK_LONGTEXT, false )
         change_safe ()
+    add_bool( "demux-cache", true,
+              DEMUX_CACHE_TEXT, DEMUX_CACHE_LONGTEXT, true )
     add_float( "rate", 1.,
                INPUT_RATE_TEXT, INPUT_RATE_LONGTEXT, false )
 
@@ -1895,6 +2017,10 @@ vlc_module_begin ()
                  NETWORK_CACHING_TEXT, NETWORK_CACHING_LONGTEXT, true )
         change_integer_range( 0, 60000 )
         change_safe()
+    add_integer( "zap-caching", 0,
+                 ZAP_CACHING_TEXT, ZAP_CACHING_LONGTEXT, true )
+        change_integer_range( 0, 60000 )
+        change_safe()
     add_obsolete_integer( "ftp-caching" ) /* 2.0.0 */
     add_obsolete_integer( "http-caching" ) /* 2.0.0 */
     add_obsolete_integer( "mms-caching" ) /* 2.0.0 */
@@ -1914,12 +2040,24 @@ vlc_module_begin ()
     add_integer( "clock-jitter", 5 * CLOCK_FREQ/1000, CLOCK_JITTER_TEXT,
               CLOCK_JITTER_LONGTEXT, true )
         change_safe()
+    add_string( "clock-recovery", "average", CLOCK_RECOVERY_TEXT,
+                CLOCK_RECOVERY_LONGTEXT, true )
+        change_string_list( ppsz_clock_recovery_values,
+                            ppsz_clock_recovery_descriptions )
+        change_safe()
+    add_bool( "adaptive-caching", false, ADAPTIVE_CACHING_TEXT,
+              ADAPTIVE_CACHING_LONGTEXT, true )
+        change_safe()
+    add_bool( "free-run", false, FREE_RUN_TEXT, FREE_RUN_LONGTEXT, true )
 
     add_bool( "network-synchronisation", false, NETSYNC_TEXT,
               NETSYNC_LONGTEXT, true )
 
     add_directory( "input-record-path", NULL, INPUT_RECORD_PATH_TEXT,
                 INPUT_RECORD_PATH_LONGTEXT, true )
+    add_integer( "input-record-preroll", 0, INPUT_RECORD_PREROLL_TEXT,
+                 INPUT_RECORD_PREROLL_LONGTEXT, true )
+        change_integer_range( 0, 600 )
     add_bool( "input-record-native", true, INPUT_RECORD_NATIVE_TEXT,
               INPUT_RECORD_NATIVE_LONGTEXT, true )
 
@@ -1927,6 +2065,8 @@ vlc_module_begin ()
                 INPUT_TIMESHIFT_PATH_LONGTEXT, true )
     add_integer( "input-timeshift-granularity", -1, INPUT_TIMESHIFT_GRANULARITY_TEXT,
                  INPUT_TIMESHIFT_GRANULARITY_LONGTEXT, true )
+    add_integer( "input-timeshift-size", -1, INPUT_TIMESHIFT_SIZE_TEXT,
+                 INPUT_TIMESHIFT_SIZE_LONGTEXT, true )
 
     add_string( "input-title-format", "$Z", INPUT_TITLE_FORMAT_TEXT, INPUT_TITLE_FORMAT_LONGTEXT, false );
 
@@ -1939,6 +2079,20 @@ vlc_module_begin ()
                 CODEC_LONGTEXT, true )
     add_string( "encoder",  NULL, ENCODER_TEXT,
                 ENCODER_LONGTEXT, true )
+    add_bool( "decoder-executor", false, DECODER_EXECUTOR_TEXT,
+              DECODER_EXECUTOR_LONGTEXT, true )
+    add_integer( "decoder-fifo-duration", 20000, DECODER_FIFO_DURATION_TEXT,
+                 DECODER_FIFO_DURATION_LONGTEXT, true )
+        change_integer_range( 0, 600000 )
+    add_integer( "memory-budget", 0, MEMORY_BUDGET_TEXT,
+                 MEMORY_BUDGET_LONGTEXT, true )
+        change_integer_range( 0, 1 << 20 )
+    add_string( "thread-affinity", "none", THREAD_AFFINITY_TEXT,
+                THREAD_AFFINITY_LONGTEXT, true )
+        change_string_list( ppsz_thread_affinity, ppsz_thread_affinity_text )
+    add_integer( "thread-affinity-cores", 4, THREAD_AFFINITY_CORES_TEXT,
+                 THREAD_AFFINITY_CORES_LONGTEXT, true )
+        change_integer_range( 0, 1024 )
 
     set_subcategory( SUBCAT_INPUT_ACCESS )
     add_category_hint( N_("Input"), INPUT_CAT_LONGTEXT , false )
@@ -2034,6 +2188,13 @@ vlc_module_begin ()
               PLUGINS_CACHE_LONGTEXT, true )
     add_bool( "plugins-scan", true, PLUGINS_SCAN_TEXT,
               PLUGINS_SCAN_LONGTEXT, true )
+    add_bool( "plugins-lazy", false, PLUGINS_LAZY_TEXT,
+              PLUGINS_LAZY_LONGTEXT, true )
+#ifdef ENABLE_TRACE
+    add_savefile( "trace-file", NULL, TRACE_FILE_TEXT,
+                  TRACE_FILE_LONGTEXT, true )
+        change_volatile ()
+#endif
     add_obsolete_string( "plugin-path" ) /* since 2.0.0 */
 #endif
     add_obsolete_string( "data-path" ) /* since 2.1.0 */
@@ -2082,6 +2243,9 @@ vlc_module_begin ()
         change_safe()
     add_bool( "play-and-pause", 0, PAP_TEXT, PAP_LONGTEXT, true )
         change_safe()
+    add_integer( "playlist-preroll", 0, PREROLL_TEXT, PREROLL_LONGTEXT, true )
+        change_integer_range( 0, 60000 )
+        change_safe()
     add_bool( "start-paused", 0, SP_TEXT, SP_LONGTEXT, false )
     add_bool( "playlist-autostart", true,
               AUTOSTART_TEXT, AUTOSTART_LONGTEXT, false )
@@ -2111,6 +2275,9 @@ vlc_module_begin ()
 
     add_integer( "preparse-timeout", 5000, PREPARSE_TIMEOUT_TEXT,
                  PREPARSE_TIMEOUT_LONGTEXT, false )
+    add_integer( "preparse-threads", 0, PREPARSE_THREADS_TEXT,
+                 PREPARSE_THREADS_LONGTEXT, true )
+        change_integer_range( 0, 64 )
 
     add_obsolete_integer( "album-art" )
     add_bool( "metadata-network-access", false, METADATA_NETWORK_TEXT,
@@ -2140,6 +2307,7 @@ vlc_module_begin ()
                  false )
         change_short('v')
         change_volatile ()
+    add_bool( "log-async", false, LOG_ASYNC_TEXT, LOG_ASYNC_LONGTEXT, true )
     add_obsolete_string( "verbose-objects" ) /* since 2.1.0 */
 #if !defined(_WIN32) && !defined(__OS2__)
     add_bool( "daemon", 0, DAEMON_TEXT, DAEMON_LONGTEXT, true )
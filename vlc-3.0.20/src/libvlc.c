@@ -66,6 +66,7 @@
 #include "libvlc.h"
 #include "playlist/playlist_internal.h"
 #include "misc/variables.h"
+#include "misc/executor.h"
 
 #include <vlc_vlm.h>
 
@@ -93,6 +94,9 @@ libvlc_int_t * libvlc_InternalCreate( void )
     priv = libvlc_priv (p_libvlc);
     priv->playlist = NULL;
     priv->p_vlm = NULL;
+    priv->p_decoder_executor = NULL;
+    priv->memory_budget = NULL;
+    priv->affinity = NULL;
 
     vlc_ExitInit( &priv->exit );
 
@@ -162,6 +166,7 @@ int libvlc_InternalInit( libvlc_int_t *p_libvlc, int i_argc,
         goto error;
 
     vlc_LogInit(p_libvlc);
+    vlc_trace_Init(p_libvlc);
 
     /*
      * Support for gettext
@@ -231,6 +236,31 @@ int libvlc_InternalInit( libvlc_int_t *p_libvlc, int i_argc,
 
     priv->b_stats = var_InheritBool( p_libvlc, "stats" );
 
+    if( var_InheritBool( p_libvlc, "decoder-executor" ) )
+    {
+        priv->p_decoder_executor =
+            vlc_executor_New( VLC_THREAD_PRIORITY_AUDIO );
+        if( priv->p_decoder_executor == NULL )
+            goto error;
+    }
+
+    int64_t budget = var_InheritInteger( p_libvlc, "memory-budget" );
+    if( budget > 0 )
+    {
+        priv->memory_budget = vlc_memory_BudgetNew( (size_t)budget << 20 );
+        if( priv->memory_budget == NULL )
+            goto error;
+        msg_Dbg( p_libvlc, "input buffers limited to %"PRId64" MiB", budget );
+    }
+
+    char *affinity = var_InheritString( p_libvlc, "thread-affinity" );
+    if( affinity != NULL )
+    {
+        priv->affinity = vlc_affinity_New( VLC_OBJECT(p_libvlc), affinity,
+                        var_InheritInteger( p_libvlc, "thread-affinity-cores" ) );
+        free( affinity );
+    }
+
     /*
      * Initialize hotkey handling
      */
@@ -416,12 +446,23 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
     if (priv->parser != NULL)
         playlist_preparser_Delete(priv->parser);
 
+    if( priv->p_decoder_executor != NULL )
+        vlc_executor_Delete( priv->p_decoder_executor );
+
+    if( priv->memory_budget != NULL )
+        vlc_memory_BudgetDelete( priv->memory_budget );
+
+    if( priv->affinity != NULL )
+        vlc_affinity_Delete( priv->affinity );
+
     libvlc_InternalActionsClean( p_libvlc );
 
     /* Save the configuration */
     if( !var_InheritBool( p_libvlc, "ignore-config" ) )
         config_AutoSaveConfigFile( VLC_OBJECT(p_libvlc) );
 
+    vlc_trace_Deinit (p_libvlc);
+
     /* Free module bank. It is refcounted, so we call this each time  */
     vlc_LogDeinit (p_libvlc);
     module_EndBank (true);
@@ -495,12 +536,11 @@ int vlc_MetadataRequest(libvlc_int_t *libvlc, input_item_t *item,
     if (unlikely(priv->parser == NULL))
         return VLC_ENOMEM;
 
+    vlc_mutex_lock( &item->lock );
     if( i_options & META_REQUEST_OPTION_DO_INTERACT )
-    {
-        vlc_mutex_lock( &item->lock );
         item->b_preparse_interact = true;
-        vlc_mutex_unlock( &item->lock );
-    }
+    item->b_preparse_lite = i_options & META_REQUEST_OPTION_PARSE_LITE;
+    vlc_mutex_unlock( &item->lock );
     playlist_preparser_Push( priv->parser, item, i_options, timeout, id );
     return VLC_SUCCESS;
 
@@ -525,6 +565,7 @@ int libvlc_MetadataRequest(libvlc_int_t *libvlc, input_item_t *item,
         item->i_preparse_depth = 1;
     if( i_options & META_REQUEST_OPTION_DO_INTERACT )
         item->b_preparse_interact = true;
+    item->b_preparse_lite = i_options & META_REQUEST_OPTION_PARSE_LITE;
     vlc_mutex_unlock( &item->lock );
     playlist_preparser_Push( priv->parser, item, i_options, timeout, id );
     return VLC_SUCCESS;
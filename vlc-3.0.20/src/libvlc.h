@@ -74,6 +74,12 @@ int vlc_LogPreinit(libvlc_int_t *);
 int vlc_LogInit(libvlc_int_t *);
 void vlc_LogDeinit(libvlc_int_t *);
 
+/*
+ * Trace events
+ */
+void vlc_trace_Init(libvlc_int_t *);
+void vlc_trace_Deinit(libvlc_int_t *);
+
 /*
  * LibVLC exit event handling
  */
@@ -191,6 +197,9 @@ typedef struct libvlc_priv_t
     struct playlist_t *playlist; ///< Playlist for interfaces
     struct playlist_preparser_t *parser; ///< Input item meta data handler
     vlc_actions_t *actions; ///< Hotkeys handler
+    struct vlc_executor *p_decoder_executor; ///< shared decoder threads
+    struct vlc_memory_budget *memory_budget; ///< input buffers cap (or NULL)
+    struct vlc_affinity *affinity; ///< input threads placement (or NULL)
 
     /* Exit callback */
     vlc_exit_t       exit;
@@ -201,6 +210,38 @@ static inline libvlc_priv_t *libvlc_priv (libvlc_int_t *libvlc)
     return container_of(libvlc, libvlc_priv_t, public_data);
 }
 
+struct vlc_memory_budget *vlc_memory_BudgetNew(size_t limit);
+void vlc_memory_BudgetDelete(struct vlc_memory_budget *);
+
+/**
+ * Creates a CPU placement policy for the input threads.
+ *
+ * \param policy "node" for one group per NUMA node, "cores" for groups of
+ *               \p cores CPUs within a node
+ * \return the policy, or NULL if none applies or on error
+ */
+struct vlc_affinity *vlc_affinity_New(vlc_object_t *, const char *policy,
+                                      unsigned cores);
+void vlc_affinity_Delete(struct vlc_affinity *);
+
+/**
+ * Pins the calling thread to the least loaded CPU group. The threads it
+ * creates afterwards inherit the placement.
+ *
+ * \return the group, to be left with vlc_affinity_Leave(), or NULL on error
+ */
+struct vlc_affinity_group *vlc_affinity_Place(struct vlc_affinity *,
+                                              vlc_object_t *);
+void vlc_affinity_Leave(struct vlc_affinity *, struct vlc_affinity_group *);
+const char *vlc_affinity_GroupName(const struct vlc_affinity_group *);
+
+/**
+ * Gives the calling thread the CPU mask of the process before any placement.
+ * Threads shared by all inputs call this when they start, so that they do
+ * not keep the placement of the input thread that happened to create them.
+ */
+void vlc_affinity_Unpin(void);
+
 int intf_InsertItem(libvlc_int_t *, const char *mrl, unsigned optc,
                     const char * const *optv, unsigned flags);
 void intf_DestroyAll( libvlc_int_t * );
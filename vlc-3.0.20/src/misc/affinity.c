@@ -0,0 +1,384 @@
+/*****************************************************************************
+ * affinity.c: CPU placement of the input thread groups
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+
+#include "libvlc.h"
+
+/*
+ * The input thread pins itself to a group of CPUs before it opens anything.
+ * Every thread it creates afterwards (demuxer helpers, decoders, filters,
+ * encoders, video and audio outputs) inherits that CPU mask, so a whole
+ * pipeline stays on the caches of one NUMA node or of a few cores.
+ *
+ * Threads shared by all inputs (executor, timer, slice and background worker
+ * pools) may also be created on demand from a pinned thread. They unpin
+ * themselves when they start.
+ */
+
+#if defined(__linux__) && defined(HAVE_SCHED_GETAFFINITY)
+#include <dirent.h>
+#include <sched.h>
+
+#define SYSFS_NODE "/sys/devices/system/node"
+
+struct vlc_affinity_group
+{
+    cpu_set_t cpus;
+    unsigned inputs; /**< inputs currently placed in the group */
+    unsigned long placed; /**< inputs ever placed in the group */
+    char name[80];
+};
+
+struct vlc_affinity
+{
+    vlc_mutex_t lock;
+    unsigned count;
+    struct vlc_affinity_group groups[];
+};
+
+/* CPU mask of the process before any placement */
+static vlc_mutex_t unpinned_lock = VLC_STATIC_MUTEX;
+static bool unpinned_valid = false;
+static cpu_set_t unpinned;
+
+/** Formats a CPU set as a list of ranges, as in the sysfs cpulist files */
+static void CPUListFormat(char *buf, size_t size, const cpu_set_t *set)
+{
+    size_t len = 0;
+
+    buf[0] = '\0';
+    for (unsigned i = 0; i < CPU_SETSIZE && len < size; i++)
+    {
+        if (!CPU_ISSET(i, set))
+            continue;
+
+        unsigned j = i;
+        while (j + 1 < CPU_SETSIZE && CPU_ISSET(j + 1, set))
+            j++;
+
+        int n = (i == j)
+            ? snprintf(buf + len, size - len, "%s%u", len ? "," : "", i)
+            : snprintf(buf + len, size - len, "%s%u-%u", len ? "," : "", i, j);
+        if (n < 0)
+            break;
+        len += n;
+        i = j;
+    }
+}
+
+static int CPUListParse(const char *str, cpu_set_t *set)
+{
+    CPU_ZERO(set);
+
+    while (*str != '\0' && *str != '\n')
+    {
+        char *end;
+        unsigned long first = strtoul(str, &end, 10), last = first;
+
+        if (end == str)
+            return -1;
+        if (*end == '-')
+        {
+            str = end + 1;
+            last = strtoul(str, &end, 10);
+            if (end == str || last < first)
+                return -1;
+        }
+
+        for (unsigned long i = first; i <= last && i < CPU_SETSIZE; i++)
+            CPU_SET(i, set);
+
+        str = end;
+        if (*str == ',')
+            str++;
+    }
+    return 0;
+}
+
+/**
+ * Lists the CPU sets of the NUMA nodes, restricted to the usable CPUs.
+ * Usable CPUs without NUMA information make up one more node.
+ */
+static unsigned NodesGet(const cpu_set_t *usable, cpu_set_t *nodes,
+                         unsigned max)
+{
+    cpu_set_t rest = *usable;
+    unsigned count = 0;
+    DIR *dir = opendir(SYSFS_NODE);
+
+    if (dir != NULL)
+    {
+        struct dirent *ent;
+
+        while (count < max && (ent = readdir(dir)) != NULL)
+        {
+            unsigned id;
+            char path[sizeof (SYSFS_NODE) + 32], line[4096];
+
+            if (sscanf(ent->d_name, "node%u", &id) != 1)
+                continue;
+
+            snprintf(path, sizeof (path), SYSFS_NODE"/node%u/cpulist", id);
+            FILE *stream = fopen(path, "re");
+            if (stream == NULL)
+                continue;
+
+            bool ok = fgets(line, sizeof (line), stream) != NULL
+                   && CPUListParse(line, &nodes[count]) == 0;
+            fclose(stream);
+            if (!ok)
+                continue;
+
+            CPU_AND(&nodes[count], &nodes[count], &rest);
+            if (CPU_COUNT(&nodes[count]) > 0)
+            {
+                CPU_XOR(&rest, &rest, &nodes[count]);
+                count++;
+            }
+        }
+        closedir(dir);
+    }
+
+    /* Nodes are disjoint and not empty, so there is room for the rest */
+    if (CPU_COUNT(&rest) > 0)
+        nodes[count++] = rest;
+    return count;
+}
+
+struct vlc_affinity *vlc_affinity_New(vlc_object_t *obj, const char *policy,
+                                      unsigned cores)
+{
+    bool per_node;
+
+    if (!strcmp(policy, "node"))
+        per_node = true;
+    else if (!strcmp(policy, "cores"))
+        per_node = false;
+    else
+        return NULL;
+
+    cpu_set_t usable;
+    if (sched_getaffinity(0, sizeof (usable), &usable))
+    {
+        msg_Err(obj, "cannot get the CPU affinity: %s", vlc_strerror_c(errno));
+        return NULL;
+    }
+
+    vlc_mutex_lock(&unpinned_lock);
+    if (!unpinned_valid)
+    {
+        unpinned = usable;
+        unpinned_valid = true;
+    }
+    vlc_mutex_unlock(&unpinned_lock);
+
+    unsigned ncpus = CPU_COUNT(&usable);
+    cpu_set_t *nodes = malloc(ncpus * sizeof (*nodes));
+    if (unlikely(nodes == NULL))
+        return NULL;
+
+    unsigned nnodes = NodesGet(&usable, nodes, ncpus);
+
+    if (per_node || cores == 0 || cores > ncpus)
+        cores = 0;
+
+    /* Groups never straddle two nodes: at most one partial group per node */
+    unsigned max = cores ? ncpus / cores + nnodes : nnodes;
+    struct vlc_affinity *aff = malloc(sizeof (*aff)
+                                      + max * sizeof (aff->groups[0]));
+    if (unlikely(aff == NULL))
+    {
+        free(nodes);
+        return NULL;
+    }
+
+    vlc_mutex_init(&aff->lock);
+    aff->count = 0;
+
+    for (unsigned n = 0; n < nnodes; n++)
+    {
+        struct vlc_affinity_group *group = NULL;
+        unsigned members = 0;
+
+        for (unsigned i = 0; i < CPU_SETSIZE; i++)
+        {
+            if (!CPU_ISSET(i, &nodes[n]))
+                continue;
+
+            if (group == NULL || (cores && members == cores))
+            {
+                assert(aff->count < max);
+                group = &aff->groups[aff->count++];
+                CPU_ZERO(&group->cpus);
+                group->inputs = 0;
+                group->placed = 0;
+                members = 0;
+            }
+            CPU_SET(i, &group->cpus);
+            members++;
+        }
+    }
+    free(nodes);
+
+    for (unsigned i = 0; i < aff->count; i++)
+    {
+        struct vlc_affinity_group *group = &aff->groups[i];
+        char list[48];
+
+        CPUListFormat(list, sizeof (list), &group->cpus);
+        snprintf(group->name, sizeof (group->name), "group %u cpus %s",
+                 i, list);
+    }
+
+    msg_Dbg(obj, "placing inputs on %u CPU group(s) over %u node(s)",
+            aff->count, nnodes);
+    return aff;
+}
+
+void vlc_affinity_Delete(struct vlc_affinity *aff)
+{
+#ifndef NDEBUG
+    for (unsigned i = 0; i < aff->count; i++)
+        assert(aff->groups[i].inputs == 0);
+#endif
+    vlc_mutex_destroy(&aff->lock);
+    free(aff);
+}
+
+struct vlc_affinity_group *vlc_affinity_Place(struct vlc_affinity *aff,
+                                              vlc_object_t *obj)
+{
+    struct vlc_affinity_group *group = NULL;
+
+    vlc_mutex_lock(&aff->lock);
+    /* Least loaded group first, then the least used one over time, so that
+     * short-lived inputs do not all land on the first group. */
+    for (unsigned i = 0; i < aff->count; i++)
+    {
+        struct vlc_affinity_group *g = &aff->groups[i];
+
+        if (group == NULL || g->inputs < group->inputs
+         || (g->inputs == group->inputs && g->placed < group->placed))
+            group = g;
+    }
+    group->inputs++;
+    group->placed++;
+    vlc_mutex_unlock(&aff->lock);
+
+    if (sched_setaffinity(0, sizeof (group->cpus), &group->cpus))
+    {
+        msg_Warn(obj, "cannot place the input thread: %s",
+                 vlc_strerror_c(errno));
+        vlc_affinity_Leave(aff, group);
+        return NULL;
+    }
+
+    vlc_mutex_lock(&aff->lock);
+    for (unsigned i = 0; i < aff->count; i++)
+        msg_Dbg(obj, "%s%s: %u input(s), %lu placed", aff->groups[i].name,
+                (&aff->groups[i] == group) ? " (selected)" : "",
+                aff->groups[i].inputs, aff->groups[i].placed);
+    vlc_mutex_unlock(&aff->lock);
+    return group;
+}
+
+void vlc_affinity_Leave(struct vlc_affinity *aff,
+                        struct vlc_affinity_group *group)
+{
+    vlc_mutex_lock(&aff->lock);
+    assert(group->inputs > 0);
+    group->inputs--;
+    vlc_mutex_unlock(&aff->lock);
+}
+
+const char *vlc_affinity_GroupName(const struct vlc_affinity_group *group)
+{
+    return group->name;
+}
+
+void vlc_affinity_Unpin(void)
+{
+    cpu_set_t cpus;
+    bool valid;
+
+    vlc_mutex_lock(&unpinned_lock);
+    valid = unpinned_valid;
+    if (valid)
+        cpus = unpinned;
+    vlc_mutex_unlock(&unpinned_lock);
+
+    /* Nothing was ever placed if there is no policy */
+    if (valid)
+        sched_setaffinity(0, sizeof (cpus), &cpus);
+}
+
+#else /* !__linux__ */
+
+struct vlc_affinity *vlc_affinity_New(vlc_object_t *obj, const char *policy,
+                                      unsigned cores)
+{
+    if (strcmp(policy, "none"))
+        msg_Warn(obj, "thread affinity is not supported on this platform");
+    (void) cores;
+    return NULL;
+}
+
+void vlc_affinity_Delete(struct vlc_affinity *aff)
+{
+    (void) aff;
+    vlc_assert_unreachable();
+}
+
+struct vlc_affinity_group *vlc_affinity_Place(struct vlc_affinity *aff,
+                                              vlc_object_t *obj)
+{
+    (void) aff; (void) obj;
+    vlc_assert_unreachable();
+}
+
+void vlc_affinity_Leave(struct vlc_affinity *aff,
+                        struct vlc_affinity_group *group)
+{
+    (void) aff; (void) group;
+    vlc_assert_unreachable();
+}
+
+const char *vlc_affinity_GroupName(const struct vlc_affinity_group *group)
+{
+    (void) group;
+    vlc_assert_unreachable();
+}
+
+void vlc_affinity_Unpin(void)
+{
+}
+
+#endif
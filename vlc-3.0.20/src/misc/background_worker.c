@@ -21,17 +21,37 @@
 #endif
 
 #include <assert.h>
+#include <stdint.h>
+#ifdef HAVE_SEARCH_H
+# include <search.h>
+#endif
 #include <vlc_common.h>
 #include <vlc_threads.h>
+#include <vlc_interrupt.h>
 #include <vlc_arrays.h>
 
 #include "libvlc.h"
 #include "background_worker.h"
 
+#define BG_LANE_COUNT 2 /**< interactive, background */
+
 struct bg_queued_item {
     void* id; /**< id associated with entity */
     void* entity; /**< the entity to process */
     int timeout; /**< timeout duration in microseconds */
+    int lane; /**< index of the queue holding the item */
+    vlc_tick_t date; /**< time of queuing */
+    struct bg_queued_item* prev;
+    struct bg_queued_item* next;
+};
+
+struct bg_thread {
+    struct background_worker* worker;
+    struct bg_queued_item* item; /**< item being processed, or NULL */
+    vlc_tick_t deadline; /**< deadline of the current task */
+    bool probe_request; /**< true if a probe is requested */
+    bool cancel; /**< true if the current task shall be stopped */
+    vlc_interrupt_t* interrupt; /**< context of the current pf_run task */
 };
 
 struct background_worker {
@@ -39,145 +59,361 @@ struct background_worker {
     struct background_worker_config conf;
 
     vlc_mutex_t lock; /**< acquire to inspect members that follow */
+    vlc_cond_t queue_wait; /**< wait for new items or termination */
+    vlc_cond_t probe_wait; /**< wait for probe request or cancelation */
+    vlc_cond_t done_wait; /**< wait for a task or a thread to finish */
+
     struct {
-        bool probe_request; /**< true if a probe is requested */
-        vlc_cond_t wait; /**< wait for update in terms of head */
-        vlc_cond_t worker_wait; /**< wait for probe request or cancelation */
-        vlc_tick_t deadline; /**< deadline of the current task */
-        void* id; /**< id of the current task */
-        bool active; /**< true if there is an active thread */
-    } head;
+        struct bg_queued_item* first;
+        struct bg_queued_item* last;
+    } queue[BG_LANE_COUNT]; /**< pending entities, by priority */
+    size_t queued; /**< number of pending entities */
+    void* index; /**< search tree of pending entities, by entity and id */
+
+    vlc_array_t threads; /**< running threads (struct bg_thread) */
+    size_t idle; /**< number of threads waiting for an entity */
+    bool terminate; /**< true if the threads shall exit */
+
+    vlc_timer_t timer; /**< kills pf_run tasks past their deadline */
+    bool has_timer; /**< true once the timer is created */
+    vlc_tick_t timer_deadline; /**< when the timer fires, or INT64_MAX */
 
     struct {
-        vlc_cond_t wait; /**< wait for update in terms of tail */
-        vlc_array_t data; /**< queue of pending entities to process */
-    } tail;
+        uint64_t done;
+        vlc_tick_t wait_total;
+        vlc_tick_t wait_max;
+        vlc_tick_t run_total;
+    } stats;
 };
 
-static void* Thread( void* data )
+static int QueuedItemCmp( const void* a_, const void* b_ )
+{
+    const struct bg_queued_item* a = a_;
+    const struct bg_queued_item* b = b_;
+
+    if( a->entity != b->entity )
+        return (uintptr_t)a->entity < (uintptr_t)b->entity ? -1 : 1;
+    if( a->id != b->id )
+        return (uintptr_t)a->id < (uintptr_t)b->id ? -1 : 1;
+    return 0;
+}
+
+static void QueueAppend( struct background_worker* worker,
+                         struct bg_queued_item* item, int lane )
+{
+    item->lane = lane;
+    item->prev = worker->queue[lane].last;
+    item->next = NULL;
+
+    if( item->prev != NULL )
+        item->prev->next = item;
+    else
+        worker->queue[lane].first = item;
+    worker->queue[lane].last = item;
+}
+
+static void QueueUnlink( struct background_worker* worker,
+                         struct bg_queued_item* item )
+{
+    int lane = item->lane;
+
+    if( item->prev != NULL )
+        item->prev->next = item->next;
+    else
+        worker->queue[lane].first = item->next;
+
+    if( item->next != NULL )
+        item->next->prev = item->prev;
+    else
+        worker->queue[lane].last = item->prev;
+}
+
+static void QueueRemove( struct background_worker* worker,
+                         struct bg_queued_item* item )
+{
+    QueueUnlink( worker, item );
+    tdelete( item, &worker->index, QueuedItemCmp );
+    worker->queued--;
+}
+
+static struct bg_queued_item* QueuePop( struct background_worker* worker )
+{
+    for( int lane = 0; lane < BG_LANE_COUNT; lane++ )
+    {
+        struct bg_queued_item* item = worker->queue[lane].first;
+
+        if( item != NULL )
+        {
+            QueueRemove( worker, item );
+            return item;
+        }
+    }
+    return NULL;
+}
+
+static void ThreadRemove( struct background_worker* worker,
+                          struct bg_thread* th )
+{
+    int idx = vlc_array_index_of_item( &worker->threads, th );
+
+    assert( idx >= 0 );
+    vlc_array_remove( &worker->threads, idx );
+    vlc_cond_broadcast( &worker->done_wait );
+}
+
+static void WorkerTimeout( void* data )
 {
     struct background_worker* worker = data;
+    vlc_tick_t now = mdate();
+    vlc_tick_t next = INT64_MAX;
 
-    for( ;; )
+    vlc_mutex_lock( &worker->lock );
+    for( size_t i = 0; i < vlc_array_count( &worker->threads ); ++i )
+    {
+        struct bg_thread* th = vlc_array_item_at_index( &worker->threads, i );
+
+        if( th->interrupt == NULL )
+            continue;
+        if( th->deadline <= now )
+            vlc_interrupt_kill( th->interrupt );
+        else if( th->deadline < next )
+            next = th->deadline;
+    }
+
+    worker->timer_deadline = next;
+    if( next != INT64_MAX )
+        vlc_timer_schedule( worker->timer, true, next, 0 );
+    vlc_mutex_unlock( &worker->lock );
+}
+
+/* Makes sure that the timer fires by the given deadline, lock held */
+static void WorkerTimeoutAt( struct background_worker* worker,
+                             vlc_tick_t deadline )
+{
+    if( !worker->has_timer )
     {
-        struct bg_queued_item* item = NULL;
-        void* handle;
+        if( vlc_timer_create( &worker->timer, WorkerTimeout, worker ) )
+            return;
+        worker->has_timer = true;
+    }
+
+    if( deadline < worker->timer_deadline )
+    {
+        worker->timer_deadline = deadline;
+        vlc_timer_schedule( worker->timer, true, deadline, 0 );
+    }
+}
+
+static void ThreadRun( struct background_worker* worker, struct bg_thread* th,
+                       struct bg_queued_item* item )
+{
+    vlc_interrupt_t* interrupt = vlc_interrupt_create();
+
+    if( unlikely( interrupt == NULL ) )
+        return;
+
+    vlc_mutex_lock( &worker->lock );
+    th->interrupt = interrupt;
+    if( th->cancel )
+        vlc_interrupt_kill( interrupt );
+    if( th->deadline != INT64_MAX )
+        WorkerTimeoutAt( worker, th->deadline );
+    vlc_mutex_unlock( &worker->lock );
+
+    vlc_interrupt_t* prev = vlc_interrupt_set( interrupt );
+    worker->conf.pf_run( worker->owner, item->entity );
+    vlc_interrupt_set( prev );
+
+    vlc_mutex_lock( &worker->lock );
+    th->interrupt = NULL;
+    vlc_mutex_unlock( &worker->lock );
+    vlc_interrupt_destroy( interrupt );
+}
+
+static void ThreadProbe( struct background_worker* worker, struct bg_thread* th,
+                         struct bg_queued_item* item )
+{
+    void* handle;
+
+    if( worker->conf.pf_start( worker->owner, item->entity, &handle ) )
+        return;
 
+    for( ;; )
+    {
         vlc_mutex_lock( &worker->lock );
-        for( ;; )
-        {
-            if( vlc_array_count( &worker->tail.data ) )
-            {
-                item = vlc_array_item_at_index( &worker->tail.data, 0 );
-                handle = NULL;
 
-                vlc_array_remove( &worker->tail.data, 0 );
-            }
+        bool const b_timeout = th->cancel || th->deadline <= mdate();
+        th->probe_request = false;
 
-            if( worker->head.deadline == VLC_TICK_0 && item == NULL )
-                worker->head.active = false;
-            worker->head.id = item ? item->id : NULL;
-            vlc_cond_broadcast( &worker->head.wait );
+        vlc_mutex_unlock( &worker->lock );
 
-            if( item )
-            {
-                if( item->timeout > 0 )
-                    worker->head.deadline = mdate() + item->timeout * 1000;
-                else
-                    worker->head.deadline = INT64_MAX;
-            }
-            else if( worker->head.deadline != VLC_TICK_0 )
-            {
-                /* Wait 1 seconds for new inputs before terminating */
-                vlc_tick_t deadline = mdate() + INT64_C(1000000);
-                int ret = vlc_cond_timedwait( &worker->tail.wait,
-                                              &worker->lock, deadline );
-                if( ret != 0 )
-                {
-                    /* Timeout: if there is still no items, the thread will be
-                     * terminated at next loop iteration (active = false). */
-                    worker->head.deadline = VLC_TICK_0;
-                }
-                continue;
-            }
+        if( b_timeout ||
+            worker->conf.pf_probe( worker->owner, handle ) )
+        {
+            worker->conf.pf_stop( worker->owner, handle );
             break;
         }
 
-        if( !worker->head.active )
+        vlc_mutex_lock( &worker->lock );
+        if( th->probe_request == false && th->cancel == false &&
+            th->deadline > mdate() )
         {
-            vlc_mutex_unlock( &worker->lock );
-            break;
+            vlc_cond_timedwait( &worker->probe_wait, &worker->lock,
+                                 th->deadline );
         }
         vlc_mutex_unlock( &worker->lock );
+    }
+}
+
+static void* Thread( void* data )
+{
+    struct bg_thread* th = data;
+    struct background_worker* worker = th->worker;
+
+    vlc_affinity_Unpin();
 
-        assert( item != NULL );
+    vlc_mutex_lock( &worker->lock );
+    for( ;; )
+    {
+        if( worker->terminate )
+            break;
 
-        if( worker->conf.pf_start( worker->owner, item->entity, &handle ) )
+        struct bg_queued_item* item = QueuePop( worker );
+        if( item == NULL )
         {
-            worker->conf.pf_release( item->entity );
-            free( item );
+            /* Park until new inputs: bursts of work do not pay for thread
+             * creation again */
+            worker->idle++;
+            vlc_cond_wait( &worker->queue_wait, &worker->lock );
+            worker->idle--;
             continue;
         }
 
-        for( ;; )
-        {
-            vlc_mutex_lock( &worker->lock );
+        vlc_tick_t start = mdate();
 
-            bool const b_timeout = worker->head.deadline <= mdate();
-            worker->head.probe_request = false;
+        worker->stats.wait_total += start - item->date;
+        if( start - item->date > worker->stats.wait_max )
+            worker->stats.wait_max = start - item->date;
 
-            vlc_mutex_unlock( &worker->lock );
+        th->item = item;
+        th->probe_request = false;
+        th->cancel = false;
+        if( item->timeout > 0 )
+            th->deadline = start + item->timeout * 1000;
+        else
+            th->deadline = INT64_MAX;
+        vlc_mutex_unlock( &worker->lock );
 
-            if( b_timeout ||
-                worker->conf.pf_probe( worker->owner, handle ) )
-            {
-                worker->conf.pf_stop( worker->owner, handle );
-                worker->conf.pf_release( item->entity );
-                free( item );
-                break;
-            }
+        if( worker->conf.pf_run != NULL )
+            ThreadRun( worker, th, item );
+        else
+            ThreadProbe( worker, th, item );
 
-            vlc_mutex_lock( &worker->lock );
-            if( worker->head.probe_request == false &&
-                worker->head.deadline > mdate() )
-            {
-                vlc_cond_timedwait( &worker->head.worker_wait, &worker->lock,
-                                     worker->head.deadline );
-            }
-            vlc_mutex_unlock( &worker->lock );
-        }
+        vlc_mutex_lock( &worker->lock );
+        th->item = NULL;
+        worker->stats.done++;
+        worker->stats.run_total += mdate() - start;
+        vlc_cond_broadcast( &worker->done_wait );
+        vlc_mutex_unlock( &worker->lock );
+
+        worker->conf.pf_release( item->entity );
+        free( item );
+        vlc_mutex_lock( &worker->lock );
     }
 
+    ThreadRemove( worker, th );
+    vlc_mutex_unlock( &worker->lock );
+    free( th );
     return NULL;
 }
 
+static int ThreadSpawn( struct background_worker* worker )
+{
+    struct bg_thread* th = malloc( sizeof( *th ) );
+
+    if( unlikely( !th ) )
+        return VLC_ENOMEM;
+
+    th->worker = worker;
+    th->item = NULL;
+    th->probe_request = false;
+    th->cancel = false;
+    th->interrupt = NULL;
+
+    if( vlc_array_append( &worker->threads, th ) )
+    {
+        free( th );
+        return VLC_ENOMEM;
+    }
+
+    if( vlc_clone_detach( NULL, Thread, th, VLC_THREAD_PRIORITY_LOW ) )
+    {
+        vlc_array_remove( &worker->threads,
+                          vlc_array_count( &worker->threads ) - 1 );
+        free( th );
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static bool IsRunning( struct background_worker* worker, void* id )
+{
+    for( size_t i = 0; i < vlc_array_count( &worker->threads ); ++i )
+    {
+        struct bg_thread* th = vlc_array_item_at_index( &worker->threads, i );
+
+        if( th->item != NULL && ( id == NULL || th->item->id == id ) )
+            return true;
+    }
+    return false;
+}
+
 static void BackgroundWorkerCancel( struct background_worker* worker, void* id)
 {
     vlc_mutex_lock( &worker->lock );
-    for( size_t i = 0; i < vlc_array_count( &worker->tail.data ); )
+    for( int lane = 0; lane < BG_LANE_COUNT; lane++ )
     {
-        struct bg_queued_item* item =
-            vlc_array_item_at_index( &worker->tail.data, i );
+        struct bg_queued_item* item = worker->queue[lane].first;
 
-        if( id == NULL || item->id == id )
+        while( item != NULL )
         {
-            vlc_array_remove( &worker->tail.data, i );
-            worker->conf.pf_release( item->entity );
-            free( item );
-            continue;
-        }
+            struct bg_queued_item* next = item->next;
 
-        ++i;
+            if( id == NULL || item->id == id )
+            {
+                QueueRemove( worker, item );
+                worker->conf.pf_release( item->entity );
+                free( item );
+            }
+            item = next;
+        }
     }
 
-    while( ( id == NULL && worker->head.active )
-        || ( id != NULL && worker->head.id == id ) )
+    for( size_t i = 0; i < vlc_array_count( &worker->threads ); ++i )
     {
-        worker->head.deadline = VLC_TICK_0;
-        vlc_cond_signal( &worker->head.worker_wait );
-        vlc_cond_signal( &worker->tail.wait );
-        vlc_cond_wait( &worker->head.wait, &worker->lock );
+        struct bg_thread* th = vlc_array_item_at_index( &worker->threads, i );
+
+        if( th->item != NULL && ( id == NULL || th->item->id == id ) )
+        {
+            th->cancel = true;
+            if( th->interrupt != NULL )
+                vlc_interrupt_kill( th->interrupt );
+        }
     }
+
+    if( id == NULL )
+    {   /* Stop all threads */
+        worker->terminate = true;
+        vlc_cond_broadcast( &worker->queue_wait );
+    }
+    vlc_cond_broadcast( &worker->probe_wait );
+
+    while( id == NULL ? vlc_array_count( &worker->threads ) > 0
+                      : IsRunning( worker, id ) )
+        vlc_cond_wait( &worker->done_wait, &worker->lock );
+
+    if( id == NULL )
+        worker->terminate = false;
     vlc_mutex_unlock( &worker->lock );
 }
 
@@ -190,56 +426,96 @@ struct background_worker* background_worker_New( void* owner,
         return NULL;
 
     worker->conf = *conf;
+    if( worker->conf.max_threads < 1 )
+        worker->conf.max_threads = 1;
     worker->owner = owner;
-    worker->head.id = NULL;
-    worker->head.active = false;
-    worker->head.deadline = VLC_TICK_INVALID;
 
     vlc_mutex_init( &worker->lock );
-    vlc_cond_init( &worker->head.wait );
-    vlc_cond_init( &worker->head.worker_wait );
-
-    vlc_array_init( &worker->tail.data );
-    vlc_cond_init( &worker->tail.wait );
+    vlc_cond_init( &worker->queue_wait );
+    vlc_cond_init( &worker->probe_wait );
+    vlc_cond_init( &worker->done_wait );
+
+    for( int lane = 0; lane < BG_LANE_COUNT; lane++ )
+        worker->queue[lane].first = worker->queue[lane].last = NULL;
+    worker->queued = 0;
+    worker->index = NULL;
+
+    vlc_array_init( &worker->threads );
+    worker->idle = 0;
+    worker->terminate = false;
+    worker->has_timer = false;
+    worker->timer_deadline = INT64_MAX;
+
+    worker->stats.done = 0;
+    worker->stats.wait_total = 0;
+    worker->stats.wait_max = 0;
+    worker->stats.run_total = 0;
 
     return worker;
 }
 
 int background_worker_Push( struct background_worker* worker, void* entity,
-                        void* id, int timeout )
+                        void* id, int timeout, bool background )
 {
-    struct bg_queued_item* item = malloc( sizeof( *item ) );
+    int lane = background ? 1 : 0;
 
+    vlc_mutex_lock( &worker->lock );
+
+    /* Do not queue the same request twice, but bump its priority */
+    struct bg_queued_item key = { .id = id, .entity = entity };
+    void** pp = tfind( &key, &worker->index, QueuedItemCmp );
+    if( pp != NULL )
+    {
+        struct bg_queued_item* item = *pp;
+
+        if( lane < item->lane )
+        {
+            QueueUnlink( worker, item );
+            QueueAppend( worker, item, lane );
+        }
+        vlc_mutex_unlock( &worker->lock );
+        return VLC_SUCCESS;
+    }
+
+    struct bg_queued_item* item = malloc( sizeof( *item ) );
     if( unlikely( !item ) )
+    {
+        vlc_mutex_unlock( &worker->lock );
         return VLC_EGENERIC;
+    }
 
     item->id = id;
     item->entity = entity;
     item->timeout = timeout < 0 ? worker->conf.default_timeout : timeout;
+    item->date = mdate();
 
-    vlc_mutex_lock( &worker->lock );
-    int i_ret = vlc_array_append( &worker->tail.data, item );
-    vlc_cond_signal( &worker->tail.wait );
-    if( i_ret != 0 )
+    if( unlikely( tsearch( item, &worker->index, QueuedItemCmp ) == NULL ) )
     {
+        vlc_mutex_unlock( &worker->lock );
         free( item );
         return VLC_EGENERIC;
     }
+    QueueAppend( worker, item, lane );
+    worker->queued++;
+
+    /* Start another thread unless enough are already waiting */
+    if( worker->idle < worker->queued &&
+        vlc_array_count( &worker->threads ) < (size_t)worker->conf.max_threads )
+        ThreadSpawn( worker );
 
-    if( worker->head.active == false )
+    if( vlc_array_count( &worker->threads ) == 0 )
     {
-        worker->head.probe_request = false;
-        worker->head.active =
-            !vlc_clone_detach( NULL, Thread, worker, VLC_THREAD_PRIORITY_LOW );
+        QueueRemove( worker, item );
+        vlc_mutex_unlock( &worker->lock );
+        free( item );
+        return VLC_EGENERIC;
     }
 
-    if( worker->head.active )
-        worker->conf.pf_hold( item->entity );
-
-    int ret = worker->head.active ? VLC_SUCCESS : VLC_EGENERIC;
+    worker->conf.pf_hold( item->entity );
+    vlc_cond_signal( &worker->queue_wait );
     vlc_mutex_unlock( &worker->lock );
 
-    return ret;
+    return VLC_SUCCESS;
 }
 
 void background_worker_Cancel( struct background_worker* worker, void* id )
@@ -250,18 +526,50 @@ void background_worker_Cancel( struct background_worker* worker, void* id )
 void background_worker_RequestProbe( struct background_worker* worker )
 {
     vlc_mutex_lock( &worker->lock );
-    worker->head.probe_request = true;
-    vlc_cond_signal( &worker->head.worker_wait );
+    for( size_t i = 0; i < vlc_array_count( &worker->threads ); ++i )
+    {
+        struct bg_thread* th = vlc_array_item_at_index( &worker->threads, i );
+        th->probe_request = true;
+    }
+    vlc_cond_broadcast( &worker->probe_wait );
+    vlc_mutex_unlock( &worker->lock );
+}
+
+void background_worker_GetStats( struct background_worker* worker,
+                                 struct background_worker_stats* stats )
+{
+    vlc_mutex_lock( &worker->lock );
+    stats->queued = worker->queued;
+    stats->running = 0;
+    for( size_t i = 0; i < vlc_array_count( &worker->threads ); ++i )
+    {
+        struct bg_thread* th = vlc_array_item_at_index( &worker->threads, i );
+        if( th->item != NULL )
+            stats->running++;
+    }
+    stats->threads = vlc_array_count( &worker->threads );
+    stats->done = worker->stats.done;
+    stats->wait_max = worker->stats.wait_max;
+    if( worker->stats.done > 0 )
+    {
+        stats->wait_avg = worker->stats.wait_total / worker->stats.done;
+        stats->run_avg = worker->stats.run_total / worker->stats.done;
+    }
+    else
+        stats->wait_avg = stats->run_avg = 0;
     vlc_mutex_unlock( &worker->lock );
 }
 
 void background_worker_Delete( struct background_worker* worker )
 {
     BackgroundWorkerCancel( worker, NULL );
-    vlc_array_clear( &worker->tail.data );
+    assert( worker->index == NULL );
+    if( worker->has_timer )
+        vlc_timer_destroy( worker->timer );
+    vlc_array_clear( &worker->threads );
     vlc_mutex_destroy( &worker->lock );
-    vlc_cond_destroy( &worker->head.wait );
-    vlc_cond_destroy( &worker->head.worker_wait );
-    vlc_cond_destroy( &worker->tail.wait );
+    vlc_cond_destroy( &worker->queue_wait );
+    vlc_cond_destroy( &worker->probe_wait );
+    vlc_cond_destroy( &worker->done_wait );
     free( worker );
 }
@@ -29,13 +29,22 @@ struct background_worker_config {
      **/
     vlc_tick_t default_timeout;
 
+    /**
+     * Maximum number of tasks running in parallel
+     *
+     * Each running task is probed, or run, from its own thread. The threads
+     * are started on demand and then parked until the background-worker is
+     * deleted. Values less than 1 denote a single task at a time.
+     **/
+    int max_threads;
+
     /**
      * Release an entity
      *
      * This callback will be called in order to decrement the ref-count of a
      * entity within the background-worker. It will happen either when \ref
-     * pf_stop has finished executing, or if the entity is removed from the
-     * queue (through \ref background_worker_Cancel)
+     * pf_stop or \ref pf_run has finished executing, or if the entity is
+     * removed from the queue (through \ref background_worker_Cancel)
      *
      * \param entity the entity to release
      **/
@@ -99,6 +108,30 @@ struct background_worker_config {
      * \parma handle the handle associated with the task to be stopped
      **/
     void( *pf_stop )( void* owner, void* handle );
+
+    /**
+     * Run a task
+     *
+     * If not NULL, this callback processes an entity from a thread of the
+     * background-worker, and \ref pf_start, \ref pf_probe and \ref pf_stop
+     * are not used. It runs with its own interruption context, which is
+     * killed when the task is cancelled or when its timeout is reached: the
+     * task shall use interruptible functions (see vlc_interrupt.h).
+     *
+     * \param owner the owner of the background-worker
+     * \param entity the entity to process
+     **/
+    void( *pf_run )( void* owner, void* entity );
+};
+
+struct background_worker_stats {
+    size_t queued; /**< entities waiting for a thread */
+    size_t running; /**< entities being processed */
+    size_t threads; /**< threads of the pool, running or parked */
+    uint64_t done; /**< entities processed so far */
+    vlc_tick_t wait_avg; /**< average time spent queued */
+    vlc_tick_t wait_max; /**< longest time spent queued */
+    vlc_tick_t run_avg; /**< average processing time */
 };
 
 /**
@@ -119,10 +152,10 @@ struct background_worker* background_worker_New( void* owner,
     struct background_worker_config* config );
 
 /**
- * Request the background-worker to probe the current task
+ * Request the background-worker to probe the current tasks
  *
  * This function is used to signal the background-worker that it should do
- * another probe to see whether the current task is still alive.
+ * another probe to see whether the current tasks are still alive.
  *
  * \warning Note that the function will not wait for the probing to finish, it
  *          will simply ask the background worker to recheck it as soon as
@@ -137,7 +170,11 @@ void background_worker_RequestProbe( struct background_worker* worker );
  *
  * This function is used to push an entity into the queue of pending work. The
  * entities will be processed in the order in which they are received (in terms
- * of the order of invocations in a single-threaded environment).
+ * of the order of invocations in a single-threaded environment), except that
+ * background entities are only started when no other entity is pending.
+ *
+ * If the same entity is already pending with the same id, it is not queued
+ * again; it is only moved to the interactive queue if requested.
  *
  * \param worker the background-worker
  * \param entity the entity which is to be queued
@@ -145,11 +182,12 @@ void background_worker_RequestProbe( struct background_worker* worker );
  * \param timeout the timeout of the entity in milliseconds, `0` denotes no
  *                timeout, a negative value will use the default timeout
  *                associated with the background-worker.
+ * \param background true for low priority work, such as bulk indexing
  * \return VLC_SUCCESS if the entity was successfully queued, an error-code on
  *         failure.
  **/
 int background_worker_Push( struct background_worker* worker, void* entity,
-    void* id, int timeout );
+    void* id, int timeout, bool background );
 
 /**
  * Remove entities from the background-worker
@@ -167,6 +205,15 @@ int background_worker_Push( struct background_worker* worker, void* entity,
  **/
 void background_worker_Cancel( struct background_worker* worker, void* id );
 
+/**
+ * Get statistics about a background-worker
+ *
+ * \param worker the background-worker
+ * \param stats [out] the current queue depth and latencies
+ **/
+void background_worker_GetStats( struct background_worker* worker,
+                                 struct background_worker_stats* stats );
+
 /**
  * Delete a background-worker
  *
@@ -28,12 +28,14 @@
 #include <sys/stat.h>
 #include <assert.h>
 #include <errno.h>
+#include <limits.h>
 #include <unistd.h>
 #include <fcntl.h>
 
 #include <vlc_common.h>
 #include <vlc_block.h>
 #include <vlc_fs.h>
+#include <vlc_atomic.h>
 
 #ifndef NDEBUG
 static void BlockNoRelease( block_t *b )
@@ -86,6 +88,7 @@ void block_Init( block_t *restrict b, void *buf, size_t size )
     b->i_pts =
     b->i_dts = VLC_TICK_INVALID;
     b->i_length = 0;
+    b->i_ingest = VLC_TICK_INVALID;
 #ifndef NDEBUG
     b->pf_release = BlockNoRelease;
 #endif
@@ -117,6 +120,260 @@ static void BlockMetaCopy( block_t *restrict out, const block_t *in )
 /** Initial reserved header and footer size. */
 #define BLOCK_PADDING      32
 
+/** Extra buffer space around the payload of a block_Alloc() block:
+ * alignment slack, plus pre and post padding. */
+#define BLOCK_EXTRA        (BLOCK_ALIGN + (2 * BLOCK_PADDING))
+
+/*****************************************************************************
+ * Block pool
+ *****************************************************************************
+ * Blocks with a small enough payload are rounded up to a power of two size
+ * class and recycled instead of being returned to the heap. Each thread keeps
+ * a small cache of free blocks per size class, so that most allocations do
+ * not even take a lock. Thread caches exchange batches of blocks with a
+ * global, lock-protected, pool in both directions.
+ *
+ * Pooled blocks are laid out exactly like other block_Alloc() blocks: the
+ * size class is recovered from the buffer size (block_t.i_size), which is
+ * never modified by block_TryRealloc().
+ *****************************************************************************/
+#define BLOCK_POOL_MIN_SHIFT  8  /**< 256 bytes smallest size class */
+#define BLOCK_POOL_MAX_SHIFT 16  /**< 64 KiB largest size class */
+#define BLOCK_POOL_CLASSES   (BLOCK_POOL_MAX_SHIFT - BLOCK_POOL_MIN_SHIFT + 1)
+
+/** Free bytes kept per size class by each thread cache */
+#define BLOCK_POOL_THREAD_BYTES  (256 * 1024)
+/** Number of blocks moved at once between a thread cache and the pool */
+#define BLOCK_POOL_BATCH          8
+/** Thread cache hits accumulated before being folded into the statistics */
+#define BLOCK_POOL_STATS_PERIOD 256
+
+struct block_pool_cache
+{
+    block_t *heads[BLOCK_POOL_CLASSES];
+    unsigned counts[BLOCK_POOL_CLASSES];
+    unsigned long hits;
+    bool registered; /**< thread exit handler installed */
+    bool dead; /**< thread exit handler already ran */
+};
+
+static thread_local struct block_pool_cache block_cache;
+
+static struct
+{
+    vlc_mutex_t lock;
+    block_t *heads[BLOCK_POOL_CLASSES];
+    unsigned counts[BLOCK_POOL_CLASSES];
+    vlc_threadvar_t key;
+    bool has_key;
+
+    atomic_ulong thread_hits;
+    atomic_ulong global_hits;
+    atomic_ulong misses;
+    atomic_ulong unpooled;
+} block_pool = { .lock = VLC_STATIC_MUTEX };
+
+/** Maximum free blocks kept per size class in a thread cache */
+static inline unsigned block_pool_ClassMax(unsigned cls)
+{
+    unsigned max = BLOCK_POOL_THREAD_BYTES >> (BLOCK_POOL_MIN_SHIFT + cls);
+    return (max < BLOCK_POOL_BATCH) ? BLOCK_POOL_BATCH : max;
+}
+
+/** Maximum free blocks kept per size class in the global pool */
+static inline unsigned block_pool_GlobalMax(unsigned cls)
+{
+    return 4 * block_pool_ClassMax(cls);
+}
+
+static inline size_t block_pool_ClassSize(unsigned cls)
+{
+    return ((size_t)1) << (BLOCK_POOL_MIN_SHIFT + cls);
+}
+
+/** Returns the size class for a given payload size, -1 if too large. */
+static inline int block_pool_ClassOf(size_t size)
+{
+    if (size > block_pool_ClassSize(BLOCK_POOL_CLASSES - 1))
+        return -1;
+    if (size <= block_pool_ClassSize(0))
+        return 0;
+    return (sizeof (unsigned) * 8) - clz(size - 1) - BLOCK_POOL_MIN_SHIFT;
+}
+
+static void block_pool_FlushStats(struct block_pool_cache *cache)
+{
+    if (cache->hits > 0)
+    {
+        atomic_fetch_add_explicit(&block_pool.thread_hits, cache->hits,
+                                  memory_order_relaxed);
+        cache->hits = 0;
+    }
+}
+
+/** Moves up to count blocks from a thread cache class to the global pool.
+ * Blocks that do not fit in the global pool are freed. */
+static void block_pool_Spill(struct block_pool_cache *cache, unsigned cls,
+                             unsigned count)
+{
+    block_t *list = NULL;
+
+    vlc_mutex_lock(&block_pool.lock);
+    while (count > 0 && cache->heads[cls] != NULL)
+    {
+        block_t *b = cache->heads[cls];
+
+        cache->heads[cls] = b->p_next;
+        cache->counts[cls]--;
+        count--;
+
+        if (block_pool.counts[cls] < block_pool_GlobalMax(cls))
+        {
+            b->p_next = block_pool.heads[cls];
+            block_pool.heads[cls] = b;
+            block_pool.counts[cls]++;
+        }
+        else
+        {
+            b->p_next = list;
+            list = b;
+        }
+    }
+    vlc_mutex_unlock(&block_pool.lock);
+
+    while (list != NULL)
+    {
+        block_t *next = list->p_next;
+        free(list);
+        list = next;
+    }
+}
+
+static void block_pool_ThreadExit(void *data)
+{
+    struct block_pool_cache *cache = data;
+
+    block_pool_FlushStats(cache);
+    for (unsigned cls = 0; cls < BLOCK_POOL_CLASSES; cls++)
+        block_pool_Spill(cache, cls, UINT_MAX);
+    cache->registered = false;
+    cache->dead = true;
+}
+
+/** Returns the calling thread block cache, or NULL if not usable. */
+static struct block_pool_cache *block_pool_GetCache(void)
+{
+    struct block_pool_cache *cache = &block_cache;
+
+    if (likely(cache->registered))
+        return cache;
+    if (cache->dead)
+        return NULL;
+
+    /* First use of the pool by this thread: make sure the blocks cached by
+     * the thread get back to the global pool when it exits. */
+    vlc_mutex_lock(&block_pool.lock);
+    if (!block_pool.has_key)
+        block_pool.has_key =
+            vlc_threadvar_create(&block_pool.key,
+                                 block_pool_ThreadExit) == 0;
+    vlc_mutex_unlock(&block_pool.lock);
+
+    if (!block_pool.has_key
+     || vlc_threadvar_set(block_pool.key, cache))
+    {
+        cache->dead = true;
+        return NULL;
+    }
+    cache->registered = true;
+    return cache;
+}
+
+static void block_pool_Release(block_t *block)
+{
+    int cls = block_pool_ClassOf(block->i_size - BLOCK_EXTRA);
+
+    /* That is always true for blocks allocated with block_Alloc(). */
+    assert(block->p_start == (unsigned char *)(block + 1));
+    assert(cls >= 0
+        && block->i_size == block_pool_ClassSize(cls) + BLOCK_EXTRA);
+    block_Invalidate(block);
+
+    struct block_pool_cache *cache = block_pool_GetCache();
+    if (unlikely(cache == NULL))
+    {
+        free(block);
+        return;
+    }
+
+    block->p_next = cache->heads[cls];
+    cache->heads[cls] = block;
+    if (++cache->counts[cls] > block_pool_ClassMax(cls))
+        block_pool_Spill(cache, cls, BLOCK_POOL_BATCH);
+}
+
+/** Takes a free block of the given class, or returns NULL. */
+static block_t *block_pool_Get(unsigned cls)
+{
+    struct block_pool_cache *cache = block_pool_GetCache();
+    block_t *b;
+
+    if (likely(cache != NULL) && (b = cache->heads[cls]) != NULL)
+    {
+        cache->heads[cls] = b->p_next;
+        cache->counts[cls]--;
+        if (++cache->hits >= BLOCK_POOL_STATS_PERIOD)
+            block_pool_FlushStats(cache);
+        return b;
+    }
+
+    /* Thread cache is empty: refill it from the global pool */
+    vlc_mutex_lock(&block_pool.lock);
+    b = block_pool.heads[cls];
+    if (b != NULL)
+    {
+        block_pool.heads[cls] = b->p_next;
+        block_pool.counts[cls]--;
+
+        for (unsigned i = 1; cache != NULL && i < BLOCK_POOL_BATCH
+                          && block_pool.heads[cls] != NULL; i++)
+        {
+            block_t *next = block_pool.heads[cls];
+
+            block_pool.heads[cls] = next->p_next;
+            block_pool.counts[cls]--;
+            next->p_next = cache->heads[cls];
+            cache->heads[cls] = next;
+            cache->counts[cls]++;
+        }
+    }
+    vlc_mutex_unlock(&block_pool.lock);
+
+    if (b != NULL)
+        atomic_fetch_add_explicit(&block_pool.global_hits, 1,
+                                  memory_order_relaxed);
+    if (cache != NULL)
+        block_pool_FlushStats(cache);
+    return b;
+}
+
+void block_PoolGetStats(block_pool_stats_t *stats)
+{
+    struct block_pool_cache *cache = &block_cache;
+
+    if (cache->registered)
+        block_pool_FlushStats(cache);
+
+    stats->i_thread_hits = atomic_load_explicit(&block_pool.thread_hits,
+                                                memory_order_relaxed);
+    stats->i_global_hits = atomic_load_explicit(&block_pool.global_hits,
+                                                memory_order_relaxed);
+    stats->i_misses = atomic_load_explicit(&block_pool.misses,
+                                           memory_order_relaxed);
+    stats->i_unpooled = atomic_load_explicit(&block_pool.unpooled,
+                                             memory_order_relaxed);
+}
+
 block_t *block_Alloc (size_t size)
 {
     if (unlikely(size >> 27))
@@ -125,23 +382,40 @@ block_t *block_Alloc (size_t size)
         return NULL;
     }
 
-    /* 2 * BLOCK_PADDING: pre + post padding */
-    const size_t alloc = sizeof (block_t) + BLOCK_ALIGN + (2 * BLOCK_PADDING)
-                       + size;
-    if (unlikely(alloc <= size))
-        return NULL;
+    int cls = block_pool_ClassOf(size);
+    size_t capacity = size;
+    block_t *b = NULL;
 
-    block_t *b = malloc (alloc);
-    if (unlikely(b == NULL))
+    if (cls >= 0)
+    {
+        capacity = block_pool_ClassSize(cls);
+        b = block_pool_Get(cls);
+        if (b == NULL)
+            atomic_fetch_add_explicit(&block_pool.misses, 1,
+                                      memory_order_relaxed);
+    }
+    else
+        atomic_fetch_add_explicit(&block_pool.unpooled, 1,
+                                  memory_order_relaxed);
+
+    const size_t alloc = sizeof (block_t) + BLOCK_EXTRA + capacity;
+    if (unlikely(alloc <= capacity))
         return NULL;
 
+    if (b == NULL)
+    {
+        b = malloc (alloc);
+        if (unlikely(b == NULL))
+            return NULL;
+    }
+
     block_Init (b, b + 1, alloc - sizeof (*b));
     static_assert ((BLOCK_PADDING % BLOCK_ALIGN) == 0,
                    "BLOCK_PADDING must be a multiple of BLOCK_ALIGN");
     b->p_buffer += BLOCK_PADDING + BLOCK_ALIGN - 1;
     b->p_buffer = (void *)(((uintptr_t)b->p_buffer) & ~(BLOCK_ALIGN - 1));
     b->i_buffer = size;
-    b->pf_release = block_generic_Release;
+    b->pf_release = (cls >= 0) ? block_pool_Release : block_generic_Release;
     return b;
 }
 
@@ -178,10 +452,12 @@ block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
         p_block->i_buffer = i_body;
 
     size_t requested = i_prebody + i_body;
+    /* The payload of a shared block is never modified in place */
+    const bool b_shared = !block_IsWritable( p_block );
 
     if( p_block->i_buffer == 0 )
     {   /* Corner case: nothing to preserve */
-        if( requested <= p_block->i_size )
+        if( requested <= p_block->i_size && !b_shared )
         {   /* Enough room: recycle buffer */
             size_t extra = p_block->i_size - requested;
 
@@ -205,7 +481,8 @@ block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
 
     /* Second, reallocate the buffer if we lack space. */
     assert( i_prebody >= 0 );
-    if( (size_t)(p_block->p_buffer - p_start) < (size_t)i_prebody
+    if( b_shared
+     || (size_t)(p_block->p_buffer - p_start) < (size_t)i_prebody
      || (size_t)(p_end - p_block->p_buffer) < i_body )
     {
         block_t *p_rea = block_Alloc( requested );
@@ -244,6 +521,96 @@ block_t *block_Realloc (block_t *block, ssize_t prebody, size_t body)
     return rea;
 }
 
+/*****************************************************************************
+ * Shared blocks
+ *****************************************************************************
+ * The payload of shared blocks belongs to a hidden owner block, which is
+ * released along with the last shared block. Shared blocks only have their
+ * own header.
+ *****************************************************************************/
+typedef struct
+{
+    atomic_uint refs;
+    block_t    *owner;
+} block_payload_t;
+
+typedef struct
+{
+    block_t          self;
+    block_payload_t *payload;
+} block_shared_t;
+
+static void block_shared_Release (block_t *block)
+{
+    block_shared_t *shared = (block_shared_t *)block;
+    block_payload_t *payload = shared->payload;
+
+    block_Invalidate (block);
+    if (atomic_fetch_sub_explicit (&payload->refs, 1,
+                                   memory_order_acq_rel) == 1)
+    {
+        block_Release (payload->owner);
+        free (payload);
+    }
+    free (shared);
+}
+
+static block_t *block_shared_New (const block_t *block,
+                                  block_payload_t *payload)
+{
+    block_shared_t *shared = malloc (sizeof (*shared));
+    if (unlikely(shared == NULL))
+        return NULL;
+
+    shared->self = *block;
+    shared->self.p_next = NULL;
+    shared->self.pf_release = block_shared_Release;
+    shared->payload = payload;
+    return &shared->self;
+}
+
+block_t *block_Share (block_t **pp_block)
+{
+    block_t *block = *pp_block;
+
+    block_Check (block);
+
+    if (block->pf_release != block_shared_Release)
+    {   /* First share: hide the block behind a shared one */
+        block_payload_t *payload = malloc (sizeof (*payload));
+        if (unlikely(payload == NULL))
+            return NULL;
+
+        block_t *first = block_shared_New (block, payload);
+        if (unlikely(first == NULL))
+        {
+            free (payload);
+            return NULL;
+        }
+        first->p_next = block->p_next;
+        block->p_next = NULL;
+        atomic_init (&payload->refs, 1);
+        payload->owner = block;
+        *pp_block = block = first;
+    }
+
+    block_payload_t *payload = ((block_shared_t *)block)->payload;
+    block_t *dup = block_shared_New (block, payload);
+    if (likely(dup != NULL))
+        atomic_fetch_add_explicit (&payload->refs, 1, memory_order_relaxed);
+    return dup;
+}
+
+bool block_IsWritable (const block_t *block)
+{
+    if (block->pf_release != block_shared_Release)
+        return true;
+
+    const block_shared_t *shared = (const block_shared_t *)block;
+    return atomic_load_explicit (&shared->payload->refs,
+                                 memory_order_acquire) == 1;
+}
+
 static void block_heap_Release (block_t *block)
 {
     block_Invalidate (block);
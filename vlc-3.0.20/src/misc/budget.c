@@ -0,0 +1,122 @@
+/*****************************************************************************
+ * budget.c: memory budget of the input buffers
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_atomic.h>
+#include <vlc_memory.h>
+
+#include "libvlc.h"
+
+struct vlc_memory_budget
+{
+    size_t limit;
+    atomic_size_t used; /**< sum of the registered users sizes */
+};
+
+struct vlc_memory_user
+{
+    struct vlc_memory_budget *budget;
+    size_t limit; /**< share of the budget for the user priority */
+    size_t size;
+};
+
+struct vlc_memory_budget *vlc_memory_BudgetNew(size_t limit)
+{
+    struct vlc_memory_budget *budget = malloc(sizeof (*budget));
+    if (likely(budget != NULL))
+    {
+        budget->limit = limit;
+        atomic_init(&budget->used, 0);
+    }
+    return budget;
+}
+
+void vlc_memory_BudgetDelete(struct vlc_memory_budget *budget)
+{
+    assert(atomic_load(&budget->used) == 0);
+    free(budget);
+}
+
+#undef vlc_memory_Register
+vlc_memory_user_t *vlc_memory_Register(vlc_object_t *obj,
+                                       enum vlc_memory_priority priority)
+{
+    struct vlc_memory_budget *budget =
+        libvlc_priv(obj->obj.libvlc)->memory_budget;
+    if (budget == NULL)
+        return NULL;
+
+    vlc_memory_user_t *user = malloc(sizeof (*user));
+    if (unlikely(user == NULL))
+        return NULL; /* not accounted */
+
+    user->budget = budget;
+    user->size = 0;
+    switch (priority)
+    {
+        case VLC_MEMORY_LOW:
+            user->limit = budget->limit / 2;
+            break;
+        case VLC_MEMORY_NORMAL:
+            user->limit = budget->limit - budget->limit / 10;
+            break;
+        default:
+            user->limit = budget->limit;
+            break;
+    }
+    return user;
+}
+
+void vlc_memory_Unregister(vlc_memory_user_t *user)
+{
+    if (user == NULL)
+        return;
+
+    atomic_fetch_sub(&user->budget->used, user->size);
+    free(user);
+}
+
+void vlc_memory_Set(vlc_memory_user_t *user, size_t size)
+{
+    if (user == NULL || user->size == size)
+        return;
+
+    if (size > user->size)
+        atomic_fetch_add(&user->budget->used, size - user->size);
+    else
+        atomic_fetch_sub(&user->budget->used, user->size - size);
+    user->size = size;
+}
+
+bool vlc_memory_Allow(const vlc_memory_user_t *user, size_t extra)
+{
+    if (user == NULL)
+        return true;
+
+    size_t used = atomic_load(&user->budget->used);
+    return used <= user->limit && extra <= user->limit - used;
+}
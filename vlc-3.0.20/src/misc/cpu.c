@@ -334,3 +334,93 @@ void vlc_CPU_dump (vlc_object_t *obj)
         free(stream.ptr);
     }
 }
+
+static bool vlc_CPU_KernelSupported(const vlc_cpu_kernel_t *kernel)
+{
+    return (kernel->flags & ~vlc_CPU()) == 0;
+}
+
+/* Looks up the variant forced for a kernel kind, if any */
+static const vlc_cpu_kernel_t *vlc_CPU_KernelOverride(const char *kind,
+                                                      const vlc_cpu_kernel_t *tab,
+                                                      size_t count)
+{
+    const char *env = getenv("VLC_CPU_KERNELS");
+    if (env == NULL)
+        return NULL;
+
+    size_t kindlen = strlen(kind);
+
+    while (*env != '\0')
+    {
+        size_t len = strcspn(env, ",");
+        const char *eq = memchr(env, '=', len);
+
+        if (eq != NULL)
+        {
+            size_t keylen = eq - env;
+            const char *name = eq + 1;
+            size_t namelen = env + len - name;
+
+            if ((keylen == 1 && *env == '*')
+             || (keylen == kindlen && !strncmp(env, kind, keylen)))
+                for (size_t i = 0; i < count; i++)
+                    if (strlen(tab[i].name) == namelen
+                     && !strncmp(tab[i].name, name, namelen)
+                     && vlc_CPU_KernelSupported(&tab[i]))
+                        return &tab[i];
+        }
+
+        env += len;
+        if (*env == ',')
+            env++;
+    }
+    return NULL;
+}
+
+const void *vlc_CPU_SelectKernel(const char *kind,
+                                 const vlc_cpu_kernel_t *tab, size_t count)
+{
+    const vlc_cpu_kernel_t *kernel = vlc_CPU_KernelOverride(kind, tab, count);
+
+    for (size_t i = 0; kernel == NULL && i < count; i++)
+        if (vlc_CPU_KernelSupported(&tab[i]))
+            kernel = &tab[i];
+
+    return (kernel != NULL) ? kernel->impl : NULL;
+}
+
+static vlc_mutex_t decoder_threads_lock = VLC_STATIC_MUTEX;
+static uint64_t decoder_threads_weight = 0;
+
+/* Pictures of unknown or smaller sizes weigh as much as a SD picture */
+static uint64_t DecoderWeight(unsigned width, unsigned height)
+{
+    uint64_t pixels = (uint64_t)width * height;
+    return (pixels > 720 * 576) ? pixels : 720 * 576;
+}
+
+unsigned vlc_AcquireDecoderThreads(unsigned width, unsigned height)
+{
+    const uint64_t weight = DecoderWeight(width, height);
+    const unsigned count = vlc_GetCPUCount();
+
+    vlc_mutex_lock(&decoder_threads_lock);
+    decoder_threads_weight += weight;
+    uint64_t total = decoder_threads_weight;
+    vlc_mutex_unlock(&decoder_threads_lock);
+
+    /* Round to nearest */
+    unsigned threads = (count * weight + total / 2) / total;
+    return (threads > 0) ? threads : 1;
+}
+
+void vlc_ReleaseDecoderThreads(unsigned width, unsigned height)
+{
+    const uint64_t weight = DecoderWeight(width, height);
+
+    vlc_mutex_lock(&decoder_threads_lock);
+    assert(decoder_threads_weight >= weight);
+    decoder_threads_weight -= weight;
+    vlc_mutex_unlock(&decoder_threads_lock);
+}
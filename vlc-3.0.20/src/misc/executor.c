@@ -0,0 +1,150 @@
+/*****************************************************************************
+ * executor.c: shared pool of worker threads
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_threads.h>
+
+#include "libvlc.h"
+#include "executor.h"
+
+/* Time an idle worker thread waits for a task before exiting */
+#define EXECUTOR_IDLE_TIMEOUT INT64_C(5000000)
+
+struct vlc_executor
+{
+    vlc_mutex_t lock;
+    vlc_cond_t queue_wait; /**< wait for new tasks or termination */
+    vlc_cond_t done_wait; /**< wait for a thread to exit */
+
+    struct vlc_task *first; /**< pending tasks */
+    struct vlc_task **plast;
+    size_t queued; /**< number of pending tasks */
+
+    size_t threads; /**< number of worker threads */
+    size_t idle; /**< number of threads waiting for a task */
+    int priority;
+    bool terminate; /**< true if the threads shall exit */
+};
+
+static void *Thread(void *data)
+{
+    vlc_executor_t *executor = data;
+
+    vlc_affinity_Unpin();
+
+    vlc_mutex_lock(&executor->lock);
+    for (;;)
+    {
+        struct vlc_task *task = executor->first;
+
+        if (task == NULL)
+        {
+            if (executor->terminate)
+                break;
+
+            vlc_tick_t deadline = mdate() + EXECUTOR_IDLE_TIMEOUT;
+
+            executor->idle++;
+            int ret = vlc_cond_timedwait(&executor->queue_wait,
+                                         &executor->lock, deadline);
+            executor->idle--;
+
+            if (ret != 0 && executor->queued == 0)
+                break;
+            continue;
+        }
+
+        executor->first = task->next;
+        if (executor->first == NULL)
+            executor->plast = &executor->first;
+        executor->queued--;
+        vlc_mutex_unlock(&executor->lock);
+
+        /* The task may be destroyed by its own callback */
+        task->pf_run(task->opaque);
+
+        vlc_mutex_lock(&executor->lock);
+    }
+
+    executor->threads--;
+    vlc_cond_broadcast(&executor->done_wait);
+    vlc_mutex_unlock(&executor->lock);
+    return NULL;
+}
+
+vlc_executor_t *vlc_executor_New(int priority)
+{
+    vlc_executor_t *executor = malloc(sizeof (*executor));
+    if (unlikely(executor == NULL))
+        return NULL;
+
+    vlc_mutex_init(&executor->lock);
+    vlc_cond_init(&executor->queue_wait);
+    vlc_cond_init(&executor->done_wait);
+    executor->first = NULL;
+    executor->plast = &executor->first;
+    executor->queued = 0;
+    executor->threads = 0;
+    executor->idle = 0;
+    executor->priority = priority;
+    executor->terminate = false;
+    return executor;
+}
+
+void vlc_executor_Delete(vlc_executor_t *executor)
+{
+    vlc_mutex_lock(&executor->lock);
+    assert(executor->first == NULL);
+    executor->terminate = true;
+    vlc_cond_broadcast(&executor->queue_wait);
+    while (executor->threads > 0)
+        vlc_cond_wait(&executor->done_wait, &executor->lock);
+    vlc_mutex_unlock(&executor->lock);
+
+    vlc_cond_destroy(&executor->done_wait);
+    vlc_cond_destroy(&executor->queue_wait);
+    vlc_mutex_destroy(&executor->lock);
+    free(executor);
+}
+
+void vlc_executor_Submit(vlc_executor_t *executor, struct vlc_task *task)
+{
+    vlc_mutex_lock(&executor->lock);
+    assert(!executor->terminate);
+
+    task->next = NULL;
+    *executor->plast = task;
+    executor->plast = &task->next;
+    executor->queued++;
+
+    /* Tasks may wait for one another: never leave one behind a busy thread */
+    if (executor->idle < executor->queued
+     && vlc_clone_detach(NULL, Thread, executor, executor->priority) == 0)
+        executor->threads++;
+    vlc_cond_signal(&executor->queue_wait);
+    vlc_mutex_unlock(&executor->lock);
+}
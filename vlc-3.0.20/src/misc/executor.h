@@ -0,0 +1,62 @@
+/*****************************************************************************
+ * executor.h: shared pool of worker threads
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_EXECUTOR_H
+#define VLC_EXECUTOR_H
+
+/**
+ * Task run by an executor.
+ *
+ * The task is owned by the submitter. It must not be submitted again before
+ * its run callback has been called.
+ */
+struct vlc_task
+{
+    void (*pf_run)(void *opaque);
+    void *opaque;
+    struct vlc_task *next; /**< private to the executor */
+};
+
+typedef struct vlc_executor vlc_executor_t;
+
+/**
+ * Creates an executor.
+ *
+ * Worker threads are spawned on demand: a submitted task never waits for
+ * another task to complete, so tasks may block on each other. Threads exit
+ * after being idle for a while, hence an idle executor holds no threads.
+ *
+ * \param priority priority of the worker threads
+ */
+vlc_executor_t *vlc_executor_New(int priority) VLC_USED;
+
+/**
+ * Waits for the worker threads to exit and destroys the executor.
+ *
+ * All the submitted tasks must have been run.
+ */
+void vlc_executor_Delete(vlc_executor_t *);
+
+/**
+ * Queues a task for execution on a worker thread.
+ */
+void vlc_executor_Submit(vlc_executor_t *, struct vlc_task *);
+
+#endif
@@ -30,8 +30,12 @@
 
 #include <vlc_common.h>
 #include <vlc_block.h>
+#include <vlc_atomic.h>
 #include "libvlc.h"
 
+/** Ring capacity of single producer single consumer FIFOs (power of two) */
+#define FIFO_RING_SIZE 1024
+
 /**
  * Internal state for block queues
  */
@@ -44,6 +48,19 @@ struct block_fifo_t
     block_t             **pp_last;
     size_t              i_depth;
     size_t              i_size;
+
+    /* Single producer single consumer FIFOs only. Blocks are queued in a
+     * lock-free ring, and only spill to the locked list above when the ring
+     * is full. The list is then consumed after the ring, and the producer
+     * keeps using the list until it gets drained, which preserves ordering.
+     * The counters may briefly go negative, as the consumer can dequeue a
+     * block before the producer accounted for it. */
+    block_t             **ring;
+    atomic_size_t       ring_head; /**< written by the consumer only */
+    atomic_size_t       ring_tail; /**< written by the producer only */
+    bool                ring_overflow; /**< producer private */
+    atomic_intptr_t     depth;
+    atomic_intptr_t     size;
 };
 
 void vlc_fifo_Lock(vlc_fifo_t *fifo)
@@ -78,17 +95,128 @@ int vlc_fifo_TimedWaitCond(vlc_fifo_t *fifo, vlc_cond_t *condvar, vlc_tick_t dea
 
 size_t vlc_fifo_GetCount(const vlc_fifo_t *fifo)
 {
+    if (fifo->ring != NULL)
+    {
+        intptr_t depth = atomic_load_explicit(&fifo->depth,
+                                              memory_order_relaxed);
+        return (depth > 0) ? depth : 0;
+    }
     return fifo->i_depth;
 }
 
 size_t vlc_fifo_GetBytes(const vlc_fifo_t *fifo)
 {
+    if (fifo->ring != NULL)
+    {
+        intptr_t size = atomic_load_explicit(&fifo->size,
+                                             memory_order_relaxed);
+        return (size > 0) ? size : 0;
+    }
     return fifo->i_size;
 }
 
+/** Accounts for dequeued blocks of a single producer single consumer FIFO */
+static void vlc_fifo_RingSub(vlc_fifo_t *fifo, size_t depth, size_t size)
+{
+    atomic_fetch_sub(&fifo->depth, depth);
+    atomic_fetch_sub_explicit(&fifo->size, size, memory_order_relaxed);
+}
+
+/** Queues a block into the ring, unless it is full or overflowing */
+static bool vlc_fifo_RingPush(vlc_fifo_t *fifo, block_t *block)
+{
+    size_t tail = atomic_load_explicit(&fifo->ring_tail,
+                                       memory_order_relaxed);
+    size_t head = atomic_load_explicit(&fifo->ring_head,
+                                       memory_order_acquire);
+
+    if (fifo->ring_overflow || tail - head >= FIFO_RING_SIZE)
+        return false;
+
+    fifo->ring[tail & (FIFO_RING_SIZE - 1)] = block;
+    /* Sequentially consistent, so that the producer cannot miss a dequeue
+     * from the consumer when checking whether the FIFO was empty and vice
+     * versa (see vlc_fifo_RingQueue()). */
+    atomic_store(&fifo->ring_tail, tail + 1);
+    return true;
+}
+
+/**
+ * Queues blocks into a single producer single consumer FIFO.
+ *
+ * \param locked whether the calling thread holds the FIFO lock
+ */
+static void vlc_fifo_RingQueue(vlc_fifo_t *fifo, block_t *block, bool locked)
+{
+    size_t depth = 0, size = 0;
+
+    while (block != NULL)
+    {
+        block_t *next = block->p_next;
+
+        block->p_next = NULL;
+        depth++;
+        size += block->i_buffer;
+
+        if (!vlc_fifo_RingPush(fifo, block))
+        {
+            if (!locked)
+                vlc_mutex_lock(&fifo->lock);
+
+            bool queued = false;
+
+            if (fifo->ring_overflow && fifo->p_first == NULL)
+            {   /* The consumer drained the list, hence the ring before it */
+                fifo->ring_overflow = false;
+                queued = vlc_fifo_RingPush(fifo, block);
+            }
+
+            if (!queued)
+            {   /* Use the list, in order, until it gets drained */
+                fifo->ring_overflow = true;
+                *(fifo->pp_last) = block;
+                fifo->pp_last = &block->p_next;
+            }
+
+            if (!locked)
+                vlc_mutex_unlock(&fifo->lock);
+        }
+        block = next;
+    }
+
+    /* Account for the blocks only after they are visible to the consumer:
+     * if the FIFO was empty, the consumer has seen all older blocks and
+     * might be waiting for these ones. Otherwise, it has yet to dequeue an
+     * older block, and will find the new ones without waiting. */
+    atomic_fetch_add_explicit(&fifo->size, size, memory_order_relaxed);
+    if (atomic_fetch_add(&fifo->depth, depth) <= 0 && depth > 0)
+    {
+        if (!locked)
+            vlc_mutex_lock(&fifo->lock);
+        vlc_fifo_Signal(fifo);
+        if (!locked)
+            vlc_mutex_unlock(&fifo->lock);
+    }
+}
+
+void vlc_fifo_Queue(vlc_fifo_t *fifo, block_t *block)
+{
+    if (fifo->ring != NULL)
+        vlc_fifo_RingQueue(fifo, block, false);
+    else
+        block_FifoPut(fifo, block);
+}
+
 void vlc_fifo_QueueUnlocked(block_fifo_t *fifo, block_t *block)
 {
     vlc_assert_locked(&fifo->lock);
+
+    if (fifo->ring != NULL)
+    {
+        vlc_fifo_RingQueue(fifo, block, true);
+        return;
+    }
+
     assert(*(fifo->pp_last) == NULL);
 
     *(fifo->pp_last) = block;
@@ -105,10 +233,41 @@ void vlc_fifo_QueueUnlocked(block_fifo_t *fifo, block_t *block)
     vlc_fifo_Signal(fifo);
 }
 
+/** Dequeues the oldest block of the ring, if any */
+static block_t *vlc_fifo_RingDequeue(vlc_fifo_t *fifo)
+{
+    size_t head = atomic_load_explicit(&fifo->ring_head,
+                                       memory_order_relaxed);
+    size_t tail = atomic_load(&fifo->ring_tail);
+
+    if (head == tail)
+        return NULL;
+
+    block_t *block = fifo->ring[head & (FIFO_RING_SIZE - 1)];
+    atomic_store_explicit(&fifo->ring_head, head + 1, memory_order_release);
+    return block;
+}
+
 block_t *vlc_fifo_DequeueUnlocked(block_fifo_t *fifo)
 {
     vlc_assert_locked(&fifo->lock);
 
+    if (fifo->ring != NULL)
+    {
+        block_t *block = vlc_fifo_RingDequeue(fifo);
+
+        if (block == NULL && (block = fifo->p_first) != NULL)
+        {
+            fifo->p_first = block->p_next;
+            if (block->p_next == NULL)
+                fifo->pp_last = &fifo->p_first;
+            block->p_next = NULL;
+        }
+        if (block != NULL)
+            vlc_fifo_RingSub(fifo, 1, block->i_buffer);
+        return block;
+    }
+
     block_t *block = fifo->p_first;
 
     if (block == NULL)
@@ -131,6 +290,32 @@ block_t *vlc_fifo_DequeueAllUnlocked(block_fifo_t *fifo)
 {
     vlc_assert_locked(&fifo->lock);
 
+    if (fifo->ring != NULL)
+    {
+        block_t *list = NULL, **pp = &list, *block;
+        size_t depth = 0, size = 0;
+
+        while ((block = vlc_fifo_RingDequeue(fifo)) != NULL)
+        {
+            depth++;
+            size += block->i_buffer;
+            *pp = block;
+            pp = &block->p_next;
+        }
+
+        *pp = fifo->p_first;
+        for (block = fifo->p_first; block != NULL; block = block->p_next)
+        {
+            depth++;
+            size += block->i_buffer;
+        }
+        fifo->p_first = NULL;
+        fifo->pp_last = &fifo->p_first;
+
+        vlc_fifo_RingSub(fifo, depth, size);
+        return list;
+    }
+
     block_t *block = fifo->p_first;
 
     fifo->p_first = NULL;
@@ -152,12 +337,42 @@ block_fifo_t *block_FifoNew( void )
     p_fifo->p_first = NULL;
     p_fifo->pp_last = &p_fifo->p_first;
     p_fifo->i_depth = p_fifo->i_size = 0;
+    p_fifo->ring = NULL;
+
+    return p_fifo;
+}
+
+block_fifo_t *block_FifoNewSPSC( void )
+{
+    block_fifo_t *p_fifo = block_FifoNew();
+    if( !p_fifo )
+        return NULL;
+
+    p_fifo->ring = malloc( FIFO_RING_SIZE * sizeof (*p_fifo->ring) );
+    if( !p_fifo->ring )
+    {
+        block_FifoRelease( p_fifo );
+        return NULL;
+    }
+    atomic_init( &p_fifo->ring_head, 0 );
+    atomic_init( &p_fifo->ring_tail, 0 );
+    p_fifo->ring_overflow = false;
+    atomic_init( &p_fifo->depth, 0 );
+    atomic_init( &p_fifo->size, 0 );
 
     return p_fifo;
 }
 
 void block_FifoRelease( block_fifo_t *p_fifo )
 {
+    if( p_fifo->ring != NULL )
+    {
+        block_t *b;
+
+        while( (b = vlc_fifo_RingDequeue( p_fifo )) != NULL )
+            block_Release( b );
+        free( p_fifo->ring );
+    }
     block_ChainRelease( p_fifo->p_first );
     vlc_cond_destroy( &p_fifo->wait );
     vlc_mutex_destroy( &p_fifo->lock );
@@ -205,6 +420,19 @@ block_t *block_FifoShow( block_fifo_t *p_fifo )
     block_t *b;
 
     vlc_mutex_lock( &p_fifo->lock );
+    if( p_fifo->ring != NULL )
+    {
+        size_t head = atomic_load_explicit( &p_fifo->ring_head,
+                                            memory_order_relaxed );
+        size_t tail = atomic_load_explicit( &p_fifo->ring_tail,
+                                            memory_order_acquire );
+        if( head != tail )
+        {
+            b = p_fifo->ring[head & (FIFO_RING_SIZE - 1)];
+            vlc_mutex_unlock( &p_fifo->lock );
+            return b;
+        }
+    }
     assert(p_fifo->p_first != NULL);
     b = p_fifo->p_first;
     vlc_mutex_unlock( &p_fifo->lock );
@@ -218,7 +446,7 @@ size_t block_FifoSize (block_fifo_t *fifo)
     size_t size;
 
     vlc_mutex_lock (&fifo->lock);
-    size = fifo->i_size;
+    size = vlc_fifo_GetBytes (fifo);
     vlc_mutex_unlock (&fifo->lock);
     return size;
 }
@@ -229,7 +457,7 @@ size_t block_FifoCount (block_fifo_t *fifo)
     size_t depth;
 
     vlc_mutex_lock (&fifo->lock);
-    depth = fifo->i_depth;
+    depth = vlc_fifo_GetCount (fifo);
     vlc_mutex_unlock (&fifo->lock);
     return depth;
 }
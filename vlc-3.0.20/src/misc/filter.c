@@ -183,6 +183,177 @@ void filter_DeleteBlend( filter_t *p_blend )
     vlc_object_release( p_blend );
 }
 
+/* Slice threads, shared by all the filters */
+#define SLICE_THREADS_MAX 15
+
+struct filter_slice_job
+{
+    filter_t *p_filter;
+    void (*pf_slice)( filter_t *, void *, unsigned, unsigned );
+    void *p_data;
+    unsigned i_lines;
+    unsigned i_band;
+    unsigned i_next;    /* first line of the next band to run */
+    unsigned i_pending; /* bands not completed yet */
+    struct filter_slice_job *p_next;
+};
+
+static struct
+{
+    vlc_mutex_t lock;   /* protects the jobs and the exit flag */
+    vlc_cond_t  wait;   /* signaled when a job is queued or on exit */
+    vlc_cond_t  done;   /* signaled when a job is completed */
+    struct filter_slice_job *p_jobs;
+    bool b_exit;
+
+    vlc_mutex_t hold_lock; /* protects the references and the threads */
+    unsigned i_refs;
+    unsigned i_threads;
+    vlc_thread_t threads[SLICE_THREADS_MAX];
+} slices = {
+    .lock = VLC_STATIC_MUTEX,
+    .wait = VLC_STATIC_COND,
+    .done = VLC_STATIC_COND,
+    .hold_lock = VLC_STATIC_MUTEX,
+};
+
+/* Runs the next band of a job, called and returning with the lock held */
+static void SliceRunNext( struct filter_slice_job *p_job )
+{
+    const unsigned i_first = p_job->i_next;
+    const unsigned i_count = __MIN( p_job->i_band, p_job->i_lines - i_first );
+
+    p_job->i_next += i_count;
+    if( p_job->i_next >= p_job->i_lines )
+    {
+        /* Last band: nothing left to pick up for the other threads */
+        struct filter_slice_job **pp_job = &slices.p_jobs;
+        while( *pp_job != p_job )
+            pp_job = &(*pp_job)->p_next;
+        *pp_job = p_job->p_next;
+    }
+
+    vlc_mutex_unlock( &slices.lock );
+    p_job->pf_slice( p_job->p_filter, p_job->p_data, i_first, i_count );
+    vlc_mutex_lock( &slices.lock );
+
+    if( --p_job->i_pending == 0 )
+        vlc_cond_broadcast( &slices.done );
+}
+
+static void *SliceThread( void *p_data )
+{
+    VLC_UNUSED( p_data );
+
+    vlc_affinity_Unpin();
+
+    vlc_mutex_lock( &slices.lock );
+    for( ;; )
+    {
+        while( slices.p_jobs == NULL && !slices.b_exit )
+            vlc_cond_wait( &slices.wait, &slices.lock );
+        if( slices.p_jobs == NULL )
+            break;
+        SliceRunNext( slices.p_jobs );
+    }
+    vlc_mutex_unlock( &slices.lock );
+    return NULL;
+}
+
+unsigned filter_HoldSlices( filter_t *p_filter )
+{
+    vlc_mutex_lock( &slices.hold_lock );
+    if( slices.i_refs++ == 0 )
+    {
+        unsigned i_count = vlc_GetCPUCount();
+        i_count = __MIN( i_count > 0 ? i_count - 1 : 0, SLICE_THREADS_MAX );
+
+        while( slices.i_threads < i_count
+            && vlc_clone( &slices.threads[slices.i_threads], SliceThread, NULL,
+                          VLC_THREAD_PRIORITY_VIDEO ) == 0 )
+            slices.i_threads++;
+
+        msg_Dbg( p_filter, "using %u slice threads", slices.i_threads );
+    }
+    const unsigned i_bands = 1 + slices.i_threads;
+    vlc_mutex_unlock( &slices.hold_lock );
+
+    return i_bands;
+}
+
+void filter_ReleaseSlices( filter_t *p_filter )
+{
+    VLC_UNUSED( p_filter );
+
+    vlc_mutex_lock( &slices.hold_lock );
+    assert( slices.i_refs > 0 );
+    if( --slices.i_refs == 0 && slices.i_threads > 0 )
+    {
+        vlc_mutex_lock( &slices.lock );
+        slices.b_exit = true;
+        vlc_cond_broadcast( &slices.wait );
+        vlc_mutex_unlock( &slices.lock );
+
+        for( unsigned i = 0; i < slices.i_threads; i++ )
+            vlc_join( slices.threads[i], NULL );
+        slices.i_threads = 0;
+
+        vlc_mutex_lock( &slices.lock );
+        slices.b_exit = false;
+        vlc_mutex_unlock( &slices.lock );
+    }
+    vlc_mutex_unlock( &slices.hold_lock );
+}
+
+void filter_RunSlices( filter_t *p_filter, unsigned i_lines, unsigned i_align,
+                       void (*pf_slice)( filter_t *, void *, unsigned, unsigned ),
+                       void *p_data )
+{
+    if( i_lines == 0 )
+        return;
+    if( i_align == 0 )
+        i_align = 1;
+
+    /* i_threads can only change once all the filters released the threads,
+     * so it is stable for the callers that hold them */
+    vlc_mutex_lock( &slices.lock );
+    const unsigned i_bands = slices.b_exit ? 1 : 1 + slices.i_threads;
+    vlc_mutex_unlock( &slices.lock );
+
+    unsigned i_band = ( i_lines + i_bands - 1 ) / i_bands;
+    i_band = ( i_band + i_align - 1 ) / i_align * i_align;
+    if( i_band >= i_lines )
+    {
+        pf_slice( p_filter, p_data, 0, i_lines );
+        return;
+    }
+
+    struct filter_slice_job job = {
+        .p_filter = p_filter,
+        .pf_slice = pf_slice,
+        .p_data = p_data,
+        .i_lines = i_lines,
+        .i_band = i_band,
+        .i_next = 0,
+        .i_pending = ( i_lines + i_band - 1 ) / i_band,
+        .p_next = NULL,
+    };
+
+    vlc_mutex_lock( &slices.lock );
+    struct filter_slice_job **pp_job = &slices.p_jobs;
+    while( *pp_job != NULL )
+        pp_job = &(*pp_job)->p_next;
+    *pp_job = &job;
+    vlc_cond_broadcast( &slices.wait );
+
+    /* Take part in the work, then wait for the bands run by the threads */
+    while( job.i_next < job.i_lines )
+        SliceRunNext( &job );
+    while( job.i_pending > 0 )
+        vlc_cond_wait( &slices.done, &slices.lock );
+    vlc_mutex_unlock( &slices.lock );
+}
+
 /* */
 #include <vlc_video_splitter.h>
 
@@ -162,6 +162,11 @@ static picture_t *ImageRead( image_handler_t *p_image, block_t *p_block,
         p_image->p_dec->p_queue_ctx = p_image;
     }
 
+    /* Decoders that can directly output a smaller picture may do so: it will
+     * be converted to the requested size anyway */
+    var_SetInteger( p_image->p_dec, "image-decode-width", p_fmt_out->i_width );
+    var_SetInteger( p_image->p_dec, "image-decode-height", p_fmt_out->i_height );
+
     p_block->i_pts = p_block->i_dts = mdate();
     int ret = p_image->p_dec->pf_decode( p_image->p_dec, p_block );
     if( ret == VLCDEC_SUCCESS )
@@ -684,6 +689,9 @@ static decoder_t *CreateDecoder( vlc_object_t *p_this, const video_format_t *fmt
     p_dec->pf_vout_format_update = video_update_format;
     p_dec->pf_vout_buffer_new = video_new_buffer;
 
+    var_Create( p_dec, "image-decode-width", VLC_VAR_INTEGER );
+    var_Create( p_dec, "image-decode-height", VLC_VAR_INTEGER );
+
     /* Find a suitable decoder module */
     p_dec->p_module = module_need( p_dec, "video decoder", "$codec", false );
     if( !p_dec->p_module )
@@ -41,8 +41,11 @@
 #include <vlc_interface.h>
 #include <vlc_charset.h>
 #include <vlc_modules.h>
+#include <vlc_atomic.h>
 #include "../libvlc.h"
 
+typedef struct vlc_log_async_t vlc_log_async_t;
+
 struct vlc_logger_t
 {
     VLC_COMMON_MEMBERS
@@ -50,8 +53,12 @@ struct vlc_logger_t
     vlc_log_cb log;
     void *sys;
     module_t *module;
+    vlc_log_async_t *async;
 };
 
+static void vlc_LogAsyncPush(vlc_log_async_t *, int, const vlc_log_t *,
+                             const char *, va_list);
+
 static void vlc_vaLogCallback(libvlc_int_t *vlc, int type,
                               const vlc_log_t *item, const char *format,
                               va_list ap)
@@ -62,7 +69,10 @@ static void vlc_vaLogCallback(libvlc_int_t *vlc, int type,
     assert(logger != NULL);
     canc = vlc_savecancel();
     vlc_rwlock_rdlock(&logger->lock);
-    logger->log(logger->sys, type, item, format, ap);
+    if (logger->async != NULL)
+        vlc_LogAsyncPush(logger->async, type, item, format, ap);
+    else
+        logger->log(logger->sys, type, item, format, ap);
     vlc_rwlock_unlock(&logger->lock);
     vlc_restorecancel(canc);
 }
@@ -286,6 +296,186 @@ static void vlc_LogEarlyClose(vlc_logger_t *logger, void *d)
     free(sys);
 }
 
+/*
+ * Asynchronous logging.
+ *
+ * Messages are formatted by the emitting thread into a slot of a bounded
+ * lock-free queue (a multiple producers ring with per-slot sequence numbers)
+ * and a dedicated thread passes them on to the log callback. If the queue is
+ * full, messages are dropped and counted, instead of blocking the emitter.
+ */
+#define LOG_ASYNC_SLOTS 1024 /* must be a power of two */
+
+typedef struct
+{
+    atomic_size_t seq;
+    int type;
+    vlc_log_t meta;
+    char module[32];
+    char header[64];
+    char msg[384];
+} vlc_log_slot_t;
+
+struct vlc_log_async_t
+{
+    vlc_logger_t *logger;
+    vlc_thread_t thread;
+    vlc_sem_t ready;
+    atomic_bool stop;
+    atomic_size_t head;
+    size_t tail; /* logger thread only */
+    atomic_uint dropped;
+    vlc_log_slot_t slots[LOG_ASYNC_SLOTS];
+};
+
+static void vlc_LogAsyncPush(vlc_log_async_t *async, int type,
+                             const vlc_log_t *item, const char *format,
+                             va_list ap)
+{
+    size_t pos = atomic_load_explicit(&async->head, memory_order_relaxed);
+    vlc_log_slot_t *slot;
+
+    for (;;)
+    {
+        slot = &async->slots[pos % LOG_ASYNC_SLOTS];
+
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        ptrdiff_t diff = (ptrdiff_t)(seq - pos);
+
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&async->head, &pos,
+                                                      pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {   /* Queue full */
+            atomic_fetch_add_explicit(&async->dropped, 1,
+                                      memory_order_relaxed);
+            return;
+        }
+        else
+            pos = atomic_load_explicit(&async->head, memory_order_relaxed);
+    }
+
+    slot->type = type;
+    slot->meta = *item;
+    if (item->psz_module != NULL)
+    {
+        strlcpy(slot->module, item->psz_module, sizeof (slot->module));
+        slot->meta.psz_module = slot->module;
+    }
+    if (item->psz_header != NULL)
+    {
+        strlcpy(slot->header, item->psz_header, sizeof (slot->header));
+        slot->meta.psz_header = slot->header;
+    }
+    vsnprintf(slot->msg, sizeof (slot->msg), format, ap);
+
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    vlc_sem_post(&async->ready);
+}
+
+static void vlc_LogAsyncOutput(vlc_logger_t *logger, int type,
+                               const vlc_log_t *item, const char *format, ...)
+{
+    va_list ap;
+
+    va_start(ap, format);
+    vlc_rwlock_rdlock(&logger->lock);
+    logger->log(logger->sys, type, item, format, ap);
+    vlc_rwlock_unlock(&logger->lock);
+    va_end(ap);
+}
+
+static void *vlc_LogAsyncThread(void *data)
+{
+    vlc_log_async_t *async = data;
+    vlc_logger_t *logger = async->logger;
+
+    for (;;)
+    {
+        vlc_sem_wait(&async->ready);
+
+        /* Output all the published messages in order. If the next one is
+         * still being written, its emitter will wake this thread again. */
+        for (;;)
+        {
+            vlc_log_slot_t *slot = &async->slots[async->tail % LOG_ASYNC_SLOTS];
+
+            if (atomic_load_explicit(&slot->seq, memory_order_acquire)
+                                                         != async->tail + 1)
+                break;
+
+            vlc_LogAsyncOutput(logger, slot->type, &slot->meta, "%s",
+                               slot->msg);
+            atomic_store_explicit(&slot->seq, async->tail + LOG_ASYNC_SLOTS,
+                                  memory_order_release);
+            async->tail++;
+        }
+
+        unsigned dropped = atomic_exchange_explicit(&async->dropped, 0,
+                                                    memory_order_relaxed);
+        if (dropped > 0)
+        {
+            const vlc_log_t meta = {
+                .i_object_id = (uintptr_t)logger,
+                .psz_object_type = "logger",
+                .psz_module = "core",
+                .line = -1,
+                .tid = vlc_thread_id(),
+            };
+
+            vlc_LogAsyncOutput(logger, VLC_MSG_WARN, &meta,
+                               "%u log messages dropped", dropped);
+        }
+
+        if (atomic_load_explicit(&async->stop, memory_order_acquire))
+            break;
+    }
+    return NULL;
+}
+
+static vlc_log_async_t *vlc_LogAsyncStart(vlc_logger_t *logger)
+{
+    vlc_log_async_t *async = malloc(sizeof (*async));
+    if (unlikely(async == NULL))
+        return NULL;
+
+    async->logger = logger;
+    vlc_sem_init(&async->ready, 0);
+    atomic_init(&async->stop, false);
+    atomic_init(&async->head, 0);
+    async->tail = 0;
+    atomic_init(&async->dropped, 0);
+    for (size_t i = 0; i < LOG_ASYNC_SLOTS; i++)
+        atomic_init(&async->slots[i].seq, i);
+
+    if (vlc_clone(&async->thread, vlc_LogAsyncThread, async,
+                  VLC_THREAD_PRIORITY_LOW))
+    {
+        vlc_sem_destroy(&async->ready);
+        free(async);
+        return NULL;
+    }
+    return async;
+}
+
+/**
+ * Stops the logger thread, once all queued messages have been output.
+ * No messages must be queued anymore.
+ */
+static void vlc_LogAsyncStop(vlc_log_async_t *async)
+{
+    atomic_store_explicit(&async->stop, true, memory_order_release);
+    vlc_sem_post(&async->ready);
+    vlc_join(async->thread, NULL);
+    vlc_sem_destroy(&async->ready);
+    free(async);
+}
+
 static void vlc_vaLogDiscard(void *d, int type, const vlc_log_t *item,
                              const char *format, va_list ap)
 {
@@ -330,6 +520,7 @@ int vlc_LogPreinit(libvlc_int_t *vlc)
         return -1;
 
     vlc_rwlock_init(&logger->lock);
+    logger->async = NULL;
 
     if (vlc_LogEarlyOpen(logger))
     {
@@ -359,6 +550,7 @@ int vlc_LogInit(libvlc_int_t *vlc)
 
     vlc_log_cb cb;
     void *sys, *early_sys = NULL;
+    vlc_log_async_t *async = NULL;
 
     /* TODO: module configuration item */
     module_t *module = vlc_module_load(logger, "logger", NULL, false,
@@ -366,6 +558,9 @@ int vlc_LogInit(libvlc_int_t *vlc)
     if (module == NULL)
         cb = vlc_vaLogDiscard;
 
+    if (var_InheritBool(vlc, "log-async"))
+        async = vlc_LogAsyncStart(logger);
+
     vlc_rwlock_wrlock(&logger->lock);
     if (logger->log == vlc_vaLogEarly)
         early_sys = logger->sys;
@@ -374,6 +569,7 @@ int vlc_LogInit(libvlc_int_t *vlc)
     logger->sys = sys;
     assert(logger->module == NULL); /* Only one call to vlc_LogInit()! */
     logger->module = module;
+    logger->async = async;
     vlc_rwlock_unlock(&logger->lock);
 
     if (early_sys != NULL)
@@ -426,6 +622,15 @@ void vlc_LogDeinit(libvlc_int_t *vlc)
     if (unlikely(logger == NULL))
         return;
 
+    /* Output the pending messages and go back to synchronous logging */
+    vlc_rwlock_wrlock(&logger->lock);
+    vlc_log_async_t *async = logger->async;
+    logger->async = NULL;
+    vlc_rwlock_unlock(&logger->lock);
+
+    if (async != NULL)
+        vlc_LogAsyncStop(async);
+
     if (logger->module != NULL)
         vlc_module_unload(vlc, logger->module, vlc_logger_unload, logger->sys);
     else
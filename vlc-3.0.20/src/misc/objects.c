@@ -191,7 +191,9 @@ void *vlc_custom_create (vlc_object_t *parent, size_t length,
     if (unlikely(priv == NULL))
         return NULL;
     priv->psz_name = NULL;
-    priv->var_root = NULL;
+    priv->var_table = NULL;
+    priv->var_count = 0;
+    priv->var_mask = 0;
     vlc_mutex_init (&priv->var_lock);
     vlc_cond_init (&priv->var_wait);
     atomic_init (&priv->refs, 1);
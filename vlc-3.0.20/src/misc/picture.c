@@ -32,6 +32,9 @@
 # include "config.h"
 #endif
 #include <assert.h>
+#ifdef __linux__
+# include <sys/mman.h>
+#endif
 
 #include <vlc_common.h>
 #include "picture.h"
@@ -39,6 +42,9 @@
 #include <vlc_block.h>
 
 #define PICTURE_SW_SIZE_MAX (1<<28) /* 256MB: 8K * 8K * 4*/
+#ifdef MADV_HUGEPAGE
+# define PICTURE_HUGE_PAGE_SIZE (1<<21) /* 2MB: x86 and ARM64 huge pages */
+#endif
 
 /**
  * Allocate a new picture in the heap.
@@ -71,13 +77,30 @@ static int AllocatePicture( picture_t *p_pic )
     }
 
     i_bytes = (i_bytes + 63) & ~63; /* must be a multiple of 64 */
-    uint8_t *p_data = aligned_alloc( 64, i_bytes );
+
+    size_t i_align = 64;
+#ifdef PICTURE_HUGE_PAGE_SIZE
+    /* Large pictures (1080p and above) are aligned on huge pages to cut the
+     * TLB misses of the decoders and filters walking through them. */
+    if( i_bytes >= PICTURE_HUGE_PAGE_SIZE )
+        i_align = PICTURE_HUGE_PAGE_SIZE;
+#endif
+
+    uint8_t *p_data = aligned_alloc( i_align, i_bytes );
     if( i_bytes > 0 && p_data == NULL )
     {
         p_pic->i_planes = 0;
         return VLC_EGENERIC;
     }
 
+#ifdef PICTURE_HUGE_PAGE_SIZE
+    /* The pixels are not touched here, so that the pages get placed on the
+     * NUMA node of the thread that first writes them, usually the decoder. */
+    if( i_align == PICTURE_HUGE_PAGE_SIZE )
+        madvise( p_data, i_bytes & ~(PICTURE_HUGE_PAGE_SIZE - 1),
+                 MADV_HUGEPAGE );
+#endif
+
     /* Fill the p_pixels field for each plane */
     p_pic->p[0].p_pixels = p_data;
     for( int i = 1; i < p_pic->i_planes; i++ )
@@ -131,6 +154,7 @@ void picture_Reset( picture_t *p_picture )
     /* */
     p_picture->date = VLC_TICK_INVALID;
     p_picture->b_force = false;
+    p_picture->ingest = VLC_TICK_INVALID;
     p_picture->b_progressive = false;
     p_picture->i_nb_fields = 2;
     p_picture->b_top_field_first = false;
@@ -359,6 +383,7 @@ void picture_CopyProperties( picture_t *p_dst, const picture_t *p_src )
 {
     p_dst->date = p_src->date;
     p_dst->b_force = p_src->b_force;
+    p_dst->ingest = p_src->ingest;
 
     p_dst->b_progressive = p_src->b_progressive;
     p_dst->i_nb_fields = p_src->i_nb_fields;
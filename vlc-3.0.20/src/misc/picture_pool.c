@@ -34,9 +34,13 @@
 #include <vlc_atomic.h>
 #include "picture.h"
 
-#define POOL_MAX (CHAR_BIT * sizeof (unsigned long long))
+#define POOL_WORD_BITS (CHAR_BIT * sizeof (unsigned long long))
+#define POOL_MAX USHRT_MAX
 
-static_assert ((POOL_MAX & (POOL_MAX - 1)) == 0, "Not a power of two");
+struct picture_pool_slot {
+    picture_pool_t *pool;
+    picture_t      *picture;
+};
 
 struct picture_pool_t {
     int       (*pic_lock)(picture_t *);
@@ -44,11 +48,13 @@ struct picture_pool_t {
     vlc_mutex_t lock;
     vlc_cond_t  wait;
 
-    bool               canceled;
-    unsigned long long available;
-    atomic_ushort      refs;
+    atomic_bool        canceled;
+    atomic_uint        waiters;
+    atomic_uint        refs;
     unsigned short     picture_count;
-    picture_t  *picture[];
+    unsigned short     word_count;
+    atomic_ullong     *available;
+    struct picture_pool_slot slot[];
 };
 
 static void picture_pool_Destroy(picture_pool_t *pool)
@@ -58,23 +64,74 @@ static void picture_pool_Destroy(picture_pool_t *pool)
 
     vlc_cond_destroy(&pool->wait);
     vlc_mutex_destroy(&pool->lock);
-    aligned_free(pool);
+    free(pool);
 }
 
 void picture_pool_Release(picture_pool_t *pool)
 {
     for (unsigned i = 0; i < pool->picture_count; i++)
-        picture_Release(pool->picture[i]);
+        picture_Release(pool->slot[i].picture);
     picture_pool_Destroy(pool);
 }
 
+/**
+ * Takes the first available picture at or after a given offset.
+ *
+ * This is lock-free: the bit of the picture is cleared with a CAS, so that
+ * concurrent callers never get the same picture.
+ *
+ * \return the offset of the picture plus one, or zero if none is available
+ */
+static unsigned picture_pool_Take(picture_pool_t *pool, unsigned offset)
+{
+    for (unsigned w = offset / POOL_WORD_BITS; w < pool->word_count; w++)
+    {
+        unsigned long long mask = ~0ULL;
+        if (w == offset / POOL_WORD_BITS)
+            mask <<= offset % POOL_WORD_BITS;
+
+        unsigned long long bits = atomic_load(&pool->available[w]);
+
+        while ((bits & mask) != 0)
+        {
+            unsigned i = ffsll(bits & mask) - 1;
+
+            if (atomic_compare_exchange_weak(&pool->available[w], &bits,
+                                             bits & ~(1ULL << i)))
+                return w * POOL_WORD_BITS + i + 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Gives a picture back to the pool and wakes a waiter up if there is any.
+ */
+static void picture_pool_Put(picture_pool_t *pool, unsigned offset)
+{
+    unsigned long long bit = 1ULL << (offset % POOL_WORD_BITS);
+    unsigned long long prev =
+        atomic_fetch_or(&pool->available[offset / POOL_WORD_BITS], bit);
+
+    assert(!(prev & bit));
+    (void) prev;
+
+    /* Waiters register under the lock before they look for a picture, so
+     * either they see the bit set above, or the counter is seen here. */
+    if (atomic_load(&pool->waiters) > 0)
+    {
+        vlc_mutex_lock(&pool->lock);
+        vlc_cond_signal(&pool->wait);
+        vlc_mutex_unlock(&pool->lock);
+    }
+}
+
 static void picture_pool_ReleasePicture(picture_t *clone)
 {
     picture_priv_t *priv = (picture_priv_t *)clone;
-    uintptr_t sys = (uintptr_t)priv->gc.opaque;
-    picture_pool_t *pool = (void *)(sys & ~(POOL_MAX - 1));
-    unsigned offset = sys & (POOL_MAX - 1);
-    picture_t *picture = pool->picture[offset];
+    struct picture_pool_slot *slot = priv->gc.opaque;
+    picture_pool_t *pool = slot->pool;
+    picture_t *picture = slot->picture;
 
     free(clone);
 
@@ -82,20 +139,14 @@ static void picture_pool_ReleasePicture(picture_t *clone)
         pool->pic_unlock(picture);
     picture_Release(picture);
 
-    vlc_mutex_lock(&pool->lock);
-    assert(!(pool->available & (1ULL << offset)));
-    pool->available |= 1ULL << offset;
-    vlc_cond_signal(&pool->wait);
-    vlc_mutex_unlock(&pool->lock);
-
+    picture_pool_Put(pool, slot - pool->slot);
     picture_pool_Destroy(pool);
 }
 
 static picture_t *picture_pool_ClonePicture(picture_pool_t *pool,
                                             unsigned offset)
 {
-    picture_t *picture = pool->picture[offset];
-    uintptr_t sys = ((uintptr_t)pool) + offset;
+    picture_t *picture = pool->slot[offset].picture;
     picture_resource_t res = {
         .p_sys = picture->p_sys,
         .pf_destroy = picture_pool_ReleasePicture,
@@ -109,7 +160,7 @@ static picture_t *picture_pool_ClonePicture(picture_pool_t *pool,
 
     picture_t *clone = picture_NewFromResource(&picture->format, &res);
     if (likely(clone != NULL)) {
-        ((picture_priv_t *)clone)->gc.opaque = (void *)sys;
+        ((picture_priv_t *)clone)->gc.opaque = &pool->slot[offset];
         picture_Hold(picture);
     }
     return clone;
@@ -121,10 +172,13 @@ picture_pool_t *picture_pool_NewExtended(const picture_pool_configuration_t *cfg
         return NULL;
 
     picture_pool_t *pool;
-    size_t size = sizeof (*pool) + cfg->picture_count * sizeof (picture_t *);
+    unsigned words = (cfg->picture_count + POOL_WORD_BITS - 1)
+                     / POOL_WORD_BITS;
+    size_t size = sizeof (*pool)
+                + cfg->picture_count * sizeof (struct picture_pool_slot);
 
-    size += (-size) & (POOL_MAX - 1);
-    pool = aligned_alloc(POOL_MAX, size);
+    size += (-size) & (sizeof (atomic_ullong) - 1);
+    pool = malloc(size + words * sizeof (atomic_ullong));
     if (unlikely(pool == NULL))
         return NULL;
 
@@ -132,15 +186,24 @@ picture_pool_t *picture_pool_NewExtended(const picture_pool_configuration_t *cfg
     pool->pic_unlock = cfg->unlock;
     vlc_mutex_init(&pool->lock);
     vlc_cond_init(&pool->wait);
-    if (cfg->picture_count == POOL_MAX)
-        pool->available = ~0ULL;
-    else
-        pool->available = (1ULL << cfg->picture_count) - 1;
+    pool->available = (atomic_ullong *)(((char *)pool) + size);
+    for (unsigned w = 0; w < words; w++)
+    {
+        unsigned left = cfg->picture_count - w * POOL_WORD_BITS;
+
+        atomic_init(&pool->available[w], (left >= POOL_WORD_BITS)
+                                         ? ~0ULL : (1ULL << left) - 1);
+    }
     atomic_init(&pool->refs,  1);
+    atomic_init(&pool->waiters, 0);
     pool->picture_count = cfg->picture_count;
-    memcpy(pool->picture, cfg->picture,
-           cfg->picture_count * sizeof (picture_t *));
-    pool->canceled = false;
+    pool->word_count = words;
+    for (unsigned i = 0; i < cfg->picture_count; i++)
+    {
+        pool->slot[i].pool = pool;
+        pool->slot[i].picture = cfg->picture[i];
+    }
+    atomic_init(&pool->canceled, false);
     return pool;
 }
 
@@ -201,47 +264,35 @@ error:
     return NULL;
 }
 
-/** Find next (bit) set */
-static int fnsll(unsigned long long x, unsigned i)
+static picture_t *picture_pool_Acquire(picture_pool_t *pool, unsigned offset)
 {
-    if (i >= CHAR_BIT * sizeof (x))
-        return 0;
-    return ffsll(x & ~((1ULL << i) - 1));
+    picture_t *clone = picture_pool_ClonePicture(pool, offset);
+    if (clone != NULL) {
+        assert(clone->p_next == NULL);
+        atomic_fetch_add(&pool->refs, 1);
+    }
+    return clone;
 }
 
 picture_t *picture_pool_Get(picture_pool_t *pool)
 {
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load(&pool->refs) > 0);
 
-    if (pool->canceled)
-    {
-        vlc_mutex_unlock(&pool->lock);
+    if (atomic_load(&pool->canceled))
         return NULL;
-    }
 
-    for (unsigned i = ffsll(pool->available); i; i = fnsll(pool->available, i))
+    for (unsigned i = picture_pool_Take(pool, 0); i;
+         i = picture_pool_Take(pool, i))
     {
-        pool->available &= ~(1ULL << (i - 1));
-        vlc_mutex_unlock(&pool->lock);
-
-        picture_t *picture = pool->picture[i - 1];
+        picture_t *picture = pool->slot[i - 1].picture;
 
         if (pool->pic_lock != NULL && pool->pic_lock(picture) != VLC_SUCCESS) {
-            vlc_mutex_lock(&pool->lock);
-            pool->available |= 1ULL << (i - 1);
+            picture_pool_Put(pool, i - 1);
             continue;
         }
 
-        picture_t *clone = picture_pool_ClonePicture(pool, i - 1);
-        if (clone != NULL) {
-            assert(clone->p_next == NULL);
-            atomic_fetch_add(&pool->refs, 1);
-        }
-        return clone;
+        return picture_pool_Acquire(pool, i - 1);
     }
-
-    vlc_mutex_unlock(&pool->lock);
     return NULL;
 }
 
@@ -249,48 +300,44 @@ picture_t *picture_pool_Wait(picture_pool_t *pool)
 {
     unsigned i;
 
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load(&pool->refs) > 0);
 
-    while (pool->available == 0)
+    i = picture_pool_Take(pool, 0);
+    if (i == 0)
     {
-        if (pool->canceled)
+        vlc_mutex_lock(&pool->lock);
+        atomic_fetch_add(&pool->waiters, 1);
+
+        while ((i = picture_pool_Take(pool, 0)) == 0)
         {
-            vlc_mutex_unlock(&pool->lock);
-            return NULL;
+            if (atomic_load(&pool->canceled))
+                break;
+            vlc_cond_wait(&pool->wait, &pool->lock);
         }
-        vlc_cond_wait(&pool->wait, &pool->lock);
-    }
 
-    i = ffsll(pool->available);
-    assert(i > 0);
-    pool->available &= ~(1ULL << (i - 1));
-    vlc_mutex_unlock(&pool->lock);
+        atomic_fetch_sub(&pool->waiters, 1);
+        vlc_mutex_unlock(&pool->lock);
+
+        if (i == 0)
+            return NULL;
+    }
 
-    picture_t *picture = pool->picture[i - 1];
+    picture_t *picture = pool->slot[i - 1].picture;
 
     if (pool->pic_lock != NULL && pool->pic_lock(picture) != VLC_SUCCESS) {
-        vlc_mutex_lock(&pool->lock);
-        pool->available |= 1ULL << (i - 1);
-        vlc_cond_signal(&pool->wait);
-        vlc_mutex_unlock(&pool->lock);
+        picture_pool_Put(pool, i - 1);
         return NULL;
     }
 
-    picture_t *clone = picture_pool_ClonePicture(pool, i - 1);
-    if (clone != NULL) {
-        assert(clone->p_next == NULL);
-        atomic_fetch_add(&pool->refs, 1);
-    }
-    return clone;
+    return picture_pool_Acquire(pool, i - 1);
 }
 
 void picture_pool_Cancel(picture_pool_t *pool, bool canceled)
 {
     vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load(&pool->refs) > 0);
 
-    pool->canceled = canceled;
+    atomic_store(&pool->canceled, canceled);
     if (canceled)
         vlc_cond_broadcast(&pool->wait);
     vlc_mutex_unlock(&pool->lock);
@@ -305,9 +352,8 @@ bool picture_pool_OwnsPic(picture_pool_t *pool, picture_t *pic)
         priv = (picture_priv_t *)pic;
     }
 
-    uintptr_t sys = (uintptr_t)priv->gc.opaque;
-    picture_pool_t *picpool = (void *)(sys & ~(POOL_MAX - 1));
-    return pool == picpool;
+    const struct picture_pool_slot *slot = priv->gc.opaque;
+    return pool == slot->pool;
 }
 
 unsigned picture_pool_GetSize(const picture_pool_t *pool)
@@ -321,5 +367,5 @@ void picture_pool_Enum(picture_pool_t *pool, void (*cb)(void *, picture_t *),
     /* NOTE: So far, the pictures table cannot change after the pool is created
      * so there is no need to lock the pool mutex here. */
     for (unsigned i = 0; i < pool->picture_count; i++)
-        cb(opaque, pool->picture[i]);
+        cb(opaque, pool->slot[i].picture);
 }
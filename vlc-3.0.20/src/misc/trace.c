@@ -0,0 +1,219 @@
+/*****************************************************************************
+ * trace.c: trace events
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_atomic.h>
+#include <vlc_fs.h>
+#include <vlc_trace.h>
+#include "libvlc.h"
+
+#ifdef ENABLE_TRACE
+#define TRACE_EVENTS (1 << 18) /* for all threads: 10 MiB */
+
+struct vlc_trace_record
+{
+    mtime_t date;
+    const char *category;
+    const char *name;
+    unsigned long tid;
+    int type;
+};
+
+/* One buffer for all threads, so that short-lived threads cost nothing once
+ * they are gone. Slots are reserved with an atomic counter; once full, new
+ * events are dropped. */
+static struct
+{
+    vlc_mutex_t lock;
+    libvlc_int_t *owner; /* instance writing the trace file */
+    char *path;
+    struct vlc_trace_record *records;
+    atomic_size_t count; /* reserved slots, may exceed TRACE_EVENTS */
+    atomic_uint writers; /* threads between the enabled check and the store */
+} traces = { VLC_STATIC_MUTEX, NULL, NULL, NULL,
+             ATOMIC_VAR_INIT(0), ATOMIC_VAR_INIT(0) };
+
+static atomic_bool trace_enabled = ATOMIC_VAR_INIT(false);
+#endif
+
+void vlc_trace_event(int type, const char *category, const char *name)
+{
+#ifdef ENABLE_TRACE
+    if (!atomic_load_explicit(&trace_enabled, memory_order_relaxed))
+        return;
+
+    /* Deinit waits for the writers before it releases the records */
+    atomic_fetch_add(&traces.writers, 1);
+    if (likely(atomic_load(&trace_enabled)))
+    {
+        size_t slot = atomic_fetch_add_explicit(&traces.count, 1,
+                                                memory_order_relaxed);
+        if (slot < TRACE_EVENTS)
+        {
+            struct vlc_trace_record *rec = &traces.records[slot];
+
+            rec->date = mdate();
+            rec->category = category;
+            rec->name = name;
+            rec->tid = vlc_thread_id();
+            rec->type = type;
+        }
+    }
+    atomic_fetch_sub_explicit(&traces.writers, 1, memory_order_release);
+#else
+    VLC_UNUSED(type); VLC_UNUSED(category); VLC_UNUSED(name);
+#endif
+}
+
+#ifdef ENABLE_TRACE
+static void vlc_trace_WriteString(FILE *stream, const char *str)
+{
+    fputc('"', stream);
+    for (; *str != '\0'; str++)
+    {
+        if (*str == '"' || *str == '\\')
+            fputc('\\', stream);
+        if ((unsigned char)*str >= 0x20)
+            fputc(*str, stream);
+    }
+    fputc('"', stream);
+}
+
+static int vlc_trace_Write(FILE *stream,
+                           const struct vlc_trace_record *records,
+                           size_t count)
+{
+    static const char phases[] = { 'B', 'E', 'i' };
+    const char *sep = "";
+    size_t dropped = 0;
+
+    if (count > TRACE_EVENTS)
+    {
+        dropped = count - TRACE_EVENTS;
+        count = TRACE_EVENTS;
+    }
+
+    fputs("{\"traceEvents\":[", stream);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const struct vlc_trace_record *rec = &records[i];
+
+        fprintf(stream, "%s\n{\"name\":", sep);
+        vlc_trace_WriteString(stream, rec->name);
+        fputs(",\"cat\":", stream);
+        vlc_trace_WriteString(stream, rec->category);
+        fprintf(stream, ",\"ph\":\"%c\",\"ts\":%"PRId64",\"pid\":1,"
+                "\"tid\":%lu%s}", phases[rec->type], rec->date, rec->tid,
+                (rec->type == VLC_TRACE_INSTANT) ? ",\"s\":\"t\"" : "");
+        sep = ",";
+    }
+
+    fprintf(stream, "\n],\"displayTimeUnit\":\"ms\","
+            "\"otherData\":{\"dropped\":%zu}}\n", dropped);
+    return ferror(stream) ? -1 : 0;
+}
+#endif
+
+/**
+ * Starts recording trace events, if a trace file is configured.
+ */
+void vlc_trace_Init(libvlc_int_t *vlc)
+{
+#ifdef ENABLE_TRACE
+    char *path = var_InheritString(vlc, "trace-file");
+    if (path == NULL)
+        return;
+
+    vlc_mutex_lock(&traces.lock);
+    if (traces.owner == NULL)
+    {
+        traces.records = malloc(TRACE_EVENTS * sizeof (*traces.records));
+        if (likely(traces.records != NULL))
+        {
+            traces.owner = vlc;
+            traces.path = path;
+            path = NULL;
+            atomic_store_explicit(&traces.count, 0, memory_order_relaxed);
+            atomic_store(&trace_enabled, true);
+        }
+    }
+    else
+        msg_Warn(vlc, "trace events already recorded to %s", traces.path);
+    vlc_mutex_unlock(&traces.lock);
+
+    free(path);
+#else
+    VLC_UNUSED(vlc);
+#endif
+}
+
+/**
+ * Stops recording trace events, and writes them to the trace file.
+ */
+void vlc_trace_Deinit(libvlc_int_t *vlc)
+{
+#ifdef ENABLE_TRACE
+    vlc_mutex_lock(&traces.lock);
+    if (traces.owner != vlc)
+    {
+        vlc_mutex_unlock(&traces.lock);
+        return;
+    }
+
+    atomic_store(&trace_enabled, false);
+    /* Threads that saw the recording enabled are about to store an event */
+    while (atomic_load_explicit(&traces.writers, memory_order_acquire) > 0)
+        msleep(1000);
+
+    char *path = traces.path;
+    struct vlc_trace_record *records = traces.records;
+
+    traces.owner = NULL;
+    traces.path = NULL;
+    traces.records = NULL;
+    vlc_mutex_unlock(&traces.lock);
+
+    size_t count = atomic_load_explicit(&traces.count, memory_order_relaxed);
+    FILE *stream = vlc_fopen(path, "wt");
+    if (stream == NULL)
+        msg_Err(vlc, "cannot create trace file %s: %s", path,
+                vlc_strerror_c(errno));
+    else
+    {
+        if (vlc_trace_Write(stream, records, count) | fclose(stream))
+            msg_Err(vlc, "cannot write trace file %s", path);
+        else
+            msg_Dbg(vlc, "trace events written to %s", path);
+    }
+    free(records);
+    free(path);
+#else
+    VLC_UNUSED(vlc);
+#endif
+}
@@ -28,9 +28,6 @@
 # include "config.h"
 #endif
 
-#ifdef HAVE_SEARCH_H
-# include <search.h>
-#endif
 #include <assert.h>
 #include <float.h>
 #include <math.h>
@@ -73,7 +70,9 @@ typedef struct callback_table_t
  */
 struct variable_t
 {
-    char *       psz_name; /**< The variable unique name (must be first) */
+    char *       psz_name; /**< The variable unique name */
+    size_t       hash;     /**< Hash of the name */
+    variable_t * next;     /**< Next variable in the same hash bucket */
 
     /** The variable's exported value */
     vlc_value_t  val;
@@ -141,23 +140,112 @@ int_ops    = { CmpInt,     DupDummy,  FreeDummy,  },
 string_ops = { CmpString,  DupString, FreeString, },
 coords_ops = { NULL,       DupDummy,  FreeDummy,  };
 
-static int varcmp( const void *a, const void *b )
+/**
+ * Hashes a variable name (32-bits FNV-1a).
+ */
+static size_t var_hash( const char *psz_name )
 {
-    const variable_t *va = a, *vb = b;
+    uint_fast32_t hash = 2166136261u;
 
-    /* psz_name must be first */
-    assert( va == (const void *)&va->psz_name );
-    return strcmp( va->psz_name, vb->psz_name );
+    for( const unsigned char *p = (const unsigned char *)psz_name; *p; p++ )
+    {
+        hash ^= *p;
+        hash = (hash * 16777619u) & 0xffffffffu;
+    }
+    return hash;
 }
 
-static variable_t *Lookup( vlc_object_t *obj, const char *psz_name )
+static variable_t *LookupLocked( vlc_object_internals_t *priv,
+                                 const char *psz_name, size_t hash )
+{
+    if( priv->var_table == NULL )
+        return NULL;
+
+    for( variable_t *var = priv->var_table[hash & priv->var_mask];
+         var != NULL;
+         var = var->next )
+        if( var->hash == hash && !strcmp( var->psz_name, psz_name ) )
+            return var;
+    return NULL;
+}
+
+/**
+ * Looks up a variable by name and hash, and locks the object variables.
+ */
+static variable_t *LookupHashed( vlc_object_t *obj, const char *psz_name,
+                                 size_t hash )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
-    variable_t **pp_var;
 
     vlc_mutex_lock(&priv->var_lock);
-    pp_var = tfind( &psz_name, &priv->var_root, varcmp );
-    return (pp_var != NULL) ? *pp_var : NULL;
+    return LookupLocked( priv, psz_name, hash );
+}
+
+static variable_t *Lookup( vlc_object_t *obj, const char *psz_name )
+{
+    return LookupHashed( obj, psz_name, var_hash( psz_name ) );
+}
+
+/**
+ * Adds a variable to the object hash table, growing it as needed.
+ * The object variables must be locked.
+ */
+static int Insert( vlc_object_internals_t *priv, variable_t *p_var )
+{
+    if( priv->var_table == NULL || priv->var_count > priv->var_mask )
+    {
+        size_t size = (priv->var_table != NULL) ? 2 * (priv->var_mask + 1)
+                                                : 16;
+        variable_t **table = calloc( size, sizeof (*table) );
+
+        if( unlikely(table == NULL) )
+        {
+            if( priv->var_table == NULL )
+                return VLC_ENOMEM;
+            /* Keep on using the full table; it only gets slower. */
+        }
+        else
+        {
+            for( size_t i = 0; priv->var_table != NULL
+                            && i <= priv->var_mask; i++ )
+            {
+                variable_t *var = priv->var_table[i];
+
+                while( var != NULL )
+                {
+                    variable_t *next = var->next;
+
+                    var->next = table[var->hash & (size - 1)];
+                    table[var->hash & (size - 1)] = var;
+                    var = next;
+                }
+            }
+            free( priv->var_table );
+            priv->var_table = table;
+            priv->var_mask = size - 1;
+        }
+    }
+
+    variable_t **pp = &priv->var_table[p_var->hash & priv->var_mask];
+
+    p_var->next = *pp;
+    *pp = p_var;
+    priv->var_count++;
+    return VLC_SUCCESS;
+}
+
+/**
+ * Removes a variable from the object hash table.
+ * The object variables must be locked.
+ */
+static void Remove( vlc_object_internals_t *priv, variable_t *p_var )
+{
+    variable_t **pp = &priv->var_table[p_var->hash & priv->var_mask];
+
+    while( *pp != p_var )
+        pp = &(*pp)->next;
+    *pp = p_var->next;
+    priv->var_count--;
 }
 
 static void Destroy( variable_t *p_var )
@@ -304,6 +392,7 @@ int var_Create( vlc_object_t *p_this, const char *psz_name, int i_type )
         return VLC_ENOMEM;
 
     p_var->psz_name = strdup( psz_name );
+    p_var->hash = var_hash( psz_name );
     p_var->psz_text = NULL;
 
     p_var->i_type = i_type & ~VLC_VAR_DOINHERIT;
@@ -362,16 +451,18 @@ int var_Create( vlc_object_t *p_this, const char *psz_name, int i_type )
         var_Inherit(p_this, psz_name, i_type, &p_var->val);
 
     vlc_object_internals_t *p_priv = vlc_internals( p_this );
-    variable_t **pp_var, *p_oldvar;
+    variable_t *p_oldvar;
     int ret = VLC_SUCCESS;
 
     vlc_mutex_lock( &p_priv->var_lock );
 
-    pp_var = tsearch( p_var, &p_priv->var_root, varcmp );
-    if( unlikely(pp_var == NULL) )
-        ret = VLC_ENOMEM;
-    else if( (p_oldvar = *pp_var) == p_var ) /* Variable create */
-        p_var = NULL; /* Variable created */
+    p_oldvar = LookupLocked( p_priv, p_var->psz_name, p_var->hash );
+    if( p_oldvar == NULL ) /* Variable create */
+    {
+        ret = Insert( p_priv, p_var );
+        if( likely(ret == VLC_SUCCESS) )
+            p_var = NULL; /* Variable created */
+    }
     else /* Variable already exists */
     {
         assert (((i_type ^ p_oldvar->i_type) & VLC_VAR_CLASS) == 0);
@@ -410,7 +501,7 @@ void (var_Destroy)(vlc_object_t *p_this, const char *psz_name)
     else if( --p_var->i_usage == 0 )
     {
         assert(!p_var->b_incallback);
-        tdelete( p_var, &p_priv->var_root, varcmp );
+        Remove( p_priv, p_var );
     }
     else
     {
@@ -423,17 +514,26 @@ void (var_Destroy)(vlc_object_t *p_this, const char *psz_name)
         Destroy( p_var );
 }
 
-static void CleanupVar( void *var )
-{
-    Destroy( var );
-}
-
 void var_DestroyAll( vlc_object_t *obj )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
 
-    tdestroy( priv->var_root, CleanupVar );
-    priv->var_root = NULL;
+    for( size_t i = 0; priv->var_table != NULL && i <= priv->var_mask; i++ )
+    {
+        variable_t *var = priv->var_table[i];
+
+        while( var != NULL )
+        {
+            variable_t *next = var->next;
+
+            Destroy( var );
+            var = next;
+        }
+    }
+    free( priv->var_table );
+    priv->var_table = NULL;
+    priv->var_count = 0;
+    priv->var_mask = 0;
 }
 
 #undef var_Change
@@ -726,6 +826,7 @@ int var_SetChecked( vlc_object_t *p_this, const char *psz_name,
     vlc_value_t oldval;
 
     assert( p_this );
+    VLC_UNUSED(expected_type); /* only checked in debug builds */
 
     vlc_object_internals_t *p_priv = vlc_internals( p_this );
 
@@ -777,17 +878,17 @@ int var_Set( vlc_object_t *p_this, const char *psz_name, vlc_value_t val )
     return var_SetChecked( p_this, psz_name, 0, val );
 }
 
-#undef var_GetChecked
-int var_GetChecked( vlc_object_t *p_this, const char *psz_name,
-                    int expected_type, vlc_value_t *p_val )
+static int GetChecked( vlc_object_t *p_this, const char *psz_name,
+                       size_t hash, int expected_type, vlc_value_t *p_val )
 {
     assert( p_this );
+    VLC_UNUSED(expected_type); /* only checked in debug builds */
 
     vlc_object_internals_t *p_priv = vlc_internals( p_this );
     variable_t *p_var;
     int err = VLC_SUCCESS;
 
-    p_var = Lookup( p_this, psz_name );
+    p_var = LookupHashed( p_this, psz_name, hash );
     if( p_var != NULL )
     {
         assert( expected_type == 0 ||
@@ -807,6 +908,14 @@ int var_GetChecked( vlc_object_t *p_this, const char *psz_name,
     return err;
 }
 
+#undef var_GetChecked
+int var_GetChecked( vlc_object_t *p_this, const char *psz_name,
+                    int expected_type, vlc_value_t *p_val )
+{
+    return GetChecked( p_this, psz_name, var_hash( psz_name ), expected_type,
+                       p_val );
+}
+
 #undef var_Get
 /**
  * Get a variable's value
@@ -1173,10 +1282,13 @@ int var_LocationParse (vlc_object_t *obj, const char *mrl, const char *pref)
 int var_Inherit( vlc_object_t *p_this, const char *psz_name, int i_type,
                  vlc_value_t *p_val )
 {
+    /* Hash the name once for the whole objects chain */
+    size_t hash = var_hash( psz_name );
+
     i_type &= VLC_VAR_CLASS;
     for( vlc_object_t *obj = p_this; obj != NULL; obj = obj->obj.parent )
     {
-        if( var_GetChecked( obj, psz_name, i_type, p_val ) == VLC_SUCCESS )
+        if( GetChecked( obj, psz_name, hash, i_type, p_val ) == VLC_SUCCESS )
             return VLC_SUCCESS;
     }
 
@@ -1309,13 +1421,15 @@ void var_FreeList( vlc_value_t *p_val, vlc_value_t *p_val2 )
     }
 }
 
-static void DumpVariable(const void *data, const VISIT which, const int depth)
+static int DumpCompare(const void *a, const void *b)
 {
-    if (which != postorder && which != leaf)
-        return;
-    (void) depth;
+    const variable_t *const *va = a, *const *vb = b;
+
+    return strcmp((*va)->psz_name, (*vb)->psz_name);
+}
 
-    const variable_t *var = *(const variable_t **)data;
+static void DumpVariable(const variable_t *var)
+{
     const char *typename = "unknown";
 
     switch (var->i_type & VLC_VAR_TYPE)
@@ -1370,27 +1484,31 @@ static void DumpVariable(const void *data, const VISIT which, const int depth)
 
 void DumpVariables(vlc_object_t *obj)
 {
-    vlc_mutex_lock(&vlc_internals(obj)->var_lock);
-    if (vlc_internals(obj)->var_root == NULL)
+    vlc_object_internals_t *priv = vlc_internals(obj);
+
+    vlc_mutex_lock(&priv->var_lock);
+    if (priv->var_count == 0)
         puts(" `-o No variables");
     else
-        twalk(vlc_internals(obj)->var_root, DumpVariable);
-    vlc_mutex_unlock(&vlc_internals(obj)->var_lock);
-}
+    {   /* Dump in alphabetical order */
+        const variable_t **tab = vlc_alloc(priv->var_count, sizeof (*tab));
+        size_t n = 0;
 
-static thread_local void *twalk_ctx;
-
-static void TwalkGetNames(const void *data, const VISIT which, const int depth)
-{
-    if (which != postorder && which != leaf)
-        return;
-    (void) depth;
-
-    const variable_t *var = *(const variable_t **)data;
-    DECL_ARRAY(char *) *names = twalk_ctx;
-    char *dup = strdup(var->psz_name);
-    if (dup != NULL)
-        ARRAY_APPEND(*names, dup);
+        if (tab != NULL)
+        {
+            for (size_t i = 0; i <= priv->var_mask; i++)
+                for (const variable_t *var = priv->var_table[i];
+                     var != NULL;
+                     var = var->next)
+                    tab[n++] = var;
+
+            qsort(tab, n, sizeof (*tab), DumpCompare);
+            for (size_t i = 0; i < n; i++)
+                DumpVariable(tab[i]);
+            free(tab);
+        }
+    }
+    vlc_mutex_unlock(&priv->var_lock);
 }
 
 char **var_GetAllNames(vlc_object_t *obj)
@@ -1400,9 +1518,16 @@ char **var_GetAllNames(vlc_object_t *obj)
     DECL_ARRAY(char *) names;
     ARRAY_INIT(names);
 
-    twalk_ctx = &names;
     vlc_mutex_lock(&priv->var_lock);
-    twalk(priv->var_root, TwalkGetNames);
+    for (size_t i = 0; priv->var_table != NULL && i <= priv->var_mask; i++)
+        for (const variable_t *var = priv->var_table[i];
+             var != NULL;
+             var = var->next)
+        {
+            char *dup = strdup(var->psz_name);
+            if (dup != NULL)
+                ARRAY_APPEND(names, dup);
+        }
     vlc_mutex_unlock(&priv->var_lock);
 
     if (names.i_size == 0)
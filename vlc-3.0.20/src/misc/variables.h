@@ -39,7 +39,9 @@ struct vlc_object_internals
     char           *psz_name; /* given name */
 
     /* Object variables */
-    void           *var_root;
+    struct variable_t **var_table; /* hash table of variables by name */
+    size_t          var_count;
+    size_t          var_mask; /* buckets count minus one */
     vlc_mutex_t     var_lock;
     vlc_cond_t      var_wait;
 
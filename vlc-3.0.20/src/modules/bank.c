@@ -36,9 +36,6 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
-#ifdef HAVE_SEARCH_H
-# include <search.h>
-#endif
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
@@ -53,107 +50,182 @@
 #include <TargetConditionals.h>
 #endif
 
-typedef struct vlc_modcap
+static struct
 {
-    char *name;
-    module_t **modv;
-    size_t modc;
-} vlc_modcap_t;
+    vlc_mutex_t lock;
+    block_t *caches;
+    vlc_modcap_t *caps; /**< Capabilities, sorted by name */
+    size_t capc;
+    unsigned usage;
+} modules = { VLC_STATIC_MUTEX, NULL, NULL, 0, 0 };
 
-static int vlc_modcap_cmp(const void *a, const void *b)
-{
-    const vlc_modcap_t *capa = a, *capb = b;
-    return strcmp(capa->name, capb->name);
-}
+vlc_plugin_t *vlc_plugins = NULL;
 
-static void vlc_modcap_free(void *data)
+/**
+ * Looks a capability up in the bank.
+ *
+ * \param name capability name
+ * \param pos [OUT] index of the capability if found, or where it belongs
+ * \return the capability or NULL if not found
+ */
+static vlc_modcap_t *vlc_modcap_find(const char *name, size_t *restrict pos)
 {
-    vlc_modcap_t *cap = data;
+    size_t lo = 0, hi = modules.capc;
 
-    free(cap->modv);
-    free(cap->name);
-    free(cap);
-}
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        int cmp = strcmp(name, modules.caps[mid].name);
 
-static int vlc_module_cmp (const void *a, const void *b)
-{
-    const module_t *const *ma = a, *const *mb = b;
-    /* Note that qsort() uses _ascending_ order,
-     * so the smallest module is the one with the biggest score. */
-    return (*mb)->i_score - (*ma)->i_score;
+        if (cmp == 0)
+        {
+            *pos = mid;
+            return &modules.caps[mid];
+        }
+        if (cmp < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    *pos = lo;
+    return NULL;
 }
 
-static void vlc_modcap_sort(const void *node, const VISIT which,
-                            const int depth)
+/**
+ * Looks a capability up in the bank, adding it if it is missing.
+ */
+static vlc_modcap_t *vlc_modcap_get(const char *name)
 {
-    vlc_modcap_t *const *cp = node, *cap = *cp;
+    size_t pos;
+    vlc_modcap_t *cap = vlc_modcap_find(name, &pos);
+    if (cap != NULL)
+        return cap;
 
-    if (which != postorder && which != leaf)
-        return;
-
-    qsort(cap->modv, cap->modc, sizeof (*cap->modv), vlc_module_cmp);
-    (void) depth;
-}
+    vlc_modcap_t *tab = realloc(modules.caps,
+                                (modules.capc + 1) * sizeof (*tab));
+    if (unlikely(tab == NULL))
+        return NULL;
 
-static struct
-{
-    vlc_mutex_t lock;
-    block_t *caches;
-    void *caps_tree;
-    unsigned usage;
-} modules = { VLC_STATIC_MUTEX, NULL, NULL, 0 };
+    memmove(tab + pos + 1, tab + pos, (modules.capc - pos) * sizeof (*tab));
+    modules.caps = tab;
+    modules.capc++;
 
-vlc_plugin_t *vlc_plugins = NULL;
+    cap = &tab[pos];
+    cap->name = name;
+    cap->modv = NULL;
+    cap->modc = 0;
+    return cap;
+}
 
 /**
  * Adds a module to the bank
+ *
+ * Each capability keeps its modules from the highest score to the lowest,
+ * so that lookups never need to sort.
  */
 static int vlc_module_store(module_t *mod)
 {
-    const char *name = module_get_capability(mod);
-    vlc_modcap_t *cap = malloc(sizeof (*cap));
+    vlc_modcap_t *cap = vlc_modcap_get(module_get_capability(mod));
     if (unlikely(cap == NULL))
         return -1;
 
-    cap->name = strdup(name);
-    cap->modv = NULL;
-    cap->modc = 0;
+    module_t **modv = realloc(cap->modv, sizeof (*modv) * (cap->modc + 1));
+    if (unlikely(modv == NULL))
+        return -1;
 
-    if (unlikely(cap->name == NULL))
-        goto error;
+    /* Insert after any module with the same or a higher score */
+    size_t lo = 0, hi = cap->modc;
 
-    vlc_modcap_t **cp = tsearch(cap, &modules.caps_tree, vlc_modcap_cmp);
-    if (unlikely(cp == NULL))
-        goto error;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+
+        if (modv[mid]->i_score >= mod->i_score)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    memmove(modv + lo + 1, modv + lo, (cap->modc - lo) * sizeof (*modv));
+    modv[lo] = mod;
+    cap->modv = modv;
+    cap->modc++;
+    return 0;
+}
+
+#ifdef HAVE_DYNAMIC_PLUGINS
+/**
+ * Adds a pre-sorted capability list from a plugins cache to the bank.
+ * The module table is taken over (or released).
+ */
+static int vlc_modcap_merge(vlc_modcap_t *src)
+{
+    vlc_modcap_t *cap = vlc_modcap_get(src->name);
+    if (unlikely(cap == NULL))
+    {
+        free(src->modv);
+        return -1;
+    }
 
-    if (*cp != cap)
+    if (cap->modc == 0)
     {
-        vlc_modcap_free(cap);
-        cap = *cp;
+        free(cap->modv);
+        cap->modv = src->modv;
+        cap->modc = src->modc;
+        return 0;
     }
 
-    module_t **modv = realloc(cap->modv, sizeof (*modv) * (cap->modc + 1));
+    module_t **modv = vlc_alloc(cap->modc + src->modc, sizeof (*modv));
     if (unlikely(modv == NULL))
+    {
+        free(src->modv);
         return -1;
+    }
 
+    size_t i = 0, j = 0, n = 0;
+
+    while (i < cap->modc && j < src->modc)
+        if (cap->modv[i]->i_score >= src->modv[j]->i_score)
+            modv[n++] = cap->modv[i++];
+        else
+            modv[n++] = src->modv[j++];
+    while (i < cap->modc)
+        modv[n++] = cap->modv[i++];
+    while (j < src->modc)
+        modv[n++] = src->modv[j++];
+
+    free(cap->modv);
+    free(src->modv);
     cap->modv = modv;
-    cap->modv[cap->modc] = mod;
-    cap->modc++;
+    cap->modc = n;
     return 0;
-error:
-    vlc_modcap_free(cap);
-    return -1;
 }
 
+static void vlc_modcap_release(vlc_modcap_t *caps, size_t capc)
+{
+    for (size_t i = 0; i < capc; i++)
+        free(caps[i].modv);
+    free(caps);
+}
+#endif
+
 /**
- * Adds a plugin (and all its modules) to the bank
+ * Adds a plugin to the list, without indexing its modules
  */
-static void vlc_plugin_store(vlc_plugin_t *lib)
+static void vlc_plugin_link(vlc_plugin_t *lib)
 {
     /*vlc_assert_locked (&modules.lock);*/
 
     lib->next = vlc_plugins;
     vlc_plugins = lib;
+}
+
+/**
+ * Adds a plugin (and all its modules) to the bank
+ */
+static void vlc_plugin_store(vlc_plugin_t *lib)
+{
+    vlc_plugin_link(lib);
 
     for (module_t *m = lib->module; m != NULL; m = m->next)
         vlc_module_store(m);
@@ -252,6 +324,7 @@ typedef enum
     CACHE_READ_FILE  = 0x1,
     CACHE_SCAN_DIR   = 0x2,
     CACHE_WRITE_FILE = 0x4,
+    CACHE_LAZY       = 0x8, /**< Never load a plug-in to describe it */
 } cache_mode_t;
 
 typedef struct module_bank
@@ -263,8 +336,38 @@ typedef struct module_bank
     size_t        size;
     vlc_plugin_t **plugins;
     vlc_plugin_t *cache;
+
+    /* Plug-ins used from the cache, and their pre-sorted capabilities */
+    size_t        cached_count;
+    vlc_plugin_t **cached;
+    vlc_modcap_t *caps;
+    size_t        capc;
 } module_bank_t;
 
+/**
+ * Drops the capabilities index of the plugins cache, e.g. if a cache entry
+ * was rejected. The modules will be indexed one by one instead.
+ */
+static void ModuleBankDropIndex(module_bank_t *bank)
+{
+    vlc_modcap_release(bank->caps, bank->capc);
+    bank->caps = NULL;
+    bank->capc = 0;
+}
+
+/**
+ * Adds a plug-in from the plugins cache.
+ */
+static void ModuleBankLinkCached(module_bank_t *bank, vlc_plugin_t *plugin)
+{
+    vlc_plugin_link(plugin);
+
+    bank->cached = xrealloc(bank->cached,
+                            (bank->cached_count + 1) * sizeof (vlc_plugin_t *));
+    bank->cached[bank->cached_count] = plugin;
+    bank->cached_count++;
+}
+
 /**
  * Scans a plug-in from a file.
  */
@@ -286,25 +389,29 @@ static int AllocatePluginFile (module_bank_t *bank, const char *abspath,
                     plugin->abspath);
             vlc_plugin_destroy(plugin);
             plugin = NULL;
+            ModuleBankDropIndex(bank);
         }
     }
 
-    if (plugin == NULL)
+    if (plugin != NULL)
+        ModuleBankLinkCached(bank, plugin);
+    else
     {
-        plugin = module_InitDynamic(bank->obj, abspath, true);
-
-        if (plugin != NULL)
+        if (bank->mode & CACHE_LAZY)
         {
-            plugin->path = xstrdup(relpath);
-            plugin->mtime = st->st_mtime;
-            plugin->size = st->st_size;
+            msg_Warn(bank->obj, "ignoring %s: not in plugins cache", abspath);
+            return -1;
         }
-    }
 
-    if (plugin == NULL)
-        return -1;
+        plugin = module_InitDynamic(bank->obj, abspath, true);
+        if (plugin == NULL)
+            return -1;
 
-    vlc_plugin_store(plugin);
+        plugin->path = xstrdup(relpath);
+        plugin->mtime = st->st_mtime;
+        plugin->size = st->st_size;
+        vlc_plugin_store(plugin);
+    }
 
     if (bank->mode & CACHE_WRITE_FILE) /* Add entry to to-be-saved cache */
     {
@@ -476,10 +583,17 @@ static void AllocatePluginPath(vlc_object_t *obj, const char *path,
     };
 
     if (mode & CACHE_READ_FILE)
-        bank.cache = vlc_cache_load(obj, path, &modules.caches);
+        bank.cache = vlc_cache_load(obj, path, &modules.caches,
+                                    &bank.caps, &bank.capc);
     else
         msg_Dbg(bank.obj, "ignoring plugins cache file");
 
+    if ((mode & CACHE_LAZY) && bank.cache == NULL)
+    {   /* Without a cache, plug-ins can only be known by loading them */
+        msg_Warn(obj, "no plugins cache in %s, loading all plug-ins", path);
+        bank.mode &= ~CACHE_LAZY;
+    }
+
     if (mode & CACHE_SCAN_DIR)
     {
         msg_Dbg(obj, "recursively browsing `%s'", bank.base);
@@ -495,11 +609,27 @@ static void AllocatePluginPath(vlc_object_t *obj, const char *path,
 
         bank.cache = plugin->next;
         if (mode & CACHE_SCAN_DIR)
+        {
             vlc_plugin_destroy(plugin);
+            ModuleBankDropIndex(&bank);
+        }
         else
-            vlc_plugin_store(plugin);
+            ModuleBankLinkCached(&bank, plugin);
     }
 
+    /* Index the modules from the cache, if it still matches the plug-ins */
+    if (bank.caps != NULL)
+    {
+        for (size_t i = 0; i < bank.capc; i++)
+            vlc_modcap_merge(&bank.caps[i]);
+        free(bank.caps);
+    }
+    else
+        for (size_t i = 0; i < bank.cached_count; i++)
+            for (module_t *m = bank.cached[i]->module; m != NULL; m = m->next)
+                vlc_module_store(m);
+    free(bank.cached);
+
     if (mode & CACHE_WRITE_FILE)
         CacheSave(obj, path, bank.plugins, bank.size);
 
@@ -525,6 +655,8 @@ static void AllocateAllPlugins (vlc_object_t *p_this)
         mode |= CACHE_SCAN_DIR;
     if (var_InheritBool(p_this, "reset-plugins-cache"))
         mode = (mode | CACHE_WRITE_FILE) & ~CACHE_READ_FILE;
+    if ((mode & CACHE_READ_FILE) && var_InheritBool(p_this, "plugins-lazy"))
+        mode |= CACHE_LAZY;
 
 #if VLC_WINSTORE_APP
     /* Windows Store Apps can not load external plugins with absolute paths. */
@@ -686,7 +818,8 @@ void module_EndBank (bool b_plugins)
 {
     vlc_plugin_t *libs = NULL;
     block_t *caches = NULL;
-    void *caps_tree = NULL;
+    vlc_modcap_t *caps = NULL;
+    size_t capc = 0;
 
     /* If plugins were _not_ loaded, then the caller still has the bank lock
      * from module_InitBank(). */
@@ -701,14 +834,18 @@ void module_EndBank (bool b_plugins)
         config_UnsortConfig ();
         libs = vlc_plugins;
         caches = modules.caches;
-        caps_tree = modules.caps_tree;
+        caps = modules.caps;
+        capc = modules.capc;
         vlc_plugins = NULL;
         modules.caches = NULL;
-        modules.caps_tree = NULL;
+        modules.caps = NULL;
+        modules.capc = 0;
     }
     vlc_mutex_unlock (&modules.lock);
 
-    tdestroy(caps_tree, vlc_modcap_free);
+    for (size_t i = 0; i < capc; i++)
+        free(caps[i].modv);
+    free(caps);
 
     while (libs != NULL)
     {
@@ -743,8 +880,6 @@ size_t module_LoadPlugins (vlc_object_t *obj)
 #endif
         config_UnsortConfig ();
         config_SortConfig ();
-
-        twalk(modules.caps_tree, vlc_modcap_sort);
     }
     vlc_mutex_unlock (&modules.lock);
 
@@ -807,14 +942,14 @@ module_t **module_list_get (size_t *n)
  */
 ssize_t module_list_cap (module_t ***restrict list, const char *name)
 {
-    const vlc_modcap_t **cp = tfind(&name, &modules.caps_tree, vlc_modcap_cmp);
-    if (cp == NULL)
+    size_t pos;
+    const vlc_modcap_t *cap = vlc_modcap_find(name, &pos);
+    if (cap == NULL)
     {
         *list = NULL;
         return 0;
     }
 
-    const vlc_modcap_t *cap = *cp;
     size_t n = cap->modc;
     module_t **tab = vlc_alloc (n, sizeof (*tab));
     *list = tab;
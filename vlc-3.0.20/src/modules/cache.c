@@ -42,6 +42,7 @@
 #include "libvlc.h"
 
 #include <vlc_plugin.h>
+#include <vlc_modules.h>
 #include <errno.h>
 
 #include "config/configuration.h"
@@ -57,7 +58,7 @@
 #ifdef HAVE_DYNAMIC_PLUGINS
 /* Sub-version number
  * (only used to avoid breakage in dev version when cache structure changes) */
-#define CACHE_SUBVERSION_NUM 34
+#define CACHE_SUBVERSION_NUM 35
 
 /* Cache filename */
 #define CACHE_NAME "plugins.dat"
@@ -288,12 +289,18 @@ error:
     return -1; /* FIXME: leaks */
 }
 
-static int vlc_cache_load_module(vlc_plugin_t *plugin, block_t *file)
+static int vlc_cache_load_module(vlc_plugin_t *plugin, block_t *file,
+                                 module_t **modv, size_t *modi, size_t modc)
 {
+    if (*modi >= modc)
+        return -1;
+
     module_t *module = vlc_module_create(plugin);
     if (unlikely(module == NULL))
         return -1;
 
+    modv[(*modi)++] = module;
+
     LOAD_STRING(module->psz_shortname);
     LOAD_STRING(module->psz_longname);
     LOAD_STRING(module->psz_help);
@@ -318,7 +325,8 @@ error:
     return -1;
 }
 
-static vlc_plugin_t *vlc_cache_load_plugin(block_t *file)
+static vlc_plugin_t *vlc_cache_load_plugin(block_t *file, module_t **modv,
+                                           size_t *modi, size_t modc)
 {
     vlc_plugin_t *plugin = vlc_plugin_create();
     if (unlikely(plugin == NULL))
@@ -328,7 +336,7 @@ static vlc_plugin_t *vlc_cache_load_plugin(block_t *file)
     LOAD_IMMEDIATE(modules);
 
     for (size_t i = 0; i < modules; i++)
-        if (vlc_cache_load_module(plugin, file))
+        if (vlc_cache_load_module(plugin, file, modv, modi, modc))
             goto error;
 
     if (vlc_cache_load_plugin_config(plugin, file))
@@ -359,6 +367,76 @@ error:
     return NULL;
 }
 
+/**
+ * Loads the capabilities index, i.e. the modules of each capability, already
+ * sorted by decreasing score. Modules are referred to by their rank in the
+ * cache file.
+ */
+static int vlc_cache_load_caps(vlc_modcap_t **restrict capsp,
+                               size_t *restrict capcp,
+                               module_t *const *modv, size_t modc,
+                               block_t *file)
+{
+    vlc_modcap_t *caps = NULL;
+    uint32_t capc, i = 0;
+
+    LOAD_IMMEDIATE(capc);
+    if (capc > modc)
+        goto error;
+
+    caps = vlc_alloc(capc, sizeof (*caps));
+    if (unlikely(caps == NULL) && capc > 0)
+        goto error;
+
+    for (i = 0; i < capc; i++)
+    {
+        vlc_modcap_t *cap = caps + i;
+        const uint32_t *refs;
+        uint32_t count;
+
+        cap->modv = NULL;
+        LOAD_STRING(cap->name);
+        LOAD_IMMEDIATE(count);
+        /* Capabilities must be sorted, as they are looked up by bisection */
+        if (cap->name == NULL || count == 0 || count > modc
+         || (i > 0 && strcmp(caps[i - 1].name, cap->name) >= 0))
+            goto error;
+
+        LOAD_ALIGNOF(*refs);
+        LOAD_ARRAY(refs, count);
+
+        cap->modv = vlc_alloc(count, sizeof (*cap->modv));
+        if (unlikely(cap->modv == NULL))
+            goto error;
+        cap->modc = count;
+
+        for (uint32_t j = 0; j < count; j++)
+        {
+            if (refs[j] >= modc)
+                goto error;
+
+            module_t *module = modv[refs[j]];
+
+            if (strcmp(module_get_capability(module), cap->name)
+             || (j > 0 && cap->modv[j - 1]->i_score < module->i_score))
+                goto error;
+            cap->modv[j] = module;
+        }
+    }
+
+    *capsp = caps;
+    *capcp = capc;
+    return 0;
+error:
+    if (caps != NULL)
+    {
+        for (uint32_t j = 0; j <= i && j < capc; j++)
+            free(caps[j].modv);
+        free(caps);
+    }
+    return -1;
+}
+
 /**
  * Loads a plugins cache file.
  *
@@ -366,9 +444,15 @@ error:
  * will in turn be queried by AllocateAllPlugins() to see if it needs to
  * actually load the dynamically loadable module.
  * This allows us to only fully load plugins when they are actually used.
+ *
+ * The file is mapped in memory and its strings and tables are used in place.
+ * It also provides the modules of each capability pre-sorted by score
+ * (see vlc_cache_load_caps()), so that the bank needs not sort them.
  */
 vlc_plugin_t *vlc_cache_load(vlc_object_t *p_this, const char *dir,
-                             block_t **backingp)
+                             block_t **backingp,
+                             vlc_modcap_t **restrict capsp,
+                             size_t *restrict capcp)
 {
     char *psz_filename;
 
@@ -438,11 +522,32 @@ vlc_plugin_t *vlc_cache_load(vlc_object_t *p_this, const char *dir,
         return 0;
     }
 
+    /* Check plug-ins and modules count */
+    uint32_t plugins, modc;
+
+    if (vlc_cache_load_immediate(&plugins, file, sizeof (plugins))
+     || vlc_cache_load_immediate(&modc, file, sizeof (modc))
+     || plugins > file->i_buffer || modc > file->i_buffer)
+    {
+        msg_Warn( p_this, "This doesn't look like a valid plugins cache "
+                  "(corrupted header)" );
+        block_Release(file);
+        return 0;
+    }
+
     vlc_plugin_t *cache = NULL;
+    module_t **modv = vlc_alloc(modc, sizeof (*modv));
+    size_t modi = 0;
 
-    while (file->i_buffer > 0)
+    if (unlikely(modv == NULL) && modc > 0)
     {
-        vlc_plugin_t *plugin = vlc_cache_load_plugin(file);
+        block_Release(file);
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < plugins; i++)
+    {
+        vlc_plugin_t *plugin = vlc_cache_load_plugin(file, modv, &modi, modc);
         if (plugin == NULL)
             goto error;
 
@@ -458,6 +563,12 @@ vlc_plugin_t *vlc_cache_load(vlc_object_t *p_this, const char *dir,
         cache = plugin;
     }
 
+    if (modi != modc
+     || vlc_cache_load_caps(capsp, capcp, modv, modc, file)
+     || file->i_buffer > 0)
+        goto error;
+
+    free(modv);
     file->p_next = *backingp;
     *backingp = file;
     return cache;
@@ -466,6 +577,7 @@ error:
     msg_Warn( p_this, "plugins cache not loaded (corrupted)" );
 
     /* TODO: cleanup */
+    free(modv);
     block_Release(file);
     return NULL;
 }
@@ -594,6 +706,76 @@ error:
     return -1;
 }
 
+struct vlc_cache_ref
+{
+    const module_t *module;
+    uint32_t rank; /**< Rank of the module in the cache file */
+};
+
+static int vlc_cache_ref_cmp(const void *a, const void *b)
+{
+    const struct vlc_cache_ref *ra = a, *rb = b;
+    int cmp = strcmp(module_get_capability(ra->module),
+                     module_get_capability(rb->module));
+
+    if (cmp == 0) /* highest score first */
+        cmp = rb->module->i_score - ra->module->i_score;
+    if (cmp == 0)
+        cmp = (ra->rank > rb->rank) - (ra->rank < rb->rank);
+    return cmp;
+}
+
+static int CacheSaveCaps(FILE *file, vlc_plugin_t *const *cache, size_t n,
+                         uint32_t modc)
+{
+    struct vlc_cache_ref *refs = vlc_alloc(modc, sizeof (*refs));
+    uint32_t rank = 0, capc = 0;
+
+    if (unlikely(refs == NULL) && modc > 0)
+        return -1;
+
+    for (size_t i = 0; i < n; i++)
+        for (const module_t *module = cache[i]->module;
+             module != NULL;
+             module = module->next)
+        {
+            refs[rank].module = module;
+            refs[rank].rank = rank;
+            rank++;
+        }
+    assert(rank == modc);
+
+    qsort(refs, modc, sizeof (*refs), vlc_cache_ref_cmp);
+
+    for (uint32_t i = 0; i < modc; i++)
+        if (i == 0 || strcmp(module_get_capability(refs[i - 1].module),
+                             module_get_capability(refs[i].module)))
+            capc++;
+
+    SAVE_IMMEDIATE(capc);
+
+    for (uint32_t i = 0, count; i < modc; i += count)
+    {
+        const char *name = module_get_capability(refs[i].module);
+
+        for (count = 1; i + count < modc; count++)
+            if (strcmp(module_get_capability(refs[i + count].module), name))
+                break;
+
+        SAVE_STRING(name);
+        SAVE_IMMEDIATE(count);
+        SAVE_ALIGNOF(uint32_t);
+        for (uint32_t j = 0; j < count; j++)
+            SAVE_IMMEDIATE(refs[i + j].rank);
+    }
+
+    free(refs);
+    return 0;
+error:
+    free(refs);
+    return -1;
+}
+
 static int CacheSaveBank(FILE *file, vlc_plugin_t *const *cache, size_t n)
 {
     uint32_t i_file_size = 0;
@@ -617,6 +799,14 @@ static int CacheSaveBank(FILE *file, vlc_plugin_t *const *cache, size_t n)
     if (fwrite (&i_file_size, sizeof (i_file_size), 1, file) != 1)
         goto error;
 
+    /* Plug-ins and modules count */
+    uint32_t plugins = n, modc = 0;
+
+    for (size_t i = 0; i < n; i++)
+        modc += cache[i]->modules_count;
+    SAVE_IMMEDIATE(plugins);
+    SAVE_IMMEDIATE(modc);
+
     for (size_t i = 0; i < n; i++)
     {
         const vlc_plugin_t *plugin = cache[i];
@@ -642,6 +832,10 @@ static int CacheSaveBank(FILE *file, vlc_plugin_t *const *cache, size_t n)
         SAVE_IMMEDIATE(plugin->size);
     }
 
+    /* Capabilities index */
+    if (CacheSaveCaps(file, cache, n, modc))
+        goto error;
+
     if (fflush (file)) /* flush libc buffers */
         goto error;
     return 0; /* success! */
@@ -103,6 +103,16 @@ struct module_t
     void *pf_deactivate;
 };
 
+/**
+ * Modules with a given capability, from the highest score to the lowest
+ */
+typedef struct vlc_modcap
+{
+    const char *name;
+    module_t **modv;
+    size_t modc;
+} vlc_modcap_t;
+
 vlc_plugin_t *vlc_plugin_create(void);
 void vlc_plugin_destroy(vlc_plugin_t *);
 module_t *vlc_module_create(vlc_plugin_t *);
@@ -127,7 +137,8 @@ void *module_Lookup (module_handle_t, const char *);
 void module_Unload (module_handle_t);
 
 /* Plugins cache */
-vlc_plugin_t *vlc_cache_load(vlc_object_t *, const char *, block_t **);
+vlc_plugin_t *vlc_cache_load(vlc_object_t *, const char *, block_t **,
+                             vlc_modcap_t **, size_t *);
 vlc_plugin_t *vlc_cache_lookup(vlc_plugin_t **, const char *relpath);
 
 void CacheSave(vlc_object_t *, const char *, vlc_plugin_t *const *, size_t);
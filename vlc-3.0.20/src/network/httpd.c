@@ -40,11 +40,15 @@
 #include <vlc_url.h>
 #include <vlc_mime.h>
 #include <vlc_block.h>
+#include <vlc_fs.h>
 #include "../libvlc.h"
 
+#include <ctype.h>
 #include <string.h>
 #include <errno.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #ifdef HAVE_SYS_UIO_H
 # include <sys/uio.h>
 #endif
@@ -63,11 +67,13 @@
 /* We need HUGE buffer otherwise TCP throughput is very limited */
 #define HTTPD_CL_BUFSIZE 1000000
 #else
-#define HTTPD_CL_BUFSIZE 10000
+/* About a socket send buffer, not to wake up for every few packets */
+#define HTTPD_CL_BUFSIZE 65536
 #endif
 
 static void httpd_ClientDestroy(httpd_client_t *cl);
-static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data);
+static int httpd_AppendData(httpd_stream_t *stream, const uint8_t *p_data,
+                            size_t i_data);
 
 /* each host run in his own thread */
 struct httpd_host_t
@@ -145,7 +151,11 @@ struct httpd_client_t
     int     i_ref;
 
     bool    b_stream_mode;
+    bool    b_chunked;      /* chunked transfer coding of the answer */
+    bool    b_chunked_end;  /* last chunk queued */
+    bool    b_ready;        /* worth trying to receive or send */
     uint8_t i_state;
+    int     i_poll;         /* index in the poll() set, or -1 */
 
     vlc_tick_t i_timeout_date;
 
@@ -154,6 +164,13 @@ struct httpd_client_t
     int     i_buffer;
     uint8_t *p_buffer;
 
+    /* stream data shared with the httpd_stream_t, sent after p_buffer */
+    block_t *p_chain;
+
+    /* file being sent by httpd_FilePathCallBack, or -1 */
+    int      i_file_fd;
+    uint64_t i_file_end;    /* last byte of the answered range */
+
     /*
      * If waiting for a keyframe, this is the position (in bytes) of the
      * last keyframe the stream saw before this client connected.
@@ -188,15 +205,15 @@ static const char *httpd_ReasonFromCode(unsigned i_code)
           { 202, "Accepted" },
           { 203, "Non-authoritative information" },
           { 204, "No content" },
-          { 205, "Reset content" },
-          { 206, "Partial content" },
-          { 250, "Low on storage space" },
+          { 205, "Reset content" },*/
+        { 206, "Partial content" },
+        /*{ 250, "Low on storage space" },
           { 300, "Multiple choices" },*/
         { 301, "Moved permanently" },
         /*{ 302, "Moved temporarily" },
-          { 303, "See other" },
-          { 304, "Not modified" },
-          { 305, "Use proxy" },
+          { 303, "See other" },*/
+        { 304, "Not modified" },
+        /*{ 305, "Use proxy" },
           { 307, "Temporary redirect" },
           { 400, "Bad request" },*/
         { 401, "Unauthorized" },
@@ -213,9 +230,9 @@ static const char *httpd_ReasonFromCode(unsigned i_code)
           { 412, "Precondition failed" },
           { 413, "Request entity too large" },
           { 414, "Request-URI too large" },
-          { 415, "Unsupported media Type" },
-          { 416, "Requested range not satisfiable" },
-          { 417, "Expectation failed" },
+          { 415, "Unsupported media Type" },*/
+        { 416, "Requested range not satisfiable" },
+        /*{ 417, "Expectation failed" },
           { 451, "Parameter not understood" },
           { 452, "Conference not found" },
           { 453, "Not enough bandwidth" },*/
@@ -296,6 +313,7 @@ struct httpd_file_t
     httpd_url_t *url;
     httpd_file_callback_t pf_fill;
     httpd_file_sys_t      *p_sys;
+    char *path; /* served from disk if non-NULL */
     char mime[1];
 };
 
@@ -372,6 +390,7 @@ httpd_file_t *httpd_FileNew(httpd_host_t *host,
 
     file->pf_fill = pf_fill;
     file->p_sys   = p_sys;
+    file->path    = NULL;
     memcpy(file->mime, mime, mimelen + 1);
 
     httpd_UrlCatch(file->url, HTTPD_MSG_HEAD, httpd_FileCallBack,
@@ -384,11 +403,222 @@ httpd_file_t *httpd_FileNew(httpd_host_t *host,
     return file;
 }
 
+/* Parses a single "bytes=" range. Returns 1 if the whole file shall be sent
+ * (no range, or a range we do not handle), 0 for a satisfiable range, and -1
+ * if the range lies beyond the end of the file. */
+static int httpd_FileRange(const char *range, uint64_t size,
+                           uint64_t *restrict start, uint64_t *restrict end)
+{
+    uint64_t first, last;
+    char *p;
+
+    if (range == NULL || strncasecmp(range, "bytes=", 6)
+     || strchr(range, ',') != NULL /* multipart answers are not supported */)
+        return 1;
+    range += 6;
+
+    if (*range == '-') { /* suffix: the last N bytes */
+        uint64_t n = strtoull(range + 1, &p, 10);
+        if (p == range + 1 || *p != '\0')
+            return 1;
+        if (n == 0 || size == 0)
+            return -1;
+        *start = (n < size) ? size - n : 0;
+        *end = size - 1;
+        return 0;
+    }
+
+    if (!isdigit((unsigned char)*range))
+        return 1;
+    first = strtoull(range, &p, 10);
+    if (*p != '-')
+        return 1;
+    range = p + 1;
+    if (*range != '\0') {
+        last = strtoull(range, &p, 10);
+        if (*p != '\0' || last < first)
+            return 1;
+    } else
+        last = UINT64_MAX;
+
+    if (first >= size)
+        return -1;
+    *start = first;
+    *end = (last < size) ? last : size - 1;
+    return 0;
+}
+
+/* Serves a file from disk in chunks of HTTPD_CL_BUFSIZE bytes: the callback
+ * is invoked again for each chunk, with the file offset as i_body_offset.
+ * The file stays open in the client until the last chunk is read. */
+static int
+httpd_FilePathCallBack(httpd_callback_sys_t *p_sys, httpd_client_t *cl,
+                       httpd_message_t *answer, const httpd_message_t *query)
+{
+    httpd_file_t *file = (httpd_file_t*)p_sys;
+    struct stat st;
+
+    if (!answer || !query)
+        return VLC_SUCCESS;
+
+    uint64_t start, end;
+
+    if (answer->i_body_offset > 0) {
+        /* next chunk of a response whose headers were already sent */
+        if (cl->i_file_fd == -1) {
+            answer->i_body_offset = 0;
+            httpd_MsgAdd(answer, "Connection", "close");
+            return VLC_SUCCESS;
+        }
+        start = answer->i_body_offset;
+        end = cl->i_file_end;
+        goto body;
+    }
+
+    if (cl->i_file_fd != -1) {
+        /* left over from an interrupted answer */
+        vlc_close(cl->i_file_fd);
+        cl->i_file_fd = -1;
+    }
+
+    int fd = vlc_open(file->path, O_RDONLY);
+    if (fd != -1 && (fstat(fd, &st) || !S_ISREG(st.st_mode))) {
+        vlc_close(fd);
+        fd = -1;
+    }
+    if (fd == -1)
+        return VLC_EGENERIC; /* 404 */
+
+    uint64_t size = st.st_size;
+    start = 0;
+    end = size - 1;
+    int range = httpd_FileRange(httpd_MsgGet(query, "Range"), size,
+                                &start, &end);
+
+    answer->i_proto  = HTTPD_PROTO_HTTP;
+    answer->i_version= 1;
+    answer->i_type   = HTTPD_MSG_ANSWER;
+    answer->i_status = 200;
+
+    char etag[2 * 16 + 4];
+    snprintf(etag, sizeof (etag), "\"%"PRIx64"-%"PRIx64"\"",
+             (uint64_t)st.st_mtime, size);
+
+    httpd_MsgAdd(answer, "Content-type",  "%s", file->mime);
+    httpd_MsgAdd(answer, "Cache-Control", "%s", "no-cache");
+    httpd_MsgAdd(answer, "ETag", "%s", etag);
+    httpd_MsgAdd(answer, "Accept-Ranges", "bytes");
+
+    const char *match = httpd_MsgGet(query, "If-None-Match");
+    if (match != NULL && (strstr(match, etag) != NULL || !strcmp(match, "*"))) {
+        answer->i_status = 304;
+        vlc_close(fd);
+        goto out;
+    }
+
+    if (range < 0) {
+        answer->i_status = 416;
+        httpd_MsgAdd(answer, "Content-Range", "bytes */%"PRIu64, size);
+        httpd_MsgAdd(answer, "Content-Length", "0");
+        vlc_close(fd);
+        goto out;
+    }
+    if (range == 0) {
+        answer->i_status = 206;
+        httpd_MsgAdd(answer, "Content-Range", "bytes %"PRIu64"-%"PRIu64
+                     "/%"PRIu64, start, end, size);
+    }
+    httpd_MsgAdd(answer, "Content-Length", "%"PRIu64,
+                 (size > 0) ? end - start + 1 : 0);
+
+    if (query->i_type == HTTPD_MSG_HEAD || size == 0) {
+        vlc_close(fd);
+        goto out;
+    }
+    cl->i_file_fd = fd;
+    cl->i_file_end = end;
+    if (lseek(fd, start, SEEK_SET) != (off_t)start)
+        goto error;
+
+body:
+    if (start <= end) {
+        size_t len = (end - start < HTTPD_CL_BUFSIZE)
+                   ? end - start + 1 : HTTPD_CL_BUFSIZE;
+        uint8_t *buf = malloc(len);
+        ssize_t val = -1;
+
+        if (likely(buf != NULL))
+            val = read(cl->i_file_fd, buf, len);
+        if (val > 0) {
+            answer->p_body = buf;
+            answer->i_body = val;
+            start += val;
+            answer->i_body_offset = (start <= end) ? start : 0;
+            if (answer->i_body_offset == 0) {
+                vlc_close(cl->i_file_fd);
+                cl->i_file_fd = -1;
+            }
+            goto out;
+        }
+        free(buf);
+    }
+error:
+    /* the file shrank or could not be read: the length is now wrong */
+    vlc_close(cl->i_file_fd);
+    cl->i_file_fd = -1;
+    answer->i_body_offset = 0;
+    httpd_MsgAdd(answer, "Connection", "close");
+    return VLC_SUCCESS;
+
+out:
+    /* We respect client request */
+    if (httpd_MsgGet(&cl->query, "Connection") != NULL)
+        httpd_MsgAdd(answer, "Connection", "close");
+    return VLC_SUCCESS;
+}
+
+httpd_file_t *httpd_FilePathNew(httpd_host_t *host,
+                                 const char *psz_url, const char *psz_path,
+                                 const char *psz_mime,
+                                 const char *psz_user, const char *psz_password)
+{
+    const char *mime = psz_mime;
+    if (mime == NULL || mime[0] == '\0')
+        mime = vlc_mime_Ext2Mime(psz_path);
+
+    size_t mimelen = strlen(mime);
+    httpd_file_t *file = malloc(sizeof(*file) + mimelen);
+    if (unlikely(file == NULL))
+        return NULL;
+
+    file->path = strdup(psz_path);
+    file->url = httpd_UrlNew(host, psz_url, psz_user, psz_password);
+    if (unlikely(file->path == NULL) || !file->url) {
+        if (file->url)
+            httpd_UrlDelete(file->url);
+        free(file->path);
+        free(file);
+        return NULL;
+    }
+
+    file->pf_fill = NULL;
+    file->p_sys   = NULL;
+    memcpy(file->mime, mime, mimelen + 1);
+
+    httpd_UrlCatch(file->url, HTTPD_MSG_HEAD, httpd_FilePathCallBack,
+                    (httpd_callback_sys_t*)file);
+    httpd_UrlCatch(file->url, HTTPD_MSG_GET,  httpd_FilePathCallBack,
+                    (httpd_callback_sys_t*)file);
+
+    return file;
+}
+
 httpd_file_sys_t *httpd_FileDelete(httpd_file_t *file)
 {
     httpd_file_sys_t *p_sys = file->p_sys;
 
     httpd_UrlDelete(file->url);
+    free(file->path);
     free(file);
     return p_sys;
 }
@@ -588,6 +818,16 @@ void httpd_RedirectDelete(httpd_redirect_t *rdir)
 /*****************************************************************************
  * High Level Funtions: httpd_stream_t
  *****************************************************************************/
+/* Minimum allocation of a stream block: small writes (such as TS packets)
+ * are gathered until a client takes the block */
+#define HTTPD_STREAM_BLOCK 16384
+
+struct httpd_stream_block
+{
+    int64_t i_pos;      /* absolute position of the first byte */
+    block_t *p_block;
+};
+
 struct httpd_stream_t
 {
     vlc_mutex_t lock;
@@ -607,9 +847,13 @@ struct httpd_stream_t
     bool        b_has_keyframes;
     int64_t     i_last_keyframe_seen_pos;
 
-    /* circular buffer */
-    int         i_buffer_size;      /* buffer size, can't be reallocated smaller */
-    uint8_t     *p_buffer;          /* buffer */
+    /* ring of the last blocks, shared with the clients that send them */
+    struct httpd_stream_block *p_blocks;
+    size_t      i_blocks_alloc;
+    size_t      i_blocks_first;
+    size_t      i_blocks;
+    size_t      i_buffer_size;      /* bytes kept for the slow clients */
+    size_t      i_buffer;           /* bytes allocated by the kept blocks */
     int64_t     i_buffer_pos;       /* absolute position from beginning */
     int64_t     i_buffer_last_pos;  /* a new connection will start with that */
 
@@ -618,6 +862,13 @@ struct httpd_stream_t
     httpd_header * p_http_headers;
 };
 
+static inline struct httpd_stream_block *
+httpd_StreamBlockAt(httpd_stream_t *stream, size_t i)
+{
+    return &stream->p_blocks[(stream->i_blocks_first + i)
+                             % stream->i_blocks_alloc];
+}
+
 static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
                                  httpd_client_t *cl, httpd_message_t *answer,
                                  const httpd_message_t *query)
@@ -628,47 +879,71 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
         return VLC_SUCCESS;
 
     if (answer->i_body_offset > 0) {
-        int     i_pos;
+        vlc_mutex_lock(&stream->lock);
 
         if (answer->i_body_offset >= stream->i_buffer_pos)
-            return VLC_EGENERIC;    /* wait, no data available */
+            goto wait;  /* no data available */
 
         if (cl->i_keyframe_wait_to_pass >= 0) {
             if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
                 /* still waiting for the next keyframe */
-                return VLC_EGENERIC;
+                goto wait;
 
             /* seek to the new keyframe */
             answer->i_body_offset = stream->i_last_keyframe_seen_pos;
             cl->i_keyframe_wait_to_pass = -1;
         }
 
-        if (answer->i_body_offset + stream->i_buffer_size < stream->i_buffer_pos)
+        if (answer->i_body_offset < httpd_StreamBlockAt(stream, 0)->i_pos)
             answer->i_body_offset = stream->i_buffer_last_pos; /* this client isn't fast enough */
 
-        i_pos   = answer->i_body_offset % stream->i_buffer_size;
-        int64_t i_write = stream->i_buffer_pos - answer->i_body_offset;
+        /* find the last block starting at or before the client position */
+        size_t i_lo = 0, i_hi = stream->i_blocks;
+        while (i_hi - i_lo > 1) {
+            size_t i_mid = (i_lo + i_hi) / 2;
+            if (httpd_StreamBlockAt(stream, i_mid)->i_pos <= answer->i_body_offset)
+                i_lo = i_mid;
+            else
+                i_hi = i_mid;
+        }
 
-        if (i_write > HTTPD_CL_BUFSIZE)
-            i_write = HTTPD_CL_BUFSIZE;
-        else if (i_write <= 0)
-            return VLC_EGENERIC;    /* wait, no data available */
+        /* hand out references to the blocks, not copies of the data */
+        block_t *p_chain = NULL, **pp_last = &p_chain;
+        size_t i_skip = answer->i_body_offset - httpd_StreamBlockAt(stream, i_lo)->i_pos;
+        size_t i_write = 0;
+
+        for (size_t i = i_lo; i < stream->i_blocks && i_write < HTTPD_CL_BUFSIZE; i++) {
+            block_t *p_dup = block_Share(&httpd_StreamBlockAt(stream, i)->p_block);
+            if (unlikely(p_dup == NULL))
+                break;
+
+            p_dup->p_buffer += i_skip;
+            p_dup->i_buffer -= i_skip;
+            i_skip = 0;
+            i_write += p_dup->i_buffer;
+            block_ChainLastAppend(&pp_last, p_dup);
+        }
+        vlc_mutex_unlock(&stream->lock);
 
-        /* Don't go past the end of the circular buffer */
-        i_write = __MIN(i_write, stream->i_buffer_size - i_pos);
+        if (i_write == 0) {
+            block_ChainRelease(p_chain);
+            return VLC_EGENERIC;    /* wait, no data available */
+        }
 
         /* using HTTPD_MSG_ANSWER -> data available */
         answer->i_proto  = HTTPD_PROTO_HTTP;
         answer->i_version= 0;
         answer->i_type   = HTTPD_MSG_ANSWER;
 
-        answer->i_body = i_write;
-        answer->p_body = xmalloc(i_write);
-        memcpy(answer->p_body, &stream->p_buffer[i_pos], i_write);
+        assert(cl->p_chain == NULL && !cl->b_chunked);
+        cl->p_chain = p_chain;
 
         answer->i_body_offset += i_write;
 
         return VLC_SUCCESS;
+wait:
+        vlc_mutex_unlock(&stream->lock);
+        return VLC_EGENERIC;
     } else {
         answer->i_proto  = HTTPD_PROTO_HTTP;
         answer->i_version= 0;
@@ -764,8 +1039,12 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
 
     stream->i_header = 0;
     stream->p_header = NULL;
+    stream->p_blocks = NULL;
+    stream->i_blocks_alloc = 0;
+    stream->i_blocks_first = 0;
+    stream->i_blocks = 0;
     stream->i_buffer_size = 5000000;    /* 5 Mo per stream */
-    stream->p_buffer = xmalloc(stream->i_buffer_size);
+    stream->i_buffer = 0;
     /* We set to 1 to make life simpler
      * (this way i_body_offset can never be 0) */
     stream->i_buffer_pos = 1;
@@ -801,22 +1080,63 @@ int httpd_StreamHeader(httpd_stream_t *stream, uint8_t *p_data, int i_data)
     return VLC_SUCCESS;
 }
 
-static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data)
+static int httpd_AppendData(httpd_stream_t *stream, const uint8_t *p_data,
+                            size_t i_data)
 {
-    int i_pos = stream->i_buffer_pos % stream->i_buffer_size;
-    int i_count = i_data;
-    while (i_count > 0) {
-        int i_copy = __MIN(i_count, stream->i_buffer_size - i_pos);
+    block_t *p_last = NULL;
 
-        /* Ok, we can't go past the end of our buffer */
-        memcpy(&stream->p_buffer[i_pos], p_data, i_copy);
+    if (stream->i_blocks > 0)
+        p_last = httpd_StreamBlockAt(stream, stream->i_blocks - 1)->p_block;
 
-        i_pos = (i_pos + i_copy) % stream->i_buffer_size;
-        i_count -= i_copy;
-        p_data  += i_copy;
+    if (p_last != NULL && block_IsWritable(p_last) &&
+        (size_t)(p_last->p_start + p_last->i_size -
+                 (p_last->p_buffer + p_last->i_buffer)) >= i_data) {
+        /* no client holds the last block yet: gather the data in it */
+        memcpy(p_last->p_buffer + p_last->i_buffer, p_data, i_data);
+        p_last->i_buffer += i_data;
+    } else {
+        if (stream->i_blocks == stream->i_blocks_alloc) {
+            size_t i_alloc = stream->i_blocks_alloc ? 2 * stream->i_blocks_alloc : 64;
+            struct httpd_stream_block *p_blocks =
+                vlc_alloc(i_alloc, sizeof(*p_blocks));
+            if (unlikely(p_blocks == NULL))
+                return VLC_ENOMEM;
+
+            for (size_t i = 0; i < stream->i_blocks; i++)
+                p_blocks[i] = *httpd_StreamBlockAt(stream, i);
+            free(stream->p_blocks);
+            stream->p_blocks = p_blocks;
+            stream->i_blocks_alloc = i_alloc;
+            stream->i_blocks_first = 0;
+        }
+
+        block_t *p_block = block_Alloc(__MAX(i_data, HTTPD_STREAM_BLOCK));
+        if (unlikely(p_block == NULL))
+            return VLC_ENOMEM;
+        memcpy(p_block->p_buffer, p_data, i_data);
+        p_block->i_buffer = i_data;
+
+        struct httpd_stream_block *p_new =
+            httpd_StreamBlockAt(stream, stream->i_blocks++);
+        p_new->i_pos = stream->i_buffer_pos;
+        p_new->p_block = p_block;
+        stream->i_buffer += p_block->i_size;
     }
 
     stream->i_buffer_pos += i_data;
+
+    /* Forget the oldest blocks. The clients sending them keep their own
+     * references, so this never waits for them. */
+    while (stream->i_blocks > 1 && stream->i_buffer > stream->i_buffer_size) {
+        struct httpd_stream_block *p_first = httpd_StreamBlockAt(stream, 0);
+
+        stream->i_buffer -= p_first->p_block->i_size;
+        block_Release(p_first->p_block);
+        stream->i_blocks_first = (stream->i_blocks_first + 1)
+                               % stream->i_blocks_alloc;
+        stream->i_blocks--;
+    }
+    return VLC_SUCCESS;
 }
 
 int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
@@ -826,18 +1146,21 @@ int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
 
     vlc_mutex_lock(&stream->lock);
 
-    /* save this pointer (to be used by new connection) */
-    stream->i_buffer_last_pos = stream->i_buffer_pos;
+    int64_t i_pos = stream->i_buffer_pos;
+    int i_ret = httpd_AppendData(stream, p_block->p_buffer, p_block->i_buffer);
 
-    if (p_block->i_flags & BLOCK_FLAG_TYPE_I) {
-        stream->b_has_keyframes = true;
-        stream->i_last_keyframe_seen_pos = stream->i_buffer_pos;
-    }
+    if (i_ret == VLC_SUCCESS) {
+        /* save this pointer (to be used by new connection) */
+        stream->i_buffer_last_pos = i_pos;
 
-    httpd_AppendData(stream, p_block->p_buffer, p_block->i_buffer);
+        if (p_block->i_flags & BLOCK_FLAG_TYPE_I) {
+            stream->b_has_keyframes = true;
+            stream->i_last_keyframe_seen_pos = i_pos;
+        }
+    }
 
     vlc_mutex_unlock(&stream->lock);
-    return VLC_SUCCESS;
+    return i_ret;
 }
 
 void httpd_StreamDelete(httpd_stream_t *stream)
@@ -851,7 +1174,9 @@ void httpd_StreamDelete(httpd_stream_t *stream)
     vlc_mutex_destroy(&stream->lock);
     free(stream->psz_mime);
     free(stream->p_header);
-    free(stream->p_buffer);
+    for (size_t i = 0; i < stream->i_blocks; i++)
+        block_Release(httpd_StreamBlockAt(stream, i)->p_block);
+    free(stream->p_blocks);
     free(stream);
 }
 
@@ -1194,8 +1519,14 @@ static void httpd_ClientInit(httpd_client_t *cl)
     cl->i_buffer_size = HTTPD_CL_BUFSIZE;
     cl->i_buffer = 0;
     cl->p_buffer = xmalloc(cl->i_buffer_size);
+    cl->p_chain = NULL;
+    cl->i_file_fd = -1;
     cl->i_keyframe_wait_to_pass = -1;
     cl->b_stream_mode = false;
+    cl->b_chunked = false;
+    cl->b_chunked_end = false;
+    cl->b_ready = false;
+    cl->i_poll = -1;
 
     httpd_MsgInit(&cl->query);
     httpd_MsgInit(&cl->answer);
@@ -1211,12 +1542,67 @@ char* httpd_ServerIP(const httpd_client_t *cl, char *ip, int *port)
     return net_GetSockAddress(vlc_tls_GetFD(cl->sock), ip, port) ? NULL : ip;
 }
 
+void httpd_ClientStream(httpd_client_t *cl, httpd_message_t *answer)
+{
+    cl->b_stream_mode = true;
+    cl->b_chunked = cl->query.i_proto == HTTPD_PROTO_HTTP &&
+                    cl->query.i_version > 0;
+    cl->b_chunked_end = false;
+
+    answer->i_proto = HTTPD_PROTO_HTTP;
+    answer->i_version = cl->b_chunked ? 1 : 0;
+    if (cl->b_chunked)
+        httpd_MsgAdd(answer, "Transfer-Encoding", "chunked");
+    else
+        httpd_MsgAdd(answer, "Connection", "close");
+}
+
+/* Moves the answer body to the send buffer, framing it as a chunk if needed */
+static void httpd_ClientSendBody(httpd_client_t *cl)
+{
+    uint8_t *p_body = cl->answer.p_body;
+    int i_body = cl->answer.i_body;
+
+    if (cl->b_chunked) {
+        bool b_last = cl->answer.i_body_offset == 0;
+        uint8_t *p = xmalloc(i_body + 20);
+        int i = 0;
+
+        if (i_body > 0) {
+            i = sprintf((char *)p, "%x\r\n", i_body);
+            memcpy(&p[i], p_body, i_body);
+            i += i_body;
+            memcpy(&p[i], "\r\n", 2);
+            i += 2;
+        }
+        if (b_last) {
+            memcpy(&p[i], "0\r\n\r\n", 5);
+            i += 5;
+            cl->b_chunked_end = true;
+        }
+        free(p_body);
+        p_body = p;
+        i_body = i;
+    }
+
+    free(cl->p_buffer);
+    cl->p_buffer = p_body;
+    cl->i_buffer_size = i_body;
+    cl->i_buffer = 0;
+
+    cl->answer.i_body = 0;
+    cl->answer.p_body = NULL;
+}
+
 static void httpd_ClientDestroy(httpd_client_t *cl)
 {
     vlc_tls_Close(cl->sock);
     httpd_MsgClean(&cl->answer);
     httpd_MsgClean(&cl->query);
 
+    block_ChainRelease(cl->p_chain);
+    if (cl->i_file_fd != -1)
+        vlc_close(cl->i_file_fd);
     free(cl->p_buffer);
     free(cl);
 }
@@ -1251,6 +1637,40 @@ ssize_t httpd_NetSend (httpd_client_t *cl, const uint8_t *p, size_t i_len)
     return sock->writev(sock, &iov, 1);
 }
 
+/* Sends the shared stream blocks without copying them, and releases what
+ * has been sent */
+static
+ssize_t httpd_NetSendChain (httpd_client_t *cl)
+{
+    vlc_tls_t *sock = cl->sock;
+    struct iovec iov[16];
+    int i_iov = 0;
+
+    for (block_t *b = cl->p_chain; b != NULL && i_iov < 16; b = b->p_next) {
+        iov[i_iov].iov_base = b->p_buffer;
+        iov[i_iov].iov_len = b->i_buffer;
+        i_iov++;
+    }
+
+    ssize_t i_len = sock->writev(sock, iov, i_iov);
+    if (i_len < 0)
+        return i_len;
+
+    size_t i_sent = i_len;
+    while (cl->p_chain != NULL && i_sent >= cl->p_chain->i_buffer) {
+        block_t *p_next = cl->p_chain->p_next;
+
+        i_sent -= cl->p_chain->i_buffer;
+        block_Release(cl->p_chain);
+        cl->p_chain = p_next;
+    }
+    if (i_sent > 0) {
+        cl->p_chain->p_buffer += i_sent;
+        cl->p_chain->i_buffer -= i_sent;
+    }
+    return i_len;
+}
+
 
 static const struct
 {
@@ -1599,8 +2019,12 @@ static int httpd_ClientSend(httpd_client_t *cl)
         cl->i_buffer_size = (uint8_t*)p - cl->p_buffer;
     }
 
-    i_len = httpd_NetSend(cl, &cl->p_buffer[cl->i_buffer],
-                           cl->i_buffer_size - cl->i_buffer);
+    bool b_chain = cl->i_buffer >= cl->i_buffer_size && cl->p_chain != NULL;
+    if (b_chain)
+        i_len = httpd_NetSendChain(cl);
+    else
+        i_len = httpd_NetSend(cl, &cl->p_buffer[cl->i_buffer],
+                               cl->i_buffer_size - cl->i_buffer);
 
     if (i_len < 0) {
 #if defined(_WIN32)
@@ -1615,9 +2039,10 @@ static int httpd_ClientSend(httpd_client_t *cl)
         return 0;
     }
 
-    cl->i_buffer += i_len;
+    if (!b_chain)
+        cl->i_buffer += i_len;
 
-    if (cl->i_buffer >= cl->i_buffer_size) {
+    if (cl->i_buffer >= cl->i_buffer_size && cl->p_chain == NULL) {
         if (cl->answer.i_body == 0  && cl->answer.i_body_offset > 0) {
             /* catch more body data */
             int     i_msg = cl->query.i_type;
@@ -1630,15 +2055,11 @@ static int httpd_ClientSend(httpd_client_t *cl)
                                      &cl->answer, &cl->query);
         }
 
-        if (cl->answer.i_body > 0) {
-            /* send the body data */
-            free(cl->p_buffer);
-            cl->p_buffer = cl->answer.p_body;
-            cl->i_buffer_size = cl->answer.i_body;
-            cl->i_buffer = 0;
-
-            cl->answer.i_body = 0;
-            cl->answer.p_body = NULL;
+        if (cl->answer.i_body > 0 || cl->p_chain != NULL ||
+            (cl->b_chunked && !cl->b_chunked_end &&
+             cl->answer.i_body_offset == 0)) {
+            /* send the body data, or the last chunk */
+            httpd_ClientSendBody(cl);
         } else /* send finished */
             cl->i_state = HTTPD_CLIENT_SEND_DONE;
     }
@@ -1718,14 +2139,23 @@ static void httpdLoop(httpd_host_t *host)
     int canc = vlc_savecancel();
     for (int i_client = 0; i_client < host->i_client; i_client++) {
         httpd_client_t *cl = host->client[i_client];
+        const uint8_t i_state = cl->i_state;
         int val = -1;
 
+        /* Only try the clients that poll() reported or that changed state,
+         * rather than making a system call for every client whenever any of
+         * them is ready. TLS sessions may hold data that poll() cannot see. */
+        bool b_try = cl->b_ready || host->p_tls != NULL;
+        cl->b_ready = false;
+
         switch (cl->i_state) {
             case HTTPD_CLIENT_RECEIVING:
-                val = httpd_ClientRecv(cl);
+                if (b_try)
+                    val = httpd_ClientRecv(cl);
                 break;
             case HTTPD_CLIENT_SENDING:
-                val = httpd_ClientSend(cl);
+                if (b_try)
+                    val = httpd_ClientSend(cl);
                 break;
             case HTTPD_CLIENT_TLS_HS_IN:
             case HTTPD_CLIENT_TLS_HS_OUT:
@@ -1927,7 +2357,15 @@ static void httpdLoop(httpd_host_t *host)
                     else
                         do_close = true;
 
+                    /* the end of a streamed body is the end of the connection,
+                     * unless it was chunked */
+                    if (cl->b_stream_mode && !cl->b_chunked)
+                        do_close = true;
+
                     if (!do_close) {
+                        cl->b_stream_mode = false;
+                        cl->b_chunked = false;
+                        cl->b_chunked_end = false;
                         httpd_MsgClean(&cl->query);
                         httpd_MsgInit(&cl->query);
 
@@ -1965,18 +2403,20 @@ static void httpdLoop(httpd_host_t *host)
                         &cl->answer, &cl->query);
                 if (cl->answer.i_type != HTTPD_MSG_NONE) {
                     /* we have new data, so re-enter send mode */
-                    cl->i_buffer      = 0;
-                    cl->p_buffer      = cl->answer.p_body;
-                    cl->i_buffer_size = cl->answer.i_body;
-                    cl->answer.p_body = NULL;
-                    cl->answer.i_body = 0;
+                    httpd_ClientSendBody(cl);
                     cl->i_state = HTTPD_CLIENT_SENDING;
                 }
             }
         }
 
+        /* a client that changed state gets a try right away */
+        if (cl->i_state != i_state) {
+            cl->b_ready = true;
+            delay = 0;
+        }
+
         if (pufd->events != 0)
-            nfd++;
+            cl->i_poll = nfd++;
         /* we will wait 20ms (not too big) if HTTPD_CLIENT_WAITING */
         else if (delay != 0)
             delay = 20;
@@ -1995,6 +2435,18 @@ static void httpdLoop(httpd_host_t *host)
 
     now = mdate();
 
+    /* Remember which clients are ready (some may have been deleted
+     * meanwhile, but the others kept their place in the poll() set) */
+    for (int i_client = 0; i_client < host->i_client; i_client++) {
+        httpd_client_t *cl = host->client[i_client];
+
+        if (cl->i_poll >= 0 && (unsigned)cl->i_poll < nfd
+         && ufd[cl->i_poll].fd == vlc_tls_GetFD(cl->sock)
+         && ufd[cl->i_poll].revents != 0)
+            cl->b_ready = true;
+        cl->i_poll = -1;
+    }
+
     /* Handle server sockets (accept new connections) */
     for (nfd = 0; nfd < host->nfd; nfd++) {
         httpd_client_t *cl;
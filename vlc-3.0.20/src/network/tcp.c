@@ -60,6 +60,326 @@ static int SocksHandshakeTCP( vlc_object_t *,
 extern int net_Socket( vlc_object_t *p_this, int i_family, int i_socktype,
                        int i_protocol );
 
+/* Delay between two connection attempts (RFC 8305 section 5) */
+#define CONNECT_ATTEMPT_DELAY (CLOCK_FREQ / 4)
+
+/* Lifetime of the resolver cache entries. getaddrinfo() does not expose
+ * the record TTL, so keep this short. */
+#define DNS_CACHE_TTL  (30 * CLOCK_FREQ)
+#define DNS_CACHE_SIZE 16
+
+struct net_addr
+{
+    int family;
+    int socktype;
+    int protocol;
+    socklen_t addrlen;
+    struct sockaddr_storage addr;
+};
+
+static struct
+{
+    char *host;
+    int port;
+    int type;
+    int proto;
+    vlc_tick_t expiry;
+    struct addrinfo *res;
+} dns_cache[DNS_CACHE_SIZE];
+static vlc_mutex_t dns_cache_lock = VLC_STATIC_MUTEX;
+
+/**
+ * Copies a resolved address list, interleaving the address families
+ * starting with the first (preferred) one, as per RFC 8305 section 4.
+ */
+static struct net_addr *net_SortAddresses(const struct addrinfo *res,
+                                          size_t *restrict countp)
+{
+    size_t count = 0;
+
+    for (const struct addrinfo *ptr = res; ptr != NULL; ptr = ptr->ai_next)
+        if (ptr->ai_addrlen <= sizeof (struct sockaddr_storage))
+            count++;
+
+    struct net_addr *tab = vlc_alloc(count, sizeof (*tab));
+    if (unlikely(tab == NULL))
+        return NULL;
+
+    const int family = res->ai_family;
+    const struct addrinfo *a = res, *b = res;
+    bool preferred = true;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const struct addrinfo *ptr;
+
+        while (a != NULL && (a->ai_family != family
+                 || a->ai_addrlen > sizeof (struct sockaddr_storage)))
+            a = a->ai_next;
+        while (b != NULL && (b->ai_family == family
+                 || b->ai_addrlen > sizeof (struct sockaddr_storage)))
+            b = b->ai_next;
+
+        if ((preferred && a != NULL) || b == NULL)
+        {
+            ptr = a;
+            a = a->ai_next;
+        }
+        else
+        {
+            ptr = b;
+            b = b->ai_next;
+        }
+        preferred = !preferred;
+
+        tab[i].family = ptr->ai_family;
+        tab[i].socktype = ptr->ai_socktype;
+        tab[i].protocol = ptr->ai_protocol;
+        tab[i].addrlen = ptr->ai_addrlen;
+        memcpy(&tab[i].addr, ptr->ai_addr, ptr->ai_addrlen);
+    }
+
+    *countp = count;
+    return tab;
+}
+
+static bool dns_cache_match(size_t i, const char *host, int port,
+                            int type, int proto)
+{
+    return host != NULL && dns_cache[i].host != NULL
+        && dns_cache[i].port == port
+        && dns_cache[i].type == type && dns_cache[i].proto == proto
+        && !strcmp(dns_cache[i].host, host);
+}
+
+static void dns_cache_clear(size_t i)
+{
+    free(dns_cache[i].host);
+    dns_cache[i].host = NULL;
+    if (dns_cache[i].res != NULL)
+        freeaddrinfo(dns_cache[i].res);
+    dns_cache[i].res = NULL;
+}
+
+/**
+ * Resolves a host name, going through a small process-wide cache so that
+ * successive connections to the same server do not wait for the resolver.
+ * @return 0 on success, a getaddrinfo() error otherwise.
+ */
+static int net_Resolve(const char *host, int port, int type, int proto,
+                       struct net_addr **restrict tabp,
+                       size_t *restrict countp)
+{
+    vlc_tick_t now = mdate();
+    size_t slot = 0;
+
+    vlc_mutex_lock(&dns_cache_lock);
+    for (size_t i = 0; i < DNS_CACHE_SIZE; i++)
+    {
+        if (dns_cache[i].host != NULL && dns_cache[i].expiry <= now)
+            dns_cache_clear(i);
+
+        if (dns_cache_match(i, host, port, type, proto))
+        {
+            *tabp = net_SortAddresses(dns_cache[i].res, countp);
+            vlc_mutex_unlock(&dns_cache_lock);
+            return (*tabp != NULL) ? 0 : EAI_MEMORY;
+        }
+
+        /* Reuse a free slot, or else the one expiring first */
+        if (dns_cache[slot].host != NULL
+         && (dns_cache[i].host == NULL
+          || dns_cache[i].expiry < dns_cache[slot].expiry))
+            slot = i;
+    }
+    vlc_mutex_unlock(&dns_cache_lock);
+
+    struct addrinfo hints = {
+        .ai_socktype = type,
+        .ai_protocol = proto,
+        .ai_flags = AI_NUMERICSERV | AI_IDN,
+    }, *res;
+
+    int val = vlc_getaddrinfo_i11e(host, port, &hints, &res);
+    if (val)
+        return val;
+
+    *tabp = net_SortAddresses(res, countp);
+    if (unlikely(*tabp == NULL))
+    {
+        freeaddrinfo(res);
+        return EAI_MEMORY;
+    }
+
+    char *name = (host != NULL) ? strdup(host) : NULL;
+    if (name == NULL)
+    {
+        freeaddrinfo(res);
+        return 0;
+    }
+
+    vlc_mutex_lock(&dns_cache_lock);
+    /* Another thread may have resolved the same name in the meantime */
+    for (size_t i = 0; i < DNS_CACHE_SIZE; i++)
+        if (dns_cache_match(i, host, port, type, proto))
+            slot = i;
+    dns_cache_clear(slot);
+    dns_cache[slot].host = name;
+    dns_cache[slot].port = port;
+    dns_cache[slot].type = type;
+    dns_cache[slot].proto = proto;
+    dns_cache[slot].expiry = mdate() + DNS_CACHE_TTL;
+    dns_cache[slot].res = res;
+    vlc_mutex_unlock(&dns_cache_lock);
+    return 0;
+}
+
+/**
+ * Drops a cached resolution, e.g. when none of its addresses is reachable.
+ */
+static void net_ForgetAddresses(const char *host, int port, int type,
+                                int proto)
+{
+    vlc_mutex_lock(&dns_cache_lock);
+    for (size_t i = 0; i < DNS_CACHE_SIZE; i++)
+        if (dns_cache_match(i, host, port, type, proto))
+            dns_cache_clear(i);
+    vlc_mutex_unlock(&dns_cache_lock);
+}
+
+/**
+ * Connects to the first reachable address out of a list.
+ *
+ * Following RFC 8305 ("Happy Eyeballs"), a new connection attempt is started
+ * whenever the previous ones have not completed within
+ * CONNECT_ATTEMPT_DELAY, without aborting them, so that an unreachable
+ * address family does not hold the connection for the whole timeout.
+ * @return the connected socket, or -1 on error.
+ */
+static int net_ConnectAddresses(vlc_object_t *p_this,
+                                const struct net_addr *tab, size_t count)
+{
+    vlc_tick_t timeout = var_InheritInteger(p_this, "ipv4-timeout")
+                      * (CLOCK_FREQ / 1000);
+    struct pollfd *ufd = vlc_alloc(count, sizeof (*ufd));
+    vlc_tick_t *deadlines = vlc_alloc(count, sizeof (*deadlines));
+    vlc_tick_t next_attempt = mdate();
+    size_t next = 0, pending = 0;
+    int fd = -1;
+
+    if (unlikely(ufd == NULL || deadlines == NULL))
+        goto out;
+
+    for (;;)
+    {
+        vlc_tick_t now = mdate();
+
+        if (next < count && (pending == 0 || now >= next_attempt))
+        {
+            const struct net_addr *a = &tab[next++];
+            int sfd = net_Socket(p_this, a->family, a->socktype, a->protocol);
+
+            if (sfd == -1)
+            {
+                msg_Dbg(p_this, "socket error: %s",
+                        vlc_strerror_c(net_errno));
+                continue;
+            }
+
+            if (connect(sfd, (const struct sockaddr *)&a->addr, a->addrlen)
+                == 0)
+            {
+                fd = sfd;
+                break;
+            }
+
+            if (net_errno != EINPROGRESS && errno != EINTR)
+            {
+                msg_Err(p_this, "connection failed: %s",
+                        vlc_strerror_c(net_errno));
+                net_Close(sfd);
+                continue;
+            }
+
+            ufd[pending].fd = sfd;
+            ufd[pending].events = POLLOUT;
+            deadlines[pending] = now + timeout;
+            pending++;
+            next_attempt = now + CONNECT_ATTEMPT_DELAY;
+            continue;
+        }
+
+        if (pending == 0)
+            break; /* all attempts failed */
+
+        vlc_tick_t deadline = deadlines[0];
+        for (size_t i = 1; i < pending; i++)
+            if (deadlines[i] < deadline)
+                deadline = deadlines[i];
+        if (next < count && next_attempt < deadline)
+            deadline = next_attempt;
+
+        if (vlc_killed())
+            break;
+
+        if (now > deadline)
+            now = deadline;
+
+        int val = vlc_poll_i11e(ufd, pending, (deadline - now) / 1000);
+        if (val == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            msg_Err(p_this, "polling error: %s", vlc_strerror_c(net_errno));
+            break;
+        }
+
+        now = mdate();
+        for (size_t i = 0; i < pending;)
+        {
+            int sfd = ufd[i].fd;
+
+            if (ufd[i].revents)
+            {
+                /* There is NO WAY around checking SO_ERROR.
+                 * Don't ifdef it out!!! */
+                if (getsockopt(sfd, SOL_SOCKET, SO_ERROR, &val,
+                               &(socklen_t){ sizeof (val) }))
+                    val = net_errno;
+
+                if (val == 0)
+                {
+                    fd = sfd;
+                    ufd[i] = ufd[--pending];
+                    goto done;
+                }
+
+                msg_Err(p_this, "connection failed: %s", vlc_strerror_c(val));
+            }
+            else if (now >= deadlines[i])
+                msg_Warn(p_this, "connection timed out");
+            else
+            {
+                i++;
+                continue;
+            }
+
+            net_Close(sfd);
+            ufd[i] = ufd[--pending];
+            deadlines[i] = deadlines[pending];
+            /* Do not wait before trying the next address */
+            next_attempt = now;
+        }
+    }
+done:
+    while (pending > 0)
+        net_Close(ufd[--pending].fd);
+out:
+    free(deadlines);
+    free(ufd);
+    return fd;
+}
+
 #undef net_Connect
 /*****************************************************************************
  * net_Connect:
@@ -122,13 +442,10 @@ int net_Connect( vlc_object_t *p_this, const char *psz_host, int i_port,
                  i_realport );
     }
 
-    struct addrinfo hints = {
-        .ai_socktype = type,
-        .ai_protocol = proto,
-        .ai_flags = AI_NUMERICSERV | AI_IDN,
-    }, *res;
+    struct net_addr *tab;
+    size_t count;
 
-    int val = vlc_getaddrinfo_i11e(psz_realhost, i_realport, &hints, &res);
+    int val = net_Resolve(psz_realhost, i_realport, type, proto, &tab, &count);
     if (val)
     {
         msg_Err (p_this, "cannot resolve %s port %d : %s", psz_realhost,
@@ -136,83 +453,15 @@ int net_Connect( vlc_object_t *p_this, const char *psz_host, int i_port,
         free( psz_socks );
         return -1;
     }
-    free( psz_socks );
-
-    vlc_tick_t timeout = var_InheritInteger(p_this, "ipv4-timeout")
-                      * (CLOCK_FREQ / 1000);
-
-    for (struct addrinfo *ptr = res; ptr != NULL; ptr = ptr->ai_next)
-    {
-        int fd = net_Socket( p_this, ptr->ai_family,
-                             ptr->ai_socktype, ptr->ai_protocol );
-        if( fd == -1 )
-        {
-            msg_Dbg( p_this, "socket error: %s", vlc_strerror_c(net_errno) );
-            continue;
-        }
-
-        if( connect( fd, ptr->ai_addr, ptr->ai_addrlen ) )
-        {
-            if( net_errno != EINPROGRESS && errno != EINTR )
-            {
-                msg_Err( p_this, "connection failed: %s",
-                         vlc_strerror_c(net_errno) );
-                goto next_ai;
-            }
-
-            struct pollfd ufd;
-            vlc_tick_t deadline = VLC_TICK_INVALID;
 
-            ufd.fd = fd;
-            ufd.events = POLLOUT;
-            deadline = mdate() + timeout;
+    i_handle = net_ConnectAddresses(p_this, tab, count);
+    free(tab);
 
-            do
-            {
-                vlc_tick_t now = mdate();
-
-                if (vlc_killed())
-                    goto next_ai;
-
-                if (now > deadline)
-                    now = deadline;
-
-                val = vlc_poll_i11e(&ufd, 1, (deadline - now) / 1000);
-            }
-            while (val == -1 && errno == EINTR);
-
-            switch (val)
-            {
-                 case -1: /* error */
-                     msg_Err (p_this, "polling error: %s",
-                              vlc_strerror_c(net_errno));
-                     goto next_ai;
-
-                 case 0: /* timeout */
-                     msg_Warn (p_this, "connection timed out");
-                     goto next_ai;
-            }
-
-            /* There is NO WAY around checking SO_ERROR.
-             * Don't ifdef it out!!! */
-            if (getsockopt (fd, SOL_SOCKET, SO_ERROR, &val,
-                            &(socklen_t){ sizeof (val) }) || val)
-            {
-                msg_Err (p_this, "connection failed: %s",
-                         vlc_strerror_c(val));
-                goto next_ai;
-            }
-        }
-
-        msg_Dbg( p_this, "connection succeeded (socket = %d)", fd );
-        i_handle = fd; /* success! */
-        break;
-
-next_ai: /* failure */
-        net_Close( fd );
-    }
-
-    freeaddrinfo( res );
+    if (i_handle == -1)
+        net_ForgetAddresses(psz_realhost, i_realport, type, proto);
+    else
+        msg_Dbg( p_this, "connection succeeded (socket = %d)", i_handle );
+    free( psz_socks );
 
     if( i_handle == -1 )
         return -1;
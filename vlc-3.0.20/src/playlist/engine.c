@@ -264,6 +264,11 @@ playlist_t *playlist_Create( vlc_object_t *p_parent )
     pl_priv(p_playlist)->last_eos = 0;
     pl_priv(p_playlist)->eos_burst_count = 0;
     p->request.input_dead = false;
+    p->request.preroll = false;
+    p->request.preroll_dead = false;
+    p->p_preroll = NULL;
+    p->i_preroll = INT64_C(1000) * var_InheritInteger( p_playlist,
+                                                       "playlist-preroll" );
 
     if (ml != NULL)
         playlist_MLLoad( p_playlist );
@@ -353,6 +358,7 @@ void playlist_Destroy( playlist_t *p_playlist )
     assert( p_playlist->root.i_children <= 0 );
     PL_UNLOCK;
 
+    free( p_sys->search.psz_string );
     vlc_cond_destroy( &p_sys->signal );
     vlc_mutex_destroy( &p_sys->lock );
 
@@ -38,7 +38,6 @@
 #include "fetcher.h"
 #include "input/input_interface.h"
 #include "misc/background_worker.h"
-#include "misc/interrupt.h"
 
 struct playlist_fetcher_t {
     struct background_worker* local;
@@ -57,18 +56,6 @@ struct fetcher_request {
     int options;
 };
 
-struct fetcher_thread {
-    void (*pf_worker)( playlist_fetcher_t*, struct fetcher_request* );
-
-    struct background_worker* worker;
-    struct fetcher_request* req;
-    playlist_fetcher_t* fetcher;
-
-    vlc_interrupt_t interrupt;
-    vlc_thread_t thread;
-    atomic_bool active;
-};
-
 static char* CreateCacheKey( input_item_t* item )
 {
     vlc_mutex_lock( &item->lock );
@@ -189,6 +176,11 @@ static int SearchArt( playlist_fetcher_t* fetcher, input_item_t* item, int scope
     return CheckArt( item );
 }
 
+static bool IsBackground( const struct fetcher_request* req )
+{
+    return req->options & META_REQUEST_OPTION_BACKGROUND;
+}
+
 static int SearchByScope( playlist_fetcher_t* fetcher,
     struct fetcher_request* req, int scope )
 {
@@ -207,7 +199,8 @@ static int SearchByScope( playlist_fetcher_t* fetcher,
         ! SearchArt( fetcher, item, scope ) )
     {
         AddAlbumCache( fetcher, req->item, false );
-        if( !background_worker_Push( fetcher->downloader, req, NULL, 0 ) )
+        if( !background_worker_Push( fetcher->downloader, req, NULL, 0,
+                                     IsBackground( req ) ) )
             return VLC_SUCCESS;
     }
 
@@ -297,7 +290,8 @@ static void SearchLocal( playlist_fetcher_t* fetcher, struct fetcher_request* re
     if( var_InheritBool( fetcher->owner, "metadata-network-access" ) ||
         req->options & META_REQUEST_OPTION_SCOPE_NETWORK )
     {
-        if( background_worker_Push( fetcher->network, req, NULL, 0 ) )
+        if( background_worker_Push( fetcher->network, req, NULL, 0,
+                                    IsBackground( req ) ) )
             SetPreparsed( req );
     }
     else
@@ -333,80 +327,23 @@ static void RequestHold( void* req_ )
     atomic_fetch_add_explicit( &req->refs, 1, memory_order_relaxed );
 }
 
-static void* FetcherThread( void* handle )
-{
-    struct fetcher_thread* th = handle;
-    vlc_interrupt_set( &th->interrupt );
-
-    th->pf_worker( th->fetcher, th->req );
-
-    atomic_store( &th->active, false );
-    background_worker_RequestProbe( th->worker );
-    return NULL;
-}
-
-static int StartWorker( playlist_fetcher_t* fetcher,
-    void( *pf_worker )( playlist_fetcher_t*, struct fetcher_request* ),
-    struct background_worker* bg, struct fetcher_request* req, void** handle )
-{
-    struct fetcher_thread* th = malloc( sizeof *th );
-
-    if( unlikely( !th ) )
-        return VLC_ENOMEM;
-
-    th->req = req;
-    th->worker = bg;
-    th->fetcher = fetcher;
-    th->pf_worker = pf_worker;
-
-    vlc_interrupt_init( &th->interrupt );
-    atomic_init( &th->active, true );
-
-    if( !vlc_clone( &th->thread, FetcherThread, th, VLC_THREAD_PRIORITY_LOW ) )
-    {
-        *handle = th;
-        return VLC_SUCCESS;
-    }
-
-    vlc_interrupt_deinit( &th->interrupt );
-    free( th );
-    return VLC_EGENERIC;
-}
-
-static int ProbeWorker( void* fetcher_, void* th_ )
-{
-    return !atomic_load( &((struct fetcher_thread*)th_)->active );
-    VLC_UNUSED( fetcher_ );
-}
-
-static void CloseWorker( void* fetcher_, void* th_ )
-{
-    struct fetcher_thread* th = th_;
-    VLC_UNUSED( fetcher_ );
-
-    vlc_interrupt_kill( &th->interrupt );
-    vlc_join( th->thread, NULL );
-    vlc_interrupt_deinit( &th->interrupt );
-    free( th );
-}
-
-#define DEF_STARTER(name, worker) \
-static int Start ## name( void* fetcher_, void* req_, void** out ) { \
-    playlist_fetcher_t* fetcher = fetcher_; \
-    return StartWorker( fetcher, name, worker, req_, out ); }
+/* The requests run on the threads of the background workers, interrupted
+ * by them on cancellation */
+#define DEF_RUNNER(name) \
+static void Run ## name( void* fetcher, void* req ) { \
+    name( fetcher, req ); }
 
-DEF_STARTER(  SearchLocal, fetcher->local )
-DEF_STARTER(SearchNetwork, fetcher->network )
-DEF_STARTER(   Downloader, fetcher->downloader )
+DEF_RUNNER(  SearchLocal )
+DEF_RUNNER(SearchNetwork )
+DEF_RUNNER(   Downloader )
 
 static void WorkerInit( playlist_fetcher_t* fetcher,
-    struct background_worker** worker, int( *starter )( void*, void*, void** ) )
+    struct background_worker** worker, void( *runner )( void*, void* ) )
 {
     struct background_worker_config conf = {
         .default_timeout = 0,
-        .pf_start = starter,
-        .pf_probe = ProbeWorker,
-        .pf_stop = CloseWorker,
+        .max_threads = 1,
+        .pf_run = runner,
         .pf_release = RequestRelease,
         .pf_hold = RequestHold };
 
@@ -422,9 +359,9 @@ playlist_fetcher_t* playlist_fetcher_New( vlc_object_t* owner )
 
     fetcher->owner = owner;
 
-    WorkerInit( fetcher, &fetcher->local, StartSearchLocal );
-    WorkerInit( fetcher, &fetcher->network, StartSearchNetwork );
-    WorkerInit( fetcher, &fetcher->downloader, StartDownloader );
+    WorkerInit( fetcher, &fetcher->local, RunSearchLocal );
+    WorkerInit( fetcher, &fetcher->network, RunSearchNetwork );
+    WorkerInit( fetcher, &fetcher->downloader, RunDownloader );
 
     if( unlikely( !fetcher->local || !fetcher->network || !fetcher->downloader ) )
     {
@@ -462,7 +399,8 @@ int playlist_fetcher_Push( playlist_fetcher_t* fetcher, input_item_t* item,
     atomic_init( &req->refs, 1 );
     input_item_Hold( item );
 
-    if( background_worker_Push( fetcher->local, req, NULL, 0 ) )
+    if( background_worker_Push( fetcher->local, req, NULL, 0,
+                                IsBackground( req ) ) )
         SetPreparsed( req );
 
     RequestRelease( req );
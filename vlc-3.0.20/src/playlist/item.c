@@ -38,6 +38,8 @@
 #include "libvlc.h"
 
 static void playlist_Preparse( playlist_t *, playlist_item_t * );
+static void playlist_NodeAddItems( playlist_t *, playlist_item_t *,
+                                   playlist_item_t *const *, int, int );
 
 static int RecursiveAddIntoParent (
                 playlist_t *p_playlist, playlist_item_t *p_parent,
@@ -533,12 +535,7 @@ playlist_item_t * playlist_NodeAddInput( playlist_t *p_playlist,
     if( unlikely(p_item == NULL) )
         return NULL;
 
-    if( p_input->i_type != ITEM_TYPE_NODE )
-        ARRAY_APPEND(p_playlist->items, p_item);
-
-    playlist_NodeInsert( p_parent, p_item, i_pos );
-    playlist_SendAddNotify( p_playlist, p_item );
-    playlist_Preparse( p_playlist, p_item );
+    playlist_NodeAddItems( p_playlist, p_parent, &p_item, 1, i_pos );
 
     return p_item;
 }
@@ -752,6 +749,27 @@ static void playlist_Preparse( playlist_t *p_playlist,
     free( psz_album );
 }
 
+/* Insert new items into a node at once, then notify and preparse them */
+static void playlist_NodeAddItems( playlist_t *p_playlist,
+                                   playlist_item_t *p_parent,
+                                   playlist_item_t *const *pp_items,
+                                   int i_items, int i_pos )
+{
+    PL_ASSERT_LOCKED;
+
+    for( int i = 0; i < i_items; i++ )
+        if( pp_items[i]->p_input->i_type != ITEM_TYPE_NODE )
+            ARRAY_APPEND(p_playlist->items, pp_items[i]);
+
+    playlist_NodeInsertItems( p_parent, pp_items, i_items, i_pos );
+
+    for( int i = 0; i < i_items; i++ )
+    {
+        playlist_SendAddNotify( p_playlist, pp_items[i] );
+        playlist_Preparse( p_playlist, pp_items[i] );
+    }
+}
+
 /* Actually convert an item to a node */
 static void ChangeToNode( playlist_t *p_playlist, playlist_item_t *p_item )
 {
@@ -784,41 +802,64 @@ static int RecursiveAddIntoParent (
 
     if( i_pos == PLAYLIST_END ) i_pos = p_parent->i_children;
 
-    for( int i = 0; i < p_node->i_children; i++ )
+    for( int i = 0; i < p_node->i_children; )
     {
         input_item_node_t *p_child_node = p_node->pp_children[i];
 
-        playlist_item_t *p_new_item = NULL;
-        bool b_children = p_child_node->i_children > 0;
-
-        //Create the playlist item represented by input node, if allowed.
-        if( !(b_flat && b_children) )
+        //If flat, insert the children of the node instead of the node itself,
+        //continuing from the current position
+        if( b_flat && p_child_node->i_children > 0 )
         {
-            p_new_item = playlist_NodeAddInput( p_playlist,
-                                                p_child_node->p_item,
-                                                p_parent, i_pos );
-            if( !p_new_item ) return i_pos;
+            playlist_item_t *p_leaf;
+            i_pos = RecursiveAddIntoParent( p_playlist, p_parent, p_child_node,
+                                            i_pos, true, &p_leaf );
+            if( i == 0 ) *pp_first_leaf = p_leaf;
+            i++;
+            continue;
+        }
+
+        //Create the playlist items of the following input nodes that are
+        //represented by an item, and insert them at once
+        int i_run = 1;
+        while( i + i_run < p_node->i_children &&
+               !( b_flat && p_node->pp_children[i + i_run]->i_children > 0 ) )
+            i_run++;
 
-            i_pos++;
+        playlist_item_t **pp_new_items = vlc_alloc( i_run, sizeof( *pp_new_items ) );
+        if( unlikely(pp_new_items == NULL) )
+            return i_pos;
+
+        int i_new_items = 0;
+        while( i_new_items < i_run )
+        {
+            input_item_t *p_input = p_node->pp_children[i + i_new_items]->p_item;
+            pp_new_items[i_new_items] = playlist_ItemNewFromInput( p_playlist, p_input );
+            if( unlikely(pp_new_items[i_new_items] == NULL) )
+                break;
+            i_new_items++;
         }
-        //Recurse if any children
-        if( b_children )
+
+        playlist_NodeAddItems( p_playlist, p_parent, pp_new_items, i_new_items,
+                               i_pos );
+        i_pos += i_new_items;
+
+        for( int j = 0; j < i_new_items; j++ )
         {
-            //Substitute p_new_item for first child leaf
-            //(If flat, continue counting from current position)
-            int i_last_pos = RecursiveAddIntoParent(
-                    p_playlist,
-                    p_new_item ? p_new_item : p_parent,
-                    p_child_node,
-                    ( b_flat ? i_pos : 0 ),
-                    b_flat,
-                    &p_new_item );
-            //If flat, take position after recursion as current position
-            if( b_flat ) i_pos = i_last_pos;
+            playlist_item_t *p_new_item = pp_new_items[j];
+            p_child_node = p_node->pp_children[i + j];
+
+            //Recurse if any children, substituting p_new_item for first child leaf
+            if( p_child_node->i_children > 0 )
+                RecursiveAddIntoParent( p_playlist, p_new_item, p_child_node,
+                                        0, b_flat, &p_new_item );
+
+            if( i + j == 0 ) *pp_first_leaf = p_new_item;
         }
+        free( pp_new_items );
 
-        assert( p_new_item != NULL );
-        if( i == 0 ) *pp_first_leaf = p_new_item;
+        if( i_new_items < i_run )
+            return i_pos;
+        i += i_run;
     }
     return i_pos;
 }
@@ -58,6 +58,9 @@ typedef struct playlist_private_t
     input_thread_t *      p_input;  /**< the input thread associated
                                      * with the current item */
     input_resource_t *   p_input_resource; /**< input resources */
+    input_thread_t *      p_preroll; /**< the input thread opened
+                                      * ahead for the next item */
+    vlc_tick_t            i_preroll; /**< preroll time, or 0 */
     vlc_renderer_item_t *p_renderer;
     struct {
         /* Current status. These fields are readonly, only the playlist
@@ -77,6 +80,8 @@ typedef struct playlist_private_t
                                            The playlist sets it back to false
                                            when processing the request */
         bool input_dead; /**< Set when input has finished. */
+        bool preroll; /**< Set when the next item should be opened. */
+        bool preroll_dead; /**< Set when prerolled input has finished. */
     } request;
 
     vlc_thread_t thread; /**< engine thread */
@@ -88,6 +93,12 @@ typedef struct playlist_private_t
     int      i_last_playlist_id; /**< Last id to an item */
     bool     b_reset_currently_playing; /** Reset current item array */
 
+    struct {
+        char *psz_string; /**< Last live search string */
+        playlist_item_t *p_root; /**< Root of the last live search */
+        bool b_recursive;
+    } search;
+
     /**
      * Playing a tiny stream (either empty, or with unreported errors) in a loop
      * would cause high CPU usage. To mitigate the problem, temporize if
@@ -137,6 +148,7 @@ int playlist_InsertInputItemTree ( playlist_t *,
 
 /* Tree walking */
 int playlist_NodeInsert(playlist_item_t*, playlist_item_t *, int);
+int playlist_NodeInsertItems(playlist_item_t *, playlist_item_t *const *, int, int);
 
 /**
  * Flags for playlist_NodeDeleteExplicit
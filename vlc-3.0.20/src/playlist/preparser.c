@@ -107,7 +107,12 @@ static void PreparserCloseInput( void* preparser_, void* input_ )
 
     if( preparser->fetcher )
     {
-        if( !playlist_fetcher_Push( preparser->fetcher, item, 0, status ) )
+        vlc_mutex_lock( &item->lock );
+        input_item_meta_request_option_t options = item->b_preparse_background
+            ? META_REQUEST_OPTION_BACKGROUND : META_REQUEST_OPTION_NONE;
+        vlc_mutex_unlock( &item->lock );
+
+        if( !playlist_fetcher_Push( preparser->fetcher, item, options, status ) )
             return;
     }
 
@@ -122,8 +127,13 @@ playlist_preparser_t* playlist_preparser_New( vlc_object_t *parent )
 {
     playlist_preparser_t* preparser = malloc( sizeof *preparser );
 
+    int threads = var_InheritInteger( parent, "preparse-threads" );
+    if( threads <= 0 )
+        threads = vlc_GetCPUCount();
+
     struct background_worker_config conf = {
         .default_timeout = var_InheritInteger( parent, "preparse-timeout" ),
+        .max_threads = threads,
         .pf_start = PreparserOpenInput,
         .pf_probe = PreparserProbeInput,
         .pf_stop = PreparserCloseInput,
@@ -157,9 +167,13 @@ void playlist_preparser_Push( playlist_preparser_t *preparser,
     if( atomic_load( &preparser->deactivated ) )
         return;
 
+    bool b_background = i_options & META_REQUEST_OPTION_BACKGROUND;
+
     vlc_mutex_lock( &item->lock );
     int i_type = item->i_type;
     int b_net = item->b_net;
+    /* An interactive request takes over a pending background one */
+    item->b_preparse_background = b_background;
     vlc_mutex_unlock( &item->lock );
 
     switch( i_type )
@@ -175,7 +189,8 @@ void playlist_preparser_Push( playlist_preparser_t *preparser,
             return;
     }
 
-    if( background_worker_Push( preparser->worker, item, id, timeout ) )
+    if( background_worker_Push( preparser->worker, item, id, timeout,
+                                b_background ) )
         input_item_SignalPreparseEnded( item, ITEM_PREPARSE_FAILED );
 }
 
@@ -199,6 +214,15 @@ void playlist_preparser_Deactivate( playlist_preparser_t* preparser )
 
 void playlist_preparser_Delete( playlist_preparser_t *preparser )
 {
+    struct background_worker_stats stats;
+
+    background_worker_GetStats( preparser->worker, &stats );
+    if( stats.done > 0 )
+        msg_Dbg( preparser->owner, "preparsed %"PRIu64" items, queued %"PRId64
+                 " us on average (%"PRId64" us max), parsed in %"PRId64
+                 " us on average", stats.done, stats.wait_avg, stats.wait_max,
+                 stats.run_avg );
+
     background_worker_Delete( preparser->worker );
 
     if( preparser->fetcher )
@@ -33,76 +33,141 @@
 #include "playlist_internal.h"
 
 
+/* Sort keys */
+
+enum
+{
+    SORT_META_ARTIST,
+    SORT_META_ALBUM,
+    SORT_META_DATE,
+    SORT_META_DISC_NUMBER,
+    SORT_META_TRACK_NUMBER,
+    SORT_META_DESCRIPTION,
+    SORT_META_GENRE,
+    SORT_META_RATING,
+    SORT_META_COUNT
+};
+
+static const vlc_meta_type_t sort_metas[SORT_META_COUNT] =
+{
+    [SORT_META_ARTIST]       = vlc_meta_Artist,
+    [SORT_META_ALBUM]        = vlc_meta_Album,
+    [SORT_META_DATE]         = vlc_meta_Date,
+    [SORT_META_DISC_NUMBER]  = vlc_meta_DiscNumber,
+    [SORT_META_TRACK_NUMBER] = vlc_meta_TrackNumber,
+    [SORT_META_DESCRIPTION]  = vlc_meta_Description,
+    [SORT_META_GENRE]        = vlc_meta_Genre,
+    [SORT_META_RATING]       = vlc_meta_Rating,
+};
+
+/**
+ * Values compared by the sorting functions. They are read once per item
+ * before sorting, so that comparisons neither lock the input items nor
+ * copy their meta data.
+ */
+typedef struct
+{
+    const playlist_item_t *p_item;
+    char *psz_title; /**< title, or name if the title is empty */
+    char *psz_uri;
+    char *ppsz_meta[SORT_META_COUNT];
+    vlc_tick_t i_duration;
+} sort_key_t;
+
+static inline char *sort_strdup( const char *psz )
+{
+    return psz ? strdup( psz ) : NULL;
+}
+
+static void sort_key_Init( sort_key_t *p_key, const playlist_item_t *p_item )
+{
+    input_item_t *p_input = p_item->p_input;
+    const vlc_meta_t *p_meta;
+
+    p_key->p_item = p_item;
+
+    vlc_mutex_lock( &p_input->lock );
+    p_meta = p_input->p_meta;
+
+    const char *psz_title = p_meta ? vlc_meta_Get( p_meta, vlc_meta_Title ) : NULL;
+    if( EMPTY_STR( psz_title ) )
+        psz_title = p_input->psz_name;
+    p_key->psz_title = sort_strdup( psz_title );
+    p_key->psz_uri = sort_strdup( p_input->psz_uri );
+    for( unsigned i = 0; i < SORT_META_COUNT; i++ )
+        p_key->ppsz_meta[i] = p_meta ? sort_strdup( vlc_meta_Get( p_meta, sort_metas[i] ) )
+                                     : NULL;
+    p_key->i_duration = p_input->i_duration;
+
+    vlc_mutex_unlock( &p_input->lock );
+}
+
+static void sort_key_Clean( sort_key_t *p_key )
+{
+    free( p_key->psz_title );
+    free( p_key->psz_uri );
+    for( unsigned i = 0; i < SORT_META_COUNT; i++ )
+        free( p_key->ppsz_meta[i] );
+}
+
 /* General comparison functions */
 /**
- * Compare two items using their title or name
- * @param first: the first item
- * @param second: the second item
+ * Compare two strings, missing ones going last
+ * @param psz_first: the first string
+ * @param psz_second: the second string
+ * @param b_integer: true if the strings are integers
  * @return -1, 0 or 1 like strcmp
  */
-static inline int meta_strcasecmp_title( const playlist_item_t *first,
-                              const playlist_item_t *second )
+static inline int sort_strcasecmp( const char *psz_first, const char *psz_second,
+                                   bool b_integer )
 {
-    int i_ret;
-    char *psz_first = input_item_GetTitleFbName( first->p_input );
-    char *psz_second = input_item_GetTitleFbName( second->p_input );
-
     if( psz_first && psz_second )
-        i_ret = strcasecmp( psz_first, psz_second );
+        return b_integer ? atoi( psz_first ) - atoi( psz_second )
+                         : strcasecmp( psz_first, psz_second );
     else if( !psz_first && psz_second )
-        i_ret = 1;
+        return 1;
     else if( psz_first && !psz_second )
-        i_ret = -1;
+        return -1;
     else
-        i_ret = 0;
-    free( psz_first );
-    free( psz_second );
+        return 0;
+}
 
-    return i_ret;
+/**
+ * Compare two items using their title or name
+ * @param first: the first item
+ * @param second: the second item
+ * @return -1, 0 or 1 like strcmp
+ */
+static inline int meta_strcasecmp_title( const sort_key_t *first,
+                              const sort_key_t *second )
+{
+    return sort_strcasecmp( first->psz_title, second->psz_title, false );
 }
 
 /**
  * Compare two intems according to the given meta type
  * @param first: the first item
  * @param second: the second item
- * @param meta: the meta type to use to sort the items
+ * @param meta: the SORT_META_* index of the meta to use to sort the items
  * @param b_integer: true if the meta are integers
  * @return -1, 0 or 1 like strcmp
  */
-static inline int meta_sort( const playlist_item_t *first,
-                             const playlist_item_t *second,
-                             vlc_meta_type_t meta, bool b_integer )
+static inline int meta_sort( const sort_key_t *first,
+                             const sort_key_t *second,
+                             unsigned meta, bool b_integer )
 {
-    int i_ret;
-    char *psz_first = input_item_GetMeta( first->p_input, meta );
-    char *psz_second = input_item_GetMeta( second->p_input, meta );
-
     /* Nodes go first */
-    if( first->i_children == -1 && second->i_children >= 0 )
-        i_ret = 1;
-    else if( first->i_children >= 0 && second->i_children == -1 )
-       i_ret = -1;
+    if( first->p_item->i_children == -1 && second->p_item->i_children >= 0 )
+        return 1;
+    else if( first->p_item->i_children >= 0 && second->p_item->i_children == -1 )
+        return -1;
     /* Both are nodes, sort by name */
-    else if( first->i_children >= 0 && second->i_children >= 0 )
-        i_ret = meta_strcasecmp_title( first, second );
+    else if( first->p_item->i_children >= 0 && second->p_item->i_children >= 0 )
+        return meta_strcasecmp_title( first, second );
     /* Both are items */
-    else if( !psz_first && !psz_second )
-        i_ret = 0;
-    else if( !psz_first && psz_second )
-        i_ret = 1;
-    else if( psz_first && !psz_second )
-        i_ret = -1;
     else
-    {
-        if( b_integer )
-            i_ret = atoi( psz_first ) - atoi( psz_second );
-        else
-            i_ret = strcasecmp( psz_first, psz_second );
-    }
-
-    free( psz_first );
-    free( psz_second );
-    return i_ret;
+        return sort_strcasecmp( first->ppsz_meta[meta], second->ppsz_meta[meta],
+                                b_integer );
 }
 
 /* Comparison functions */
@@ -128,15 +193,32 @@ static inline sortfn_t find_sorting_fn( unsigned i_mode, unsigned i_type )
  * @param i_items: number of items
  * @param pp_items: the array of items
  * @param p_sortfn: the sorting function
- * @return nothing
+ * @return VLC_SUCCESS, or VLC_ENOMEM if the array was left unsorted
  */
 static inline
-void playlist_ItemArraySort( unsigned i_items, playlist_item_t **pp_items,
-                             sortfn_t p_sortfn )
+int playlist_ItemArraySort( unsigned i_items, playlist_item_t **pp_items,
+                            sortfn_t p_sortfn )
 {
     if( p_sortfn )
     {
-        qsort( pp_items, i_items, sizeof( pp_items[0] ), p_sortfn );
+        if( i_items < 2 )
+            return VLC_SUCCESS;
+
+        sort_key_t *p_keys = vlc_alloc( i_items, sizeof( *p_keys ) );
+        if( unlikely(p_keys == NULL) )
+            return VLC_ENOMEM;
+
+        for( unsigned i = 0; i < i_items; i++ )
+            sort_key_Init( &p_keys[i], pp_items[i] );
+
+        qsort( p_keys, i_items, sizeof( p_keys[0] ), p_sortfn );
+
+        for( unsigned i = 0; i < i_items; i++ )
+        {
+            pp_items[i] = (playlist_item_t *)p_keys[i].p_item;
+            sort_key_Clean( &p_keys[i] );
+        }
+        free( p_keys );
     }
     else /* Randomise */
     {
@@ -152,6 +234,7 @@ void playlist_ItemArraySort( unsigned i_items, playlist_item_t **pp_items,
             pp_items[i_new] = p_temp;
         }
     }
+    return VLC_SUCCESS;
 }
 
 
@@ -167,15 +250,17 @@ static int recursiveNodeSort( playlist_t *p_playlist, playlist_item_t *p_node,
                               sortfn_t p_sortfn )
 {
     int i;
-    playlist_ItemArraySort(p_node->i_children,p_node->pp_children,p_sortfn);
+    int i_ret = playlist_ItemArraySort( p_node->i_children, p_node->pp_children,
+                                        p_sortfn );
     for( i = 0 ; i< p_node->i_children; i++ )
     {
-        if( p_node->pp_children[i]->i_children != -1 )
+        if( p_node->pp_children[i]->i_children != -1 &&
+            recursiveNodeSort( p_playlist, p_node->pp_children[i], p_sortfn ) )
         {
-            recursiveNodeSort( p_playlist, p_node->pp_children[i], p_sortfn );
+            i_ret = VLC_ENOMEM;
         }
     }
-    return VLC_SUCCESS;
+    return i_ret;
 }
 
 /**
@@ -204,7 +289,7 @@ int playlist_RecursiveNodeSort( playlist_t *p_playlist, playlist_item_t *p_node,
 
 /* This is the stuff the sorting functions are made of. The proto_##
  * functions are wrapped in cmp_a_## and cmp_d_## functions that do
- * void * to const playlist_item_t * casting and dereferencing and
+ * void * to const sort_key_t * casting and
  * cmp_d_## inverts the result, too. proto_## are static inline,
  * cmp_[ad]_## are merely static as they're the target of pointers.
  *
@@ -213,16 +298,16 @@ int playlist_RecursiveNodeSort( playlist_t *p_playlist, playlist_item_t *p_node,
  */
 
 #define SORTFN( SORT, first, second ) static inline int proto_##SORT \
-    ( const playlist_item_t *first, const playlist_item_t *second )
+    ( const sort_key_t *first, const sort_key_t *second )
 
 SORTFN( SORT_TRACK_NUMBER, first, second )
 {
-    return meta_sort( first, second, vlc_meta_TrackNumber, true );
+    return meta_sort( first, second, SORT_META_TRACK_NUMBER, true );
 }
 
 SORTFN( SORT_DISC_NUMBER, first, second )
 {
-    int i_ret = meta_sort( first, second, vlc_meta_DiscNumber, true );
+    int i_ret = meta_sort( first, second, SORT_META_DISC_NUMBER, true );
     /* Items came from the same disc: compare the track numbers */
     if( i_ret == 0 )
         i_ret = proto_SORT_TRACK_NUMBER( first, second );
@@ -232,7 +317,7 @@ SORTFN( SORT_DISC_NUMBER, first, second )
 
 SORTFN( SORT_ALBUM, first, second )
 {
-    int i_ret = meta_sort( first, second, vlc_meta_Album, false );
+    int i_ret = meta_sort( first, second, SORT_META_ALBUM, false );
     /* Items came from the same album: compare the disc numbers */
     if( i_ret == 0 )
         i_ret = proto_SORT_DISC_NUMBER( first, second );
@@ -242,7 +327,7 @@ SORTFN( SORT_ALBUM, first, second )
 
 SORTFN( SORT_DATE, first, second )
 {
-    int i_ret = meta_sort( first, second, vlc_meta_Date, true );
+    int i_ret = meta_sort( first, second, SORT_META_DATE, true );
     /* Items came from the same date: compare the albums */
     if( i_ret == 0 )
         i_ret = proto_SORT_ALBUM( first, second );
@@ -252,7 +337,7 @@ SORTFN( SORT_DATE, first, second )
 
 SORTFN( SORT_ARTIST, first, second )
 {
-    int i_ret = meta_sort( first, second, vlc_meta_Artist, false );
+    int i_ret = meta_sort( first, second, SORT_META_ARTIST, false );
     /* Items came from the same artist: compare the dates */
     if( i_ret == 0 )
         i_ret = proto_SORT_DATE( first, second );
@@ -262,13 +347,13 @@ SORTFN( SORT_ARTIST, first, second )
 
 SORTFN( SORT_DESCRIPTION, first, second )
 {
-    return meta_sort( first, second, vlc_meta_Description, false );
+    return meta_sort( first, second, SORT_META_DESCRIPTION, false );
 }
 
 SORTFN( SORT_DURATION, first, second )
 {
-    vlc_tick_t time1 = input_item_GetDuration( first->p_input );
-    vlc_tick_t time2 = input_item_GetDuration( second->p_input );
+    vlc_tick_t time1 = first->i_duration;
+    vlc_tick_t time2 = second->i_duration;
     int i_ret = time1 > time2 ? 1 :
                     ( time1 == time2 ? 0 : -1 );
     return i_ret;
@@ -276,17 +361,17 @@ SORTFN( SORT_DURATION, first, second )
 
 SORTFN( SORT_GENRE, first, second )
 {
-    return meta_sort( first, second, vlc_meta_Genre, false );
+    return meta_sort( first, second, SORT_META_GENRE, false );
 }
 
 SORTFN( SORT_ID, first, second )
 {
-    return first->i_id - second->i_id;
+    return first->p_item->i_id - second->p_item->i_id;
 }
 
 SORTFN( SORT_RATING, first, second )
 {
-    return meta_sort( first, second, vlc_meta_Rating, true );
+    return meta_sort( first, second, SORT_META_RATING, true );
 }
 
 SORTFN( SORT_TITLE, first, second )
@@ -297,10 +382,10 @@ SORTFN( SORT_TITLE, first, second )
 SORTFN( SORT_TITLE_NODES_FIRST, first, second )
 {
     /* If first is a node but not second */
-    if( first->i_children == -1 && second->i_children >= 0 )
+    if( first->p_item->i_children == -1 && second->p_item->i_children >= 0 )
         return -1;
     /* If second is a node but not first */
-    else if( first->i_children >= 0 && second->i_children == -1 )
+    else if( first->p_item->i_children >= 0 && second->p_item->i_children == -1 )
         return 1;
     /* Both are nodes or both are not nodes */
     else
@@ -309,42 +394,12 @@ SORTFN( SORT_TITLE_NODES_FIRST, first, second )
 
 SORTFN( SORT_TITLE_NUMERIC, first, second )
 {
-    int i_ret;
-    char *psz_first = input_item_GetTitleFbName( first->p_input );
-    char *psz_second = input_item_GetTitleFbName( second->p_input );
-
-    if( psz_first && psz_second )
-        i_ret = atoi( psz_first ) - atoi( psz_second );
-    else if( !psz_first && psz_second )
-        i_ret = 1;
-    else if( psz_first && !psz_second )
-        i_ret = -1;
-    else
-        i_ret = 0;
-
-    free( psz_first );
-    free( psz_second );
-    return i_ret;
+    return sort_strcasecmp( first->psz_title, second->psz_title, true );
 }
 
 SORTFN( SORT_URI, first, second )
 {
-    int i_ret;
-    char *psz_first = input_item_GetURI( first->p_input );
-    char *psz_second = input_item_GetURI( second->p_input );
-
-    if( psz_first && psz_second )
-        i_ret = strcasecmp( psz_first, psz_second );
-    else if( !psz_first && psz_second )
-        i_ret = 1;
-    else if( psz_first && !psz_second )
-        i_ret = -1;
-    else
-        i_ret = 0;
-
-    free( psz_first );
-    free( psz_second );
-    return i_ret;
+    return sort_strcasecmp( first->psz_uri, second->psz_uri, false );
 }
 
 #undef  SORTFN
@@ -359,11 +414,9 @@ SORTFN( SORT_URI, first, second )
 
 #define DEF( s ) \
     static int cmp_a_##s(const void *l,const void *r) \
-    { return proto_##s(*(const playlist_item_t *const *)l, \
-                           *(const playlist_item_t *const *)r); } \
+    { return proto_##s((const sort_key_t *)l, (const sort_key_t *)r); } \
     static int cmp_d_##s(const void *l,const void *r) \
-    { return -1*proto_##s(*(const playlist_item_t * const *)l, \
-                              *(const playlist_item_t * const *)r); }
+    { return -1*proto_##s((const sort_key_t *)l, (const sort_key_t *)r); }
 
     VLC_DEFINE_SORT_FUNCTIONS
 
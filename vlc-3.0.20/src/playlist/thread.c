@@ -96,19 +96,75 @@ static int InputEvent( vlc_object_t *p_this, char const *psz_cmd,
 {
     VLC_UNUSED(p_this); VLC_UNUSED(psz_cmd); VLC_UNUSED(oldval);
     playlist_t *p_playlist = p_data;
+    playlist_private_t *sys = pl_priv(p_playlist);
 
     if( newval.i_int == INPUT_EVENT_DEAD )
     {
-        playlist_private_t *sys = pl_priv(p_playlist);
-
         PL_LOCK;
         sys->request.input_dead = true;
         vlc_cond_signal( &sys->signal );
         PL_UNLOCK;
     }
+    else if( newval.i_int == INPUT_EVENT_POSITION && sys->i_preroll > 0 )
+    {
+        input_thread_t *p_input = (input_thread_t *)p_this;
+        vlc_tick_t i_length = var_GetInteger( p_input, "length" );
+        vlc_tick_t i_time = var_GetInteger( p_input, "time" );
+
+        if( i_length > 0 && i_length - i_time <= sys->i_preroll )
+        {
+            PL_LOCK;
+            if( !sys->request.preroll )
+            {
+                sys->request.preroll = true;
+                vlc_cond_signal( &sys->signal );
+            }
+            PL_UNLOCK;
+        }
+    }
+    return VLC_SUCCESS;
+}
+
+/* Prerolled input Callback */
+static int PrerollEvent( vlc_object_t *p_this, char const *psz_cmd,
+                         vlc_value_t oldval, vlc_value_t newval, void *p_data )
+{
+    VLC_UNUSED(p_this); VLC_UNUSED(psz_cmd); VLC_UNUSED(oldval);
+    playlist_t *p_playlist = p_data;
+
+    if( newval.i_int == INPUT_EVENT_DEAD )
+    {
+        PL_LOCK;
+        pl_priv(p_playlist)->request.preroll_dead = true;
+        PL_UNLOCK;
+    }
     return VLC_SUCCESS;
 }
 
+/**
+ * Stop and destroy the prerolled input, if any.
+ *
+ * The playlist lock must be held, it is released meanwhile.
+ */
+static void DiscardPreroll( playlist_t *p_playlist )
+{
+    playlist_private_t *p_sys = pl_priv(p_playlist);
+    input_thread_t *p_preroll = p_sys->p_preroll;
+
+    PL_ASSERT_LOCKED;
+
+    if( p_preroll == NULL )
+        return;
+    p_sys->p_preroll = NULL;
+    PL_UNLOCK;
+
+    msg_Dbg( p_playlist, "discarding prerolled input" );
+    input_Stop( p_preroll );
+    var_DelCallback( p_preroll, "intf-event", PrerollEvent, p_playlist );
+    input_Close( p_preroll );
+    PL_LOCK;
+}
+
 /**
  * Synchronise the current index of the playlist
  * to match the index of the current item.
@@ -210,16 +266,44 @@ static bool PlayItem( playlist_t *p_playlist, playlist_item_t *p_item )
     if( p_renderer )
         vlc_renderer_item_hold( p_renderer );
     assert( p_sys->p_input == NULL );
+
+    input_thread_t *p_input_thread = NULL;
+    if( p_sys->p_preroll != NULL )
+    {
+        if( input_GetItem( p_sys->p_preroll ) == p_input )
+        {
+            p_input_thread = p_sys->p_preroll;
+            p_sys->p_preroll = NULL;
+        }
+        else
+            DiscardPreroll( p_playlist );
+    }
     PL_UNLOCK;
 
     libvlc_MetadataCancel( p_playlist->obj.libvlc, p_item );
 
-    input_thread_t *p_input_thread = input_Create( p_playlist, p_input, NULL,
-                                                   p_sys->p_input_resource,
-                                                   p_renderer );
+    const bool b_prerolled = p_input_thread != NULL;
+    if( b_prerolled )
+    {
+        msg_Dbg( p_playlist, "using prerolled input" );
+        /* Add the callback first, so that no end event can be lost */
+        var_AddCallback( p_input_thread, "intf-event",
+                         InputEvent, p_playlist );
+        var_DelCallback( p_input_thread, "intf-event",
+                         PrerollEvent, p_playlist );
+        input_EndPreroll( p_input_thread );
+
+        PL_LOCK;
+        if( p_sys->request.preroll_dead )
+            p_sys->request.input_dead = true;
+        PL_UNLOCK;
+    }
+    else
+        p_input_thread = input_Create( p_playlist, p_input, NULL,
+                                       p_sys->p_input_resource, p_renderer );
     if( p_renderer )
         vlc_renderer_item_release( p_renderer );
-    if( likely(p_input_thread != NULL) )
+    if( likely(p_input_thread != NULL) && !b_prerolled )
     {
         var_AddCallback( p_input_thread, "intf-event",
                          InputEvent, p_playlist );
@@ -421,10 +505,80 @@ static playlist_item_t *NextItem( playlist_t *p_playlist )
     return p_new;
 }
 
+/**
+ * Guess the item NextItem() will pick once the current one ends, without
+ * changing the playlist state. Only the plain forward course is handled.
+ */
+static playlist_item_t *PeekNextItem( playlist_t *p_playlist )
+{
+    playlist_private_t *p_sys = pl_priv(p_playlist);
+
+    PL_ASSERT_LOCKED;
+
+    if( p_sys->request.b_request || p_sys->b_reset_currently_playing )
+        return NULL;
+    if( var_GetBool( p_playlist, "repeat" )
+     || var_InheritBool( p_playlist, "play-and-stop" ) )
+        return NULL;
+
+    int i_next = p_playlist->i_current_index + 1;
+    if( i_next < 0 || i_next >= p_playlist->current.i_size )
+        return NULL;
+    return ARRAY_VAL( p_playlist->current, i_next );
+}
+
+/**
+ * Open the next item while the current one is still playing.
+ */
+static void Preroll( playlist_t *p_playlist )
+{
+    playlist_private_t *p_sys = pl_priv(p_playlist);
+
+    PL_ASSERT_LOCKED;
+
+    /* Stream outputs cannot be shared by two inputs */
+    if( p_sys->p_preroll != NULL || p_sys->p_renderer != NULL )
+        return;
+
+    playlist_item_t *p_item = PeekNextItem( p_playlist );
+    if( p_item == NULL )
+        return;
+
+    input_item_t *p_input = p_item->p_input;
+    input_item_Hold( p_input );
+    p_sys->request.preroll_dead = false;
+    PL_UNLOCK;
+
+    msg_Dbg( p_playlist, "prerolling next item" );
+    input_thread_t *p_preroll = input_CreatePreroll( VLC_OBJECT(p_playlist),
+                                                     p_input,
+                                                     p_sys->p_input_resource,
+                                                     NULL );
+    input_item_Release( p_input );
+    if( p_preroll != NULL )
+    {
+        char *psz_sout = var_GetNonEmptyString( p_preroll, "sout" );
+        free( psz_sout );
+
+        var_AddCallback( p_preroll, "intf-event", PrerollEvent, p_playlist );
+        if( psz_sout != NULL || input_Start( p_preroll ) )
+        {
+            var_DelCallback( p_preroll, "intf-event",
+                             PrerollEvent, p_playlist );
+            input_Close( p_preroll );
+            p_preroll = NULL;
+        }
+    }
+
+    PL_LOCK;
+    p_sys->p_preroll = p_preroll;
+}
+
 static bool LoopInput( playlist_t *p_playlist )
 {
     playlist_private_t *p_sys = pl_priv(p_playlist);
     input_thread_t *p_input = p_sys->p_input;
+    bool b_prerolled = false;
 
     assert( p_input != NULL );
 
@@ -436,6 +590,12 @@ static bool LoopInput( playlist_t *p_playlist )
             PL_DEBUG( "incoming request - stopping current input" );
             input_Stop( p_input );
         }
+        else if( p_sys->request.preroll && !b_prerolled )
+        {
+            b_prerolled = true;
+            Preroll( p_playlist );
+            continue;
+        }
         vlc_cond_wait( &p_sys->signal, &p_sys->lock );
     }
 
@@ -447,6 +607,7 @@ static bool LoopInput( playlist_t *p_playlist )
     PL_DEBUG( "dead input" );
     p_sys->p_input = NULL;
     p_sys->request.input_dead = false;
+    p_sys->request.preroll = false;
     PL_UNLOCK;
 
     var_SetAddress( p_playlist, "input-current", NULL );
@@ -527,6 +688,7 @@ static void *Thread ( void *data )
         }
 
         /* Playlist stopping */
+        DiscardPreroll( p_playlist );
         msg_Dbg( p_playlist, "nothing to play" );
         if( played && var_InheritBool( p_playlist, "play-and-exit" ) )
         {
@@ -148,18 +148,44 @@ void playlist_NodeDeleteExplicit( playlist_t *p_playlist,
 
 int playlist_NodeInsert( playlist_item_t *p_parent, playlist_item_t *p_item,
                          int i_position )
+{
+    return playlist_NodeInsertItems( p_parent, &p_item, 1, i_position );
+}
+
+/**
+ * Insert several items at once in a node, growing its children array once
+ */
+int playlist_NodeInsertItems( playlist_item_t *p_parent,
+                              playlist_item_t *const *pp_items, int i_items,
+                              int i_position )
 {
     assert( p_parent && p_parent->i_children != -1 );
     if( i_position == -1 ) i_position = p_parent->i_children ;
     assert( i_position <= p_parent->i_children);
 
-    TAB_INSERT(p_parent->i_children, p_parent->pp_children,
-               p_item, i_position);
-    p_item->p_parent = p_parent;
+    if( i_items <= 0 )
+        return VLC_SUCCESS;
 
-    /* Inherit special flags from parent (sd cases) */
-    if( ( p_parent->i_flags & PLAYLIST_NO_INHERIT_FLAG ) == 0 )
-        p_item->i_flags |= (p_parent->i_flags & PLAYLIST_RO_FLAG);
+    playlist_item_t **pp_children =
+        realloc( p_parent->pp_children,
+                 ( p_parent->i_children + i_items ) * sizeof( *pp_children ) );
+    if( unlikely(pp_children == NULL) )
+        abort();
+    memmove( pp_children + i_position + i_items, pp_children + i_position,
+             ( p_parent->i_children - i_position ) * sizeof( *pp_children ) );
+    memcpy( pp_children + i_position, pp_items, i_items * sizeof( *pp_children ) );
+    p_parent->pp_children = pp_children;
+    p_parent->i_children += i_items;
+
+    for( int i = 0; i < i_items; i++ )
+    {
+        playlist_item_t *p_item = pp_items[i];
+        p_item->p_parent = p_parent;
+
+        /* Inherit special flags from parent (sd cases) */
+        if( ( p_parent->i_flags & PLAYLIST_NO_INHERIT_FLAG ) == 0 )
+            p_item->i_flags |= (p_parent->i_flags & PLAYLIST_RO_FLAG);
+    }
 
     return VLC_SUCCESS;
 }
@@ -1,5 +1,5 @@
 /*****************************************************************************
- * timer.c: simple threaded timer
+ * timer.c: shared threaded timers
  *****************************************************************************
  * Copyright (C) 2009-2012 Rémi Denis-Courmont
  *
@@ -22,7 +22,6 @@
 # include "config.h"
 #endif
 
-#include <stdnoreturn.h>
 #include <stdlib.h>
 #include <errno.h>
 #include <assert.h>
@@ -30,80 +29,299 @@
 #include <vlc_common.h>
 #include <vlc_atomic.h>
 
+#include "libvlc.h"
+
 /*
  * POSIX timers are essentially unusable from a library: there provide no safe
  * way to ensure that a timer has no pending/ongoing iteration. Furthermore,
  * they typically require one thread per timer plus one thread per iteration,
  * which is inefficient and overkill (unless you need multiple iteration
  * of the same timer concurrently).
- * Thus, this is a generic manual implementation of timers using a thread.
+ * Thus, this is a generic manual implementation of timers. All timers share
+ * one dispatcher thread, which sleeps until the earliest deadline, and a
+ * small pool of threads running the callbacks. The threads exist only while
+ * at least one timer does.
+ * Callbacks may block (some poll devices or the network): if every pooled
+ * thread is busy and a due timer has waited for too long, the dispatcher
+ * starts a temporary extra thread, which exits once the queue is empty.
  */
 
+/* Number of pooled threads running the callbacks */
+#define TIMER_WORKERS_MAX 4
+
+/* How long a due timer may wait for a busy pool before an extra thread */
+#define TIMER_WORKERS_DELAY (CLOCK_FREQ / 100)
+
+/* Deadlines closer than this are served by a single wake-up: a timer can
+ * fire this late so that the dispatcher sleeps longer */
+#ifndef VLC_TIMER_SLACK
+# define VLC_TIMER_SLACK (CLOCK_FREQ / 1000)
+#endif
+
 struct vlc_timer
 {
-    vlc_thread_t thread;
-    vlc_cond_t   reschedule;
-    vlc_mutex_t  lock;
+    /* Armed timers, sorted by deadline */
+    struct vlc_timer *prev, *next;
+    /* Timers due, waiting for a worker */
+    struct vlc_timer *queue_next;
+
     void       (*func) (void *);
     void        *data;
     vlc_tick_t   value, interval;
+    vlc_tick_t   queued_at;
     atomic_uint  overruns;
+
+    bool         queued;
+    bool         running;
+    bool         pending; /* fired again while running */
 };
 
-noreturn static void *vlc_timer_thread (void *data)
+static struct
+{
+    vlc_mutex_t lock;
+    bool        initialized;
+    vlc_cond_t  reschedule; /* dispatcher */
+    vlc_cond_t  work; /* workers */
+    vlc_cond_t  idle; /* a callback returned or the threads stopped */
+
+    struct vlc_timer *armed;
+    struct vlc_timer *queue, **queue_tail;
+
+    unsigned    users;
+    bool        started;
+    bool        stopping;
+    vlc_thread_t dispatcher;
+    vlc_thread_t workers[TIMER_WORKERS_MAX];
+    unsigned    worker_count;
+    unsigned    idle_workers;
+    unsigned    extra_workers; /* detached, exit when the queue is empty */
+    vlc_tick_t  spawned_at; /* last worker thread start */
+} service = { .lock = VLC_STATIC_MUTEX };
+
+static void vlc_timer_unarm (struct vlc_timer *timer)
+{
+    if (timer->prev != NULL)
+        timer->prev->next = timer->next;
+    else if (service.armed == timer)
+        service.armed = timer->next;
+    else
+        return; /* not armed */
+    if (timer->next != NULL)
+        timer->next->prev = timer->prev;
+    timer->prev = timer->next = NULL;
+}
+
+/* Returns true if the timer is the first to fire */
+static bool vlc_timer_arm (struct vlc_timer *timer)
+{
+    struct vlc_timer *prev = NULL, *next = service.armed;
+
+    while (next != NULL && next->value <= timer->value)
+    {
+        prev = next;
+        next = next->next;
+    }
+
+    timer->prev = prev;
+    timer->next = next;
+    if (next != NULL)
+        next->prev = timer;
+    if (prev != NULL)
+        prev->next = timer;
+    else
+        service.armed = timer;
+    return prev == NULL;
+}
+
+static void vlc_timer_enqueue (struct vlc_timer *timer)
+{
+    assert (!timer->queued);
+    timer->queued = true;
+    timer->queued_at = mdate ();
+    timer->queue_next = NULL;
+    *service.queue_tail = timer;
+    service.queue_tail = &timer->queue_next;
+}
+
+static void vlc_timer_dequeue (struct vlc_timer *timer)
 {
-    struct vlc_timer *timer = data;
+    struct vlc_timer **pp = &service.queue;
 
-    vlc_mutex_lock (&timer->lock);
-    mutex_cleanup_push (&timer->lock);
+    while (*pp != timer)
+        pp = &(*pp)->queue_next;
+    *pp = timer->queue_next;
+    if (service.queue_tail == &timer->queue_next)
+        service.queue_tail = pp;
+    timer->queued = false;
+}
 
-    for (;;)
+static void *vlc_timer_worker (void *data)
+{
+    bool extra = data != NULL;
+
+    vlc_affinity_Unpin ();
+
+    vlc_mutex_lock (&service.lock);
+    while (!service.stopping)
     {
-        while (timer->value == 0)
+        struct vlc_timer *timer = service.queue;
+
+        if (timer == NULL)
         {
-            assert(timer->interval == 0);
-            vlc_cond_wait (&timer->reschedule, &timer->lock);
+            if (extra)
+                break;
+            service.idle_workers++;
+            vlc_cond_wait (&service.work, &service.lock);
+            service.idle_workers--;
+            continue;
         }
 
-        if (timer->interval != 0)
-        {
-            vlc_tick_t now = mdate();
+        vlc_timer_dequeue (timer);
+        timer->running = true;
+        vlc_mutex_unlock (&service.lock);
 
-            if (now > timer->value)
-            {   /* Update overrun counter */
-                unsigned misses = (now - timer->value) / timer->interval;
+        timer->func (timer->data);
 
-                timer->value += misses * timer->interval;
-                assert(timer->value <= now);
-                atomic_fetch_add_explicit(&timer->overruns, misses,
-                                          memory_order_relaxed);
-            }
+        vlc_mutex_lock (&service.lock);
+        timer->running = false;
+        if (timer->pending)
+        {
+            timer->pending = false;
+            vlc_timer_enqueue (timer);
         }
+        vlc_cond_broadcast (&service.idle);
+    }
+    if (extra)
+    {
+        service.extra_workers--;
+        vlc_cond_broadcast (&service.idle);
+    }
+    vlc_mutex_unlock (&service.lock);
+    return NULL;
+}
 
-        vlc_tick_t value = timer->value;
+/* When the pool should be considered stuck, if it is busy */
+static vlc_tick_t vlc_timer_stall_deadline (void)
+{
+    vlc_tick_t since = service.queue->queued_at;
 
-        if (vlc_cond_timedwait(&timer->reschedule, &timer->lock, value) == 0)
-            continue;
+    /* At most one thread start per delay: the last started thread may not
+     * have dequeued the timer yet */
+    if (since < service.spawned_at)
+        since = service.spawned_at;
+    return since + TIMER_WORKERS_DELAY;
+}
 
-        if (likely(timer->value <= value))
+/* Starts a thread for the due timers if none is available */
+static void vlc_timer_wake_worker (vlc_tick_t now)
+{
+    if (service.idle_workers == 0)
+    {
+        if (service.worker_count < TIMER_WORKERS_MAX)
         {
-            timer->value += timer->interval; /* rearm */
+            service.spawned_at = now;
+            if (vlc_clone (&service.workers[service.worker_count],
+                           vlc_timer_worker, NULL,
+                           VLC_THREAD_PRIORITY_INPUT) == 0)
+                service.worker_count++;
+        }
+        else if (vlc_timer_stall_deadline () <= now)
+        {   /* The whole pool is stuck in callbacks */
+            vlc_thread_t th;
 
-            if (timer->interval == 0)
-                timer->value = 0; /* disarm */
+            service.spawned_at = now;
+            if (vlc_clone_detach (&th, vlc_timer_worker, &service,
+                                  VLC_THREAD_PRIORITY_INPUT) == 0)
+                service.extra_workers++;
         }
+    }
+    vlc_cond_signal (&service.work);
+}
 
-        vlc_mutex_unlock (&timer->lock);
+static void vlc_timer_fire (struct vlc_timer *timer, vlc_tick_t now)
+{
+    if (timer->interval != 0)
+    {
+        if (now > timer->value)
+        {   /* Update overrun counter */
+            unsigned misses = (now - timer->value) / timer->interval;
 
-        int canc = vlc_savecancel ();
-        timer->func (timer->data);
-        vlc_restorecancel (canc);
+            timer->value += misses * timer->interval;
+            assert(timer->value <= now);
+            atomic_fetch_add_explicit(&timer->overruns, misses,
+                                      memory_order_relaxed);
+        }
+        timer->value += timer->interval; /* rearm */
+        vlc_timer_arm (timer);
+    }
+    else
+        timer->value = 0; /* disarm */
 
-        vlc_mutex_lock (&timer->lock);
+    if (timer->queued)
+        return;
+    if (timer->running)
+    {   /* Serialize the occurrences of a timer */
+        if (timer->interval != 0)
+            atomic_fetch_add_explicit(&timer->overruns, 1,
+                                      memory_order_relaxed);
+        else
+            timer->pending = true;
+        return;
     }
+    vlc_timer_enqueue (timer);
+}
+
+static void *vlc_timer_dispatcher (void *data)
+{
+    (void) data;
+
+    vlc_affinity_Unpin ();
+
+    vlc_mutex_lock (&service.lock);
+    while (!service.stopping)
+    {
+        struct vlc_timer *timer = service.armed;
+        vlc_tick_t deadline = INT64_MAX;
+
+        if (timer != NULL)
+        {   /* Coalesce the deadlines within the slack into one wake-up */
+            deadline = timer->value;
+            for (struct vlc_timer *t = timer->next;
+                 t != NULL && t->value <= timer->value + VLC_TIMER_SLACK;
+                 t = t->next)
+                deadline = t->value;
+        }
 
-    vlc_cleanup_pop ();
-    vlc_assert_unreachable ();
+        /* Check again for a busy pool when the first due timer overstays */
+        if (service.queue != NULL && service.idle_workers == 0
+         && vlc_timer_stall_deadline () < deadline)
+            deadline = vlc_timer_stall_deadline ();
+
+        if (deadline == INT64_MAX)
+        {
+            vlc_cond_wait (&service.reschedule, &service.lock);
+            continue;
+        }
+
+        if (vlc_cond_timedwait (&service.reschedule, &service.lock,
+                                deadline) == 0)
+            continue; /* rescheduled */
+
+        vlc_tick_t now = mdate ();
+        if (now < deadline)
+            now = deadline;
+
+        while ((timer = service.armed) != NULL && timer->value <= now)
+        {
+            vlc_timer_unarm (timer);
+            vlc_timer_fire (timer, now);
+        }
+
+        if (service.queue != NULL)
+            vlc_timer_wake_worker (now);
+    }
+    vlc_mutex_unlock (&service.lock);
+    return NULL;
 }
 
 int vlc_timer_create (vlc_timer_t *id, void (*func) (void *), void *data)
@@ -112,23 +330,40 @@ int vlc_timer_create (vlc_timer_t *id, void (*func) (void *), void *data)
 
     if (unlikely(timer == NULL))
         return ENOMEM;
-    vlc_mutex_init (&timer->lock);
-    vlc_cond_init (&timer->reschedule);
     assert (func);
+    timer->prev = timer->next = timer->queue_next = NULL;
     timer->func = func;
     timer->data = data;
     timer->value = 0;
     timer->interval = 0;
     atomic_init(&timer->overruns, 0);
+    timer->queued = timer->running = timer->pending = false;
 
-    if (vlc_clone (&timer->thread, vlc_timer_thread, timer,
-                   VLC_THREAD_PRIORITY_INPUT))
+    vlc_mutex_lock (&service.lock);
+    if (!service.initialized)
     {
-        vlc_cond_destroy (&timer->reschedule);
-        vlc_mutex_destroy (&timer->lock);
-        free (timer);
-        return ENOMEM;
+        vlc_cond_init (&service.reschedule);
+        vlc_cond_init (&service.work);
+        vlc_cond_init (&service.idle);
+        service.queue_tail = &service.queue;
+        service.initialized = true;
+    }
+    while (service.stopping)
+        vlc_cond_wait (&service.idle, &service.lock);
+
+    if (!service.started)
+    {
+        if (vlc_clone (&service.dispatcher, vlc_timer_dispatcher, NULL,
+                       VLC_THREAD_PRIORITY_INPUT))
+        {
+            vlc_mutex_unlock (&service.lock);
+            free (timer);
+            return ENOMEM;
+        }
+        service.started = true;
     }
+    service.users++;
+    vlc_mutex_unlock (&service.lock);
 
     *id = timer;
     return 0;
@@ -136,10 +371,36 @@ int vlc_timer_create (vlc_timer_t *id, void (*func) (void *), void *data)
 
 void vlc_timer_destroy (vlc_timer_t timer)
 {
-    vlc_cancel (timer->thread);
-    vlc_join (timer->thread, NULL);
-    vlc_cond_destroy (&timer->reschedule);
-    vlc_mutex_destroy (&timer->lock);
+    vlc_mutex_lock (&service.lock);
+    vlc_timer_unarm (timer);
+    if (timer->queued)
+        vlc_timer_dequeue (timer);
+    timer->pending = false;
+    while (timer->running)
+        vlc_cond_wait (&service.idle, &service.lock);
+
+    assert (service.users > 0);
+    if (--service.users == 0)
+    {   /* Last timer: stop the threads */
+        service.stopping = true;
+        vlc_cond_signal (&service.reschedule);
+        vlc_cond_broadcast (&service.work);
+        vlc_mutex_unlock (&service.lock);
+
+        vlc_join (service.dispatcher, NULL);
+        for (unsigned i = 0; i < service.worker_count; i++)
+            vlc_join (service.workers[i], NULL);
+
+        vlc_mutex_lock (&service.lock);
+        while (service.extra_workers > 0)
+            vlc_cond_wait (&service.idle, &service.lock);
+        assert (service.armed == NULL && service.queue == NULL);
+        service.worker_count = 0;
+        service.started = false;
+        service.stopping = false;
+        vlc_cond_broadcast (&service.idle);
+    }
+    vlc_mutex_unlock (&service.lock);
     free (timer);
 }
 
@@ -152,11 +413,14 @@ void vlc_timer_schedule (vlc_timer_t timer, bool absolute,
     if (!absolute)
         value += mdate();
 
-    vlc_mutex_lock (&timer->lock);
+    vlc_mutex_lock (&service.lock);
+    vlc_timer_unarm (timer);
+    timer->pending = false;
     timer->value = value;
     timer->interval = interval;
-    vlc_cond_signal (&timer->reschedule);
-    vlc_mutex_unlock (&timer->lock);
+    if (value != 0 && vlc_timer_arm (timer))
+        vlc_cond_signal (&service.reschedule);
+    vlc_mutex_unlock (&service.lock);
 }
 
 unsigned vlc_timer_getoverrun (vlc_timer_t timer)
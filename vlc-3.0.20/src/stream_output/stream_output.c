@@ -965,5 +965,9 @@ rtp:
 #undef sout_EncoderCreate
 encoder_t *sout_EncoderCreate( vlc_object_t *p_this )
 {
-    return vlc_custom_create( p_this, sizeof( encoder_t ), "encoder" );
+    encoder_t *p_enc = vlc_custom_create( p_this, sizeof( encoder_t ),
+                                          "encoder" );
+    if( p_enc != NULL )
+        p_enc->i_delay = -1;
+    return p_enc;
 }
@@ -86,11 +86,212 @@ static void test_block (void)
     //assert (block == NULL);
 }
 
+static void test_block_pool (void)
+{
+    block_pool_stats_t before, after;
+    block_t *blocks[64];
+
+    block_PoolGetStats (&before);
+
+    for (unsigned i = 0; i < 64; i++)
+    {
+        blocks[i] = block_Alloc (188 + i);
+        assert (blocks[i] != NULL);
+        assert (((uintptr_t)blocks[i]->p_buffer % 32) == 0);
+        memset (blocks[i]->p_buffer, i, blocks[i]->i_buffer);
+    }
+    for (unsigned i = 0; i < 64; i++)
+        block_Release (blocks[i]);
+
+    /* Recycled blocks must behave like fresh ones */
+    for (unsigned i = 0; i < 64; i++)
+    {
+        blocks[i] = block_Alloc (sizeof (text));
+        assert (blocks[i] != NULL);
+        assert (blocks[i]->i_buffer == sizeof (text));
+        assert (blocks[i]->p_next == NULL);
+        assert (blocks[i]->i_flags == 0);
+        memcpy (blocks[i]->p_buffer, text, sizeof (text));
+        blocks[i] = block_Realloc (blocks[i], 16, sizeof (text) + 16);
+        assert (blocks[i] != NULL);
+        assert (!memcmp (blocks[i]->p_buffer + 16, text, sizeof (text)));
+    }
+    for (unsigned i = 0; i < 64; i++)
+        block_Release (blocks[i]);
+
+    block_t *big = block_Alloc (1 << 20);
+    assert (big != NULL);
+    block_Release (big);
+
+    block_PoolGetStats (&after);
+    assert (after.i_thread_hits > before.i_thread_hits);
+    assert (after.i_unpooled > before.i_unpooled);
+}
+
+static void test_block_Share (void)
+{
+    block_t *block = block_Alloc (sizeof (text));
+    assert (block != NULL);
+    memcpy (block->p_buffer, text, sizeof (text));
+    block->i_pts = 42;
+    assert (block_IsWritable (block));
+
+    block_t *orig = block;
+    block_t *dup = block_Share (&block);
+    assert (dup != NULL);
+    assert (block != orig);
+    assert (dup->p_buffer == block->p_buffer);
+    assert (dup->i_buffer == sizeof (text));
+    assert (dup->i_pts == 42);
+    assert (!block_IsWritable (block));
+    assert (!block_IsWritable (dup));
+
+    /* Sharing again does not replace the block */
+    orig = block;
+    block_t *dup2 = block_Share (&block);
+    assert (dup2 != NULL);
+    assert (block == orig);
+    assert (dup2->p_buffer == block->p_buffer);
+
+    /* Headers are independent */
+    dup2->p_buffer += 5;
+    dup2->i_buffer -= 5;
+    assert (!memcmp (dup2->p_buffer, text + 5, sizeof (text) - 5));
+    block_Release (dup2);
+
+    /* Reallocation copies the shared payload out */
+    dup = block_Realloc (dup, 4, dup->i_buffer);
+    assert (dup != NULL);
+    assert (block_IsWritable (dup));
+    assert (!memcmp (dup->p_buffer + 4, text, sizeof (text)));
+    memset (dup->p_buffer, 'X', dup->i_buffer);
+    assert (!memcmp (block->p_buffer, text, sizeof (text)));
+    block_Release (dup);
+
+    /* The last reference can modify the payload */
+    assert (block_IsWritable (block));
+    block = block_Realloc (block, 0, 4);
+    assert (block != NULL);
+    assert (block->i_buffer == 4);
+    assert (!memcmp (block->p_buffer, text, 4));
+    block_Release (block);
+}
+
+static void test_block_ShareChain (void)
+{
+    block_t *first = block_Alloc (16), *second = block_Alloc (16);
+    assert (first != NULL && second != NULL);
+    first->p_next = second;
+
+    /* The shared block takes the place of the original in the chain */
+    block_t *dup = block_Share (&first);
+    assert (dup != NULL);
+    assert (dup->p_next == NULL);
+    assert (first->p_next == second);
+    block_Release (dup);
+    block_ChainRelease (first);
+}
+
+#define FIFO_BLOCKS 20000
+
+static void fifo_queue (block_fifo_t *fifo, unsigned from, unsigned count)
+{
+    for (unsigned i = from; i < from + count; i++)
+    {
+        block_t *block = block_Alloc (i % 7);
+        assert (block != NULL);
+        block->i_dts = i;
+        vlc_fifo_Queue (fifo, block);
+    }
+}
+
+static void fifo_dequeue (block_fifo_t *fifo, unsigned from, unsigned count)
+{
+    vlc_fifo_Lock (fifo);
+    for (unsigned i = from; i < from + count; i++)
+    {
+        block_t *block = vlc_fifo_DequeueUnlocked (fifo);
+
+        /* Blocks must come out in order, whether from the ring or not */
+        assert (block != NULL);
+        assert (block->i_dts == (vlc_tick_t)i);
+        assert (block->i_buffer == i % 7);
+        block_Release (block);
+    }
+    vlc_fifo_Unlock (fifo);
+}
+
+static void *fifo_producer (void *data)
+{
+    fifo_queue (data, 0, FIFO_BLOCKS);
+    return NULL;
+}
+
+static void test_fifo_spsc (void)
+{
+    block_fifo_t *fifo = block_FifoNewSPSC ();
+    vlc_thread_t th;
+    unsigned next = 0;
+
+    assert (fifo != NULL);
+    assert (vlc_fifo_IsEmpty (fifo));
+
+    /* Overflow the ring, and queue more while it is partially drained */
+    fifo_queue (fifo, 0, 3000);
+    assert (vlc_fifo_GetCount (fifo) == 3000);
+    fifo_dequeue (fifo, 0, 1500);
+    fifo_queue (fifo, 3000, 3000);
+    fifo_dequeue (fifo, 1500, 4500);
+    assert (vlc_fifo_IsEmpty (fifo));
+    assert (vlc_fifo_GetBytes (fifo) == 0);
+
+    /* Concurrent producer and consumer */
+    if (vlc_clone (&th, fifo_producer, fifo, VLC_THREAD_PRIORITY_LOW))
+        abort ();
+
+    vlc_fifo_Lock (fifo);
+    while (next < FIFO_BLOCKS)
+    {
+        block_t *block = vlc_fifo_DequeueUnlocked (fifo);
+        if (block == NULL)
+        {
+            vlc_fifo_Wait (fifo);
+            continue;
+        }
+
+        assert (block->i_dts == (vlc_tick_t)next);
+        block_Release (block);
+        next++;
+    }
+    vlc_fifo_Unlock (fifo);
+    vlc_join (th, NULL);
+
+    assert (vlc_fifo_IsEmpty (fifo));
+    assert (vlc_fifo_GetBytes (fifo) == 0);
+
+    /* Regular queueing and flushing on a non-empty FIFO */
+    for (unsigned i = 0; i < 2000; i++)
+        block_FifoPut (fifo, block_Alloc (1));
+    vlc_fifo_Lock (fifo);
+    assert (vlc_fifo_GetCount (fifo) == 2000);
+    assert (vlc_fifo_GetBytes (fifo) == 2000);
+    vlc_fifo_Unlock (fifo);
+    block_FifoEmpty (fifo);
+    assert (vlc_fifo_IsEmpty (fifo));
+
+    fifo_queue (fifo, 0, 1);
+    block_FifoRelease (fifo);
+}
+
 int main (void)
 {
     test_block_File(false);
     test_block_File(true);
     test_block ();
+    test_block_pool ();
+    test_block_Share ();
+    test_block_ShareChain ();
+    test_fifo_spsc ();
     return 0;
 }
 
@@ -106,6 +106,48 @@ static void test(bool zombie)
             picture_Release(pics[i]);
 }
 
+#define LARGE_PICTURES 150
+
+static void *wait_thread(void *data)
+{
+    return picture_pool_Wait(data);
+}
+
+static void test_large(void)
+{
+    video_format_t small;
+    picture_t *pics[LARGE_PICTURES];
+    vlc_thread_t th;
+    void *ret;
+
+    video_format_Setup(&small, VLC_CODEC_I420, 16, 16, 16, 16, 1, 1);
+
+    pool = picture_pool_NewFromFormat(&small, LARGE_PICTURES);
+    assert(pool != NULL);
+    assert(picture_pool_GetSize(pool) == LARGE_PICTURES);
+
+    for (unsigned i = 0; i < LARGE_PICTURES; i++) {
+        pics[i] = picture_pool_Get(pool);
+        assert(pics[i] != NULL);
+        for (unsigned j = 0; j < i; j++)
+            assert(pics[j]->p[0].p_pixels != pics[i]->p[0].p_pixels);
+    }
+    assert(picture_pool_Get(pool) == NULL);
+
+    /* A waiter is woken up by the release of a picture beyond 64 */
+    void *plane = pics[LARGE_PICTURES - 1]->p[0].p_pixels;
+    assert(vlc_clone(&th, wait_thread, pool, VLC_THREAD_PRIORITY_LOW) == 0);
+    picture_Release(pics[LARGE_PICTURES - 1]);
+    vlc_join(th, &ret);
+    pics[LARGE_PICTURES - 1] = ret;
+    assert(pics[LARGE_PICTURES - 1] != NULL);
+    assert(pics[LARGE_PICTURES - 1]->p[0].p_pixels == plane);
+
+    for (unsigned i = 0; i < LARGE_PICTURES; i++)
+        picture_Release(pics[i]);
+    picture_pool_Release(pool);
+}
+
 int main(void)
 {
     video_format_Setup(&fmt, VLC_CODEC_I420, 320, 200, 320, 200, 1, 1);
@@ -122,6 +164,7 @@ int main(void)
 
     test(false);
     test(true);
+    test_large();
 
     return 0;
 }
@@ -49,6 +49,133 @@ static void callback (void *ptr)
 }
 
 
+#define MANY_TIMERS 100
+
+struct many_data
+{
+    vlc_mutex_t lock;
+    vlc_cond_t  wait;
+    unsigned count;
+};
+
+static void many_callback (void *ptr)
+{
+    struct many_data *data = ptr;
+
+    vlc_mutex_lock (&data->lock);
+    data->count++;
+    vlc_cond_signal (&data->wait);
+    vlc_mutex_unlock (&data->lock);
+}
+
+/* Many timers share the same threads */
+static void test_many (void)
+{
+    struct many_data data;
+    vlc_timer_t timers[MANY_TIMERS];
+
+    vlc_mutex_init (&data.lock);
+    vlc_cond_init (&data.wait);
+    data.count = 0;
+
+    for (unsigned i = 0; i < MANY_TIMERS; i++)
+    {
+        int val = vlc_timer_create (&timers[i], many_callback, &data);
+        assert (val == 0);
+    }
+    /* Scheduled in reverse order of deadlines */
+    for (unsigned i = 0; i < MANY_TIMERS; i++)
+        vlc_timer_schedule (timers[i], false,
+                            (MANY_TIMERS - i) * (CLOCK_FREQ / 1000), 0);
+    /* Disarmed timers do not fire */
+    vlc_timer_schedule (timers[0], false, 0, 0);
+
+    vlc_mutex_lock (&data.lock);
+    while (data.count < MANY_TIMERS - 1)
+        vlc_cond_wait (&data.wait, &data.lock);
+    vlc_mutex_unlock (&data.lock);
+
+    for (unsigned i = 0; i < MANY_TIMERS; i++)
+        vlc_timer_destroy (timers[i]);
+    assert (data.count == MANY_TIMERS - 1);
+    vlc_cond_destroy (&data.wait);
+    vlc_mutex_destroy (&data.lock);
+}
+
+#define BLOCKING_TIMERS 8
+
+struct blocking_data
+{
+    vlc_mutex_t lock;
+    vlc_cond_t  wait;
+    unsigned count;
+    bool released;
+};
+
+static void blocking_callback (void *ptr)
+{
+    struct blocking_data *data = ptr;
+
+    vlc_mutex_lock (&data->lock);
+    data->count++;
+    vlc_cond_broadcast (&data->wait);
+    while (!data->released)
+        vlc_cond_wait (&data->wait, &data->lock);
+    vlc_mutex_unlock (&data->lock);
+}
+
+/* Blocking callbacks do not starve the other timers */
+static void test_blocking (void)
+{
+    struct blocking_data data;
+    struct timer_data other;
+    vlc_timer_t timers[BLOCKING_TIMERS];
+
+    vlc_mutex_init (&data.lock);
+    vlc_cond_init (&data.wait);
+    data.count = 0;
+    data.released = false;
+
+    for (unsigned i = 0; i < BLOCKING_TIMERS; i++)
+    {
+        int val = vlc_timer_create (&timers[i], blocking_callback, &data);
+        assert (val == 0);
+        vlc_timer_schedule (timers[i], false, 1, 0);
+    }
+
+    /* More callbacks than pooled threads end up blocked at once */
+    vlc_mutex_lock (&data.lock);
+    while (data.count < BLOCKING_TIMERS)
+        vlc_cond_wait (&data.wait, &data.lock);
+    vlc_mutex_unlock (&data.lock);
+
+    vlc_mutex_init (&other.lock);
+    vlc_cond_init (&other.wait);
+    other.count = 0;
+
+    int val = vlc_timer_create (&other.timer, callback, &other);
+    assert (val == 0);
+    vlc_timer_schedule (other.timer, false, 1, 0);
+
+    vlc_mutex_lock (&other.lock);
+    while (other.count == 0)
+        vlc_cond_wait (&other.wait, &other.lock);
+    vlc_mutex_unlock (&other.lock);
+    vlc_timer_destroy (other.timer);
+
+    vlc_mutex_lock (&data.lock);
+    data.released = true;
+    vlc_cond_broadcast (&data.wait);
+    vlc_mutex_unlock (&data.lock);
+
+    for (unsigned i = 0; i < BLOCKING_TIMERS; i++)
+        vlc_timer_destroy (timers[i]);
+    vlc_cond_destroy (&other.wait);
+    vlc_mutex_destroy (&other.lock);
+    vlc_cond_destroy (&data.wait);
+    vlc_mutex_destroy (&data.lock);
+}
+
 int main (void)
 {
     struct timer_data data;
@@ -108,5 +235,7 @@ int main (void)
     vlc_cond_destroy (&data.wait);
     vlc_mutex_destroy (&data.lock);
 
+    test_many ();
+    test_blocking ();
     return 0;
 }
@@ -1520,8 +1520,10 @@ void vout_SendDisplayEventMouse(vout_thread_t *vout, const vlc_mouse_t *m)
     if (vout->p->filter.chain_static && vout->p->filter.chain_interactive) {
         if (!filter_chain_MouseFilter(vout->p->filter.chain_interactive, &tmp1, m))
             m = &tmp1;
+        vlc_mutex_lock( &vout->p->prepare.chain_lock );
         if (!filter_chain_MouseFilter(vout->p->filter.chain_static,      &tmp2, m))
             m = &tmp2;
+        vlc_mutex_unlock( &vout->p->prepare.chain_lock );
     }
     vlc_mutex_unlock( &vout->p->filter.lock );
 
@@ -24,6 +24,7 @@
 #ifndef LIBVLC_VOUT_STATISTIC_H
 # define LIBVLC_VOUT_STATISTIC_H
 # include <vlc_atomic.h>
+# include <vlc_input_item.h>
 
 /* NOTE: Both statistics are atomic on their own, so one might be older than
  * the other one. Currently, only one of them is updated at a time, so this
@@ -31,12 +32,19 @@
 typedef struct {
     atomic_uint displayed;
     atomic_uint lost;
+    atomic_uint timings[INPUT_STATS_VOUT_TIMINGS][INPUT_STATS_TIMING_BUCKETS];
+    atomic_uint latency[INPUT_STATS_LATENCY_BUCKETS];
 } vout_statistic_t;
 
 static inline void vout_statistic_Init(vout_statistic_t *stat)
 {
     atomic_init(&stat->displayed, 0);
     atomic_init(&stat->lost, 0);
+    for (unsigned i = 0; i < INPUT_STATS_VOUT_TIMINGS; i++)
+        for (unsigned j = 0; j < INPUT_STATS_TIMING_BUCKETS; j++)
+            atomic_init(&stat->timings[i][j], 0);
+    for (unsigned i = 0; i < INPUT_STATS_LATENCY_BUCKETS; i++)
+        atomic_init(&stat->latency[i], 0);
 }
 
 static inline void vout_statistic_Clean(vout_statistic_t *stat)
@@ -52,6 +60,38 @@ static inline void vout_statistic_GetReset(vout_statistic_t *stat,
     *lost      = atomic_exchange(&stat->lost, 0);
 }
 
+static inline void vout_statistic_GetResetTimings(vout_statistic_t *stat,
+    unsigned timings[INPUT_STATS_VOUT_TIMINGS][INPUT_STATS_TIMING_BUCKETS])
+{
+    for (unsigned i = 0; i < INPUT_STATS_VOUT_TIMINGS; i++)
+        for (unsigned j = 0; j < INPUT_STATS_TIMING_BUCKETS; j++)
+            timings[i][j] = atomic_exchange(&stat->timings[i][j], 0);
+}
+
+static inline void vout_statistic_GetResetLatency(vout_statistic_t *stat,
+    unsigned latency[INPUT_STATS_LATENCY_BUCKETS])
+{
+    for (unsigned i = 0; i < INPUT_STATS_LATENCY_BUCKETS; i++)
+        latency[i] = atomic_exchange(&stat->latency[i], 0);
+}
+
+static inline void vout_statistic_AddLatency(vout_statistic_t *stat,
+                                             vlc_tick_t latency)
+{
+    atomic_fetch_add(&stat->latency[input_stats_LatencyBucket(latency)], 1);
+}
+
+static inline void vout_statistic_AddTiming(vout_statistic_t *stat,
+                                            enum input_stats_vout_timing timing,
+                                            vlc_tick_t duration)
+{
+    unsigned bucket = 0;
+    while (bucket < INPUT_STATS_TIMING_BUCKETS - 1 &&
+           duration >= (CLOCK_FREQ / 1000) << bucket)
+        bucket++;
+    atomic_fetch_add(&stat->timings[timing][bucket], 1);
+}
+
 static inline void vout_statistic_AddDisplayed(vout_statistic_t *stat,
                                                int displayed)
 {
@@ -47,6 +47,7 @@
 #include <vlc_vout_osd.h>
 #include <vlc_image.h>
 #include <vlc_plugin.h>
+#include <vlc_trace.h>
 
 #include <libvlc.h>
 #include "vout_internal.h"
@@ -59,6 +60,7 @@
  * Local prototypes
  *****************************************************************************/
 static void *Thread(void *);
+static void *PrepareThread(void *);
 static void VoutDestructor(vlc_object_t *);
 
 /* Maximum delay between 2 displayed pictures.
@@ -134,6 +136,7 @@ static vout_thread_t *VoutCreate(vlc_object_t *object,
 
     vout->p->original = original;
     vout->p->dpb_size = cfg->dpb_size;
+    vout->p->picture_align = cfg->picture_align;
 
     vout_control_Init(&vout->p->control);
     vout_control_PushVoid(&vout->p->control, VOUT_CONTROL_INIT);
@@ -144,6 +147,10 @@ static vout_thread_t *VoutCreate(vlc_object_t *object,
 
     /* Initialize locks */
     vlc_mutex_init(&vout->p->filter.lock);
+    vlc_mutex_init(&vout->p->prepare.lock);
+    vlc_mutex_init(&vout->p->prepare.chain_lock);
+    vlc_cond_init(&vout->p->prepare.wait);
+    vlc_cond_init(&vout->p->prepare.idle);
     vlc_mutex_init(&vout->p->spu_lock);
 
     /* Take care of some "interface/control" related initialisations */
@@ -292,6 +299,10 @@ static void VoutDestructor(vlc_object_t *object)
 
     /* Destroy the locks */
     vlc_mutex_destroy(&vout->p->spu_lock);
+    vlc_cond_destroy(&vout->p->prepare.idle);
+    vlc_cond_destroy(&vout->p->prepare.wait);
+    vlc_mutex_destroy(&vout->p->prepare.chain_lock);
+    vlc_mutex_destroy(&vout->p->prepare.lock);
     vlc_mutex_destroy(&vout->p->filter.lock);
     vout_control_Clean(&vout->p->control);
 
@@ -328,6 +339,18 @@ void vout_GetResetStatistic(vout_thread_t *vout, unsigned *restrict displayed,
     vout_statistic_GetReset( &vout->p->statistic, displayed, lost );
 }
 
+void vout_GetResetTimings(vout_thread_t *vout,
+                          unsigned timings[INPUT_STATS_VOUT_TIMINGS][INPUT_STATS_TIMING_BUCKETS])
+{
+    vout_statistic_GetResetTimings(&vout->p->statistic, timings);
+}
+
+void vout_GetResetLatency(vout_thread_t *vout,
+                          unsigned latency[INPUT_STATS_LATENCY_BUCKETS])
+{
+    vout_statistic_GetResetLatency(&vout->p->statistic, latency);
+}
+
 void vout_Flush(vout_thread_t *vout, vlc_tick_t date)
 {
     vout_control_PushTime(&vout->p->control, VOUT_CONTROL_FLUSH, date);
@@ -336,6 +359,14 @@ void vout_Flush(vout_thread_t *vout, vlc_tick_t date)
 
 bool vout_IsEmpty(vout_thread_t *vout)
 {
+    vlc_mutex_lock(&vout->p->prepare.lock);
+    const bool prepared = vout->p->prepare.count > 0 ||
+                          vout->p->prepare.pending != NULL ||
+                          vout->p->prepare.redo_count > 0;
+    vlc_mutex_unlock(&vout->p->prepare.lock);
+    if (prepared)
+        return false;
+
     picture_t *picture = picture_fifo_Peek(vout->p->decoder_fifo);
     if (picture)
         picture_Release(picture);
@@ -427,8 +458,15 @@ void vout_PutPicture(vout_thread_t *vout, picture_t *picture)
     picture->p_next = NULL;
     if (picture_pool_OwnsPic(vout->p->decoder_pool, picture))
     {
+        if (picture->date > VLC_TS_INVALID)
+            vout_statistic_AddTiming(&vout->p->statistic, INPUT_STATS_VOUT_LEAD,
+                                     picture->date - mdate());
         picture_fifo_Push(vout->p->decoder_fifo, picture);
 
+        vlc_mutex_lock(&vout->p->prepare.lock);
+        vlc_cond_signal(&vout->p->prepare.wait);
+        vlc_mutex_unlock(&vout->p->prepare.lock);
+
         vout_control_Wake(&vout->p->control);
     }
     else
@@ -694,15 +732,75 @@ static picture_t *VoutVideoFilterStaticNewPicture(filter_t *filter)
 {
     vout_thread_t *vout = filter->owner.sys;
 
-    vlc_assert_locked(&vout->p->filter.lock);
+    /* The interactive chain only changes while the static filters are not
+     * running (see ThreadPreparePark()) */
     if (filter_chain_IsEmpty(vout->p->filter.chain_interactive))
         return VoutVideoFilterInteractiveNewPicture(filter);
 
     return picture_NewFromFormat(&filter->fmt_out.video);
 }
 
+/**
+ * Stops the static filters thread from using the static filters and the
+ * decoded pictures, until ThreadPrepareResume(). Calls can be nested.
+ */
+static void ThreadPreparePark(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    vlc_mutex_lock(&sys->prepare.lock);
+    sys->prepare.park++;
+    while (sys->prepare.is_busy)
+        vlc_cond_wait(&sys->prepare.idle, &sys->prepare.lock);
+    vlc_mutex_unlock(&sys->prepare.lock);
+}
+
+static void ThreadPrepareResume(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    vlc_mutex_lock(&sys->prepare.lock);
+    assert(sys->prepare.park > 0);
+    if (--sys->prepare.park == 0)
+        vlc_cond_signal(&sys->prepare.wait);
+    vlc_mutex_unlock(&sys->prepare.lock);
+}
+
+/* Drops the prepared pictures and gives their sources back, in order, to be
+ * filtered again. The static filters thread must be parked. */
+static void ThreadPrepareRequeue(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+    picture_t *decoded[ARRAY_SIZE(sys->prepare.redo)];
+    unsigned count = 0;
+
+    vlc_mutex_lock(&sys->prepare.lock);
+    assert(sys->prepare.park > 0);
+    for (unsigned i = 0; i < sys->prepare.count; i++) {
+        picture_Release(sys->prepare.queue[i].picture);
+        if (sys->prepare.queue[i].decoded)
+            decoded[count++] = sys->prepare.queue[i].decoded;
+    }
+    sys->prepare.count = 0;
+    if (sys->prepare.pending) {
+        decoded[count++] = sys->prepare.pending;
+        sys->prepare.pending = NULL;
+    }
+
+    /* Nothing is taken from the decoder while there are pictures to filter
+     * again, so they cannot outnumber the prepared ones */
+    assert(count + sys->prepare.redo_count <= ARRAY_SIZE(sys->prepare.redo));
+    memmove(&sys->prepare.redo[count], &sys->prepare.redo[0],
+            sys->prepare.redo_count * sizeof(*sys->prepare.redo));
+    memcpy(sys->prepare.redo, decoded, count * sizeof(*decoded));
+    sys->prepare.redo_count += count;
+    vlc_mutex_unlock(&sys->prepare.lock);
+}
+
 static void ThreadFilterFlush(vout_thread_t *vout, bool is_locked)
 {
+    ThreadPreparePark(vout);
+
     if (vout->p->displayed.current)
         picture_Release( vout->p->displayed.current );
     vout->p->displayed.current = NULL;
@@ -711,12 +809,16 @@ static void ThreadFilterFlush(vout_thread_t *vout, bool is_locked)
         picture_Release( vout->p->displayed.next );
     vout->p->displayed.next = NULL;
 
+    ThreadPrepareRequeue(vout);
+
     if (!is_locked)
         vlc_mutex_lock(&vout->p->filter.lock);
     filter_chain_VideoFlush(vout->p->filter.chain_static);
     filter_chain_VideoFlush(vout->p->filter.chain_interactive);
     if (!is_locked)
         vlc_mutex_unlock(&vout->p->filter.lock);
+
+    ThreadPrepareResume(vout);
 }
 
 typedef struct {
@@ -730,6 +832,7 @@ static void ThreadChangeFilters(vout_thread_t *vout,
                                 int deinterlace,
                                 bool is_locked)
 {
+    ThreadPreparePark(vout);
     ThreadFilterFlush(vout, is_locked);
     ThreadDelAllFilterCallbacks(vout);
 
@@ -841,64 +944,71 @@ static void ThreadChangeFilters(vout_thread_t *vout,
 
     if (!is_locked)
         vlc_mutex_unlock(&vout->p->filter.lock);
+
+    ThreadPrepareResume(vout);
 }
 
 
-/* */
-static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool frame_by_frame)
+/* Takes the next picture filtered by the static filters thread. If the
+ * filters have to change first, filters the pending picture instead. */
+static picture_t *ThreadPrepareTake(vout_thread_t *vout)
 {
-    bool is_late_dropped = vout->p->is_late_dropped && !vout->p->pause.is_on && !frame_by_frame;
-
-    vlc_mutex_lock(&vout->p->filter.lock);
+    vout_thread_sys_t *sys = vout->p;
+    picture_t *picture = NULL;
+    picture_t *decoded = NULL;
+
+    vlc_mutex_lock(&sys->prepare.lock);
+    if (sys->prepare.count > 0) {
+        picture = sys->prepare.queue[0].picture;
+        decoded = sys->prepare.queue[0].decoded;
+        memmove(&sys->prepare.queue[0], &sys->prepare.queue[1],
+                --sys->prepare.count * sizeof(*sys->prepare.queue));
+        vlc_cond_signal(&sys->prepare.wait);
+    } else if (sys->prepare.pending) {
+        /* The thread waits for the pending picture to be taken, so it is
+         * parked before it can use the current filters again */
+        decoded = sys->prepare.pending;
+        sys->prepare.pending = NULL;
+        sys->prepare.park++;
+    }
+    vlc_mutex_unlock(&sys->prepare.lock);
 
-    picture_t *picture = filter_chain_VideoFilter(vout->p->filter.chain_static, NULL);
-    assert(!reuse || !picture);
+    if (decoded && !picture) {
+        vlc_mutex_lock(&sys->filter.lock);
+        if (!VideoFormatIsCropArEqual(&decoded->format, &sys->filter.format))
+            ThreadChangeFilters(vout, &decoded->format, sys->filter.configuration, -1, true);
+        picture = filter_chain_VideoFilter(sys->filter.chain_static, picture_Hold(decoded));
+        vlc_mutex_unlock(&sys->filter.lock);
 
-    while (!picture) {
-        picture_t *decoded;
-        if (reuse && vout->p->displayed.decoded) {
-            decoded = picture_Hold(vout->p->displayed.decoded);
-        } else {
-            decoded = picture_fifo_Pop(vout->p->decoder_fifo);
-            if (decoded) {
-                if (is_late_dropped && !decoded->b_force) {
-                    vlc_tick_t late_threshold;
-                    if (decoded->format.i_frame_rate && decoded->format.i_frame_rate_base)
-                        late_threshold = ((CLOCK_FREQ/2) * decoded->format.i_frame_rate_base) / decoded->format.i_frame_rate;
-                    else
-                        late_threshold = VOUT_DISPLAY_LATE_THRESHOLD;
-                    const vlc_tick_t predicted = mdate() + 0; /* TODO improve */
-                    const vlc_tick_t late = predicted - decoded->date;
-                    if (late > late_threshold) {
-                        msg_Warn(vout, "picture is too late to be displayed (missing %"PRId64" ms)", late/1000);
-                        picture_Release(decoded);
-                        vout_statistic_AddLost(&vout->p->statistic, 1);
-                        continue;
-                    } else if (late > 0) {
-                        msg_Dbg(vout, "picture might be displayed late (missing %"PRId64" ms)", late/1000);
-                    }
-                }
-                if (!VideoFormatIsCropArEqual(&decoded->format, &vout->p->filter.format))
-                    ThreadChangeFilters(vout, &decoded->format, vout->p->filter.configuration, -1, true);
-            }
-        }
+        ThreadPrepareResume(vout);
+    }
 
-        if (!decoded)
-            break;
-        reuse = false;
+    if (decoded) {
+        if (sys->displayed.decoded)
+            picture_Release(sys->displayed.decoded);
 
-        if (vout->p->displayed.decoded)
-            picture_Release(vout->p->displayed.decoded);
+        sys->displayed.decoded       = decoded;
+        sys->displayed.timestamp     = decoded->date;
+        sys->displayed.is_interlaced = !decoded->b_progressive;
+    }
+    return picture;
+}
 
-        vout->p->displayed.decoded       = picture_Hold(decoded);
-        vout->p->displayed.timestamp     = decoded->date;
-        vout->p->displayed.is_interlaced = !decoded->b_progressive;
+static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse)
+{
+    picture_t *picture = NULL;
 
-        picture = filter_chain_VideoFilter(vout->p->filter.chain_static, decoded);
+    if (reuse && vout->p->displayed.decoded) {
+        ThreadPreparePark(vout);
+        vlc_mutex_lock(&vout->p->filter.lock);
+        picture = filter_chain_VideoFilter(vout->p->filter.chain_static,
+                                           picture_Hold(vout->p->displayed.decoded));
+        vlc_mutex_unlock(&vout->p->filter.lock);
+        ThreadPrepareResume(vout);
     }
 
-    vlc_mutex_unlock(&vout->p->filter.lock);
-
+    if (!picture)
+        picture = ThreadPrepareTake(vout);
     if (!picture)
         return VLC_EGENERIC;
 
@@ -973,9 +1083,13 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
 
     vout_chrono_Start(&vout->p->render);
 
+    vlc_tick_t start = mdate();
     vlc_mutex_lock(&vout->p->filter.lock);
     picture_t *filtered = filter_chain_VideoFilter(vout->p->filter.chain_interactive, torender);
     vlc_mutex_unlock(&vout->p->filter.lock);
+    vlc_tick_t stop = mdate();
+    vout_statistic_AddTiming(&sys->statistic,
+                             INPUT_STATS_VOUT_INTERACTIVE_FILTER, stop - start);
 
     if (!filtered)
         return VLC_EGENERIC;
@@ -1054,11 +1168,29 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
 
     video_format_t fmt_spu_rot;
     video_format_ApplyRotation(&fmt_spu_rot, &fmt_spu);
+    start = mdate();
     subpicture_t *subpic = spu_Render(vout->p->spu,
                                       subpicture_chromas, &fmt_spu_rot,
                                       &vd->source,
                                       render_subtitle_date, render_osd_date,
                                       do_snapshot);
+    stop = mdate();
+    vout_statistic_AddTiming(&sys->statistic, INPUT_STATS_VOUT_SPU,
+                             stop - start);
+
+    /* Let the SPU prepare the subpictures of the next picture meanwhile */
+    if (!vout->p->pause.is_on && !do_snapshot) {
+        picture_t *next = vout->p->displayed.next != NULL
+                        ? picture_Hold(vout->p->displayed.next)
+                        : picture_fifo_Peek(vout->p->decoder_fifo);
+        if (next != NULL) {
+            if (next->date > 1)
+                spu_Prerender(vout->p->spu, subpicture_chromas, &fmt_spu_rot,
+                              &vd->source, next->date);
+            picture_Release(next);
+        }
+    }
+    start = mdate();
     /*
      * Perform rendering
      *
@@ -1155,6 +1287,8 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
     }
 
     vout_chrono_Stop(&vout->p->render);
+    vout_statistic_AddTiming(&sys->statistic, INPUT_STATS_VOUT_PREPARE,
+                             mdate() - start);
 #if 0
         {
         static int i = 0;
@@ -1170,12 +1304,26 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
     if (delay < 1000)
         msg_Warn(vout, "picture is late (%lld ms)", delay / 1000);
 #endif
-    if (!is_forced)
+    if (!is_forced) {
+        vlc_trace_begin("vout", "wait");
         mwait(todisplay->date);
+        vlc_trace_end("vout", "wait");
+    }
 
     /* Display the direct buffer returned by vout_RenderPicture */
     vout->p->displayed.date = mdate();
+    if (!is_forced)
+        vout_statistic_AddTiming(&sys->statistic, INPUT_STATS_VOUT_LATE,
+                                 vout->p->displayed.date - todisplay->date);
+    const vlc_tick_t ingest = todisplay->ingest;
+    vlc_trace_begin("vout", "display");
     vout_display_Display(vd, todisplay, subpic);
+    vlc_trace_end("vout", "display");
+    const vlc_tick_t displayed = mdate();
+    vout_statistic_AddTiming(&sys->statistic, INPUT_STATS_VOUT_DISPLAY,
+                             displayed - vout->p->displayed.date);
+    if (ingest != VLC_TICK_INVALID && !is_forced)
+        vout_statistic_AddLatency(&sys->statistic, displayed - ingest);
 
     vout_statistic_AddDisplayed(&vout->p->statistic, 1);
 
@@ -1189,12 +1337,15 @@ static int ThreadDisplayPicture(vout_thread_t *vout, vlc_tick_t *deadline)
     bool first = !vout->p->displayed.current;
 
     if (first)
-        if (ThreadDisplayPreparePicture(vout, true, frame_by_frame)) /* FIXME not sure it is ok */
+        if (ThreadDisplayPreparePicture(vout, true)) /* FIXME not sure it is ok */
             return VLC_EGENERIC;
 
-    if (!paused || frame_by_frame)
-        while (!vout->p->displayed.next && !ThreadDisplayPreparePicture(vout, false, frame_by_frame))
+    if (!paused || frame_by_frame) {
+        vlc_trace_begin("vout", "prepare");
+        while (!vout->p->displayed.next && !ThreadDisplayPreparePicture(vout, false))
             ;
+        vlc_trace_end("vout", "prepare");
+    }
 
     const vlc_tick_t date = mdate();
     const vlc_tick_t render_delay = vout_chrono_GetHigh(&vout->p->render) + VOUT_MWAIT_TOLERANCE;
@@ -1247,7 +1398,9 @@ static int ThreadDisplayPicture(vout_thread_t *vout, vlc_tick_t *deadline)
 
     /* display the picture immediately */
     bool is_forced = frame_by_frame || force_refresh || vout->p->displayed.current->b_force;
+    vlc_trace_begin("vout", "render");
     int ret = ThreadDisplayRenderPicture(vout, is_forced);
+    vlc_trace_end("vout", "render");
     return force_refresh ? VLC_EGENERIC : ret;
 }
 
@@ -1291,19 +1444,26 @@ static void ThreadChangePause(vout_thread_t *vout, bool is_paused, vlc_tick_t da
 {
     assert(!vout->p->pause.is_on || !is_paused);
 
+    ThreadPreparePark(vout);
+
     if (vout->p->pause.is_on) {
         const vlc_tick_t duration = date - vout->p->pause.date;
 
+        /* Get the prepared pictures back first, to offset their date too */
+        ThreadFilterFlush(vout, false);
+
         if (vout->p->step.timestamp > VLC_TICK_INVALID)
             vout->p->step.timestamp += duration;
         if (vout->p->step.last > VLC_TICK_INVALID)
             vout->p->step.last += duration;
         picture_fifo_OffsetDate(vout->p->decoder_fifo, duration);
+        vlc_mutex_lock(&vout->p->prepare.lock);
+        for (unsigned i = 0; i < vout->p->prepare.redo_count; i++)
+            vout->p->prepare.redo[i]->date += duration;
+        vlc_mutex_unlock(&vout->p->prepare.lock);
         if (vout->p->displayed.decoded)
             vout->p->displayed.decoded->date += duration;
         spu_OffsetSubtitleDate(vout->p->spu, duration);
-
-        ThreadFilterFlush(vout, false);
     } else {
         vout->p->step.timestamp = VLC_TICK_INVALID;
         vout->p->step.last      = VLC_TICK_INVALID;
@@ -1311,6 +1471,11 @@ static void ThreadChangePause(vout_thread_t *vout, bool is_paused, vlc_tick_t da
     vout->p->pause.is_on = is_paused;
     vout->p->pause.date  = date;
 
+    vlc_mutex_lock(&vout->p->prepare.lock);
+    vout->p->prepare.is_paused = is_paused;
+    vlc_mutex_unlock(&vout->p->prepare.lock);
+    ThreadPrepareResume(vout);
+
     vout_window_t *window = vout->p->window;
     if (window != NULL)
         vout_window_SetInhibition(window, !is_paused);
@@ -1321,6 +1486,7 @@ static void ThreadFlush(vout_thread_t *vout, bool below, vlc_tick_t date)
     vout->p->step.timestamp = VLC_TICK_INVALID;
     vout->p->step.last      = VLC_TICK_INVALID;
 
+    ThreadPreparePark(vout);
     ThreadFilterFlush(vout, false); /* FIXME too much */
 
     picture_t *last = vout->p->displayed.decoded;
@@ -1335,7 +1501,22 @@ static void ThreadFlush(vout_thread_t *vout, bool below, vlc_tick_t date)
         }
     }
 
+    unsigned kept = 0;
+    vlc_mutex_lock(&vout->p->prepare.lock);
+    for (unsigned i = 0; i < vout->p->prepare.redo_count; i++) {
+        picture_t *picture = vout->p->prepare.redo[i];
+        if (( below && picture->date <= date) ||
+            (!below && picture->date >= date))
+            picture_Release(picture);
+        else
+            vout->p->prepare.redo[kept++] = picture;
+    }
+    vout->p->prepare.redo_count = kept;
+    vlc_mutex_unlock(&vout->p->prepare.lock);
+
     picture_fifo_Flush(vout->p->decoder_fifo, date, below);
+    ThreadPrepareResume(vout);
+
     vout_FilterFlush(vout->p->display.vd);
 }
 
@@ -1552,6 +1733,20 @@ static int ThreadStart(vout_thread_t *vout, vout_display_state_t *state)
     vout->p->spu_blend_chroma        = 0;
     vout->p->spu_blend               = NULL;
 
+    vout->p->prepare.is_busy         = false;
+    vout->p->prepare.exit            = false;
+    vout->p->prepare.park            = 0;
+    vout->p->prepare.count           = 0;
+    vout->p->prepare.pending         = NULL;
+    vout->p->prepare.redo_count      = 0;
+    if (vlc_clone(&vout->p->prepare.thread, PrepareThread, vout,
+                  VLC_THREAD_PRIORITY_OUTPUT)) {
+        vout_EndWrapper(vout);
+        vout_CloseWrapper(vout, state);
+        goto error;
+    }
+    vout->p->prepare.is_started = true;
+
     video_format_Print(VLC_OBJECT(vout), "original format", &vout->p->original);
     return VLC_SUCCESS;
 error:
@@ -1570,6 +1765,15 @@ error:
 
 static void ThreadStop(vout_thread_t *vout, vout_display_state_t *state)
 {
+    if (vout->p->prepare.is_started) {
+        vlc_mutex_lock(&vout->p->prepare.lock);
+        vout->p->prepare.exit = true;
+        vlc_cond_signal(&vout->p->prepare.wait);
+        vlc_mutex_unlock(&vout->p->prepare.lock);
+        vlc_join(vout->p->prepare.thread, NULL);
+        vout->p->prepare.is_started = false;
+    }
+
     if (vout->p->spu_blend)
         filter_DeleteBlend(vout->p->spu_blend);
 
@@ -1592,6 +1796,8 @@ static void ThreadStop(vout_thread_t *vout, vout_display_state_t *state)
     if (vout->p->decoder_fifo)
         picture_fifo_Delete(vout->p->decoder_fifo);
     assert(!vout->p->decoder_pool);
+    assert(vout->p->prepare.count == 0 && !vout->p->prepare.pending &&
+           vout->p->prepare.redo_count == 0);
 }
 
 static void ThreadInit(vout_thread_t *vout)
@@ -1600,6 +1806,8 @@ static void ThreadInit(vout_thread_t *vout)
     vout->p->is_late_dropped = var_InheritBool(vout, "drop-late-frames");
     vout->p->pause.is_on     = false;
     vout->p->pause.date      = VLC_TICK_INVALID;
+    vout->p->prepare.is_started = false;
+    vout->p->prepare.is_paused  = false;
 
     vout_chrono_Init(&vout->p->render, 5, 10000); /* Arbitrary initial time */
 }
@@ -1618,6 +1826,9 @@ static int ThreadReinit(vout_thread_t *vout,
 
     vout->p->pause.is_on = false;
     vout->p->pause.date  = VLC_TICK_INVALID;
+    vlc_mutex_lock(&vout->p->prepare.lock);
+    vout->p->prepare.is_paused = false;
+    vlc_mutex_unlock(&vout->p->prepare.lock);
 
     if (VoutValidateFormat(&original, cfg->fmt)) {
         ThreadStop(vout, NULL);
@@ -1631,11 +1842,12 @@ static int ThreadReinit(vout_thread_t *vout,
     vout->p->original.i_sar_num = original.i_sar_num;
     vout->p->original.i_sar_den = original.i_sar_den;
     if (video_format_IsSimilar(&original, &vout->p->original)) {
-        if (cfg->dpb_size <= vout->p->dpb_size) {
+        if (cfg->dpb_size <= vout->p->dpb_size &&
+            cfg->picture_align <= vout->p->picture_align) {
             video_format_Clean(&original);
             return VLC_SUCCESS;
         }
-        msg_Warn(vout, "DPB need to be increased");
+        msg_Warn(vout, "DPB or picture alignment need to be increased");
     }
 
     vout_display_state_t state;
@@ -1668,6 +1880,7 @@ static int ThreadReinit(vout_thread_t *vout,
 
     vout->p->original = original;
     vout->p->dpb_size = cfg->dpb_size;
+    vout->p->picture_align = cfg->picture_align;
     if (ThreadStart(vout, &state)) {
         ThreadClean(vout);
         return VLC_EGENERIC;
@@ -1781,6 +1994,119 @@ static int ThreadControl(vout_thread_t *vout, vout_control_cmd_t cmd)
     return 0;
 }
 
+static bool PictureIsLate(vout_thread_t *vout, const picture_t *decoded)
+{
+    vlc_tick_t late_threshold;
+    if (decoded->format.i_frame_rate && decoded->format.i_frame_rate_base)
+        late_threshold = ((CLOCK_FREQ/2) * decoded->format.i_frame_rate_base) / decoded->format.i_frame_rate;
+    else
+        late_threshold = VOUT_DISPLAY_LATE_THRESHOLD;
+    const vlc_tick_t predicted = mdate() + 0; /* TODO improve */
+    const vlc_tick_t late = predicted - decoded->date;
+    if (late > late_threshold) {
+        msg_Warn(vout, "picture is too late to be displayed (missing %"PRId64" ms)", late/1000);
+        return true;
+    } else if (late > 0) {
+        msg_Dbg(vout, "picture might be displayed late (missing %"PRId64" ms)", late/1000);
+    }
+    return false;
+}
+
+/* Runs the static filters, with the prepare lock released meanwhile */
+static picture_t *PrepareFilter(vout_thread_t *vout, picture_t *decoded)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    sys->prepare.is_busy = true;
+    vlc_mutex_unlock(&sys->prepare.lock);
+
+    vlc_tick_t start = mdate();
+    vlc_mutex_lock(&sys->prepare.chain_lock);
+    picture_t *picture = filter_chain_VideoFilter(sys->filter.chain_static, decoded);
+    vlc_mutex_unlock(&sys->prepare.chain_lock);
+    if (decoded != NULL)
+        vout_statistic_AddTiming(&sys->statistic, INPUT_STATS_VOUT_FILTER,
+                                 mdate() - start);
+
+    vlc_mutex_lock(&sys->prepare.lock);
+    sys->prepare.is_busy = false;
+    vlc_cond_signal(&sys->prepare.idle);
+    return picture;
+}
+
+static picture_t *PreparePop(vout_thread_sys_t *sys)
+{
+    if (sys->prepare.redo_count > 0) {
+        picture_t *decoded = sys->prepare.redo[0];
+        memmove(&sys->prepare.redo[0], &sys->prepare.redo[1],
+                --sys->prepare.redo_count * sizeof(*sys->prepare.redo));
+        return decoded;
+    }
+    return picture_fifo_Pop(sys->decoder_fifo);
+}
+
+/*****************************************************************************
+ * PrepareThread: static filters thread
+ *****************************************************************************
+ * It runs the static filters (deinterlacing, post-processing) on the decoded
+ * pictures, up to VOUT_PREPARE_AHEAD pictures ahead of the video output
+ * thread, so that they are done while the current picture waits for its
+ * display date.
+ *****************************************************************************/
+static void *PrepareThread(void *object)
+{
+    vout_thread_t *vout = object;
+    vout_thread_sys_t *sys = vout->p;
+
+    vlc_mutex_lock(&sys->prepare.lock);
+    while (!sys->prepare.exit) {
+        if (sys->prepare.park > 0 || sys->prepare.pending ||
+            sys->prepare.count >= VOUT_PREPARE_AHEAD) {
+            vlc_cond_wait(&sys->prepare.wait, &sys->prepare.lock);
+            continue;
+        }
+
+        /* Pictures still held by the filters go first */
+        picture_t *decoded = NULL;
+        picture_t *picture = PrepareFilter(vout, NULL);
+        if (!picture) {
+            if (sys->prepare.park > 0)
+                continue;
+
+            decoded = PreparePop(sys);
+            if (!decoded) {
+                vlc_cond_wait(&sys->prepare.wait, &sys->prepare.lock);
+                continue;
+            }
+            if (sys->is_late_dropped && !sys->prepare.is_paused &&
+                !decoded->b_force && PictureIsLate(vout, decoded)) {
+                picture_Release(decoded);
+                vout_statistic_AddLost(&sys->statistic, 1);
+                continue;
+            }
+            if (!VideoFormatIsCropArEqual(&decoded->format, &sys->filter.format)) {
+                /* The vout thread changes the filters and filters it */
+                sys->prepare.pending = decoded;
+                vout_control_Wake(&sys->control);
+                continue;
+            }
+
+            picture = PrepareFilter(vout, picture_Hold(decoded));
+            if (!picture) {
+                picture_Release(decoded);
+                continue;
+            }
+        }
+
+        sys->prepare.queue[sys->prepare.count].picture = picture;
+        sys->prepare.queue[sys->prepare.count].decoded = decoded;
+        sys->prepare.count++;
+        vout_control_Wake(&sys->control);
+    }
+    vlc_mutex_unlock(&sys->prepare.lock);
+    return NULL;
+}
+
 /*****************************************************************************
  * Thread: video output thread
  *****************************************************************************
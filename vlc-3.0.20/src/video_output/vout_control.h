@@ -25,6 +25,8 @@
 #ifndef LIBVLC_VOUT_CONTROL_H
 #define LIBVLC_VOUT_CONTROL_H 1
 
+#include <vlc_input_item.h>
+
 typedef struct vout_window_mouse_event_t vout_window_mouse_event_t;
 
 /**
@@ -44,6 +46,18 @@ void spu_OffsetSubtitleDate( spu_t *p_spu, vlc_tick_t i_duration );
 void vout_GetResetStatistic( vout_thread_t *p_vout, unsigned *pi_displayed,
                              unsigned *pi_lost );
 
+/**
+ * This function will return and reset the timing histograms.
+ */
+void vout_GetResetTimings( vout_thread_t *p_vout,
+                           unsigned timings[INPUT_STATS_VOUT_TIMINGS][INPUT_STATS_TIMING_BUCKETS] );
+
+/**
+ * This function will return and reset the end-to-end latency histogram.
+ */
+void vout_GetResetLatency( vout_thread_t *p_vout,
+                           unsigned latency[INPUT_STATS_LATENCY_BUCKETS] );
+
 /**
  * This function will ensure that all ready/displayed pictures have at most
  * the provided date.
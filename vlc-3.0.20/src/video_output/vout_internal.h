@@ -43,6 +43,12 @@
  */
 #define VOUT_MAX_PICTURES (20)
 
+/* Number of pictures the static filters may prepare ahead of the display
+ * (in addition to the next one). Each of them keeps a decoded picture and
+ * a filtered one.
+ */
+#define VOUT_PREPARE_AHEAD (2)
+
 /* */
 struct vout_thread_sys_t
 {
@@ -55,6 +61,7 @@ struct vout_thread_sys_t
     /* */
     video_format_t  original;   /* Original format ie coming from the decoder */
     unsigned        dpb_size;
+    unsigned        picture_align; /* required by the decoder */
 
     /* Snapshot interface */
     vout_snapshot_t snapshot;
@@ -127,6 +134,30 @@ struct vout_thread_sys_t
         bool            has_deint;
     } filter;
 
+    /* Static filters, run by their own thread ahead of the display. The
+     * thread is parked while the vout thread changes, flushes or uses the
+     * static filters itself. */
+    struct {
+        vlc_thread_t    thread;
+        vlc_mutex_t     lock;
+        vlc_cond_t      wait;
+        vlc_cond_t      idle;
+        vlc_mutex_t     chain_lock; /* static chain used by the thread */
+        bool            is_started;
+        bool            is_busy;
+        bool            is_paused;
+        bool            exit;
+        unsigned        park;
+        unsigned        count;
+        struct {
+            picture_t   *picture;
+            picture_t   *decoded; /* source, NULL for later outputs */
+        } queue[VOUT_PREPARE_AHEAD];
+        picture_t       *pending; /* waiting for the filters to change */
+        unsigned        redo_count;
+        picture_t       *redo[VOUT_PREPARE_AHEAD + 1]; /* to filter again */
+    } prepare;
+
     /* */
     vlc_mouse_t     mouse;
 
@@ -168,5 +199,7 @@ void vout_ManageWrapper(vout_thread_t *);
 int spu_ProcessMouse(spu_t *, const vlc_mouse_t *, const video_format_t *);
 void spu_Attach( spu_t *, vlc_object_t *input, bool );
 void spu_ChangeMargin(spu_t *, int);
+void spu_Prerender(spu_t *, const vlc_fourcc_t *, const video_format_t *,
+                   const video_format_t *, vlc_tick_t);
 
 #endif
@@ -96,6 +96,24 @@ struct spu_private_t {
     /* */
     vlc_tick_t          last_sort_date;
     vout_thread_t       *vout;
+
+    /* Rendering of the next picture subpictures, ahead of time */
+    unsigned generation;     /**< incremented when the heap is modified */
+    struct {
+        vlc_thread_t   thread;
+        vlc_cond_t     wait;
+        bool           running;
+        bool           stop;
+        bool           pending;                   /**< request to process */
+        bool           ready;                     /**< result is available */
+        unsigned       generation;     /**< heap generation of the result */
+        const vlc_fourcc_t *chroma_list;
+        video_format_t fmt_dst;
+        video_format_t fmt_src;
+        vlc_tick_t     date;                          /**< subtitle date */
+        bool           has_osd;      /**< result depends on the OSD date */
+        subpicture_t   *render;
+    } prerender;
 };
 
 /*****************************************************************************
@@ -1160,6 +1178,7 @@ static void UpdateSPU(spu_t *spu, vlc_object_t *object)
 
     vlc_mutex_lock(&sys->lock);
 
+    sys->generation++;
     sys->force_palette = false;
     sys->force_crop = false;
 
@@ -1281,6 +1300,162 @@ static int SubSourceDelProxyCallbacks(filter_t *filter, void *opaque)
     return VLC_SUCCESS;
 }
 
+/**
+ * Selects, updates and renders the subpictures for the given dates.
+ * The SPU lock must be held.
+ */
+static subpicture_t *SpuRenderLocked(spu_t *spu,
+                                     const vlc_fourcc_t *chroma_list,
+                                     const video_format_t *fmt_dst,
+                                     const video_format_t *fmt_src,
+                                     vlc_tick_t render_subtitle_date,
+                                     vlc_tick_t render_osd_date,
+                                     bool ignore_osd,
+                                     bool *has_osd)
+{
+    unsigned int subpicture_count;
+    subpicture_t *subpicture_array[VOUT_MAX_SUBPICTURES];
+
+    /* Get an array of subpictures to render */
+    SpuSelectSubpictures(spu, &subpicture_count, subpicture_array,
+                         render_subtitle_date, render_osd_date, ignore_osd);
+    if (has_osd != NULL) {
+        *has_osd = false;
+        for (unsigned i = 0; i < subpicture_count; i++)
+            if (!subpicture_array[i]->b_subtitle)
+                *has_osd = true;
+    }
+    if (subpicture_count <= 0)
+        return NULL;
+
+    /* Updates the subpictures */
+    for (unsigned i = 0; i < subpicture_count; i++) {
+        subpicture_t *subpic = subpicture_array[i];
+        subpicture_Update(subpic,
+                          fmt_src, fmt_dst,
+                          subpic->b_subtitle ? render_subtitle_date : render_osd_date);
+    }
+
+    /* Now order the subpicture array
+     * XXX The order is *really* important for overlap subtitles positionning */
+    qsort(subpicture_array, subpicture_count, sizeof(*subpicture_array), SubpictureCmp);
+
+    /* Render the subpictures */
+    return SpuRenderSubpictures(spu,
+                                subpicture_count, subpicture_array,
+                                chroma_list,
+                                fmt_dst,
+                                fmt_src,
+                                render_subtitle_date,
+                                render_osd_date);
+}
+
+static const vlc_fourcc_t *SpuChromaList(const vlc_fourcc_t *chroma_list,
+                                         const video_format_t *fmt_dst)
+{
+    static const vlc_fourcc_t chroma_list_default_yuv[] = {
+        VLC_CODEC_YUVA,
+        VLC_CODEC_RGBA,
+        VLC_CODEC_ARGB,
+        VLC_CODEC_BGRA,
+        VLC_CODEC_YUVP,
+        0,
+    };
+    static const vlc_fourcc_t chroma_list_default_rgb[] = {
+        VLC_CODEC_RGBA,
+        VLC_CODEC_ARGB,
+        VLC_CODEC_BGRA,
+        VLC_CODEC_YUVA,
+        VLC_CODEC_YUVP,
+        0,
+    };
+
+    if (!chroma_list || *chroma_list == 0)
+        chroma_list = vlc_fourcc_IsYUV(fmt_dst->i_chroma) ? chroma_list_default_yuv
+                                                          : chroma_list_default_rgb;
+    return chroma_list;
+}
+
+/*****************************************************************************
+ * Prerendering
+ *****************************************************************************
+ * The vout thread requests the subpictures of the next picture once it has
+ * rendered the current one. They are selected, updated (text layout,
+ * libass...) and converted/scaled to the output format here, so that only
+ * blending remains to be done when the picture is displayed. The result is
+ * used only if the request exactly matches the next spu_Render() call and
+ * the heap was not modified in between.
+ *****************************************************************************/
+struct spu_prerender_key {
+    const vlc_fourcc_t   *chroma_list;
+    const video_format_t *fmt_dst;
+    const video_format_t *fmt_src;
+    vlc_tick_t           date;
+    bool                 ignore_osd;
+};
+
+static bool SpuFormatEqual(const video_format_t *a, const video_format_t *b)
+{
+    return a->i_chroma         == b->i_chroma &&
+           a->i_width          == b->i_width &&
+           a->i_height         == b->i_height &&
+           a->i_x_offset       == b->i_x_offset &&
+           a->i_y_offset       == b->i_y_offset &&
+           a->i_visible_width  == b->i_visible_width &&
+           a->i_visible_height == b->i_visible_height &&
+           a->i_sar_num        == b->i_sar_num &&
+           a->i_sar_den        == b->i_sar_den &&
+           a->orientation      == b->orientation;
+}
+
+static bool SpuPrerenderMatch(const spu_private_t *sys,
+                              const struct spu_prerender_key *key)
+{
+    return sys->prerender.ready &&
+           sys->prerender.generation == sys->generation &&
+           !sys->prerender.has_osd &&
+           !key->ignore_osd &&
+           sys->prerender.date == key->date &&
+           sys->prerender.chroma_list == key->chroma_list &&
+           SpuFormatEqual(&sys->prerender.fmt_dst, key->fmt_dst) &&
+           SpuFormatEqual(&sys->prerender.fmt_src, key->fmt_src);
+}
+
+static void SpuPrerenderFlush(spu_private_t *sys)
+{
+    if (sys->prerender.render != NULL)
+        subpicture_Delete(sys->prerender.render);
+    sys->prerender.render = NULL;
+    sys->prerender.ready = false;
+}
+
+static void *SpuPrerenderThread(void *data)
+{
+    spu_t *spu = data;
+    spu_private_t *sys = spu->p;
+
+    vlc_mutex_lock(&sys->lock);
+    for (;;) {
+        while (!sys->prerender.pending && !sys->prerender.stop)
+            vlc_cond_wait(&sys->prerender.wait, &sys->lock);
+        if (sys->prerender.stop)
+            break;
+
+        sys->prerender.pending = false;
+        /* The OSD date is unknown: results with OSD subpictures are not
+         * used */
+        sys->prerender.render =
+            SpuRenderLocked(spu, sys->prerender.chroma_list,
+                            &sys->prerender.fmt_dst, &sys->prerender.fmt_src,
+                            sys->prerender.date, mdate(), false,
+                            &sys->prerender.has_osd);
+        sys->prerender.generation = sys->generation;
+        sys->prerender.ready = true;
+    }
+    vlc_mutex_unlock(&sys->lock);
+    return NULL;
+}
+
 /*****************************************************************************
  * Public API
  *****************************************************************************/
@@ -1340,6 +1515,16 @@ spu_t *spu_Create(vlc_object_t *object, vout_thread_t *vout)
     sys->last_sort_date = -1;
     sys->vout = vout;
 
+    sys->generation = 0;
+    vlc_cond_init(&sys->prerender.wait);
+    sys->prerender.stop = false;
+    sys->prerender.pending = false;
+    sys->prerender.ready = false;
+    sys->prerender.render = NULL;
+    sys->prerender.running = vout != NULL &&
+        !vlc_clone(&sys->prerender.thread, SpuPrerenderThread, spu,
+                   VLC_THREAD_PRIORITY_OUTPUT);
+
     return spu;
 }
 
@@ -1352,6 +1537,16 @@ void spu_Destroy(spu_t *spu)
 {
     spu_private_t *sys = spu->p;
 
+    if (sys->prerender.running) {
+        vlc_mutex_lock(&sys->lock);
+        sys->prerender.stop = true;
+        vlc_cond_signal(&sys->prerender.wait);
+        vlc_mutex_unlock(&sys->lock);
+        vlc_join(sys->prerender.thread, NULL);
+    }
+    SpuPrerenderFlush(sys);
+    vlc_cond_destroy(&sys->prerender.wait);
+
     if (sys->text)
         FilterRelease(sys->text);
 
@@ -1404,6 +1599,7 @@ void spu_Attach(spu_t *spu, vlc_object_t *input, bool attach)
         if (spu->p->text)
             FilterRelease(spu->p->text);
         spu->p->text = SpuRenderCreateAndLoadText(spu);
+        spu->p->generation++;
 
         vlc_mutex_unlock(&spu->p->lock);
     } else {
@@ -1514,6 +1710,7 @@ void spu_PutSubpicture(spu_t *spu, subpicture_t *subpic)
 
     /* */
     vlc_mutex_lock(&sys->lock);
+    sys->generation++;
     if (SpuHeapPush(&sys->heap, subpic)) {
         vlc_mutex_unlock(&sys->lock);
         msg_Err(spu, "subpicture heap full");
@@ -1560,70 +1757,64 @@ subpicture_t *spu_Render(spu_t *spu,
     filter_chain_SubSource(sys->source_chain, spu, render_osd_date);
     vlc_mutex_unlock(&sys->source_chain_lock);
 
-    static const vlc_fourcc_t chroma_list_default_yuv[] = {
-        VLC_CODEC_YUVA,
-        VLC_CODEC_RGBA,
-        VLC_CODEC_ARGB,
-        VLC_CODEC_BGRA,
-        VLC_CODEC_YUVP,
-        0,
-    };
-    static const vlc_fourcc_t chroma_list_default_rgb[] = {
-        VLC_CODEC_RGBA,
-        VLC_CODEC_ARGB,
-        VLC_CODEC_BGRA,
-        VLC_CODEC_YUVA,
-        VLC_CODEC_YUVP,
-        0,
-    };
-
-    if (!chroma_list || *chroma_list == 0)
-        chroma_list = vlc_fourcc_IsYUV(fmt_dst->i_chroma) ? chroma_list_default_yuv
-                                                          : chroma_list_default_rgb;
+    chroma_list = SpuChromaList(chroma_list, fmt_dst);
 
     vlc_mutex_lock(&sys->lock);
 
-    unsigned int subpicture_count;
-    subpicture_t *subpicture_array[VOUT_MAX_SUBPICTURES];
+    /* Use the subpictures rendered ahead of time if nothing changed since */
+    struct spu_prerender_key key = {
+        chroma_list, fmt_dst, fmt_src, render_subtitle_date, ignore_osd,
+    };
+    sys->prerender.pending = false;
+    if (SpuPrerenderMatch(sys, &key)) {
+        subpicture_t *render = sys->prerender.render;
 
-    /* Get an array of subpictures to render */
-    SpuSelectSubpictures(spu, &subpicture_count, subpicture_array,
-                         render_subtitle_date, render_osd_date, ignore_osd);
-    if (subpicture_count <= 0) {
+        sys->prerender.render = NULL;
+        sys->prerender.ready = false;
         vlc_mutex_unlock(&sys->lock);
-        return NULL;
-    }
-
-    /* Updates the subpictures */
-    for (unsigned i = 0; i < subpicture_count; i++) {
-        subpicture_t *subpic = subpicture_array[i];
-        subpicture_Update(subpic,
-                          fmt_src, fmt_dst,
-                          subpic->b_subtitle ? render_subtitle_date : render_osd_date);
+        return render;
     }
+    SpuPrerenderFlush(sys);
 
-    /* Now order the subpicture array
-     * XXX The order is *really* important for overlap subtitles positionning */
-    qsort(subpicture_array, subpicture_count, sizeof(*subpicture_array), SubpictureCmp);
-
-    /* Render the subpictures */
-    subpicture_t *render = SpuRenderSubpictures(spu,
-                                                subpicture_count, subpicture_array,
-                                                chroma_list,
-                                                fmt_dst,
-                                                fmt_src,
-                                                render_subtitle_date,
-                                                render_osd_date);
+    subpicture_t *render = SpuRenderLocked(spu, chroma_list, fmt_dst, fmt_src,
+                                           render_subtitle_date,
+                                           render_osd_date, ignore_osd, NULL);
     vlc_mutex_unlock(&sys->lock);
 
     return render;
 }
 
+/**
+ * Requests the subpictures for a future picture to be rendered ahead of
+ * time, so that the spu_Render() call for that picture returns them at once.
+ */
+void spu_Prerender(spu_t *spu,
+                   const vlc_fourcc_t *chroma_list,
+                   const video_format_t *fmt_dst,
+                   const video_format_t *fmt_src,
+                   vlc_tick_t render_subtitle_date)
+{
+    spu_private_t *sys = spu->p;
+
+    vlc_mutex_lock(&sys->lock);
+    if (sys->prerender.running) {
+        SpuPrerenderFlush(sys);
+        sys->prerender.chroma_list = SpuChromaList(chroma_list, fmt_dst);
+        sys->prerender.fmt_dst = *fmt_dst;
+        sys->prerender.fmt_src = *fmt_src;
+        sys->prerender.date = render_subtitle_date;
+        sys->prerender.pending = true;
+        vlc_cond_signal(&sys->prerender.wait);
+    }
+    vlc_mutex_unlock(&sys->lock);
+}
+
 void spu_OffsetSubtitleDate(spu_t *spu, vlc_tick_t duration)
 {
     spu_private_t *sys = spu->p;
 
     vlc_mutex_lock(&sys->lock);
+    sys->generation++;
     for (int i = 0; i < VOUT_MAX_SUBPICTURES; i++) {
         spu_heap_entry_t *entry = &sys->heap.entry[i];
         subpicture_t *current = entry->subpicture;
@@ -1654,6 +1845,7 @@ void spu_ClearChannel(spu_t *spu, int channel)
     spu_private_t *sys = spu->p;
 
     vlc_mutex_lock(&sys->lock);
+    sys->generation++;
 
     for (int i = 0; i < VOUT_MAX_SUBPICTURES; i++) {
         spu_heap_entry_t *entry = &sys->heap.entry[i];
@@ -1715,6 +1907,7 @@ void spu_ChangeMargin(spu_t *spu, int margin)
 
     vlc_mutex_lock(&sys->lock);
     sys->margin = margin;
+    sys->generation++;
     vlc_mutex_unlock(&sys->lock);
 }
 
@@ -116,6 +116,32 @@ static void NoDrInit(vout_thread_t *vout)
         sys->display_pool = NULL;
 }
 
+/* Checks that the display pictures can be rendered into by a decoder
+ * requiring the given alignment. Otherwise, the decoder would have to
+ * render elsewhere and copy every picture itself; the system memory pool
+ * is then a better choice. */
+static bool IsPoolAligned(picture_pool_t *pool, unsigned align)
+{
+    if (align <= 1)
+        return true;
+
+    picture_t *picture = picture_pool_Get(pool);
+    if (picture == NULL)
+        return true;
+
+    bool aligned = true;
+    for (int i = 0; i < picture->i_planes; i++) {
+        const plane_t *p = &picture->p[i];
+        if (p->p_pixels == NULL) /* opaque surfaces */
+            continue;
+        if ((p->i_pitch % align) != 0 ||
+            ((uintptr_t)p->p_pixels % align) != 0)
+            aligned = false;
+    }
+    picture_Release(picture);
+    return aligned;
+}
+
 int vout_InitWrapper(vout_thread_t *vout)
 {
     vout_thread_sys_t *sys = vout->p;
@@ -123,9 +149,9 @@ int vout_InitWrapper(vout_thread_t *vout)
 
     sys->display.use_dr = !vout_IsDisplayFiltered(vd);
     const bool allow_dr = !vd->info.has_pictures_invalid && !vd->info.is_slow && sys->display.use_dr;
-    const unsigned private_picture  = 4; /* XXX 3 for filter, 1 for SPU */
+    const unsigned private_picture  = 4 + VOUT_PREPARE_AHEAD; /* XXX 3 for filter, 1 for SPU, prepared */
     const unsigned decoder_picture  = 1 + sys->dpb_size;
-    const unsigned kept_picture     = 1; /* last displayed picture */
+    const unsigned kept_picture     = 1 + VOUT_PREPARE_AHEAD; /* last displayed picture, sources of the prepared ones */
     const unsigned reserved_picture = DISPLAY_PICTURE_COUNT +
                                       private_picture +
                                       kept_picture;
@@ -142,7 +168,8 @@ int vout_InitWrapper(vout_thread_t *vout)
 #endif
 
     if (allow_dr &&
-        picture_pool_GetSize(display_pool) >= reserved_picture + decoder_picture) {
+        picture_pool_GetSize(display_pool) >= reserved_picture + decoder_picture &&
+        IsPoolAligned(display_pool, sys->picture_align)) {
         sys->dpb_size     = picture_pool_GetSize(display_pool) - reserved_picture;
         sys->decoder_pool = display_pool;
         sys->display_pool = display_pool;
@@ -153,10 +180,14 @@ int vout_InitWrapper(vout_thread_t *vout)
                                              reserved_picture + decoder_picture - DISPLAY_PICTURE_COUNT));
         if (!sys->decoder_pool)
             return VLC_EGENERIC;
-        if (allow_dr) {
+        if (allow_dr &&
+            picture_pool_GetSize(display_pool) < reserved_picture + decoder_picture) {
             msg_Warn(vout, "Not enough direct buffers, using system memory");
             sys->dpb_size = 0;
         } else {
+            if (allow_dr)
+                msg_Dbg(vout, "Direct buffers not aligned to %u bytes, using system memory",
+                        sys->picture_align);
             sys->dpb_size = picture_pool_GetSize(sys->decoder_pool) - reserved_picture;
         }
         NoDrInit(vout);
@@ -190,6 +190,52 @@ static void test_media_player_pause_stop(const char** argv, int argc)
     libvlc_release (vlc);
 }
 
+static void test_media_player_mirror(const char** argv, int argc)
+{
+    libvlc_instance_t *vlc;
+    libvlc_media_t *md;
+    libvlc_media_player_t *mi, *mirror;
+    const char * file = test_default_video;
+
+    log ("Testing mirroring of %s\n", file);
+
+    vlc = libvlc_new (argc, argv);
+    assert (vlc != NULL);
+
+    md = libvlc_media_new_path (vlc, file);
+    assert (md != NULL);
+
+    mi = libvlc_media_player_new_from_media (md);
+    assert (mi != NULL);
+
+    libvlc_media_release (md);
+
+    mirror = libvlc_media_player_new (vlc);
+    assert (mirror != NULL);
+
+    assert (libvlc_media_player_set_mirror (mi, mi) == -1);
+    assert (libvlc_media_player_set_mirror (mirror, mi) == 0);
+
+    libvlc_media_player_play (mi);
+    log ("Waiting for playing\n");
+    wait_playing (mi);
+
+    /* Removal closes the outputs of the mirror at once, so the mirror can
+     * be destroyed while the source keeps playing */
+    assert (libvlc_media_player_set_mirror (mirror, NULL) == 0);
+    libvlc_media_player_release (mirror);
+
+    /* The last player may also be destroyed while still mirroring */
+    mirror = libvlc_media_player_new (vlc);
+    assert (mirror != NULL);
+    assert (libvlc_media_player_set_mirror (mirror, mi) == 0);
+    libvlc_media_player_release (mirror);
+
+    libvlc_media_player_stop (mi);
+    libvlc_media_player_release (mi);
+    libvlc_release (vlc);
+}
+
 
 int main (void)
 {
@@ -198,6 +244,7 @@ int main (void)
     test_media_player_set_media (test_defaults_args, test_defaults_nargs);
     test_media_player_play_stop (test_defaults_args, test_defaults_nargs);
     test_media_player_pause_stop (test_defaults_args, test_defaults_nargs);
+    test_media_player_mirror (test_defaults_args, test_defaults_nargs);
 
     return 0;
 }
@@ -0,0 +1,274 @@
+/*****************************************************************************
+ * startcode.c: AnnexB startcode lookup tests and benchmark
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vlc_common.h>
+#include "../modules/packetizer/startcode_helper.h"
+
+/* Runs the correctness checks, then measures the throughput of each
+ * available variant, either on synthetic streams or on the files given
+ * as arguments (raw AnnexB elementary streams). */
+
+typedef const uint8_t * (*startcode_find_t)( const uint8_t *, const uint8_t * );
+
+static struct
+{
+    const char *psz_name;
+    startcode_find_t pf_find;
+    bool b_available;
+} variants[] = {
+    { "C",    startcode_FindAnnexB_Bits, true },
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+    { "SSE2", startcode_FindAnnexB_SSE2, false },
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    { "AVX2", startcode_FindAnnexB_AVX2, false },
+#endif
+#ifdef HAVE_STARTCODE_NEON
+    { "NEON", startcode_FindAnnexB_NEON, false },
+#endif
+};
+
+static void probe_variants( void )
+{
+    for( size_t i = 0; i < ARRAY_SIZE(variants); i++ )
+    {
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+        if( variants[i].pf_find == startcode_FindAnnexB_SSE2 )
+            variants[i].b_available = vlc_CPU_SSE2();
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+        if( variants[i].pf_find == startcode_FindAnnexB_AVX2 )
+            variants[i].b_available = vlc_CPU_AVX2();
+#endif
+#ifdef HAVE_STARTCODE_NEON
+        if( variants[i].pf_find == startcode_FindAnnexB_NEON )
+            variants[i].b_available = vlc_CPU_ARM64_NEON();
+#endif
+    }
+}
+
+static const uint8_t * reference_find( const uint8_t *p, const uint8_t *end )
+{
+    for( ; end - p >= 3; p++ )
+    {
+        if( p[0] == 0 && p[1] == 0 && p[2] == 1 )
+            return p;
+    }
+    return NULL;
+}
+
+static size_t count_startcodes( startcode_find_t pf_find,
+                                const uint8_t *p, const uint8_t *end )
+{
+    size_t i_count = 0;
+    while( (p = pf_find( p, end )) )
+    {
+        i_count++;
+        p += 3;
+    }
+    return i_count;
+}
+
+/* Dense buffers of 0 and 1 values, at all alignments and small sizes,
+ * so that every prologue, vector and epilogue boundary gets hit */
+static void test_boundaries( startcode_find_t pf_find )
+{
+    uint8_t buf[256 + 64];
+    srand( 42 );
+    for( unsigned i_pass = 0; i_pass < 16; i_pass++ )
+    {
+        for( size_t i = 0; i < sizeof(buf); i++ )
+            buf[i] = ( rand() % 3 ) ? 0 : 1;
+
+        for( size_t i_offset = 0; i_offset < 64; i_offset++ )
+        {
+            for( size_t i_size = 0; i_size <= 256; i_size++ )
+            {
+                const uint8_t *p = &buf[i_offset];
+                const uint8_t *end = p + i_size;
+                for( ;; )
+                {
+                    const uint8_t *ref = reference_find( p, end );
+                    const uint8_t *res = pf_find( p, end );
+                    assert( ref == res );
+                    if( !ref )
+                        break;
+                    p = ref + 1;
+                }
+            }
+        }
+    }
+}
+
+/* Emulation prevented payloads, with a 3 or 4 bytes startcode before
+ * every NAL, which is what the packetizers scan in practice */
+static uint8_t * generate_stream( size_t i_size, size_t i_nal_size, size_t *pi_count )
+{
+    uint8_t *p_buf = malloc( i_size );
+    if( !p_buf )
+        return NULL;
+
+    size_t i = 0, i_count = 0;
+    unsigned i_zeros = 0;
+    while( i < i_size )
+    {
+        size_t i_nal_end = i + i_nal_size / 2 + rand() % i_nal_size;
+        if( i + 4 <= i_size )
+        {
+            if( rand() & 1 )
+                p_buf[i++] = 0;
+            p_buf[i++] = 0; p_buf[i++] = 0; p_buf[i++] = 1;
+            i_count++;
+        }
+        i_zeros = 0;
+        for( ; i < i_nal_end && i + 1 < i_size; i++ )
+        {
+            /* entropy coded payloads, with some extra zeros */
+            uint8_t v = ( rand() % 64 ) ? rand() : 0;
+            if( i_zeros >= 2 && v <= 3 )
+            {
+                p_buf[i++] = 3;
+                i_zeros = 0;
+            }
+            p_buf[i] = v;
+            i_zeros = v ? 0 : i_zeros + 1;
+        }
+        /* no trailing zero before the next startcode */
+        if( i < i_size )
+            p_buf[i++] = 0x80;
+    }
+
+    *pi_count = i_count;
+    return p_buf;
+}
+
+static void bench( const char *psz_name, const uint8_t *p_buf, size_t i_buf,
+                   size_t i_count )
+{
+    /* scan at least 256MB per variant */
+    unsigned i_passes = 1 + ( 256 << 20 ) / i_buf;
+
+    printf( "%s: %zu bytes, %zu startcodes\n", psz_name, i_buf, i_count );
+    for( size_t i = 0; i < ARRAY_SIZE(variants); i++ )
+    {
+        if( !variants[i].b_available )
+            continue;
+
+        assert( count_startcodes( variants[i].pf_find,
+                                  p_buf, p_buf + i_buf ) == i_count );
+
+        mtime_t i_start = mdate();
+        size_t i_total = 0;
+        for( unsigned j = 0; j < i_passes; j++ )
+            i_total += count_startcodes( variants[i].pf_find, p_buf, p_buf + i_buf );
+        mtime_t i_elapsed = mdate() - i_start;
+        assert( i_total == i_count * i_passes );
+
+        printf( "  %-5s %8.1f MB/s\n", variants[i].psz_name,
+                i_elapsed ? (double) i_buf * i_passes / i_elapsed : 0. );
+    }
+}
+
+static uint8_t * load_file( const char *psz_path, size_t *pi_size )
+{
+    FILE *fp = fopen( psz_path, "rb" );
+    if( !fp )
+        return NULL;
+
+    uint8_t *p_buf = NULL;
+    if( fseek( fp, 0, SEEK_END ) == 0 )
+    {
+        long i_size = ftell( fp );
+        if( i_size > 0 && fseek( fp, 0, SEEK_SET ) == 0 &&
+            (p_buf = malloc( i_size )) )
+        {
+            if( fread( p_buf, 1, i_size, fp ) == (size_t) i_size )
+                *pi_size = i_size;
+            else
+                FREENULL( p_buf );
+        }
+    }
+    fclose( fp );
+    return p_buf;
+}
+
+int main( int argc, char **argv )
+{
+    probe_variants();
+
+    for( size_t i = 0; i < ARRAY_SIZE(variants); i++ )
+    {
+        if( !variants[i].b_available )
+            continue;
+        printf( "checking %s\n", variants[i].psz_name );
+        test_boundaries( variants[i].pf_find );
+    }
+
+    if( argc > 1 )
+    {
+        for( int i = 1; i < argc; i++ )
+        {
+            size_t i_buf;
+            uint8_t *p_buf = load_file( argv[i], &i_buf );
+            if( !p_buf )
+            {
+                fprintf( stderr, "cannot read %s\n", argv[i] );
+                return 1;
+            }
+            bench( argv[i], p_buf, i_buf,
+                   count_startcodes( reference_find, p_buf, p_buf + i_buf ) );
+            free( p_buf );
+        }
+        return 0;
+    }
+
+    /* slice sizes of typical 1080p and 2160p streams */
+    static const struct
+    {
+        const char *psz_name;
+        size_t i_nal_size;
+    } profiles[] = {
+        { "1080p slices", 24 * 1024 },
+        { "2160p slices", 160 * 1024 },
+    };
+
+    for( size_t i = 0; i < ARRAY_SIZE(profiles); i++ )
+    {
+        size_t i_count;
+        uint8_t *p_buf = generate_stream( 16 << 20, profiles[i].i_nal_size, &i_count );
+        assert( p_buf );
+        assert( count_startcodes( reference_find, p_buf, p_buf + (16 << 20) ) == i_count );
+        bench( profiles[i].psz_name, p_buf, 16 << 20, i_count );
+        free( p_buf );
+    }
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+/*****************************************************************************
+ * ring.c: test the lock-free audio ring buffer
+ *****************************************************************************
+ * Copyright (C) 2018 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <sched.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+
+#define STREAM_SIZE (4 * 1024 * 1024)
+
+static void test_single(void)
+{
+    uint8_t in[300], out[300];
+    for (size_t i = 0; i < sizeof (in); i++)
+        in[i] = i;
+
+    aout_ring_t *ring = aout_ring_New(200);
+    assert(ring != NULL);
+    assert(aout_ring_Used(ring) == 0);
+    assert(aout_ring_Read(ring, out, sizeof (out)) == 0);
+
+    /* Capacity is rounded up to 256 */
+    assert(aout_ring_Write(ring, in, sizeof (in)) == 256);
+    assert(aout_ring_Used(ring) == 256);
+    assert(aout_ring_Write(ring, in, 1) == 0);
+
+    assert(aout_ring_Read(ring, out, 100) == 100);
+    assert(memcmp(in, out, 100) == 0);
+    assert(aout_ring_Used(ring) == 156);
+
+    /* Wrap around */
+    assert(aout_ring_Write(ring, in, 100) == 100);
+    assert(aout_ring_Read(ring, out, 156) == 156);
+    assert(memcmp(in + 100, out, 156) == 0);
+    assert(aout_ring_Read(ring, out, sizeof (out)) == 100);
+    assert(memcmp(in, out, 100) == 0);
+    assert(aout_ring_Used(ring) == 0);
+
+    /* Flushed data is skipped by the next read */
+    assert(aout_ring_Write(ring, in, 50) == 50);
+    aout_ring_Flush(ring);
+    assert(aout_ring_Used(ring) == 0);
+    assert(aout_ring_Write(ring, in + 50, 20) == 20);
+    assert(aout_ring_Used(ring) == 20);
+    assert(aout_ring_Read(ring, out, sizeof (out)) == 20);
+    assert(memcmp(in + 50, out, 20) == 0);
+
+    /* A flush older than the read position is ignored */
+    aout_ring_Flush(ring);
+    assert(aout_ring_Write(ring, in, 10) == 10);
+    assert(aout_ring_Read(ring, out, 5) == 5);
+    assert(aout_ring_Used(ring) == 5);
+    assert(aout_ring_Read(ring, out, sizeof (out)) == 5);
+    assert(memcmp(in + 5, out, 5) == 0);
+
+    aout_ring_Delete(ring);
+}
+
+static void *consumer(void *data)
+{
+    aout_ring_t *ring = data;
+    uint8_t buf[333];
+    size_t total = 0;
+
+    while (total < STREAM_SIZE)
+    {
+        size_t len = aout_ring_Read(ring, buf, sizeof (buf));
+        for (size_t i = 0; i < len; i++)
+            assert(buf[i] == (uint8_t)((total + i) % 251));
+        total += len;
+        if (len == 0)
+            sched_yield();
+    }
+    return NULL;
+}
+
+static void test_threaded(void)
+{
+    aout_ring_t *ring = aout_ring_New(4096);
+    assert(ring != NULL);
+
+    vlc_thread_t th;
+    int ret = vlc_clone(&th, consumer, ring, VLC_THREAD_PRIORITY_LOW);
+    assert(ret == 0);
+
+    uint8_t buf[1000];
+    size_t total = 0;
+    while (total < STREAM_SIZE)
+    {
+        size_t len = __MIN(sizeof (buf), STREAM_SIZE - total);
+        for (size_t i = 0; i < len; i++)
+            buf[i] = (total + i) % 251;
+
+        size_t done = 0;
+        while (done < len)
+        {
+            size_t written = aout_ring_Write(ring, buf + done, len - done);
+            if (written == 0)
+                sched_yield();
+            done += written;
+        }
+        total += len;
+    }
+
+    vlc_join(th, NULL);
+    assert(aout_ring_Used(ring) == 0);
+    aout_ring_Delete(ring);
+}
+
+int main(void)
+{
+    test_single();
+    test_threaded();
+    return 0;
+}
@@ -0,0 +1,380 @@
+/*****************************************************************************
+ * bench.c: core media primitives micro-benchmarks
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+#undef log /* conflicts with <math.h> */
+
+#include <limits.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_stream.h>
+#include <vlc_bits.h>
+#include <vlc_picture_pool.h>
+#include <vlc_filter.h>
+#include <vlc_variables.h>
+#include "../modules/packetizer/startcode_helper.h"
+
+/* Each benchmark runs for at least BENCH_ROUND, BENCH_ROUNDS times, and the
+ * median time per operation is reported, as JSON on the standard output.
+ * A benchmark name given as argument restricts the run to it. */
+#define BENCH_ROUND  (CLOCK_FREQ / 20)
+#define BENCH_ROUNDS 7
+
+#define BUFFER_SIZE (1 << 20)
+
+static uint8_t buffer[BUFFER_SIZE];
+static volatile uint64_t sink; /* keeps results alive */
+
+/*** block ***/
+static void *block_alloc_setup( libvlc_int_t *obj )
+{
+    (void) obj;
+    return buffer;
+}
+
+static void block_alloc_run( void *opaque, unsigned n )
+{
+    (void) opaque;
+    for( unsigned i = 0; i < n; i++ )
+        block_Release( block_Alloc( 1500 ) );
+}
+
+static void *block_fifo_setup( libvlc_int_t *obj )
+{
+    (void) obj;
+    return block_FifoNew();
+}
+
+static void block_fifo_run( void *opaque, unsigned n )
+{
+    block_fifo_t *fifo = opaque;
+    block_t *block = block_Alloc( 188 );
+
+    if( block == NULL )
+        return;
+    for( unsigned i = 0; i < n; i++ )
+    {
+        block_FifoPut( fifo, block );
+        block = block_FifoGet( fifo );
+    }
+    block_Release( block );
+}
+
+static void block_fifo_cleanup( void *opaque )
+{
+    block_FifoRelease( opaque );
+}
+
+/*** stream ***/
+static void *stream_setup( libvlc_int_t *obj )
+{
+    return vlc_stream_MemoryNew( obj, buffer, sizeof (buffer), true );
+}
+
+static void stream_read_run( void *opaque, unsigned n )
+{
+    stream_t *s = opaque;
+    uint8_t buf[4096];
+
+    for( unsigned i = 0; i < n; i++ )
+        if( vlc_stream_Read( s, buf, sizeof (buf) ) < (ssize_t)sizeof (buf) )
+            vlc_stream_Seek( s, 0 );
+}
+
+static void stream_peek_run( void *opaque, unsigned n )
+{
+    stream_t *s = opaque;
+    const uint8_t *peek;
+
+    for( unsigned i = 0; i < n; i++ )
+    {
+        if( vlc_stream_Peek( s, &peek, 188 ) < 188 )
+            vlc_stream_Seek( s, 0 );
+        else
+            vlc_stream_Read( s, NULL, 188 );
+    }
+}
+
+static void stream_cleanup( void *opaque )
+{
+    vlc_stream_Delete( opaque );
+}
+
+/*** bitstream ***/
+static void *bits_setup( libvlc_int_t *obj )
+{
+    (void) obj;
+    return buffer;
+}
+
+static void bits_read_run( void *opaque, unsigned n )
+{
+    bs_t bs;
+    uint32_t sum = 0;
+
+    bs_init( &bs, opaque, BUFFER_SIZE );
+    for( unsigned i = 0; i < n; i++ )
+    {
+        if( bs_eof( &bs ) )
+            bs_init( &bs, opaque, BUFFER_SIZE );
+        sum += bs_read( &bs, 13 );
+    }
+    sink = sum;
+}
+
+/*** start codes ***/
+static void *startcode_setup( libvlc_int_t *obj )
+{
+    (void) obj;
+    /* entropy-like payload with a start code every ~4 kB */
+    srand( 42 );
+    for( size_t i = 0; i < BUFFER_SIZE; i++ )
+        buffer[i] = 0x80 | rand();
+    for( size_t i = 0; i + 3 <= BUFFER_SIZE; i += 4000 + rand() % 200 )
+        memcpy( &buffer[i], "\x00\x00\x01", 3 );
+    return buffer;
+}
+
+/* One operation scans 64 kB */
+static void startcode_run( void *opaque, unsigned n )
+{
+    const uint8_t *base = opaque;
+
+    for( unsigned i = 0; i < n; i++ )
+    {
+        const uint8_t *p = base + ( i % 16 ) * 65536;
+        const uint8_t *end = p + 65536;
+
+        while( ( p = startcode_FindAnnexB( p, end ) ) != NULL )
+            p += 3;
+    }
+}
+
+/*** picture pool ***/
+static void *picture_pool_setup( libvlc_int_t *obj )
+{
+    video_format_t fmt;
+
+    (void) obj;
+    video_format_Setup( &fmt, VLC_CODEC_I420, 1280, 720, 1280, 720, 1, 1 );
+    return picture_pool_NewFromFormat( &fmt, 8 );
+}
+
+static void picture_pool_run( void *opaque, unsigned n )
+{
+    for( unsigned i = 0; i < n; i++ )
+    {
+        picture_t *pic = picture_pool_Get( opaque );
+        if( pic != NULL )
+            picture_Release( pic );
+    }
+}
+
+static void picture_pool_cleanup( void *opaque )
+{
+    picture_pool_Release( opaque );
+}
+
+/*** blending ***/
+struct blend_ctx
+{
+    filter_t *filter;
+    picture_t *dst;
+    picture_t *src;
+};
+
+static void blend_cleanup( void *opaque );
+
+static void *blend_setup( libvlc_int_t *obj )
+{
+    struct blend_ctx *ctx = calloc( 1, sizeof (*ctx) );
+    video_format_t dst_fmt, src_fmt;
+
+    if( ctx == NULL )
+        return NULL;
+
+    video_format_Setup( &dst_fmt, VLC_CODEC_I420, 1280, 720, 1280, 720, 1, 1 );
+    video_format_Setup( &src_fmt, VLC_CODEC_YUVA, 640, 120, 640, 120, 1, 1 );
+
+    ctx->dst = picture_NewFromFormat( &dst_fmt );
+    ctx->src = picture_NewFromFormat( &src_fmt );
+    ctx->filter = filter_NewBlend( VLC_OBJECT(obj), &dst_fmt );
+    if( ctx->dst == NULL || ctx->src == NULL || ctx->filter == NULL
+     || filter_ConfigureBlend( ctx->filter, 1280, 720, &src_fmt ) )
+    {
+        blend_cleanup( ctx );
+        return NULL;
+    }
+
+    for( int i = 0; i < ctx->src->i_planes; i++ )
+        memset( ctx->src->p[i].p_pixels, 0x80,
+                ctx->src->p[i].i_pitch * ctx->src->p[i].i_lines );
+    return ctx;
+}
+
+/* One operation blends a 640x120 subtitle-like picture */
+static void blend_run( void *opaque, unsigned n )
+{
+    struct blend_ctx *ctx = opaque;
+
+    for( unsigned i = 0; i < n; i++ )
+        filter_Blend( ctx->filter, ctx->dst, 320, 560, ctx->src, 0xff );
+}
+
+static void blend_cleanup( void *opaque )
+{
+    struct blend_ctx *ctx = opaque;
+
+    if( ctx->filter != NULL )
+        filter_DeleteBlend( ctx->filter );
+    if( ctx->src != NULL )
+        picture_Release( ctx->src );
+    if( ctx->dst != NULL )
+        picture_Release( ctx->dst );
+    free( ctx );
+}
+
+/*** variables ***/
+static void *var_setup( libvlc_int_t *obj )
+{
+    var_Create( obj, "bench-integer", VLC_VAR_INTEGER );
+    var_SetInteger( obj, "bench-integer", 42 );
+    return obj;
+}
+
+static void var_get_run( void *opaque, unsigned n )
+{
+    int64_t sum = 0;
+
+    for( unsigned i = 0; i < n; i++ )
+        sum += var_GetInteger( (vlc_object_t *)opaque, "bench-integer" );
+    sink = sum;
+}
+
+static void var_cleanup( void *opaque )
+{
+    var_Destroy( (vlc_object_t *)opaque, "bench-integer" );
+}
+
+static const struct
+{
+    const char *name;
+    void *(*setup)( libvlc_int_t * );
+    void (*run)( void *, unsigned );
+    void (*cleanup)( void * );
+} benchmarks[] = {
+    { "block_alloc",      block_alloc_setup,  block_alloc_run,  NULL },
+    { "block_fifo",       block_fifo_setup,   block_fifo_run,   block_fifo_cleanup },
+    { "stream_read_4k",   stream_setup,       stream_read_run,  stream_cleanup },
+    { "stream_peek_188",  stream_setup,       stream_peek_run,  stream_cleanup },
+    { "bs_read",          bits_setup,         bits_read_run,    NULL },
+    { "startcode_64k",    startcode_setup,    startcode_run,    NULL },
+    { "picture_pool_get", picture_pool_setup, picture_pool_run, picture_pool_cleanup },
+    { "blend_i420",       blend_setup,        blend_run,        blend_cleanup },
+    { "var_get",          var_setup,          var_get_run,      var_cleanup },
+};
+
+static int compare_double( const void *a, const void *b )
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return ( x > y ) - ( x < y );
+}
+
+/* Returns the median time per operation in nanoseconds */
+static double measure( void (*run)( void *, unsigned ), void *opaque,
+                       unsigned *restrict iterations )
+{
+    double samples[BENCH_ROUNDS];
+    unsigned n = 1;
+
+    run( opaque, n ); /* warm up */
+    for( ;; )
+    {
+        mtime_t start = mdate();
+        run( opaque, n );
+        if( mdate() - start >= BENCH_ROUND || n >= UINT_MAX / 2 )
+            break;
+        n *= 2;
+    }
+
+    for( unsigned i = 0; i < BENCH_ROUNDS; i++ )
+    {
+        mtime_t start = mdate();
+        run( opaque, n );
+        samples[i] = (double)( mdate() - start ) * ( 1000000000 / CLOCK_FREQ )
+                   / n;
+    }
+
+    qsort( samples, BENCH_ROUNDS, sizeof (samples[0]), compare_double );
+    *iterations = n;
+    return samples[BENCH_ROUNDS / 2];
+}
+
+int main( int argc, char **argv )
+{
+    setenv( "VLC_PLUGIN_PATH", "../modules", 1 );
+
+    libvlc_instance_t *vlc = libvlc_new( test_defaults_nargs,
+                                         test_defaults_args );
+    if( vlc == NULL )
+        return 1;
+
+    libvlc_int_t *obj = vlc->p_libvlc_int;
+    bool first = true;
+
+    printf( "{\n  \"unit\": \"ns/op\",\n  \"benchmarks\": [" );
+    for( size_t i = 0; i < ARRAY_SIZE(benchmarks); i++ )
+    {
+        if( argc > 1 )
+        {
+            int j = 1;
+            while( j < argc && strcmp( argv[j], benchmarks[i].name ) )
+                j++;
+            if( j == argc )
+                continue;
+        }
+
+        void *opaque = benchmarks[i].setup( obj );
+        if( opaque == NULL )
+        {
+            fprintf( stderr, "%s: not available\n", benchmarks[i].name );
+            continue;
+        }
+
+        unsigned iterations;
+        double ns = measure( benchmarks[i].run, opaque, &iterations );
+
+        if( benchmarks[i].cleanup != NULL )
+            benchmarks[i].cleanup( opaque );
+
+        printf( "%s\n    { \"name\": \"%s\", \"value\": %.2f, "
+                "\"iterations\": %u }", first ? "" : ",",
+                benchmarks[i].name, ns, iterations );
+        first = false;
+        fflush( stdout );
+    }
+    printf( "\n  ]\n}\n" );
+
+    libvlc_release( vlc );
+    return 0;
+}
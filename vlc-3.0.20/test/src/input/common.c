@@ -22,7 +22,10 @@
 # include "config.h"
 #endif
 
+#include <time.h>
+
 #include "../lib/libvlc_internal.h"
+#include <vlc_block.h>
 
 #include "common.h"
 
@@ -41,6 +44,36 @@ void vlc_run_args_init(struct vlc_run_args *args)
 
     args->name = getenv("VLC_TARGET");
     args->test_demux_controls = getenv_atoi("VLC_DEMUX_CONTROLS");
+    args->benchmark = getenv_atoi("VLC_DEMUX_BENCH");
+    args->decoder = getenv("VLC_DECODER");
+    args->filters = getenv("VLC_FILTERS");
+}
+
+void vlc_run_counters_get(struct vlc_run_counters *mark)
+{
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    mark->time = ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+#else
+    mark->time = mdate() * 1000;
+#endif
+
+    /* exact for the calling thread, which flushes its own cache stats */
+    block_pool_stats_t stats;
+    block_PoolGetStats(&stats);
+    mark->allocs = stats.i_thread_hits + stats.i_global_hits
+                 + stats.i_misses + stats.i_unpooled;
+}
+
+void vlc_run_counters_add(struct vlc_run_counters *total,
+                          struct vlc_run_counters *mark)
+{
+    struct vlc_run_counters now;
+    vlc_run_counters_get(&now);
+    total->time += now.time - mark->time;
+    total->allocs += now.allocs - mark->allocs;
+    *mark = now;
 }
 
 libvlc_instance_t *libvlc_create(const struct vlc_run_args *args)
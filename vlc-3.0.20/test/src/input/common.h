@@ -37,8 +37,32 @@ struct vlc_run_args
 
     /* true to test demux controls */
     bool test_demux_controls;
+
+    /* true to print per ES timings and allocations as JSON */
+    bool benchmark;
+
+    /* force specific decoder name, "none" to stop after the packetizer.
+     * NULL to don't force any */
+    const char *decoder;
+
+    /* video filter chain applied to decoded pictures before dropping them.
+     * NULL for none */
+    const char *filters;
 };
 
+/* Time (in ns) and block allocations spent in a processing stage */
+struct vlc_run_counters
+{
+    uint64_t time;
+    uint64_t allocs;
+};
+
+/* Reads the current counters into mark */
+void vlc_run_counters_get(struct vlc_run_counters *mark);
+/* Adds what was spent since mark to total, and moves mark to now */
+void vlc_run_counters_add(struct vlc_run_counters *total,
+                          struct vlc_run_counters *mark);
+
 void vlc_run_args_init(struct vlc_run_args *args);
 
 libvlc_instance_t *libvlc_create(const struct vlc_run_args *args);
@@ -27,6 +27,7 @@
 #include <vlc_common.h>
 #include <vlc_modules.h>
 #include <vlc_codec.h>
+#include <vlc_filter.h>
 #include <vlc_stream.h>
 #include <vlc_access.h>
 #include <vlc_meta.h>
@@ -34,11 +35,72 @@
 #include <vlc_url.h>
 
 #include <vlc/libvlc.h>
-#include "../../lib/libvlc_internal.h"
+#include "../lib/libvlc_internal.h"
 
 #include "common.h"
 #include "decoder.h"
 
+struct test_packetizer
+{
+    decoder_t dec;
+    struct test_decoder_stats stats;
+    struct vlc_run_counters mark;
+
+    bool decode; /* false to stop after the packetizer */
+    const char *filters_name;
+    filter_chain_t *filters;
+    video_format_t filters_fmt;
+};
+
+static picture_t *video_new_buffer_filter(filter_t *filter)
+{
+    return picture_NewFromFormat(&filter->fmt_out.video);
+}
+
+static void video_filter(struct test_packetizer *owner, decoder_t *dec,
+                         picture_t *pic)
+{
+    if (owner->filters != NULL
+     && !video_format_IsSimilar(&owner->filters_fmt, &dec->fmt_out.video))
+    {
+        filter_chain_Delete(owner->filters);
+        owner->filters = NULL;
+        video_format_Clean(&owner->filters_fmt);
+    }
+
+    if (owner->filters == NULL)
+    {
+        static const filter_owner_t filter_owner = {
+            .video = {
+                .buffer_new = video_new_buffer_filter,
+            },
+        };
+
+        owner->filters = filter_chain_NewVideo(dec, true, &filter_owner);
+        if (owner->filters == NULL)
+        {
+            picture_Release(pic);
+            return;
+        }
+
+        es_format_t fmt;
+        es_format_InitFromVideo(&fmt, &dec->fmt_out.video);
+        filter_chain_Reset(owner->filters, &fmt, &fmt);
+        es_format_Clean(&fmt);
+        if (filter_chain_AppendFromString(owner->filters,
+                                          owner->filters_name) < 0)
+            debug("cannot append filters: %s\n", owner->filters_name);
+        video_format_Copy(&owner->filters_fmt, &dec->fmt_out.video);
+    }
+
+    for (pic = filter_chain_VideoFilter(owner->filters, pic); pic != NULL;
+         pic = filter_chain_VideoFilter(owner->filters, NULL))
+    {
+        owner->stats.pictures++;
+        picture_Release(pic);
+    }
+}
+
 static picture_t *video_new_buffer_decoder(decoder_t *dec)
 {
     return picture_NewFromFormat(&dec->fmt_out.video);
@@ -58,7 +120,18 @@ static int video_update_format_decoder(decoder_t *dec)
 }
 static int queue_video(decoder_t *dec, picture_t *pic)
 {
-    (void) dec;
+    struct test_packetizer *owner = (void *) dec->p_owner;
+
+    if (owner->filters_name != NULL)
+    {
+        /* account the filters separately from the decoder */
+        vlc_run_counters_add(&owner->stats.decoder, &owner->mark);
+        video_filter(owner, dec, pic);
+        vlc_run_counters_add(&owner->stats.filter, &owner->mark);
+        return 0;
+    }
+
+    owner->stats.pictures++;
     picture_Release(pic);
     return 0;
 }
@@ -83,7 +156,7 @@ static int queue_sub(decoder_t *dec, subpicture_t *p_subpic)
 }
 
 static int decoder_load(decoder_t *decoder, bool is_packetizer,
-                         const es_format_t *restrict fmt)
+                         const es_format_t *restrict fmt, const char *name)
 {
     decoder->b_frame_drop_allowed = true;
     decoder->i_extra_picture_buffers = 0;
@@ -104,7 +177,8 @@ static int decoder_load(decoder_t *decoder, bool is_packetizer,
             [SPU_ES] = "spu decoder",
         };
         decoder->p_module =
-            module_need(decoder, caps[decoder->fmt_in.i_cat], NULL, false);
+            module_need(decoder, caps[decoder->fmt_in.i_cat], name,
+                        name != NULL);
     }
     else
         decoder->p_module = module_need(decoder, "packetizer", NULL, false);
@@ -136,20 +210,27 @@ static void decoder_unload(decoder_t *decoder)
 void test_decoder_destroy(decoder_t *decoder)
 {
     decoder_t *packetizer = (void *) decoder->p_owner;
+    struct test_packetizer *owner = (struct test_packetizer *)packetizer;
 
+    if (owner->filters != NULL)
+    {
+        filter_chain_Delete(owner->filters);
+        video_format_Clean(&owner->filters_fmt);
+    }
     decoder_unload(packetizer);
     decoder_unload(decoder);
     vlc_object_release(packetizer);
     vlc_object_release(decoder);
 }
 
-decoder_t *test_decoder_create(vlc_object_t *parent, const es_format_t *fmt)
+decoder_t *test_decoder_create(vlc_object_t *parent, const es_format_t *fmt,
+                               const struct vlc_run_args *args)
 {
     assert(parent && fmt);
     decoder_t *packetizer = NULL;
     decoder_t *decoder = NULL;
 
-    packetizer = vlc_object_create(parent, sizeof(*packetizer));
+    packetizer = vlc_object_create(parent, sizeof(struct test_packetizer));
     decoder = vlc_object_create(parent, sizeof(*decoder));
 
     if (packetizer == NULL || decoder == NULL)
@@ -168,10 +249,18 @@ decoder_t *test_decoder_create(vlc_object_t *parent, const es_format_t *fmt)
     decoder->pf_queue_sub = queue_sub;
     decoder->p_owner = (void *)packetizer;
 
-    if (decoder_load(packetizer, true, fmt) != VLC_SUCCESS)
+    struct test_packetizer *owner = (struct test_packetizer *)packetizer;
+    memset(&owner->stats, 0, sizeof(owner->stats));
+    owner->decode = args->decoder == NULL || strcmp(args->decoder, "none");
+    owner->filters_name = args->filters;
+    owner->filters = NULL;
+
+    if (decoder_load(packetizer, true, fmt, NULL) != VLC_SUCCESS)
         goto end;
 
-    if (decoder_load(decoder, false, &packetizer->fmt_out) != VLC_SUCCESS)
+    if (owner->decode
+     && decoder_load(decoder, false, &packetizer->fmt_out,
+                     args->decoder) != VLC_SUCCESS)
         goto end;
 
     return decoder;
@@ -184,22 +273,29 @@ end:
 int test_decoder_process(decoder_t *decoder, block_t *p_block)
 {
     decoder_t *packetizer = (void *) decoder->p_owner;
+    struct test_packetizer *owner = (struct test_packetizer *)packetizer;
 
     /* This case can happen if a decoder reload failed */
-    if (decoder->p_module == NULL)
+    if (owner->decode && decoder->p_module == NULL)
     {
         if (p_block != NULL)
             block_Release(p_block);
         return VLC_EGENERIC;
     }
 
+    struct test_decoder_stats *stats = &owner->stats;
+    struct vlc_run_counters *mark = &owner->mark;
+    vlc_run_counters_get(mark);
+
     block_t **pp_block = p_block ? &p_block : NULL;
     block_t *p_packetized_block;
     while ((p_packetized_block =
                 packetizer->pf_packetize(packetizer, pp_block)))
     {
+        vlc_run_counters_add(&stats->packetizer, mark);
 
-        if (!es_format_IsSimilar(&decoder->fmt_in, &packetizer->fmt_out))
+        if (owner->decode
+         && !es_format_IsSimilar(&decoder->fmt_in, &packetizer->fmt_out))
         {
             debug("restarting module due to input format change\n");
 
@@ -208,11 +304,13 @@ int test_decoder_process(decoder_t *decoder, block_t *p_block)
 
             /* Reload decoder */
             decoder_unload(decoder);
-            if (decoder_load(decoder, false, &packetizer->fmt_out) != VLC_SUCCESS)
+            if (decoder_load(decoder, false, &packetizer->fmt_out,
+                             NULL) != VLC_SUCCESS)
             {
                 block_ChainRelease(p_packetized_block);
                 return VLC_EGENERIC;
             }
+            vlc_run_counters_add(&stats->decoder, mark);
         }
 
         if (packetizer->pf_get_cc)
@@ -221,6 +319,7 @@ int test_decoder_process(decoder_t *decoder, block_t *p_block)
             block_t *p_cc = packetizer->pf_get_cc(packetizer, &desc);
             if (p_cc)
                 block_Release(p_cc);
+            vlc_run_counters_add(&stats->packetizer, mark);
         }
 
         while (p_packetized_block != NULL)
@@ -228,19 +327,39 @@ int test_decoder_process(decoder_t *decoder, block_t *p_block)
 
             block_t *p_next = p_packetized_block->p_next;
             p_packetized_block->p_next = NULL;
+            stats->frames++;
+
+            if (!owner->decode)
+            {
+                block_Release(p_packetized_block);
+                p_packetized_block = p_next;
+                continue;
+            }
 
             int ret = decoder->pf_decode(decoder, p_packetized_block);
 
             if (ret == VLCDEC_ECRITICAL)
             {
                 block_ChainRelease(p_next);
+                vlc_run_counters_add(&stats->decoder, mark);
                 return VLC_EGENERIC;
             }
 
             p_packetized_block = p_next;
         }
+        vlc_run_counters_add(&stats->decoder, mark);
     }
-    if (p_block == NULL) /* Drain */
+    vlc_run_counters_add(&stats->packetizer, mark);
+
+    if (p_block == NULL && owner->decode) /* Drain */
+    {
         decoder->pf_decode(decoder, NULL);
+        vlc_run_counters_add(&stats->decoder, mark);
+    }
     return VLC_SUCCESS;
 }
+
+const struct test_decoder_stats *test_decoder_get_stats(decoder_t *decoder)
+{
+    return &((struct test_packetizer *)decoder->p_owner)->stats;
+}
@@ -20,6 +20,18 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
  *****************************************************************************/
 
-decoder_t *test_decoder_create(vlc_object_t *parent, const es_format_t *fmt);
+decoder_t *test_decoder_create(vlc_object_t *parent, const es_format_t *fmt,
+                               const struct vlc_run_args *args);
 void test_decoder_destroy(decoder_t *decoder);
 int test_decoder_process(decoder_t *decoder, block_t *block);
+
+struct test_decoder_stats
+{
+    uint64_t frames; /* packetized blocks */
+    uint64_t pictures; /* pictures out of the filters */
+    struct vlc_run_counters packetizer;
+    struct vlc_run_counters decoder;
+    struct vlc_run_counters filter;
+};
+
+const struct test_decoder_stats *test_decoder_get_stats(decoder_t *decoder);
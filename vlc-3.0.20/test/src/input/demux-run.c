@@ -29,10 +29,15 @@
 # include "config.h"
 #endif
 
+#include <ctype.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#ifndef _WIN32
+# include <sys/resource.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_access.h>
@@ -41,6 +46,8 @@
 #include <vlc_input.h>
 #include <vlc_meta.h>
 #include <vlc_es_out.h>
+#include <vlc_fourcc.h>
+#include <vlc_modules.h>
 #include <vlc_url.h>
 #include "../lib/libvlc_internal.h"
 
@@ -53,6 +60,21 @@ struct test_es_out_t
 {
     struct es_out_t out;
     struct es_out_id_t *ids;
+
+    /* benchmark: deleted ES kept for the report, and what the demuxer
+     * spent outside of the ES it output blocks for */
+    const struct vlc_run_args *args;
+    bool benchmark;
+    struct es_out_id_t *done;
+    unsigned count;
+    struct vlc_run_counters mark;
+    struct vlc_run_counters open;
+    struct vlc_run_counters demux;
+    char demux_name[32];
+    char *url;
+    uint64_t stream_size;
+    uint64_t start_ns;
+    uint64_t start_cpu_ns;
 };
 
 struct es_out_id_t
@@ -60,7 +82,16 @@ struct es_out_id_t
     struct es_out_id_t *next;
 #ifdef HAVE_DECODERS
     decoder_t *decoder;
+    struct test_decoder_stats stats;
 #endif
+    bool packetized;
+    unsigned index;
+    enum es_format_category_e cat;
+    vlc_fourcc_t codec;
+    uint64_t blocks;
+    uint64_t bytes;
+    /* time and allocations of the demuxer since its previous output */
+    struct vlc_run_counters demux;
 };
 
 static es_out_id_t *EsOutAdd(es_out_t *out, const es_format_t *fmt)
@@ -76,8 +107,20 @@ static es_out_id_t *EsOutAdd(es_out_t *out, const es_format_t *fmt)
 
     id->next = ctx->ids;
     ctx->ids = id;
+    id->packetized = false;
+    id->index = ctx->count++;
+    id->cat = fmt->i_cat;
+    id->codec = fmt->i_codec;
+    id->blocks = id->bytes = 0;
+    id->demux.time = id->demux.allocs = 0;
 #ifdef HAVE_DECODERS
-    id->decoder = test_decoder_create((void *)out->p_sys, fmt);
+    /* keep the decoder creation out of the demuxer figures */
+    struct vlc_run_counters skipped = { 0, 0 }, mark;
+    vlc_run_counters_get(&mark);
+    id->decoder = test_decoder_create((void *)out->p_sys, fmt, ctx->args);
+    vlc_run_counters_add(&skipped, &mark);
+    ctx->mark.time += skipped.time;
+    ctx->mark.allocs += skipped.allocs;
 #endif
 
     debug("[%p] Added   ES\n", (void *)id);
@@ -97,28 +140,47 @@ static void EsOutCheckId(es_out_t *out, es_out_id_t *id)
 
 static int EsOutSend(es_out_t *out, es_out_id_t *id, block_t *block)
 {
+    struct test_es_out_t *ctx = (struct test_es_out_t *) out;
+
     //debug("[%p] Sent    ES: %zu\n", (void *)idd, block->i_buffer);
     EsOutCheckId(out, id);
+    if (ctx->benchmark)
+    {
+        vlc_run_counters_add(&id->demux, &ctx->mark);
+        id->blocks++;
+        id->bytes += block->i_buffer;
+    }
 #ifdef HAVE_DECODERS
     if (id->decoder)
         test_decoder_process(id->decoder, block);
     else
 #endif
         block_Release(block);
+    if (ctx->benchmark)
+        vlc_run_counters_get(&ctx->mark);
     return VLC_SUCCESS;
 }
 
-static void IdDelete(es_out_id_t *id)
+static void IdDelete(struct test_es_out_t *ctx, es_out_id_t *id)
 {
 #ifdef HAVE_DECODERS
     if (id->decoder)
     {
         /* Drain */
         test_decoder_process(id->decoder, NULL);
+        id->stats = *test_decoder_get_stats(id->decoder);
+        id->packetized = true;
         test_decoder_destroy(id->decoder);
     }
 #endif
-    free(id);
+    if (ctx->benchmark)
+    {
+        id->next = ctx->done;
+        ctx->done = id;
+        vlc_run_counters_get(&ctx->mark);
+    }
+    else
+        free(id);
 }
 
 static void EsOutDelete(es_out_t *out, es_out_id_t *id)
@@ -135,7 +197,7 @@ static void EsOutDelete(es_out_t *out, es_out_id_t *id)
 
     debug("[%p] Deleted ES\n", (void *)id);
     *pp = id->next;
-    IdDelete(id);
+    IdDelete(ctx, id);
 }
 
 static int EsOutControl(es_out_t *out, int query, va_list args)
@@ -181,6 +243,146 @@ static int EsOutControl(es_out_t *out, int query, va_list args)
     return VLC_SUCCESS;
 }
 
+static const char *EsCategoryName(enum es_format_category_e cat)
+{
+    switch (cat)
+    {
+        case VIDEO_ES: return "video";
+        case AUDIO_ES: return "audio";
+        case SPU_ES:   return "spu";
+        case DATA_ES:  return "data";
+        default:       return "unknown";
+    }
+}
+
+static uint64_t PerFrame(uint64_t value, uint64_t frames)
+{
+    return frames ? value / frames : 0;
+}
+
+/* Process CPU time in ns (all threads), and peak resident size in kB */
+static uint64_t GetCPUTime(uint64_t *peak_rss)
+{
+#ifndef _WIN32
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0)
+    {
+        if (peak_rss != NULL)
+            *peak_rss = ru.ru_maxrss;
+        return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * UINT64_C(1000000000)
+             + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * UINT64_C(1000);
+    }
+#endif
+    if (peak_rss != NULL)
+        *peak_rss = 0;
+    return 0;
+}
+
+/* With several inputs, the reports form a JSON array */
+static unsigned reports;
+
+static void EsOutReport(struct test_es_out_t *ctx)
+{
+    struct vlc_run_counters demux = ctx->demux;
+    for (es_out_id_t *id = ctx->done; id != NULL; id = id->next)
+    {
+        demux.time += id->demux.time;
+        demux.allocs += id->demux.allocs;
+    }
+
+    struct vlc_run_counters now;
+    uint64_t peak_rss;
+    vlc_run_counters_get(&now);
+    uint64_t cpu_ns = GetCPUTime(&peak_rss) - ctx->start_cpu_ns;
+
+    printf("%s{\n"
+           "  \"url\": \"%s\",\n"
+           "  \"demux\": \"%s\",\n"
+           "  \"stream_size\": %"PRIu64",\n"
+           "  \"wall_ns\": %"PRIu64",\n"
+           "  \"cpu_ns\": %"PRIu64",\n"
+           "  \"peak_rss_kb\": %"PRIu64",\n"
+           "  \"open_ns\": %"PRIu64",\n"
+           "  \"demux_ns\": %"PRIu64",\n"
+           "  \"demux_allocs\": %"PRIu64",\n"
+           "  \"es\": [",
+           reports++ ? "," : "",
+           ctx->url ? ctx->url : "", ctx->demux_name, ctx->stream_size,
+           now.time - ctx->start_ns, cpu_ns, peak_rss, ctx->open.time,
+           demux.time, demux.allocs);
+
+    /* in creation order */
+    for (unsigned i = 0; i < ctx->count; i++)
+    {
+        es_out_id_t *id = ctx->done;
+        while (id != NULL && id->index != i)
+            id = id->next;
+        if (id == NULL)
+            continue;
+
+        char codec[5];
+        vlc_fourcc_to_char(id->codec, codec);
+        for (size_t j = 0; j < 4; j++)
+            if (!isprint((unsigned char)codec[j]) ||
+                codec[j] == '"' || codec[j] == '\\')
+                codec[j] = '.';
+        codec[4] = '\0';
+
+        /* without packetizer, the demuxer output is the frame */
+        uint64_t frames = id->blocks;
+        struct vlc_run_counters packetizer = { 0, 0 };
+        struct vlc_run_counters decoder = { 0, 0 };
+        struct vlc_run_counters filter = { 0, 0 };
+        uint64_t pictures = 0;
+#ifdef HAVE_DECODERS
+        if (id->packetized)
+        {
+            frames = id->stats.frames;
+            pictures = id->stats.pictures;
+            packetizer = id->stats.packetizer;
+            decoder = id->stats.decoder;
+            filter = id->stats.filter;
+        }
+#endif
+        printf("%s\n    {\n"
+               "      \"id\": %u,\n"
+               "      \"cat\": \"%s\",\n"
+               "      \"codec\": \"%s\",\n"
+               "      \"blocks_in\": %"PRIu64",\n"
+               "      \"bytes_in\": %"PRIu64",\n"
+               "      \"frames_out\": %"PRIu64",\n"
+               "      \"demux_ns\": %"PRIu64",\n"
+               "      \"demux_allocs\": %"PRIu64",\n",
+               i ? "," : "", id->index, EsCategoryName(id->cat), codec,
+               id->blocks, id->bytes, frames,
+               id->demux.time, id->demux.allocs);
+        if (id->packetized)
+            printf("      \"packetizer_ns\": %"PRIu64",\n"
+                   "      \"packetizer_allocs\": %"PRIu64",\n"
+                   "      \"decoder_ns\": %"PRIu64",\n"
+                   "      \"decoder_allocs\": %"PRIu64",\n"
+                   "      \"filter_ns\": %"PRIu64",\n"
+                   "      \"filter_allocs\": %"PRIu64",\n",
+                   packetizer.time, packetizer.allocs,
+                   decoder.time, decoder.allocs, filter.time, filter.allocs);
+        if (id->cat == VIDEO_ES && pictures > 0)
+        {
+            /* whole pipeline throughput, without any clock */
+            uint64_t total = id->demux.time + packetizer.time
+                           + decoder.time + filter.time;
+            printf("      \"pictures_out\": %"PRIu64",\n"
+                   "      \"fps\": %.2f,\n", pictures,
+                   total ? pictures * 1e9 / total : 0.);
+        }
+        printf("      \"ns_per_frame\": %"PRIu64",\n"
+               "      \"allocs_per_frame\": %"PRIu64"\n"
+               "    }",
+               PerFrame(id->demux.time + packetizer.time, frames),
+               PerFrame(id->demux.allocs + packetizer.allocs, frames));
+    }
+    printf("\n  ]\n}\n");
+}
+
 static void EsOutDestroy(es_out_t *out)
 {
     struct test_es_out_t *ctx = (struct test_es_out_t *)out;
@@ -189,12 +391,25 @@ static void EsOutDestroy(es_out_t *out)
     while ((id = ctx->ids) != NULL)
     {
         ctx->ids = id->next;
-        IdDelete(id);
+        IdDelete(ctx, id);
     }
+
+    if (ctx->benchmark)
+    {
+        EsOutReport(ctx);
+        while ((id = ctx->done) != NULL)
+        {
+            ctx->done = id->next;
+            free(id);
+        }
+    }
+    free(ctx->url);
     free(ctx);
 }
 
-static es_out_t *test_es_out_create(vlc_object_t *parent)
+static es_out_t *test_es_out_create(vlc_object_t *parent,
+                                    const struct vlc_run_args *args,
+                                    const char *url)
 {
     struct test_es_out_t *ctx = malloc(sizeof (*ctx));
     if (ctx == NULL)
@@ -204,6 +419,18 @@ static es_out_t *test_es_out_create(vlc_object_t *parent)
     }
 
     ctx->ids = NULL;
+    ctx->args = args;
+    ctx->benchmark = args->benchmark;
+    ctx->done = NULL;
+    ctx->count = 0;
+    ctx->open.time = ctx->open.allocs = 0;
+    ctx->demux.time = ctx->demux.allocs = 0;
+    ctx->demux_name[0] = '\0';
+    ctx->url = url ? strdup(url) : NULL;
+    ctx->stream_size = 0;
+    vlc_run_counters_get(&ctx->mark);
+    ctx->start_ns = ctx->mark.time;
+    ctx->start_cpu_ns = GetCPUTime(NULL);
 
     es_out_t *out = &ctx->out;
     out->pf_add = EsOutAdd;
@@ -265,10 +492,11 @@ static int demux_process_stream(const struct vlc_run_args *args, stream_t *s)
     if (s == NULL)
         return -1;
 
-    es_out_t *out = test_es_out_create(VLC_OBJECT(s));
+    es_out_t *out = test_es_out_create(VLC_OBJECT(s), args, s->psz_url);
     if (out == NULL)
         return -1;
 
+    struct test_es_out_t *ctx = (struct test_es_out_t *)out;
     demux_t *demux = demux_New(VLC_OBJECT(s), name, "", s, out);
     if (demux == NULL)
     {
@@ -278,12 +506,21 @@ static int demux_process_stream(const struct vlc_run_args *args, stream_t *s)
         return -1;
     }
 
+    if (args->benchmark)
+    {
+        vlc_run_counters_add(&ctx->open, &ctx->mark);
+        snprintf(ctx->demux_name, sizeof(ctx->demux_name), "%s",
+                 module_get_object(demux->p_module));
+    }
+
     uintmax_t i = 0;
     int val;
 
     while ((val = demux_Demux(demux)) == VLC_DEMUXER_SUCCESS)
     {
-        if (args->test_demux_controls)
+        if (args->benchmark)
+            vlc_run_counters_add(&ctx->demux, &ctx->mark);
+        else if (args->test_demux_controls)
         {
             if (demux_test_and_clear_flags(demux, INPUT_UPDATE_TITLE_LIST))
                 demux_get_title_list(demux);
@@ -305,6 +542,13 @@ static int demux_process_stream(const struct vlc_run_args *args, stream_t *s)
         i++;
     }
 
+    if (args->benchmark)
+    {
+        vlc_run_counters_add(&ctx->demux, &ctx->mark);
+        if (vlc_stream_GetSize(s, &ctx->stream_size))
+            ctx->stream_size = 0;
+    }
+
     demux_Delete(demux);
     es_out_Delete(out);
 
@@ -240,6 +240,54 @@ int main(void)
     vlc_stream_Delete(s);
     block_Release(block);
 
+    /* Large blocks are peeked and handed out without copies */
+    s = vlc_stream_fifo_New(parent);
+    assert(s != NULL);
+    block_t *big = block_Alloc(8192);
+    assert(big != NULL);
+    for (size_t i = 0; i < big->i_buffer; i++)
+        big->p_buffer[i] = i;
+    big->i_pts = 42;
+    const uint8_t *payload = big->p_buffer;
+    val = vlc_stream_fifo_Queue(s, big);
+    assert(val == 0);
+    val = vlc_stream_fifo_Write(s, "tail", 4);
+    assert(val == 4);
+    vlc_stream_fifo_Close(s);
+
+    val = vlc_stream_Peek(s, &peek, 100);
+    assert(val == 100);
+    assert(peek == payload);
+
+    block = vlc_stream_Block(s, 4096);
+    assert(block != NULL);
+    assert(block->i_buffer == 4096);
+    assert(block->p_buffer == payload);
+    assert(block->i_pts == VLC_TS_INVALID);
+    assert(vlc_stream_Tell(s) == 4096);
+    block_Release(block);
+
+    val = vlc_stream_Peek(s, &peek, 16);
+    assert(val == 16);
+    assert(peek == payload + 4096);
+    assert(peek[0] == (uint8_t)4096);
+
+    block = vlc_stream_Block(s, 4096);
+    assert(block != NULL);
+    assert(block->p_buffer == payload + 4096);
+    assert(block->p_buffer[4095] == (uint8_t)8191);
+    assert(vlc_stream_Tell(s) == 8192);
+    block_Release(block);
+
+    /* Small reads are still copied, and cross block boundaries */
+    block = vlc_stream_Block(s, 10);
+    assert(block != NULL);
+    assert(block->i_buffer == 4);
+    assert(memcmp(block->p_buffer, "tail", 4) == 0);
+    assert(vlc_stream_Tell(s) == 8196);
+    block_Release(block);
+    vlc_stream_Delete(s);
+
     libvlc_release(vlc);
 
     return 0;
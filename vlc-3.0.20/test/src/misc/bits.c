@@ -37,6 +37,12 @@ static uint8_t *skip1( uint8_t *p, uint8_t *end, void *priv, size_t i_count )
     return p;
 }
 
+static uint8_t *skip0( uint8_t *p, uint8_t *end, void *priv, size_t i_count )
+{
+    (void) end; (void) priv;
+    return p + i_count;
+}
+
 int main( void )
 {
     test_init();
@@ -127,5 +133,33 @@ int main( void )
         work[i] = bs_read( &bs, 8 );
     assert(!memcmp( &work, &ok, 6 ));
 
+    /* Check the word reads against the byte by byte (forwarding) path */
+    uint8_t seq[24];
+    for( unsigned i=0; i<sizeof(seq); i++ )
+        seq[i] = 0x5A ^ (i * 37);
+    for( int w=1; w<=32; w++ )
+    {
+        bs_t ref;
+        bs_init( &bs, &seq, sizeof(seq) );
+        bs_init( &ref, &seq, sizeof(seq) );
+        ref.pf_forward = skip0;
+        bs_skip( &bs, w % 7 );
+        bs_skip( &ref, w % 7 );
+        while( !bs_eof( &ref ) )
+        {
+            assert( bs_read( &bs, w ) == bs_read( &ref, w ) );
+            assert( bs_pos( &bs ) == bs_pos( &ref ) );
+        }
+    }
+
+    /* ue(v) codes 0 to 5, then 200, then se(v) -3 */
+    const uint8_t golomb[16] = { 0xA6, 0x42, 0x98, 0x06, 0x49, 0xC0 };
+    bs_init( &bs, &golomb, 16 );
+    for( unsigned i=0; i<6; i++ )
+        assert( bs_read_ue( &bs ) == i );
+    assert( bs_read_ue( &bs ) == 200 );
+    assert( bs_read_se( &bs ) == -3 );
+    assert( bs_pos( &bs ) == 42 );
+
     return 0;
 }